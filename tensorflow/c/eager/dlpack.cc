@@ -18,12 +18,21 @@ limitations under the License.
 #include "include/dlpack/dlpack.h"  // from @dlpack
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/c_api_experimental.h"
+#include "tensorflow/c/eager/tfe_context_internal.h"
 #include "tensorflow/c/eager/tfe_tensorhandle_internal.h"
 #include "tensorflow/c/tf_status_internal.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/stream_executor.h"
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 namespace tensorflow {
 
@@ -219,6 +228,67 @@ Status TfDataTypeFormDlDataType(const DLDataType& dtype,
   }
 }
 
+// Returns the compute stream of `device` if it is a CUDA or ROCm GPU, nullptr
+// otherwise.
+se::Stream* GetGpuComputeStream(Device* device) {
+  if (device == nullptr) return nullptr;
+  const DeviceBase::GpuDeviceInfo* gpu_device_info =
+      device->tensorflow_gpu_device_info();
+  if (gpu_device_info == nullptr || gpu_device_info->stream == nullptr) {
+    return nullptr;
+  }
+  se::Stream* stream = gpu_device_info->stream;
+  const se::PlatformKind kind = stream->parent()->platform_kind();
+  if (kind != se::PlatformKind::kCuda && kind != se::PlatformKind::kROCm) {
+    return nullptr;
+  }
+  return stream;
+}
+
+// Makes `waiter` wait, on the device, until all the work enqueued on `signaler`
+// so far has completed. Exactly one of the two is a stream of `tf_stream`'s
+// GPU; the other is a raw stream handle owned by another framework.
+Status WaitStreamOnStream(se::Stream* tf_stream, void* signaler,
+                          void* waiter) {
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  se::gpu::GpuContext* context =
+      se::gpu::ExtractGpuExecutor(tf_stream->parent())->gpu_context();
+  se::gpu::GpuEventHandle event;
+  TF_RETURN_IF_ERROR(se::gpu::GpuDriver::InitEvent(
+      context, &event, se::gpu::GpuDriver::EventFlags::kDisableTiming));
+  Status status = se::gpu::GpuDriver::RecordEvent(
+      context, event, static_cast<se::gpu::GpuStreamHandle>(signaler));
+  if (status.ok() && !se::gpu::GpuDriver::WaitStreamOnEvent(
+                         context, static_cast<se::gpu::GpuStreamHandle>(waiter),
+                         event)) {
+    status = errors::Internal("Failed to wait on a DLPack stream event");
+  }
+  // Destroying a recorded event is safe: its resources are released once the
+  // waiting stream is done with it.
+  se::gpu::GpuDriver::DestroyEvent(context, &event).IgnoreError();
+  return status;
+#else
+  return errors::Unimplemented(
+      "DLPack stream synchronization requires a CUDA or ROCm build");
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+}
+
+// Makes the data of `tensor_handle` safe to access by a DLPack consumer. For
+// GPU tensors with a `consumer_stream`, the consumer stream is made to wait for
+// the TF compute stream. Otherwise the device is synchronized with the host.
+Status PrepareTensorForExport(TensorHandle* tensor_handle,
+                              void* consumer_stream) {
+  Device* device = tensor_handle->device();
+  if (device == nullptr) return Status::OK();
+  se::Stream* stream = GetGpuComputeStream(device);
+  if (stream != nullptr && consumer_stream != nullptr) {
+    return WaitStreamOnStream(
+        stream, stream->implementation()->GpuStreamMemberHack(),
+        consumer_stream);
+  }
+  return device->Sync();
+}
+
 // Wraps the deleter function of DLManagedTensor to match the function signature
 // TFE_NewTensorHandleFromDeviceMemory.
 void DeallocatorWrapperFunc(void* data, size_t len, void* dlmt_vptr) {
@@ -226,16 +296,23 @@ void DeallocatorWrapperFunc(void* data, size_t len, void* dlmt_vptr) {
 }
 
 // Checks whether the stride array matches the layout of compact, row-majored
-// data.
+// data. The strides of dimensions of size 1 don't affect the layout and may
+// hold any value, as may all strides of empty tensors. This lets views such as
+// the ones produced by unsqueeze or by slicing along the leading dimension be
+// imported without a copy.
 bool IsValidStrideCompactRowMajorData(int64_t* shape_arr, int64_t* stride_arr,
                                       int ndim) {
-  if (ndim >= 1 && stride_arr[ndim - 1] != 1) {
-    return false;
+  for (int i = 0; i < ndim; ++i) {
+    if (shape_arr[i] == 0) {
+      return true;
+    }
   }
-  for (int i = ndim - 2; i >= 0; --i) {
-    if (stride_arr[i] != shape_arr[i + 1] * stride_arr[i + 1]) {
+  int64_t expected_stride = 1;
+  for (int i = ndim - 1; i >= 0; --i) {
+    if (shape_arr[i] != 1 && stride_arr[i] != expected_stride) {
       return false;
     }
+    expected_stride *= shape_arr[i];
   }
   return true;
 }
@@ -249,17 +326,29 @@ void TFE_CallDLManagedTensorDeleter(void* dlm_ptr) {
 }
 
 void* TFE_HandleToDLPack(TFE_TensorHandle* h, TF_Status* status) {
+  return TFE_HandleToDLPackWithStream(h, /*consumer_stream=*/nullptr, status);
+}
+
+void* TFE_HandleToDLPackWithStream(TFE_TensorHandle* h, void* consumer_stream,
+                                   TF_Status* status) {
   auto tf_dlm_context = GetDlContext(h, status);
   if (!status->status.ok()) {
     return nullptr;
   }
 
-  auto* tf_dlm_data = TFE_TensorHandleDevicePointer(h, status);
+  // Waits for the handle to be ready.
+  const Tensor* tensor = GetTensorFromHandle(h, status);
   if (!status->status.ok()) {
     return nullptr;
   }
-
-  const Tensor* tensor = GetTensorFromHandle(h, status);
+  status->status = PrepareTensorForExport(
+      tensorflow::TensorHandleFromInterface(tensorflow::unwrap(h)),
+      consumer_stream);
+  if (!status->status.ok()) {
+    return nullptr;
+  }
+  void* tf_dlm_data =
+      const_cast<void*>(static_cast<const void*>(tensor->tensor_data().data()));
   TF_DataType data_type = static_cast<TF_DataType>(tensor->dtype());
 
   auto tf_dlm_type = GetDlDataType(data_type, status);
@@ -306,6 +395,14 @@ void* TFE_HandleToDLPack(TFE_TensorHandle* h, TF_Status* status) {
 
 TFE_TensorHandle* TFE_HandleFromDLPack(void* dlm, TF_Status* status,
                                        TFE_Context* ctx) {
+  return TFE_HandleFromDLPackWithStream(dlm, /*producer_stream=*/nullptr,
+                                        status, ctx);
+}
+
+TFE_TensorHandle* TFE_HandleFromDLPackWithStream(void* dlm,
+                                                 void* producer_stream,
+                                                 TF_Status* status,
+                                                 TFE_Context* ctx) {
   DLManagedTensor* dlmt = static_cast<DLManagedTensor*>(dlm);
   DLTensor* dl_tensor = &dlmt->dl_tensor;
   absl::optional<std::string> device_name =
@@ -323,7 +420,7 @@ TFE_TensorHandle* TFE_HandleFromDLPack(void* dlm, TF_Status* status,
   }
   int num_dims = dl_tensor->ndim;
   const int64_t* dims = dl_tensor->shape;
-  void* data = dl_tensor->data;
+  void* data = static_cast<char*>(dl_tensor->data) + dl_tensor->byte_offset;
 
   size_t total_bytes = dl_tensor->dtype.bits / 8;
   for (int i = 0; i < num_dims; i++) {
@@ -338,6 +435,27 @@ TFE_TensorHandle* TFE_HandleFromDLPack(void* dlm, TF_Status* status,
     return nullptr;
   }
 
+  if (producer_stream != nullptr &&
+      dl_tensor->ctx.device_type == DLDeviceType::kDLGPU) {
+    // Orders all future TF work on the device after the producer's pending
+    // work, instead of synchronizing the producer stream with the host.
+    Device* device = nullptr;
+    Status s = tensorflow::ContextFromInterface(tensorflow::unwrap(ctx))
+                   ->FindDeviceFromName(device_name.value().c_str(), &device);
+    se::Stream* stream = s.ok() ? GetGpuComputeStream(device) : nullptr;
+    if (stream == nullptr) {
+      status->status = tensorflow::errors::InvalidArgument(
+          "No GPU compute stream found for DLPack device ", *device_name);
+      return nullptr;
+    }
+    status->status = WaitStreamOnStream(
+        stream, producer_stream,
+        stream->implementation()->GpuStreamMemberHack());
+    if (!status->status.ok()) {
+      return nullptr;
+    }
+  }
+
   TFE_TensorHandle* handle = TFE_NewTensorHandleFromDeviceMemory(
       ctx, device_name.value().c_str(), dtype, dims, num_dims, data,
       total_bytes, &DeallocatorWrapperFunc, dlmt, status);
@@ -28,11 +28,25 @@ const char* const kDlTensorCapsuleName = "dltensor";
 TF_CAPI_EXPORT extern void* TFE_HandleToDLPack(TFE_TensorHandle* h,
                                                TF_Status* status);
 
+// Like TFE_HandleToDLPack, but for GPU tensors `consumer_stream` (a
+// CUstream or hipStream_t of the consuming framework) is made to wait on the
+// device for the pending TF work that produces the tensor, instead of
+// synchronizing the TF device with the host. A null `consumer_stream` behaves
+// like TFE_HandleToDLPack.
+TF_CAPI_EXPORT extern void* TFE_HandleToDLPackWithStream(
+    TFE_TensorHandle* h, void* consumer_stream, TF_Status* status);
+
 // Converts DLPack (DLManagedTensor*) to eager tensor handle.
 TF_CAPI_EXPORT extern TFE_TensorHandle* TFE_HandleFromDLPack(void* dlm,
                                                              TF_Status* status,
                                                              TFE_Context* ctx);
 
+// Like TFE_HandleFromDLPack, but for GPU tensors the TF compute stream is made
+// to wait on the device for the work pending on `producer_stream` (a CUstream
+// or hipStream_t of the producing framework) when it is non-null.
+TF_CAPI_EXPORT extern TFE_TensorHandle* TFE_HandleFromDLPackWithStream(
+    void* dlm, void* producer_stream, TF_Status* status, TFE_Context* ctx);
+
 // Calls the destructor of DLManagedTensor, used in the destructor of PyCapsule.
 TF_CAPI_EXPORT extern void TFE_CallDLManagedTensorDeleter(void* dlm_ptr);
 }  // namespace tensorflow
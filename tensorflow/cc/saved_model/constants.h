@@ -33,6 +33,10 @@ constexpr char kSavedModelFilenamePb[] = "saved_model.pb";
 /// SavedModel text format proto filename.
 constexpr char kSavedModelFilenamePbTxt[] = "saved_model.pbtxt";
 
+/// SavedModel warmup requests filename, in the assets.extra directory.
+constexpr char kSavedModelWarmupRequestsFilename[] =
+    "saved_model_warmup_requests";
+
 /// SavedModel legacy init op collection key. Used in v1 SavedModels.
 constexpr char kSavedModelLegacyInitOpKey[] = "legacy_init_op";
 
@@ -45,6 +49,9 @@ constexpr char kSavedModelVariablesDirectory[] = "variables";
 /// SavedModel variables filename.
 constexpr char kSavedModelVariablesFilename[] = "variables";
 
+/// SavedModel memory-mapped variables package filename.
+constexpr char kSavedModelMemmappedVariablesFilename[] = "variables.memmapped";
+
 /// SavedModel SignatureDef keys for the initialization and train ops. Used in
 /// V2 SavedModels.
 constexpr char kSavedModelInitOpSignatureKey[] = "__saved_model_init_op";
@@ -19,7 +19,9 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader_util.h"
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
 #include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/cc/saved_model/warmup.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -235,6 +237,35 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
                  nullptr /* outputs */, &run_metadata, session);
 }
 
+// Replays the warmup requests of the SavedModel, if it has any, so that the
+// first client requests find the session's caches populated.
+Status RunWarmup(const RunOptions& run_options, const string& export_dir,
+                 const SavedModelBundle& bundle) {
+  const uint64 start_microseconds = Env::Default()->NowMicros();
+  SavedModelWarmupStats stats;
+  TF_RETURN_IF_ERROR(WarmupSavedModel(run_options, export_dir,
+                                      bundle.meta_graph_def,
+                                      bundle.session.get(), &stats));
+  if (stats.signatures.empty()) return Status::OK();
+  load_latency_by_stage->GetCell(export_dir, "warmup")
+      ->Add(GetLatencyMicroseconds(start_microseconds));
+  LOG(INFO) << "Warmed up SavedModel bundle at path: " << export_dir
+            << ". Reading the requests took " << stats.read_microseconds
+            << " microseconds, replaying them took "
+            << stats.replay_microseconds << " microseconds.";
+  for (const auto& signature : stats.signatures) {
+    LOG(INFO) << "Signature \"" << signature.signature_name << "\": "
+              << signature.num_requests << " requests, " << signature.num_runs
+              << " runs, " << signature.num_executors
+              << " executors cached. First run took "
+              << signature.first_run_microseconds
+              << " microseconds, last run took "
+              << signature.last_run_microseconds << " microseconds, "
+              << signature.replay_microseconds << " microseconds in total.";
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 SavedModelBundleInterface::~SavedModelBundleInterface() {}
@@ -258,6 +289,28 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  // A session left in `bundle` by an earlier load may use `session_env`.
+  bundle->session.reset();
+  bundle->session_env.reset();
+  if (session_options.config.experimental()
+          .use_memmapped_saved_model_variables()) {
+    // The session runs a copy of the graph that reads the variables from the
+    // package; the bundle keeps the graph as saved.
+    MetaGraphDef memmapped_meta_graph_def(bundle->meta_graph_def);
+    std::unique_ptr<MemmappedEnv> memmapped_env;
+    TF_RETURN_IF_ERROR(internal::MaybeMemmapSavedModelVariables(
+        session_options.env, export_dir, &memmapped_meta_graph_def,
+        &memmapped_env));
+    if (memmapped_env) {
+      SessionOptions memmapped_options(session_options);
+      memmapped_options.env = memmapped_env.get();
+      bundle->session_env = std::move(memmapped_env);
+      TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+          memmapped_options, memmapped_meta_graph_def, &bundle->session));
+      return RestoreSession(run_options, memmapped_meta_graph_def, export_dir,
+                            &bundle->session);
+    }
+  }
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
       session_options, bundle->meta_graph_def, &bundle->session));
   TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
@@ -271,8 +324,11 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       SavedModelBundle* const bundle) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  Status status = LoadSavedModelInternal(session_options, run_options,
+                                         export_dir, tags, bundle);
+  if (status.ok()) {
+    status = RunWarmup(run_options, export_dir, *bundle);
+  }
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "SavedModel load for tags { " << absl::StrJoin(tags, " ")
               << " }; Status: " << status_str << ": " << status << ". Took "
@@ -298,8 +354,9 @@ namespace {
 // users.
 class LiteSessionWrapper : public Session {
  public:
-  explicit LiteSessionWrapper(std::unique_ptr<Session> wrapped)
-      : wrapped_(std::move(wrapped)) {}
+  LiteSessionWrapper(std::unique_ptr<Session> wrapped,
+                     std::unique_ptr<Env> env)
+      : env_(std::move(env)), wrapped_(std::move(wrapped)) {}
 
   Status Create(const GraphDef& graph) override {
     return errors::Unimplemented("Session::Create()");
@@ -394,6 +451,8 @@ class LiteSessionWrapper : public Session {
   }
 
  private:
+  // Environment that `wrapped_` was created with, if owned by the bundle.
+  const std::unique_ptr<Env> env_;
   const std::unique_ptr<Session> wrapped_;
 };
 }  // namespace
@@ -449,7 +508,9 @@ Status LoadSavedModel(const SessionOptions& session_options,
   TF_RETURN_IF_ERROR(LoadSavedModel(rewritten_options, run_options, export_dir,
                                     tags, &legacy_bundle));
   *bundle = SavedModelBundleLite(
-      absl::make_unique<LiteSessionWrapper>(std::move(legacy_bundle.session)),
+      absl::make_unique<LiteSessionWrapper>(
+          std::move(legacy_bundle.session),
+          std::move(legacy_bundle.session_env)),
       std::move(*legacy_bundle.meta_graph_def.mutable_signature_def()));
   return Status::OK();
 }
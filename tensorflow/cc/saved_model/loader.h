@@ -62,6 +62,10 @@ struct SavedModelBundle : public SavedModelBundleInterface {
     return meta_graph_def.signature_def();
   }
 
+  /// Environment of `session` when it serves memory-mapped variables, which
+  /// must outlive it. See ConfigProto.Experimental's
+  /// use_memmapped_saved_model_variables.
+  std::unique_ptr<Env> session_env;
   std::unique_ptr<Session> session;
   MetaGraphDef meta_graph_def;
   std::unique_ptr<GraphDebugInfo> debug_info;
@@ -116,6 +120,9 @@ Status LoadMetagraphIntoSession(const SessionOptions& session_options,
 /// the set of tags used at SavedModel build time. Stores a SavedModel bundle in
 /// *bundle with a session and the requested MetaGraphDef, if found.
 ///
+/// If the SavedModel has warmup requests, they are replayed against the
+/// session before this returns; see WarmupSavedModel() in warmup.h.
+///
 /// NOTE: Prefer the overload that takes a SavedModelBundleLite* in new code.
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
@@ -0,0 +1,524 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/variable.pb.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+// Collections holding the VariableDefs, and so the initializer names, of the
+// variables of a v1 graph.
+constexpr const char* kVariableCollections[] = {"variables",
+                                                "local_variables"};
+
+string VariablesPath(const string& export_dir) {
+  return io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                      kSavedModelVariablesFilename);
+}
+
+string PackagePath(const string& export_dir) {
+  return io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                      kSavedModelMemmappedVariablesFilename);
+}
+
+// ImmutableConst only has a CPU kernel.
+bool IsOnCpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed_name;
+  return node.device().empty() ||
+         (DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+          (!parsed_name.has_type || parsed_name.type == DEVICE_CPU));
+}
+
+// A data edge into `node`'s input `input`.
+struct Edge {
+  NodeDef* node;
+  int input;
+};
+
+// Looks up nodes and the consumers of their outputs in a GraphDef.
+class GraphIndex {
+ public:
+  explicit GraphIndex(GraphDef* graph) {
+    for (NodeDef& node : *graph->mutable_node()) {
+      nodes_[node.name()] = &node;
+    }
+    for (NodeDef& node : *graph->mutable_node()) {
+      for (int i = 0; i < node.input_size(); ++i) {
+        const TensorId id = ParseTensorName(node.input(i));
+        if (IsTensorIdControl(id)) {
+          nodes_with_control_outputs_.insert(string(id.node()));
+        } else {
+          outputs_[{string(id.node()), id.index()}].push_back({&node, i});
+        }
+      }
+    }
+  }
+
+  NodeDef* Find(StringPiece name) const {
+    auto it = nodes_.find(string(name));
+    return it == nodes_.end() ? nullptr : it->second;
+  }
+
+  // Returns the node producing the data input `input` of `node`.
+  NodeDef* Input(const NodeDef& node, int input) const {
+    if (input >= node.input_size()) return nullptr;
+    const TensorId id = ParseTensorName(node.input(input));
+    return IsTensorIdControl(id) ? nullptr : Find(id.node());
+  }
+
+  const std::vector<Edge>& Consumers(const string& name, int output) const {
+    static const std::vector<Edge>* const kNone = new std::vector<Edge>();
+    auto it = outputs_.find({name, output});
+    return it == outputs_.end() ? *kNone : it->second;
+  }
+
+  bool HasControlOutputs(const string& name) const {
+    return nodes_with_control_outputs_.count(name) > 0;
+  }
+
+ private:
+  std::unordered_map<string, NodeDef*> nodes_;
+  std::map<std::pair<string, int>, std::vector<Edge>> outputs_;
+  std::unordered_set<string> nodes_with_control_outputs_;
+};
+
+// A variable that the saver restores from a single bundle entry, and the
+// nodes that the rewrite changes for it.
+struct MemmappedVariable {
+  string key;
+  DataType dtype;
+  TensorShape shape;
+  // Nodes that read the value: the variable itself for a reference variable,
+  // or its ReadVariableOps. Each becomes an ImmutableConst.
+  std::vector<NodeDef*> readers;
+  // IsVariableInitialized and VarIsInitializedOp nodes, which become true.
+  std::vector<NodeDef*> initialized_checks;
+  // The restore and initializer assignments, which are removed.
+  std::vector<string> writers;
+};
+
+// Replaces `node` with a node of op `op` that keeps its name, device, control
+// inputs and internal attributes.
+void ResetNode(const string& op, NodeDef* node) {
+  std::vector<string> control_inputs;
+  for (const string& input : node->input()) {
+    if (IsTensorIdControl(ParseTensorName(input))) {
+      control_inputs.push_back(input);
+    }
+  }
+  node->clear_input();
+  for (const string& input : control_inputs) node->add_input(input);
+  auto* attrs = node->mutable_attr();
+  for (auto it = attrs->begin(); it != attrs->end();) {
+    if (absl::StartsWith(it->first, "_")) {
+      ++it;
+    } else {
+      it = attrs->erase(it);
+    }
+  }
+  node->set_op(op);
+}
+
+void ConvertToImmutableConst(const MemmappedVariable& variable,
+                             NodeDef* node) {
+  ResetNode("ImmutableConst", node);
+  AttrValue attr_type;
+  attr_type.set_type(variable.dtype);
+  node->mutable_attr()->insert({"dtype", attr_type});
+  AttrValue attr_shape;
+  variable.shape.AsProto(attr_shape.mutable_shape());
+  node->mutable_attr()->insert({"shape", attr_shape});
+  AttrValue attr_region;
+  attr_region.set_s(internal::MemmappedVariableRegionName(variable.key));
+  node->mutable_attr()->insert({"memory_region_name", attr_region});
+}
+
+void ConvertToTrue(NodeDef* node) {
+  ResetNode("Const", node);
+  AttrValue attr_type;
+  attr_type.set_type(DT_BOOL);
+  node->mutable_attr()->insert({"dtype", attr_type});
+  AttrValue attr_value;
+  Tensor(true).AsProtoTensorContent(attr_value.mutable_tensor());
+  node->mutable_attr()->insert({"value", attr_value});
+}
+
+// Reads the string vector held by the Const node `node`.
+bool GetConstStrings(const NodeDef* node, std::vector<tstring>* values) {
+  if (node == nullptr || node->op() != "Const") return false;
+  auto it = node->attr().find("value");
+  Tensor tensor;
+  if (it == node->attr().end() || !tensor.FromProto(it->second.tensor()) ||
+      tensor.dtype() != DT_STRING || tensor.dims() != 1) {
+    return false;
+  }
+  const auto flat = tensor.flat<tstring>();
+  values->assign(flat.data(), flat.data() + flat.size());
+  return true;
+}
+
+void SetConstStrings(const std::vector<tstring>& values, NodeDef* node) {
+  Tensor tensor(DT_STRING, TensorShape({static_cast<int64>(values.size())}));
+  std::copy(values.begin(), values.end(), tensor.flat<tstring>().data());
+  tensor.AsProtoField((*node->mutable_attr())["value"].mutable_tensor());
+}
+
+// Finds the variable that output `output` of the RestoreV2 node `restore` is
+// assigned to, either directly by an Assign or through an Identity by an
+// AssignVariableOp, and records the assignment in `variable->writers`.
+NodeDef* FindRestoredVariable(const GraphIndex& index, const NodeDef& restore,
+                              int output, MemmappedVariable* variable) {
+  const std::vector<Edge>& consumers = index.Consumers(restore.name(), output);
+  if (consumers.size() != 1) return nullptr;
+  const NodeDef* value = &restore;
+  const NodeDef* assign = consumers[0].node;
+  if (assign->op() == "Identity") {
+    const std::vector<Edge>& identity_consumers =
+        index.Consumers(assign->name(), 0);
+    if (identity_consumers.size() != 1) return nullptr;
+    variable->writers.push_back(assign->name());
+    value = assign;
+    assign = identity_consumers[0].node;
+    if (assign->op() != "AssignVariableOp") return nullptr;
+  } else if (assign->op() != "Assign") {
+    return nullptr;
+  }
+  if (index.Input(*assign, 1) != value) return nullptr;
+  variable->writers.push_back(assign->name());
+  return index.Input(*assign, 0);
+}
+
+// Returns true if every use of `node` is one that the rewrite can replace,
+// filling in the readers, initialization checks and writers of `variable`.
+bool CollectVariableUses(const GraphIndex& index, NodeDef* node,
+                         const std::unordered_set<string>& initializers,
+                         MemmappedVariable* variable) {
+  const bool is_resource = node->op() == "VarHandleOp";
+  if (!is_resource && node->op() != "VariableV2" && node->op() != "Variable") {
+    return false;
+  }
+  if (!IsOnCpu(*node)) return false;
+  const string restore_writer = variable->writers.back();
+  if (!is_resource) variable->readers.push_back(node);
+  for (const Edge& use : index.Consumers(node->name(), 0)) {
+    const string& op = use.node->op();
+    if (op == (is_resource ? "AssignVariableOp" : "Assign")) {
+      if (use.input != 0 || !index.Consumers(use.node->name(), 0).empty()) {
+        return false;
+      }
+      if (use.node->name() == restore_writer) continue;
+      if (initializers.count(use.node->name()) == 0) return false;
+      variable->writers.push_back(use.node->name());
+    } else if (op == (is_resource ? "VarIsInitializedOp"
+                                  : "IsVariableInitialized")) {
+      variable->initialized_checks.push_back(use.node);
+    } else if (is_resource) {
+      if (op != "ReadVariableOp" || !IsOnCpu(*use.node)) return false;
+      variable->readers.push_back(use.node);
+    } else {
+      // Any other op may use the value of a reference variable, but not
+      // mutate it through a reference input.
+      const OpDef* op_def = nullptr;
+      DataType input_type;
+      if (!OpRegistry::Global()->LookUpOpDef(op, &op_def).ok() ||
+          !InputTypeForNode(*use.node, *op_def, use.input, &input_type).ok() ||
+          IsRefType(input_type)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Removes from the RestoreV2 node `restore` the outputs in `memmapped`,
+// which are no longer used, and renumbers the uses of the others. Removes
+// `restore` altogether if it has no outputs left.
+void PruneRestore(const GraphIndex& index, const std::vector<bool>& memmapped,
+                  NodeDef* restore, std::unordered_set<string>* removed) {
+  NodeDef* names_node = index.Input(*restore, 1);
+  NodeDef* slices_node = index.Input(*restore, 2);
+  // The tensor names and slices can only be changed if nothing else uses
+  // them.
+  for (const NodeDef* node : {names_node, slices_node}) {
+    if (index.Consumers(node->name(), 0).size() != 1 ||
+        index.HasControlOutputs(node->name())) {
+      return;
+    }
+  }
+  std::vector<tstring> names, slices;
+  GetConstStrings(names_node, &names);
+  GetConstStrings(slices_node, &slices);
+  std::vector<tstring> kept_names, kept_slices;
+  AttrValue kept_dtypes;
+  const auto& dtypes = restore->attr().at("dtypes").list().type();
+  for (int i = 0; i < memmapped.size(); ++i) {
+    if (memmapped[i]) continue;
+    const string new_input = kept_names.empty()
+                                 ? restore->name()
+                                 : strings::StrCat(restore->name(), ":",
+                                                   kept_names.size());
+    for (const Edge& use : index.Consumers(restore->name(), i)) {
+      use.node->set_input(use.input, new_input);
+    }
+    kept_names.push_back(names[i]);
+    kept_slices.push_back(slices[i]);
+    kept_dtypes.mutable_list()->add_type(static_cast<DataType>(dtypes[i]));
+  }
+  if (kept_names.empty()) {
+    removed->insert(restore->name());
+    removed->insert(names_node->name());
+    removed->insert(slices_node->name());
+    return;
+  }
+  SetConstStrings(kept_names, names_node);
+  SetConstStrings(kept_slices, slices_node);
+  (*restore->mutable_attr())["dtypes"] = kept_dtypes;
+  restore->mutable_attr()->erase("_output_shapes");
+}
+
+// Removes the nodes in `removed`, and control inputs on them.
+void RemoveNodes(const std::unordered_set<string>& removed, GraphDef* graph) {
+  int num_kept = 0;
+  for (int i = 0; i < graph->node_size(); ++i) {
+    if (removed.count(graph->node(i).name()) > 0) continue;
+    graph->mutable_node()->SwapElements(i, num_kept++);
+  }
+  graph->mutable_node()->DeleteSubrange(num_kept,
+                                        graph->node_size() - num_kept);
+  for (NodeDef& node : *graph->mutable_node()) {
+    auto* inputs = node.mutable_input();
+    for (auto it = inputs->begin(); it != inputs->end();) {
+      const TensorId id = ParseTensorName(*it);
+      if (IsTensorIdControl(id) && removed.count(string(id.node())) > 0) {
+        it = inputs->erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+Status WriteMemmappedSavedModelVariables(const string& export_dir) {
+  Env* env = Env::Default();
+  BundleReader reader(env, VariablesPath(export_dir));
+  TF_RETURN_IF_ERROR(reader.status());
+
+  // Write to a temporary file first so that a loader never sees a partial
+  // package.
+  const string package_path = PackagePath(export_dir);
+  const string temp_path =
+      strings::StrCat(package_path, ".tempstate", random::New64());
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(env, temp_path));
+  int num_written = 0;
+  for (reader.Seek(kHeaderEntryKey); reader.Valid(); reader.Next()) {
+    // Skips the header and the slices of partitioned tensors, whose keys
+    // start with a zero byte.
+    const StringPiece key = reader.key();
+    if (key.empty() || key[0] == '\0') continue;
+    BundleEntryProto entry;
+    if (!entry.ParseFromArray(reader.value().data(), reader.value().size())) {
+      return errors::DataLoss("Cannot parse bundle entry for ", key);
+    }
+    if (!DataTypeCanUseMemcpy(entry.dtype()) || entry.slices_size() > 0 ||
+        entry.size() == 0) {
+      continue;
+    }
+    Tensor value;
+    TF_RETURN_IF_ERROR(reader.ReadCurrent(&value));
+    TF_RETURN_IF_ERROR(writer.SaveTensor(
+        value, internal::MemmappedVariableRegionName(string(key))));
+    ++num_written;
+  }
+  TF_RETURN_IF_ERROR(writer.FlushAndClose());
+  TF_RETURN_IF_ERROR(env->RenameFile(temp_path, package_path));
+  LOG(INFO) << "Wrote " << num_written << " memory-mappable variables to "
+            << package_path;
+  return Status::OK();
+}
+
+namespace internal {
+
+string MemmappedVariableRegionName(const string& key) {
+  // Region names are limited to [A-Za-z0-9_.], so escape everything else,
+  // and '_' itself, as '_' and two hex digits.
+  string name = MemmappedFileSystem::kMemmappedPackagePrefix;
+  for (const unsigned char c : key) {
+    if (std::isalnum(c) || c == '.') {
+      name.push_back(c);
+    } else {
+      strings::StrAppend(&name, "_", strings::Hex(c, strings::kZeroPad2));
+    }
+  }
+  return name;
+}
+
+Status RewriteGraphForMemmappedVariables(Env* env,
+                                         const string& variables_path,
+                                         MetaGraphDef* meta_graph_def,
+                                         int* num_rewritten) {
+  *num_rewritten = 0;
+  std::unordered_set<string> initializers;
+  for (const char* collection : kVariableCollections) {
+    auto it = meta_graph_def->collection_def().find(collection);
+    if (it == meta_graph_def->collection_def().end()) continue;
+    for (const string& bytes : it->second.bytes_list().value()) {
+      VariableDef variable_def;
+      if (variable_def.ParseFromString(bytes)) {
+        initializers.insert(
+            string(ParseTensorName(variable_def.initializer_name()).node()));
+      }
+    }
+  }
+
+  BundleReader reader(env, variables_path);
+  TF_RETURN_IF_ERROR(reader.status());
+  GraphDef* graph = meta_graph_def->mutable_graph_def();
+  GraphIndex index(graph);
+  std::vector<MemmappedVariable> variables;
+  std::unordered_set<const NodeDef*> claimed;
+  // The RestoreV2 nodes with memmapped outputs, and which ones.
+  std::vector<std::pair<NodeDef*, std::vector<bool>>> restores;
+  for (NodeDef& restore : *graph->mutable_node()) {
+    if (restore.op() != "RestoreV2") continue;
+    std::vector<tstring> names, slices;
+    auto dtypes = restore.attr().find("dtypes");
+    if (!GetConstStrings(index.Input(restore, 1), &names) ||
+        !GetConstStrings(index.Input(restore, 2), &slices) ||
+        dtypes == restore.attr().end() || names.size() != slices.size() ||
+        names.size() != dtypes->second.list().type_size()) {
+      continue;
+    }
+    std::vector<bool> memmapped(names.size(), false);
+    for (int i = 0; i < names.size(); ++i) {
+      MemmappedVariable variable;
+      variable.key = names[i];
+      if (!slices[i].empty() ||
+          !reader
+               .LookupDtypeAndShape(variable.key, &variable.dtype,
+                                    &variable.shape)
+               .ok() ||
+          variable.dtype != dtypes->second.list().type(i)) {
+        continue;
+      }
+      uint64 region_size = 0;
+      if (!env->GetFileSize(MemmappedVariableRegionName(variable.key),
+                            &region_size)
+               .ok() ||
+          region_size !=
+              variable.shape.num_elements() * DataTypeSize(variable.dtype)) {
+        continue;
+      }
+      NodeDef* node = FindRestoredVariable(index, restore, i, &variable);
+      if (node == nullptr || claimed.count(node) > 0 ||
+          !CollectVariableUses(index, node, initializers, &variable)) {
+        continue;
+      }
+      claimed.insert(node);
+      memmapped[i] = true;
+      variables.push_back(std::move(variable));
+    }
+    if (std::find(memmapped.begin(), memmapped.end(), true) !=
+        memmapped.end()) {
+      restores.emplace_back(&restore, std::move(memmapped));
+    }
+  }
+  if (variables.empty()) return Status::OK();
+
+  std::unordered_set<string> removed;
+  for (const MemmappedVariable& variable : variables) {
+    for (NodeDef* node : variable.readers) {
+      ConvertToImmutableConst(variable, node);
+    }
+    for (NodeDef* node : variable.initialized_checks) {
+      ConvertToTrue(node);
+    }
+    removed.insert(variable.writers.begin(), variable.writers.end());
+  }
+  for (auto& restore : restores) {
+    PruneRestore(index, restore.second, restore.first, &removed);
+  }
+  RemoveNodes(removed, graph);
+  *num_rewritten = variables.size();
+  return Status::OK();
+}
+
+Status MaybeMemmapSavedModelVariables(
+    Env* env, const string& export_dir, MetaGraphDef* meta_graph_def,
+    std::unique_ptr<MemmappedEnv>* memmapped_env) {
+  const string variables_path = VariablesPath(export_dir);
+  const string package_path = PackagePath(export_dir);
+  if (!meta_graph_def->has_saver_def() ||
+      !env->FileExists(MetaFilename(variables_path)).ok()) {
+    return Status::OK();
+  }
+  if (!env->FileExists(package_path).ok()) {
+    LOG(INFO) << "No memory-mapped variables in SavedModel bundle at path: "
+              << export_dir;
+    return Status::OK();
+  }
+  FileStatistics package_stat, index_stat;
+  TF_RETURN_IF_ERROR(env->Stat(package_path, &package_stat));
+  TF_RETURN_IF_ERROR(env->Stat(MetaFilename(variables_path), &index_stat));
+  if (package_stat.mtime_nsec < index_stat.mtime_nsec) {
+    LOG(WARNING) << "Ignoring " << package_path
+                 << ", which is older than the variables it was written from.";
+    return Status::OK();
+  }
+
+  auto package_env = absl::make_unique<MemmappedEnv>(env);
+  TF_RETURN_IF_ERROR(package_env->InitializeFromFile(package_path));
+  int num_rewritten = 0;
+  TF_RETURN_IF_ERROR(RewriteGraphForMemmappedVariables(
+      package_env.get(), variables_path, meta_graph_def, &num_rewritten));
+  LOG(INFO) << "Serving " << num_rewritten
+            << " variables from memory-mapped package " << package_path;
+  if (num_rewritten > 0) *memmapped_env = std::move(package_env);
+  return Status::OK();
+}
+
+}  // namespace internal
+}  // namespace tensorflow
@@ -0,0 +1,72 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_MEMMAPPED_VARIABLES_H_
+#define TENSORFLOW_CC_SAVED_MODEL_MEMMAPPED_VARIABLES_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+
+namespace tensorflow {
+
+/// Writes the variables of the SavedModel in `export_dir` that can be served
+/// from read-only memory (unpartitioned, non-empty tensors of memcpy-able
+/// types) into a MemmappedFileSystem package next to the variables bundle,
+/// each aligned for use as a tensor buffer.
+///
+/// A SavedModel loaded with
+/// `ConfigProto.Experimental.use_memmapped_saved_model_variables` serves the
+/// variables that no op other than their initializer and the saver's restore
+/// op assigns from this package instead of restoring them, so their pages
+/// are shared by all processes serving the model. The package must be
+/// rewritten whenever the variables are saved again; an older package is
+/// ignored.
+Status WriteMemmappedSavedModelVariables(const string& export_dir);
+
+namespace internal {
+
+// Returns the name of the package region that holds the variable saved under
+// `key` in the variables bundle.
+string MemmappedVariableRegionName(const string& key);
+
+// Rewrites `meta_graph_def` so that each variable restored from
+// `variables_path` that has a matching region in `env`, lives on the CPU, and
+// is never assigned except by its initializer and the saver's restore op, is
+// read from an ImmutableConst node over that region. The assignments are
+// removed, as are the now unused outputs of the restore ops. Stores the number
+// of rewritten variables in `*num_rewritten`.
+Status RewriteGraphForMemmappedVariables(Env* env,
+                                         const string& variables_path,
+                                         MetaGraphDef* meta_graph_def,
+                                         int* num_rewritten);
+
+// If `export_dir` has a package written by WriteMemmappedSavedModelVariables()
+// that is up to date, rewrites `meta_graph_def` to read its variables from the
+// package and sets `*memmapped_env` to an environment over `env` that serves
+// it; the session must be created with that environment. Otherwise leaves
+// both unchanged.
+Status MaybeMemmapSavedModelVariables(
+    Env* env, const string& export_dir, MetaGraphDef* meta_graph_def,
+    std::unique_ptr<MemmappedEnv>* memmapped_env);
+
+}  // namespace internal
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_MEMMAPPED_VARIABLES_H_
@@ -0,0 +1,202 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestDataSharded[] =
+    "cc/saved_model/testdata/half_plus_two/00000123";
+
+class MemmappedVariablesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Copies the SavedModel so that the package can be written next to its
+    // variables.
+    const string src_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+    export_dir_ = io::JoinPath(testing::TmpDir(), "memmapped_half_plus_two");
+    Env* env = Env::Default();
+    int64 undeleted_files, undeleted_dirs;
+    env->DeleteRecursively(export_dir_, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+    for (const char* dir :
+         {kSavedModelVariablesDirectory, kSavedModelAssetsDirectory}) {
+      TF_ASSERT_OK(env->RecursivelyCreateDir(io::JoinPath(export_dir_, dir)));
+      std::vector<string> children;
+      TF_ASSERT_OK(env->GetChildren(io::JoinPath(src_dir, dir), &children));
+      for (const string& child : children) {
+        CopyFile(io::JoinPath(src_dir, dir, child),
+                 io::JoinPath(export_dir_, dir, child));
+      }
+    }
+    CopyFile(io::JoinPath(src_dir, kSavedModelFilenamePb),
+             io::JoinPath(export_dir_, kSavedModelFilenamePb));
+  }
+
+  void CopyFile(const string& src, const string& dst) {
+    string contents;
+    TF_ASSERT_OK(ReadFileToString(Env::Default(), src, &contents));
+    TF_ASSERT_OK(WriteStringToFile(Env::Default(), dst, contents));
+  }
+
+  string MakeSerializedExample(float x) {
+    tensorflow::Example example;
+    auto* feature_map = example.mutable_features()->mutable_feature();
+    (*feature_map)["x"].mutable_float_list()->add_value(x);
+    return example.SerializeAsString();
+  }
+
+  void CheckRegression(const SavedModelBundleInterface& bundle) {
+    const auto& signature_def = bundle.GetSignatures().at("regress_x_to_y");
+    const string input_name = signature_def.inputs().at(kRegressInputs).name();
+    const string output_name =
+        signature_def.outputs().at(kRegressOutputs).name();
+    std::vector<tstring> serialized_examples;
+    for (float x : {0, 1, 2, 3}) {
+      serialized_examples.push_back(MakeSerializedExample(x));
+    }
+    Tensor input =
+        test::AsTensor<tstring>(serialized_examples, TensorShape({4}));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(bundle.GetSession()->Run({{input_name, input}},
+                                          {output_name}, {}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    test::ExpectTensorEqual<float>(
+        outputs[0],
+        test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
+  }
+
+  SessionOptions MemmappedSessionOptions() {
+    SessionOptions session_options;
+    session_options.config.mutable_experimental()
+        ->set_use_memmapped_saved_model_variables(true);
+    return session_options;
+  }
+
+  const NodeDef* FindNode(const MetaGraphDef& meta_graph_def,
+                          const string& name) {
+    for (const NodeDef& node : meta_graph_def.graph_def().node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+
+  string export_dir_;
+};
+
+TEST_F(MemmappedVariablesTest, RegionName) {
+  const string name = internal::MemmappedVariableRegionName("dense/kernel_1.x");
+  EXPECT_EQ(name, "memmapped_package://dense_2Fkernel_5F1.x");
+  EXPECT_TRUE(MemmappedFileSystem::IsWellFormedMemmappedPackageFilename(name));
+}
+
+TEST_F(MemmappedVariablesTest, RewritesVariablesWithoutAssignments) {
+  TF_ASSERT_OK(WriteMemmappedSavedModelVariables(export_dir_));
+  MetaGraphDef meta_graph_def;
+  TF_ASSERT_OK(ReadMetaGraphDefFromSavedModel(
+      export_dir_, {kSavedModelTagServe}, &meta_graph_def));
+  // Assigning to `a` outside of its initializer keeps it a variable.
+  NodeDef* assign_add = meta_graph_def.mutable_graph_def()->add_node();
+  assign_add->set_name("a/AssignAdd");
+  assign_add->set_op("AssignAdd");
+  assign_add->add_input("a");
+  assign_add->add_input("a/initial_value");
+  (*assign_add->mutable_attr())["T"].set_type(DT_FLOAT);
+
+  MemmappedEnv env(Env::Default());
+  TF_ASSERT_OK(env.InitializeFromFile(io::JoinPath(
+      export_dir_, kSavedModelVariablesDirectory,
+      kSavedModelMemmappedVariablesFilename)));
+  int num_rewritten = 0;
+  TF_ASSERT_OK(internal::RewriteGraphForMemmappedVariables(
+      &env,
+      io::JoinPath(export_dir_, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename),
+      &meta_graph_def, &num_rewritten));
+  EXPECT_EQ(num_rewritten, 2);
+
+  EXPECT_EQ(FindNode(meta_graph_def, "a")->op(), "VariableV2");
+  EXPECT_NE(FindNode(meta_graph_def, "a/Assign"), nullptr);
+  for (const string& name : {"b", "c"}) {
+    const NodeDef* node = FindNode(meta_graph_def, name);
+    EXPECT_EQ(node->op(), "ImmutableConst");
+    EXPECT_EQ(node->attr().at("memory_region_name").s(),
+              internal::MemmappedVariableRegionName(name));
+    EXPECT_EQ(FindNode(meta_graph_def, name + "/Assign"), nullptr);
+  }
+  // Only the restore op of `a` is left.
+  int num_restores = 0;
+  for (const NodeDef& node : meta_graph_def.graph_def().node()) {
+    if (node.op() == "RestoreV2") ++num_restores;
+    if (node.op() == "Assign") {
+      EXPECT_TRUE(node.input(0) == "a" || node.input(0) == "filename_tensor")
+          << node.DebugString();
+    }
+  }
+  EXPECT_EQ(num_restores, 1);
+}
+
+TEST_F(MemmappedVariablesTest, LoadsVariablesFromPackage) {
+  TF_ASSERT_OK(WriteMemmappedSavedModelVariables(export_dir_));
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(MemmappedSessionOptions(), RunOptions(),
+                              export_dir_, {kSavedModelTagServe}, &bundle));
+  EXPECT_NE(bundle.session_env, nullptr);
+  // The bundle keeps the graph as saved.
+  EXPECT_EQ(FindNode(bundle.meta_graph_def, "a")->op(), "VariableV2");
+  CheckRegression(bundle);
+
+  SavedModelBundleLite lite_bundle;
+  TF_ASSERT_OK(LoadSavedModel(MemmappedSessionOptions(), RunOptions(),
+                              export_dir_, {kSavedModelTagServe},
+                              &lite_bundle));
+  CheckRegression(lite_bundle);
+}
+
+TEST_F(MemmappedVariablesTest, RestoresVariablesWithoutPackage) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(MemmappedSessionOptions(), RunOptions(),
+                              export_dir_, {kSavedModelTagServe}, &bundle));
+  EXPECT_EQ(bundle.session_env, nullptr);
+  CheckRegression(bundle);
+}
+
+TEST_F(MemmappedVariablesTest, IgnoresPackageWithoutOption) {
+  TF_ASSERT_OK(WriteMemmappedSavedModelVariables(export_dir_));
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {kSavedModelTagServe}, &bundle));
+  EXPECT_EQ(bundle.session_env, nullptr);
+  CheckRegression(bundle);
+}
+
+}  // namespace
+}  // namespace tensorflow
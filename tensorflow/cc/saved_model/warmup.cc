@@ -0,0 +1,235 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// Upper bound on the number of records in a warmup file, so that a file
+// recorded by mistake from a whole day of traffic does not hold up loading.
+constexpr int kMaxWarmupRequests = 1000;
+
+uint64 GetLatencyMicroseconds(const uint64 start_microseconds) {
+  const uint64 end_microseconds = EnvTime::NowMicros();
+  // Avoid clock skew.
+  if (end_microseconds < start_microseconds) return 0;
+  return end_microseconds - start_microseconds;
+}
+
+// A warmup request resolved against its SignatureDef.
+struct PreparedRequest {
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_tensor_names;
+  int num_runs;
+};
+
+Status PrepareRequest(const MetaGraphDef& meta_graph_def,
+                      const SavedModelWarmupRequest& request,
+                      string* signature_name, PreparedRequest* prepared) {
+  *signature_name = request.signature_name().empty()
+                        ? kDefaultServingSignatureDefKey
+                        : request.signature_name();
+  const auto signature_it =
+      meta_graph_def.signature_def().find(*signature_name);
+  if (signature_it == meta_graph_def.signature_def().end()) {
+    return errors::InvalidArgument("Warmup request for signature \"",
+                                   *signature_name,
+                                   "\", which the SavedModel does not have");
+  }
+  const SignatureDef& signature = signature_it->second;
+
+  // Sort the inputs by key, rather than map order, so that equal requests
+  // feed the same list.
+  std::map<string, const TensorProto*> sorted_inputs;
+  for (const auto& input : request.inputs()) {
+    sorted_inputs[input.first] = &input.second;
+  }
+  for (const auto& input : sorted_inputs) {
+    const auto info_it = signature.inputs().find(input.first);
+    if (info_it == signature.inputs().end()) {
+      return errors::InvalidArgument("Warmup request for signature \"",
+                                     *signature_name, "\" has input \"",
+                                     input.first,
+                                     "\", which the signature does not have");
+    }
+    Tensor tensor;
+    if (!tensor.FromProto(*input.second)) {
+      return errors::InvalidArgument("Warmup request for signature \"",
+                                     *signature_name, "\" has input \"",
+                                     input.first, "\" with an invalid tensor");
+    }
+    prepared->inputs.emplace_back(info_it->second.name(), std::move(tensor));
+  }
+
+  if (request.output_filter().empty()) {
+    for (const auto& output : signature.outputs()) {
+      prepared->output_tensor_names.push_back(output.second.name());
+    }
+  } else {
+    for (const string& output_key : request.output_filter()) {
+      const auto info_it = signature.outputs().find(output_key);
+      if (info_it == signature.outputs().end()) {
+        return errors::InvalidArgument(
+            "Warmup request for signature \"", *signature_name,
+            "\" fetches output \"", output_key,
+            "\", which the signature does not have");
+      }
+      prepared->output_tensor_names.push_back(info_it->second.name());
+    }
+  }
+  std::sort(prepared->output_tensor_names.begin(),
+            prepared->output_tensor_names.end());
+  prepared->num_runs = std::max(request.num_runs(), 1);
+  return Status::OK();
+}
+
+// Reads the warmup requests of the SavedModel in `export_dir`, if it has any,
+// and groups them by signature.
+Status ReadWarmupRequests(
+    const string& export_dir, const MetaGraphDef& meta_graph_def,
+    std::map<string, std::vector<PreparedRequest>>* requests) {
+  const string path = io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                                   kSavedModelWarmupRequestsFilename);
+  Env* env = Env::Default();
+  if (!env->FileExists(path).ok()) return Status::OK();
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(path, &file));
+  io::SequentialRecordReader reader(file.get());
+  tstring record;
+  for (int num_records = 0;; ++num_records) {
+    const Status status = reader.ReadRecord(&record);
+    if (errors::IsOutOfRange(status)) break;
+    TF_RETURN_IF_ERROR(status);
+    if (num_records == kMaxWarmupRequests) {
+      return errors::InvalidArgument("More than ", kMaxWarmupRequests,
+                                     " warmup requests in ", path);
+    }
+    SavedModelWarmupRequest request;
+    if (!request.ParseFromArray(record.data(), record.size())) {
+      return errors::DataLoss("Failed to parse warmup request ", num_records,
+                              " in ", path);
+    }
+    string signature_name;
+    PreparedRequest prepared;
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(
+        PrepareRequest(meta_graph_def, request, &signature_name, &prepared),
+        "in ", path);
+    (*requests)[signature_name].push_back(std::move(prepared));
+  }
+  return Status::OK();
+}
+
+Status ReplaySignature(const RunOptions& run_options,
+                       const std::vector<PreparedRequest>& requests,
+                       Session* session,
+                       SavedModelWarmupStats::SignatureStats* stats) {
+  const uint64 start_microseconds = EnvTime::NowMicros();
+  std::set<std::pair<std::vector<string>, std::vector<string>>> executors;
+  std::vector<Tensor> outputs;
+  for (const PreparedRequest& request : requests) {
+    std::vector<string> input_names;
+    for (const auto& input : request.inputs) {
+      input_names.push_back(input.first);
+    }
+    executors.emplace(std::move(input_names), request.output_tensor_names);
+    for (int i = 0; i < request.num_runs; ++i) {
+      const uint64 run_start_microseconds = EnvTime::NowMicros();
+      TF_RETURN_IF_ERROR(session->Run(run_options, request.inputs,
+                                      request.output_tensor_names, {},
+                                      &outputs, nullptr /* run_metadata */));
+      stats->last_run_microseconds =
+          GetLatencyMicroseconds(run_start_microseconds);
+      if (stats->num_runs++ == 0) {
+        stats->first_run_microseconds = stats->last_run_microseconds;
+      }
+    }
+  }
+  stats->num_requests = requests.size();
+  stats->num_executors = executors.size();
+  stats->replay_microseconds = GetLatencyMicroseconds(start_microseconds);
+  return Status::OK();
+}
+
+}  // namespace
+
+Status WarmupSavedModel(const RunOptions& run_options,
+                        const string& export_dir,
+                        const MetaGraphDef& meta_graph_def, Session* session,
+                        SavedModelWarmupStats* stats) {
+  *stats = SavedModelWarmupStats();
+  const uint64 read_start_microseconds = EnvTime::NowMicros();
+  std::map<string, std::vector<PreparedRequest>> requests;
+  TF_RETURN_IF_ERROR(ReadWarmupRequests(export_dir, meta_graph_def, &requests));
+  stats->read_microseconds = GetLatencyMicroseconds(read_start_microseconds);
+  if (requests.empty()) return Status::OK();
+
+  const uint64 replay_start_microseconds = EnvTime::NowMicros();
+  stats->signatures.resize(requests.size());
+  std::vector<Status> statuses(requests.size());
+  {
+    const int num_threads =
+        std::min<int>(requests.size(), port::MaxParallelism());
+    thread::ThreadPool pool(Env::Default(), "saved_model_warmup",
+                            num_threads);
+    int i = 0;
+    for (const auto& signature_requests : requests) {
+      SavedModelWarmupStats::SignatureStats* signature_stats =
+          &stats->signatures[i];
+      Status* status = &statuses[i];
+      signature_stats->signature_name = signature_requests.first;
+      const std::vector<PreparedRequest>* prepared =
+          &signature_requests.second;
+      pool.Schedule([&run_options, session, prepared, signature_stats,
+                     status]() {
+        *status =
+            ReplaySignature(run_options, *prepared, session, signature_stats);
+      });
+      ++i;
+    }
+    // The pool waits for all signatures when it goes out of scope.
+  }
+  stats->replay_microseconds =
+      GetLatencyMicroseconds(replay_start_microseconds);
+  for (int i = 0; i < statuses.size(); ++i) {
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(
+        statuses[i], "while warming up signature \"",
+        stats->signatures[i].signature_name, "\"");
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
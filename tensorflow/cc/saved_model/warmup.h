@@ -0,0 +1,74 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+#define TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+
+/// What WarmupSavedModel() replayed, and how long it took.
+struct SavedModelWarmupStats {
+  struct SignatureStats {
+    string signature_name;
+    /// Number of warmup requests for the signature.
+    int num_requests = 0;
+    /// Number of Session::Run() calls made for them.
+    int num_runs = 0;
+    /// Number of distinct sets of feeds and fetches among the requests. The
+    /// session caches an executor for each.
+    int num_executors = 0;
+    /// Wall time of the first run, which pays for creating the executor,
+    /// compiling and autotuning kernels and growing the allocators, and of
+    /// the last run, which should be close to the steady state.
+    uint64 first_run_microseconds = 0;
+    uint64 last_run_microseconds = 0;
+    /// Wall time of all runs for the signature.
+    uint64 replay_microseconds = 0;
+  };
+
+  /// Wall time spent reading and validating the warmup requests.
+  uint64 read_microseconds = 0;
+  /// Wall time spent replaying them, across all signatures.
+  uint64 replay_microseconds = 0;
+  /// One entry per signature with warmup requests, ordered by name.
+  std::vector<SignatureStats> signatures;
+};
+
+/// Replays the warmup requests of the SavedModel in `export_dir`, if it has
+/// any (see tensorflow/core/protobuf/saved_model_warmup.proto), against
+/// `session`, which must run the graph of `meta_graph_def`. Requests for
+/// different signatures run concurrently, those for the same signature one
+/// after another. Each request runs through Session::Run(), so that the
+/// executor it creates stays cached for client requests with the same feeds
+/// and fetches. Fills in `*stats`, and returns the first error of any run.
+///
+/// LoadSavedModel() calls this before returning the bundle.
+Status WarmupSavedModel(const RunOptions& run_options,
+                        const string& export_dir,
+                        const MetaGraphDef& meta_graph_def, Session* session,
+                        SavedModelWarmupStats* stats);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
@@ -0,0 +1,151 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestDataSharded[] =
+    "cc/saved_model/testdata/half_plus_two/00000123";
+
+class WarmupTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(LoadSavedModel(
+        SessionOptions(), RunOptions(),
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded),
+        {kSavedModelTagServe}, &bundle_));
+    // The warmup requests are read from a directory of their own, next to
+    // the test data.
+    warmup_dir_ = io::JoinPath(testing::TmpDir(), "warmup_half_plus_two");
+    int64 undeleted_files, undeleted_dirs;
+    Env::Default()
+        ->DeleteRecursively(warmup_dir_, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+  }
+
+  SavedModelWarmupRequest MakeRequest(const string& signature_name,
+                                      const string& input_key,
+                                      const std::vector<float>& values,
+                                      int num_runs) {
+    SavedModelWarmupRequest request;
+    request.set_signature_name(signature_name);
+    test::AsTensor<float>(values, {static_cast<int64>(values.size()), 1})
+        .AsProtoTensorContent(&(*request.mutable_inputs())[input_key]);
+    request.set_num_runs(num_runs);
+    return request;
+  }
+
+  void WriteRequests(const std::vector<SavedModelWarmupRequest>& requests) {
+    const string dir =
+        io::JoinPath(warmup_dir_, kSavedModelAssetsExtraDirectory);
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(
+        io::JoinPath(dir, kSavedModelWarmupRequestsFilename), &file));
+    io::RecordWriter writer(file.get());
+    for (const SavedModelWarmupRequest& request : requests) {
+      TF_ASSERT_OK(writer.WriteRecord(request.SerializeAsString()));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
+  Status Warmup(SavedModelWarmupStats* stats) {
+    return WarmupSavedModel(RunOptions(), warmup_dir_, bundle_.meta_graph_def,
+                            bundle_.session.get(), stats);
+  }
+
+  SavedModelBundle bundle_;
+  string warmup_dir_;
+};
+
+TEST_F(WarmupTest, NoRequests) {
+  SavedModelWarmupStats stats;
+  TF_ASSERT_OK(Warmup(&stats));
+  EXPECT_TRUE(stats.signatures.empty());
+}
+
+TEST_F(WarmupTest, ReplaysRequestsBySignature) {
+  SavedModelWarmupRequest filtered =
+      MakeRequest("", "x", {1.0, 2.0, 3.0}, 1);
+  filtered.add_output_filter("y");
+  WriteRequests({MakeRequest("regress_x2_to_y3", "inputs", {1.0}, 0),
+                 MakeRequest("", "x", {1.0, 2.0}, 3), filtered});
+
+  SavedModelWarmupStats stats;
+  TF_ASSERT_OK(Warmup(&stats));
+  ASSERT_EQ(stats.signatures.size(), 2);
+
+  const auto& regress = stats.signatures[0];
+  EXPECT_EQ(regress.signature_name, "regress_x2_to_y3");
+  EXPECT_EQ(regress.num_requests, 1);
+  EXPECT_EQ(regress.num_runs, 1);
+  EXPECT_EQ(regress.num_executors, 1);
+
+  // Both requests for the default signature feed and fetch the same tensors,
+  // so they share an executor.
+  const auto& serving = stats.signatures[1];
+  EXPECT_EQ(serving.signature_name, "serving_default");
+  EXPECT_EQ(serving.num_requests, 2);
+  EXPECT_EQ(serving.num_runs, 4);
+  EXPECT_EQ(serving.num_executors, 1);
+  EXPECT_LE(serving.last_run_microseconds, serving.replay_microseconds);
+}
+
+TEST_F(WarmupTest, UnknownSignature) {
+  WriteRequests({MakeRequest("no_such_signature", "x", {1.0}, 1)});
+  SavedModelWarmupStats stats;
+  const Status status = Warmup(&stats);
+  EXPECT_EQ(status.code(), error::INVALID_ARGUMENT);
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "no_such_signature"))
+      << status;
+}
+
+TEST_F(WarmupTest, UnknownInput) {
+  WriteRequests({MakeRequest("", "x2", {1.0}, 1)});
+  SavedModelWarmupStats stats;
+  const Status status = Warmup(&stats);
+  EXPECT_EQ(status.code(), error::INVALID_ARGUMENT);
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "x2")) << status;
+}
+
+TEST_F(WarmupTest, FailedRun) {
+  // The signature's input is a float tensor.
+  SavedModelWarmupRequest request;
+  test::AsTensor<int32>({1, 2}, {2, 1})
+      .AsProtoTensorContent(&(*request.mutable_inputs())["x"]);
+  WriteRequests({request});
+  SavedModelWarmupStats stats;
+  const Status status = Warmup(&stats);
+  EXPECT_FALSE(status.ok());
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "serving_default"))
+      << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
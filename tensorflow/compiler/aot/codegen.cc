@@ -312,6 +312,79 @@ Status GenVariableMethods(const tf2xla::Config& config,
   return Status::OK();
 }
 
+// Generates the methods of functions compiled for batches of requests.
+Status GenBatchMethods(const CodegenOpts& opts, const tf2xla::Config& config,
+                       const xla::ProgramShapeProto& ps, string* methods) {
+  if (opts.batch_size <= 0) return Status::OK();
+  if (config.variable_size() > 0) {
+    return errors::InvalidArgument(
+        "batch_size is not supported for graphs with variables");
+  }
+  const auto check_batched = [&](const xla::Shape& shape, const string& what) {
+    if (shape.rank() == 0 || shape.dimensions(0) % opts.batch_size != 0) {
+      return errors::InvalidArgument(
+          what, " must have a leading dimension divisible by batch_size ",
+          opts.batch_size, ", got shape ", xla::ShapeUtil::HumanString(shape));
+    }
+    return Status::OK();
+  };
+  if (ps.parameters_size() != config.feed_size()) {
+    return errors::InvalidArgument("mismatch between feed_size(",
+                                   config.feed_size(), ") and num_args(",
+                                   ps.parameters_size(), ")");
+  }
+  for (int i = 0; i < config.feed_size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        check_batched(xla::Shape(ps.parameters(i)), absl::StrCat("arg ", i)));
+  }
+  std::vector<string> result_sizes;
+  for (int i = 0; i < config.fetch_size(); ++i) {
+    const xla::Shape shape(ps.result().tuple_shapes(i));
+    TF_RETURN_IF_ERROR(check_batched(shape, absl::StrCat("result ", i)));
+    result_sizes.push_back(
+        absl::StrCat(xla::ShapeUtil::ByteSizeOfElements(shape)));
+  }
+  *methods = R"(
+  // Number of requests batched into each Run call. The leading dimension of
+  // each arg and result holds kBatchSize requests.
+  static constexpr int kBatchSize = {{BATCH_SIZE}};
+
+  // Number of results of the compiled computation.
+  static constexpr size_t kNumResults = {{RESULT_NUM}};
+
+  // Byte size of each result buffer. There are kNumResults entries.
+  static const ::tensorflow::int64 ResultSize(::tensorflow::int32 index) {
+    static constexpr ::tensorflow::int64 kResultSizes[kNumResults] = {
+      {{RESULT_SIZES}}
+    };
+    return kResultSizes[index];
+  }
+
+  // Returns a thread-safe runner, which runs a new {{CLASS}} on the args of
+  // up to kBatchSize concurrent callers at once.
+  static std::unique_ptr<::tensorflow::XlaBatchedCpuFunctionRunner>
+  NewBatchRunner(
+      const ::tensorflow::XlaBatchedCpuFunctionRunner::Options& options =
+          ::tensorflow::XlaBatchedCpuFunctionRunner::Options()) {
+    std::vector<::tensorflow::int64> result_sizes;
+    for (size_t i = 0; i < kNumResults; ++i) {
+      result_sizes.push_back(ResultSize(i));
+    }
+    return std::unique_ptr<::tensorflow::XlaBatchedCpuFunctionRunner>(
+        new ::tensorflow::XlaBatchedCpuFunctionRunner(
+            std::unique_ptr<::tensorflow::XlaCompiledCpuFunction>(
+                new {{CLASS}}),
+            kBatchSize, std::move(result_sizes), options));
+  }
+)";
+  absl::StrReplaceAll({{"{{BATCH_SIZE}}", absl::StrCat(opts.batch_size)},
+                       {"{{CLASS}}", opts.class_name},
+                       {"{{RESULT_NUM}}", absl::StrCat(config.fetch_size())},
+                       {"{{RESULT_SIZES}}", absl::StrJoin(result_sizes, ", ")}},
+                      methods);
+  return Status::OK();
+}
+
 // Generates code implementing {Arg,Result}Names(), where T is one of
 // tf2xla::{Feed,Fetch,Variable}. Each feed or fetch name results in a C-style
 // string literal in the array, with nullptr terminating the array.
@@ -415,10 +488,11 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
   std::vector<BufferInfo> buffer_infos_for_temps =
       ExtractTempBufferInfos(buffer_infos);
   const xla::ProgramShapeProto& ps = compile_result.program_shape;
-  string methods_arg, methods_result, methods_variable;
+  string methods_arg, methods_result, methods_variable, methods_batch;
   TF_RETURN_IF_ERROR(GenArgMethods(config, ps, compile_result, &methods_arg));
   TF_RETURN_IF_ERROR(GenResultMethods(config, ps, &methods_result));
   TF_RETURN_IF_ERROR(GenVariableMethods(config, ps, &methods_variable));
+  TF_RETURN_IF_ERROR(GenBatchMethods(opts, config, ps, &methods_batch));
   const size_t arg_bytes_aligned =
       xla::cpu_function_runtime::AlignedBufferBytes(
           buffer_infos_for_args.data(), buffer_infos_for_args.size(),
@@ -467,6 +541,13 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
           ? R"(#include "tensorflow/compiler/xla/service/hlo_profile_printer_data.pb.h")"
           : "";
 
+  const string include_batch_runner =
+      opts.batch_size > 0
+          ? "#include <memory>\n#include <vector>\n"
+            R"(#include "tensorflow/compiler/tf2xla/xla_batched_cpu_function_runner.h")"
+            "\n"
+          : "";
+
   // When HLO profiling is disabled we only forward declare the
   // HloProfilePrinter protobuf.  So we can only conditionally emit this code
   // calling HloProfilePrinter::profile_counters_size.
@@ -493,6 +574,7 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
 
 {{INCLUDE_XLA_DATA_PROTO}}
 {{INCLUDE_HLO_PROFILE_PRINTER_DATA_PROTO}}
+{{INCLUDE_BATCH_RUNNER}}
 #include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -641,6 +723,7 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
   // buffer is not const (and thus the const can be safely const-cast'ed away)
   // unless `set_var_X_data` is called with a pointer to constant storage.
 {{METHODS_VARIABLE}}
+{{METHODS_BATCH}}
 
  private:
   // Number of buffers for the compiled computation.
@@ -713,6 +796,8 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
       {"{{METHODS_ARG}}\n", methods_arg},
       {"{{METHODS_RESULT}}\n", methods_result},
       {"{{METHODS_VARIABLE}}\n", methods_variable},
+      {"{{METHODS_BATCH}}\n", methods_batch},
+      {"{{INCLUDE_BATCH_RUNNER}}\n", include_batch_runner},
       {"{{NS_END}}\n", ns_end},
       {"{{NS_START}}\n", ns_start},
       {"{{PROGRAM_SHAPE}}", xla::ShapeUtil::HumanString(xla::ProgramShape(ps))},
@@ -48,6 +48,11 @@ struct CodegenOpts {
   // If true, emit a serialized HloProfilePrinterData protobuf that can be used
   // to pretty print HLO profile counters.
   bool gen_hlo_profile_printer_data = false;
+
+  // If positive, the function was compiled for batches of this many requests
+  // along the leading dimension of each feed and fetch, and a NewBatchRunner
+  // method is generated, see XlaBatchedCpuFunctionRunner.
+  int batch_size = 0;
 };
 
 // Describes a generated metadata object file.
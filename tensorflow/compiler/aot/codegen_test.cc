@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -264,6 +265,55 @@ TEST(CodegenTest, Golden) {
   CompareWithGoldenFile("tensorflow/compiler/aot/codegen_test_h.golden", header,
                         true);
 }
+TEST(CodegenTest, BatchSize) {
+  CodegenOpts opts;
+  opts.class_name = "MyClass";
+  opts.target_triple = "x86_64-pc-linux";
+  opts.batch_size = 4;
+  tf2xla::Config config;
+  config.add_feed()->mutable_id()->set_node_name("feed0");
+  config.add_fetch()->mutable_id()->set_node_name("fetch0");
+  CompileResult compile_result;
+  compile_result.aot.reset(new xla::cpu::CpuAotCompilationResult(
+      {},
+      {BufferInfo::MakeEntryParameter(/*size=*/32, /*param_number=*/0),
+       BufferInfo::MakeTempBuffer(8), BufferInfo::MakeTempBuffer(64)},
+      1, {}));
+  compile_result.program_shape =
+      xla::ShapeUtil::MakeProgramShape(
+          {xla::ShapeUtil::MakeShape(xla::F32, {4, 2})},
+          xla::ShapeUtil::MakeTupleShape(
+              {xla::ShapeUtil::MakeShape(xla::F32, {8, 2})}))
+          .ToProto();
+  compile_result.entry_point = "entry_point";
+  compile_result.pointer_size = 8;
+
+  MetadataResult metadata_result;
+  string header;
+  TF_ASSERT_OK(
+      GenerateHeader(opts, config, compile_result, metadata_result, &header));
+  EXPECT_THAT(header,
+              ::testing::HasSubstr("xla_batched_cpu_function_runner.h"));
+  EXPECT_THAT(header, ::testing::HasSubstr("kBatchSize = 4;"));
+  EXPECT_THAT(header, ::testing::HasSubstr("kNumResults = 1;"));
+  EXPECT_THAT(header, ::testing::HasSubstr("kResultSizes[kNumResults] = {\n"
+                                           "      64\n"));
+  EXPECT_THAT(header, ::testing::HasSubstr("new MyClass)"));
+
+  // Fetches must be divisible into batch_size requests.
+  compile_result.program_shape =
+      xla::ShapeUtil::MakeProgramShape(
+          {xla::ShapeUtil::MakeShape(xla::F32, {4, 2})},
+          xla::ShapeUtil::MakeTupleShape(
+              {xla::ShapeUtil::MakeShape(xla::F32, {2})}))
+          .ToProto();
+  Status status =
+      GenerateHeader(opts, config, compile_result, metadata_result, &header);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+  EXPECT_THAT(status.error_message(),
+              ::testing::HasSubstr("result 0 must have a leading dimension"));
+}
+
 }  // namespace
 }  // namespace tfcompile
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/compile.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
@@ -147,6 +149,7 @@ Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
+  aot_opts.set_max_parallelism(std::max(flags.max_parallelism, 1));
 
   return CompileXla(client, computation, aot_opts, compile_result);
 }
@@ -159,6 +162,22 @@ static Status ReadProtoFile(const string& fname, protobuf::Message* proto) {
   }
 }
 
+// Multiplies the leading dimension of each feed by `batch_size`, so that the
+// function is compiled for batches of requests.
+static Status BatchFeeds(int batch_size, tf2xla::Config* config) {
+  for (tf2xla::Feed& feed : *config->mutable_feed()) {
+    if (feed.shape().unknown_rank() || feed.shape().dim_size() == 0) {
+      return errors::InvalidArgument(
+          "batch_size requires feed ", feed.id().node_name(),
+          " to have a leading dimension, got shape ",
+          TensorShape::DebugString(feed.shape()));
+    }
+    TensorShapeProto::Dim* dim = feed.mutable_shape()->mutable_dim(0);
+    dim->set_size(dim->size() * batch_size);
+  }
+  return Status::OK();
+}
+
 static absl::once_flag targets_init;
 
 static void InitializeTargets() {
@@ -216,6 +235,9 @@ Status Main(const MainFlags& flags) {
   }
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, &config));
   TF_RETURN_IF_ERROR(ValidateConfig(config));
+  if (flags.batch_size > 0) {
+    TF_RETURN_IF_ERROR(BatchFeeds(flags.batch_size, &config));
+  }
   if (flags.dump_fetch_nodes) {
     std::set<string> nodes;
     for (const tf2xla::Fetch& fetch : config.fetch()) {
@@ -249,6 +271,7 @@ Status Main(const MainFlags& flags) {
   CodegenOpts codegen_opts;
   codegen_opts.gen_name_to_index = flags.gen_name_to_index;
   codegen_opts.gen_program_shape = flags.gen_program_shape;
+  codegen_opts.batch_size = flags.batch_size;
   codegen_opts.target_triple = flags.target_triple;
   if (flags.cpp_class.empty()) {
     return errors::InvalidArgument("Must specify --cpp_class");
@@ -80,10 +80,22 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
       {"experimental_quantize", &flags->experimental_quantize,
        "If set, quantization passes will run and dump the result before HLO "
        "code generation."},
+      {"max_parallelism", &flags->max_parallelism,
+       "Maximum number of partitions each HLO may be split into.  Values "
+       "greater than 1 emit fork-join calls that run the partitions on the "
+       "Eigen thread pool passed to the generated class via set_thread_pool, "
+       "or on the calling thread if no pool is set.  Requires linking "
+       "//tensorflow/compiler/xla/service/cpu:runtime_fork_join."},
       {"gen_name_to_index", &flags->gen_name_to_index,
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
        "Generate program shape data for the ProgramShape method."},
+      {"batch_size", &flags->batch_size,
+       "If positive, compile the function for batches of this many requests, "
+       "by multiplying the leading dimension of each feed by batch_size, and "
+       "generate a NewBatchRunner method that batches concurrent single "
+       "requests. Fetches must have a leading dimension divisible by "
+       "batch_size, and the graph must not have variables."},
   };
   flag_list->insert(flag_list->end(), tmp.begin(), tmp.end());
 }
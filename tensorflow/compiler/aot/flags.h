@@ -43,10 +43,12 @@ struct MainFlags {
   string out_session_module;
   string mlir_components;
   bool experimental_quantize = false;
+  int max_parallelism = 1;
 
   // C++ codegen options
   bool gen_name_to_index = false;
   bool gen_program_shape = false;
+  int batch_size = 0;
 };
 
 // Appends to flag_list a tensorflow::Flag for each field in MainFlags.
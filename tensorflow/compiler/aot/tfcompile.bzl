@@ -40,6 +40,8 @@ def tf_library(
         enable_xla_hlo_profiling = False,
         enable_tracemes = False,
         mlir_components = "None",
+        batch_size = 0,
+        max_parallelism = 1,
         deps = None,
         tags = []):
     """Runs tfcompile to compile a TensorFlow graph into executable code with fast
@@ -96,6 +98,12 @@ def tf_library(
         Xprof to construct profiler timelines.
       mlir_components: When the value is "None", no components use MLIR. When
         the value is "Bridge", use MLIR to translate GraphDef to HLO.
+      batch_size: If positive, compile the graph for batches of batch_size
+        requests along the leading dimension of each feed, and generate a
+        NewBatchRunner method that batches concurrent single requests.
+      max_parallelism: Maximum number of partitions each HLO may be split into.
+        Values greater than 1 emit fork-join calls that run on the Eigen thread
+        pool passed to the generated class via set_thread_pool.
       deps: a list of deps to include on the build rules for the generated
         library, added to the standard deps if standard_runtime_deps is True.
       tags: tags to apply to subsidiary build rules.
@@ -188,6 +196,11 @@ def tf_library(
     # `find` on such an object.
     need_xla_data_proto = flags and flags.find("--gen_program_shape") != -1
 
+    if batch_size > 0:
+        flags = flags + " --batch_size=" + str(batch_size)
+    if max_parallelism > 1:
+        flags = flags + " --max_parallelism=" + str(max_parallelism)
+
     target_cpu = tfcompile_target_cpu()
     extra_flags = "--target_cpu=" + target_cpu + " " if target_cpu else " "
     flags = extra_flags + flags
@@ -308,6 +321,10 @@ def tf_library(
             "//tensorflow/compiler/xla:xla_data_proto_cc",
         ] or []) + (enable_xla_hlo_profiling and [
             "//tensorflow/compiler/xla/service:hlo_profile_printer_data_cc",
+        ] or []) + (batch_size > 0 and [
+            "//tensorflow/compiler/tf2xla:xla_batched_cpu_function_runner",
+        ] or []) + (max_parallelism > 1 and [
+            "//tensorflow/compiler/xla/service/cpu:runtime_fork_join",
         ] or []) + (include_standard_runtime_deps and [
             # TODO(cwhipkey): only depend on kernel code that the model actually
             # needed.
@@ -164,6 +164,9 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
   ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_persistent_cache_dir = "";
+  ops_flags->tf_xla_async_compilation_max_fallbacks = 0;
+  ops_flags->tf_xla_shape_buckets = "";
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -222,6 +225,20 @@ void AllocateAndParseFlags() {
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
             "is executed until the compilation has finished."),
+       Flag("tf_xla_async_compilation_max_fallbacks",
+            &ops_flags->tf_xla_async_compilation_max_fallbacks,
+            "With asynchronous compilation, the maximum number of executions "
+            "of a new signature that take the fallback path. Later executions "
+            "wait for the compilation to finish. Zero means no limit."),
+       Flag("tf_xla_shape_buckets", &ops_flags->tf_xla_shape_buckets,
+            "If set, the leading dimension of the parameters of XLA clusters "
+            "is padded up to a bucket and treated as dynamic, which bounds "
+            "the number of recompilations. Either \"pow2\" or a comma "
+            "separated list of increasing sizes."),
+       Flag("tf_xla_persistent_cache_dir",
+            &ops_flags->tf_xla_persistent_cache_dir,
+            "If set, the directory in which optimized XLA clusters are stored "
+            "and looked up across process restarts."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
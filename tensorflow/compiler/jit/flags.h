@@ -102,6 +102,20 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile compiles the cluster asynchronously with respect to
   // the main execution. The fallback path is taken while compilation happens.
   bool tf_xla_async_compilation;
+  // If not empty, the directory in which compiled clusters are persisted so
+  // that later processes can skip the HLO optimization passes. Any path that
+  // tensorflow::Env understands can be used, including shared filesystems.
+  string tf_xla_persistent_cache_dir;
+  // With tf_xla_async_compilation, the number of executions of a new
+  // signature that take the fallback path while the cluster is compiled.
+  // Further executions wait for the compilation to finish. If zero, the
+  // fallback path is taken until the compilation has finished.
+  int64 tf_xla_async_compilation_max_fallbacks;
+  // If not empty, the leading dimension of the parameters of XLA clusters is
+  // padded up to one of these buckets, so that inputs of different sizes share
+  // one executable: "pow2" for powers of two, or a comma separated list of
+  // increasing sizes. Not supported on XLA_* devices.
+  string tf_xla_shape_buckets;
 };
 
 // Flags for the build_xla_ops pass.
@@ -84,12 +84,14 @@ class XlaExecutableClosure {
   explicit XlaExecutableClosure(
       xla::LocalClient* client, xla::LocalExecutable* executable,
       const XlaCompiler::CompilationResult* compilation_result,
-      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args)
+      ResourceVarsSnapshot resource_var_snapshots, int num_constant_args,
+      std::vector<BucketedArgument> bucketed_args)
       : client_(client),
         executable_(executable),
         compilation_result_(compilation_result),
         resource_var_snapshots_(std::move(resource_var_snapshots)),
-        num_constant_args_(num_constant_args) {}
+        num_constant_args_(num_constant_args),
+        bucketed_args_(std::move(bucketed_args)) {}
 
   XlaExecutableClosure(XlaExecutableClosure&&) = default;
   XlaExecutableClosure& operator=(XlaExecutableClosure&&) = default;
@@ -103,6 +105,9 @@ class XlaExecutableClosure {
     return resource_var_snapshots_;
   }
   int num_constant_args() const { return num_constant_args_; }
+  const std::vector<BucketedArgument>& bucketed_args() const {
+    return bucketed_args_;
+  }
 
  private:
   xla::LocalClient* client_;
@@ -110,6 +115,7 @@ class XlaExecutableClosure {
   const XlaCompiler::CompilationResult* compilation_result_;
   ResourceVarsSnapshot resource_var_snapshots_;
   int num_constant_args_;
+  std::vector<BucketedArgument> bucketed_args_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaExecutableClosure);
 };
@@ -168,6 +174,23 @@ XlaLocalLaunchBase::XlaLocalLaunchBase(OpKernelConstruction* ctx,
       platform_info_(XlaPlatformInfoFromDevice(ctx->device())),
       has_ref_vars_(has_ref_vars) {}
 
+// Returns the buckets set by --tf_xla_shape_buckets.
+static const XlaShapeBuckets& GetShapeBuckets() {
+  static const XlaShapeBuckets* buckets = [] {
+    xla::StatusOr<XlaShapeBuckets> parsed =
+        XlaShapeBuckets::Parse(GetXlaOpsCommonFlags().tf_xla_shape_buckets);
+    if (!parsed.ok()) {
+      LOG(ERROR) << "Ignoring --tf_xla_shape_buckets: " << parsed.status();
+      return new XlaShapeBuckets;
+    }
+    return new XlaShapeBuckets(parsed.ValueOrDie());
+  }();
+  return *buckets;
+}
+
+// Compiles the cluster, padding the leading dimension of its parameters to
+// the buckets set by --tf_xla_shape_buckets; the padded parameters are listed
+// in `bucketed_args`.
 static Status CompileToLocalExecutable(
     OpKernelContext* ctx, const NameAttrList& function, bool has_ref_vars,
     const XlaPlatformInfo& platform_info,
@@ -177,7 +200,8 @@ static Status CompileToLocalExecutable(
     XlaCompilationCache::CompileMode compile_mode,
     bool may_alias_resource_update, xla::LocalClient** client,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable,
+    std::vector<BucketedArgument>* bucketed_args) {
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
@@ -211,12 +235,21 @@ static Status CompileToLocalExecutable(
   compile_options.always_return_tuple = false;
   compile_options.alias_resource_update = !has_ref_vars &&
                                           may_alias_resource_update;
+  // On the host, XlaLaunch usually holds the only reference to its inputs, so
+  // outputs are computed into donated input buffers instead of fresh ones.
+  compile_options.alias_parameter_outputs =
+      may_alias_resource_update && !platform_info.is_on_xla_device() &&
+      platform_info.platform_id() == se::host::kHostPlatformId;
 
   xla::StatusOr<std::vector<XlaCompiler::Argument>> args =
       XlaComputationLaunchContext::BuildXlaCompilerArguments(
           constants, inputs, variable_infos,
           static_cast<Device*>(ctx->device()));
   TF_RETURN_IF_ERROR(args.status());
+  bucketed_args->clear();
+  if (!platform_info.is_on_xla_device()) {
+    ApplyShapeBuckets(GetShapeBuckets(), &args.ValueOrDie(), bucketed_args);
+  }
   return cache->Compile(options, function, *args, compile_options, compile_mode,
                         compilation_result, executable);
 }
@@ -297,6 +330,7 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
   xla::LocalExecutable* executable;
 
   std::vector<VariableInfo> variable_infos;
+  std::vector<BucketedArgument> bucketed_args;
   {
     OP_REQUIRES_OK(
         ctx, GetVariableInfosFromInputs(ctx->resource_manager(), ctx->device(),
@@ -306,7 +340,7 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
         ctx, function_, /*has_ref_vars=*/has_ref_vars_, platform_info_, inputs,
         variable_infos, constants_, XlaCompilationCache::CompileMode::kStrict,
         /*may_alias_resource_update=*/true, &client, &compilation_result,
-        &executable);
+        &executable, &bucketed_args);
     OP_REQUIRES_OK(ctx, s);
   }
 
@@ -328,10 +362,15 @@ void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
       platform_info_.UseMultipleStreams());
   const xla::HloInputOutputAliasConfig& input_output_alias =
       executable->executable()->module().input_output_alias_config();
+  std::vector<Tensor> padded_storage;
+  std::map<int, const Tensor*> padded_inputs;
+  OP_REQUIRES_OK(ctx, PadBucketedInputs(ctx, bucketed_args,
+                                        /*missing_ctx_input_prefix=*/0,
+                                        &padded_storage, &padded_inputs));
   xla::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs =
       launch_context.PopulateInputs(ctx, compilation_result, resource_var_ptrs,
                                     /*missing_ctx_input_prefix=*/0,
-                                    input_output_alias);
+                                    input_output_alias, padded_inputs);
   OP_REQUIRES_OK(ctx, execution_inputs.status());
 
   // Execute the computation.
@@ -458,6 +497,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   ResourceVarsSnapshot variables;
 
   std::vector<const Tensor*> inputs = InputsFromContext(ctx);
+  std::vector<BucketedArgument> bucketed_args;
   bool cannot_compile_cluster;
   {
     mutex_lock guard(cannot_compile_cluster_mu_);
@@ -487,7 +527,7 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
     Status status = CompileToLocalExecutable(
         ctx, function_, has_ref_vars_, platform_info_, inputs, variable_infos,
         constants_, compile_mode, /*may_alias_resource_update=*/false, &client,
-        &kernel, &executable);
+        &kernel, &executable, &bucketed_args);
     OP_REQUIRES_OK(ctx, SnapshotResourceVariables(ctx, resources_,
                                                   variable_infos, &variables));
     if (compile_mode != XlaCompilationCache::CompileMode::kLazy ||
@@ -531,7 +571,8 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
   // variables.
   XlaExecutableClosureStore::KeyT key =
       XlaExecutableClosureStore::Global()->Produce(XlaExecutableClosure(
-          client, executable, kernel, std::move(variables), constants_.size()));
+          client, executable, kernel, std::move(variables), constants_.size(),
+          std::move(bucketed_args)));
 
   Tensor compilation_key(cpu_allocator, DT_STRING, TensorShape({}));
   compilation_key.flat<tstring>()(0) = key;
@@ -573,6 +614,8 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
       closure.executable()->executable()->module().input_output_alias_config();
   xla::StatusOr<std::vector<xla::ExecutionInput>> execution_inputs;
   std::map<int, const Tensor*> snapshot_ptrs;
+  std::vector<Tensor> padded_storage;
+  std::map<int, const Tensor*> padded_inputs;
   {
     tensorflow::profiler::TraceMe hlo_module_activity(
         [&] {
@@ -586,10 +629,15 @@ void XlaRunOp::Compute(OpKernelContext* ctx) {
       snapshot_ptrs.emplace(p.first,
                             p.second.has_value() ? &p.second.value() : nullptr);
     }
+    OP_REQUIRES_OK(
+        ctx, PadBucketedInputs(
+                 ctx, closure.bucketed_args(),
+                 /*missing_ctx_input_prefix=*/closure.num_constant_args(),
+                 &padded_storage, &padded_inputs));
     execution_inputs = launch_context.PopulateInputs(
         ctx, closure.compilation_result(), snapshot_ptrs,
         /*missing_ctx_input_prefix=*/closure.num_constant_args(),
-        input_output_alias);
+        input_output_alias, padded_inputs);
     OP_REQUIRES_OK(ctx, execution_inputs.status());
   }
 
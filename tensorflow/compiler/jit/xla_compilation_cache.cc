@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
 #include "tensorflow/compiler/mlir/tensorflow/utils/compile_mlir_util.h"
 #include "tensorflow/compiler/mlir/utils/array_container_utils.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
@@ -59,7 +60,14 @@ constexpr int64
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : client_(client), device_type_(std::move(device_type)) {
+  const string& persistent_cache_dir =
+      GetXlaOpsCommonFlags().tf_xla_persistent_cache_dir;
+  if (!persistent_cache_dir.empty()) {
+    persistent_cache_ =
+        absl::make_unique<XlaPersistentCompilationCache>(persistent_cache_dir);
+  }
+}
 
 XlaCompilationCache::~XlaCompilationCache() {
   // Ensure any use of our programs have completed by waiting for all stream
@@ -186,14 +194,81 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_alias_passthrough_params(options.alias_passthrough_params);
   build_options.mutable_debug_options()->set_xla_detailed_logging_and_dumping(
       options.detailed_logging);
+
+  string persistent_cache_key;
+  if (persistent_cache_ != nullptr) {
+    xla::StatusOr<string> key =
+        PersistentCacheKey(*result.computation, argument_layouts, build_options);
+    if (key.ok()) {
+      persistent_cache_key = std::move(key).ValueOrDie();
+      if (BuildExecutableFromPersistentCache(persistent_cache_key,
+                                             argument_layouts, build_options,
+                                             executable)) {
+        return Status::OK();
+      }
+    } else {
+      VLOG(1) << "Not using the persistent XLA compilation cache: "
+              << key.status();
+    }
+  }
+
   TF_ASSIGN_OR_RETURN(
       auto executables,
       client_->Compile(*result.computation, argument_layouts, build_options));
   TF_RET_CHECK(executables.size() == 1);
   *executable = std::move(executables[0]);
+
+  if (!persistent_cache_key.empty() &&
+      (*executable)->executable()->has_module()) {
+    Status status = persistent_cache_->Store(
+        persistent_cache_key, (*executable)->executable()->module().ToProto());
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to write persistent XLA compilation cache entry "
+                   << persistent_cache_key << ": " << status;
+    }
+  }
   return Status::OK();
 }
 
+xla::StatusOr<string> XlaCompilationCache::PersistentCacheKey(
+    const xla::XlaComputation& computation,
+    absl::Span<const xla::Shape* const> argument_layouts,
+    const xla::ExecutableBuildOptions& build_options) {
+  TF_ASSIGN_OR_RETURN(
+      se::StreamExecutor * executor,
+      client_->backend().stream_executor(build_options.device_ordinal()));
+  const se::DeviceDescription& description = executor->GetDeviceDescription();
+  return XlaPersistentCompilationCache::Key(
+      computation.proto(), argument_layouts, build_options,
+      absl::StrCat(device_type_.type_string(), "/",
+                   client_->platform()->Name(), "/", description.name(), "/",
+                   description.platform_version()));
+}
+
+bool XlaCompilationCache::BuildExecutableFromPersistentCache(
+    const string& key, absl::Span<const xla::Shape* const> argument_layouts,
+    xla::ExecutableBuildOptions build_options,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  xla::HloModuleProto optimized_module;
+  Status status = persistent_cache_->Lookup(key, &optimized_module);
+  if (!status.ok()) {
+    VLOG(2) << "Persistent XLA compilation cache miss: " << status;
+    return false;
+  }
+  build_options.set_run_backend_only(true);
+  auto executables = client_->Compile(
+      xla::XlaComputation(std::move(optimized_module)), argument_layouts,
+      build_options);
+  if (!executables.ok() || executables.ValueOrDie().size() != 1) {
+    LOG(WARNING) << "Ignoring unusable persistent XLA compilation cache entry "
+                 << key << ": " << executables.status();
+    return false;
+  }
+  VLOG(1) << "Persistent XLA compilation cache hit: " << key;
+  *executable = std::move(executables.ValueOrDie()[0]);
+  return true;
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     const std::vector<XlaCompiler::Argument>& args,
@@ -399,6 +474,7 @@ Status XlaCompilationCache::CompileAsynchronous(
                                XlaCompiler::CompilationResult*)>& compile_fn) {
   // Explicitly capture all required data by value for async compilation.
   entry->compile_state = CompileState::kCompiling;
+  const uint64 queued_us = Env::Default()->NowMicros();
   {
     mutex_lock lock(async_compilation_state_.async_compilation_state_mu);
     async_compilation_state_.num_ongoing_compilations++;
@@ -433,6 +509,10 @@ Status XlaCompilationCache::CompileAsynchronous(
       entry->compile_state = local_entry.compile_state;
       entry->compilation_status = local_entry.compilation_status;
       entry->executable = std::move(local_entry.executable);
+      metrics::UpdateXlaAsyncCompilationFallback(
+          entry->num_fallback_executions,
+          Env::Default()->NowMicros() - queued_us);
+      entry->compiled_cv.notify_all();
     }
   });
   return Status::OK();
@@ -585,6 +665,7 @@ Status XlaCompilationCache::CompileImpl(
               << human_signature;
       TF_RETURN_IF_ERROR(CompileAsynchronous(entry, options, args,
                                              function.name(), compile_fn));
+      ++entry->num_fallback_executions;
       return_null = true;
     } else {
       VLOG(2) << "Instantly compiling for signature: " << human_signature;
@@ -592,9 +673,20 @@ Status XlaCompilationCache::CompileImpl(
           CompileStrict(entry, options, args, function.name(), compile_fn));
     }
   } else if (state == CompileState::kCompiling) {
-    VLOG(2) << "Ongoing asynchronous compilation for signature: "
-            << human_signature;
-    return_null = true;
+    const int64 max_fallbacks =
+        GetXlaOpsCommonFlags().tf_xla_async_compilation_max_fallbacks;
+    if (max_fallbacks > 0 && entry->num_fallback_executions >= max_fallbacks) {
+      VLOG(2) << "Waiting for asynchronous compilation for signature: "
+              << human_signature;
+      while (entry->compile_state == CompileState::kCompiling) {
+        entry->compiled_cv.wait(entry_lock);
+      }
+    } else {
+      VLOG(2) << "Ongoing asynchronous compilation for signature: "
+              << human_signature;
+      ++entry->num_fallback_executions;
+      return_null = true;
+    }
   } else if (state == CompileState::kCompiled) {
     VLOG(2) << "Already Compiled for signature: " << human_signature;
   }
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -149,9 +150,27 @@ class XlaCompilationCache : public ResourceBase {
                          const XlaCompiler::CompilationResult& result,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Returns the key of `computation` in the persistent compilation cache.
+  xla::StatusOr<string> PersistentCacheKey(
+      const xla::XlaComputation& computation,
+      absl::Span<const xla::Shape* const> argument_layouts,
+      const xla::ExecutableBuildOptions& build_options);
+
+  // Builds `executable` from the optimized module stored under `key` in the
+  // persistent compilation cache, running only the XLA backend. Returns false
+  // if there is no usable entry.
+  bool BuildExecutableFromPersistentCache(
+      const string& key, absl::Span<const xla::Shape* const> argument_layouts,
+      xla::ExecutableBuildOptions build_options,
+      std::unique_ptr<xla::LocalExecutable>* executable);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
 
+  // Optimized modules persisted across processes. Null unless
+  // --tf_xla_persistent_cache_dir is set.
+  std::unique_ptr<XlaPersistentCompilationCache> persistent_cache_;
+
   // The value associated with a cache entry.
   struct Entry {
     mutex mu;
@@ -162,6 +181,13 @@ class XlaCompilationCache : public ResourceBase {
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
+    // The number of executions that took the fallback path while this entry
+    // was compiled asynchronously.
+    int64 num_fallback_executions = 0;
+
+    // Notified when an asynchronous compilation of this entry has finished.
+    condition_variable compiled_cv;
+
     // Did compilation succeed?
     Status compilation_status TF_GUARDED_BY(mu);
 
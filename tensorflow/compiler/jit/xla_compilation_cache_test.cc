@@ -16,8 +16,13 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
 #include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -78,6 +83,61 @@ TEST(XlaCompilationCacheTest, TestDisabledXlaCompilation) {
       absl::StrContains(status.error_message(), "XLA compilation disabled"));
 }
 
+xla::HloModuleProto BuildAddModule() {
+  xla::XlaBuilder builder("add");
+  const xla::Shape shape = xla::ShapeUtil::MakeShape(xla::F32, {4});
+  xla::Add(xla::Parameter(&builder, 0, shape, "x"),
+           xla::Parameter(&builder, 1, shape, "y"));
+  return builder.Build().ConsumeValueOrDie().proto();
+}
+
+TEST(XlaCompilationCacheTest, PersistentCacheKey) {
+  const xla::Shape row_major =
+      xla::ShapeUtil::MakeShapeWithLayout(xla::F32, {4}, {0});
+  std::vector<const xla::Shape*> argument_layouts = {&row_major, &row_major};
+  xla::ExecutableBuildOptions build_options;
+
+  // Modules built twice get different unique ids but the same key.
+  TF_ASSERT_OK_AND_ASSIGN(
+      string key1,
+      XlaPersistentCompilationCache::Key(BuildAddModule(), argument_layouts,
+                                         build_options, "CPU"));
+  TF_ASSERT_OK_AND_ASSIGN(
+      string key2,
+      XlaPersistentCompilationCache::Key(BuildAddModule(), argument_layouts,
+                                         build_options, "CPU"));
+  EXPECT_EQ(key1, key2);
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      string other_device,
+      XlaPersistentCompilationCache::Key(BuildAddModule(), argument_layouts,
+                                         build_options, "GPU"));
+  EXPECT_NE(key1, other_device);
+
+  build_options.set_num_replicas(2);
+  TF_ASSERT_OK_AND_ASSIGN(
+      string other_options,
+      XlaPersistentCompilationCache::Key(BuildAddModule(), argument_layouts,
+                                         build_options, "CPU"));
+  EXPECT_NE(key1, other_options);
+}
+
+TEST(XlaCompilationCacheTest, PersistentCacheStoreAndLookup) {
+  XlaPersistentCompilationCache cache(
+      io::JoinPath(testing::TmpDir(), "persistent_xla_cache"));
+  xla::HloModuleProto module;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup("0123", &module)));
+
+  const xla::HloModuleProto stored = BuildAddModule();
+  TF_ASSERT_OK(cache.Store("0123", stored));
+  TF_ASSERT_OK(cache.Lookup("0123", &module));
+  EXPECT_EQ(module.SerializeAsString(), stored.SerializeAsString());
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(cache.directory(), &children));
+  EXPECT_EQ(children.size(), 1);
+}
+
 void BM_BuildSignature(::testing::benchmark::State& state) {
   const int n_args = state.range(0);
 
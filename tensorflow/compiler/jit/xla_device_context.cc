@@ -70,6 +70,7 @@ absl::optional<AllocatorStats> XlaDeviceAllocator::GetStats() {
   tf_stats.peak_bytes_reserved = se_stats->peak_bytes_reserved;
   tf_stats.bytes_reservable_limit = se_stats->bytes_reservable_limit;
   tf_stats.largest_free_block_bytes = se_stats->largest_free_block_bytes;
+  tf_stats.fragmentation = se_stats->fragmentation;
   return tf_stats;
 }
 
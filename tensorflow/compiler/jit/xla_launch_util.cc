@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
@@ -224,8 +228,10 @@ static void PopulateExecutionInputBuffer(xla::ExecutionInput& execution_input,
     // ownership from the caller of PopulateExecutionInputBuffer. If execution
     // succeeds, we'll take back that duplicate ownership in
     // GetOrCreateTensorForOutput. If execution fails, the ExecutionInput will
-    // release that duplicate ownership automatically.
+    // release that duplicate ownership automatically, without freeing the
+    // buffer the tensor still owns.
     *in_buffer = se::OwningDeviceMemory(buffer, device_ordinal, allocator);
+    execution_input.SetUnownedIndex(index);
   } else {
     *in_buffer = buffer;
   }
@@ -237,7 +243,8 @@ XlaComputationLaunchContext::PopulateInputs(
     const XlaCompiler::CompilationResult* compilation_result,
     const std::map<int, const Tensor*>& resource_vars,
     int missing_ctx_input_prefix,
-    const xla::HloInputOutputAliasConfig& input_output_alias) {
+    const xla::HloInputOutputAliasConfig& input_output_alias,
+    const std::map<int, const Tensor*>& padded_inputs) {
   std::vector<xla::ExecutionInput> arguments;
   arguments.reserve(compilation_result->xla_input_shapes.size());
 
@@ -259,12 +266,26 @@ XlaComputationLaunchContext::PopulateInputs(
                          return update.input_index == i && update.modified;
                        });
 
-    const Tensor* t = is_resource_variable
-                          ? resource_vars.at(arg_num)
-                          : &(ctx->input(arg_num - missing_ctx_input_prefix));
+    const Tensor* t;
+    bool is_padded_input = false;
+    if (is_resource_variable) {
+      t = resource_vars.at(arg_num);
+    } else if (padded_inputs.count(arg_num)) {
+      t = padded_inputs.at(arg_num);
+      is_padded_input = true;
+    } else {
+      t = &(ctx->input(arg_num - missing_ctx_input_prefix));
+    }
     CHECK(t);
+    // An input that nothing else references can be donated to an output it
+    // is aliased with, which XLA then computes in place. Padded inputs are
+    // temporaries of the launch and are never returned as outputs.
+    bool is_donatable_input =
+        !is_resource_variable && !is_padded_input && !allocate_xla_tensors_ &&
+        !ctx->input_is_ref(arg_num - missing_ctx_input_prefix);
     bool donate_buffer =
-        t->RefCountIsOne() && is_updated_resource_variable &&
+        t->RefCountIsOne() &&
+        (is_updated_resource_variable || is_donatable_input) &&
         input_output_alias.ParameterHasAlias(i, xla::ShapeIndex{});
     VLOG(3) << "Processing input: " << i
             << "; is_resource_variable=" << is_resource_variable
@@ -601,6 +622,127 @@ Status XlaComputationLaunchContext::PopulateOutputs(
   return Status::OK();
 }
 
+/*static*/ xla::StatusOr<XlaShapeBuckets> XlaShapeBuckets::Parse(
+    absl::string_view spec) {
+  XlaShapeBuckets buckets;
+  if (spec.empty()) {
+    return buckets;
+  }
+  if (spec == "pow2") {
+    buckets.power_of_two_ = true;
+    return buckets;
+  }
+  for (absl::string_view size_str : absl::StrSplit(spec, ',')) {
+    int64 size;
+    if (!absl::SimpleAtoi(size_str, &size) || size <= 0 ||
+        (!buckets.sizes_.empty() && size <= buckets.sizes_.back())) {
+      return errors::InvalidArgument(
+          "Invalid XLA shape buckets \"", spec,
+          "\": expected \"pow2\" or increasing positive sizes");
+    }
+    buckets.sizes_.push_back(size);
+  }
+  return buckets;
+}
+
+int64 XlaShapeBuckets::BucketFor(int64 size) const {
+  if (power_of_two_) {
+    int64 bucket = 1;
+    while (bucket < size) bucket <<= 1;
+    return bucket;
+  }
+  auto it = std::lower_bound(sizes_.begin(), sizes_.end(), size);
+  return it == sizes_.end() ? -1 : *it;
+}
+
+void ApplyShapeBuckets(const XlaShapeBuckets& buckets,
+                       std::vector<XlaCompiler::Argument>* args,
+                       std::vector<BucketedArgument>* bucketed_args) {
+  bucketed_args->clear();
+  if (!buckets.enabled()) return;
+  for (int i = 0, end = args->size(); i < end; ++i) {
+    XlaCompiler::Argument& arg = (*args)[i];
+    if (arg.kind != XlaCompiler::Argument::kParameter ||
+        !absl::holds_alternative<TensorShape>(arg.shape) ||
+        !DataTypeCanUseMemcpy(arg.type)) {
+      continue;
+    }
+    TensorShape shape = absl::get<TensorShape>(arg.shape);
+    if (shape.dims() == 0 || shape.dim_size(0) == 0) continue;
+    const int64 padded_size = buckets.BucketFor(shape.dim_size(0));
+    if (padded_size < 0) continue;
+
+    BucketedArgument bucketed;
+    bucketed.arg_num = i;
+    bucketed.size = shape.dim_size(0);
+    bucketed.padded_size = padded_size;
+    bucketed.size_arg_num = args->size();
+    shape.set_dim(0, padded_size);
+    arg.shape = shape;
+    arg.dynamic_dim_to_arg_num_map[0] = bucketed.size_arg_num;
+
+    XlaCompiler::Argument size_arg;
+    size_arg.kind = XlaCompiler::Argument::kParameter;
+    size_arg.type = DT_INT32;
+    size_arg.shape = TensorShape();
+    size_arg.name = absl::StrCat(arg.name, "_size");
+    args->push_back(std::move(size_arg));
+    bucketed_args->push_back(bucketed);
+  }
+}
+
+Status PadBucketedInputs(OpKernelContext* ctx,
+                         absl::Span<const BucketedArgument> bucketed_args,
+                         int missing_ctx_input_prefix,
+                         std::vector<Tensor>* storage,
+                         std::map<int, const Tensor*>* padded_inputs) {
+  se::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  // Reserve up front; `padded_inputs` points into `storage`.
+  storage->clear();
+  storage->reserve(2 * bucketed_args.size());
+  for (const BucketedArgument& bucketed : bucketed_args) {
+    const Tensor& input =
+        ctx->input(bucketed.arg_num - missing_ctx_input_prefix);
+    TF_RET_CHECK(input.dims() > 0 && input.dim_size(0) == bucketed.size);
+    TensorShape padded_shape = input.shape();
+    padded_shape.set_dim(0, bucketed.padded_size);
+    storage->emplace_back();
+    Tensor* padded = &storage->back();
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(input.dtype(), padded_shape, padded));
+    storage->emplace_back();
+    Tensor* size = &storage->back();
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(DT_INT32, TensorShape(), size));
+
+    const uint64 input_bytes = input.TotalBytes();
+    const uint64 padding_bytes = padded->TotalBytes() - input_bytes;
+    if (stream == nullptr) {
+      char* dst = const_cast<char*>(padded->tensor_data().data());
+      memcpy(dst, input.tensor_data().data(), input_bytes);
+      memset(dst + input_bytes, 0, padding_bytes);
+      size->scalar<int32>()() = bucketed.size;
+    } else {
+      se::DeviceMemoryBase dst = XlaTensor::DeviceMemoryFromTensor(*padded);
+      if (input_bytes > 0) {
+        stream->ThenMemcpyD2D(&dst, XlaTensor::DeviceMemoryFromTensor(input),
+                              input_bytes);
+      }
+      if (padding_bytes > 0) {
+        se::DeviceMemoryBase padding(
+            static_cast<char*>(dst.opaque()) + input_bytes, padding_bytes);
+        stream->ThenMemZero(&padding, padding_bytes);
+      }
+      se::DeviceMemoryBase size_mem = XlaTensor::DeviceMemoryFromTensor(*size);
+      stream->ThenMemset32(&size_mem, static_cast<uint32>(bucketed.size),
+                           sizeof(int32));
+    }
+    (*padded_inputs)[bucketed.arg_num] = padded;
+    (*padded_inputs)[bucketed.size_arg_num] = size;
+  }
+  return Status::OK();
+}
+
 xla::StatusOr<std::vector<XlaCompiler::Argument>>
 XlaComputationLaunchContext::BuildXlaCompilerArguments(
     absl::Span<int const> must_be_constant_idxs,
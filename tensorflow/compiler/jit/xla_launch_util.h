@@ -18,6 +18,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_LAUNCH_UTIL_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_LAUNCH_UTIL_H_
 
+#include <map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/compiler/jit/xla_tensor.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
@@ -120,6 +125,57 @@ Status GetVariableInfosFromInputs(ResourceMgr* rm, DeviceBase* dev,
 // Returns pointers to inputs stored in `ctx`.
 std::vector<const Tensor*> InputsFromContext(OpKernelContext* ctx);
 
+// Sizes to which the leading dimension of the parameters of XLA clusters is
+// padded, so that inputs of different sizes share one executable.
+class XlaShapeBuckets {
+ public:
+  // Parses `spec`, which is either "pow2" for powers of two or a comma
+  // separated list of increasing sizes. An empty `spec` disables bucketing.
+  static xla::StatusOr<XlaShapeBuckets> Parse(absl::string_view spec);
+
+  bool enabled() const { return power_of_two_ || !sizes_.empty(); }
+
+  // Returns the smallest bucket that is at least `size`, or -1 if there is no
+  // such bucket.
+  int64 BucketFor(int64 size) const;
+
+ private:
+  bool power_of_two_ = false;
+  std::vector<int64> sizes_;
+};
+
+// A parameter of an XLA cluster whose leading dimension is padded to a bucket.
+struct BucketedArgument {
+  // The index of the padded argument.
+  int arg_num;
+  // The true and padded sizes of the leading dimension.
+  int64 size;
+  int64 padded_size;
+  // The index of the scalar DT_INT32 argument that holds `size`.
+  int size_arg_num;
+};
+
+// Pads the leading dimension of the parameters in `args` to `buckets`. The
+// padded dimensions become dynamic in the XLA computation, which masks out
+// the padding, and their true sizes are passed in DT_INT32 arguments appended
+// to `args`. The padded parameters are listed in `bucketed_args`.
+void ApplyShapeBuckets(const XlaShapeBuckets& buckets,
+                       std::vector<XlaCompiler::Argument>* args,
+                       std::vector<BucketedArgument>* bucketed_args);
+
+// Creates the inputs for the arguments of `bucketed_args`: the inputs of
+// `ctx` padded with zeros, and scalars holding their true sizes. They are
+// added to `padded_inputs`, keyed by argument number, to be passed to
+// XlaComputationLaunchContext::PopulateInputs. `storage` owns them.
+//
+// Assumes that the first `missing_ctx_input_prefix` inputs to the kernel are
+// missing, as in PopulateInputs.
+Status PadBucketedInputs(OpKernelContext* ctx,
+                         absl::Span<const BucketedArgument> bucketed_args,
+                         int missing_ctx_input_prefix,
+                         std::vector<Tensor>* storage,
+                         std::map<int, const Tensor*>* padded_inputs);
+
 // Helper class to perform the marshalling of TensorFlow inputs and outputs to
 // ShapedBuffers suitable for passing to an XLA computation.
 class XlaComputationLaunchContext {
@@ -153,12 +209,16 @@ class XlaComputationLaunchContext {
   // missing and adjusts input indices accordingly.  All elements in kernel's
   // input_mapping must be greater than or equal to `missing_ctx_input_prefix`
   // (in other words, no inputs actually required by the kernel can be missing).
+  //
+  // `padded_inputs` maps argument numbers to the tensors created by
+  // PadBucketedInputs, which are used instead of the inputs of `ctx`.
   xla::StatusOr<std::vector<xla::ExecutionInput>> PopulateInputs(
       OpKernelContext* ctx,
       const XlaCompiler::CompilationResult* compilation_result,
       const std::map<int, const Tensor*>& resource_vars,
       int missing_ctx_input_prefix,
-      const xla::HloInputOutputAliasConfig& input_output_alias);
+      const xla::HloInputOutputAliasConfig& input_output_alias,
+      const std::map<int, const Tensor*>& padded_inputs = {});
 
   // Given the XLA output in `output`, populate all outputs of `ctx`.  Also
   // writes out the resource variable updates.
@@ -0,0 +1,120 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
+
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+
+namespace {
+constexpr char kEntrySuffix[] = ".xla_hlo";
+}  // namespace
+
+XlaPersistentCompilationCache::XlaPersistentCompilationCache(string directory,
+                                                             Env* env)
+    : directory_(std::move(directory)), env_(env) {}
+
+/*static*/ xla::StatusOr<string> XlaPersistentCompilationCache::Key(
+    const xla::HloModuleProto& module,
+    absl::Span<const xla::Shape* const> argument_layouts,
+    const xla::ExecutableBuildOptions& build_options,
+    const string& device_description) {
+  xla::DebugOptions debug_options = build_options.has_debug_options()
+                                        ? build_options.debug_options()
+                                        : xla::GetDebugOptionsFromFlags();
+  TF_ASSIGN_OR_RETURN(
+      xla::HloModuleConfig config,
+      xla::HloModule::CreateModuleConfigFromProto(module, debug_options));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<xla::HloModule> hlo_module,
+                      xla::HloModule::CreateFromProto(module, config));
+
+  // The proto carries ids handed out by a process-wide counter, so the module
+  // is printed in canonical form, with all constants, instead.
+  string fingerprint_input = hlo_module->ToString(
+      xla::HloPrintOptions::Canonical().set_print_large_constants(true));
+  for (const xla::Shape* shape : argument_layouts) {
+    absl::StrAppend(&fingerprint_input, "\narg:",
+                    xla::ShapeUtil::HumanStringWithLayout(*shape));
+  }
+  if (build_options.result_layout() != nullptr) {
+    absl::StrAppend(
+        &fingerprint_input, "\nresult:",
+        xla::ShapeUtil::HumanStringWithLayout(*build_options.result_layout()));
+  }
+  absl::StrAppend(&fingerprint_input,
+                  "\nreplicas:", build_options.num_replicas(),
+                  "\npartitions:", build_options.num_partitions(),
+                  "\nalias_passthrough_params:",
+                  build_options.alias_passthrough_params());
+  string serialized_debug_options;
+  if (!SerializeToStringDeterministic(debug_options,
+                                      &serialized_debug_options)) {
+    return errors::Internal("Failed to serialize XLA debug options");
+  }
+  absl::StrAppend(&fingerprint_input, "\ndebug_options:",
+                  serialized_debug_options, "\ndevice:", device_description,
+                  "\nversion:", TF_VERSION_STRING, " ", tf_git_version());
+
+  const Fprint128 fingerprint = Fingerprint128(fingerprint_input);
+  return absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64);
+}
+
+Status XlaPersistentCompilationCache::Lookup(
+    const string& key, xla::HloModuleProto* optimized_module) const {
+  const string path = EntryPath(key);
+  Status status = env_->FileExists(path);
+  if (!status.ok()) {
+    return errors::NotFound("No persistent XLA compilation cache entry ", path);
+  }
+  return ReadBinaryProto(env_, path, optimized_module);
+}
+
+Status XlaPersistentCompilationCache::Store(
+    const string& key, const xla::HloModuleProto& optimized_module) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  const string path = EntryPath(key);
+  string temp_path = absl::StrCat(path, ".");
+  if (!env_->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  Status status = WriteBinaryProto(env_, temp_path, optimized_module);
+  if (status.ok()) {
+    status = env_->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    env_->DeleteFile(temp_path).IgnoreError();
+  }
+  return status;
+}
+
+string XlaPersistentCompilationCache::EntryPath(const string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, kEntrySuffix));
+}
+
+}  // namespace tensorflow
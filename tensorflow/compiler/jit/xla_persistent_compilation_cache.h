@@ -0,0 +1,75 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
+
+#include <string>
+
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/client/executable_build_options.h"
+#include "tensorflow/compiler/xla/service/hlo.pb.h"
+#include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+
+// Stores the optimized HLO of compiled XLA clusters in a directory, so that a
+// later process can build the executable without running the HLO passes
+// again.
+//
+// LocalExecutables cannot be serialized, so entries hold the HloModuleProto
+// produced by the HLO passes and executables are rebuilt from it with
+// `xla::ExecutableBuildOptions::run_backend_only`. The directory can be any
+// path understood by `Env`, so several hosts can share one cache.
+class XlaPersistentCompilationCache {
+ public:
+  explicit XlaPersistentCompilationCache(string directory,
+                                         Env* env = Env::Default());
+
+  // Returns the key of the entry for compiling the unoptimized `module` with
+  // `argument_layouts` and `build_options` on the device described by
+  // `device_description`. The key also covers the XLA debug options and the
+  // TensorFlow version, and does not depend on the unique ids assigned to the
+  // module by the builder.
+  static xla::StatusOr<string> Key(
+      const xla::HloModuleProto& module,
+      absl::Span<const xla::Shape* const> argument_layouts,
+      const xla::ExecutableBuildOptions& build_options,
+      const string& device_description);
+
+  // Reads the optimized module stored under `key`. Returns NotFound if there
+  // is no such entry.
+  Status Lookup(const string& key, xla::HloModuleProto* optimized_module) const;
+
+  // Stores `optimized_module` under `key`. The entry is written to a temporary
+  // file which is then renamed, so readers never observe partial entries.
+  Status Store(const string& key,
+               const xla::HloModuleProto& optimized_module) const;
+
+  const string& directory() const { return directory_; }
+
+ private:
+  string EntryPath(const string& key) const;
+
+  const string directory_;
+  Env* const env_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
@@ -65,8 +65,13 @@ std::unique_ptr<llvm::TargetMachine> GetTargetMachine(llvm::Module* module) {
 
   llvm::TargetOptions target_options =
       llvm::codegen::InitTargetOptionsFromCodeGenFlags(llvm::Triple());
+  // Honor --mcpu and --mattr so that CPU kernels can be vectorized for wider
+  // vector units than those of the generic target.
+  std::string cpu = llvm::codegen::getCPUStr();
+  if (cpu.empty()) cpu = "generic";
   return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
-      triple.str(), "generic", "", target_options, llvm::Reloc::Model::PIC_));
+      triple.str(), cpu, llvm::codegen::getFeaturesStr(), target_options,
+      llvm::Reloc::Model::PIC_));
 }
 
 // Compiles the given MLIR module via LLVM into an executable binary format.
@@ -88,9 +88,36 @@ class AsyncCompilationTest(test.TestCase):
                 trace_level=config_pb2.RunOptions.FULL_TRACE))
         hasXlaRunOp = MetadataHasXlaRunOp(run_metadata)
 
+  # With --tf_xla_async_compilation_max_fallbacks=1 only the first execution of
+  # a new signature takes the fallback path; the second waits for the
+  # compilation to finish and runs the compiled cluster.
+  def testAsyncCompilationMaxFallbacks(self):
+
+    @function.Defun(compiled=True)
+    def CompiledFunction(x):
+      return math_ops.exp(x)
+
+    with session_lib.Session() as sess:
+      x = array_ops.placeholder(dtypes.float32)
+      y = CompiledFunction(x)
+
+      def RunAndCheckForXlaRunOp():
+        run_metadata = config_pb2.RunMetadata()
+        sess.run(
+            y,
+            feed_dict={x: [0.] * 60},
+            run_metadata=run_metadata,
+            options=config_pb2.RunOptions(
+                trace_level=config_pb2.RunOptions.FULL_TRACE))
+        return MetadataHasXlaRunOp(run_metadata)
+
+      self.assertFalse(RunAndCheckForXlaRunOp())
+      self.assertTrue(RunAndCheckForXlaRunOp())
+
 
 if __name__ == "__main__":
   os.environ["TF_XLA_FLAGS"] = ("--tf_xla_async_compilation=true " +
+                                "--tf_xla_async_compilation_max_fallbacks=1 " +
                                 "--tf_xla_enable_lazy_compilation=true " +
                                 os.environ.get("TF_XLA_FLAGS", ""))
   # This test is using Tensorflow sessions which are not compatible with eager
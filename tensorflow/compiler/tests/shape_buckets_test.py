@@ -0,0 +1,62 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for padding XLA cluster parameters to shape buckets."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.python.client import session as session_lib
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import function
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+class ShapeBucketsTest(test.TestCase):
+
+  # The leading dimension of the parameters is padded to a power of two. The
+  # results must only depend on the true sizes.
+  def testResultsIgnorePadding(self):
+
+    @function.Defun(compiled=True)
+    def CompiledFunction(x):
+      return math_ops.reduce_sum(x * 2., axis=0), x + 1.
+
+    with session_lib.Session() as sess:
+      x = array_ops.placeholder(dtypes.float32, shape=[None, 3])
+      total, incremented = CompiledFunction(x)
+
+      for rows in [1, 3, 4, 5, 7, 8]:
+        value = np.arange(rows * 3, dtype=np.float32).reshape([rows, 3])
+        total_value, incremented_value = sess.run(
+            [total, incremented], feed_dict={x: value})
+        self.assertAllClose(np.sum(value * 2., axis=0), total_value)
+        self.assertAllClose(value + 1., incremented_value)
+
+
+if __name__ == "__main__":
+  os.environ["TF_XLA_FLAGS"] = ("--tf_xla_shape_buckets=pow2 " +
+                                os.environ.get("TF_XLA_FLAGS", ""))
+  # This test is using Tensorflow sessions which are not compatible with eager
+  # mode.
+  ops.disable_eager_execution()
+  test.main()
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_TF2XLA_XLA_ARGUMENT_H_
 #define TENSORFLOW_COMPILER_TF2XLA_XLA_ARGUMENT_H_
 
+#include <map>
+#include <set>
+
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "tensorflow/compiler/tf2xla/host_compute_metadata.pb.h"
@@ -106,6 +109,11 @@ struct XlaArgument {
   // Whether this argument will receive the same data across all replicas.
   bool is_same_data_across_replicas = false;
 
+  // For a kParameter, maps dimensions of the parameter that are padded to a
+  // larger size to the index of the scalar DT_INT32 kParameter argument that
+  // holds their true size. Such dimensions are dynamic in the computation.
+  std::map<int32, int32> dynamic_dim_to_arg_num_map;
+
   bool operator==(const XlaArgument& other) const;
 
   // Returns a human-readable summary of the argument.
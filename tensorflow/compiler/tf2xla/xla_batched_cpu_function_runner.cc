@@ -0,0 +1,127 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2xla/xla_batched_cpu_function_runner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace tensorflow {
+
+XlaBatchedCpuFunctionRunner::XlaBatchedCpuFunctionRunner(
+    std::unique_ptr<XlaCompiledCpuFunction> function, int batch_size,
+    std::vector<int64> result_sizes, const Options& options)
+    : function_(std::move(function)),
+      batch_size_(batch_size),
+      result_sizes_(std::move(result_sizes)),
+      batch_timeout_(options.batch_timeout_micros) {
+  assert(batch_size_ > 0);
+  assert(function_->num_variables() == 0);
+  batch_thread_ = std::thread([this]() { BatchLoop(); });
+}
+
+XlaBatchedCpuFunctionRunner::~XlaBatchedCpuFunctionRunner() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  enqueued_.notify_all();
+  batch_thread_.join();
+}
+
+bool XlaBatchedCpuFunctionRunner::Run(const void* const* args,
+                                      void* const* results) {
+  Request request;
+  request.args = args;
+  request.results = results;
+  request.enqueue_time = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(mu_);
+  queue_.push_back(&request);
+  enqueued_.notify_all();
+  done_.wait(lock, [&request]() { return request.done; });
+  return request.ok;
+}
+
+int64 XlaBatchedCpuFunctionRunner::num_requests() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return num_requests_;
+}
+
+int64 XlaBatchedCpuFunctionRunner::num_batches() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return num_batches_;
+}
+
+void XlaBatchedCpuFunctionRunner::BatchLoop() {
+  std::vector<Request*> batch;
+  while (true) {
+    std::unique_lock<std::mutex> lock(mu_);
+    enqueued_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+    // Pending requests are still run when the runner is stopped.
+    if (queue_.empty()) return;
+    const auto deadline = queue_.front()->enqueue_time + batch_timeout_;
+    enqueued_.wait_until(lock, deadline, [this]() {
+      return stop_ || queue_.size() >= static_cast<size_t>(batch_size_);
+    });
+
+    const size_t size =
+        std::min(queue_.size(), static_cast<size_t>(batch_size_));
+    batch.assign(queue_.begin(), queue_.begin() + size);
+    queue_.erase(queue_.begin(), queue_.begin() + size);
+    lock.unlock();
+
+    const bool ok = RunBatch(batch);
+
+    lock.lock();
+    for (Request* request : batch) {
+      request->ok = ok;
+      request->done = true;
+    }
+    num_requests_ += batch.size();
+    ++num_batches_;
+    lock.unlock();
+    done_.notify_all();
+  }
+}
+
+bool XlaBatchedCpuFunctionRunner::RunBatch(const std::vector<Request*>& batch) {
+  // Gather the args of each request into its row of the arg buffers.
+  for (int i = 0; i < function_->num_args(); ++i) {
+    const int64 row_size = arg_size(i);
+    char* data = static_cast<char*>(function_->arg_data(i));
+    for (size_t row = 0; row < batch.size(); ++row) {
+      std::memcpy(data + row * row_size, batch[row]->args[i], row_size);
+    }
+    // Don't feed stale rows of a previous batch to a partial batch.
+    std::memset(data + batch.size() * row_size, 0,
+                (batch_size_ - batch.size()) * row_size);
+  }
+
+  if (!function_->Run()) return false;
+
+  // Scatter the rows of the result buffers back to the requests.
+  for (int i = 0; i < num_results(); ++i) {
+    const int64 row_size = result_size(i);
+    const char* data = static_cast<const char*>(function_->result_data(i));
+    for (size_t row = 0; row < batch.size(); ++row) {
+      std::memcpy(batch[row]->results[i], data + row * row_size, row_size);
+    }
+  }
+  return true;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_TF2XLA_XLA_BATCHED_CPU_FUNCTION_RUNNER_H_
+#define TENSORFLOW_COMPILER_TF2XLA_XLA_BATCHED_CPU_FUNCTION_RUNNER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Runs an XlaCompiledCpuFunction compiled for a batch of requests on single
+// requests of concurrent callers. Every arg and result of the function holds
+// `batch_size` requests along its leading dimension: the runner gathers the
+// args of up to `batch_size` callers into the arg buffers, runs the function
+// once, and scatters the results back to each caller. Batches that are not
+// full after `batch_timeout_micros` are run with the remaining rows zeroed.
+//
+// tfcompile generates a NewBatchRunner method for functions compiled with
+// --batch_size. The graph must treat the rows of the leading dimension as
+// independent examples, and must not have variables.
+//
+// This class is thread-safe. Batches are run one at a time, by a thread owned
+// by the runner.
+class XlaBatchedCpuFunctionRunner {
+ public:
+  struct Options {
+    // How long a request waits for more requests to join its batch.
+    int64 batch_timeout_micros = 1000;
+  };
+
+  // `result_sizes[i]` is the byte size of the buffer of result i, for the
+  // whole batch.
+  XlaBatchedCpuFunctionRunner(std::unique_ptr<XlaCompiledCpuFunction> function,
+                              int batch_size, std::vector<int64> result_sizes,
+                              const Options& options);
+  ~XlaBatchedCpuFunctionRunner();
+
+  XlaBatchedCpuFunctionRunner(const XlaBatchedCpuFunctionRunner&) = delete;
+  XlaBatchedCpuFunctionRunner& operator=(const XlaBatchedCpuFunctionRunner&) =
+      delete;
+
+  // Runs the function on a single request and blocks until its batch has run.
+  // `args[i]` points to the arg_size(i) / batch_size() bytes of arg i, and
+  // `results[i]` to a buffer that receives the result_size(i) / batch_size()
+  // bytes of result i. Returns false if the function failed.
+  bool Run(const void* const* args, void* const* results);
+
+  int batch_size() const { return batch_size_; }
+  int num_args() const { return function_->num_args(); }
+  int num_results() const { return result_sizes_.size(); }
+
+  // Byte size of arg and result `index` of a single request.
+  int64 arg_size(int index) const {
+    return function_->arg_size(index) / batch_size_;
+  }
+  int64 result_size(int index) const {
+    return result_sizes_[index] / batch_size_;
+  }
+
+  // Number of requests and batches run so far.
+  int64 num_requests() const;
+  int64 num_batches() const;
+
+ private:
+  struct Request {
+    const void* const* args;
+    void* const* results;
+    std::chrono::steady_clock::time_point enqueue_time;
+    bool done = false;
+    bool ok = false;
+  };
+
+  // Loop of `batch_thread_`, forming and running batches until stopped.
+  void BatchLoop();
+
+  // Runs `function_` on `batch`, which holds at most batch_size_ requests.
+  bool RunBatch(const std::vector<Request*>& batch);
+
+  const std::unique_ptr<XlaCompiledCpuFunction> function_;
+  const int batch_size_;
+  const std::vector<int64> result_sizes_;
+  const std::chrono::microseconds batch_timeout_;
+
+  mutable std::mutex mu_;
+  // Signaled when a request is enqueued or the runner is stopped.
+  std::condition_variable enqueued_;
+  // Signaled when a batch has run.
+  std::condition_variable done_;
+  std::deque<Request*> queue_;
+  bool stop_ = false;
+  int64 num_requests_ = 0;
+  int64 num_batches_ = 0;
+
+  std::thread batch_thread_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_TF2XLA_XLA_BATCHED_CPU_FUNCTION_RUNNER_H_
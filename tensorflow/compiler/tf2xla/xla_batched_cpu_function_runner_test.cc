@@ -0,0 +1,135 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2xla/xla_batched_cpu_function_runner.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
+#include "tensorflow/compiler/tf2xla/xla_jit_compiled_cpu_function.h"
+#include "tensorflow/compiler/xla/client/executable_build_options.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kBatchSize = 4;
+
+// sum = x + y, for int32 vectors of kBatchSize requests of one element.
+GraphDef SumGraph() {
+  GraphDef graph_def;
+  AttrValue int32_type;
+  SetAttrValue(DT_INT32, &int32_type);
+  for (const char* name : {"x", "y"}) {
+    NodeDef* node = graph_def.add_node();
+    node->set_name(name);
+    node->set_op("Placeholder");
+    (*node->mutable_attr())["dtype"] = int32_type;
+  }
+  NodeDef* sum = graph_def.add_node();
+  sum->set_name("sum");
+  sum->set_op("Add");
+  sum->add_input("x");
+  sum->add_input("y");
+  (*sum->mutable_attr())["T"] = int32_type;
+  return graph_def;
+}
+
+tf2xla::Config SumConfig() {
+  tf2xla::Config config;
+  for (const char* name : {"x", "y"}) {
+    tf2xla::Feed* feed = config.add_feed();
+    feed->mutable_id()->set_node_name(name);
+    feed->mutable_shape()->add_dim()->set_size(kBatchSize);
+  }
+  config.add_fetch()->mutable_id()->set_node_name("sum");
+  return config;
+}
+
+class XlaBatchedCpuFunctionRunnerTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<XlaBatchedCpuFunctionRunner> NewRunner(
+      int64 batch_timeout_micros) {
+    auto jit_or = XlaJitCompiledCpuFunction::Compile(
+        SumGraph(), SumConfig(), xla::ExecutableBuildOptions());
+    TF_CHECK_OK(jit_or.status());
+    jit_ = std::move(jit_or.ValueOrDie());
+    XlaBatchedCpuFunctionRunner::Options options;
+    options.batch_timeout_micros = batch_timeout_micros;
+    return std::unique_ptr<XlaBatchedCpuFunctionRunner>(
+        new XlaBatchedCpuFunctionRunner(
+            std::unique_ptr<XlaCompiledCpuFunction>(
+                new XlaCompiledCpuFunction(jit_->StaticData())),
+            kBatchSize, {kBatchSize * sizeof(int32)}, options));
+  }
+
+  std::unique_ptr<XlaJitCompiledCpuFunction> jit_;
+};
+
+TEST_F(XlaBatchedCpuFunctionRunnerTest, Sizes) {
+  std::unique_ptr<XlaBatchedCpuFunctionRunner> runner = NewRunner(1000);
+  EXPECT_EQ(kBatchSize, runner->batch_size());
+  EXPECT_EQ(2, runner->num_args());
+  EXPECT_EQ(1, runner->num_results());
+  EXPECT_EQ(sizeof(int32), runner->arg_size(0));
+  EXPECT_EQ(sizeof(int32), runner->arg_size(1));
+  EXPECT_EQ(sizeof(int32), runner->result_size(0));
+}
+
+TEST_F(XlaBatchedCpuFunctionRunnerTest, RunsPartialBatch) {
+  std::unique_ptr<XlaBatchedCpuFunctionRunner> runner = NewRunner(0);
+  const int32 x = 10;
+  const int32 y = 32;
+  int32 sum = 0;
+  const void* args[] = {&x, &y};
+  void* results[] = {&sum};
+  EXPECT_TRUE(runner->Run(args, results));
+  EXPECT_EQ(42, sum);
+  EXPECT_EQ(1, runner->num_requests());
+  EXPECT_EQ(1, runner->num_batches());
+}
+
+TEST_F(XlaBatchedCpuFunctionRunnerTest, BatchesConcurrentRequests) {
+  // Long enough for all requests of a batch to arrive.
+  std::unique_ptr<XlaBatchedCpuFunctionRunner> runner = NewRunner(10000000);
+  constexpr int kNumRequests = 4 * kBatchSize;
+  std::vector<int32> sums(kNumRequests, -1);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumRequests; ++i) {
+    threads.emplace_back([&runner, &sums, i]() {
+      const int32 x = i;
+      const int32 y = 100 * i;
+      const void* args[] = {&x, &y};
+      void* results[] = {&sums[i]};
+      EXPECT_TRUE(runner->Run(args, results));
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int i = 0; i < kNumRequests; ++i) {
+    EXPECT_EQ(101 * i, sums[i]);
+  }
+  EXPECT_EQ(kNumRequests, runner->num_requests());
+  EXPECT_EQ(kNumRequests / kBatchSize, runner->num_batches());
+}
+
+}  // namespace
+}  // namespace tensorflow
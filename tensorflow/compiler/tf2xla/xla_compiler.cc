@@ -84,6 +84,34 @@ Status CheckSignature(const DataTypeVector& types,
   return Status::OK();
 }
 
+// Checks that the `extra_args` past the arguments of the function are scalar
+// DT_INT32 parameters, each holding the size of a dynamic dimension of one of
+// the `function_args`.
+Status CheckDynamicSizeArguments(
+    absl::Span<const XlaCompiler::Argument> function_args,
+    absl::Span<const XlaCompiler::Argument> extra_args) {
+  std::set<int> size_arg_nums;
+  for (const XlaCompiler::Argument& arg : function_args) {
+    for (const auto& dim_and_arg_num : arg.dynamic_dim_to_arg_num_map) {
+      size_arg_nums.insert(dim_and_arg_num.second);
+    }
+  }
+  for (int i = 0, end = extra_args.size(); i < end; ++i) {
+    const XlaCompiler::Argument& arg = extra_args[i];
+    const int arg_num = function_args.size() + i;
+    if (!size_arg_nums.count(arg_num) ||
+        arg.kind != XlaCompiler::Argument::kParameter ||
+        arg.type != DT_INT32 || !arg.DimensionSizes().empty()) {
+      return errors::Internal(
+          "Compilation arguments have ", function_args.size() + extra_args.size(),
+          " elements while function has ", function_args.size(),
+          " and argument ", arg_num,
+          " is not the size of a dynamic dimension: ", arg.HumanString());
+    }
+  }
+  return Status::OK();
+}
+
 // Uses the _Arg and _Retval nodes in the graph to determine an OpSharding for
 // each argument and return value.
 xla::StatusOr<
@@ -161,6 +189,9 @@ Status ExecuteGraph(XlaContext* xla_context, std::unique_ptr<Graph> graph,
 //   `resource_updates` is a ResourceUpdate, whose `index` is the index of a
 //   resource variable argument to the computation to be updated, and `type` is
 //   the type of the final output.
+// - If `alias_parameter_outputs` is true, each non-constant return value of
+//   an entry computation is aliased with the first parameter argument of the
+//   same type and shape that no other output aliases.
 Status BuildComputation(
     const std::vector<XlaCompiler::Argument>& args,
     const std::vector<XlaExpression>& retvals,
@@ -171,8 +202,9 @@ Status BuildComputation(
     const XlaCompiler::ShapeRepresentationFn& shape_representation_fn,
     bool is_entry_computation, bool return_updated_values_for_all_resources,
     bool always_return_tuple, bool use_tuple_arg, bool alias_resource_update,
-    xla::XlaBuilder* builder, xla::XlaComputation* computation,
-    int* num_computation_outputs, int* num_nonconst_outputs,
+    bool alias_parameter_outputs, xla::XlaBuilder* builder,
+    xla::XlaComputation* computation, int* num_computation_outputs,
+    int* num_nonconst_outputs,
     std::vector<XlaCompiler::OutputDescription>* outputs,
     std::vector<XlaCompiler::ResourceUpdate>* resource_updates,
     xla::Shape* output_shape, absl::Span<int const> input_mapping) {
@@ -195,6 +227,10 @@ Status BuildComputation(
   std::vector<xla::XlaOp> elems;
   elems.reserve(retvals.size());
 
+  std::vector<xla::XlaBuilder::InputOutputAlias> aliases;
+  // Parameters already aliased with a return value.
+  std::vector<bool> aliased_params(input_mapping.size(), false);
+
   // Keeps track of sharding of each retval. If a retval is not in this list,
   // replicate sharding is used. The first element is the output index, second
   // element is the sharding.
@@ -242,6 +278,27 @@ Status BuildComputation(
           value = identity_op(value);
         }
 
+        if (alias_parameter_outputs && is_entry_computation &&
+            !use_tuple_arg && it == retval_shardings.end()) {
+          TF_ASSIGN_OR_RETURN(xla::Shape value_shape, builder->GetShape(value));
+          for (int xla_arg = 0; xla_arg < input_mapping.size(); ++xla_arg) {
+            const XlaCompiler::Argument& arg = args[input_mapping[xla_arg]];
+            const TensorShape* arg_shape =
+                absl::get_if<TensorShape>(&arg.shape);
+            if (aliased_params[xla_arg] || !value_shape.is_static() ||
+                arg.kind != XlaCompiler::Argument::kParameter ||
+                arg.type != output.type || arg_shape == nullptr ||
+                *arg_shape != output.shape) {
+              continue;
+            }
+            xla::ShapeIndex output_index({static_cast<int64>(elems.size())});
+            VLOG(3) << "Storing alias: " << output_index.ToString() << ": ("
+                    << xla_arg << ", {})";
+            aliases.push_back({output_index, xla_arg, xla::ShapeIndex{}});
+            aliased_params[xla_arg] = true;
+            break;
+          }
+        }
         elems.push_back(value);
         break;
       }
@@ -280,7 +337,6 @@ Status BuildComputation(
     argument_to_xla_arg[input_mapping[xla_arg]] = xla_arg;
   }
 
-  std::vector<xla::XlaBuilder::InputOutputAlias> aliases;
   for (const XlaResource* resource : arg_resources) {
     DCHECK_LT(resource->arg_num(), args.size());
     const XlaCompiler::Argument& arg = args[resource->arg_num()];
@@ -742,20 +798,35 @@ Status XlaCompiler::CompileFunction(
     config_proto = *config;
   }
 
+  // Arguments past the ones of the function may only hold the sizes of
+  // dynamic dimensions of other arguments.
+  absl::Span<const XlaCompiler::Argument> function_args = args;
+  if (args.size() > fbody->arg_types.size()) {
+    function_args = args.subspan(0, fbody->arg_types.size());
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(
+        CheckDynamicSizeArguments(function_args,
+                                  args.subspan(fbody->arg_types.size())),
+        "Signature check failure while compiling: ", fn_name_attrs.name());
+  }
   TF_RETURN_WITH_CONTEXT_IF_ERROR(
-      CheckSignature(fbody->arg_types, args),
+      CheckSignature(fbody->arg_types, function_args),
       "Signature check failure while compiling: ", fn_name_attrs.name());
 
   // Set shapes for _Arg nodes. They are useful for constant folding (e.g. an
   // Xla op requires a compile-time constant input, and that input is shape of
   // an _Arg node.
-  for (int i = 0, end = args.size(); i < end; i++) {
+  for (int i = 0, end = function_args.size(); i < end; i++) {
     // Skip resource variables and tensor lists.
     DataType dtype;
     TF_RETURN_IF_ERROR(GetNodeAttr(fbody->arg_nodes[i]->def(), "T", &dtype));
     if (dtype == DT_RESOURCE || dtype == DT_VARIANT) {
       continue;
     }
+    // The shapes of arguments with dynamic dimensions are only known at run
+    // time, so don't let them be constant folded.
+    if (!args[i].dynamic_dim_to_arg_num_map.empty()) {
+      continue;
+    }
 
     if (absl::holds_alternative<xla::Shape>(args[i].shape)) {
       xla::Shape xla_shape = absl::get<xla::Shape>(args[i].shape);
@@ -1171,6 +1242,34 @@ Status XlaCompiler::BuildArguments(
     }
   }
 
+  // Bind the dynamic dimensions of parameters to the sizes passed in other
+  // parameters.
+  absl::flat_hash_map<int, int> arg_to_parameter;
+  for (int i = 0, end = input_to_args->size(); i < end; ++i) {
+    arg_to_parameter[input_to_args->at(i)] = i;
+  }
+  for (int i = 0, end = input_to_args->size(); i < end; ++i) {
+    const XlaCompiler::Argument& arg = args[input_to_args->at(i)];
+    if (arg.kind != XlaCompiler::Argument::kParameter) continue;
+    XlaExpression& arg_expression = (*arg_expressions)[input_to_args->at(i)];
+    for (const auto& dim_and_arg_num : arg.dynamic_dim_to_arg_num_map) {
+      auto it = arg_to_parameter.find(dim_and_arg_num.second);
+      if (it == arg_to_parameter.end()) {
+        return errors::InvalidArgument(
+            "Size of dynamic dimension ", dim_and_arg_num.first, " of argument ",
+            input_to_args->at(i), " refers to argument ",
+            dim_and_arg_num.second, ", which is not a parameter");
+      }
+      VLOG(2) << "Dynamic dimension " << dim_and_arg_num.first
+              << " of argument " << input_to_args->at(i)
+              << " has its size in argument " << dim_and_arg_num.second;
+      arg_expression = XlaExpression::XlaOp(
+          xla::SetDimensionSize(arg_expression.handle(),
+                                arg_handles[it->second], dim_and_arg_num.first),
+          arg.type);
+    }
+  }
+
   return Status::OK();
 }
 
@@ -1396,10 +1495,10 @@ Status XlaCompiler::CompileGraph(
       options.is_entry_computation,
       options.return_updated_values_for_all_resources,
       options.always_return_tuple, options.use_tuple_arg,
-      options.alias_resource_update, &builder, result->computation.get(),
-      &num_computation_outputs, &num_nonconst_outputs, &result->outputs,
-      &result->resource_updates, &result->xla_output_shape,
-      result->input_mapping));
+      options.alias_resource_update, options.alias_parameter_outputs, &builder,
+      result->computation.get(), &num_computation_outputs,
+      &num_nonconst_outputs, &result->outputs, &result->resource_updates,
+      &result->xla_output_shape, result->input_mapping));
 
   VLOG(2) << "Outputs: total: " << context->retvals().size()
           << " nonconstant: " << num_nonconst_outputs;
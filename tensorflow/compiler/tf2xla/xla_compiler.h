@@ -130,6 +130,13 @@ class XlaCompiler {
     // Resource updates are converted into input / output of xla. The two
     // buffers are aliased with other if this option is true.
     bool alias_resource_update = false;
+
+    // If true, each non-constant output is aliased with a parameter argument
+    // of the same type and shape, so that a caller that donates the argument's
+    // buffer at run time gets the output written into it in place. Only
+    // worthwhile when the caller usually owns its inputs: an aliased argument
+    // that is not donated is copied by the executable.
+    bool alias_parameter_outputs = false;
   };
 
   using OutputDescription = ::tensorflow::XlaOutputDescription;
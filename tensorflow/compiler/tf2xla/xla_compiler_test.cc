@@ -1908,6 +1908,48 @@ TEST_F(XlaCompilerTest, AliasResourceUpdates) {
   EXPECT_EQ(alias.entries(0).parameter_number(), 0);
 }
 
+TEST_F(XlaCompilerTest, AliasParameterOutputs) {
+  Scope scope = Scope::NewRootScope().ExitOnError();
+  auto a = ops::_Arg(scope.WithOpName("A"), DT_INT32, 0);
+  auto b = ops::_Arg(scope.WithOpName("B"), DT_INT32, 1);
+  auto c = ops::Neg(scope.WithOpName("C"), a);
+  auto d = ops::Neg(scope.WithOpName("D"), b);
+  auto e = ops::Add(scope.WithOpName("E"), a, a);
+  auto f = ops::_Retval(scope.WithOpName("F"), c, 0);
+  auto g = ops::_Retval(scope.WithOpName("G"), d, 1);
+  auto h = ops::_Retval(scope.WithOpName("H"), e, 2);
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(scope.ToGraph(graph.get()));
+
+  // Builds a description of the arguments.
+  std::vector<XlaCompiler::Argument> args(2);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_INT32;
+  args[0].shape = TensorShape({2});
+  args[1].kind = XlaCompiler::Argument::kParameter;
+  args[1].type = DT_INT32;
+  args[1].shape = TensorShape({3});
+
+  XlaCompiler compiler(DefaultOptions());
+
+  XlaCompiler::CompileOptions compile_options;
+  compile_options.alias_parameter_outputs = true;
+
+  XlaCompiler::CompilationResult result;
+  TF_ASSERT_OK(compiler.CompileGraph(compile_options, "neg", std::move(graph),
+                                     args, &result));
+
+  // Each parameter is aliased with the first output of its shape; "E" has
+  // no parameter left to alias.
+  const xla::HloInputOutputAliasProto& alias =
+      result.computation->proto().input_output_alias();
+  ASSERT_EQ(alias.entries_size(), 2);
+  EXPECT_EQ(alias.entries(0).parameter_number(), 0);
+  EXPECT_THAT(alias.entries(0).output_shape_index(), ::testing::ElementsAre(0));
+  EXPECT_EQ(alias.entries(1).parameter_number(), 1);
+  EXPECT_THAT(alias.entries(1).output_shape_index(), ::testing::ElementsAre(1));
+}
+
 // Tests that passing in an exact duplicate input to SetDeviceToHostMeatadata
 // is not an error.
 TEST_F(XlaCompilerTest, SetDeviceToHostMetadataExactDuplicate) {
@@ -634,6 +634,27 @@ static void AllocateFlags() {
       bool_setter_for(&DebugOptions::set_xla_gpu_deterministic_ops),
       flag_values->xla_gpu_deterministic_ops(),
       "Guarantees run-to-run determinism on GPU."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Captures sequences of GPU kernels into CUDA graphs on the first run "
+      "with a given set of buffers and replays them afterwards, to reduce "
+      "kernel launch overhead."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_latency_hiding_scheduler",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_enable_latency_hiding_scheduler),
+      flag_values->xla_gpu_enable_latency_hiding_scheduler(),
+      "Schedules independent compute between the start and the end of "
+      "collectives to hide communication latency, within a peak memory "
+      "budget."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_rematerialization",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_rematerialization),
+      flag_values->xla_gpu_enable_rematerialization(),
+      "Rematerializes values after fusion so that the program fits into the "
+      "free device memory, trading recompute FLOPs for bytes."));
 
   ParseFlagsFromEnvAndDieIfUnknown("XLA_FLAGS", *flag_objects);
 }
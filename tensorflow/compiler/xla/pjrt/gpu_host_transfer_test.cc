@@ -0,0 +1,126 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/compiler/xla/pjrt/gpu_device.h"
+#include "tensorflow/compiler/xla/pjrt/pjrt_client.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+
+namespace xla {
+namespace {
+
+std::unique_ptr<PjRtClient> GetClient() {
+  auto client = GetGpuClient(/*asynchronous=*/true, GpuAllocatorConfig(),
+                             /*distributed_client=*/nullptr, /*node_id=*/0);
+  TF_CHECK_OK(client.status());
+  return client.ConsumeValueOrDie();
+}
+
+// Transfers a mix of arrays that are coalesced into one staging buffer and of
+// arrays that are transferred on their own, and reads them back.
+TEST(GpuHostTransfer, BuffersFromHostBuffersMixesCoalescedAndSeparateArrays) {
+  std::unique_ptr<PjRtClient> client = GetClient();
+  PjRtDevice* device = client->addressable_devices().at(0);
+
+  // Small dense arrays, which are coalesced, including an empty one.
+  std::vector<int32> small_s32 = {1, -2, 3};
+  std::vector<float> small_f32(1000);
+  std::iota(small_f32.begin(), small_f32.end(), 0.5f);
+  std::vector<int8> small_s8 = {7, 8, 9, 10, 11};
+  float empty_f32 = 0;
+  // An array larger than the coalescing limit.
+  std::vector<int32> large_s32(1 << 19);
+  std::iota(large_s32.begin(), large_s32.end(), -100);
+  // A column-major array, whose host layout is not its device layout:
+  // [[1, 2, 3], [4, 5, 6]].
+  std::vector<float> column_major_f32 = {1, 4, 2, 5, 3, 6};
+
+  std::vector<PjRtClient::HostBuffer> host_buffers = {
+      {small_s32.data(), ShapeUtil::MakeShape(S32, {3})},
+      {large_s32.data(),
+       ShapeUtil::MakeShape(S32, {static_cast<int64>(large_s32.size())})},
+      {small_f32.data(), ShapeUtil::MakeShape(F32, {1000})},
+      {column_major_f32.data(),
+       ShapeUtil::MakeShapeWithLayout(F32, {2, 3}, {0, 1})},
+      {&empty_f32, ShapeUtil::MakeShape(F32, {0})},
+      {small_s8.data(), ShapeUtil::MakeShape(S8, {5})},
+  };
+  tensorflow::BlockingCounter done_with_host_buffers(host_buffers.size());
+  for (PjRtClient::HostBuffer& host_buffer : host_buffers) {
+    host_buffer.on_done_with_host_buffer = [&done_with_host_buffers]() {
+      done_with_host_buffers.DecrementCount();
+    };
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+      client->BuffersFromHostBuffers(
+          absl::MakeSpan(host_buffers),
+          PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes,
+          device));
+  ASSERT_EQ(host_buffers.size(), buffers.size());
+  for (const auto& buffer : buffers) {
+    EXPECT_EQ(device, buffer->device());
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(auto literal, buffers[0]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<int32>(small_s32, *literal);
+  TF_ASSERT_OK_AND_ASSIGN(literal, buffers[1]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<int32>(large_s32, *literal);
+  TF_ASSERT_OK_AND_ASSIGN(literal, buffers[2]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<float>(small_f32, *literal);
+  TF_ASSERT_OK_AND_ASSIGN(literal, buffers[3]->ToLiteral());
+  LiteralTestUtil::ExpectR2Equal<float>({{1, 2, 3}, {4, 5, 6}}, *literal);
+  TF_ASSERT_OK_AND_ASSIGN(literal, buffers[4]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<float>({}, *literal);
+  TF_ASSERT_OK_AND_ASSIGN(literal, buffers[5]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<int8>(small_s8, *literal);
+
+  done_with_host_buffers.Wait();
+}
+
+// The coalesced arrays are gathered before BuffersFromHostBuffers returns, so
+// their host buffers may be overwritten right away.
+TEST(GpuHostTransfer, BuffersFromHostBuffersCopiesCoalescedArrays) {
+  std::unique_ptr<PjRtClient> client = GetClient();
+  PjRtDevice* device = client->addressable_devices().at(0);
+
+  std::vector<int32> a = {1, 2, 3, 4};
+  std::vector<int32> b = {5, 6};
+  std::vector<PjRtClient::HostBuffer> host_buffers = {
+      {a.data(), ShapeUtil::MakeShape(S32, {4})},
+      {b.data(), ShapeUtil::MakeShape(S32, {2})},
+  };
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+      client->BuffersFromHostBuffers(
+          absl::MakeSpan(host_buffers),
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, device));
+  std::fill(a.begin(), a.end(), 0);
+  std::fill(b.begin(), b.end(), 0);
+
+  TF_ASSERT_OK_AND_ASSIGN(auto literal, buffers[0]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<int32>({1, 2, 3, 4}, *literal);
+  TF_ASSERT_OK_AND_ASSIGN(literal, buffers[1]->ToLiteral());
+  LiteralTestUtil::ExpectR1Equal<int32>({5, 6}, *literal);
+}
+
+}  // namespace
+}  // namespace xla
@@ -34,4 +34,22 @@ StatusOr<std::uintptr_t> PjRtClient::UnsafeBufferPointer(PjRtBuffer* buffer) {
   return absl::bit_cast<std::uintptr_t>(ptr);
 }
 
+StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+PjRtClient::BuffersFromHostBuffers(absl::Span<HostBuffer> host_buffers,
+                                   HostBufferSemantics host_buffer_semantics,
+                                   PjRtDevice* device) {
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers;
+  buffers.reserve(host_buffers.size());
+  for (HostBuffer& host_buffer : host_buffers) {
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<PjRtBuffer> buffer,
+        BufferFromHostBuffer(host_buffer.data, host_buffer.shape,
+                             host_buffer_semantics,
+                             std::move(host_buffer.on_done_with_host_buffer),
+                             device));
+    buffers.push_back(std::move(buffer));
+  }
+  return buffers;
+}
+
 }  // namespace xla
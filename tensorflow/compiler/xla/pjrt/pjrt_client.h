@@ -343,6 +343,24 @@ class PjRtClient {
       HostBufferSemantics host_buffer_semantics,
       std::function<void()> on_done_with_host_buffer, PjRtDevice* device) = 0;
 
+  // An array argument to BuffersFromHostBuffers.
+  struct HostBuffer {
+    const void* data;
+    Shape shape;
+    // Optional; follows the same rules as in BufferFromHostBuffer.
+    std::function<void()> on_done_with_host_buffer;
+  };
+
+  // Transfers several arrays to `device`, as if by calling
+  // BufferFromHostBuffer on each of them. Implementations may coalesce the
+  // transfers, which is much cheaper than transferring many small arrays one
+  // by one. If an error is returned, the callbacks of some of the arrays may
+  // already have been called.
+  virtual StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+  BuffersFromHostBuffers(absl::Span<HostBuffer> host_buffers,
+                         HostBufferSemantics host_buffer_semantics,
+                         PjRtDevice* device);
+
   // Note that literal must remain in scope until the transfer has completed, so
   // the caller should, for example, wait for BlockHostUntilReady() completes on
   // the return value before letting literal go out of scope.
@@ -500,6 +500,11 @@ Status AddDestinationBufferSynchronization(
   return Status::OK();
 }
 
+// Arrays larger than this are transferred on their own by
+// BuffersFromHostBuffers: coalescing them would mostly add a device-to-device
+// copy to a transfer that is already bandwidth-bound.
+constexpr int64 kMaxCoalescedTransferBytes = 1 << 20;
+
 }  // namespace
 
 PjRtStreamExecutorBuffer::ScopedHold::~ScopedHold() {
@@ -854,6 +859,141 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
   return std::unique_ptr<PjRtBuffer>(std::move(py_buffer));
 }
 
+StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+PjRtStreamExecutorClient::BuffersFromHostBuffers(
+    absl::Span<HostBuffer> host_buffers,
+    HostBufferSemantics host_buffer_semantics, PjRtDevice* device) {
+  tensorflow::profiler::TraceMe traceme(
+      "PjRtStreamExecutorClient::BuffersFromHostBuffers");
+  TF_ASSIGN_OR_RETURN(LocalDeviceState * local_device,
+                      tensorflow::down_cast<PjRtStreamExecutorDevice*>(device)
+                          ->GetLocalDeviceState());
+  // The device-side staging buffer is freed at the tail of the host to device
+  // stream, which is only safe in the compute-synchronized allocation model.
+  if (local_device->allocation_model() !=
+      LocalDeviceState::kComputeSynchronized) {
+    return PjRtClient::BuffersFromHostBuffers(
+        host_buffers, host_buffer_semantics, device);
+  }
+
+  // Picks the arrays that can be copied as raw bytes, i.e. small dense arrays
+  // whose host layout is the layout they have on the device.
+  TransferManager* transfer_manager = client()->backend().transfer_manager();
+  std::vector<int> coalesced;
+  std::vector<int64> offsets;
+  int64 staging_size = 0;
+  for (int i = 0; i < host_buffers.size(); ++i) {
+    const Shape& shape = host_buffers[i].shape;
+    if (!shape.IsArray() || !shape.is_static() ||
+        ShapeUtil::ByteSizeOf(shape) > kMaxCoalescedTransferBytes) {
+      continue;
+    }
+    TF_ASSIGN_OR_RETURN(Shape compact_shape,
+                        transfer_manager->ChooseCompactLayoutForShape(shape));
+    if (shape.layout() != compact_shape.layout() ||
+        transfer_manager->HostShapeToDeviceShape(compact_shape) !=
+            compact_shape) {
+      continue;
+    }
+    coalesced.push_back(i);
+    offsets.push_back(staging_size);
+    staging_size +=
+        RoundUpToNearest<int64>(ShapeUtil::ByteSizeOf(shape),
+                                tensorflow::Allocator::kAllocatorAlignment);
+  }
+  if (coalesced.size() < 2) {
+    return PjRtClient::BuffersFromHostBuffers(
+        host_buffers, host_buffer_semantics, device);
+  }
+
+  // The staging buffer on the device is allocated before the destination
+  // buffers, so that the wait for the compute stream enqueued by
+  // AllocateDestinationBuffer covers it too.
+  se::Stream* h2d_stream = local_device->host_to_device_stream();
+  TF_ASSIGN_OR_RETURN(
+      se::OwningDeviceMemory device_staging_memory,
+      allocator()->Allocate(local_device->device_ordinal(), staging_size));
+  auto device_staging_buffer = std::make_shared<se::OwningDeviceMemory>(
+      std::move(device_staging_memory));
+
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers(host_buffers.size());
+  std::vector<PjRtStreamExecutorBuffer::ScopedHold::ForClosure> device_buffers;
+  device_buffers.reserve(coalesced.size());
+  for (int i : coalesced) {
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<PjRtStreamExecutorBuffer> py_buffer,
+        AllocateDestinationBuffer(host_buffers[i].shape, device, local_device,
+                                  h2d_stream,
+                                  /*is_uninitialized_create=*/false, this));
+    PjRtStreamExecutorBuffer::ScopedHold device_buffer(
+        py_buffer->GetBufferWithUsageHold());
+    CHECK(device_buffer.ok());
+    device_buffers.push_back(device_buffer.ToClosure());
+    buffers[i] = std::move(py_buffer);
+  }
+
+  // Gathers the arrays into pinned host memory right away, so the callers'
+  // buffers can be released before returning under every host buffer
+  // semantics.
+  void* ptr = host_memory_allocator()->AllocateRaw(
+      tensorflow::Allocator::kAllocatorAlignment, staging_size);
+  std::shared_ptr<void> staging_buffer(
+      ptr, [host_memory_allocator = host_memory_allocator()](void* ptr) {
+        host_memory_allocator->DeallocateRaw(ptr);
+      });
+  for (int j = 0; j < coalesced.size(); ++j) {
+    HostBuffer& host_buffer = host_buffers[coalesced[j]];
+    std::memcpy(static_cast<char*>(staging_buffer.get()) + offsets[j],
+                host_buffer.data, ShapeUtil::ByteSizeOf(host_buffer.shape));
+    if (host_buffer.on_done_with_host_buffer) {
+      host_buffer.on_done_with_host_buffer();
+      host_buffer.on_done_with_host_buffer = nullptr;
+    }
+  }
+
+  // As in BufferFromHostBuffer, the DMA is enqueued on the thread pool; it is
+  // OK to refer to the destination buffers through their usage holds.
+  auto transfer_h2d = [local_device, h2d_stream, staging_size, offsets,
+                       device_buffers{std::move(device_buffers)},
+                       staging_buffer{std::move(staging_buffer)},
+                       device_staging_buffer{
+                           std::move(device_staging_buffer)}]() {
+    se::DeviceMemoryBase device_staging = device_staging_buffer->cref();
+    h2d_stream->ThenMemcpy(&device_staging, staging_buffer.get(),
+                           staging_size);
+    for (int j = 0; j < device_buffers.size(); ++j) {
+      PjRtStreamExecutorBuffer::ScopedHold device_buffer(device_buffers[j]);
+      se::DeviceMemoryBase destination = device_buffer->device_memory()[0];
+      if (destination.size() > 0) {
+        se::DeviceMemoryBase source(
+            static_cast<char*>(device_staging.opaque()) + offsets[j],
+            destination.size());
+        h2d_stream->ThenMemcpy(&destination, source, destination.size());
+      }
+      std::shared_ptr<BufferSequencingEvent> event =
+          device_buffer->definition_events()[0];
+      TF_CHECK_OK(AddDestinationBufferSynchronization(
+          local_device, std::move(device_buffer), event, h2d_stream));
+    }
+    local_device->ThenRelease(
+        h2d_stream, std::make_pair(staging_buffer, device_staging_buffer));
+  };
+  thread_pool()->Schedule(transfer_h2d);
+
+  for (int i = 0; i < host_buffers.size(); ++i) {
+    if (buffers[i] == nullptr) {
+      HostBuffer& host_buffer = host_buffers[i];
+      TF_ASSIGN_OR_RETURN(
+          buffers[i],
+          BufferFromHostBuffer(host_buffer.data, host_buffer.shape,
+                               host_buffer_semantics,
+                               std::move(host_buffer.on_done_with_host_buffer),
+                               device));
+    }
+  }
+  return buffers;
+}
+
 StatusOr<std::unique_ptr<PjRtBuffer>>
 PjRtStreamExecutorClient::CreateUninitializedBuffer(const Shape& shape,
                                                     PjRtDevice* device) {
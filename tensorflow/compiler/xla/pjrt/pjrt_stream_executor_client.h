@@ -200,6 +200,14 @@ class PjRtStreamExecutorClient : public PjRtClient {
       std::function<void()> on_done_with_host_buffer,
       PjRtDevice* device) override;
 
+  // Copies the small arrays into one pinned staging buffer, transfers it with
+  // a single DMA and scatters the arrays with device-to-device copies. Only
+  // used on devices with the kComputeSynchronized allocation model; other
+  // arrays and devices fall back to one BufferFromHostBuffer call per array.
+  StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>> BuffersFromHostBuffers(
+      absl::Span<HostBuffer> host_buffers,
+      HostBufferSemantics host_buffer_semantics, PjRtDevice* device) override;
+
   StatusOr<std::unique_ptr<PjRtBuffer>> BufferFromHostLiteral(
       const LiteralSlice& literal, PjRtDevice* device) override;
 
@@ -75,7 +75,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_layout_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_memory_space_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
+#include "tensorflow/compiler/xla/service/cpu/dot_autotuner.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
@@ -404,7 +406,8 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
 
 Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     HloModule* module, bool is_aot_compile,
-    LLVMTargetMachineFeatures* target_machine_features) {
+    LLVMTargetMachineFeatures* target_machine_features,
+    int64 aot_max_parallelism) {
   HloPassPipeline pipeline("HLO passes after layout assignment");
   // After layout assignment, use a layout-sensitive verifier.
 
@@ -431,16 +434,26 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   }
 
   // Outline ops in the entry computation into calls to subcomputations.
+  // JIT compiles size the partitioning to this host.  AOT compiles default to
+  // single-threaded code, which avoids pulling thread pool and
+  // synchronization dependencies into the binary, unless the caller opts in
+  // via CpuAotCompilationOptions::set_max_parallelism.
   const int max_parallelism =
-      module->config().intra_op_parallelism_threads() > 0
-          ? module->config().intra_op_parallelism_threads()
-          : tensorflow::port::NumSchedulableCPUs();
+      is_aot_compile
+          ? aot_max_parallelism
+          : module->config().intra_op_parallelism_threads() > 0
+                ? module->config().intra_op_parallelism_threads()
+                : tensorflow::port::NumSchedulableCPUs();
   if (!is_aot_compile) {
+    // Pick the fastest implementation of each GEMM by timing it on this host.
+    // AOT compiles target some other machine, where these timings say nothing.
+    pipeline.AddPass<DotAutotuner>([this](std::unique_ptr<HloModule> module) {
+      return RunBackend(std::move(module), /*stream_exec=*/nullptr,
+                        CompileOptions());
+    });
+  }
+  if (!is_aot_compile || max_parallelism > 1) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
-    // binary size (and most AOT applications are single-threaded).
-    // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
         max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
   }
@@ -457,12 +470,14 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
 }
 
 Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
-                                 llvm::TargetMachine* target_machine) {
+                                 llvm::TargetMachine* target_machine,
+                                 int64 aot_max_parallelism) {
   LLVMTargetMachineFeatures target_machine_features(target_machine);
   TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(module, is_aot_compile,
                                                    &target_machine_features));
   return RunHloPassesAfterLayoutAssn(module, is_aot_compile,
-                                     &target_machine_features);
+                                     &target_machine_features,
+                                     aot_max_parallelism);
 }
 
 namespace {
@@ -472,6 +487,27 @@ int64 memory_alignment(LogicalBuffer::Color) {
   return cpu_function_runtime::kMinAlign;
 }
 
+// If a scratch memory size was requested, installs 'schedule' on 'module' and
+// runs memory space assignment to pack short-lived temporaries into the
+// cache-resident scratch arena. 'schedule' is updated with the schedule that
+// memory space assignment leaves on the module. Returns nullptr otherwise.
+StatusOr<std::unique_ptr<PresetAssignments>> AssignScratchMemory(
+    HloModule* module, const BufferValue::SizeFunction& size_fn,
+    HloSchedule* schedule) {
+  const int64 scratch_memory_size =
+      options::ScratchMemorySizeInBytes(module->config());
+  if (scratch_memory_size == 0) {
+    return std::unique_ptr<PresetAssignments>();
+  }
+  TF_RETURN_IF_ERROR(module->set_schedule(*schedule));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<PresetAssignments> preset_assignments,
+      RunCpuMemorySpaceAssignment(module, scratch_memory_size,
+                                  cpu_function_runtime::kMinAlign, size_fn));
+  *schedule = module->schedule();
+  return std::move(preset_assignments);
+}
+
 llvm::TargetOptions CompilerTargetOptions(
     const HloModuleConfig& module_config) {
   llvm::TargetOptions target_options;
@@ -607,13 +643,22 @@ CpuCompiler::RunHloPassesAndBufferAssignement(std::unique_ptr<HloModule> module,
                                      ComputationSchedulerToModuleScheduler(
                                          DFSMemoryScheduler)));
 
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PresetAssignments> preset_assignments,
+                      AssignScratchMemory(module.get(),
+                                          BufferSizeBytesFunction(),
+                                          &schedule));
+
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<BufferAssignment> assignment,
       BufferAssigner::Run(module.get(),
                           absl::make_unique<SequentialHloOrdering>(schedule),
                           BufferSizeBytesFunction(), memory_alignment,
-                          /*allocate_buffers_for_constants=*/true));
+                          /*allocate_buffers_for_constants=*/true,
+                          BufferAssigner::DefaultColorer(),
+                          /*must_not_live_out=*/{},
+                          /*can_share_buffer=*/nullptr,
+                          std::move(preset_assignments)));
 
   return std::make_tuple(std::move(module), std::move(assignment));
 }
@@ -722,13 +767,22 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
                                      ComputationSchedulerToModuleScheduler(
                                          DFSMemoryScheduler)));
 
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PresetAssignments> preset_assignments,
+                      AssignScratchMemory(module.get(),
+                                          BufferSizeBytesFunction(),
+                                          &schedule));
+
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<BufferAssignment> assignment,
       BufferAssigner::Run(module.get(),
                           absl::make_unique<SequentialHloOrdering>(schedule),
                           BufferSizeBytesFunction(), memory_alignment,
-                          /*allocate_buffers_for_constants=*/true));
+                          /*allocate_buffers_for_constants=*/true,
+                          BufferAssigner::DefaultColorer(),
+                          /*must_not_live_out=*/{},
+                          /*can_share_buffer=*/nullptr,
+                          std::move(preset_assignments)));
   DumpHloModuleIfEnabled(*module, *assignment, "after_optimizations");
 
   // Each computation is a single function.  Emit all embedded computations
@@ -911,8 +965,9 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
     HloModule* module = modules[i].get();
     VLOG(1) << "Compiling ahead-of-time: " << module->name();
 
-    TF_RETURN_IF_ERROR(
-        RunHloPasses(module, /*is_aot_compile=*/true, target_machine.get()));
+    TF_RETURN_IF_ERROR(RunHloPasses(module, /*is_aot_compile=*/true,
+                                    target_machine.get(),
+                                    options.max_parallelism()));
 
     TF_ASSIGN_OR_RETURN(HloSchedule schedule,
                         ScheduleModule(module, BufferSizeBytesFunction()));
@@ -70,12 +70,22 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
+  // The maximum number of partitions a single HLO may be split into by the
+  // ParallelTaskAssigner.  The default of 1 emits single-threaded code that
+  // has no thread pool dependency; larger values emit fork-join calls that run
+  // on the caller-supplied intra-op thread pool when one is set.
+  int64 max_parallelism() const { return max_parallelism_; }
+  void set_max_parallelism(int64 max_parallelism) {
+    max_parallelism_ = max_parallelism;
+  }
+
  private:
   const string triple_;
   const string cpu_name_;
   const string features_;
   const string entry_point_name_;
   const RelocationModel relocation_model_;
+  int64 max_parallelism_ = 1;
 };
 
 class CpuAotCompilationResult : public AotCompilationResult {
@@ -157,9 +167,11 @@ class CpuCompiler : public LLVMCompiler {
   static void InitializeLLVMTarget();
 
   // Runs the HLO passes which are necessary for both optimizations and
-  // correctness.
+  // correctness.  `aot_max_parallelism` bounds parallel task assignment for
+  // AOT compiles and is ignored otherwise.
   Status RunHloPasses(HloModule* module, bool is_aot_compile,
-                      llvm::TargetMachine* target_machine);
+                      llvm::TargetMachine* target_machine,
+                      int64 aot_max_parallelism = 1);
 
   // Runs HLO passes up to and including layout assignment.
   Status RunHloPassesThroughLayoutAssn(
@@ -169,7 +181,8 @@ class CpuCompiler : public LLVMCompiler {
   // Runs HLO passes after layout assignment.
   Status RunHloPassesAfterLayoutAssn(
       HloModule* module, bool is_aot_compile,
-      LLVMTargetMachineFeatures* target_machine_features);
+      LLVMTargetMachineFeatures* target_machine_features,
+      int64 aot_max_parallelism);
 
   TF_DISALLOW_COPY_AND_ASSIGN(CpuCompiler);
 };
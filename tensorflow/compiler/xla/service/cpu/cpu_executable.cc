@@ -29,6 +29,7 @@ limitations under the License.
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/computation_layout.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_memory_space_assignment.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
@@ -65,6 +66,11 @@ CpuExecutable::CpuExecutable(
       module_name_(entry_function_name) {
   if (assignment_) {
     buffer_assignment_.reset(new BufferAssignmentProto(assignment_->ToProto()));
+    for (const BufferAllocation& allocation : assignment_->Allocations()) {
+      if (allocation.color() == kCpuScratchMemorySpace) {
+        scratch_allocation_ = &allocation;
+      }
+    }
   }
   XlaDebugInfoManager::Get()->RegisterModule(module_name_, shared_module(),
                                              buffer_assignment_);
@@ -87,6 +93,33 @@ CpuExecutable::CpuExecutable(
 CpuExecutable::~CpuExecutable() {
   XlaDebugInfoManager::Get()->UnregisterModule(module_name_, shared_module(),
                                                buffer_assignment_);
+  tensorflow::mutex_lock lock(scratch_arena_mu_);
+  for (void* arena : free_scratch_arenas_) {
+    tensorflow::port::AlignedFree(arena);
+  }
+}
+
+void* CpuExecutable::AcquireScratchArena() {
+  {
+    tensorflow::mutex_lock lock(scratch_arena_mu_);
+    if (!free_scratch_arenas_.empty()) {
+      void* arena = free_scratch_arenas_.back();
+      free_scratch_arenas_.pop_back();
+      return arena;
+    }
+  }
+  const int64 size = scratch_allocation_->size();
+  void* arena = tensorflow::port::AlignedMalloc(size, kScratchArenaAlignment);
+  CHECK(arena != nullptr) << "Failed to allocate " << size
+                          << " bytes of scratch memory";
+  VLOG(3) << "scratch arena allocated " << size << " bytes [" << arena << "]";
+  TF_ANNOTATE_MEMORY_IS_INITIALIZED(arena, size);
+  return arena;
+}
+
+void CpuExecutable::ReleaseScratchArena(void* arena) {
+  tensorflow::mutex_lock lock(scratch_arena_mu_);
+  free_scratch_arenas_.push_back(arena);
 }
 
 static StatusOr<MaybeOwningDeviceMemory> MemoryForAllocation(
@@ -109,6 +142,11 @@ static StatusOr<MaybeOwningDeviceMemory> MemoryForAllocation(
   } else if (allocation.is_thread_local()) {
     VLOG(3) << "buffer is thread-local";
     return MaybeOwningDeviceMemory{se::DeviceMemoryBase{}};
+  } else if (allocation.color() == kCpuScratchMemorySpace) {
+    // Filled in from the scratch arena pool right before the computation is
+    // enqueued.
+    VLOG(3) << "buffer is in the scratch arena";
+    return MaybeOwningDeviceMemory{se::DeviceMemoryBase{}};
   }
 
   int64 buffer_size = allocation.size();
@@ -375,19 +413,32 @@ StatusOr<ExecutionOutput> CpuExecutable::ExecuteAsyncOnStream(
     ServiceExecutableRunOptions run_options;
     std::shared_ptr<std::vector<MaybeOwningDeviceMemory>> task_buffers;
     HloExecutionProfile* hlo_execution_profile;
+    void* scratch_arena;
 
     void operator()() {
       // Failing a CHECK here is not great, but I don't see an obvious way to
       // return a failed Status asynchronously.
       TF_CHECK_OK(executable->ExecuteComputeFunction(
           &run_options.run_options(), *task_buffers, hlo_execution_profile));
+      if (scratch_arena != nullptr) {
+        executable->ReleaseScratchArena(scratch_arena);
+      }
     }
   };
+
+  // The scratch arena is taken from the pool last, so that it is never lost
+  // on an error path above.
+  void* scratch_arena = nullptr;
+  if (scratch_allocation_ != nullptr) {
+    scratch_arena = AcquireScratchArena();
+    buffers[scratch_allocation_->index()] = MaybeOwningDeviceMemory{
+        se::DeviceMemoryBase{scratch_arena, scratch_allocation_->size()}};
+  }
   host_stream->EnqueueTask(
       AsyncRunTask{this, *run_options,
                    std::make_shared<std::vector<MaybeOwningDeviceMemory>>(
                        std::move(buffers)),
-                   hlo_execution_profile});
+                   hlo_execution_profile, scratch_arena});
 
   MarkToBeReleasedArguments(absl::MakeSpan(arguments), result);
   return std::move(result);
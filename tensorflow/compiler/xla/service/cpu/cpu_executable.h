@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/stream_executor/device_memory_allocator.h"
@@ -125,6 +126,16 @@ class CpuExecutable : public Executable {
   // computation. Uses dataflow analysis from buffer assignment.
   const InstructionValueSet& GetRootValueSet() const;
 
+  // Returns a scratch arena for the scratch allocation, reusing one released
+  // by an earlier execution when possible.
+  void* AcquireScratchArena();
+
+  // Returns 'arena' to the pool once the computation using it has finished.
+  void ReleaseScratchArena(void* arena);
+
+  // Scratch arenas are aligned to cache lines.
+  static constexpr int64 kScratchArenaAlignment = 64;
+
   // The JIT containing compiled modules.
   const std::unique_ptr<SimpleOrcJIT> jit_;
 
@@ -147,6 +158,15 @@ class CpuExecutable : public Executable {
   // Entry function name for the computation.
   const string entry_function_name_;
 
+  // The allocation packed by memory space assignment for the scratch memory
+  // space, or nullptr if there is none.
+  const BufferAllocation* scratch_allocation_ = nullptr;
+
+  // Scratch arenas not in use by a running computation. Handing the same
+  // arenas to later executions keeps them resident in the cache.
+  tensorflow::mutex scratch_arena_mu_;
+  std::vector<void*> free_scratch_arenas_ TF_GUARDED_BY(scratch_arena_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(CpuExecutable);
 };
 
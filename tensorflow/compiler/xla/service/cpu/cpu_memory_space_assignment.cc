@@ -0,0 +1,91 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/cpu_memory_space_assignment.h"
+
+#include <tuple>
+
+#include "tensorflow/compiler/xla/service/hlo_alias_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_live_range.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_value.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Buffers that stay live for more than this many instructions of the flattened
+// schedule are not worth keeping cache-resident.
+constexpr int64 kMaxScratchLiveRange = 16;
+
+bool IsAllowedInScratchMemory(const HloValue& value) {
+  const HloInstruction* instruction = value.instruction();
+  const HloComputation* computation = instruction->parent();
+  // Thread-local computations (e.g. reduction lambdas) may run concurrently,
+  // so only values of the sequentially executed entry computation qualify.
+  if (computation != computation->parent()->entry_computation()) {
+    return false;
+  }
+  if (instruction->opcode() == HloOpcode::kParameter ||
+      instruction->opcode() == HloOpcode::kConstant) {
+    return false;
+  }
+  return value.shape().IsArray() && !value.live_out_of_module();
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<PresetAssignments>> RunCpuMemorySpaceAssignment(
+    HloModule* module, int64 max_size_in_bytes, int64 alignment_in_bytes,
+    const BufferValue::SizeFunction& size_fn) {
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloAliasAnalysis> alias_analysis,
+                      HloAliasAnalysis::Run(module));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloLiveRange> hlo_live_range,
+                      HloLiveRange::Run(module->schedule(), *alias_analysis,
+                                        module->entry_computation()));
+
+  InstructionCountPrefetchIntervalPicker prefetch_interval_picker(
+      /*min_overlap_count=*/1, /*max_overlap_count=*/kMaxScratchLiveRange);
+
+  MemorySpaceAssignment::Options options;
+  options.alternate_memory_space = kCpuScratchMemorySpace;
+  options.max_size_in_bytes = max_size_in_bytes;
+  options.alignment_in_bytes = alignment_in_bytes;
+  options.size_fn = size_fn;
+  options.prefetch_interval_picker = &prefetch_interval_picker;
+  options.is_allowed_in_alternate_mem_fn = IsAllowedInScratchMemory;
+  // There is no asynchronous copy engine to overlap with on the host.
+  options.max_outstanding_prefetches = 0;
+  options.max_outstanding_evictions = 0;
+  options.enable_cross_program_prefetch = false;
+  // Place small, frequently used buffers first.
+  options.buffer_interval_compare =
+      [](const MemorySpaceAssignment::BufferInterval& x,
+         const MemorySpaceAssignment::BufferInterval& y) {
+        auto key = [](const MemorySpaceAssignment::BufferInterval& interval) {
+          const int64 num_uses = interval.buffer->uses().size();
+          return std::make_tuple(interval.size, -num_uses,
+                                 interval.buffer->id());
+        };
+        return key(x) < key(y);
+      };
+
+  return MemorySpaceAssignment::Run(module, *hlo_live_range, *alias_analysis,
+                                    options);
+}
+
+}  // namespace cpu
+}  // namespace xla
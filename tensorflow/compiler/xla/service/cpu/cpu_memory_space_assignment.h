@@ -0,0 +1,51 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_MEMORY_SPACE_ASSIGNMENT_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_MEMORY_SPACE_ASSIGNMENT_H_
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/memory_space_assignment.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// Memory space (and buffer color) of the scratch arena. Buffers assigned to it
+// are packed into a single allocation that CpuExecutable keeps around between
+// runs, so the arena stays warm in the cache.
+constexpr int64 kCpuScratchMemorySpace = 1;
+
+// Runs MemorySpaceAssignment on the scheduled 'module', modelling the per-core
+// cache as an alternate memory of 'max_size_in_bytes'. Only short-lived,
+// array-shaped temporaries of the entry computation are candidates; parameters,
+// constants and live-out values always stay in default memory. No prefetches
+// or evictions are inserted, so a buffer either lives in the scratch arena for
+// its whole lifetime or not at all.
+//
+// The returned preset assignments are meant to be passed to BufferAssigner,
+// together with the default colorer, which picks up the memory space set on
+// the assigned positions.
+StatusOr<std::unique_ptr<PresetAssignments>> RunCpuMemorySpaceAssignment(
+    HloModule* module, int64 max_size_in_bytes, int64 alignment_in_bytes,
+    const BufferValue::SizeFunction& size_fn);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_MEMORY_SPACE_ASSIGNMENT_H_
@@ -0,0 +1,86 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/cpu_memory_space_assignment.h"
+
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuMemorySpaceAssignmentTest : public HloTestBase {
+ protected:
+  static int64 SizeFn(const BufferValue& buffer) {
+    return ShapeUtil::ByteSizeOf(buffer.shape(), sizeof(void*));
+  }
+
+  StatusOr<std::unique_ptr<PresetAssignments>> Run(HloModule* module,
+                                                   int64 max_size_in_bytes) {
+    TF_ASSIGN_OR_RETURN(HloSchedule schedule, ScheduleModule(module, SizeFn));
+    TF_RETURN_IF_ERROR(module->set_schedule(schedule));
+    return RunCpuMemorySpaceAssignment(module, max_size_in_bytes,
+                                       /*alignment_in_bytes=*/16, SizeFn);
+  }
+};
+
+constexpr char kChainModule[] = R"(
+HloModule chain
+
+ENTRY main {
+  p0 = f32[64] parameter(0)
+  a = f32[64] negate(p0)
+  b = f32[64] exponential(a)
+  c = f32[64] add(a, b)
+  ROOT d = f32[64] multiply(c, p0)
+}
+)";
+
+TEST_F(CpuMemorySpaceAssignmentTest, IntermediatesGoToScratch) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kChainModule));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PresetAssignments> preset,
+                          Run(module.get(), /*max_size_in_bytes=*/4096));
+
+  EXPECT_FALSE(preset->chunks().empty());
+  for (const auto& position_and_chunk : preset->chunks()) {
+    const HloInstruction* instruction = position_and_chunk.first.instruction;
+    EXPECT_NE(instruction->opcode(), HloOpcode::kParameter);
+    EXPECT_NE(instruction, module->entry_computation()->root_instruction());
+    EXPECT_EQ(instruction->shape().layout().memory_space(),
+              kCpuScratchMemorySpace);
+  }
+  EXPECT_EQ(module->entry_computation()
+                ->root_instruction()
+                ->shape()
+                .layout()
+                .memory_space(),
+            0);
+}
+
+TEST_F(CpuMemorySpaceAssignmentTest, BuffersLargerThanScratchStayInDefault) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kChainModule));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PresetAssignments> preset,
+                          Run(module.get(), /*max_size_in_bytes=*/128));
+  EXPECT_TRUE(preset->chunks().empty());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
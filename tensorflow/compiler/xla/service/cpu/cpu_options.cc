@@ -26,6 +26,9 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kXlaCpuAutotuneDots = "xla_cpu_autotune_dots";
+const char* const kXlaCpuAutotuneDatabase = "xla_cpu_autotune_database";
+const char* const kXlaCpuScratchMemorySize = "xla_cpu_scratch_memory_size";
 
 }  // namespace
 
@@ -99,6 +102,35 @@ absl::optional<std::tuple<int64, int64, int64>> LlvmIrGemmTileSize(
                                          tile_size_n_in_vector_width);
 }
 
+bool DotAutotuningEnabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaCpuAutotuneDots) > 0;
+}
+
+absl::optional<std::string> DotAutotuneDatabasePath(
+    const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kXlaCpuAutotuneDatabase);
+  if (it == extra_options_map.end() || it->second.empty()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+int64 ScratchMemorySizeInBytes(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kXlaCpuScratchMemorySize);
+  int64 size_in_bytes;
+  if (it != extra_options_map.end() &&
+      absl::SimpleAtoi(it->second, &size_in_bytes) && size_in_bytes > 0) {
+    return size_in_bytes;
+  }
+  return 0;
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
@@ -30,6 +30,10 @@ bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config);
 absl::optional<int64> LlvmIrGemvTilingFactor(const HloModuleConfig& config);
 absl::optional<std::tuple<int64, int64, int64>> LlvmIrGemmTileSize(
     const HloModuleConfig& config);
+bool DotAutotuningEnabled(const HloModuleConfig& config);
+absl::optional<std::string> DotAutotuneDatabasePath(
+    const HloModuleConfig& config);
+int64 ScratchMemorySizeInBytes(const HloModuleConfig& config);
 
 }  // namespace options
 }  // namespace cpu
@@ -0,0 +1,337 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/dot_autotuner.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "llvm/Support/Host.h"
+#include "tensorflow/compiler/xla/cpu_function_runtime.h"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/backend_config.pb.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/maybe_owning_device_memory.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Tile sizes, as (m, k, n in vector register widths), tried for tiled LLVM IR
+// GEMMs.  The first entry is DotOpEmitter's built-in default.
+constexpr int64 kCandidateTileSizes[][3] = {
+    {11, 9, 1}, {8, 8, 1}, {4, 16, 1}, {16, 4, 1},
+    {8, 4, 2},  {4, 8, 2}, {4, 4, 4},
+};
+
+// Number of timed runs per candidate.  The fastest run is kept, which filters
+// out most of the noise from preemption and frequency scaling.
+constexpr int kNumTimedRuns = 5;
+
+struct TunedDot {
+  DotBackendConfig config;
+  int64 run_time_ns;
+};
+
+// Keyed by (host CPU name, dot key).  An ordered map keeps the database file
+// stable across runs.
+using DotAutotuneCacheKey = std::pair<std::string, std::string>;
+
+}  // namespace
+
+static tensorflow::mutex autotune_cache_mu(tensorflow::LINKER_INITIALIZED);
+static auto& autotune_cache TF_GUARDED_BY(autotune_cache_mu) =
+    *new std::map<DotAutotuneCacheKey, TunedDot>();
+// Database files that have already been merged into `autotune_cache`.
+static auto& loaded_databases TF_GUARDED_BY(autotune_cache_mu) =
+    *new absl::flat_hash_set<std::string>();
+
+// Returns true if `instr` is a GEMM that DotOpEmitter could lower either to a
+// runtime call or to a tiled LLVM IR GEMM, i.e. one worth autotuning.
+static bool IsTunableDot(const HloInstruction& instr) {
+  if (instr.opcode() != HloOpcode::kDot) {
+    return false;
+  }
+  const Shape& lhs_shape = instr.operand(0)->shape();
+  const Shape& rhs_shape = instr.operand(1)->shape();
+  const Shape& result_shape = instr.shape();
+  if (lhs_shape.rank() != 2 || rhs_shape.rank() != 2 ||
+      result_shape.rank() != 2) {
+    return false;
+  }
+  if (result_shape.element_type() != F32 &&
+      result_shape.element_type() != F64) {
+    return false;
+  }
+  // Matrix-vector products always go through the tiled GEMV emitter.
+  if (result_shape.dimensions(0) <= 1 || result_shape.dimensions(1) <= 1 ||
+      ShapeUtil::IsZeroElementArray(lhs_shape) ||
+      ShapeUtil::IsZeroElementArray(rhs_shape)) {
+    return false;
+  }
+  const DotDimensionNumbers& dnums = instr.dot_dimension_numbers();
+  if (dnums.lhs_contracting_dimensions(0) != 1 ||
+      dnums.rhs_contracting_dimensions(0) != 0) {
+    return false;
+  }
+  for (const Shape* shape : {&lhs_shape, &rhs_shape, &result_shape}) {
+    if (!LayoutUtil::IsMonotonicWithDim0Major(shape->layout())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::string DotKey(const HloInstruction& dot) {
+  return absl::StrCat(ShapeUtil::HumanStringWithLayout(dot.operand(0)->shape()),
+                      " x ",
+                      ShapeUtil::HumanStringWithLayout(dot.operand(1)->shape()),
+                      " -> ", ShapeUtil::HumanStringWithLayout(dot.shape()));
+}
+
+static std::vector<DotBackendConfig> CandidateConfigs(
+    const HloModuleConfig& config) {
+  std::vector<DotBackendConfig> candidates;
+  DotBackendConfig eigen;
+  eigen.set_strategy(DotBackendConfig::EIGEN);
+  candidates.push_back(eigen);
+  if (config.debug_options().xla_cpu_use_mkl_dnn()) {
+    DotBackendConfig mkl;
+    mkl.set_strategy(DotBackendConfig::MKL);
+    candidates.push_back(mkl);
+  }
+  for (const auto& tile_size : kCandidateTileSizes) {
+    DotBackendConfig tiled;
+    tiled.set_strategy(DotBackendConfig::TILED_LLVM_IR_GEMM);
+    tiled.set_tile_size_m(tile_size[0]);
+    tiled.set_tile_size_k(tile_size[1]);
+    tiled.set_tile_size_n_in_vector_width(tile_size[2]);
+    candidates.push_back(tiled);
+  }
+  return candidates;
+}
+
+// Compiles `dot` on its own, implemented as `candidate`, and returns the
+// fastest of several runs in nanoseconds.
+static StatusOr<int64> ProfileCandidate(
+    const HloInstruction& dot, const DotBackendConfig& candidate,
+    const DotAutotuner::CompileFn& compile_fn) {
+  HloComputation::Builder builder(absl::StrCat(dot.name(), ".autotune"));
+  HloInstruction* lhs = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, dot.operand(0)->shape(), "lhs"));
+  HloInstruction* rhs = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, dot.operand(1)->shape(), "rhs"));
+  HloInstruction* candidate_dot = builder.AddInstruction(
+      dot.CloneWithNewOperands(dot.shape(), {lhs, rhs}));
+  TF_RETURN_IF_ERROR(candidate_dot->set_backend_config(candidate));
+  std::unique_ptr<HloComputation> computation = builder.Build();
+
+  const HloModule& parent_module = *dot.GetModule();
+  HloModuleConfig config(computation->ComputeProgramShape(),
+                         /*ignore_layouts=*/false);
+  DebugOptions debug_options = parent_module.config().debug_options();
+  // Don't dump every candidate module alongside the real one.
+  debug_options.clear_xla_dump_to();
+  config.set_debug_options(debug_options);
+  auto module = absl::make_unique<HloModule>(
+      absl::StrCat(parent_module.name(), ".", dot.name(), ".autotune"),
+      config);
+  module->AddEntryComputation(std::move(computation));
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<Executable> executable,
+                      compile_fn(std::move(module)));
+  auto* cpu_executable = static_cast<CpuExecutable*>(executable.get());
+
+  std::vector<void*> allocations;
+  auto free_allocations = tensorflow::gtl::MakeCleanup([&allocations] {
+    for (void* allocation : allocations) {
+      tensorflow::port::AlignedFree(allocation);
+    }
+  });
+  std::vector<MaybeOwningDeviceMemory> buffers;
+  for (const BufferAllocation& allocation :
+       cpu_executable->buffer_assignment().Allocations()) {
+    if (allocation.is_constant() || allocation.is_thread_local()) {
+      buffers.emplace_back(se::DeviceMemoryBase());
+      continue;
+    }
+    void* data = tensorflow::port::AlignedMalloc(allocation.size(),
+                                                 cpu_function_runtime::kAlign);
+    if (data == nullptr) {
+      return ResourceExhausted("Failed to allocate %d bytes for autotuning",
+                               allocation.size());
+    }
+    allocations.push_back(data);
+    // The values don't matter for timing, but keep them away from NaNs and
+    // denormals, which are slow on some hosts.
+    memset(data, 0, allocation.size());
+    buffers.emplace_back(se::DeviceMemoryBase(data, allocation.size()));
+  }
+
+  ExecutableRunOptions run_options;
+  // The first run pays for page faults on the fresh buffers; don't time it.
+  TF_RETURN_IF_ERROR(cpu_executable->ExecuteComputeFunction(
+      &run_options, buffers, /*hlo_execution_profile=*/nullptr));
+  tensorflow::Env* env = tensorflow::Env::Default();
+  int64 best_ns = std::numeric_limits<int64>::max();
+  for (int i = 0; i < kNumTimedRuns; ++i) {
+    uint64 start_ns = env->NowNanos();
+    TF_RETURN_IF_ERROR(cpu_executable->ExecuteComputeFunction(
+        &run_options, buffers, /*hlo_execution_profile=*/nullptr));
+    best_ns = std::min<int64>(best_ns, env->NowNanos() - start_ns);
+  }
+  return best_ns;
+}
+
+static TunedDot AutotuneDot(const HloInstruction& dot,
+                            const DotAutotuner::CompileFn& compile_fn) {
+  absl::optional<TunedDot> best;
+  for (const DotBackendConfig& candidate :
+       CandidateConfigs(dot.GetModule()->config())) {
+    StatusOr<int64> run_time_ns = ProfileCandidate(dot, candidate, compile_fn);
+    if (!run_time_ns.ok()) {
+      VLOG(1) << "Skipping candidate " << candidate.ShortDebugString()
+              << " for " << dot.name() << ": " << run_time_ns.status();
+      continue;
+    }
+    VLOG(2) << DotKey(dot) << ": " << candidate.ShortDebugString() << " took "
+            << run_time_ns.ValueOrDie() << "ns";
+    if (!best.has_value() || run_time_ns.ValueOrDie() < best->run_time_ns) {
+      best = TunedDot{candidate, run_time_ns.ValueOrDie()};
+    }
+  }
+  if (!best.has_value()) {
+    LOG(WARNING) << "Unable to autotune " << dot.ToString()
+                 << "; none of the candidates ran successfully";
+    return TunedDot{DotBackendConfig(), 0};
+  }
+  VLOG(1) << "Autotuned " << DotKey(dot) << ": "
+          << best->config.ShortDebugString() << " (" << best->run_time_ns
+          << "ns)";
+  return *best;
+}
+
+static Status LoadDatabase(const std::string& path)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(autotune_cache_mu) {
+  if (!loaded_databases.insert(path).second) {
+    return Status::OK();
+  }
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->FileExists(path).ok()) {
+    return Status::OK();
+  }
+  DotAutotuneResults results;
+  TF_RETURN_IF_ERROR(tensorflow::ReadTextProto(env, path, &results));
+  for (const DotAutotuneResults::Entry& entry : results.results()) {
+    autotune_cache.emplace(std::make_pair(entry.cpu(), entry.dot()),
+                           TunedDot{entry.config(), entry.run_time_ns()});
+  }
+  VLOG(1) << "Loaded " << results.results_size()
+          << " dot autotuning results from " << path;
+  return Status::OK();
+}
+
+static Status SaveDatabase(const std::string& path)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(autotune_cache_mu) {
+  DotAutotuneResults results;
+  for (const auto& key_and_result : autotune_cache) {
+    DotAutotuneResults::Entry* entry = results.add_results();
+    entry->set_cpu(key_and_result.first.first);
+    entry->set_dot(key_and_result.first.second);
+    *entry->mutable_config() = key_and_result.second.config;
+    entry->set_run_time_ns(key_and_result.second.run_time_ns);
+  }
+  // Write to a temporary file and rename it into place, so that concurrent
+  // readers never observe a partially written database.
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::string tmp_path = absl::StrCat(path, ".tmp.", env->NowMicros());
+  TF_RETURN_IF_ERROR(tensorflow::WriteTextProto(env, tmp_path, results));
+  return env->RenameFile(tmp_path, path);
+}
+
+StatusOr<bool> DotAutotuner::Run(HloModule* module) {
+  XLA_SCOPED_LOGGING_TIMER("DotAutotuner");
+
+  const HloModuleConfig& config = module->config();
+  if (!options::DotAutotuningEnabled(config)) {
+    VLOG(2) << "Dot autotuning disabled, DotAutotuner returning early";
+    return false;
+  }
+  if (config.debug_options().xla_cpu_multi_thread_eigen()) {
+    VLOG(2) << "Dots use multi-threaded Eigen, DotAutotuner returning early";
+    return false;
+  }
+
+  const std::string cpu_name = llvm::sys::getHostCPUName().str();
+  absl::optional<std::string> database =
+      options::DotAutotuneDatabasePath(config);
+
+  // Holding the lock while profiling also keeps concurrent compilations from
+  // skewing each other's measurements.
+  tensorflow::mutex_lock lock(autotune_cache_mu);
+  if (database.has_value()) {
+    TF_RETURN_IF_ERROR(LoadDatabase(*database));
+  }
+
+  bool changed = false;
+  bool tuned_new_dots = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    for (HloInstruction* instr : computation->instructions()) {
+      if (!IsTunableDot(*instr)) {
+        continue;
+      }
+      DotAutotuneCacheKey key = std::make_pair(cpu_name, DotKey(*instr));
+      auto it = autotune_cache.find(key);
+      if (it == autotune_cache.end()) {
+        it = autotune_cache.emplace(key, AutotuneDot(*instr, compile_fn_))
+                 .first;
+        tuned_new_dots = true;
+      }
+      TF_RETURN_IF_ERROR(instr->set_backend_config(it->second.config));
+      changed = true;
+    }
+  }
+
+  if (database.has_value() && tuned_new_dots) {
+    TF_RETURN_IF_ERROR(SaveDatabase(*database));
+  }
+  return changed;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,63 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_DOT_AUTOTUNER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_DOT_AUTOTUNER_H_
+
+#include <functional>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/executable.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// Picks the fastest implementation of every row-major rank-2 GEMM in the
+// module by compiling and timing each candidate on the host: the Eigen and
+// (when enabled) MKL runtime calls, and tiled LLVM IR GEMMs over a set of tile
+// sizes and vector widths.  The winner is recorded in the dot's
+// DotBackendConfig, which DotOpEmitter honors.
+//
+// Results are cached in-process per host CPU model and dot shape, and are
+// persisted across processes when the "xla_cpu_autotune_database" backend
+// option names a file.  The pass only runs when the "xla_cpu_autotune_dots"
+// backend option is set, and only for single-threaded dots: with
+// multi-threaded Eigen the runtime call is always used.
+class DotAutotuner : public HloModulePass {
+ public:
+  // Compiles a module that has already been through the HLO pipeline into an
+  // executable for the host.
+  using CompileFn = std::function<StatusOr<std::unique_ptr<Executable>>(
+      std::unique_ptr<HloModule>)>;
+
+  explicit DotAutotuner(CompileFn compile_fn)
+      : compile_fn_(std::move(compile_fn)) {}
+
+  absl::string_view name() const override { return "dot-autotuner"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  CompileFn compile_fn_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_DOT_AUTOTUNER_H_
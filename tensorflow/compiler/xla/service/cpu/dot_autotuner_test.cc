@@ -0,0 +1,126 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/dot_autotuner.h"
+
+#include "absl/strings/match.h"
+#include "tensorflow/compiler/xla/service/cpu/backend_config.pb.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace {
+
+class DotAutotunerTest : public HloTestBase {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    (*debug_options.mutable_xla_backend_extra_options())
+        ["xla_cpu_autotune_dots"] = "";
+    debug_options.set_xla_cpu_multi_thread_eigen(false);
+    return debug_options;
+  }
+
+  StatusOr<bool> RunDotAutotuner(HloModule* module) {
+    return cpu::DotAutotuner([this](std::unique_ptr<HloModule> module) {
+             return backend().compiler()->RunBackend(
+                 std::move(module), backend().default_stream_executor(),
+                 Compiler::CompileOptions());
+           })
+        .Run(module);
+  }
+};
+
+TEST_F(DotAutotunerTest, PicksImplementationAndPersistsIt) {
+  const string hlo_string = R"(
+    HloModule DotAutotune
+    ENTRY Dot {
+      lhs = f32[64,32]{1,0} parameter(0)
+      rhs = f32[32,48]{1,0} parameter(1)
+      ROOT dot = f32[64,48]{1,0} dot(lhs, rhs),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    }
+  )";
+
+  const string database = tensorflow::io::JoinPath(
+      tensorflow::testing::TmpDir(), "dot_autotune.pbtxt");
+  HloModuleConfig module_config = GetModuleConfigForTest();
+  DebugOptions debug_options = module_config.debug_options();
+  (*debug_options.mutable_xla_backend_extra_options())
+      ["xla_cpu_autotune_database"] = database;
+  module_config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<HloModule> m,
+      ParseAndReturnVerifiedModule(hlo_string, module_config));
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunDotAutotuner(m.get()));
+  EXPECT_TRUE(changed);
+  TF_ASSERT_OK_AND_ASSIGN(
+      cpu::DotBackendConfig config,
+      m->entry_computation()->root_instruction()->backend_config<
+          cpu::DotBackendConfig>());
+  EXPECT_NE(config.strategy(), cpu::DotBackendConfig::DEFAULT);
+
+  cpu::DotAutotuneResults results;
+  TF_ASSERT_OK(tensorflow::ReadTextProto(tensorflow::Env::Default(), database,
+                                         &results));
+  // The database holds everything tuned in this process, so look for ours.
+  const cpu::DotAutotuneResults::Entry* entry = nullptr;
+  for (const cpu::DotAutotuneResults::Entry& result : results.results()) {
+    if (absl::StartsWith(result.dot(), "f32[64,32]{1,0} x f32[32,48]{1,0}")) {
+      entry = &result;
+    }
+  }
+  ASSERT_NE(entry, nullptr);
+  EXPECT_FALSE(entry->cpu().empty());
+  EXPECT_EQ(entry->config().SerializeAsString(), config.SerializeAsString());
+}
+
+TEST_F(DotAutotunerTest, MatrixVectorProductNotTuned) {
+  const string hlo_string = R"(
+    HloModule DotAutotune
+    ENTRY Dot {
+      lhs = f32[64,32]{1,0} parameter(0)
+      rhs = f32[32,1]{1,0} parameter(1)
+      ROOT dot = f32[64,1]{1,0} dot(lhs, rhs),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunDotAutotuner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(DotAutotunerTest, AutotunedDotComputesCorrectResult) {
+  const string hlo_string = R"(
+    HloModule DotAutotune
+    ENTRY Dot {
+      lhs = f32[100,70]{1,0} parameter(0)
+      rhs = f32[70,90]{1,0} parameter(1)
+      ROOT dot = f32[100,90]{1,0} dot(lhs, rhs),
+        lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    }
+  )";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{1e-3, 1e-3}));
+}
+
+}  // namespace
+}  // namespace xla
@@ -33,6 +33,7 @@ limitations under the License.
 #include "mlir/IR/OperationSupport.h"  // from @llvm-project
 #include "mlir/IR/Value.h"  // from @llvm-project
 #include "tensorflow/compiler/xla/primitive_util.h"
+#include "tensorflow/compiler/xla/service/cpu/backend_config.pb.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
@@ -70,6 +71,8 @@ struct DotInfo {
   Shape rhs_shape;
   Shape result_shape;
   DotDimensionNumbers dim_nums;
+  // The implementation picked by the DotAutotuner, if any.
+  DotBackendConfig backend_config;
 
   DotInfo() = default;
 
@@ -79,6 +82,10 @@ struct DotInfo {
     rhs_shape = instr.operand(1)->shape();
     result_shape = instr.shape();
     dim_nums = instr.dot_dimension_numbers();
+    StatusOr<DotBackendConfig> tuned = instr.backend_config<DotBackendConfig>();
+    if (tuned.ok()) {
+      backend_config = tuned.ValueOrDie();
+    }
   }
 };
 
@@ -194,6 +201,15 @@ class DotOpEmitter {
   }
 
   std::tuple<int64, int64, int64> GetGemmTileSize() const {
+    const DotBackendConfig& tuned = dot_info_.backend_config;
+    if (tuned.strategy() == DotBackendConfig::TILED_LLVM_IR_GEMM &&
+        tuned.tile_size_m() > 0 && tuned.tile_size_k() > 0 &&
+        tuned.tile_size_n_in_vector_width() > 0) {
+      return std::tuple<int64, int64, int64>(
+          tuned.tile_size_m(), tuned.tile_size_k(),
+          tuned.tile_size_n_in_vector_width());
+    }
+
     // Tuned for broadwell - Intel(R) Xeon(R) CPU E5-2690 v4 @ 2.60GHz
     //
     // TODO(b/80093688): Tune for other architectures and centralize this
@@ -738,6 +754,16 @@ Status DotOpEmitter::EmitCallToRuntime() {
 
   bool multi_threaded = ShouldUseMultiThreadedEigen(hlo_module_config_);
   bool use_mkl_dnn = hlo_module_config_.debug_options().xla_cpu_use_mkl_dnn();
+  switch (dot_info_.backend_config.strategy()) {
+    case DotBackendConfig::EIGEN:
+      use_mkl_dnn = false;
+      break;
+    case DotBackendConfig::MKL:
+      use_mkl_dnn = true;
+      break;
+    default:
+      break;
+  }
   PrimitiveType type = target_array_.GetShape().element_type();
   llvm::Function* function = b_->GetInsertBlock()->getParent();
   llvm::Module* module = function->getParent();
@@ -983,7 +1009,11 @@ bool CanEmitTiledLlvmIrGemm(
       dot_info.dim_nums.lhs_contracting_dimensions(0));
   int n = dot_info.result_shape.dimensions(1);
 
-  if (!options::ForceEnableExperimentalLlvmIrGemm(config)) {
+  // A tiled GEMM picked by the autotuner has been measured to beat Eigen on
+  // this host, so the size heuristic below does not apply to it.
+  bool autotuned = dot_info.backend_config.strategy() ==
+                   DotBackendConfig::TILED_LLVM_IR_GEMM;
+  if (!options::ForceEnableExperimentalLlvmIrGemm(config) && !autotuned) {
     // TODO(sanjoy):  We should make these numbers micro-arch specific.
     bool small_gemm =
         k <= 128 && ((m <= 32 && n <= 128) || (m <= 128 && n <= 32));
@@ -1027,6 +1057,13 @@ DotImplementationStrategy GetDotImplementationStrategy(
   }
 
   if (IsAlignedGemm(dot_info, target_machine_features)) {
+    switch (dot_info.backend_config.strategy()) {
+      case DotBackendConfig::EIGEN:
+      case DotBackendConfig::MKL:
+        return DotImplementationStrategy::kEigen;
+      default:
+        break;
+    }
     if (CanEmitTiledLlvmIrGemm(config, dot_info, target_machine_features)) {
       return DotImplementationStrategy::kTiledLlvmIrGemm;
     }
@@ -1677,6 +1677,16 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
     return false;
   }
 
+  // In a parallel compute function the outer output dimensions come with
+  // dynamic bounds. The vectorized loop nest below can take those for every
+  // dimension except the innermost one, which it strides by the vector width.
+  const bool emit_parallel_loop = ShouldEmitParallelLoopFor(*reduce);
+  if (emit_parallel_loop &&
+      num_dynamic_loop_bounds_ >= reduce->shape().dimensions_size()) {
+    *failure_reason = "innermost dimension is partitioned for parallel emission";
+    return false;
+  }
+
   CHECK(!reduce->shape().IsTuple());
   TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
 
@@ -1701,15 +1711,27 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   //  }
 
   llvm_ir::ForLoopNest loop_nest(IrName(reduce), &b_);
-  std::vector<llvm::Value*> array_multi_index(
-      reduce->shape().dimensions_size());
+  std::vector<std::pair<llvm::Value*, llvm::Value*>> dynamic_loop_bounds;
+  if (emit_parallel_loop) {
+    dynamic_loop_bounds = compute_function_->GetDynamicLoopBounds();
+  }
+  const int64 num_dims = reduce->shape().dimensions_size();
+  std::vector<llvm::Value*> array_multi_index(num_dims);
   for (int i = LayoutUtil::MinorToMajor(reduce->shape()).size() - 1; i > 0;
        --i) {
     int64 dimension = LayoutUtil::Minor(reduce->shape().layout(), i);
-    int64 start_index = 0;
-    int64 end_index = reduce->shape().dimensions(dimension);
-    std::unique_ptr<llvm_ir::ForLoop> loop = loop_nest.AddLoop(
-        start_index, end_index, absl::StrFormat("dim.%d", dimension));
+    const int bounds_index = num_dims - 1 - i;
+    std::unique_ptr<llvm_ir::ForLoop> loop;
+    if (bounds_index < dynamic_loop_bounds.size()) {
+      loop = loop_nest.AddLoop(absl::StrFormat("dim.%d", dimension),
+                               dynamic_loop_bounds[bounds_index].first,
+                               dynamic_loop_bounds[bounds_index].second);
+    } else {
+      int64 start_index = 0;
+      int64 end_index = reduce->shape().dimensions(dimension);
+      loop = loop_nest.AddLoop(start_index, end_index,
+                               absl::StrFormat("dim.%d", dimension));
+    }
     array_multi_index[dimension] = loop->GetIndVarValue();
   }
 
@@ -2131,9 +2153,13 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
         /*buffer_table_arg=*/GetBufferTableArgument(),
         /*profile_counters_arg=*/GetProfileCountersArgument());
 
+    // Multi-output roots are partitioned over their (common) output shape.
     HloInstruction* root = computation->root_instruction();
+    const Shape& partition_shape = root->shape().IsTuple()
+                                       ? root->shape().tuple_shapes(0)
+                                       : root->shape();
     TF_RETURN_IF_ERROR(EmitCallToParallelForkJoin(
-        call_args, root->shape(), root->outer_dimension_partitions(), &b_,
+        call_args, partition_shape, root->outer_dimension_partitions(), &b_,
         call_ir_function, computation->name()));
   } else {
     EmitGlobalCall(*computation, computation->name());
@@ -3155,7 +3181,6 @@ Status IrEmitter::EmitTargetElementLoop(
        target_op->opcode() == HloOpcode::kReduce ||
        target_op->opcode() == HloOpcode::kReduceWindow)) {
     // For multiple outputs fusion, we need to emit each operand and the root.
-    TF_RET_CHECK(num_dynamic_loop_bounds_ == 0);
     std::vector<llvm_ir::IrArray> output_arrays;
     for (int64 i = 0; i < ShapeUtil::TupleElementCount(target_shape); ++i) {
       TF_ASSIGN_OR_RETURN(BufferAllocation::Slice slice,
@@ -3165,15 +3190,36 @@ Status IrEmitter::EmitTargetElementLoop(
       output_arrays.push_back(
           llvm_ir::IrArray(op_target_address, element_shape));
     }
-    TF_RETURN_IF_ERROR(
-        llvm_ir::LoopEmitter(element_generator, output_arrays, &b_)
-            .EmitLoop(IrName(target_op)));
-
     std::vector<llvm::Value*> tuple_operand_ptrs;
     for (int64 i = 0; i < output_arrays.size(); ++i) {
       tuple_operand_ptrs.push_back(output_arrays[i].GetBasePointer());
     }
-    llvm_ir::EmitTuple(target_array, tuple_operand_ptrs, &b_);
+
+    if (ShouldEmitParallelLoopFor(*target_op)) {
+      std::vector<std::pair<llvm::Value*, llvm::Value*>> dynamic_loop_bounds =
+          compute_function_->GetDynamicLoopBounds();
+      TF_RETURN_IF_ERROR(ParallelLoopEmitter(element_generator, output_arrays,
+                                             &dynamic_loop_bounds, &b_)
+                             .EmitLoop(IrName(target_op)));
+
+      // Every partition would write the same tuple, so only the partition
+      // that starts at the origin does it.
+      llvm::Value* is_first_partition = b_.getTrue();
+      for (const auto& bounds : dynamic_loop_bounds) {
+        is_first_partition = And(is_first_partition,
+                                 ICmpEQ(bounds.first, b_.getInt64(0)));
+      }
+      llvm_ir::LlvmIfData if_first_partition = llvm_ir::EmitIfThenElse(
+          is_first_partition, "first_partition", &b_, /*emit_else=*/false);
+      SetToFirstInsertPoint(if_first_partition.true_block, &b_);
+      llvm_ir::EmitTuple(target_array, tuple_operand_ptrs, &b_);
+      SetToFirstInsertPoint(if_first_partition.after_block, &b_);
+    } else {
+      TF_RETURN_IF_ERROR(
+          llvm_ir::LoopEmitter(element_generator, output_arrays, &b_)
+              .EmitLoop(IrName(target_op)));
+      llvm_ir::EmitTuple(target_array, tuple_operand_ptrs, &b_);
+    }
 
   } else {
     if (ShouldEmitParallelLoopFor(*target_op)) {
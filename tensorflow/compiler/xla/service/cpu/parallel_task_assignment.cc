@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 
+#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
@@ -24,10 +25,58 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 
 namespace xla {
 namespace cpu {
 
+namespace {
+
+// Returns the array shape that a parallel loop for 'instruction' iterates
+// over, or nullptr if 'instruction' cannot be emitted as a single loop nest.
+// Multi-output loop fusions and variadic reduces emit all of their outputs
+// from one loop nest, so they qualify when every output has the same
+// dimensions and layout.
+const Shape* GetParallelLoopShape(const HloInstruction& instruction) {
+  const Shape& shape = instruction.shape();
+  if (!shape.IsTuple()) {
+    return &shape;
+  }
+  if (instruction.opcode() != HloOpcode::kReduce &&
+      !instruction.IsLoopFusion()) {
+    return nullptr;
+  }
+  if (shape.tuple_shapes_size() == 0) {
+    return nullptr;
+  }
+  const Shape& first = shape.tuple_shapes(0);
+  for (const Shape& element_shape : shape.tuple_shapes()) {
+    if (!element_shape.IsArray() ||
+        !ShapeUtil::EqualIgnoringElementType(first, element_shape)) {
+      return nullptr;
+    }
+  }
+  return &first;
+}
+
+// Returns true if 'instruction' is a reduction or a fusion producing one.
+// These read much more than they write, so their output size understates the
+// work to be split.
+bool IsReduction(const HloInstruction& instruction) {
+  const HloInstruction* root = instruction.opcode() == HloOpcode::kFusion
+                                   ? instruction.fused_expression_root()
+                                   : &instruction;
+  if (root->opcode() == HloOpcode::kTuple) {
+    return absl::c_any_of(root->operands(), [](const HloInstruction* operand) {
+      return operand->opcode() == HloOpcode::kReduce;
+    });
+  }
+  return root->opcode() == HloOpcode::kReduce ||
+         root->opcode() == HloOpcode::kReduceWindow;
+}
+
+}  // namespace
+
 class SimpleCostModel : public ParallelCostModel {
  public:
   SimpleCostModel(const int64 max_parallelism,
@@ -37,7 +86,8 @@ class SimpleCostModel : public ParallelCostModel {
 
   int64 GetParallelTaskCount(HloInstruction* instruction) override {
     // Simple cost model based on hlo size and typical L2 cache size.
-    const int64 instruction_cost = shape_size_(instruction->shape());
+    const int64 instruction_cost =
+        shape_size_(*GetParallelLoopShape(*instruction));
     const int64 min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
     // Return target parallel task count in [1, max_parallelism_].
     return std::min(max_parallelism_,
@@ -79,7 +129,10 @@ class DefaultCostModel : public ParallelCostModel {
           max_parallelism_,
           std::ceil(std::sqrt(tensorflow::port::MaxParallelism())));
       // Use shape size instruction cost and L2 cache size min per-thread cost.
-      instruction_cost = shape_size_(instruction->shape());
+      // Reductions are sized by the bytes they read instead.
+      instruction_cost = IsReduction(*instruction)
+                             ? bytes_accessed
+                             : shape_size_(*GetParallelLoopShape(*instruction));
       min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
     } else {
       // Use max parallelism for compute bound instructions.
@@ -135,16 +188,18 @@ int64 ParallelTaskAssignment::GetTargetParallelTaskCount(
   // *) Internal threading (library calls to kConv, kDot, kFft, kCustomCall).
   // *) Emit custom loops (kSelectAndScatter).
   // *) Operations that are not thread safe (like infeed and rng).
-  // *) Tuple-shaped.
+  // *) Tuple-shaped, unless all outputs come from a single loop nest.
+  // *) Scalar-shaped (nothing to partition).
   // *) Operations that might be implemented as an in-place
   //    dynamic-update-slice, because we can't know how many output elements
   //    they will write (out-of-place will touch the whole output buffer, while
   //    in-place will only touch the updated elements).
   // TODO(b/27458679) Parallelize instructions which are skipped here.
   auto opcode = instruction->opcode();
+  const Shape* loop_shape = GetParallelLoopShape(*instruction);
   if (llvm_ir::MayBeImplementedAsInPlaceDynamicUpdateSlice(instruction) ||
-      instruction->shape().IsTuple() || opcode == HloOpcode::kRng ||
-      opcode == HloOpcode::kConstant) {
+      loop_shape == nullptr || ShapeUtil::IsScalar(*loop_shape) ||
+      opcode == HloOpcode::kRng || opcode == HloOpcode::kConstant) {
     return 1;
   }
 
@@ -218,8 +273,9 @@ bool ParallelTaskAssigner::AssignParallelTasksHelper(
     // Get target parallel task count computed for 'instruction'.
     const int64 target_parallel_task_count = (*it).second;
     // Assign feasible dimension partitions (based on actual dimension sizes).
-    auto dim_partition_counts = ShapePartitionAssigner(instruction->shape())
-                                    .Run(target_parallel_task_count);
+    auto dim_partition_counts =
+        ShapePartitionAssigner(*GetParallelLoopShape(*instruction))
+            .Run(target_parallel_task_count);
     const int64 total_partition_count =
         ShapePartitionAssigner::GetTotalPartitionCount(dim_partition_counts);
     if (total_partition_count <= 1) {
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace xla {
 namespace {
@@ -205,5 +206,85 @@ TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, ReduceToScalarNotParallelized) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_reduce_to_scalar
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY ReduceToScalar {
+      input = f32[4096,4096] parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[] reduce(input, zero), dimensions={0,1}, to_apply=add
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(ParallelTaskAssignmentTest, RowReductionParallelized) {
+  // Reductions are I/O bound, so their parallelism is capped by the square
+  // root of the host parallelism.
+  if (tensorflow::port::MaxParallelism() < 4) {
+    GTEST_SKIP() << "Not enough host parallelism";
+  }
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_row_reduction
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY RowReduction {
+      input = f32[4096,4096] parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[4096] reduce(input, zero), dimensions={1}, to_apply=add
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+}
+
+TEST_F(ParallelTaskAssignmentTest,
+       VariadicReduceWithMismatchedLayoutsNotParallelized) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_variadic_reduce
+    max_argmax {
+      lhs_value = f32[] parameter(0)
+      lhs_index = s32[] parameter(1)
+      rhs_value = f32[] parameter(2)
+      rhs_index = s32[] parameter(3)
+      cmp = pred[] compare(lhs_value, rhs_value), direction=GE
+      value = f32[] select(cmp, lhs_value, rhs_value)
+      index = s32[] select(cmp, lhs_index, rhs_index)
+      ROOT result = (f32[], s32[]) tuple(value, index)
+    }
+
+    ENTRY VariadicReduce {
+      values = f32[4096,4096,2]{2,1,0} parameter(0)
+      indices = s32[4096,4096,2]{2,1,0} parameter(1)
+      init_value = f32[] constant(-inf)
+      init_index = s32[] constant(0)
+      ROOT reduce = (f32[4096,2]{1,0}, s32[4096,2]{0,1}) reduce(values, indices,
+        init_value, init_index), dimensions={1}, to_apply=max_argmax
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
 }  // namespace
 }  // namespace xla
@@ -17,6 +17,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/blocking_counter.h"
@@ -31,8 +34,12 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
+// Calls 'function_ptr' once for each of 'num_partitions' partitions.
+// At most one worker per intra-op thread is enqueued (never more than
+// 'num_partitions - 1'), and the calling thread acts as one more worker.
+// Workers claim partitions from a shared atomic counter until all partitions
+// are taken, so uneven partitions balance themselves and the number of
+// closures handed to the thread pool does not grow with the partition count.
 // Uses blocking counter to synchronize threads after parallel calls complete.
 //
 // The 'partitions' array has a total number of elements equal to
@@ -74,31 +81,42 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   const xla::ExecutableRunOptions* run_options =
       static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
   CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
 
   ComputeFunctionType function =
       reinterpret_cast<ComputeFunctionType>(function_ptr);
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+  std::atomic<int32> next_partition(0);
+  auto run_partitions = [&](int32 worker) {
+    for (int32 i = next_partition.fetch_add(1, std::memory_order_relaxed);
+         i < num_partitions;
+         i = next_partition.fetch_add(1, std::memory_order_relaxed)) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done on worker "
+              << worker << ".";
+    }
+  };
+
+  // Dispatch up to 'num_partitions - 1' workers to run in parallel.  AOT
+  // callers may not supply a thread pool, in which case every partition runs
+  // on the calling thread.
+  const Eigen::ThreadPoolDevice* pool = run_options->intra_op_thread_pool();
+  const int32 num_workers =
+      pool == nullptr
+          ? 0
+          : std::min<int32>(num_partitions - 1, pool->numThreads());
+  tensorflow::BlockingCounter bc(num_workers);
+  for (int32 w = 1; w <= num_workers; ++w) {
+    pool->enqueueNoNotification([w, &run_partitions, &bc]() {
+      run_partitions(w);
+      bc.DecrementCount();
+    });
   }
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  // Run partitions on the calling thread as well.
+  run_partitions(0);
   bc.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
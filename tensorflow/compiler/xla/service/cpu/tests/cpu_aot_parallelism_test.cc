@@ -0,0 +1,69 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/cpu/cpu_compiler.h"
+#include "tensorflow/compiler/xla/service/cpu/test_target_triple_helper.h"
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using CpuAotParallelismTest = CpuCodegenTest;
+
+const char* const kHloText = R"(
+HloModule ParallelAdd
+
+ENTRY main {
+  lhs = f32[1024,1024] parameter(0)
+  rhs = f32[1024,1024] parameter(1)
+  ROOT add = f32[1024,1024] add(lhs, rhs)
+}
+)";
+
+CpuAotCompilationOptions AotOptions() {
+  return CpuAotCompilationOptions{
+      /*triple=*/kTargetTripleForHost, /*cpu_name=*/kTargetCpuForHost,
+      /*features=*/"",
+      /*entry_point_name=*/"entry",
+      /*relocation_model=*/CpuAotCompilationOptions::RelocationModel::Static};
+}
+
+TEST_F(CpuAotParallelismTest, SingleThreadedByDefault) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  CpuAotCompilationOptions options = AotOptions();
+  EXPECT_EQ(options.max_parallelism(), 1);
+
+  CompileAheadOfTimeAndVerifyIr(std::move(module), options,
+                                R"(CHECK-NOT: ParallelForkJoin)",
+                                /*match_optimized_ir=*/false);
+}
+
+TEST_F(CpuAotParallelismTest, EmitsForkJoinWhenEnabled) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  CpuAotCompilationOptions options = AotOptions();
+  options.set_max_parallelism(4);
+
+  CompileAheadOfTimeAndVerifyIr(
+      std::move(module), options,
+      R"(CHECK: call void @__xla_cpu_runtime_ParallelForkJoin)",
+      /*match_optimized_ir=*/false);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -69,6 +69,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_layout_assignment.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_rematerialization.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_sanitize_constant_names.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_scatter_expander.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_spmd_partitioner.h"
@@ -390,6 +391,22 @@ Status GpuCompiler::OptimizeHloModule(
     pipeline.AddPass<AlgebraicSimplifier>(options);
     TF_RETURN_IF_ERROR(pipeline.Run(hlo_module).status());
   }
+
+  if (stream_exec != nullptr &&
+      hlo_module->config().debug_options().xla_gpu_enable_rematerialization()) {
+    absl::optional<int64> memory_budget =
+        GetDeviceMemoryBudget(stream_exec, device_allocator);
+    if (memory_budget) {
+      HloPassPipeline pipeline("rematerialization");
+      pipeline.AddPass<GpuRematerialization>(*memory_budget,
+                                             GetFlopsPerByte(stream_exec),
+                                             ShapeSizeBytesFunction());
+      TF_RETURN_IF_ERROR(pipeline.Run(hlo_module).status());
+    } else {
+      VLOG(1) << "Skipping rematerialization, the free device memory of "
+              << hlo_module->name() << " is unknown.";
+    }
+  }
   return Status::OK();
 }
 
@@ -975,6 +992,8 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
         profile_index_map->GetProfileIndexFor(*module->entry_computation());
   }
 
+  const bool enable_cuda_graphs =
+      module->config().debug_options().xla_gpu_enable_cuda_graphs();
   GpuVersion gpu_version = GetGpuVersion(stream_exec);
   auto* gpu_executable = new GpuExecutable(
       {std::move(backend_result.first), std::move(backend_result.second),
@@ -984,7 +1003,8 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::RunBackend(
        compile_module_results.module_name, compile_module_results.output_shape,
        std::move(compile_module_results.allocations),
        std::move(buffer_assignment_proto), std::move(module), profile_index,
-       std::move(profile_printer), std::move(profile_index_map)});
+       std::move(profile_printer), std::move(profile_index_map),
+       enable_cuda_graphs});
   if (embed_ir_in_executable) {
     DCHECK_NE("", ir_module_string_before_opt);
     gpu_executable->set_ir_module_string(ir_module_string_before_opt);
@@ -50,6 +50,27 @@ namespace {
 
 using ::tensorflow::profiler::ScopedAnnotation;
 
+// Shorter runs of capturable thunks aren't worth a separate graph launch.
+constexpr int64 kMinThunksPerGraph = 2;
+
+// Maximum number of buffer address sets to keep captured graphs for.
+constexpr int64 kMaxCachedGraphSets = 16;
+
+// Returns true if `thunk` only enqueues device work that CUDA stream capture
+// supports.  Copy thunks are left out because host-to-device copies read
+// pageable host memory, and library calls (cuBLAS, cuDNN, cuFFT) may allocate
+// scratch memory that doesn't outlive the run.
+bool IsCapturableThunk(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kKernel:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+      return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 // Implementation note: HLO profiling is always enabled for GPU executables,
@@ -71,6 +92,9 @@ GpuExecutable::GpuExecutable(GpuExecutable::Params params)
       output_info_(std::move(params.output_info)) {
   XlaDebugInfoManager::Get()->RegisterModule(module_name_, shared_module(),
                                              debug_buffer_assignment_);
+  if (params.enable_cuda_graphs) {
+    BuildThunkSegments();
+  }
 }
 
 GpuExecutable::~GpuExecutable() {
@@ -91,6 +115,117 @@ GpuExecutable::~GpuExecutable() {
   }
 }
 
+void GpuExecutable::BuildThunkSegments() {
+  if (!GpuGraphExec::IsSupported()) {
+    VLOG(1) << "CUDA graphs are not supported in this build";
+    return;
+  }
+  // Graphs are captured from a single stream.  Schedules that use several
+  // streams synchronize them with events, which we don't capture.
+  if (thunk_schedule_->StreamCount() != 1) {
+    VLOG(1) << "Not using CUDA graphs for " << module_name_ << ": it runs on "
+            << thunk_schedule_->StreamCount() << " streams";
+    return;
+  }
+
+  const ThunkSequence& thunks = thunk_schedule_->TotalOrder();
+  bool any_capturable = false;
+  for (int64 begin = 0; begin < thunks.size();) {
+    bool capturable = IsCapturableThunk(*thunks[begin]);
+    int64 end = begin + 1;
+    while (end < thunks.size() &&
+           IsCapturableThunk(*thunks[end]) == capturable) {
+      ++end;
+    }
+    if (capturable && end - begin < kMinThunksPerGraph) {
+      capturable = false;
+    }
+    if (!capturable && !thunk_segments_.empty() &&
+        !thunk_segments_.back().capturable) {
+      thunk_segments_.back().end = end;
+    } else {
+      thunk_segments_.push_back({begin, end, capturable});
+    }
+    any_capturable |= capturable;
+    begin = end;
+  }
+  if (!any_capturable) {
+    thunk_segments_.clear();
+  }
+  VLOG(1) << module_name_ << ": " << thunk_segments_.size()
+          << " thunk segments for CUDA graphs";
+}
+
+Status GpuExecutable::ExecuteThunksWithGraphs(
+    se::Stream* stream, const BufferAllocations& buffer_allocations,
+    const std::function<Status(Thunk*)>& execute_thunk) {
+  const ThunkSequence& thunks = thunk_schedule_->TotalOrder();
+  auto execute_segment = [&](const ThunkSegment& segment) -> Status {
+    for (int64 i = segment.begin; i < segment.end; ++i) {
+      TF_RETURN_IF_ERROR(execute_thunk(thunks[i].get()));
+    }
+    return Status::OK();
+  };
+
+  // Captured graphs bake in device addresses, so they can only be replayed
+  // when every allocation lives where it did during capture.
+  GraphCacheKey key;
+  key.first = stream->parent();
+  key.second.reserve(allocations_.size());
+  for (BufferAllocation::Index i = 0; i < allocations_.size(); ++i) {
+    key.second.push_back(buffer_allocations.GetDeviceAddress(i).opaque());
+  }
+
+  std::shared_ptr<CapturedGraphs> captured_graphs;
+  {
+    tensorflow::mutex_lock lock(graph_cache_mutex_);
+    auto it = graph_cache_.find(key);
+    if (it == graph_cache_.end()) {
+      if (graph_cache_.size() >= kMaxCachedGraphSets) {
+        // Buffer addresses keep changing from run to run; start over rather
+        // than track which sets are still in use.
+        graph_cache_.clear();
+      }
+      it = graph_cache_
+               .emplace(std::move(key), std::make_shared<CapturedGraphs>())
+               .first;
+    }
+    captured_graphs = it->second;
+  }
+
+  tensorflow::mutex_lock lock(captured_graphs->mu);
+  if (!captured_graphs->captured) {
+    captured_graphs->graphs.resize(thunk_segments_.size());
+    for (int64 i = 0; i < thunk_segments_.size(); ++i) {
+      const ThunkSegment& segment = thunk_segments_[i];
+      if (!segment.capturable) {
+        continue;
+      }
+      StatusOr<std::unique_ptr<GpuGraphExec>> graph = GpuGraphExec::Capture(
+          stream, [&] { return execute_segment(segment); });
+      if (!graph.ok()) {
+        VLOG(1) << "Executing thunks [" << segment.begin << ", " << segment.end
+                << ") of " << module_name_
+                << " without a CUDA graph: " << graph.status();
+        continue;
+      }
+      captured_graphs->graphs[i] = std::move(graph).ValueOrDie();
+    }
+    captured_graphs->captured = true;
+  }
+
+  for (int64 i = 0; i < thunk_segments_.size(); ++i) {
+    if (GpuGraphExec* graph = captured_graphs->graphs[i].get()) {
+      VLOG(2) << "Launching CUDA graph for thunks [" << thunk_segments_[i].begin
+              << ", " << thunk_segments_[i].end << ")";
+      TF_RETURN_IF_ERROR(graph->Launch(stream));
+    } else {
+      TF_RETURN_IF_ERROR(execute_segment(thunk_segments_[i]));
+    }
+  }
+  return Status::OK();
+}
+
 Status GpuExecutable::CheckCompatibilityWithServiceExecutableRunOptions(
     const ServiceExecutableRunOptions* run_options) {
   se::Stream* main_stream = run_options->stream();
@@ -166,17 +301,17 @@ Status GpuExecutable::ExecuteThunks(
   absl::flat_hash_map<const Thunk*, std::unique_ptr<se::Event>>
       thunk_to_finish_event;
   std::vector<std::function<void()>> deferred_host_callbacks;
-  for (const std::unique_ptr<Thunk>& thunk : thunk_schedule_->TotalOrder()) {
+  auto execute_thunk = [&](Thunk* thunk) -> Status {
     // Annotate execution of this op if tracing was enabled when we started
     // running this module.  If tracing is enabled *while* we're running the
     // module, we won't get any data, but that's probably an OK trade-off.
     ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
 
-    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk.get());
+    int32 stream_no = thunk_schedule_->StreamNumberForThunk(thunk);
     se::Stream* stream =
         (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
 
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk.get())) {
+    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
       stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
     }
 
@@ -198,11 +333,22 @@ Status GpuExecutable::ExecuteThunks(
             ? &gpu_options->nccl_unique_id_callback()
             : nullptr};
     TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
-    if (thunk_schedule_->Depended(thunk.get())) {
+    if (thunk_schedule_->Depended(thunk)) {
       auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
       finish_event->Init();
       stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk.get()] = std::move(finish_event);
+      thunk_to_finish_event[thunk] = std::move(finish_event);
+    }
+    return Status::OK();
+  };
+
+  // Per-thunk timers can't be captured, so profiled runs never use graphs.
+  if (!thunk_segments_.empty() && !do_profile) {
+    TF_RETURN_IF_ERROR(ExecuteThunksWithGraphs(main_stream, buffer_allocations,
+                                               execute_thunk));
+  } else {
+    for (const std::unique_ptr<Thunk>& thunk : thunk_schedule_->TotalOrder()) {
+      TF_RETURN_IF_ERROR(execute_thunk(thunk.get()));
     }
   }
 
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/executable.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk.h"
@@ -82,6 +86,7 @@ class GpuExecutable : public Executable {
     size_t entry_computation_profile_index = 0;
     std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data = nullptr;
     std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map = nullptr;
+    bool enable_cuda_graphs = false;
   };
 
   // We need to share ownership of hlo_module and assignment with profiler to
@@ -142,6 +147,37 @@ class GpuExecutable : public Executable {
                        bool block_host_until_done,
                        HloExecutionProfile* hlo_execution_profile);
 
+  // A run of consecutive thunks in the schedule's total order, [begin, end).
+  // Capturable segments are recorded into a CUDA graph and replayed; the
+  // others are executed thunk by thunk.
+  struct ThunkSegment {
+    int64 begin;
+    int64 end;
+    bool capturable;
+  };
+
+  // The graphs captured for one StreamExecutor and one set of buffer
+  // addresses, indexed like `thunk_segments_`.  Entries for segments that are
+  // not capturable, or whose capture failed, stay null.
+  struct CapturedGraphs {
+    tensorflow::mutex mu;
+    bool captured TF_GUARDED_BY(mu) = false;
+    std::vector<std::unique_ptr<GpuGraphExec>> graphs TF_GUARDED_BY(mu);
+  };
+  using GraphCacheKey =
+      std::pair<se::StreamExecutor*, std::vector<const void*>>;
+
+  // Splits the thunk schedule into `thunk_segments_`.  Leaves it empty if
+  // graphs can't be used for this executable.
+  void BuildThunkSegments();
+
+  // Executes all thunks on `stream`, replaying the CUDA graphs captured for
+  // the current buffer addresses and capturing them on the first run.
+  // `execute_thunk` enqueues a single thunk.
+  Status ExecuteThunksWithGraphs(
+      se::Stream* stream, const BufferAllocations& buffer_allocations,
+      const std::function<Status(Thunk*)>& execute_thunk);
+
   using BufferAllocToDeviceMemoryMap =
       absl::flat_hash_map<BufferAllocation::Index, se::DeviceMemoryBase>;
 
@@ -216,6 +252,13 @@ class GpuExecutable : public Executable {
   std::vector<ConstantInfo> constants_;
   const absl::flat_hash_map<ShapeIndex, OutputInfo> output_info_;
 
+  // CUDA graph state; see ExecuteThunksWithGraphs.  `thunk_segments_` is empty
+  // when graphs are disabled.
+  std::vector<ThunkSegment> thunk_segments_;
+  tensorflow::mutex graph_cache_mutex_;
+  absl::flat_hash_map<GraphCacheKey, std::shared_ptr<CapturedGraphs>>
+      graph_cache_ TF_GUARDED_BY(graph_cache_mutex_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
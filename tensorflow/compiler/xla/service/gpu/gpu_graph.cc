@@ -0,0 +1,117 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_graph.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/logging.h"
+
+#if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/stream_executor/gpu/gpu_activation.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif
+
+namespace xla {
+namespace gpu {
+
+// Stream capture modes, which let unrelated threads keep using the CUDA API
+// while a capture is in progress, appeared in CUDA 10.1.
+#if GOOGLE_CUDA && CUDA_VERSION >= 10010
+#define XLA_GPU_GRAPHS_SUPPORTED 1
+#endif
+
+#if XLA_GPU_GRAPHS_SUPPORTED
+static Status CuResultToStatus(CUresult result, const char* operation) {
+  if (result == CUDA_SUCCESS) {
+    return Status::OK();
+  }
+  const char* error_name = nullptr;
+  if (cuGetErrorName(result, &error_name) != CUDA_SUCCESS) {
+    error_name = "unknown error";
+  }
+  return InternalError("%s failed: %s", operation, error_name);
+}
+#endif
+
+bool GpuGraphExec::IsSupported() {
+#if XLA_GPU_GRAPHS_SUPPORTED
+  return true;
+#else
+  return false;
+#endif
+}
+
+StatusOr<std::unique_ptr<GpuGraphExec>> GpuGraphExec::Capture(
+    se::Stream* stream, const std::function<Status()>& record) {
+#if XLA_GPU_GRAPHS_SUPPORTED
+  se::gpu::ScopedActivateExecutorContext activation(stream->parent());
+  CUstream cu_stream = se::gpu::AsGpuStreamValue(stream);
+  TF_RETURN_IF_ERROR(CuResultToStatus(
+      cuStreamBeginCapture(cu_stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+      "cuStreamBeginCapture"));
+  Status record_status = record();
+  // Always end the capture, even if recording failed, so that the stream
+  // leaves capture mode.
+  CUgraph graph = nullptr;
+  Status end_status = CuResultToStatus(cuStreamEndCapture(cu_stream, &graph),
+                                       "cuStreamEndCapture");
+  auto destroy_graph = MakeCleanup([graph] {
+    if (graph != nullptr) {
+      cuGraphDestroy(graph);
+    }
+  });
+  TF_RETURN_IF_ERROR(record_status);
+  TF_RETURN_IF_ERROR(end_status);
+  if (!stream->ok()) {
+    return InternalError("Stream entered an error state during graph capture");
+  }
+
+  CUgraphExec exec = nullptr;
+  TF_RETURN_IF_ERROR(CuResultToStatus(
+      cuGraphInstantiate(&exec, graph, /*phErrorNode=*/nullptr,
+                         /*logBuffer=*/nullptr, /*bufferSize=*/0),
+      "cuGraphInstantiate"));
+  return absl::WrapUnique(new GpuGraphExec(stream->parent(), exec));
+#else
+  return Unimplemented("GPU graphs are not supported in this build");
+#endif
+}
+
+GpuGraphExec::~GpuGraphExec() {
+#if XLA_GPU_GRAPHS_SUPPORTED
+  se::gpu::ScopedActivateExecutorContext activation(executor_);
+  // An in-flight graph is released once it completes.
+  CUresult result = cuGraphExecDestroy(exec_);
+  if (result != CUDA_SUCCESS) {
+    LOG(ERROR) << CuResultToStatus(result, "cuGraphExecDestroy");
+  }
+#endif
+}
+
+Status GpuGraphExec::Launch(se::Stream* stream) {
+#if XLA_GPU_GRAPHS_SUPPORTED
+  CHECK_EQ(stream->parent(), executor_);
+  se::gpu::ScopedActivateExecutorContext activation(executor_);
+  return CuResultToStatus(
+      cuGraphLaunch(exec_, se::gpu::AsGpuStreamValue(stream)), "cuGraphLaunch");
+#else
+  return Unimplemented("GPU graphs are not supported in this build");
+#endif
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,71 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_H_
+
+#include <functional>
+#include <memory>
+
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+
+// Opaque handle of an instantiated CUDA graph (CUgraphExec).
+struct CUgraphExec_st;
+
+namespace xla {
+namespace gpu {
+
+// An executable CUDA graph, recorded by capturing the work enqueued on a
+// stream.
+//
+// The graph bakes in the kernels, launch dimensions and device addresses that
+// were used while recording, so it may only be replayed when all of those are
+// unchanged.
+class GpuGraphExec {
+ public:
+  // Returns true if this build can capture and launch GPU graphs.
+  static bool IsSupported();
+
+  // Puts `stream` into capture mode, runs `record` to enqueue work on it, and
+  // instantiates the captured work as a graph.  None of the work is executed.
+  // Fails if `record` fails or enqueues an operation that can't be captured;
+  // `stream` is usable again afterwards either way.
+  static StatusOr<std::unique_ptr<GpuGraphExec>> Capture(
+      se::Stream* stream, const std::function<Status()>& record);
+
+  ~GpuGraphExec();
+
+  // Enqueues one execution of the graph on `stream`, which must belong to the
+  // same StreamExecutor the graph was captured on.
+  Status Launch(se::Stream* stream);
+
+ private:
+  GpuGraphExec(se::StreamExecutor* executor, CUgraphExec_st* exec)
+      : executor_(executor), exec_(exec) {}
+
+  se::StreamExecutor* executor_;
+  CUgraphExec_st* exec_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuGraphExec);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_GRAPH_H_
@@ -13,17 +13,26 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <deque>
+#include <limits>
 #include <memory>
+#include <queue>
 #include <unordered_map>
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/heap_simulator.h"
+#include "tensorflow/compiler/xla/service/hlo_alias_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_reachability.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -184,6 +193,255 @@ void BFSLaunchOrder(const HloComputation* computation,
   }
 }
 
+// Rough device characteristics used by the latency-hiding scheduler to
+// estimate instruction run times. Only their ratios matter for the schedule.
+constexpr double kFlopsPerSecond = 1.0e13;
+constexpr double kMemoryBytesPerSecond = 9.0e11;
+constexpr double kInterconnectBytesPerSecond = 2.5e10;
+constexpr double kKernelLaunchSeconds = 5.0e-6;
+constexpr double kCollectiveLatencySeconds = 1.0e-5;
+
+// The latency-hiding schedule is used only if its peak memory, as computed by
+// the heap simulator, exceeds that of the memory-minimizing schedule by at
+// most this factor.
+constexpr double kMaxPeakMemoryIncrease = 1.1;
+
+bool IsCollective(const HloInstruction& hlo) {
+  switch (hlo.opcode()) {
+    case HloOpcode::kAllGather:
+    case HloOpcode::kAllReduce:
+    case HloOpcode::kAllToAll:
+    case HloOpcode::kCollectivePermute:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Estimates how long an instruction takes. Collectives are costed by the bytes
+// they move over the interconnect, everything else by a roofline over the
+// flops and bytes reported by HloCostAnalysis.
+class LatencyEstimator {
+ public:
+  explicit LatencyEstimator(const HloCostAnalysis* cost_analysis)
+      : cost_analysis_(cost_analysis) {}
+
+  double Estimate(const HloInstruction& hlo) const {
+    switch (hlo.opcode()) {
+      case HloOpcode::kBitcast:
+      case HloOpcode::kConstant:
+      case HloOpcode::kGetTupleElement:
+      case HloOpcode::kParameter:
+      case HloOpcode::kTuple:
+        return 0.0;
+      default:
+        break;
+    }
+    if (IsCollective(hlo)) {
+      int64 bytes = 0;
+      ShapeUtil::ForEachSubshape(
+          hlo.shape(), [&](const Shape& subshape, const ShapeIndex&) {
+            if (subshape.IsArray()) {
+              bytes += ShapeUtil::ByteSizeOf(subshape);
+            }
+          });
+      // A ring all-reduce sends and receives every byte about twice.
+      const double transferred_bytes =
+          hlo.opcode() == HloOpcode::kAllReduce ? 2.0 * bytes : bytes;
+      return kCollectiveLatencySeconds +
+             transferred_bytes / kInterconnectBytesPerSecond;
+    }
+    return kKernelLaunchSeconds +
+           std::max(cost_analysis_->flop_count(hlo) / kFlopsPerSecond,
+                    cost_analysis_->bytes_accessed(hlo) /
+                        kMemoryBytesPerSecond);
+  }
+
+ private:
+  const HloCostAnalysis* cost_analysis_;
+};
+
+// Computes a launch order for 'computation' that hides collective latency.
+//
+// Collectives are modelled as a start, issued when the collective is
+// scheduled, and a done, LatencyEstimator::Estimate seconds later; their users
+// only become available after the done. Other instructions run back to back on
+// the compute stream. Among the available instructions the list scheduler
+// picks, in order of preference:
+//   1. collectives, so they start as soon as their operands are scheduled;
+//   2. instructions that let a collective start soonest;
+//   3. instructions on the longest estimated path to the end.
+// Independent compute thereby fills the time between a collective's start and
+// done. The scheduler only stalls (picks an instruction that is not available
+// yet) when nothing else is left.
+std::vector<HloInstruction*> LatencyHidingLaunchOrder(
+    const HloComputation* computation, const LatencyEstimator& estimator) {
+  const std::vector<HloInstruction*> post_order =
+      computation->MakeInstructionPostOrder();
+  absl::flat_hash_map<const HloInstruction*, int64> position;
+  for (int64 i = 0; i < post_order.size(); ++i) {
+    position[post_order[i]] = i;
+  }
+
+  auto successors = [](const HloInstruction* hlo) {
+    std::vector<HloInstruction*> result(hlo->users().begin(),
+                                        hlo->users().end());
+    result.insert(result.end(), hlo->control_successors().begin(),
+                  hlo->control_successors().end());
+    return result;
+  };
+
+  // Longest estimated time from the start of each instruction to the end of
+  // the computation.
+  absl::flat_hash_map<const HloInstruction*, double> path_to_end;
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    double longest = 0.0;
+    for (const HloInstruction* successor : successors(*it)) {
+      longest = std::max(longest, path_to_end[successor]);
+    }
+    path_to_end[*it] = longest + estimator.Estimate(**it);
+  }
+
+  // Estimated compute time from the start of each instruction until one of
+  // the collectives depending on it can start, or infinity if there is none.
+  absl::flat_hash_map<const HloInstruction*, double> time_to_collective;
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    double shortest = std::numeric_limits<double>::infinity();
+    for (const HloInstruction* successor : successors(*it)) {
+      shortest = std::min(shortest, IsCollective(*successor)
+                                        ? 0.0
+                                        : time_to_collective[successor]);
+    }
+    time_to_collective[*it] = shortest + estimator.Estimate(**it);
+  }
+
+  absl::flat_hash_map<const HloInstruction*, int64> unscheduled_predecessors;
+  absl::flat_hash_map<const HloInstruction*, double> ready_time;
+  for (const HloInstruction* hlo : post_order) {
+    absl::flat_hash_set<const HloInstruction*> predecessors(
+        hlo->operands().begin(), hlo->operands().end());
+    predecessors.insert(hlo->control_predecessors().begin(),
+                        hlo->control_predecessors().end());
+    unscheduled_predecessors[hlo] = predecessors.size();
+    ready_time[hlo] = 0.0;
+  }
+
+  // Instructions that can be scheduled now, best candidate on top.
+  auto available_less = [&](const HloInstruction* a, const HloInstruction* b) {
+    if (IsCollective(*a) != IsCollective(*b)) {
+      return IsCollective(*b);
+    }
+    if (time_to_collective[a] != time_to_collective[b]) {
+      return time_to_collective[a] > time_to_collective[b];
+    }
+    if (path_to_end[a] != path_to_end[b]) {
+      return path_to_end[a] < path_to_end[b];
+    }
+    return position[a] > position[b];
+  };
+  // Instructions whose operands are scheduled but not done yet, earliest on
+  // top.
+  auto pending_less = [&](const HloInstruction* a, const HloInstruction* b) {
+    if (ready_time[a] != ready_time[b]) {
+      return ready_time[a] > ready_time[b];
+    }
+    return position[a] > position[b];
+  };
+  std::priority_queue<HloInstruction*, std::vector<HloInstruction*>,
+                      decltype(available_less)>
+      available(available_less);
+  std::priority_queue<HloInstruction*, std::vector<HloInstruction*>,
+                      decltype(pending_less)>
+      pending(pending_less);
+
+  double now = 0.0;
+  auto enqueue = [&](HloInstruction* hlo) {
+    if (IsCollective(*hlo) || ready_time[hlo] <= now) {
+      available.push(hlo);
+    } else {
+      pending.push(hlo);
+    }
+  };
+  for (HloInstruction* hlo : post_order) {
+    if (unscheduled_predecessors[hlo] == 0) {
+      enqueue(hlo);
+    }
+  }
+
+  std::vector<HloInstruction*> launch_order;
+  launch_order.reserve(post_order.size());
+  while (!available.empty() || !pending.empty()) {
+    if (available.empty()) {
+      now = ready_time[pending.top()];
+    }
+    while (!pending.empty() && ready_time[pending.top()] <= now) {
+      available.push(pending.top());
+      pending.pop();
+    }
+
+    HloInstruction* hlo = available.top();
+    available.pop();
+    launch_order.push_back(hlo);
+
+    const double start = std::max(now, ready_time[hlo]);
+    const double done = start + estimator.Estimate(*hlo);
+    if (!IsCollective(*hlo)) {
+      now = done;
+    }
+    for (HloInstruction* successor : successors(hlo)) {
+      ready_time[successor] = std::max(ready_time[successor], done);
+      if (--unscheduled_predecessors[successor] == 0) {
+        enqueue(successor);
+      }
+    }
+  }
+  CHECK_EQ(launch_order.size(), post_order.size());
+  return launch_order;
+}
+
+// Replaces the entry computation's sequence in 'schedule' with a
+// latency-hiding order, unless that would raise peak memory above the budget.
+Status ApplyLatencyHidingSchedule(
+    const HloModule* module, const LogicalBuffer::SizeFunction& size_function,
+    const HloCostAnalysis::ShapeSizeFunction& shape_size,
+    HloSchedule* schedule) {
+  const HloComputation* entry_computation = module->entry_computation();
+  HloCostAnalysis cost_analysis(shape_size);
+  Status status = entry_computation->Accept(&cost_analysis);
+  if (!status.ok()) {
+    VLOG(1) << "Not using the latency-hiding schedule, cost analysis failed: "
+            << status;
+    return Status::OK();
+  }
+  HloInstructionSequence latency_hiding_sequence(LatencyHidingLaunchOrder(
+      entry_computation, LatencyEstimator(&cost_analysis)));
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloAliasAnalysis> alias_analysis,
+                      HloAliasAnalysis::Run(module));
+  TF_ASSIGN_OR_RETURN(
+      const int64 memory_minimizing_peak,
+      HeapSimulator::MinimumMemoryForComputation(
+          *entry_computation, schedule->sequence(entry_computation),
+          *alias_analysis, size_function, schedule));
+  TF_ASSIGN_OR_RETURN(
+      const int64 latency_hiding_peak,
+      HeapSimulator::MinimumMemoryForComputation(
+          *entry_computation, latency_hiding_sequence, *alias_analysis,
+          size_function, schedule));
+  VLOG(1) << "Peak memory of the memory-minimizing schedule: "
+          << memory_minimizing_peak
+          << ", of the latency-hiding schedule: " << latency_hiding_peak;
+  if (latency_hiding_peak >
+      kMaxPeakMemoryIncrease * static_cast<double>(memory_minimizing_peak)) {
+    VLOG(1) << "Not using the latency-hiding schedule, it exceeds the peak "
+               "memory budget.";
+    return Status::OK();
+  }
+  schedule->set_sequence(entry_computation,
+                         std::move(latency_hiding_sequence));
+  return Status::OK();
+}
+
 }  // end namespace
 
 GpuHloSchedule::GpuHloSchedule() {}
@@ -199,14 +457,24 @@ StatusOr<std::unique_ptr<GpuHloSchedule>> GpuHloSchedule::Build(
   if (stream_assignment.StreamCount() == 1) {
     // All kernels are launched on a single stream, so there's no loss of
     // concurrency by optimizing for minimal memory usage.
+    auto size_function = [pointer_size](const BufferValue& buffer) {
+      return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
+    };
     TF_ASSIGN_OR_RETURN(
         HloSchedule sequences,
         ScheduleModule(
-            module,
-            [pointer_size](const BufferValue& buffer) {
-              return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
-            },
+            module, size_function,
             ComputationSchedulerToModuleScheduler(DefaultMemoryScheduler)));
+    if (module->config()
+            .debug_options()
+            .xla_gpu_enable_latency_hiding_scheduler()) {
+      TF_RETURN_IF_ERROR(ApplyLatencyHidingSchedule(
+          module, size_function,
+          [pointer_size](const Shape& shape) {
+            return ShapeUtil::ByteSizeOf(shape, pointer_size);
+          },
+          &sequences));
+    }
     schedule->thunk_launch_order_ =
         sequences.sequence(entry_computation).instructions();
     schedule->hlo_ordering_ =
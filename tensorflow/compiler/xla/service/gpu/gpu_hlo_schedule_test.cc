@@ -141,6 +141,52 @@ TEST_F(GpuHloScheduleTest, SequentialAdd) {
   EXPECT_TRUE(order->ExecutesBefore(add2, add3));
 }
 
+// With the latency-hiding scheduler, the all-reduce starts before the
+// independent compute chain, and its user runs after it.
+TEST_F(GpuHloScheduleTest, LatencyHidingSchedulerOverlapsAllReduce) {
+  const char* hlo_text = R"(
+HloModule AllReduceOverlap
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p0 = f32[256] parameter(0)
+  p1 = f32[1024,1024] parameter(1)
+  neg = f32[256] negate(p0)
+  all-reduce = f32[256] all-reduce(neg), replica_groups={}, to_apply=add
+  exp = f32[1024,1024] exponential(p1)
+  sqrt = f32[1024,1024] sqrt(exp)
+  log = f32[1024,1024] log(sqrt)
+  ROOT tuple = (f32[256], f32[1024,1024]) tuple(all-reduce, log)
+}
+)";
+  HloModuleConfig config;
+  DebugOptions debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_text, config));
+
+  std::unique_ptr<StreamAssignment> streams = AssignStreams(*module);
+  ASSERT_EQ(streams->StreamCount(), 1);
+  auto schedule = BuildGpuHloSchedule(module.get(), *streams);
+
+  const HloVec& order = schedule->ThunkLaunchOrder();
+  auto position = [&](absl::string_view name) {
+    return std::find_if(order.begin(), order.end(),
+                        [&](const HloInstruction* hlo) {
+                          return hlo->name() == name;
+                        }) -
+           order.begin();
+  };
+  EXPECT_LT(position("all-reduce"), position("exp"));
+  EXPECT_LT(position("log"), position("tuple"));
+}
+
 // Test of two streams.
 TEST_F(GpuHloScheduleTest, DISABLED_ConcurrentMatMul) {
   HloComputation::Builder builder("entry_computation");
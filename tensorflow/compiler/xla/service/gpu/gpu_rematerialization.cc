@@ -0,0 +1,139 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_rematerialization.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/dump.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/service/hlo_rematerialization.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Rematerialization only considers blocks of up to this many instructions;
+// after fusion most instructions are kernels, so larger blocks rarely help.
+constexpr int kBlockSizeLimit = 1;
+
+// Number of FP32 lanes per core assumed when estimating the peak FLOP rate.
+constexpr int kFlopsPerCorePerCycle = 2 * 64;
+
+}  // namespace
+
+StatusOr<bool> GpuRematerialization::Run(HloModule* module) {
+  HloCostAnalysis cost_analysis(shape_size_function_);
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    TF_RETURN_IF_ERROR(computation->Accept(&cost_analysis));
+  }
+  // The cost of recomputing an instruction relative to keeping its output
+  // live, with both expressed as device time. Rematerialized copies are not
+  // known to the cost analysis and are treated as free.
+  auto recompute_cost = [&](const HloInstruction* instruction) {
+    const int64 output_bytes = shape_size_function_(instruction->shape());
+    if (output_bytes <= 0) {
+      return 0.0;
+    }
+    const double flops = cost_analysis.flop_count(*instruction) +
+                         cost_analysis.transcendental_count(*instruction);
+    return flops / (flops_per_byte_ * output_bytes);
+  };
+
+  TF_ASSIGN_OR_RETURN(
+      HloSchedule schedule,
+      ScheduleModule(module,
+                     [this](const BufferValue& buffer) {
+                       return shape_size_function_(buffer.shape());
+                     },
+                     ComputationSchedulerToModuleScheduler(
+                         DefaultMemoryScheduler)));
+  TF_RETURN_IF_ERROR(module->set_schedule(std::move(schedule)));
+
+  HloRematerialization::RematerializationSizes sizes;
+  HloRematerialization remat(
+      shape_size_function_, memory_limit_bytes_, &sizes,
+      HloRematerialization::RematerializationPass::kPostFusion,
+      kBlockSizeLimit, /*block_rematerialization_factor=*/1,
+      /*compact_shape_function=*/nullptr,
+      HloRematerialization::RematerializationMode::kRecomputeOnly,
+      /*min_remat_size=*/0, recompute_cost);
+  TF_ASSIGN_OR_RETURN(bool changed, remat.Run(module));
+  module->clear_schedule();
+
+  if (DumpingEnabledForHloModule(*module)) {
+    std::string report = absl::StrCat(
+        "memory limit: ", memory_limit_bytes_, " bytes\n",
+        "peak memory before: ", sizes.before_bytes, " bytes\n",
+        "peak memory after: ", sizes.after_bytes, " bytes\n");
+    for (const HloComputation* computation :
+         module->MakeNonfusionComputations()) {
+      for (const HloInstruction* instruction : computation->instructions()) {
+        if (!absl::StrContains(instruction->name(), ".remat")) {
+          continue;
+        }
+        absl::StrAppend(&report, "rematerialized ", instruction->name(), ": ",
+                        shape_size_function_(instruction->shape()),
+                        " bytes\n");
+      }
+    }
+    DumpToFileInDirOrStdout(*module, "", "gpu_rematerialization", report);
+  }
+  VLOG(1) << "Peak memory of " << module->name() << " went from "
+          << sizes.before_bytes << " to " << sizes.after_bytes
+          << " bytes, limit " << memory_limit_bytes_;
+  return changed;
+}
+
+absl::optional<int64> GetDeviceMemoryBudget(
+    se::StreamExecutor* stream_exec,
+    se::DeviceMemoryAllocator* device_allocator) {
+  if (device_allocator != nullptr) {
+    absl::optional<se::AllocatorStats> stats =
+        device_allocator->GetAllocatorStats(stream_exec->device_ordinal());
+    if (stats && stats->bytes_limit) {
+      return *stats->bytes_limit - stats->bytes_in_use;
+    }
+  }
+  int64 free_bytes;
+  int64 total_bytes;
+  if (stream_exec->DeviceMemoryUsage(&free_bytes, &total_bytes)) {
+    return free_bytes;
+  }
+  return absl::nullopt;
+}
+
+double GetFlopsPerByte(se::StreamExecutor* stream_exec) {
+  const se::DeviceDescription& description =
+      stream_exec->GetDeviceDescription();
+  const double flops_per_second = description.core_count() *
+                                  description.clock_rate_ghz() * 1e9 *
+                                  kFlopsPerCorePerCycle;
+  if (flops_per_second <= 0 || description.memory_bandwidth() <= 0) {
+    return 1.0;
+  }
+  return flops_per_second / description.memory_bandwidth();
+}
+
+}  // namespace gpu
+}  // namespace xla
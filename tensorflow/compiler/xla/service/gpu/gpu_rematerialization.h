@@ -0,0 +1,74 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_REMATERIALIZATION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_REMATERIALIZATION_H_
+
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/stream_executor/device_memory_allocator.h"
+
+namespace xla {
+namespace gpu {
+
+// Rematerializes values of a fused GPU module so that its peak memory fits
+// into 'memory_limit_bytes'. Candidates are ranked by the memory they free,
+// penalized by the FLOPs needed to recompute them: an instruction costs as
+// much as its FLOPs divided by 'flops_per_byte' times its output size, so
+// cheap elementwise fusions are recomputed before convolutions or dots.
+//
+// The module is scheduled with the memory-minimizing scheduler for the
+// duration of the pass and left unscheduled afterwards, as the GPU backend
+// builds its own schedule before emitting thunks. The decisions are dumped
+// as "gpu_rematerialization" when dumping is enabled.
+class GpuRematerialization : public HloModulePass {
+ public:
+  GpuRematerialization(int64 memory_limit_bytes, double flops_per_byte,
+                       HloCostAnalysis::ShapeSizeFunction shape_size_function)
+      : memory_limit_bytes_(memory_limit_bytes),
+        flops_per_byte_(flops_per_byte),
+        shape_size_function_(std::move(shape_size_function)) {}
+
+  absl::string_view name() const override { return "gpu-rematerialization"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  const int64 memory_limit_bytes_;
+  const double flops_per_byte_;
+  const HloCostAnalysis::ShapeSizeFunction shape_size_function_;
+};
+
+// Returns the number of bytes a program compiled for 'stream_exec' may use:
+// the free memory of the allocator backing the device if it tracks its
+// limit (as the BFC allocator does), otherwise the free memory reported by
+// the driver. Returns nullopt if neither is known.
+absl::optional<int64> GetDeviceMemoryBudget(
+    se::StreamExecutor* stream_exec,
+    se::DeviceMemoryAllocator* device_allocator);
+
+// Returns the ratio of peak FLOP throughput to memory bandwidth of the device,
+// i.e. the number of FLOPs that take as long as moving one byte.
+double GetFlopsPerByte(se::StreamExecutor* stream_exec);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_REMATERIALIZATION_H_
@@ -0,0 +1,83 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/gpu_rematerialization.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+
+class GpuRematerializationTest : public HloTestBase {
+ protected:
+  StatusOr<bool> RunRematerialization(HloModule* module,
+                                      int64 memory_limit_bytes) {
+    GpuRematerialization remat(
+        memory_limit_bytes, /*flops_per_byte=*/10.0, [](const Shape& shape) {
+          return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+        });
+    return remat.Run(module);
+  }
+};
+
+// The broadcast is live across the negate and the first concatenate. The
+// program needs 16KB as is, and 12KB if the broadcast is recomputed right
+// before the second concatenate.
+constexpr char kRematerializableModule[] = R"(
+HloModule RematerializableModule
+
+ENTRY entry {
+  param = f32[1] parameter(0)
+  reshape = f32[] reshape(param)
+  bcast = f32[1024] broadcast(reshape), dimensions={}
+  negate = f32[1024] negate(bcast)
+  concat.1 = f32[2048] concatenate(negate, negate), dimensions={0}
+  slice.1 = f32[1] slice(concat.1), slice={[0:1]}
+  concat.2 = f32[1025] concatenate(bcast, slice.1), dimensions={0}
+  ROOT slice.2 = f32[1] slice(concat.2), slice={[0:1]}
+})";
+
+TEST_F(GpuRematerializationTest, RecomputesBroadcastToFitLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kRematerializableModule));
+  const HloInstruction* concat =
+      module->entry_computation()->root_instruction()->operand(0);
+  const HloInstruction* bcast = concat->operand(0);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunRematerialization(module.get(), 14 * 1024));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(concat->operand(0), op::Broadcast(::testing::Ne(bcast)));
+  // The GPU backend builds its own schedule later on.
+  EXPECT_FALSE(module->has_schedule());
+}
+
+TEST_F(GpuRematerializationTest, NoChangeWithinLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kRematerializableModule));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunRematerialization(module.get(), 1024 * 1024));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,75 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <utility>
+
+#include "tensorflow/compiler/xla/service/gpu/tests/gpu_codegen_test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+class GpuCudaGraphsTest : public GpuCodegenTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = GpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_cuda_graphs(true);
+    return debug_options;
+  }
+};
+
+// Several independent fusions end up as a run of kernel thunks that is
+// captured into a single graph and replayed on later executions.
+TEST_F(GpuCudaGraphsTest, KernelSequence) {
+  const char* hlo_text = R"(
+HloModule KernelSequence
+
+ENTRY main {
+  p0 = f32[1024] parameter(0)
+  p1 = f32[1024] parameter(1)
+  add = f32[1024] add(p0, p1)
+  exp = f32[1024] exponential(add)
+  rev = f32[1024] reverse(exp), dimensions={0}
+  mul = f32[1024] multiply(rev, p1)
+  ROOT tuple = (f32[1024], f32[1024]) tuple(mul, add)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+}
+
+// Back-to-back executions must not observe stale captured graphs.
+TEST_F(GpuCudaGraphsTest, RepeatedExecution) {
+  const char* hlo_text = R"(
+HloModule RepeatedExecution
+
+ENTRY main {
+  p0 = f32[256,256] parameter(0)
+  t = f32[256,256] transpose(p0), dimensions={1,0}
+  neg = f32[256,256] negate(t)
+  ROOT add = f32[256,256] add(neg, p0)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_text));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(RunAndCompareNoHloPasses(module->Clone(),
+                                         ErrorSpec{1e-5, 1e-5}));
+  }
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -79,12 +80,37 @@ StatusOr<bool> HloDCE::Run(HloModule* module) {
   VLOG(2) << "Before dce:";
   XLA_VLOG_LINES(2, module->ToString());
 
+  // Removing instructions does not add or remove computations, so the same
+  // post order is valid for the first two phases below.
+  const std::vector<HloComputation*> computations =
+      module->MakeComputationPostOrder();
+
   // Run DCE on each computation.
-  for (auto* computation : module->MakeComputationPostOrder()) {
-    TF_ASSIGN_OR_RETURN(
-        bool changed_for_computation,
-        RunOnComputation(computation, remove_cross_partition_collective_ops_));
-    changed |= changed_for_computation;
+  if (thread_pool_ != nullptr && computations.size() > 1) {
+    std::vector<StatusOr<bool>> results(computations.size(), false);
+    tensorflow::BlockingCounter counter(computations.size());
+    for (int64 i = 0; i < computations.size(); ++i) {
+      thread_pool_->Schedule([&, i]() {
+        results[i] = RunOnComputation(computations[i],
+                                      remove_cross_partition_collective_ops_);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    // Report the first error in post order so that failures are
+    // deterministic.
+    for (StatusOr<bool>& result : results) {
+      TF_ASSIGN_OR_RETURN(bool changed_for_computation, std::move(result));
+      changed |= changed_for_computation;
+    }
+  } else {
+    for (auto* computation : computations) {
+      TF_ASSIGN_OR_RETURN(bool changed_for_computation,
+                          RunOnComputation(
+                              computation,
+                              remove_cross_partition_collective_ops_));
+      changed |= changed_for_computation;
+    }
   }
 
   // Now DCE HloComputations.  First, collect the computations that are
@@ -93,7 +119,7 @@ StatusOr<bool> HloDCE::Run(HloModule* module) {
   if (HloComputation* entry_computation = module->entry_computation()) {
     live_computations.insert(entry_computation);
   }
-  for (auto* computation : module->MakeComputationPostOrder()) {
+  for (auto* computation : computations) {
     for (auto* instruction : computation->instructions()) {
       for (auto* subcomp : instruction->called_computations()) {
         live_computations.insert(subcomp);
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 #include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -33,12 +34,18 @@ namespace xla {
 //
 // This pass does not remove dead parameter instructions, as parameter
 // instructions cannot be deleted.
+//
+// Removing dead instructions only touches the computation being processed, so
+// if a `thread_pool` is given the computations are processed in parallel. The
+// result does not depend on the schedule.
 class HloDCE : public HloModulePass {
  public:
   HloDCE() : remove_cross_partition_collective_ops_(false) {}
-  explicit HloDCE(bool remove_cross_partition_collective_ops)
+  explicit HloDCE(bool remove_cross_partition_collective_ops,
+                  tensorflow::thread::ThreadPool* thread_pool = nullptr)
       : remove_cross_partition_collective_ops_(
-            remove_cross_partition_collective_ops) {}
+            remove_cross_partition_collective_ops),
+        thread_pool_(thread_pool) {}
   ~HloDCE() override {}
   absl::string_view name() const override { return "dce"; }
 
@@ -52,6 +59,7 @@ class HloDCE : public HloModulePass {
 
  private:
   bool remove_cross_partition_collective_ops_;
+  tensorflow::thread::ThreadPool* thread_pool_ = nullptr;  // Not owned.
 };
 
 }  // namespace xla
@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
@@ -33,6 +34,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -447,5 +450,68 @@ TEST_F(HloDceTest, KeepUsedSubcomputation) {
   EXPECT_EQ(module->MakeComputationPostOrder().size(), 2);
 }
 
+TEST_F(HloDceTest, ParallelMatchesSequential) {
+  const char* const hlo_string = R"(
+HloModule ParallelDce
+
+add {
+  p0 = f32[] parameter(0)
+  p1 = f32[] parameter(1)
+  dead.0 = f32[] multiply(p0, p1)
+  ROOT add = f32[] add(p0, p1)
+}
+
+body {
+  p = (f32[], f32[100]) parameter(0)
+  x = f32[] get-tuple-element(p), index=0
+  v = f32[100] get-tuple-element(p), index=1
+  dead.1 = f32[100] negate(v)
+  zero = f32[] constant(0)
+  r = f32[] reduce(v, zero), dimensions={0}, to_apply=add
+  sum = f32[] add(x, r)
+  ROOT t = (f32[], f32[100]) tuple(sum, v)
+}
+
+cond {
+  p = (f32[], f32[100]) parameter(0)
+  x = f32[] get-tuple-element(p), index=0
+  dead.2 = f32[] negate(x)
+  limit = f32[] constant(10)
+  ROOT lt = pred[] compare(x, limit), direction=LT
+}
+
+ENTRY entry {
+  x = f32[] parameter(0)
+  v = f32[100] parameter(1)
+  dead.3 = f32[100] exponential(v)
+  init = (f32[], f32[100]) tuple(x, v)
+  w = (f32[], f32[100]) while(init), condition=cond, body=body
+  ROOT out = f32[] get-tuple-element(w), index=0
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto sequential_module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(auto parallel_module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+
+  HloDCE sequential_dce;
+  EXPECT_TRUE(sequential_dce.Run(sequential_module.get()).ValueOrDie());
+
+  tensorflow::thread::ThreadPool thread_pool(tensorflow::Env::Default(),
+                                             "hlo_dce_test", 4);
+  HloDCE parallel_dce(/*remove_cross_partition_collective_ops=*/false,
+                      &thread_pool);
+  EXPECT_TRUE(parallel_dce.Run(parallel_module.get()).ValueOrDie());
+
+  EXPECT_EQ(parallel_module->ToString(), sequential_module->ToString());
+  for (const HloComputation* computation :
+       parallel_module->MakeComputationPostOrder()) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      EXPECT_FALSE(absl::StartsWith(instruction->name(), "dead"))
+          << computation->name();
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xla
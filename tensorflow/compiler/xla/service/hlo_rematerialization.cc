@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <set>
 #include <string>
@@ -494,6 +495,8 @@ class MemoryUsageTracker {
       const HloComputation* computation,
       const HloRematerialization::ShapeSizeFunction& size_function,
       const HloRematerialization::CompactShapeFunction& compact_shape_function,
+      const HloRematerialization::RecomputeCostFunction&
+          recompute_cost_function,
       const TuplePointsToAnalysis& points_to_analysis,
       const InstructionList& instruction_list,
       HloRematerialization::RematerializationMode mode);
@@ -526,8 +529,19 @@ class MemoryUsageTracker {
     }
 
     CHECK_GT(memory_reduced, 0);
-    // Return the inverse of the benefit of rematerialization.
-    return memory_limit_bytes / memory_reduced;
+    // Return the inverse of the benefit of rematerialization, scaled by the
+    // cost of recomputing the block if the client provided one.
+    const int64 cost = memory_limit_bytes / memory_reduced;
+    if (recompute_cost_function_ == nullptr) {
+      return cost;
+    }
+    double recompute_cost = 0.0;
+    for (auto* item : items) {
+      recompute_cost += recompute_cost_function_(item->instruction);
+    }
+    return static_cast<int64>(
+        std::min(static_cast<double>(cost) * (1.0 + recompute_cost),
+                 static_cast<double>(std::numeric_limits<int64>::max() / 2)));
   }
 
   // Finishes the placement of the current instruction. This frees any dead
@@ -766,6 +780,9 @@ class MemoryUsageTracker {
   // already considered compact.
   const HloRematerialization::CompactShapeFunction& compact_shape_function_;
 
+  // Returns the relative cost of recomputing an instruction. May be null.
+  const HloRematerialization::RecomputeCostFunction& recompute_cost_function_;
+
   // A map that caches existing known compact shape for each instruction.
   absl::flat_hash_map<const HloInstruction*, Shape> compact_shape_;
 
@@ -785,6 +802,7 @@ MemoryUsageTracker::MemoryUsageTracker(
     const HloComputation* computation,
     const HloRematerialization::ShapeSizeFunction& size_function,
     const HloRematerialization::CompactShapeFunction& compact_shape_function,
+    const HloRematerialization::RecomputeCostFunction& recompute_cost_function,
     const TuplePointsToAnalysis& points_to_analysis,
     const InstructionList& instruction_list,
     HloRematerialization::RematerializationMode mode)
@@ -792,6 +810,7 @@ MemoryUsageTracker::MemoryUsageTracker(
       instruction_list_(instruction_list),
       size_function_(size_function),
       compact_shape_function_(compact_shape_function),
+      recompute_cost_function_(recompute_cost_function),
       mode_(mode) {
   PointsToSet::BufferSet live_out_set =
       points_to_analysis.GetPointsToSet(computation_->root_instruction())
@@ -1472,7 +1491,7 @@ MemoryUsageTracker::PickRematerializationCandidates(
       const int64 memory_reduced = MemoryReducedIfRematerialized(block);
       effort++;
       if (memory_reduced > 0) {
-        const int cost =
+        const int64 cost =
             RematerializationCost(block, memory_reduced, memory_limit_bytes);
 
         VLOG(5) << "Candidate block of size " << block.size()
@@ -1803,8 +1822,8 @@ StatusOr<int64> HloRematerialization::ComputePeakMemory(
     const HloInstructionSequence& order) const {
   InstructionList instruction_list(order);
   MemoryUsageTracker tracker(computation, size_function_,
-                             compact_shape_function_, *points_to_analysis_,
-                             instruction_list, mode_);
+                             compact_shape_function_, recompute_cost_function_,
+                             *points_to_analysis_, instruction_list, mode_);
   int64 peak_memory = tracker.memory_usage();
   for (auto* item = instruction_list.first(); item != nullptr;
        item = instruction_list.next(item)) {
@@ -1848,7 +1867,7 @@ StatusOr<bool> HloRematerialization::RematerializeComputation(
   InstructionList instruction_list(schedule->sequence(computation));
   MemoryUsageTracker memory_tracker(
       computation, size_function_, compact_shape_function_,
-      *points_to_analysis_, instruction_list, mode_);
+      recompute_cost_function_, *points_to_analysis_, instruction_list, mode_);
 
   instruction_list.PromoteNodesToSkip([&](Item* item) {
     return memory_tracker.AllocatedSize(item) >= min_remat_size;
@@ -42,6 +42,8 @@ class HloRematerialization : public HloModulePass {
 
   using CompactShapeFunction = std::function<StatusOr<Shape>(const Shape&)>;
 
+  using RecomputeCostFunction = std::function<double(const HloInstruction*)>;
+
   // Helper struct that communicates the before / after sizes for the
   // rematerialization process.
   struct RematerializationSizes {
@@ -80,13 +82,21 @@ class HloRematerialization : public HloModulePass {
   //
   //   compact_shape_function: Function which returns the compact form of a
   //   shape. If nullptr is provided, an default identity function is used.
+  //
+  //   recompute_cost_function: Function which returns the cost of recomputing
+  //   an instruction relative to the memory its output occupies. The cost of a
+  //   candidate block is scaled by one plus the sum over its instructions, so
+  //   expensive instructions are only rematerialized if they save
+  //   proportionally more memory. If nullptr is provided, recomputation is
+  //   considered free.
   explicit HloRematerialization(
       const ShapeSizeFunction& size_function, int64 memory_limit_bytes,
       RematerializationSizes* sizes, RematerializationPass pass_location,
       int block_size_limit, int block_rematerialization_factor,
       CompactShapeFunction compact_shape_function = nullptr,
       RematerializationMode mode = RematerializationMode::kRecomputeAndCompress,
-      int64 min_remat_size = 0)
+      int64 min_remat_size = 0,
+      RecomputeCostFunction recompute_cost_function = nullptr)
       : size_function_(size_function),
         memory_limit_bytes_(memory_limit_bytes),
         sizes_(sizes),
@@ -97,7 +107,8 @@ class HloRematerialization : public HloModulePass {
                                     ? DefaultCompactShapeFunction
                                     : std::move(compact_shape_function)),
         mode_(mode),
-        min_remat_size_(min_remat_size) {}
+        min_remat_size_(min_remat_size),
+        recompute_cost_function_(std::move(recompute_cost_function)) {}
   ~HloRematerialization() override = default;
 
   absl::string_view name() const override { return "rematerialization"; }
@@ -196,6 +207,8 @@ class HloRematerialization : public HloModulePass {
   RematerializationMode mode_;
 
   int64 min_remat_size_;
+
+  const RecomputeCostFunction recompute_cost_function_;
 };
 
 }  // namespace xla
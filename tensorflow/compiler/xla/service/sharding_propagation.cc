@@ -1782,6 +1782,14 @@ StatusOr<bool> ShardingPropagation::Run(HloModule* module) {
   // sharding as its sharding have to match with the one expected by the host.
   provided_shardings.insert(module->entry_computation()->root_instruction());
 
+  // The fixpoint iteration below only changes shardings and never the graph
+  // structure, so the per-computation post orders are computed once instead
+  // of on every iteration.
+  std::vector<std::vector<HloInstruction*>> computation_post_orders;
+  for (const HloComputation* computation : module->computations()) {
+    computation_post_orders.push_back(computation->MakeInstructionPostOrder());
+  }
+
   // Iterate to a fixpoint that is guaranteed to be reached because we only
   // strictly improve the sharding of the graph and it can't be improved
   // indefinitely.
@@ -1796,13 +1804,13 @@ StatusOr<bool> ShardingPropagation::Run(HloModule* module) {
       int64 inferred_from_user_counter = 0;
       int64 instruction_counter = 0;
       int64 already_sharded_counter = 0;
-      for (const HloComputation* computation : module->computations()) {
-        std::vector<HloInstruction*> instructions =
-            computation->MakeInstructionPostOrder();
-
-        instruction_counter += instructions.size();
-        for (const HloInstruction* instruction : instructions) {
-          already_sharded_counter += (instruction->has_sharding() ? 1 : 0);
+      for (const std::vector<HloInstruction*>& instructions :
+           computation_post_orders) {
+        if (VLOG_IS_ON(1)) {
+          instruction_counter += instructions.size();
+          for (const HloInstruction* instruction : instructions) {
+            already_sharded_counter += (instruction->has_sharding() ? 1 : 0);
+          }
         }
         auto clear_cache = [&](HloInstruction* hlo) {
           for (auto operand : hlo->operands()) {
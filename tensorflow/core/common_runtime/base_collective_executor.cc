@@ -15,8 +15,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -49,6 +52,14 @@ bool IsCancelled(CancellationManager* cancel_mgr) {
   return cancel_mgr != nullptr &&
          (cancel_mgr->IsCancelled() || cancel_mgr->IsCancelling());
 }
+
+// Maximum number of reductions in one bucket.  The group leader sends the
+// instance keys of each bucket to the other members in a fixed size tensor.
+constexpr int kMaxFusedReductions = 256;
+
+string FusionManifestKey(int32 group_key, int64 bucket, int rank) {
+  return strings::StrCat("fusion:", group_key, ":", bucket, ":", rank);
+}
 }  // namespace
 
 /*static*/
@@ -267,6 +278,27 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
                                           const CollectiveParams* col_params,
                                           const string& exec_key,
                                           StatusCallback done) {
+  if (CanFuse(ctx, *col_params)) {
+    EnqueueFusedReduction({ctx, col_params, exec_key, std::move(done)});
+    return;
+  }
+  Tensor* output = ctx->mutable_output(0);
+  const Tensor* input = (col_params->instance.type == REDUCTION_COLLECTIVE ||
+                         col_params->instance.type == GATHER_COLLECTIVE ||
+                         col_params->instance.type == PERMUTE_COLLECTIVE ||
+                         (col_params->instance.type == BROADCAST_COLLECTIVE &&
+                          col_params->is_source))
+                            ? &ctx->input(0)
+                            : nullptr;
+  ExecuteInternal(ctx, col_params, exec_key, input, output, std::move(done));
+}
+
+void BaseCollectiveExecutor::ExecuteInternal(OpKernelContext* ctx,
+                                             const CollectiveParams* col_params,
+                                             const string& exec_key,
+                                             const Tensor* input,
+                                             Tensor* output,
+                                             StatusCallback done) {
   // See CompleteParamsAsync() how done() and the timeout callback interacts.
   const auto is_callback_called = std::make_shared<std::atomic<bool>>(false);
   auto done_safe = [this, done, ctx, is_callback_called](const Status& s) {
@@ -296,14 +328,6 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
         });
   }
 
-  Tensor* output = ctx->mutable_output(0);
-  const Tensor* input = (col_params->instance.type == REDUCTION_COLLECTIVE ||
-                         col_params->instance.type == GATHER_COLLECTIVE ||
-                         col_params->instance.type == PERMUTE_COLLECTIVE ||
-                         (col_params->instance.type == BROADCAST_COLLECTIVE &&
-                          col_params->is_source))
-                            ? &ctx->input(0)
-                            : nullptr;
   CollectiveImplementationInterface* col_impl = nullptr;
   Status status = CreateCollective(*col_params, &col_impl);
   if (!status.ok()) {
@@ -343,6 +367,328 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
   });
 }
 
+bool BaseCollectiveExecutor::CanFuse(OpKernelContext* ctx,
+                                     const CollectiveParams& col_params) const {
+  if (fusion_options_.threshold_bytes <= 0) return false;
+  // Buckets are packed and unpacked with host memcpy, and their content is
+  // exchanged as host tensors, so only CPU reductions are bucketed.
+  return col_params.instance.type == REDUCTION_COLLECTIVE &&
+         col_params.group.device_type == DEVICE_CPU &&
+         col_params.group.group_size > 1 &&
+         col_params.instance.impl_details.collective_name != "NcclReduce" &&
+         col_params.instance.impl_details.dependencies.empty() &&
+         col_params.merge_op != nullptr && col_params.final_op != nullptr &&
+         DataTypeCanUseMemcpy(col_params.instance.data_type) &&
+         ctx->input(0).dtype() == col_params.instance.data_type &&
+         static_cast<int64>(ctx->input(0).TotalBytes()) <
+             fusion_options_.threshold_bytes;
+}
+
+void BaseCollectiveExecutor::EnqueueFusedReduction(
+    PendingReduction reduction) {
+  const string queue_key =
+      strings::StrCat(reduction.ctx->device()->name(), ":",
+                      reduction.col_params->group.group_key);
+  const bool is_leader = reduction.col_params->default_rank == 0;
+  VLOG(2) << "EnqueueFusedReduction " << reduction.col_params->name
+          << " instance " << reduction.col_params->instance.instance_key
+          << " queue " << queue_key;
+  {
+    mutex_lock l(fusion_mu_);
+    FusionQueue& queue = fusion_queues_[queue_key];
+    queue.pending_bytes += reduction.ctx->input(0).TotalBytes();
+    queue.pending.push_back(std::move(reduction));
+  }
+  if (is_leader) {
+    FlushFusionQueue(queue_key, /*flush_all=*/false);
+  } else {
+    AdvanceFusionQueue(queue_key);
+  }
+}
+
+void BaseCollectiveExecutor::FlushFusionQueue(const string& queue_key,
+                                              bool flush_all) {
+  std::vector<std::vector<PendingReduction>> buckets;
+  std::vector<int64> bucket_seqs;
+  {
+    mutex_lock l(fusion_mu_);
+    FusionQueue& queue = fusion_queues_[queue_key];
+    while (!queue.pending.empty() &&
+           (flush_all ||
+            queue.pending_bytes >= fusion_options_.threshold_bytes)) {
+      // The bucket takes the oldest reduction, and the following ones with
+      // the same data type and ops, up to the byte threshold.
+      const CollectiveParams* head = queue.pending.front().col_params;
+      std::vector<PendingReduction> bucket;
+      std::vector<PendingReduction> rest;
+      int64 bucket_bytes = 0;
+      for (PendingReduction& reduction : queue.pending) {
+        const CollectiveParams* cp = reduction.col_params;
+        const int64 bytes = reduction.ctx->input(0).TotalBytes();
+        if (bucket.empty() ||
+            (static_cast<int>(bucket.size()) < kMaxFusedReductions &&
+             bucket_bytes + bytes <= fusion_options_.threshold_bytes &&
+             cp->instance.data_type == head->instance.data_type &&
+             cp->merge_op->type_string() == head->merge_op->type_string() &&
+             cp->final_op->type_string() == head->final_op->type_string())) {
+          bucket_bytes += bytes;
+          bucket.push_back(std::move(reduction));
+        } else {
+          rest.push_back(std::move(reduction));
+        }
+      }
+      queue.pending = std::move(rest);
+      queue.pending_bytes -= bucket_bytes;
+      buckets.push_back(std::move(bucket));
+      bucket_seqs.push_back(queue.next_bucket++);
+    }
+    if (!queue.pending.empty() && !queue.flush_scheduled) {
+      queue.flush_scheduled = true;
+      Ref();
+      auto flush = [this, queue_key] {
+        {
+          mutex_lock l(fusion_mu_);
+          fusion_queues_[queue_key].flush_scheduled = false;
+        }
+        FlushFusionQueue(queue_key, /*flush_all=*/true);
+        Unref();
+      };
+      SchedNonBlockingClosureAfter(fusion_options_.window_us, flush);
+    }
+  }
+
+  for (int b = 0; b < static_cast<int>(buckets.size()); ++b) {
+    std::vector<PendingReduction>& bucket = buckets[b];
+    const PendingReduction& head = bucket.front();
+    const CollectiveParams& cp = *head.col_params;
+    Device* device = nullptr;
+    Status s = dev_mgr_->LookupDevice(head.ctx->device()->name(), &device);
+    if (!s.ok()) {
+      for (PendingReduction& reduction : bucket) reduction.done(s);
+      continue;
+    }
+    // Send the instance keys of the bucket to the other members.
+    auto manifest = std::make_shared<Tensor>(
+        DT_INT32, TensorShape({kMaxFusedReductions + 1}));
+    auto manifest_flat = manifest->flat<int32>();
+    manifest_flat(0) = bucket.size();
+    for (int i = 0; i < static_cast<int>(bucket.size()); ++i) {
+      manifest_flat(i + 1) = bucket[i].col_params->instance.instance_key;
+    }
+    for (int rank = 1; rank < cp.group.group_size; ++rank) {
+      Ref();
+      remote_access_->PostToPeer(
+          cp.group.device_names[rank], cp.group.task_names[rank],
+          FusionManifestKey(cp.group.group_key, bucket_seqs[b], rank), device,
+          head.ctx->op_device_context(), AllocatorAttributes(), manifest.get(),
+          device->attributes().locality(), /*cancellation_manager=*/nullptr,
+          [this, manifest](const Status& s) {
+            if (!s.ok()) StartAbort(s);
+            Unref();
+          });
+    }
+    RunFusedReduction(std::move(bucket));
+  }
+}
+
+void BaseCollectiveExecutor::AdvanceFusionQueue(const string& queue_key) {
+  std::vector<PendingReduction> bucket;
+  std::vector<PendingReduction> failed;
+  Status status;
+  bool request_manifest = false;
+  PendingReduction next;
+  int64 next_seq = 0;
+  {
+    mutex_lock l(fusion_mu_);
+    FusionQueue& queue = fusion_queues_[queue_key];
+    status = TakeManifestBucket(&queue, &bucket);
+    if (!status.ok()) {
+      failed = std::move(queue.pending);
+      queue.pending.clear();
+      queue.pending_bytes = 0;
+    } else if (!queue.pending.empty() && !queue.manifest_requested) {
+      queue.manifest_requested = true;
+      request_manifest = true;
+      next = queue.pending.front();
+      next_seq = queue.next_bucket;
+    }
+  }
+  if (!status.ok()) {
+    StartAbort(status);
+    for (PendingReduction& reduction : failed) {
+      reduction.done(GetStatus(status));
+    }
+    return;
+  }
+  if (request_manifest) {
+    RequestFusionManifest(queue_key, next, next_seq);
+  }
+  if (!bucket.empty()) {
+    RunFusedReduction(std::move(bucket));
+  }
+}
+
+void BaseCollectiveExecutor::RequestFusionManifest(
+    const string& queue_key, const PendingReduction& reduction, int64 bucket) {
+  const CollectiveParams& cp = *reduction.col_params;
+  Device* device = nullptr;
+  Status s = dev_mgr_->LookupDevice(reduction.ctx->device()->name(), &device);
+  auto manifest = std::make_shared<Tensor>(
+      DT_INT32, TensorShape({kMaxFusedReductions + 1}));
+  auto done = [this, queue_key, manifest](const Status& s) {
+    {
+      mutex_lock l(fusion_mu_);
+      FusionQueue& queue = fusion_queues_[queue_key];
+      if (s.ok()) {
+        queue.manifest = manifest;
+      } else {
+        queue.manifest_requested = false;
+      }
+    }
+    if (s.ok()) {
+      AdvanceFusionQueue(queue_key);
+    } else {
+      std::vector<PendingReduction> failed;
+      {
+        mutex_lock l(fusion_mu_);
+        FusionQueue& queue = fusion_queues_[queue_key];
+        failed = std::move(queue.pending);
+        queue.pending.clear();
+        queue.pending_bytes = 0;
+      }
+      StartAbort(s);
+      for (PendingReduction& reduction : failed) {
+        reduction.done(GetStatus(s));
+      }
+    }
+    Unref();
+  };
+  Ref();
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  remote_access_->RecvFromPeer(
+      cp.group.device_names[0], cp.group.task_names[0], cp.task.is_local[0],
+      FusionManifestKey(cp.group.group_key, bucket, cp.default_rank), device,
+      reduction.ctx->op_device_context(), AllocatorAttributes(),
+      manifest.get(), device->attributes().locality(),
+      0 /*dev_to_dev_stream_index*/, /*cancellation_manager=*/nullptr,
+      std::move(done));
+}
+
+Status BaseCollectiveExecutor::TakeManifestBucket(
+    FusionQueue* queue, std::vector<PendingReduction>* bucket) {
+  if (!queue->manifest) return Status::OK();
+  auto manifest_flat = queue->manifest->flat<int32>();
+  const int num_reductions = manifest_flat(0);
+  if (num_reductions < 1 || num_reductions > kMaxFusedReductions) {
+    return errors::Internal("Invalid number of fused reductions ",
+                            num_reductions);
+  }
+  std::vector<int> indices;
+  for (int i = 1; i <= num_reductions; ++i) {
+    int index = -1;
+    for (int j = 0; j < static_cast<int>(queue->pending.size()); ++j) {
+      if (queue->pending[j].col_params->instance.instance_key ==
+          manifest_flat(i)) {
+        index = j;
+        break;
+      }
+    }
+    // Wait until all reductions of the bucket are issued on this device.
+    if (index < 0) return Status::OK();
+    indices.push_back(index);
+  }
+  std::vector<bool> taken(queue->pending.size(), false);
+  for (int index : indices) {
+    queue->pending_bytes -= queue->pending[index].ctx->input(0).TotalBytes();
+    bucket->push_back(std::move(queue->pending[index]));
+    taken[index] = true;
+  }
+  std::vector<PendingReduction> rest;
+  for (int j = 0; j < static_cast<int>(queue->pending.size()); ++j) {
+    if (!taken[j]) rest.push_back(std::move(queue->pending[j]));
+  }
+  queue->pending = std::move(rest);
+  queue->manifest.reset();
+  queue->manifest_requested = false;
+  ++queue->next_bucket;
+  return Status::OK();
+}
+
+void BaseCollectiveExecutor::RunFusedReduction(
+    std::vector<PendingReduction> bucket) {
+  OpKernelContext* ctx = bucket.front().ctx;
+  const CollectiveParams* head = bucket.front().col_params;
+  const string exec_key = bucket.front().exec_key;
+  int64 num_elements = 0;
+  for (const PendingReduction& reduction : bucket) {
+    if (reduction.col_params->instance.data_type !=
+        head->instance.data_type) {
+      Status s = errors::Internal("Fused reductions of different data types ",
+                                  head->name, " and ",
+                                  reduction.col_params->name);
+      StartAbort(s);
+      for (PendingReduction& r : bucket) r.done(GetStatus(s));
+      return;
+    }
+    num_elements += reduction.ctx->input(0).NumElements();
+  }
+  VLOG(1) << "RunFusedReduction of " << bucket.size() << " reductions, "
+          << num_elements << " elements, on device " << ctx->device()->name();
+
+  // Pack the inputs.
+  auto fused = std::make_shared<Tensor>(
+      ctx->device()->GetAllocator(AllocatorAttributes()),
+      head->instance.data_type, TensorShape({num_elements}));
+  char* fused_base = static_cast<char*>(DMAHelper::base(fused.get()));
+  int64 offset = 0;
+  for (const PendingReduction& reduction : bucket) {
+    const Tensor& input = reduction.ctx->input(0);
+    std::memcpy(fused_base + offset, DMAHelper::base(&input),
+                input.TotalBytes());
+    offset += input.TotalBytes();
+  }
+
+  // The bucket is reduced like its first reduction, on the packed buffer.
+  CollectiveParams* fused_params = new CollectiveParams();
+  fused_params->name =
+      strings::StrCat(head->name, " (fused, ", bucket.size(), " reductions)");
+  fused_params->group = head->group;
+  fused_params->instance = head->instance;
+  fused_params->instance.shape = fused->shape();
+  fused_params->task = head->task;
+  fused_params->subdiv_rank = head->subdiv_rank;
+  fused_params->default_rank = head->default_rank;
+  fused_params->is_source = head->is_source;
+  fused_params->merge_op = head->merge_op;
+  fused_params->final_op = head->final_op;
+
+  ExecuteInternal(
+      ctx, fused_params, exec_key, fused.get(), fused.get(),
+      [bucket = std::move(bucket), fused, fused_params](const Status& s) {
+        if (s.ok()) {
+          // Unpack the outputs.
+          const char* fused_base =
+              static_cast<const char*>(DMAHelper::base(fused.get()));
+          int64 offset = 0;
+          for (const PendingReduction& reduction : bucket) {
+            Tensor* output = reduction.ctx->mutable_output(0);
+            std::memcpy(DMAHelper::base(output), fused_base + offset,
+                        output->TotalBytes());
+            offset += output->TotalBytes();
+          }
+        }
+        fused_params->Unref();
+        // The first reduction's context is used by the fused collective, so
+        // it is released last.
+        for (int i = bucket.size() - 1; i >= 0; --i) {
+          bucket[i].done(s);
+        }
+      });
+}
+
 void BaseCollectiveExecutor::CompleteParamsAsync(
     const DeviceAttributes& device, CollectiveParams* cp,
     CancellationManager* cancel_mgr, StatusCallback done) {
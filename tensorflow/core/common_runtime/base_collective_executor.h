@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
 #include "tensorflow/core/framework/collective.h"
@@ -90,6 +92,17 @@ CollectiveAdapter* MakeCollectiveAdapter(Tensor* output, int num_chunks,
                                          Allocator* allocator,
                                          bool align_chunks = true);
 
+// Options for bucketing small reductions into a single collective, see
+// ConfigProto.Experimental.collective_fusion_threshold_bytes.
+struct CollectiveFusionOptions {
+  // Reductions of fewer bytes than this are bucketed.  Bucketing is disabled
+  // if not positive.
+  int64 threshold_bytes = 0;
+  // How long the group leader waits for more reductions before it launches a
+  // bucket smaller than threshold_bytes.
+  int64 window_us = 1000;
+};
+
 // Default implementation of CollectiveExecutor.  Delegates the actual
 // work of moving data to a class specialized for the operation type,
 // arguments and device+interconnect topology.
@@ -98,13 +111,16 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   BaseCollectiveExecutor(CollectiveExecutorMgrInterface* cem,
                          CollectiveRemoteAccess* remote_access, int64 step_id,
                          const DeviceMgr* dev_mgr, const string* gpu_ring_order,
-                         std::shared_ptr<UnboundedWorkQueue> work_queue)
+                         std::shared_ptr<UnboundedWorkQueue> work_queue,
+                         const CollectiveFusionOptions& fusion_options =
+                             CollectiveFusionOptions())
       : CollectiveExecutor(cem),
         step_id_(step_id),
         dev_mgr_(dev_mgr),
         remote_access_(remote_access),
         gpu_ring_order_(gpu_ring_order),
-        work_queue_(std::move(work_queue)) {}
+        work_queue_(std::move(work_queue)),
+        fusion_options_(fusion_options) {}
 
   ~BaseCollectiveExecutor() override;
 
@@ -152,6 +168,63 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   Status status_ TF_GUARDED_BY(status_mu_);
 
  private:
+  // A reduction waiting to be run as part of a bucket.
+  struct PendingReduction {
+    OpKernelContext* ctx;
+    const CollectiveParams* col_params;
+    string exec_key;
+    StatusCallback done;
+  };
+
+  // The reductions of one device in one group that have not been run yet.
+  struct FusionQueue {
+    // In order of arrival.
+    std::vector<PendingReduction> pending;
+    int64 pending_bytes = 0;
+    // Sequence number of the next bucket of this queue.
+    int64 next_bucket = 0;
+    // Group leader only: whether a flush of the queue is scheduled.
+    bool flush_scheduled = false;
+    // Other members only: whether the content of the next bucket is being
+    // received from the leader, or has been received but not run yet.
+    bool manifest_requested = false;
+    std::shared_ptr<Tensor> manifest;
+  };
+
+  // Runs the collective on "input" and "output", instead of on the input and
+  // output of "ctx".
+  void ExecuteInternal(OpKernelContext* ctx, const CollectiveParams* col_params,
+                       const string& exec_key, const Tensor* input,
+                       Tensor* output, StatusCallback done);
+
+  // Returns true if the reduction may be bucketed with others.
+  bool CanFuse(OpKernelContext* ctx, const CollectiveParams& col_params) const;
+  // Adds the reduction to the queue of its device and group.
+  void EnqueueFusedReduction(PendingReduction reduction)
+      TF_LOCKS_EXCLUDED(fusion_mu_);
+  // Group leader only: launches the buckets of the queue, and sends their
+  // content to the other members of the group.  Only launches full buckets
+  // unless "flush_all".
+  void FlushFusionQueue(const string& queue_key, bool flush_all)
+      TF_LOCKS_EXCLUDED(fusion_mu_);
+  // Other members only: receives the content of the next bucket from the
+  // group leader.
+  void RequestFusionManifest(const string& queue_key,
+                             const PendingReduction& reduction,
+                             int64 bucket) TF_LOCKS_EXCLUDED(fusion_mu_);
+  // Other members only: runs the next bucket if its content is known and all
+  // its reductions are pending, and requests the content of the bucket after.
+  void AdvanceFusionQueue(const string& queue_key)
+      TF_LOCKS_EXCLUDED(fusion_mu_);
+  // Other members only: takes the next bucket out of "queue", if its content
+  // is known and all its reductions are pending.
+  Status TakeManifestBucket(FusionQueue* queue,
+                            std::vector<PendingReduction>* bucket)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(fusion_mu_);
+  // Packs the inputs of "bucket" in one buffer, reduces it, and unpacks the
+  // result to the outputs.
+  void RunFusedReduction(std::vector<PendingReduction> bucket);
+
   Status CreateCollective(const CollectiveParams& col_params,
                           CollectiveImplementationInterface** col_impl);
   // Check if all ops on which this collective depends on have launched.
@@ -160,6 +233,12 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   // Tries to return the status that is the original error. It returns the
   // aborted status if the collective executor is aborted.
   Status GetStatus(const Status& s) TF_LOCKS_EXCLUDED(status_mu_);
+
+  const CollectiveFusionOptions fusion_options_;
+  mutex fusion_mu_;
+  // device name + group key -> reductions not yet run.
+  std::unordered_map<string, FusionQueue> fusion_queues_
+      TF_GUARDED_BY(fusion_mu_);
 };
 
 }  // namespace tensorflow
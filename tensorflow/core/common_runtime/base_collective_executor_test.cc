@@ -0,0 +1,314 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/unbounded_work_queue.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+static int64 kStepId = 123;
+
+// Number of times TestSumReducer::Run was called.
+std::atomic<int> num_collective_runs(0);
+
+// Partial sums of TestSumReducer, by exec key.
+struct SumTable {
+  mutex mu;
+  condition_variable cv;
+  std::unordered_map<string, std::pair<Tensor, int>> sums TF_GUARDED_BY(mu);
+};
+
+SumTable* GetSumTable() {
+  static SumTable* table = new SumTable;
+  return table;
+}
+
+// Sums the float inputs of all members of the group, through a shared table.
+// Ignores the final op.
+class TestSumReducer : public CollectiveImplementationInterface {
+ public:
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override {
+    return Status::OK();
+  }
+
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override {
+    col_ctx_ = col_ctx;
+    return Status::OK();
+  }
+
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  void Run(StatusCallback done) override {
+    ++num_collective_runs;
+    const int group_size = col_ctx_->col_params->group.group_size;
+    SumTable* table = GetSumTable();
+    mutex_lock l(table->mu);
+    auto& entry = table->sums[col_ctx_->exec_key];
+    if (entry.second == 0) {
+      entry.first = Tensor(DT_FLOAT, col_ctx_->input->shape());
+      entry.first.flat<float>().setZero();
+    }
+    if (entry.first.shape() != col_ctx_->input->shape()) {
+      done(errors::Internal("Shape mismatch for ", col_ctx_->exec_key));
+      return;
+    }
+    entry.first.flat<float>() += col_ctx_->input->flat<float>();
+    ++entry.second;
+    table->cv.notify_all();
+    while (entry.second < group_size) {
+      table->cv.wait(l);
+    }
+    col_ctx_->output->flat<float>() = entry.first.flat<float>();
+    done(Status::OK());
+  }
+
+ private:
+  std::shared_ptr<CollectiveContext> col_ctx_;
+};
+
+REGISTER_COLLECTIVE(TestSumReduce, TestSumReducer);
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op, "_node"), op);
+  TF_CHECK_OK(builder.Attr("T", DT_FLOAT)
+                  .Input(FakeInput(DT_FLOAT))
+                  .Input(FakeInput(DT_FLOAT))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+class BaseCollectiveExecutorFusionTest : public ::testing::Test {
+ protected:
+  ~BaseCollectiveExecutorFusionTest() override {
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(int num_devices, const CollectiveFusionOptions& fusion_options) {
+    std::vector<std::unique_ptr<Device>> devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    for (int di = 0; di < num_devices; ++di) {
+      devices.push_back(absl::make_unique<ThreadPoolDevice>(
+          sess_opts, strings::StrCat(kTaskName, "/cpu:", di), Bytes(4 << 20),
+          DeviceLocality(), cpu_allocator()));
+      device_names_.push_back(devices.back()->name());
+    }
+    dev_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(devices));
+    dev_resolver_ = absl::make_unique<DeviceResolverLocal>(dev_mgr_.get());
+    work_queue_ = std::make_shared<UnboundedWorkQueue>(Env::Default(), "test");
+    col_exec_ = new BaseCollectiveExecutor(
+        &col_exec_mgr_,
+        new CollectiveRemoteAccessLocal(dev_mgr_.get(), dev_resolver_.get(),
+                                        kStepId),
+        kStepId, dev_mgr_.get(), &gpu_ring_order_, work_queue_,
+        fusion_options);
+    num_collective_runs = 0;
+    SumTable* table = GetSumTable();
+    mutex_lock l(table->mu);
+    table->sums.clear();
+  }
+
+  // Reduces a tensor of "len" floats on the device of rank "rank", in the
+  // collective instance "instance_key".
+  Status DoReduce(int rank, int instance_key, int len, Tensor* result) {
+    Device* device = nullptr;
+    TF_CHECK_OK(dev_mgr_->LookupDevice(device_names_[rank], &device));
+    std::unique_ptr<OpKernel> merge_op = GetBinOp("Add", device);
+    std::unique_ptr<OpKernel> final_op = GetBinOp("Div", device);
+
+    CollectiveParams* col_params = new CollectiveParams();
+    core::ScopedUnref unref(col_params);
+    col_params->name = strings::StrCat("reduce_", instance_key);
+    col_params->group.group_key = 1;
+    col_params->group.group_size = device_names_.size();
+    col_params->group.device_type = DEVICE_CPU;
+    col_params->group.num_tasks = 1;
+    for (const string& device_name : device_names_) {
+      col_params->group.device_names.push_back(device_name);
+      col_params->group.task_names.push_back(kTaskName);
+      col_params->task.is_local.push_back(true);
+    }
+    col_params->instance.type = REDUCTION_COLLECTIVE;
+    col_params->instance.instance_key = instance_key;
+    col_params->instance.data_type = DT_FLOAT;
+    col_params->instance.shape = TensorShape({len});
+    col_params->instance.impl_details.collective_name = "TestSumReduce";
+    col_params->default_rank = rank;
+    col_params->merge_op = merge_op.get();
+    col_params->final_op = final_op.get();
+
+    Tensor input(DT_FLOAT, TensorShape({len}));
+    for (int i = 0; i < len; ++i) {
+      input.flat<float>()(i) = rank * 1000 + instance_key * 10 + i;
+    }
+
+    // Prepare an OpKernelContext.
+    OpKernelContext::Params op_params;
+    op_params.step_id = kStepId;
+    op_params.device = device;
+    op_params.cancellation_manager = &cancellation_manager_;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    inputs.push_back(TensorValue(&input));
+    op_params.inputs = &inputs;
+    gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+        {AllocatorAttributes()});
+    op_params.input_alloc_attrs = &input_aa;
+    DeviceContext* dev_ctx = new DeviceContext;
+    op_params.op_device_context = dev_ctx;
+    AllocatorAttributes generic_alloc_attr;
+    op_params.output_attr_array = &generic_alloc_attr;
+    op_params.op_kernel = merge_op.get();
+    OpKernelContext ctx(&op_params, 1);
+    Tensor* output = nullptr;
+    TF_CHECK_OK(ctx.allocate_output(0, input.shape(), &output));
+
+    Notification note;
+    Status status;
+    col_exec_->ExecuteAsync(&ctx, col_params,
+                            strings::StrCat(instance_key, ":0:0"),
+                            [&note, &status](const Status& s) {
+                              status = s;
+                              note.Notify();
+                            });
+    note.WaitForNotification();
+    *result = *output;
+    dev_ctx->Unref();
+    return status;
+  }
+
+  // Runs "num_reductions" reductions of different lengths concurrently on
+  // every device, and checks their results.
+  void RunReductions(int num_reductions) {
+    const int num_devices = device_names_.size();
+    std::vector<Tensor> results(num_devices * num_reductions);
+    std::vector<Status> statuses(num_devices * num_reductions);
+    BlockingCounter counter(num_devices * num_reductions);
+    for (int rank = 0; rank < num_devices; ++rank) {
+      for (int r = 0; r < num_reductions; ++r) {
+        const int idx = rank * num_reductions + r;
+        SchedClosure([this, rank, r, idx, &results, &statuses, &counter] {
+          statuses[idx] = DoReduce(rank, r, kLen + r, &results[idx]);
+          counter.DecrementCount();
+        });
+      }
+    }
+    counter.Wait();
+    for (int rank = 0; rank < num_devices; ++rank) {
+      for (int r = 0; r < num_reductions; ++r) {
+        const int idx = rank * num_reductions + r;
+        TF_ASSERT_OK(statuses[idx]);
+        ASSERT_EQ(kLen + r, results[idx].NumElements());
+        for (int i = 0; i < kLen + r; ++i) {
+          float expected = 0;
+          for (int peer = 0; peer < num_devices; ++peer) {
+            expected += peer * 1000 + r * 10 + i;
+          }
+          EXPECT_EQ(expected, results[idx].flat<float>()(i))
+              << "rank " << rank << " reduction " << r << " index " << i;
+        }
+      }
+    }
+  }
+
+  static constexpr int kLen = 16;
+  static constexpr char kTaskName[] = "/job:localhost/replica:0/task:0";
+
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  std::vector<string> device_names_;
+  string gpu_ring_order_;
+  CancellationManager cancellation_manager_;
+};
+
+constexpr int BaseCollectiveExecutorFusionTest::kLen;
+constexpr char BaseCollectiveExecutorFusionTest::kTaskName[];
+
+TEST_F(BaseCollectiveExecutorFusionTest, NoFusionByDefault) {
+  Init(/*num_devices=*/3, CollectiveFusionOptions());
+  RunReductions(/*num_reductions=*/4);
+  EXPECT_EQ(3 * 4, num_collective_runs);
+}
+
+TEST_F(BaseCollectiveExecutorFusionTest, FusesUpToThreshold) {
+  CollectiveFusionOptions fusion_options;
+  // The four reductions are 16, 17, 18 and 19 floats long, so the bucket is
+  // full when the last one is issued.
+  fusion_options.threshold_bytes = (16 + 17 + 18 + 19) * sizeof(float);
+  fusion_options.window_us = 60 * 1000 * 1000;
+  Init(/*num_devices=*/3, fusion_options);
+  RunReductions(/*num_reductions=*/4);
+  EXPECT_EQ(3, num_collective_runs);
+}
+
+TEST_F(BaseCollectiveExecutorFusionTest, FlushesAfterWindow) {
+  CollectiveFusionOptions fusion_options;
+  fusion_options.threshold_bytes = 1 << 20;
+  fusion_options.window_us = 1000;
+  Init(/*num_devices=*/4, fusion_options);
+  // The bucket boundaries depend on timing, only the results are checked.
+  RunReductions(/*num_reductions=*/5);
+}
+
+TEST_F(BaseCollectiveExecutorFusionTest, LargeReductionsAreNotFused) {
+  CollectiveFusionOptions fusion_options;
+  fusion_options.threshold_bytes = 4;
+  fusion_options.window_us = 60 * 1000 * 1000;
+  Init(/*num_devices=*/2, fusion_options);
+  RunReductions(/*num_reductions=*/3);
+  EXPECT_EQ(2 * 3, num_collective_runs);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <atomic>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -35,11 +37,189 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr int64 BFCAllocator::kDecommittedAllocationId;
 constexpr uint64 BFCAllocator::kMemDebugHistorySize;
+constexpr size_t BFCAllocator::kMaxCachedChunkSize;
+constexpr size_t BFCAllocator::kChunkCacheShardCapacity;
+
+// Front-end cache of small chunks that lets threads reuse recently freed
+// chunks without taking BFCAllocator::lock_.
+//
+// Chunks held by the cache stay in use as far as the bins and stats_ are
+// concerned.  Free lists are sharded by thread: a chunk is cached in the shard
+// of the thread that frees it and handed out again to threads of that shard.
+// Since the fast paths cannot look at Chunk metadata, the size of every small
+// chunk handed out by the bins is also recorded in an index sharded by
+// address.
+//
+// BFCAllocator::lock_ may be held while acquiring a shard mutex, but never the
+// other way around.
+class BFCAllocator::ChunkCache {
+ public:
+  explicit ChunkCache(int num_shards)
+      : num_shards_(num_shards),
+        cache_shards_(new CacheShard[num_shards]),
+        index_shards_(new IndexShard[num_shards]) {}
+
+  // Records that the bins handed out the chunk at 'ptr', of 'size' bytes, for
+  // a request of 'requested_size' bytes.
+  void Register(const void* ptr, size_t size, size_t requested_size) {
+    DCHECK_LE(size, kMaxCachedChunkSize);
+    IndexShard* index = IndexShardFor(ptr);
+    mutex_lock l(index->mu);
+    index->chunks[ptr] = {size, requested_size};
+  }
+
+  // Tries to cache the chunk at 'ptr', which is being deallocated.  Returns
+  // false if the chunk was not registered or the calling thread's shard is
+  // full, in which case the chunk is unregistered and has to be freed into the
+  // bins by the caller.
+  bool Insert(void* ptr) {
+    IndexShard* index = IndexShardFor(ptr);
+    size_t size;
+    {
+      mutex_lock l(index->mu);
+      auto it = index->chunks.find(ptr);
+      if (it == index->chunks.end()) return false;
+      size = it->second.size;
+    }
+    CacheShard* shard = CacheShardForCurrentThread();
+    {
+      mutex_lock l(shard->mu);
+      if (shard->cached_bytes + size <= kChunkCacheShardCapacity) {
+        shard->free_lists[SizeClass(size)].push_back(ptr);
+        shard->cached_bytes += size;
+        cached_bytes_.fetch_add(size, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    mutex_lock l(index->mu);
+    index->chunks.erase(ptr);
+    return false;
+  }
+
+  // Returns a cached chunk of exactly 'rounded_bytes' bytes for a request of
+  // 'num_bytes' bytes, or nullptr if the calling thread's shard has none.
+  void* Remove(size_t rounded_bytes, size_t num_bytes) {
+    DCHECK_LE(rounded_bytes, kMaxCachedChunkSize);
+    CacheShard* shard = CacheShardForCurrentThread();
+    void* ptr;
+    {
+      mutex_lock l(shard->mu);
+      std::vector<void*>& free_list =
+          shard->free_lists[SizeClass(rounded_bytes)];
+      if (free_list.empty()) return nullptr;
+      ptr = free_list.back();
+      free_list.pop_back();
+      shard->cached_bytes -= rounded_bytes;
+    }
+    cached_bytes_.fetch_sub(rounded_bytes, std::memory_order_relaxed);
+    num_hits_.fetch_add(1, std::memory_order_relaxed);
+    IndexShard* index = IndexShardFor(ptr);
+    mutex_lock l(index->mu);
+    index->chunks[ptr].requested_size = num_bytes;
+    return ptr;
+  }
+
+  // Returns true and sets '*requested_size' if 'ptr' is a registered chunk.
+  bool RequestedSize(const void* ptr, size_t* requested_size) {
+    IndexShard* index = IndexShardFor(ptr);
+    mutex_lock l(index->mu);
+    auto it = index->chunks.find(ptr);
+    if (it == index->chunks.end()) return false;
+    *requested_size = it->second.requested_size;
+    return true;
+  }
+
+  // Unregisters every cached chunk and appends it to 'ptrs'.
+  void TakeAll(std::vector<void*>* ptrs) {
+    const size_t first = ptrs->size();
+    for (int i = 0; i < num_shards_; ++i) {
+      CacheShard* shard = &cache_shards_[i];
+      mutex_lock l(shard->mu);
+      for (std::vector<void*>& free_list : shard->free_lists) {
+        ptrs->insert(ptrs->end(), free_list.begin(), free_list.end());
+        free_list.clear();
+      }
+      cached_bytes_.fetch_sub(shard->cached_bytes, std::memory_order_relaxed);
+      shard->cached_bytes = 0;
+    }
+    for (size_t i = first; i < ptrs->size(); ++i) {
+      IndexShard* index = IndexShardFor((*ptrs)[i]);
+      mutex_lock l(index->mu);
+      index->chunks.erase((*ptrs)[i]);
+    }
+  }
+
+  // Inserts the address of every cached chunk into 'ptrs'.
+  void CollectCached(absl::flat_hash_set<const void*>* ptrs) {
+    for (int i = 0; i < num_shards_; ++i) {
+      CacheShard* shard = &cache_shards_[i];
+      mutex_lock l(shard->mu);
+      for (const std::vector<void*>& free_list : shard->free_lists) {
+        ptrs->insert(free_list.begin(), free_list.end());
+      }
+    }
+  }
+
+  int64 cached_bytes() const {
+    return cached_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // Number of allocations served by the cache since the last ClearHits().
+  int64 num_hits() const { return num_hits_.load(std::memory_order_relaxed); }
+  void ClearHits() { num_hits_.store(0, std::memory_order_relaxed); }
+
+ private:
+  // One free list per multiple of kMinAllocationSize up to
+  // kMaxCachedChunkSize.
+  static constexpr int kNumSizeClasses =
+      kMaxCachedChunkSize / kMinAllocationSize;
+  static int SizeClass(size_t size) {
+    DCHECK_EQ(size % kMinAllocationSize, 0);
+    return static_cast<int>(size / kMinAllocationSize) - 1;
+  }
+
+  struct CacheShard {
+    mutex mu;
+    std::vector<void*> free_lists[kNumSizeClasses] TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+  };
+
+  struct IndexEntry {
+    size_t size;
+    size_t requested_size;
+  };
+
+  struct IndexShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, IndexEntry> chunks TF_GUARDED_BY(mu);
+  };
+
+  CacheShard* CacheShardForCurrentThread() {
+    static std::atomic<int> next_thread_index{0};
+    static thread_local int thread_index =
+        next_thread_index.fetch_add(1, std::memory_order_relaxed);
+    return &cache_shards_[thread_index % num_shards_];
+  }
+
+  IndexShard* IndexShardFor(const void* ptr) {
+    const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(ptr);
+    return &index_shards_[(p >> kMinAllocationBits) % num_shards_];
+  }
+
+  const int num_shards_;
+  std::unique_ptr<CacheShard[]> cache_shards_;
+  std::unique_ptr<IndexShard[]> index_shards_;
+  std::atomic<int64> cached_bytes_{0};
+  std::atomic<int64> num_hits_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ChunkCache);
+};
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
-                           bool garbage_collection)
+                           bool garbage_collection, bool enable_chunk_cache)
     : garbage_collection_(garbage_collection),
       coalesce_regions_(sub_allocator->SupportsCoalescing()),
       sub_allocator_(sub_allocator),
@@ -77,6 +257,12 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (enable_chunk_cache) {
+    const int num_shards = std::min(64, std::max(1, port::MaxParallelism()));
+    VLOG(1) << "Enabling chunk cache with " << num_shards << " shards";
+    chunk_cache_.reset(new ChunkCache(num_shards));
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -308,9 +494,12 @@ bool BFCAllocator::DeallocateFreeRegions(size_t rounded_bytes)
   for (const AllocationRegion& region : region_manager_.regions()) {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     bool any_use = false;
+    size_t region_decommitted_bytes = 0;
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
+      if (c->decommitted()) {
+        region_decommitted_bytes += c->size;
+      } else if (c->in_use()) {
         any_use = true;
         break;
       }
@@ -320,7 +509,7 @@ bool BFCAllocator::DeallocateFreeRegions(size_t rounded_bytes)
     if (!any_use) {
       VLOG(2) << "Found free region with ptr = " << region.ptr();
       free_region_ptrs.insert(region.ptr());
-      total_free_bytes += region.memory_size();
+      total_free_bytes += region.memory_size() - region_decommitted_bytes;
     }
   }
 
@@ -369,23 +558,104 @@ void BFCAllocator::DeallocateRegions(
     VLOG(2) << "Deallocate region with ptr = " << it->ptr();
     // Remove all chunk registrations from Bins.
     ChunkHandle h = region_manager_.get_handle(it->ptr());
+    size_t region_decommitted_bytes = 0;
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
       if (c->bin_num != kInvalidBinNum) {
         RemoveFreeChunkFromBin(h);
       }
+      if (c->decommitted()) {
+        region_decommitted_bytes += c->size;
+      }
       auto h_to_delete = h;
       h = c->next;
       DeleteChunk(h_to_delete);
     }
 
-    // Deallocate the memory.
+    // Deallocate the memory.  Decommitted chunks were already freed.
     sub_allocator_->Free(it->ptr(), it->memory_size());
-    total_region_allocated_bytes_ -= it->memory_size();
+    total_region_allocated_bytes_ -=
+        it->memory_size() - region_decommitted_bytes;
+    decommitted_bytes_ -= region_decommitted_bytes;
     it = region_manager_.RemoveAllocationRegion(it);
   }
 }
 
+bool BFCAllocator::DecommitFreeChunks(size_t rounded_bytes) {
+  const size_t page_size = sub_allocator_->PartialFreeGranularity();
+  if (page_size == 0) {
+    return false;
+  }
+  DCHECK_EQ(page_size & (page_size - 1), 0);
+
+  // Collect the whole pages covered by free chunks.  Chunks that are not yet
+  // safe to reuse under the timing counter are left alone.
+  struct PageRange {
+    ChunkHandle h;
+    uintptr_t begin;
+    uintptr_t end;
+  };
+  std::vector<PageRange> page_ranges;
+  size_t total_page_bytes = 0;
+  for (BinNum b = BinNumForSize(page_size); b < kNumBins; b++) {
+    for (ChunkHandle h : BinFromIndex(b)->free_chunks) {
+      const Chunk* c = ChunkFromHandle(h);
+      if (c->freed_at_count > 0) continue;
+      const uintptr_t chunk_begin = reinterpret_cast<uintptr_t>(c->ptr);
+      const uintptr_t begin = (chunk_begin + page_size - 1) & ~(page_size - 1);
+      const uintptr_t end = (chunk_begin + c->size) & ~(page_size - 1);
+      if (end <= begin) continue;
+      page_ranges.push_back({h, begin, end});
+      total_page_bytes += end - begin;
+    }
+  }
+
+  if (total_page_bytes == 0) {
+    return false;
+  }
+
+  // Rough estimation to check whether decommitting can help.
+  size_t available_bytes =
+      memory_limit_ - total_region_allocated_bytes_ + total_page_bytes;
+  if (rounded_bytes > available_bytes) {
+    return false;
+  }
+
+  LOG(WARNING) << "Allocator (" << Name() << ") is fragmented: decommitting "
+               << strings::HumanReadableNumBytes(total_page_bytes)
+               << " in " << page_ranges.size() << " free chunks so that a "
+               << strings::HumanReadableNumBytes(rounded_bytes)
+               << " allocation can be backed by a new region.";
+
+  for (const PageRange& range : page_ranges) {
+    ChunkHandle h = range.h;
+    RemoveFreeChunkFromBin(h);
+    // Split off the parts of the chunk outside the page range; SplitChunk()
+    // returns the tail to the bins.
+    const uintptr_t chunk_begin =
+        reinterpret_cast<uintptr_t>(ChunkFromHandle(h)->ptr);
+    if (range.begin > chunk_begin) {
+      SplitChunk(h, range.begin - chunk_begin);
+      InsertFreeChunkIntoBin(h);
+      h = ChunkFromHandle(h)->next;
+      RemoveFreeChunkFromBin(h);
+    }
+    if (ChunkFromHandle(h)->size > range.end - range.begin) {
+      SplitChunk(h, range.end - range.begin);
+    }
+
+    Chunk* c = ChunkFromHandle(h);
+    c->allocation_id = kDecommittedAllocationId;
+    c->requested_size = 0;
+    sub_allocator_->Free(c->ptr, c->size);
+    total_region_allocated_bytes_ -= c->size;
+    decommitted_bytes_ += c->size;
+  }
+  VLOG(1) << "Total decommitted bytes: "
+          << strings::HumanReadableNumBytes(decommitted_bytes_);
+  return true;
+}
+
 void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
                                         size_t num_bytes,
                                         bool dump_log_on_failure,
@@ -399,6 +669,13 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (chunk_cache_ != nullptr && rounded_bytes <= kMaxCachedChunkSize) {
+    void* ptr = chunk_cache_->Remove(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
@@ -436,6 +713,16 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Chunks held by the front-end cache are only reusable for allocations of
+  // their exact size.  Return them to the bins so that they can be coalesced.
+  if (chunk_cache_ != nullptr && FlushChunkCacheLocked()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // Reaching this point means that no chunks can satisfy the request. Also,
   // the unallocated bytes cannot satisfy the request. Before giving up, let's
   // try deallocating free regions so that suballocator can combine them with
@@ -449,6 +736,17 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Free regions alone were not enough.  If the sub-allocator can release
+  // parts of a region, move the memory under free chunks to a new region.
+  if (DecommitFreeChunks(rounded_bytes) &&
+      Extend(unused_alignment, rounded_bytes)) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
@@ -480,7 +778,8 @@ int64 BFCAllocator::LargestFreeChunk() {
 }
 
 double BFCAllocator::GetFragmentation() {
-  int64 bytes_available = total_region_allocated_bytes_ - stats_.bytes_in_use;
+  int64 bytes_available =
+      total_region_allocated_bytes_ - (stats_.bytes_in_use - CachedBytes());
   DCHECK_GT(bytes_available, 0);
   return static_cast<double>(bytes_available - LargestFreeChunk()) /
          bytes_available;
@@ -586,6 +885,10 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
           size_history_[slot] = stats_.bytes_in_use;
         }
 
+        if (chunk_cache_ != nullptr && chunk->size <= kMaxCachedChunkSize) {
+          chunk_cache_->Register(chunk->ptr, chunk->size, num_bytes);
+        }
+
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
           LOG(INFO) << "A: " << RenderOccupancy();
@@ -639,7 +942,11 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
-  DeallocateRawInternal(ptr);
+  if (ptr == nullptr || chunk_cache_ == nullptr || !chunk_cache_->Insert(ptr)) {
+    DeallocateRawInternal(ptr);
+  }
+  // A cached chunk can satisfy a pending allocation as well, so wake up any
+  // waiters in either case.
   retry_helper_.NotifyDealloc();
 }
 
@@ -659,6 +966,18 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   int64 req_bytes = chunk->requested_size;
   int64 alloc_bytes = chunk->size;
 
+  FreeChunkLocked(h);
+
+  // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
+  // correct aggregation stats (bytes_in_use, fragmentation).
+  AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes);
+
+  if (VLOG_IS_ON(4)) {
+    LOG(INFO) << "F: " << RenderOccupancy();
+  }
+}
+
+void BFCAllocator::FreeChunkLocked(ChunkHandle h) {
   MarkFree(h);
 
   // Consider coalescing it.
@@ -668,14 +987,35 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   } else {
     InsertFreeChunkIntoBin(TryToCoalesce(h, false));
   }
+}
 
-  // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
-  // correct aggregation stats (bytes_in_use, fragmentation).
-  AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes);
+bool BFCAllocator::FlushChunkCacheLocked() {
+  std::vector<void*> ptrs;
+  chunk_cache_->TakeAll(&ptrs);
+  VLOG(1) << "Returning " << ptrs.size() << " cached chunks to the bins of "
+          << Name();
+  for (void* ptr : ptrs) {
+    ChunkHandle h = region_manager_.get_handle(ptr);
+    CHECK(h != kInvalidChunkHandle);
+    FreeChunkLocked(h);
+  }
+  return !ptrs.empty();
+}
 
-  if (VLOG_IS_ON(4)) {
-    LOG(INFO) << "F: " << RenderOccupancy();
+int64 BFCAllocator::CachedBytes() const {
+  return chunk_cache_ != nullptr ? chunk_cache_->cached_bytes() : 0;
+}
+
+void BFCAllocator::SetTimingCounter(SharedCounter* sc) {
+  mutex_lock l(lock_);
+  // Timestamped chunks must go through the bins, so stop caching.  Chunks that
+  // are already cached are returned before `timing_counter_` is set, since
+  // they were freed without a timestamp.
+  if (chunk_cache_ != nullptr) {
+    FlushChunkCacheLocked();
+    chunk_cache_.reset();
   }
+  timing_counter_ = sc;
 }
 
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
@@ -890,6 +1230,13 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  size_t requested_size;
+  if (chunk_cache_ != nullptr &&
+      chunk_cache_->RequestedSize(ptr, &requested_size)) {
+    // The chunk may have been reused from the cache, in which case its
+    // metadata still describes the first allocation.
+    return requested_size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -967,7 +1314,7 @@ string BFCAllocator::RenderOccupancy() {
     // Then render each chunk left to right.
     while (h != kInvalidChunkHandle) {
       Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
+      if (c->in_use() && !c->decommitted()) {
         // Render the wasted space
         size_t wasted = c->size - c->requested_size;
         if (wasted > 0) {
@@ -993,12 +1340,14 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
   for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
     Bin* b = BinFromIndex(bin_num);
     const BinDebugInfo& bin_info = bin_infos[bin_num];
-    CHECK_EQ(b->free_chunks.size(),
-             bin_info.total_chunks_in_bin - bin_info.total_chunks_in_use);
+    CHECK_EQ(b->free_chunks.size(), bin_info.total_chunks_in_bin -
+                                         bin_info.total_chunks_in_use -
+                                         bin_info.total_chunks_in_cache);
 
     LOG(INFO) << "Bin (" << b->bin_size
               << "): \tTotal Chunks: " << bin_info.total_chunks_in_bin
-              << ", Chunks in use: " << bin_info.total_chunks_in_use << ". "
+              << ", Chunks in use: " << bin_info.total_chunks_in_use
+              << ", Chunks in cache: " << bin_info.total_chunks_in_cache << ". "
               << strings::HumanReadableNumBytes(bin_info.total_bytes_in_bin)
               << " allocated for chunks. "
               << strings::HumanReadableNumBytes(bin_info.total_bytes_in_use)
@@ -1029,11 +1378,12 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
-      if (c->in_use()) {
+      if (c->in_use() && !c->decommitted()) {
         in_use_by_size[c->size]++;
       }
       string buf = strings::StrCat(
-          (c->in_use() ? "InUse" : "Free "), " at ",
+          (c->decommitted() ? "Decommitted" : c->in_use() ? "InUse" : "Free "),
+          " at ",
           strings::Hex(reinterpret_cast<uint64>(c->ptr)), " of size ", c->size);
       if (ShouldRecordOpName()) {
         strings::StrAppend(&buf, " by op ", c->GetDebugOpName(),
@@ -1063,7 +1413,8 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
             << " memory_limit_: " << memory_limit_ << " available bytes: "
             << (memory_limit_ - total_region_allocated_bytes_)
             << " curr_region_allocation_bytes_: "
-            << curr_region_allocation_bytes_;
+            << curr_region_allocation_bytes_
+            << " decommitted_bytes_: " << decommitted_bytes_;
   LOG(INFO) << "Stats: \n" << stats_.DebugString();
 }
 
@@ -1098,8 +1449,9 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
   // Record the general stats
   MemAllocatorStats* mas = md.mutable_stats();
-  mas->set_num_allocs(stats_.num_allocs);
-  mas->set_bytes_in_use(stats_.bytes_in_use);
+  const AllocatorStats stats = StatsLocked();
+  mas->set_num_allocs(stats.num_allocs);
+  mas->set_bytes_in_use(stats.bytes_in_use);
   mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
   mas->set_largest_alloc_size(stats_.largest_alloc_size);
 
@@ -1108,8 +1460,9 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
     Bin* b = BinFromIndex(bin_num);
     const BinDebugInfo& bin_info = bin_infos[bin_num];
-    DCHECK_EQ(b->free_chunks.size(),
-              bin_info.total_chunks_in_bin - bin_info.total_chunks_in_use);
+    DCHECK_EQ(b->free_chunks.size(), bin_info.total_chunks_in_bin -
+                                          bin_info.total_chunks_in_use -
+                                          bin_info.total_chunks_in_cache);
     BinSummary* bs = md.add_bin_summary();
     bs->set_bin(bin_num);
     bs->set_total_bytes_in_use(bin_info.total_bytes_in_use);
@@ -1119,12 +1472,16 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   }
 
   // Record state of every defined Chunk.
+  absl::flat_hash_set<const void*> cached_ptrs;
+  if (chunk_cache_ != nullptr) {
+    chunk_cache_->CollectCached(&cached_ptrs);
+  }
   for (const auto& region : region_manager_.regions()) {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
       MemChunk* mc = md.add_chunk();
-      mc->set_in_use(c->in_use());
+      mc->set_in_use(c->in_use() && !cached_ptrs.contains(c->ptr));
       mc->set_address(reinterpret_cast<uint64>(c->ptr));
       mc->set_size(c->size);
       mc->set_requested_size(c->requested_size);
@@ -1155,11 +1512,31 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = StatsLocked();
+  stats.largest_free_block_bytes = LargestFreeChunk();
+  if (total_region_allocated_bytes_ >
+      static_cast<size_t>(stats_.bytes_in_use - CachedBytes())) {
+    stats.fragmentation = GetFragmentation();
+  }
+  return stats;
+}
+
+AllocatorStats BFCAllocator::StatsLocked() const {
+  AllocatorStats stats = stats_;
+  if (chunk_cache_ != nullptr) {
+    // Cached chunks are in use as far as stats_ is concerned, and allocations
+    // served by the cache never reach the bins.
+    stats.bytes_in_use -= chunk_cache_->cached_bytes();
+    stats.num_allocs += chunk_cache_->num_hits();
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  if (chunk_cache_ != nullptr) {
+    chunk_cache_->ClearHits();
+  }
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
@@ -1168,6 +1545,10 @@ void BFCAllocator::ClearStats() {
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
 BFCAllocator::get_bin_debug_info() {
   std::array<BinDebugInfo, kNumBins> bin_infos;
+  absl::flat_hash_set<const void*> cached_ptrs;
+  if (chunk_cache_ != nullptr) {
+    chunk_cache_->CollectCached(&cached_ptrs);
+  }
   for (const auto& region : region_manager_.regions()) {
     ChunkHandle h = region_manager_.get_handle(region.ptr());
     while (h != kInvalidChunkHandle) {
@@ -1176,7 +1557,12 @@ BFCAllocator::get_bin_debug_info() {
       BinDebugInfo& bin_info = bin_infos[bin_num];
       bin_info.total_bytes_in_bin += c->size;
       bin_info.total_chunks_in_bin++;
-      if (c->in_use()) {
+      if (c->decommitted()) {
+        // Not backed by memory.
+      } else if (c->in_use() && cached_ptrs.contains(c->ptr)) {
+        bin_info.total_bytes_in_cache += c->size;
+        bin_info.total_chunks_in_cache++;
+      } else if (c->in_use()) {
         bin_info.total_bytes_in_use += c->size;
         bin_info.total_requested_bytes_in_use += c->requested_size;
         bin_info.total_chunks_in_use++;
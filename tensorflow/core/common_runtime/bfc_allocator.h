@@ -49,9 +49,16 @@ class MemoryDump;
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
+  //
+  // If enable_chunk_cache is true, small chunks (up to
+  // kMaxCachedChunkSize bytes) are freed into a sharded front-end cache and
+  // reused from there without taking the allocator-wide lock.  Cached chunks
+  // are returned to the bins when a shard overflows or when an allocation
+  // cannot otherwise be satisfied.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name,
-               bool garbage_collection = false);
+               bool garbage_collection = false,
+               bool enable_chunk_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -77,7 +84,11 @@ class BFCAllocator : public Allocator {
 
   void ClearStats() override;
 
-  void SetTimingCounter(SharedCounter* sc) { timing_counter_ = sc; }
+  // Chunks freed while a timing counter is set are not reusable until the
+  // counter passes the safe frontier, which the front-end chunk cache cannot
+  // honor, so this also disables the chunk cache.  Must be called before the
+  // allocator is used.
+  void SetTimingCounter(SharedCounter* sc);
 
   void SetSafeFrontier(uint64 count) override;
 
@@ -85,8 +96,16 @@ class BFCAllocator : public Allocator {
 
   MemoryDump RecordMemoryMap();
 
+  // Largest chunk size that is kept in the front-end chunk cache.  This
+  // covers the four lowest bins.
+  static constexpr size_t kMaxCachedChunkSize = 4 << 10;
+
+  // Maximum number of bytes held by a single chunk cache shard.
+  static constexpr size_t kChunkCacheShardCapacity = 256 << 10;
+
  private:
   struct Bin;
+  class ChunkCache;
 
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure,
@@ -98,6 +117,19 @@ class BFCAllocator : public Allocator {
 
   void DeallocateRawInternal(void* ptr);
 
+  // Returns every chunk held by chunk_cache_ to the bins.  Returns true if
+  // any chunk was returned.
+  bool FlushChunkCacheLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the number of bytes held by chunk_cache_.  These bytes are
+  // counted in stats_.bytes_in_use but are free from the client's point of
+  // view.
+  int64 CachedBytes() const;
+
+  // Returns stats_ adjusted for the chunks and allocations handled by
+  // chunk_cache_.
+  AllocatorStats StatsLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
   //
@@ -137,6 +169,16 @@ class BFCAllocator : public Allocator {
 
   typedef int BinNum;
   static constexpr int kInvalidBinNum = -1;
+
+  // allocation_id of a chunk whose backing memory was given back to the
+  // sub-allocator by DecommitFreeChunks().  Such a chunk counts as in use so
+  // that it is never handed out nor merged with its neighbors.
+  static constexpr int64 kDecommittedAllocationId = -2;
+
+  // Marks the chunk 'h' free and returns it to the bins, coalescing it with
+  // its neighbors when possible.
+  void FreeChunkLocked(ChunkHandle h) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // The following means that the largest bin'd chunk size is 256 << 21 = 512MB.
   static constexpr int kNumBins = 21;
 
@@ -188,6 +230,10 @@ class BFCAllocator : public Allocator {
 
     bool in_use() const { return allocation_id != -1; }
 
+    bool decommitted() const {
+      return allocation_id == kDecommittedAllocationId;
+    }
+
     // optional debugging info
     const char* op_name = nullptr;
     uint64 step_id = 0;
@@ -201,6 +247,8 @@ class BFCAllocator : public Allocator {
       // a special op name "UNUSED";
       if (!in_use())
         return "UNUSED";
+      else if (decommitted())
+        return "DECOMMITTED";
       else if (op_name)
         return op_name;
       else
@@ -449,6 +497,15 @@ class BFCAllocator : public Allocator {
   // found and freed; false otherwise.
   bool DeallocateFreeRegions(size_t rounded_bytes);
 
+  // Gives the page-aligned parts of free chunks back to the sub-allocator, if
+  // it supports partial frees, so that their memory can back a new region.
+  // This compacts the heap without moving live allocations: the decommitted
+  // chunks stay behind as address space holes that are never reused.  Used
+  // when OOM happens even though enough bytes are free.  Returns true if any
+  // memory was decommitted.
+  bool DecommitFreeChunks(size_t rounded_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Helper function to deallocate regions.
   void DeallocateRegions(const absl::flat_hash_set<void*>& region_ptrs)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
@@ -511,6 +568,10 @@ class BFCAllocator : public Allocator {
     size_t total_requested_bytes_in_use = 0;
     size_t total_chunks_in_use = 0;
     size_t total_chunks_in_bin = 0;
+    // Chunks held by the front-end chunk cache.  They are counted in
+    // total_*_in_bin but not in total_*_in_use.
+    size_t total_bytes_in_cache = 0;
+    size_t total_chunks_in_cache = 0;
   };
 
   // Computes and returns a BinDebugInfo for each Bin.
@@ -566,6 +627,10 @@ class BFCAllocator : public Allocator {
   // The total number of allocated bytes by the allocator.
   size_t total_region_allocated_bytes_ = 0;
 
+  // The number of bytes in decommitted chunks.  These are part of the
+  // regions but not of total_region_allocated_bytes_.
+  size_t decommitted_bytes_ = 0;
+
   // An indicator that expansion of a region has hit the limits
   // of the available memory.
   bool started_backpedal_ = false;
@@ -588,6 +653,9 @@ class BFCAllocator : public Allocator {
 
   std::atomic<uint64> safe_frontier_ = {0};
 
+  // Optional front-end cache of small free chunks.  Null if disabled.
+  std::unique_ptr<ChunkCache> chunk_cache_;
+
   // Structures mutable after construction
   mutable mutex lock_;
   RegionManager region_manager_ TF_GUARDED_BY(lock_);
@@ -17,9 +17,14 @@ limitations under the License.
 #include <algorithm>
 #include <random>
 
+#include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
 
 namespace tensorflow {
 
@@ -45,6 +50,258 @@ class FakeSubAllocator : public SubAllocator {
   int64 alloc_counter_;
 };
 
+// A SubAllocator backed by host memory, for tests that need real addresses.
+class HostSubAllocator : public SubAllocator {
+ public:
+  HostSubAllocator() : SubAllocator({}, {}) {}
+  ~HostSubAllocator() override {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    *bytes_received = num_bytes;
+    return port::AlignedMalloc(num_bytes, Allocator::kAllocatorAlignment);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+
+  bool SupportsCoalescing() const override { return false; }
+};
+
+// A SubAllocator that hands out consecutive pages of a host buffer and, like
+// a GPU virtual memory allocator, can free any page-aligned part of them.
+// Freed addresses are never handed out again.
+class PagedSubAllocator : public SubAllocator {
+ public:
+  static constexpr size_t kPageSize = 64 << 10;
+
+  explicit PagedSubAllocator(size_t address_space_size)
+      : SubAllocator({}, {}),
+        address_space_size_(address_space_size),
+        base_(static_cast<char*>(
+            port::AlignedMalloc(address_space_size, kPageSize))) {}
+  ~PagedSubAllocator() override { port::AlignedFree(base_); }
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    num_bytes = (num_bytes + kPageSize - 1) & ~(kPageSize - 1);
+    if (next_offset_ + num_bytes > address_space_size_) return nullptr;
+    void* ptr = base_ + next_offset_;
+    next_offset_ += num_bytes;
+    mapped_bytes_ += num_bytes;
+    *bytes_received = num_bytes;
+    return ptr;
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % kPageSize);
+    EXPECT_EQ(0, num_bytes % kPageSize);
+    mapped_bytes_ -= num_bytes;
+  }
+
+  bool SupportsCoalescing() const override { return true; }
+
+  size_t PartialFreeGranularity() const override { return kPageSize; }
+
+  size_t mapped_bytes() const { return mapped_bytes_; }
+  size_t next_offset() const { return next_offset_; }
+
+ private:
+  const size_t address_space_size_;
+  char* const base_;
+  size_t next_offset_ = 0;
+  size_t mapped_bytes_ = 0;
+};
+
+constexpr size_t PagedSubAllocator::kPageSize;
+
+BFCAllocator* NewCachingBFCAllocator(size_t total_memory) {
+  return new BFCAllocator(new HostSubAllocator, total_memory,
+                          /*allow_growth=*/false, "cpu_bfc",
+                          /*garbage_collection=*/false,
+                          /*enable_chunk_cache=*/true);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheReusesSmallChunks) {
+  std::unique_ptr<BFCAllocator> a(NewCachingBFCAllocator(1 << 20));
+
+  void* p1 = a->AllocateRaw(1, 1000);
+  ASSERT_NE(p1, nullptr);
+  a->DeallocateRaw(p1);
+
+  // 900 bytes round to the same 1KiB chunk, which comes back from the cache.
+  void* p2 = a->AllocateRaw(1, 900);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(900, a->RequestedSize(p2));
+  EXPECT_EQ(1024, a->AllocatedSize(p2));
+
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(1024, stats->bytes_in_use);
+
+  a->DeallocateRaw(p2);
+  stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheBypassedForLargeChunks) {
+  std::unique_ptr<BFCAllocator> a(NewCachingBFCAllocator(1 << 20));
+
+  void* p1 = a->AllocateRaw(1, BFCAllocator::kMaxCachedChunkSize * 2);
+  ASSERT_NE(p1, nullptr);
+  a->DeallocateRaw(p1);
+
+  // The freed chunk went back to the bins and is coalesced into the region.
+  void* p2 = a->AllocateRaw(1, 1 << 20);
+  EXPECT_NE(p2, nullptr);
+  a->DeallocateRaw(p2);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheInMemoryMap) {
+  std::unique_ptr<BFCAllocator> a(NewCachingBFCAllocator(1 << 20));
+
+  void* in_use = a->AllocateRaw(1, 1024);
+  void* cached = a->AllocateRaw(1, 1024);
+  a->DeallocateRaw(cached);
+
+  MemoryDump md = a->RecordMemoryMap();
+  EXPECT_EQ(1024, md.stats().bytes_in_use());
+  // 1KiB chunks live in bin 2.
+  const BinSummary& bs = md.bin_summary(2);
+  EXPECT_EQ(2, bs.total_chunks_in_bin());
+  EXPECT_EQ(1, bs.total_chunks_in_use());
+  EXPECT_EQ(1024, bs.total_bytes_in_use());
+  for (const MemChunk& mc : md.chunk()) {
+    if (mc.address() == reinterpret_cast<uint64>(in_use)) {
+      EXPECT_TRUE(mc.in_use());
+    } else {
+      EXPECT_FALSE(mc.in_use());
+    }
+  }
+  a->DeallocateRaw(in_use);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheFlushedUnderMemoryPressure) {
+  std::unique_ptr<BFCAllocator> a(NewCachingBFCAllocator(1 << 20));
+
+  // Fill the whole region with cacheable chunks and free them all.  Some of
+  // them stay in the cache, which fragments the region.
+  const size_t kChunkSize = BFCAllocator::kMaxCachedChunkSize;
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < (1 << 20) / kChunkSize; ++i) {
+    ptrs.push_back(a->AllocateRaw(1, kChunkSize));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+
+  // Serving the whole region requires returning the cached chunks.
+  AllocationAttributes attr;
+  attr.retry_on_failure = false;
+  void* p = a->AllocateRaw(1, 1 << 20, attr);
+  EXPECT_NE(p, nullptr);
+  a->DeallocateRaw(p);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheFlushedBySetTimingCounter) {
+  std::unique_ptr<BFCAllocator> a(NewCachingBFCAllocator(1 << 20));
+
+  void* p1 = a->AllocateRaw(1, 1024);
+  ASSERT_NE(p1, nullptr);
+  a->DeallocateRaw(p1);
+
+  // Enabling timestamps disables the cache, which must return the cached
+  // chunk to the bins instead of dropping it.
+  SharedCounter counter;
+  a->SetTimingCounter(&counter);
+  EXPECT_EQ(0, a->GetStats()->bytes_in_use);
+
+  AllocationAttributes attr;
+  attr.retry_on_failure = false;
+  void* p2 = a->AllocateRaw(1, 1 << 20, attr);
+  EXPECT_NE(p2, nullptr);
+  a->DeallocateRaw(p2);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheConcurrentAllocations) {
+  std::unique_ptr<BFCAllocator> a(NewCachingBFCAllocator(64 << 20));
+  {
+    thread::ThreadPool pool(Env::Default(), "bfc_test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&a, t]() {
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 1000; ++i) {
+          const size_t size = 256 * (1 + (i + t) % 20);
+          void* p = a->AllocateRaw(1, size);
+          ASSERT_NE(p, nullptr);
+          EXPECT_GE(a->AllocatedSize(p), size);
+          ptrs.push_back(p);
+          if (i % 3 == 0) {
+            a->DeallocateRaw(ptrs.front());
+            ptrs.erase(ptrs.begin());
+          }
+        }
+        for (void* p : ptrs) {
+          a->DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(8000, stats->num_allocs);
+}
+
+TEST(BFCAllocatorTest, DecommitFreeChunksCompactsHeap) {
+  constexpr size_t kPageSize = PagedSubAllocator::kPageSize;
+  constexpr size_t kMemoryLimit = 16 * kPageSize;
+  PagedSubAllocator* sub_allocator = new PagedSubAllocator(4 * kMemoryLimit);
+  BFCAllocator a(sub_allocator, kMemoryLimit, /*allow_growth=*/false,
+                 "paged_bfc");
+
+  // Fill the heap with pages, then free every other one: half of the memory
+  // is free but no two free pages are adjacent.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, kPageSize));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  for (int i = 0; i < 16; i += 2) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  EXPECT_EQ(kPageSize, stats->largest_free_block_bytes);
+  EXPECT_DOUBLE_EQ(7.0 / 8.0, stats->fragmentation);
+
+  // A four page allocation only fits if the free pages are decommitted and
+  // remapped behind the heap.
+  void* large = a.AllocateRaw(1, 4 * kPageSize);
+  ASSERT_NE(large, nullptr);
+  EXPECT_GE(static_cast<char*>(large),
+            static_cast<char*>(ptrs.back()) + kPageSize);
+  EXPECT_LE(sub_allocator->mapped_bytes(), kMemoryLimit);
+
+  // Live allocations did not move and the rest of the new region is usable.
+  for (int i = 1; i < 16; i += 2) {
+    EXPECT_EQ(kPageSize, a.AllocatedSize(ptrs[i]));
+  }
+  void* more = a.AllocateRaw(1, 4 * kPageSize);
+  ASSERT_NE(more, nullptr);
+  EXPECT_EQ(nullptr,
+            a.AllocateRaw(1, kPageSize, AllocationAttributes(
+                                            /*retry_on_failure=*/false,
+                                            /*allocation_will_be_logged=*/false,
+                                            /*freed_by_func=*/nullptr)));
+
+  a.DeallocateRaw(large);
+  a.DeallocateRaw(more);
+  for (int i = 1; i < 16; i += 2) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  EXPECT_EQ(0, a.GetStats()->bytes_in_use);
+}
+
 void BM_Allocator(::testing::benchmark::State& state) {
   constexpr int kAllocSize = 1 << 14;
   const int kLongLivedObjects = state.range(0);
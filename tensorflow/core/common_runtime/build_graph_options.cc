@@ -48,6 +48,13 @@ string BuildGraphOptions::DebugString() const {
       break;
   }
   strings::StrAppend(&rv, "\ncollective_order: ", collective_order_str);
+  if (!feed_shapes.empty()) {
+    strings::StrAppend(&rv, "\nFeed shapes: ");
+    for (const auto& feed_shape : feed_shapes) {
+      strings::StrAppend(&rv, feed_shape.first, feed_shape.second.DebugString(),
+                         ", ");
+    }
+  }
   return rv;
 }
 
@@ -35,7 +35,14 @@ CollectiveExecutorMgr::CollectiveExecutorMgr(
           config.gpu_options().experimental().collective_ring_order()),
       nccl_communicator_(std::move(nccl_communicator)),
       work_queue_(std::make_shared<UnboundedWorkQueue>(Env::Default(),
-                                                       "collective_ops")) {}
+                                                       "collective_ops")) {
+  fusion_options_.threshold_bytes =
+      config.experimental().collective_fusion_threshold_bytes();
+  if (config.experimental().collective_fusion_window_us() > 0) {
+    fusion_options_.window_us =
+        config.experimental().collective_fusion_window_us();
+  }
+}
 
 CollectiveExecutorMgr::~CollectiveExecutorMgr() {
   for (auto iter : executor_table_) {
@@ -63,7 +70,8 @@ CollectiveExecutor* CollectiveExecutorMgr::Create(int64 step_id) {
   CollectiveRemoteAccessLocal* rma =
       new CollectiveRemoteAccessLocal(dev_mgr_, dev_resolver_.get(), step_id);
   return new BaseCollectiveExecutor(this, rma, step_id, dev_mgr_,
-                                    &gpu_ring_order_, work_queue_);
+                                    &gpu_ring_order_, work_queue_,
+                                    fusion_options_);
 }
 
 void CollectiveExecutorMgr::Cleanup(int64 step_id) {
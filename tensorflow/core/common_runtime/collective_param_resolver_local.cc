@@ -678,6 +678,19 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  // A CPU reduction over several tasks with several devices each, uses the
+  // hierarchical implementation, which sends less data between tasks than a
+  // ring over all devices.
+  const string& hint = cp->instance.impl_details.communication_hint;
+  if (!use_nccl && cp->instance.type == REDUCTION_COLLECTIVE &&
+      (hint.empty() || hint == "auto") &&
+      cp->group.device_type == DEVICE_CPU && cp->group.num_tasks > 1 &&
+      cp->group.group_size > cp->group.num_tasks &&
+      CollectiveRegistry::LookupParamResolverInstance("HierarchicalReduce",
+                                                      &col_impl)
+          .ok()) {
+    cp->instance.impl_details.collective_name = "HierarchicalReduce";
+  }
   VLOG(1) << "AssignCollectiveType "
           << cp->instance.impl_details.collective_name;
 }
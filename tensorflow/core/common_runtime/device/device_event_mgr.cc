@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -28,6 +29,21 @@ namespace {
 //  - Should EventMgrs be shared between devices on a machine with multiple
 //  devices of the same type?
 static const int kNumThreads = 2;
+
+// Adaptive polling thresholds, see EventMgr::PollLoop().
+//
+// With at most this many events pending the polling loop busy-polls...
+static const size_t kBusyPollMaxPending = 4;
+// ...until it has gone this long without observing a completion.
+static const uint64 kBusyPollMaxUsecs = 200;
+// With at least this many events pending the polling loop waits for host
+// callbacks enqueued on the streams.
+static const size_t kHostCallbackMinPending = 64;
+// At most one host callback is enqueued per this many queued events.
+static const int kHostCallbackStride = 16;
+// Waiting for a host callback times out after this long, since events
+// recorded on other streams are not covered by the callback.
+static const int64 kHostCallbackWaitUsecs = 1000;
 }  // namespace
 
 namespace device_event_mgr {
@@ -95,7 +111,14 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      adaptive_polling_(gpu_options.experimental().adaptive_event_polling()),
       threadpool_(Env::Default(), "Device_Event_Manager", kNumThreads) {
+  callback_lag_histograms_[static_cast<int>(PollingMode::kBusyPoll)] =
+      metrics::GetDeviceEventCallbackLagHistogram("busy_poll");
+  callback_lag_histograms_[static_cast<int>(PollingMode::kSleep)] =
+      metrics::GetDeviceEventCallbackLagHistogram("sleep");
+  callback_lag_histograms_[static_cast<int>(PollingMode::kHostCallback)] =
+      metrics::GetDeviceEventCallbackLagHistogram("host_callback");
   device_event_mgr::InitThreadpoolLabels(&threadpool_);
   StartPollingLoop();
 }
@@ -103,6 +126,14 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
 EventMgr::~EventMgr() {
   StopPollingLoop();
 
+  // Host callbacks reference this object.
+  {
+    mutex_lock l(host_callback_mu_);
+    while (host_callbacks_in_flight_ > 0) {
+      host_callback_cv_.wait(l);
+    }
+  }
+
   // Events are owned by this object.
   for (auto& e : free_events_) {
     delete e;
@@ -132,6 +163,10 @@ void EventMgr::StopPollingLoop() {
       stop_polling_ = true;
       events_pending_.notify_all();
     }
+    {
+      mutex_lock l(host_callback_mu_);
+      host_callback_cv_.notify_all();
+    }
     polling_stopped_->WaitForNotification();
     polling_stopped_.reset(nullptr);
   }
@@ -141,31 +176,115 @@ void EventMgr::StopPollingLoop() {
 //
 // While one or more events is outstanding, poll for completed events.  When no
 // events are outstanding, we sleep until one is enqueued.
+//
+// By default the loop sleeps polling_active_delay_usecs_ between polls.  In
+// adaptive mode the wait depends on the number of pending events:
+//  - With only a few events pending, something on the host is likely waiting
+//    for them, so the loop busy-polls.  This is bounded to kBusyPollMaxUsecs
+//    without a completion, so that a long-running kernel does not keep a core
+//    spinning.
+//  - With a deep queue the device is far behind the host and sweeping the
+//    whole queue every few microseconds is wasted work, so the loop instead
+//    waits for host callbacks that QueueInUse() enqueues on the streams.
+//  - Otherwise, it sleeps as in the default mode.
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
+  uint64 busy_poll_since_usecs = 0;
   while (true) {
     bool events_still_pending;
+    PollingMode mode = PollingMode::kSleep;
     {
       mutex_lock l(mu_);
       if (stop_polling_) {
         break;
       }
-      if (used_events_.empty()) {
+      bool was_empty = used_events_.empty();
+      if (was_empty) {
         events_pending_.wait(l);
       }
       PollEvents(true, &to_free);
       events_still_pending = !used_events_.empty();
+      if (adaptive_polling_) {
+        const uint64 now_usecs = Env::Default()->NowMicros();
+        if (was_empty || !to_free.empty()) {
+          busy_poll_since_usecs = now_usecs;
+        }
+        mode = ChoosePollingMode(busy_poll_since_usecs, now_usecs);
+        polling_mode_ = mode;
+      }
     }
     FreeMemory(to_free);
     to_free.clear();
 
     if (events_still_pending) {
-      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+      switch (mode) {
+        case PollingMode::kBusyPoll:
+          break;
+        case PollingMode::kSleep:
+          Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+          break;
+        case PollingMode::kHostCallback:
+          WaitForHostCallback();
+          break;
+      }
     }
   }
   polling_stopped_->Notify();
 }
 
+EventMgr::PollingMode EventMgr::ChoosePollingMode(uint64 busy_poll_since_usecs,
+                                                  uint64 now_usecs) {
+  const size_t num_pending = used_events_.size();
+  if (num_pending >= kHostCallbackMinPending) {
+    return PollingMode::kHostCallback;
+  }
+  if (num_pending <= kBusyPollMaxPending &&
+      now_usecs - busy_poll_since_usecs < kBusyPollMaxUsecs) {
+    return PollingMode::kBusyPoll;
+  }
+  return PollingMode::kSleep;
+}
+
+void EventMgr::MaybeQueueHostCallback(se::Stream* stream) {
+  if (used_events_.size() < kHostCallbackMinPending) {
+    return;
+  }
+  {
+    mutex_lock l(host_callback_mu_);
+    // Always keep one callback in flight so that the polling loop is woken up
+    // even if the queue just became deep.
+    if (++events_since_host_callback_ < kHostCallbackStride &&
+        host_callbacks_in_flight_ > 0) {
+      return;
+    }
+    ++host_callbacks_in_flight_;
+  }
+  events_since_host_callback_ = 0;
+  // The callback runs on a driver thread and must not call into the device
+  // or block, so it only flags the polling loop.
+  stream->ThenDoHostCallback([this]() {
+    mutex_lock l(host_callback_mu_);
+    --host_callbacks_in_flight_;
+    host_callback_fired_ = true;
+    host_callback_cv_.notify_all();
+  });
+}
+
+void EventMgr::WaitForHostCallback() {
+  mutex_lock l(host_callback_mu_);
+  if (!host_callback_fired_) {
+    host_callback_cv_.wait_for(
+        l, std::chrono::microseconds(kHostCallbackWaitUsecs));
+  }
+  host_callback_fired_ = false;
+}
+
+void EventMgr::RecordCallbackLag(PollingMode mode, uint64 pending_usecs) {
+  const uint64 now_usecs = Env::Default()->NowMicros();
+  callback_lag_histograms_[static_cast<int>(mode)]->Add(
+      now_usecs > pending_usecs ? now_usecs - pending_usecs : 0);
+}
+
 void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
@@ -179,8 +298,12 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
   free_events_.pop_back();
   stream->ThenRecordEvent(e);
   in_use.event = e;
+  if (adaptive_polling_) {
+    in_use.pending_usecs = Env::Default()->NowMicros();
+  }
   bool was_empty = used_events_.empty();
   used_events_.push_back(in_use);
+  if (adaptive_polling_) MaybeQueueHostCallback(stream);
   // Maybe wake up the polling thread
   if (was_empty) events_pending_.notify_all();
 }
@@ -207,6 +330,9 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
                           gtl::InlinedVector<InUse, 4>* to_free) {
   VLOG(2) << "PollEvents  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
+  // In adaptive mode, remember when each event was last seen pending: its
+  // callback lag is measured from there, which bounds the lag from above.
+  const uint64 now_usecs = adaptive_polling_ ? Env::Default()->NowMicros() : 0;
   // Sweep the remaining events in order.  If this is the dedicated
   // polling thread, check the entire set.  Otherwise, just sweep up to
   // the first non-complete record that is still pending.
@@ -221,9 +347,11 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
         LOG(FATAL) << "Unexpected Event status: " << static_cast<int>(s);
         break;
       case se::Event::Status::kPending:
+        iu.pending_usecs = now_usecs;
         if (!is_dedicated_poller) return;  // quit processing queue
         break;
       case se::Event::Status::kComplete:
+        iu.mode = polling_mode_;
         // Make a copy of the InUse record so we can free it after releasing
         // the lock
         to_free->push_back(iu);
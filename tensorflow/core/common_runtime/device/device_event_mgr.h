@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -86,12 +87,24 @@ class EventMgr {
   friend class EventMgrFactory;
   se::StreamExecutor* const exec_;
   const int32 polling_active_delay_usecs_;
+  // If true, the polling loop picks between busy-polling, sleeping and
+  // waiting for device host callbacks based on the number of pending events.
+  // See PollLoop().
+  const bool adaptive_polling_;
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
+  // How the polling loop waits between two sweeps in adaptive mode.
+  enum class PollingMode { kBusyPoll, kSleep, kHostCallback };
+
   struct InUse {
     se::Event* event;
     std::function<void()> func;
+    // Only maintained in adaptive mode: the last time (in microseconds) the
+    // event was known not to have completed yet, and the polling mode in
+    // effect when its completion was observed.
+    uint64 pending_usecs = 0;
+    PollingMode mode = PollingMode::kSleep;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
@@ -101,10 +114,39 @@ class EventMgr {
   void FreeMemory(const ToFreeVector& to_free) {
     for (const auto& iu : to_free) {
       // The function must be called in another thread.
-      if (iu.func != nullptr) threadpool_.Schedule(iu.func);
+      if (iu.func == nullptr) continue;
+      if (adaptive_polling_) {
+        threadpool_.Schedule(
+            [this, func = iu.func, pending_usecs = iu.pending_usecs,
+             mode = iu.mode]() {
+              RecordCallbackLag(mode, pending_usecs);
+              func();
+            });
+      } else {
+        threadpool_.Schedule(iu.func);
+      }
     }
   }
 
+  // Adds the time elapsed since pending_usecs to the callback lag histogram
+  // of the given polling mode.
+  void RecordCallbackLag(PollingMode mode, uint64 pending_usecs);
+
+  // Returns how the polling loop should wait before its next sweep.  The
+  // loop has been polling since busy_poll_since_usecs without observing an
+  // event completion.
+  PollingMode ChoosePollingMode(uint64 busy_poll_since_usecs, uint64 now_usecs)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // In host callback mode, enqueues on stream a host callback that wakes up
+  // the polling loop once the device reaches it.  Called after each event is
+  // queued; only every few events get a callback.
+  void MaybeQueueHostCallback(se::Stream* stream)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Blocks until a host callback has run or a timeout expires.
+  void WaitForHostCallback();
+
   // Stream-enqueue an unused Event and save with it a collection of
   // Tensors and/or a BufRec to be deleted only after the Event
   // records.
@@ -139,6 +181,21 @@ class EventMgr {
   std::deque<InUse> used_events_ TF_GUARDED_BY(mu_);
 
   bool stop_polling_ TF_GUARDED_BY(mu_);
+  PollingMode polling_mode_ TF_GUARDED_BY(mu_) = PollingMode::kSleep;
+
+  // Host callbacks run on a driver thread that must not block behind mu_, so
+  // they only touch the state below.
+  mutex host_callback_mu_ TF_ACQUIRED_AFTER(mu_);
+  condition_variable host_callback_cv_;
+  // Number of host callbacks enqueued but not yet run.
+  int host_callbacks_in_flight_ TF_GUARDED_BY(host_callback_mu_) = 0;
+  // Set by a host callback, cleared by the polling loop once it wakes up.
+  bool host_callback_fired_ TF_GUARDED_BY(host_callback_mu_) = false;
+  // Events queued since the last host callback was enqueued.
+  int events_since_host_callback_ TF_GUARDED_BY(mu_) = 0;
+
+  // Callback lag histograms, indexed by PollingMode.
+  monitoring::SamplerCell* callback_lag_histograms_[3];
   std::unique_ptr<Notification> polling_stopped_;
 
   // The main PollLoop for the event manager runs in this threadpool.
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -138,6 +139,44 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// Tests that with adaptive polling every callback runs, whether the queue is
+// shallow or deep enough to switch to host callbacks, and that callback lags
+// are recorded.
+TEST(EventMgr, AdaptivePolling) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.mutable_experimental()->set_adaptive_event_polling(true);
+  TEST_EventMgr em(stream_exec, gpu_options);
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  auto num_lags_recorded = []() {
+    int64 num = 0;
+    for (const char* mode : {"busy_poll", "sleep", "host_callback"}) {
+      num += metrics::GetDeviceEventCallbackLagHistogram(mode)->value().num();
+    }
+    return num;
+  };
+  const int64 lags_before = num_lags_recorded();
+  for (int num_events : {1, 10, 500}) {
+    mutex mu;
+    int num_done = 0;
+    condition_variable all_done;
+    for (int i = 0; i < num_events; ++i) {
+      em.ThenExecute(stream.get(), [&mu, &num_done, &all_done]() {
+        mutex_lock l(mu);
+        ++num_done;
+        all_done.notify_all();
+      });
+    }
+    mutex_lock l(mu);
+    while (num_done < num_events) {
+      all_done.wait(l);
+    }
+  }
+  EXPECT_EQ(511, num_lags_recorded() - lags_before);
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/executor_snapshot.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
@@ -38,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -68,12 +70,14 @@ limitations under the License.
 #include "tensorflow/core/nccl/collective_communicator.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
@@ -428,6 +432,10 @@ Status DirectSession::ExtendLocked(GraphDef graph) {
   if (finalized_) {
     return errors::FailedPrecondition("Session has been finalized.");
   }
+  if (!options_.config.experimental().executor_snapshot_dir().empty()) {
+    graph_fingerprint_ =
+        FingerprintCat64(graph_fingerprint_, FingerprintGraphDef(graph));
+  }
   if (!(flib_def_ && execution_state_)) {
     // If this is the first call, we can initialize the execution state
     // with `graph` and do not need to call `Extend()`.
@@ -679,6 +687,8 @@ Status DirectSession::RunInternal(
     options.set_host_tracer_level(0);
     profiler_session = ProfilerSession::Create(options);
   }
+  // Traces this step if it is picked by the sampling profiler.
+  profiler::SamplingProfiler::Step sampled_step;
 
   // Register this step with session's cancellation manager, so that
   // `Session::Close()` will cancel the step.
@@ -714,6 +724,15 @@ Status DirectSession::RunInternal(
         }
       };
 
+  // Devices that serve step-local buffers from a static memory plan key the
+  // plan on the callable being run.
+  const uint64 plan_signature = reinterpret_cast<uintptr_t>(executors_and_keys);
+  for (Device* device : devices_) {
+    if (StaticPlanAllocator* a = device->GetStaticPlanAllocator()) {
+      a->BeginStep(step_id, plan_signature);
+    }
+  }
+
   if (can_execute_synchronously) {
     PrivateIntraProcessRendezvous rendezvous(device_mgr_.get());
     args.rendezvous = &rendezvous;
@@ -751,6 +770,12 @@ Status DirectSession::RunInternal(
     }
   }
 
+  for (Device* device : devices_) {
+    if (StaticPlanAllocator* a = device->GetStaticPlanAllocator()) {
+      a->EndStep(step_id);
+    }
+  }
+
   if (step_cancellation_manager.IsCancelled()) {
     run_status.Update(errors::Cancelled("Run call was cancelled"));
   }
@@ -852,6 +877,13 @@ Status DirectSession::Run(const RunOptions& run_options,
   RunStateArgs run_state_args(run_options.debug_options());
   run_state_args.collective_graph_key =
       run_options.experimental().collective_graph_key();
+  if (options_.config.experimental().max_shape_specialized_executors() > 0) {
+    for (const auto& it : inputs) {
+      if (it.second.dtype() != DT_RESOURCE) {
+        run_state_args.feed_shapes.emplace(it.first, it.second.shape());
+      }
+    }
+  }
 
   TF_RETURN_IF_ERROR(GetOrCreateExecutors(input_tensor_names, output_names,
                                           target_nodes, &executors_and_keys,
@@ -1298,6 +1330,7 @@ Status DirectSession::CreateExecutors(
   options.use_function_convention = !run_state_args->is_partial_run;
   options.collective_graph_key =
       callable_options.run_options().experimental().collective_graph_key();
+  options.feed_shapes = run_state_args->feed_shapes;
   if (options_.config.experimental()
           .collective_deterministic_sequential_execution()) {
     options.collective_order = GraphCollectiveOrder::kEdges;
@@ -1476,11 +1509,20 @@ Status DirectSession::GetOrCreateExecutors(
         run_state_args->debug_options.debug_tensor_watch_opts());
   }
 
+  // Executors specialized to the feed shapes are cached separately from the
+  // generic ones.
+  string feed_shapes_summary;
+  for (const auto& feed_shape : run_state_args->feed_shapes) {
+    strings::StrAppend(&feed_shapes_summary, "/", feed_shape.first,
+                       feed_shape.second.DebugString());
+  }
+
   // Fast lookup path, no sorting.
-  const string key = strings::StrCat(
+  const string generic_key = strings::StrCat(
       absl::StrJoin(inputs, ","), "->", absl::StrJoin(outputs, ","), "/",
       absl::StrJoin(target_nodes, ","), "/", run_state_args->is_partial_run,
       "/", debug_tensor_watches_summary);
+  const string key = strings::StrCat(generic_key, feed_shapes_summary);
   // Set the handle, if it's needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1495,6 +1537,20 @@ Status DirectSession::GetOrCreateExecutors(
       *executors_and_keys = it->second.get();
       return Status::OK();
     }
+    // Once a signature has used up its shape-specialized executors, other
+    // shapes go straight to the generic executors.
+    if (!feed_shapes_summary.empty()) {
+      auto fallback_it = shape_agnostic_executors_.find(generic_key);
+      if (fallback_it != shape_agnostic_executors_.end()) {
+        run_state_args->feed_shapes.clear();
+        if (handle_name_counter_value >= 0) {
+          run_state_args->handle =
+              strings::StrCat(generic_key, ";", handle_name_counter_value);
+        }
+        *executors_and_keys = fallback_it->second.get();
+        return Status::OK();
+      }
+    }
   }
 
   // Slow lookup path, the unsorted key missed the cache.
@@ -1510,10 +1566,12 @@ Status DirectSession::GetOrCreateExecutors(
   std::vector<string> tn_sorted(target_nodes.begin(), target_nodes.end());
   std::sort(tn_sorted.begin(), tn_sorted.end());
 
-  const string sorted_key = strings::StrCat(
+  const string generic_sorted_key = strings::StrCat(
       absl::StrJoin(inputs_sorted, ","), "->",
       absl::StrJoin(outputs_sorted, ","), "/", absl::StrJoin(tn_sorted, ","),
       "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary);
+  const string sorted_key =
+      strings::StrCat(generic_sorted_key, feed_shapes_summary);
   // Set the handle, if its needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1528,6 +1586,29 @@ Status DirectSession::GetOrCreateExecutors(
       *executors_and_keys = it->second.get();
       return Status::OK();
     }
+    // Only a bounded number of shape signatures get specialized executors,
+    // the others fall back to the generic executors.
+    if (!run_state_args->feed_shapes.empty()) {
+      int& num_specialized =
+          num_shape_specialized_executors_[generic_sorted_key];
+      if (num_specialized >= options_.config.experimental()
+                                 .max_shape_specialized_executors()) {
+        run_state_args->feed_shapes.clear();
+      } else {
+        ++num_specialized;
+      }
+    }
+  }
+  if (!feed_shapes_summary.empty() && run_state_args->feed_shapes.empty()) {
+    TF_RETURN_IF_ERROR(GetOrCreateExecutors(
+        inputs, outputs, target_nodes, executors_and_keys, run_state_args));
+    // The generic executors are now cached under `generic_key`.
+    mutex_lock l(executor_lock_);
+    auto it = executors_.find(generic_key);
+    if (it != executors_.end()) {
+      shape_agnostic_executors_.emplace(generic_key, it->second);
+    }
+    return Status::OK();
   }
 
   // Nothing found, so create the executors and store in the cache.
@@ -1586,6 +1667,33 @@ Status DirectSession::CreateGraphs(
     return errors::FailedPrecondition("Session has been finalized.");
   }
 
+  const string& snapshot_dir =
+      options_.config.experimental().executor_snapshot_dir();
+  const bool use_snapshot =
+      !snapshot_dir.empty() && !run_state_args->is_partial_run;
+  uint64 snapshot_fingerprint = 0;
+  if (use_snapshot) {
+    snapshot_fingerprint = ExecutorSnapshotFingerprint(
+        graph_fingerprint_, subgraph_options, options_.config, device_set_);
+    ExecutorSnapshot snapshot;
+    Status s = ReadExecutorSnapshot(options_.env, snapshot_dir,
+                                    snapshot_fingerprint, &snapshot);
+    if (s.ok()) {
+      s = CreateGraphsFromSnapshotLocked(snapshot, outputs, flib_def,
+                                         input_types, output_types,
+                                         collective_graph_key);
+      if (s.ok()) {
+        VLOG(1) << "Created graphs from executor snapshot "
+                << ExecutorSnapshotPath(snapshot_dir, snapshot_fingerprint);
+        return s;
+      }
+      outputs->clear();
+    }
+    if (!errors::IsNotFound(s)) {
+      LOG(WARNING) << "Ignoring executor snapshot: " << s;
+    }
+  }
+
   std::unique_ptr<ClientGraph> client_graph;
 
   std::unique_ptr<GraphExecutionState> temp_exec_state_holder;
@@ -1732,9 +1840,62 @@ Status DirectSession::CreateGraphs(
   *flib_def = std::move(client_graph->flib_def);
   std::swap(*input_types, client_graph->feed_types);
   std::swap(*output_types, client_graph->fetch_types);
+
+  if (s.ok() && use_snapshot) {
+    ExecutorSnapshot snapshot;
+    snapshot.set_fingerprint(snapshot_fingerprint);
+    ExportExecutorSnapshot(*outputs, **flib_def, &snapshot);
+    for (DataType dtype : *input_types) snapshot.add_feed_types(dtype);
+    for (DataType dtype : *output_types) snapshot.add_fetch_types(dtype);
+    snapshot.set_collective_graph_key(*collective_graph_key);
+    snapshot.mutable_stateful_placements()->insert(stateful_placements_.begin(),
+                                                   stateful_placements_.end());
+    Status write_status =
+        WriteExecutorSnapshot(options_.env, snapshot_dir, snapshot);
+    if (!write_status.ok()) {
+      LOG(WARNING) << "Failed to write executor snapshot: " << write_status;
+    }
+  }
   return s;
 }
 
+Status DirectSession::CreateGraphsFromSnapshotLocked(
+    const ExecutorSnapshot& snapshot,
+    std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
+    std::unique_ptr<FunctionLibraryDefinition>* flib_def,
+    DataTypeVector* input_types, DataTypeVector* output_types,
+    int64* collective_graph_key) {
+  // Stateful nodes must stay where earlier callables placed them.
+  for (const auto& placement_pair : snapshot.stateful_placements()) {
+    auto iter = stateful_placements_.find(placement_pair.first);
+    if (iter != stateful_placements_.end() &&
+        iter->second != placement_pair.second) {
+      return errors::FailedPrecondition(
+          "Stateful placement mismatch. Current assignment of ",
+          placement_pair.first, " to ", iter->second, " does not match ",
+          placement_pair.second);
+    }
+  }
+  TF_RETURN_IF_ERROR(ImportExecutorSnapshot(snapshot, outputs, flib_def));
+  for (auto& partition : *outputs) {
+    partition.second->SetConstructionContext(
+        ConstructionContext::kDirectSession);
+  }
+  for (const auto& placement_pair : snapshot.stateful_placements()) {
+    stateful_placements_.emplace(placement_pair.first, placement_pair.second);
+  }
+  input_types->clear();
+  for (int dtype : snapshot.feed_types()) {
+    input_types->push_back(static_cast<DataType>(dtype));
+  }
+  output_types->clear();
+  for (int dtype : snapshot.fetch_types()) {
+    output_types->push_back(static_cast<DataType>(dtype));
+  }
+  *collective_graph_key = snapshot.collective_graph_key();
+  return Status::OK();
+}
+
 ::tensorflow::Status DirectSession::ListDevices(
     std::vector<DeviceAttributes>* response) {
   response->clear();
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_DIRECT_SESSION_H_
 
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -43,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/executor_snapshot.pb.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
@@ -236,6 +238,9 @@ class DirectSession : public Session {
     std::unique_ptr<Graph> graph;
     const DebugOptions& debug_options;
     int64 collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+    // If not empty, the concrete shapes of the feeds of this run, to which
+    // the executors are specialized.
+    std::map<string, TensorShape> feed_shapes;
   };
 
   // Retrieves an already existing set of executors to run 'inputs' and
@@ -263,6 +268,16 @@ class DirectSession : public Session {
       RunStateArgs* run_state_args, DataTypeVector* input_types,
       DataTypeVector* output_types, int64* collective_graph_key);
 
+  // Like CreateGraphs(), but takes the graphs from `snapshot` instead of
+  // building them.
+  ::tensorflow::Status CreateGraphsFromSnapshotLocked(
+      const ExecutorSnapshot& snapshot,
+      std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
+      std::unique_ptr<FunctionLibraryDefinition>* flib_def,
+      DataTypeVector* input_types, DataTypeVector* output_types,
+      int64* collective_graph_key)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(graph_state_lock_);
+
   ::tensorflow::Status RunInternal(
       int64 step_id, const RunOptions& run_options,
       CallFrameInterface* call_frame, ExecutorsAndKeys* executors_and_keys,
@@ -366,6 +381,15 @@ class DirectSession : public Session {
   // same ExecutorsAndKey object.
   std::unordered_map<string, std::shared_ptr<ExecutorsAndKeys>> executors_
       TF_GUARDED_BY(executor_lock_);
+  // Number of shape-specialized executors created for each sorted signature,
+  // bounded by `ConfigProto.Experimental.max_shape_specialized_executors`.
+  std::unordered_map<string, int> num_shape_specialized_executors_
+      TF_GUARDED_BY(executor_lock_);
+  // Generic executors of the signatures (keyed by their unsorted signature
+  // without feed shapes) that have reached that bound, so that runs with new
+  // feed shapes find them with a single lookup.
+  std::unordered_map<string, std::shared_ptr<ExecutorsAndKeys>>
+      shape_agnostic_executors_ TF_GUARDED_BY(executor_lock_);
 
   class RunCallableCallFrame;
   struct Callable {
@@ -399,6 +423,11 @@ class DirectSession : public Session {
   std::unique_ptr<GraphExecutionState> execution_state_
       TF_GUARDED_BY(graph_state_lock_);
 
+  // Fingerprint of the GraphDefs passed to Create() and Extend(), used to key
+  // executor snapshots.  Only maintained if
+  // ConfigProto.Experimental.executor_snapshot_dir is set.
+  uint64 graph_fingerprint_ TF_GUARDED_BY(graph_state_lock_) = 0;
+
   // The function library, before any rewrites or optimizations have been
   // performed. In particular, CreateGraphs() may need to modify the function
   // library; it copies and modifies the function library.
@@ -43,11 +43,14 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/executor_snapshot.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
@@ -228,6 +231,123 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_OptimizeForStaticGraph) {
       absl::StrContains(s.error_message(), "optimize_for_static_graph"));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_ExecutorSnapshot) {
+  Initialize({3, 2, -1, 0});
+  const string dir = io::JoinPath(testing::TmpDir(), "executor_snapshots");
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_executor_snapshot_dir(dir);
+  const CallableOptions callable_options =
+      MakeCallableOptions({x_ + ":0"}, {y_ + ":0"}, {});
+  Tensor x_tensor(DT_FLOAT, TensorShape({2, 1}));
+  test::FillValues<float>(&x_tensor, {1, 1});
+
+  auto run_callable = [&](float expected) {
+    auto session = absl::WrapUnique(NewSession(options));
+    ASSERT_TRUE(session != nullptr);
+    TF_ASSERT_OK(session->Create(def_));
+    Session::CallableHandle handle;
+    TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {x_tensor}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(expected, outputs[0].matrix<float>()(0, 0));
+    TF_ASSERT_OK(session->ReleaseCallable(handle));
+  };
+
+  run_callable(5.0);
+  std::vector<string> snapshots;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+      io::JoinPath(dir, "executor_snapshot_*.pb"), &snapshots));
+  ASSERT_EQ(1, snapshots.size());
+
+  // Change the value of `a` in the snapshot: a new session must use the
+  // snapshotted graphs instead of rebuilding them from `def_`.
+  ExecutorSnapshot snapshot;
+  TF_ASSERT_OK(ReadBinaryProto(Env::Default(), snapshots[0], &snapshot));
+  bool found = false;
+  for (auto& partition : *snapshot.mutable_partitions()) {
+    for (NodeDef& node : *partition.second.mutable_node()) {
+      if (node.name() != a_) continue;
+      Tensor a_tensor(DT_FLOAT, TensorShape({2, 2}));
+      test::FillValues<float>(&a_tensor, {1, 1, 1, 1});
+      a_tensor.AsProtoTensorContent(
+          (*node.mutable_attr())["value"].mutable_tensor());
+      found = true;
+    }
+  }
+  ASSERT_TRUE(found);
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), snapshots[0], snapshot));
+  run_callable(2.0);
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_CacheOptimizedGraphs) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_cache_optimized_graphs(true);
+  auto session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  auto run = [&session](const string& fetch, float expected) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {fetch + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(expected, outputs[0].matrix<float>()(0, 0));
+  };
+  run(y_, 5.0);
+  run(z_, -5.0);
+
+  // Extend the graph: `y` and `z` have the same fanin as before and reuse
+  // their optimized graphs, whereas `w` is optimized from scratch.
+  GraphDef extension;
+  *extension.mutable_versions() = def_.versions();
+  NodeDef* w = extension.add_node();
+  w->set_name("w");
+  w->set_op("Square");
+  w->add_input(y_);
+  w->set_device("/job:localhost/replica:0/task:0/cpu:0");
+  (*w->mutable_attr())["T"].set_type(DT_FLOAT);
+  TF_ASSERT_OK(session->Extend(extension));
+  run(y_, 5.0);
+  run(z_, -5.0);
+  run("w", 25.0);
+}
+
+TEST(DirectSessionTest, ShapeSpecializedExecutors) {
+  // y = Shape(x) is constant folded in the specialized graphs.
+  Graph g(OpRegistry::Global());
+  Node* x;
+  TF_ASSERT_OK(NodeBuilder("x", "Placeholder")
+                   .Attr("shape", PartialTensorShape({-1}))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &x));
+  Node* y;
+  TF_ASSERT_OK(NodeBuilder("y", "Shape")
+                   .Input(x)
+                   .Attr("T", DT_FLOAT)
+                   .Finalize(&g, &y));
+  GraphDef def;
+  g.ToGraphDef(&def);
+
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_max_shape_specialized_executors(
+      2);
+  auto session = absl::WrapUnique(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  // The third shape uses the generic executors, and so do all later new
+  // shapes, which find them through the cached fallback.
+  for (int64 size : {1, 2, 3, 1, 3, 4, 5, 4, 2}) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({{"x:0", Tensor(DT_FLOAT, TensorShape({size}))}},
+                              {"y:0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<int32>(
+        test::AsTensor<int32>({static_cast<int32>(size)}), outputs[0]);
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest,
        RunSimpleNetwork_DisableOutputPartitionGraphs) {
   Initialize({3, 2, -1, 0});
@@ -72,6 +72,14 @@ auto* eager_context_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/core/eager_context_created",
                                     "True if an eager context was created.");
 
+// Source of EagerContext::KernelCacheGeneration() values. Shared by all
+// contexts so that a generation observed on one context never matches another
+// context allocated at the same address.
+uint64 NewKernelCacheGeneration() {
+  static std::atomic<uint64> next_generation{0};
+  return next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 }  // namespace
 
 EagerContext::EagerContext(
@@ -88,6 +96,7 @@ EagerContext::EagerContext(
       rendezvous_(rendezvous),
       thread_pool_(NewThreadPoolFromSessionOptions(opts)),
       cluster_flr_(cluster_flr),
+      kernel_cache_generation_(NewKernelCacheGeneration()),
       log_device_placement_(opts.config.log_device_placement()),
       allow_soft_placement_(opts.config.allow_soft_placement()),
       num_active_steps_(0),
@@ -387,6 +396,8 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
   mutex_lock ml(cache_mu_);
   default_executor_.WaitForAllPendingNodes().IgnoreError();
   kernel_cache_.clear();
+  kernel_cache_generation_.store(NewKernelCacheGeneration(),
+                                 std::memory_order_release);
   for (auto& entry : registered_functions_) {
     entry.second->cached_kernel_keys->clear();
   }
@@ -804,6 +815,8 @@ Status EagerContext::RemoveFunction(const string& func) {
       for (auto& key : *registered_function->cached_kernel_keys) {
         kernel_cache_.erase(key);
       }
+      kernel_cache_generation_.store(NewKernelCacheGeneration(),
+                                     std::memory_order_release);
       registered_functions_.erase(func);
     }
     registered_function->Unref();
@@ -251,6 +251,14 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
 
+  // Changes whenever kernels are dropped from the kernel cache, so that
+  // references to cached kernels kept outside of it (see
+  // EagerOperation::GetInlineCachedKernel) can tell they may be stale.
+  // Values are unique across contexts.
+  uint64 KernelCacheGeneration() const {
+    return kernel_cache_generation_.load(std::memory_order_acquire);
+  }
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   void SetLogDevicePlacement(bool enable) override {
     log_device_placement_ = enable;
@@ -634,6 +642,7 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
       kernel_cache_ TF_GUARDED_BY(cache_mu_);
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       TF_GUARDED_BY(cache_mu_);
+  std::atomic<uint64> kernel_cache_generation_;
 
   // Whether we should compute RunMetadata.
   std::atomic<bool> should_store_graphs_{false};
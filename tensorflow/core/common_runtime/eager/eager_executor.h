@@ -17,9 +17,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
@@ -39,6 +39,7 @@ limitations under the License.
 namespace tensorflow {
 
 class AsyncEagerNode;
+class AsyncExecuteNode;
 class AsyncRemoteExecuteNode;
 namespace eager {
 class EagerClient;
@@ -70,6 +71,13 @@ class EagerNode {
   // Returns nullptr iff this Eager node is synchronous.
   virtual AsyncEagerNode* AsAsync() { return nullptr; }
   virtual AsyncRemoteExecuteNode* AsAsyncRemoteExecuteNode() { return nullptr; }
+  virtual AsyncExecuteNode* AsAsyncExecuteNode() { return nullptr; }
+
+  // Called by an async EagerExecutor, if elementwise fusion is enabled, on
+  // the next node to run while `next` is queued right behind it. Returns true
+  // if `next` took over the computation of this node, which must then not
+  // compute anything when run.
+  virtual bool FuseInto(EagerNode* next) { return false; }
 
   virtual string DebugString() const = 0;
 
@@ -221,7 +229,7 @@ class EagerExecutor {
   condition_variable nodes_pending_ TF_GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending NodeItems. Ordered by NodeItem::id.
-  std::queue<core::RefCountPtr<NodeItem>> node_queue_
+  std::deque<core::RefCountPtr<NodeItem>> node_queue_
       TF_GUARDED_BY(node_queue_mutex_);
 
   // Ordered by NodeItem::id.
@@ -258,6 +266,11 @@ class EagerExecutor {
 
   const bool enable_async_wait_for_remote_function_;
 
+  // Whether nodes may hand their computation over to the node queued right
+  // behind them, see EagerNode::FuseInto. Set with the
+  // TF_EAGER_ENABLE_ASYNC_ELEMENTWISE_FUSION environment variable.
+  const bool enable_elementwise_fusion_;
+
   // Callbacks to run on destruction.
   std::unordered_map<intptr_t, std::vector<std::function<void()>>> cleanups_;
 };
@@ -40,6 +40,34 @@ void EagerOperation::Clear() {
   ClearInferenceState();
 }
 
+core::RefCountPtr<KernelAndDevice> EagerOperation::GetInlineCachedKernel(
+    const Fprint128& cache_key) {
+  const uint64 generation = ctx_.KernelCacheGeneration();
+  for (InlineCacheEntry& entry : inline_kernel_cache_) {
+    if (entry.kernel == nullptr || !(entry.cache_key == cache_key)) continue;
+    if (entry.generation != generation) {
+      entry.kernel.reset();
+      return nullptr;
+    }
+    entry.kernel->Ref();
+    return core::RefCountPtr<KernelAndDevice>(entry.kernel.get());
+  }
+  return nullptr;
+}
+
+void EagerOperation::AddKernelToInlineCache(const Fprint128& cache_key,
+                                            uint64 generation,
+                                            KernelAndDevice* kernel) {
+  InlineCacheEntry& entry =
+      inline_kernel_cache_[next_inline_kernel_cache_entry_];
+  next_inline_kernel_cache_entry_ =
+      (next_inline_kernel_cache_entry_ + 1) % kInlineKernelCacheSize;
+  kernel->Ref();
+  entry.cache_key = cache_key;
+  entry.generation = generation;
+  entry.kernel.reset(kernel);
+}
+
 Status EagerOperation::SetAttrValue(const char* attr_name,
                                     const AttrValue& value) {
   MutableAttrs()->Set(attr_name, value);
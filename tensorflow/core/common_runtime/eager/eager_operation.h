@@ -184,6 +184,20 @@ class EagerOperation : public ImmediateExecutionOperation {
 
   EagerExecutor& Executor() { return *executor_; }
 
+  // Returns a kernel that this operation object ran recently under
+  // `cache_key`, or nullptr. Callers that reuse one EagerOperation for a
+  // stream of small ops, like the Python fast path which keeps one per
+  // thread, find their kernel here without going through the locked kernel
+  // cache of the EagerContext. Entries are ignored once the context's
+  // KernelCacheGeneration() has moved on.
+  core::RefCountPtr<KernelAndDevice> GetInlineCachedKernel(
+      const Fprint128& cache_key);
+  // Remembers `kernel`, which was found in or added to the EagerContext
+  // kernel cache under `cache_key` while its KernelCacheGeneration() was
+  // `generation`. Takes a reference on `kernel`.
+  void AddKernelToInlineCache(const Fprint128& cache_key, uint64 generation,
+                              KernelAndDevice* kernel);
+
   string DebugString() const;
 
   const absl::optional<EagerRemoteFunctionParams>& remote_func_params() const {
@@ -260,6 +274,16 @@ class EagerOperation : public ImmediateExecutionOperation {
   int inference_arg_idx_;  // arg definition index for the next input to be
                            // added
   gtl::FlatSet<std::string> inference_attrs_;  // attributes inferred so far
+
+  // Kernels run recently through this object. Survives Clear() and Reset().
+  struct InlineCacheEntry {
+    Fprint128 cache_key;
+    uint64 generation = 0;
+    core::RefCountPtr<KernelAndDevice> kernel;
+  };
+  static constexpr int kInlineKernelCacheSize = 8;
+  InlineCacheEntry inline_kernel_cache_[kInlineKernelCacheSize];
+  int next_inline_kernel_cache_entry_ = 0;
 };
 
 inline void EagerOperation::UpdateInput(int i, TensorHandle* h) {
@@ -47,5 +47,36 @@ TEST(EagerOperationTest, DeviceName) {
   ctx->Unref();
 }
 
+TEST(EagerOperationTest, InlineKernelCache) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  auto op = new EagerOperation(ctx);
+  core::RefCountPtr<KernelAndDevice> kernel(
+      new KernelAndDeviceOp(nullptr, false, nullptr, nullptr, nullptr,
+                            nullptr));
+  const Fprint128 key{1, 2};
+  const Fprint128 other_key{3, 4};
+
+  EXPECT_EQ(op->GetInlineCachedKernel(key), nullptr);
+  op->AddKernelToInlineCache(key, ctx->KernelCacheGeneration(), kernel.get());
+  EXPECT_EQ(op->GetInlineCachedKernel(key).get(), kernel.get());
+  EXPECT_EQ(op->GetInlineCachedKernel(other_key), nullptr);
+
+  // Entries survive clearing the operation for reuse.
+  op->Clear();
+  EXPECT_EQ(op->GetInlineCachedKernel(key).get(), kernel.get());
+
+  // Clearing the context's kernel cache invalidates them.
+  ctx->ClearCachesAndDefaultExecutor();
+  EXPECT_EQ(op->GetInlineCachedKernel(key), nullptr);
+
+  delete op;
+  ctx->Unref();
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -476,6 +476,19 @@ Status WrapInCallOp(EagerOperation* op, EagerOperation** wrapped_op) {
   return Status::OK();
 }
 
+Status ReturnKernel(core::RefCountPtr<KernelAndDevice> kernel, int* num_retvals,
+                    core::RefCountPtr<KernelAndDevice>* out_kernel) {
+  int num_outputs = kernel->num_outputs();
+  if (num_outputs > *num_retvals) {
+    return errors::InvalidArgument("Expecting ", num_outputs,
+                                   " outputs, but *num_retvals is ",
+                                   *num_retvals);
+  }
+  *num_retvals = num_outputs;
+  *out_kernel = std::move(kernel);
+  return Status::OK();
+}
+
 Status GetOrCreateKernelAndDevice(
     EagerOperation* op, TensorHandle** retvals, int* num_retvals,
     core::RefCountPtr<KernelAndDevice>* out_kernel) {
@@ -559,7 +572,22 @@ Status GetOrCreateKernelAndDevice(
     }
   }
 
-  core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
+  // Primitive ops first check the kernels recently run through this
+  // operation object, which skips the lock on the context's kernel cache.
+  // Function kernels are left out: they hold on to function library state
+  // that must not outlive the context.
+  const bool use_inline_cache =
+      !op->is_function() && !ctx.RunEagerOpAsFunction();
+  const uint64 cache_generation = ctx.KernelCacheGeneration();
+  core::RefCountPtr<KernelAndDevice> kernel;
+  if (use_inline_cache) {
+    kernel = op->GetInlineCachedKernel(cache_key);
+    if (kernel != nullptr) {
+      return ReturnKernel(std::move(kernel), num_retvals, out_kernel);
+    }
+  }
+  kernel = ctx.GetCachedKernel(cache_key);
+  bool add_to_inline_cache = use_inline_cache && kernel != nullptr;
   AbstractOperationPtr wrapped_op_releaser;
   if (kernel == nullptr) {
     if (ctx.RunEagerOpAsFunction() && !op->is_function()) {
@@ -659,21 +687,15 @@ Status GetOrCreateKernelAndDevice(
       TF_RETURN_IF_ERROR(OpDefForOp(op->Name().data(), &op_def));
       if (KernelCacheEnabled(*op_def)) {
         ctx.AddKernelToCache(cache_key, kernel.get());
+        add_to_inline_cache = use_inline_cache;
       }
     }
   }
-
-  int num_outputs = kernel->num_outputs();
-  if (num_outputs > *num_retvals) {
-    return errors::InvalidArgument("Expecting ", num_outputs,
-                                   " outputs, but *num_retvals is ",
-                                   *num_retvals);
+  if (add_to_inline_cache) {
+    op->AddKernelToInlineCache(cache_key, cache_generation, kernel.get());
   }
-  *num_retvals = num_outputs;
 
-  kernel->Ref();  // Ownership of reference is passed to out_kernel.
-  out_kernel->reset(kernel.get());
-  return Status::OK();
+  return ReturnKernel(std::move(kernel), num_retvals, out_kernel);
 }
 
 Status CreateUnshapedOutput(
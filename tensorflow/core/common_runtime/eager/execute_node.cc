@@ -14,9 +14,93 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 
+#include <algorithm>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
+namespace {
+
+constexpr char kFusedElementwise[] = "_FusedElementwise";
+
+// Upper bound on the number of ops fused into one node, as in the
+// elementwise_fusion grappler pass.
+constexpr size_t kMaxFusedOps = 32;
+
+// Returns the number of inputs of the elementwise ops supported by the
+// `_FusedElementwise` kernel, and 0 for all other ops.
+int ElementwiseOpArity(const string& op) {
+  static const auto* arity = new absl::flat_hash_map<string, int>({
+      // Unary ops.
+      {"Abs", 1},
+      {"Exp", 1},
+      {"Log", 1},
+      {"Neg", 1},
+      {"Reciprocal", 1},
+      {"Relu", 1},
+      {"Rsqrt", 1},
+      {"Sigmoid", 1},
+      {"Sqrt", 1},
+      {"Square", 1},
+      {"Tanh", 1},
+      // Binary ops, whose inputs may broadcast.
+      {"Add", 2},
+      {"AddV2", 2},
+      {"Maximum", 2},
+      {"Minimum", 2},
+      {"Mul", 2},
+      {"RealDiv", 2},
+      {"SquaredDifference", 2},
+      {"Sub", 2},
+  });
+  auto it = arity->find(op);
+  return it == arity->end() ? 0 : it->second;
+}
+
+// Returns a `_FusedElementwise` kernel on `device` evaluating `op_names` with
+// `operands` in the encoding of the op, creating it on first use.
+Status GetFusedElementwiseKernel(EagerContext* ctx, Device* device,
+                                 DataType dtype, int num_args,
+                                 const std::vector<string>& op_names,
+                                 const std::vector<int>& operands,
+                                 core::RefCountPtr<KernelAndDevice>* kernel) {
+  const Fprint128 cache_key = Fingerprint128(strings::StrCat(
+      kFusedElementwise, ";", device->name(), ";", dtype, ";", num_args, ";",
+      absl::StrJoin(op_names, ","), ";", absl::StrJoin(operands, ",")));
+  *kernel = ctx->GetCachedKernel(cache_key);
+  if (*kernel != nullptr) return Status::OK();
+
+  NodeDef ndef;
+  ndef.set_name(kFusedElementwise);
+  ndef.set_op(kFusedElementwise);
+  ndef.set_device(device->name());
+  AddNodeAttr("T", dtype, &ndef);
+  AddNodeAttr("num_args", num_args, &ndef);
+  AddNodeAttr("op_names", op_names, &ndef);
+  AddNodeAttr("operands", operands, &ndef);
+
+  FunctionLibraryRuntime* flr = ctx->func_lib(device);
+  if (flr == nullptr) {
+    return errors::NotFound(
+        "Unable to find a FunctionLibraryRuntime corresponding to device ",
+        device->name());
+  }
+  auto runner = flr->runner() != nullptr ? flr->runner() : ctx->runner();
+  core::RefCountPtr<KernelAndDevice> new_kernel(new KernelAndDeviceOp(
+      ctx->GetRendezvous(), ctx->LogMemory(), flr, runner,
+      ctx->GetCollectiveExecutorHandle(), ctx->HostCPU()));
+  TF_RETURN_IF_ERROR(new_kernel->Init(/*log_device_placement=*/false, ndef,
+                                      /*graph_collector=*/nullptr));
+  ctx->AddKernelToCache(cache_key, new_kernel.get());
+  *kernel = std::move(new_kernel);
+  return Status::OK();
+}
+
+}  // namespace
 
 #if !defined(IS_MOBILE_PLATFORM)
 bool ExecuteNodeArgs::IsRemote(EagerContext* ctx, Device* input_device,
@@ -141,4 +225,104 @@ Status ExecuteNodeArgs::GetLocalArg(const FunctionArgIndex& index,
   }
 }
 
+bool AsyncExecuteNode::IsFusibleElementwise() const {
+  const OpKernel* op_kernel = kernel_->kernel();
+  if (op_kernel == nullptr || remote_func_params_.has_value() ||
+      graph_collector_ != nullptr || retvals_.size() != 1 ||
+      ElementwiseOpArity(op_kernel->type_string()) !=
+          static_cast<int>(inputs_.size())) {
+    return false;
+  }
+  const DataType dtype = kernel_->output_dtypes()[0];
+  if ((dtype != DT_FLOAT && dtype != DT_DOUBLE) ||
+      kernel_->device() == nullptr ||
+      kernel_->device()->device_type() != DEVICE_CPU) {
+    return false;
+  }
+  for (TensorHandle* input : inputs_) {
+    if (input->Type() != TensorHandle::LOCAL) return false;
+  }
+  return true;
+}
+
+bool AsyncExecuteNode::FuseInto(EagerNode* next_node) {
+  AsyncExecuteNode* next = next_node->AsAsyncExecuteNode();
+  if (next == nullptr || fused_into_next_ || !IsFusibleElementwise() ||
+      !next->IsFusibleElementwise() ||
+      kernel_->device() != next->kernel_->device() ||
+      kernel_->output_dtypes()[0] != next->kernel_->output_dtypes()[0] ||
+      cancellation_manager_ != next->cancellation_manager_) {
+    return false;
+  }
+  const size_t num_ops = fused_ == nullptr ? 1 : fused_->op_names.size();
+  if (num_ops + 1 > kMaxFusedOps) return false;
+  TensorHandle* output = retvals_[0];
+  if (std::count(next->inputs_.begin(), next->inputs_.end(), output) != 1) {
+    return false;
+  }
+  // Drop the reference of this node. If `next` holds the only other one, no
+  // one else can read the output, which is then never computed.
+  output->Unref();
+  if (!output->RefCountIsOne()) {
+    output->Ref();
+    return false;
+  }
+  retvals_.clear();
+
+  std::unique_ptr<FusedElementwise> fused = std::move(fused_);
+  if (fused == nullptr) {
+    fused = absl::make_unique<FusedElementwise>();
+    fused->op_names.push_back(kernel_->kernel()->type_string());
+    for (int i = 0, end = inputs_.size(); i < end; ++i) {
+      auto it = std::find(fused->args.begin(), fused->args.end(), inputs_[i]);
+      if (it == fused->args.end()) {
+        inputs_[i]->Ref();
+        it = fused->args.insert(fused->args.end(), inputs_[i]);
+      }
+      fused->operands.emplace_back(false, it - fused->args.begin());
+    }
+    if (inputs_.size() == 1) fused->operands.emplace_back(false, -1);
+  }
+  const int output_step = fused->op_names.size() - 1;
+  fused->op_names.push_back(next->kernel_->kernel()->type_string());
+  for (TensorHandle* input : next->inputs_) {
+    if (input == output) {
+      fused->operands.emplace_back(true, output_step);
+      continue;
+    }
+    auto it = std::find(fused->args.begin(), fused->args.end(), input);
+    if (it == fused->args.end()) {
+      input->Ref();
+      it = fused->args.insert(fused->args.end(), input);
+    }
+    fused->operands.emplace_back(false, it - fused->args.begin());
+  }
+  if (next->inputs_.size() == 1) fused->operands.emplace_back(false, -1);
+  next->fused_ = std::move(fused);
+
+  // Nothing waits for the output, but make sure it does not look pending.
+  output->Poison(errors::Internal("Output of ", kernel_->name(),
+                                  " was fused into ", next->kernel_->name()),
+                 ctx_->CanonicalDevice(kernel_->OutputDevice(0)));
+  fused_into_next_ = true;
+  return true;
+}
+
+Status AsyncExecuteNode::RunFused() {
+  const int num_args = fused_->args.size();
+  std::vector<int> operands;
+  operands.reserve(fused_->operands.size());
+  for (const auto& operand : fused_->operands) {
+    operands.push_back(operand.first ? num_args + operand.second
+                                     : operand.second);
+  }
+  core::RefCountPtr<KernelAndDevice> kernel;
+  TF_RETURN_IF_ERROR(GetFusedElementwiseKernel(
+      ctx_, kernel_->device(), kernel_->output_dtypes()[0], num_args,
+      fused_->op_names, operands, &kernel));
+  return EagerKernelExecute(ctx_, fused_->args, remote_func_params_, kernel,
+                            graph_collector_, cancellation_manager_,
+                            absl::MakeSpan(retvals_), stack_trace_);
+}
+
 }  // namespace tensorflow
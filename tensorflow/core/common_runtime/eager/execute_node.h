@@ -20,6 +20,8 @@ limitations under the License.
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/platform.h"
@@ -185,23 +187,44 @@ class AsyncExecuteNode : public EagerNode {
     for (auto handle : inputs_) {
       handle->Unref();
     }
+
+    if (fused_ != nullptr) {
+      for (auto handle : fused_->args) {
+        handle->Unref();
+      }
+    }
   }
 
+  AsyncExecuteNode* AsAsyncExecuteNode() override { return this; }
+
+  // Hands the computation of this node over to `next` if both run a CPU
+  // elementwise op supported by `_FusedElementwise` and the output of this
+  // node is used by `next` only. `next` then evaluates this node's op (and
+  // the ops previously fused into it) together with its own in a single
+  // kernel, so the intermediate result is never materialized.
+  bool FuseInto(EagerNode* next) override;
+
   Status Run() override {
-    int i = 0;
-    for (TensorHandle* h : inputs_) {
-      if (h->RefCountIsOne()) {
-        const Device* d = ctx_->CanonicalDevice(kernel_->InputDevice(i));
-        Status s = h->Unprotect(d);
-        if (!s.ok()) {
-          VLOG(1) << "Unable to unprotect tensor: " << s;
+    if (fused_into_next_) return Status::OK();
+    Status status;
+    if (fused_ != nullptr) {
+      status = RunFused();
+    } else {
+      int i = 0;
+      for (TensorHandle* h : inputs_) {
+        if (h->RefCountIsOne()) {
+          const Device* d = ctx_->CanonicalDevice(kernel_->InputDevice(i));
+          Status s = h->Unprotect(d);
+          if (!s.ok()) {
+            VLOG(1) << "Unable to unprotect tensor: " << s;
+          }
         }
+        ++i;
       }
-      ++i;
+      status = EagerKernelExecute(
+          ctx_, inputs_, remote_func_params_, kernel_, graph_collector_,
+          cancellation_manager_, absl::MakeSpan(retvals_), stack_trace_);
     }
-    Status status = EagerKernelExecute(
-        ctx_, inputs_, remote_func_params_, kernel_, graph_collector_,
-        cancellation_manager_, absl::MakeSpan(retvals_), stack_trace_);
     if (!status.ok()) {
       if (stack_trace_.has_value()) {
         status = Status(status.code(), status.error_message(),
@@ -226,10 +249,28 @@ class AsyncExecuteNode : public EagerNode {
   std::string DebugString() const override {
     std::string out = "[AsyncExecuteNode]";
     strings::StrAppend(&out, " kernel: ", kernel_->name());
+    if (fused_ != nullptr) {
+      strings::StrAppend(&out, " fused: ", fused_->op_names.size(), " ops");
+    }
     return out;
   }
 
  private:
+  // Elementwise ops evaluated by this node, in the order they were queued,
+  // when ops of preceding nodes were fused into it.
+  struct FusedElementwise {
+    std::vector<string> op_names;
+    // Two operands per op: (true, i) is the result of op i and (false, i) is
+    // args[i]. The second operand of unary ops is (false, -1).
+    std::vector<std::pair<bool, int>> operands;
+    // Inputs of the fused ops. Holds a reference on each handle.
+    absl::InlinedVector<TensorHandle*, 4> args;
+  };
+
+  // Returns true if this node runs an elementwise op that can be fused.
+  bool IsFusibleElementwise() const;
+  Status RunFused();
+
   EagerContext* ctx_;
   absl::InlinedVector<TensorHandle*, 4> inputs_;
   const absl::optional<EagerRemoteFunctionParams> remote_func_params_;
@@ -238,6 +279,8 @@ class AsyncExecuteNode : public EagerNode {
   CancellationManager* const cancellation_manager_;
   absl::optional<ManagedStackTrace> stack_trace_;
   absl::InlinedVector<TensorHandle*, 2> retvals_;
+  std::unique_ptr<FusedElementwise> fused_;
+  bool fused_into_next_ = false;
 };
 
 }  // namespace tensorflow
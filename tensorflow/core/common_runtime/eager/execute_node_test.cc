@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 
+#include <cmath>
 #include <memory>
 
 #include "tensorflow/core/common_runtime/composite_device.h"
@@ -22,7 +23,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -138,5 +142,68 @@ TEST(ExecuteNodeTest, ExecuteNodeArgs) {
   ctx->Unref();
 }
 
+core::RefCountPtr<KernelAndDevice> CreateCpuKernel(EagerContext* ctx,
+                                                   const string& op) {
+  Device* device = ctx->HostCPU();
+  NodeDefBuilder builder(op, op);
+  builder.Device(device->name()).Attr("T", DT_FLOAT);
+  for (int i = 0; i < (op == "Exp" ? 1 : 2); ++i) {
+    builder.Input(FakeInput(DT_FLOAT));
+  }
+  NodeDef ndef;
+  TF_CHECK_OK(builder.Finalize(&ndef));
+  core::RefCountPtr<KernelAndDevice> kernel(new KernelAndDeviceOp(
+      ctx->GetRendezvous(), ctx->LogMemory(), ctx->func_lib(device),
+      ctx->runner(), ctx->GetCollectiveExecutorHandle(), device));
+  TF_CHECK_OK(kernel->Init(/*log_device_placement=*/false, ndef,
+                           /*graph_collector=*/nullptr));
+  return kernel;
+}
+
+TEST(ExecuteNodeTest, FuseElementwiseOps) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  Device* device = device_mgr.ListDevices().at(0);
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+
+  TensorHandle* x = TensorHandle::CreateLocalHandle(
+      test::AsTensor<float>({0.0f, 1.0f}, TensorShape({2})), nullptr, device,
+      ctx);
+  TensorHandle* y = TensorHandle::CreateLocalHandle(
+      test::AsTensor<float>({2.0f}, TensorShape({})), nullptr, device, ctx);
+  TensorHandle* exp_x = TensorHandle::CreateEmptyLocalHandle(
+      nullptr, device, nullptr, DT_FLOAT, ctx);
+  TensorHandle* result = TensorHandle::CreateEmptyLocalHandle(
+      nullptr, device, nullptr, DT_FLOAT, ctx);
+
+  // result = Mul(Exp(x), y)
+  AsyncExecuteNode exp_node(ctx, {x}, absl::nullopt,
+                            CreateCpuKernel(ctx, "Exp"), nullptr, nullptr,
+                            absl::MakeSpan(&exp_x, 1), absl::nullopt);
+  AsyncExecuteNode mul_node(ctx, {exp_x, y}, absl::nullopt,
+                            CreateCpuKernel(ctx, "Mul"), nullptr, nullptr,
+                            absl::MakeSpan(&result, 1), absl::nullopt);
+
+  // The intermediate result cannot be skipped while it is still referenced.
+  EXPECT_FALSE(exp_node.FuseInto(&mul_node));
+  exp_x->Unref();
+  EXPECT_TRUE(exp_node.FuseInto(&mul_node));
+
+  TF_ASSERT_OK(exp_node.Run());
+  TF_ASSERT_OK(mul_node.Run());
+  const Tensor* t = nullptr;
+  TF_ASSERT_OK(result->Tensor(&t));
+  test::ExpectTensorNear<float>(
+      *t, test::AsTensor<float>({2.0f, 2.0f * std::exp(1.0f)}), 1e-5);
+
+  x->Unref();
+  y->Unref();
+  result->Unref();
+  ctx->Unref();
+}
+
 }  // namespace
 }  // namespace tensorflow
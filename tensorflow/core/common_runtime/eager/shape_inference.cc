@@ -18,19 +18,131 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 namespace eager {
+namespace {
+
+// Bounds the memory used by workloads with constantly changing shapes.
+constexpr int kMaxShapeInferenceCacheEntries = 4096;
+
+// Returns the shape of input `i` of `ic`.
+PartialTensorShape InputShape(shape_inference::InferenceContext* ic, int i) {
+  const shape_inference::ShapeHandle input = ic->input(i);
+  const int32 rank = ic->Rank(input);
+  if (rank == shape_inference::InferenceContext::kUnknownRank) {
+    return PartialTensorShape();
+  }
+  gtl::InlinedVector<int64, 4> dims(rank);
+  for (int32 d = 0; d < rank; ++d) dims[d] = ic->Value(ic->Dim(input, d));
+  return PartialTensorShape(dims);
+}
+
+}  // namespace
+
+ShapeInferenceCache::ShapeInferenceCache(int max_entries)
+    : max_entries_(max_entries) {}
+
+ShapeInferenceCache* ShapeInferenceCache::Global() {
+  static ShapeInferenceCache* cache =
+      new ShapeInferenceCache(kMaxShapeInferenceCacheEntries);
+  return cache;
+}
+
+bool ShapeInferenceCache::KeyRefEq::operator()(const KeyRef& a,
+                                               const KeyRef& b) const {
+  if (a.hash != b.hash || *a.op != *b.op ||
+      a.attrs->size() != b.attrs->size() ||
+      a.input_shapes->size() != b.input_shapes->size()) {
+    return false;
+  }
+  for (const auto& attr : *a.attrs) {
+    const auto it = b.attrs->find(attr.first);
+    if (it == b.attrs->end() || !AreAttrValuesEqual(attr.second, it->second)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < a.input_shapes->size(); ++i) {
+    if (!(*a.input_shapes)[i].IsIdenticalTo((*b.input_shapes)[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ShapeInferenceCache::KeyRef ShapeInferenceCache::MakeKeyRef(
+    const NodeDef& ndef, const std::vector<PartialTensorShape>& input_shapes) {
+  uint64 hash = Hash64(ndef.op());
+  // Attrs are combined in an order independent way, since the iteration order
+  // of the attr map is unspecified.
+  uint64 attrs_hash = 0;
+  for (const auto& attr : ndef.attr()) {
+    attrs_hash +=
+        Hash64Combine(Hash64(attr.first), FastAttrValueHash(attr.second));
+  }
+  hash = Hash64Combine(hash, attrs_hash);
+  for (const PartialTensorShape& shape : input_shapes) {
+    hash = Hash64Combine(hash, static_cast<uint64>(shape.dims()));
+    for (int d = 0; d < shape.dims(); ++d) {
+      hash = Hash64Combine(hash, static_cast<uint64>(shape.dim_size(d)));
+    }
+  }
+  return {&ndef.op(), &ndef.attr(), &input_shapes, hash};
+}
+
+bool ShapeInferenceCache::Lookup(
+    const NodeDef& ndef, const std::vector<PartialTensorShape>& input_shapes,
+    std::vector<PartialTensorShape>* output_shapes) {
+  const KeyRef key = MakeKeyRef(ndef, input_shapes);
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return false;
+  lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  *output_shapes = it->second->output_shapes;
+  return true;
+}
+
+void ShapeInferenceCache::Insert(
+    const NodeDef& ndef, const std::vector<PartialTensorShape>& input_shapes,
+    std::vector<PartialTensorShape> output_shapes) {
+  const KeyRef key = MakeKeyRef(ndef, input_shapes);
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    // Another thread inserted the same results first.
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+    return;
+  }
+  lru_list_.push_front({ndef.op(), ndef.attr(), input_shapes,
+                        std::move(output_shapes), key.hash});
+  const Entry& entry = lru_list_.front();
+  entries_.emplace(
+      KeyRef{&entry.op, &entry.attrs, &entry.input_shapes, entry.hash},
+      lru_list_.begin());
+  if (lru_list_.size() > max_entries_) {
+    const Entry& lru = lru_list_.back();
+    entries_.erase(KeyRef{&lru.op, &lru.attrs, &lru.input_shapes, lru.hash});
+    lru_list_.pop_back();
+  }
+}
+
+int ShapeInferenceCache::size() const {
+  mutex_lock l(mu_);
+  return lru_list_.size();
+}
 
 Status RunShapeInference(const NodeDef& ndef,
                          const FunctionLibraryDefinition& lib_def,
                          const gtl::InlinedVector<TensorHandle*, 4>& inputs,
                          const gtl::InlinedVector<TensorHandle*, 2>& retvals) {
   const tensorflow::OpRegistrationData* op_reg_data;
-  // TODO(b/141209983): Consider adding a shape inference cache.
   // FunctionLibraryDefinition::LookUp delegates to global OpRegistry
   // if op is not a function.
   TF_RETURN_IF_ERROR(lib_def.LookUp(ndef.op(), &op_reg_data));
@@ -45,12 +157,37 @@ Status RunShapeInference(const NodeDef& ndef,
     ic.SetInput(i, shape);
   }
 
+  // Shape functions of ops with many distinct shape signatures can be costly
+  // (e.g. StridedSlice, Einsum), so only run them once per signature.
+  std::vector<PartialTensorShape> input_shapes(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    input_shapes[i] = InputShape(&ic, i);
+  }
+  std::vector<PartialTensorShape> output_shapes;
+  if (ShapeInferenceCache::Global()->Lookup(ndef, input_shapes,
+                                            &output_shapes) &&
+      output_shapes.size() == retvals.size()) {
+    for (int i = 0; i < output_shapes.size(); i++) {
+      shape_inference::ShapeHandle shape_handle;
+      TF_RETURN_IF_ERROR(
+          ic.MakeShapeFromPartialTensorShape(output_shapes[i], &shape_handle));
+      retvals[i]->SetInferenceShape(&ic, shape_handle);
+    }
+    return Status::OK();
+  }
+
   TF_RETURN_IF_ERROR(ic.Run(op_reg_data->shape_inference_fn));
   CHECK_EQ(ic.num_outputs(), retvals.size());
+  output_shapes.resize(ic.num_outputs());
   for (int i = 0; i < ic.num_outputs(); i++) {
     shape_inference::ShapeHandle shape_handle = ic.output(i);
     retvals[i]->SetInferenceShape(&ic, shape_handle);
+    TensorShapeProto shape_proto;
+    ic.ShapeHandleToProto(shape_handle, &shape_proto);
+    output_shapes[i] = PartialTensorShape(shape_proto);
   }
+  ShapeInferenceCache::Global()->Insert(ndef, input_shapes,
+                                        std::move(output_shapes));
   // TODO(slebedev): populate TensorHandle::handle_dtypes_and_shapes.
   return Status::OK();
 }
@@ -16,15 +16,88 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SHAPE_INFERENCE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_SHAPE_INFERENCE_H_
 
+#include <list>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace eager {
 
+// Cache of shape function results, with a least recently used eviction
+// policy. Since no input tensor values are given to the shape functions run
+// by RunShapeInference, their output shapes depend only on the op, its attrs
+// and its input shapes, which make up the cache key.
+class ShapeInferenceCache {
+ public:
+  explicit ShapeInferenceCache(int max_entries);
+
+  // The cache used by RunShapeInference.
+  static ShapeInferenceCache* Global();
+
+  // Sets `output_shapes` and returns true if results are cached for the op
+  // and attrs of `ndef` with `input_shapes`.
+  bool Lookup(const NodeDef& ndef,
+              const std::vector<PartialTensorShape>& input_shapes,
+              std::vector<PartialTensorShape>* output_shapes);
+
+  // Caches `output_shapes` for the op and attrs of `ndef` with
+  // `input_shapes`, evicting the least recently used results if the cache is
+  // full.
+  void Insert(const NodeDef& ndef,
+              const std::vector<PartialTensorShape>& input_shapes,
+              std::vector<PartialTensorShape> output_shapes);
+
+  int size() const;
+
+ private:
+  // The parts of a key, which point either to a cached entry or to the
+  // arguments of a lookup.
+  struct KeyRef {
+    const string* op;
+    const AttrValueMap* attrs;
+    const std::vector<PartialTensorShape>* input_shapes;
+    uint64 hash;
+  };
+  struct KeyRefHash {
+    size_t operator()(const KeyRef& key) const { return key.hash; }
+  };
+  struct KeyRefEq {
+    bool operator()(const KeyRef& a, const KeyRef& b) const;
+  };
+
+  struct Entry {
+    string op;
+    AttrValueMap attrs;
+    std::vector<PartialTensorShape> input_shapes;
+    std::vector<PartialTensorShape> output_shapes;
+    uint64 hash;
+  };
+
+  static KeyRef MakeKeyRef(const NodeDef& ndef,
+                           const std::vector<PartialTensorShape>& input_shapes);
+
+  const int max_entries_;
+
+  mutable mutex mu_;
+  // The most recently used entry is at the front. The list owns the entries,
+  // so that the keys of `entries_` can point into them.
+  std::list<Entry> lru_list_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<KeyRef, std::list<Entry>::iterator, KeyRefHash, KeyRefEq>
+      entries_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShapeInferenceCache);
+};
+
 Status RunShapeInference(const NodeDef& ndef,
                          const FunctionLibraryDefinition& lib_def,
                          const gtl::InlinedVector<TensorHandle*, 4>& inputs,
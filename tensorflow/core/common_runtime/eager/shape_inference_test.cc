@@ -0,0 +1,120 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/shape_inference.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+NodeDef MakeNodeDef(const string& op, int64 axis) {
+  NodeDef ndef;
+  ndef.set_op(op);
+  AddNodeAttr("T", DT_FLOAT, &ndef);
+  AddNodeAttr("axis", axis, &ndef);
+  return ndef;
+}
+
+// Returns the output shapes cached for `ndef` and `input_shapes`, or
+// an empty vector if there is none.
+std::vector<PartialTensorShape> Lookup(
+    ShapeInferenceCache* cache, const NodeDef& ndef,
+    const std::vector<PartialTensorShape>& input_shapes) {
+  std::vector<PartialTensorShape> output_shapes;
+  if (!cache->Lookup(ndef, input_shapes, &output_shapes)) return {};
+  return output_shapes;
+}
+
+bool IsCached(ShapeInferenceCache* cache, const NodeDef& ndef,
+              const std::vector<PartialTensorShape>& input_shapes) {
+  return !Lookup(cache, ndef, input_shapes).empty();
+}
+
+TEST(ShapeInferenceCacheTest, ReturnsInsertedShapes) {
+  ShapeInferenceCache cache(/*max_entries=*/8);
+  const NodeDef ndef = MakeNodeDef("ExpandDims", 1);
+  cache.Insert(ndef, {PartialTensorShape({2, 3})},
+               {PartialTensorShape({2, 1, 3})});
+
+  const std::vector<PartialTensorShape> output_shapes =
+      Lookup(&cache, ndef, {PartialTensorShape({2, 3})});
+  ASSERT_EQ(1, output_shapes.size());
+  EXPECT_TRUE(output_shapes[0].IsIdenticalTo(PartialTensorShape({2, 1, 3})));
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST(ShapeInferenceCacheTest, ComparesFullKey) {
+  ShapeInferenceCache cache(/*max_entries=*/8);
+  cache.Insert(MakeNodeDef("ExpandDims", 1), {PartialTensorShape({2, -1})},
+               {PartialTensorShape({2, 1, -1})});
+
+  EXPECT_TRUE(IsCached(&cache, MakeNodeDef("ExpandDims", 1),
+                       {PartialTensorShape({2, -1})}));
+  // A different op.
+  EXPECT_FALSE(IsCached(&cache, MakeNodeDef("Squeeze", 1),
+                        {PartialTensorShape({2, -1})}));
+  // A different attr value.
+  EXPECT_FALSE(IsCached(&cache, MakeNodeDef("ExpandDims", 0),
+                        {PartialTensorShape({2, -1})}));
+  // An extra attr.
+  NodeDef extra_attr = MakeNodeDef("ExpandDims", 1);
+  AddNodeAttr("Tdim", DT_INT32, &extra_attr);
+  EXPECT_FALSE(IsCached(&cache, extra_attr, {PartialTensorShape({2, -1})}));
+  // Different input shapes, including less defined ones.
+  EXPECT_FALSE(IsCached(&cache, MakeNodeDef("ExpandDims", 1),
+                        {PartialTensorShape({2, 3})}));
+  EXPECT_FALSE(IsCached(&cache, MakeNodeDef("ExpandDims", 1),
+                        {PartialTensorShape({-1, -1})}));
+  EXPECT_FALSE(
+      IsCached(&cache, MakeNodeDef("ExpandDims", 1), {PartialTensorShape()}));
+  EXPECT_FALSE(IsCached(&cache, MakeNodeDef("ExpandDims", 1),
+                        {PartialTensorShape({2, -1}), PartialTensorShape()}));
+}
+
+TEST(ShapeInferenceCacheTest, EvictsLeastRecentlyUsedEntry) {
+  ShapeInferenceCache cache(/*max_entries=*/2);
+  const NodeDef ndef = MakeNodeDef("ExpandDims", 0);
+  const PartialTensorShape a({1});
+  const PartialTensorShape b({2});
+  const PartialTensorShape c({3});
+  cache.Insert(ndef, {a}, {PartialTensorShape({1, 1})});
+  cache.Insert(ndef, {b}, {PartialTensorShape({1, 2})});
+  // Using a makes b the least recently used entry.
+  EXPECT_TRUE(IsCached(&cache, ndef, {a}));
+  cache.Insert(ndef, {c}, {PartialTensorShape({1, 3})});
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_TRUE(IsCached(&cache, ndef, {a}));
+  EXPECT_FALSE(IsCached(&cache, ndef, {b}));
+  EXPECT_TRUE(IsCached(&cache, ndef, {c}));
+
+  // Inserting a cached key again only marks it as used.
+  cache.Insert(ndef, {c}, {PartialTensorShape({1, 3})});
+  cache.Insert(ndef, {b}, {PartialTensorShape({1, 2})});
+  EXPECT_EQ(2, cache.size());
+  EXPECT_FALSE(IsCached(&cache, ndef, {a}));
+  EXPECT_TRUE(IsCached(&cache, ndef, {b}));
+  EXPECT_TRUE(IsCached(&cache, ndef, {c}));
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
@@ -62,8 +62,65 @@ string SafeDeviceDebugString(Device* device) {
     return device->DebugString();
   }
 }
+
+// Maximum number of released TensorHandle blocks each thread keeps around.
+constexpr int kMaxCachedHandleBlocks = 64;
+
+// Set once the calling thread's HandleBlockCache has been destroyed, so that
+// handles released during thread teardown bypass the cache.
+thread_local bool handle_block_cache_destroyed = false;
+
+// Fixed-capacity stack of raw sizeof(TensorHandle) blocks. Handles are usually
+// created and released on the same thread, but a block freed on another thread
+// simply migrates to that thread's cache.
+class HandleBlockCache {
+ public:
+  ~HandleBlockCache() {
+    handle_block_cache_destroyed = true;
+    for (int i = 0; i < num_blocks_; ++i) {
+      ::operator delete(blocks_[i]);
+    }
+  }
+
+  void* Pop() { return num_blocks_ > 0 ? blocks_[--num_blocks_] : nullptr; }
+
+  bool Push(void* block) {
+    if (num_blocks_ == kMaxCachedHandleBlocks) return false;
+    blocks_[num_blocks_++] = block;
+    return true;
+  }
+
+ private:
+  void* blocks_[kMaxCachedHandleBlocks];
+  int num_blocks_ = 0;
+};
+
+HandleBlockCache* GetHandleBlockCache() {
+#if defined(ADDRESS_SANITIZER) || defined(MEMORY_SANITIZER)
+  // Recycling blocks would hide use-after-free bugs from the sanitizers.
+  return nullptr;
+#else
+  if (handle_block_cache_destroyed) return nullptr;
+  static thread_local HandleBlockCache cache;
+  return &cache;
+#endif
+}
 }  // namespace
 
+void* TensorHandle::operator new(size_t size) {
+  DCHECK_EQ(size, sizeof(TensorHandle));
+  HandleBlockCache* cache = GetHandleBlockCache();
+  void* block = cache != nullptr ? cache->Pop() : nullptr;
+  return block != nullptr ? block : ::operator new(size);
+}
+
+void TensorHandle::operator delete(void* ptr) {
+  HandleBlockCache* cache = GetHandleBlockCache();
+  if (cache == nullptr || !cache->Push(ptr)) {
+    ::operator delete(ptr);
+  }
+}
+
 TensorHandle::PackedTensorHandleData::PackedTensorHandleData(
     std::vector<TensorHandle*>&& handles, const TensorShape& shape)
     : handles_(std::move(handles)), shape_(shape) {
@@ -72,6 +72,12 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
 #endif  // IS_MOBILE_PLATFORM
 
  public:
+  // TensorHandles are created and released for every eager op output. Their
+  // storage is recycled through a small per-thread free list rather than going
+  // back to the global allocator each time.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+
   // TensorHandle with no assigned device
   static TensorHandle* CreateLocalHandle(const tensorflow::Tensor& t);
   static TensorHandle* CreateLocalHandle(tensorflow::Tensor&& t, Device* d,
@@ -104,19 +104,23 @@ string LocalTensorHandleData::DebugString() const {
 
 void LocalTensorHandleData::BlockingControl::SetReady() {
   mutex_lock l(mu_);
-  is_ready_ = true;
+  is_ready_.store(true, std::memory_order_release);
 }
 
 Status LocalTensorHandleData::BlockingControl::WaitReady(
     const char* caller) const {
+  if (IsReady()) return is_poisoned_;
+
   tf_shared_lock l(mu_);
-  if (!is_ready_) {
+  if (!IsReady()) {
     profiler::TraceMe activity(
         [caller] { return absl::StrCat(caller, " WaitReady"); },
 
         profiler::TraceMeLevel::kInfo);
     DVLOG(3) << "WaitReady: " << caller << " " << this;
-    mu_.Await(Condition(&is_ready_));
+    mu_.Await(Condition(
+        +[](const std::atomic<bool>* ready) { return ready->load(); },
+        &is_ready_));
   }
 
   return is_poisoned_;
@@ -124,12 +128,19 @@ Status LocalTensorHandleData::BlockingControl::WaitReady(
 
 void LocalTensorHandleData::BlockingControl::Poison(Status status) {
   mutex_lock l(mu_);
-  if (is_ready_) {
+  if (IsReady()) {
     LOG(ERROR) << "Poison can only be called on non-ready handle: " << this;
     return;
   }
   is_poisoned_ = status;
-  is_ready_ = true;
+  is_ready_.store(true, std::memory_order_release);
+}
+
+Status LocalTensorHandleData::BlockingControl::IsPoisoned() const {
+  if (IsReady()) return is_poisoned_;
+
+  tf_shared_lock l(mu_);
+  return is_poisoned_;
 }
 
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TENSOR_HANDLE_DATA_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_TENSOR_HANDLE_DATA_H_
 
+#include <atomic>
+
 #include "absl/types/variant.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -82,24 +84,24 @@ class LocalTensorHandleData {
     Status IsPoisoned() const { return Status::OK(); }
   };
 
+  // Once is_ready_ has been published, is_poisoned_ is immutable and both are
+  // read without taking mu_. The mutex is only used to wait for readiness and
+  // to serialize the transition to the ready state, so handles produced by
+  // async execution become as cheap to query as NonBlockingControl ones once
+  // their tensor has been set.
   class BlockingControl {
    public:
-    bool IsReady() const {
-      tf_shared_lock l(mu_);
-      return is_ready_;
-    }
+    bool IsReady() const { return is_ready_.load(std::memory_order_acquire); }
     void SetReady();
     Status WaitReady(const char* caller) const;
     void Poison(Status status);
-    Status IsPoisoned() const {
-      tf_shared_lock l(mu_);
-      return is_poisoned_;
-    }
+    Status IsPoisoned() const;
 
    private:
     mutable mutex mu_;
-    bool is_ready_ TF_GUARDED_BY(mu_);
-    Status is_poisoned_ TF_GUARDED_BY(mu_);
+    std::atomic<bool> is_ready_{false};
+    // Written under mu_ only before is_ready_ is set.
+    Status is_poisoned_;
   };
 
   absl::variant<NonBlockingControl, BlockingControl> ctrl_;
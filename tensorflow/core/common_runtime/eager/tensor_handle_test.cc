@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -66,6 +68,51 @@ TEST(TensorHandle_ShapeTest, AsyncShape) {
   ctx->Unref();
 }
 
+TEST(TensorHandle_ShapeTest, AsyncHandleBecomesReady) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  TensorHandle* async_th = TensorHandle::CreateEmptyLocalHandle(
+      nullptr, nullptr, nullptr, DataType::DT_FLOAT, ctx);
+
+  Notification done;
+  TensorShape shape;
+  std::unique_ptr<Thread> waiter(Env::Default()->StartThread(
+      {}, "waiter", [async_th, &shape, &done] {
+        TF_EXPECT_OK(async_th->Shape(&shape));
+        done.Notify();
+      }));
+  TF_ASSERT_OK(async_th->SetTensor(Tensor(DT_FLOAT, TensorShape({3, 5})),
+                                   nullptr));
+  done.WaitForNotification();
+  EXPECT_EQ(shape, TensorShape({3, 5}));
+
+  // Once ready, queries are answered without blocking.
+  const Tensor* t = nullptr;
+  TF_EXPECT_OK(async_th->Tensor(&t));
+  EXPECT_EQ(t->NumElements(), 15);
+
+  async_th->Unref();
+  ctx->Unref();
+}
+
+#if !defined(ADDRESS_SANITIZER) && !defined(MEMORY_SANITIZER)
+TEST(TensorHandle_AllocationTest, ReleasedStorageIsReused) {
+  TensorHandle* first = TensorHandle::CreateLocalHandle(Tensor(1.0f));
+  const void* first_address = first;
+  first->Unref();
+  TensorHandle* second = TensorHandle::CreateLocalHandle(Tensor(2.0f));
+  EXPECT_EQ(first_address, second);
+  const Tensor* t = nullptr;
+  TF_EXPECT_OK(second->Tensor(&t));
+  EXPECT_EQ(t->scalar<float>()(), 2.0f);
+  second->Unref();
+}
+#endif
+
 static Device* CreateDevice(const char* type, const char* name,
                             bool is_local = true) {
   class FakeDevice : public Device {
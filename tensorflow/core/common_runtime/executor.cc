@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -56,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -71,6 +73,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/ThreadPool"
 
 namespace tensorflow {
 
@@ -134,13 +137,28 @@ struct KernelTimer {
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+// Identifies the work-stealing worker (if any) that is running on the current
+// thread. `executor_state` is the `ExecutorState` that owns the worker, and is
+// used to ignore workers that belong to other (e.g. nested) executors.
+struct WorkStealingWorkerContext {
+  const void* executor_state = nullptr;
+  int worker_id = -1;
+};
+thread_local WorkStealingWorkerContext current_work_stealing_worker;
+
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  // If `num_work_stealing_workers` is greater than zero, each step dispatches
+  // ready nodes to up to that many workers with per-worker ready queues,
+  // instead of scheduling one closure per node on the inter-op threadpool.
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        int num_work_stealing_workers = 0)
+      : immutable_state_(p),
+        num_work_stealing_workers_(num_work_stealing_workers) {}
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
-    kernel_stats_.Initialize(immutable_state_.graph_view());
+    kernel_stats_.Initialize(immutable_state_);
     return Status::OK();
   }
 
@@ -155,15 +173,27 @@ class ExecutorImpl : public Executor {
    public:
     KernelStats() = default;
 
-    void Initialize(const GraphView& gview) {
+    void Initialize(const ImmutableExecutorState& immutable_state) {
+      const GraphView& gview = immutable_state.graph_view();
       is_expensive_.resize(gview.num_nodes());
       cost_estimates_ =
           absl::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
+      // Used to convert static cost estimates from nanoseconds to cycles.
+      const double cycles_per_ns =
+          profile_utils::CpuUtils::GetCycleCounterFrequency() / 1.0e9;
       for (int32 i = 0; i < gview.num_nodes(); ++i) {
         if (gview.node(i)) {
           is_expensive_[i] =
               gview.node(i)->kernel && gview.node(i)->kernel->IsExpensive();
-          cost_estimates_[i] = kInitialCostEstimateCycles;
+          const int64 cost_estimate_ns = immutable_state.cost_estimate_ns(i);
+          if (cost_estimate_ns >= 0 && cycles_per_ns > 0) {
+            // Start from the static estimate, so that the node is classified
+            // correctly before its execution time has been measured.
+            cost_estimates_[i] =
+                static_cast<uint64>(cost_estimate_ns * cycles_per_ns);
+          } else {
+            cost_estimates_[i] = kInitialCostEstimateCycles;
+          }
         }
       }
     }
@@ -214,6 +244,7 @@ class ExecutorImpl : public Executor {
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  const int num_work_stealing_workers_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -245,6 +276,8 @@ class ExecutorImpl : public Executor {
 //   * `void clear()`
 //   * `const_iterator begin() const`
 //   * `const_iterator end() const`
+//   `TaggedNode` must be default constructible, and a value-initialized
+//   `TaggedNode` must have a null `node_item`.
 // * A public constructor, `PropagatorStateType(const ImmutableExecutorState&
 //   immutable_state, int64 step_id)`.
 // * The following public methods:
@@ -272,7 +305,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                int num_work_stealing_workers);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -285,6 +319,7 @@ class ExecutorState {
   typedef typename PropagatorStateType::TaggedNodeSeq TaggedNodeSeq;
 
   struct AsyncState;
+  struct WorkStealingState;
 
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64 scheduled_nsec);
@@ -324,6 +359,43 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Work-stealing variant of `ScheduleReady()`. When called from one of this
+  // step's workers, keeps at most one node in `*inline_ready` and pushes the
+  // remaining nodes onto the front of the worker's own ready queue, where idle
+  // workers can steal them from the back. Otherwise, hands the nodes to the
+  // shared injection queue and starts workers to drain it.
+  //
+  // This method will clear `*ready` before returning.
+  void ScheduleReadyWorkStealing(TaggedNodeSeq* ready,
+                                 TaggedNodeReadyQueue* inline_ready);
+
+  // Adds `nodes` to the shared injection queue of the work-stealing scheduler
+  // and starts workers for them if any worker slots are free.
+  void InjectWorkStealing(const TaggedNodeSeq& nodes);
+
+  // Starts the workers whose slots were claimed with
+  // `WorkStealingState::ClaimWorkerSlotsLocked()`.
+  void StartWorkers(const std::vector<int>& worker_ids);
+
+  // Main loop of a work-stealing worker.
+  void RunWorker(int worker_id);
+
+  // Finds the next node for the given worker to run, first from its own ready
+  // queue, then by stealing from other workers, and finally from the shared
+  // injection queue. Returns false, and releases the worker's slot, if no work
+  // is available. In that case, `*finish` is set to true if this was the last
+  // active worker of a completed step, and the caller must call
+  // `ScheduleFinish()`.
+  bool NextWorkStealingNode(int worker_id, TaggedNode* node, bool* finish);
+
+  // Returns the id of the worker of this step that is running on the current
+  // thread, or -1 if the current thread is not one of this step's workers.
+  int CurrentWorkerId() const {
+    return current_work_stealing_worker.executor_state == this
+               ? current_work_stealing_worker.worker_id
+               : -1;
+  }
+
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
   // directly.
@@ -334,6 +406,12 @@ class ExecutorState {
   void Finish();
   void ScheduleFinish();
 
+  // Called when the last outstanding op of the step has completed. In
+  // work-stealing mode, the call to `ScheduleFinish()` is deferred until all
+  // workers have retired, because workers still access `this` after running
+  // their last node.
+  void OnCompleted();
+
   // Contains the device context assigned by the device at the beginning of a
   // step.
   DeviceContext* device_context_ = nullptr;
@@ -372,6 +450,9 @@ class ExecutorState {
 
   PropagatorStateType propagator_;
 
+  // Non-null iff this step uses the work-stealing scheduler.
+  std::unique_ptr<WorkStealingState> work_stealing_;
+
   // Invoked when the execution finishes.
   Executor::DoneCallback done_cb_;
 
@@ -387,10 +468,86 @@ class ExecutorState {
   Status status_ TF_GUARDED_BY(mu_);
 };
 
+// Per-step state of the work-stealing scheduler.
+//
+// Each worker slot owns a ready queue. The worker that currently holds the slot
+// pushes and pops nodes at the front of the queue without locking, and other
+// workers steal from the back of the queue. Nodes that become ready on threads
+// that are not workers of this step (e.g. in the callback of an asynchronous
+// kernel) are added to the shared `injected` queue.
+//
+// Ready queues are allocated when their slot is first claimed, so that a step
+// only pays for the workers that it actually uses.
+template <class PropagatorStateType>
+struct ExecutorState<PropagatorStateType>::WorkStealingState {
+  // Capacity of each per-worker ready queue. When a queue is full, additional
+  // nodes are added to `injected`.
+  static constexpr unsigned kReadyQueueSize = 1024;
+  typedef Eigen::RunQueue<TaggedNode, kReadyQueueSize> ReadyQueue;
+
+  explicit WorkStealingState(int num_workers)
+      : num_workers(num_workers),
+        ready_queues(new std::atomic<ReadyQueue*>[num_workers]),
+        worker_active(num_workers, false) {
+    for (int i = 0; i < num_workers; ++i) {
+      ready_queues[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~WorkStealingState() {
+    for (int i = 0; i < num_workers; ++i) {
+      delete ready_queues[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  // Returns the ready queue of the given worker slot, or nullptr if the slot
+  // has never been claimed.
+  ReadyQueue* ready_queue(int worker_id) const {
+    return ready_queues[worker_id].load(std::memory_order_acquire);
+  }
+
+  // Claims up to `max_workers` free worker slots and returns their ids in
+  // `*worker_ids`. The caller must start the workers after releasing `mu`,
+  // since `runner_` may run them inline.
+  void ClaimWorkerSlotsLocked(int max_workers, std::vector<int>* worker_ids)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu) {
+    for (int i = 0; i < num_workers && max_workers > 0 &&
+                    num_active_workers < num_workers;
+         ++i) {
+      if (!worker_active[i]) {
+        if (ready_queues[i].load(std::memory_order_relaxed) == nullptr) {
+          ready_queues[i].store(new ReadyQueue, std::memory_order_release);
+        }
+        worker_active[i] = true;
+        ++num_active_workers;
+        --max_workers;
+        worker_ids->push_back(i);
+      }
+    }
+    num_active_workers_hint.store(num_active_workers,
+                                  std::memory_order_relaxed);
+  }
+
+  const int num_workers;
+  // Only written under `mu`, but read without locking by stealing workers.
+  std::unique_ptr<std::atomic<ReadyQueue*>[]> ready_queues;
+
+  // A lock-free approximation of `num_active_workers`, which is used to avoid
+  // acquiring `mu` when all worker slots are already taken.
+  std::atomic<int> num_active_workers_hint{0};
+
+  mutex mu;
+  std::deque<TaggedNode> injected TF_GUARDED_BY(mu);
+  std::vector<bool> worker_active TF_GUARDED_BY(mu);
+  int num_active_workers TF_GUARDED_BY(mu) = 0;
+  // True if the step has completed while workers were still active.
+  bool finish_pending TF_GUARDED_BY(mu) = false;
+};
+
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, int num_work_stealing_workers)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -420,6 +577,12 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  // When all kernels run inline, a single closure already executes the whole
+  // step, so there is nothing to steal.
+  if (num_work_stealing_workers > 0 && !run_all_kernels_inline_) {
+    work_stealing_ =
+        absl::make_unique<WorkStealingState>(num_work_stealing_workers);
+  }
 }
 
 template <class PropagatorStateType>
@@ -627,7 +790,7 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
     outputs.clear();
     const bool completed = NodeDone(s, &ready, stats, nullptr);
     delete state;
-    if (completed) ScheduleFinish();
+    if (completed) OnCompleted();
   };
   nodestats::SetOpStart(stats);
   {
@@ -731,9 +894,6 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
     if (finish_when_deferred_ops_done) Finish();
   };
 
-  // Set the device_context for this device, if it exists.
-  params.op_device_context = device_context_;
-
   Status s;
   NodeExecStatsInterface* stats = nullptr;
 
@@ -749,6 +909,13 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
     propagator_.MaybeMarkStarted(tagged_node);
 
+    // Set the device_context for this node, falling back to the one for this
+    // device.
+    DeviceContext* node_device_context = immutable_state_.device_context(id);
+    params.op_device_context = node_device_context != nullptr
+                                   ? node_device_context
+                                   : device_context_;
+
     params.track_allocations = false;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.get_is_dead()) {
@@ -846,7 +1013,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   }  // while !inline_ready.empty()
 
   // This thread of computation is done if completed = true.
-  if (completed) ScheduleFinish();
+  if (completed) OnCompleted();
 }
 
 template <class PropagatorStateType>
@@ -1143,6 +1310,11 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
   DCHECK(!ready->empty());
 
+  if (work_stealing_ != nullptr) {
+    ScheduleReadyWorkStealing(ready, inline_ready);
+    return;
+  }
+
   int64 scheduled_nsec = 0;
   if (stats_collector_) {
     scheduled_nsec = nodestats::NowInNsec();
@@ -1166,11 +1338,37 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     }
   } else {
     const TaggedNode* curr_expensive_node = nullptr;
-    if (inline_ready == nullptr) {
+    if (inline_ready == nullptr && !immutable_state_.has_cost_estimates()) {
       // Schedule to run all the ready ops in thread pool.
       for (auto& tagged_node : *ready) {
         RunTask([=]() { Process(tagged_node, scheduled_nsec); });
       }
+    } else if (inline_ready == nullptr) {
+      // Schedule to run all the ready ops in thread pool. When the graph has
+      // static cost estimates, inexpensive ops are run from a single closure,
+      // which amortizes the closure creation and thread wakeup overhead across
+      // them. Any inexpensive successors of these ops are then run inline by
+      // `Process()`.
+      TaggedNodeSeq inexpensive_nodes;
+      for (auto& tagged_node : *ready) {
+        const NodeItem& item = *tagged_node.node_item;
+        if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
+          inexpensive_nodes.push_back(tagged_node);
+        } else {
+          RunTask([=]() { Process(tagged_node, scheduled_nsec); });
+        }
+      }
+      if (inexpensive_nodes.size() == 1) {
+        RunTask(std::bind(&ExecutorState::Process, this, inexpensive_nodes[0],
+                          scheduled_nsec));
+      } else if (!inexpensive_nodes.empty()) {
+        RunTask([this, inexpensive_nodes = std::move(inexpensive_nodes),
+                 scheduled_nsec]() {
+          for (auto& tagged_node : inexpensive_nodes) {
+            Process(tagged_node, scheduled_nsec);
+          }
+        });
+      }
     } else {
       for (auto& tagged_node : *ready) {
         const NodeItem& item = *tagged_node.node_item;
@@ -1202,6 +1400,148 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleReadyWorkStealing(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
+  const int worker_id = CurrentWorkerId();
+  if (worker_id < 0) {
+    // Nodes that become ready outside of a worker (the roots of the step, or
+    // the successors of an asynchronous kernel that completed on another
+    // thread) cannot be pushed onto a per-worker queue.
+    InjectWorkStealing(*ready);
+    ready->clear();
+    return;
+  }
+
+  auto it = ready->begin();
+  if (inline_ready != nullptr && inline_ready->empty()) {
+    // Continue with one of the ready nodes on this thread, as the
+    // non-work-stealing path does.
+    inline_ready->push_back(*it);
+    ++it;
+  }
+  if (it == ready->end()) {
+    ready->clear();
+    return;
+  }
+
+  typename WorkStealingState::ReadyQueue& queue =
+      *work_stealing_->ready_queue(worker_id);
+  TaggedNodeSeq overflow;
+  for (; it != ready->end(); ++it) {
+    TaggedNode rejected = queue.PushFront(*it);
+    if (rejected.node_item != nullptr) {
+      overflow.push_back(rejected);
+    }
+  }
+  ready->clear();
+
+  if (!overflow.empty()) {
+    InjectWorkStealing(overflow);
+  } else if (work_stealing_->num_active_workers_hint.load(
+                 std::memory_order_relaxed) < work_stealing_->num_workers) {
+    // Wake up one more worker to steal the nodes that were just queued.
+    std::vector<int> worker_ids;
+    {
+      mutex_lock l(work_stealing_->mu);
+      work_stealing_->ClaimWorkerSlotsLocked(1, &worker_ids);
+    }
+    StartWorkers(worker_ids);
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::InjectWorkStealing(
+    const TaggedNodeSeq& nodes) {
+  std::vector<int> worker_ids;
+  {
+    mutex_lock l(work_stealing_->mu);
+    work_stealing_->injected.insert(work_stealing_->injected.end(),
+                                    nodes.begin(), nodes.end());
+    work_stealing_->ClaimWorkerSlotsLocked(nodes.size(), &worker_ids);
+  }
+  StartWorkers(worker_ids);
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::StartWorkers(
+    const std::vector<int>& worker_ids) {
+  for (int worker_id : worker_ids) {
+    RunTask([this, worker_id]() { RunWorker(worker_id); });
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunWorker(int worker_id) {
+  // Workers of nested executors may run on this thread (e.g. when `runner_`
+  // runs closures inline), so restore the previous context when done.
+  const WorkStealingWorkerContext saved_context = current_work_stealing_worker;
+  current_work_stealing_worker.executor_state = this;
+  current_work_stealing_worker.worker_id = worker_id;
+
+  TaggedNode tagged_node;
+  bool finish = false;
+  while (NextWorkStealingNode(worker_id, &tagged_node, &finish)) {
+    Process(tagged_node, stats_collector_ ? nodestats::NowInNsec() : 0);
+  }
+
+  current_work_stealing_worker = saved_context;
+  // NOTE: `this` may only be accessed by the last worker of a completed step
+  // from this point on.
+  if (finish) ScheduleFinish();
+}
+
+template <class PropagatorStateType>
+bool ExecutorState<PropagatorStateType>::NextWorkStealingNode(
+    int worker_id, TaggedNode* node, bool* finish) {
+  WorkStealingState* ws = work_stealing_.get();
+
+  // Most recently readied nodes come first, since their inputs are most
+  // likely to still be in cache.
+  *node = ws->ready_queue(worker_id)->PopFront();
+  if (node->node_item != nullptr) return true;
+
+  // Steal the oldest node of another worker.
+  for (int i = 1; i < ws->num_workers; ++i) {
+    const int victim = (worker_id + i) % ws->num_workers;
+    typename WorkStealingState::ReadyQueue* queue = ws->ready_queue(victim);
+    if (queue == nullptr) continue;
+    *node = queue->PopBack();
+    if (node->node_item != nullptr) return true;
+  }
+
+  mutex_lock l(ws->mu);
+  if (!ws->injected.empty()) {
+    *node = ws->injected.front();
+    ws->injected.pop_front();
+    return true;
+  }
+
+  // Retire this worker. Only the owner of a slot pushes onto its ready queue,
+  // so the queue is empty at this point, and nodes on the ready queues of other
+  // active workers will be run by those workers. Nodes that are injected after
+  // this point will start a new worker.
+  ws->worker_active[worker_id] = false;
+  --ws->num_active_workers;
+  ws->num_active_workers_hint.store(ws->num_active_workers,
+                                    std::memory_order_relaxed);
+  *finish = ws->finish_pending && ws->num_active_workers == 0;
+  return false;
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::OnCompleted() {
+  if (work_stealing_ != nullptr) {
+    mutex_lock l(work_stealing_->mu);
+    if (work_stealing_->num_active_workers > 0) {
+      // The last worker to retire will call `ScheduleFinish()`.
+      work_stealing_->finish_pending = true;
+      return;
+    }
+  }
+  ScheduleFinish();
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1339,11 +1679,12 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        num_work_stealing_workers_))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, num_work_stealing_workers_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1397,6 +1738,30 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers an executor that dispatches ready nodes to per-worker ready queues
+// with work stealing, instead of scheduling one closure per node on the
+// inter-op threadpool. This reduces closure creation and threadpool contention
+// for graphs with many inexpensive nodes.
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING_EXECUTOR", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl = absl::make_unique<ExecutorImpl>(
+          params, /*num_work_stealing_workers=*/port::MaxParallelism());
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -0,0 +1,91 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/executor_cost_annotation_pass.h"
+
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/immutable_executor_state.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+
+Status AnnotateExecutorCostEstimates(Graph* graph) {
+  grappler::GrapplerItem item;
+  item.id = "executor_cost_annotation";
+  graph->ToGraphDef(&item.graph);
+
+  grappler::GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  grappler::OpLevelCostEstimator estimator;
+  int num_annotated = 0;
+  for (Node* n : graph->op_nodes()) {
+    auto it = name_to_node.find(n->name());
+    if (it == name_to_node.end() || !properties.HasInputProperties(n->name())) {
+      continue;
+    }
+    grappler::OpContext op_context;
+    op_context.name = n->name();
+    op_context.device_name = n->assigned_device_name();
+    op_context.op_info = grappler::BuildOpInfoWithoutDevice(
+        *it->second, name_to_node, properties.GetInputProperties(n->name()));
+    *op_context.op_info.mutable_device() =
+        grappler::GetDeviceInfo(n->assigned_device_name());
+
+    const grappler::Costs costs = estimator.PredictCosts(op_context);
+    if (costs.inaccurate) continue;
+    n->AddAttr(kExecutorCostEstimateNsAttr,
+               static_cast<int64>(costs.execution_time.count()));
+    ++num_annotated;
+  }
+  VLOG(1) << "Annotated " << num_annotated << " of " << graph->num_op_nodes()
+          << " nodes with executor cost estimates";
+  return Status::OK();
+}
+
+Status ExecutorCostAnnotationPass::Run(
+    const GraphOptimizationPassOptions& options) {
+  if (options.session_options == nullptr ||
+      !options.session_options->config.experimental()
+           .annotate_executor_cost_estimates() ||
+      options.partition_graphs == nullptr) {
+    return Status::OK();
+  }
+  for (auto& partition : *options.partition_graphs) {
+    TF_RETURN_IF_ERROR(AnnotateExecutorCostEstimates(partition.second.get()));
+  }
+  return Status::OK();
+}
+
+// Runs after the other POST_PARTITIONING passes, which may rewrite the graph.
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_PARTITIONING, 100,
+                      ExecutorCostAnnotationPass);
+
+}  // namespace tensorflow
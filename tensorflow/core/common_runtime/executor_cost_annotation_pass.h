@@ -0,0 +1,41 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EXECUTOR_COST_ANNOTATION_PASS_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EXECUTOR_COST_ANNOTATION_PASS_H_
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Estimates the execution time of every node in `graph` with the grappler
+// `OpLevelCostEstimator`, using statically inferred input shapes, and stores
+// the estimate (in nanoseconds) in the node's `kExecutorCostEstimateNsAttr`
+// attribute. Nodes whose cost cannot be estimated accurately (e.g. because an
+// input shape is unknown, or the op has no cost model) are not annotated.
+Status AnnotateExecutorCostEstimates(Graph* graph);
+
+// Runs `AnnotateExecutorCostEstimates()` on each partition graph when
+// `ConfigProto.Experimental.annotate_executor_cost_estimates` is set.
+class ExecutorCostAnnotationPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EXECUTOR_COST_ANNOTATION_PASS_H_
@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/executor_cost_annotation_pass.h"
+
+#include "tensorflow/core/common_runtime/immutable_executor_state.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kCpuDevice[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+TEST(ExecutorCostAnnotationPassTest, AnnotatesNodesWithKnownShapes) {
+  Graph g(OpRegistry::Global());
+  Tensor small(DT_FLOAT, TensorShape({2, 2}));
+  small.flat<float>().setZero();
+  Tensor large(DT_FLOAT, TensorShape({512, 512}));
+  large.flat<float>().setZero();
+  Node* small_matmul =
+      test::graph::Matmul(&g, test::graph::Constant(&g, small),
+                          test::graph::Constant(&g, small), false, false);
+  Node* large_matmul =
+      test::graph::Matmul(&g, test::graph::Constant(&g, large),
+                          test::graph::Constant(&g, large), false, false);
+  for (Node* n : g.op_nodes()) {
+    n->set_assigned_device_name(kCpuDevice);
+  }
+
+  TF_ASSERT_OK(AnnotateExecutorCostEstimates(&g));
+
+  int64 small_cost_ns = -1;
+  int64 large_cost_ns = -1;
+  ASSERT_TRUE(TryGetNodeAttr(small_matmul->attrs(), kExecutorCostEstimateNsAttr,
+                             &small_cost_ns));
+  ASSERT_TRUE(TryGetNodeAttr(large_matmul->attrs(), kExecutorCostEstimateNsAttr,
+                             &large_cost_ns));
+  EXPECT_GE(small_cost_ns, 0);
+  EXPECT_GT(large_cost_ns, small_cost_ns);
+}
+
+TEST(ExecutorCostAnnotationPassTest, SkipsNodesWithUnknownShapes) {
+  Graph g(OpRegistry::Global());
+  Node* a;
+  TF_ASSERT_OK(NodeBuilder("a", "Placeholder")
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &a));
+  Node* b;
+  TF_ASSERT_OK(NodeBuilder("b", "Placeholder")
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &b));
+  Node* matmul = test::graph::Matmul(&g, a, b, false, false);
+  for (Node* n : g.op_nodes()) {
+    n->set_assigned_device_name(kCpuDevice);
+  }
+
+  TF_ASSERT_OK(AnnotateExecutorCostEstimates(&g));
+
+  int64 cost_ns;
+  EXPECT_FALSE(
+      TryGetNodeAttr(matmul->attrs(), kExecutorCostEstimateNsAttr, &cost_ns));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,220 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the framework overhead of the executor: graphs of inexpensive
+// nodes in several topologies, run with a varying number of inter-op threads.
+// The label of each benchmark reports the average wall time per executed node.
+//
+// Run with:
+//   bazel run -c opt \
+//     //tensorflow/core/common_runtime:executor_overhead_benchmark -- \
+//     --benchmarks=all
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/cc/ops/while_loop.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+// Adds the nodes of a topology to `g` and returns the number of nodes executed
+// per run, excluding the source and sink nodes.
+using GraphBuilder = std::function<int64(int size, Graph* g)>;
+
+// A chain of `size` no-ops, each depending on the previous one.
+int64 BuildChain(int size, Graph* g) {
+  Node* prev = test::graph::NoOp(g, {});
+  for (int i = 1; i < size; ++i) {
+    prev = test::graph::NoOp(g, {prev});
+  }
+  return size;
+}
+
+// A no-op that `size` no-ops depend on.
+int64 BuildFanOut(int size, Graph* g) {
+  Node* root = test::graph::NoOp(g, {});
+  for (int i = 0; i < size; ++i) {
+    test::graph::NoOp(g, {root});
+  }
+  return size + 1;
+}
+
+// `size` no-ops that a single no-op depends on.
+int64 BuildFanIn(int size, Graph* g) {
+  std::vector<Node*> inputs;
+  inputs.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    inputs.push_back(test::graph::NoOp(g, {}));
+  }
+  test::graph::NoOp(g, inputs);
+  return size + 1;
+}
+
+// A while loop frame running `size` iterations of `i = i + 1`.
+int64 BuildWhileLoop(int size, Graph* g) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  std::vector<Output> outputs;
+  TF_CHECK_OK(ops::BuildWhileLoop(
+      root, {ops::Const(root, 0)},
+      [size](const Scope& s, const std::vector<Output>& inputs,
+             Output* output) {
+        *output = ops::Less(s, inputs[0], ops::Const(s, size));
+        return s.status();
+      },
+      [](const Scope& s, const std::vector<Output>& inputs,
+         std::vector<Output>* outputs) {
+        outputs->push_back(ops::Add(s, inputs[0], ops::Const(s, 1)));
+        return s.status();
+      },
+      "loop", &outputs));
+  TF_CHECK_OK(root.ToGraph(g));
+  // Each iteration runs Merge, Const, Less, LoopCond, Switch, Const, Add and
+  // NextIteration. The last condition check runs 5 nodes, and the initial
+  // value, Enter and Exit run once.
+  return 8 * static_cast<int64>(size) + 8;
+}
+
+// `size` pairs of Send and Recv nodes, exchanging a scalar through the
+// rendezvous of the step.
+int64 BuildSendRecv(int size, Graph* g) {
+  Tensor value(DT_FLOAT, TensorShape({}));
+  value.scalar<float>()() = 1.0;
+  Node* in = test::graph::Constant(g, value);
+  for (int i = 0; i < size; ++i) {
+    const string tensor_name = strings::StrCat("t", i);
+    test::graph::Send(g, in, tensor_name, kDevice, 1, kDevice);
+    test::graph::Recv(g, tensor_name, "float", kDevice, 1, kDevice);
+  }
+  return 2 * static_cast<int64>(size) + 1;
+}
+
+// Runs the graph built by `build_graph` with `executor_type`, scheduling the
+// nodes on a pool of `num_threads` inter-op threads.
+void RunExecutorOverhead(::testing::benchmark::State& state,
+                         const GraphBuilder& build_graph,
+                         const string& executor_type) {
+  const int size = state.range(0);
+  const int num_threads = state.range(1);
+
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  const int64 num_nodes = build_graph(size, g.get());
+  FixupSourceAndSinkEdges(g.get());
+  const bool uses_rendezvous = absl::c_any_of(g->op_nodes(), [](Node* n) {
+    return n->IsSend() || n->IsRecv();
+  });
+
+  std::unique_ptr<Device> device(DeviceFactory::NewDevice(
+      "CPU", SessionOptions(), "/job:localhost/replica:0/task:0"));
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device.get();
+  params.create_kernel =
+      [&device, version](const std::shared_ptr<const NodeProperties>& props,
+                         OpKernel** kernel) {
+        return CreateNonCachedKernel(device.get(), nullptr, props, version,
+                                     kernel);
+      };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  std::unique_ptr<Executor> exec;
+  TF_CHECK_OK(NewExecutor(executor_type, params, *g, &exec));
+
+  thread::ThreadPool pool(Env::Default(), "executor_overhead", num_threads);
+  Executor::Args args;
+  args.runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+
+  const uint64 start_time = Env::Default()->NowNanos();
+  for (auto s : state) {
+    Rendezvous* rendez = nullptr;
+    if (uses_rendezvous) {
+      rendez = NewLocalRendezvous();
+      args.rendezvous = rendez;
+    }
+    TF_CHECK_OK(exec->Run(args));
+    if (rendez != nullptr) rendez->Unref();
+  }
+  const uint64 elapsed_ns = Env::Default()->NowNanos() - start_time;
+
+  const int64 num_executed_nodes =
+      num_nodes * static_cast<int64>(state.iterations());
+  state.SetLabel(strings::StrCat(
+      "Nodes = ", num_nodes, ", ns/node = ",
+      num_executed_nodes > 0 ? elapsed_ns / num_executed_nodes : 0));
+  state.SetItemsProcessed(num_executed_nodes);
+}
+
+// Defines the benchmarks of a topology with the default and the work-stealing
+// executors, for small and large graphs with 1 to 16 threads.
+#define BM_EXECUTOR_OVERHEAD(TOPOLOGY)                                      \
+  static void BM_ExecutorOverhead_##TOPOLOGY(                               \
+      ::testing::benchmark::State& state) {                                 \
+    RunExecutorOverhead(state, Build##TOPOLOGY, "");                        \
+  }                                                                         \
+  static void BM_ExecutorOverhead_##TOPOLOGY##_WorkStealing(                \
+      ::testing::benchmark::State& state) {                                 \
+    RunExecutorOverhead(state, Build##TOPOLOGY, "WORK_STEALING_EXECUTOR");  \
+  }                                                                         \
+  BENCHMARK(BM_ExecutorOverhead_##TOPOLOGY)                                 \
+      ->UseRealTime()                                                       \
+      ->ArgPair(16, 1)                                                      \
+      ->ArgPair(16, 4)                                                      \
+      ->ArgPair(16, 16)                                                     \
+      ->ArgPair(1024, 1)                                                    \
+      ->ArgPair(1024, 4)                                                    \
+      ->ArgPair(1024, 16);                                                  \
+  BENCHMARK(BM_ExecutorOverhead_##TOPOLOGY##_WorkStealing)                  \
+      ->UseRealTime()                                                       \
+      ->ArgPair(16, 1)                                                      \
+      ->ArgPair(16, 4)                                                      \
+      ->ArgPair(16, 16)                                                     \
+      ->ArgPair(1024, 1)                                                    \
+      ->ArgPair(1024, 4)                                                    \
+      ->ArgPair(1024, 16);
+
+BM_EXECUTOR_OVERHEAD(Chain);
+BM_EXECUTOR_OVERHEAD(FanOut);
+BM_EXECUTOR_OVERHEAD(FanIn);
+BM_EXECUTOR_OVERHEAD(WhileLoop);
+BM_EXECUTOR_OVERHEAD(SendRecv);
+
+}  // namespace
+}  // namespace tensorflow
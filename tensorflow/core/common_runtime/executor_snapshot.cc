@@ -0,0 +1,154 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/executor_snapshot.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+
+namespace {
+
+uint64 FingerprintMessage(const protobuf::MessageLite& message) {
+  string serialized;
+  // Only fails for messages larger than 2GB, which cannot be snapshotted
+  // anyway; the resulting key simply never matches a stored snapshot.
+  SerializeToStringDeterministic(message, &serialized);
+  return Fingerprint64(serialized);
+}
+
+}  // namespace
+
+uint64 FingerprintGraphDef(const GraphDef& graph_def) {
+  return FingerprintMessage(graph_def);
+}
+
+uint64 ExecutorSnapshotFingerprint(uint64 graph_fingerprint,
+                                   const BuildGraphOptions& options,
+                                   const ConfigProto& config,
+                                   const DeviceSet& device_set) {
+  uint64 fingerprint = Fingerprint64(strings::StrCat(
+      TF_VERSION_STRING, "/", TF_GRAPH_DEF_VERSION, "/", graph_fingerprint));
+  fingerprint = FingerprintCat64(fingerprint,
+                                 FingerprintMessage(options.callable_options));
+  fingerprint = FingerprintCat64(
+      fingerprint,
+      Fingerprint64(strings::StrCat(
+          options.use_function_convention, "/", options.collective_graph_key,
+          "/", static_cast<int>(options.collective_order))));
+  for (const auto& feed_shape : options.feed_shapes) {
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(strings::StrCat(
+                         feed_shape.first, feed_shape.second.DebugString())));
+  }
+
+  // The snapshot directory itself does not affect the graphs.
+  ConfigProto config_key = config;
+  config_key.mutable_experimental()->clear_executor_snapshot_dir();
+  fingerprint = FingerprintCat64(fingerprint, FingerprintMessage(config_key));
+
+  for (const Device* device : device_set.devices()) {
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(strings::StrCat(device->name(), "/",
+                                                   device->device_type())));
+  }
+  return fingerprint;
+}
+
+string ExecutorSnapshotPath(const string& dir, uint64 fingerprint) {
+  return io::JoinPath(
+      dir, strings::StrCat("executor_snapshot_",
+                           strings::Hex(fingerprint, strings::kZeroPad16),
+                           ".pb"));
+}
+
+Status ReadExecutorSnapshot(Env* env, const string& dir, uint64 fingerprint,
+                            ExecutorSnapshot* snapshot) {
+  const string path = ExecutorSnapshotPath(dir, fingerprint);
+  Status s = env->FileExists(path);
+  if (!s.ok()) {
+    return errors::NotFound("No executor snapshot at ", path);
+  }
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, path, snapshot));
+  if (snapshot->fingerprint() != fingerprint) {
+    return errors::DataLoss("Executor snapshot ", path,
+                            " has unexpected fingerprint ",
+                            snapshot->fingerprint());
+  }
+  return Status::OK();
+}
+
+Status WriteExecutorSnapshot(Env* env, const string& dir,
+                             const ExecutorSnapshot& snapshot) {
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dir));
+  const string path = ExecutorSnapshotPath(dir, snapshot.fingerprint());
+  string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  Status s = WriteBinaryProto(env, temp_path, snapshot);
+  if (s.ok()) {
+    s = env->RenameFile(temp_path, path);
+  }
+  if (!s.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+  return s;
+}
+
+void ExportExecutorSnapshot(
+    const std::unordered_map<string, std::unique_ptr<Graph>>& partitions,
+    const FunctionLibraryDefinition& flib_def, ExecutorSnapshot* snapshot) {
+  auto* partition_defs = snapshot->mutable_partitions();
+  for (const auto& partition : partitions) {
+    partition.second->ToGraphDef(&(*partition_defs)[partition.first]);
+  }
+  *snapshot->mutable_library() = flib_def.ToProto();
+}
+
+Status ImportExecutorSnapshot(
+    const ExecutorSnapshot& snapshot,
+    std::unordered_map<string, std::unique_ptr<Graph>>* partitions,
+    std::unique_ptr<FunctionLibraryDefinition>* flib_def) {
+  auto library = absl::make_unique<FunctionLibraryDefinition>(
+      OpRegistry::Global(), snapshot.library());
+  std::unordered_map<string, std::unique_ptr<Graph>> graphs;
+  for (const auto& partition : snapshot.partitions()) {
+    auto graph = absl::make_unique<Graph>(library.get());
+    GraphConstructorOptions opts;
+    // Partition graphs contain internal operations (e.g., send/recv) and are
+    // already placed.
+    opts.allow_internal_ops = true;
+    opts.expect_device_spec = true;
+    TF_RETURN_IF_ERROR(
+        ConvertGraphDefToGraph(opts, partition.second, graph.get()));
+    graphs.emplace(partition.first, std::move(graph));
+  }
+  partitions->swap(graphs);
+  *flib_def = std::move(library);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
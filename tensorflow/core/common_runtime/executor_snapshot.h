@@ -0,0 +1,84 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EXECUTOR_SNAPSHOT_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EXECUTOR_SNAPSHOT_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/build_graph_options.h"
+#include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/executor_snapshot.pb.h"
+
+namespace tensorflow {
+
+// Utilities for ConfigProto.Experimental.executor_snapshot_dir, which lets a
+// DirectSession skip placement, Grappler and partitioning for callables whose
+// graphs it (or an earlier process) has already built.
+//
+// A snapshot holds the partition graphs and function library that
+// DirectSession::CreateGraphs() produced for one callable, keyed by a
+// fingerprint of everything those graphs depend on.
+
+// Returns a fingerprint of `graph_def` that is stable across processes.
+uint64 FingerprintGraphDef(const GraphDef& graph_def);
+
+// Returns the key of the graphs built for `options` on `device_set` from a
+// session graph with fingerprint `graph_fingerprint` under `config`.  The key
+// also covers the TensorFlow version, so snapshots written by another
+// release are never reused.
+uint64 ExecutorSnapshotFingerprint(uint64 graph_fingerprint,
+                                   const BuildGraphOptions& options,
+                                   const ConfigProto& config,
+                                   const DeviceSet& device_set);
+
+// Returns the path of the snapshot with key `fingerprint` in `dir`.
+string ExecutorSnapshotPath(const string& dir, uint64 fingerprint);
+
+// Reads the snapshot with key `fingerprint` from `dir` into `*snapshot`.
+// Returns NotFound if there is no such snapshot.
+Status ReadExecutorSnapshot(Env* env, const string& dir, uint64 fingerprint,
+                            ExecutorSnapshot* snapshot);
+
+// Writes `snapshot` to `dir`, creating the directory if needed.  The file is
+// written under a temporary name and renamed into place, so that concurrent
+// readers never see a partial snapshot.
+Status WriteExecutorSnapshot(Env* env, const string& dir,
+                             const ExecutorSnapshot& snapshot);
+
+// Stores `partitions` and `flib_def` in `*snapshot`.
+void ExportExecutorSnapshot(
+    const std::unordered_map<string, std::unique_ptr<Graph>>& partitions,
+    const FunctionLibraryDefinition& flib_def, ExecutorSnapshot* snapshot);
+
+// Rebuilds the partition graphs and function library stored in `snapshot`.
+// The graphs in `*partitions` refer to the functions in `*flib_def`.
+Status ImportExecutorSnapshot(
+    const ExecutorSnapshot& snapshot,
+    std::unordered_map<string, std::unique_ptr<Graph>>* partitions,
+    std::unique_ptr<FunctionLibraryDefinition>* flib_def);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EXECUTOR_SNAPSHOT_H_
@@ -0,0 +1,150 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/executor_snapshot.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kCpu[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+GraphDef MakeGraphDef() {
+  GraphDef graph_def;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      strings::StrCat("node { name: 'a' op: 'NoOp' device: '", kCpu, "' }",
+                      "node { name: 'b' op: 'NoOp' device: '", kCpu, "'",
+                      "       input: '^a' }"),
+      &graph_def));
+  *graph_def.mutable_library()->add_function() = test::function::XTimesTwo();
+  return graph_def;
+}
+
+string SnapshotDir(const string& name) {
+  return io::JoinPath(testing::TmpDir(), "executor_snapshot_test", name);
+}
+
+TEST(ExecutorSnapshotTest, GraphFingerprintIsDeterministic) {
+  GraphDef graph_def = MakeGraphDef();
+  EXPECT_EQ(FingerprintGraphDef(graph_def), FingerprintGraphDef(graph_def));
+  const uint64 fingerprint = FingerprintGraphDef(graph_def);
+  graph_def.mutable_node(1)->set_name("c");
+  EXPECT_NE(fingerprint, FingerprintGraphDef(graph_def));
+}
+
+TEST(ExecutorSnapshotTest, FingerprintCoversCallableAndConfig) {
+  DeviceSet device_set;
+  BuildGraphOptions options;
+  ConfigProto config;
+  const uint64 base =
+      ExecutorSnapshotFingerprint(17, options, config, device_set);
+  EXPECT_NE(base, ExecutorSnapshotFingerprint(18, options, config, device_set));
+
+  BuildGraphOptions fetch_options;
+  fetch_options.callable_options.add_fetch("b:0");
+  EXPECT_NE(base, ExecutorSnapshotFingerprint(17, fetch_options, config,
+                                              device_set));
+
+  BuildGraphOptions function_options;
+  function_options.use_function_convention = true;
+  EXPECT_NE(base, ExecutorSnapshotFingerprint(17, function_options, config,
+                                              device_set));
+
+  ConfigProto other_config;
+  other_config.mutable_graph_options()->set_place_pruned_graph(true);
+  EXPECT_NE(base, ExecutorSnapshotFingerprint(17, options, other_config,
+                                              device_set));
+
+  // The location of the snapshots does not matter.
+  ConfigProto dir_config;
+  dir_config.mutable_experimental()->set_executor_snapshot_dir("/tmp/x");
+  EXPECT_EQ(base, ExecutorSnapshotFingerprint(17, options, dir_config,
+                                              device_set));
+}
+
+TEST(ExecutorSnapshotTest, WriteAndRead) {
+  Env* env = Env::Default();
+  const string dir = SnapshotDir("write_and_read");
+  ExecutorSnapshot snapshot;
+  snapshot.set_fingerprint(0x1234);
+  snapshot.add_feed_types(DT_FLOAT);
+  snapshot.add_fetch_types(DT_INT32);
+  (*snapshot.mutable_stateful_placements())["v"] = kCpu;
+  TF_ASSERT_OK(WriteExecutorSnapshot(env, dir, snapshot));
+  TF_EXPECT_OK(env->FileExists(ExecutorSnapshotPath(dir, 0x1234)));
+
+  ExecutorSnapshot read;
+  TF_ASSERT_OK(ReadExecutorSnapshot(env, dir, 0x1234, &read));
+  EXPECT_EQ(snapshot.SerializeAsString(), read.SerializeAsString());
+
+  std::vector<string> children;
+  TF_ASSERT_OK(env->GetChildren(dir, &children));
+  EXPECT_EQ(1, children.size());
+}
+
+TEST(ExecutorSnapshotTest, ReadMissingOrStale) {
+  Env* env = Env::Default();
+  const string dir = SnapshotDir("missing_or_stale");
+  ExecutorSnapshot snapshot;
+  EXPECT_TRUE(errors::IsNotFound(ReadExecutorSnapshot(env, dir, 1, &snapshot)));
+
+  snapshot.set_fingerprint(1);
+  TF_ASSERT_OK(env->RecursivelyCreateDir(dir));
+  TF_ASSERT_OK(WriteBinaryProto(env, ExecutorSnapshotPath(dir, 2), snapshot));
+  EXPECT_TRUE(errors::IsDataLoss(ReadExecutorSnapshot(env, dir, 2, &snapshot)));
+}
+
+TEST(ExecutorSnapshotTest, ExportAndImport) {
+  GraphDef graph_def = MakeGraphDef();
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), graph_def.library());
+  std::unordered_map<string, std::unique_ptr<Graph>> partitions;
+  auto graph = absl::make_unique<Graph>(&flib_def);
+  GraphConstructorOptions opts;
+  opts.expect_device_spec = true;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, graph_def, graph.get()));
+  partitions.emplace(kCpu, std::move(graph));
+
+  ExecutorSnapshot snapshot;
+  ExportExecutorSnapshot(partitions, flib_def, &snapshot);
+  ASSERT_EQ(1, snapshot.partitions().size());
+  EXPECT_EQ(1, snapshot.library().function_size());
+
+  std::unordered_map<string, std::unique_ptr<Graph>> imported;
+  std::unique_ptr<FunctionLibraryDefinition> imported_flib_def;
+  TF_ASSERT_OK(ImportExecutorSnapshot(snapshot, &imported, &imported_flib_def));
+  ASSERT_EQ(1, imported.size());
+  ASSERT_NE(nullptr, imported_flib_def->Find("XTimesTwo"));
+  const Graph& imported_graph = *imported.at(kCpu);
+  EXPECT_EQ(imported_flib_def.get(),
+            imported_graph.flib_def().default_registry());
+  int num_ops = 0;
+  for (const Node* node : imported_graph.op_nodes()) {
+    EXPECT_EQ(kCpu, node->assigned_device_name());
+    ++num_ops;
+  }
+  EXPECT_EQ(2, num_ops);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,6 +16,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <set>
+
+#include "absl/strings/match.h"
 
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/array_ops.h"
@@ -25,18 +29,23 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/immutable_executor_state.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -82,7 +91,13 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (executor_type_.empty()) {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    } else {
+      std::unique_ptr<Executor> executor;
+      TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &executor));
+      exec_ = executor.release();
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -94,6 +109,8 @@ class ExecutorTest : public ::testing::Test {
     return exec_->Run(args);
   }
 
+  // The executor type to create. If empty, uses `NewLocalExecutor()`.
+  string executor_type_;
   thread::ThreadPool* thread_pool_ = nullptr;
   std::unique_ptr<Device> device_;
   Executor* exec_ = nullptr;
@@ -255,6 +272,53 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+// Builds a graph of `depth` layers of `width` no-ops each. Every layer joins
+// into a single no-op, which all nodes of the next layer depend on, so each
+// join node has a fan-in of `width`. The input "a" is forwarded to "b" after
+// the last join.
+void BuildFanInLayers(int width, int depth, Graph* g) {
+  auto in = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  Node* join = in;
+  for (int i = 0; i < depth; ++i) {
+    std::vector<Node*> layer;
+    for (int j = 0; j < width; ++j) {
+      layer.push_back(test::graph::NoOp(g, {join}));
+    }
+    join = test::graph::NoOp(g, layer);
+  }
+  auto out = test::graph::Identity(g, in, 0);
+  g->AddControlEdge(join, out);
+  test::graph::Send(g, out, "b", BOB, 1, ALICE);
+}
+
+TEST_F(ExecutorTest, CacheAwarePendingCountsLayout) {
+  setenv("TF_EXECUTOR_CACHE_AWARE_PENDING_COUNTS", "1", 1);
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildFanInLayers(/*width=*/64, /*depth=*/8, g.get());
+  BuildTree(256, g.get());
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_CACHE_AWARE_PENDING_COUNTS");
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    // Both subgraphs receive "a" and send "b".
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    const float first = V(out);
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(257.0, first + V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -430,6 +494,240 @@ TEST_F(ExecutorTest, NoInputTensors) {
   TF_ASSERT_OK(Run(rendez_));
 }
 
+// Builds a graph of `width` independent no-op roots, which are joined into a
+// single no-op. If `cost_estimate_ns` is non-negative, every node is annotated
+// with that static cost estimate.
+void BuildAnnotatedRoots(int width, int64 cost_estimate_ns, Graph* g) {
+  std::vector<Node*> roots;
+  for (int i = 0; i < width; ++i) {
+    roots.push_back(test::graph::NoOp(g, {}));
+  }
+  test::graph::NoOp(g, roots);
+  if (cost_estimate_ns >= 0) {
+    for (Node* n : g->op_nodes()) {
+      n->AddAttr(kExecutorCostEstimateNsAttr, cost_estimate_ns);
+    }
+  }
+}
+
+// Returns the number of closures that one step of the current executor passes
+// to its runner.
+int CountScheduledClosures(Executor* exec, thread::ThreadPool* pool) {
+  std::atomic<int> num_closures{0};
+  Executor::Args args;
+  args.runner = [pool, &num_closures](std::function<void()> fn) {
+    ++num_closures;
+    pool->Schedule(std::move(fn));
+  };
+  TF_CHECK_OK(exec->Run(args));
+  return num_closures;
+}
+
+TEST_F(ExecutorTest, InexpensiveRootsNotBatchedWithoutCostEstimates) {
+  const int kWidth = 16;
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildAnnotatedRoots(kWidth, /*cost_estimate_ns=*/-1, g.get());
+  Create(std::move(g));
+  // Each root is dispatched from its own closure.
+  EXPECT_GE(CountScheduledClosures(exec_, thread_pool_), kWidth);
+}
+
+TEST_F(ExecutorTest, InexpensiveRootsBatchedWithCostEstimates) {
+  const int kWidth = 16;
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildAnnotatedRoots(kWidth, /*cost_estimate_ns=*/1, g.get());
+  Create(std::move(g));
+  // All roots are inexpensive, so they run from a single closure, and the join
+  // node runs inline after them. The other closure runs the done callback.
+  EXPECT_EQ(2, CountScheduledClosures(exec_, thread_pool_));
+}
+
+class WorkStealingExecutorTest : public ExecutorTest {
+ protected:
+  WorkStealingExecutorTest() { executor_type_ = "WORK_STEALING_EXECUTOR"; }
+};
+
+TEST_F(WorkStealingExecutorTest, SelfAdd) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto v = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  const int N = 10;
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g.get(), v, v);
+  }
+  test::graph::Send(g.get(), v, "b", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+}
+
+TEST_F(WorkStealingExecutorTest, RandomTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
+TEST_F(WorkStealingExecutorTest, SimpleSwitchDead) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g.get(), VB(true));
+  auto tmp = test::graph::Switch(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
+TEST_F(WorkStealingExecutorTest, RecvInvalidDtype) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto one = test::graph::Recv(g.get(), "one", "float", ALICE, 1, BOB);
+  auto var = test::graph::Var(g.get(), DT_FLOAT, TensorShape({1}));
+  auto init = test::graph::Assign(g.get(), var, one);
+  auto* two = test::graph::Send(g.get(), var, "two", BOB, 1, ALICE);
+  g->AddControlEdge(init, two);
+  Create(std::move(g));
+  Rendezvous* rendez = NewLocalRendezvous();
+  TF_ASSERT_OK(rendez->Send(Key(ALICE, 1, BOB, "one"), Rendezvous::Args(),
+                            VD(1.0), false));
+  EXPECT_TRUE(errors::IsInternal(Run(rendez)));
+  rendez->Unref();
+}
+
+// Ops whose kernels fail to construct if their "fail" attr is set.
+REGISTER_OP("ExecutorTestConstruct")
+    .Attr("fail: bool = false")
+    .SetShapeFn(shape_inference::NoOutputs);
+REGISTER_OP("ExecutorTestConstructStateful")
+    .Attr("fail: bool = false")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
+
+class ExecutorTestConstructOp : public OpKernel {
+ public:
+  explicit ExecutorTestConstructOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    bool fail;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("fail", &fail));
+    OP_REQUIRES(ctx, !fail,
+                errors::InvalidArgument("Failed to construct ", name()));
+  }
+
+  void Compute(OpKernelContext* ctx) override {}
+};
+
+REGISTER_KERNEL_BUILDER(Name("ExecutorTestConstruct").Device(DEVICE_CPU),
+                        ExecutorTestConstructOp);
+REGISTER_KERNEL_BUILDER(
+    Name("ExecutorTestConstructStateful").Device(DEVICE_CPU),
+    ExecutorTestConstructOp);
+
+// Creates an executor for a graph of `num_nodes` nodes named n0, n1, ...,
+// which are stateful if their index is in `stateful`, and fail to construct if
+// it is in `failing`.
+Status CreateExecutorForConstructTest(int num_nodes,
+                                      const std::set<int>& stateful,
+                                      const std::set<int>& failing) {
+  std::unique_ptr<Device> device(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  Graph g(OpRegistry::Global());
+  for (int i = 0; i < num_nodes; ++i) {
+    TF_RETURN_IF_ERROR(
+        NodeBuilder(strings::StrCat("n", i),
+                    stateful.count(i) ? "ExecutorTestConstructStateful"
+                                      : "ExecutorTestConstruct")
+            .Attr("fail", failing.count(i) > 0)
+            .Finalize(&g, nullptr));
+  }
+  FixupSourceAndSinkEdges(&g);
+  const int version = g.versions().producer();
+  LocalExecutorParams params;
+  params.device = device.get();
+  params.create_kernel =
+      [&device, version](const std::shared_ptr<const NodeProperties>& props,
+                         OpKernel** kernel) {
+        return CreateNonCachedKernel(device.get(), nullptr, props, version,
+                                     kernel);
+      };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  Executor* exec = nullptr;
+  TF_RETURN_IF_ERROR(NewLocalExecutor(params, g, &exec));
+  delete exec;
+  return Status::OK();
+}
+
+// Graphs this large construct their stateless kernels in parallel.
+constexpr int kNumConstructTestNodes = 512;
+
+TEST(ExecutorKernelCreationTest, ConstructsAllKernels) {
+  TF_EXPECT_OK(CreateExecutorForConstructTest(kNumConstructTestNodes,
+                                              /*stateful=*/{1, 300},
+                                              /*failing=*/{}));
+}
+
+TEST(ExecutorKernelCreationTest, ReportsFirstFailingNodeInNodeOrder) {
+  // Whichever kernel fails first, the error is the one of n100.
+  for (int i = 0; i < 20; ++i) {
+    Status s = CreateExecutorForConstructTest(
+        kNumConstructTestNodes, /*stateful=*/{},
+        /*failing=*/{100, 101, 300, 400, kNumConstructTestNodes - 1});
+    EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+    EXPECT_TRUE(
+        absl::StrContains(s.error_message(), "Failed to construct n100"))
+        << s;
+  }
+}
+
+TEST(ExecutorKernelCreationTest, ReportsStatefulFailureBeforeLaterStateless) {
+  // Stateful kernels are constructed after the stateless ones, but their
+  // errors are still reported in node order.
+  for (int i = 0; i < 20; ++i) {
+    Status s = CreateExecutorForConstructTest(kNumConstructTestNodes,
+                                              /*stateful=*/{200},
+                                              /*failing=*/{200, 300, 400});
+    EXPECT_TRUE(
+        absl::StrContains(s.error_message(), "Failed to construct n200"))
+        << s;
+  }
+}
+
+TEST(ExecutorKernelCreationTest, ReportsStatelessFailureBeforeLaterStateful) {
+  for (int i = 0; i < 20; ++i) {
+    Status s = CreateExecutorForConstructTest(kNumConstructTestNodes,
+                                              /*stateful=*/{200},
+                                              /*failing=*/{100, 200});
+    EXPECT_TRUE(
+        absl::StrContains(s.error_message(), "Failed to construct n100"))
+        << s;
+  }
+}
+
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
@@ -484,6 +782,80 @@ BENCHMARK(BM_executor)->UseRealTime()->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(1024, 1024);
 
+// Measures how executing a graph of wide fan-in layers (see
+// BuildFanInLayers()) scales with the number of inter-op threads, with the
+// default or the cache-aware pending counts layout. Uses the work-stealing
+// executor, which spreads inexpensive nodes over all threads.
+static void BM_executor_fan_in_threads(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const bool cache_aware = state.range(1);
+  const int width = 256;
+  const int depth = 16;
+
+  std::unique_ptr<Device> device(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildFanInLayers(width, depth, g.get());
+  FixupSourceAndSinkEdges(g.get());
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device.get();
+  params.create_kernel =
+      [&device, version](const std::shared_ptr<const NodeProperties>& props,
+                         OpKernel** kernel) {
+        return CreateNonCachedKernel(device.get(), nullptr, props, version,
+                                     kernel);
+      };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  setenv("TF_EXECUTOR_CACHE_AWARE_PENDING_COUNTS", cache_aware ? "1" : "0", 1);
+  std::unique_ptr<Executor> exec;
+  TF_CHECK_OK(NewExecutor("WORK_STEALING_EXECUTOR", params, *g, &exec));
+  unsetenv("TF_EXECUTOR_CACHE_AWARE_PENDING_COUNTS");
+
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  Executor::Args args;
+  args.runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  for (auto s : state) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args rendez_args;
+    TF_CHECK_OK(rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), rendez_args,
+                             V(1.0), false));
+    args.rendezvous = rendez;
+    TF_CHECK_OK(exec->Run(args));
+    Tensor out;
+    bool is_dead = false;
+    TF_CHECK_OK(rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), rendez_args,
+                             &out, &is_dead));
+    rendez->Unref();
+  }
+
+  const int64 num_nodes = (width + 1) * depth + 3;
+  state.SetLabel(strings::StrCat("Nodes = ", num_nodes,
+                                 cache_aware ? " cache-aware" : ""));
+  state.SetItemsProcessed(num_nodes * static_cast<int64>(state.iterations()));
+}
+
+BENCHMARK(BM_executor_fan_in_threads)
+    ->UseRealTime()
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(2, 0)
+    ->ArgPair(2, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(32, 0)
+    ->ArgPair(32, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1);
+
 static void BM_const_identity(::testing::benchmark::State& state) {
   const int width = state.range(0);
   const int outputs_per_const = state.range(1);
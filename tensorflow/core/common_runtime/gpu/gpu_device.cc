@@ -31,6 +31,8 @@ limitations under the License.
 #include <list>
 #include <map>
 #include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -38,20 +40,25 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device/device_id_utils.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_host_staging_pool.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/memory_types.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -293,10 +300,42 @@ class BaseGPUDevice::StreamGroupFactory {
         VLOG(2) << "Created device_to_device_stream[" << stream_group_within_gpu
                 << "] = " << group->device_to_device.back();
       }
+
+      int num_compute_streams = options.experimental().num_compute_streams();
+      if (num_compute_streams == 0) num_compute_streams = 1;
+      if (num_compute_streams < 1 || num_compute_streams > 16) {
+        LOG(ERROR) << "Illegal GPUOptions.experimental.num_compute_streams="
+                   << num_compute_streams << " set to 1 instead.";
+        num_compute_streams = 1;
+      }
+      for (int i = 1; i < num_compute_streams; ++i) {
+        se::Stream* stream = GetStream(executor, priority);
+        stream->Init();
+        group->extra_compute.push_back(stream);
+        VLOG(2) << "Created extra_compute_stream[" << stream_group_within_gpu
+                << "] = " << group->extra_compute.back();
+      }
     }
     return group;
   }
 
+  // Returns the allocator that defers the frees of `allocator` until every
+  // compute stream of `group` has passed them, creating it if it does not yet
+  // exist.
+  // This function is thread safe.
+  GPUStreamAwareAllocator* GetOrCreateStreamAwareAllocator(
+      StreamGroup* group, Allocator* allocator, EventMgr* event_mgr) {
+    mutex_lock guard(lock_);
+    if (!group->stream_aware_allocator) {
+      std::vector<se::Stream*> streams = {group->compute};
+      streams.insert(streams.end(), group->extra_compute.begin(),
+                     group->extra_compute.end());
+      group->stream_aware_allocator =
+          new GPUStreamAwareAllocator(allocator, std::move(streams), event_mgr);
+    }
+    return group->stream_aware_allocator;
+  }
+
   // Returns a reference to the StreamGroupFactory singleton. Note that this is
   // never destroyed, so the objects it owns are never deleted.
   static StreamGroupFactory& Global() {
@@ -309,6 +348,14 @@ class BaseGPUDevice::StreamGroupFactory {
     mutex_lock guard(lock_);
     for (auto& item : streams_) {
       auto& stream = item.second;
+      if (stream.stream_aware_allocator) {
+        TF_CHECK_OK(stream.compute->BlockHostUntilDone());
+        for (se::Stream* extra_compute : stream.extra_compute) {
+          TF_CHECK_OK(extra_compute->BlockHostUntilDone());
+        }
+        delete stream.stream_aware_allocator;
+        stream.stream_aware_allocator = nullptr;
+      }
       if (stream.compute) {
         delete stream.compute;
         stream.compute = nullptr;
@@ -334,6 +381,10 @@ class BaseGPUDevice::StreamGroupFactory {
         }
         stream.device_to_device.pop_back();
       }
+      while (!stream.extra_compute.empty()) {
+        delete stream.extra_compute.back();
+        stream.extra_compute.pop_back();
+      }
     }
     streams_.clear();
   }
@@ -397,14 +448,19 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 
 BaseGPUDevice::~BaseGPUDevice() {
   delete gpu_device_info_;
-  gpu_allocator_->DeallocateRaw(scratch_);
+  for (char* scratch : scratch_) {
+    gpu_allocator_->DeallocateRaw(scratch);
+  }
   device_context_->Unref();
+  if (host_staging_pool_ != nullptr) host_staging_pool_->Unref();
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
+  // Kernels on different compute streams may run concurrently, so each
+  // stream gets its own scratch buffer.
+  while (scratch_.size() < compute_streams_.size()) {
     DCHECK(stream_);
     size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
     ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
@@ -419,7 +475,7 @@ Status BaseGPUDevice::InitScratchBuffers() {
         se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
     TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
         &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    scratch_.push_back(static_cast<char*>(scratch_buffer));
   }
   return Status::OK();
 }
@@ -447,6 +503,25 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
 
+  const int64 staging_chunk_bytes = options.config.gpu_options()
+                                        .experimental()
+                                        .host_to_device_staging_chunk_bytes();
+  if (staging_chunk_bytes > 0) {
+    int num_staging_buffers = options.config.gpu_options()
+                                  .experimental()
+                                  .num_host_to_device_staging_buffers();
+    if (num_staging_buffers <= 0) num_staging_buffers = 4;
+    host_staging_pool_ = new GpuHostStagingPool(
+        GPUProcessState::singleton()->GetGpuHostAllocator(
+            attributes().locality().numa_node()),
+        staging_chunk_bytes, num_staging_buffers);
+    device_context_->set_host_staging_pool(host_staging_pool_);
+  }
+
+  oversubscription_allocator_ =
+      GPUProcessState::singleton()->GpuOversubscriptionAllocatorFor(
+          tf_device_id_);
+
   GPUKernelTracker::Params tracker_params(
       options.config.gpu_options().experimental().kernel_tracker_max_interval(),
       options.config.gpu_options().experimental().kernel_tracker_max_bytes(),
@@ -472,6 +547,25 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
         timestamped_allocator_ ? gpu_allocator_ : nullptr, em_));
   }
 
+  compute_streams_.push_back(stream_->compute);
+  if (!stream_->extra_compute.empty()) {
+    if (kernel_tracker_) {
+      // GPUKernelTracker follows a single compute stream.
+      LOG(WARNING) << "GPUOptions.experimental.num_compute_streams is ignored "
+                   << "because kernel tracking is enabled.";
+    } else {
+      compute_streams_.insert(compute_streams_.end(),
+                              stream_->extra_compute.begin(),
+                              stream_->extra_compute.end());
+      stream_aware_allocator_ =
+          StreamGroupFactory::Global().GetOrCreateStreamAwareAllocator(
+              stream_, gpu_allocator_, em_);
+      gpu_allocator_ = stream_aware_allocator_;
+      VLOG(1) << "GPU " << tf_device_id_.value() << " launches kernels on "
+              << compute_streams_.size() << " compute streams";
+    }
+  }
+
   gpu_device_info_ = new GpuDeviceInfo;
   gpu_device_info_->stream = stream_->compute;
   gpu_device_info_->default_context = device_context_;
@@ -569,7 +663,19 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
   ScopedMemoryDebugAnnotation op_annotation(op_kernel->name_view().data(),
                                             context->step_id());
+  for (se::Stream* wait_stream : gpu_device_context->wait_streams()) {
+    stream->ThenWaitFor(wait_stream);
+  }
+  if (oversubscription_allocator_ != nullptr) {
+    // Prefetches go to the host-to-device stream so that they overlap the
+    // kernels already queued on `stream`.
+    PrefetchManagedInputs(context, stream,
+                          gpu_device_context->host_to_device_stream());
+  }
   op_kernel->Compute(context);
+  if (stream_aware_allocator_) {
+    stream_aware_allocator_->ReleaseFreedBuffers();
+  }
   if (context->status().ok()) {
     if (sync_every_op_) {
       // Note: GPUUtil::Sync() only syncs the default stream.
@@ -603,6 +709,24 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
   }
 }
 
+void BaseGPUDevice::PrefetchManagedInputs(OpKernelContext* context,
+                                          se::Stream* stream,
+                                          se::Stream* prefetch_stream) {
+  bool prefetched = false;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (context->input_memory_type(i) == HOST_MEMORY) continue;
+    const Tensor input = context->input_is_ref(i)
+                             ? context->mutable_input(i, /*lock_held=*/false)
+                             : context->input(i);
+    if (!input.IsInitialized() || input.TotalBytes() == 0) continue;
+    prefetched |= oversubscription_allocator_->Prefetch(
+        input.tensor_data().data(), prefetch_stream);
+  }
+  if (prefetched) {
+    stream->ThenWaitFor(prefetch_stream);
+  }
+}
+
 Status BaseGPUDevice::Sync() {
   DCHECK_NE(stream_, nullptr);
 
@@ -612,7 +736,10 @@ Status BaseGPUDevice::Sync() {
   // enqueued the operation has completed.  We do use other streams for copies
   // and collectives, but in those cases the (Async)OpKernels themselves block
   // until the queued operation has finished.
-  return stream_->compute->BlockHostUntilDone();
+  for (se::Stream* stream : compute_streams_) {
+    TF_RETURN_IF_ERROR(stream->BlockHostUntilDone());
+  }
+  return Status::OK();
 }
 
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
@@ -631,9 +758,156 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << " stream[" << stream_id << "]";
 
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  if (compute_streams_.size() > 1) {
+    for (se::Stream* wait_stream : gpu_device_context->wait_streams()) {
+      stream->ThenWaitFor(wait_stream);
+    }
+    // Asynchronous kernels such as function calls may hand their inputs to
+    // nodes without data inputs (e.g. _Arg), which run on stream 0, and may
+    // produce their outputs on any stream. Order stream 0 after the inputs,
+    // and this kernel's stream after all work queued before it is done.
+    if (stream != compute_streams_[0]) {
+      compute_streams_[0]->ThenWaitFor(stream);
+    }
+    done = [this, stream, done = std::move(done)]() {
+      for (se::Stream* other : compute_streams_) {
+        if (other != stream) stream->ThenWaitFor(other);
+      }
+      stream_aware_allocator_->ReleaseFreedBuffers();
+      done();
+    };
+  }
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
+namespace {
+// Returns true if `n` must run on compute stream 0. Nodes that are stateful
+// or use resources or reference-typed tensors stay there so that updates to
+// persistent state happen in program order, also across steps. Nodes without
+// data inputs (e.g. _Arg or _Recv) stay there because the values they pass
+// on were produced outside of the graph, ordered with respect to stream 0.
+bool RunsOnFirstComputeStream(const Node* n) {
+  if (n->num_inputs() == 0 || n->op_def().is_stateful()) return true;
+  for (const DataTypeVector* types :
+       {&n->input_types(), &n->output_types()}) {
+    for (DataType dtype : *types) {
+      if (IsRefType(dtype) || dtype == DT_RESOURCE) return true;
+    }
+  }
+  return false;
+}
+
+// Assigns each node of `graph` one of `num_streams` compute streams. A node
+// that does not have to run on stream 0 continues the stream of its first
+// producer that has not passed its stream on to another consumer yet, so
+// chains of kernels stay on one stream, and otherwise starts a new branch on
+// the next stream in round-robin order.
+void AssignComputeStreams(const Graph& graph, int num_streams,
+                          std::vector<int>* node_to_stream_id) {
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order, NodeComparatorName());
+  node_to_stream_id->assign(graph.num_node_ids(), 0);
+  // Whether a consumer may still continue the stream of a node.
+  std::vector<bool> can_continue(graph.num_node_ids(), false);
+  int next_stream_id = 1 % num_streams;
+  for (const Node* n : order) {
+    if (!n->IsOp() || RunsOnFirstComputeStream(n)) continue;
+    const Edge* continued = nullptr;
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge() || !can_continue[e->src()->id()]) continue;
+      if (continued == nullptr || e->dst_input() < continued->dst_input()) {
+        continued = e;
+      }
+    }
+    int stream_id;
+    if (continued != nullptr) {
+      can_continue[continued->src()->id()] = false;
+      stream_id = (*node_to_stream_id)[continued->src()->id()];
+    } else {
+      stream_id = next_stream_id;
+      next_stream_id = (next_stream_id + 1) % num_streams;
+    }
+    (*node_to_stream_id)[n->id()] = stream_id;
+    can_continue[n->id()] = true;
+  }
+}
+}  // namespace
+
+Status BaseGPUDevice::FillContextMap(
+    const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+  const int num_streams = compute_streams_.size();
+  if (num_streams <= 1) return Status::OK();
+
+  std::vector<int> node_to_stream_id;
+  AssignComputeStreams(*graph, num_streams, &node_to_stream_id);
+
+  std::unordered_map<int, MemoryTypeVector> output_memory_types;
+  auto is_host_memory_output = [&](const Node* n, int output) {
+    auto it = output_memory_types.find(n->id());
+    if (it == output_memory_types.end()) {
+      MemoryTypeVector input_types, output_types;
+      if (!MemoryTypesForNode(graph->op_registry(), DeviceType(device_type()),
+                              n->def(), &input_types, &output_types)
+               .ok()) {
+        output_types.clear();
+      }
+      it = output_memory_types.emplace(n->id(), std::move(output_types)).first;
+    }
+    return output < it->second.size() && it->second[output] == HOST_MEMORY;
+  };
+
+  // Nodes on the same stream that wait for the same streams share a context.
+  std::map<std::pair<int, std::vector<int>>, GPUDeviceContext*> contexts;
+  device_context_map->assign(graph->num_node_ids(), nullptr);
+  for (const Node* n : graph->op_nodes()) {
+    const int stream_id = node_to_stream_id[n->id()];
+    // Only data dependencies need cross-stream events: the values of
+    // constants are copied to the GPU when their kernels are created, values
+    // in host memory are not written by kernels on a stream, and the nodes
+    // that share state through resources or references all run on stream 0.
+    std::vector<int> wait_stream_ids;
+    for (const Edge* e : n->in_edges()) {
+      const Node* src = e->src();
+      if (e->IsControlEdge() || !src->IsOp() || src->IsConstant()) continue;
+      const int src_stream_id = node_to_stream_id[src->id()];
+      if (src_stream_id == stream_id ||
+          is_host_memory_output(src, e->src_output())) {
+        continue;
+      }
+      wait_stream_ids.push_back(src_stream_id);
+    }
+    std::sort(wait_stream_ids.begin(), wait_stream_ids.end());
+    wait_stream_ids.erase(
+        std::unique(wait_stream_ids.begin(), wait_stream_ids.end()),
+        wait_stream_ids.end());
+
+    GPUDeviceContext*& context =
+        contexts[std::make_pair(stream_id, wait_stream_ids)];
+    if (context == nullptr) {
+      context = new GPUDeviceContext(stream_id, compute_streams_[stream_id],
+#if TENSORFLOW_USE_ROCM
+                                     stream_->nccl,
+#endif
+                                     stream_->host_to_device,
+                                     stream_->device_to_host,
+                                     stream_->device_to_device);
+      gtl::InlinedVector<se::Stream*, 2> wait_streams;
+      for (int wait_stream_id : wait_stream_ids) {
+        wait_streams.push_back(compute_streams_[wait_stream_id]);
+      }
+      context->set_wait_streams(std::move(wait_streams));
+      context->set_host_staging_pool(host_staging_pool_);
+    } else {
+      context->Ref();
+    }
+    (*device_context_map)[n->id()] = context;
+    VLOG(2) << "Node " << n->name() << " on GPU " << tf_device_id_.value()
+            << " => stream[" << stream_id << "], waits for "
+            << wait_stream_ids.size() << " streams";
+  }
+  return Status::OK();
+}
+
 Status BaseGPUDevice::MaybeCopyTensorToGPU(
     const AllocatorAttributes& alloc_attrs, const Tensor& from, Tensor* to,
     StatusCallback done) {
@@ -930,7 +1204,8 @@ Status SingleVirtualDeviceMemoryLimit(const GPUOptions& gpu_options,
     return errors::Internal("Failed to get compute capability for device.");
   }
   if (per_process_gpu_memory_fraction > 1.0 ||
-      gpu_options.experimental().use_unified_memory()) {
+      gpu_options.experimental().use_unified_memory() ||
+      gpu_options.experimental().managed_memory_threshold_bytes() > 0) {
     if (cc_major < 6) {
       return errors::Internal(
           "Unified memory on GPUs with compute capability lower than 6.0 "
@@ -990,11 +1265,12 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_GE(stream_id, 0);
+  DCHECK_LT(stream_id, compute_streams_.size());
   const gpuStream_t* gpu_stream = reinterpret_cast<const gpuStream_t*>(
-      stream_->compute->implementation()->GpuStreamMemberHack());
+      compute_streams_[stream_id]->implementation()->GpuStreamMemberHack());
   concrete_device->Reinitialize(context, gpu_stream, tf_device_id_, allocator,
-                                scratch_);
+                                scratch_[stream_id]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -1011,7 +1287,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
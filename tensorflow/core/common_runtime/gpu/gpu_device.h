@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_aware_allocator.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
@@ -48,6 +49,8 @@ limitations under the License.
 
 namespace tensorflow {
 class GPUKernelTracker;
+class GpuHostStagingPool;
+class GpuOversubscriptionAllocator;
 
 class BaseGPUDevice : public LocalDevice {
  public:
@@ -67,6 +70,13 @@ class BaseGPUDevice : public LocalDevice {
 
   Status Sync() override;
 
+  // If the device runs kernels on more than one compute stream, assigns each
+  // node of `graph` a stream and a context that waits for the streams of the
+  // node's producers.
+  Status FillContextMap(
+      const Graph* graph,
+      std::vector<DeviceContext*>* device_context_map) override;
+
   void ComputeAsync(AsyncOpKernel* op_kernel, OpKernelContext* context,
                     AsyncOpKernel::DoneCallback done) override;
 
@@ -142,19 +152,34 @@ class BaseGPUDevice : public LocalDevice {
     se::Stream* host_to_device = nullptr;
     se::Stream* device_to_host = nullptr;
     gtl::InlinedVector<se::Stream*, 4> device_to_device;
+    // Compute streams in addition to `compute`, created when
+    // GPUOptions.experimental.num_compute_streams > 1.
+    gtl::InlinedVector<se::Stream*, 4> extra_compute;
+    // Defers frees until all compute streams have passed them. Created on
+    // first use when there are extra compute streams.
+    GPUStreamAwareAllocator* stream_aware_allocator = nullptr;
     int priority = 0;
   };
   class StreamGroupFactory;
 
   StreamGroup* stream_;
+  // The compute streams kernels are launched on, indexed by stream id.
+  // Holds only stream_->compute unless multiple compute streams are enabled.
+  gtl::InlinedVector<se::Stream*, 4> compute_streams_;
+  GPUStreamAwareAllocator* stream_aware_allocator_ = nullptr;  // not owned
   mutex scratch_init_mutex_;
-  char* scratch_ = nullptr;
+  // Eigen scratch buffers, one per compute stream.
+  gtl::InlinedVector<char*, 4> scratch_;
   GPUDeviceContext* device_context_;
   GpuDeviceInfo* gpu_device_info_ = nullptr;
   mutex trace_mu_;
   TfDeviceId tf_device_id_;
   const bool sync_every_op_ = false;
   EventMgr* em_ = nullptr;
+  // Pinned buffers for staging host-to-device copies, or nullptr.
+  GpuHostStagingPool* host_staging_pool_ = nullptr;
+  // Places large allocations in managed memory, or nullptr.
+  GpuOversubscriptionAllocator* oversubscription_allocator_ = nullptr;
   std::unique_ptr<thread::ThreadPool> thread_pool_;
   std::unique_ptr<GPUKernelTracker> kernel_tracker_;
   int32 pending_cap_ = 0;
@@ -169,6 +194,12 @@ class BaseGPUDevice : public LocalDevice {
   std::string ComputeOpKernelDebugString(const OpKernel& op_kernel,
                                          const int& stream_id);
 
+  // Starts migrating the inputs of the kernel of `context` that are in managed
+  // memory to the device on `prefetch_stream`, and makes `stream` wait for the
+  // migration.
+  void PrefetchManagedInputs(OpKernelContext* context, se::Stream* stream,
+                             se::Stream* prefetch_stream);
+
   // This method returns an initialization status, in addition to
   // calling the "done" StatusCallback, if there is a failure to
   // allocate memory or if the tensor "from" is not DMA-copyable.
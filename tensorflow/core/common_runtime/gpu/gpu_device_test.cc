@@ -17,8 +17,12 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+
 #include "tensorflow/core/common_runtime/device/device_id_utils.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -405,6 +409,51 @@ TEST_F(GPUDeviceTest, UnifiedMemoryAllocation) {
   allocator->DeallocateRaw(ptr);
 }
 
+// Allocations above GPUOptions.experimental.managed_memory_threshold_bytes
+// are placed in managed memory and can be prefetched; smaller ones are not.
+TEST_F(GPUDeviceTest, ManagedMemoryThreshold) {
+  static constexpr PlatformDeviceId kPlatformDeviceId(0);
+  static constexpr int64 kThresholdBytes = 1 << 20;
+
+  int cc_major, cc_minor;
+  TF_ASSERT_OK(GetComputeCapability(kPlatformDeviceId, &cc_major, &cc_minor));
+  if (cc_major < 6) {
+    LOG(INFO) << "Managed memory oversubscription is not supported with "
+                 "pre-Pascal GPUs.";
+    return;
+  }
+
+  SessionOptions opts = MakeSessionOptions("0");
+  opts.config.mutable_gpu_options()
+      ->mutable_experimental()
+      ->set_managed_memory_threshold_bytes(kThresholdBytes);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  ASSERT_EQ(1, devices.size());
+
+  GpuOversubscriptionAllocator* allocator =
+      GPUProcessState::singleton()->GpuOversubscriptionAllocatorFor(
+          TfDeviceId(0));
+  ASSERT_NE(allocator, nullptr);
+  se::Stream* stream =
+      devices[0]->tensorflow_gpu_device_info()->default_context->stream();
+
+  void* small = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  void* large =
+      allocator->AllocateRaw(Allocator::kAllocatorAlignment, kThresholdBytes);
+  ASSERT_NE(small, nullptr);
+  ASSERT_NE(large, nullptr);
+  EXPECT_FALSE(allocator->Prefetch(small, stream));
+  EXPECT_TRUE(allocator->Prefetch(large, stream));
+  // Slices of a managed allocation prefetch the whole allocation.
+  EXPECT_TRUE(allocator->Prefetch(static_cast<char*>(large) + 4096, stream));
+  EXPECT_EQ(kThresholdBytes, allocator->RequestedSize(large));
+  TF_EXPECT_OK(stream->BlockHostUntilDone());
+  allocator->DeallocateRaw(small);
+  allocator->DeallocateRaw(large);
+}
+
 TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   SessionOptions opts = MakeSessionOptions("0");
   std::vector<std::unique_ptr<Device>> devices;
@@ -444,6 +493,93 @@ TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   }
 }
 
+TEST_F(GPUDeviceTest, CopyCPUTensorToGPUThroughStagingPool) {
+  SessionOptions opts = MakeSessionOptions("0");
+  auto* experimental =
+      opts.config.mutable_gpu_options()->mutable_experimental();
+  experimental->set_host_to_device_staging_chunk_bytes(1024);
+  experimental->set_num_host_to_device_staging_buffers(2);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  Device* device = devices[0].get();
+  auto* device_context = static_cast<GPUDeviceContext*>(
+      device->tensorflow_gpu_device_info()->default_context);
+  ASSERT_NE(device_context->host_staging_pool(), nullptr);
+  Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+
+  // 4000 bytes: three full chunks and a partial one, more than the pool has
+  // buffers for, so some chunks are staged and some are copied directly.
+  constexpr int kNumElements = 1000;
+  Tensor cpu_tensor(cpu_allocator(), DT_FLOAT, TensorShape({kNumElements}));
+  auto input = cpu_tensor.tensor<float, 1>();
+  for (int i = 0; i < kNumElements; ++i) {
+    input(i) = i;
+  }
+  Tensor gpu_tensor(allocator, DT_FLOAT, TensorShape({kNumElements}));
+  CopyCPUToGPU(&cpu_tensor, &gpu_tensor, device, device_context);
+
+  Tensor output_cpu_tensor(cpu_allocator(), DT_FLOAT,
+                           TensorShape({kNumElements}));
+  CopyGPUToCPU(&gpu_tensor, &output_cpu_tensor, device, device_context);
+  auto output = output_cpu_tensor.tensor<float, 1>();
+  for (int i = 0; i < kNumElements; ++i) {
+    EXPECT_EQ(input(i), output(i)) << " for index " << i;
+  }
+}
+
+TEST_F(GPUDeviceTest, FillContextMapAssignsBranchesToComputeStreams) {
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Const(root.WithOpName("x"), {1.0f, 2.0f});
+  auto a = ops::Square(root.WithOpName("a"), x);
+  auto b = ops::Square(root.WithOpName("b"), x);
+  auto c = ops::Add(root.WithOpName("c"), a, b);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&graph));
+  std::unordered_map<string, const Node*> nodes = graph.BuildNodeNameIndex();
+
+  {
+    // A single compute stream leaves the map empty.
+    SessionOptions opts = MakeSessionOptions("0");
+    std::vector<std::unique_ptr<Device>> devices;
+    TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+        opts, kDeviceNamePrefix, &devices));
+    std::vector<DeviceContext*> device_context_map;
+    TF_ASSERT_OK(devices[0]->FillContextMap(&graph, &device_context_map));
+    EXPECT_TRUE(device_context_map.empty());
+  }
+  BaseGPUDevice::TestOnlyReset();
+  GPUProcessState::singleton()->TestOnlyReset();
+
+  SessionOptions opts = MakeSessionOptions("0");
+  opts.config.mutable_gpu_options()
+      ->mutable_experimental()
+      ->set_num_compute_streams(2);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  std::vector<DeviceContext*> device_context_map;
+  TF_ASSERT_OK(devices[0]->FillContextMap(&graph, &device_context_map));
+  ASSERT_EQ(device_context_map.size(), graph.num_node_ids());
+  auto context = [&](const string& name) {
+    return static_cast<GPUDeviceContext*>(
+        device_context_map[nodes[name]->id()]);
+  };
+  // The constant stays on stream 0, the two independent branches start on
+  // different streams, and the join continues the stream of its first input
+  // after waiting for the other one.
+  EXPECT_EQ(context("x")->stream_id(), 0);
+  EXPECT_NE(context("a")->stream_id(), context("b")->stream_id());
+  EXPECT_TRUE(context("a")->wait_streams().empty());
+  EXPECT_TRUE(context("b")->wait_streams().empty());
+  EXPECT_EQ(context("c")->stream_id(), context("a")->stream_id());
+  ASSERT_EQ(context("c")->wait_streams().size(), 1);
+  EXPECT_EQ(context("c")->wait_streams()[0], context("b")->stream());
+  for (DeviceContext* device_context : device_context_map) {
+    if (device_context != nullptr) device_context->Unref();
+  }
+}
+
 TEST_F(GPUDeviceTest, DeviceDetails) {
   DeviceFactory* factory = DeviceFactory::GetFactory("GPU");
   std::vector<string> devices;
@@ -0,0 +1,82 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_host_staging_pool.h"
+
+#include "tensorflow/core/platform/logging.h"
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/stream_executor/gpu/gpu_driver.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+namespace tensorflow {
+
+GpuHostStagingPool::GpuHostStagingPool(Allocator* host_allocator,
+                                       size_t chunk_bytes, int max_buffers)
+    : host_allocator_(host_allocator),
+      chunk_bytes_(chunk_bytes),
+      max_buffers_(max_buffers) {
+  CHECK_GT(chunk_bytes_, 0);
+  CHECK_GT(max_buffers_, 0);
+}
+
+GpuHostStagingPool::~GpuHostStagingPool() {
+  mutex_lock l(mu_);
+  DCHECK_EQ(free_buffers_.size(), static_cast<size_t>(num_allocated_))
+      << "Staging buffers still in use";
+  for (void* buffer : free_buffers_) {
+    host_allocator_->DeallocateRaw(buffer);
+  }
+}
+
+void* GpuHostStagingPool::TryAcquire() {
+  mutex_lock l(mu_);
+  if (!free_buffers_.empty()) {
+    void* buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    return buffer;
+  }
+  if (num_allocated_ >= max_buffers_) {
+    return nullptr;
+  }
+  AllocationAttributes attrs;
+  attrs.retry_on_failure = false;
+  void* buffer = host_allocator_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                              chunk_bytes_, attrs);
+  if (buffer != nullptr) {
+    ++num_allocated_;
+  }
+  return buffer;
+}
+
+void GpuHostStagingPool::Release(void* buffer) {
+  DCHECK(buffer != nullptr);
+  mutex_lock l(mu_);
+  free_buffers_.push_back(buffer);
+}
+
+/*static*/
+bool GpuHostStagingPool::IsPinnedHostMemory(const void* ptr) {
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  auto memory_space = se::gpu::GpuDriver::GetPointerMemorySpace(
+      reinterpret_cast<se::gpu::GpuDevicePtr>(const_cast<void*>(ptr)));
+  return memory_space.ok() &&
+         memory_space.ValueOrDie() == se::gpu::MemorySpace::kHost;
+#else
+  return false;
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+}
+
+}  // namespace tensorflow
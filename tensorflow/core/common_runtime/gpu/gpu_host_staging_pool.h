@@ -0,0 +1,81 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_HOST_STAGING_POOL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_HOST_STAGING_POOL_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A bounded pool of fixed-size pinned host buffers used to stage CPU->GPU
+// copies of tensors that live in pageable memory.
+//
+// A copy from pageable memory is staged by the driver and blocks the host for
+// the whole transfer.  GPUUtil::CopyCPUTensorToGPU instead splits large
+// tensors into chunks of chunk_bytes(), copies each chunk into a buffer from
+// this pool and enqueues an asynchronous DMA from it on the host-to-device
+// stream, so the host copy of one chunk overlaps the transfer of the previous
+// ones.  Buffers are returned once the DMA reading them has completed.
+//
+// Reference counted because in-flight copies may still hold buffers when the
+// owning GPU device is destroyed.
+class GpuHostStagingPool : public core::RefCounted {
+ public:
+  // Does not take ownership of `host_allocator`, which must return memory
+  // the GPU can DMA from and outlive the pool.  At most `max_buffers`
+  // buffers of `chunk_bytes` are allocated, lazily on first use.
+  GpuHostStagingPool(Allocator* host_allocator, size_t chunk_bytes,
+                     int max_buffers);
+  ~GpuHostStagingPool() override;
+
+  size_t chunk_bytes() const { return chunk_bytes_; }
+
+  // Returns a buffer of chunk_bytes(), or nullptr if all buffers are in use
+  // or the host allocator is out of memory.  Never blocks: callers fall back
+  // to copying from the source directly, which keeps copies issued from
+  // EventMgr callbacks from waiting on the EventMgr.
+  void* TryAcquire() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns a buffer obtained from TryAcquire() to the pool.
+  void Release(void* buffer) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns true if `ptr` points to page-locked host memory, which the GPU
+  // can DMA from without staging.  Returns false if the platform cannot
+  // tell.
+  static bool IsPinnedHostMemory(const void* ptr);
+
+ private:
+  Allocator* const host_allocator_;  // Not owned.
+  const size_t chunk_bytes_;
+  const int max_buffers_;
+
+  mutex mu_;
+  std::vector<void*> free_buffers_ TF_GUARDED_BY(mu_);
+  int num_allocated_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuHostStagingPool);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_HOST_STAGING_POOL_H_
@@ -15,6 +15,8 @@ limitations under the License.
 
 #if GOOGLE_CUDA
 #include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
 #define EIGEN_USE_GPU
 #endif
 
@@ -25,6 +27,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 
+#include "tensorflow/core/common_runtime/device/device_id_utils.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/platform/logging.h"
+
 namespace tensorflow {
 
 void* GpuManagedAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
@@ -51,4 +57,137 @@ void GpuManagedAllocator::DeallocateRaw(void* ptr) {
 #endif
 }
 
+
+GpuOversubscriptionAllocator::GpuOversubscriptionAllocator(
+    Allocator* device_allocator, PlatformDeviceId platform_device_id,
+    size_t threshold_bytes)
+    : device_allocator_(device_allocator),
+      stream_exec_(DeviceIdUtil::ExecutorForPlatformDeviceId(
+                       GPUMachineManager(), platform_device_id)
+                       .ValueOrDie()),
+      platform_device_id_(platform_device_id),
+      threshold_bytes_(threshold_bytes) {}
+
+GpuOversubscriptionAllocator::~GpuOversubscriptionAllocator() {}
+
+void* GpuOversubscriptionAllocator::AllocateRaw(size_t alignment,
+                                                size_t num_bytes) {
+#if GOOGLE_CUDA
+  if (num_bytes >= threshold_bytes_ && alignment <= kAllocatorAlignment) {
+    se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+    CUdeviceptr result = 0;
+    CUresult res = cuMemAllocManaged(&result, num_bytes, CU_MEM_ATTACH_GLOBAL);
+    if (res == CUDA_SUCCESS) {
+      // Lets the device map the pages that are on the host, so that accesses
+      // not covered by a prefetch read them remotely instead of faulting.
+      cuMemAdvise(result, num_bytes, CU_MEM_ADVISE_SET_ACCESSED_BY,
+                  platform_device_id_.value());
+      mutex_lock l(mu_);
+      managed_[static_cast<uintptr_t>(result)] = num_bytes;
+      return reinterpret_cast<void*>(result);
+    }
+    const char* error_name;
+    cuGetErrorName(res, &error_name);
+    LOG(WARNING) << "cuMemAllocManaged failed to allocate " << num_bytes
+                 << " bytes: " << error_name
+                 << ". Falling back to device memory.";
+  }
+#endif  // GOOGLE_CUDA
+  return device_allocator_->AllocateRaw(alignment, num_bytes);
+}
+
+void GpuOversubscriptionAllocator::DeallocateRaw(void* ptr) {
+  bool managed;
+  {
+    mutex_lock l(mu_);
+    managed = managed_.erase(reinterpret_cast<uintptr_t>(ptr)) > 0;
+  }
+  if (!managed) {
+    device_allocator_->DeallocateRaw(ptr);
+    return;
+  }
+#if GOOGLE_CUDA
+  CUresult res = cuMemFree(reinterpret_cast<CUdeviceptr>(ptr));
+  if (res != CUDA_SUCCESS && res != CUDA_ERROR_DEINITIALIZED) {
+    const char* error_name;
+    cuGetErrorName(res, &error_name);
+    LOG(ERROR) << "cuMemFree failed to free managed memory at " << ptr << ": "
+               << error_name;
+  }
+#endif  // GOOGLE_CUDA
+}
+
+size_t GpuOversubscriptionAllocator::ManagedSize(const void* ptr) const {
+  mutex_lock l(mu_);
+  auto it = managed_.find(reinterpret_cast<uintptr_t>(ptr));
+  return it == managed_.end() ? 0 : it->second;
+}
+
+bool GpuOversubscriptionAllocator::TracksAllocationSizes() const {
+  return device_allocator_->TracksAllocationSizes();
+}
+
+size_t GpuOversubscriptionAllocator::RequestedSize(const void* ptr) const {
+  const size_t managed_size = ManagedSize(ptr);
+  return managed_size > 0 ? managed_size
+                          : device_allocator_->RequestedSize(ptr);
+}
+
+size_t GpuOversubscriptionAllocator::AllocatedSize(const void* ptr) const {
+  const size_t managed_size = ManagedSize(ptr);
+  return managed_size > 0 ? managed_size
+                          : device_allocator_->AllocatedSize(ptr);
+}
+
+int64 GpuOversubscriptionAllocator::AllocationId(const void* ptr) const {
+  return ManagedSize(ptr) > 0 ? 0 : device_allocator_->AllocationId(ptr);
+}
+
+absl::optional<AllocatorStats> GpuOversubscriptionAllocator::GetStats() {
+  return device_allocator_->GetStats();
+}
+
+void GpuOversubscriptionAllocator::ClearStats() {
+  device_allocator_->ClearStats();
+}
+
+void GpuOversubscriptionAllocator::SetSafeFrontier(uint64 count) {
+  device_allocator_->SetSafeFrontier(count);
+}
+
+void GpuOversubscriptionAllocator::SetStream(void* stream) {
+  device_allocator_->SetStream(stream);
+}
+
+bool GpuOversubscriptionAllocator::Prefetch(const void* ptr,
+                                            se::Stream* stream) {
+  uintptr_t begin;
+  size_t num_bytes;
+  {
+    mutex_lock l(mu_);
+    // Tensors may be slices of a larger buffer: finds the allocation that
+    // contains `ptr`.
+    auto it = managed_.upper_bound(reinterpret_cast<uintptr_t>(ptr));
+    if (it == managed_.begin()) return false;
+    --it;
+    if (reinterpret_cast<uintptr_t>(ptr) >= it->first + it->second) {
+      return false;
+    }
+    begin = it->first;
+    num_bytes = it->second;
+  }
+#if GOOGLE_CUDA
+  CUresult res = cuMemPrefetchAsync(static_cast<CUdeviceptr>(begin), num_bytes,
+                                    platform_device_id_.value(),
+                                    se::gpu::AsGpuStreamValue(stream));
+  if (res != CUDA_SUCCESS) {
+    VLOG(1) << "cuMemPrefetchAsync failed for " << num_bytes << " bytes";
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif  // GOOGLE_CUDA
+}
+
 }  // namespace tensorflow
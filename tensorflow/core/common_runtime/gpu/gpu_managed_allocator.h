@@ -16,7 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
 
+#include <map>
+#include <memory>
+
+#include "tensorflow/core/common_runtime/gpu/gpu_id.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
@@ -31,6 +40,60 @@ class GpuManagedAllocator : public Allocator {
   void DeallocateRaw(void* ptr) override;
 };
 
+// Wraps a GPU allocator and serves the allocations of at least
+// `threshold_bytes` from CUDA managed memory instead, for devices with
+// GPUOptions.experimental.managed_memory_threshold_bytes set.
+//
+// The driver migrates the pages of managed memory between host and device on
+// demand and evicts them to host memory when the device is full, so a model
+// whose large tensors (embeddings, optimizer slots) slightly exceed device
+// memory runs slower instead of failing. To avoid taking the page faults on
+// the critical path, the GPU device calls Prefetch() on the inputs of each
+// kernel it launches: the host usually runs ahead of the GPU, so the migration
+// overlaps the kernels queued before.
+//
+// Managed allocations are made only on Pascal or later GPUs.
+class GpuOversubscriptionAllocator : public Allocator {
+ public:
+  // Takes ownership of `device_allocator`.
+  GpuOversubscriptionAllocator(Allocator* device_allocator,
+                               PlatformDeviceId platform_device_id,
+                               size_t threshold_bytes);
+  ~GpuOversubscriptionAllocator() override;
+
+  string Name() override { return device_allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override;
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  int64 AllocationId(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+  void SetSafeFrontier(uint64 count) override;
+  void SetStream(void* stream) override;
+
+  // If `ptr` points into a managed allocation, enqueues the migration of the
+  // whole allocation to the device on `stream` and returns true. Returns false
+  // otherwise, without touching `stream`.
+  bool Prefetch(const void* ptr, se::Stream* stream);
+
+ private:
+  // Returns the size of the managed allocation starting at `ptr`, or 0.
+  size_t ManagedSize(const void* ptr) const;
+
+  std::unique_ptr<Allocator> device_allocator_;
+  se::StreamExecutor* stream_exec_;  // Not owned.
+  const PlatformDeviceId platform_device_id_;
+  const size_t threshold_bytes_;
+
+  mutable mutex mu_;
+  // Managed allocations by address, with their size.
+  std::map<uintptr_t, size_t> managed_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuOversubscriptionAllocator);
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_MANAGED_ALLOCATOR_H_
@@ -28,7 +28,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_managed_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_virtual_mem_allocator.h"
+#include "tensorflow/core/common_runtime/memory_timeline_allocator.h"
 #include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -39,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
 #include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
@@ -72,6 +75,13 @@ static bool UseCudaMallocAsyncAllocator() {
 #endif
 }
 
+// NOLINTNEXTLINE(clang-diagnostic-unused-function)
+static bool UseVirtualMemoryBfcAllocator() {
+  const char* allocator_env = std::getenv("TF_GPU_ALLOCATOR");
+  return allocator_env != nullptr &&
+         std::strcmp(allocator_env, "vmm_bfc") == 0;
+}
+
 /*static*/ GPUProcessState* GPUProcessState::singleton(GPUProcessState* ps) {
   static GPUProcessState* instance = ps ? ps : new GPUProcessState;
   DCHECK((!ps) || (ps == instance))
@@ -103,6 +113,39 @@ static SubAllocator* CreateSubAllocator(
                                                             platform_device_id)
                       .ValueOrDie();
 
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 10020
+  // TF_GPU_ALLOCATOR=vmm_bfc backs the BFC allocator with pages of virtual
+  // memory so that it can compact its heap when fragmented.  Holes left by
+  // compaction are never reused, hence the generous address space.
+  if (UseVirtualMemoryBfcAllocator() &&
+      !(options.per_process_gpu_memory_fraction() > 1.0 ||
+        options.experimental().use_unified_memory())) {
+    constexpr size_t kVirtualAddressSpaceFactor = 8;
+    auto* gpu_context = reinterpret_cast<stream_executor::gpu::GpuContext*>(
+        executor->implementation()->GpuContextHack());
+    std::vector<PlatformDeviceId> platform_peer_gpu_ids;
+    for (const TfDeviceId tf_device_id : peer_gpu_ids) {
+      PlatformDeviceId platform_device_id;
+      TF_CHECK_OK(GpuIdManager::TfToPlatformDeviceId(tf_device_id,
+                                                     &platform_device_id));
+      platform_peer_gpu_ids.push_back(platform_device_id);
+    }
+    auto allocator = GpuVirtualMemAllocator::Create(
+        alloc_visitors, {}, *gpu_context, platform_device_id,
+        /*virtual_address_space_size=*/total_bytes *
+            kVirtualAddressSpaceFactor,
+        platform_peer_gpu_ids, /*map_in_pages=*/true);
+    if (allocator.ok()) {
+      LOG(INFO) << "Using virtual memory BFC allocator for GPU: "
+                << platform_device_id;
+      return allocator.ValueOrDie().release();
+    }
+    LOG(WARNING) << "TF_GPU_ALLOCATOR=vmm_bfc is set but the virtual memory "
+                 << "allocator is unavailable: " << allocator.status()
+                 << ". Falling back to the default allocator.";
+  }
+#endif
+
   // FIXME(imintz): Observed OOM issues when using the virtual memory
   // allocators. This should be reenabled when resolved.
 #if 0 && defined(GOOGLE_CUDA) && CUDA_VERSION >= 10020
@@ -217,6 +260,23 @@ Allocator* GPUProcessState::GetGPUAllocator(
           new GpuCudaMallocAsyncAllocator(platform_device_id, total_bytes);
     }
 
+    GpuOversubscriptionAllocator* oversubscription_allocator = nullptr;
+    const int64 managed_memory_threshold_bytes =
+        options.experimental().managed_memory_threshold_bytes();
+    if (managed_memory_threshold_bytes > 0) {
+      LOG(INFO) << "Placing GPU allocations of at least "
+                << managed_memory_threshold_bytes
+                << " bytes in managed memory on GPU: " << platform_device_id;
+      oversubscription_allocator = new GpuOversubscriptionAllocator(
+          gpu_allocator, platform_device_id, managed_memory_threshold_bytes);
+      gpu_allocator = oversubscription_allocator;
+    }
+
+    if (profiler::MemoryTimeline* timeline = profiler::MemoryTimeline::Get()) {
+      gpu_allocator = new MemoryTimelineAllocator(
+          gpu_allocator, /*owns_allocator=*/true, timeline);
+    }
+
     Allocator* recording_allocator = nullptr;
     if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
       ProcessState::MemDesc md;
@@ -230,7 +290,8 @@ Allocator* GPUProcessState::GetGPUAllocator(
     allocator_parts = {std::unique_ptr<Allocator>(gpu_allocator),
                        std::unique_ptr<SharedCounter>(timing_counter),
                        gpu_bfc_allocator, sub_allocator,
-                       std::unique_ptr<Allocator>(recording_allocator)};
+                       std::unique_ptr<Allocator>(recording_allocator),
+                       oversubscription_allocator};
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
     return allocator_parts.recording_allocator.get();
@@ -269,6 +330,15 @@ SharedCounter* GPUProcessState::GPUAllocatorCounter(TfDeviceId tf_device_id) {
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 }
 
+GpuOversubscriptionAllocator* GPUProcessState::GpuOversubscriptionAllocatorFor(
+    TfDeviceId tf_device_id) {
+  mutex_lock l(mu_);
+  if (tf_device_id.value() >= static_cast<int64>(gpu_allocators_.size())) {
+    return nullptr;
+  }
+  return gpu_allocators_[tf_device_id.value()].oversubscription_allocator;
+}
+
 Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
   CHECK(process_state_);
   if (!HasGPUDevice() ||
@@ -32,6 +32,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class GpuOversubscriptionAllocator;
+
 class Allocator;
 class GPUBFCAllocator;
 class PoolAllocator;
@@ -119,6 +121,12 @@ class GPUProcessState {
 
   SharedCounter* GPUAllocatorCounter(TfDeviceId tf_device_id);
 
+  // Returns the allocator that places the large allocations of the GPU in
+  // managed memory, or nullptr if GetGPUAllocator() did not create one for
+  // `tf_device_id`. See GPUOptions.Experimental.managed_memory_threshold_bytes.
+  GpuOversubscriptionAllocator* GpuOversubscriptionAllocatorFor(
+      TfDeviceId tf_device_id);
+
  protected:
   // GPUProcessState is a singleton that should not normally be deleted except
   // at process shutdown.
@@ -147,6 +155,8 @@ class GPUProcessState {
     GPUBFCAllocator* bfc_allocator;
     SubAllocator* sub_allocator;  // owned by allocator
     std::unique_ptr<Allocator> recording_allocator;
+    // Owned by allocator, if any.
+    GpuOversubscriptionAllocator* oversubscription_allocator = nullptr;
   };
   std::vector<AllocatorParts> gpu_allocators_ TF_GUARDED_BY(mu_);
   std::vector<std::vector<SubAllocator::Visitor>> gpu_visitors_
@@ -0,0 +1,114 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_aware_allocator.h"
+
+#include <atomic>
+#include <utility>
+
+namespace tensorflow {
+
+GPUStreamAwareAllocator::GPUStreamAwareAllocator(
+    Allocator* allocator, std::vector<se::Stream*> streams,
+    EventMgr* event_mgr)
+    : allocator_(allocator),
+      streams_(std::move(streams)),
+      event_mgr_(event_mgr) {}
+
+GPUStreamAwareAllocator::~GPUStreamAwareAllocator() {
+  mutex_lock l(mu_);
+  for (void* ptr : freed_) allocator_->DeallocateRaw(ptr);
+}
+
+void* GPUStreamAwareAllocator::AllocateRaw(size_t alignment,
+                                           size_t num_bytes) {
+  return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+}
+
+void* GPUStreamAwareAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  bool has_freed;
+  {
+    mutex_lock l(mu_);
+    has_freed = !freed_.empty();
+  }
+  if (has_freed && allocation_attr.retry_on_failure) {
+    // Before waiting for memory to be freed, make sure the buffers held back
+    // here will eventually be released.
+    AllocationAttributes no_retry(/*retry_on_failure=*/false,
+                                  allocation_attr.allocation_will_be_logged,
+                                  allocation_attr.freed_by_func);
+    void* ptr = allocator_->AllocateRaw(alignment, num_bytes, no_retry);
+    if (ptr != nullptr) return ptr;
+    ReleaseFreedBuffers();
+  }
+  return allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+}
+
+void GPUStreamAwareAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  mutex_lock l(mu_);
+  freed_.push_back(ptr);
+}
+
+void GPUStreamAwareAllocator::ReleaseFreedBuffers() {
+  struct Release {
+    std::vector<void*> buffers;
+    std::atomic<int> pending_streams;
+  };
+  Release* release;
+  {
+    mutex_lock l(mu_);
+    if (freed_.empty()) return;
+    release = new Release;
+    release->buffers.swap(freed_);
+  }
+  release->pending_streams = streams_.size();
+  // The callbacks only use the wrapped allocator, so they do not depend on
+  // the lifetime of this one.
+  Allocator* allocator = allocator_;
+  for (se::Stream* stream : streams_) {
+    event_mgr_->ThenExecute(stream, [allocator, release]() {
+      if (release->pending_streams.fetch_sub(1) != 1) return;
+      for (void* ptr : release->buffers) allocator->DeallocateRaw(ptr);
+      delete release;
+    });
+  }
+}
+
+bool GPUStreamAwareAllocator::TracksAllocationSizes() const {
+  return allocator_->TracksAllocationSizes();
+}
+
+size_t GPUStreamAwareAllocator::RequestedSize(const void* ptr) const {
+  return allocator_->RequestedSize(ptr);
+}
+
+size_t GPUStreamAwareAllocator::AllocatedSize(const void* ptr) const {
+  return allocator_->AllocatedSize(ptr);
+}
+
+int64 GPUStreamAwareAllocator::AllocationId(const void* ptr) const {
+  return allocator_->AllocationId(ptr);
+}
+
+absl::optional<AllocatorStats> GPUStreamAwareAllocator::GetStats() {
+  return allocator_->GetStats();
+}
+
+void GPUStreamAwareAllocator::ClearStats() { allocator_->ClearStats(); }
+
+}  // namespace tensorflow
@@ -0,0 +1,82 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_AWARE_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_AWARE_ALLOCATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device/device_event_mgr.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that wraps the allocator of a GPU device that launches
+// kernels on more than one compute stream.
+//
+// With a single compute stream, a buffer can be handed out again as soon as
+// it is freed on the host: any kernel that still uses it was queued earlier
+// on the same stream and will finish before the next user starts.  With
+// several compute streams that no longer holds, so freed buffers are kept
+// back and only returned to the wrapped allocator once an event queued on
+// every compute stream after the free has completed.
+class GPUStreamAwareAllocator : public Allocator {
+ public:
+  // Does not take ownership of `allocator`, `streams` or `event_mgr`.
+  GPUStreamAwareAllocator(Allocator* allocator,
+                          std::vector<se::Stream*> streams,
+                          EventMgr* event_mgr);
+  // Returns the buffers still held back directly to the wrapped allocator,
+  // so the streams must be idle.
+  ~GPUStreamAwareAllocator() override;
+
+  string Name() override { return allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override;
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  int64 AllocationId(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Queues an event on every compute stream and returns the buffers freed so
+  // far to the wrapped allocator once all of them have completed.  The GPU
+  // device calls this after launching each kernel.
+  void ReleaseFreedBuffers() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  Allocator* const allocator_;  // Not owned.
+  const std::vector<se::Stream*> streams_;
+  EventMgr* const event_mgr_;  // Not owned.
+
+  mutex mu_;
+  // Buffers freed on the host that may still be in use on some stream.
+  std::vector<void*> freed_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUStreamAwareAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_AWARE_ALLOCATOR_H_
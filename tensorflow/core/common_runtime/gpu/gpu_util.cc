@@ -15,10 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_host_staging_pool.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -295,6 +300,36 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
       });
 }
 
+namespace {
+
+// Copies `total_bytes` from pageable host memory at `src` to `dst` on the GPU
+// in chunks staged through pinned buffers from `pool`, so the host copy of
+// each chunk overlaps the DMA of the chunks queued before it on `stream`.
+// Chunks for which no staging buffer is free are copied from `src` directly.
+void CopyPageableToGPUInChunks(const char* src, char* dst, int64 total_bytes,
+                               GpuHostStagingPool* pool, se::Stream* stream,
+                               EventMgr* event_mgr) {
+  const int64 chunk_bytes = pool->chunk_bytes();
+  for (int64 offset = 0; offset < total_bytes; offset += chunk_bytes) {
+    const int64 bytes = std::min(chunk_bytes, total_bytes - offset);
+    DeviceMemoryBase gpu_dst_ptr(dst + offset, bytes);
+    void* staging = pool->TryAcquire();
+    if (staging == nullptr) {
+      stream->ThenMemcpy(&gpu_dst_ptr, src + offset, bytes);
+      continue;
+    }
+    memcpy(staging, src + offset, bytes);
+    stream->ThenMemcpy(&gpu_dst_ptr, staging, bytes);
+    pool->Ref();
+    event_mgr->ThenExecute(stream, [pool, staging]() {
+      pool->Release(staging);
+      pool->Unref();
+    });
+  }
+}
+
+}  // namespace
+
 /*  static */
 void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
                                  const DeviceContext* device_context,
@@ -323,12 +358,25 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   }
 
   const int64 total_bytes = cpu_tensor->TotalBytes();
+  GpuHostStagingPool* staging_pool =
+      static_cast<const GPUDeviceContext*>(device_context)
+          ->host_staging_pool();
   // Note that 0-size tensors have no backing buffer.
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
-    DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
-    recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
+    if (staging_pool != nullptr &&
+        total_bytes >= static_cast<int64>(staging_pool->chunk_bytes()) &&
+        !GpuHostStagingPool::IsPinnedHostMemory(src_ptr)) {
+      CopyPageableToGPUInChunks(static_cast<const char*>(src_ptr),
+                                static_cast<char*>(dst_ptr), total_bytes,
+                                staging_pool, recv_host_to_device_stream,
+                                dev_info->event_mgr);
+    } else {
+      DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
+      recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr,
+                                             total_bytes);
+    }
   }
   // Use of cpu_tensor may outlive stack scope, so keep a ref.
   TensorReference input_ref(*cpu_tensor);
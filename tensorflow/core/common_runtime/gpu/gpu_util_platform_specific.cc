@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_host_staging_pool.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -23,6 +24,16 @@ limitations under the License.
 
 namespace tensorflow {
 
+GPUDeviceContext::~GPUDeviceContext() {
+  if (host_staging_pool_ != nullptr) host_staging_pool_->Unref();
+}
+
+void GPUDeviceContext::set_host_staging_pool(GpuHostStagingPool* pool) {
+  if (pool != nullptr) pool->Ref();
+  if (host_staging_pool_ != nullptr) host_staging_pool_->Unref();
+  host_staging_pool_ = pool;
+}
+
 void GPUDeviceContext::CopyCPUTensorToDevice(const Tensor* cpu_tensor,
                                              Device* device,
                                              Tensor* device_tensor,
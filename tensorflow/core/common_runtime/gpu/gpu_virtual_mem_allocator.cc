@@ -63,7 +63,7 @@ GpuVirtualMemAllocator::Create(
     const std::vector<Visitor>& alloc_visitors,
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id, size_t virtual_address_space_size,
-    const std::vector<PlatformDeviceId>& peer_gpu_ids) {
+    const std::vector<PlatformDeviceId>& peer_gpu_ids, bool map_in_pages) {
   std::vector<GpuDeviceHandle> access_gpu_handles;
   access_gpu_handles.reserve(peer_gpu_ids.size() + 1);
 
@@ -105,7 +105,7 @@ GpuVirtualMemAllocator::Create(
 
   return std::unique_ptr<GpuVirtualMemAllocator>(new GpuVirtualMemAllocator(
       alloc_visitors, free_visitors, gpu_context, gpu_id,
-      std::move(access_gpu_handles), vmem, max_granularity));
+      std::move(access_gpu_handles), vmem, max_granularity, map_in_pages));
 }
 
 GpuVirtualMemAllocator::GpuVirtualMemAllocator(
@@ -113,13 +113,14 @@ GpuVirtualMemAllocator::GpuVirtualMemAllocator(
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id,
     const std::vector<GpuDeviceHandle> access_gpu_handles,
-    GpuDriver::VmemSpan vmem, size_t granularity)
+    GpuDriver::VmemSpan vmem, size_t granularity, bool map_in_pages)
     : SubAllocator(alloc_visitors, free_visitors),
       gpu_context_(gpu_context),
       gpu_id_(gpu_id),
       access_gpu_handles_(access_gpu_handles),
       vmem_(vmem),
-      granularity_(granularity) {}
+      granularity_(granularity),
+      map_in_pages_(map_in_pages) {}
 
 GpuVirtualMemAllocator::~GpuVirtualMemAllocator() {
   for (const auto mapping : mappings_) {
@@ -147,72 +148,109 @@ void* GpuVirtualMemAllocator::Alloc(size_t alignment, size_t num_bytes,
     return nullptr;
   }
 
-  // Create physical memory backing allocation.
-  auto maybe_handle =
-      GpuDriver::CreateMemoryHandle(&gpu_context_, padded_bytes);
+  // Create physical memory backing allocation, one handle per page if
+  // requested.
+  const size_t mapping_bytes = map_in_pages_ ? granularity_ : padded_bytes;
+  size_t mapped_bytes = 0;
+  int num_mappings = 0;
+  while (mapped_bytes < padded_bytes) {
+    size_t bytes = MapNewMemory(next_va + mapped_bytes, mapping_bytes);
+    if (bytes == 0) {
+      UnmapMappings(mappings_.end() - num_mappings, mappings_.end());
+      return nullptr;
+    }
+    mapped_bytes += bytes;
+    ++num_mappings;
+  }
+  next_alloc_offset_ += mapped_bytes;
+  VisitAlloc(reinterpret_cast<void*>(next_va), gpu_id_.value(), mapped_bytes);
+  *bytes_received = mapped_bytes;
+  return reinterpret_cast<void*>(next_va);
+}
+
+size_t GpuVirtualMemAllocator::MapNewMemory(GpuDevicePtr va,
+                                            size_t num_bytes) {
+  auto maybe_handle = GpuDriver::CreateMemoryHandle(&gpu_context_, num_bytes);
   if (!maybe_handle.ok()) {
     LOG(ERROR) << maybe_handle.status();
-    return nullptr;
+    return 0;
   }
   GpuDriver::GenericMemoryHandle handle = std::move(maybe_handle).ValueOrDie();
 
   // Map VAs for this physical memory.
-  auto status =
-      GpuDriver::MapMemory(&gpu_context_, next_va, handle, access_gpu_handles_);
+  auto status = GpuDriver::MapMemory(&gpu_context_, va, handle,
+                                     access_gpu_handles_);
   if (!status.ok()) {
     LOG(ERROR) << status;
     GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
-    return nullptr;
+    return 0;
   }
-  next_alloc_offset_ += handle.bytes;
-  mappings_.push_back({next_va, std::move(handle)});
-  VisitAlloc(reinterpret_cast<void*>(next_va), gpu_id_.value(), padded_bytes);
-  *bytes_received = padded_bytes;
-  return reinterpret_cast<void*>(next_va);
+  const size_t bytes = handle.bytes;
+  mappings_.push_back({va, std::move(handle)});
+  return bytes;
+}
+
+void GpuVirtualMemAllocator::UnmapMappings(
+    std::vector<Mapping>::iterator first, std::vector<Mapping>::iterator last) {
+  for (auto it = first; it != last; ++it) {
+    GpuDriver::UnmapMemory(&gpu_context_, it->va, it->physical.bytes);
+    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(it->physical));
+  }
+  mappings_.erase(first, last);
 }
 
 void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
   if (ptr == nullptr) return;
 
-  auto mapping_it =
-      std::lower_bound(mappings_.begin(), mappings_.end(), ptr,
-                       [](const Mapping& mapping, const void* ptr) {
-                         return reinterpret_cast<const void*>(mapping.va) < ptr;
-                       });
-  if (mapping_it == mappings_.end() ||
-      (reinterpret_cast<void*>(mapping_it->va) != ptr)) {
-    LOG(ERROR) << "Could not find GPU vmem mapping for address at "
-               << reinterpret_cast<uintptr_t>(ptr);
-    return;
+  const GpuDevicePtr begin = reinterpret_cast<GpuDevicePtr>(ptr);
+  const GpuDevicePtr end = begin + num_bytes;
+  auto first = std::lower_bound(
+      mappings_.begin(), mappings_.end(), begin,
+      [](const Mapping& mapping, GpuDevicePtr va) { return mapping.va < va; });
+  // Mappings can only be unmapped as a whole, so the range must not start or
+  // end inside one.
+  if (first != mappings_.begin()) {
+    const Mapping& prev = *(first - 1);
+    if (prev.va + prev.physical.bytes > begin) {
+      LOG(ERROR) << "Could not find GPU vmem mapping for address at "
+                 << reinterpret_cast<uintptr_t>(ptr);
+      return;
+    }
   }
-
-  int num_mappings_to_free = 0;
-  int total_bytes = 0;
-  for (auto it = mapping_it; it != mappings_.end() && total_bytes < num_bytes;
-       ++it) {
-    ++num_mappings_to_free;
-    total_bytes += it->physical.bytes;
+  auto last = first;
+  size_t total_bytes = 0;
+  for (; last != mappings_.end() && last->va < end; ++last) {
+    total_bytes += last->physical.bytes;
   }
-  if (total_bytes != num_bytes) {
-    LOG(ERROR) << "Invalid size requested for freeing GPU vmem mapping. Got "
-               << strings::HumanReadableNumBytes(num_bytes) << " but expected "
-               << strings::HumanReadableNumBytes(mapping_it->physical.bytes);
-    return;
+  if (last != first) {
+    const Mapping& back = *(last - 1);
+    if (back.va + back.physical.bytes > end) {
+      LOG(ERROR) << "Invalid size requested for freeing GPU vmem mapping. Got "
+                 << strings::HumanReadableNumBytes(num_bytes)
+                 << " but the last mapping ends "
+                 << strings::HumanReadableNumBytes(back.va +
+                                                   back.physical.bytes - end)
+                 << " later";
+      return;
+    }
   }
 
-  VLOG(1) << "Freeing " << num_mappings_to_free << " mappings for a total of "
+  VLOG(1) << "Freeing " << (last - first) << " mappings for a total of "
           << total_bytes << " bytes";
-  for (auto it = mapping_it; it < mapping_it + num_mappings_to_free; ++it) {
-    GpuDriver::UnmapMemory(&gpu_context_, it->va, it->physical.bytes);
-    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(it->physical));
+  if (map_in_pages_ && last != first) {
+    // The freed range may be part of a region that the device is still
+    // working on.  Make sure that no pending work touches it once unmapped.
+    GpuDriver::SynchronizeContext(&gpu_context_);
   }
 
-  // Move back the next_alloc_offset_ if this free was at the end.
-  if (mapping_it + num_mappings_to_free == mappings_.end()) {
-    next_alloc_offset_ = mapping_it->va - vmem_.base;
+  // Move back the next_alloc_offset_ if this free was at the end.  With
+  // map_in_pages the range may be part of a region that stays allocated, so
+  // its addresses are never reused.
+  if (!map_in_pages_ && last == mappings_.end()) {
+    next_alloc_offset_ = begin - vmem_.base;
   }
 
-  mappings_.erase(mapping_it, mapping_it + num_mappings_to_free);
+  UnmapMappings(first, last);
   VisitFree(ptr, gpu_id_.value(), num_bytes);
 }
 
@@ -37,6 +37,13 @@ namespace tensorflow {
 // reserving a large chunk of virtual addresses at construction and then mapping
 // physical memory pages to this virtual address range as requested.
 //
+// If map_in_pages is true, each page of an allocation gets its own physical
+// memory handle so that Free() can release any page-aligned part of an
+// allocation.  BFCAllocator uses this to compact its heap: the pages under free
+// chunks are returned and remapped at the end of the address range to back a
+// new region.  Since holes are never reused, the virtual address space should
+// then be several times larger than the physical memory.
+//
 // This class is not thread-safe.
 class GpuVirtualMemAllocator : public SubAllocator {
  public:
@@ -46,7 +53,8 @@ class GpuVirtualMemAllocator : public SubAllocator {
          const std::vector<Visitor>& free_visitors,
          stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
          size_t virtual_address_space_size,
-         const std::vector<PlatformDeviceId>& peer_gpu_ids);
+         const std::vector<PlatformDeviceId>& peer_gpu_ids,
+         bool map_in_pages = false);
   ~GpuVirtualMemAllocator() override;
 
   // Allocates memory at least as large as requested by num_bytes. Will be
@@ -65,18 +73,30 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // should be much larger than the max physical size of the allocator.
   //
   // In practice, since the BFC allocator coalesces adjacent AllocationRegions,
-  // this free function should never be invoked.
+  // this free function should never be invoked unless map_in_pages is set.
+  //
+  // The range may contain holes left by earlier frees.  With map_in_pages, it
+  // may be any page-aligned part of an allocation.
   void Free(void* ptr, size_t num_bytes) override;
 
   bool SupportsCoalescing() const override { return true; }
 
+  size_t PartialFreeGranularity() const override {
+    return map_in_pages_ ? granularity_ : 0;
+  }
+
  private:
   GpuVirtualMemAllocator(
       const std::vector<Visitor>& alloc_visitors,
       const std::vector<Visitor>& free_visitors,
       stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
       std::vector<stream_executor::gpu::GpuDeviceHandle> access_device_handles,
-      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity);
+      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity,
+      bool map_in_pages);
+
+  // Creates physical memory of num_bytes, maps it at va and records the
+  // mapping.  Returns the number of bytes mapped, or 0 on failure.
+  size_t MapNewMemory(stream_executor::gpu::GpuDevicePtr va, size_t num_bytes);
 
   stream_executor::gpu::GpuContext& gpu_context_;
   PlatformDeviceId gpu_id_;
@@ -97,6 +117,9 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // Smallest allocation as determined by CUDA.
   const size_t granularity_;
 
+  // Whether each granularity_ sized page is mapped separately.
+  const bool map_in_pages_;
+
   struct Mapping {
     stream_executor::gpu::GpuDevicePtr va;
     stream_executor::gpu::GpuDriver::GenericMemoryHandle physical;
@@ -104,6 +127,10 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // List of mappings, sorted by va.
   std::vector<Mapping> mappings_;
 
+  // Unmaps and releases the mappings in [first, last) and forgets them.
+  void UnmapMappings(std::vector<Mapping>::iterator first,
+                     std::vector<Mapping>::iterator last);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuVirtualMemAllocator);
 };
 
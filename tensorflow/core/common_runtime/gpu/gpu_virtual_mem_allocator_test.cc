@@ -179,6 +179,38 @@ TEST(GpuVirtualMemAllocatorTest, FreeRange) {
   ASSERT_EQ(re_alloc, first_alloc);
 }
 
+TEST(GpuVirtualMemAllocatorTest, FreePartOfAllocationMappedInPages) {
+  PlatformDeviceId gpu_id(0);
+  auto executor =
+      DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(), gpu_id)
+          .ValueOrDie();
+  GpuContext* gpu_context = reinterpret_cast<GpuContext*>(
+      executor->implementation()->GpuContextHack());
+  auto allocator = GpuVirtualMemAllocator::Create(
+                       {}, {}, *gpu_context, gpu_id,
+                       /*virtual_address_space_size=*/4 * k2MiB, {},
+                       /*map_in_pages=*/true)
+                       .ValueOrDie();
+  EXPECT_EQ(allocator->PartialFreeGranularity(), k2MiB);
+  size_t bytes_received;  // Ignored in this test.
+  void* first_alloc = allocator->Alloc(/*alignment=*/0, /*num_bytes=*/3 * k2MiB,
+                                       &bytes_received);
+  ASSERT_NE(first_alloc, nullptr);
+
+  // Free the middle page only.
+  allocator->Free(reinterpret_cast<char*>(first_alloc) + k2MiB, k2MiB);
+
+  // The hole is not reused.
+  void* second_alloc =
+      allocator->Alloc(/*alignment=*/0, /*num_bytes=*/k2MiB, &bytes_received);
+  ASSERT_NE(second_alloc, nullptr);
+  ASSERT_EQ(second_alloc,
+            reinterpret_cast<const char*>(first_alloc) + 3 * k2MiB);
+
+  // Freeing the whole first allocation skips over the hole.
+  allocator->Free(first_alloc, 3 * k2MiB);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
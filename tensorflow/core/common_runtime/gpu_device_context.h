@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <utility>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -26,6 +28,8 @@ class Stream;
 
 namespace tensorflow {
 
+class GpuHostStagingPool;
+
 class GPUDeviceContext : public DeviceContext {
  public:
   // Does not take ownership of streams.
@@ -46,7 +50,7 @@ class GPUDeviceContext : public DeviceContext {
         device_to_device_stream_(device_to_device_stream) {
   }
 
-  ~GPUDeviceContext() override {}
+  ~GPUDeviceContext() override;
 
   se::Stream* stream() const override { return stream_; }
 #if TENSORFLOW_USE_ROCM
@@ -59,6 +63,22 @@ class GPUDeviceContext : public DeviceContext {
   }
   int stream_id() const { return stream_id_; }
 
+  // Compute streams whose queued work must finish before kernels launched
+  // with this context may start: the streams of the producers of a node's
+  // inputs, when those were assigned a different stream than stream().
+  const gtl::InlinedVector<se::Stream*, 2>& wait_streams() const {
+    return wait_streams_;
+  }
+  void set_wait_streams(gtl::InlinedVector<se::Stream*, 2> wait_streams) {
+    wait_streams_ = std::move(wait_streams);
+  }
+
+  // Pinned host buffers that CPU->GPU copies of large pageable tensors are
+  // staged through, or nullptr if staging is disabled.
+  GpuHostStagingPool* host_staging_pool() const { return host_staging_pool_; }
+  // Takes a reference on `pool`.
+  void set_host_staging_pool(GpuHostStagingPool* pool);
+
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor, StatusCallback done,
                              bool sync_dst_compute) const override;
@@ -92,6 +112,9 @@ class GPUDeviceContext : public DeviceContext {
   se::Stream* device_to_host_stream_;
   // Streams to use for copying data between GPUs.
   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream_;
+  // Compute streams to wait for before launching kernels on stream_.
+  gtl::InlinedVector<se::Stream*, 2> wait_streams_;
+  GpuHostStagingPool* host_staging_pool_ = nullptr;
 };
 
 }  // namespace tensorflow
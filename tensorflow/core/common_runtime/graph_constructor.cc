@@ -354,10 +354,12 @@ class GraphConstructor {
   // Used in the conversion from node_defs_ to g_ to represent the ith input
   // of a node.
   struct InputInfo {
-    explicit InputInfo(const string& node_name, Node* n, int i)
+    explicit InputInfo(StringPiece node_name, Node* n, int i)
         : name(node_name), node(n), index(i) {}
-    // Use string instead of StringPiece so we don't have to manage lifetime
-    string name;
+    // Points to a key of `gdef_nodes_` or `existing_nodes_`, neither of which
+    // is resized while nodes are converted, so this avoids copying the name of
+    // every input.
+    StringPiece name;
     Node* node;
     int index;
 
@@ -375,7 +377,7 @@ class GraphConstructor {
   // Used in the conversion from node_defs_ to g_ to represent an edge from
   // the node named 'name' to node 'n'.
   struct EdgeInfo {
-    explicit EdgeInfo(const string& name, int i1, Node* n, int i2)
+    explicit EdgeInfo(StringPiece name, int i1, Node* n, int i2)
         : src_name(name), src_index(i1), dst_node(n), dst_index(i2) {}
     // Use string instead of StringPiece so we don't have to manage lifetime
     string src_name;
@@ -639,6 +641,7 @@ Status GraphConstructor::ValidateInputMapAndControlDependencies() {
 
 Status GraphConstructor::BuildNodeIndex() {
   // Validate the node names and add them to gdef_nodes_ and gdef_prefixes_.
+  gdef_nodes_.reserve(node_def_count());
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
     if (!IsValidNodeName(node_def.name(), opts_.allow_internal_ops)) {
@@ -685,7 +688,8 @@ Status GraphConstructor::InitFromEdges() {
   const int num_nodes = node_def_count();
   pending_count_.reserve(num_nodes);
   outputs_.resize(num_nodes);
-  gtl::FlatSet<string> next_iteration_nodes;
+  // Names point into the NodeDefs, which are not consumed until Convert().
+  absl::flat_hash_set<StringPiece> next_iteration_nodes;
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
     if (IsNextIteration(node_def)) {
@@ -710,8 +714,7 @@ Status GraphConstructor::InitFromEdges() {
           num_control_edges++;
         } else {
           TensorId id(ParseTensorName(input_name));
-          if (next_iteration_nodes.find(string(id.first)) !=
-              next_iteration_nodes.end()) {
+          if (next_iteration_nodes.contains(id.first)) {
             has_loop_back_edge = true;
           }
         }
@@ -1133,7 +1136,8 @@ Status GraphConstructor::Convert() {
     input_already_exists.clear();
     input_already_exists.resize(node_def.input_size(), false);
 
-    std::string node_name = node_def.name();
+    // Look up the entry for this node before its name is rewritten below.
+    NodeInfo& node_info = gdef_nodes_.find(node_def.name())->second;
 
     if (opts_.importing) {
       if (opts_.skip_mapped_nodes) {
@@ -1173,12 +1177,14 @@ Status GraphConstructor::Convert() {
         src_node = iter->second.node;
         src_index = tensor_id.index();
         if (src_node == nullptr) has_data_back_edge = true;
+        inputs.emplace_back(iter->first, src_node, src_index);
       } else {
         // Input refers to preexistng node in graph
         auto iter = existing_nodes_.find(tensor_id.node());
         DCHECK(iter != existing_nodes_.end()) << tensor_id.node();
         src_node = iter->second;
         src_index = tensor_id.index();
+        inputs.emplace_back(iter->first, src_node, src_index);
       }
 
       if (src_node != nullptr && src_index >= src_node->num_outputs()) {
@@ -1196,8 +1202,6 @@ Status GraphConstructor::Convert() {
         }
         return errors::InvalidArgument(out.str());
       }
-
-      inputs.emplace_back(string(tensor_id.node()), src_node, src_index);
     }
 
     if (has_data_back_edge && !IsMerge(node_def)) {
@@ -1234,7 +1238,7 @@ Status GraphConstructor::Convert() {
 
     TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
 
-    gdef_nodes_[node_name].node = node;
+    node_info.node = node;
 
     // Remove duplicate control inputs before adding edges to the graph. It
     // will allow us to skip expensive duplicates check in 'AddControlEdge'.
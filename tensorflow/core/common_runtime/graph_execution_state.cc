@@ -22,6 +22,8 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_join.h"
@@ -49,7 +51,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
@@ -64,12 +68,115 @@ limitations under the License.
 namespace tensorflow {
 
 namespace {
+// The number of optimized graphs cached per session if
+// `ConfigProto.Experimental.cache_optimized_graphs` is set.
+constexpr int64 kOptimizedGraphCacheCapacity = 16;
+
 bool IsCollectiveV2(const string& op) {
   return op == "CollectiveReduceV2" || op == "CollectiveGatherV2" ||
          op == "CollectiveBcastRecvV2" || op == "CollectiveBcastSendV2";
 }
+
+#ifndef IS_MOBILE_PLATFORM
+// Returns the nodes of `graph` in the transitive fanin (including control
+// inputs) of the feeds and fetches of `item`, sorted by name.
+std::vector<const Node*> FeedFetchClosure(const Graph& graph,
+                                          const grappler::GrapplerItem& item) {
+  absl::flat_hash_set<string> roots;
+  for (const auto& feed : item.feed) {
+    roots.insert(string(ParseTensorName(feed.first).node()));
+  }
+  for (const string& fetch : item.fetch) {
+    roots.insert(string(ParseTensorName(fetch).node()));
+  }
+  std::vector<const Node*> closure;
+  absl::flat_hash_set<const Node*> visited;
+  for (const Node* node : graph.op_nodes()) {
+    if (roots.contains(node->name()) && visited.insert(node).second) {
+      closure.push_back(node);
+    }
+  }
+  for (size_t i = 0; i < closure.size(); ++i) {
+    for (const Edge* edge : closure[i]->in_edges()) {
+      const Node* src = edge->src();
+      if (src->IsOp() && visited.insert(src).second) {
+        closure.push_back(src);
+      }
+    }
+  }
+  absl::c_sort(closure, [](const Node* a, const Node* b) {
+    return a->name() < b->name();
+  });
+  return closure;
+}
+
+// Returns a fingerprint of the inputs of the optimization of `item`, when its
+// graph consists of the nodes in `closure`.
+uint64 OptimizationFingerprint(
+    const grappler::GrapplerItem& item,
+    const absl::flat_hash_map<string, TensorShape>& specialized_feed_shapes,
+    const std::vector<const Node*>& closure, const Graph& graph,
+    const FunctionLibraryDefinition* flib_def) {
+  uint64 fingerprint = DeterministicProtoHash64(graph.versions());
+  for (const auto& feed : item.feed) {
+    auto specialized_shape = specialized_feed_shapes.find(feed.first);
+    fingerprint = FingerprintCat64(
+        fingerprint,
+        Fingerprint64(strings::StrCat(
+            feed.first, ":", DataTypeString(feed.second.dtype()),
+            feed.second.shape().DebugString(),
+            specialized_shape == specialized_feed_shapes.end()
+                ? ""
+                : specialized_shape->second.DebugString())));
+  }
+  for (const string& fetch : item.fetch) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(fetch));
+  }
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  absl::c_sort(devices);
+  for (const string& device : devices) {
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(device));
+  }
+  for (const Node* node : closure) {
+    fingerprint = DeterministicProtoHash64(node->def(), fingerprint);
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(node->assigned_device_name()));
+  }
+  if (flib_def) {
+    fingerprint = DeterministicProtoHash64(flib_def->ToProto(), fingerprint);
+  }
+  return fingerprint;
+}
+#endif  // IS_MOBILE_PLATFORM
 }  // namespace
 
+std::shared_ptr<const GraphDef> OptimizedGraphCache::Lookup(uint64 key) {
+  mutex_lock l(mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void OptimizedGraphCache::Insert(uint64 key,
+                                 std::shared_ptr<const GraphDef> graph) {
+  mutex_lock l(mu_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->second = std::move(graph);
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  entries_.emplace_front(key, std::move(graph));
+  index_[key] = entries_.begin();
+  while (static_cast<int64>(entries_.size()) > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
 GraphExecutionState::GraphExecutionState(
     std::unique_ptr<GraphDef>&& graph_def,
     std::unique_ptr<FunctionLibraryDefinition>&& flib_def,
@@ -80,7 +187,14 @@ GraphExecutionState::GraphExecutionState(
       session_options_(options.session_options),
       session_handle_(options.session_handle),
       flib_def_(std::move(flib_def)),
-      graph_(nullptr) {}
+      graph_(nullptr),
+      optimized_graph_cache_(options.optimized_graph_cache) {
+  if (!optimized_graph_cache_ &&
+      session_options_->config.experimental().cache_optimized_graphs()) {
+    optimized_graph_cache_ =
+        std::make_shared<OptimizedGraphCache>(kOptimizedGraphCacheCapacity);
+  }
+}
 
 GraphExecutionState::~GraphExecutionState() {
   node_name_to_cost_id_map_.clear();
@@ -262,6 +376,7 @@ Status GraphExecutionState::Extend(
   combined_options.session_options = session_options_;
   combined_options.session_handle = session_handle_;
   combined_options.stateful_placements = stateful_placements_;
+  combined_options.optimized_graph_cache = optimized_graph_cache_;
 
   TF_RETURN_IF_ERROR(AddDefaultAttrsToGraphDef(&gdef, *flib_def_, 0));
   auto flib_def = absl::make_unique<FunctionLibraryDefinition>(
@@ -498,6 +613,24 @@ Status GetFeedShapeAndTypeFromAttribute(const NodeDef& node,
   return Status::OK();
 }
 
+// Sets the `shape` attribute of the fed placeholders in `graph` to their
+// concrete shapes in `feed_shapes`, so that the optimizers see fully defined
+// shapes.
+void SpecializeFeedShapes(
+    const absl::flat_hash_map<string, TensorShape>& feed_shapes,
+    GraphDef* graph) {
+  for (NodeDef& node : *graph->mutable_node()) {
+    auto it = feed_shapes.find(node.name());
+    if (it == feed_shapes.end() ||
+        (node.op() != "Placeholder" && node.op() != "PlaceholderV2" &&
+         node.op() != "PlaceholderWithDefault")) {
+      continue;
+    }
+    VLOG(3) << "Specialize feed " << node.name() << " to shape " << it->second;
+    it->second.AsProto((*node.mutable_attr())["shape"].mutable_shape());
+  }
+}
+
 }  // namespace
 
 Status GraphExecutionState::PruneGraph(
@@ -683,6 +816,7 @@ Status GraphExecutionState::OptimizeGraph(
 
     // Add feeds to the GrapplerItem if we know them.
     absl::flat_hash_set<absl::string_view> node_names;
+    absl::flat_hash_map<string, TensorShape> specialized_feed_shapes;
     if (!(options.callable_options.feed().empty() &&
           options.callable_options.tensor_connection().empty())) {
       std::vector<SafeTensorId> feeds;
@@ -714,6 +848,17 @@ Status GraphExecutionState::OptimizeGraph(
         }
       }
 
+      // Concrete shapes of the feeds with tensor index 0, if the graph is
+      // specialized. Shapes that are incompatible with the shape of the fed
+      // node are dropped below.
+      for (const auto& feed_shape : options.feed_shapes) {
+        const TensorId feed = ParseTensorName(feed_shape.first);
+        if (feed.index() == 0) {
+          specialized_feed_shapes.emplace(string(feed.node()),
+                                          feed_shape.second);
+        }
+      }
+
       // For feeds with tensor index == 0 we try to infer data type and tensor
       // shape from the graph, by looking at the fed node attributes.
       node_names.reserve(graph.num_nodes());
@@ -740,8 +885,17 @@ Status GraphExecutionState::OptimizeGraph(
         // to set unknown dimensions of its shape to any value we desire. We
         // choose 0 to minimize the memory impact. Note that this only matters
         // if an optimizer chooses to run the graph.
+        // A specialized feed has a fully defined shape instead.
+        auto specialized_shape = specialized_feed_shapes.find(node->name());
+        if (specialized_shape != specialized_feed_shapes.end() &&
+            !partial_shape.IsCompatibleWith(specialized_shape->second)) {
+          specialized_feed_shapes.erase(specialized_shape);
+          specialized_shape = specialized_feed_shapes.end();
+        }
         TensorShape shape;
-        if (partial_shape.unknown_rank()) {
+        if (specialized_shape != specialized_feed_shapes.end()) {
+          shape = specialized_shape->second;
+        } else if (partial_shape.unknown_rank()) {
           shape = TensorShape({0});
         } else {
           for (int i = 0; i < partial_shape.dims(); ++i) {
@@ -786,30 +940,77 @@ Status GraphExecutionState::OptimizeGraph(
       }
     }
 
-    // Convert Graph to GraphDef and add it to the GrapplerItem.
-    graph.ToGraphDef(&item.graph);
-    // TODO(b/114748242): Add a unit test to test this bug fix.
-    if (flib_def) {
-      *item.graph.mutable_library() = flib_def->ToProto();
-    }
-
-    // Construct a virtual cluster and find the cpu_device, which the
-    // ConstantFolding optimizer will use for partial evaluation of the graph.
-    grappler::VirtualCluster cluster(device_set_);
-    Device* cpu_device = nullptr;
-    for (const auto& device : device_set_->devices()) {
-      if (device->parsed_name().id == 0 &&
-          StringPiece(device->parsed_name().type) == "CPU" &&
-          device->GetAllocator(AllocatorAttributes()) != nullptr) {
-        cpu_device = device;
+    // When optimized graphs are cached, only the feeds, fetches and their
+    // fanin are optimized, so that the result can be reused for any graph
+    // (e.g. an extension of this one) that has the same fanin.
+    uint64 cache_key = 0;
+    std::shared_ptr<const GraphDef> cached_graph;
+    absl::flat_hash_set<string> closure_names;
+    if (optimized_graph_cache_) {
+      std::vector<const Node*> closure = FeedFetchClosure(graph, item);
+      cache_key = OptimizationFingerprint(item, specialized_feed_shapes,
+                                          closure, graph, flib_def);
+      cached_graph = optimized_graph_cache_->Lookup(cache_key);
+      if (!cached_graph) {
+        for (const Node* node : closure) {
+          closure_names.insert(node->name());
+        }
       }
     }
 
-    // Now we can run the MetaOptimizer on the constructed GrapplerItem.
+    // The optimized graph is either owned by `new_graph` or, when graphs are
+    // cached, shared with the cache through `cached_graph`. In the latter case
+    // it is imported directly from the cache entry instead of being copied.
     GraphDef new_graph;
-    TF_RETURN_IF_ERROR(
-        grappler::RunMetaOptimizer(std::move(item), session_options_->config,
-                                   cpu_device, &cluster, &new_graph));
+    if (cached_graph) {
+      VLOG(1) << "Reusing the cached optimized graph with fingerprint "
+              << cache_key;
+    } else {
+      // Convert Graph to GraphDef and add it to the GrapplerItem. The graph's
+      // own function library is skipped when it is replaced below.
+      graph.ToGraphDef(&item.graph, /*include_flib_def=*/flib_def == nullptr);
+      if (!specialized_feed_shapes.empty()) {
+        SpecializeFeedShapes(specialized_feed_shapes, &item.graph);
+      }
+      // TODO(b/114748242): Add a unit test to test this bug fix.
+      if (flib_def) {
+        *item.graph.mutable_library() = flib_def->ToProto();
+      }
+      if (optimized_graph_cache_) {
+        auto* nodes = item.graph.mutable_node();
+        int num_kept = 0;
+        for (int i = 0; i < nodes->size(); ++i) {
+          if (closure_names.contains(nodes->Get(i).name())) {
+            nodes->SwapElements(i, num_kept++);
+          }
+        }
+        nodes->DeleteSubrange(num_kept, nodes->size() - num_kept);
+      }
+
+      // Construct a virtual cluster and find the cpu_device, which the
+      // ConstantFolding optimizer will use for partial evaluation of the
+      // graph.
+      grappler::VirtualCluster cluster(device_set_);
+      Device* cpu_device = nullptr;
+      for (const auto& device : device_set_->devices()) {
+        if (device->parsed_name().id == 0 &&
+            StringPiece(device->parsed_name().type) == "CPU" &&
+            device->GetAllocator(AllocatorAttributes()) != nullptr) {
+          cpu_device = device;
+        }
+      }
+
+      // Now we can run the MetaOptimizer on the constructed GrapplerItem.
+      TF_RETURN_IF_ERROR(
+          grappler::RunMetaOptimizer(std::move(item), session_options_->config,
+                                     cpu_device, &cluster, &new_graph));
+      if (optimized_graph_cache_) {
+        cached_graph = std::make_shared<const GraphDef>(std::move(new_graph));
+        optimized_graph_cache_->Insert(cache_key, cached_graph);
+      }
+    }
+    const GraphDef& optimized_graph_def =
+        cached_graph ? *cached_graph : new_graph;
 
     // Merge optimized graph function library with an original library.
     // Optimized graph might have new functions specialized for it's
@@ -817,7 +1018,7 @@ Status GraphExecutionState::OptimizeGraph(
     // function body for the existing functions.
     optimized_flib->reset(new FunctionLibraryDefinition(*flib_def));
 
-    for (const FunctionDef& fdef : new_graph.library().function()) {
+    for (const FunctionDef& fdef : optimized_graph_def.library().function()) {
       const string& func_name = fdef.signature().name();
 
       if ((*optimized_flib)->Contains(func_name)) {
@@ -833,8 +1034,13 @@ Status GraphExecutionState::OptimizeGraph(
     // Convert the optimized GraphDef back to a Graph.
     GraphConstructorOptions opts;
     opts.allow_internal_ops = true;
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, std::move(new_graph),
-                                              optimized_graph->get()));
+    if (cached_graph) {
+      TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, optimized_graph_def,
+                                                optimized_graph->get()));
+    } else {
+      TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, std::move(new_graph),
+                                                optimized_graph->get()));
+    }
     // The graph conversion sets the requested device names but not the
     // assigned device names. However, since at this point the graph is placed
     // TF expects an assigned device name for every node. Therefore we copy
@@ -17,10 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GRAPH_EXECUTION_STATE_H_
 
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+
 #include "tensorflow/core/common_runtime/build_graph_options.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_set.h"
@@ -30,6 +34,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -39,6 +45,34 @@ namespace subgraph {
 struct RewriteGraphMetadata;
 }
 
+// A least-recently-used cache of optimized graphs, shared by the execution
+// states of a session. Entries are keyed by a fingerprint of everything the
+// optimized graph depends on (see `GraphExecutionState::OptimizeGraph()`).
+//
+// OptimizedGraphCache is thread-safe.
+class OptimizedGraphCache {
+ public:
+  explicit OptimizedGraphCache(int64 capacity) : capacity_(capacity) {}
+
+  // Returns the graph cached under `key`, or nullptr if there is none.
+  std::shared_ptr<const GraphDef> Lookup(uint64 key) TF_LOCKS_EXCLUDED(mu_);
+
+  // Caches `graph` under `key`, evicting the least recently used graph if the
+  // cache is full.
+  void Insert(uint64 key, std::shared_ptr<const GraphDef> graph)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  using Entry = std::pair<uint64, std::shared_ptr<const GraphDef>>;
+
+  const int64 capacity_;
+  mutex mu_;
+  // Most recently used entries first.
+  std::list<Entry> entries_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<uint64, std::list<Entry>::iterator> index_
+      TF_GUARDED_BY(mu_);
+};
+
 struct GraphExecutionStateOptions {
   const DeviceSet* device_set = nullptr;
   const SessionOptions* session_options = nullptr;
@@ -47,6 +81,10 @@ struct GraphExecutionStateOptions {
   // A map from node name to device name, representing the unchangeable
   // placement of stateful nodes.
   std::unordered_map<string, string> stateful_placements;
+  // Cache of optimized graphs to share with other execution states. If null
+  // and `ConfigProto.Experimental.cache_optimized_graphs` is set, a new cache
+  // is created.
+  std::shared_ptr<OptimizedGraphCache> optimized_graph_cache;
 };
 
 // A ClientGraph is simply a sub-graph of the full graph as induced by
@@ -216,6 +254,10 @@ class GraphExecutionState {
   // The dataflow graph owned by this object.
   Graph* graph_;
 
+  // Shared with execution states created by `Extend()`. Null if optimized
+  // graphs are not cached.
+  std::shared_ptr<OptimizedGraphCache> optimized_graph_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GraphExecutionState);
 };
 
@@ -0,0 +1,362 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <utility>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Buffer keys of the transfers of the different phases.
+constexpr int kReduceScatterPhase = 0;
+constexpr int kGatherPhase = 1;
+constexpr int kLeaderReduceScatterPhase = 2;
+constexpr int kLeaderAllGatherPhase = 3;
+constexpr int kBroadcastPhase = 4;
+
+}  // namespace
+
+HierarchicalReducer::HierarchicalReducer()
+    : col_ctx_(nullptr), col_params_(nullptr) {}
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
+  CHECK_EQ(col_params->instance.impl_details.collective_name,
+           "HierarchicalReduce");
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::Unimplemented(
+        "HierarchicalReduce only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  // Devices of the same task must be adjacent in the group.
+  for (int di = 1; di < col_params->group.group_size; ++di) {
+    const string& task_name = col_params->group.task_names[di];
+    if (task_name != col_params->group.task_names[di - 1]) {
+      for (int dj = 0; dj < di - 1; ++dj) {
+        if (col_params->group.task_names[dj] == task_name) {
+          return errors::Internal("Devices of task ", task_name,
+                                  " are not adjacent in the group");
+        }
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  // Start by copying input to output if they're not already the same.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+  if (col_ctx_->output->NumElements() == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  // Find the devices of this task, and the leader of each task.
+  const std::vector<string>& task_names = col_params_->group.task_names;
+  const int rank = col_params_->default_rank;
+  std::vector<int> local_devs;
+  std::vector<int> leaders;
+  int task_idx = -1;
+  for (int di = 0; di < col_params_->group.group_size; ++di) {
+    if (di == 0 || task_names[di] != task_names[di - 1]) {
+      leaders.push_back(di);
+    }
+    if (task_names[di] == task_names[rank]) {
+      if (local_devs.empty()) task_idx = leaders.size() - 1;
+      local_devs.push_back(di);
+    }
+  }
+  const int local_rank = rank - local_devs[0];
+  VLOG(1) << "HierarchicalReducer::Run for device " << col_ctx_->device_name
+          << " rank " << rank << " task " << task_idx << " local rank "
+          << local_rank << " of " << local_devs.size() << " local devices and "
+          << leaders.size() << " tasks";
+
+  Status s = ReduceScatterAndGatherLocal(local_devs, local_rank);
+  if (s.ok() && local_rank == 0) {
+    s = AllReduceLeaders(leaders, task_idx);
+    if (s.ok() && col_params_->final_op) {
+      // Only the leaders apply the final op, before the broadcast.
+      std::unique_ptr<CollectiveAdapter> ca(MakeCollectiveAdapter(
+          col_ctx_->output, 1, col_ctx_->device->GetAllocator({})));
+      Tensor group_size = ca->Scalar(col_params_->group.group_size);
+      Tensor value = ca->ChunkAlias(0);
+      s = collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->final_op, &value, &group_size);
+      ca->ConsumeFinalValue(col_ctx_->output);
+    }
+  }
+  if (s.ok()) {
+    s = BroadcastLocal(local_devs, local_rank);
+  }
+  if (!s.ok()) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+  done(s);
+}
+
+Status HierarchicalReducer::ReduceScatterAndGatherLocal(
+    const std::vector<int>& local_devs, int local_rank) {
+  const int num_local = local_devs.size();
+  if (num_local == 1) return Status::OK();
+  std::unique_ptr<CollectiveAdapter> ca(
+      MakeCollectiveAdapter(col_ctx_->output, num_local,
+                            col_ctx_->device->GetAllocator(
+                                col_ctx_->op_ctx->output_alloc_attr(0))));
+  std::vector<Tensor> chunks;
+  for (int i = 0; i < num_local; ++i) {
+    chunks.push_back(ca->ChunkAlias(i));
+  }
+
+  // Reduce-scatter: every device sends chunk i to local device i, and reduces
+  // the chunk it owns.
+  Status s;
+  {
+    std::vector<Tensor> tmp_chunks(num_local);
+    std::vector<Transfer> transfers;
+    for (int i = 0; i < num_local; ++i) {
+      if (i == local_rank || ca->ChunkBytes(i) == 0) continue;
+      transfers.push_back(Send(local_devs[i], kReduceScatterPhase, i,
+                               local_rank, &chunks[i]));
+    }
+    if (ca->ChunkBytes(local_rank) > 0) {
+      for (int i = 0; i < num_local; ++i) {
+        if (i == local_rank) continue;
+        tmp_chunks[i] = ca->TempChunk(local_rank);
+        transfers.push_back(Recv(local_devs[i], kReduceScatterPhase,
+                                 local_rank, i, &tmp_chunks[i]));
+      }
+    }
+    s = RunTransfers(transfers);
+    for (int i = 0; s.ok() && i < num_local; ++i) {
+      if (tmp_chunks[i].IsInitialized()) {
+        s = Merge(&chunks[local_rank], &tmp_chunks[i]);
+      }
+    }
+  }
+
+  // Gather the reduced chunks on the leader.
+  if (s.ok()) {
+    std::vector<Transfer> transfers;
+    if (local_rank == 0) {
+      for (int i = 1; i < num_local; ++i) {
+        if (ca->ChunkBytes(i) == 0) continue;
+        transfers.push_back(
+            Recv(local_devs[i], kGatherPhase, i, 0, &chunks[i]));
+      }
+    } else if (ca->ChunkBytes(local_rank) > 0) {
+      transfers.push_back(Send(local_devs[0], kGatherPhase, local_rank, 0,
+                               &chunks[local_rank]));
+    }
+    s = RunTransfers(transfers);
+  }
+  chunks.clear();
+  ca->ConsumeFinalValue(col_ctx_->output);
+  return s;
+}
+
+Status HierarchicalReducer::AllReduceLeaders(const std::vector<int>& leaders,
+                                             int task_idx) {
+  const int num_tasks = leaders.size();
+  if (num_tasks == 1) return Status::OK();
+  std::unique_ptr<CollectiveAdapter> ca(
+      MakeCollectiveAdapter(col_ctx_->output, num_tasks,
+                            col_ctx_->device->GetAllocator(
+                                col_ctx_->op_ctx->output_alloc_attr(0))));
+  std::vector<Tensor> chunks;
+  for (int i = 0; i < num_tasks; ++i) {
+    chunks.push_back(ca->ChunkAlias(i));
+  }
+  const int next = leaders[(task_idx + 1) % num_tasks];
+  const int prev = leaders[(task_idx + num_tasks - 1) % num_tasks];
+
+  // Ring reduce-scatter: after step s, the leader of task t holds the sum
+  // over s + 2 tasks of chunk (t - s - 1).
+  Status s;
+  for (int step = 0; s.ok() && step < num_tasks - 1; ++step) {
+    const int send_chunk = (task_idx - step + num_tasks) % num_tasks;
+    const int recv_chunk = (task_idx - step - 1 + 2 * num_tasks) % num_tasks;
+    std::vector<Transfer> transfers;
+    if (ca->ChunkBytes(send_chunk) > 0) {
+      transfers.push_back(Send(next, kLeaderReduceScatterPhase, step,
+                               send_chunk, &chunks[send_chunk]));
+    }
+    Tensor tmp_chunk;
+    if (ca->ChunkBytes(recv_chunk) > 0) {
+      tmp_chunk = ca->TempChunk(recv_chunk);
+      transfers.push_back(Recv(prev, kLeaderReduceScatterPhase, step,
+                               recv_chunk, &tmp_chunk));
+    }
+    s = RunTransfers(transfers);
+    if (s.ok() && tmp_chunk.IsInitialized()) {
+      s = Merge(&chunks[recv_chunk], &tmp_chunk);
+    }
+  }
+
+  // Ring all-gather of the reduced chunks.
+  for (int step = 0; s.ok() && step < num_tasks - 1; ++step) {
+    const int send_chunk = (task_idx - step + 1 + num_tasks) % num_tasks;
+    const int recv_chunk = (task_idx - step + num_tasks) % num_tasks;
+    std::vector<Transfer> transfers;
+    if (ca->ChunkBytes(send_chunk) > 0) {
+      transfers.push_back(Send(next, kLeaderAllGatherPhase, step, send_chunk,
+                               &chunks[send_chunk]));
+    }
+    if (ca->ChunkBytes(recv_chunk) > 0) {
+      transfers.push_back(Recv(prev, kLeaderAllGatherPhase, step, recv_chunk,
+                               &chunks[recv_chunk]));
+    }
+    s = RunTransfers(transfers);
+  }
+  chunks.clear();
+  ca->ConsumeFinalValue(col_ctx_->output);
+  return s;
+}
+
+Status HierarchicalReducer::BroadcastLocal(const std::vector<int>& local_devs,
+                                           int local_rank) {
+  std::vector<Transfer> transfers;
+  if (local_rank == 0) {
+    for (int i = 1; i < static_cast<int>(local_devs.size()); ++i) {
+      transfers.push_back(
+          Send(local_devs[i], kBroadcastPhase, 0, i, col_ctx_->output));
+    }
+  } else {
+    transfers.push_back(Recv(local_devs[0], kBroadcastPhase, 0, local_rank,
+                             col_ctx_->output));
+  }
+  return RunTransfers(transfers);
+}
+
+Status HierarchicalReducer::RunTransfers(
+    const std::vector<Transfer>& transfers) {
+  if (transfers.empty()) return Status::OK();
+  BlockingCounter pending(transfers.size());
+  mutex mu;
+  Status status;
+  for (const Transfer& transfer : transfers) {
+    transfer([this, &pending, &mu, &status](const Status& s) {
+      if (!s.ok()) {
+        bool first_error;
+        {
+          mutex_lock l(mu);
+          first_error = status.ok();
+          status.Update(s);
+        }
+        // Abort the other pending transfers, of this device and of its
+        // peers, which may otherwise never complete.
+        if (first_error) col_ctx_->col_exec->StartAbort(s);
+      }
+      pending.DecrementCount();
+    });
+  }
+  pending.Wait();
+  return status;
+}
+
+HierarchicalReducer::Transfer HierarchicalReducer::Send(int dev_idx, int phase,
+                                                        int a, int b,
+                                                        const Tensor* tensor) {
+  return [this, dev_idx, phase, a, b, tensor](const StatusCallback& done) {
+    const string key = strings::StrCat(col_ctx_->exec_key, ":", phase, ":", a,
+                                       ":", b, ":", col_params_->default_rank);
+    col_ctx_->col_exec->remote_access()->PostToPeer(
+        col_params_->group.device_names[dev_idx],
+        col_params_->group.task_names[dev_idx], key, col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), tensor,
+        col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
+        done);
+  };
+}
+
+HierarchicalReducer::Transfer HierarchicalReducer::Recv(int dev_idx, int phase,
+                                                        int a, int b,
+                                                        Tensor* tensor) {
+  return [this, dev_idx, phase, a, b, tensor](const StatusCallback& done) {
+    const string key = strings::StrCat(col_ctx_->exec_key, ":", phase, ":", a,
+                                       ":", b, ":", dev_idx);
+    col_ctx_->col_exec->remote_access()->RecvFromPeer(
+        col_params_->group.device_names[dev_idx],
+        col_params_->group.task_names[dev_idx],
+        col_params_->task.is_local[dev_idx], key, col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), tensor,
+        col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/,
+        col_ctx_->op_ctx->cancellation_manager(), done);
+  };
+}
+
+Status HierarchicalReducer::Merge(Tensor* output, Tensor* input) {
+  return collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                       col_ctx_->device, col_params_->merge_op,
+                                       output, input);
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Two-level implementation of collective all-reduce, for groups that span
+// several tasks with several devices each.  Each task first reduce-scatters
+// its devices' values and gathers the per-task sum on a leader device, the
+// leaders of all tasks then run a ring all-reduce, and each leader finally
+// sends the result back to the other devices of its task.  Compared to a flat
+// ring over all devices, every byte crosses the network between tasks only
+// once in each direction per task.
+//
+// Only supports CPU devices.
+class HierarchicalReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalReducer();
+  ~HierarchicalReducer() override = default;
+
+  // Validates the group; the device order of the group is used as is.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // No-op for hierarchical reducer.
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Begins async execution of the hierarchical reduce algorithm.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  using Transfer = std::function<void(const StatusCallback&)>;
+
+  // Runs all "transfers" concurrently, and returns once all of them are done.
+  // Aborts the collective executor on the first error.
+  Status RunTransfers(const std::vector<Transfer>& transfers);
+
+  // Returns a transfer of "tensor" to, or from, the device at "dev_idx" in the
+  // group, under the buffer key made of "phase", "a" and "b".
+  Transfer Send(int dev_idx, int phase, int a, int b, const Tensor* tensor);
+  Transfer Recv(int dev_idx, int phase, int a, int b, Tensor* tensor);
+
+  // Reduces "input" into "output" with the merge op.
+  Status Merge(Tensor* output, Tensor* input);
+
+  // The phases of the algorithm.  "local_devs" are the group indices of the
+  // devices of this task, and "leaders" those of the first device of each
+  // task.
+  Status ReduceScatterAndGatherLocal(const std::vector<int>& local_devs,
+                                     int local_rank);
+  Status AllReduceLeaders(const std::vector<int>& leaders, int task_idx);
+  Status BroadcastLocal(const std::vector<int>& local_devs, int local_rank);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
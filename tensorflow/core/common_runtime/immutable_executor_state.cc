@@ -16,14 +16,19 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/core/framework/device.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -40,6 +45,9 @@ ImmutableExecutorState::~ImmutableExecutorState() {
       params_.delete_kernel(item->kernel);
     }
   }
+  for (DeviceContext* device_context : device_context_map_) {
+    if (device_context != nullptr) device_context->Unref();
+  }
 }
 
 namespace {
@@ -65,6 +73,66 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
   *max_pending = initial_count;
   *max_dead_count = num_in_edges;
 }
+
+// With the cache-aware layout, nodes with at least this many incoming edges
+// get their pending counts on a cache line of their own.
+constexpr size_t kMinFanInForPaddedPendingCounts = 8;
+
+// Returns true if pending counts should be laid out in topological order,
+// with the counts of high fan-in nodes padded to a full cache line, instead
+// of in node ID order.  This trades memory for less false sharing between
+// threads that concurrently activate neighboring nodes in large graphs.
+bool UseCacheAwarePendingCountsLayout() {
+  bool cache_aware = false;
+  Status status = ReadBoolFromEnvVar("TF_EXECUTOR_CACHE_AWARE_PENDING_COUNTS",
+                                     /*default_val=*/false, &cache_aware);
+  if (!status.ok()) {
+    LOG(ERROR) << "ImmutableExecutorState: " << status.error_message();
+  }
+  return cache_aware;
+}
+
+// Graphs with fewer nodes than this construct all kernels on the calling
+// thread.
+constexpr int kMinNodesForParallelKernelCreation = 256;
+
+// Returns the pool used to construct kernels in parallel, or nullptr if
+// kernels should be constructed on the calling thread.
+thread::ThreadPool* KernelCreationThreadPool() {
+  static const bool enabled = [] {
+    bool parallel = true;
+    Status status = ReadBoolFromEnvVar("TF_EXECUTOR_PARALLEL_KERNEL_CREATION",
+                                       /*default_val=*/true, &parallel);
+    if (!status.ok()) {
+      LOG(ERROR) << "ImmutableExecutorState: " << status.error_message();
+    }
+    return parallel;
+  }();
+  if (!enabled || port::MaxParallelism() <= 1) return nullptr;
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "tf_kernel_creation", port::MaxParallelism());
+  // Executors created while constructing a kernel (e.g. for a function call)
+  // must not block a pool thread on work queued behind it.
+  if (pool->CurrentThreadId() != -1) return nullptr;
+  return pool;
+}
+
+// Allocates a handle for the pending counts of `n` in `layout`.
+PendingCounts::Handle CreatePendingCountsHandle(const Node* n,
+                                                bool cache_aware,
+                                                PendingCounts::Layout* layout) {
+  // Compute the maximum values we'll store for this node in the
+  // pending counts data structure, and allocate a handle in
+  // that frame's pending counts data structure that has enough
+  // space to store these maximal count values.
+  size_t max_pending, max_dead;
+  GetMaxPendingCounts(n, &max_pending, &max_dead);
+  if (cache_aware &&
+      n->in_edges().size() >= kMinFanInForPaddedPendingCounts) {
+    return layout->CreatePaddedHandle(max_pending, max_dead);
+  }
+  return layout->CreateHandle(max_pending, max_dead);
+}
 }  // namespace
 
 ImmutableExecutorState::FrameInfo* ImmutableExecutorState::EnsureFrameInfo(
@@ -95,6 +163,34 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   root_frame_info_ = frame_info_[""].get();
 
   pending_ids_.resize(gview_.num_nodes());
+  const bool cache_aware_layout = UseCacheAwarePendingCountsLayout();
+
+  // Construct the kernels of stateless ops concurrently up front. Stateful
+  // kernels are constructed in the loop below, in node order, so that the
+  // state they create or look up does not depend on thread scheduling.
+  std::vector<Status> kernel_status;
+  thread::ThreadPool* pool = nullptr;
+  if (graph.num_nodes() >= kMinNodesForParallelKernelCreation) {
+    pool = KernelCreationThreadPool();
+  }
+  if (pool != nullptr) {
+    std::vector<const Node*> stateless_nodes;
+    for (const Node* n : graph.nodes()) {
+      if (!IsSink(n) && !n->op_def().is_stateful()) {
+        stateless_nodes.push_back(n);
+      }
+    }
+    kernel_status.resize(gview_.num_nodes());
+    pool->ParallelFor(
+        stateless_nodes.size(), /*cost_per_unit=*/100000,
+        [this, &stateless_nodes, &kernel_status](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            const Node* n = stateless_nodes[i];
+            kernel_status[n->id()] = params_.create_kernel(
+                n->properties(), &gview_.node(n->id())->kernel);
+          }
+        });
+  }
 
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node.
@@ -129,7 +225,10 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     item->input_start = frame_info->total_inputs;
     frame_info->total_inputs += n->num_inputs();
 
-    Status s = params_.create_kernel(n->properties(), &item->kernel);
+    Status s = kernel_status.empty() ? Status::OK() : kernel_status[id];
+    if (s.ok() && item->kernel == nullptr) {
+      s = params_.create_kernel(n->properties(), &item->kernel);
+    }
     if (!s.ok()) {
       item->kernel = nullptr;
       s = AttachDef(s, *n);
@@ -195,14 +294,19 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     item->is_recv_or_switch = IsRecv(n) || IsSwitch(n);
     item->is_next_iteration = IsNextIteration(n);
 
-    // Compute the maximum values we'll store for this node in the
-    // pending counts data structure, and allocate a handle in
-    // that frame's pending counts data structure that has enough
-    // space to store these maximal count values.
-    size_t max_pending, max_dead;
-    GetMaxPendingCounts(n, &max_pending, &max_dead);
-    pending_ids_[id] =
-        frame_info->pending_counts_layout.CreateHandle(max_pending, max_dead);
+    int64 cost_estimate_ns;
+    if (TryGetNodeAttr(n->attrs(), kExecutorCostEstimateNsAttr,
+                       &cost_estimate_ns)) {
+      if (cost_estimates_ns_.empty()) {
+        cost_estimates_ns_.resize(gview_.num_nodes(), -1);
+      }
+      cost_estimates_ns_[id] = cost_estimate_ns;
+    }
+
+    if (!cache_aware_layout) {
+      pending_ids_[id] = CreatePendingCountsHandle(
+          n, /*cache_aware=*/false, &frame_info->pending_counts_layout);
+    }
 
     // See if this node is a root node, and if so, add item to root_nodes_.
     if (n->in_edges().empty()) {
@@ -240,6 +344,26 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     }
   }
 
+  if (cache_aware_layout) {
+    // Allocate the pending counts in topological order, so that nodes which
+    // become ready one after another (and are often run by the same thread)
+    // have their counts next to each other.  Nodes that are not reachable
+    // from the source follow in ID order.
+    std::vector<Node*> order;
+    GetReversePostOrder(graph, &order);
+    std::vector<bool> has_handle(gview_.num_nodes(), false);
+    auto create_handle = [&](const Node* n) {
+      const int id = n->id();
+      if (IsSink(n) || has_handle[id]) return;
+      has_handle[id] = true;
+      FrameInfo* frame_info = EnsureFrameInfo(cf_info.frame_names[id]);
+      pending_ids_[id] = CreatePendingCountsHandle(
+          n, /*cache_aware=*/true, &frame_info->pending_counts_layout);
+    };
+    for (const Node* n : order) create_handle(n);
+    for (const Node* n : graph.nodes()) create_handle(n);
+  }
+
   // Rewrite each `EdgeInfo::input_slot` member to refer directly to the input
   // location.
   for (const Node* n : graph.nodes()) {
@@ -257,6 +381,17 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   // Initialize PendingCounts only after pending_ids_[node.id] is initialized
   // for all nodes.
   InitializePending(&graph, cf_info);
+
+  // Ask the device to fill in the device context map.
+  TF_RETURN_IF_ERROR(
+      params_.device->FillContextMap(&graph, &device_context_map_));
+  if (!device_context_map_.empty() &&
+      device_context_map_.size() != gview_.num_nodes()) {
+    return errors::Internal("Device ", params_.device->name(),
+                            " filled a context map of size ",
+                            device_context_map_.size(), " for ",
+                            gview_.num_nodes(), " nodes");
+  }
   return gview_.SetAllocAttrs(&graph, params_.device);
 }
 
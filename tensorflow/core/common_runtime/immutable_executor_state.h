@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_view.h"
 #include "tensorflow/core/common_runtime/local_executor_params.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
@@ -35,6 +36,12 @@ namespace tensorflow {
 
 class Graph;
 
+// The name of an optional `int` node attribute that holds a static estimate of
+// the node's execution time in nanoseconds. When present, the executor uses it
+// to classify the node as expensive or inexpensive before the kernel's
+// execution time has been measured.
+constexpr char kExecutorCostEstimateNsAttr[] = "_executor_cost_estimate_ns";
+
 // Represents the state of an executor (graph and control flow information)
 // that is immutable throughout execution.
 //
@@ -94,6 +101,23 @@ class ImmutableExecutorState {
 
   const FrameInfo& get_root_frame_info() const { return *root_frame_info_; }
 
+  // Returns the static execution time estimate of the given node, in
+  // nanoseconds, from its `kExecutorCostEstimateNsAttr` attribute, or -1 if the
+  // node does not have a cost estimate.
+  int64 cost_estimate_ns(int32 node_id) const {
+    return cost_estimates_ns_.empty() ? -1 : cost_estimates_ns_[node_id];
+  }
+
+  // Returns true if any node has a `kExecutorCostEstimateNsAttr` attribute.
+  bool has_cost_estimates() const { return !cost_estimates_ns_.empty(); }
+
+  // Returns the DeviceContext that the device assigned to the given node in
+  // `Device::FillContextMap()`, or nullptr if it did not assign one.
+  DeviceContext* device_context(int32 node_id) const {
+    return device_context_map_.empty() ? nullptr
+                                       : device_context_map_[node_id];
+  }
+
   const FrameInfo& get_enter_frame_info(const NodeItem& node_item) const {
     DCHECK(node_item.is_enter);
     return *enter_frame_info_[node_item.node_id];
@@ -155,6 +179,14 @@ class ImmutableExecutorState {
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
+  // If any node has a `kExecutorCostEstimateNsAttr` attribute, maps dense node
+  // IDs to the estimate (or -1 for nodes without an estimate). Empty otherwise.
+  std::vector<int64> cost_estimates_ns_;
+
+  // Per-node device contexts filled in by `Device::FillContextMap()`, indexed
+  // by dense node ID. Empty if the device uses a single context. Owned.
+  std::vector<DeviceContext*> device_context_map_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ImmutableExecutorState);
 };
 
@@ -0,0 +1,104 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_timeline_allocator.h"
+
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/env_time.h"
+
+namespace tensorflow {
+
+MemoryTimelineAllocator::MemoryTimelineAllocator(
+    Allocator* allocator, bool owns_allocator,
+    profiler::MemoryTimeline* timeline)
+    : allocator_(allocator),
+      owns_allocator_(owns_allocator),
+      timeline_(timeline),
+      allocator_id_(timeline->InternString(allocator->Name())) {}
+
+MemoryTimelineAllocator::~MemoryTimelineAllocator() {
+  if (owns_allocator_) delete allocator_;
+}
+
+void* MemoryTimelineAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  void* ptr = allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr == nullptr) return nullptr;
+
+  const MemoryDebugAnnotation& annotation =
+      ScopedMemoryDebugAnnotation::CurrentAnnotation();
+  Allocation allocation;
+  allocation.num_bytes = allocator_->TracksAllocationSizes()
+                             ? allocator_->AllocatedSize(ptr)
+                             : num_bytes;
+  allocation.step_id = annotation.pending_step_id;
+  allocation.op_name_id = annotation.pending_op_name
+                              ? timeline_->InternString(
+                                    annotation.pending_op_name)
+                              : 0;
+  allocation.shape_id =
+      annotation.pending_shape
+          ? timeline_->InternString(annotation.pending_shape->DebugString())
+          : 0;
+  allocation.data_type = annotation.pending_data_type;
+
+  profiler::MemoryTimelineRecord record;
+  record.address = reinterpret_cast<uint64>(ptr);
+  record.bytes = allocation.num_bytes;
+  record.step_id = allocation.step_id;
+  record.allocator_id = allocator_id_;
+  record.op_name_id = allocation.op_name_id;
+  record.shape_id = allocation.shape_id;
+  record.data_type = allocation.data_type;
+  {
+    mutex_lock l(mu_);
+    allocations_[ptr] = allocation;
+    bytes_in_use_ += allocation.num_bytes;
+    record.bytes_in_use = bytes_in_use_;
+    record.timestamp_ns = EnvTime::NowNanos();
+  }
+  timeline_->Record(record);
+  return ptr;
+}
+
+void MemoryTimelineAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  profiler::MemoryTimelineRecord record;
+  record.address = reinterpret_cast<uint64>(ptr);
+  record.allocator_id = allocator_id_;
+  bool found = false;
+  {
+    mutex_lock l(mu_);
+    auto it = allocations_.find(ptr);
+    if (it != allocations_.end()) {
+      const Allocation& allocation = it->second;
+      record.bytes = -allocation.num_bytes;
+      record.step_id = allocation.step_id;
+      record.op_name_id = allocation.op_name_id;
+      record.shape_id = allocation.shape_id;
+      record.data_type = allocation.data_type;
+      bytes_in_use_ -= allocation.num_bytes;
+      record.bytes_in_use = bytes_in_use_;
+      record.timestamp_ns = EnvTime::NowNanos();
+      allocations_.erase(it);
+      found = true;
+    }
+  }
+  allocator_->DeallocateRaw(ptr);
+  if (found) timeline_->Record(record);
+}
+
+}  // namespace tensorflow
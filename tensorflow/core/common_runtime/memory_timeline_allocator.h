@@ -0,0 +1,102 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_TIMELINE_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_TIMELINE_ALLOCATOR_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
+
+namespace tensorflow {
+
+// Wraps an allocator and records each of its allocations and deallocations in
+// a MemoryTimeline, attributed to the op, step and tensor shape of the current
+// ScopedMemoryDebugAnnotation. Deallocations are attributed to the op that
+// made the allocation.
+//
+// ProcessState and GPUProcessState wrap their allocators with this class when
+// profiler::MemoryTimeline::Get() is not null.
+class MemoryTimelineAllocator : public Allocator {
+ public:
+  // Takes ownership of `allocator` if `owns_allocator` is true.
+  MemoryTimelineAllocator(Allocator* allocator, bool owns_allocator,
+                          profiler::MemoryTimeline* timeline);
+  ~MemoryTimelineAllocator() override;
+
+  std::string Name() override { return allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override {
+    return allocator_->TracksAllocationSizes();
+  }
+  bool AllocatesOpaqueHandle() const override {
+    return allocator_->AllocatesOpaqueHandle();
+  }
+  size_t RequestedSize(const void* ptr) const override {
+    return allocator_->RequestedSize(ptr);
+  }
+  size_t AllocatedSize(const void* ptr) const override {
+    return allocator_->AllocatedSize(ptr);
+  }
+  int64 AllocationId(const void* ptr) const override {
+    return allocator_->AllocationId(ptr);
+  }
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+  void ClearStats() override { allocator_->ClearStats(); }
+  void SetSafeFrontier(uint64 count) override {
+    allocator_->SetSafeFrontier(count);
+  }
+  void SetStream(void* stream) override { allocator_->SetStream(stream); }
+
+  // Returns the wrapped allocator.
+  Allocator* wrapped() const { return allocator_; }
+
+ private:
+  // Attribution of a live allocation, reused for its deallocation record.
+  struct Allocation {
+    int64 num_bytes;
+    int64 step_id;
+    int32 op_name_id;
+    int32 shape_id;
+    int32 data_type;
+  };
+
+  Allocator* const allocator_;
+  const bool owns_allocator_;
+  profiler::MemoryTimeline* const timeline_;
+  const int32 allocator_id_;
+
+  mutex mu_;
+  absl::flat_hash_map<const void*, Allocation> allocations_ TF_GUARDED_BY(mu_);
+  int64 bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryTimelineAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_TIMELINE_ALLOCATOR_H_
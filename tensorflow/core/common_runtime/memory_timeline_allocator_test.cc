@@ -0,0 +1,69 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_timeline_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(MemoryTimelineAllocatorTest, RecordsAllocationsWithAnnotations) {
+  profiler::MemoryTimeline timeline(/*capacity=*/16);
+  MemoryTimelineAllocator allocator(cpu_allocator(), /*owns_allocator=*/false,
+                                    &timeline);
+  TensorShape shape({4, 8});
+  void* ptr;
+  {
+    ScopedMemoryDebugAnnotation annotation("my_op", /*step_id=*/7, "output",
+                                           DT_FLOAT, &shape);
+    ptr = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  }
+  const int64 size =
+      allocator.TracksAllocationSizes() ? allocator.AllocatedSize(ptr) : 128;
+  void* other = allocator.AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  allocator.DeallocateRaw(ptr);
+  allocator.DeallocateRaw(other);
+
+  std::vector<profiler::MemoryTimelineRecord> records = timeline.GetRecords();
+  ASSERT_EQ(records.size(), 4);
+  EXPECT_EQ(records[0].address, reinterpret_cast<uint64>(ptr));
+  EXPECT_EQ(records[0].bytes, size);
+  EXPECT_EQ(records[0].bytes_in_use, size);
+  EXPECT_EQ(records[0].step_id, 7);
+  EXPECT_EQ(timeline.GetString(records[0].op_name_id), "my_op");
+  EXPECT_EQ(timeline.GetString(records[0].shape_id), shape.DebugString());
+  EXPECT_EQ(records[0].data_type, DT_FLOAT);
+  EXPECT_EQ(timeline.GetString(records[0].allocator_id), allocator.Name());
+
+  EXPECT_EQ(records[1].op_name_id, 0);
+  EXPECT_GT(records[1].bytes_in_use, records[0].bytes_in_use);
+
+  // Deallocations are attributed to the allocating op.
+  EXPECT_EQ(records[2].address, reinterpret_cast<uint64>(ptr));
+  EXPECT_EQ(records[2].bytes, -size);
+  EXPECT_EQ(records[2].step_id, 7);
+  EXPECT_EQ(timeline.GetString(records[2].op_name_id), "my_op");
+  EXPECT_EQ(records[3].bytes_in_use, 0);
+  EXPECT_LE(records[0].timestamp_ns, records[3].timestamp_ns);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,12 +16,14 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <atomic>
 
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/util/port.h"
 
 namespace tensorflow {
@@ -73,15 +75,27 @@ class PendingCounts {
    public:
     Handle CreateHandle(size_t max_pending_count, size_t max_dead_count);
 
+    // Like CreateHandle(), but places the counts on a cache line of their
+    // own.  Intended for nodes with a high fan-in, whose counts are updated
+    // concurrently by many threads and would otherwise falsely share a
+    // cache line with the counts of their neighbors.
+    Handle CreatePaddedHandle(size_t max_pending_count, size_t max_dead_count);
+
    private:
     friend class PendingCounts;
     int next_offset_ = 0;  // Next byte offset to allocate
+    bool has_padded_handles_ = false;
   };
 
+  // The assumed size of a cache line, for CreatePaddedHandle().
+  static constexpr int kCacheLineSize = 64;
+
   // Create a new PendingCounts object that can hold the state of
   // all the Handles allocated from "final_allocator".
   explicit PendingCounts(Layout layout)
-      : num_bytes_(layout.next_offset_), bytes_(new char[num_bytes_]) {
+      : num_bytes_(layout.next_offset_),
+        cache_line_aligned_(layout.has_padded_handles_),
+        bytes_(AllocateBytes(num_bytes_, cache_line_aligned_)) {
     if (num_bytes_ >= sizeof(LargeCounts)) {
       CHECK_EQ(uintptr_t(bytes_) % alignof(LargeCounts), 0);
     }
@@ -90,14 +104,22 @@ class PendingCounts {
   // Create a new PendingCounts object with the same layout and counts
   // as "other".
   explicit PendingCounts(const PendingCounts& other)
-      : num_bytes_(other.num_bytes_), bytes_(new char[num_bytes_]) {
+      : num_bytes_(other.num_bytes_),
+        cache_line_aligned_(other.cache_line_aligned_),
+        bytes_(AllocateBytes(num_bytes_, cache_line_aligned_)) {
     if (num_bytes_ >= sizeof(LargeCounts)) {
       CHECK_EQ(uintptr_t(bytes_) % alignof(LargeCounts), 0);
     }
     memcpy(bytes_, other.bytes_, other.num_bytes_);
   }
 
-  ~PendingCounts() { delete[] bytes_; }
+  ~PendingCounts() {
+    if (cache_line_aligned_) {
+      port::AlignedFree(bytes_);
+    } else {
+      delete[] bytes_;
+    }
+  }
 
   void set_initial_count(Handle h, size_t pending_count) {
     if (h.is_large_) {
@@ -366,8 +388,19 @@ class PendingCounts {
                                                         h.byte_offset_);
   }
 
+  static char* AllocateBytes(int num_bytes, bool cache_line_aligned) {
+    if (cache_line_aligned) {
+      return static_cast<char*>(
+          port::AlignedMalloc(std::max(num_bytes, 1), kCacheLineSize));
+    }
+    return new char[num_bytes];
+  }
+
   const int num_bytes_;  // Just for bounds checking in debug mode
-  char* bytes_;          // Array of num_bytes_ bytes
+  // If true, `bytes_` starts on a cache line boundary, so that padded handles
+  // occupy whole cache lines.
+  const bool cache_line_aligned_;
+  char* bytes_;  // Array of num_bytes_ bytes
 
   void operator=(const PendingCounts&) = delete;
 };
@@ -396,6 +429,21 @@ inline PendingCounts::Handle PendingCounts::Layout::CreateHandle(
   return result;
 }
 
+inline PendingCounts::Handle PendingCounts::Layout::CreatePaddedHandle(
+    size_t max_pending_count, size_t max_dead_count) {
+  constexpr int B = kCacheLineSize;
+  static_assert(B % alignof(std::atomic<LargeCounts>) == 0,
+                "cache lines must be aligned for std::atomic<LargeCounts>");
+  Handle result;
+  int64 offset = ((static_cast<int64>(next_offset_) + B - 1) / B) * B;
+  result.byte_offset_ = offset;
+  result.is_large_ = true;
+  // Reserve the rest of the line, so that no other counts share it.
+  next_offset_ = result.byte_offset_ + B;
+  has_padded_handles_ = true;
+  return result;
+}
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_PENDING_COUNTS_H_
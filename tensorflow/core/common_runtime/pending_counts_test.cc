@@ -202,4 +202,63 @@ TEST(PendingCounts, AdjustForActivationAtomic) {
   EXPECT_EQ(c.pending(handles[1]), 0);
 }
 
+TEST(PendingCounts, PaddedHandles) {
+  const int C = 40;
+  PendingCounts::Layout layout;
+  std::vector<PendingCounts::Handle> h(C);
+  for (int id = 0; id < C; id++) {
+    h[id] = (id % 3 == 0) ? layout.CreatePaddedHandle(id, id)
+                          : layout.CreateHandle(id, id);
+  }
+
+  PendingCounts c(layout);
+  for (int id = 0; id < C; id++) {
+    c.set_initial_count(h[id], id);
+  }
+  for (int id = 1; id < C; id++) {
+    EXPECT_EQ(c.decrement_pending(h[id], 1), id - 1);
+    c.increment_dead_count(h[id]);
+  }
+
+  PendingCounts copy(c);
+  for (int id = 1; id < C; id++) {
+    EXPECT_EQ(copy.pending(h[id]), id - 1);
+    EXPECT_EQ(copy.dead_count(h[id]), (id == 1) ? 0 : 1);
+  }
+}
+
+TEST(PendingCounts, PaddedHandleAdjustForActivationAtomic) {
+  PendingCounts::Layout layout;
+  PendingCounts::Handle handles[3];
+  const int kInitialCounts[3] = {64, 4, 64};
+  handles[0] = layout.CreatePaddedHandle(kInitialCounts[0], 0);
+  handles[1] = layout.CreateHandle(kInitialCounts[1], 0);
+  handles[2] = layout.CreatePaddedHandle(kInitialCounts[2], 0);
+  PendingCounts c(layout);
+  for (int i = 0; i < 3; i++) {
+    c.set_initial_count(handles[i], kInitialCounts[i]);
+  }
+
+  Env* env = Env::Default();
+  std::atomic<bool> start{false};
+  std::vector<unique_ptr<Thread>> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back(env->StartThread({}, "tester", [&]() {
+      while (!start) {
+      }
+      for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < kInitialCounts[i] / 4; j++) {
+          c.adjust_for_activation_atomic(handles[i], false);
+        }
+      }
+    }));
+  }
+  start = true;
+  threads.clear();  // Joins the threads.
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(c.pending(handles[i]), 0);
+  }
+}
+
 }  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "absl/base/call_once.h"
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/common_runtime/memory_timeline_allocator.h"
 #include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
 #include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
@@ -71,73 +73,111 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
 
   mutex_lock lock(mu_);
   while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
-    // If visitors have been defined we need an Allocator built from
-    // a SubAllocator.  Prefer BFCAllocator, but fall back to PoolAllocator
-    // depending on env var setting.
-    const bool alloc_visitors_defined =
-        (!cpu_alloc_visitors_.empty() || !cpu_free_visitors_.empty());
-    bool use_bfc_allocator = false;
-    Status status = ReadBoolFromEnvVar(
-        "TF_CPU_ALLOCATOR_USE_BFC", alloc_visitors_defined, &use_bfc_allocator);
-    if (!status.ok()) {
-      LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
-    }
-    Allocator* allocator = nullptr;
-    SubAllocator* sub_allocator =
-        (numa_enabled_ || alloc_visitors_defined || use_bfc_allocator)
-            ? new BasicCPUAllocator(
-                  numa_enabled_ ? numa_node : port::kNUMANoAffinity,
-                  cpu_alloc_visitors_, cpu_free_visitors_)
-            : nullptr;
-    if (use_bfc_allocator) {
-      // TODO(reedwm): evaluate whether 64GB by default is the best choice.
-      int64 cpu_mem_limit_in_mb = -1;
-      Status status = ReadInt64FromEnvVar("TF_CPU_BFC_MEM_LIMIT_IN_MB",
-                                          1LL << 16 /*64GB max by default*/,
-                                          &cpu_mem_limit_in_mb);
-      if (!status.ok()) {
-        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
-      }
-      int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
-      DCHECK(sub_allocator);
-      allocator =
-          new BFCAllocator(sub_allocator, cpu_mem_limit, /*allow_growth=*/true,
-                           /*name=*/"bfc_cpu_allocator_for_gpu");
-      VLOG(2) << "Using BFCAllocator with memory limit of "
-              << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
-    } else if (sub_allocator) {
-      DCHECK(sub_allocator);
-      allocator =
-          new PoolAllocator(/*pool_size_limit=*/100, /*auto_resize=*/true,
-                            sub_allocator, new NoopRounder, "cpu_pool");
-      VLOG(2) << "Using PoolAllocator for ProcessState CPU allocator "
-              << "numa_enabled_=" << numa_enabled_
-              << " numa_node=" << numa_node;
-    } else {
-      DCHECK(!sub_allocator);
-      allocator = cpu_allocator_base();
-    }
-    if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
-      // Wrap the allocator to track allocation ids for better logging
-      // at the cost of performance.
-      allocator = new TrackingAllocator(allocator, true);
-    }
+    // The allocator created by this iteration serves this NUMA node.
+    const int allocator_node = static_cast<int>(cpu_allocators_.size());
+    Allocator* allocator = NewCPUAllocatorLocked(
+        numa_enabled_ ? allocator_node : port::kNUMANoAffinity);
     cpu_allocators_.push_back(allocator);
     if (cpu_allocators_.size() < cpu_allocators_cache_.max_size()) {
       cpu_allocators_cache_[cpu_allocators_.size() - 1] = allocator;
       cpu_allocators_cached_.fetch_add(1, std::memory_order_release);
     }
-    if (!sub_allocator) {
-      DCHECK(cpu_alloc_visitors_.empty() && cpu_free_visitors_.empty());
-    }
   }
   return cpu_allocators_[numa_node];
 }
 
+Allocator* ProcessState::GetNUMAAllocator(int numa_node) {
+  if (numa_enabled_ || numa_node == port::kNUMANoAffinity) {
+    return GetCPUAllocator(numa_node);
+  }
+  mutex_lock lock(mu_);
+  auto it = numa_allocators_.find(numa_node);
+  if (it == numa_allocators_.end()) {
+    it = numa_allocators_.emplace(numa_node, NewCPUAllocatorLocked(numa_node))
+             .first;
+  }
+  return it->second;
+}
+
+Allocator* ProcessState::NewCPUAllocatorLocked(int numa_node) {
+  const bool numa_local = numa_node != port::kNUMANoAffinity;
+  // If visitors have been defined we need an Allocator built from
+  // a SubAllocator.  Prefer BFCAllocator, but fall back to PoolAllocator
+  // depending on env var setting.  NUMA node-local allocators also default
+  // to BFCAllocator, so that each node gets its own coalescing heap.
+  const bool alloc_visitors_defined =
+      (!cpu_alloc_visitors_.empty() || !cpu_free_visitors_.empty());
+  bool use_bfc_allocator = false;
+  Status status = ReadBoolFromEnvVar("TF_CPU_ALLOCATOR_USE_BFC",
+                                     alloc_visitors_defined || numa_local,
+                                     &use_bfc_allocator);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+  }
+  Allocator* allocator = nullptr;
+  SubAllocator* sub_allocator =
+      (numa_local || alloc_visitors_defined || use_bfc_allocator)
+          ? new BasicCPUAllocator(numa_node, cpu_alloc_visitors_,
+                                  cpu_free_visitors_)
+          : nullptr;
+  if (use_bfc_allocator) {
+    // TODO(reedwm): evaluate whether 64GB by default is the best choice.
+    int64 cpu_mem_limit_in_mb = -1;
+    Status status = ReadInt64FromEnvVar("TF_CPU_BFC_MEM_LIMIT_IN_MB",
+                                        1LL << 16 /*64GB max by default*/,
+                                        &cpu_mem_limit_in_mb);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+    }
+    int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+    bool enable_chunk_cache = false;
+    status = ReadBoolFromEnvVar("TF_CPU_BFC_ENABLE_CHUNK_CACHE",
+                                /*default_val=*/false, &enable_chunk_cache);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+    }
+    DCHECK(sub_allocator);
+    const string name =
+        numa_local ? strings::StrCat("numa_", numa_node, "_bfc_cpu_allocator")
+                   : "bfc_cpu_allocator_for_gpu";
+    allocator = new BFCAllocator(sub_allocator, cpu_mem_limit,
+                                 /*allow_growth=*/true, name,
+                                 /*garbage_collection=*/false,
+                                 enable_chunk_cache);
+    VLOG(2) << "Using BFCAllocator with memory limit of "
+            << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
+  } else if (sub_allocator) {
+    DCHECK(sub_allocator);
+    allocator =
+        new PoolAllocator(/*pool_size_limit=*/100, /*auto_resize=*/true,
+                          sub_allocator, new NoopRounder, "cpu_pool");
+    VLOG(2) << "Using PoolAllocator for ProcessState CPU allocator "
+            << "numa_node=" << numa_node;
+  } else {
+    DCHECK(!sub_allocator);
+    allocator = cpu_allocator_base();
+  }
+  if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
+    // Wrap the allocator to track allocation ids for better logging
+    // at the cost of performance.
+    allocator = new TrackingAllocator(allocator, true);
+  }
+  if (profiler::MemoryTimeline* timeline = profiler::MemoryTimeline::Get()) {
+    // The default CPU allocator is static and must not be deleted.
+    allocator = new MemoryTimelineAllocator(
+        allocator, /*owns_allocator=*/allocator != cpu_allocator_base(),
+        timeline);
+  }
+  if (!sub_allocator) {
+    DCHECK(cpu_alloc_visitors_.empty() && cpu_free_visitors_.empty());
+  }
+  return allocator;
+}
+
 void ProcessState::AddCPUAllocVisitor(SubAllocator::Visitor visitor) {
   VLOG(1) << "AddCPUAllocVisitor";
   mutex_lock lock(mu_);
-  CHECK_EQ(0, cpu_allocators_.size())  // Crash OK
+  CHECK(cpu_allocators_.empty() && numa_allocators_.empty())  // Crash OK
       << "AddCPUAllocVisitor must be called prior to first call to "
          "ProcessState::GetCPUAllocator";
   cpu_alloc_visitors_.push_back(std::move(visitor));
@@ -145,7 +185,7 @@ void ProcessState::AddCPUAllocVisitor(SubAllocator::Visitor visitor) {
 
 void ProcessState::AddCPUFreeVisitor(SubAllocator::Visitor visitor) {
   mutex_lock lock(mu_);
-  CHECK_EQ(0, cpu_allocators_.size())  // Crash OK
+  CHECK(cpu_allocators_.empty() && numa_allocators_.empty())  // Crash OK
       << "AddCPUFreeVisitor must be called prior to first call to "
          "ProcessState::GetCPUAllocator";
   cpu_free_visitors_.push_back(std::move(visitor));
@@ -160,6 +200,10 @@ void ProcessState::TestOnlyReset() {
     if (a != default_cpu_allocator) delete a;
   }
   cpu_allocators_.clear();
+  for (const auto& entry : numa_allocators_) {
+    delete entry.second;
+  }
+  numa_allocators_.clear();
   for (Allocator* a : cpu_al_) {
     delete a;
   }
@@ -56,7 +56,8 @@ class ProcessState : public ProcessStateInterface {
   };
 
   // If NUMA Allocators are desired, call this before calling any
-  // Allocator accessor.
+  // Allocator accessor.  Allocators that were already created are kept and
+  // have no NUMA affinity.
   void EnableNUMA() { numa_enabled_ = true; }
 
   // Returns what we know about the memory at ptr.
@@ -67,6 +68,13 @@ class ProcessState : public ProcessStateInterface {
   // Treats numa_node == kNUMANoAffinity as numa_node == 0.
   Allocator* GetCPUAllocator(int numa_node) override;
 
+  // Returns a CPUAllocator whose memory is local to the given numa_node,
+  // whether or not EnableNUMA() was called.  This lets callers that want
+  // node-local memory (e.g. per-NUMA-node CPU devices) get it without
+  // changing the allocator that GetCPUAllocator() returns for everyone else.
+  // Treats numa_node == kNUMANoAffinity like GetCPUAllocator() does.
+  Allocator* GetNUMAAllocator(int numa_node);
+
   // Registers alloc visitor for the CPU allocator(s).
   // REQUIRES: must be called before GetCPUAllocator.
   void AddCPUAllocVisitor(SubAllocator::Visitor v);
@@ -92,6 +100,11 @@ class ProcessState : public ProcessStateInterface {
   // cleaning up everything. Never use in production.
   void TestOnlyReset();
 
+  // Creates a new CPU allocator for `numa_node`, or one without NUMA affinity
+  // if `numa_node` is kNUMANoAffinity.
+  Allocator* NewCPUAllocatorLocked(int numa_node)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   static ProcessState* instance_;
   bool numa_enabled_;
 
@@ -100,6 +113,9 @@ class ProcessState : public ProcessStateInterface {
   // Indexed by numa_node.  If we want numa-specific allocators AND a
   // non-specific allocator, maybe should index by numa_node+1.
   std::vector<Allocator*> cpu_allocators_ TF_GUARDED_BY(mu_);
+  // Node-local allocators created by GetNUMAAllocator() while NUMA is not
+  // enabled, indexed by numa_node.
+  std::map<int, Allocator*> numa_allocators_ TF_GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_alloc_visitors_ TF_GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_free_visitors_ TF_GUARDED_BY(mu_);
 
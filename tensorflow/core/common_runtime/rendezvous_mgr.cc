@@ -115,6 +115,35 @@ void SameWorkerRecvDone(const DeviceMgr* device_mgr,
       out, 0 /*dev_to_dev_stream_index*/, std::move(done), sync_dst_compute);
 }
 
+// Wraps `done` so that the received tensor is copied to the destination
+// device before it is handed to the caller.
+RendezvousInterface::DoneCallback WrapRecvDone(
+    const DeviceMgr* device_mgr, const RendezvousInterface::ParsedKey& parsed,
+    RendezvousInterface::DoneCallback done) {
+  return [device_mgr, parsed, done = std::move(done)](
+             const Status& status, const Rendezvous::Args& send_args,
+             const Rendezvous::Args& recv_args, const Tensor& in,
+             bool is_dead) mutable {
+    // If "in" is an uninitialized tensor, do copy-construction to
+    // preserve the uninitialized state, along with data type and shape
+    // info, which is useful for debugger purposes.
+    Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
+
+    auto final_callback = [send_args, recv_args, out, is_dead,
+                           done = std::move(done)](const Status& s) {
+      done(s, send_args, recv_args, *out, is_dead);
+      delete out;
+    };
+
+    if (status.ok() && in.IsInitialized()) {
+      SameWorkerRecvDone(device_mgr, parsed, send_args, recv_args, in, out,
+                         std::move(final_callback));
+    } else {
+      final_callback(status);
+    }
+  };
+}
+
 void IntraProcessRecvAsyncImpl(const DeviceMgr* device_mgr,
                                LocalRendezvous* local,
                                const RendezvousInterface::ParsedKey& parsed,
@@ -124,30 +153,21 @@ void IntraProcessRecvAsyncImpl(const DeviceMgr* device_mgr,
 
   ScopedMemoryDebugAnnotation op_annotation("RecvAsync");
   // Recv the tensor from local_.
-  local->RecvAsync(
-      parsed, recv_args,
-      [device_mgr, parsed, done = std::move(done)](
-          const Status& status, const Rendezvous::Args& send_args,
-          const Rendezvous::Args& recv_args, const Tensor& in,
-          bool is_dead) mutable {
-        // If "in" is an uninitialized tensor, do copy-construction to
-        // preserve the uninitialized state, along with data type and shape
-        // info, which is useful for debugger purposes.
-        Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
-
-        auto final_callback = [send_args, recv_args, out, is_dead,
-                               done = std::move(done)](const Status& s) {
-          done(s, send_args, recv_args, *out, is_dead);
-          delete out;
-        };
-
-        if (status.ok() && in.IsInitialized()) {
-          SameWorkerRecvDone(device_mgr, parsed, send_args, recv_args, in, out,
-                             std::move(final_callback));
-        } else {
-          final_callback(status);
-        }
-      });
+  local->RecvAsync(parsed, recv_args,
+                   WrapRecvDone(device_mgr, parsed, std::move(done)));
+}
+
+void IntraProcessRecvBatchAsyncImpl(
+    const DeviceMgr* device_mgr, LocalRendezvous* local,
+    gtl::MutableArraySlice<RendezvousInterface::RecvItem> items) {
+  VLOG(1) << "IntraProcessRendezvous RecvBatch " << local << " "
+          << items.size() << " keys";
+
+  ScopedMemoryDebugAnnotation op_annotation("RecvAsync");
+  for (RendezvousInterface::RecvItem& item : items) {
+    item.done = WrapRecvDone(device_mgr, item.key, std::move(item.done));
+  }
+  local->RecvBatchAsync(items);
 }
 
 }  // namespace
@@ -173,6 +193,16 @@ void RefCountedIntraProcessRendezvous::RecvAsync(const ParsedKey& key,
   IntraProcessRecvAsyncImpl(device_mgr_, &local_, key, args, std::move(done));
 }
 
+Status RefCountedIntraProcessRendezvous::SendBatch(
+    gtl::ArraySlice<SendItem> items) {
+  return local_.SendBatch(items);
+}
+
+void RefCountedIntraProcessRendezvous::RecvBatchAsync(
+    gtl::MutableArraySlice<RecvItem> items) {
+  IntraProcessRecvBatchAsyncImpl(device_mgr_, &local_, items);
+}
+
 void RefCountedIntraProcessRendezvous::StartAbort(const Status& s) {
   local_.StartAbort(s);
 }
@@ -199,6 +229,16 @@ void PrivateIntraProcessRendezvous::RecvAsync(const ParsedKey& key,
   IntraProcessRecvAsyncImpl(device_mgr_, &local_, key, args, std::move(done));
 }
 
+Status PrivateIntraProcessRendezvous::SendBatch(
+    gtl::ArraySlice<SendItem> items) {
+  return local_.SendBatch(items);
+}
+
+void PrivateIntraProcessRendezvous::RecvBatchAsync(
+    gtl::MutableArraySlice<RecvItem> items) {
+  IntraProcessRecvBatchAsyncImpl(device_mgr_, &local_, items);
+}
+
 void PrivateIntraProcessRendezvous::StartAbort(const Status& s) {
   local_.StartAbort(s);
 }
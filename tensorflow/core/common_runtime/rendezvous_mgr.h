@@ -49,6 +49,8 @@ class RefCountedIntraProcessRendezvous : public Rendezvous {
               const Tensor& val, const bool is_dead) override;
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
+  Status SendBatch(gtl::ArraySlice<SendItem> items) override;
+  void RecvBatchAsync(gtl::MutableArraySlice<RecvItem> items) override;
   void StartAbort(const Status& status) override;
 
  private:
@@ -78,6 +80,8 @@ class PrivateIntraProcessRendezvous : public RendezvousInterface {
               const Tensor& val, const bool is_dead) override;
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
+  Status SendBatch(gtl::ArraySlice<SendItem> items) override;
+  void RecvBatchAsync(gtl::MutableArraySlice<RecvItem> items) override;
   void StartAbort(const Status& status) override;
 
  private:
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/rendezvous_util.h"
+
+#include <vector>
+
 #include "tensorflow/core/platform/mutex.h"
 
 #include "tensorflow/core/util/reffed_status_callback.h"
@@ -39,18 +42,20 @@ Status SendTensorsToRendezvous(
     return errors::InvalidArgument("Rendezvous is null.");
   }
 
-  Rendezvous::ParsedKey parsed;
+  // Handing the rendezvous all tensors at once lets it take each of its
+  // locks once for the whole batch.
+  std::vector<Rendezvous::SendItem> items(keys.size());
   for (int i = 0; i < keys.size(); ++i) {
-    Rendezvous::Args rendez_args;
-    rendez_args.device_context = device_context;
+    Rendezvous::SendItem& item = items[i];
+    item.args.device_context = device_context;
     if (!alloc_attrs.empty()) {
-      rendez_args.alloc_attrs = alloc_attrs[i];
+      item.args.alloc_attrs = alloc_attrs[i];
     }
-    TF_RETURN_IF_ERROR(Rendezvous::ParseKey(keys[i], &parsed));
-    TF_RETURN_IF_ERROR(
-        rendezvous->Send(parsed, rendez_args, tensors_to_send[i], false));
+    TF_RETURN_IF_ERROR(Rendezvous::ParseKey(keys[i], &item.key));
+    item.val = tensors_to_send[i];
+    item.is_dead = false;
   }
-  return Status::OK();
+  return rendezvous->SendBatch(items);
 }
 
 void RecvOutputsFromRendezvousAsync(
@@ -69,52 +74,42 @@ void RecvOutputsFromRendezvousAsync(
   }
 
   received_tensors->reserve(keys.size());
-  std::vector<
-      std::tuple<string, Tensor*, Rendezvous::ParsedKey, AllocatorAttributes>>
-      arguments;
+  std::vector<Rendezvous::RecvItem> items(keys.size());
   for (int i = 0; i < keys.size(); ++i) {
-    Rendezvous::ParsedKey parsed;
-    Status s = Rendezvous::ParseKey(keys[i], &parsed);
+    Status s = Rendezvous::ParseKey(keys[i], &items[i].key);
     received_tensors->push_back(Tensor());
     if (!s.ok()) {
       done(s);
       return;
     }
-    AllocatorAttributes alloc_attr;
-    if (!alloc_attrs.empty()) {
-      alloc_attr = alloc_attrs[i];
-    }
-    arguments.emplace_back(keys[i], &((*received_tensors)[i]), parsed,
-                           alloc_attr);
   }
 
   auto status_cb = new ReffedStatusCallback(std::move(done));
-  for (auto& p : arguments) {
-    const string& key = std::get<0>(p);
-    Tensor* val = std::get<1>(p);
-    Rendezvous::ParsedKey parsed = std::get<2>(p);
-    Rendezvous::Args rendez_args;
-    rendez_args.device_context = device_context;
-    rendez_args.alloc_attrs = std::get<3>(p);
+  for (int i = 0; i < keys.size(); ++i) {
+    Rendezvous::RecvItem& item = items[i];
+    item.args.device_context = device_context;
+    if (!alloc_attrs.empty()) {
+      item.args.alloc_attrs = alloc_attrs[i];
+    }
+    Tensor* val = &((*received_tensors)[i]);
     status_cb->Ref();
-    rendezvous->RecvAsync(
-        parsed, rendez_args,
-        [val, key, status_cb](const Status& s,
-                              const Rendezvous::Args& send_args,
-                              const Rendezvous::Args& recv_args,
-                              const Tensor& v, const bool is_dead) {
-          Status status = s;
-          if (status.ok()) {
-            *val = v;
-            if (is_dead) {
-              status = errors::InvalidArgument("The tensor returned for ", key,
-                                               " was not valid.");
-            }
-          }
-          status_cb->UpdateStatus(status);
-          status_cb->Unref();
-        });
+    item.done = [val, key = keys[i], status_cb](
+                    const Status& s, const Rendezvous::Args& send_args,
+                    const Rendezvous::Args& recv_args, const Tensor& v,
+                    const bool is_dead) {
+      Status status = s;
+      if (status.ok()) {
+        *val = v;
+        if (is_dead) {
+          status = errors::InvalidArgument("The tensor returned for ", key,
+                                           " was not valid.");
+        }
+      }
+      status_cb->UpdateStatus(status);
+      status_cb->Unref();
+    };
   }
+  rendezvous->RecvBatchAsync(absl::MakeSpan(items));
   status_cb->Unref();
 }
 
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
@@ -728,6 +729,43 @@ TEST_F(RingReducerTest, AutomaticSubdivDisabled) {
   RunSubdivPermsTest(cp, {{0, 1, 2, 3}}, {0});
 }
 
+// Benchmarks the CPU all-reduce of a DT_FLOAT tensor with "tensor_len"
+// elements over "num_workers" x "num_devices" devices.
+class RingReducerBenchmark : public RingReducerTest {
+ public:
+  void TestBody() override {}
+
+  void Run(::testing::benchmark::State& state, int num_workers,
+           int num_devices, int num_subdivs, int tensor_len) {
+    Init(num_workers, num_devices, DT_FLOAT, DEVICE_CPU, num_subdivs,
+         0 /*fail_after*/);
+    for (auto s : state) {
+      state.PauseTiming();
+      for (DeviceInstance* instance : instances_) {
+        instance->InitTensor(DT_FLOAT, TensorShape({tensor_len}),
+                             [](Tensor* t) { t->flat<float>().setConstant(1); });
+      }
+      state.ResumeTiming();
+      Reduce(0 /*fail_after*/);
+    }
+    state.SetBytesProcessed(static_cast<int64>(state.iterations()) *
+                            tensor_len * sizeof(float));
+  }
+};
+
+static void BM_RingReduceCPU(::testing::benchmark::State& state) {
+  const int num_workers = state.range(0);
+  const int tensor_len = state.range(1);
+  RingReducerBenchmark benchmark;
+  benchmark.Run(state, num_workers, 1 /*num_devices*/, 2 /*num_subdivs*/,
+                tensor_len);
+}
+BENCHMARK(BM_RingReduceCPU)
+    ->ArgPair(2, 1 << 18)
+    ->ArgPair(4, 1 << 18)
+    ->ArgPair(4, 1 << 22)
+    ->ArgPair(8, 1 << 22);
+
 // TODO(b/113171733): change to use TEST_P.
 #define DEF_TEST(B, T, W, D, S, L, A)                                         \
   TEST_F(RingReducerTest,                                                     \
@@ -0,0 +1,362 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t n, size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+constexpr int64 StaticPlanAllocator::kNotFreed;
+
+StaticPlanAllocator::StaticPlanAllocator(Allocator* base, int warmup_steps)
+    : base_(base), warmup_steps_(std::max(warmup_steps, 1)) {}
+
+StaticPlanAllocator::~StaticPlanAllocator() {
+  if (arena_ != nullptr) {
+    if (!live_arena_.empty()) {
+      LOG(ERROR) << "StaticPlanAllocator destroyed with " << live_arena_.size()
+                 << " buffers still live in its arena.";
+    }
+    base_->DeallocateRaw(arena_);
+  }
+}
+
+string StaticPlanAllocator::Name() { return base_->Name(); }
+
+void* StaticPlanAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const MemoryDebugAnnotation& annotation =
+      ScopedMemoryDebugAnnotation::CurrentAnnotation();
+  if (annotation.pending_op_name == nullptr) {
+    return base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+  const int64 step_id = annotation.pending_step_id;
+  BufferKey key;
+  int64 alloc_time = 0;
+  bool traced = false;
+  {
+    mutex_lock l(mu_);
+    if (has_active_step_ && step_id == active_step_id_) {
+      key = {annotation.pending_op_name,
+             op_ordinals_[annotation.pending_op_name]++};
+      alloc_time = ++clock_;
+      if (serving_step_) {
+        bool mismatch = false;
+        void* ptr = AllocateFromPlanLocked(key, alignment, num_bytes, &mismatch);
+        if (ptr != nullptr) return ptr;
+        if (mismatch) ++num_mismatches_;
+      } else {
+        traced = true;
+      }
+    }
+  }
+  void* ptr = base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr == nullptr || !traced) return ptr;
+
+  mutex_lock l(mu_);
+  if (has_active_step_ && step_id == active_step_id_ && !serving_step_) {
+    BufferLifetime& lifetime = trace_[key];
+    lifetime.num_bytes = num_bytes;
+    lifetime.alignment = alignment;
+    lifetime.first_use = alloc_time;
+    live_traced_[ptr] = key;
+  }
+  return ptr;
+}
+
+void StaticPlanAllocator::DeallocateRaw(void* ptr) {
+  {
+    mutex_lock l(mu_);
+    if (InArena(ptr)) {
+      auto it = live_arena_.find(ptr);
+      CHECK(it != live_arena_.end())
+          << "Deallocating a buffer that is not live in the static plan arena";
+      if (has_plan_) plan_[it->second.buffer].in_use = false;
+      live_arena_.erase(it);
+      if (!has_plan_ && live_arena_.empty()) {
+        base_->DeallocateRaw(arena_);
+        arena_ = nullptr;
+        arena_bytes_ = 0;
+      }
+      return;
+    }
+    auto it = live_traced_.find(ptr);
+    if (it != live_traced_.end()) {
+      trace_[it->second].last_use = ++clock_;
+      live_traced_.erase(it);
+    }
+  }
+  base_->DeallocateRaw(ptr);
+}
+
+bool StaticPlanAllocator::TracksAllocationSizes() const {
+  return base_->TracksAllocationSizes();
+}
+
+size_t StaticPlanAllocator::RequestedSize(const void* ptr) const {
+  {
+    mutex_lock l(mu_);
+    if (InArena(ptr)) {
+      auto it = live_arena_.find(ptr);
+      CHECK(it != live_arena_.end());
+      return it->second.requested_bytes;
+    }
+  }
+  return base_->RequestedSize(ptr);
+}
+
+size_t StaticPlanAllocator::AllocatedSize(const void* ptr) const {
+  {
+    mutex_lock l(mu_);
+    if (InArena(ptr)) {
+      auto it = live_arena_.find(ptr);
+      CHECK(it != live_arena_.end());
+      return has_plan_ ? plan_[it->second.buffer].num_bytes
+                       : it->second.requested_bytes;
+    }
+  }
+  return base_->AllocatedSize(ptr);
+}
+
+int64 StaticPlanAllocator::AllocationId(const void* ptr) const {
+  {
+    mutex_lock l(mu_);
+    if (InArena(ptr)) return 0;
+  }
+  return base_->AllocationId(ptr);
+}
+
+absl::optional<AllocatorStats> StaticPlanAllocator::GetStats() {
+  return base_->GetStats();
+}
+
+void StaticPlanAllocator::ClearStats() { base_->ClearStats(); }
+
+void StaticPlanAllocator::BeginStep(int64 step_id, uint64 signature) {
+  mutex_lock l(mu_);
+  if (has_active_step_) return;
+  has_active_step_ = true;
+  active_step_id_ = step_id;
+  clock_ = 0;
+  num_mismatches_ = 0;
+  if (signature != signature_) {
+    signature_ = signature;
+    num_matching_steps_ = 0;
+    reference_.clear();
+    if (has_plan_) InvalidatePlanLocked();
+  }
+  serving_step_ = has_plan_;
+}
+
+void StaticPlanAllocator::EndStep(int64 step_id) {
+  mutex_lock l(mu_);
+  if (!has_active_step_ || step_id != active_step_id_) return;
+  has_active_step_ = false;
+  if (serving_step_) {
+    if (num_mismatches_ > 0) {
+      VLOG(1) << "Dropping static memory plan after " << num_mismatches_
+              << " allocations did not match it in step " << step_id;
+      InvalidatePlanLocked();
+      num_matching_steps_ = 0;
+      reference_.clear();
+    }
+  } else {
+    // Buffers still live at the end of the step outlive it and are never
+    // planned; their eventual deallocation goes to the base allocator.
+    live_traced_.clear();
+    MergeTraceLocked();
+    if (!has_plan_ && arena_ == nullptr &&
+        num_matching_steps_ == warmup_steps_) {
+      BuildPlanLocked();
+    }
+  }
+  trace_.clear();
+  op_ordinals_.clear();
+}
+
+bool StaticPlanAllocator::HasPlan() const {
+  mutex_lock l(mu_);
+  return has_plan_;
+}
+
+int64 StaticPlanAllocator::PlannedArenaBytes() const {
+  mutex_lock l(mu_);
+  return has_plan_ ? arena_bytes_ : 0;
+}
+
+int64 StaticPlanAllocator::NumArenaAllocations() const {
+  mutex_lock l(mu_);
+  return num_arena_allocations_;
+}
+
+void* StaticPlanAllocator::AllocateFromPlanLocked(const BufferKey& key,
+                                                  size_t alignment,
+                                                  size_t num_bytes,
+                                                  bool* mismatch) {
+  auto it = plan_index_.find(key);
+  if (it == plan_index_.end()) {
+    *mismatch = true;
+    return nullptr;
+  }
+  // Known allocation that outlives the step; never served from the arena.
+  if (it->second < 0) return nullptr;
+  PlannedBuffer& buffer = plan_[it->second];
+  char* ptr = arena_ + buffer.offset;
+  if (num_bytes > buffer.num_bytes ||
+      reinterpret_cast<uintptr_t>(ptr) % std::max<size_t>(alignment, 1) != 0) {
+    *mismatch = true;
+    return nullptr;
+  }
+  if (buffer.in_use) return nullptr;
+  for (int conflict : buffer.conflicts) {
+    if (plan_[conflict].in_use) return nullptr;
+  }
+  buffer.in_use = true;
+  live_arena_[ptr] = {it->second, num_bytes};
+  ++num_arena_allocations_;
+  return ptr;
+}
+
+void StaticPlanAllocator::MergeTraceLocked() {
+  bool matches =
+      num_matching_steps_ > 0 && trace_.size() == reference_.size();
+  for (auto it = trace_.begin(); matches && it != trace_.end(); ++it) {
+    auto ref = reference_.find(it->first);
+    matches = ref != reference_.end() &&
+              ref->second.num_bytes == it->second.num_bytes &&
+              (ref->second.last_use == kNotFreed) ==
+                  (it->second.last_use == kNotFreed);
+  }
+  if (!matches) {
+    reference_.swap(trace_);
+    num_matching_steps_ = 1;
+    return;
+  }
+  for (const auto& entry : trace_) {
+    BufferLifetime& ref = reference_[entry.first];
+    ref.alignment = std::max(ref.alignment, entry.second.alignment);
+    ref.first_use = std::min(ref.first_use, entry.second.first_use);
+    if (ref.last_use != kNotFreed) {
+      ref.last_use = std::max(ref.last_use, entry.second.last_use);
+    }
+  }
+  ++num_matching_steps_;
+}
+
+void StaticPlanAllocator::BuildPlanLocked() {
+  std::vector<std::pair<BufferKey, BufferLifetime>> buffers;
+  for (const auto& entry : reference_) {
+    if (entry.second.last_use != kNotFreed) buffers.push_back(entry);
+  }
+  if (buffers.empty()) return;
+
+  // Place the largest buffers first, each at the lowest offset that does not
+  // overlap a placed buffer whose lifetime intersects its own.
+  std::sort(buffers.begin(), buffers.end(),
+            [](const std::pair<BufferKey, BufferLifetime>& a,
+               const std::pair<BufferKey, BufferLifetime>& b) {
+              if (a.second.num_bytes != b.second.num_bytes) {
+                return a.second.num_bytes > b.second.num_bytes;
+              }
+              return a.second.first_use < b.second.first_use;
+            });
+  auto lifetimes_overlap = [&buffers](int a, int b) {
+    return buffers[a].second.first_use <= buffers[b].second.last_use &&
+           buffers[b].second.first_use <= buffers[a].second.last_use;
+  };
+
+  std::vector<PlannedBuffer> plan(buffers.size());
+  size_t arena_bytes = 0;
+  size_t total_bytes = 0;
+  std::vector<int> overlapping;
+  for (int i = 0; i < buffers.size(); ++i) {
+    const size_t alignment =
+        std::max(buffers[i].second.alignment, Allocator::kAllocatorAlignment);
+    const size_t num_bytes = std::max<size_t>(buffers[i].second.num_bytes, 1);
+    overlapping.clear();
+    for (int j = 0; j < i; ++j) {
+      if (lifetimes_overlap(i, j)) overlapping.push_back(j);
+    }
+    std::sort(overlapping.begin(), overlapping.end(), [&plan](int a, int b) {
+      return plan[a].offset < plan[b].offset;
+    });
+    size_t offset = 0;
+    for (int j : overlapping) {
+      if (offset + num_bytes <= plan[j].offset) break;
+      offset =
+          std::max(offset, RoundUp(plan[j].offset + plan[j].num_bytes,
+                                   alignment));
+    }
+    plan[i].offset = offset;
+    plan[i].num_bytes = num_bytes;
+    arena_bytes = std::max(arena_bytes, offset + num_bytes);
+    total_bytes += num_bytes;
+  }
+
+  for (int i = 0; i < plan.size(); ++i) {
+    for (int j = i + 1; j < plan.size(); ++j) {
+      if (plan[i].offset < plan[j].offset + plan[j].num_bytes &&
+          plan[j].offset < plan[i].offset + plan[i].num_bytes) {
+        plan[i].conflicts.push_back(j);
+        plan[j].conflicts.push_back(i);
+      }
+    }
+  }
+
+  void* arena =
+      base_->AllocateRaw(Allocator::kAllocatorAlignment, arena_bytes);
+  if (arena == nullptr) {
+    LOG(WARNING) << "Could not allocate a static memory plan arena of "
+                 << arena_bytes << " bytes; continuing without a plan.";
+    return;
+  }
+  arena_ = static_cast<char*>(arena);
+  arena_bytes_ = arena_bytes;
+  plan_ = std::move(plan);
+  plan_index_.clear();
+  for (const auto& entry : reference_) plan_index_[entry.first] = -1;
+  for (int i = 0; i < buffers.size(); ++i) {
+    plan_index_[buffers[i].first] = i;
+  }
+  has_plan_ = true;
+  VLOG(1) << "Planned " << plan_.size() << " buffers totalling " << total_bytes
+          << " bytes into a static arena of " << arena_bytes_ << " bytes";
+}
+
+void StaticPlanAllocator::InvalidatePlanLocked() {
+  has_plan_ = false;
+  plan_.clear();
+  plan_index_.clear();
+  if (arena_ != nullptr && live_arena_.empty()) {
+    base_->DeallocateRaw(arena_);
+    arena_ = nullptr;
+    arena_bytes_ = 0;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,174 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_PLAN_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_PLAN_ALLOCATOR_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An Allocator that serves the step-local buffers of a repeatedly executed
+// step from a single pre-planned arena.
+//
+// The owner brackets each step with BeginStep()/EndStep().  Allocations made
+// by kernels of the active step (as identified by the
+// ScopedMemoryDebugAnnotation set in OpKernelContext) are keyed by
+// (kernel, per-kernel allocation ordinal) and traced along with their logical
+// lifetimes.  Once `warmup_steps` consecutive steps with the same signature
+// have produced the same set of keys and sizes, the buffers that were freed
+// within the step are assigned offsets in one arena by a greedy-by-size
+// interval packing, and subsequent steps with that signature take those
+// buffers from the arena instead of the base allocator.
+//
+// Serving from the plan is always safe: a planned buffer is handed out only
+// if neither it nor any buffer whose planned range overlaps it is currently
+// live, so any deviation from the recorded schedule (concurrent steps, a
+// buffer kept alive by the client) falls back to the base allocator.  A step
+// whose allocations no longer match the plan drops it and warm-up restarts.
+//
+// Only one step at a time is traced or served; allocations of concurrently
+// running steps, and allocations made outside of a kernel's
+// allocate_output/allocate_temp, go straight to the base allocator.
+class StaticPlanAllocator : public Allocator {
+ public:
+  // Does not take ownership of `base`, which must outlive this object.
+  StaticPlanAllocator(Allocator* base, int warmup_steps);
+  ~StaticPlanAllocator() override;
+
+  string Name() override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() const override;
+  size_t RequestedSize(const void* ptr) const override;
+  size_t AllocatedSize(const void* ptr) const override;
+  int64 AllocationId(const void* ptr) const override;
+  absl::optional<AllocatorStats> GetStats() override;
+  void ClearStats() override;
+
+  // Marks the start of step `step_id`, whose graph is identified by
+  // `signature`.  A no-op if another step is already active.
+  void BeginStep(int64 step_id, uint64 signature);
+
+  // Marks the end of step `step_id`.  A no-op unless `step_id` is the step
+  // that was accepted by the last BeginStep().
+  void EndStep(int64 step_id);
+
+  // Returns true if steps with the current signature are served from a plan.
+  bool HasPlan() const;
+
+  // Returns the size of the planned arena in bytes, or 0 if there is no plan.
+  int64 PlannedArenaBytes() const;
+
+  // Returns the number of allocations served from the arena so far.
+  int64 NumArenaAllocations() const;
+
+ private:
+  using BufferKey = std::pair<const char*, int64>;
+
+  // Logical timestamp of an allocation that was not freed within its step.
+  static constexpr int64 kNotFreed = -1;
+
+  struct BufferLifetime {
+    size_t num_bytes = 0;
+    size_t alignment = 0;
+    int64 first_use = 0;
+    int64 last_use = kNotFreed;
+  };
+
+  struct PlannedBuffer {
+    size_t offset = 0;
+    size_t num_bytes = 0;
+    // Indices of the planned buffers whose arena ranges overlap this one.
+    std::vector<int> conflicts;
+    bool in_use = false;
+  };
+
+  struct ArenaAllocation {
+    int buffer = 0;
+    size_t requested_bytes = 0;
+  };
+
+  bool InArena(const void* ptr) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const char* p = static_cast<const char*>(ptr);
+    return arena_ != nullptr && p >= arena_ && p < arena_ + arena_bytes_;
+  }
+
+  // Returns a buffer from the arena for `key`, or nullptr if it is not
+  // available.  Sets `*mismatch` if the request does not fit the plan.
+  void* AllocateFromPlanLocked(const BufferKey& key, size_t alignment,
+                               size_t num_bytes, bool* mismatch)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Folds the trace of the step that just ended into `reference_`.
+  void MergeTraceLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Computes the offset plan from `reference_` and allocates the arena.
+  void BuildPlanLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Drops the plan.  The arena is released once no buffer in it is live.
+  void InvalidatePlanLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;  // Not owned.
+  const int warmup_steps_;
+
+  mutable mutex mu_;
+
+  // State of the active step.
+  bool has_active_step_ TF_GUARDED_BY(mu_) = false;
+  int64 active_step_id_ TF_GUARDED_BY(mu_) = 0;
+  bool serving_step_ TF_GUARDED_BY(mu_) = false;
+  int64 clock_ TF_GUARDED_BY(mu_) = 0;
+  int64 num_mismatches_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<const char*, int64> op_ordinals_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<BufferKey, BufferLifetime> trace_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<void*, BufferKey> live_traced_ TF_GUARDED_BY(mu_);
+
+  // Union of the lifetimes seen over `num_matching_steps_` consecutive steps
+  // with signature `signature_`.
+  uint64 signature_ TF_GUARDED_BY(mu_) = 0;
+  int num_matching_steps_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<BufferKey, BufferLifetime> reference_ TF_GUARDED_BY(mu_);
+
+  // The plan for `signature_`, if any.
+  bool has_plan_ TF_GUARDED_BY(mu_) = false;
+  std::vector<PlannedBuffer> plan_ TF_GUARDED_BY(mu_);
+  // Index into `plan_` of every traced buffer, or -1 for those not planned.
+  absl::flat_hash_map<BufferKey, int> plan_index_ TF_GUARDED_BY(mu_);
+  char* arena_ TF_GUARDED_BY(mu_) = nullptr;
+  size_t arena_bytes_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<const void*, ArenaAllocation> live_arena_
+      TF_GUARDED_BY(mu_);
+  int64 num_arena_allocations_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticPlanAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_PLAN_ALLOCATOR_H_
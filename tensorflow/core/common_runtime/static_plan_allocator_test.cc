@@ -0,0 +1,178 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
+
+#include <cstring>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr uint64 kSignature = 17;
+
+const char* const kOpA = "a";
+const char* const kOpB = "b";
+const char* const kOpC = "c";
+const char* const kOpOut = "out";
+
+void* AllocateFor(StaticPlanAllocator* allocator, const char* op_name,
+                  int64 step_id, size_t num_bytes) {
+  ScopedMemoryDebugAnnotation annotation(op_name, step_id);
+  void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment, num_bytes);
+  CHECK(ptr != nullptr);
+  // Touch the whole buffer so that overlapping assignments would be noticed
+  // by memory checkers.
+  memset(ptr, 0xab, num_bytes);
+  return ptr;
+}
+
+class StaticPlanAllocatorTest : public ::testing::Test {
+ protected:
+  StaticPlanAllocatorTest() : allocator_(cpu_allocator(), /*warmup_steps=*/2) {}
+
+  // Runs a step in which "a" and "c" have disjoint lifetimes that both
+  // intersect the lifetime of "b", and "out" outlives the step.
+  void RunStep(uint64 signature = kSignature, size_t b_bytes = 2048) {
+    const int64 step_id = next_step_id_++;
+    allocator_.BeginStep(step_id, signature);
+    a_ = AllocateFor(&allocator_, kOpA, step_id, 1024);
+    b_ = AllocateFor(&allocator_, kOpB, step_id, b_bytes);
+    allocator_.DeallocateRaw(a_);
+    c_ = AllocateFor(&allocator_, kOpC, step_id, 1024);
+    allocator_.DeallocateRaw(b_);
+    allocator_.DeallocateRaw(c_);
+    void* out = AllocateFor(&allocator_, kOpOut, step_id, 64);
+    allocator_.EndStep(step_id);
+    allocator_.DeallocateRaw(out);
+  }
+
+  StaticPlanAllocator allocator_;
+  int64 next_step_id_ = 1;
+  void* a_ = nullptr;
+  void* b_ = nullptr;
+  void* c_ = nullptr;
+};
+
+TEST_F(StaticPlanAllocatorTest, PlansAfterWarmup) {
+  RunStep();
+  EXPECT_FALSE(allocator_.HasPlan());
+  RunStep();
+  ASSERT_TRUE(allocator_.HasPlan());
+  // "a" and "c" share an offset; "out" is not planned.
+  EXPECT_EQ(3072, allocator_.PlannedArenaBytes());
+  EXPECT_EQ(0, allocator_.NumArenaAllocations());
+
+  RunStep();
+  EXPECT_TRUE(allocator_.HasPlan());
+  EXPECT_EQ(3, allocator_.NumArenaAllocations());
+  EXPECT_EQ(a_, c_);
+  EXPECT_NE(a_, b_);
+
+  RunStep();
+  EXPECT_TRUE(allocator_.HasPlan());
+  EXPECT_EQ(6, allocator_.NumArenaAllocations());
+}
+
+TEST_F(StaticPlanAllocatorTest, LiveConflictFallsBack) {
+  RunStep();
+  RunStep();
+  ASSERT_TRUE(allocator_.HasPlan());
+
+  // Keep "a" alive past the allocation of "c", which was planned at the same
+  // offset.
+  const int64 step_id = next_step_id_++;
+  allocator_.BeginStep(step_id, kSignature);
+  void* a = AllocateFor(&allocator_, kOpA, step_id, 1024);
+  void* b = AllocateFor(&allocator_, kOpB, step_id, 2048);
+  void* c = AllocateFor(&allocator_, kOpC, step_id, 1024);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(2, allocator_.NumArenaAllocations());
+  allocator_.DeallocateRaw(a);
+  allocator_.DeallocateRaw(b);
+  allocator_.DeallocateRaw(c);
+  allocator_.EndStep(step_id);
+
+  // A conflict is not a mismatch, so the plan is kept.
+  EXPECT_TRUE(allocator_.HasPlan());
+  RunStep();
+  EXPECT_EQ(5, allocator_.NumArenaAllocations());
+}
+
+TEST_F(StaticPlanAllocatorTest, MismatchDropsPlan) {
+  RunStep();
+  RunStep();
+  ASSERT_TRUE(allocator_.HasPlan());
+
+  RunStep(kSignature, /*b_bytes=*/4096);
+  EXPECT_FALSE(allocator_.HasPlan());
+
+  // Warm-up restarts with the new sizes.
+  RunStep(kSignature, 4096);
+  EXPECT_FALSE(allocator_.HasPlan());
+  RunStep(kSignature, 4096);
+  ASSERT_TRUE(allocator_.HasPlan());
+  EXPECT_EQ(5120, allocator_.PlannedArenaBytes());
+}
+
+TEST_F(StaticPlanAllocatorTest, SignatureChangeDropsPlan) {
+  RunStep();
+  RunStep();
+  ASSERT_TRUE(allocator_.HasPlan());
+
+  RunStep(kSignature + 1);
+  EXPECT_FALSE(allocator_.HasPlan());
+  RunStep(kSignature + 1);
+  EXPECT_TRUE(allocator_.HasPlan());
+}
+
+TEST_F(StaticPlanAllocatorTest, ConcurrentStepUsesBaseAllocator) {
+  RunStep();
+  RunStep();
+  ASSERT_TRUE(allocator_.HasPlan());
+
+  allocator_.BeginStep(100, kSignature);
+  // Rejected: step 100 is still active.
+  allocator_.BeginStep(101, kSignature);
+  void* other = AllocateFor(&allocator_, kOpA, 101, 1024);
+  EXPECT_EQ(0, allocator_.NumArenaAllocations());
+  void* a = AllocateFor(&allocator_, kOpA, 100, 1024);
+  EXPECT_EQ(1, allocator_.NumArenaAllocations());
+  EXPECT_NE(a, other);
+  EXPECT_EQ(1024, allocator_.RequestedSize(a));
+  allocator_.DeallocateRaw(a);
+  allocator_.DeallocateRaw(other);
+  allocator_.EndStep(101);
+  allocator_.EndStep(100);
+  EXPECT_TRUE(allocator_.HasPlan());
+}
+
+TEST_F(StaticPlanAllocatorTest, UnannotatedAllocationsUseBaseAllocator) {
+  RunStep();
+  RunStep();
+  ASSERT_TRUE(allocator_.HasPlan());
+
+  allocator_.BeginStep(100, kSignature);
+  void* ptr = allocator_.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  EXPECT_EQ(0, allocator_.NumArenaAllocations());
+  allocator_.DeallocateRaw(ptr);
+  allocator_.EndStep(100);
+  EXPECT_TRUE(allocator_.HasPlan());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -61,6 +61,14 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
                                name, DEVICE_CPU, memory_limit, locality)),
       allocator_(allocator),
       scoped_allocator_mgr_(new ScopedAllocatorMgr(name)) {
+  const int32 warmup_steps =
+      options.config.experimental().static_memory_plan_warmup_steps();
+  if (warmup_steps > 0) {
+    static_plan_allocator_.reset(
+        new StaticPlanAllocator(allocator_, warmup_steps));
+  } else if (options.config.experimental().enable_tensor_buffer_pool()) {
+    tensor_buffer_pool_.reset(new TensorBufferPool(allocator_));
+  }
 #if defined(ENABLE_ONEDNN_OPENMP) && defined(INTEL_MKL)
   // Early return when MKL is disabled
   if (!IsMKLEnabled()) return;
@@ -90,9 +98,14 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
 #endif  // defined(ENABLE_ONEDNN_OPENMP) && defined(INTEL_MKL)
 }
 
-ThreadPoolDevice::~ThreadPoolDevice() {}
+ThreadPoolDevice::~ThreadPoolDevice() {
+  // Tensors handed out by the pool keep it alive, but stop caching buffers
+  // for a device that is going away.
+  if (tensor_buffer_pool_) tensor_buffer_pool_->Shutdown();
+}
 
 Allocator* ThreadPoolDevice::GetAllocator(AllocatorAttributes attr) {
+  if (static_plan_allocator_) return static_plan_allocator_.get();
   return allocator_;
 }
 
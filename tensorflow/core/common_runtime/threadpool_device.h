@@ -18,6 +18,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/static_plan_allocator.h"
+#include "tensorflow/core/framework/tensor_buffer_pool.h"
 
 namespace tensorflow {
 
@@ -35,6 +37,12 @@ class ThreadPoolDevice : public LocalDevice {
   ScopedAllocatorMgr* GetScopedAllocatorMgr() const override {
     return scoped_allocator_mgr_.get();
   }
+  StaticPlanAllocator* GetStaticPlanAllocator() const override {
+    return static_plan_allocator_.get();
+  }
+  TensorBufferPool* GetTensorBufferPool() const override {
+    return tensor_buffer_pool_.get();
+  }
   Status MakeTensorFromProto(const TensorProto& tensor_proto,
                              const AllocatorAttributes alloc_attrs,
                              Tensor* tensor) override;
@@ -47,6 +55,9 @@ class ThreadPoolDevice : public LocalDevice {
  private:
   Allocator* allocator_;  // Not owned
   std::unique_ptr<ScopedAllocatorMgr> scoped_allocator_mgr_;
+  // Wraps `allocator_` when static memory planning is enabled.
+  std::unique_ptr<StaticPlanAllocator> static_plan_allocator_;
+  core::RefCountPtr<TensorBufferPool> tensor_buffer_pool_;
 };
 
 }  // namespace tensorflow
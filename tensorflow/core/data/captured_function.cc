@@ -832,7 +832,8 @@ InstantiatedCapturedFunction::InstantiatedCapturedFunction(
       ret_types_(std::move(ret_types)),
       captured_runner_(std::move(runner)),
       captured_func_(captured_func),
-      is_multi_device_(is_multi_device) {}
+      is_multi_device_(is_multi_device),
+      create_rendezvous_(ShouldCreateRendezvous()) {}
 
 Status InstantiatedCapturedFunction::Run(IteratorContext* ctx,
                                          std::vector<Tensor>&& args,
@@ -855,7 +856,7 @@ Status InstantiatedCapturedFunction::Run(
       });
   f_opts.step_container = &step_container;
   f_opts.runner = ctx->runner();
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
   CancellationManager cancellation_manager(ctx->cancellation_manager());
   f_opts.cancellation_manager = &cancellation_manager;
 
@@ -918,7 +919,7 @@ Status InstantiatedCapturedFunction::RunWithBorrowedArgs(
       });
   f_opts.step_container = &step_container;
   f_opts.runner = ctx->runner();
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
   CancellationManager cancellation_manager(ctx->cancellation_manager());
   f_opts.cancellation_manager = &cancellation_manager;
 
@@ -973,7 +974,7 @@ Status InstantiatedCapturedFunction::RunInstantiated(
       });
   f_opts.step_container = &step_container;
   f_opts.runner = &captured_runner_;
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
   CancellationManager cancellation_manager;
   f_opts.cancellation_manager = &cancellation_manager;
 
@@ -1019,7 +1020,7 @@ void InstantiatedCapturedFunction::RunAsync(
       });
   f_opts.step_container = step_container;
   f_opts.runner = ctx->runner();
-  f_opts.create_rendezvous = ShouldCreateRendezvous();
+  f_opts.create_rendezvous = create_rendezvous_;
   auto cancellation_manager =
       absl::make_unique<CancellationManager>(ctx->cancellation_manager());
   f_opts.cancellation_manager = cancellation_manager.get();
@@ -288,6 +288,9 @@ class InstantiatedCapturedFunction {
   std::function<void(std::function<void()>)> captured_runner_;
   CapturedFunction* const captured_func_;  // Not owned.
   const bool is_multi_device_;
+  // Cached result of `ShouldCreateRendezvous()`, which is invariant for the
+  // lifetime of the instantiated function.
+  const bool create_rendezvous_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(InstantiatedCapturedFunction);
 };
@@ -68,6 +68,15 @@ Status CompressElement(const std::vector<Tensor>& element,
                              out->mutable_data())) {
     return errors::Internal("Failed to compress using snappy.");
   }
+  if (out->data().size() >= static_cast<size_t>(total_size)) {
+    // The data is incompressible (e.g. already-encoded images). Store it raw
+    // so that readers can skip snappy decompression entirely.
+    out->set_data(uncompressed.data(), total_size);
+    out->set_stored_uncompressed(true);
+    VLOG(3) << "Stored incompressible element of " << total_size
+            << " bytes uncompressed";
+    return Status::OK();
+  }
   VLOG(3) << "Compressed element from " << total_size << " bytes to "
           << out->data().size() << " bytes";
   return Status::OK();
@@ -111,22 +120,37 @@ Status UncompressElement(const CompressedElement& compressed,
 
   // Step 2: Uncompress into the iovec.
   const std::string& compressed_data = compressed.data();
-  size_t uncompressed_size;
-  if (!port::Snappy_GetUncompressedLength(
-          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
-    return errors::Internal(
-        "Could not get snappy uncompressed length. Compressed data size: ",
-        compressed_data.size());
-  }
-  if (uncompressed_size != static_cast<size_t>(total_size)) {
-    return errors::Internal(
-        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
-        " whereas the tensor metadata suggests ", total_size);
-  }
-  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
-                                      compressed_data.size(), iov.data(),
-                                      num_components)) {
-    return errors::Internal("Failed to perform snappy decompression.");
+  if (compressed.stored_uncompressed()) {
+    if (compressed_data.size() != static_cast<size_t>(total_size)) {
+      return errors::Internal("Uncompressed size mismatch. Stored data has ",
+                              compressed_data.size(),
+                              " bytes whereas the tensor metadata suggests ",
+                              total_size);
+    }
+    const char* position = compressed_data.data();
+    for (int i = 0; i < num_components; ++i) {
+      memcpy(iov[i].iov_base, position, iov[i].iov_len);
+      position += iov[i].iov_len;
+    }
+  } else {
+    size_t uncompressed_size;
+    if (!port::Snappy_GetUncompressedLength(compressed_data.data(),
+                                            compressed_data.size(),
+                                            &uncompressed_size)) {
+      return errors::Internal(
+          "Could not get snappy uncompressed length. Compressed data size: ",
+          compressed_data.size());
+    }
+    if (uncompressed_size != static_cast<size_t>(total_size)) {
+      return errors::Internal(
+          "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
+          " whereas the tensor metadata suggests ", total_size);
+    }
+    if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
+                                        compressed_data.size(), iov.data(),
+                                        num_components)) {
+      return errors::Internal("Failed to perform snappy decompression.");
+    }
   }
 
   // Step 3: Deserialize tensor proto strings to tensors.
@@ -146,5 +170,20 @@ Status UncompressElement(const CompressedElement& compressed,
   return Status::OK();
 }
 
+Status SnappyCompressStoredData(const CompressedElement& compressed,
+                                CompressedElement* out) {
+  if (!compressed.stored_uncompressed()) {
+    *out = compressed;
+    return Status::OK();
+  }
+  out->Clear();
+  *out->mutable_component_metadata() = compressed.component_metadata();
+  if (!port::Snappy_Compress(compressed.data().data(),
+                             compressed.data().size(), out->mutable_data())) {
+    return errors::Internal("Failed to compress using snappy.");
+  }
+  return Status::OK();
+}
+
 }  // namespace data
 }  // namespace tensorflow
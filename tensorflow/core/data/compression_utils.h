@@ -33,6 +33,12 @@ Status CompressElement(const std::vector<Tensor>& element,
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out);
 
+// Sets `out` to `compressed` with its data snappy-compressed, for readers that
+// predate `CompressedElement.stored_uncompressed`. Copies `compressed` as is
+// if its data is already compressed.
+Status SnappyCompressStoredData(const CompressedElement& compressed,
+                                CompressedElement* out);
+
 }  // namespace data
 }  // namespace tensorflow
 
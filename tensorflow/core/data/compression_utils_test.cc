@@ -16,6 +16,8 @@ limitations under the License.
 
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -35,6 +37,64 @@ TEST_P(ParameterizedCompressionUtilsTest, RoundTrip) {
       ExpectEqual(element, round_trip_element, /*compare_order=*/true));
 }
 
+class CompressionUtilsTest : public DatasetOpsTestBase {};
+
+TEST_F(CompressionUtilsTest, IncompressibleElementIsStoredUncompressed) {
+  random::PhiloxRandom philox(/*seed=*/42);
+  random::SimplePhilox rng(&philox);
+  std::vector<int64> values(1024);
+  for (int64& value : values) {
+    value = rng.Rand64();
+  }
+  std::vector<Tensor> element = {
+      CreateTensor<int64>(TensorShape{1024}, values),
+      CreateTensor<tstring>(TensorShape{1}, {"a"})};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, &compressed));
+  EXPECT_TRUE(compressed.stored_uncompressed());
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
+TEST_F(CompressionUtilsTest, CompressibleElementIsCompressed) {
+  std::vector<Tensor> element = {
+      CreateTensor<int64>(TensorShape{1024}, std::vector<int64>(1024, 7))};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, &compressed));
+  EXPECT_FALSE(compressed.stored_uncompressed());
+  EXPECT_LT(compressed.data().size(), 1024 * sizeof(int64));
+}
+
+TEST_F(CompressionUtilsTest, SnappyCompressStoredData) {
+  random::PhiloxRandom philox(/*seed=*/42);
+  random::SimplePhilox rng(&philox);
+  std::vector<int64> values(1024);
+  for (int64& value : values) {
+    value = rng.Rand64();
+  }
+  std::vector<Tensor> element = {
+      CreateTensor<int64>(TensorShape{1024}, values),
+      CreateTensor<tstring>(TensorShape{1}, {"a"})};
+  CompressedElement stored;
+  TF_ASSERT_OK(CompressElement(element, &stored));
+  ASSERT_TRUE(stored.stored_uncompressed());
+
+  CompressedElement compressed;
+  TF_ASSERT_OK(SnappyCompressStoredData(stored, &compressed));
+  EXPECT_FALSE(compressed.stored_uncompressed());
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+
+  // Compressed data is left as is.
+  CompressedElement copy;
+  TF_ASSERT_OK(SnappyCompressStoredData(compressed, &copy));
+  EXPECT_EQ(compressed.SerializeAsString(), copy.SerializeAsString());
+}
+
 std::vector<std::vector<Tensor>> TestCases() {
   return {
       CreateTensors<int64>(TensorShape{1}, {{1}}),             // int64
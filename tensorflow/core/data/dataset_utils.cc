@@ -1139,6 +1139,48 @@ Status CopyBatch(bool parallel_copy, IteratorContext* ctx,
   return Status::OK();
 }
 
+Status CopyElementToBatch(IteratorContext* ctx, int64 batch_size, int64 index,
+                          std::vector<Tensor> element,
+                          std::vector<Tensor>* batch) {
+  if (batch->empty()) {
+    batch->reserve(element.size());
+    for (size_t component_index = 0; component_index < element.size();
+         ++component_index) {
+      const Tensor& component = element[component_index];
+      TensorShape batch_component_shape({batch_size});
+      batch_component_shape.AppendShape(component.shape());
+      batch->emplace_back(ctx->allocator({}), component.dtype(),
+                          batch_component_shape);
+      if (!batch->back().IsInitialized()) {
+        return errors::ResourceExhausted(
+            "Failed to allocate memory for the batch of component ",
+            component_index);
+      }
+    }
+  }
+  if (element.size() != batch->size()) {
+    return errors::InvalidArgument("Cannot batch elements with ",
+                                   batch->size(), " and ", element.size(),
+                                   " components.");
+  }
+  for (size_t component_index = 0; component_index < element.size();
+       ++component_index) {
+    Tensor& batch_component = (*batch)[component_index];
+    TensorShape element_shape(batch_component.shape());
+    element_shape.RemoveDim(0);
+    if (element[component_index].shape() != element_shape) {
+      return errors::InvalidArgument(
+          "Cannot batch tensors with different shapes in component ",
+          component_index, ". First element had shape ",
+          element_shape.DebugString(), " and element ", index, " had shape ",
+          element[component_index].shape().DebugString(), ".");
+    }
+    TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+        std::move(element[component_index]), &batch_component, index));
+  }
+  return Status::OK();
+}
+
 void GetOptimizations(const Options& options,
                       std::vector<tstring>* optimizations_enabled,
                       std::vector<tstring>* optimizations_disabled,
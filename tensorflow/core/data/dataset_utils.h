@@ -323,6 +323,16 @@ Status CopyBatch(bool parallel_copy, IteratorContext* ctx,
                  std::vector<Tensor>* out_tensors,
                  std::vector<std::vector<Tensor>>* batch_elements);
 
+// Copies the components of `element` into row `index` of the corresponding
+// components of `batch`. If `batch` is empty, first allocates one tensor with
+// `batch_size` rows per component, shaped like the components of `element`.
+//
+// Unlike CopyBatch(), this lets a batch be assembled while its elements are
+// produced, without buffering them.
+Status CopyElementToBatch(IteratorContext* ctx, int64 batch_size, int64 index,
+                          std::vector<Tensor> element,
+                          std::vector<Tensor>* batch);
+
 // Configures tf.data experiments and determines which optimizations should be
 // applied.
 std::vector<tstring> ConfigureExperimentsAndSelectOptimizations(
@@ -0,0 +1,152 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/element_spill_store.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+
+namespace tensorflow {
+namespace data {
+
+ElementSpillStore::ElementSpillStore(Env* env, const std::string& directory,
+                                     int64 max_file_bytes)
+    : env_(env),
+      directory_(directory),
+      max_file_bytes_(max_file_bytes),
+      store_id_(random::New64()) {}
+
+ElementSpillStore::~ElementSpillStore() {
+  mutex_lock l(mu_);
+  if (writer_) {
+    writer_->Close().IgnoreError();
+    writer_.reset();
+  }
+  while (!files_.empty()) {
+    DeleteFileLocked(files_.begin()->first);
+  }
+}
+
+Status ElementSpillStore::Write(const std::vector<Tensor>& element,
+                                Handle* handle) {
+  CompressedElement compressed;
+  TF_RETURN_IF_ERROR(CompressElement(element, &compressed));
+  std::string data;
+  if (!compressed.SerializeToString(&data)) {
+    return errors::Internal("Failed to serialize an element of size ",
+                            compressed.ByteSizeLong(), " for spilling.");
+  }
+
+  mutex_lock l(mu_);
+  if (!writer_ ||
+      current_file_bytes_ >= static_cast<uint64>(max_file_bytes_)) {
+    TF_RETURN_IF_ERROR(StartFileLocked());
+  }
+  TF_RETURN_IF_ERROR(writer_->Append(data));
+  // Makes the element visible to `Read()`.
+  TF_RETURN_IF_ERROR(writer_->Flush());
+  handle->file_index = current_file_index_;
+  handle->offset = current_file_bytes_;
+  handle->size = data.size();
+  current_file_bytes_ += data.size();
+  ++files_[current_file_index_].num_live_elements;
+  return Status::OK();
+}
+
+Status ElementSpillStore::Read(const Handle& handle,
+                               std::vector<Tensor>* element) {
+  std::shared_ptr<RandomAccessFile> reader;
+  {
+    mutex_lock l(mu_);
+    auto it = files_.find(handle.file_index);
+    if (it == files_.end()) {
+      return errors::NotFound("Spilled element at ", handle.file_index, ":",
+                              handle.offset, " has been released.");
+    }
+    reader = it->second.reader;
+  }
+  std::string scratch(handle.size, '\0');
+  StringPiece data;
+  TF_RETURN_IF_ERROR(
+      reader->Read(handle.offset, handle.size, &data, &scratch[0]));
+  CompressedElement compressed;
+  if (data.size() != handle.size ||
+      !compressed.ParseFromArray(data.data(), data.size())) {
+    return errors::DataLoss("Failed to read spilled element at ",
+                            handle.file_index, ":", handle.offset);
+  }
+  return UncompressElement(compressed, element);
+}
+
+void ElementSpillStore::Release(const Handle& handle) {
+  mutex_lock l(mu_);
+  auto it = files_.find(handle.file_index);
+  if (it == files_.end()) {
+    return;
+  }
+  if (--it->second.num_live_elements == 0 &&
+      handle.file_index != current_file_index_) {
+    DeleteFileLocked(handle.file_index);
+  }
+}
+
+int64 ElementSpillStore::NumFiles() {
+  mutex_lock l(mu_);
+  return files_.size();
+}
+
+Status ElementSpillStore::StartFileLocked() {
+  if (writer_) {
+    TF_RETURN_IF_ERROR(writer_->Close());
+    writer_.reset();
+    if (files_[current_file_index_].num_live_elements == 0) {
+      DeleteFileLocked(current_file_index_);
+    }
+  }
+  if (current_file_index_ < 0) {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  }
+  const int64 file_index = current_file_index_ + 1;
+  File file;
+  file.filename = io::JoinPath(
+      directory_, absl::StrCat("spill_", store_id_, "_", file_index));
+  std::unique_ptr<WritableFile> writer;
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(file.filename, &writer));
+  std::unique_ptr<RandomAccessFile> reader;
+  TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(file.filename, &reader));
+  file.reader = std::move(reader);
+  files_.emplace(file_index, std::move(file));
+  writer_ = std::move(writer);
+  current_file_index_ = file_index;
+  current_file_bytes_ = 0;
+  return Status::OK();
+}
+
+void ElementSpillStore::DeleteFileLocked(int64 file_index) {
+  auto it = files_.find(file_index);
+  Status s = env_->DeleteFile(it->second.filename);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete spill file " << it->second.filename
+                 << ": " << s;
+  }
+  files_.erase(it);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,101 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_ELEMENT_SPILL_STORE_H_
+#define TENSORFLOW_CORE_DATA_ELEMENT_SPILL_STORE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// Stores dataset elements in append-only files in a local directory, so that
+// buffers of elements (e.g. the buffer of `shuffle`) are not bounded by the
+// available memory. Elements are stored as `CompressedElement`s.
+//
+// The store writes to one file at a time and starts a new one once the current
+// file exceeds `max_file_bytes`. A file is deleted once all elements written to
+// it have been released, and all files are deleted with the store.
+//
+// All methods are thread-safe.
+class ElementSpillStore {
+ public:
+  // Location of a stored element.
+  struct Handle {
+    int64 file_index = -1;
+    uint64 offset = 0;
+    uint64 size = 0;
+
+    bool valid() const { return file_index >= 0; }
+    bool operator==(const Handle& other) const {
+      return file_index == other.file_index && offset == other.offset;
+    }
+  };
+
+  ElementSpillStore(Env* env, const std::string& directory,
+                    int64 max_file_bytes);
+  ~ElementSpillStore();
+
+  ElementSpillStore(const ElementSpillStore&) = delete;
+  ElementSpillStore& operator=(const ElementSpillStore&) = delete;
+
+  // Writes `element` to the store and returns its location in `handle`.
+  Status Write(const std::vector<Tensor>& element, Handle* handle);
+
+  // Reads the element at `handle`, which must not have been released.
+  Status Read(const Handle& handle, std::vector<Tensor>* element);
+
+  // Releases the element at `handle`, which may not be read afterwards.
+  void Release(const Handle& handle);
+
+  // Returns the number of files of the store that have not been deleted.
+  int64 NumFiles();
+
+ private:
+  struct File {
+    std::string filename;
+    std::shared_ptr<RandomAccessFile> reader;
+    int64 num_live_elements = 0;
+  };
+
+  // Closes the current file and starts writing to a new one.
+  Status StartFileLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void DeleteFileLocked(int64 file_index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const std::string directory_;
+  const int64 max_file_bytes_;
+  // Distinguishes the files of stores that share `directory_`.
+  const uint64 store_id_;
+
+  mutex mu_;
+  std::unique_ptr<WritableFile> writer_ TF_GUARDED_BY(mu_);
+  int64 current_file_index_ TF_GUARDED_BY(mu_) = -1;
+  uint64 current_file_bytes_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<int64, File> files_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_ELEMENT_SPILL_STORE_H_
@@ -0,0 +1,101 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/element_spill_store.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::vector<Tensor> MakeElement(int64 i) {
+  return {test::AsScalar<int64>(i),
+          test::AsTensor<tstring>({"element", std::string(i, 'x')}, {2})};
+}
+
+void ExpectElement(int64 i, const std::vector<Tensor>& element) {
+  ASSERT_EQ(2, element.size());
+  test::ExpectEqual(test::AsScalar<int64>(i), element[0]);
+  test::ExpectEqual(
+      test::AsTensor<tstring>({"element", std::string(i, 'x')}, {2}),
+      element[1]);
+}
+
+std::string SpillDir(const std::string& name) {
+  return io::JoinPath(testing::TmpDir(), "element_spill_store_test", name);
+}
+
+int64 NumChildren(const std::string& dir) {
+  std::vector<string> children;
+  TF_CHECK_OK(Env::Default()->GetChildren(dir, &children));
+  return children.size();
+}
+
+TEST(ElementSpillStoreTest, WriteAndRead) {
+  ElementSpillStore store(Env::Default(), SpillDir("write_and_read"),
+                          /*max_file_bytes=*/1 << 20);
+  std::vector<ElementSpillStore::Handle> handles(10);
+  for (int64 i = 0; i < handles.size(); ++i) {
+    TF_ASSERT_OK(store.Write(MakeElement(i), &handles[i]));
+    EXPECT_TRUE(handles[i].valid());
+  }
+  EXPECT_EQ(1, store.NumFiles());
+  for (int64 i = handles.size() - 1; i >= 0; --i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(store.Read(handles[i], &element));
+    ExpectElement(i, element);
+    // Elements can be read more than once until they are released.
+    TF_ASSERT_OK(store.Read(handles[i], &element));
+    ExpectElement(i, element);
+  }
+}
+
+TEST(ElementSpillStoreTest, DeletesReleasedFiles) {
+  const std::string dir = SpillDir("deletes_released_files");
+  std::vector<ElementSpillStore::Handle> handles(20);
+  {
+    // Every element starts a new file.
+    ElementSpillStore store(Env::Default(), dir, /*max_file_bytes=*/1);
+    for (int64 i = 0; i < handles.size(); ++i) {
+      TF_ASSERT_OK(store.Write(MakeElement(i), &handles[i]));
+    }
+    EXPECT_EQ(20, store.NumFiles());
+    EXPECT_EQ(20, NumChildren(dir));
+
+    for (int64 i = 0; i < 10; ++i) {
+      store.Release(handles[i]);
+      std::vector<Tensor> element;
+      EXPECT_TRUE(errors::IsNotFound(store.Read(handles[i], &element)));
+    }
+    EXPECT_EQ(10, store.NumFiles());
+    EXPECT_EQ(10, NumChildren(dir));
+
+    // The file being written is kept until the store moves on to the next.
+    store.Release(handles[19]);
+    EXPECT_EQ(10, store.NumFiles());
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(store.Read(handles[10], &element));
+    ExpectElement(10, element);
+  }
+  EXPECT_EQ(0, NumChildren(dir));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,245 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/data/pipeline_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/stringprintf.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Calls `fn` for every node of the model in depth-first order starting from
+// the output node.
+template <typename Fn>
+void ForEachNode(const std::shared_ptr<model::Node>& node, int depth,
+                 const Fn& fn) {
+  if (!node) return;
+  fn(node, depth);
+  for (const auto& input : node->inputs()) {
+    ForEachNode(input, depth + 1, fn);
+  }
+}
+
+// Tracks the average number of buffered elements of each node.
+class BufferSampler {
+ public:
+  void Sample(const std::shared_ptr<model::Node>& output) {
+    mutex_lock l(mu_);
+    ForEachNode(output, /*depth=*/0,
+                [this](const std::shared_ptr<model::Node>& node, int depth) {
+                  Samples& samples = samples_[node->id()];
+                  samples.sum += node->buffered_elements();
+                  ++samples.count;
+                });
+  }
+
+  double Average(int64 node_id) const {
+    mutex_lock l(mu_);
+    auto it = samples_.find(node_id);
+    if (it == samples_.end() || it->second.count == 0) return 0;
+    return it->second.sum / it->second.count;
+  }
+
+ private:
+  struct Samples {
+    double sum = 0;
+    int64 count = 0;
+  };
+
+  mutable mutex mu_;
+  absl::flat_hash_map<int64, Samples> samples_ TF_GUARDED_BY(mu_);
+};
+
+PipelineStageStats MakeStageStats(const model::Node& node, int depth,
+                                  const BufferSampler& sampler) {
+  PipelineStageStats stats;
+  stats.name = node.long_name();
+  stats.depth = depth;
+  stats.num_elements = node.num_elements();
+  stats.self_time_ns = node.SelfProcessingTime();
+  if (node.has_parameter(model::kParallelism)) {
+    stats.parallelism =
+        std::max(1.0, node.parameter_value(model::kParallelism));
+  }
+  // Parallel stages buffer up to `parallelism` elements, unless they expose
+  // an explicit buffer size.
+  if (node.has_parameter(model::kBufferSize)) {
+    stats.buffer_capacity = node.parameter_value(model::kBufferSize);
+  } else if (node.has_parameter(model::kParallelism)) {
+    stats.buffer_capacity = stats.parallelism;
+  }
+  stats.buffered_elements = sampler.Average(node.id());
+  if (stats.buffer_capacity > 0) {
+    stats.buffer_utilization =
+        stats.buffered_elements / stats.buffer_capacity;
+  }
+  return stats;
+}
+
+}  // namespace
+
+Status RunPipelineBenchmark(const GraphDef& graph_def,
+                            const PipelineBenchmarkOptions& options,
+                            PipelineBenchmarkResult* result) {
+  if (options.num_consumer_threads < 1) {
+    return errors::InvalidArgument(
+        "num_consumer_threads must be positive, got ",
+        options.num_consumer_threads);
+  }
+  standalone::Dataset::Params params;
+  std::unique_ptr<standalone::Dataset> dataset;
+  TF_RETURN_IF_ERROR(
+      standalone::Dataset::FromGraph(params, graph_def, &dataset));
+  auto model = std::make_shared<model::Model>();
+  model->EnableResourceUsageCollection();
+  std::unique_ptr<standalone::Iterator> iterator;
+  TF_RETURN_IF_ERROR(dataset->MakeIterator(/*split_provider=*/nullptr, model,
+                                           &iterator));
+
+  std::atomic<int64> num_claimed(0);
+  std::atomic<bool> done(false);
+  mutex mu;
+  Status status;
+  int64 num_elements = 0;
+  int64 num_bytes = 0;
+  auto consume = [&]() {
+    int64 local_elements = 0;
+    int64 local_bytes = 0;
+    while (!done) {
+      if (options.num_elements >= 0 &&
+          num_claimed.fetch_add(1) >= options.num_elements) {
+        break;
+      }
+      std::vector<Tensor> outputs;
+      bool end_of_input = false;
+      Status s = iterator->GetNext(&outputs, &end_of_input);
+      if (!s.ok() || end_of_input) {
+        done = true;
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          status.Update(s);
+        }
+        break;
+      }
+      ++local_elements;
+      for (const Tensor& t : outputs) {
+        local_bytes += t.TotalBytes();
+      }
+    }
+    mutex_lock l(mu);
+    num_elements += local_elements;
+    num_bytes += local_bytes;
+  };
+
+  BufferSampler sampler;
+  Notification consumers_done;
+  Env* env = Env::Default();
+  std::unique_ptr<Thread> sampler_thread(env->StartThread(
+      {}, "tf_data_pipeline_benchmark_sampler", [&]() {
+        while (!WaitForNotificationWithTimeout(
+            &consumers_done,
+            options.sample_interval_ms * EnvTime::kMillisToMicros)) {
+          sampler.Sample(model->output());
+        }
+      }));
+
+  const uint64 start_us = env->NowMicros();
+  {
+    std::vector<std::unique_ptr<Thread>> consumers;
+    for (int i = 0; i < options.num_consumer_threads; ++i) {
+      consumers.emplace_back(env->StartThread(
+          {}, strings::StrCat("tf_data_pipeline_benchmark_consumer_", i),
+          consume));
+    }
+  }
+  const uint64 end_us = env->NowMicros();
+  consumers_done.Notify();
+  sampler_thread.reset();
+  TF_RETURN_IF_ERROR(status);
+
+  *result = PipelineBenchmarkResult();
+  result->num_elements = num_elements;
+  result->num_bytes = num_bytes;
+  result->wall_time_s = static_cast<double>(end_us - start_us) / 1e6;
+  if (result->wall_time_s > 0) {
+    result->elements_per_sec = num_elements / result->wall_time_s;
+    result->bytes_per_sec = num_bytes / result->wall_time_s;
+  }
+  double max_time_per_element = 0;
+  ForEachNode(model->output(), /*depth=*/0,
+              [&](const std::shared_ptr<model::Node>& node, int depth) {
+                result->stages.push_back(
+                    MakeStageStats(*node, depth, sampler));
+                const PipelineStageStats& stats = result->stages.back();
+                if (stats.num_elements == 0) return;
+                double time_per_element =
+                    stats.self_time_ns / stats.parallelism;
+                if (result->bottleneck == -1 ||
+                    time_per_element > max_time_per_element) {
+                  max_time_per_element = time_per_element;
+                  result->bottleneck = result->stages.size() - 1;
+                }
+              });
+  return Status::OK();
+}
+
+string FormatPipelineBenchmarkResult(const PipelineBenchmarkResult& result) {
+  string report = strings::Printf(
+      "Consumed %lld elements (%lld bytes) in %.3f s: %.1f elements/s, "
+      "%.1f bytes/s\n",
+      static_cast<long long>(result.num_elements),
+      static_cast<long long>(result.num_bytes), result.wall_time_s,
+      result.elements_per_sec, result.bytes_per_sec);
+  strings::StrAppend(&report,
+                     strings::Printf("  %-48s %10s %14s %8s %10s\n", "stage",
+                                     "elements", "self_time_us", "parallel",
+                                     "buffer_use"));
+  for (int i = 0; i < static_cast<int>(result.stages.size()); ++i) {
+    const PipelineStageStats& stage = result.stages[i];
+    string name = strings::StrCat(string(2 * stage.depth, ' '), stage.name);
+    string buffer_use =
+        stage.buffer_capacity > 0
+            ? strings::Printf("%.0f%%", 100 * stage.buffer_utilization)
+            : "-";
+    strings::StrAppend(
+        &report, i == result.bottleneck ? "* " : "  ",
+        strings::Printf("%-48s %10lld %14.2f %8.0f %10s\n", name.c_str(),
+                        static_cast<long long>(stage.num_elements),
+                        stage.self_time_ns / 1000, stage.parallelism,
+                        buffer_use.c_str()));
+  }
+  if (result.bottleneck >= 0) {
+    strings::StrAppend(&report, "Bottleneck: ",
+                       result.stages[result.bottleneck].name, "\n");
+  }
+  return report;
+}
+
+}  // namespace data
+}  // namespace tensorflow
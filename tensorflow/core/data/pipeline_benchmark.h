@@ -0,0 +1,97 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DATA_PIPELINE_BENCHMARK_H_
+#define TENSORFLOW_CORE_DATA_PIPELINE_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// Utilities for benchmarking a serialized tf.data input pipeline outside of a
+// training job. The pipeline is executed through the standalone API (see
+// `standalone.h`) with resource usage collection enabled, so that the
+// per-stage statistics of the tf.data performance model can be reported next
+// to the end-to-end throughput.
+//
+// Synthetic sources are expressed in the pipeline graph itself, e.g. by
+// serializing `tf.data.Dataset.range(n)` or
+// `tf.data.Dataset.from_tensors(x).repeat()` followed by the transformations
+// under test.
+
+struct PipelineBenchmarkOptions {
+  // Number of threads concurrently calling `GetNext` on the iterator.
+  int num_consumer_threads = 1;
+  // Total number of elements to consume, or -1 to consume until the end of
+  // the input.
+  int64 num_elements = -1;
+  // Interval at which the number of buffered elements of each stage is
+  // sampled.
+  int64 sample_interval_ms = 10;
+};
+
+// Statistics for a single stage (i.e. a `model::Node`) of the pipeline.
+struct PipelineStageStats {
+  string name;
+  // Depth of the stage in the pipeline, with 0 being the output stage.
+  int depth = 0;
+  int64 num_elements = 0;
+  // Average time spent producing an element in this stage, excluding the time
+  // spent in its inputs.
+  double self_time_ns = 0;
+  // Parallelism of the stage, or 1 if the stage is not parallel.
+  double parallelism = 1;
+  // Average number of elements buffered by the stage.
+  double buffered_elements = 0;
+  // Capacity of the buffer of the stage, or 0 if the stage has no buffer.
+  double buffer_capacity = 0;
+  // Ratio of `buffered_elements` to `buffer_capacity`, or 0 if the stage has
+  // no buffer.
+  double buffer_utilization = 0;
+};
+
+struct PipelineBenchmarkResult {
+  int64 num_elements = 0;
+  int64 num_bytes = 0;
+  double wall_time_s = 0;
+  double elements_per_sec = 0;
+  double bytes_per_sec = 0;
+  // Stages in depth-first order starting from the output stage.
+  std::vector<PipelineStageStats> stages;
+  // Index into `stages` of the stage with the highest self time per unit of
+  // parallelism, or -1 if no stage produced an element.
+  int bottleneck = -1;
+};
+
+// Runs the input pipeline produced by `graph_def` and stores its throughput
+// and per-stage statistics in `result`.
+Status RunPipelineBenchmark(const GraphDef& graph_def,
+                            const PipelineBenchmarkOptions& options,
+                            PipelineBenchmarkResult* result);
+
+// Returns a human-readable report of `result`, with the bottleneck stage
+// flagged.
+string FormatPipelineBenchmarkResult(const PipelineBenchmarkResult& result);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_PIPELINE_BENCHMARK_H_
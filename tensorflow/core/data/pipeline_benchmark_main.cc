@@ -0,0 +1,72 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks a serialized tf.data input pipeline and reports its throughput
+// together with per-stage statistics of the tf.data performance model.
+//
+// The input is a `GraphDef` (binary or text format) whose `_Retval` node
+// produces the dataset variant, e.g. obtained from
+// `tf.data.Dataset._as_serialized_graph()`. Synthetic sources such as
+// `tf.data.Dataset.range(n)` or `tf.data.Dataset.from_tensors(x).repeat()` can
+// stand in for real data by serializing them in front of the transformations
+// under test.
+//
+// Usage:
+//   pipeline_benchmark --graph=/tmp/dataset.pb --num_consumer_threads=4
+
+#include <iostream>
+#include <vector>
+
+#include "tensorflow/core/data/pipeline_benchmark.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+int main(int argc, char** argv) {
+  tensorflow::string graph_path;
+  tensorflow::data::PipelineBenchmarkOptions options;
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("graph", &graph_path,
+                       "Path to the serialized dataset GraphDef."),
+      tensorflow::Flag("num_consumer_threads", &options.num_consumer_threads,
+                       "Number of threads concurrently consuming elements."),
+      tensorflow::Flag("num_elements", &options.num_elements,
+                       "Number of elements to consume, or -1 to consume "
+                       "until the end of the input."),
+      tensorflow::Flag("sample_interval_ms", &options.sample_interval_ms,
+                       "Interval at which stage buffers are sampled.")};
+  std::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
+  bool parsed_values_ok = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  if (!parsed_values_ok || graph_path.empty()) {
+    std::cerr << usage << std::endl;
+    return 2;
+  }
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+
+  tensorflow::GraphDef graph_def;
+  tensorflow::Status s = tensorflow::ReadTextOrBinaryProto(
+      tensorflow::Env::Default(), graph_path, &graph_def);
+  if (s.ok()) {
+    tensorflow::data::PipelineBenchmarkResult result;
+    s = tensorflow::data::RunPipelineBenchmark(graph_def, options, &result);
+    if (s.ok()) {
+      std::cout << tensorflow::data::FormatPipelineBenchmarkResult(result);
+      return 0;
+    }
+  }
+  std::cerr << s << std::endl;
+  return 1;
+}
@@ -0,0 +1,157 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/data/pipeline_benchmark.h"
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// range(10)
+constexpr const char* const kRangeGraphProto = R"proto(
+  node {
+    name: "Const/_0"
+    op: "Const"
+    attr {
+      key: "dtype"
+      value { type: DT_INT64 }
+    }
+    attr {
+      key: "value"
+      value {
+        tensor {
+          dtype: DT_INT64
+          tensor_shape {}
+          int64_val: 0
+        }
+      }
+    }
+  }
+  node {
+    name: "Const/_1"
+    op: "Const"
+    attr {
+      key: "dtype"
+      value { type: DT_INT64 }
+    }
+    attr {
+      key: "value"
+      value {
+        tensor {
+          dtype: DT_INT64
+          tensor_shape {}
+          int64_val: 10
+        }
+      }
+    }
+  }
+  node {
+    name: "Const/_2"
+    op: "Const"
+    attr {
+      key: "dtype"
+      value { type: DT_INT64 }
+    }
+    attr {
+      key: "value"
+      value {
+        tensor {
+          dtype: DT_INT64
+          tensor_shape {}
+          int64_val: 1
+        }
+      }
+    }
+  }
+  node {
+    name: "RangeDataset/_3"
+    op: "RangeDataset"
+    input: "Const/_0"
+    input: "Const/_1"
+    input: "Const/_2"
+    attr {
+      key: "output_shapes"
+      value { list { shape {} } }
+    }
+    attr {
+      key: "output_types"
+      value { list { type: DT_INT64 } }
+    }
+  }
+  node {
+    name: "dataset"
+    op: "_Retval"
+    input: "RangeDataset/_3"
+    attr {
+      key: "T"
+      value { type: DT_VARIANT }
+    }
+    attr {
+      key: "index"
+      value { i: 0 }
+    }
+  }
+  library {}
+  versions { producer: 96 }
+)proto";
+
+GraphDef RangeGraph() {
+  GraphDef graph_def;
+  protobuf::TextFormat::ParseFromString(kRangeGraphProto, &graph_def);
+  return graph_def;
+}
+
+TEST(PipelineBenchmarkTest, ConsumesEntireInput) {
+  PipelineBenchmarkOptions options;
+  PipelineBenchmarkResult result;
+  TF_ASSERT_OK(RunPipelineBenchmark(RangeGraph(), options, &result));
+  EXPECT_EQ(result.num_elements, 10);
+  EXPECT_EQ(result.num_bytes, 10 * static_cast<int64>(sizeof(int64)));
+  ASSERT_EQ(result.stages.size(), 1);
+  EXPECT_EQ(result.stages[0].depth, 0);
+  EXPECT_EQ(result.stages[0].num_elements, 10);
+  EXPECT_EQ(result.stages[0].parallelism, 1);
+  EXPECT_EQ(result.stages[0].buffer_capacity, 0);
+  EXPECT_EQ(result.bottleneck, 0);
+  EXPECT_NE(FormatPipelineBenchmarkResult(result).find("Bottleneck"),
+            string::npos);
+}
+
+TEST(PipelineBenchmarkTest, ConsumesRequestedElements) {
+  PipelineBenchmarkOptions options;
+  options.num_consumer_threads = 4;
+  options.num_elements = 5;
+  PipelineBenchmarkResult result;
+  TF_ASSERT_OK(RunPipelineBenchmark(RangeGraph(), options, &result));
+  EXPECT_EQ(result.num_elements, 5);
+}
+
+TEST(PipelineBenchmarkTest, InvalidConsumerThreads) {
+  PipelineBenchmarkOptions options;
+  options.num_consumer_threads = 0;
+  PipelineBenchmarkResult result;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      RunPipelineBenchmark(RangeGraph(), options, &result)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/grpc_util.h"
+#include "tensorflow/core/data/service/shm_transfer.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -389,8 +390,24 @@ Status DataServiceWorkerClient::EnsureInitialized() {
   if (client_) {
     return Status::OK();
   }
+  std::string address = address_;
+  int64 segment_id;
+  if (transfer_protocol_ == "grpc" &&
+      ParseShmTransferAddress(address_, &address, &segment_id) &&
+      IsLocalAddress(address)) {
+    // The worker also serves co-located clients through shared memory; fall
+    // back to gRPC if its segment is not usable from this process.
+    Status s = DataTransferClient::Build(
+        kShmTransferProtocol,
+        {protocol_, absl::StrCat("localhost:", segment_id)}, &client_);
+    if (s.ok()) {
+      return Status::OK();
+    }
+    VLOG(1) << "Not using shared memory to read from " << address << ": "
+            << s;
+  }
   TF_RETURN_IF_ERROR(DataTransferClient::Build(
-      transfer_protocol_, {protocol_, address_}, &client_));
+      transfer_protocol_, {protocol_, address}, &client_));
   return Status::OK();
 }
 
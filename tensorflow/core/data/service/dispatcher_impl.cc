@@ -224,7 +224,9 @@ Status DataServiceDispatcherImpl::FindNewTasks(
     const std::string& worker_address,
     const absl::flat_hash_set<int64>& current_tasks,
     std::vector<std::shared_ptr<const Task>>& assigned_tasks,
-    WorkerHeartbeatResponse* response) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    WorkerHeartbeatResponse* response,
+    std::vector<std::pair<TaskDef*, std::shared_ptr<const DatasetDef>>>&
+        dataset_defs) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   // Check for round-robin jobs that had tasks on the worker removed. Now that
   // the worker is back, we create a new pending task for the worker.
   absl::flat_hash_set<int64> assigned_job_ids;
@@ -253,7 +255,7 @@ Status DataServiceDispatcherImpl::FindNewTasks(
     if (config_.work_dir().empty()) {
       std::shared_ptr<const DatasetDef> dataset_def;
       TF_RETURN_IF_ERROR(dataset_store_->Get(dataset_key, dataset_def));
-      *task_def->mutable_dataset_def() = *dataset_def;
+      dataset_defs.emplace_back(task_def, std::move(dataset_def));
     } else {
       std::string path =
           io::JoinPath(DatasetsDir(config_.work_dir()), dataset_key);
@@ -277,31 +279,41 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
   TF_RETURN_IF_ERROR(CheckStarted());
   VLOG(4) << "Received worker heartbeat request from worker "
           << request->worker_address();
-  mutex_lock l(mu_);
   const std::string& worker_address = request->worker_address();
-  // Assigned tasks from the perspective of the dispatcher.
-  std::vector<std::shared_ptr<const Task>> assigned_tasks;
-  Status s = state_.TasksForWorker(worker_address, assigned_tasks);
-  if (!s.ok()) {
-    if (!errors::IsNotFound(s)) {
-      return s;
-    }
-    VLOG(1) << "Registering new worker at address " << worker_address;
-    Update update;
-    update.mutable_register_worker()->set_worker_address(worker_address);
-    update.mutable_register_worker()->set_transfer_address(
-        request->transfer_address());
-    TF_RETURN_IF_ERROR(Apply(update));
-    TF_RETURN_IF_ERROR(CreateTasksForWorker(worker_address));
-    TF_RETURN_IF_ERROR(state_.TasksForWorker(worker_address, assigned_tasks));
-  }
   absl::flat_hash_set<int64> current_tasks;
   current_tasks.insert(request->current_tasks().cbegin(),
                        request->current_tasks().cend());
-  TF_RETURN_IF_ERROR(
-      FindTasksToDelete(current_tasks, assigned_tasks, response));
-  TF_RETURN_IF_ERROR(
-      FindNewTasks(worker_address, current_tasks, assigned_tasks, response));
+  std::vector<std::pair<TaskDef*, std::shared_ptr<const DatasetDef>>>
+      dataset_defs;
+  {
+    mutex_lock l(mu_);
+    // Assigned tasks from the perspective of the dispatcher.
+    std::vector<std::shared_ptr<const Task>> assigned_tasks;
+    Status s = state_.TasksForWorker(worker_address, assigned_tasks);
+    if (!s.ok()) {
+      if (!errors::IsNotFound(s)) {
+        return s;
+      }
+      VLOG(1) << "Registering new worker at address " << worker_address;
+      Update update;
+      update.mutable_register_worker()->set_worker_address(worker_address);
+      update.mutable_register_worker()->set_transfer_address(
+          request->transfer_address());
+      TF_RETURN_IF_ERROR(Apply(update));
+      TF_RETURN_IF_ERROR(CreateTasksForWorker(worker_address));
+      TF_RETURN_IF_ERROR(state_.TasksForWorker(worker_address, assigned_tasks));
+    }
+    TF_RETURN_IF_ERROR(
+        FindTasksToDelete(current_tasks, assigned_tasks, response));
+    TF_RETURN_IF_ERROR(FindNewTasks(worker_address, current_tasks,
+                                    assigned_tasks, response, dataset_defs));
+  }
+  // Dataset definitions are immutable once stored and may be large, so copy
+  // them into the response without holding `mu_`.
+  for (auto& task_def_and_dataset_def : dataset_defs) {
+    *task_def_and_dataset_def.first->mutable_dataset_def() =
+        *task_def_and_dataset_def.second;
+  }
 
   VLOG(4) << "Finished worker heartbeat for worker at address "
           << request->worker_address();
@@ -744,6 +756,7 @@ Status DataServiceDispatcherImpl::AssignTask(std::shared_ptr<const Task> task)
   task_def->set_dataset_id(task->job->dataset_id);
   task_def->set_job_id(task->job->job_id);
   task_def->set_worker_address(task->worker_address);
+  std::shared_ptr<const DatasetDef> dataset_def;
   {
     mutex_lock l(mu_);
     std::shared_ptr<const Dataset> dataset;
@@ -751,15 +764,16 @@ Status DataServiceDispatcherImpl::AssignTask(std::shared_ptr<const Task> task)
     std::string dataset_key =
         DatasetKey(dataset->dataset_id, dataset->fingerprint);
     if (config_.work_dir().empty()) {
-      std::shared_ptr<const DatasetDef> dataset_def;
       TF_RETURN_IF_ERROR(dataset_store_->Get(dataset_key, dataset_def));
-      *task_def->mutable_dataset_def() = *dataset_def;
     } else {
       std::string path =
           io::JoinPath(DatasetsDir(config_.work_dir()), dataset_key);
       task_def->set_path(path);
     }
   }
+  if (dataset_def) {
+    *task_def->mutable_dataset_def() = *dataset_def;
+  }
   task_def->set_task_id(task->task_id);
   task_def->set_processing_mode(ProcessingModeDef(task->job->processing_mode));
   if (task->job->num_consumers.has_value()) {
@@ -878,8 +892,7 @@ Status DataServiceDispatcherImpl::GetWorkers(const GetWorkersRequest* request,
 }
 
 Status DataServiceDispatcherImpl::CheckStarted() TF_LOCKS_EXCLUDED(mu_) {
-  mutex_lock l(mu_);
-  if (!started_) {
+  if (!started_.load(std::memory_order_acquire)) {
     return errors::Unavailable("Dispatcher has not started yet.");
   }
   return Status::OK();
@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_DISPATCHER_IMPL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_DISPATCHER_IMPL_H_
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_service.h"
@@ -189,12 +193,16 @@ class DataServiceDispatcherImpl {
           assigned_tasks,
       WorkerHeartbeatResponse* response);
   // Finds new tasks that should be assigned to a worker and adds them to
-  // the heartbeat response.
+  // the heartbeat response. Dataset definitions for the new tasks are not
+  // copied into the response; instead they are added to `dataset_defs` so
+  // that the caller can copy them after releasing `mu_`.
   Status FindNewTasks(
       const std::string& worker_address,
       const absl::flat_hash_set<int64>& current_tasks,
       std::vector<std::shared_ptr<const DispatcherState::Task>>& assigned_tasks,
-      WorkerHeartbeatResponse* response);
+      WorkerHeartbeatResponse* response,
+      std::vector<std::pair<TaskDef*, std::shared_ptr<const DatasetDef>>>&
+          dataset_defs);
   // Acquires a job client id to read from the given job and sets
   // `job_client_id`.
   Status AcquireJobClientId(
@@ -267,7 +275,9 @@ class DataServiceDispatcherImpl {
   Env* env_;
 
   mutex mu_;
-  bool started_ TF_GUARDED_BY(mu_) = false;
+  // Only written under `mu_`, but read without it so that every RPC does not
+  // need to acquire `mu_` just to check whether the dispatcher has started.
+  std::atomic<bool> started_{false};
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
 
   // Cached worker stubs for communicating with workers.
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/grpc_dispatcher_impl.h"
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/grpc_worker_impl.h"
+#include "tensorflow/core/data/service/shm_transfer.h"
 #include "tensorflow/core/platform/errors.h"
 
 namespace tensorflow {
@@ -122,7 +123,11 @@ WorkerGrpcDataServer::WorkerGrpcDataServer(
     : GrpcDataServerBase(config.port(), config.protocol(), "WorkerServer"),
       config_(config) {}
 
-WorkerGrpcDataServer::~WorkerGrpcDataServer() { delete service_; }
+WorkerGrpcDataServer::~WorkerGrpcDataServer() {
+  // The transfer server calls into `service_`.
+  transfer_server_.reset();
+  delete service_;
+}
 
 void WorkerGrpcDataServer::AddDataServiceToBuilder(
     ::grpc::ServerBuilder& builder) {
@@ -149,12 +154,32 @@ Status WorkerGrpcDataServer::StartServiceInternal() {
         config_.data_transfer_address(), kPortPlaceholder,
         absl::StrCat(transfer_server_->get_port()),
         /*replace_all=*/false);
+  } else if (ShmTransferEnabled()) {
+    // Clients on this host find the segment through the id advertised in the
+    // transfer address and read from it instead of going through gRPC.
+    transfer_server_ = std::make_shared<ShmDataTransferServer>(
+        service_->get_element_getter());
+    Status s = transfer_server_->Start();
+    if (s.ok()) {
+      LOG(INFO) << "Shared-memory data transfer server started with segment "
+                << transfer_server_->get_port();
+      transfer_address =
+          ShmTransferAddress(worker_address, transfer_server_->get_port());
+    } else {
+      LOG(WARNING) << "Failed to start the shared-memory data transfer "
+                      "server; local clients will use gRPC: "
+                   << s;
+      transfer_server_.reset();
+    }
   }
   TF_RETURN_IF_ERROR(service_->Start(worker_address, transfer_address));
   return Status::OK();
 }
 
-void WorkerGrpcDataServer::StopServiceInternal() { service_->Stop(); }
+void WorkerGrpcDataServer::StopServiceInternal() {
+  service_->Stop();
+  transfer_server_.reset();
+}
 
 Status WorkerGrpcDataServer::NumTasks(int* num_tasks) {
   GetWorkerTasksRequest req;
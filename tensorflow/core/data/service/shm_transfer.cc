@@ -0,0 +1,781 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shm_transfer.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+
+// Separates the gRPC address of a worker from the id of its shared memory
+// segment in the transfer address it advertises.
+constexpr char kShmAddressSeparator[] = ";shm=";
+
+// Parses the segment id out of a "host:port" transfer address.
+Status ParseSegmentId(absl::string_view address, int64* segment_id) {
+  const size_t colon = address.rfind(':');
+  if (colon == absl::string_view::npos ||
+      !absl::SimpleAtoi(address.substr(colon + 1), segment_id) ||
+      *segment_id < 0) {
+    return errors::InvalidArgument(
+        "Expected a shared-memory transfer address of the form host:port, "
+        "but got ",
+        address);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+bool ShmTransferEnabled() {
+  bool enabled;
+  Status s = ReadBoolFromEnvVar("TF_DATA_SERVICE_SHM_TRANSFER",
+                                /*default_val=*/false, &enabled);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return false;
+  }
+  return enabled;
+}
+
+bool IsLocalAddress(absl::string_view address) {
+  const size_t colon = address.rfind(':');
+  if (colon == absl::string_view::npos) {
+    return false;
+  }
+  absl::string_view host = address.substr(0, colon);
+  if (absl::ConsumePrefix(&host, "[")) {
+    absl::ConsumeSuffix(&host, "]");
+  }
+  return host == "localhost" || host == "127.0.0.1" || host == "::1" ||
+         host == port::Hostname();
+}
+
+std::string ShmTransferAddress(absl::string_view grpc_address,
+                               int64 segment_id) {
+  return absl::StrCat(grpc_address, kShmAddressSeparator, segment_id);
+}
+
+bool ParseShmTransferAddress(absl::string_view transfer_address,
+                             std::string* grpc_address, int64* segment_id) {
+  const size_t separator = transfer_address.rfind(kShmAddressSeparator);
+  if (separator == absl::string_view::npos ||
+      !absl::SimpleAtoi(
+          transfer_address.substr(separator + strlen(kShmAddressSeparator)),
+          segment_id) ||
+      *segment_id < 0) {
+    *grpc_address = std::string(transfer_address);
+    return false;
+  }
+  *grpc_address = std::string(transfer_address.substr(0, separator));
+  return true;
+}
+
+#if defined(__linux__)
+
+namespace {
+
+constexpr uint64 kMagic = 0x5446444154415348ull;  // "TFDATASH"
+constexpr int kNumSlots = 64;
+constexpr size_t kMaxRequestBytes = 4032;
+constexpr size_t kAlignment = 64;
+constexpr size_t kMinDataSegmentBytes = 1 << 20;
+constexpr int64 kWaitTimeoutMicros = 100 * 1000;
+constexpr int64 kReapIntervalMicros = 1000 * 1000;
+constexpr int kMaxStartAttempts = 8;
+
+// Slot states.
+constexpr uint32 kFree = 0;       // Not claimed by any client.
+constexpr uint32 kIdle = 1;       // Claimed, no outstanding request.
+constexpr uint32 kRequest = 2;    // A request is waiting to be served.
+constexpr uint32 kResponse = 3;   // The response is in the data segment.
+constexpr uint32 kAbandoned = 4;  // The client left during a request.
+
+// The state word of a slot holds the pid of the client that claimed it next
+// to the slot state, so that claiming a slot publishes its owner atomically
+// and the server never frees a slot on behalf of an earlier, dead owner.
+// Linux pids are below 2^22.
+constexpr int kStateBits = 3;
+constexpr uint32 kStateMask = (1u << kStateBits) - 1;
+
+uint32 SlotWord(int32 pid, uint32 state) {
+  return (static_cast<uint32>(pid) << kStateBits) | state;
+}
+uint32 StateOf(uint32 word) { return word & kStateMask; }
+int32 PidOf(uint32 word) { return static_cast<int32>(word >> kStateBits); }
+
+static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32),
+              "Slot state words are used as futex words.");
+
+struct alignas(kAlignment) Slot {
+  // See SlotWord(). kFree is 0 regardless of the pid.
+  std::atomic<uint32> state;
+  // Generation of the slot's data segment that holds the response.
+  uint32 data_generation;
+  uint32 request_size;
+  uint64 response_size;
+  char request[kMaxRequestBytes];
+};
+
+struct ControlSegment {
+  std::atomic<uint64> magic;
+  int32 server_pid;
+  std::atomic<uint32> shutdown;
+  std::atomic<uint32> doorbell;
+  Slot slots[kNumSlots];
+};
+
+// Layout of a response in a data segment: a ResponseHeader followed by the
+// status message, then for each component a ComponentHeader, its metadata and
+// its data. Each of the three parts starts at a multiple of kAlignment.
+struct ResponseHeader {
+  int32 code;
+  uint32 num_components;
+  uint64 message_size;
+  int64 element_index;
+  uint8 end_of_sequence;
+  uint8 skip;
+};
+
+// Component kinds.
+//   kRawTensor: metadata is a TensorProto without content, data holds the
+//     tensor buffer.
+//   kTensorProto: metadata is a TensorProto with content, data is empty.
+//   kCompressed: metadata is a CompressedElement, data is empty.
+constexpr uint32 kRawTensor = 0;
+constexpr uint32 kTensorProto = 1;
+constexpr uint32 kCompressed = 2;
+
+struct ComponentHeader {
+  uint32 kind;
+  uint64 metadata_size;
+  uint64 data_size;
+};
+
+size_t Align(size_t n) { return (n + kAlignment - 1) & ~(kAlignment - 1); }
+
+std::string SegmentName(int64 segment_id) {
+  return absl::StrCat("/tf_data_shm_", segment_id);
+}
+
+std::string DataSegmentName(int64 segment_id, int index, uint32 generation) {
+  return absl::StrCat("/tf_data_shm_", segment_id, "_", index, "_",
+                      generation);
+}
+
+void FutexWait(std::atomic<uint32>* word, uint32 expected,
+               int64 timeout_micros) {
+  struct timespec timeout;
+  timeout.tv_sec = timeout_micros / 1000000;
+  timeout.tv_nsec = (timeout_micros % 1000000) * 1000;
+  syscall(SYS_futex, reinterpret_cast<uint32*>(word), FUTEX_WAIT, expected,
+          &timeout, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32*>(word), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+bool ProcessAlive(int32 pid) { return kill(pid, 0) == 0 || errno == EPERM; }
+
+// Maps the shared memory segment `name`. If `create` is true, the segment is
+// created with `*size` bytes, which are reserved up front so that running out
+// of shared memory is reported here instead of as SIGBUS on first access.
+// Otherwise `*size` is set to the size of the existing segment.
+Status MapSegment(const std::string& name, bool create, size_t* size,
+                  char** base) {
+  const int fd = create ? shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL,
+                                   S_IRUSR | S_IWUSR)
+                        : shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return errors::Unavailable("Failed to open shared memory segment ", name,
+                               ": ", strerror(errno));
+  }
+  Status status;
+  if (create) {
+    const int error = posix_fallocate(fd, 0, *size);
+    if (error != 0) {
+      status = errors::ResourceExhausted("Failed to allocate ", *size,
+                                         " bytes of shared memory for ", name,
+                                         ": ", strerror(error));
+    }
+  } else {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      status = errors::Unavailable("Failed to stat shared memory segment ",
+                                   name, ": ", strerror(errno));
+    } else {
+      *size = st.st_size;
+    }
+  }
+  if (status.ok()) {
+    void* address =
+        mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+      status = errors::Unavailable("Failed to map shared memory segment ",
+                                   name, ": ", strerror(errno));
+    } else {
+      *base = static_cast<char*>(address);
+    }
+  }
+  close(fd);
+  if (!status.ok() && create) {
+    shm_unlink(name.c_str());
+  }
+  return status;
+}
+
+class ShmDataTransferClient : public DataTransferClient {
+ public:
+  static Status Create(absl::string_view address,
+                       std::unique_ptr<DataTransferClient>* out) {
+    int64 segment_id;
+    TF_RETURN_IF_ERROR(ParseSegmentId(address, &segment_id));
+    const std::string name = SegmentName(segment_id);
+    size_t size;
+    char* base;
+    TF_RETURN_IF_ERROR(MapSegment(name, /*create=*/false, &size, &base));
+    auto* segment = reinterpret_cast<ControlSegment*>(base);
+    if (size != sizeof(ControlSegment) ||
+        segment->magic.load(std::memory_order_acquire) != kMagic ||
+        segment->shutdown.load(std::memory_order_acquire) != 0 ||
+        !ProcessAlive(segment->server_pid)) {
+      munmap(base, size);
+      return errors::Unavailable("No shared-memory transfer server at ", name);
+    }
+    const int32 pid = getpid();
+    for (int i = 0; i < kNumSlots; ++i) {
+      Slot& slot = segment->slots[i];
+      uint32 expected = kFree;
+      if (slot.state.compare_exchange_strong(expected, SlotWord(pid, kIdle),
+                                             std::memory_order_acq_rel)) {
+        *out = absl::WrapUnique(
+            new ShmDataTransferClient(segment_id, segment, i, pid));
+        return Status::OK();
+      }
+    }
+    munmap(base, size);
+    return errors::ResourceExhausted("All ", kNumSlots,
+                                     " client slots of shared memory segment ",
+                                     name, " are in use.");
+  }
+
+  ~ShmDataTransferClient() override {
+    Slot& slot = segment_->slots[index_];
+    uint32 expected = SlotWord(pid_, kRequest);
+    // If a request is still pending, the server frees the slot once it is done
+    // with it, or once it sees the slot if it never dispatched the request.
+    if (!slot.state.compare_exchange_strong(expected,
+                                            SlotWord(pid_, kAbandoned),
+                                            std::memory_order_acq_rel)) {
+      slot.state.store(kFree, std::memory_order_release);
+    }
+    if (data_ != nullptr) {
+      munmap(data_, data_size_);
+    }
+    munmap(segment_, sizeof(ControlSegment));
+  }
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    mutex_lock l(mu_);
+    if (cancelled_.load(std::memory_order_acquire)) {
+      return errors::Cancelled("Client was cancelled.");
+    }
+    Slot& slot = segment_->slots[index_];
+    const size_t request_size = req.ByteSizeLong();
+    if (request_size > kMaxRequestBytes) {
+      return errors::InvalidArgument("GetElementRequest of ", request_size,
+                                     " bytes exceeds the maximum of ",
+                                     kMaxRequestBytes, " bytes.");
+    }
+    req.SerializeToArray(slot.request, request_size);
+    slot.request_size = request_size;
+    const uint32 request_word = SlotWord(pid_, kRequest);
+    slot.state.store(request_word, std::memory_order_release);
+    segment_->doorbell.fetch_add(1, std::memory_order_acq_rel);
+    FutexWake(&segment_->doorbell);
+
+    while (slot.state.load(std::memory_order_acquire) == request_word) {
+      FutexWait(&slot.state, request_word, kWaitTimeoutMicros);
+      if (cancelled_.load(std::memory_order_acquire)) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+      if (segment_->shutdown.load(std::memory_order_acquire) != 0 ||
+          !ProcessAlive(segment_->server_pid)) {
+        return errors::Unavailable(
+            "The tf.data service worker serving shared memory segment ",
+            SegmentName(segment_id_), " has shut down.");
+      }
+    }
+
+    Status status = MapDataSegment(slot.data_generation);
+    if (status.ok()) {
+      status = ReadResponse(slot.response_size, result);
+    }
+    slot.state.store(SlotWord(pid_, kIdle), std::memory_order_release);
+    return status;
+  }
+
+  void TryCancel() override {
+    cancelled_.store(true, std::memory_order_release);
+    FutexWake(&segment_->slots[index_].state);
+  }
+
+ private:
+  ShmDataTransferClient(int64 segment_id, ControlSegment* segment, int index,
+                        int32 pid)
+      : segment_id_(segment_id), segment_(segment), index_(index), pid_(pid) {}
+
+  // Maps the data segment of the current response, unless it already is.
+  Status MapDataSegment(uint32 generation) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (data_ != nullptr && data_generation_ == generation) {
+      return Status::OK();
+    }
+    if (data_ != nullptr) {
+      munmap(data_, data_size_);
+      data_ = nullptr;
+    }
+    TF_RETURN_IF_ERROR(
+        MapSegment(DataSegmentName(segment_id_, index_, generation),
+                   /*create=*/false, &data_size_, &data_));
+    data_generation_ = generation;
+    return Status::OK();
+  }
+
+  Status ReadResponse(size_t size, GetElementResult& result)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto corrupt = [this]() {
+      return errors::Internal("Corrupt response in shared memory segment ",
+                              SegmentName(segment_id_));
+    };
+    if (size < sizeof(ResponseHeader) || size > data_size_) {
+      return corrupt();
+    }
+    ResponseHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    size_t offset = sizeof(header);
+    if (header.message_size > size - offset) {
+      return corrupt();
+    }
+    if (header.code != error::OK) {
+      return Status(static_cast<error::Code>(header.code),
+                    std::string(data_ + offset, header.message_size));
+    }
+    offset = Align(offset + header.message_size);
+    result.components.clear();
+    result.element_index = header.element_index;
+    result.end_of_sequence = header.end_of_sequence;
+    result.skip = header.skip;
+    for (uint32 i = 0; i < header.num_components; ++i) {
+      if (offset > size || size - offset < sizeof(ComponentHeader)) {
+        return corrupt();
+      }
+      ComponentHeader component;
+      std::memcpy(&component, data_ + offset, sizeof(component));
+      offset += sizeof(component);
+      if (component.metadata_size > size - offset) {
+        return corrupt();
+      }
+      const char* metadata = data_ + offset;
+      offset = Align(offset + component.metadata_size);
+      if (offset > size || component.data_size > size - offset) {
+        return corrupt();
+      }
+      const char* data = data_ + offset;
+      offset += Align(component.data_size);
+
+      switch (component.kind) {
+        case kRawTensor: {
+          TensorProto proto;
+          if (!proto.ParseFromArray(metadata, component.metadata_size) ||
+              !DataTypeCanUseMemcpy(proto.dtype()) ||
+              !TensorShape::IsValid(proto.tensor_shape())) {
+            return corrupt();
+          }
+          Tensor tensor(proto.dtype(), TensorShape(proto.tensor_shape()));
+          if (tensor.TotalBytes() != component.data_size) {
+            return corrupt();
+          }
+          std::memcpy(tensor.data(), data, component.data_size);
+          result.components.push_back(std::move(tensor));
+          break;
+        }
+        case kTensorProto: {
+          TensorProto proto;
+          result.components.emplace_back();
+          if (!proto.ParseFromArray(metadata, component.metadata_size) ||
+              !result.components.back().FromProto(proto)) {
+            return errors::Internal("Failed to parse tensor.");
+          }
+          break;
+        }
+        case kCompressed: {
+          CompressedElement compressed;
+          if (!compressed.ParseFromArray(metadata, component.metadata_size)) {
+            return corrupt();
+          }
+          Tensor tensor(DT_VARIANT, TensorShape{});
+          tensor.scalar<Variant>()() = std::move(compressed);
+          result.components.push_back(std::move(tensor));
+          break;
+        }
+        default:
+          return corrupt();
+      }
+    }
+    return Status::OK();
+  }
+
+  const int64 segment_id_;
+  ControlSegment* const segment_;
+  const int index_;
+  const int32 pid_;
+  std::atomic<bool> cancelled_{false};
+  // Serializes requests, since the slot holds one request at a time.
+  mutex mu_;
+  char* data_ TF_GUARDED_BY(mu_) = nullptr;
+  size_t data_size_ TF_GUARDED_BY(mu_) = 0;
+  uint32 data_generation_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+struct ShmDataTransferServer::Segment : public ControlSegment {};
+
+struct ShmDataTransferServer::DataSegment {
+  ~DataSegment() {
+    if (base != nullptr) {
+      munmap(base, capacity);
+      shm_unlink(name.c_str());
+    }
+  }
+
+  std::string name;
+  char* base = nullptr;
+  size_t capacity = 0;
+  // Generation 0 is never mapped, so that clients always map the first one.
+  uint32 generation = 0;
+};
+
+ShmDataTransferServer::ShmDataTransferServer(GetElementT get_element,
+                                             int64 segment_id)
+    : get_element_(std::move(get_element)), segment_id_(segment_id) {}
+
+ShmDataTransferServer::~ShmDataTransferServer() {
+  if (segment_ == nullptr) {
+    return;
+  }
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+  }
+  segment_->shutdown.store(1, std::memory_order_release);
+  segment_->doorbell.fetch_add(1, std::memory_order_acq_rel);
+  FutexWake(&segment_->doorbell);
+  for (Slot& slot : segment_->slots) {
+    FutexWake(&slot.state);
+  }
+  dispatch_thread_.reset();
+  thread_pool_.reset();
+  data_segments_.clear();
+  munmap(segment_, sizeof(ControlSegment));
+  shm_unlink(name_.c_str());
+}
+
+Status ShmDataTransferServer::Start() {
+  if (segment_ != nullptr) {
+    return errors::FailedPrecondition(
+        "The shared-memory transfer server has already been started.");
+  }
+  size_t size = sizeof(ControlSegment);
+  char* base = nullptr;
+  Status status;
+  if (segment_id_ >= 0) {
+    name_ = SegmentName(segment_id_);
+    status = MapSegment(name_, /*create=*/true, &size, &base);
+  } else {
+    for (int attempt = 0; attempt < kMaxStartAttempts; ++attempt) {
+      segment_id_ = (1 << 16) + random::New64() % (1 << 30);
+      name_ = SegmentName(segment_id_);
+      status = MapSegment(name_, /*create=*/true, &size, &base);
+      if (status.ok()) break;
+    }
+  }
+  TF_RETURN_IF_ERROR(status);
+
+  segment_ = new (base) Segment();
+  segment_->server_pid = getpid();
+  segment_->magic.store(kMagic, std::memory_order_release);
+  for (int i = 0; i < kNumSlots; ++i) {
+    data_segments_.push_back(absl::make_unique<DataSegment>());
+  }
+  {
+    mutex_lock l(mu_);
+    in_flight_.assign(kNumSlots, false);
+  }
+  // Requests may block until their element is produced, so every slot gets a
+  // thread to avoid one slow task delaying the others.
+  thread_pool_ = absl::make_unique<thread::ThreadPool>(
+      Env::Default(), "tf_data_shm_transfer", kNumSlots);
+  dispatch_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+      {}, "tf_data_shm_dispatch", [this]() { DispatchLoop(); }));
+  return Status::OK();
+}
+
+int ShmDataTransferServer::get_port() { return segment_id_; }
+
+void ShmDataTransferServer::DispatchLoop() {
+  uint64 next_reap_micros = Env::Default()->NowMicros() + kReapIntervalMicros;
+  while (true) {
+    const uint32 doorbell = segment_->doorbell.load(std::memory_order_acquire);
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return;
+      }
+      for (int i = 0; i < kNumSlots; ++i) {
+        if (in_flight_[i]) continue;
+        std::atomic<uint32>& state = segment_->slots[i].state;
+        uint32 word = state.load(std::memory_order_acquire);
+        if (StateOf(word) == kRequest) {
+          in_flight_[i] = true;
+          thread_pool_->Schedule([this, i]() { Process(i); });
+        } else if (StateOf(word) == kAbandoned) {
+          // The client left before its request was dispatched. Process()
+          // frees the slot itself if it sees the request, so a slot that is
+          // not in flight was never dispatched.
+          state.compare_exchange_strong(word, kFree,
+                                        std::memory_order_acq_rel);
+        }
+      }
+    }
+    if (Env::Default()->NowMicros() >= next_reap_micros) {
+      ReapDeadClients();
+      next_reap_micros = Env::Default()->NowMicros() + kReapIntervalMicros;
+    }
+    FutexWait(&segment_->doorbell, doorbell, kWaitTimeoutMicros);
+  }
+}
+
+void ShmDataTransferServer::Process(int index) {
+  Slot& slot = segment_->slots[index];
+  GetElementRequest request;
+  GetElementResult result;
+  Status status;
+  if (slot.request_size > kMaxRequestBytes ||
+      !request.ParseFromArray(slot.request, slot.request_size)) {
+    status = errors::Internal("Failed to parse GetElementRequest.");
+  } else {
+    status = get_element_(&request, &result);
+  }
+  Status write_status = WriteResponse(index, status, result);
+  if (!write_status.ok()) {
+    GetElementResult empty_result;
+    write_status = WriteResponse(index, write_status, empty_result);
+  }
+  if (!write_status.ok()) {
+    LOG(ERROR) << "Failed to write tf.data service response to shared memory: "
+               << write_status;
+    slot.response_size = 0;
+  }
+  // Only the client moves the slot out of kRequest, by abandoning it.
+  uint32 word = slot.state.load(std::memory_order_acquire);
+  if (StateOf(word) != kRequest ||
+      !slot.state.compare_exchange_strong(word,
+                                          SlotWord(PidOf(word), kResponse),
+                                          std::memory_order_acq_rel)) {
+    // The client went away while the request was being served.
+    slot.state.store(kFree, std::memory_order_release);
+  }
+  FutexWake(&slot.state);
+  mutex_lock l(mu_);
+  in_flight_[index] = false;
+}
+
+Status ShmDataTransferServer::WriteResponse(int index, const Status& status,
+                                            GetElementResult& result) {
+  ResponseHeader header = {};
+  header.code = status.code();
+  header.message_size = status.error_message().size();
+  header.element_index = result.element_index;
+  header.end_of_sequence = result.end_of_sequence;
+  header.skip = result.skip;
+  size_t size = Align(sizeof(header) + header.message_size);
+
+  std::vector<ComponentHeader> components;
+  std::vector<std::string> metadata;
+  if (status.ok()) {
+    header.num_components = result.components.size();
+    components.resize(result.components.size());
+    metadata.resize(result.components.size());
+    for (int i = 0; i < result.components.size(); ++i) {
+      const Tensor& tensor = result.components[i];
+      ComponentHeader& component = components[i];
+      const CompressedElement* compressed = nullptr;
+      if (tensor.dtype() == DT_VARIANT &&
+          TensorShapeUtils::IsScalar(tensor.shape())) {
+        compressed = tensor.scalar<Variant>()().get<CompressedElement>();
+      }
+      if (compressed != nullptr) {
+        component.kind = kCompressed;
+        compressed->SerializeToString(&metadata[i]);
+      } else if (DataTypeCanUseMemcpy(tensor.dtype())) {
+        component.kind = kRawTensor;
+        TensorProto proto;
+        proto.set_dtype(tensor.dtype());
+        tensor.shape().AsProto(proto.mutable_tensor_shape());
+        proto.SerializeToString(&metadata[i]);
+        component.data_size = tensor.tensor_data().size();
+      } else {
+        component.kind = kTensorProto;
+        TensorProto proto;
+        tensor.AsProtoTensorContent(&proto);
+        proto.SerializeToString(&metadata[i]);
+      }
+      component.metadata_size = metadata[i].size();
+      size += Align(sizeof(component) + component.metadata_size) +
+              Align(component.data_size);
+    }
+  }
+
+  DataSegment& data = *data_segments_[index];
+  if (size > data.capacity) {
+    auto grown = absl::make_unique<DataSegment>();
+    grown->capacity =
+        std::max({size, 2 * data.capacity, kMinDataSegmentBytes});
+    // Skip generations whose name is taken, e.g. by a crashed server that
+    // used the same segment id; only segments created here are unlinked.
+    Status map_status;
+    for (int attempt = 0; attempt < kMaxStartAttempts; ++attempt) {
+      grown->generation = data.generation + 1 + attempt;
+      grown->name = DataSegmentName(segment_id_, index, grown->generation);
+      map_status = MapSegment(grown->name, /*create=*/true, &grown->capacity,
+                              &grown->base);
+      if (map_status.ok()) break;
+    }
+    TF_RETURN_IF_ERROR(map_status);
+    // Clients that mapped the old generation keep their mapping until they
+    // see the new one; unlinking only removes the name.
+    data_segments_[index] = std::move(grown);
+  }
+  DataSegment& out = *data_segments_[index];
+  char* dest = out.base;
+  std::memcpy(dest, &header, sizeof(header));
+  std::memcpy(dest + sizeof(header), status.error_message().data(),
+              header.message_size);
+  dest += Align(sizeof(header) + header.message_size);
+  for (int i = 0; i < components.size(); ++i) {
+    std::memcpy(dest, &components[i], sizeof(ComponentHeader));
+    std::memcpy(dest + sizeof(ComponentHeader), metadata[i].data(),
+                metadata[i].size());
+    dest += Align(sizeof(ComponentHeader) + metadata[i].size());
+    if (components[i].data_size > 0) {
+      std::memcpy(dest, result.components[i].tensor_data().data(),
+                  components[i].data_size);
+      dest += Align(components[i].data_size);
+    }
+  }
+
+  Slot& slot = segment_->slots[index];
+  slot.data_generation = out.generation;
+  slot.response_size = size;
+  return Status::OK();
+}
+
+void ShmDataTransferServer::ReapDeadClients() {
+  for (Slot& slot : segment_->slots) {
+    uint32 word = slot.state.load(std::memory_order_acquire);
+    const uint32 state = StateOf(word);
+    // Fails if another client claimed the slot in the meantime, since its
+    // pid is part of the word.
+    if ((state == kIdle || state == kResponse) &&
+        !ProcessAlive(PidOf(word))) {
+      slot.state.compare_exchange_strong(word, kFree,
+                                         std::memory_order_acq_rel);
+    }
+  }
+}
+
+class ShmTransferRegistrar {
+ public:
+  ShmTransferRegistrar() {
+    DataTransferServer::Register(
+        kShmTransferProtocol, [](DataTransferServer::GetElementT get_element) {
+          return std::make_shared<ShmDataTransferServer>(get_element);
+        });
+    DataTransferClient::Register(
+        kShmTransferProtocol, [](DataTransferClient::Config config,
+                                 std::unique_ptr<DataTransferClient>* out) {
+          return ShmDataTransferClient::Create(config.address, out);
+        });
+  }
+};
+static ShmTransferRegistrar registrar;
+
+#else  // defined(__linux__)
+
+struct ShmDataTransferServer::Segment {};
+struct ShmDataTransferServer::DataSegment {};
+
+ShmDataTransferServer::ShmDataTransferServer(GetElementT get_element,
+                                             int64 segment_id)
+    : get_element_(std::move(get_element)), segment_id_(segment_id) {}
+
+ShmDataTransferServer::~ShmDataTransferServer() = default;
+
+Status ShmDataTransferServer::Start() {
+  return errors::Unimplemented(
+      "The shared-memory data transfer is only supported on Linux.");
+}
+
+int ShmDataTransferServer::get_port() { return segment_id_; }
+
+#endif  // defined(__linux__)
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,114 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHM_TRANSFER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHM_TRANSFER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace data {
+
+// Protocol name under which the shared-memory transfer server and client are
+// registered with DataTransferServer and DataTransferClient.
+constexpr const char kShmTransferProtocol[] = "shm";
+
+// Returns whether gRPC workers should also serve clients on the same host
+// through shared memory. Controlled by the TF_DATA_SERVICE_SHM_TRANSFER
+// environment variable (default false). Clients use the shared-memory transfer
+// whenever their worker advertises it and runs on the same host.
+bool ShmTransferEnabled();
+
+// Returns whether the host of `address` ("host:port") is this host.
+bool IsLocalAddress(absl::string_view address);
+
+// Returns the transfer address that a gRPC worker at `grpc_address` advertises
+// when it also serves the shared memory segment `segment_id`.
+std::string ShmTransferAddress(absl::string_view grpc_address,
+                               int64 segment_id);
+
+// If `transfer_address` was built by ShmTransferAddress(), sets
+// `*grpc_address` and `*segment_id` to its parts and returns true. Otherwise
+// sets `*grpc_address` to `transfer_address` and returns false.
+bool ParseShmTransferAddress(absl::string_view transfer_address,
+                             std::string* grpc_address, int64* segment_id);
+
+// Serves GetElement requests from clients in other processes (or the same
+// process) on this host through POSIX shared memory, bypassing gRPC
+// serialization and the loopback network stack.
+//
+// The server owns a control segment with a fixed ring of request slots. A
+// client claims a slot for its lifetime, writes a serialized GetElementRequest
+// into it and waits on the slot's state word, which doubles as a futex. The
+// server writes the raw tensor buffers of the response into a per-slot data
+// segment that it grows as needed, and the client copies them out once into
+// freshly allocated tensors.
+//
+// The segment is identified by `get_port()`, so transfer addresses have the
+// usual "host:port" form. The server only ever creates and unlinks segments
+// with its own id. Shared memory is only supported on Linux; elsewhere Start()
+// returns Unimplemented.
+class ShmDataTransferServer : public DataTransferServer {
+ public:
+  // Serves `get_element` from the segment named after `segment_id`, which
+  // must not exist yet. If `segment_id` is negative, Start() picks an unused
+  // random id above the range of valid ports.
+  explicit ShmDataTransferServer(GetElementT get_element,
+                                 int64 segment_id = -1);
+  ~ShmDataTransferServer() override;
+
+  Status Start() override;
+  int get_port() override;
+
+ private:
+  struct Segment;
+  struct DataSegment;
+
+  // Waits for requests and dispatches them to `thread_pool_`.
+  void DispatchLoop();
+  // Serves the request in slot `index`.
+  void Process(int index);
+  // Writes `result` (or `status`) into the data segment of slot `index`.
+  Status WriteResponse(int index, const Status& status,
+                       GetElementResult& result);
+  // Frees slots whose client process has exited.
+  void ReapDeadClients();
+
+  const GetElementT get_element_;
+  int64 segment_id_;
+  std::string name_;
+  Segment* segment_ = nullptr;
+  std::vector<std::unique_ptr<DataSegment>> data_segments_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  std::unique_ptr<Thread> dispatch_thread_;
+
+  mutex mu_;
+  std::vector<bool> in_flight_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHM_TRANSFER_H_
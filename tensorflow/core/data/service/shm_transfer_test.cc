@@ -0,0 +1,289 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shm_transfer.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Produces elements [task_id, index] and a string component; task 0 always
+// fails, task 1 is at end of sequence.
+Status GetElement(const GetElementRequest* request, GetElementResult* result) {
+  if (request->task_id() == 0) {
+    return errors::NotFound("No task 0");
+  }
+  result->element_index = 7;
+  result->end_of_sequence = request->task_id() == 1;
+  result->skip = false;
+  if (result->end_of_sequence) {
+    return Status::OK();
+  }
+  result->components.push_back(
+      test::AsTensor<int64>({request->task_id(), 7}, {2}));
+  result->components.push_back(test::AsTensor<tstring>({"a", "bc"}, {2}));
+  return Status::OK();
+}
+
+Status MakeClient(const std::shared_ptr<DataTransferServer>& server,
+                  std::unique_ptr<DataTransferClient>* client) {
+  return DataTransferClient::Build(
+      kShmTransferProtocol,
+      {"grpc", absl::StrCat("localhost:", server->get_port())}, client);
+}
+
+TEST(ShmTransferTest, RoundTrip) {
+  auto server = std::make_shared<ShmDataTransferServer>(GetElement);
+  TF_ASSERT_OK(server->Start());
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(MakeClient(server, &client));
+
+  for (int64 task_id = 2; task_id < 5; ++task_id) {
+    GetElementRequest request;
+    request.set_task_id(task_id);
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    EXPECT_EQ(7, result.element_index);
+    EXPECT_FALSE(result.end_of_sequence);
+    ASSERT_EQ(2, result.components.size());
+    test::ExpectEqual(result.components[0],
+                      test::AsTensor<int64>({task_id, 7}, {2}));
+    test::ExpectEqual(result.components[1],
+                      test::AsTensor<tstring>({"a", "bc"}, {2}));
+  }
+}
+
+TEST(ShmTransferTest, EndOfSequenceAndErrors) {
+  auto server = std::make_shared<ShmDataTransferServer>(GetElement);
+  TF_ASSERT_OK(server->Start());
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(MakeClient(server, &client));
+
+  GetElementRequest request;
+  GetElementResult result;
+  request.set_task_id(1);
+  TF_ASSERT_OK(client->GetElement(request, result));
+  EXPECT_TRUE(result.end_of_sequence);
+  EXPECT_TRUE(result.components.empty());
+
+  request.set_task_id(0);
+  Status s = client->GetElement(request, result);
+  EXPECT_TRUE(errors::IsNotFound(s)) << s;
+  EXPECT_EQ("No task 0", s.error_message());
+}
+
+TEST(ShmTransferTest, LargeAndCompressedElements) {
+  CompressedElement compressed;
+  compressed.set_data("compressed");
+  auto server = std::make_shared<ShmDataTransferServer>(
+      [&compressed](const GetElementRequest* request,
+                    GetElementResult* result) {
+        result->end_of_sequence = false;
+        result->skip = false;
+        if (request->task_id() == 0) {
+          Tensor tensor(DT_VARIANT, TensorShape{});
+          tensor.scalar<Variant>()() = compressed;
+          result->components.push_back(tensor);
+        } else {
+          Tensor tensor(DT_FLOAT, TensorShape({request->task_id()}));
+          test::FillIota<float>(&tensor, 0.0f);
+          result->components.push_back(tensor);
+        }
+        return Status::OK();
+      });
+  TF_ASSERT_OK(server->Start());
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(MakeClient(server, &client));
+
+  // Grow the data segment past its initial size, then shrink the element.
+  for (int64 size : {16, 1 << 20, 3 << 20, 5}) {
+    GetElementRequest request;
+    request.set_task_id(size);
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    ASSERT_EQ(1, result.components.size());
+    Tensor expected(DT_FLOAT, TensorShape({size}));
+    test::FillIota<float>(&expected, 0.0f);
+    test::ExpectEqual(result.components[0], expected);
+  }
+
+  GetElementRequest request;
+  request.set_task_id(0);
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(request, result));
+  ASSERT_EQ(1, result.components.size());
+  const CompressedElement* received =
+      result.components[0].scalar<Variant>()().get<CompressedElement>();
+  ASSERT_NE(nullptr, received);
+  EXPECT_EQ("compressed", received->data());
+}
+
+TEST(ShmTransferTest, ConcurrentClients) {
+  constexpr int kClients = 8;
+  constexpr int kRequests = 100;
+  auto server = std::make_shared<ShmDataTransferServer>(GetElement);
+  TF_ASSERT_OK(server->Start());
+  {
+    thread::ThreadPool threads(Env::Default(), "test", kClients);
+    for (int i = 0; i < kClients; ++i) {
+      threads.Schedule([&server, i]() {
+        std::unique_ptr<DataTransferClient> client;
+        TF_ASSERT_OK(MakeClient(server, &client));
+        for (int j = 0; j < kRequests; ++j) {
+          GetElementRequest request;
+          request.set_task_id(2 + i);
+          GetElementResult result;
+          TF_ASSERT_OK(client->GetElement(request, result));
+          test::ExpectEqual(result.components[0],
+                            test::AsTensor<int64>({2 + i, 7}, {2}));
+        }
+      });
+    }
+  }
+}
+
+TEST(ShmTransferTest, Cancel) {
+  Notification started;
+  Notification release;
+  auto server = std::make_shared<ShmDataTransferServer>(
+      [&](const GetElementRequest* request, GetElementResult* result) {
+        started.Notify();
+        release.WaitForNotification();
+        result->end_of_sequence = true;
+        return Status::OK();
+      });
+  TF_ASSERT_OK(server->Start());
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(MakeClient(server, &client));
+
+  std::unique_ptr<Thread> canceller(
+      Env::Default()->StartThread({}, "canceller", [&]() {
+        started.WaitForNotification();
+        client->TryCancel();
+      }));
+  GetElementRequest request;
+  GetElementResult result;
+  EXPECT_TRUE(errors::IsCancelled(client->GetElement(request, result)));
+  EXPECT_TRUE(errors::IsCancelled(client->GetElement(request, result)));
+  canceller.reset();
+  client.reset();
+  release.Notify();
+}
+
+TEST(ShmTransferTest, ServerShutdown) {
+  auto server = std::make_shared<ShmDataTransferServer>(GetElement);
+  TF_ASSERT_OK(server->Start());
+  const int port = server->get_port();
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(MakeClient(server, &client));
+  server.reset();
+
+  GetElementRequest request;
+  request.set_task_id(2);
+  GetElementResult result;
+  EXPECT_TRUE(errors::IsUnavailable(client->GetElement(request, result)));
+  EXPECT_TRUE(errors::IsUnavailable(DataTransferClient::Build(
+      kShmTransferProtocol, {"grpc", absl::StrCat("localhost:", port)},
+      &client)));
+}
+
+TEST(ShmTransferTest, ReusesSlotsOfDeadClients) {
+  auto server = std::make_shared<ShmDataTransferServer>(GetElement);
+  TF_ASSERT_OK(server->Start());
+
+  // A child process claims every slot and exits without releasing them.
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    std::unique_ptr<DataTransferClient> client;
+    while (MakeClient(server, &client).ok()) {
+      client.release();
+    }
+    _exit(0);
+  }
+  int wstatus;
+  ASSERT_EQ(pid, waitpid(pid, &wstatus, 0));
+  ASSERT_TRUE(WIFEXITED(wstatus));
+
+  // The server frees the slots once it notices that the child is gone.
+  std::unique_ptr<DataTransferClient> client;
+  Status s;
+  for (int i = 0; i < 100; ++i) {
+    s = MakeClient(server, &client);
+    if (s.ok()) break;
+    EXPECT_TRUE(errors::IsResourceExhausted(s)) << s;
+    Env::Default()->SleepForMicroseconds(100 * 1000);
+  }
+  TF_ASSERT_OK(s);
+  GetElementRequest request;
+  request.set_task_id(2);
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(request, result));
+  test::ExpectEqual(result.components[0], test::AsTensor<int64>({2, 7}, {2}));
+}
+
+TEST(ShmTransferTest, DoesNotReplaceExistingSegment) {
+  auto server = std::make_shared<ShmDataTransferServer>(GetElement);
+  TF_ASSERT_OK(server->Start());
+  auto duplicate =
+      std::make_shared<ShmDataTransferServer>(GetElement, server->get_port());
+  EXPECT_FALSE(duplicate->Start().ok());
+  duplicate.reset();
+
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(MakeClient(server, &client));
+  GetElementRequest request;
+  request.set_task_id(1);
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(request, result));
+  EXPECT_TRUE(result.end_of_sequence);
+}
+
+TEST(ShmTransferTest, ShmTransferAddress) {
+  const std::string address = ShmTransferAddress("localhost:5000", 123456);
+  std::string grpc_address;
+  int64 segment_id;
+  EXPECT_TRUE(ParseShmTransferAddress(address, &grpc_address, &segment_id));
+  EXPECT_EQ("localhost:5000", grpc_address);
+  EXPECT_EQ(123456, segment_id);
+
+  EXPECT_FALSE(
+      ParseShmTransferAddress("localhost:5000", &grpc_address, &segment_id));
+  EXPECT_EQ("localhost:5000", grpc_address);
+}
+
+TEST(ShmTransferTest, IsLocalAddress) {
+  EXPECT_TRUE(IsLocalAddress("localhost:5000"));
+  EXPECT_TRUE(IsLocalAddress("127.0.0.1:5000"));
+  EXPECT_TRUE(IsLocalAddress("[::1]:5000"));
+  EXPECT_TRUE(IsLocalAddress(absl::StrCat(port::Hostname(), ":5000")));
+  EXPECT_FALSE(IsLocalAddress("localhost"));
+  EXPECT_FALSE(IsLocalAddress("some.other.host:5000"));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -18,7 +18,6 @@ limitations under the License.
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
-#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -206,20 +205,19 @@ Status RoundRobinTaskRunner::GetNext(const GetElementRequest& req,
   }
   auto& buffer_result = buffer_[req.consumer_index()];
   result.element_index = buffer_result->index;
-  std::vector<Tensor> element;
-  for (auto& component : buffer_result->components) {
-    element.push_back(tensor::DeepCopy(component));
-  }
+  // The element shares its buffers with the round. Transfer servers only read
+  // the components, so there is no need to copy them, and keeping the shared
+  // lock short lets the next round start as soon as its last request arrives.
+  result.components = buffer_result->components;
   if (VLOG_IS_ON(2)) {
     int64 size = 0;
-    for (auto& component : element) {
+    for (auto& component : result.components) {
       size += component.TotalBytes();
     }
     VLOG(2) << worker_address_ << ": Returning element " << result.element_index
             << " to consumer " << req.consumer_index() << " for round "
             << req.round_index() << ". element size " << size;
   }
-  result.components = std::move(element);
   return Status::OK();
 }
 
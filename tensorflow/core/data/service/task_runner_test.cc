@@ -141,6 +141,36 @@ INSTANTIATE_TEST_SUITE_P(ConsumeParallelTests, ConsumeParallelTest,
                                            std::make_tuple(4, 20),
                                            std::make_tuple(0, 20)));
 
+TEST(RoundRobinTaskRunner, RepeatedRequestsShareRoundBuffer) {
+  std::vector<std::vector<Tensor>> elements;
+  for (int64 i = 0; i < 4; ++i) {
+    elements.push_back({test::AsTensor<int64>({i, i + 1, i + 2})});
+  }
+  RoundRobinTaskRunner runner(absl::make_unique<TestTaskIterator>(elements),
+                              /*num_consumers=*/1,
+                              /*worker_address=*/"test_worker_address");
+  GetElementRequest request;
+  request.set_round_index(0);
+  request.set_consumer_index(0);
+  request.set_allow_skip(false);
+  GetElementResult first;
+  TF_ASSERT_OK(runner.GetNext(request, first));
+  GetElementResult second;
+  TF_ASSERT_OK(runner.GetNext(request, second));
+  ASSERT_EQ(first.components.size(), 1);
+  ASSERT_EQ(second.components.size(), 1);
+  test::ExpectEqual(first.components[0], elements[0][0]);
+  EXPECT_EQ(first.components[0].tensor_data().data(),
+            second.components[0].tensor_data().data());
+
+  // Elements handed out for a round stay valid after the next round starts.
+  request.set_round_index(1);
+  GetElementResult next;
+  TF_ASSERT_OK(runner.GetNext(request, next));
+  test::ExpectEqual(next.components[0], elements[1][0]);
+  test::ExpectEqual(first.components[0], elements[0][0]);
+}
+
 TEST(RoundRobinTaskRunner, ConsumeParallelPartialRound) {
   int64 num_consumers = 5;
   std::vector<int64> starting_rounds = {12, 11, 11, 12, 12};
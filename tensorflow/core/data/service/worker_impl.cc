@@ -19,6 +19,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "tensorflow/c/c_api_internal.h"
 #include "tensorflow/c/tf_status_helper.h"
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
@@ -72,6 +73,27 @@ Status MoveElementToResponse(std::vector<Tensor>&& element,
   *resp.mutable_compressed() = *compressed;
   return Status::OK();
 }
+
+// Snappy-compresses an element stored uncompressed, for clients that cannot
+// read it. The element's tensor may be shared, so it is replaced rather than
+// modified in place.
+Status CompressStoredElement(std::vector<Tensor>& element) {
+  if (element.size() != 1 || element[0].dtype() != DT_VARIANT ||
+      !TensorShapeUtils::IsScalar(element[0].shape())) {
+    return Status::OK();
+  }
+  const CompressedElement* stored =
+      element[0].scalar<Variant>()().get<CompressedElement>();
+  if (stored == nullptr || !stored->stored_uncompressed()) {
+    return Status::OK();
+  }
+  CompressedElement compressed;
+  TF_RETURN_IF_ERROR(SnappyCompressStoredData(*stored, &compressed));
+  Tensor tensor(DT_VARIANT, TensorShape({}));
+  tensor.scalar<Variant>()() = std::move(compressed);
+  element[0] = std::move(tensor);
+  return Status::OK();
+}
 }  // namespace
 
 DataServiceWorkerImpl::DataServiceWorkerImpl(
@@ -180,6 +202,9 @@ Status DataServiceWorkerImpl::GetElementResult(
     cv_.notify_all();
   });
   TF_RETURN_IF_ERROR(task->task_runner->GetNext(*request, *result));
+  if (!request->accepts_stored_uncompressed()) {
+    TF_RETURN_IF_ERROR(CompressStoredElement(result->components));
+  }
   return Status::OK();
 }
 
@@ -24,6 +24,9 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
+#include "tensorflow/core/lib/io/lz4/lz4_compression_options.h"
+#include "tensorflow/core/lib/io/lz4/lz4_inputstream.h"
+#include "tensorflow/core/lib/io/lz4/lz4_outputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
@@ -31,6 +34,9 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
 #include "tensorflow/core/platform/coding.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -39,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/snapshot.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -173,15 +180,31 @@ Status CustomWriter::Initialize(tensorflow::Env* env) {
   }
 #else   // IS_SLIM_BUILD
   if (compression_type_ == io::compression::kGzip) {
-    zlib_underlying_dest_.swap(dest_);
+    underlying_dest_.swap(dest_);
     io::ZlibCompressionOptions zlib_options;
     zlib_options = io::ZlibCompressionOptions::GZIP();
 
     io::ZlibOutputBuffer* zlib_output_buffer = new io::ZlibOutputBuffer(
-        zlib_underlying_dest_.get(), zlib_options.input_buffer_size,
+        underlying_dest_.get(), zlib_options.input_buffer_size,
         zlib_options.output_buffer_size, zlib_options);
     TF_CHECK_OK(zlib_output_buffer->Init());
     dest_.reset(zlib_output_buffer);
+  } else if (compression_type_ == io::compression::kZstd) {
+    underlying_dest_.swap(dest_);
+    io::ZstdCompressionOptions zstd_options;
+    auto zstd_output_buffer = absl::make_unique<io::ZstdOutputBuffer>(
+        underlying_dest_.get(), zstd_options.input_buffer_size,
+        zstd_options.output_buffer_size, zstd_options);
+    TF_RETURN_IF_ERROR(zstd_output_buffer->Init());
+    dest_ = std::move(zstd_output_buffer);
+  } else if (compression_type_ == io::compression::kLz4) {
+    underlying_dest_.swap(dest_);
+    io::Lz4CompressionOptions lz4_options;
+    auto lz4_output_buffer = absl::make_unique<io::Lz4OutputBuffer>(
+        underlying_dest_.get(), lz4_options.input_buffer_size,
+        lz4_options.output_buffer_size, lz4_options);
+    TF_RETURN_IF_ERROR(lz4_output_buffer->Init());
+    dest_ = std::move(lz4_output_buffer);
   }
 #endif  // IS_SLIM_BUILD
   simple_tensor_mask_.reserve(dtypes_.size());
@@ -288,9 +311,9 @@ Status CustomWriter::Close() {
     TF_RETURN_IF_ERROR(dest_->Close());
     dest_ = nullptr;
   }
-  if (zlib_underlying_dest_ != nullptr) {
-    TF_RETURN_IF_ERROR(zlib_underlying_dest_->Close());
-    zlib_underlying_dest_ = nullptr;
+  if (underlying_dest_ != nullptr) {
+    TF_RETURN_IF_ERROR(underlying_dest_->Close());
+    underlying_dest_ = nullptr;
   }
   return Status::OK();
 }
@@ -682,6 +705,16 @@ Status CustomReader::Initialize(Env* env) {
       input_stream_ =
           absl::make_unique<io::BufferedInputStream>(file_.get(), 64 << 20);
     }
+  } else if (compression_type_ == io::compression::kZstd) {
+    io::ZstdCompressionOptions zstd_options;
+    input_stream_ = absl::make_unique<io::ZstdInputStream>(
+        input_stream_.release(), zstd_options.input_buffer_size,
+        zstd_options.output_buffer_size, zstd_options, true);
+  } else if (compression_type_ == io::compression::kLz4) {
+    io::Lz4CompressionOptions lz4_options;
+    input_stream_ = absl::make_unique<io::Lz4InputStream>(
+        input_stream_.release(), lz4_options.input_buffer_size,
+        lz4_options.output_buffer_size, true);
   }
 #endif  // IS_SLIM_BUILD
   simple_tensor_mask_.reserve(dtypes_.size());
@@ -935,6 +968,24 @@ Status DetermineOpState(const std::string& mode_string, bool file_exists,
   }
 }
 
+bool SharePendingSnapshots() {
+  bool share = false;
+  Status s = ReadBoolFromEnvVar("TF_DATA_SNAPSHOT_SHARE_PENDING_RUNS",
+                                /*default_val=*/false, &share);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+  }
+  return share;
+}
+
+bool IsLivePendingSnapshot(
+    const experimental::SnapshotMetadataRecord& metadata) {
+  return !metadata.finalized() &&
+         metadata.heartbeat_timestamp() >=
+             static_cast<int64>(EnvTime::NowMicros()) -
+                 kPendingSnapshotExpiryMicros;
+}
+
 AsyncWriter::AsyncWriter(Env* env, int64 file_index,
                          const std::string& shard_directory,
                          uint64 checkpoint_id, const std::string& compression,
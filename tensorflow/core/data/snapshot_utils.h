@@ -154,10 +154,11 @@ class CustomWriter : public Writer {
   const std::string filename_;
   const std::string compression_type_;
   const DataTypeVector dtypes_;
-  // We hold zlib_dest_ because we may create a ZlibOutputBuffer and put that
-  // in dest_ if we want compression. ZlibOutputBuffer doesn't own the original
-  // dest_ and so we need somewhere to store the original one.
-  std::unique_ptr<WritableFile> zlib_underlying_dest_;
+  // We hold underlying_dest_ because we may create a compressing output buffer
+  // (e.g. ZlibOutputBuffer) and put that in dest_ if we want compression. The
+  // output buffers don't own the original dest_ and so we need somewhere to
+  // store the original one.
+  std::unique_ptr<WritableFile> underlying_dest_;
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
   int num_simple_ = 0;
   int num_complex_ = 0;
@@ -298,6 +299,24 @@ Status DetermineOpState(const std::string& mode_string, bool file_exists,
                         const uint64 pending_snapshot_expiry_seconds,
                         Mode* mode);
 
+// How often the writer of a snapshot refreshes the heartbeat in its metadata
+// file when pending snapshots are shared, and how long after the last heartbeat
+// a pending snapshot is considered abandoned.
+constexpr int64 kSnapshotHeartbeatIntervalMicros = 30LL * 1000 * 1000;
+constexpr int64 kPendingSnapshotExpiryMicros =
+    10 * kSnapshotHeartbeatIntervalMicros;
+
+// Returns whether snapshot writers should share an unfinalized snapshot that
+// is still being written instead of writing another copy of it. Controlled by
+// the TF_DATA_SNAPSHOT_SHARE_PENDING_RUNS environment variable (default
+// false).
+bool SharePendingSnapshots();
+
+// Returns whether `metadata` describes an unfinalized snapshot whose writer has
+// sent a heartbeat within the last `kPendingSnapshotExpiryMicros`.
+bool IsLivePendingSnapshot(
+    const experimental::SnapshotMetadataRecord& metadata);
+
 // Represents a dataset element or EOF.
 struct ElementOrEOF {
   std::vector<Tensor> value;
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/snapshot.pb.h"
 
 namespace tensorflow {
 namespace data {
@@ -147,6 +148,29 @@ BENCHMARK(SnapshotCustomReaderSnappyBenchmark);
 BENCHMARK(SnapshotTFRecordReaderNoneBenchmark);
 BENCHMARK(SnapshotTFRecordReaderGzipBenchmark);
 
+TEST(SnapshotUtilTest, SharePendingSnapshots) {
+  EXPECT_FALSE(SharePendingSnapshots());
+  setenv("TF_DATA_SNAPSHOT_SHARE_PENDING_RUNS", "true", /*overwrite=*/1);
+  EXPECT_TRUE(SharePendingSnapshots());
+  unsetenv("TF_DATA_SNAPSHOT_SHARE_PENDING_RUNS");
+}
+
+TEST(SnapshotUtilTest, IsLivePendingSnapshot) {
+  experimental::SnapshotMetadataRecord metadata;
+  EXPECT_FALSE(IsLivePendingSnapshot(metadata));
+
+  metadata.set_heartbeat_timestamp(EnvTime::NowMicros());
+  EXPECT_TRUE(IsLivePendingSnapshot(metadata));
+
+  metadata.set_finalized(true);
+  EXPECT_FALSE(IsLivePendingSnapshot(metadata));
+
+  metadata.set_finalized(false);
+  metadata.set_heartbeat_timestamp(EnvTime::NowMicros() -
+                                   2 * kPendingSnapshotExpiryMicros);
+  EXPECT_FALSE(IsLivePendingSnapshot(metadata));
+}
+
 void SnapshotWriterBenchmarkLoop(::testing::benchmark::State& state,
                                  std::string compression_type, int version) {
   tensorflow::DataTypeVector dtypes;
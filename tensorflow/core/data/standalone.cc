@@ -100,6 +100,12 @@ Status Dataset::FromGraph(Params params, const GraphDef& graph_def,
 
 Status Dataset::MakeIterator(std::unique_ptr<SplitProvider> split_provider,
                              std::unique_ptr<Iterator>* result) {
+  return MakeIterator(std::move(split_provider), /*model=*/nullptr, result);
+}
+
+Status Dataset::MakeIterator(std::unique_ptr<SplitProvider> split_provider,
+                             std::shared_ptr<model::Model> model,
+                             std::unique_ptr<Iterator>* result) {
   // Create an `IteratorContext`, which bundles together the necessary runtime
   // support to create and get elements from an iterator.
   std::unique_ptr<IteratorContext> ctx;
@@ -117,6 +123,7 @@ Status Dataset::MakeIterator(std::unique_ptr<SplitProvider> split_provider,
     params.resource_mgr = &resource_mgr_;
     params.cancellation_manager = &cancellation_manager_;
     params.split_provider = std::move(split_provider);
+    params.model = std::move(model);
 
     ctx = absl::make_unique<IteratorContext>(std::move(params));
   }
@@ -102,6 +102,12 @@ class Dataset {
   Status MakeIterator(std::unique_ptr<SplitProvider> split_provider,
                       std::unique_ptr<Iterator>* result);
 
+  // Creates an iterator, optionally with a split provider, that records the
+  // performance of the input pipeline in `model` if it is not null.
+  Status MakeIterator(std::unique_ptr<SplitProvider> split_provider,
+                      std::shared_ptr<model::Model> model,
+                      std::unique_ptr<Iterator>* result);
+
   // Creates a split provider for this dataset.
   Status MakeSplitProvider(std::unique_ptr<SplitProvider>* result);
   // Returns a pointer to the underlying dataset.
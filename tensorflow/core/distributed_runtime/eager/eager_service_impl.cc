@@ -594,6 +594,11 @@ Status EagerServiceImpl::Enqueue(CallOptions* call_opts,
         // TODO(b/138847548): Cleanup the executor when StreamCall is deleted.
         context->Context()->RemoteMgr()->DeleteExecutorForStream(stream_id);
       }
+      if (request->report_item_status()) {
+        response->set_status_code(s.code());
+        response->set_status_error_message(s.error_message());
+        return Status::OK();
+      }
       return s;
     }
   }
@@ -1103,6 +1103,74 @@ TEST_F(EagerServiceImplTest, SendTensorTest) {
                                                &close_context_response));
 }
 
+// Test that the failure of an item is returned in the response when the
+// request asks for item statuses, and that the items after it are not run.
+TEST_F(EagerServiceImplTest, ReportItemStatusTest) {
+  TestEagerServiceImpl eager_service_impl(&worker_env_);
+
+  uint64 context_id = random::New64();
+
+  CreateContextRequest request;
+  request.mutable_server_def()->set_job_name("localhost");
+  request.mutable_server_def()->set_task_index(0);
+  request.set_context_id(context_id);
+  CreateContextResponse response;
+
+  TF_ASSERT_OK(eager_service_impl.CreateContext(&request, &response));
+
+  EnqueueRequest remote_enqueue_request;
+  remote_enqueue_request.set_context_id(context_id);
+  auto* send_tensor = remote_enqueue_request.add_queue()->mutable_send_tensor();
+  send_tensor->set_op_id(1);
+  SetTensorProto(send_tensor->add_tensors());
+
+  std::unordered_map<string, AttrValue> attrs;
+  AttrValue val;
+  val.set_type(tensorflow::DataType::DT_FLOAT);
+  attrs.insert({"T", val});
+  val.Clear();
+  val.set_b(false);
+  attrs.insert({"transpose_a", val});
+  attrs.insert({"transpose_b", val});
+  // Op 3 does not exist.
+  AddOperationToEnqueueRequest(
+      2, "MatMul", {std::make_pair(3, 0), std::make_pair(1, 0)}, attrs,
+      "/job:localhost/replica:0/task:0/device:CPU:0", &remote_enqueue_request);
+
+  send_tensor = remote_enqueue_request.add_queue()->mutable_send_tensor();
+  send_tensor->set_op_id(4);
+  SetTensorProto(send_tensor->add_tensors());
+
+  EnqueueResponse remote_enqueue_response;
+  EXPECT_FALSE(eager_service_impl
+                   .Enqueue(nullptr, &remote_enqueue_request,
+                            &remote_enqueue_response)
+                   .ok());
+
+  remote_enqueue_request.set_report_item_status(true);
+  remote_enqueue_request.mutable_queue(0)->mutable_send_tensor()->set_op_id(5);
+  remote_enqueue_response.Clear();
+  TF_ASSERT_OK(eager_service_impl.Enqueue(nullptr, &remote_enqueue_request,
+                                          &remote_enqueue_response));
+  EXPECT_EQ(2, remote_enqueue_response.queue_response_size());
+  EXPECT_NE(error::OK, remote_enqueue_response.status_code());
+  EXPECT_FALSE(remote_enqueue_response.status_error_message().empty());
+
+  tensorflow::TensorHandle* tensor_handle;
+  TF_EXPECT_OK(eager_service_impl.GetTensorHandle(
+      context_id, RemoteTensorHandleInternal(5, 0), &tensor_handle));
+  Status status = eager_service_impl.GetTensorHandle(
+      context_id, RemoteTensorHandleInternal(4, 0), &tensor_handle);
+  EXPECT_FALSE(status.ok());
+
+  CloseContextRequest close_context_request;
+  close_context_request.set_context_id(context_id);
+  close_context_request.set_context_view_id(0);
+  CloseContextResponse close_context_response;
+  TF_ASSERT_OK(eager_service_impl.CloseContext(&close_context_request,
+                                               &close_context_response));
+}
+
 // Test serializes and sends a pack TensorHandle.
 TEST_F(EagerServiceImplTest, SendPackedHandleTest) {
   TestEagerServiceImpl eager_service_impl(&worker_env_);
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/rendezvous_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
+#include "tensorflow/core/distributed_runtime/staleness_tracker.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/log_memory.h"
@@ -162,6 +163,13 @@ Status GraphMgr::InitItem(
   opts.validate_nodes = true;
   TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
 
+  if (config_proto.experimental().max_staleness_steps() > 0 &&
+      worker_env_->staleness_tracker != nullptr) {
+    item->staleness_shard = StalenessTracker::ShardForGraph(graph);
+    item->max_staleness_steps =
+        config_proto.experimental().max_staleness_steps();
+  }
+
   // Splits "graph" into multiple subgraphs by device names.
   std::unordered_map<string, GraphDef> partitions;
   PartitionOptions popts;
@@ -313,6 +321,10 @@ Status GraphMgr::Register(
     item->handle = *graph_handle;
     CHECK(table_.insert({*graph_handle, item}).second);
   }
+  if (!item->staleness_shard.empty()) {
+    worker_env_->staleness_tracker->Register(item->staleness_shard,
+                                             item->session);
+  }
   return Status::OK();
 }
 
@@ -329,6 +341,10 @@ Status GraphMgr::Deregister(const string& handle) {
     item = iter->second;
     table_.erase(iter);
   }
+  if (!item->staleness_shard.empty()) {
+    worker_env_->staleness_tracker->Unregister(item->staleness_shard,
+                                               item->session);
+  }
   item->Unref();
   return Status::OK();
 }
@@ -344,6 +360,10 @@ Status GraphMgr::DeregisterAll() {
     table_.clear();
   }
   for (auto item : items) {
+    if (!item->staleness_shard.empty()) {
+      worker_env_->staleness_tracker->Unregister(item->staleness_shard,
+                                                 item->session);
+    }
     item->Unref();
   }
   return Status::OK();
@@ -443,6 +463,59 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
     return;
   }
 
+  if (item->staleness_shard.empty()) {
+    RunItemAsync(handle, step_id, item, session, opts, collector, response,
+                 cancellation_manager, in, start_time_usecs, std::move(done));
+    return;
+  }
+
+  // Waits until the slowest sessions updating the same variables have caught
+  // up, then runs the step.
+  StalenessTracker* tracker = worker_env_->staleness_tracker;
+  const int64 tracker_step_id = tracker->NewStep();
+  CancellationToken token = CancellationManager::kInvalidToken;
+  if (cancellation_manager != nullptr) {
+    token = cancellation_manager->get_cancellation_token();
+    if (!cancellation_manager->RegisterCallback(
+            token, [tracker, tracker_step_id]() {
+              tracker->Cancel(tracker_step_id);
+            })) {
+      tracker->Cancel(tracker_step_id);
+    }
+  }
+  tracker->StartStep(
+      tracker_step_id, item->staleness_shard, item->session,
+      item->max_staleness_steps,
+      [this, tracker, handle, step_id, item, session, opts, collector,
+       response, cancellation_manager, token, in, start_time_usecs,
+       done](const Status& s) {
+        if (cancellation_manager != nullptr) {
+          cancellation_manager->TryDeregisterCallback(token);
+        }
+        if (!s.ok()) {
+          done(s);
+          item->Unref();
+          return;
+        }
+        const string shard = item->staleness_shard;
+        const string participant = item->session;
+        RunItemAsync(handle, step_id, item, session, opts, collector, response,
+                     cancellation_manager, in, start_time_usecs,
+                     [tracker, shard, participant, done](const Status& s) {
+                       tracker->FinishStep(shard, participant);
+                       done(s);
+                     });
+      });
+}
+
+void GraphMgr::RunItemAsync(const string& handle, const int64 step_id,
+                            Item* item, WorkerSession* session,
+                            const ExecutorOpts& opts,
+                            StepStatsCollector* collector,
+                            MutableRunGraphResponseWrapper* response,
+                            CancellationManager* cancellation_manager,
+                            const NamedTensors& in, uint64 start_time_usecs,
+                            StatusCallback done) {
   CostGraphDef* cost_graph = nullptr;
   if (response != nullptr) {
     cost_graph = response->mutable_cost_graph();
@@ -142,6 +142,12 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64 collective_graph_key;
+
+    // The variables updated by the graph, whose updates are bounded to
+    // "max_staleness_steps" by the worker's StalenessTracker.  Empty if the
+    // staleness is not bounded.
+    string staleness_shard;
+    int max_staleness_steps = 0;
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
@@ -163,6 +169,16 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Runs one step of "item", once it may start.  Takes ownership of the ref
+  // on "item" held by ExecuteAsync.
+  void RunItemAsync(const string& handle, const int64 step_id, Item* item,
+                    WorkerSession* session, const ExecutorOpts& opts,
+                    StepStatsCollector* collector,
+                    MutableRunGraphResponseWrapper* response,
+                    CancellationManager* cancellation_manager,
+                    const NamedTensors& in, uint64 start_time_usecs,
+                    StatusCallback done);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               CollectiveExecutor::Handle* ce_handle,
@@ -0,0 +1,119 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/recv_tensor_compression.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+auto* recv_tensor_compression_bytes_saved = monitoring::Counter<1>::New(
+    "/tensorflow/core/recv_tensor_compression_bytes_saved",
+    "The number of bytes saved by compressing tensors sent in RecvTensor "
+    "responses.",
+    "dtype");
+
+DataType ToDataType(RPCOptions::TensorCompression::Type type) {
+  switch (type) {
+    case RPCOptions::TensorCompression::HALF:
+      return DT_HALF;
+    case RPCOptions::TensorCompression::BFLOAT16:
+      return DT_BFLOAT16;
+    default:
+      return DT_INVALID;
+  }
+}
+
+}  // namespace
+
+RecvTensorCompression::RecvTensorCompression(const RPCOptions& rpc_options) {
+  for (const auto& compression : rpc_options.recv_tensor_compression()) {
+    auto pattern = absl::make_unique<RE2>(compression.tensor_name_pattern());
+    if (!pattern->ok()) {
+      LOG(WARNING) << "Ignoring invalid recv_tensor_compression pattern \""
+                   << compression.tensor_name_pattern()
+                   << "\": " << pattern->error();
+      continue;
+    }
+    rules_.emplace_back(std::move(pattern), ToDataType(compression.type()));
+  }
+}
+
+DataType RecvTensorCompression::CompressedDtype(StringPiece rendezvous_key,
+                                                const Tensor& val) const {
+  if (val.dtype() != DT_FLOAT || val.NumElements() == 0) return DT_INVALID;
+  const re2::StringPiece key(rendezvous_key.data(), rendezvous_key.size());
+  for (const auto& rule : rules_) {
+    if (RE2::PartialMatch(key, *rule.first)) return rule.second;
+  }
+  return DT_INVALID;
+}
+
+Status CompressRecvTensor(const Tensor& in, DataType dtype, Tensor* out) {
+  if (in.dtype() != DT_FLOAT) {
+    return errors::InvalidArgument("Cannot compress a tensor of type ",
+                                   DataTypeString(in.dtype()));
+  }
+  Tensor result(cpu_allocator(), dtype, in.shape());
+  auto src = in.flat<float>();
+  switch (dtype) {
+    case DT_HALF:
+      result.flat<Eigen::half>() = src.cast<Eigen::half>();
+      break;
+    case DT_BFLOAT16:
+      RoundFloatToBFloat16(src.data(), result.flat<bfloat16>().data(),
+                           src.size());
+      break;
+    default:
+      return errors::InvalidArgument("Cannot compress a tensor to type ",
+                                     DataTypeString(dtype));
+  }
+  recv_tensor_compression_bytes_saved->GetCell(DataTypeString(dtype))
+      ->IncrementBy(in.TotalBytes() - result.TotalBytes());
+  *out = std::move(result);
+  return Status::OK();
+}
+
+Status DecompressRecvTensor(const Tensor& in, DataType uncompressed_dtype,
+                            Allocator* allocator, Tensor* out) {
+  if (uncompressed_dtype != DT_FLOAT) {
+    return errors::InvalidArgument("Cannot decompress a tensor to type ",
+                                   DataTypeString(uncompressed_dtype));
+  }
+  Tensor result(allocator, DT_FLOAT, in.shape());
+  auto dst = result.flat<float>();
+  switch (in.dtype()) {
+    case DT_HALF:
+      dst = in.flat<Eigen::half>().cast<float>();
+      break;
+    case DT_BFLOAT16:
+      BFloat16ToFloat(in.flat<bfloat16>().data(), dst.data(), dst.size());
+      break;
+    default:
+      return errors::InvalidArgument("Cannot decompress a tensor of type ",
+                                     DataTypeString(in.dtype()));
+  }
+  *out = std::move(result);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
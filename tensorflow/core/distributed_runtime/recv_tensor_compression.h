@@ -0,0 +1,62 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RECV_TENSOR_COMPRESSION_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RECV_TENSOR_COMPRESSION_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "re2/re2.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+// Decides which tensors sent in RecvTensor responses are downcast, as
+// configured by RPCOptions.recv_tensor_compression.
+class RecvTensorCompression {
+ public:
+  explicit RecvTensorCompression(const RPCOptions& rpc_options);
+
+  // Returns the dtype to send "val" as, for the tensor identified by
+  // "rendezvous_key", or DT_INVALID if "val" is sent as is.
+  DataType CompressedDtype(StringPiece rendezvous_key, const Tensor& val) const;
+
+  bool empty() const { return rules_.empty(); }
+
+ private:
+  std::vector<std::pair<std::unique_ptr<RE2>, DataType>> rules_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecvTensorCompression);
+};
+
+// Downcasts the DT_FLOAT tensor "in" to "dtype" (DT_HALF or DT_BFLOAT16),
+// allocating "*out" on the CPU. Records the bytes saved in the
+// /tensorflow/core/recv_tensor_compression_bytes_saved counter.
+Status CompressRecvTensor(const Tensor& in, DataType dtype, Tensor* out);
+
+// Casts "in", produced by CompressRecvTensor(), back to "uncompressed_dtype",
+// allocating "*out" with "allocator".
+Status DecompressRecvTensor(const Tensor& in, DataType uncompressed_dtype,
+                            Allocator* allocator, Tensor* out);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RECV_TENSOR_COMPRESSION_H_
@@ -0,0 +1,92 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/recv_tensor_compression.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+RPCOptions MakeOptions() {
+  RPCOptions options;
+  auto* compression = options.add_recv_tensor_compression();
+  compression->set_tensor_name_pattern("edge_[0-9]+_keep");
+  compression->set_type(RPCOptions::TensorCompression::NONE);
+  compression = options.add_recv_tensor_compression();
+  compression->set_tensor_name_pattern("gradients");
+  compression->set_type(RPCOptions::TensorCompression::BFLOAT16);
+  compression = options.add_recv_tensor_compression();
+  compression->set_tensor_name_pattern("activations");
+  compression->set_type(RPCOptions::TensorCompression::HALF);
+  return options;
+}
+
+TEST(RecvTensorCompressionTest, CompressedDtype) {
+  RecvTensorCompression compression(MakeOptions());
+  Tensor val(DT_FLOAT, TensorShape({2}));
+  EXPECT_EQ(DT_BFLOAT16,
+            compression.CompressedDtype("a;1;b;edge_3_gradients/x;0:0", val));
+  EXPECT_EQ(DT_HALF,
+            compression.CompressedDtype("a;1;b;edge_4_activations;0:0", val));
+  // The first matching entry applies.
+  EXPECT_EQ(DT_INVALID, compression.CompressedDtype(
+                            "a;1;b;edge_5_keep/gradients;0:0", val));
+  EXPECT_EQ(DT_INVALID,
+            compression.CompressedDtype("a;1;b;edge_6_logits;0:0", val));
+  // Only float tensors are compressed.
+  Tensor int_val(DT_INT32, TensorShape({2}));
+  EXPECT_EQ(DT_INVALID, compression.CompressedDtype(
+                            "a;1;b;edge_3_gradients/x;0:0", int_val));
+}
+
+TEST(RecvTensorCompressionTest, InvalidPatternIsIgnored) {
+  RPCOptions options;
+  auto* compression = options.add_recv_tensor_compression();
+  compression->set_tensor_name_pattern("(");
+  compression->set_type(RPCOptions::TensorCompression::HALF);
+  EXPECT_TRUE(RecvTensorCompression(options).empty());
+}
+
+TEST(RecvTensorCompressionTest, RoundTrip) {
+  Tensor val = test::AsTensor<float>({1.0f, -2.5f, 0.0f, 1024.0f},
+                                     TensorShape({2, 2}));
+  for (DataType dtype : {DT_HALF, DT_BFLOAT16}) {
+    Tensor compressed;
+    TF_ASSERT_OK(CompressRecvTensor(val, dtype, &compressed));
+    EXPECT_EQ(dtype, compressed.dtype());
+    EXPECT_EQ(val.TotalBytes() / 2, compressed.TotalBytes());
+
+    Tensor decompressed;
+    TF_ASSERT_OK(DecompressRecvTensor(compressed, DT_FLOAT, cpu_allocator(),
+                                      &decompressed));
+    test::ExpectTensorEqual<float>(val, decompressed);
+  }
+}
+
+TEST(RecvTensorCompressionTest, UnsupportedTypes) {
+  Tensor int_val(DT_INT32, TensorShape({2}));
+  Tensor out;
+  EXPECT_FALSE(CompressRecvTensor(int_val, DT_HALF, &out).ok());
+  Tensor float_val(DT_FLOAT, TensorShape({2}));
+  EXPECT_FALSE(CompressRecvTensor(float_val, DT_INT8, &out).ok());
+  EXPECT_FALSE(DecompressRecvTensor(int_val, DT_FLOAT, cpu_allocator(), &out)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,89 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/eager/enqueue_batch.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace eager {
+
+EnqueueBatch::EnqueueBatch(uint64 context_id, uint64 batch_id)
+    : batch_id_(batch_id) {
+  request_.set_context_id(context_id);
+  request_.set_report_item_status(true);
+}
+
+void EnqueueBatch::Add(const EnqueueRequest& request,
+                       EnqueueResponse* response, StatusCallback done) {
+  DCHECK_EQ(request.context_id(), request_.context_id());
+  request_.mutable_queue()->MergeFrom(request.queue());
+  bytes_ += request.ByteSizeLong();
+  pending_.push_back({response, request.queue_size(), std::move(done)});
+}
+
+void EnqueueBatch::Finish(const Status& status) {
+  if (!status.ok()) {
+    for (Pending& pending : pending_) {
+      pending.done(status);
+    }
+    return;
+  }
+
+  // The service adds one queue response per item it runs. With
+  // report_item_status, a failed item is the one of the last queue response.
+  const int num_responses = response_.queue_response_size();
+  const bool item_failed = response_.status_code() != error::OK;
+  const Status item_status =
+      item_failed ? Status(response_.status_code(),
+                           response_.status_error_message())
+                  : Status::OK();
+  if (item_failed && num_responses == 0) {
+    Finish(item_status);
+    return;
+  }
+  if (!item_failed && num_responses != request_.queue_size()) {
+    Finish(errors::Internal("Expected ", request_.queue_size(),
+                            " queue responses, got ", num_responses));
+    return;
+  }
+  const int failed_index = item_failed ? num_responses - 1 : num_responses;
+  int offset = 0;
+  for (Pending& pending : pending_) {
+    const int end = offset + pending.num_items;
+    if (end <= failed_index) {
+      for (int i = offset; i < end; ++i) {
+        pending.response->add_queue_response()->Swap(
+            response_.mutable_queue_response(i));
+      }
+      pending.done(Status::OK());
+    } else if (offset <= failed_index) {
+      pending.done(item_status);
+    } else {
+      pending.done(Status(
+          item_status.code(),
+          strings::StrCat("Not run after the failure of an earlier enqueue "
+                          "request in the same batch: ",
+                          item_status.error_message())));
+    }
+    offset = end;
+  }
+}
+
+}  // namespace eager
+}  // namespace tensorflow
@@ -0,0 +1,76 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_ENQUEUE_BATCH_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_ENQUEUE_BATCH_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
+
+namespace tensorflow {
+namespace eager {
+
+// Enqueue requests of one context coalesced into a single EnqueueRequest,
+// whose response is split back between the original requests.
+class EnqueueBatch {
+ public:
+  // "batch_id" identifies the batch, e.g. for the timer that sends it.
+  EnqueueBatch(uint64 context_id, uint64 batch_id);
+
+  uint64 batch_id() const { return batch_id_; }
+
+  // Appends the items of "request". "done" is called by Finish(), after the
+  // responses of those items are added to "response".
+  void Add(const EnqueueRequest& request, EnqueueResponse* response,
+           StatusCallback done);
+
+  // Number of requests added, and the sum of their serialized sizes.
+  int num_requests() const { return pending_.size(); }
+  int64 bytes() const { return bytes_; }
+
+  // The request to send, and the response to fill.
+  const EnqueueRequest& request() const { return request_; }
+  EnqueueResponse* mutable_response() { return &response_; }
+
+  // Calls the "done" callback of every added request, with "status" if the
+  // whole call failed. Otherwise, the requests before the item that failed,
+  // if any, get their responses and an OK status; the request of that item
+  // gets its error; and the requests after it, which were not run, get an
+  // error with the same code.
+  void Finish(const Status& status);
+
+ private:
+  struct Pending {
+    EnqueueResponse* response;
+    int num_items;
+    StatusCallback done;
+  };
+
+  const uint64 batch_id_;
+  EnqueueRequest request_;
+  EnqueueResponse response_;
+  int64 bytes_ = 0;
+  std::vector<Pending> pending_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EnqueueBatch);
+};
+
+}  // namespace eager
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_ENQUEUE_BATCH_H_
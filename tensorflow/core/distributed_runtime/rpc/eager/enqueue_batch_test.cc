@@ -0,0 +1,146 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/eager/enqueue_batch.h"
+
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+constexpr uint64 kContextId = 7;
+
+// Returns a request with one operation item per id in "op_ids".
+EnqueueRequest MakeRequest(const std::vector<int64>& op_ids) {
+  EnqueueRequest request;
+  request.set_context_id(kContextId);
+  for (int64 op_id : op_ids) {
+    request.add_queue()->mutable_operation()->set_id(op_id);
+  }
+  return request;
+}
+
+// Adds the response of an item, identified by its device.
+void AddQueueResponse(EnqueueResponse* response, int item) {
+  response->add_queue_response()->add_device(strings::StrCat(item));
+}
+
+class EnqueueBatchTest : public ::testing::Test {
+ protected:
+  // Adds requests of "num_items" items each to "batch_".
+  void AddRequests(const std::vector<int>& num_items) {
+    int64 op_id = 0;
+    for (int n : num_items) {
+      std::vector<int64> op_ids;
+      for (int i = 0; i < n; ++i) op_ids.push_back(op_id++);
+      const int index = responses_.size();
+      responses_.emplace_back();
+      statuses_.emplace_back(errors::Unknown("Not called"));
+      batch_.Add(MakeRequest(op_ids), &responses_[index],
+                 [this, index](const Status& s) { statuses_[index] = s; });
+    }
+  }
+
+  // Returns the items whose response was given to request "index".
+  std::vector<string> ResponseItems(int index) {
+    std::vector<string> items;
+    for (const QueueResponse& response : responses_[index].queue_response()) {
+      items.push_back(response.device(0));
+    }
+    return items;
+  }
+
+  EnqueueBatch batch_{kContextId, /*batch_id=*/3};
+  // A deque, since the batch keeps pointers to the responses.
+  std::deque<EnqueueResponse> responses_;
+  std::vector<Status> statuses_;
+};
+
+TEST_F(EnqueueBatchTest, CoalescesRequestsInOrder) {
+  AddRequests({2, 1, 3});
+  EXPECT_EQ(3, batch_.batch_id());
+  EXPECT_EQ(3, batch_.num_requests());
+  EXPECT_EQ(MakeRequest({0, 1}).ByteSizeLong() +
+                MakeRequest({2}).ByteSizeLong() +
+                MakeRequest({3, 4, 5}).ByteSizeLong(),
+            batch_.bytes());
+
+  const EnqueueRequest& request = batch_.request();
+  EXPECT_EQ(kContextId, request.context_id());
+  EXPECT_TRUE(request.report_item_status());
+  ASSERT_EQ(6, request.queue_size());
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(i, request.queue(i).operation().id());
+  }
+}
+
+TEST_F(EnqueueBatchTest, SplitsResponses) {
+  AddRequests({2, 1, 3});
+  for (int i = 0; i < 6; ++i) AddQueueResponse(batch_.mutable_response(), i);
+  batch_.Finish(Status::OK());
+
+  for (const Status& s : statuses_) TF_EXPECT_OK(s);
+  EXPECT_EQ(std::vector<string>({"0", "1"}), ResponseItems(0));
+  EXPECT_EQ(std::vector<string>({"2"}), ResponseItems(1));
+  EXPECT_EQ(std::vector<string>({"3", "4", "5"}), ResponseItems(2));
+}
+
+TEST_F(EnqueueBatchTest, ReportsItemErrorToItsRequest) {
+  AddRequests({2, 2, 1});
+  // The third item fails: the service stops after its response.
+  EnqueueResponse* response = batch_.mutable_response();
+  for (int i = 0; i < 3; ++i) AddQueueResponse(response, i);
+  response->set_status_code(error::INVALID_ARGUMENT);
+  response->set_status_error_message("Bad op");
+  batch_.Finish(Status::OK());
+
+  TF_EXPECT_OK(statuses_[0]);
+  EXPECT_EQ(std::vector<string>({"0", "1"}), ResponseItems(0));
+  EXPECT_EQ(error::INVALID_ARGUMENT, statuses_[1].code());
+  EXPECT_EQ("Bad op", statuses_[1].error_message());
+  EXPECT_EQ(error::INVALID_ARGUMENT, statuses_[2].code());
+  EXPECT_NE("Bad op", statuses_[2].error_message());
+  EXPECT_TRUE(ResponseItems(2).empty());
+}
+
+TEST_F(EnqueueBatchTest, ReportsCallErrorToAllRequests) {
+  AddRequests({1, 2});
+  batch_.Finish(errors::Unavailable("Stream removed"));
+  for (const Status& s : statuses_) {
+    EXPECT_EQ(error::UNAVAILABLE, s.code());
+  }
+  EXPECT_TRUE(ResponseItems(0).empty());
+  EXPECT_TRUE(ResponseItems(1).empty());
+}
+
+TEST_F(EnqueueBatchTest, MissingResponsesAreAnError) {
+  AddRequests({1, 2});
+  AddQueueResponse(batch_.mutable_response(), 0);
+  batch_.Finish(Status::OK());
+  for (const Status& s : statuses_) {
+    EXPECT_EQ(error::INTERNAL, s.code());
+  }
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
+#include "absl/memory/memory.h"
 #include "grpcpp/generic/generic_stub.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/rpc/eager/enqueue_batch.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
@@ -63,6 +65,32 @@ bool EnableStreaming() {
   return result;
 }
 
+// Setting "TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH_WINDOW_US" to a positive
+// value coalesces the streaming enqueue requests made within that many
+// microseconds of the first one into a single message on the stream, up to
+// "TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH_BYTES" (default 1MB) of requests.
+// This saves one message and one server-side dispatch per remote op, at the
+// cost of up to one window of latency.
+int64 StreamingBatchWindowMicros() {
+  static const int64 window_us = [] {
+    int64 result;
+    TF_CHECK_OK(ReadInt64FromEnvVar(
+        "TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH_WINDOW_US", 0, &result));
+    return result;
+  }();
+  return window_us;
+}
+
+int64 StreamingBatchMaxBytes() {
+  static const int64 max_bytes = [] {
+    int64 result;
+    TF_CHECK_OK(ReadInt64FromEnvVar(
+        "TF_EAGER_CLIENT_STREAMING_ENQUEUE_BATCH_BYTES", 1 << 20, &result));
+    return result;
+  }();
+  return max_bytes;
+}
+
 // Ref-counted thread to handle callbacks for completed requests a GRPC
 // completion queue. The thread might be shared by multiple eager clients, and
 // each one of them should hold a reference count to ensure that the thread
@@ -169,6 +197,10 @@ class GrpcEagerClient : public EagerClient {
             << request->DebugString();
 
     mutex_lock l(mu_);
+    if (enqueue_batches_.find(request->context_id()) !=
+        enqueue_batches_.end()) {
+      FlushEnqueueBatchLocked(request->context_id());
+    }
     const auto& it = enqueue_dispatchers_.find(request->context_id());
     if (it != enqueue_dispatchers_.end()) {
       it->second.CancelCall();
@@ -184,20 +216,14 @@ class GrpcEagerClient : public EagerClient {
                              EnqueueResponse* response,
                              StatusCallback done) override {
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
-    if (EnableStreaming()) {
+    if (EnableStreaming() && StreamingBatchWindowMicros() > 0) {
+      mutex_lock l(mu_);
+      AddToEnqueueBatchLocked(*request, response, std::move(done_wrapped));
+    } else if (EnableStreaming()) {
       mutex_lock l(mu_);
-      auto it = enqueue_dispatchers_.find(request->context_id());
-      if (it == enqueue_dispatchers_.end()) {
-        auto it_and_bool = enqueue_dispatchers_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(request->context_id()),
-            std::forward_as_tuple(
-                &stub_, cq_,
-                "/tensorflow.eager.EagerService/StreamingEnqueue"));
-        it = it_and_bool.first;
-      }
       // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
-      it->second.SendNextRequest(*request, response, std::move(done_wrapped));
+      GetEnqueueDispatcherLocked(request->context_id())
+          ->SendNextRequest(*request, response, std::move(done_wrapped));
     } else {
       Notification n;
       Status status;
@@ -223,6 +249,73 @@ class GrpcEagerClient : public EagerClient {
   std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
       enqueue_dispatchers_ TF_GUARDED_BY(mu_);
 
+  // The batches of streaming enqueue requests being filled, by context id.
+  std::unordered_map<uint64, std::unique_ptr<EnqueueBatch>> enqueue_batches_
+      TF_GUARDED_BY(mu_);
+  uint64 next_batch_id_ TF_GUARDED_BY(mu_) = 0;
+
+  StreamingRPCDispatcher<EnqueueResponse>* GetEnqueueDispatcherLocked(
+      uint64 context_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = enqueue_dispatchers_.find(context_id);
+    if (it == enqueue_dispatchers_.end()) {
+      it = enqueue_dispatchers_
+               .emplace(std::piecewise_construct,
+                        std::forward_as_tuple(context_id),
+                        std::forward_as_tuple(
+                            &stub_, cq_,
+                            "/tensorflow.eager.EagerService/StreamingEnqueue"))
+               .first;
+    }
+    return &it->second;
+  }
+
+  // Adds "request" to the batch of its context, which is sent once it is full
+  // or its window has passed.
+  void AddToEnqueueBatchLocked(const EnqueueRequest& request,
+                               EnqueueResponse* response, StatusCallback done)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const uint64 context_id = request.context_id();
+    std::unique_ptr<EnqueueBatch>& batch = enqueue_batches_[context_id];
+    const bool new_batch = batch == nullptr;
+    if (new_batch) {
+      batch = absl::make_unique<EnqueueBatch>(context_id, next_batch_id_++);
+    }
+    batch->Add(request, response, std::move(done));
+
+    if (batch->bytes() >= StreamingBatchMaxBytes()) {
+      FlushEnqueueBatchLocked(context_id);
+    } else if (new_batch) {
+      Ref();
+      Env::Default()->SchedClosureAfter(
+          StreamingBatchWindowMicros(),
+          [this, context_id, batch_id = batch->batch_id()]() {
+            {
+              mutex_lock l(mu_);
+              auto it = enqueue_batches_.find(context_id);
+              if (it != enqueue_batches_.end() &&
+                  it->second->batch_id() == batch_id) {
+                FlushEnqueueBatchLocked(context_id);
+              }
+            }
+            Unref();
+          });
+    }
+  }
+
+  // Sends the batch of "context_id" as one request, and splits the response
+  // between the requests of the batch.
+  void FlushEnqueueBatchLocked(uint64 context_id)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = enqueue_batches_.find(context_id);
+    std::shared_ptr<EnqueueBatch> batch(std::move(it->second));
+    enqueue_batches_.erase(it);
+    VLOG(3) << "Sending " << batch->num_requests()
+            << " coalesced enqueue requests of context " << context_id;
+    GetEnqueueDispatcherLocked(context_id)
+        ->SendNextRequest(batch->request(), batch->mutable_response(),
+                          [batch](const Status& s) { batch->Finish(s); });
+  }
+
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
     return [this, done = std::move(done)](const Status& status) {
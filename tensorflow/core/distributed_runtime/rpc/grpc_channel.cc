@@ -133,6 +133,12 @@ const ::grpc::ChannelArguments* GetDefaultChannelArguments() {
       VLOG(5) << "Disabling TCP connection sharing";
       args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, true);
     }
+    if (rpc_options->num_channels_per_target() > 1 ||
+        rpc_options->num_tensor_channels_per_target() > 0) {
+      // Otherwise all the channels to a target share one connection.
+      VLOG(5) << "Using one TCP connection per channel";
+      args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, true);
+    }
   }
   return args;
 }
@@ -163,6 +169,21 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
   };
 }
 
+ChannelCreationFunction ConvertToChannelCreationFunction(
+    const std::function<Status(string, const RPCOptions*,
+                               SharedGrpcChannelPtr*)>& new_channel_func_ptr,
+    const RPCOptions& rpc_options) {
+  return [new_channel_func_ptr,
+          rpc_options](const string& target) -> SharedGrpcChannelPtr {
+    SharedGrpcChannelPtr channel_ptr;
+    if (new_channel_func_ptr(target, &rpc_options, &channel_ptr).ok()) {
+      return channel_ptr;
+    } else {
+      return nullptr;
+    }
+  };
+}
+
 Status GrpcChannelSpec::AddHostPortsJob(const string& job_id,
                                         const std::vector<string>& host_ports) {
   std::map<int, string> host_ports_map;
@@ -195,8 +216,11 @@ using CachingGrpcChannelCache = GenericCachingChannelCache<GrpcChannelCache>;
 class MultiGrpcChannelCache : public CachingGrpcChannelCache {
  public:
   explicit MultiGrpcChannelCache(const std::vector<GrpcChannelCache*>& caches,
-                                 int num_channels_per_target)
-      : CachingGrpcChannelCache(num_channels_per_target), caches_(caches) {}
+                                 int num_channels_per_target,
+                                 int num_tensor_channels_per_target)
+      : CachingGrpcChannelCache(num_channels_per_target,
+                                num_tensor_channels_per_target),
+        caches_(caches) {}
 
   ~MultiGrpcChannelCache() override {
     for (GrpcChannelCache* cache : caches_) {
@@ -248,6 +272,18 @@ class MultiGrpcChannelCache : public CachingGrpcChannelCache {
     return nullptr;
   }
 
+  SharedGrpcChannelPtr FindTensorChannelOnce(const string& target) override {
+    for (GrpcChannelCache* cache : caches_) {
+      SharedGrpcChannelPtr ch(cache->FindWorkerTensorChannel(target));
+      if (ch) {
+        mutex_lock l(mu_);
+        target_caches_.insert({target, cache});
+        return ch;
+      }
+    }
+    return nullptr;
+  }
+
  private:
   // List of channels used by this MultiGrpcChannelCache.
   const std::vector<GrpcChannelCache*> caches_;
@@ -264,8 +300,10 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   SparseGrpcChannelCache(const string& job_id,
                          const std::map<int, string>& host_ports,
                          ChannelCreationFunction channel_func,
-                         int num_channels_per_target)
-      : CachingGrpcChannelCache(num_channels_per_target),
+                         int num_channels_per_target,
+                         int num_tensor_channels_per_target)
+      : CachingGrpcChannelCache(num_channels_per_target,
+                                num_tensor_channels_per_target),
         job_id_(job_id),
         host_ports_(host_ports),
         channel_func_(std::move(channel_func)) {
@@ -356,13 +394,16 @@ GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
   caches.reserve(num_jobs);
   for (auto& job : spec.host_ports_jobs()) {
     VLOG(2) << "Creating Grpc Channel Cache for: " << job.job_id;
-    caches.push_back(
-        new SparseGrpcChannelCache(job.job_id, job.host_ports, channel_func,
-                                   options.num_channels_per_target()));
+    caches.push_back(new SparseGrpcChannelCache(
+        job.job_id, job.host_ports, channel_func,
+        options.num_channels_per_target(),
+        options.num_tensor_channels_per_target()));
   }
-  return caches.size() == 1 ? caches[0]
-                            : new MultiGrpcChannelCache(
-                                  caches, options.num_channels_per_target());
+  return caches.size() == 1
+             ? caches[0]
+             : new MultiGrpcChannelCache(
+                   caches, options.num_channels_per_target(),
+                   options.num_tensor_channels_per_target());
 }
 
 }  // end namespace tensorflow
@@ -75,6 +75,12 @@ class GrpcChannelCache {
   // E.g., /job:mnist/task:2
   virtual SharedGrpcChannelPtr FindWorkerChannel(const string& target) = 0;
 
+  // Like FindWorkerChannel, but returns a channel for the RPCs that transfer
+  // tensors (RecvTensor and RecvBuf).  Defaults to FindWorkerChannel.
+  virtual SharedGrpcChannelPtr FindWorkerTensorChannel(const string& target) {
+    return FindWorkerChannel(target);
+  }
+
   // Translates a string in the form `/job:X/task:Z` into a host_port.
   virtual string TranslateTask(const string& task) = 0;
 };
@@ -93,6 +99,12 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
     const std::function<Status(string, const RPCOptions*,
                                SharedGrpcChannelPtr*)>& new_channel_func_ptr);
 
+// As above, but creates the channels with "rpc_options".
+ChannelCreationFunction ConvertToChannelCreationFunction(
+    const std::function<Status(string, const RPCOptions*,
+                               SharedGrpcChannelPtr*)>& new_channel_func_ptr,
+    const RPCOptions& rpc_options);
+
 Status NewHostPortGrpcChannel(const string& target,
                               const RPCOptions* rpc_options,
                               SharedGrpcChannelPtr* channel_pointer);
@@ -32,21 +32,61 @@ namespace tensorflow {
 // same target to provide throughput gains. When multiple channels exist for
 // the same target they are chosen in a simple round robin fashion on each call
 // to FindWorkerChannel.
+//
+// If num_tensor_channels_per_target is positive, FindWorkerTensorChannel
+// round-robins over a separate set of channels to each target, so that large
+// tensor transfers do not share connections with the other RPCs.
 template <typename ChannelCacheT>
 class GenericCachingChannelCache : public ChannelCacheT {
  public:
-  explicit GenericCachingChannelCache(int num_channels_per_target)
+  explicit GenericCachingChannelCache(int num_channels_per_target,
+                                      int num_tensor_channels_per_target = 0)
       : num_channels_per_target_(
-            num_channels_per_target > 0 ? num_channels_per_target : 1) {}
+            num_channels_per_target > 0 ? num_channels_per_target : 1),
+        num_tensor_channels_per_target_(
+            num_tensor_channels_per_target > 0 ? num_tensor_channels_per_target
+                                               : 0) {}
 
   ~GenericCachingChannelCache() override {}
 
   SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
+    return FindOrCreateChannel(target, /*tensor_channel=*/false);
+  }
+
+  SharedGrpcChannelPtr FindWorkerTensorChannel(const string& target) override {
+    if (num_tensor_channels_per_target_ == 0) {
+      return FindWorkerChannel(target);
+    }
+    return FindOrCreateChannel(target, /*tensor_channel=*/true);
+  }
+
+ protected:
+  // Find the ClientChannel for "target".  Only called when no channel was
+  // found in the channels_ cache for "target".  A non nullptr result will be
+  // cached in channels_.
+  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
+
+  // Like FindChannelOnce, for the channels returned by
+  // FindWorkerTensorChannel.
+  virtual SharedGrpcChannelPtr FindTensorChannelOnce(const string& target) {
+    return FindChannelOnce(target);
+  }
+
+ private:
+  struct ChannelState {
+    std::vector<SharedGrpcChannelPtr> channels;
+    int last_used;
+    std::vector<SharedGrpcChannelPtr> tensor_channels;
+    int last_tensor_used;
+  };
+
+  SharedGrpcChannelPtr FindOrCreateChannel(const string& target,
+                                           bool tensor_channel) {
     {
       mutex_lock l(mu_);
       auto iter = channels_.find(target);
       if (iter != channels_.end()) {
-        return GetNextChannelPtrAndUpdateState(iter->second);
+        return GetNextChannelPtrAndUpdateState(iter->second, tensor_channel);
       }
     }
     ChannelState new_chan_state;
@@ -56,6 +96,12 @@ class GenericCachingChannelCache : public ChannelCacheT {
       new_chan_state.channels.push_back(ch);
     }
     new_chan_state.last_used = num_channels_per_target_ - 1;
+    for (int indx = 0; indx < num_tensor_channels_per_target_; indx++) {
+      auto ch = FindTensorChannelOnce(target);
+      if (!ch) return nullptr;
+      new_chan_state.tensor_channels.push_back(ch);
+    }
+    new_chan_state.last_tensor_used = num_tensor_channels_per_target_ - 1;
 
     {
       mutex_lock l(mu_);
@@ -64,26 +110,24 @@ class GenericCachingChannelCache : public ChannelCacheT {
       std::tie(iter, was_inserted) = channels_.insert({target, new_chan_state});
       VLOG(2) << "Channel cache for target: " << target
               << " Size: " << new_chan_state.channels.size()
+              << " Tensor channels: " << new_chan_state.tensor_channels.size()
               << " insertion: " << was_inserted;
-      return GetNextChannelPtrAndUpdateState(iter->second);
+      return GetNextChannelPtrAndUpdateState(iter->second, tensor_channel);
     }
   }
 
- protected:
-  // Find the ClientChannel for "target".  Only called when no channel was
-  // found in the channels_ cache for "target".  A non nullptr result will be
-  // cached in channels_.
-  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
-
- private:
-  struct ChannelState {
-    std::vector<SharedGrpcChannelPtr> channels;
-    int last_used;
-  };
-
   // Should be called with mu_ held.
   SharedGrpcChannelPtr GetNextChannelPtrAndUpdateState(
-      ChannelState& chan_state) {
+      ChannelState& chan_state, bool tensor_channel) {
+    if (tensor_channel) {
+      // Following statement is marked as Crash OK as this is an invariant of
+      // code flow in this class.
+      CHECK_EQ(chan_state.tensor_channels.size(),  // Crash OK
+               num_tensor_channels_per_target_);
+      chan_state.last_tensor_used =
+          (chan_state.last_tensor_used + 1) % num_tensor_channels_per_target_;
+      return chan_state.tensor_channels[chan_state.last_tensor_used];
+    }
     // Following statement is marked as Crash OK as this is an invariant of
     // code flow in this class.
     CHECK_EQ(chan_state.channels.size(), num_channels_per_target_);  // Crash OK
@@ -93,6 +137,7 @@ class GenericCachingChannelCache : public ChannelCacheT {
   }
 
   const int num_channels_per_target_;
+  const int num_tensor_channels_per_target_;
   // TODO(zhifengc): Eviction when the map becomes too big.
   mutex mu_;
   absl::flat_hash_map<string, ChannelState> channels_ TF_GUARDED_BY(mu_);
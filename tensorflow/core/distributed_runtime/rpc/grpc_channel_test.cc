@@ -119,6 +119,52 @@ TEST(GrpcChannelTest, HostPorts) {
   }
 }
 
+TEST(GrpcChannelTest, HostPortsSeparateTensorChannels) {
+  GrpcChannelSpec spec;
+  TF_EXPECT_OK(
+      spec.AddHostPortsJob("mnist", std::vector<string>{"a:1", "b:2"}));
+  TF_EXPECT_OK(spec.AddHostPortsJob("mnist2", {"c:3"}));
+  RPCOptions rpc_options;
+  rpc_options.set_num_channels_per_target(2);
+  rpc_options.set_num_tensor_channels_per_target(3);
+  ChannelCreationFunction channel_func =
+      ConvertToChannelCreationFunction(NewHostPortGrpcChannel, rpc_options);
+  std::unique_ptr<GrpcChannelCache> cc(
+      NewGrpcChannelCache(spec, channel_func, rpc_options));
+
+  EXPECT_EQ(nullptr, cc->FindWorkerTensorChannel("invalid_target"));
+  EXPECT_EQ(nullptr,
+            cc->FindWorkerTensorChannel("/job:mnist/replica:0/task:3"));
+
+  for (const string& target :
+       {"/job:mnist/replica:0/task:0", "/job:mnist2/replica:0/task:0"}) {
+    std::vector<SharedGrpcChannelPtr> channels, tensor_channels;
+    for (int i = 0; i < 6; i++) {
+      channels.push_back(cc->FindWorkerChannel(target));
+      tensor_channels.push_back(cc->FindWorkerTensorChannel(target));
+    }
+
+    // Tensor channels are round-robined separately, every 3 calls.
+    for (int i = 0; i < 3; i++) {
+      EXPECT_EQ(tensor_channels[i].get(), tensor_channels[i + 3].get());
+      for (int j = 1; j < 3; j++) {
+        EXPECT_NE(tensor_channels[i].get(), tensor_channels[i + j].get());
+      }
+    }
+    for (int i = 0; i < 4; i++) {
+      EXPECT_EQ(channels[i].get(), channels[i + 2].get());
+      EXPECT_NE(channels[i].get(), channels[i + 1].get());
+    }
+
+    // The other RPCs never share a channel with tensor transfers.
+    for (const auto& channel : channels) {
+      for (const auto& tensor_channel : tensor_channels) {
+        EXPECT_NE(channel.get(), tensor_channel.get());
+      }
+    }
+  }
+}
+
 TEST(GrpcChannelTest, HostPortsMultiChannelPerTarget) {
   GrpcChannelSpec spec;
   TF_EXPECT_OK(spec.AddHostPortsJob("mnist", {"a:1", "b:2", "c:3"}));
@@ -43,11 +43,14 @@ namespace tensorflow {
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
+                            SharedGrpcChannelPtr tensor_channel,
                             ::grpc::CompletionQueue* completion_queue,
                             thread::ThreadPool* callback_threadpool,
                             WorkerCacheLogger* logger, const string& target)
       : channel_(std::move(channel)),
         stub_(channel_),
+        tensor_channel_(tensor_channel ? std::move(tensor_channel) : channel_),
+        tensor_stub_(tensor_channel_),
         cq_(completion_queue),
         callback_threadpool_(callback_threadpool),
         getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
@@ -169,7 +172,8 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvbuf_, callback, call_opts);
+    IssueRequest(request, response, recvbuf_, callback, call_opts,
+                 /*fail_fast=*/true, &tensor_stub_);
   }
 
   void CompleteGroupAsync(CallOptions* call_opts,
@@ -268,20 +272,24 @@ class GrpcRemoteWorker : public WorkerInterface {
  private:
   // Utility method for issuing a generic asynchronous request. The
   // given callback, `done`, will be called when the RPC completes.
+  // The request is sent on "stub" if not null, and on stub_ otherwise.
   void IssueRequest(const protobuf::Message* request,
                     protobuf::Message* response, const ::grpc::string& method,
                     StatusCallback done, CallOptions* call_opts = nullptr,
-                    bool fail_fast = true) {
+                    bool fail_fast = true,
+                    ::grpc::GenericStub* stub = nullptr) {
     new RPCState<protobuf::Message>(
-        &stub_, cq_, method, *request, response, std::move(done), call_opts,
-        callback_threadpool_, MaxRetries(), fail_fast, &target_);
+        stub != nullptr ? stub : &stub_, cq_, method, *request, response,
+        std::move(done), call_opts, callback_threadpool_, MaxRetries(),
+        fail_fast, &target_);
   }
 
+  // Only used for RecvTensor, so the request is sent on tensor_stub_.
   void IssueRequest(const protobuf::Message* request, TensorResponse* response,
                     const ::grpc::string& method, StatusCallback done,
                     CallOptions* call_opts = nullptr) {
-    new RPCState<TensorResponse>(&stub_, cq_, method, *request, response,
-                                 std::move(done), call_opts,
+    new RPCState<TensorResponse>(&tensor_stub_, cq_, method, *request,
+                                 response, std::move(done), call_opts,
                                  callback_threadpool_, MaxRetries(),
                                  /*fail_fast=*/true, &target_);
   }
@@ -309,6 +317,10 @@ class GrpcRemoteWorker : public WorkerInterface {
 
   SharedGrpcChannelPtr channel_;
   ::grpc::GenericStub stub_;
+  // Used for the RPCs that transfer tensors.  Same as channel_ unless a
+  // separate channel was given.
+  SharedGrpcChannelPtr tensor_channel_;
+  ::grpc::GenericStub tensor_stub_;
   ::grpc::CompletionQueue* cq_;
   thread::ThreadPool* callback_threadpool_;
 
@@ -341,8 +353,20 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger,
                                      const string& target) {
-  return new GrpcRemoteWorker(std::move(channel), completion_queue,
-                              callback_threadpool, logger, target);
+  return new GrpcRemoteWorker(std::move(channel), /*tensor_channel=*/nullptr,
+                              completion_queue, callback_threadpool, logger,
+                              target);
+}
+
+WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
+                                     SharedGrpcChannelPtr tensor_channel,
+                                     ::grpc::CompletionQueue* completion_queue,
+                                     thread::ThreadPool* callback_threadpool,
+                                     WorkerCacheLogger* logger,
+                                     const string& target) {
+  return new GrpcRemoteWorker(std::move(channel), std::move(tensor_channel),
+                              completion_queue, callback_threadpool, logger,
+                              target);
 }
 
 }  // namespace tensorflow
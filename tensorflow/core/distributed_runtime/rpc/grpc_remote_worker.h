@@ -32,6 +32,15 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      WorkerCacheLogger* logger,
                                      const string& target);
 
+// As above, but sends the RPCs that transfer tensors (RecvTensor and RecvBuf)
+// on "tensor_channel".
+WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
+                                     SharedGrpcChannelPtr tensor_channel,
+                                     ::grpc::CompletionQueue* completion_queue,
+                                     thread::ThreadPool* callback_threadpool,
+                                     WorkerCacheLogger* logger,
+                                     const string& target);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
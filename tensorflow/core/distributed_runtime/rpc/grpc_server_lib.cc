@@ -300,6 +300,8 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
         return WorkerCacheFactory(options, worker_cache);
       });
   worker_env_.compute_pool = ComputePool(sess_opts);
+  staleness_tracker_.reset(new StalenessTracker);
+  worker_env_.staleness_tracker = staleness_tracker_.get();
 
   // Finish setting up master environment.
   master_env_.ops = OpRegistry::Global();
@@ -375,7 +377,8 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
         "rpc_options not set in WorkerCacheFactoryOptions");
   }
   std::shared_ptr<GrpcChannelCache> channel_cache(NewGrpcChannelCache(
-      channel_spec, GetChannelCreationFunction(), *options.rpc_options));
+      channel_spec, GetChannelCreationFunction(*options.rpc_options),
+      *options.rpc_options));
 
   string name_prefix = strings::StrCat("/job:", *options.job_name, "/replica:0",
                                        "/task:", options.task_index);
@@ -519,6 +522,22 @@ ChannelCreationFunction GrpcServer::GetChannelCreationFunction() const {
   return ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
 }
 
+ChannelCreationFunction GrpcServer::GetChannelCreationFunction(
+    const RPCOptions& rpc_options) const {
+  if (rpc_options.num_channels_per_target() <= 1 &&
+      rpc_options.num_tensor_channels_per_target() <= 0) {
+    return GetChannelCreationFunction();
+  }
+  // Only the number of channels applies to the channels between workers.
+  RPCOptions channel_options;
+  channel_options.set_num_channels_per_target(
+      rpc_options.num_channels_per_target());
+  channel_options.set_num_tensor_channels_per_target(
+      rpc_options.num_tensor_channels_per_target());
+  return ConvertToChannelCreationFunction(NewHostPortGrpcChannel,
+                                          channel_options);
+}
+
 std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
   return std::unique_ptr<Master>(new Master(master_env, 0.0));
 }
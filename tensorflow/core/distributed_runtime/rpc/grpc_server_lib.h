@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 #include "tensorflow/core/distributed_runtime/server_lib.h"
 #include "tensorflow/core/distributed_runtime/session_mgr.h"
+#include "tensorflow/core/distributed_runtime/staleness_tracker.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/op.h"
@@ -122,6 +123,14 @@ class GrpcServer : public ServerInterface {
 
   virtual ChannelCreationFunction GetChannelCreationFunction() const;
 
+  // Returns the function that creates the channels of a worker cache
+  // configured with "rpc_options".  By default, this is
+  // GetChannelCreationFunction(), unless several channels are opened to each
+  // target, in which case each channel gets its own connection.  A subclass
+  // that overrides GetChannelCreationFunction() should override this too.
+  virtual ChannelCreationFunction GetChannelCreationFunction(
+      const RPCOptions& rpc_options) const;
+
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
   // Creates a WorkerCacheInterface for a session.
@@ -176,6 +185,7 @@ class GrpcServer : public ServerInterface {
   // Implementation of a TensorFlow worker, and RPC polling thread.
   WorkerEnv worker_env_;
   std::unique_ptr<const DeviceMgr> owned_device_manager_;
+  std::unique_ptr<StalenessTracker> staleness_tracker_;
   std::unique_ptr<GrpcWorker> worker_impl_;
   AsyncServiceInterface* worker_service_ = nullptr;
   std::unique_ptr<Thread> worker_thread_ TF_GUARDED_BY(mu_);
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 
+#include <vector>
+
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
 #include "absl/flags/flag.h"
@@ -23,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
 #include "tensorflow/core/platform/env.h"
@@ -137,8 +140,107 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 #endif
 }
 
+// Returns a slice that takes ownership of the contents of "*data", so that
+// they are handed to gRPC without another copy.
+static ::grpc::Slice MakeOwnedSlice(string* data) {
+  string* owned = new string(std::move(*data));
+  data->clear();
+  return ::grpc::Slice(
+      const_cast<char*>(owned->data()), owned->size(),
+      [](void* backing) { delete static_cast<string*>(backing); }, owned);
+}
+
+// Encodes a DT_STRING "val" into "*result", given the encoding of
+// RecvTensorResponse "header" without its tensor() field.
+//
+// The tensor data is the TensorProto::tensor_content encoding of a string
+// tensor: the varint32 sizes of all the elements followed by their
+// concatenated data. Elements larger than "large_string_bytes" that own their
+// storage are not copied; their slices share the backing store of "val", as
+// in (E) for other types. Runs of smaller elements are copied together into
+// owned slices.
+static void EncodeStringTensorToByteBuffer(const string& header,
+                                           const Tensor& val,
+                                           size_t large_string_bytes,
+                                           ::grpc::ByteBuffer* result) {
+  const auto strings = val.flat<tstring>();
+  string sizes;
+  size_t data_bytes = 0;
+  for (int64 i = 0; i < strings.size(); ++i) {
+    core::PutVarint32(&sizes, strings(i).size());
+    data_bytes += strings(i).size();
+  }
+
+  gtl::InlinedVector<char, 128> skeleton(SkeletonEncodingSizeUpperBound(val));
+  io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
+  EncodeSkeleton(val, &e_skeleton);
+
+  const size_t content_bytes = sizes.size() + data_bytes;
+  uint32 overall_tensor_proto_bytesize =
+      (e_skeleton.size() +
+       VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
+                             content_bytes));
+  size_t expected_size =
+      (header.size() +
+       VarLengthEncodingSize(RecvTensorResponse::kTensorFieldNumber,
+                             overall_tensor_proto_bytesize));
+
+  gtl::InlinedVector<char, 1024> space(expected_size - content_bytes);
+  io::ProtoEncodeHelper e(space.data(), space.size());
+  // (A)
+  e.WriteRawBytes(header);
+  // (B1) & (B2)
+  e.WriteVarlengthBeginning(RecvTensorResponse::kTensorFieldNumber,
+                            overall_tensor_proto_bytesize);
+  // (C)
+  e.WriteRawBytes(StringPiece(e_skeleton.data(), e_skeleton.size()));
+  // (D1) & (D2)
+  e.WriteVarlengthBeginning(TensorProto::kTensorContentFieldNumber,
+                            content_bytes);
+
+  // (E) "pending" holds everything since the last shared slice.
+  std::vector<::grpc::Slice> slices;
+  string pending(e.data(), e.size());
+  pending.append(sizes);
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  for (int64 i = 0; i < strings.size(); ++i) {
+    const tstring& element = strings(i);
+    if (element.size() <= large_string_bytes ||
+        element.type() != tstring::LARGE) {
+      pending.append(element.data(), element.size());
+      continue;
+    }
+    if (!pending.empty()) {
+      slices.push_back(MakeOwnedSlice(&pending));
+    }
+    buf->Ref();
+    slices.push_back(::grpc::Slice(
+        const_cast<char*>(element.data()), element.size(),
+        [](void* backing) { static_cast<TensorBuffer*>(backing)->Unref(); },
+        const_cast<TensorBuffer*>(buf)));
+  }
+  if (!pending.empty()) {
+    slices.push_back(MakeOwnedSlice(&pending));
+  }
+
+  size_t total_bytes = 0;
+  for (const auto& slice : slices) {
+    total_bytes += slice.size();
+  }
+  CHECK_EQ(total_bytes, expected_size);
+
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val, require_ack, DT_INVALID, result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              DataType uncompressed_dtype,
+                              ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
   const int64 kProtoBufLimitBytes = 1LL << 31;
 
@@ -155,7 +257,14 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
   response.set_require_ack(require_ack);
   response.set_send_start_micros(Env::Default()->NowMicros());
-  if (!DataTypeCanUseMemcpy(val.dtype())) {
+  if (uncompressed_dtype != DT_INVALID) {
+    response.set_uncompressed_dtype(uncompressed_dtype);
+  }
+  if (val.dtype() == DT_STRING) {
+    string header;  // All of RecvTensorResponse except the tensor() field
+    response.AppendToString(&header);
+    EncodeStringTensorToByteBuffer(header, val, kLargeTensorBytes, result);
+  } else if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
     // go directly from val -> ByteBuffer, with some effort.
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/framework/types.pb.h"
 
 namespace tensorflow {
 class Tensor;
@@ -49,6 +50,12 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// As above, for a tensor that was downcast from "uncompressed_dtype" (see
+// RecvTensorResponse::uncompressed_dtype).
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
+                              DataType uncompressed_dtype,
+                              ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
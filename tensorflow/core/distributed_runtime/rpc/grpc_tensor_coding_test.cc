@@ -100,4 +100,23 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, LargeStringTensor) {
+  Tensor t(DT_STRING, TensorShape({4}));
+  test::FillValues<tstring>(&t, {"small", string(100000, 'a'), "",
+                                 string(2000, 'b')});
+  Validate(t, false);
+
+  // The large elements share the backing store of the tensor, so they are
+  // in slices of their own.
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, false, &buf);
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  ASSERT_EQ(slices.size(), 3);
+  EXPECT_EQ(slices[1].begin(),
+            reinterpret_cast<const uint8_t*>(t.flat<tstring>()(1).data()));
+  EXPECT_EQ(slices[2].begin(),
+            reinterpret_cast<const uint8_t*>(t.flat<tstring>()(3).data()));
+}
+
 }  // namespace tensorflow
@@ -58,9 +58,14 @@ class GrpcWorkerCache : public WorkerCachePartial {
       if (!channel) {
         return nullptr;
       }
+      SharedGrpcChannelPtr tensor_channel =
+          channel_cache_->FindWorkerTensorChannel(target);
+      if (!tensor_channel) {
+        return nullptr;
+      }
       size_t index = AssignWorkerToThread(target);
       return NewGrpcRemoteWorker(
-          channel, worker_env_->GetCompletionQueue(index),
+          channel, tensor_channel, worker_env_->GetCompletionQueue(index),
           worker_env_->GetThreadPool(), &logger_, target);
     }
   }
@@ -423,7 +423,8 @@ GrpcWorker::GrpcWorker(WorkerEnv* worker_env, const ConfigProto& config)
       recv_buf_max_chunk_(
           config.experimental().recv_buf_max_chunk() > 0
               ? config.experimental().recv_buf_max_chunk()
-              : (config.experimental().recv_buf_max_chunk() < 0 ? 0 : 4096)) {
+              : (config.experimental().recv_buf_max_chunk() < 0 ? 0 : 4096)),
+      recv_tensor_compression_(config.rpc_options()) {
   if (config.rpc_options().cache_rpc_response()) {
     EnableResponseCache();
   }
@@ -447,10 +448,30 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
-    if (status.ok()) {
+  const bool compression_ok =
+      request->compression_ok() && !recv_tensor_compression_.empty();
+  auto do_response = [this, request, response, done, cache_enabled,
+                      compression_ok](const Tensor& tensor, bool is_dead,
+                                      const Status& status) {
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+    const DataType compressed_dtype =
+        compression_ok && !is_dead
+            ? recv_tensor_compression_.CompressedDtype(
+                  request->rendezvous_key(), tensor)
+            : DT_INVALID;
+    if (compressed_dtype != DT_INVALID) {
+      Tensor compressed;
+      Status s = CompressRecvTensor(tensor, compressed_dtype, &compressed);
+      if (!s.ok()) {
+        done(s);
+        return;
+      }
+      grpc::EncodeTensorToByteBuffer(is_dead, compressed, cache_enabled,
+                                     tensor.dtype(), response);
+    } else {
       grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
     }
     done(status);
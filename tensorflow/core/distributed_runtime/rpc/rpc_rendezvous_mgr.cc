@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/recv_tensor_compression.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
@@ -70,6 +71,10 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    // Compressed tensors are decompressed on the CPU, so only accept them
+    // when receiving into host memory.
+    req_.set_compression_ok(alloc_attrs.on_host() ||
+                            dst_device->device_type() == DEVICE_CPU);
   }
 
   void Reset() {
@@ -84,6 +89,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     // opts_ appropriately.
     req_.Clear();
     resp_.Clear();
+    decompressed_tensor_ = Tensor();
     {
       mutex_lock l(mu_);
       status_ = Status::OK();
@@ -123,7 +129,11 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_ = nullptr;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  const Tensor& tensor() const {
+    return resp_.metadata().uncompressed_dtype() != DT_INVALID
+               ? decompressed_tensor_
+               : resp_.tensor();
+  }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
 
@@ -143,9 +153,15 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
       // Make sure the Rendezvous abort checking is finished before running the
       // callback, which might destroy the current call object.
       abort_checked->WaitForNotification();
-      if (!s.ok()) {
+      Status status = s;
+      if (status.ok() && resp_.metadata().uncompressed_dtype() != DT_INVALID) {
+        status = DecompressRecvTensor(
+            resp_.tensor(), resp_.metadata().uncompressed_dtype(),
+            dst_device_->GetAllocator(alloc_attrs_), &decompressed_tensor_);
+      }
+      if (!status.ok()) {
         mutex_lock l(mu_);
-        status_.Update(s);
+        status_.Update(status);
       }
       recv_done();
     };
@@ -176,6 +192,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   CallOptions opts_;
   RecvTensorRequest req_;
   TensorResponse resp_;
+  Tensor decompressed_tensor_;
   Rendezvous::Args recv_args_;
   Rendezvous::DoneCallback done_;
 
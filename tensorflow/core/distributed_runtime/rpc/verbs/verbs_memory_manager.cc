@@ -0,0 +1,684 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_memory_manager.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <rdma/rdma_cma.h>
+#include <rdma/rdma_verbs.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#endif  // GOOGLE_CUDA
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs.pb.h"
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+
+namespace {
+
+// All queue pairs share a single completion queue, which must be large
+// enough for the outstanding work requests of every connection.
+constexpr int kCompletionQueueSize = 64 * 1024;
+constexpr int kMaxSendWorkRequests = 256;
+// Number of receives posted on each accepted connection, for the messages
+// releasing pinned tensors.
+constexpr int kNumReleaseReceives = 64;
+constexpr int kMaxCompletionsPerPoll = 32;
+constexpr int kListenBacklog = 128;
+constexpr int kPollTimeoutMs = 10;
+// Pinned tensors are normally released by the receiver or by the cleanup of
+// their step. The timeout only bounds the pins of steps that are never
+// cleaned up.
+constexpr uint64 kPinTimeoutMicros = 10 * 60 * 1000 * 1000ull;
+constexpr uint64 kPinExpiryIntervalMicros = 1000 * 1000;
+
+Status ErrnoError(const string& what) {
+  return errors::Unavailable(what, " failed: ", strerror(errno));
+}
+
+Status SetNonBlocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    return ErrnoError("fcntl");
+  }
+  return Status::OK();
+}
+
+class VerbsMemoryManager;
+
+// A connected queue pair. Send work requests (RDMA reads and release
+// messages) beyond kMaxSendWorkRequests are queued until completions come
+// back.
+struct Endpoint {
+  explicit Endpoint(rdma_cm_id* id) : id(id) {}
+
+  rdma_cm_id* const id;
+
+  // Registered buffers for the release messages of an accepted connection.
+  std::vector<uint32> release_buffers;
+  ibv_mr* release_mr = nullptr;
+
+  mutex mu;
+  int outstanding_sends TF_GUARDED_BY(mu) = 0;
+  std::deque<std::function<int()>> pending_sends TF_GUARDED_BY(mu);
+};
+
+// The context of a work request, passed through ibv_wc::wr_id together with
+// its WorkRequestKind.
+struct WorkRequest {
+  Endpoint* endpoint;
+  // For receives of release messages: the index in release_buffers.
+  int release_index = -1;
+  // For RDMA reads: called when the read completes.
+  StatusCallback done;
+};
+
+// The rdma_post_* functions use their context argument as the wr_id.
+void* WorkRequestContext(const WorkRequest* request, WorkRequestKind kind) {
+  return reinterpret_cast<void*>(EncodeWorkRequestId(request, kind));
+}
+
+class VerbsMemoryManager : public RemoteMemoryManager {
+ public:
+  VerbsMemoryManager(const string& host, const string& port)
+      : host_(host), port_(port), pinned_tensors_(kPinTimeoutMicros) {}
+
+  ~VerbsMemoryManager() override;
+
+  Status Init() override;
+  void Run() override;
+  void Stop() override;
+
+  void TransportOptionsFromTensor(
+      ::google::protobuf::Any* mutable_transport_options, const Tensor& tensor,
+      Device* device, DeviceContext* device_context, bool on_host,
+      int64 step_id, StatusCallback done) override;
+
+  void TensorFromTransportOptions(
+      Tensor* tensor, const ::google::protobuf::Any& transport_options,
+      Device* device, DeviceContext* device_context,
+      const AllocatorAttributes& alloc_attrs, StatusCallback done) override;
+
+  void ReleaseStep(int64 step_id) override;
+
+ private:
+  ibv_qp_init_attr QueuePairAttributes() const;
+
+  // Alloc and free visitors of the registered allocators.
+  void RegisterMemoryRegion(void* ptr, size_t num_bytes);
+  void DeregisterMemoryRegion(void* ptr, size_t num_bytes);
+
+  // Returns the memory region containing [addr, addr + length), or nullptr.
+  ibv_mr* FindMemoryRegion(const void* addr, size_t length);
+
+  // Returns a host allocator whose memory is registered.
+  Allocator* RegisteredHostAllocator() const;
+
+  // Pins a host tensor in registered memory for a remote read.
+  void PinTensor(const Tensor& tensor, ibv_mr* mr, int64 step_id,
+                 ::google::protobuf::Any* mutable_transport_options);
+
+  Status GetOrConnectEndpoint(const string& host, const string& port,
+                              Endpoint** endpoint);
+  Status AcceptEndpoint();
+  void PostReleaseReceive(Endpoint* endpoint, int index);
+
+  // Posts a send work request built by "post", or queues it if the send
+  // queue of "endpoint" is full. "post" returns 0 on success.
+  void PostSend(Endpoint* endpoint, std::function<int()> post);
+  void OnSendCompleted(Endpoint* endpoint);
+
+  void PollCompletions();
+
+  const string host_;
+  const string port_;
+
+  rdma_cm_id* listening_ = nullptr;
+  ibv_pd* pd_ = nullptr;
+  ibv_comp_channel* event_channel_ = nullptr;
+  ibv_cq* cq_ = nullptr;
+
+  std::atomic<bool> stopped_{false};
+  std::unique_ptr<Thread> thread_;
+
+  mutex mrs_mu_;
+  // Registered memory regions, keyed by start address.
+  std::map<uintptr_t, ibv_mr*> mrs_ TF_GUARDED_BY(mrs_mu_);
+
+  mutex endpoints_mu_;
+  absl::flat_hash_map<string, std::unique_ptr<Endpoint>> clients_
+      TF_GUARDED_BY(endpoints_mu_);
+  std::vector<std::unique_ptr<Endpoint>> accepted_
+      TF_GUARDED_BY(endpoints_mu_);
+
+  PinnedTensorTable pinned_tensors_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(VerbsMemoryManager);
+};
+
+VerbsMemoryManager::~VerbsMemoryManager() {
+  Stop();
+  {
+    mutex_lock l(endpoints_mu_);
+    for (auto& client : clients_) {
+      rdma_disconnect(client.second->id);
+      rdma_destroy_ep(client.second->id);
+    }
+    for (auto& endpoint : accepted_) {
+      rdma_disconnect(endpoint->id);
+      if (endpoint->release_mr != nullptr) rdma_dereg_mr(endpoint->release_mr);
+      rdma_destroy_ep(endpoint->id);
+    }
+  }
+  if (cq_ != nullptr) ibv_destroy_cq(cq_);
+  if (event_channel_ != nullptr) ibv_destroy_comp_channel(event_channel_);
+  // Memory regions stay registered: the allocators outlive this object.
+  if (listening_ != nullptr) rdma_destroy_ep(listening_);
+}
+
+ibv_qp_init_attr VerbsMemoryManager::QueuePairAttributes() const {
+  ibv_qp_init_attr attr = {};
+  attr.qp_type = IBV_QPT_RC;
+  attr.send_cq = cq_;
+  attr.recv_cq = cq_;
+  attr.cap.max_send_wr = kMaxSendWorkRequests;
+  attr.cap.max_recv_wr = kNumReleaseReceives;
+  attr.cap.max_send_sge = 1;
+  attr.cap.max_recv_sge = 1;
+  attr.cap.max_inline_data = sizeof(uint32);
+  attr.sq_sig_all = 1;
+  return attr;
+}
+
+Status VerbsMemoryManager::Init() {
+  rdma_addrinfo hints = {};
+  hints.ai_flags = RAI_PASSIVE;
+  hints.ai_port_space = RDMA_PS_TCP;
+  rdma_addrinfo* addrinfo;
+  if (rdma_getaddrinfo(const_cast<char*>(host_.c_str()),
+                       const_cast<char*>(port_.c_str()), &hints,
+                       &addrinfo) != 0) {
+    return ErrnoError(strings::StrCat("rdma_getaddrinfo ", host_, ":", port_));
+  }
+  const int ret = rdma_create_ep(&listening_, addrinfo, nullptr, nullptr);
+  rdma_freeaddrinfo(addrinfo);
+  if (ret != 0) return ErrnoError("rdma_create_ep");
+  if (rdma_listen(listening_, kListenBacklog) != 0) {
+    return ErrnoError("rdma_listen");
+  }
+  if (listening_->verbs == nullptr) {
+    return errors::Unavailable(host_, " is not bound to an RDMA device");
+  }
+
+  pd_ = ibv_alloc_pd(listening_->verbs);
+  if (pd_ == nullptr) return ErrnoError("ibv_alloc_pd");
+  event_channel_ = ibv_create_comp_channel(listening_->verbs);
+  if (event_channel_ == nullptr) return ErrnoError("ibv_create_comp_channel");
+  cq_ = ibv_create_cq(listening_->verbs, kCompletionQueueSize, nullptr,
+                      event_channel_, 0);
+  if (cq_ == nullptr) return ErrnoError("ibv_create_cq");
+  if (ibv_req_notify_cq(cq_, 0) != 0) return ErrnoError("ibv_req_notify_cq");
+  TF_RETURN_IF_ERROR(SetNonBlocking(listening_->channel->fd));
+  TF_RETURN_IF_ERROR(SetNonBlocking(event_channel_->fd));
+
+  // Register memory once per allocator region.
+  const auto alloc_visitor = [this](void* ptr, int /*index*/,
+                                    size_t num_bytes) {
+    RegisterMemoryRegion(ptr, num_bytes);
+  };
+  const auto free_visitor = [this](void* ptr, int /*index*/,
+                                   size_t num_bytes) {
+    DeregisterMemoryRegion(ptr, num_bytes);
+  };
+  ProcessState::singleton()->AddCPUAllocVisitor(alloc_visitor);
+  ProcessState::singleton()->AddCPUFreeVisitor(free_visitor);
+#if GOOGLE_CUDA
+  GPUProcessState::singleton()->AddGpuHostAllocVisitor(0, alloc_visitor);
+  GPUProcessState::singleton()->AddGpuHostFreeVisitor(0, free_visitor);
+#endif  // GOOGLE_CUDA
+  LOG(INFO) << "RDMA listener bound to " << host_ << ":" << port_;
+  return Status::OK();
+}
+
+void VerbsMemoryManager::Run() {
+  thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "TF_verbs_memory_manager", [this]() {
+        pollfd fds[2];
+        fds[0].fd = listening_->channel->fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = event_channel_->fd;
+        fds[1].events = POLLIN;
+        uint64 last_expiry_micros = Env::Default()->NowMicros();
+        while (!stopped_) {
+          const uint64 now_micros = Env::Default()->NowMicros();
+          if (now_micros - last_expiry_micros >= kPinExpiryIntervalMicros) {
+            last_expiry_micros = now_micros;
+            const int num_expired = pinned_tensors_.Expire(now_micros);
+            if (num_expired > 0) {
+              LOG(WARNING) << "Unpinned " << num_expired
+                           << " tensors that were never released";
+            }
+          }
+          fds[0].revents = fds[1].revents = 0;
+          if (poll(fds, 2, kPollTimeoutMs) <= 0) continue;
+          if (fds[0].revents & POLLIN) {
+            Status s = AcceptEndpoint();
+            if (!s.ok()) LOG(WARNING) << s;
+          }
+          if (fds[1].revents & POLLIN) {
+            PollCompletions();
+          }
+        }
+      }));
+}
+
+void VerbsMemoryManager::Stop() {
+  stopped_ = true;
+  thread_.reset();
+}
+
+void VerbsMemoryManager::RegisterMemoryRegion(void* ptr, size_t num_bytes) {
+  ibv_mr* mr = ibv_reg_mr(pd_, ptr, num_bytes,
+                          IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ);
+  if (mr == nullptr) {
+    LOG(ERROR) << "Failed to register " << num_bytes
+               << " bytes of memory for RDMA: " << strerror(errno);
+    return;
+  }
+  mutex_lock l(mrs_mu_);
+  mrs_[reinterpret_cast<uintptr_t>(ptr)] = mr;
+}
+
+void VerbsMemoryManager::DeregisterMemoryRegion(void* ptr,
+                                                size_t /*num_bytes*/) {
+  ibv_mr* mr = nullptr;
+  {
+    mutex_lock l(mrs_mu_);
+    auto it = mrs_.find(reinterpret_cast<uintptr_t>(ptr));
+    if (it == mrs_.end()) return;
+    mr = it->second;
+    mrs_.erase(it);
+  }
+  ibv_dereg_mr(mr);
+}
+
+ibv_mr* VerbsMemoryManager::FindMemoryRegion(const void* addr,
+                                             size_t length) {
+  const uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+  mutex_lock l(mrs_mu_);
+  auto it = mrs_.upper_bound(start);
+  if (it == mrs_.begin()) return nullptr;
+  --it;
+  ibv_mr* mr = it->second;
+  const uintptr_t mr_start = reinterpret_cast<uintptr_t>(mr->addr);
+  return start + length <= mr_start + mr->length ? mr : nullptr;
+}
+
+Allocator* VerbsMemoryManager::RegisteredHostAllocator() const {
+#if GOOGLE_CUDA
+  return GPUProcessState::singleton()->GetGpuHostAllocator(0);
+#else
+  return ProcessState::singleton()->GetCPUAllocator(port::kNUMANoAffinity);
+#endif  // GOOGLE_CUDA
+}
+
+void VerbsMemoryManager::PinTensor(
+    const Tensor& tensor, ibv_mr* mr, int64 step_id,
+    ::google::protobuf::Any* mutable_transport_options) {
+  const uint32 tensor_key =
+      pinned_tensors_.Pin(tensor, step_id, Env::Default()->NowMicros());
+  TransportOptionsFromRegion(host_, port_, tensor, mr->rkey, tensor_key,
+                             mutable_transport_options);
+}
+
+void VerbsMemoryManager::ReleaseStep(int64 step_id) {
+  const int num_released = pinned_tensors_.ReleaseStep(step_id);
+  if (num_released > 0) {
+    VLOG(1) << "Unpinned " << num_released << " tensors of step " << step_id;
+  }
+}
+
+void VerbsMemoryManager::TransportOptionsFromTensor(
+    ::google::protobuf::Any* mutable_transport_options, const Tensor& tensor,
+    Device* device, DeviceContext* device_context, bool on_host,
+    int64 step_id, StatusCallback done) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype()) || tensor.TotalBytes() == 0) {
+    done(errors::InvalidArgument("Tensor of type ",
+                                 DataTypeString(tensor.dtype()),
+                                 " with ", tensor.TotalBytes(),
+                                 " bytes cannot be read remotely"));
+    return;
+  }
+  const bool is_device_tensor =
+      !on_host && device->tensorflow_gpu_device_info() != nullptr;
+  if (!is_device_tensor) {
+    ibv_mr* mr =
+        FindMemoryRegion(DMAHelper::base(&tensor), tensor.TotalBytes());
+    if (mr != nullptr) {
+      PinTensor(tensor, mr, step_id, mutable_transport_options);
+      done(Status::OK());
+      return;
+    }
+  }
+
+  // Stage the tensor in registered host memory.
+  Tensor* host_copy = new Tensor(RegisteredHostAllocator(), tensor.dtype(),
+                                 tensor.shape());
+  auto staged = [this, host_copy, mutable_transport_options, step_id,
+                 done](const Status& s) {
+    if (s.ok()) {
+      ibv_mr* mr = FindMemoryRegion(DMAHelper::base(host_copy),
+                                    host_copy->TotalBytes());
+      if (mr == nullptr) {
+        done(errors::Internal("Staging buffer is not registered for RDMA"));
+      } else {
+        PinTensor(*host_copy, mr, step_id, mutable_transport_options);
+        done(Status::OK());
+      }
+    } else {
+      done(s);
+    }
+    delete host_copy;
+  };
+  if (is_device_tensor) {
+    device_context->CopyDeviceTensorToCPU(&tensor, "", device, host_copy,
+                                          std::move(staged));
+  } else {
+    memcpy(DMAHelper::base(host_copy), DMAHelper::base(&tensor),
+           tensor.TotalBytes());
+    staged(Status::OK());
+  }
+}
+
+Status VerbsMemoryManager::GetOrConnectEndpoint(const string& host,
+                                                const string& port,
+                                                Endpoint** endpoint) {
+  const string key = strings::StrCat(host, ":", port);
+  mutex_lock l(endpoints_mu_);
+  auto it = clients_.find(key);
+  if (it != clients_.end()) {
+    *endpoint = it->second.get();
+    return Status::OK();
+  }
+
+  rdma_addrinfo hints = {};
+  hints.ai_port_space = RDMA_PS_TCP;
+  rdma_addrinfo* addrinfo;
+  if (rdma_getaddrinfo(const_cast<char*>(host.c_str()),
+                       const_cast<char*>(port.c_str()), &hints,
+                       &addrinfo) != 0) {
+    return ErrnoError(strings::StrCat("rdma_getaddrinfo ", key));
+  }
+  ibv_qp_init_attr attr = QueuePairAttributes();
+  rdma_cm_id* id;
+  const int ret = rdma_create_ep(&id, addrinfo, pd_, &attr);
+  rdma_freeaddrinfo(addrinfo);
+  if (ret != 0) return ErrnoError(strings::StrCat("rdma_create_ep ", key));
+  if (rdma_connect(id, nullptr) != 0) {
+    Status s = ErrnoError(strings::StrCat("rdma_connect ", key));
+    rdma_destroy_ep(id);
+    return s;
+  }
+  VLOG(1) << "Connected RDMA endpoint to " << key;
+  auto inserted = clients_.emplace(key, absl::make_unique<Endpoint>(id));
+  *endpoint = inserted.first->second.get();
+  return Status::OK();
+}
+
+Status VerbsMemoryManager::AcceptEndpoint() {
+  rdma_cm_id* id;
+  if (rdma_get_request(listening_, &id) != 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return Status::OK();
+    return ErrnoError("rdma_get_request");
+  }
+  ibv_qp_init_attr attr = QueuePairAttributes();
+  if (rdma_create_qp(id, pd_, &attr) != 0) {
+    Status s = ErrnoError("rdma_create_qp");
+    rdma_destroy_id(id);
+    return s;
+  }
+  auto endpoint = absl::make_unique<Endpoint>(id);
+  endpoint->release_buffers.resize(kNumReleaseReceives);
+  endpoint->release_mr = rdma_reg_msgs(
+      id, endpoint->release_buffers.data(),
+      endpoint->release_buffers.size() * sizeof(uint32));
+  if (endpoint->release_mr == nullptr) {
+    Status s = ErrnoError("rdma_reg_msgs");
+    rdma_destroy_ep(id);
+    return s;
+  }
+  for (int i = 0; i < kNumReleaseReceives; ++i) {
+    PostReleaseReceive(endpoint.get(), i);
+  }
+  if (rdma_accept(id, nullptr) != 0) {
+    Status s = ErrnoError("rdma_accept");
+    rdma_dereg_mr(endpoint->release_mr);
+    rdma_destroy_ep(id);
+    return s;
+  }
+  VLOG(1) << "Accepted RDMA endpoint";
+  mutex_lock l(endpoints_mu_);
+  accepted_.push_back(std::move(endpoint));
+  return Status::OK();
+}
+
+void VerbsMemoryManager::PostReleaseReceive(Endpoint* endpoint, int index) {
+  WorkRequest* request = new WorkRequest;
+  request->endpoint = endpoint;
+  request->release_index = index;
+  if (rdma_post_recv(endpoint->id,
+                     WorkRequestContext(request,
+                                        WorkRequestKind::kReleaseReceive),
+                     &endpoint->release_buffers[index], sizeof(uint32),
+                     endpoint->release_mr) != 0) {
+    LOG(ERROR) << "rdma_post_recv failed: " << strerror(errno);
+    delete request;
+  }
+}
+
+void VerbsMemoryManager::PostSend(Endpoint* endpoint,
+                                  std::function<int()> post) {
+  {
+    mutex_lock l(endpoint->mu);
+    if (endpoint->outstanding_sends >= kMaxSendWorkRequests) {
+      endpoint->pending_sends.push_back(std::move(post));
+      return;
+    }
+    ++endpoint->outstanding_sends;
+  }
+  if (post() != 0) {
+    LOG(ERROR) << "Failed to post RDMA send work request: " << strerror(errno);
+    OnSendCompleted(endpoint);
+  }
+}
+
+void VerbsMemoryManager::OnSendCompleted(Endpoint* endpoint) {
+  std::function<int()> post;
+  {
+    mutex_lock l(endpoint->mu);
+    if (endpoint->pending_sends.empty()) {
+      --endpoint->outstanding_sends;
+      return;
+    }
+    post = std::move(endpoint->pending_sends.front());
+    endpoint->pending_sends.pop_front();
+  }
+  if (post() != 0) {
+    LOG(ERROR) << "Failed to post RDMA send work request: " << strerror(errno);
+    OnSendCompleted(endpoint);
+  }
+}
+
+void VerbsMemoryManager::TensorFromTransportOptions(
+    Tensor* tensor, const ::google::protobuf::Any& transport_options,
+    Device* device, DeviceContext* device_context,
+    const AllocatorAttributes& alloc_attrs, StatusCallback done) {
+  RemoteMemoryRegion region;
+  Status s = RegionFromTransportOptions(transport_options, &region);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  Endpoint* endpoint;
+  s = GetOrConnectEndpoint(region.host(), region.port(), &endpoint);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  // Read straight into the destination tensor when it is in registered host
+  // memory; otherwise into a registered staging buffer.
+  const bool on_host =
+      alloc_attrs.on_host() || device->tensorflow_gpu_device_info() == nullptr;
+  const TensorShape shape(region.tensor_shape());
+  Tensor* buffer = nullptr;
+  if (on_host) {
+    *tensor = Tensor(device->GetAllocator(alloc_attrs), region.dtype(), shape);
+    if (FindMemoryRegion(DMAHelper::base(tensor), tensor->TotalBytes())) {
+      buffer = new Tensor(*tensor);
+    }
+  } else {
+    AllocatorAttributes device_attrs = alloc_attrs;
+    *tensor = Tensor(device->GetAllocator(device_attrs), region.dtype(), shape);
+  }
+  if (buffer == nullptr) {
+    buffer = new Tensor(RegisteredHostAllocator(), region.dtype(), shape);
+  }
+  ibv_mr* mr = FindMemoryRegion(DMAHelper::base(buffer), buffer->TotalBytes());
+  if (mr == nullptr || buffer->TotalBytes() != region.length()) {
+    delete buffer;
+    done(errors::Internal("Cannot read remote tensor of ", region.length(),
+                          " bytes into a registered buffer"));
+    return;
+  }
+
+  const uint32 tensor_key = region.tensor_key();
+  WorkRequest* request = new WorkRequest;
+  request->endpoint = endpoint;
+  request->done = [this, tensor, buffer, endpoint, tensor_key, on_host, device,
+                   device_context, done](const Status& s) {
+    // Release the remote tensor, whether or not the read succeeded.
+    WorkRequest* release = new WorkRequest;
+    release->endpoint = endpoint;
+    PostSend(endpoint, [endpoint, release, tensor_key]() {
+      uint32 key = tensor_key;
+      return rdma_post_send(
+          endpoint->id,
+          WorkRequestContext(release, WorkRequestKind::kReleaseSend), &key,
+          sizeof(key), nullptr, IBV_SEND_INLINE);
+    });
+    if (!s.ok() || on_host) {
+      if (on_host && s.ok() &&
+          DMAHelper::base(buffer) != DMAHelper::base(tensor)) {
+        memcpy(DMAHelper::base(tensor), DMAHelper::base(buffer),
+               buffer->TotalBytes());
+      }
+      delete buffer;
+      done(s);
+      return;
+    }
+    device_context->CopyCPUTensorToDevice(
+        buffer, device, tensor, [buffer, done](const Status& s) {
+          delete buffer;
+          done(s);
+        });
+  };
+  void* addr = DMAHelper::base(buffer);
+  const size_t length = buffer->TotalBytes();
+  const uint64 remote_addr = region.addr();
+  const uint32 rkey = region.rkey();
+  PostSend(endpoint, [endpoint, request, addr, length, mr, remote_addr,
+                      rkey]() {
+    return rdma_post_read(
+        endpoint->id, WorkRequestContext(request, WorkRequestKind::kRead),
+        addr, length, mr, 0, remote_addr, rkey);
+  });
+}
+
+void VerbsMemoryManager::PollCompletions() {
+  ibv_cq* cq;
+  void* cq_context;
+  if (ibv_get_cq_event(event_channel_, &cq, &cq_context) != 0) return;
+  ibv_ack_cq_events(cq, 1);
+  if (ibv_req_notify_cq(cq, 0) != 0) {
+    LOG(ERROR) << "ibv_req_notify_cq failed: " << strerror(errno);
+  }
+
+  ibv_wc wcs[kMaxCompletionsPerPoll];
+  int num_completions;
+  while ((num_completions = ibv_poll_cq(cq, kMaxCompletionsPerPoll, wcs)) >
+         0) {
+    for (int i = 0; i < num_completions; ++i) {
+      const ibv_wc& wc = wcs[i];
+      WorkRequestKind kind;
+      WorkRequest* request =
+          static_cast<WorkRequest*>(DecodeWorkRequestId(wc.wr_id, &kind));
+      const Status s =
+          wc.status == IBV_WC_SUCCESS
+              ? Status::OK()
+              : errors::Unavailable("RDMA work request failed: ",
+                                    ibv_wc_status_str(wc.status));
+      if (kind == WorkRequestKind::kReleaseReceive) {
+        // A receiver is done with one of our pinned tensors.
+        Endpoint* endpoint = request->endpoint;
+        const int index = request->release_index;
+        delete request;
+        if (s.ok()) {
+          pinned_tensors_.Release(endpoint->release_buffers[index]);
+        } else {
+          LOG(WARNING) << s;
+        }
+        // Keep the receive slot posted. A flushed receive means that the
+        // queue pair is in the error state, where reposting would only flush
+        // it again.
+        if (wc.status != IBV_WC_WR_FLUSH_ERR) {
+          PostReleaseReceive(endpoint, index);
+        }
+        continue;
+      }
+      OnSendCompleted(request->endpoint);
+      if (request->done) request->done(s);
+      delete request;
+    }
+  }
+}
+
+}  // namespace
+
+RemoteMemoryManager* CreateRemoteMemoryManager(const string& host,
+                                               const string& port) {
+  return new VerbsMemoryManager(host, port);
+}
+
+}  // namespace tensorflow
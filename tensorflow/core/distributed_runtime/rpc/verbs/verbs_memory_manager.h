@@ -0,0 +1,79 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_VERBS_VERBS_MEMORY_MANAGER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_VERBS_VERBS_MEMORY_MANAGER_H_
+
+#include <memory>
+#include <string>
+
+#include "google/protobuf/any.pb.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+
+// Moves tensor content between workers with one-sided RDMA reads, while the
+// metadata is exchanged over gRPC in RecvTensor.
+//
+// Host memory is registered with the RDMA device once per allocator region,
+// through the alloc and free visitors of the ProcessState CPU allocator (and
+// of the GPU host allocators in CUDA builds), so that tensors allocated from
+// those allocators can be read remotely without any copy.
+class RemoteMemoryManager {
+ public:
+  virtual ~RemoteMemoryManager() {}
+
+  // Binds the RDMA listener, and registers the allocator visitors. Must be
+  // called before the first call to ProcessState::GetCPUAllocator().
+  virtual Status Init() = 0;
+
+  // Starts serving RDMA connections and completions.
+  virtual void Run() = 0;
+
+  // Stops serving RDMA connections and completions.
+  virtual void Stop() = 0;
+
+  // Fills "mutable_transport_options" with a RemoteMemoryRegion that lets the
+  // receiver read "tensor". The tensor is pinned until the receiver releases
+  // it, or until ReleaseStep("step_id"). Tensors that are not in registered
+  // host memory (e.g. GPU tensors) are first copied to a registered host
+  // buffer, with "device_context" for device tensors.
+  virtual void TransportOptionsFromTensor(
+      ::google::protobuf::Any* mutable_transport_options, const Tensor& tensor,
+      Device* device, DeviceContext* device_context, bool on_host,
+      int64 step_id, StatusCallback done) = 0;
+
+  // Reads the tensor described by "transport_options" into "*tensor", which
+  // is allocated on "device" with "alloc_attrs", then releases the remote
+  // tensor.
+  virtual void TensorFromTransportOptions(
+      Tensor* tensor, const ::google::protobuf::Any& transport_options,
+      Device* device, DeviceContext* device_context,
+      const AllocatorAttributes& alloc_attrs, StatusCallback done) = 0;
+
+  // Unpins the tensors sent in "step_id" that were not released yet.
+  virtual void ReleaseStep(int64 step_id) = 0;
+};
+
+// Creates a RemoteMemoryManager that listens for RDMA connections on
+// "host":"port".
+RemoteMemoryManager* CreateRemoteMemoryManager(const string& host,
+                                               const string& port);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_VERBS_VERBS_MEMORY_MANAGER_H_
@@ -0,0 +1,242 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_rendezvous_mgr.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/request_id.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+class VerbsRemoteRendezvous : public BaseRemoteRendezvous {
+ public:
+  VerbsRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                        RemoteMemoryManager* remote_memory_manager)
+      : BaseRemoteRendezvous(env, step_id),
+        remote_memory_manager_(remote_memory_manager) {}
+
+ protected:
+  void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                           const Rendezvous::Args& args,
+                           DoneCallback done) override;
+
+ private:
+  ~VerbsRemoteRendezvous() override {}
+
+  RemoteMemoryManager* const remote_memory_manager_;  // Not owned.
+
+  TF_DISALLOW_COPY_AND_ASSIGN(VerbsRemoteRendezvous);
+};
+
+// Used only to retrieve tensors from remote processes. Follows
+// RpcRecvTensorCall, with an extra RDMA read when the response carries
+// transport options instead of the tensor content.
+class VerbsRecvTensorCall : public BaseRecvTensorCall {
+ public:
+  VerbsRecvTensorCall(WorkerInterface* wi, int64 step_id, StringPiece key,
+                      const string& src_worker, Device* dst_device,
+                      const Rendezvous::Args& recv_args,
+                      RemoteMemoryManager* remote_memory_manager)
+      : wi_(wi),
+        src_worker_(src_worker),
+        dst_device_(dst_device),
+        recv_args_(recv_args),
+        remote_memory_manager_(remote_memory_manager) {
+    req_.set_step_id(step_id);
+    req_.set_rendezvous_key(key.data(), key.size());
+    req_.set_request_id(GetUniqueRequestId());
+    req_.set_dma_ok(true);
+  }
+
+  ~VerbsRecvTensorCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in VerbsRecvTensorCall destructor.";
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    resp_.InitAlloc(dst_device_, recv_args_.alloc_attrs);
+    auto abort_checked = std::make_shared<Notification>();
+    auto cb = [this, abort_checked,
+               recv_done = std::move(recv_done)](const Status& s) {
+      abort_checked->WaitForNotification();
+      if (!s.ok() || !resp_.metadata().has_transport_options()) {
+        if (!s.ok()) {
+          mutex_lock l(mu_);
+          status_.Update(s);
+        } else {
+          tensor_ = resp_.tensor();
+        }
+        recv_done();
+        return;
+      }
+      remote_memory_manager_->TensorFromTransportOptions(
+          &tensor_, resp_.metadata().transport_options(), dst_device_,
+          recv_args_.device_context, recv_args_.alloc_attrs,
+          [this, recv_done](const Status& s) {
+            if (!s.ok()) {
+              mutex_lock l(mu_);
+              status_.Update(s);
+            }
+            recv_done();
+          });
+    };
+    wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
+
+    // See RpcRecvTensorCall::StartRTCall for why the abort is checked after
+    // sending out the RPC.
+    Status s;
+    {
+      mutex_lock l(mu_);
+      s = status_;
+    }
+    if (!s.ok()) {
+      opts_.StartCancel();
+    }
+    abort_checked->Notify();
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  void ReleaseWorker(WorkerCacheInterface* worker_cache) {
+    DCHECK_NE(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "VerbsRecvTensorCall::ReleaseWorker() called twice.";
+    worker_cache->ReleaseWorker(src_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+  const Tensor& tensor() const { return tensor_; }
+
+  bool is_dead() const { return resp_.metadata().is_dead(); }
+
+  const Rendezvous::Args& recv_args() const { return recv_args_; }
+
+ private:
+  WorkerInterface* wi_;  // Not owned.
+  const string src_worker_;
+  Device* const dst_device_;
+  const Rendezvous::Args recv_args_;
+  RemoteMemoryManager* const remote_memory_manager_;  // Not owned.
+  CallOptions opts_;
+  RecvTensorRequest req_;
+  TensorResponse resp_;
+  Tensor tensor_;
+
+  mutable mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(VerbsRecvTensorCall);
+};
+
+void VerbsRemoteRendezvous::RecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
+  CHECK(is_initialized());
+  Status s;
+
+  // key.src_device identifies a remote device.
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    s = errors::Internal(parsed.src_device,
+                         " is invalid remote source device.");
+  }
+  WorkerSession* sess = session();
+  std::shared_ptr<WorkerCacheInterface> worker_cache =
+      sess->GetSharedWorkerCache();
+  WorkerInterface* rwi =
+      s.ok() ? worker_cache->GetOrCreateWorker(src_worker) : nullptr;
+  if (s.ok() && rwi == nullptr) {
+    s = errors::Internal("No worker known as ", src_worker);
+  }
+
+  Device* dst_device;
+  if (s.ok()) {
+    s = sess->device_mgr()->LookupDevice(parsed.dst_device, &dst_device);
+  }
+  if (!s.ok()) {
+    if (rwi != nullptr) {
+      worker_cache->ReleaseWorker(src_worker, rwi);
+    }
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+
+  VerbsRecvTensorCall* call =
+      new VerbsRecvTensorCall(rwi, step_id_, parsed.FullKey(), src_worker,
+                              dst_device, recv_args, remote_memory_manager_);
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call, recv_args);
+
+  // RendezvousMgr already aborted, shouldn't send RPC call any more
+  if (!call->status().ok()) {
+    DeregisterCall(call);
+    call->ReleaseWorker(worker_cache.get());
+    done(call->status(), Args(), Args(), Tensor(), false);
+    delete call;
+    return;
+  }
+
+  // Start "call".
+  Ref();
+  call->Start([this, call, worker_cache, done = std::move(done)]() {
+    // Removes "call" from active_. Prevent StartAbort().
+    DeregisterCall(call);
+    // If StartAbort was called prior to DeregisterCall, then the
+    // current status should be bad.
+    Status s = call->status();
+    call->ReleaseWorker(worker_cache.get());
+    done(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+    delete call;
+    Unref();
+  });
+}
+
+}  // namespace
+
+VerbsRendezvousMgr::VerbsRendezvousMgr(
+    const WorkerEnv* env, RemoteMemoryManager* remote_memory_manager)
+    : BaseRendezvousMgr(env), remote_memory_manager_(remote_memory_manager) {}
+
+BaseRemoteRendezvous* VerbsRendezvousMgr::Create(int64 step_id,
+                                                 const WorkerEnv* worker_env) {
+  return new VerbsRemoteRendezvous(worker_env, step_id, remote_memory_manager_);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_server_lib.h"
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_worker.h"
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+VerbsServer::VerbsServer(const ServerDef& server_def, Env* env)
+    : GrpcServer(server_def, env) {}
+
+Status VerbsServer::Init() {
+  string host;
+  int port;
+  TF_RETURN_IF_ERROR(GetHostAndPort(server_def(), &host, &port));
+  remote_memory_manager_.reset(
+      CreateRemoteMemoryManager(host, strings::StrCat(port)));
+  // The allocator visitors must be registered before GrpcServer::Init()
+  // creates the devices and their allocators.
+  TF_RETURN_IF_ERROR(remote_memory_manager_->Init());
+
+  RemoteMemoryManager* remote_memory_manager = remote_memory_manager_.get();
+  GrpcServerOptions opts;
+  opts.rendezvous_mgr_func = [remote_memory_manager](const WorkerEnv* env) {
+    return new VerbsRendezvousMgr(env, remote_memory_manager);
+  };
+  opts.worker_func = [remote_memory_manager](WorkerEnv* env,
+                                             const ConfigProto& config) {
+    return NewVerbsWorker(env, config, remote_memory_manager);
+  };
+  return GrpcServer::Init(opts);
+}
+
+Status VerbsServer::Start() {
+  Status s = GrpcServer::Start();
+  if (s.ok()) {
+    remote_memory_manager_->Run();
+  }
+  return s;
+}
+
+Status VerbsServer::Stop() {
+  Status s = GrpcServer::Stop();
+  if (s.ok() && remote_memory_manager_ != nullptr) {
+    remote_memory_manager_->Stop();
+  }
+  return s;
+}
+
+/* static */
+Status VerbsServer::Create(const ServerDef& server_def, Env* env,
+                           std::unique_ptr<ServerInterface>* out_server) {
+  std::unique_ptr<VerbsServer> ret(new VerbsServer(server_def, env));
+  TF_RETURN_IF_ERROR(ret->Init());
+  *out_server = std::move(ret);
+  return Status::OK();
+}
+
+namespace {
+
+class VerbsServerFactory : public ServerFactory {
+ public:
+  bool AcceptsOptions(const ServerDef& server_def) override {
+    return server_def.protocol() == "grpc+verbs";
+  }
+
+  Status NewServer(const ServerDef& server_def, const Options& options,
+                   std::unique_ptr<ServerInterface>* out_server) override {
+    return VerbsServer::Create(server_def, Env::Default(), out_server);
+  }
+};
+
+// Registers a `ServerFactory` for `VerbsServer` instances.
+class VerbsServerRegistrar {
+ public:
+  VerbsServerRegistrar() {
+    ServerFactory::Register("VERBS_SERVER", new VerbsServerFactory());
+  }
+};
+static VerbsServerRegistrar registrar;
+
+}  // namespace
+}  // namespace tensorflow
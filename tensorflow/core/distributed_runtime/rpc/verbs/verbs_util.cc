@@ -0,0 +1,138 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_util.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/overflow.h"
+
+namespace tensorflow {
+
+namespace {
+
+constexpr uint64 kWorkRequestKindMask = 3;
+
+}  // namespace
+
+uint64 EncodeWorkRequestId(const void* context, WorkRequestKind kind) {
+  const uint64 id = reinterpret_cast<uint64>(context);
+  DCHECK_EQ(id & kWorkRequestKindMask, 0);
+  return id | static_cast<uint64>(kind);
+}
+
+void* DecodeWorkRequestId(uint64 wr_id, WorkRequestKind* kind) {
+  *kind = static_cast<WorkRequestKind>(wr_id & kWorkRequestKindMask);
+  return reinterpret_cast<void*>(wr_id & ~kWorkRequestKindMask);
+}
+
+void TransportOptionsFromRegion(const string& host, const string& port,
+                                const Tensor& tensor, uint32 rkey,
+                                uint32 tensor_key,
+                                ::google::protobuf::Any* transport_options) {
+  RemoteMemoryRegion region;
+  region.set_host(host);
+  region.set_port(port);
+  region.set_addr(reinterpret_cast<uint64>(DMAHelper::base(&tensor)));
+  region.set_length(tensor.TotalBytes());
+  region.set_rkey(rkey);
+  region.set_tensor_key(tensor_key);
+  region.set_dtype(tensor.dtype());
+  tensor.shape().AsProto(region.mutable_tensor_shape());
+  transport_options->PackFrom(region);
+}
+
+Status RegionFromTransportOptions(
+    const ::google::protobuf::Any& transport_options,
+    RemoteMemoryRegion* region) {
+  if (!transport_options.UnpackTo(region)) {
+    return errors::NotFound("No RDMA transport options found");
+  }
+  if (!DataTypeCanUseMemcpy(region->dtype())) {
+    return errors::InvalidArgument("Tensor of type ",
+                                   DataTypeString(region->dtype()),
+                                   " cannot be read remotely");
+  }
+  TF_RETURN_IF_ERROR(TensorShape::IsValidShape(region->tensor_shape()));
+  const TensorShape shape(region->tensor_shape());
+  const int64 num_bytes = MultiplyWithoutOverflow(
+      shape.num_elements(), DataTypeSize(region->dtype()));
+  if (num_bytes < 0 || static_cast<uint64>(num_bytes) != region->length()) {
+    return errors::InvalidArgument("Remote tensor of ", region->length(),
+                                   " bytes does not match its ",
+                                   DataTypeString(region->dtype()), " shape ",
+                                   shape.DebugString());
+  }
+  return Status::OK();
+}
+
+uint32 PinnedTensorTable::Pin(const Tensor& tensor, int64 step_id,
+                              uint64 now_micros) {
+  mutex_lock l(mu_);
+  const uint32 key = next_key_++;
+  pinned_[key] = Pinned{tensor, step_id, now_micros};
+  return key;
+}
+
+bool PinnedTensorTable::Release(uint32 key) {
+  Tensor unpinned;
+  mutex_lock l(mu_);
+  auto it = pinned_.find(key);
+  if (it == pinned_.end()) return false;
+  // Drop the reference outside of the lock.
+  unpinned = std::move(it->second.tensor);
+  pinned_.erase(it);
+  return true;
+}
+
+int PinnedTensorTable::ReleaseStep(int64 step_id) {
+  std::vector<Tensor> unpinned;
+  mutex_lock l(mu_);
+  for (auto it = pinned_.begin(); it != pinned_.end();) {
+    if (it->second.step_id == step_id) {
+      unpinned.push_back(std::move(it->second.tensor));
+      pinned_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  return unpinned.size();
+}
+
+int PinnedTensorTable::Expire(uint64 now_micros) {
+  std::vector<Tensor> unpinned;
+  mutex_lock l(mu_);
+  for (auto it = pinned_.begin(); it != pinned_.end();) {
+    if (it->second.pinned_micros + timeout_micros_ <= now_micros) {
+      unpinned.push_back(std::move(it->second.tensor));
+      pinned_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  return unpinned.size();
+}
+
+size_t PinnedTensorTable::size() const {
+  mutex_lock l(mu_);
+  return pinned_.size();
+}
+
+}  // namespace tensorflow
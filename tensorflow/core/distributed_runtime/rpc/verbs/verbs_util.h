@@ -0,0 +1,105 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_VERBS_VERBS_UTIL_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_VERBS_VERBS_UTIL_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "google/protobuf/any.pb.h"
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+// Parts of the RDMA transport that do not depend on the RDMA libraries.
+
+namespace tensorflow {
+
+// The kind of a work request, carried in the low bits of ibv_wc::wr_id: the
+// opcode of a completion is undefined when its status is an error, so it
+// cannot tell receives from sends.
+enum class WorkRequestKind : uint64 {
+  kRead = 0,
+  kReleaseSend = 1,
+  kReleaseReceive = 2,
+};
+
+// Returns the wr_id of a work request whose context is "context", which must
+// be aligned to at least 4 bytes.
+uint64 EncodeWorkRequestId(const void* context, WorkRequestKind kind);
+
+// Inverse of EncodeWorkRequestId.
+void* DecodeWorkRequestId(uint64 wr_id, WorkRequestKind* kind);
+
+// Packs a RemoteMemoryRegion describing "tensor", which is readable at its
+// current address with "rkey" and pinned under "tensor_key", into
+// "transport_options".
+void TransportOptionsFromRegion(const string& host, const string& port,
+                                const Tensor& tensor, uint32 rkey,
+                                uint32 tensor_key,
+                                ::google::protobuf::Any* transport_options);
+
+// Unpacks the RemoteMemoryRegion in "transport_options", and checks that its
+// length matches its dtype and shape.
+Status RegionFromTransportOptions(
+    const ::google::protobuf::Any& transport_options,
+    RemoteMemoryRegion* region);
+
+// The tensors pinned for remote reads. A tensor is unpinned when the receiver
+// releases it, when the step it was sent in is cleaned up, or at the latest
+// "timeout_micros" after it was pinned, in case neither happens.
+class PinnedTensorTable {
+ public:
+  explicit PinnedTensorTable(uint64 timeout_micros)
+      : timeout_micros_(timeout_micros) {}
+
+  // Pins "tensor" for "step_id" and returns its key.
+  uint32 Pin(const Tensor& tensor, int64 step_id, uint64 now_micros);
+
+  // Unpins the tensor of "key". Returns false if it is not pinned.
+  bool Release(uint32 key);
+
+  // Unpins the tensors of "step_id", and returns how many there were.
+  int ReleaseStep(int64 step_id);
+
+  // Unpins the tensors pinned for longer than the timeout, and returns how
+  // many there were.
+  int Expire(uint64 now_micros);
+
+  size_t size() const;
+
+ private:
+  struct Pinned {
+    Tensor tensor;
+    int64 step_id;
+    uint64 pinned_micros;
+  };
+
+  const uint64 timeout_micros_;
+
+  mutable mutex mu_;
+  uint32 next_key_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<uint32, Pinned> pinned_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PinnedTensorTable);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_VERBS_VERBS_UTIL_H_
@@ -0,0 +1,141 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_util.h"
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(VerbsUtilTest, WorkRequestIdRoundTrip) {
+  int64 contexts[2];
+  for (void* context : {static_cast<void*>(&contexts[0]),
+                        static_cast<void*>(&contexts[1])}) {
+    for (WorkRequestKind kind :
+         {WorkRequestKind::kRead, WorkRequestKind::kReleaseSend,
+          WorkRequestKind::kReleaseReceive}) {
+      WorkRequestKind decoded_kind;
+      const uint64 wr_id = EncodeWorkRequestId(context, kind);
+      EXPECT_EQ(context, DecodeWorkRequestId(wr_id, &decoded_kind));
+      EXPECT_EQ(kind, decoded_kind);
+    }
+  }
+}
+
+TEST(VerbsUtilTest, TransportOptionsRoundTrip) {
+  Tensor tensor = test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3});
+  ::google::protobuf::Any transport_options;
+  TransportOptionsFromRegion("worker0", "4000", tensor, /*rkey=*/17,
+                             /*tensor_key=*/42, &transport_options);
+
+  RemoteMemoryRegion region;
+  TF_ASSERT_OK(RegionFromTransportOptions(transport_options, &region));
+  EXPECT_EQ("worker0", region.host());
+  EXPECT_EQ("4000", region.port());
+  EXPECT_EQ(reinterpret_cast<uint64>(tensor.tensor_data().data()),
+            region.addr());
+  EXPECT_EQ(6 * sizeof(float), region.length());
+  EXPECT_EQ(17, region.rkey());
+  EXPECT_EQ(42, region.tensor_key());
+  EXPECT_EQ(DT_FLOAT, region.dtype());
+  EXPECT_EQ(TensorShape({2, 3}), TensorShape(region.tensor_shape()));
+}
+
+TEST(VerbsUtilTest, RejectsInvalidTransportOptions) {
+  RemoteMemoryRegion region;
+  ::google::protobuf::Any transport_options;
+  EXPECT_TRUE(errors::IsNotFound(
+      RegionFromTransportOptions(transport_options, &region)));
+
+  Tensor tensor = test::AsTensor<int32>({1, 2, 3}, {3});
+  TransportOptionsFromRegion("worker0", "4000", tensor, 1, 2,
+                             &transport_options);
+  ASSERT_TRUE(transport_options.UnpackTo(&region));
+
+  // Length not matching the shape.
+  RemoteMemoryRegion corrupt = region;
+  corrupt.set_length(region.length() + 4);
+  transport_options.PackFrom(corrupt);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      RegionFromTransportOptions(transport_options, &corrupt)));
+
+  // Invalid shape.
+  corrupt = region;
+  corrupt.mutable_tensor_shape()->mutable_dim(0)->set_size(-2);
+  transport_options.PackFrom(corrupt);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      RegionFromTransportOptions(transport_options, &corrupt)));
+
+  // Type that cannot be copied with memcpy.
+  corrupt = region;
+  corrupt.set_dtype(DT_STRING);
+  transport_options.PackFrom(corrupt);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      RegionFromTransportOptions(transport_options, &corrupt)));
+}
+
+TEST(PinnedTensorTableTest, ReleaseUnpinsOnce) {
+  PinnedTensorTable table(/*timeout_micros=*/1000);
+  Tensor tensor = test::AsTensor<float>({1, 2});
+  const uint32 first = table.Pin(tensor, /*step_id=*/1, /*now_micros=*/0);
+  const uint32 second = table.Pin(tensor, /*step_id=*/1, /*now_micros=*/0);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(2, table.size());
+  EXPECT_FALSE(tensor.RefCountIsOne());
+
+  EXPECT_TRUE(table.Release(first));
+  EXPECT_FALSE(table.Release(first));
+  EXPECT_EQ(1, table.size());
+  EXPECT_TRUE(table.Release(second));
+  EXPECT_EQ(0, table.size());
+  EXPECT_TRUE(tensor.RefCountIsOne());
+}
+
+TEST(PinnedTensorTableTest, ReleaseStepUnpinsOnlyThatStep) {
+  PinnedTensorTable table(/*timeout_micros=*/1000);
+  Tensor tensor = test::AsTensor<float>({1, 2});
+  table.Pin(tensor, /*step_id=*/1, /*now_micros=*/0);
+  const uint32 released = table.Pin(tensor, /*step_id=*/1, /*now_micros=*/0);
+  const uint32 other_step = table.Pin(tensor, /*step_id=*/2, /*now_micros=*/0);
+  EXPECT_TRUE(table.Release(released));
+
+  EXPECT_EQ(1, table.ReleaseStep(1));
+  EXPECT_EQ(0, table.ReleaseStep(1));
+  EXPECT_EQ(1, table.size());
+  EXPECT_TRUE(table.Release(other_step));
+  EXPECT_TRUE(tensor.RefCountIsOne());
+}
+
+TEST(PinnedTensorTableTest, ExpiresAfterTimeout) {
+  PinnedTensorTable table(/*timeout_micros=*/1000);
+  Tensor tensor = test::AsTensor<float>({1, 2});
+  const uint32 old_pin = table.Pin(tensor, /*step_id=*/1, /*now_micros=*/0);
+  const uint32 new_pin = table.Pin(tensor, /*step_id=*/1, /*now_micros=*/500);
+
+  EXPECT_EQ(0, table.Expire(999));
+  EXPECT_EQ(1, table.Expire(1000));
+  EXPECT_FALSE(table.Release(old_pin));
+  EXPECT_EQ(1, table.Expire(1500));
+  EXPECT_FALSE(table.Release(new_pin));
+  EXPECT_EQ(0, table.size());
+  EXPECT_TRUE(tensor.RefCountIsOne());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,116 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/verbs/verbs_worker.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/tracing.h"
+
+namespace tensorflow {
+
+VerbsWorker::VerbsWorker(WorkerEnv* env, const ConfigProto& config,
+                         RemoteMemoryManager* remote_memory_manager)
+    : GrpcWorker(env, config), remote_memory_manager_(remote_memory_manager) {}
+
+void VerbsWorker::GrpcRecvTensorAsync(CallOptions* opts,
+                                      const RecvTensorRequest* request,
+                                      ::grpc::ByteBuffer* response,
+                                      StatusCallback done) {
+  if (!request->dma_ok()) {
+    GrpcWorker::GrpcRecvTensorAsync(opts, request, response, std::move(done));
+    return;
+  }
+
+  const int64 step_id = request->step_id();
+  const string& key = request->rendezvous_key();
+  Status s = recent_request_ids_.TrackUnique(
+      request->request_id(), "RecvTensor (VerbsWorker)", *request);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
+  Rendezvous::ParsedKey parsed;
+  s = Rendezvous::ParseKey(key, &parsed);
+  Device* src_dev = nullptr;
+  if (s.ok()) {
+    s = PrepareRecvTensor(parsed, &src_dev);
+  }
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  // Request the tensor associated with the rendezvous key. As in GrpcWorker,
+  // cancellations are only logged.
+  opts->SetCancelCallback(
+      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
+  env_->rendezvous_mgr->RecvLocalAsync(
+      step_id, parsed,
+      [this, opts, response, done, src_dev, step_id](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
+        opts->ClearCancelCallback();
+        if (!status.ok()) {
+          done(status);
+          return;
+        }
+        if (is_dead || val.TotalBytes() == 0 ||
+            !DataTypeCanUseMemcpy(val.dtype())) {
+          // Nothing to read remotely: send the tensor inline.
+          grpc::EncodeTensorToByteBuffer(is_dead, val, false, response);
+          done(Status::OK());
+          return;
+        }
+        RecvTensorResponse* proto = new RecvTensorResponse;
+        proto->set_is_dead(is_dead);
+        proto->set_send_start_micros(Env::Default()->NowMicros());
+        remote_memory_manager_->TransportOptionsFromTensor(
+            proto->mutable_transport_options(), val, src_dev,
+            send_args.device_context, send_args.alloc_attrs.on_host(),
+            step_id, [proto, response, done](const Status& s) {
+              if (s.ok()) {
+                grpc::EncodeRecvTensorResponseToByteBuffer(*proto, response);
+              }
+              delete proto;
+              done(s);
+            });
+      });
+}
+
+void VerbsWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
+                                    CleanupGraphResponse* response,
+                                    StatusCallback done) {
+  remote_memory_manager_->ReleaseStep(request->step_id());
+  GrpcWorker::CleanupGraphAsync(request, response, std::move(done));
+}
+
+std::unique_ptr<GrpcWorker> NewVerbsWorker(
+    WorkerEnv* worker_env, const ConfigProto& config,
+    RemoteMemoryManager* remote_memory_manager) {
+  return absl::make_unique<VerbsWorker>(worker_env, config,
+                                        remote_memory_manager);
+}
+
+}  // namespace tensorflow
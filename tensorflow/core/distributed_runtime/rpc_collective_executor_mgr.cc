@@ -53,7 +53,8 @@ CollectiveExecutor* RpcCollectiveExecutorMgr::Create(int64 step_id) {
                                             work_queue_, worker_cache_, step_id,
                                             task_name_);
   return new BaseCollectiveExecutor(this, rma, step_id, dev_mgr_,
-                                    &gpu_ring_order_, work_queue_);
+                                    &gpu_ring_order_, work_queue_,
+                                    fusion_options_);
 }
 
 namespace {
@@ -0,0 +1,215 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/staleness_tracker.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+bool IsVariableNode(const Node* node) {
+  return node->type_string() == "VariableV2" ||
+         node->type_string() == "Variable" ||
+         node->type_string() == "VarHandleOp";
+}
+
+// Returns true if "node" updates the variable it takes as input.
+bool IsVariableUpdate(const Node* node) {
+  static const char* const kUpdatePrefixes[] = {
+      "Apply",  "ResourceApply", "SparseApply",     "ResourceSparseApply",
+      "Assign", "Scatter",       "ResourceScatter",
+  };
+  for (const char* prefix : kUpdatePrefixes) {
+    if (absl::StartsWith(node->type_string(), prefix)) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+/*static*/
+string StalenessTracker::ShardForGraph(const Graph& graph) {
+  bool updates_variables = false;
+  std::vector<string> variables;
+  for (const Node* node : graph.op_nodes()) {
+    if (IsVariableNode(node)) {
+      string name;
+      if (!GetNodeAttr(node->attrs(), "shared_name", &name).ok() ||
+          name.empty()) {
+        name = node->name();
+      }
+      variables.push_back(std::move(name));
+    } else if (IsVariableUpdate(node)) {
+      updates_variables = true;
+    }
+  }
+  if (!updates_variables || variables.empty()) return "";
+  std::sort(variables.begin(), variables.end());
+  return absl::StrJoin(variables, ",");
+}
+
+void StalenessTracker::Register(const string& shard,
+                                const string& participant) {
+  mutex_lock l(mu_);
+  Shard& s = shards_[shard];
+  auto it = s.participants.find(participant);
+  if (it == s.participants.end()) {
+    // Start at the progress of the slowest participant.
+    int64 slowest = 0;
+    if (!s.participants.empty()) {
+      slowest = std::numeric_limits<int64>::max();
+      for (const auto& p : s.participants) {
+        slowest = std::min(slowest, p.second.completed);
+      }
+    }
+    it = s.participants.emplace(participant, Participant()).first;
+    it->second.started = slowest;
+    it->second.completed = slowest;
+  }
+  ++it->second.registrations;
+}
+
+void StalenessTracker::Unregister(const string& shard,
+                                  const string& participant) {
+  std::vector<StartCallback> ready;
+  {
+    mutex_lock l(mu_);
+    auto shard_it = shards_.find(shard);
+    if (shard_it == shards_.end()) return;
+    auto it = shard_it->second.participants.find(participant);
+    if (it == shard_it->second.participants.end()) return;
+    if (--it->second.registrations > 0) return;
+    shard_it->second.participants.erase(it);
+    // The slowest participant may have left.
+    ready = StartWaiters(shard);
+    if (shard_it->second.participants.empty()) shards_.erase(shard_it);
+  }
+  for (auto& start : ready) start(Status::OK());
+}
+
+int64 StalenessTracker::NewStep() {
+  mutex_lock l(mu_);
+  const int64 step_id = next_step_id_++;
+  waiters_[step_id];
+  return step_id;
+}
+
+void StalenessTracker::StartStep(int64 step_id, const string& shard,
+                                 const string& participant, int bound,
+                                 StartCallback start) {
+  Status status;
+  {
+    mutex_lock l(mu_);
+    auto it = waiters_.find(step_id);
+    if (it == waiters_.end() || it->second.waiting) {
+      status = errors::Internal("Unknown staleness tracker step ", step_id);
+    } else if (it->second.cancelled) {
+      waiters_.erase(it);
+      status = errors::Cancelled(
+          "Step was cancelled while waiting for stale workers");
+    } else {
+      auto shard_it = shards_.find(shard);
+      if (shard_it == shards_.end() ||
+          MaybeStart(&shard_it->second, participant, bound)) {
+        waiters_.erase(it);
+      } else {
+        VLOG(1) << "Step of " << participant << " waits for stale workers";
+        Waiter& waiter = it->second;
+        waiter.shard = shard;
+        waiter.participant = participant;
+        waiter.bound = bound;
+        waiter.start = std::move(start);
+        waiter.waiting = true;
+        return;
+      }
+    }
+  }
+  start(status);
+}
+
+void StalenessTracker::Cancel(int64 step_id) {
+  StartCallback start;
+  {
+    mutex_lock l(mu_);
+    auto it = waiters_.find(step_id);
+    if (it == waiters_.end()) return;
+    if (!it->second.waiting) {
+      it->second.cancelled = true;
+      return;
+    }
+    start = std::move(it->second.start);
+    waiters_.erase(it);
+  }
+  start(
+      errors::Cancelled("Step was cancelled while waiting for stale workers"));
+}
+
+void StalenessTracker::FinishStep(const string& shard,
+                                  const string& participant) {
+  std::vector<StartCallback> ready;
+  {
+    mutex_lock l(mu_);
+    auto shard_it = shards_.find(shard);
+    if (shard_it == shards_.end()) return;
+    auto it = shard_it->second.participants.find(participant);
+    if (it == shard_it->second.participants.end()) return;
+    ++it->second.completed;
+    ready = StartWaiters(shard);
+  }
+  for (auto& start : ready) start(Status::OK());
+}
+
+bool StalenessTracker::MaybeStart(Shard* shard, const string& participant,
+                                  int bound) {
+  auto it = shard->participants.find(participant);
+  if (it == shard->participants.end()) return true;
+  int64 slowest = std::numeric_limits<int64>::max();
+  for (const auto& p : shard->participants) {
+    slowest = std::min(slowest, p.second.completed);
+  }
+  if (it->second.started - slowest > bound) return false;
+  ++it->second.started;
+  return true;
+}
+
+std::vector<StalenessTracker::StartCallback> StalenessTracker::StartWaiters(
+    const string& shard) {
+  std::vector<StartCallback> ready;
+  auto shard_it = shards_.find(shard);
+  for (auto it = waiters_.begin(); it != waiters_.end();) {
+    Waiter& waiter = it->second;
+    if (waiter.waiting && waiter.shard == shard &&
+        (shard_it == shards_.end() ||
+         MaybeStart(&shard_it->second, waiter.participant, waiter.bound))) {
+      ready.push_back(std::move(waiter.start));
+      it = waiters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return ready;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STALENESS_TRACKER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STALENESS_TRACKER_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Bounds the staleness of asynchronous parameter server updates.
+//
+// The steps that update a set of variables (a "shard") are counted per
+// participant, i.e. per client session.  A participant may start a step on
+// a shard only when it has started at most "bound" more steps on it than the
+// slowest participant of the shard has completed.  Waiting steps are started
+// as soon as the slowest participants catch up, so there is no global
+// barrier.
+//
+// A participant that joins a shard starts at the progress of the slowest
+// participant, so that it does not hold back the others.
+class StalenessTracker {
+ public:
+  StalenessTracker() {}
+
+  // Returns the shard updated by "graph": the sorted names of the variables
+  // of "graph", if "graph" updates a variable.  Returns an empty string if
+  // "graph" does not update any variable.
+  static string ShardForGraph(const Graph& graph);
+
+  // Adds (or removes) a registered graph of "participant" that updates
+  // "shard".  A participant takes part in a shard while it has registered
+  // graphs that update it.
+  void Register(const string& shard, const string& participant)
+      TF_LOCKS_EXCLUDED(mu_);
+  void Unregister(const string& shard, const string& participant)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns a new step id, for StartStep and Cancel.
+  int64 NewStep() TF_LOCKS_EXCLUDED(mu_);
+
+  // Calls "start" with an OK status once "participant" may start step
+  // "step_id" on "shard", or with a Cancelled status if the step is
+  // cancelled before.  "start" may be called before StartStep returns.
+  void StartStep(int64 step_id, const string& shard, const string& participant,
+                 int bound, std::function<void(const Status&)> start)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Cancels step "step_id" if it has not started yet.
+  void Cancel(int64 step_id) TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that a step of "participant" on "shard" has completed.
+  void FinishStep(const string& shard, const string& participant)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  typedef std::function<void(const Status&)> StartCallback;
+
+  struct Participant {
+    int registrations = 0;
+    int64 started = 0;
+    int64 completed = 0;
+  };
+
+  struct Waiter {
+    string shard;
+    string participant;
+    int bound = 0;
+    StartCallback start;
+    // Whether StartStep was called for this step.
+    bool waiting = false;
+    // Whether Cancel was called before StartStep.
+    bool cancelled = false;
+  };
+
+  struct Shard {
+    std::unordered_map<string, Participant> participants;
+  };
+
+  // Returns true, and counts the step as started, if "participant" may start
+  // a step with "bound".
+  bool MaybeStart(Shard* shard, const string& participant, int bound)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Starts the waiting steps of "shard" that may start, and returns their
+  // callbacks.
+  std::vector<StartCallback> StartWaiters(const string& shard)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  std::unordered_map<string, Shard> shards_ TF_GUARDED_BY(mu_);
+  // Steps that have not started yet, in order of step id.
+  std::map<int64, Waiter> waiters_ TF_GUARDED_BY(mu_);
+  int64 next_step_id_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StalenessTracker);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STALENESS_TRACKER_H_
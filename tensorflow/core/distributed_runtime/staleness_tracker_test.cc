@@ -0,0 +1,159 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/staleness_tracker.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Records the status passed to a start callback.
+struct StartResult {
+  bool called = false;
+  Status status;
+
+  std::function<void(const Status&)> Callback() {
+    return [this](const Status& s) {
+      called = true;
+      status = s;
+    };
+  }
+};
+
+void StartStep(StalenessTracker* tracker, const string& participant,
+               int bound, StartResult* result) {
+  tracker->StartStep(tracker->NewStep(), "vars", participant, bound,
+                     result->Callback());
+}
+
+TEST(StalenessTrackerTest, FastParticipantWaitsForSlowOne) {
+  StalenessTracker tracker;
+  tracker.Register("vars", "fast");
+  tracker.Register("vars", "slow");
+
+  StartResult slow;
+  StartStep(&tracker, "slow", 1, &slow);
+  EXPECT_TRUE(slow.called);
+
+  // "fast" may run two steps ahead of the slowest completed step.
+  StartResult fast[3];
+  for (int i = 0; i < 3; ++i) {
+    StartStep(&tracker, "fast", 1, &fast[i]);
+    if (i < 2) tracker.FinishStep("vars", "fast");
+  }
+  EXPECT_TRUE(fast[0].called);
+  EXPECT_TRUE(fast[1].called);
+  EXPECT_FALSE(fast[2].called);
+
+  tracker.FinishStep("vars", "slow");
+  EXPECT_TRUE(fast[2].called);
+  TF_EXPECT_OK(fast[2].status);
+}
+
+TEST(StalenessTrackerTest, CancelWaitingStep) {
+  StalenessTracker tracker;
+  tracker.Register("vars", "fast");
+  tracker.Register("vars", "slow");
+
+  StartResult first;
+  StartStep(&tracker, "fast", 0, &first);
+  EXPECT_TRUE(first.called);
+  tracker.FinishStep("vars", "fast");
+
+  StartResult second;
+  const int64 step_id = tracker.NewStep();
+  tracker.StartStep(step_id, "vars", "fast", 0, second.Callback());
+  EXPECT_FALSE(second.called);
+  tracker.Cancel(step_id);
+  EXPECT_TRUE(second.called);
+  EXPECT_TRUE(errors::IsCancelled(second.status));
+
+  // A step cancelled before it is started fails when it is started.
+  StartResult third;
+  const int64 cancelled_id = tracker.NewStep();
+  tracker.Cancel(cancelled_id);
+  tracker.StartStep(cancelled_id, "vars", "slow", 0, third.Callback());
+  EXPECT_TRUE(third.called);
+  EXPECT_TRUE(errors::IsCancelled(third.status));
+}
+
+TEST(StalenessTrackerTest, UnregisterReleasesWaiters) {
+  StalenessTracker tracker;
+  tracker.Register("vars", "fast");
+  tracker.Register("vars", "slow");
+
+  StartResult first;
+  StartStep(&tracker, "fast", 0, &first);
+  tracker.FinishStep("vars", "fast");
+  StartResult second;
+  StartStep(&tracker, "fast", 0, &second);
+  EXPECT_FALSE(second.called);
+
+  tracker.Unregister("vars", "slow");
+  EXPECT_TRUE(second.called);
+  TF_EXPECT_OK(second.status);
+}
+
+TEST(StalenessTrackerTest, LateParticipantStartsAtSlowestProgress) {
+  StalenessTracker tracker;
+  tracker.Register("vars", "first");
+  for (int i = 0; i < 5; ++i) {
+    StartResult result;
+    StartStep(&tracker, "first", 0, &result);
+    EXPECT_TRUE(result.called);
+    tracker.FinishStep("vars", "first");
+  }
+
+  // "late" does not hold back "first", and may start right away.
+  tracker.Register("vars", "late");
+  StartResult late;
+  StartStep(&tracker, "late", 0, &late);
+  EXPECT_TRUE(late.called);
+  StartResult first;
+  StartStep(&tracker, "first", 0, &first);
+  EXPECT_TRUE(first.called);
+  tracker.FinishStep("vars", "first");
+
+  // Now "first" waits for "late".
+  StartResult next;
+  StartStep(&tracker, "first", 0, &next);
+  EXPECT_FALSE(next.called);
+  tracker.FinishStep("vars", "late");
+  EXPECT_TRUE(next.called);
+}
+
+TEST(StalenessTrackerTest, ShardForGraph) {
+  Scope root = Scope::NewRootScope();
+  auto w = ops::Variable(root.WithOpName("w"), {2}, DT_FLOAT);
+  auto b = ops::Variable(root.WithOpName("b"), {2}, DT_FLOAT);
+  auto read = ops::Identity(root.WithOpName("read"), w);
+  Graph read_only(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&read_only));
+  EXPECT_EQ("", StalenessTracker::ShardForGraph(read_only));
+
+  auto update = ops::Assign(root.WithOpName("update"), b,
+                            ops::Const(root, {1.0f, 2.0f}));
+  Graph updating(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&updating));
+  EXPECT_EQ("b,w", StalenessTracker::ShardForGraph(updating));
+}
+
+}  // namespace
+}  // namespace tensorflow
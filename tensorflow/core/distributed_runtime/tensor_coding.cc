@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <vector>
+
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -88,6 +90,11 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    // The tensor is transferred out of band (see
+    // RecvTensorResponse::transport_options); leave it to the transport.
+    if (!meta_.has_tensor() && meta_.has_transport_options()) {
+      return Status::OK();
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -142,6 +149,28 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
   return input->DecrementRecursionDepthAndPopLimit(p.first);
 }
 
+// Reads the TensorProto::tensor_content encoding of a DT_STRING tensor (the
+// varint32 sizes of all the elements followed by their concatenated data)
+// directly into the elements of "*t", instead of into a temporary proto.
+bool ReadStringTensorContent(protobuf::io::CodedInputStream* input,
+                             int num_bytes, Tensor* t) {
+  auto strings = t->flat<tstring>();
+  std::vector<uint32> sizes(strings.size());
+  const int start = input->CurrentPosition();
+  int64 total_bytes = 0;
+  for (auto& size : sizes) {
+    if (!input->ReadVarint32(&size)) return false;
+    total_bytes += size;
+  }
+  total_bytes += input->CurrentPosition() - start;
+  if (total_bytes != num_bytes) return false;
+  for (int64 i = 0; i < strings.size(); ++i) {
+    strings(i).resize_uninitialized(sizes[i]);
+    if (!input->ReadRaw(strings(i).mdata(), sizes[i])) return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
@@ -167,7 +196,10 @@ bool TensorResponse::ParseTensorSubmessage(
         if ((wt != WIRETYPE_VARINT) || !input->ReadVarint32(&v)) return false;
         if (seen_tensor_content) return false;
         tensor_meta->set_dtype(static_cast<DataType>(static_cast<int>(v)));
-        if (!DataTypeCanUseMemcpy(tensor_meta->dtype())) return false;
+        if (!DataTypeCanUseMemcpy(tensor_meta->dtype()) &&
+            tensor_meta->dtype() != DT_STRING) {
+          return false;
+        }
         break;
       }
       case TensorProto::kTensorShapeFieldNumber: {
@@ -197,6 +229,11 @@ bool TensorResponse::ParseTensorSubmessage(
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
         Tensor t(allocator_, tensor_meta->dtype(), shape);
+        if (tensor_meta->dtype() == DT_STRING) {
+          if (!ReadStringTensorContent(input, num_bytes, &t)) return false;
+          tensor_ = std::move(t);
+          break;
+        }
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -267,6 +304,12 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_require_ack(v != 0);
         break;
       }
+      case RecvTensorResponse::kUncompressedDtypeFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_uncompressed_dtype(static_cast<DataType>(v));
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
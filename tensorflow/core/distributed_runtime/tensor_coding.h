@@ -68,6 +68,9 @@ class TensorResponse {
 
   // Parse the RecvTensorResponse encoded in the data yielded by
   // source->contents() into *this.
+  //
+  // If the response carries transport_options but no tensor, the tensor
+  // content is transferred out of band and tensor() is left empty.
   Status ParseFrom(Source* source);
 
   // Initialize tensor from *response.
@@ -31,6 +31,7 @@ class DeviceMgr;
 class Env;
 class RendezvousMgrInterface;
 class SessionMgr;
+class StalenessTracker;
 
 // The worker environment class, which holds a bag of pointers to
 // per-worker singletons.
@@ -64,6 +65,11 @@ struct WorkerEnv {
 
   // A pool of threads for scheduling compute work.
   thread::ThreadPool* compute_pool = nullptr;
+
+  // Bounds the staleness of asynchronous updates to the variables of this
+  // worker, for graphs registered with a positive
+  // ConfigProto.Experimental.max_staleness_steps.  Not enforced if null.
+  StalenessTracker* staleness_tracker = nullptr;
 };
 
 }  // end namespace tensorflow
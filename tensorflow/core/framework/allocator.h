@@ -164,6 +164,11 @@ struct AllocatorStats {
 
   int64 largest_free_block_bytes;  // Largest free block's size in heap.
 
+  // Fraction of the free bytes in the heap that lie outside the largest free
+  // block, within [0, 1].  Close to 1 means that large allocations may fail
+  // even though enough bytes are free.
+  double fragmentation;
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
@@ -171,7 +176,8 @@ struct AllocatorStats {
         largest_alloc_size(0),
         bytes_reserved(0),
         peak_bytes_reserved(0),
-        largest_free_block_bytes(0) {}
+        largest_free_block_bytes(0),
+        fragmentation(0) {}
 
   std::string DebugString() const;
 };
@@ -454,6 +460,12 @@ class SubAllocator {
   // returned by this allocator.
   virtual bool SupportsCoalescing() const = 0;
 
+  // Returns the granularity at which Free() can release part of a region
+  // returned by Alloc() while the rest of the region stays usable, or 0 if
+  // only whole regions can be freed.  Partial frees must start and end at
+  // multiples of this granularity.
+  virtual size_t PartialFreeGranularity() const { return 0; }
+
  protected:
   // Implementation of Alloc() method must call this on newly allocated
   // value.
@@ -16,8 +16,8 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 
 #include <forward_list>
+#include <vector>
 
-#include "absl/memory/memory.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -35,92 +35,113 @@ CancellationManager::CancellationManager(CancellationManager* parent)
   is_cancelled_ = parent->RegisterChild(this);
 }
 
+CancellationManager::State* CancellationManager::GetOrCreateState() {
+  State* state = state_.load(std::memory_order_acquire);
+  if (TF_PREDICT_TRUE(state != nullptr)) return state;
+  mutex_lock l(mu_);
+  state = state_.load(std::memory_order_relaxed);
+  if (state == nullptr) {
+    state = new State;
+    state_.store(state, std::memory_order_release);
+  }
+  return state;
+}
+
 void CancellationManager::StartCancel() {
-  gtl::FlatMap<CancellationToken, CancelCallback> callbacks_to_run;
+  std::vector<CancelCallback> callbacks_to_run;
   std::forward_list<CancellationManager*> children_to_cancel;
-  Notification* cancelled_notification = nullptr;
+  State* state = nullptr;
   {
     mutex_lock l(mu_);
     if (is_cancelled_.load(std::memory_order_relaxed) || is_cancelling_) {
       return;
     }
     is_cancelling_ = true;
-    if (state_) {
-      std::swap(state_->callbacks, callbacks_to_run);
-
+    state = state_.load(std::memory_order_relaxed);
+    if (state) {
       // Remove all children from the list of children.
-      CancellationManager* child = state_->first_child;
+      CancellationManager* child = state->first_child;
       while (child != nullptr) {
         children_to_cancel.push_front(child);
         child->is_removed_from_parent_ = true;
         child = child->next_sibling_;
       }
-      state_->first_child = nullptr;
-
-      cancelled_notification = &state_->cancelled_notification;
+      state->first_child = nullptr;
     }
   }
-  // We call these callbacks without holding mu_, so that concurrent
+  // Since `is_cancelling_` is set, no callback can be added to or removed
+  // from a shard once its callbacks have been taken here.
+  if (state) {
+    for (CallbackShard& shard : state->callback_shards) {
+      mutex_lock l(shard.mu);
+      for (auto& key_and_value : shard.callbacks) {
+        callbacks_to_run.push_back(std::move(key_and_value.second));
+      }
+      shard.callbacks.clear();
+    }
+  }
+  // We call these callbacks without holding any lock, so that concurrent
   // calls to DeregisterCallback, which can happen asynchronously, do
   // not block. The callbacks remain valid because any concurrent call
   // to DeregisterCallback will block until the
   // cancelled_notification_ is notified.
-  for (auto key_and_value : callbacks_to_run) {
-    key_and_value.second();
+  for (const CancelCallback& callback : callbacks_to_run) {
+    callback();
   }
   for (CancellationManager* child : children_to_cancel) {
     child->StartCancel();
   }
   {
     mutex_lock l(mu_);
+    is_cancelled_.store(true);
     is_cancelling_ = false;
-    is_cancelled_.store(true, std::memory_order_release);
+    // The state may have been created by a registration that raced with this
+    // cancellation, so reload it. A state created after this point cannot have
+    // waiters, since they would observe that cancellation has finished.
+    state = state_.load(std::memory_order_relaxed);
   }
-  if (cancelled_notification) {
-    cancelled_notification->Notify();
+  if (state) {
+    state->cancelled_notification.Notify();
   }
 }
 
 bool CancellationManager::RegisterCallback(CancellationToken token,
                                            CancelCallback callback) {
   DCHECK_LT(token, next_cancellation_token_) << "Invalid cancellation token";
-  mutex_lock l(mu_);
-  bool should_register = !is_cancelled_ && !is_cancelling_;
+  CallbackShard* shard = GetCallbackShard(GetOrCreateState(), token);
+  mutex_lock l(shard->mu);
+  bool should_register = !IsCancellingOrCancelled();
   if (should_register) {
-    if (!state_) {
-      state_ = absl::make_unique<State>();
-    }
-    std::swap(state_->callbacks[token], callback);
+    std::swap(shard->callbacks[token], callback);
   }
   return should_register;
 }
 
 bool CancellationManager::DeregisterCallback(CancellationToken token) {
-  mu_.lock();
-  if (is_cancelled_) {
-    mu_.unlock();
-    return false;
-  } else if (is_cancelling_) {
-    Notification* cancelled_notification =
-        state_ ? &state_->cancelled_notification : nullptr;
-    mu_.unlock();
+  State* state = state_.load(std::memory_order_acquire);
+  if (state == nullptr) {
+    // No callback was ever registered, so none can be running.
+    return !IsCancellingOrCancelled();
+  }
+  CallbackShard* shard = GetCallbackShard(state, token);
+  shard->mu.lock();
+  if (is_cancelling_) {
+    shard->mu.unlock();
     // Wait for all of the cancellation callbacks to be called. This
     // wait ensures that the caller of DeregisterCallback does not
     // return immediately and free objects that may be used in the
     // execution of any currently pending callbacks in StartCancel.
-    if (cancelled_notification) {
-      cancelled_notification->WaitForNotification();
-    }
+    state->cancelled_notification.WaitForNotification();
+    return false;
+  } else if (is_cancelled_) {
+    shard->mu.unlock();
     return false;
   } else {
-    if (state_) {
-      state_->callbacks.erase(token);
-    }
-    mu_.unlock();
+    shard->callbacks.erase(token);
+    shard->mu.unlock();
     return true;
   }
 }
-
 bool CancellationManager::RegisterChild(CancellationManager* child) {
   mutex_lock l(mu_);
   if (is_cancelled_.load(std::memory_order_relaxed) || is_cancelling_) {
@@ -128,13 +149,15 @@ bool CancellationManager::RegisterChild(CancellationManager* child) {
     return true;
   }
 
-  if (!state_) {
-    state_ = absl::make_unique<State>();
+  State* state = state_.load(std::memory_order_relaxed);
+  if (!state) {
+    state = new State;
+    state_.store(state, std::memory_order_release);
   }
 
   // Push `child` onto the front of the list of children.
-  CancellationManager* current_head = state_->first_child;
-  state_->first_child = child;
+  CancellationManager* current_head = state->first_child;
+  state->first_child = child;
   child->prev_sibling_ = nullptr;
   child->next_sibling_ = current_head;
   if (current_head) {
@@ -151,12 +174,13 @@ void CancellationManager::DeregisterChild(CancellationManager* child) {
     mutex_lock l(mu_);
     if (!child->is_removed_from_parent_) {
       // Remove the child from this manager's list of children.
-      DCHECK(state_);
+      State* state = state_.load(std::memory_order_relaxed);
+      DCHECK(state);
 
       if (child->prev_sibling_ == nullptr) {
         // The child was at the head of the list.
-        DCHECK_EQ(state_->first_child, child);
-        state_->first_child = child->next_sibling_;
+        DCHECK_EQ(state->first_child, child);
+        state->first_child = child->next_sibling_;
       } else {
         child->prev_sibling_->next_sibling_ = child->next_sibling_;
       }
@@ -167,8 +191,9 @@ void CancellationManager::DeregisterChild(CancellationManager* child) {
 
       child->is_removed_from_parent_ = true;
     }
-    if (is_cancelling_) {
-      cancelled_notification = &state_->cancelled_notification;
+    State* state = state_.load(std::memory_order_relaxed);
+    if (is_cancelling_ && state) {
+      cancelled_notification = &state->cancelled_notification;
     }
   }
 
@@ -181,13 +206,16 @@ void CancellationManager::DeregisterChild(CancellationManager* child) {
 }
 
 bool CancellationManager::TryDeregisterCallback(CancellationToken token) {
-  mutex_lock lock(mu_);
-  if (is_cancelled_ || is_cancelling_) {
+  State* state = state_.load(std::memory_order_acquire);
+  if (state == nullptr) {
+    return !IsCancellingOrCancelled();
+  }
+  CallbackShard* shard = GetCallbackShard(state, token);
+  mutex_lock lock(shard->mu);
+  if (IsCancellingOrCancelled()) {
     return false;
   } else {
-    if (state_) {
-      state_->callbacks.erase(token);
-    }
+    shard->callbacks.erase(token);
     return true;
   }
 }
@@ -196,8 +224,9 @@ CancellationManager::~CancellationManager() {
   if (parent_) {
     parent_->DeregisterChild(this);
   }
-  if (state_) {
+  if (state_.load(std::memory_order_acquire)) {
     StartCancel();
+    delete state_.load(std::memory_order_relaxed);
   }
 }
 
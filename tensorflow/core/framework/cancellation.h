@@ -19,6 +19,7 @@ limitations under the License.
 #include <atomic>
 #include <functional>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
@@ -147,9 +148,19 @@ class CancellationManager {
   bool IsCancelling();
 
  private:
+  // Callbacks are spread over shards by token, each with its own mutex, so
+  // that concurrent registrations and deregistrations on a manager shared by
+  // many ops do not serialize on `mu_`.
+  static constexpr int kNumCallbackShards = 8;
+  struct CallbackShard {
+    mutex mu;
+    absl::flat_hash_map<CancellationToken, CancelCallback> callbacks
+        TF_GUARDED_BY(mu);
+  };
+
   struct State {
     Notification cancelled_notification;
-    gtl::FlatMap<CancellationToken, CancelCallback> callbacks;
+    CallbackShard callback_shards[kNumCallbackShards];
 
     // If this CancellationManager has any children, this member points to the
     // head of a doubly-linked list of its children.
@@ -159,7 +170,24 @@ class CancellationManager {
   bool RegisterChild(CancellationManager* child);
   void DeregisterChild(CancellationManager* child);
 
-  bool is_cancelling_;
+  // Returns the state, creating it on first use.
+  State* GetOrCreateState();
+  static CallbackShard* GetCallbackShard(State* state,
+                                         CancellationToken token) {
+    return &state->callback_shards[static_cast<uint64>(token) %
+                                   kNumCallbackShards];
+  }
+  // Returns true iff StartCancel() has been called, whether or not it has
+  // finished. Callbacks may only be added to or removed from a shard while
+  // this is false and the shard's mutex is held.
+  bool IsCancellingOrCancelled() {
+    // StartCancel() sets `is_cancelled_` before it clears `is_cancelling_`, so
+    // reading the flags in this order cannot miss both.
+    return is_cancelling_.load() || is_cancelled_.load();
+  }
+
+  // Written under `mu_`, but read without it by callback (de)registration.
+  std::atomic_bool is_cancelling_;
   std::atomic_bool is_cancelled_;
   std::atomic<CancellationToken> next_cancellation_token_;
 
@@ -179,7 +207,9 @@ class CancellationManager {
       nullptr;  // Not owned.
 
   mutex mu_;
-  std::unique_ptr<State> state_ TF_GUARDED_BY(mu_);
+  // Created under `mu_` and never replaced, so once non-null it can be read
+  // without holding `mu_`. Owned.
+  std::atomic<State*> state_{nullptr};
 };
 
 // Registers the given cancellation callback, returning a function that can be
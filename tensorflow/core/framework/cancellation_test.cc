@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 
 #include <algorithm>
+#include <atomic>
 #include <numeric>
 #include <random>
 #include <vector>
@@ -196,6 +197,32 @@ TEST(Cancellation, TryDeregisterDuringCancel) {
   delete manager;
 }
 
+TEST(Cancellation, ConcurrentRegisterAndDeregister) {
+  CancellationManager* manager = new CancellationManager();
+  std::atomic<int> num_cancelled(0);
+  const int kNumThreads = 8;
+  const int kNumIterations = 1000;
+  {
+    thread::ThreadPool w(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      w.Schedule([&]() {
+        for (int i = 0; i < kNumIterations; ++i) {
+          auto token = manager->get_cancellation_token();
+          EXPECT_TRUE(manager->RegisterCallback(
+              token, [&num_cancelled]() { ++num_cancelled; }));
+          // Leave the last callback of each thread registered.
+          if (i + 1 < kNumIterations) {
+            EXPECT_TRUE(manager->DeregisterCallback(token));
+          }
+        }
+      });
+    }
+  }
+  manager->StartCancel();
+  EXPECT_EQ(kNumThreads, num_cancelled);
+  delete manager;
+}
+
 TEST(Cancellation, Parent_CancelManyChildren) {
   CancellationManager parent;
   std::vector<std::unique_ptr<CancellationManager>> children;
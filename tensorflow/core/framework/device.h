@@ -151,6 +151,19 @@ class Device : public DeviceBase {
     return Status::OK();
   }
 
+  // Fills in a per-node DeviceContext map for executing `graph`, indexed by
+  // node id.  Devices that run nodes on more than one stream use this to
+  // pick the context (and therefore the stream) of each node; nodes without
+  // an entry, or all nodes if the map is left empty, use the context
+  // returned by TryGetDeviceContext().
+  //
+  // The caller takes ownership of one reference on each non-null
+  // DeviceContext* in the map, and should call Unref().
+  virtual Status FillContextMap(
+      const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+    return Status::OK();
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
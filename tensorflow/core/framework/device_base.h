@@ -47,6 +47,8 @@ class EventMgr;
 class OpKernelContext;
 class ResourceMgr;
 class ScopedAllocatorMgr;
+class StaticPlanAllocator;
+class TensorBufferPool;
 class TensorProto;
 
 namespace thread {
@@ -200,6 +202,17 @@ class DeviceBase {
 
   virtual ScopedAllocatorMgr* GetScopedAllocatorMgr() const { return nullptr; }
 
+  // Returns the allocator that serves step-local buffers from a static memory
+  // plan, if the device has one.  The session brackets each step with its
+  // BeginStep()/EndStep().
+  virtual StaticPlanAllocator* GetStaticPlanAllocator() const {
+    return nullptr;
+  }
+
+  // Returns the pool that OpKernelContext uses to recycle the buffers of
+  // tensors allocated from this device's default allocator, if any.
+  virtual TensorBufferPool* GetTensorBufferPool() const { return nullptr; }
+
   virtual bool has_eigen_cpu_device() const {
     return !eigen_cpu_devices_.empty();
   }
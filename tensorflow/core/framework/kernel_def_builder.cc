@@ -141,7 +141,7 @@ KernelDefBuilder& KernelDefBuilder::Priority(int32 priority) {
   return *this;
 }
 
-const KernelDef* KernelDefBuilder::Build() {
+KernelDef* KernelDefBuilder::Build() {
   KernelDef* r = kernel_def_;
   kernel_def_ = nullptr;
   return r;
@@ -81,7 +81,7 @@ class KernelDefBuilder {
   // Returns a pointer to a KernelDef with fields set based on the
   // above calls to this instance.
   // Caller takes ownership of the result.
-  const KernelDef* Build();
+  KernelDef* Build();
 
  private:
   KernelDef* kernel_def_;
@@ -15,10 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/framework/local_rendezvous.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -96,41 +101,49 @@ void LocalRendezvous::ItemQueue::push_back(Item* item) {
   }
 }
 
+constexpr int LocalRendezvous::kNumShards;
+
 LocalRendezvous::~LocalRendezvous() {
-  if (!table_.empty()) {
-    StartAbort(errors::Cancelled("LocalRendezvous deleted"));
+  for (Shard& shard : shards_) {
+    if (!shard.table.empty()) {
+      StartAbort(errors::Cancelled("LocalRendezvous deleted"));
+      break;
+    }
   }
 }
 
 namespace {
 uint64 KeyHash(const StringPiece& k) { return Hash64(k.data(), k.size()); }
-}  // namespace
 
-Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
-                             const Rendezvous::Args& send_args,
-                             const Tensor& val, const bool is_dead) {
-  uint64 key_hash = KeyHash(key.FullKey());
-  DVLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
-
-  if (is_dead) {
-    static auto* rendezvous_dead_values_sent = monitoring::Counter<2>::New(
-        "/tensorflow/core/rendezvous_dead_values_sent",
-        "The number of dead values sent between a pair of devices.",
-        "send_device", "recv_device");
-    rendezvous_dead_values_sent
-        ->GetCell(string(key.src_device), string(key.dst_device))
-        ->IncrementBy(1);
-  }
+void RecordDeadValue(const Rendezvous::ParsedKey& key) {
+  static auto* rendezvous_dead_values_sent = monitoring::Counter<2>::New(
+      "/tensorflow/core/rendezvous_dead_values_sent",
+      "The number of dead values sent between a pair of devices.",
+      "send_device", "recv_device");
+  rendezvous_dead_values_sent
+      ->GetCell(string(key.src_device), string(key.dst_device))
+      ->IncrementBy(1);
+}
 
-  mu_.lock();
-  if (!status_.ok()) {
-    // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
-    return s;
-  }
+// Returns the indices of `items` ordered by the shard of their key hash.  The
+// relative order of items within a shard, and hence of messages under one
+// key, is preserved.
+template <typename ShardFn>
+std::vector<int> OrderByShard(const std::vector<uint64>& key_hashes,
+                              ShardFn shard_fn) {
+  std::vector<int> order(key_hashes.size());
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return shard_fn(key_hashes[a]) < shard_fn(key_hashes[b]);
+  });
+  return order;
+}
+}  // namespace
 
-  ItemQueue* queue = &table_[key_hash];
+LocalRendezvous::Item* LocalRendezvous::SendLocked(
+    Shard* shard, uint64 key_hash, const Rendezvous::ParsedKey& key,
+    const Rendezvous::Args& send_args, const Tensor& val, bool is_dead) {
+  ItemQueue* queue = &shard->table[key_hash];
   if (queue->head == nullptr || queue->head->type == Item::kSend) {
     // There is no waiter for this message. Append the message
     // into the queue. The waiter will pick it up when arrives.
@@ -139,8 +152,7 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
     // the lock.
     DVLOG(2) << "Enqueue Send Item (key:" << key.FullKey() << "). ";
     queue->push_back(new Item(send_args, val, is_dead));
-    mu_.unlock();
-    return Status::OK();
+    return nullptr;
   }
 
   DVLOG(2) << "Consume Recv Item (key:" << key.FullKey() << "). ";
@@ -150,36 +162,97 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    shard->table.erase(key_hash);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
-
-  // Notify the waiter by invoking its done closure, outside the
-  // lock.
   DCHECK_EQ(item->type, Item::kRecv);
-  (*item->recv_state.waiter)(Status::OK(), send_args, item->args, val, is_dead);
-  delete item;
-  return Status::OK();
+  return item;
 }
 
-void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
-                                const Rendezvous::Args& recv_args,
-                                Rendezvous::DoneCallback done) {
+Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
+                             const Rendezvous::Args& send_args,
+                             const Tensor& val, const bool is_dead) {
   uint64 key_hash = KeyHash(key.FullKey());
-  DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
+  DVLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
+
+  if (is_dead) RecordDeadValue(key);
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = ShardFor(key_hash);
+  shard->mu.lock();
+  if (!shard->status.ok()) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
-    done(s, Rendezvous::Args(), recv_args, Tensor(), false);
-    return;
+    Status s = shard->status;
+    shard->mu.unlock();
+    return s;
   }
+  Item* item = SendLocked(shard, key_hash, key, send_args, val, is_dead);
+  shard->mu.unlock();
+
+  if (item != nullptr) {
+    // Notify the waiter by invoking its done closure, outside the
+    // lock.
+    (*item->recv_state.waiter)(Status::OK(), send_args, item->args, val,
+                               is_dead);
+    delete item;
+  }
+  return Status::OK();
+}
+
+Status LocalRendezvous::SendBatch(
+    gtl::ArraySlice<Rendezvous::SendItem> items) {
+  // Callbacks run between shards may drop the caller's reference to the
+  // owner, so keep it alive until the whole batch has been processed.
+  if (rc_owner_) rc_owner_->Ref();
+  core::ScopedUnref unref_owner(rc_owner_);
+  std::vector<uint64> key_hashes(items.size());
+  for (int i = 0; i < items.size(); ++i) {
+    const Rendezvous::SendItem& send = items[i];
+    key_hashes[i] = KeyHash(send.key.FullKey());
+    DVLOG(2) << "Send " << this << " " << key_hashes[i] << " "
+             << send.key.FullKey();
+    if (send.is_dead) RecordDeadValue(send.key);
+  }
+  const std::vector<int> order = OrderByShard(
+      key_hashes, [this](uint64 key_hash) { return ShardFor(key_hash); });
+
+  std::vector<std::pair<Item*, int>> waiters;
+  for (int begin = 0; begin < order.size();) {
+    Shard* shard = ShardFor(key_hashes[order[begin]]);
+    int end = begin;
+    {
+      mutex_lock l(shard->mu);
+      if (!shard->status.ok()) {
+        // Rendezvous has been aborted.
+        return shard->status;
+      }
+      for (; end < order.size() && ShardFor(key_hashes[order[end]]) == shard;
+           ++end) {
+        const int i = order[end];
+        const Rendezvous::SendItem& send = items[i];
+        Item* item = SendLocked(shard, key_hashes[i], send.key, send.args,
+                                send.val, send.is_dead);
+        if (item != nullptr) waiters.emplace_back(item, i);
+      }
+    }
+    for (const auto& waiter : waiters) {
+      const Rendezvous::SendItem& send = items[waiter.second];
+      (*waiter.first->recv_state.waiter)(Status::OK(), send.args,
+                                         waiter.first->args, send.val,
+                                         send.is_dead);
+      delete waiter.first;
+    }
+    waiters.clear();
+    begin = end;
+  }
+  return Status::OK();
+}
 
-  ItemQueue* queue = &table_[key_hash];
+LocalRendezvous::RecvOutcome LocalRendezvous::RecvLocked(
+    Shard* shard, uint64 key_hash, const Rendezvous::ParsedKey& key,
+    const Rendezvous::Args& recv_args, Rendezvous::DoneCallback* done,
+    Item** item) {
+  ItemQueue* queue = &shard->table[key_hash];
   if (queue->head == nullptr || queue->head->type == Item::kRecv) {
     // There is no message to pick up.
     // Only recv-related fields need to be filled.
@@ -202,11 +275,12 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       //     unref in the cancellation callback.
       if (rc_owner_) rc_owner_->Ref();
       token = cm->get_cancellation_token();
-      already_cancelled = !cm->RegisterCallback(token, [this, token, key_hash] {
+      already_cancelled = !cm->RegisterCallback(token, [this, shard, token,
+                                                        key_hash] {
         Item* item = nullptr;
         {
-          mutex_lock l(mu_);
-          ItemQueue* queue = &table_[key_hash];
+          mutex_lock l(shard->mu);
+          ItemQueue* queue = &shard->table[key_hash];
           // Find an item in the queue with a cancellation token that matches
           // `token`, and remove it.
           if (queue->head != nullptr && queue->head->type == Item::kRecv) {
@@ -217,7 +291,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
                 if (queue->head->next == nullptr) {
                   // We have a single-element queue, so we can erase it from
                   // the table.
-                  table_.erase(key_hash);
+                  shard->table.erase(key_hash);
                 } else {
                   // Remove the current item from the queue.
                   if (curr == queue->head) {
@@ -249,13 +323,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       });
     }
     if (already_cancelled) {
-      mu_.unlock();
-      // Unref case (2)
-      if (rc_owner_) rc_owner_->Unref();
-      done(StatusGroup::MakeDerived(
-               errors::Cancelled("RecvAsync is cancelled.")),
-           Rendezvous::Args(), recv_args, Tensor(), /*is_dead=*/false);
-      return;
+      return RecvOutcome::kCancelled;
     }
 
     DVLOG(2) << "Enqueue Recv Item (key:" << key.FullKey() << "). ";
@@ -268,7 +336,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       // cancellation manager may no longer be live after `done` is called.
       queue->push_back(new Item(
           recv_args,
-          [this, cm, token, done = std::move(done)](
+          [this, cm, token, done = std::move(*done)](
               const Status& s, const Rendezvous::Args& send_args,
               const Rendezvous::Args& recv_args, const Tensor& v, bool dead) {
             // TryDeregisterCallback returns true when the cancellation callback
@@ -283,52 +351,143 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
           },
           token));
     } else {
-      queue->push_back(new Item(recv_args, std::move(done), token));
+      queue->push_back(new Item(recv_args, std::move(*done), token));
     }
-
-    mu_.unlock();
-    return;
+    return RecvOutcome::kEnqueued;
   }
 
   DVLOG(2) << "Consume Send Item (key:" << key.FullKey() << "). ";
   // A message has already arrived and is queued in the table under
   // this key.  Consumes the message and invokes the done closure.
-  Item* item = queue->head;
+  *item = queue->head;
 
   // Delete the queue when the last element has been consumed.
-  if (item->next == nullptr) {
+  if ((*item)->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    shard->table.erase(key_hash);
   } else {
-    queue->head = item->next;
+    queue->head = (*item)->next;
+  }
+  DCHECK_EQ((*item)->type, Item::kSend);
+  return RecvOutcome::kConsumed;
+}
+
+void LocalRendezvous::FinishRecv(RecvOutcome outcome, Item* item,
+                                 const Rendezvous::Args& recv_args,
+                                 const Rendezvous::DoneCallback& done) {
+  switch (outcome) {
+    case RecvOutcome::kEnqueued:
+      break;
+    case RecvOutcome::kConsumed:
+      // Invoke done() without holding the table lock.
+      done(Status::OK(), item->args, recv_args, *item->send_state.value,
+           item->send_state.is_dead);
+      delete item;
+      break;
+    case RecvOutcome::kCancelled:
+      // Unref case (2)
+      if (rc_owner_) rc_owner_->Unref();
+      done(StatusGroup::MakeDerived(
+               errors::Cancelled("RecvAsync is cancelled.")),
+           Rendezvous::Args(), recv_args, Tensor(), /*is_dead=*/false);
+      break;
+  }
+}
+
+void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
+                                const Rendezvous::Args& recv_args,
+                                Rendezvous::DoneCallback done) {
+  uint64 key_hash = KeyHash(key.FullKey());
+  DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
+
+  Shard* shard = ShardFor(key_hash);
+  shard->mu.lock();
+  if (!shard->status.ok()) {
+    // Rendezvous has been aborted.
+    Status s = shard->status;
+    shard->mu.unlock();
+    done(s, Rendezvous::Args(), recv_args, Tensor(), false);
+    return;
   }
-  mu_.unlock();
+  Item* item = nullptr;
+  RecvOutcome outcome =
+      RecvLocked(shard, key_hash, key, recv_args, &done, &item);
+  shard->mu.unlock();
+  FinishRecv(outcome, item, recv_args, done);
+}
 
-  // Invoke done() without holding the table lock.
-  DCHECK_EQ(item->type, Item::kSend);
-  done(Status::OK(), item->args, recv_args, *item->send_state.value,
-       item->send_state.is_dead);
-  delete item;
+void LocalRendezvous::RecvBatchAsync(
+    gtl::MutableArraySlice<Rendezvous::RecvItem> items) {
+  // Callbacks run between shards may drop the caller's reference to the
+  // owner, so keep it alive until the whole batch has been processed.
+  if (rc_owner_) rc_owner_->Ref();
+  core::ScopedUnref unref_owner(rc_owner_);
+  std::vector<uint64> key_hashes(items.size());
+  for (int i = 0; i < items.size(); ++i) {
+    key_hashes[i] = KeyHash(items[i].key.FullKey());
+    DVLOG(2) << "Recv " << this << " " << key_hashes[i] << " "
+             << items[i].key.FullKey();
+  }
+  const std::vector<int> order = OrderByShard(
+      key_hashes, [this](uint64 key_hash) { return ShardFor(key_hash); });
+
+  std::vector<std::pair<RecvOutcome, Item*>> outcomes(items.size());
+  for (int begin = 0; begin < order.size();) {
+    Shard* shard = ShardFor(key_hashes[order[begin]]);
+    int end = begin;
+    while (end < order.size() && ShardFor(key_hashes[order[end]]) == shard) {
+      ++end;
+    }
+    Status status;
+    {
+      mutex_lock l(shard->mu);
+      status = shard->status;
+      if (status.ok()) {
+        for (int j = begin; j < end; ++j) {
+          const int i = order[j];
+          Rendezvous::RecvItem& recv = items[i];
+          outcomes[i].second = nullptr;
+          outcomes[i].first =
+              RecvLocked(shard, key_hashes[i], recv.key, recv.args,
+                         &recv.done, &outcomes[i].second);
+        }
+      }
+    }
+    for (int j = begin; j < end; ++j) {
+      const int i = order[j];
+      Rendezvous::RecvItem& recv = items[i];
+      if (!status.ok()) {
+        // Rendezvous has been aborted.
+        recv.done(status, Rendezvous::Args(), recv.args, Tensor(), false);
+      } else {
+        FinishRecv(outcomes[i].first, outcomes[i].second, recv.args,
+                   recv.done);
+      }
+    }
+    begin = end;
+  }
 }
 
 void LocalRendezvous::StartAbort(const Status& status) {
   CHECK(!status.ok());
-  Table table;
-  {
-    mutex_lock l(mu_);
-    status_.Update(status);
-    table_.swap(table);
-  }
-  for (auto& p : table) {
-    Item* item = p.second.head;
-    while (item != nullptr) {
-      if (item->type == Item::kRecv) {
-        (*item->recv_state.waiter)(status, Rendezvous::Args(),
-                                   Rendezvous::Args(), Tensor(), false);
+  for (Shard& shard : shards_) {
+    Table table;
+    {
+      mutex_lock l(shard.mu);
+      shard.status.Update(status);
+      shard.table.swap(table);
+    }
+    for (auto& p : table) {
+      Item* item = p.second.head;
+      while (item != nullptr) {
+        if (item->type == Item::kRecv) {
+          (*item->recv_state.waiter)(status, Rendezvous::Args(),
+                                     Rendezvous::Args(), Tensor(), false);
+        }
+        Item* to_delete = item;
+        item = item->next;
+        delete to_delete;
       }
-      Item* to_delete = item;
-      item = item->next;
-      delete to_delete;
     }
   }
 }
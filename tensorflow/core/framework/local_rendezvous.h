@@ -19,9 +19,11 @@ limitations under the License.
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -50,6 +52,12 @@ class LocalRendezvous {
                  Rendezvous::DoneCallback done);
   void StartAbort(const Status& status);
 
+  // Batched versions of Send() and RecvAsync() with the semantics of
+  // RendezvousInterface::SendBatch() and RecvBatchAsync().  Each shard of the
+  // table is locked once per batch rather than once per message.
+  Status SendBatch(gtl::ArraySlice<Rendezvous::SendItem> items);
+  void RecvBatchAsync(gtl::MutableArraySlice<Rendezvous::RecvItem> items);
+
  private:
   struct Item;
 
@@ -66,13 +74,46 @@ class LocalRendezvous {
 
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
+  // The table is split by key hash into independently locked shards, so that
+  // concurrent Send/Recv calls on unrelated keys do not contend.
+  struct Shard {
+    mutex mu;
+    Table table TF_GUARDED_BY(mu);
+    Status status TF_GUARDED_BY(mu);
+  };
+  static constexpr int kNumShards = 8;
+
+  // What RecvLocked() did with a request.
+  enum class RecvOutcome { kEnqueued, kConsumed, kCancelled };
+
+  Shard* ShardFor(uint64 key_hash) {
+    return &shards_[(key_hash >> 32) % kNumShards];
+  }
+
+  // Enqueues a message in `shard`, or dequeues and returns the earliest
+  // waiter for it, which the caller must notify and delete after releasing
+  // the lock.
+  Item* SendLocked(Shard* shard, uint64 key_hash,
+                   const Rendezvous::ParsedKey& key,
+                   const Rendezvous::Args& send_args, const Tensor& val,
+                   bool is_dead) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+
+  // Enqueues a waiter in `shard`, moving from `*done`, or dequeues the
+  // earliest message into `*item`.  The caller must pass the result to
+  // FinishRecv() after releasing the lock.
+  RecvOutcome RecvLocked(Shard* shard, uint64 key_hash,
+                         const Rendezvous::ParsedKey& key,
+                         const Rendezvous::Args& recv_args,
+                         Rendezvous::DoneCallback* done, Item** item)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+  void FinishRecv(RecvOutcome outcome, Item* item,
+                  const Rendezvous::Args& recv_args,
+                  const Rendezvous::DoneCallback& done);
+
   // Pointer to the owner class of this LocalRendezvous if it is refcounted.
   const Rendezvous* rc_owner_;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ TF_GUARDED_BY(mu_);
-  Status status_ TF_GUARDED_BY(mu_);
+  Shard shards_[kNumShards];
 
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvous);
 };
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -38,6 +39,27 @@ auto* graph_optimization_usecs =
                                 "optimization pass in microseconds.",
                                 "kind", "name");
 
+auto* grappler_pass_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/grappler/pass_time_usecs",
+     "The wall-clock time of each run of a Grappler pass in microseconds.",
+     "name"},
+    // Power of 2 with bucket count 30 (> 17 minutes)
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
+auto* grappler_pass_nodes_added = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler/pass_nodes_added",
+    "The number of nodes added to graphs by a Grappler pass.", "name");
+
+auto* grappler_pass_nodes_removed = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler/pass_nodes_removed",
+    "The number of nodes removed from graphs by a Grappler pass.", "name");
+
+auto* grappler_pass_deadline_exceeded = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler/pass_deadline_exceeded",
+    "The number of times a Grappler pass exceeded the meta optimizer "
+    "deadline.",
+    "name");
+
 auto* graph_run_time_usecs_histogram = monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_time_usecs_histogram",
      "The wall-clock time spent on executing graphs in microseconds."},
@@ -77,6 +99,16 @@ auto* tf_data_bytes_produced_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/bytes_produced",
     "The number of bytes produced by a tf.data Dataset.", "name");
 
+auto* tf_data_buffered_bytes_gauge = monitoring::Gauge<int64, 1>::New(
+    "/tensorflow/data/buffered_bytes",
+    "The number of bytes buffered by a tf.data Dataset.", "name");
+
+auto* tf_data_cpu_time_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/cpu_time",
+    "The thread CPU time in microseconds spent by a tf.data Dataset, excluding "
+    "its inputs.",
+    "name");
+
 auto* tf_data_bytes_read_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/bytes_read",
     "The number of bytes read by tf.data Dataset sources.", "name");
@@ -163,6 +195,16 @@ auto* xla_compilation_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_async_compilation_fallbacks = monitoring::Counter<0>::New(
+    "/tensorflow/core/xla_async_compilation_fallbacks",
+    "The number of XLA cluster executions that took the TF fallback path "
+    "while the cluster was compiled asynchronously.");
+
+auto* xla_async_compilation_fallback_time_usecs = monitoring::Counter<0>::New(
+    "/tensorflow/core/xla_async_compilation_fallback_time_usecs",
+    "The total time in microseconds during which XLA clusters ran on the TF "
+    "fallback path while they were compiled asynchronously.");
+
 auto* xla_tpu_spmd_cores_per_replica = monitoring::Counter<1>::New(
     "/tensorflow/tpu/xla_spmd_cores_per_replica",
     "The number of cores used by XLA SPMD-replicated models.", "cores");
@@ -172,6 +214,22 @@ auto* bfc_allocator_delay =
                                 "The total time spent running each graph "
                                 "optimization pass in microseconds.");
 
+auto* run_handler_queueing_delay_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler_queueing_delay_usecs_histogram",
+     "The mean time inter-op closures of a RunHandler request waited before "
+     "running, in microseconds.",
+     "priority"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* device_event_callback_lag_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/device_event_callback_lag_usecs_histogram",
+     "Upper bound on the time between a device event completing and the "
+     "EventMgr callback waiting on it starting to run, in microseconds.",
+     "polling_mode"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
 }  // namespace
 
 void RecordTFDataAutotune(const string& name) {
@@ -190,6 +248,14 @@ monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name) {
   return tf_data_bytes_read_counter->GetCell(name);
 }
 
+monitoring::GaugeCell<int64>* GetTFDataBufferedBytesGauge(const string& name) {
+  return tf_data_buffered_bytes_gauge->GetCell(name);
+}
+
+monitoring::CounterCell* GetTFDataCpuTimeCounter(const string& name) {
+  return tf_data_cpu_time_counter->GetCell(name);
+}
+
 monitoring::CounterCell* GetTFDataElementsCounter(const string& name) {
   return tf_data_elements_counter->GetCell(name);
 }
@@ -305,6 +371,23 @@ void UpdateGrapplerPassTime(const string& pass_name,
   }
 }
 
+void UpdateGrapplerPassReport(const string& pass_name,
+                              const uint64 running_time_usecs,
+                              const int64 num_nodes_delta,
+                              const bool deadline_exceeded) {
+  grappler_pass_time_usecs->GetCell(pass_name)->Add(running_time_usecs);
+  if (num_nodes_delta > 0) {
+    grappler_pass_nodes_added->GetCell(pass_name)->IncrementBy(
+        num_nodes_delta);
+  } else if (num_nodes_delta < 0) {
+    grappler_pass_nodes_removed->GetCell(pass_name)->IncrementBy(
+        -num_nodes_delta);
+  }
+  if (deadline_exceeded) {
+    grappler_pass_deadline_exceeded->GetCell(pass_name)->IncrementBy(1);
+  }
+}
+
 void UpdateGraphBuildTime(const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
     static auto* build_graph_calls_cell = build_graph_calls->GetCell();
@@ -325,6 +408,17 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+void UpdateXlaAsyncCompilationFallback(const uint64 fallback_executions,
+                                       const uint64 fallback_time_usecs) {
+  static auto* xla_async_compilation_fallbacks_cell =
+      xla_async_compilation_fallbacks->GetCell();
+  static auto* xla_async_compilation_fallback_time_usecs_cell =
+      xla_async_compilation_fallback_time_usecs->GetCell();
+  xla_async_compilation_fallbacks_cell->IncrementBy(fallback_executions);
+  xla_async_compilation_fallback_time_usecs_cell->IncrementBy(
+      fallback_time_usecs);
+}
+
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   static auto* bfc_allocator_delay_cell = bfc_allocator_delay->GetCell();
   if (delay_usecs > 0) {
@@ -332,6 +426,17 @@ void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   }
 }
 
+void RecordRunHandlerQueueingDelay(int64 priority, uint64 delay_usecs) {
+  run_handler_queueing_delay_usecs_histogram
+      ->GetCell(absl::StrCat(priority))
+      ->Add(delay_usecs);
+}
+
+monitoring::SamplerCell* GetDeviceEventCallbackLagHistogram(
+    const string& polling_mode) {
+  return device_event_callback_lag_usecs_histogram->GetCell(polling_mode);
+}
+
 void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_FRAMEWORK_METRICS_H_
 
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -47,6 +49,19 @@ monitoring::CounterCell* GetTFDataBytesProducedCounter(const string& name);
 // TODO(jsimsa): Remove this now that we have GetTFDataBytesConsumedCounter?
 monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name);
 
+// Returns a gauge that can be used to record the number of bytes buffered by
+// a tf.data.Dataset.
+//
+// The `name` argument identifies the Dataset type (e.g. "Prefetch").
+monitoring::GaugeCell<int64>* GetTFDataBufferedBytesGauge(const string& name);
+
+// Returns a counter that can be used to record the thread CPU time (in
+// microseconds) spent producing elements of a tf.data.Dataset, excluding the
+// time spent in its inputs.
+//
+// The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
+monitoring::CounterCell* GetTFDataCpuTimeCounter(const string& name);
+
 // Returns a counter than can be used to record the number of elements produced
 // by a tf.data.Dataset.
 //
@@ -135,12 +150,39 @@ void UpdateGraphOptimizationPassTime(const string& pass_name,
 void UpdateGrapplerPassTime(const string& pass_name,
                             const uint64 running_time_usecs);
 
+// Updates the metrics stored about the effect of a single run of a Grappler
+// pass: its wall time, the number of nodes it added or removed, and whether
+// it exceeded the meta optimizer deadline.
+void UpdateGrapplerPassReport(const string& pass_name,
+                              const uint64 running_time_usecs,
+                              const int64 num_nodes_delta,
+                              const bool deadline_exceeded);
+
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Updates the metrics stored about executions that took the TF fallback path
+// while an XLA cluster was compiled asynchronously, and about the time from
+// queueing that compilation until it finished.
+void UpdateXlaAsyncCompilationFallback(const uint64 fallback_executions,
+                                       const uint64 fallback_time_usecs);
+
 // Updates the metrics stored about time BFC allocator spents during delay.
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 
+// Records the mean time (in microseconds) that the inter-op closures of one
+// RunHandler request of the given priority waited before they started running.
+void RecordRunHandlerQueueingDelay(int64 priority, uint64 delay_usecs);
+
+// Returns a histogram cell recording, in microseconds, the lag between a
+// device event completing and the EventMgr callback waiting on it starting to
+// run, for the given EventMgr polling mode ("busy_poll", "sleep" or
+// "host_callback").
+//
+// The returned cell is valid for the lifetime of the process.
+monitoring::SamplerCell* GetDeviceEventCallbackLagHistogram(
+    const string& polling_mode);
+
 }  // namespace metrics
 }  // namespace tensorflow
 
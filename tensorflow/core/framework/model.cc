@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 
 namespace tensorflow {
 namespace data {
@@ -891,6 +893,7 @@ class Unknown : public Node {
 }  // namespace
 
 thread_local int64 Node::work_start_;
+thread_local int64 Node::cpu_work_start_;
 
 std::shared_ptr<Parameter> MakeParameter(const string& name,
                                          std::shared_ptr<SharedState> state,
@@ -1116,6 +1119,8 @@ void Node::FlushMetrics() {
   metrics_.record_bytes_consumed(bytes_consumed_);
   metrics_.record_bytes_produced(bytes_produced_);
   metrics_.record_num_elements(num_elements_);
+  metrics_.record_cpu_time(cpu_time_);
+  metrics_.record_buffered_bytes(buffered_bytes_);
 }
 
 double Node::OutputTime(Node::NodeValues* input_times,
@@ -1405,6 +1410,7 @@ std::shared_ptr<Node> Node::SnapshotHelper(
     cloned_current->buffered_elements_.store(buffered_elements_);
     cloned_current->bytes_consumed_.store(bytes_consumed_);
     cloned_current->bytes_produced_.store(bytes_produced_);
+    cloned_current->cpu_time_.store(cpu_time_);
     cloned_current->num_elements_.store(num_elements_);
     cloned_current->record_metrics_.store(false);
     cloned_current->processing_time_.store(processing_time_);
@@ -1466,6 +1472,7 @@ Status Node::ToProto(ModelProto::Node* node_proto) const {
   node_proto->set_buffered_elements(buffered_elements_);
   node_proto->set_bytes_consumed(bytes_consumed_);
   node_proto->set_bytes_produced(bytes_produced_);
+  node_proto->set_cpu_time(cpu_time_);
   node_proto->set_num_elements(num_elements_);
   node_proto->set_processing_time(processing_time_);
   node_proto->set_record_metrics(record_metrics_);
@@ -1497,6 +1504,7 @@ Status Node::FromProtoHelper(ModelProto::Node node_proto,
   node->buffered_elements_.store(node_proto.buffered_elements());
   node->bytes_consumed_.store(node_proto.bytes_consumed());
   node->bytes_produced_.store(node_proto.bytes_produced());
+  node->cpu_time_.store(node_proto.cpu_time());
   node->num_elements_.store(node_proto.num_elements());
   node->processing_time_.store(node_proto.processing_time());
   node->record_metrics_.store(node_proto.record_metrics());
@@ -1602,6 +1610,21 @@ void Model::FlushMetrics() {
     auto node = queue.front();
     queue.pop_front();
     node->FlushMetrics();
+    // Summarizes the node in the trace, so that profiles attribute the work of
+    // the input pipeline to individual iterators.
+    profiler::TraceMe::InstantActivity(
+        [&node]() {
+          return profiler::TraceMeEncode(
+              "TfDataNodeStats",
+              {{"name", node->long_name()},
+               {"cpu_time_us", node->cpu_time() / EnvTime::kMicrosToNanos},
+               {"processing_time_us",
+                node->processing_time() / EnvTime::kMicrosToNanos},
+               {"num_elements", node->num_elements()},
+               {"bytes_produced", node->bytes_produced()},
+               {"buffered_bytes", node->buffered_bytes()}});
+        },
+        profiler::TraceMeLevel::kInfo);
     for (auto input : node->inputs()) {
       queue.push_back(input);
     }
@@ -1807,6 +1830,7 @@ void Model::OptimizeGradientDescent(
   for (auto& pair : parameters) {
     pair.second->value = std::round(pair.second->value);
   }
+  EnforceRamBudget(snapshot, optimization_params, &parameters);
   UpdateStateValues(&parameters);
 }
 
@@ -1875,9 +1899,65 @@ void Model::OptimizeHillClimb(std::shared_ptr<Node> snapshot,
     }
     best_parameter->value++;
   }
+  EnforceRamBudget(snapshot, optimization_params, &parameters);
   UpdateStateValues(&parameters);
 }
 
+void Model::EnforceRamBudget(std::shared_ptr<Node> snapshot,
+                             const OptimizationParams& optimization_params,
+                             ModelParameters* parameters) {
+  const double ram_budget = optimization_params.ram_budget();
+  double buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+  if (buffered_bytes <= ram_budget) {
+    return;
+  }
+  double output_time =
+      OutputTime(snapshot, optimization_params.model_input_time(),
+                 /*gradients=*/nullptr);
+  while (buffered_bytes > ram_budget) {
+    Parameter* best_parameter = nullptr;
+    double best_cost = 0;
+    double best_output_time = 0;
+    double best_buffered_bytes = 0;
+    for (auto& pair : *parameters) {
+      Parameter* parameter = pair.second.get();
+      if (parameter->value - 1 < parameter->min) {
+        continue;
+      }
+      parameter->value--;
+      const double new_buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+      const double freed_bytes = buffered_bytes - new_buffered_bytes;
+      if (freed_bytes > 0) {
+        const double new_output_time =
+            OutputTime(snapshot, optimization_params.model_input_time(),
+                       /*gradients=*/nullptr);
+        // Output time added per byte freed.
+        const double cost =
+            std::max(new_output_time - output_time, 0.0) / freed_bytes;
+        if (!best_parameter || cost < best_cost) {
+          best_parameter = parameter;
+          best_cost = cost;
+          best_output_time = new_output_time;
+          best_buffered_bytes = new_buffered_bytes;
+        }
+      }
+      parameter->value++;
+    }
+    if (!best_parameter) {
+      VLOG(2) << "Failed to bring the maximum buffered bytes "
+              << buffered_bytes << " within the RAM budget " << ram_budget
+              << " since no tunable parameter can be decreased further.";
+      return;
+    }
+    VLOG(3) << "Decreasing tunable parameter " << best_parameter->name
+            << " to " << best_parameter->value - 1
+            << " to stay within the RAM budget.";
+    best_parameter->value--;
+    output_time = best_output_time;
+    buffered_bytes = best_buffered_bytes;
+  }
+}
+
 double Model::OutputTime(std::shared_ptr<Node> node, double model_input_time,
                          Model::ParameterGradients* gradients) {
   // To store the input time for each node.
@@ -155,6 +155,7 @@ class Node {
         buffered_elements_(0),
         bytes_consumed_(0),
         bytes_produced_(0),
+        cpu_time_(0),
         num_elements_(0),
         processing_time_(0),
         record_metrics_(true),
@@ -223,6 +224,9 @@ class Node {
     return bytes_produced_;
   }
 
+  // Returns the aggregate thread CPU time spent in this node.
+  int64 cpu_time() const TF_LOCKS_EXCLUDED(mu_) { return cpu_time_; }
+
   // Indicates whether the node has tunable parameters.
   bool has_tunable_parameters() const TF_LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -255,6 +259,12 @@ class Node {
   // Returns the node output.
   Node* output() const { return output_; }
 
+  // Returns true if the node has a parameter with the given name.
+  bool has_parameter(const string& name) const TF_LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return parameters_.contains(name);
+  }
+
   // Returns the parameter value.
   double parameter_value(const string& name) const TF_LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -287,6 +297,7 @@ class Node {
   void record_start(int64 time_nanos) TF_LOCKS_EXCLUDED(mu_) {
     DCHECK_EQ(work_start_, 0);
     work_start_ = time_nanos;
+    cpu_work_start_ = EnvTime::ThreadCpuNanos();
   }
 
   // Records that a node thread has stopped executing.
@@ -294,6 +305,7 @@ class Node {
     // TODO(jsimsa): Use DCHECK_NE(work_start_, 0) here.
     if (work_start_ != 0) {
       processing_time_ += time_nanos - work_start_;
+      cpu_time_ += EnvTime::ThreadCpuNanos() - cpu_work_start_;
       work_start_ = 0;
     } else {
       VLOG(1) << "Encountered a stop event without a matching start event.";
@@ -393,9 +405,12 @@ class Node {
         : bytes_consumed_counter_(metrics::GetTFDataBytesConsumedCounter(name)),
           bytes_produced_counter_(metrics::GetTFDataBytesProducedCounter(name)),
           num_elements_counter_(metrics::GetTFDataElementsCounter(name)),
+          cpu_time_counter_(metrics::GetTFDataCpuTimeCounter(name)),
+          buffered_bytes_gauge_(metrics::GetTFDataBufferedBytesGauge(name)),
           recorded_bytes_consumed_(0),
           recorded_bytes_produced_(0),
-          recorded_num_elements_(0) {}
+          recorded_num_elements_(0),
+          recorded_cpu_time_micros_(0) {}
 
     // Expects the total number of bytes consumed and records the delta since
     // last invocation.
@@ -421,13 +436,30 @@ class Node {
       num_elements_counter_->IncrementBy(delta);
     }
 
+    // Expects the total thread CPU time in nanoseconds and records the delta
+    // since last invocation.
+    void record_cpu_time(int64 total_nanos) {
+      int64 total_micros = total_nanos / EnvTime::kMicrosToNanos;
+      int64 delta =
+          total_micros - recorded_cpu_time_micros_.exchange(total_micros);
+      cpu_time_counter_->IncrementBy(delta);
+    }
+
+    // Records the number of bytes currently buffered.
+    void record_buffered_bytes(int64 buffered_bytes) {
+      buffered_bytes_gauge_->Set(buffered_bytes);
+    }
+
    private:
     monitoring::CounterCell* const bytes_consumed_counter_;
     monitoring::CounterCell* const bytes_produced_counter_;
     monitoring::CounterCell* const num_elements_counter_;
+    monitoring::CounterCell* const cpu_time_counter_;
+    monitoring::GaugeCell<int64>* const buffered_bytes_gauge_;
     std::atomic<int64> recorded_bytes_consumed_;
     std::atomic<int64> recorded_bytes_produced_;
     std::atomic<int64> recorded_num_elements_;
+    std::atomic<int64> recorded_cpu_time_micros_;
   };
 
   // Returns the number of inputs.
@@ -553,6 +585,9 @@ class Node {
   // on thread `t`, then `n->record_stop()` must be called before another call
   // to `Node::record_start()` (for any node).
   static thread_local int64 work_start_;  // Will be initialized to zero.
+  // Stores the thread CPU time at the last call to `Node::record_start()` on
+  // the current thread. The same invariant as for `work_start_` applies.
+  static thread_local int64 cpu_work_start_;
 
   mutable mutex mu_;
   const int64 id_;
@@ -566,6 +601,7 @@ class Node {
   std::atomic<int64> buffered_elements_;
   std::atomic<int64> bytes_consumed_;
   std::atomic<int64> bytes_produced_;
+  std::atomic<int64> cpu_time_;
   std::atomic<int64> num_elements_;
   std::atomic<int64> processing_time_;
   std::atomic<bool> record_metrics_;
@@ -660,6 +696,10 @@ class Model {
   // Indicates whether to collect resource usage.
   bool collect_resource_usage() const { return collect_resource_usage_; }
 
+  // Collects resource usage even if no node has tunable parameters, e.g., to
+  // benchmark an input pipeline.
+  void EnableResourceUsageCollection() { collect_resource_usage_ = true; }
+
   // Returns a pointer to the model's output node.
   const std::shared_ptr<Node> output() {
     mutex_lock l(mu_);
@@ -748,6 +788,15 @@ class Model {
                                const OptimizationParams& optimization_params,
                                CancellationManager* cancellation_manager);
 
+  // Decrements tunable parameters until the model's maximum buffered bytes fit
+  // into the RAM budget, or no parameter can be decremented.  Each step takes
+  // the parameter whose decrement costs the least output time per byte freed,
+  // so that the buffers that help the least are shrunk first.  Expects rounded
+  // parameter values.
+  void EnforceRamBudget(std::shared_ptr<Node> snapshot,
+                        const OptimizationParams& optimization_params,
+                        ModelParameters* parameters);
+
   // Determines if we should stop the gradient descent optimization iterations
   // based on number of increasable parameters, CPU budget, RAM budget and
   // current resource usage.
@@ -1170,6 +1170,56 @@ TEST_P(OptimizeZeroRamBudgetTest, Model) {
 INSTANTIATE_TEST_SUITE_P(Test, OptimizeZeroRamBudgetTest,
                          ::testing::Values(0, 1));
 
+TEST(OptimizeRamBudgetTest, HillClimb) {
+  const model::AutotuneAlgorithm algorithm =
+      model::AutotuneAlgorithm::HILL_CLIMB;
+
+  std::shared_ptr<mutex> mutex1 = std::make_shared<mutex>();
+  std::shared_ptr<condition_variable> cv1 =
+      std::make_shared<condition_variable>();
+  std::shared_ptr<Node> node1 = model::MakeAsyncKnownRatioNode(
+      {1, "1", nullptr}, 1,
+      {model::MakeParameter("parallelism",
+                            std::make_shared<SharedState>(
+                                /*value=*/model::kAutotune, mutex1, cv1),
+                            /*min=*/1, /*max=*/8)});
+  node1->record_buffer_event(100, 1);
+  node1->add_processing_time(1000);
+  node1->record_element();
+
+  std::shared_ptr<mutex> mutex2 = std::make_shared<mutex>();
+  std::shared_ptr<condition_variable> cv2 =
+      std::make_shared<condition_variable>();
+  std::shared_ptr<Node> node2 = model::MakeAsyncKnownRatioNode(
+      {2, "2", node1}, 1,
+      {model::MakeParameter("buffer_size",
+                            std::make_shared<SharedState>(
+                                /*value=*/model::kAutotune, mutex2, cv2),
+                            /*min=*/0, /*max=*/8)});
+  node2->record_buffer_event(100, 1);
+  node2->add_processing_time(1000);
+  node2->record_element();
+
+  model::Model model;
+  model.AddNode([&node1](model::Node::Args args) { return node1; }, "1",
+                nullptr, &node1);
+  model.AddNode([&node2](model::Node::Args args) { return node2; }, "2", node1,
+                &node2);
+
+  // The unconstrained optimum buffers more than the budget.
+  constexpr int64 kRamBudget = 250;
+  CancellationManager cancellation_manager;
+  model.Optimize(algorithm, /*cpu_budget=*/40, /*ram_budget=*/1 << 20,
+                 /*model_input_time=*/0, &cancellation_manager);
+  ASSERT_GT(node1->TotalMaximumBufferedBytes(), kRamBudget);
+
+  model.Optimize(algorithm, /*cpu_budget=*/40, kRamBudget,
+                 /*model_input_time=*/0, &cancellation_manager);
+  // The budget is a hard limit, but is still used up.
+  EXPECT_LE(node1->TotalMaximumBufferedBytes(), kRamBudget);
+  EXPECT_GT(node1->parameter_value("parallelism"), 1);
+}
+
 TEST(RecordTimeTest, RecordTimeTest) {
   std::shared_ptr<Node> source = model::MakeSourceNode({});
   EXPECT_FALSE(source->is_recording());
@@ -1179,6 +1229,34 @@ TEST(RecordTimeTest, RecordTimeTest) {
   EXPECT_FALSE(source->is_recording());
 }
 
+TEST(RecordTimeTest, RecordCpuTime) {
+  if (EnvTime::ThreadCpuNanos() == 0) {
+    GTEST_SKIP() << "Thread CPU time is not supported on this platform.";
+  }
+  std::shared_ptr<Node> source = model::MakeSourceNode({});
+  EXPECT_EQ(source->cpu_time(), 0);
+  source->record_start(EnvTime::NowNanos());
+  const uint64 start_cpu_nanos = EnvTime::ThreadCpuNanos();
+  volatile int64 sum = 0;
+  while (EnvTime::ThreadCpuNanos() - start_cpu_nanos < 1000 * 1000) {
+    sum = sum + 1;
+  }
+  source->record_stop(EnvTime::NowNanos());
+  EXPECT_GE(source->cpu_time(), 1000 * 1000);
+  EXPECT_LE(source->cpu_time(), source->processing_time());
+
+  // Time spent outside of `record_start` and `record_stop` is not recorded.
+  const int64 cpu_time = source->cpu_time();
+  while (EnvTime::ThreadCpuNanos() - start_cpu_nanos < 2000 * 1000) {
+    sum = sum + 1;
+  }
+  EXPECT_EQ(source->cpu_time(), cpu_time);
+
+  ModelProto::Node node_proto;
+  TF_ASSERT_OK(source->ToProto(&node_proto));
+  EXPECT_EQ(node_proto.cpu_time(), cpu_time);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/node_properties.h"
 #include "tensorflow/core/framework/op_def_util.h"
+#include "tensorflow/core/framework/tensor_buffer_pool.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -712,11 +713,17 @@ Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
   Allocator* a = get_allocator(attr);
-  Tensor new_tensor(
-      a, type, shape,
-      AllocationAttributes(
-          /*retry_on_failure=*/allocation_attr.retry_on_failure,
-          /*allocation_will_be_logged=*/true, allocation_attr.freed_by_func));
+  AllocationAttributes new_allocation_attr(
+      /*retry_on_failure=*/allocation_attr.retry_on_failure,
+      /*allocation_will_be_logged=*/true, allocation_attr.freed_by_func);
+  Tensor new_tensor;
+  // The pool only recycles buffers of the device's own allocator, so tracked
+  // allocations (which go through a TrackingAllocator) bypass it.
+  TensorBufferPool* pool = params_->device->GetTensorBufferPool();
+  if (pool == nullptr || pool->allocator() != a || params_->log_memory ||
+      !pool->AllocateTensor(type, shape, new_allocation_attr, &new_tensor)) {
+    new_tensor = Tensor(a, type, shape, new_allocation_attr);
+  }
 
   if (!new_tensor.IsInitialized()) {
     return errors::ResourceExhausted(
@@ -1122,9 +1129,9 @@ const string& OpKernelContext::executor_type() const {
 // OpKernel registration ------------------------------------------------------
 
 struct KernelRegistration {
-  KernelRegistration(const KernelDef& d, StringPiece c,
+  KernelRegistration(KernelDef&& d, StringPiece c,
                      std::unique_ptr<kernel_factory::OpKernelFactory> f)
-      : def(d), kernel_class_name(c), factory(std::move(f)) {}
+      : def(std::move(d)), kernel_class_name(c), factory(std::move(f)) {}
 
   const KernelDef def;
   const string kernel_class_name;
@@ -1258,12 +1265,11 @@ static string Key(StringPiece op_type, const DeviceType& device_type,
 
 namespace kernel_factory {
 
-void OpKernelRegistrar::InitInternal(const KernelDef* kernel_def,
+void OpKernelRegistrar::InitInternal(std::unique_ptr<KernelDef> kernel_def,
                                      StringPiece kernel_class_name,
                                      std::unique_ptr<OpKernelFactory> factory) {
-  const string key =
-      Key(kernel_def->op(), DeviceType(kernel_def->device_type()),
-          kernel_def->label());
+  string key = Key(kernel_def->op(), DeviceType(kernel_def->device_type()),
+                   kernel_def->label());
 
   // To avoid calling LoadDynamicKernels DO NOT CALL GlobalKernelRegistryTyped
   // here.
@@ -1274,11 +1280,14 @@ void OpKernelRegistrar::InitInternal(const KernelDef* kernel_def,
   // registration mechanism, we have this workaround here.
   auto global_registry =
       reinterpret_cast<KernelRegistry*>(GlobalKernelRegistry());
+  // This runs once per kernel at startup. The registrar owns `kernel_def`, so
+  // move it and the key straight into the registry entry rather than copying
+  // them (the entry's `def` is const, so a temporary entry would be copied).
   mutex_lock l(global_registry->mu);
   global_registry->registry.emplace(
-      key,
-      KernelRegistration(*kernel_def, kernel_class_name, std::move(factory)));
-  delete kernel_def;
+      std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+      std::forward_as_tuple(std::move(*kernel_def), kernel_class_name,
+                            std::move(factory)));
 }
 
 OpKernel* OpKernelRegistrar::PtrOpKernelFactory::Create(
@@ -17,10 +17,12 @@ limitations under the License.
 #define TENSORFLOW_CORE_FRAMEWORK_OP_KERNEL_H_
 
 #include <functional>
+#include <memory>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/control_flow.h"
@@ -1461,7 +1463,7 @@ class Name : public KernelDefBuilder {
           TF_INIT_ON_STARTUP_IF(is_system_kernel ||                         \
                                 (SHOULD_REGISTER_OP_KERNEL(#__VA_ARGS__) && \
                                  SHOULD_REGISTER_OP(op_name)))              \
-          << ([](::tensorflow::KernelDef const* kernel_def) {               \
+          << ([](::tensorflow::KernelDef* kernel_def) {                     \
                ::tensorflow::kernel_factory::OpKernelRegistrar registrar(   \
                    kernel_def, #__VA_ARGS__,                                \
                    [](::tensorflow::OpKernelConstruction* context)          \
@@ -1545,17 +1547,18 @@ class OpKernelRegistrar {
  public:
   // Registers the given kernel factory with TensorFlow. TF will call the
   // factory Create() method when it determines that a kernel matching the given
-  // KernelDef is required.
-  OpKernelRegistrar(const KernelDef* kernel_def, StringPiece kernel_class_name,
+  // KernelDef is required. Takes ownership of `kernel_def`.
+  OpKernelRegistrar(KernelDef* kernel_def, StringPiece kernel_class_name,
                     std::unique_ptr<OpKernelFactory> factory) {
-    InitInternal(kernel_def, kernel_class_name, std::move(factory));
+    InitInternal(absl::WrapUnique(kernel_def), kernel_class_name,
+                 std::move(factory));
   }
 
   // Registers the given factory function with TensorFlow. This is equivalent
   // to registering a factory whose Create function invokes `create_fn`.
-  OpKernelRegistrar(const KernelDef* kernel_def, StringPiece kernel_class_name,
+  OpKernelRegistrar(KernelDef* kernel_def, StringPiece kernel_class_name,
                     OpKernel* (*create_fn)(OpKernelConstruction*)) {
-    InitInternal(kernel_def, kernel_class_name,
+    InitInternal(absl::WrapUnique(kernel_def), kernel_class_name,
                  absl::make_unique<PtrOpKernelFactory>(create_fn));
   }
 
@@ -1569,7 +1572,8 @@ class OpKernelRegistrar {
     OpKernel* (*create_func_)(OpKernelConstruction*);
   };
 
-  void InitInternal(const KernelDef* kernel_def, StringPiece kernel_class_name,
+  void InitInternal(std::unique_ptr<KernelDef> kernel_def,
+                    StringPiece kernel_class_name,
                     std::unique_ptr<OpKernelFactory> factory);
 };
 
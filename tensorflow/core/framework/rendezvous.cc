@@ -148,6 +148,20 @@ Status RendezvousInterface::Recv(const ParsedKey& key, const Args& args,
   return Recv(key, args, val, is_dead, no_timeout);
 }
 
+Status RendezvousInterface::SendBatch(gtl::ArraySlice<SendItem> items) {
+  for (const SendItem& item : items) {
+    TF_RETURN_IF_ERROR(Send(item.key, item.args, item.val, item.is_dead));
+  }
+  return Status::OK();
+}
+
+void RendezvousInterface::RecvBatchAsync(
+    gtl::MutableArraySlice<RecvItem> items) {
+  for (RecvItem& item : items) {
+    RecvAsync(item.key, item.args, std::move(item.done));
+  }
+}
+
 namespace {
 class LocalRendezvousWrapper : public Rendezvous {
  public:
@@ -163,6 +177,14 @@ class LocalRendezvousWrapper : public Rendezvous {
     impl_.RecvAsync(key, recv_args, std::move(done));
   }
 
+  Status SendBatch(gtl::ArraySlice<SendItem> items) override {
+    return impl_.SendBatch(items);
+  }
+
+  void RecvBatchAsync(gtl::MutableArraySlice<RecvItem> items) override {
+    impl_.RecvBatchAsync(items);
+  }
+
   void StartAbort(const Status& status) override { impl_.StartAbort(status); }
 
  private:
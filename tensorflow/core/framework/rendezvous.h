@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
@@ -104,6 +105,30 @@ class RendezvousInterface {
   virtual void RecvAsync(const ParsedKey& key, const Args& args,
                          DoneCallback done) = 0;
 
+  // A message passed to SendBatch().
+  struct SendItem {
+    ParsedKey key;
+    Args args;
+    Tensor val;
+    bool is_dead = false;
+  };
+
+  // A request passed to RecvBatchAsync().
+  struct RecvItem {
+    ParsedKey key;
+    Args args;
+    DoneCallback done;
+  };
+
+  // Equivalent to calling Send() for each item in order, stopping at the
+  // first error.  Implementations may override this to amortize per-message
+  // overheads such as locking across the batch.
+  virtual Status SendBatch(gtl::ArraySlice<SendItem> items);
+
+  // Equivalent to calling RecvAsync() for each item.  The `done` callbacks of
+  // `items` are moved from.
+  virtual void RecvBatchAsync(gtl::MutableArraySlice<RecvItem> items);
+
   // Synchronous wrapper for RecvAsync.
   Status Recv(const ParsedKey& key, const Args& args, Tensor* val,
               bool* is_dead, int64 timeout_ms);
@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/framework/rendezvous.h"
 
+#include "absl/strings/match.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -394,6 +396,136 @@ TEST_F(LocalRendezvousTest, AbortThenRecvOrSend) {
       errors::IsAborted(rendez_->Recv(KeyFoo(), args, &val, &val_dead)));
 }
 
+// Enough keys to cover every shard of the table.
+std::vector<Rendezvous::ParsedKey> MakeKeys(int n) {
+  std::vector<Rendezvous::ParsedKey> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("key", i)));
+  }
+  return keys;
+}
+
+std::vector<Rendezvous::RecvItem> MakeRecvItems(
+    const std::vector<Rendezvous::ParsedKey>& keys, std::vector<string>* vals,
+    BlockingCounter* counter) {
+  std::vector<Rendezvous::RecvItem> items(keys.size());
+  for (int i = 0; i < keys.size(); ++i) {
+    items[i].key = keys[i];
+    items[i].done = [vals, i, counter](const Status& s, const Rendezvous::Args&,
+                                       const Rendezvous::Args&,
+                                       const Tensor& v, const bool) {
+      (*vals)[i] = s.ok() ? V(v) : s.error_message();
+      counter->DecrementCount();
+    };
+  }
+  return items;
+}
+
+TEST_F(LocalRendezvousTest, SendBatchThenRecvBatch) {
+  static const int N = 64;
+  const auto keys = MakeKeys(N);
+  std::vector<Rendezvous::SendItem> sends(N);
+  for (int i = 0; i < N; ++i) {
+    sends[i].key = keys[i];
+    sends[i].val = V(strings::StrCat("v", i));
+  }
+  TF_ASSERT_OK(rendez_->SendBatch(sends));
+
+  std::vector<string> vals(N);
+  BlockingCounter counter(N);
+  auto recvs = MakeRecvItems(keys, &vals, &counter);
+  rendez_->RecvBatchAsync(absl::MakeSpan(recvs));
+  counter.Wait();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_EQ(strings::StrCat("v", i), vals[i]);
+  }
+}
+
+TEST_F(LocalRendezvousTest, RecvBatchThenSendBatch) {
+  static const int N = 64;
+  const auto keys = MakeKeys(N);
+  std::vector<string> vals(N);
+  BlockingCounter counter(N);
+  auto recvs = MakeRecvItems(keys, &vals, &counter);
+  rendez_->RecvBatchAsync(absl::MakeSpan(recvs));
+
+  // Mix batched and individual sends.
+  std::vector<Rendezvous::SendItem> sends(N / 2);
+  for (int i = 0; i < N / 2; ++i) {
+    sends[i].key = keys[i];
+    sends[i].val = V(strings::StrCat("v", i));
+  }
+  TF_ASSERT_OK(rendez_->SendBatch(sends));
+  for (int i = N / 2; i < N; ++i) {
+    TF_ASSERT_OK(rendez_->Send(keys[i], Rendezvous::Args(),
+                               V(strings::StrCat("v", i)), false));
+  }
+  counter.Wait();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_EQ(strings::StrCat("v", i), vals[i]);
+  }
+}
+
+TEST_F(LocalRendezvousTest, SendBatchPreservesOrderPerKey) {
+  std::vector<Rendezvous::SendItem> sends(3);
+  sends[0].key = KeyFoo();
+  sends[0].val = V("first");
+  sends[1].key = KeyBar();
+  sends[1].val = V("bar");
+  sends[2].key = KeyFoo();
+  sends[2].val = V("second");
+  TF_ASSERT_OK(rendez_->SendBatch(sends));
+
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), args, &val, &is_dead));
+  EXPECT_EQ("first", V(val));
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), args, &val, &is_dead));
+  EXPECT_EQ("second", V(val));
+  TF_ASSERT_OK(rendez_->Recv(KeyBar(), args, &val, &is_dead));
+  EXPECT_EQ("bar", V(val));
+}
+
+TEST_F(LocalRendezvousTest, AbortPendingRecvBatch) {
+  static const int N = 16;
+  const auto keys = MakeKeys(N);
+  std::vector<string> vals(N);
+  BlockingCounter counter(N);
+  auto recvs = MakeRecvItems(keys, &vals, &counter);
+  rendez_->RecvBatchAsync(absl::MakeSpan(recvs));
+  rendez_->StartAbort(errors::Aborted("aborted"));
+  counter.Wait();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_EQ("aborted", vals[i]);
+  }
+
+  std::vector<Rendezvous::SendItem> sends(1);
+  sends[0].key = KeyFoo();
+  EXPECT_TRUE(errors::IsAborted(rendez_->SendBatch(sends)));
+  BlockingCounter after_abort(N);
+  auto more_recvs = MakeRecvItems(keys, &vals, &after_abort);
+  rendez_->RecvBatchAsync(absl::MakeSpan(more_recvs));
+  after_abort.Wait();
+  EXPECT_EQ("aborted", vals[0]);
+}
+
+TEST_F(LocalRendezvousTest, CancelRecvBatch) {
+  CancellationManager cm;
+  static const int N = 16;
+  const auto keys = MakeKeys(N);
+  std::vector<string> vals(N);
+  BlockingCounter counter(N);
+  auto recvs = MakeRecvItems(keys, &vals, &counter);
+  for (auto& recv : recvs) recv.args.cancellation_manager = &cm;
+  rendez_->RecvBatchAsync(absl::MakeSpan(recvs));
+  cm.StartCancel();
+  counter.Wait();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_TRUE(absl::StrContains(vals[i], "RecvAsync is cancelled."));
+  }
+}
+
 class DummyDeviceContext : public DeviceContext {
  public:
   explicit DummyDeviceContext(int stream_id) : stream_id_(stream_id) {}
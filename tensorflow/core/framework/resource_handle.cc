@@ -19,6 +19,45 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace internal {
+
+ResourceLookupCache& ResourceLookupCache::operator=(
+    const ResourceLookupCache& other) {
+  if (this != &other) Clear();
+  return *this;
+}
+
+ResourceLookupCache::~ResourceLookupCache() {
+  if (resource_ != nullptr) resource_->Unref();
+}
+
+core::RefCounted* ResourceLookupCache::Get(const void* owner,
+                                           uint64 generation) {
+  mutex_lock l(mu_);
+  if (resource_ == nullptr || owner_ != owner || generation_ != generation) {
+    return nullptr;
+  }
+  resource_->Ref();
+  return resource_;
+}
+
+void ResourceLookupCache::Set(const void* owner, uint64 generation,
+                              core::RefCounted* resource) {
+  if (resource != nullptr) resource->Ref();
+  core::RefCounted* old_resource;
+  {
+    mutex_lock l(mu_);
+    owner_ = owner;
+    generation_ = generation;
+    old_resource = resource_;
+    resource_ = resource;
+  }
+  // The old resource may be destroyed here, so release it outside the lock.
+  if (old_resource != nullptr) old_resource->Unref();
+}
+
+}  // namespace internal
+
 ResourceHandle::ResourceHandle() {}
 
 ResourceHandle::ResourceHandle(const ResourceHandleProto& proto) {
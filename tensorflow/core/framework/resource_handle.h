@@ -18,6 +18,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/managed_stack_trace.h"
@@ -26,6 +28,38 @@ namespace tensorflow {
 
 class ResourceHandleProto;
 
+namespace internal {
+
+// Remembers the resource that a ResourceHandle last resolved to, so that
+// repeated lookups of the same handle object skip the ResourceMgr map. An
+// entry is only returned for the same owner (resource manager) and generation
+// it was stored with; the owner changes its generation whenever resources
+// are removed. Copies of a handle start with an empty cache.
+class ResourceLookupCache {
+ public:
+  ResourceLookupCache() {}
+  ResourceLookupCache(const ResourceLookupCache& other) {}
+  ResourceLookupCache& operator=(const ResourceLookupCache& other);
+  ~ResourceLookupCache();
+
+  // Returns the cached resource with a new reference, or nullptr if nothing
+  // is cached for `owner` at `generation`.
+  core::RefCounted* Get(const void* owner, uint64 generation);
+
+  // Caches `resource`, taking a new reference on it.
+  void Set(const void* owner, uint64 generation, core::RefCounted* resource);
+
+  void Clear() { Set(nullptr, 0, nullptr); }
+
+ private:
+  mutex mu_;
+  const void* owner_ TF_GUARDED_BY(mu_) = nullptr;
+  uint64 generation_ TF_GUARDED_BY(mu_) = 0;
+  core::RefCounted* resource_ TF_GUARDED_BY(mu_) = nullptr;
+};
+
+}  // namespace internal
+
 // Class representing a handle to a tensorflow resource. Handles are
 // not valid across executions, but can be serialized back and forth from within
 // a single run.
@@ -41,20 +75,32 @@ class ResourceHandle {
   // Unique name for the device containing the resource.
   const std::string& device() const { return device_; }
 
-  void set_device(const std::string& device) { device_ = device; }
+  void set_device(const std::string& device) {
+    device_ = device;
+    lookup_cache_.Clear();
+  }
 
   // Container in which this resource is placed.
   const std::string& container() const { return container_; }
-  void set_container(const std::string& container) { container_ = container; }
+  void set_container(const std::string& container) {
+    container_ = container;
+    lookup_cache_.Clear();
+  }
 
   // Unique name of this resource.
   const std::string& name() const { return name_; }
-  void set_name(const std::string& name) { name_ = name; }
+  void set_name(const std::string& name) {
+    name_ = name;
+    lookup_cache_.Clear();
+  }
 
   // Hash code for the type of the resource. Is only valid in the same device
   // and in the same execution.
   uint64 hash_code() const { return hash_code_; }
-  void set_hash_code(uint64 hash_code) { hash_code_ = hash_code; }
+  void set_hash_code(uint64 hash_code) {
+    hash_code_ = hash_code;
+    lookup_cache_.Clear();
+  }
 
   // For debug-only, the name of the type pointed to by this handle, if
   // available.
@@ -104,6 +150,9 @@ class ResourceHandle {
   std::string maybe_type_name_;
   std::vector<DtypeAndPartialTensorShape> dtypes_and_shapes_;
   absl::optional<ManagedStackTrace> definition_stack_trace_;
+
+  // Used by ResourceMgr::Lookup(const ResourceHandle&, ...).
+  mutable internal::ResourceLookupCache lookup_cache_;
 };
 
 // For backwards compatibility for when this was a proto
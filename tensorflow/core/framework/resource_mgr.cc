@@ -118,10 +118,18 @@ ResourceMgr::ResourceAndName& ResourceMgr::ResourceAndName::operator=(
   return *this;
 }
 
-ResourceMgr::ResourceMgr() : default_container_("localhost") {}
+// Generations are unique across all managers, so that a lookup cached for a
+// destroyed manager never matches a new one allocated at the same address.
+static uint64 NewGeneration() {
+  static std::atomic<uint64> next_generation{1};
+  return next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+ResourceMgr::ResourceMgr()
+    : default_container_("localhost"), generation_(NewGeneration()) {}
 
 ResourceMgr::ResourceMgr(const string& default_container)
-    : default_container_(default_container) {}
+    : default_container_(default_container), generation_(NewGeneration()) {}
 
 ResourceMgr::~ResourceMgr() { Clear(); }
 
@@ -132,6 +140,7 @@ void ResourceMgr::Clear() {
   {
     mutex_lock l(mu_);
     tmp_containers = std::move(containers_);
+    generation_.store(NewGeneration(), std::memory_order_release);
   }
   for (const auto& p : tmp_containers) {
     delete p.second;
@@ -193,9 +202,28 @@ Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
 
 Status ResourceMgr::Lookup(const ResourceHandle& handle,
                            ResourceBase** resource) const {
-  tf_shared_lock l(mu_);
-  return DoLookup(handle.container(), handle.hash_code(),
-                  /*type_name=*/"ResourceBase", handle.name(), resource);
+  return DoLookup(handle, /*type_name=*/"ResourceBase", resource);
+}
+
+Status ResourceMgr::DoLookup(const ResourceHandle& handle,
+                             const string& type_name,
+                             ResourceBase** resource) const {
+  // Read the generation before the map: if a resource is removed while the
+  // lookup below runs, the result is cached under a stale generation and is
+  // never returned from the cache.
+  const uint64 generation = generation_.load(std::memory_order_acquire);
+  core::RefCounted* cached = handle.lookup_cache_.Get(this, generation);
+  if (cached != nullptr) {
+    *resource = static_cast<ResourceBase*>(cached);
+    return Status::OK();
+  }
+  {
+    tf_shared_lock l(mu_);
+    TF_RETURN_IF_ERROR(DoLookup(handle.container(), handle.hash_code(),
+                                type_name, handle.name(), resource));
+  }
+  handle.lookup_cache_.Set(this, generation, *resource);
+  return Status::OK();
 }
 
 Status ResourceMgr::DoLookup(const string& container, TypeIndex type,
@@ -241,6 +269,7 @@ Status ResourceMgr::DoDelete(const string& container, uint64 type_hash_code,
     }
     std::swap(resource_and_name, iter->second);
     b->erase(iter);
+    generation_.store(NewGeneration(), std::memory_order_release);
   }
   DCHECK(resource_and_name.resource != nullptr);
   return Status::OK();
@@ -274,6 +303,7 @@ Status ResourceMgr::Cleanup(const string& container) {
     }
     b = iter->second;
     containers_.erase(iter);
+    generation_.store(NewGeneration(), std::memory_order_release);
   }
   CHECK(b != nullptr);
   delete b;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_MGR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_MGR_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <typeindex>
@@ -197,9 +198,16 @@ class ResourceMgr {
   // If the resource manager has a resource matching "handle", returns it in
   // "*resource" and the caller takes the ownership of one ref on "*resource".
   //
+  // The result is cached in "handle", so that looking up the same handle
+  // object again takes no lock on the manager until a resource is deleted
+  // from it.
+  //
   // REQUIRES: resource != nullptr
   Status Lookup(const ResourceHandle& handle,
                 ResourceBase** resource) const TF_MUST_USE_RESULT;
+  template <typename T, bool use_dynamic_cast = false>
+  Status Lookup(const ResourceHandle& handle,
+                T** resource) const TF_MUST_USE_RESULT;
 
   // Similar to Lookup, but looks up multiple resources at once, with only a
   // single lock acquisition.  If containers_and_names[i] is uninitialized
@@ -275,6 +283,9 @@ class ResourceMgr {
   const std::string default_container_;
   mutable mutex mu_;
   std::unordered_map<string, Container*> containers_ TF_GUARDED_BY(mu_);
+  // Replaced, while holding `mu_` exclusively, whenever resources are
+  // removed. Invalidates the lookups cached in resource handles.
+  std::atomic<uint64> generation_;
 
   template <typename T, bool use_dynamic_cast = false>
   Status LookupInternal(const std::string& container, const std::string& name,
@@ -291,6 +302,9 @@ class ResourceMgr {
   Status DoLookup(const std::string& container, TypeIndex type,
                   const std::string& name, ResourceBase** resource) const
       TF_SHARED_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
+  Status DoLookup(const ResourceHandle& handle, const std::string& type_name,
+                  ResourceBase** resource) const
+      TF_LOCKS_EXCLUDED(mu_) TF_MUST_USE_RESULT;
   Status DoLookup(const std::string& container, uint64 type_hash_code,
                   const std::string& type_name,
                   const std::string& resource_name,
@@ -638,6 +652,27 @@ Status ResourceMgr::Lookup(const std::string& container,
   return LookupInternal<T, use_dynamic_cast>(container, name, resource);
 }
 
+// Simple wrapper to allow conditional dynamic / static casts.
+template <typename T, bool use_dynamic_cast>
+struct TypeCastFunctor {
+  static T* Cast(ResourceBase* r) { return static_cast<T*>(r); }
+};
+
+template <typename T>
+struct TypeCastFunctor<T, true> {
+  static T* Cast(ResourceBase* r) { return dynamic_cast<T*>(r); }
+};
+
+template <typename T, bool use_dynamic_cast>
+Status ResourceMgr::Lookup(const ResourceHandle& handle, T** resource) const {
+  CheckDeriveFromResourceBase<T>();
+  ResourceBase* found = nullptr;
+  TF_RETURN_IF_ERROR(
+      DoLookup(handle, TypeIndex::Make<T>().name(), &found));
+  *resource = TypeCastFunctor<T, use_dynamic_cast>::Cast(found);
+  return Status::OK();
+}
+
 template <typename T, bool use_dynamic_cast>
 Status ResourceMgr::LookupMany(
     absl::Span<std::pair<const string*, const string*> const>
@@ -658,17 +693,6 @@ Status ResourceMgr::LookupMany(
   return Status::OK();
 }
 
-// Simple wrapper to allow conditional dynamic / static casts.
-template <typename T, bool use_dynamic_cast>
-struct TypeCastFunctor {
-  static T* Cast(ResourceBase* r) { return static_cast<T*>(r); }
-};
-
-template <typename T>
-struct TypeCastFunctor<T, true> {
-  static T* Cast(ResourceBase* r) { return dynamic_cast<T*>(r); }
-};
-
 template <typename T, bool use_dynamic_cast>
 Status ResourceMgr::LookupInternal(const std::string& container,
                                    const std::string& name,
@@ -776,8 +800,7 @@ template <typename T, bool use_dynamic_cast>
 Status LookupResource(OpKernelContext* ctx, const ResourceHandle& p,
                       T** value) {
   TF_RETURN_IF_ERROR(internal::ValidateDeviceAndType<T>(ctx, p));
-  return ctx->resource_manager()->Lookup<T, use_dynamic_cast>(p.container(),
-                                                              p.name(), value);
+  return ctx->resource_manager()->Lookup<T, use_dynamic_cast>(p, value);
 }
 
 // If the resource manager in "ctx" has a resource matching "p", returns it in
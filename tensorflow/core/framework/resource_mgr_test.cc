@@ -316,6 +316,42 @@ TEST(ResourceHandleTest, LookupDeleteGenericResource) {
   }
 }
 
+TEST(ResourceHandleTest, CachedLookupSeesRecreatedResource) {
+  ResourceMgr resource_mgr("");
+  OpKernelContext::Params params;
+  params.resource_manager = &resource_mgr;
+  StubDevice device("device_name");
+  params.device = &device;
+  OpKernelContext ctx(&params, 0);
+
+  ResourceHandle p =
+      MakeResourceHandle<StubResource>(&ctx, "container", "name");
+
+  auto* r = new StubResource();
+  r->value_ = 42;
+  TF_ASSERT_OK(CreateResource(&ctx, p, r));
+  for (int i = 0; i < 2; ++i) {
+    core::RefCountPtr<StubResource> found;
+    TF_ASSERT_OK(LookupResource(&ctx, p, &found));
+    EXPECT_EQ(found->value_, 42);
+  }
+
+  // Deleting the resource invalidates the lookup cached in `p`.
+  TF_ASSERT_OK(DeleteResource<StubResource>(&ctx, p));
+  r = new StubResource();
+  r->value_ = 7;
+  TF_ASSERT_OK(CreateResource(&ctx, p, r));
+  {
+    core::RefCountPtr<StubResource> found;
+    TF_ASSERT_OK(LookupResource(&ctx, p, &found));
+    EXPECT_EQ(found->value_, 7);
+  }
+
+  TF_ASSERT_OK(resource_mgr.Cleanup("container"));
+  core::RefCountPtr<StubResource> unused;
+  EXPECT_FALSE(LookupResource(&ctx, p, &unused).ok());
+}
+
 TEST(ResourceHandleTest, DifferentDevice) {
   ResourceMgr resource_mgr("");
   OpKernelContext::Params params;
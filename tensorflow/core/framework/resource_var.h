@@ -51,6 +51,14 @@ namespace tensorflow {
 // shared mutex prevents them from overlapping with dense writes, which is
 // necessary as dense writes can change the shape the of the tensor.
 //
+// To avoid copying the whole variable on every dense read in copy-on-read mode,
+// the copy made by a read is cached as a read snapshot and handed out to later
+// reads until the variable is modified. Every call to `tensor()` counts as a
+// potential modification and invalidates the snapshot, so readers should use
+// `value()` instead. Writers that update the tensor while holding only a
+// shared lock must additionally call `InvalidateReadSnapshot()` once they are
+// done, since a concurrent read may have cached a snapshot of a partial update.
+//
 // Transitioning a variable from copy-on-read mode to copy-on-write mode is
 // currently not supported. To upgrade a variable from copy-on-write to
 // copy-on-read use `EnsureSparseVariableAccess()`, and then grab the variable's
@@ -65,7 +73,33 @@ class Var : public ResourceBase {
   // increasing mu() address.
   // TODO(ebrevdo): Use LockSet instead of exposing mu.
   mutex* mu() { return &mu_; }
-  Tensor* tensor() { return &tensor_; }
+  Tensor* tensor() {
+    InvalidateReadSnapshot();
+    return &tensor_;
+  }
+  const Tensor& value() const { return tensor_; }
+
+  // Read snapshots for copy-on-read mode; see the class comment.
+  void InvalidateReadSnapshot() { version_.fetch_add(1); }
+  uint64 version() const { return version_.load(); }
+  // Returns true and sets `*snapshot` if a snapshot of the current version of
+  // the variable is cached.
+  bool LookupReadSnapshot(Tensor* snapshot) {
+    mutex_lock l(snapshot_mu_);
+    if (!snapshot_.IsInitialized() || snapshot_version_ != version_.load()) {
+      return false;
+    }
+    *snapshot = snapshot_;
+    return true;
+  }
+  // Caches `snapshot`, a copy of the variable made after observing
+  // `version()` == `version`, unless the variable was modified since.
+  void CacheReadSnapshot(const Tensor& snapshot, uint64 version) {
+    mutex_lock l(snapshot_mu_);
+    if (version != version_.load()) return;
+    snapshot_ = snapshot;
+    snapshot_version_ = version;
+  }
 
   std::string DebugString() const override {
     return strings::StrCat(DataTypeString(tensor_.dtype()), "/",
@@ -91,6 +125,11 @@ class Var : public ResourceBase {
   mutex mu_;
   Tensor tensor_;
 
+  std::atomic<uint64> version_{0};
+  mutex snapshot_mu_;
+  Tensor snapshot_ TF_GUARDED_BY(snapshot_mu_);
+  uint64 snapshot_version_ TF_GUARDED_BY(snapshot_mu_) = 0;
+
   ~Var() override {}
   TF_DISALLOW_COPY_AND_ASSIGN(Var);
 };
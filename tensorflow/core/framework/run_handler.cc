@@ -23,6 +23,7 @@ limitations under the License.
 #include <memory>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -77,6 +78,7 @@ RunHandlerEnvironment::Task RunHandlerEnvironment::CreateTask(
           std::move(f),
           Context(ContextKind::kThread),
           id,
+          /*enqueue_time_us=*/0,
       }),
   };
 }
@@ -130,6 +132,8 @@ ThreadWorkSource::ThreadWorkSource()
       non_blocking_work_queues_(non_blocking_work_sharding_factor_),
       blocking_inflight_(0),
       non_blocking_inflight_(0),
+      total_queueing_delay_us_(0),
+      num_queueing_delays_(0),
       traceme_id_(0),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
@@ -298,6 +302,17 @@ void ThreadWorkSource::DecrementInflightTaskCount(bool is_blocking) {
   counter->fetch_sub(1, std::memory_order_relaxed);
 }
 
+void ThreadWorkSource::RecordQueueingDelay(uint64 delay_us) {
+  total_queueing_delay_us_.fetch_add(delay_us, std::memory_order_relaxed);
+  num_queueing_delays_.fetch_add(1, std::memory_order_relaxed);
+}
+
+int64 ThreadWorkSource::TakeMeanQueueingDelay() {
+  const int64 count = num_queueing_delays_.exchange(0);
+  const uint64 total = total_queueing_delay_us_.exchange(0);
+  return count > 0 ? total / count : -1;
+}
+
 unsigned ThreadWorkSource::NonBlockingWorkShardingFactor() {
   return non_blocking_work_sharding_factor_;
 }
@@ -384,6 +399,9 @@ void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
                                           bool is_blocking,
                                           std::function<void()> fn) {
   Task t = env_.CreateTask(std::move(fn));
+  if (is_blocking) {
+    t.f->enqueue_time_us = EnvTime::NowMicros();
+  }
   t = tws->EnqueueTask(std::move(t), is_blocking);
   if (t.f) {
     VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
@@ -624,6 +642,10 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
           profiler::TraceMeLevel::kInfo);
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
+      if (task_from_blocking_queue) {
+        tws->RecordQueueingDelay(EnvTime::NowMicros() -
+                                 t.f->enqueue_time_us);
+      }
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
       env_.ExecuteTask(t);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
@@ -741,6 +763,20 @@ class RunHandler::Impl {
 
   int64 priority() { return options_.priority(); }
 
+  // Absolute deadline (in microseconds since unix epoch) of the request, or
+  // kuint64max if it has none.
+  uint64 deadline_us() const { return deadline_us_; }
+
+  // Returns true if this handler's work should be scheduled before the work of
+  // 'other', i.e. if it has a higher priority or the same priority and an
+  // earlier deadline.
+  bool ScheduledBefore(Impl* other) {
+    if (priority() != other->priority()) {
+      return priority() > other->priority();
+    }
+    return deadline_us_ < other->deadline_us();
+  }
+
  private:
   class ThreadPoolInterfaceWrapper : public thread::ThreadPoolInterface {
    public:
@@ -757,6 +793,7 @@ class RunHandler::Impl {
 
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  uint64 deadline_us_;
   int64 step_id_;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   internal::ThreadWorkSource tws_;
@@ -783,8 +820,19 @@ class RunHandlerPool::Impl {
         version_(0),
         sub_thread_pool_end_request_percentage_(ParamFromEnvWithDefault(
             "TF_RUN_HANDLER_SUB_THREAD_POOL_END_REQUEST_PERCENTAGE",
-            std::vector<double>({1}))) {
+            std::vector<double>({1}))),
+        reserved_priorities_(ParamFromEnvWithDefault(
+            "TF_RUN_HANDLER_RESERVED_PRIORITIES", std::vector<int>())),
+        reserved_thread_shares_(ParamFromEnvWithDefault(
+            "TF_RUN_HANDLER_RESERVED_THREAD_SHARES", std::vector<double>())) {
     VLOG(1) << "Creating a RunHandlerPool with max handlers: " << max_handlers_;
+    if (reserved_priorities_.size() != reserved_thread_shares_.size()) {
+      LOG(WARNING) << "TF_RUN_HANDLER_RESERVED_PRIORITIES and "
+                   << "TF_RUN_HANDLER_RESERVED_THREAD_SHARES have different "
+                   << "lengths; ignoring the reserved thread shares.";
+      reserved_priorities_.clear();
+      reserved_thread_shares_.clear();
+    }
     free_handlers_.reserve(max_handlers_);
     handlers_.reserve(max_handlers_);
     for (int i = 0; i < max_handlers_; ++i) {
@@ -834,6 +882,7 @@ class RunHandlerPool::Impl {
                     static_cast<int32>(ParamFromEnvWithDefault(
                         "TF_RUN_HANDLER_MAX_CONCURRENT_HANDLERS",
                         kMaxConcurrentHandlers))));
+    thread_local std::vector<int64> priorities;
     uint64 version;
     int num_active_requests;
     RunHandler::Impl* handler_impl;
@@ -862,23 +911,26 @@ class RunHandlerPool::Impl {
 
       num_active_requests = sorted_active_handlers_.size() + 1;
       thread_work_sources->resize(num_active_requests);
-      int priority = options.priority();
+      priorities.resize(num_active_requests);
       auto it = sorted_active_handlers_.cbegin();
       bool new_handler_inserted = false;
       for (int i = 0; i < num_active_requests; ++i) {
-        if (!new_handler_inserted && (it == sorted_active_handlers_.cend() ||
-                                      priority > (*it)->priority())) {
+        if (!new_handler_inserted &&
+            (it == sorted_active_handlers_.cend() ||
+             handler_impl->ScheduledBefore(*it))) {
           sorted_active_handlers_.insert(it, handler_impl);
           new_handler_inserted = true;
           // Point to the newly added handler.
           --it;
         }
         (*thread_work_sources)[i] = (*it)->tws();
+        priorities[i] = (*it)->priority();
         ++it;
       }
       version = ++version_;
     }
-    RecomputePoolStats(num_active_requests, version, *thread_work_sources);
+    RecomputePoolStats(num_active_requests, version, *thread_work_sources,
+                       priorities);
     return WrapUnique<RunHandler>(new RunHandler(handler_impl));
   }
 
@@ -893,6 +945,12 @@ class RunHandlerPool::Impl {
     double elapsed = (now - handler->start_time_us()) / 1000.0;
     time_hist_.Add(elapsed);
 
+    const int64 queueing_delay_us = handler->tws()->TakeMeanQueueingDelay();
+    if (queueing_delay_us >= 0) {
+      metrics::RecordRunHandlerQueueingDelay(handler->priority(),
+                                             queueing_delay_us);
+    }
+
     // Erase from and update sorted_active_handlers_. Add it to the end of
     // free_handlers_.
     auto iter = std::find(sorted_active_handlers_.begin(),
@@ -923,11 +981,24 @@ class RunHandlerPool::Impl {
     return ret;
   }
 
+  std::vector<int64> GetActiveHandlerStepIdsForTesting()
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    std::vector<int64> ret;
+    for (const auto& handler_impl : sorted_active_handlers_) {
+      ret.push_back(handler_impl->step_id());
+    }
+    return ret;
+  }
+
  private:
+  // 'priorities' holds the priority of each request in
+  // 'thread_work_sources'.
   void RecomputePoolStats(
       int num_active_requests, uint64 version,
       const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
-          thread_work_sources);
+          thread_work_sources,
+      const std::vector<int64>& priorities);
 
   void LogInfo() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -942,8 +1013,7 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<internal::RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by priority, then deadline, then start time.
   // TODO(chaox): Consider other data structure for maintaining the sorted
   // active handlers if the searching overhead(currently O(n)) becomes the
   // bottleneck.
@@ -958,12 +1028,18 @@ class RunHandlerPool::Impl {
   mutex mu_;
   int64 version_ TF_GUARDED_BY(mu_);
   const std::vector<double> sub_thread_pool_end_request_percentage_;
+
+  // Share of the inter-op threads that is reserved for the request of each
+  // priority class with the earliest deadline. Indexed in parallel.
+  std::vector<int> reserved_priorities_;
+  std::vector<double> reserved_thread_shares_;
 };
 
 void RunHandlerPool::Impl::RecomputePoolStats(
     int num_active_requests, uint64 version,
     const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
-        thread_work_sources) {
+        thread_work_sources,
+    const std::vector<int64>& priorities) {
   if (num_active_requests == 0) return;
 
   int sub_thread_pool_id = 0;
@@ -986,6 +1062,10 @@ void RunHandlerPool::Impl::RecomputePoolStats(
 
   std::vector<int> request_idx_list = ChooseRequestsWithExponentialDistribution(
       num_active_requests, num_blocking_threads);
+  if (!reserved_priorities_.empty()) {
+    ReserveThreadsForPriorities(priorities, reserved_priorities_,
+                                reserved_thread_shares_, &request_idx_list);
+  }
   for (int i = 0; i < num_blocking_threads; ++i) {
     VLOG(2) << "Set work for tid=" << i
             << " with start_request_idx=" << request_idx_list[i];
@@ -1067,6 +1147,9 @@ void RunHandler::Impl::Reset(
     int64 step_id,
     const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = options.deadline_in_ms() > 0
+                     ? start_time_us_ + options.deadline_in_ms() * 1000
+                     : kuint64max;
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
@@ -1092,6 +1175,10 @@ std::vector<int64> RunHandlerPool::GetActiveHandlerPrioritiesForTesting()
   return impl_->GetActiveHandlerPrioritiesForTesting();
 }
 
+std::vector<int64> RunHandlerPool::GetActiveHandlerStepIdsForTesting() const {
+  return impl_->GetActiveHandlerStepIdsForTesting();
+}
+
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
 void RunHandler::ScheduleInterOpClosure(std::function<void()> fn) {
@@ -72,6 +72,10 @@ class RunHandlerPool {
   // order of the active handler list.
   std::vector<int64> GetActiveHandlerPrioritiesForTesting() const;
 
+  // Get the step ids for active handlers, in the order of the active handler
+  // list.
+  std::vector<int64> GetActiveHandlerStepIdsForTesting() const;
+
  private:
   class Impl;
   friend class RunHandler;
@@ -82,7 +86,7 @@ class RunHandlerPool {
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
 // handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// (priority, then deadline, then time of the Get() call).
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -116,6 +120,8 @@ class RunHandlerEnvironment {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    // Time (in microseconds) at which an inter-op task was enqueued, or 0.
+    uint64 enqueue_time_us;
   };
   Env* const env_;
   const ThreadOptions thread_options_;
@@ -181,6 +187,14 @@ class ThreadWorkSource {
 
   void DecrementInflightTaskCount(bool is_blocking);
 
+  // Records that an inter-op task waited 'delay_us' microseconds in the queue
+  // before it started running.
+  void RecordQueueingDelay(uint64 delay_us);
+
+  // Returns the mean queueing delay recorded since the last call, or -1 if no
+  // delay was recorded, and resets the recorded delays.
+  int64 TakeMeanQueueingDelay();
+
   unsigned NonBlockingWorkShardingFactor();
 
   std::string ToString();
@@ -198,6 +212,9 @@ class ThreadWorkSource {
   std::atomic<int64> blocking_inflight_;
   std::atomic<int64> non_blocking_inflight_;
 
+  std::atomic<uint64> total_queueing_delay_us_;
+  std::atomic<int64> num_queueing_delays_;
+
   Queue blocking_work_queue_;
   mutex blocking_queue_op_mu_;
   char pad_[128];
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/run_handler_util.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -181,4 +182,25 @@ std::vector<int> ChooseRequestsWithExponentialDistribution(
   return request_idx_list;
 }
 
+void ReserveThreadsForPriorities(
+    const std::vector<std::int64_t>& request_priorities,
+    const std::vector<int>& reserved_priorities,
+    const std::vector<double>& reserved_shares,
+    std::vector<int>* request_idx_list) {
+  DCHECK_EQ(reserved_priorities.size(), reserved_shares.size());
+  const int num_threads = request_idx_list->size();
+  int num_unreserved_threads = num_threads;
+  for (int i = 0; i < reserved_priorities.size(); ++i) {
+    auto it = std::find(request_priorities.begin(), request_priorities.end(),
+                        reserved_priorities[i]);
+    if (it == request_priorities.end()) continue;
+    const int request_idx = it - request_priorities.begin();
+    int num_reserved_threads = std::min<int>(
+        std::round(reserved_shares[i] * num_threads), num_unreserved_threads);
+    for (; num_reserved_threads > 0; --num_reserved_threads) {
+      (*request_idx_list)[--num_unreserved_threads] = request_idx;
+    }
+  }
+}
+
 }  // namespace tensorflow
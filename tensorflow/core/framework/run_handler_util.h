@@ -54,6 +54,20 @@ void ComputeInterOpStealingRanges(int num_threads, int min_threads_per_domain,
 std::vector<int> ChooseRequestsWithExponentialDistribution(
     int num_active_requests, int num_threads);
 
+// Reserves a share of the threads in 'request_idx_list' (as returned by
+// ChooseRequestsWithExponentialDistribution) for each priority class.
+// 'request_priorities' holds the priority of every active request in
+// scheduling order. For every i such that a request of priority
+// reserved_priorities[i] is active, the last
+// round(reserved_shares[i] * request_idx_list->size()) threads not yet
+// reserved are pointed at the first such request. Reservations that do not
+// fit in the remaining threads are truncated.
+void ReserveThreadsForPriorities(
+    const std::vector<std::int64_t>& request_priorities,
+    const std::vector<int>& reserved_priorities,
+    const std::vector<double>& reserved_shares,
+    std::vector<int>* request_idx_list);
+
 // Look up environment variable named 'var_name' and return the value if it
 // exist and can be parsed. Return 'default_value' otherwise.
 double ParamFromEnvWithDefault(const char* var_name, double default_value);
@@ -126,6 +126,32 @@ TEST(RunHandlerUtilTest, TestExponentialRequestDistribution) {
   ASSERT_EQ(actual_distribution, expected_distribution);
 }
 
+TEST(RunHandlerUtilTest, TestReserveThreadsForPriorities) {
+  // Requests in scheduling order: two of priority 3, then priorities 2 and 1.
+  std::vector<std::int64_t> request_priorities{3, 3, 2, 1};
+  std::vector<int> request_idx_list =
+      ChooseRequestsWithExponentialDistribution(4, 10);
+
+  // 20% of the threads go to priority 1 and 30% to priority 2.  Priority 7 has
+  // no active request and reserves nothing.
+  ReserveThreadsForPriorities(request_priorities, {1, 7, 2}, {0.2, 0.5, 0.3},
+                              &request_idx_list);
+  ASSERT_EQ(request_idx_list.size(), 10);
+  EXPECT_EQ(request_idx_list[0], 0);
+  EXPECT_EQ(request_idx_list[5], 2);
+  EXPECT_EQ(request_idx_list[6], 2);
+  EXPECT_EQ(request_idx_list[7], 2);
+  EXPECT_EQ(request_idx_list[8], 3);
+  EXPECT_EQ(request_idx_list[9], 3);
+
+  // Reservations are truncated to the number of threads.
+  request_idx_list = ChooseRequestsWithExponentialDistribution(4, 4);
+  ReserveThreadsForPriorities(request_priorities, {1, 2}, {0.75, 0.75},
+                              &request_idx_list);
+  std::vector<int> expected_distribution{2, 3, 3, 3};
+  EXPECT_EQ(request_idx_list, expected_distribution);
+}
+
 TEST(RunHandlerUtilTest, TestParamFromEnvWithDefault) {
   std::vector<double> result = ParamFromEnvWithDefault(
       "RUN_HANDLER_TEST_ENV", std::vector<double>{0, 0, 0});
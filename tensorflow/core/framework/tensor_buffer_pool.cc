@@ -0,0 +1,253 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/tensor_buffer_pool.h"
+
+#include <new>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/types.h"
+
+namespace tensorflow {
+
+constexpr int TensorBufferPool::kMaxSizeClasses;
+constexpr int TensorBufferPool::kMaxBuffersPerSize;
+constexpr int64 TensorBufferPool::kDefaultMaxIdleBytes;
+
+// A TensorBuffer constructed in the storage of a Slot.  Deleting it (when its
+// reference count drops to zero) hands the slot back to the pool.
+class TensorBufferPool::PooledBuffer : public TensorBuffer {
+ public:
+  explicit PooledBuffer(Slot* slot);
+
+  static void* operator new(size_t size, Slot* slot);
+  // Only reached if the constructor throws.
+  static void operator delete(void* ptr, Slot* slot) {}
+  static void operator delete(void* ptr);
+
+  size_t size() const override;
+  TensorBuffer* root_buffer() override { return this; }
+  bool GetAllocatedBytes(size_t* out_bytes) const override;
+  void FillAllocationDescription(AllocationDescription* proto) const override;
+
+ private:
+  Slot* const slot_;
+};
+
+struct TensorBufferPool::Slot {
+  // Must be the first member: PooledBuffer::operator delete maps the object
+  // address back to its slot.
+  alignas(PooledBuffer) char storage[sizeof(PooledBuffer)];
+  TensorBufferPool* pool;
+  SizeClass* size_class;
+  void* data;
+  size_t num_bytes;
+};
+
+TensorBufferPool::PooledBuffer::PooledBuffer(Slot* slot)
+    : TensorBuffer(slot->data), slot_(slot) {}
+
+void* TensorBufferPool::PooledBuffer::operator new(size_t size, Slot* slot) {
+  DCHECK_EQ(size, sizeof(slot->storage));
+  return slot->storage;
+}
+
+void TensorBufferPool::PooledBuffer::operator delete(void* ptr) {
+  Slot* slot = reinterpret_cast<Slot*>(ptr);
+  slot->pool->Release(slot);
+}
+
+size_t TensorBufferPool::PooledBuffer::size() const { return slot_->num_bytes; }
+
+bool TensorBufferPool::PooledBuffer::GetAllocatedBytes(
+    size_t* out_bytes) const {
+  Allocator* allocator = slot_->pool->allocator();
+  if (allocator->TracksAllocationSizes()) {
+    *out_bytes = allocator->AllocatedSize(data());
+    return *out_bytes > 0;
+  }
+  return false;
+}
+
+void TensorBufferPool::PooledBuffer::FillAllocationDescription(
+    AllocationDescription* proto) const {
+  Allocator* allocator = slot_->pool->allocator();
+  void* data_ptr = data();
+  proto->set_requested_bytes(size());
+  proto->set_allocator_name(allocator->Name());
+  proto->set_ptr(reinterpret_cast<uintptr_t>(data_ptr));
+  if (allocator->TracksAllocationSizes()) {
+    proto->set_allocated_bytes(allocator->AllocatedSize(data_ptr));
+    int64 id = allocator->AllocationId(data_ptr);
+    if (id > 0) {
+      proto->set_allocation_id(id);
+    }
+    if (RefCountIsOne()) {
+      proto->set_has_single_reference(true);
+    }
+  }
+}
+
+TensorBufferPool::TensorBufferPool(Allocator* allocator,
+                                   int64 max_idle_bytes)
+    : allocator_(allocator), max_idle_bytes_(max_idle_bytes) {}
+
+TensorBufferPool::~TensorBufferPool() {
+  for (SizeClass& size_class : size_classes_) {
+    while (Slot* slot = Pop(&size_class)) Destroy(slot);
+  }
+}
+
+bool TensorBufferPool::AllocateTensor(
+    DataType type, const TensorShape& shape,
+    const AllocationAttributes& allocation_attr, Tensor* tensor) {
+  if (!DataTypeCanUseMemcpy(type) || allocation_attr.freed_by_func != nullptr ||
+      shutdown_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  const size_t num_bytes = shape.num_elements() * DataTypeSize(type);
+  if (num_bytes == 0) return false;
+  SizeClass* size_class = FindOrClaimSizeClass(num_bytes);
+  if (size_class == nullptr) return false;
+
+  Slot* slot = Pop(size_class);
+  if (slot != nullptr) {
+    num_hits_.fetch_add(1, std::memory_order_relaxed);
+    idle_bytes_.fetch_sub(num_bytes, std::memory_order_relaxed);
+  } else {
+    num_misses_.fetch_add(1, std::memory_order_relaxed);
+    void* data = allocator_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                         num_bytes, allocation_attr);
+    if (data == nullptr) return false;
+    slot = new Slot;
+    slot->pool = this;
+    slot->size_class = size_class;
+    slot->data = data;
+    slot->num_bytes = num_bytes;
+  }
+  // Released by Release() once the buffer is dropped.
+  Ref();
+  *tensor = Tensor(type, shape,
+                   core::RefCountPtr<TensorBuffer>(new (slot) PooledBuffer(slot)));
+  return true;
+}
+
+void TensorBufferPool::Shutdown() {
+  shutdown_.store(true, std::memory_order_release);
+  for (SizeClass& size_class : size_classes_) {
+    while (Slot* slot = Pop(&size_class)) {
+      idle_bytes_.fetch_sub(slot->num_bytes, std::memory_order_relaxed);
+      Destroy(slot);
+    }
+  }
+}
+
+TensorBufferPool::SizeClass* TensorBufferPool::FindOrClaimSizeClass(
+    size_t num_bytes) {
+  const size_t start = (num_bytes * 0x9E3779B97F4A7C15ull) >> 32;
+  for (int i = 0; i < kMaxSizeClasses; ++i) {
+    SizeClass& size_class = size_classes_[(start + i) % kMaxSizeClasses];
+    size_t claimed = size_class.num_bytes.load(std::memory_order_acquire);
+    if (claimed == 0) {
+      if (size_class.num_bytes.compare_exchange_strong(
+              claimed, num_bytes, std::memory_order_acq_rel)) {
+        return &size_class;
+      }
+      // Lost the race; `claimed` now holds the winner's size.
+    }
+    if (claimed == num_bytes) return &size_class;
+  }
+  return nullptr;
+}
+
+TensorBufferPool::Slot* TensorBufferPool::Pop(SizeClass* size_class) {
+  for (std::atomic<Slot*>& entry : size_class->free) {
+    Slot* slot = entry.load(std::memory_order_relaxed);
+    if (slot != nullptr &&
+        entry.compare_exchange_strong(slot, nullptr,
+                                      std::memory_order_acquire)) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+void TensorBufferPool::Release(Slot* slot) {
+  bool recycled = false;
+  bool reserved = false;
+  if (!shutdown_.load(std::memory_order_acquire)) {
+    reserved = ReserveIdleBytes(slot->num_bytes);
+    if (!reserved && static_cast<int64>(slot->num_bytes) <= max_idle_bytes_) {
+      EvictIdleBytes(idle_bytes_.load(std::memory_order_relaxed) +
+                         slot->num_bytes - max_idle_bytes_,
+                     slot->size_class);
+      reserved = ReserveIdleBytes(slot->num_bytes);
+    }
+  }
+  if (reserved) {
+    for (std::atomic<Slot*>& entry : slot->size_class->free) {
+      Slot* empty = nullptr;
+      if (entry.load(std::memory_order_relaxed) == nullptr &&
+          entry.compare_exchange_strong(empty, slot,
+                                        std::memory_order_release)) {
+        recycled = true;
+        break;
+      }
+    }
+    if (!recycled) {
+      idle_bytes_.fetch_sub(slot->num_bytes, std::memory_order_relaxed);
+    }
+  }
+  // A slot pushed concurrently with Shutdown() stays idle until the pool is
+  // destroyed.
+  if (!recycled) Destroy(slot);
+  Unref();
+}
+
+bool TensorBufferPool::ReserveIdleBytes(size_t num_bytes) {
+  int64 idle = idle_bytes_.load(std::memory_order_relaxed);
+  while (idle + static_cast<int64>(num_bytes) <= max_idle_bytes_) {
+    if (idle_bytes_.compare_exchange_weak(idle, idle + num_bytes,
+                                          std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TensorBufferPool::EvictIdleBytes(size_t num_bytes,
+                                      const SizeClass* keep) {
+  const int start = next_eviction_.fetch_add(1, std::memory_order_relaxed);
+  size_t evicted = 0;
+  for (int i = 0; i < kMaxSizeClasses && evicted < num_bytes; ++i) {
+    SizeClass* size_class =
+        &size_classes_[static_cast<unsigned>(start + i) % kMaxSizeClasses];
+    if (size_class == keep) continue;
+    while (evicted < num_bytes) {
+      Slot* slot = Pop(size_class);
+      if (slot == nullptr) break;
+      evicted += slot->num_bytes;
+      idle_bytes_.fetch_sub(slot->num_bytes, std::memory_order_relaxed);
+      Destroy(slot);
+    }
+  }
+}
+
+void TensorBufferPool::Destroy(Slot* slot) {
+  allocator_->DeallocateRaw(slot->data);
+  delete slot;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_TENSOR_BUFFER_POOL_H_
+#define TENSORFLOW_CORE_FRAMEWORK_TENSOR_BUFFER_POOL_H_
+
+#include <atomic>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A pool of recycled TensorBuffers for tensors whose byte size recurs, such
+// as the outputs of kernels in a serving graph with fixed shapes.
+//
+// Every buffer handed out by the pool owns both its TensorBuffer object and
+// its backing memory from `allocator`.  When the last reference to the buffer
+// is dropped, the pair is kept on a lock-free free list for its byte size
+// instead of being destroyed, and the next request for the same number of
+// bytes reuses it without calling into the allocator.  Each size class keeps
+// at most kMaxBuffersPerSize idle buffers, and at most kMaxSizeClasses
+// distinct sizes are pooled; other requests are served like an ordinary
+// Tensor allocation.  The idle buffers of all size classes together hold at
+// most `max_idle_bytes`; when a released buffer would exceed this budget,
+// idle buffers of other sizes are evicted to make room for it.
+//
+// Only types that can be memcpy'd are pooled, since the pool neither
+// constructs nor destroys elements.  Like the memory of any other tensor, the
+// contents of a recycled buffer are unspecified.
+//
+// The pool is reference-counted: every live buffer holds a reference, so
+// tensors may safely outlive the owner's reference.  `allocator` must outlive
+// all of them.
+class TensorBufferPool : public core::RefCounted {
+ public:
+  static constexpr int kMaxSizeClasses = 64;
+  static constexpr int kMaxBuffersPerSize = 16;
+  static constexpr int64 kDefaultMaxIdleBytes = 256 << 20;
+
+  explicit TensorBufferPool(Allocator* allocator,
+                            int64 max_idle_bytes = kDefaultMaxIdleBytes);
+
+  Allocator* allocator() const { return allocator_; }
+
+  // Sets `*tensor` to a tensor of `type` and `shape` backed by a pooled
+  // buffer and returns true, or returns false if the request is not pooled
+  // or the allocation failed.
+  bool AllocateTensor(DataType type, const TensorShape& shape,
+                      const AllocationAttributes& allocation_attr,
+                      Tensor* tensor);
+
+  // Releases all idle buffers and stops recycling.  Buffers that are still
+  // referenced are freed when they are released.
+  void Shutdown();
+
+  // Number of requests served from, respectively not found in, the free
+  // lists.
+  int64 num_hits() const { return num_hits_.load(std::memory_order_relaxed); }
+  int64 num_misses() const {
+    return num_misses_.load(std::memory_order_relaxed);
+  }
+
+  // Total size of the idle buffers held by the pool.
+  int64 idle_bytes() const {
+    return idle_bytes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  class PooledBuffer;
+  struct Slot;
+
+  // Idle buffers of one byte size.
+  struct SizeClass {
+    // 0 while unclaimed.
+    std::atomic<size_t> num_bytes{0};
+    std::atomic<Slot*> free[kMaxBuffersPerSize] = {};
+  };
+
+  ~TensorBufferPool() override;
+
+  // Returns the size class for `num_bytes`, claiming a new one if needed, or
+  // nullptr if all size classes are taken.
+  SizeClass* FindOrClaimSizeClass(size_t num_bytes);
+
+  // Returns an idle slot of `size_class`, or nullptr.
+  Slot* Pop(SizeClass* size_class);
+
+  // Called when the last reference to the buffer held in `slot` is dropped.
+  void Release(Slot* slot);
+
+  // Adds `num_bytes` to `idle_bytes_` and returns true if the result stays
+  // within `max_idle_bytes_`.  Otherwise leaves `idle_bytes_` unchanged and
+  // returns false.
+  bool ReserveIdleBytes(size_t num_bytes);
+
+  // Destroys idle buffers of size classes other than `keep` until at least
+  // `num_bytes` have been freed or no such buffer is left.
+  void EvictIdleBytes(size_t num_bytes, const SizeClass* keep);
+
+  // Frees `slot` and its memory.
+  void Destroy(Slot* slot);
+
+  Allocator* const allocator_;  // Not owned.
+  const int64 max_idle_bytes_;
+  std::atomic<bool> shutdown_{false};
+  std::atomic<int64> num_hits_{0};
+  std::atomic<int64> num_misses_{0};
+  std::atomic<int64> idle_bytes_{0};
+  // The size class at which the next eviction starts, so that evictions are
+  // spread over all size classes.
+  std::atomic<int> next_eviction_{0};
+  SizeClass size_classes_[kMaxSizeClasses];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TensorBufferPool);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_TENSOR_BUFFER_POOL_H_
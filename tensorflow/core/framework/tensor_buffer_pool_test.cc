@@ -0,0 +1,167 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/tensor_buffer_pool.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class TensorBufferPoolTest : public ::testing::Test {
+ protected:
+  TensorBufferPoolTest() : pool_(new TensorBufferPool(cpu_allocator())) {}
+
+  Tensor Allocate(DataType type, const TensorShape& shape) {
+    Tensor t;
+    EXPECT_TRUE(pool_->AllocateTensor(type, shape, AllocationAttributes(), &t));
+    EXPECT_EQ(type, t.dtype());
+    EXPECT_EQ(shape, t.shape());
+    return t;
+  }
+
+  core::RefCountPtr<TensorBufferPool> pool_;
+};
+
+TEST_F(TensorBufferPoolTest, RecyclesReleasedBuffers) {
+  const void* data;
+  {
+    Tensor t = Allocate(DT_FLOAT, TensorShape({4, 8}));
+    t.flat<float>().setConstant(1.0f);
+    data = t.tensor_data().data();
+  }
+  EXPECT_EQ(0, pool_->num_hits());
+  EXPECT_EQ(1, pool_->num_misses());
+  EXPECT_EQ(128, pool_->idle_bytes());
+
+  // Same byte size, different type and shape.
+  Tensor t = Allocate(DT_INT32, TensorShape({32}));
+  EXPECT_EQ(data, t.tensor_data().data());
+  EXPECT_EQ(1, pool_->num_hits());
+  EXPECT_EQ(0, pool_->idle_bytes());
+}
+
+TEST_F(TensorBufferPoolTest, SharedBufferIsNotRecycledWhileReferenced) {
+  Tensor a = Allocate(DT_FLOAT, TensorShape({16}));
+  Tensor alias = a;
+  a = Tensor();
+  Tensor b = Allocate(DT_FLOAT, TensorShape({16}));
+  EXPECT_NE(alias.tensor_data().data(), b.tensor_data().data());
+  EXPECT_EQ(0, pool_->num_hits());
+}
+
+TEST_F(TensorBufferPoolTest, DistinctSizes) {
+  const void* small_data;
+  {
+    Tensor small = Allocate(DT_FLOAT, TensorShape({16}));
+    small_data = small.tensor_data().data();
+  }
+  Tensor large = Allocate(DT_FLOAT, TensorShape({32}));
+  EXPECT_NE(small_data, large.tensor_data().data());
+  EXPECT_EQ(0, pool_->num_hits());
+  Tensor small = Allocate(DT_FLOAT, TensorShape({16}));
+  EXPECT_EQ(small_data, small.tensor_data().data());
+  EXPECT_EQ(1, pool_->num_hits());
+}
+
+TEST_F(TensorBufferPoolTest, UnsupportedRequests) {
+  Tensor t;
+  EXPECT_FALSE(pool_->AllocateTensor(DT_STRING, TensorShape({4}),
+                                     AllocationAttributes(), &t));
+  EXPECT_FALSE(pool_->AllocateTensor(DT_FLOAT, TensorShape({0}),
+                                     AllocationAttributes(), &t));
+  EXPECT_EQ(0, pool_->num_misses());
+}
+
+TEST_F(TensorBufferPoolTest, LimitsIdleBuffersPerSize) {
+  {
+    std::vector<Tensor> tensors;
+    for (int i = 0; i < TensorBufferPool::kMaxBuffersPerSize + 4; ++i) {
+      tensors.push_back(Allocate(DT_FLOAT, TensorShape({16})));
+    }
+  }
+  EXPECT_EQ(TensorBufferPool::kMaxBuffersPerSize * 64, pool_->idle_bytes());
+}
+
+TEST(TensorBufferPoolBudgetTest, EvictsOtherSizesToStayWithinBudget) {
+  core::RefCountPtr<TensorBufferPool> pool(
+      new TensorBufferPool(cpu_allocator(), /*max_idle_bytes=*/256));
+  Tensor small;
+  ASSERT_TRUE(pool->AllocateTensor(DT_FLOAT, TensorShape({32}),
+                                   AllocationAttributes(), &small));
+  Tensor large;
+  ASSERT_TRUE(pool->AllocateTensor(DT_FLOAT, TensorShape({48}),
+                                   AllocationAttributes(), &large));
+  small = Tensor();
+  EXPECT_EQ(128, pool->idle_bytes());
+
+  // Keeping the 192-byte buffer as well would exceed the budget, so the idle
+  // 128-byte buffer is evicted.
+  large = Tensor();
+  EXPECT_EQ(192, pool->idle_bytes());
+  ASSERT_TRUE(pool->AllocateTensor(DT_FLOAT, TensorShape({32}),
+                                   AllocationAttributes(), &small));
+  EXPECT_EQ(0, pool->num_hits());
+  ASSERT_TRUE(pool->AllocateTensor(DT_FLOAT, TensorShape({48}),
+                                   AllocationAttributes(), &large));
+  EXPECT_EQ(1, pool->num_hits());
+  EXPECT_EQ(0, pool->idle_bytes());
+
+  // A buffer larger than the whole budget is never kept.
+  Tensor huge;
+  ASSERT_TRUE(pool->AllocateTensor(DT_FLOAT, TensorShape({128}),
+                                   AllocationAttributes(), &huge));
+  huge = Tensor();
+  EXPECT_EQ(0, pool->idle_bytes());
+}
+
+TEST_F(TensorBufferPoolTest, TensorsOutliveShutdownPool) {
+  Tensor t = Allocate(DT_FLOAT, TensorShape({16}));
+  { Tensor idle = Allocate(DT_FLOAT, TensorShape({8})); }
+  pool_->Shutdown();
+  EXPECT_EQ(0, pool_->idle_bytes());
+  Tensor unpooled;
+  EXPECT_FALSE(pool_->AllocateTensor(DT_FLOAT, TensorShape({16}),
+                                     AllocationAttributes(), &unpooled));
+  pool_.reset();
+  t.flat<float>().setConstant(2.0f);
+  EXPECT_EQ(2.0f, t.flat<float>()(15));
+}
+
+TEST_F(TensorBufferPoolTest, ConcurrentAllocations) {
+  constexpr int kThreads = 8;
+  constexpr int kIterations = 1000;
+  {
+    thread::ThreadPool threads(Env::Default(), "test", kThreads);
+    for (int i = 0; i < kThreads; ++i) {
+      threads.Schedule([this, i]() {
+        for (int j = 0; j < kIterations; ++j) {
+          Tensor t = Allocate(DT_INT32, TensorShape({1 + (i + j) % 4}));
+          t.flat<int32>().setConstant(i);
+          EXPECT_EQ(i, t.flat<int32>()(0));
+        }
+      });
+    }
+  }
+  EXPECT_EQ(kThreads * kIterations, pool_->num_hits() + pool_->num_misses());
+  EXPECT_GT(pool_->num_hits(), pool_->num_misses());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,122 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace grappler {
+
+OpCostCalibration::OpCostCalibration(const OpCostCorrectionList& corrections) {
+  for (const OpCostCorrection& correction : corrections.correction()) {
+    if (correction.correction() <= 0) continue;
+    corrections_[Key(correction.op(), correction.device_type(),
+                     correction.shape_class())] = correction.correction();
+  }
+}
+
+Status OpCostCalibration::Load(
+    const std::string& path,
+    std::shared_ptr<const OpCostCalibration>* calibration) {
+  static mutex* mu = new mutex();
+  static auto* calibrations =
+      new absl::flat_hash_map<std::string,
+                              std::shared_ptr<const OpCostCalibration>>();
+  mutex_lock l(*mu);
+  auto it = calibrations->find(path);
+  if (it != calibrations->end()) {
+    *calibration = it->second;
+    return Status::OK();
+  }
+  OpCostCorrectionList corrections;
+  if (!ReadBinaryProto(Env::Default(), path, &corrections).ok()) {
+    TF_RETURN_IF_ERROR(ReadTextProto(Env::Default(), path, &corrections));
+  }
+  *calibration = std::make_shared<const OpCostCalibration>(corrections);
+  VLOG(1) << "Loaded " << (*calibration)->num_corrections()
+          << " cost corrections from " << path;
+  calibrations->emplace(path, *calibration);
+  return Status::OK();
+}
+
+std::shared_ptr<const OpCostCalibration> OpCostCalibration::FromEnv() {
+  const char* path = std::getenv("TF_OP_COST_CALIBRATION_FILE");
+  if (path == nullptr || *path == '\0') return nullptr;
+  std::shared_ptr<const OpCostCalibration> calibration;
+  Status s = Load(path, &calibration);
+  if (!s.ok()) {
+    LOG_FIRST_N(WARNING, 1) << "Failed to load the cost model calibration: "
+                            << s;
+    return nullptr;
+  }
+  return calibration;
+}
+
+int OpCostCalibration::ShapeClass(const OpInfo& op_info) {
+  int64 max_num_elements = 1;
+  for (const auto& input : op_info.inputs()) {
+    if (input.shape().unknown_rank()) return -1;
+    int64 num_elements = 1;
+    for (const auto& dim : input.shape().dim()) {
+      if (dim.size() < 0) return -1;
+      num_elements *= dim.size();
+    }
+    max_num_elements = std::max(max_num_elements, num_elements);
+  }
+  return static_cast<int>(std::log2(static_cast<double>(max_num_elements)));
+}
+
+double OpCostCalibration::Correction(const OpInfo& op_info) const {
+  const std::string& device_type = op_info.device().type();
+  const int shape_class = ShapeClass(op_info);
+  if (shape_class >= 0) {
+    auto it = corrections_.find(Key(op_info.op(), device_type, shape_class));
+    if (it != corrections_.end()) return it->second;
+  }
+  auto it = corrections_.find(Key(op_info.op(), device_type, -1));
+  return it != corrections_.end() ? it->second : 1.0;
+}
+
+void OpCostCalibration::Apply(const OpInfo& op_info, Costs* costs) const {
+  const double correction = Correction(op_info);
+  if (correction == 1.0) return;
+  auto scale = [correction](Costs::Duration* duration) {
+    if (*duration == Costs::Duration::infinity()) return;
+    *duration = Costs::Duration(duration->count() * correction);
+  };
+  scale(&costs->execution_time);
+  scale(&costs->compute_time);
+  scale(&costs->memory_time);
+  scale(&costs->intermediate_memory_time);
+  scale(&costs->intermediate_memory_read_time);
+  scale(&costs->intermediate_memory_write_time);
+}
+
+std::string OpCostCalibration::Key(const std::string& op,
+                                   const std::string& device_type,
+                                   int shape_class) {
+  return absl::StrCat(op, "/", device_type, "/", shape_class);
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
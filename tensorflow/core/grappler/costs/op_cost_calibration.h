@@ -0,0 +1,76 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Per-op corrections of the analytical cost model, keyed by op, device type
+// and shape class. The corrections are computed from profiles by
+// OpCostCalibrator and stored in a calibration file, which
+// OpLevelCostEstimator loads at startup from the path in the environment
+// variable TF_OP_COST_CALIBRATION_FILE.
+class OpCostCalibration {
+ public:
+  explicit OpCostCalibration(const OpCostCorrectionList& corrections);
+
+  // Loads the binary or text `OpCostCorrectionList` stored at `path`.
+  // Calibrations are cached by path, so that the file is read only once per
+  // process.
+  static Status Load(const std::string& path,
+                     std::shared_ptr<const OpCostCalibration>* calibration);
+
+  // Returns the calibration stored in the file named by
+  // TF_OP_COST_CALIBRATION_FILE, or null if the variable is unset or the file
+  // can't be loaded.
+  static std::shared_ptr<const OpCostCalibration> FromEnv();
+
+  // Returns the shape class of the op, i.e. the base 2 logarithm of the
+  // number of elements of its largest input, or -1 if an input shape is
+  // unknown.
+  static int ShapeClass(const OpInfo& op_info);
+
+  // Returns the ratio of the measured to the predicted execution time of the
+  // op. A correction for the shape class of the op is preferred over the
+  // correction for all shapes. Returns 1 if the op was not calibrated.
+  double Correction(const OpInfo& op_info) const;
+
+  // Scales the predicted times in `costs` by the correction of the op.
+  void Apply(const OpInfo& op_info, Costs* costs) const;
+
+  // Returns the number of corrections.
+  int num_corrections() const { return corrections_.size(); }
+
+ private:
+  static std::string Key(const std::string& op, const std::string& device_type,
+                         int shape_class);
+
+  absl::flat_hash_map<std::string, double> corrections_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
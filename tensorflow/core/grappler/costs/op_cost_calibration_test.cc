@@ -0,0 +1,116 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+OpInfo MakeOpInfo(const string& op, const string& device_type,
+                  const std::vector<std::vector<int64>>& input_dims) {
+  OpInfo op_info;
+  op_info.set_op(op);
+  op_info.mutable_device()->set_type(device_type);
+  for (const auto& dims : input_dims) {
+    auto* shape = op_info.add_inputs()->mutable_shape();
+    for (int64 dim : dims) shape->add_dim()->set_size(dim);
+  }
+  return op_info;
+}
+
+void AddCorrection(const string& op, const string& device_type,
+                   int shape_class, double correction,
+                   OpCostCorrectionList* list) {
+  OpCostCorrection* entry = list->add_correction();
+  entry->set_op(op);
+  entry->set_device_type(device_type);
+  entry->set_shape_class(shape_class);
+  entry->set_correction(correction);
+}
+
+TEST(OpCostCalibrationTest, ShapeClass) {
+  EXPECT_EQ(0, OpCostCalibration::ShapeClass(MakeOpInfo("NoOp", "CPU", {})));
+  EXPECT_EQ(6, OpCostCalibration::ShapeClass(
+                   MakeOpInfo("MatMul", "CPU", {{8, 8}, {4, 4}})));
+  EXPECT_EQ(6, OpCostCalibration::ShapeClass(
+                   MakeOpInfo("MatMul", "CPU", {{8, 9}})));
+  EXPECT_EQ(-1, OpCostCalibration::ShapeClass(
+                    MakeOpInfo("MatMul", "CPU", {{-1, 8}})));
+}
+
+TEST(OpCostCalibrationTest, Correction) {
+  OpCostCorrectionList list;
+  AddCorrection("MatMul", "GPU", 6, 3.0, &list);
+  AddCorrection("MatMul", "GPU", -1, 2.0, &list);
+  AddCorrection("Conv2D", "GPU", 6, 0.5, &list);
+  OpCostCalibration calibration(list);
+  EXPECT_EQ(3, calibration.num_corrections());
+
+  EXPECT_EQ(3.0, calibration.Correction(MakeOpInfo("MatMul", "GPU", {{8, 8}})));
+  // Falls back to the correction for all shapes.
+  EXPECT_EQ(2.0,
+            calibration.Correction(MakeOpInfo("MatMul", "GPU", {{16, 16}})));
+  EXPECT_EQ(2.0,
+            calibration.Correction(MakeOpInfo("MatMul", "GPU", {{-1, 8}})));
+  // Uncalibrated ops and devices are not corrected.
+  EXPECT_EQ(1.0, calibration.Correction(MakeOpInfo("MatMul", "CPU", {{8, 8}})));
+  EXPECT_EQ(1.0,
+            calibration.Correction(MakeOpInfo("Conv2D", "GPU", {{16, 16}})));
+}
+
+TEST(OpCostCalibrationTest, Apply) {
+  OpCostCorrectionList list;
+  AddCorrection("MatMul", "GPU", -1, 2.5, &list);
+  OpCostCalibration calibration(list);
+
+  Costs costs;
+  costs.execution_time = Costs::Duration(100);
+  costs.compute_time = Costs::Duration(60);
+  costs.memory_time = Costs::Duration(40);
+  calibration.Apply(MakeOpInfo("MatMul", "GPU", {{8, 8}}), &costs);
+  EXPECT_EQ(250, costs.execution_time.count());
+  EXPECT_EQ(150, costs.compute_time.count());
+  EXPECT_EQ(100, costs.memory_time.count());
+}
+
+TEST(OpCostCalibrationTest, Load) {
+  OpCostCorrectionList list;
+  AddCorrection("MatMul", "GPU", -1, 2.0, &list);
+  const string path =
+      io::JoinPath(testing::TmpDir(), "op_cost_calibration_test.pbtxt");
+  TF_ASSERT_OK(WriteTextProto(Env::Default(), path, list));
+
+  std::shared_ptr<const OpCostCalibration> calibration;
+  TF_ASSERT_OK(OpCostCalibration::Load(path, &calibration));
+  EXPECT_EQ(2.0, calibration->Correction(MakeOpInfo("MatMul", "GPU", {})));
+  // Calibrations are cached by path.
+  std::shared_ptr<const OpCostCalibration> cached;
+  TF_ASSERT_OK(OpCostCalibration::Load(path, &cached));
+  EXPECT_EQ(calibration.get(), cached.get());
+
+  EXPECT_FALSE(OpCostCalibration::Load(
+                   io::JoinPath(testing::TmpDir(), "missing"), &calibration)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
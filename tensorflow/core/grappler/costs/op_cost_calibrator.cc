@@ -0,0 +1,120 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibrator.h"
+
+#include <cmath>
+#include <unordered_map>
+
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+OpCostCalibrator::OpCostCalibrator() {
+  // Corrections are relative to the analytical model alone.
+  estimator_.set_calibration(nullptr);
+}
+
+void OpCostCalibrator::AddMeasurement(const OpInfo& op_info,
+                                      Costs::Duration predicted,
+                                      Costs::Duration measured) {
+  if (predicted.count() <= 0 || measured.count() <= 0) return;
+  const double log_ratio =
+      std::log(static_cast<double>(measured.count()) / predicted.count());
+  const std::string& device_type = op_info.device().type();
+  const int shape_class = OpCostCalibration::ShapeClass(op_info);
+  if (shape_class >= 0) {
+    Add(Key(op_info.op(), device_type, shape_class), log_ratio);
+  }
+  Add(Key(op_info.op(), device_type, -1), log_ratio);
+}
+
+Status OpCostCalibrator::AddOpMetrics(
+    const GrapplerItem& item, const profiler::OpMetricsDb& op_metrics_db,
+    const DeviceProperties& device) {
+  std::unordered_map<std::string, const profiler::OpMetrics*> metrics_by_name;
+  for (const profiler::OpMetrics& metrics : op_metrics_db.metrics_db()) {
+    if (metrics.occurrences() > 0) {
+      metrics_by_name.emplace(metrics.name(), &metrics);
+    }
+  }
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/true, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/true));
+  std::unordered_map<std::string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  int num_measured = 0;
+  for (const NodeDef& node : item.graph.node()) {
+    auto it = metrics_by_name.find(node.name());
+    if (it == metrics_by_name.end()) continue;
+    const profiler::OpMetrics& metrics = *it->second;
+
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.device_name = node.device();
+    op_context.op_info = BuildOpInfoWithoutDevice(
+        node, name_to_node, properties.GetInputProperties(node.name()));
+    *op_context.op_info.mutable_device() = device;
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+
+    const Costs costs = estimator_.PredictCosts(op_context);
+    if (costs.inaccurate) continue;
+    const double measured_ns =
+        static_cast<double>(metrics.self_time_ps()) / metrics.occurrences() /
+        1000;
+    AddMeasurement(op_context.op_info, costs.execution_time,
+                   Costs::Duration(measured_ns));
+    ++num_measured;
+  }
+  VLOG(1) << "Calibrated the cost model with " << num_measured
+          << " profiled nodes of " << item.graph.node_size();
+  return Status::OK();
+}
+
+OpCostCorrectionList OpCostCalibrator::Build(int64 min_samples) const {
+  OpCostCorrectionList corrections;
+  for (const auto& entry : ratios_) {
+    const Ratios& ratios = entry.second;
+    if (ratios.count < min_samples) continue;
+    OpCostCorrection* correction = corrections.add_correction();
+    correction->set_op(std::get<0>(entry.first));
+    correction->set_device_type(std::get<1>(entry.first));
+    correction->set_shape_class(std::get<2>(entry.first));
+    correction->set_correction(std::exp(ratios.sum_log / ratios.count));
+    correction->set_num_samples(ratios.count);
+  }
+  return corrections;
+}
+
+void OpCostCalibrator::Add(const Key& key, double log_ratio) {
+  Ratios& ratios = ratios_[key];
+  ratios.sum_log += log_ratio;
+  ++ratios.count;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATOR_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATOR_H_
+
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Computes the corrections of an OpCostCalibration by comparing the costs
+// predicted by OpLevelCostEstimator with the times measured by the profiler.
+//
+// Typical use: convert the XPlane of a profile to an OpMetricsDb (see
+// profiler/convert/xplane_to_op_metrics_db.h), add it with AddOpMetrics() for
+// the profiled graph, and write the result of Build() to the calibration file.
+class OpCostCalibrator {
+ public:
+  OpCostCalibrator();
+
+  // Records one execution of the op, predicted to take `predicted` and
+  // measured to take `measured`.
+  void AddMeasurement(const OpInfo& op_info, Costs::Duration predicted,
+                      Costs::Duration measured);
+
+  // Records the average self time of every node of `item` that is found by
+  // name in `op_metrics_db`, with the op inputs inferred statically. `device`
+  // describes the device the graph was profiled on.
+  Status AddOpMetrics(const GrapplerItem& item,
+                      const profiler::OpMetricsDb& op_metrics_db,
+                      const DeviceProperties& device);
+
+  // Returns the corrections, i.e. the geometric mean of the ratios of the
+  // measured to the predicted times, for every op, device type and shape class
+  // with at least `min_samples` measurements, and for every op and device type
+  // over all shapes.
+  OpCostCorrectionList Build(int64 min_samples = 1) const;
+
+ private:
+  struct Ratios {
+    double sum_log = 0;
+    int64 count = 0;
+  };
+  // Keyed by op, device type and shape class.
+  using Key = std::tuple<std::string, std::string, int>;
+
+  void Add(const Key& key, double log_ratio);
+
+  OpLevelCostEstimator estimator_;
+  std::map<Key, Ratios> ratios_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATOR_H_
@@ -0,0 +1,129 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibrator.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+DeviceProperties CpuDevice() {
+  DeviceProperties device;
+  device.set_type("CPU");
+  device.set_num_cores(4);
+  device.set_frequency(2000);
+  return device;
+}
+
+OpContext MatMulContext(int64 n) {
+  OpContext op_context;
+  op_context.name = "matmul";
+  op_context.op_info.set_op("MatMul");
+  *op_context.op_info.mutable_device() = CpuDevice();
+  for (int i = 0; i < 2; ++i) {
+    auto* input = op_context.op_info.add_inputs();
+    input->set_dtype(DT_FLOAT);
+    input->mutable_shape()->add_dim()->set_size(n);
+    input->mutable_shape()->add_dim()->set_size(n);
+  }
+  auto* output = op_context.op_info.add_outputs();
+  output->set_dtype(DT_FLOAT);
+  output->mutable_shape()->add_dim()->set_size(n);
+  output->mutable_shape()->add_dim()->set_size(n);
+  return op_context;
+}
+
+TEST(OpCostCalibratorTest, GeometricMeanOfRatios) {
+  OpCostCalibrator calibrator;
+  const OpInfo op_info = MatMulContext(8).op_info;
+  calibrator.AddMeasurement(op_info, Costs::Duration(100),
+                            Costs::Duration(200));
+  calibrator.AddMeasurement(op_info, Costs::Duration(100),
+                            Costs::Duration(800));
+  // Measurements without a prediction are ignored.
+  calibrator.AddMeasurement(op_info, Costs::Duration(0), Costs::Duration(800));
+
+  const OpCostCorrectionList corrections = calibrator.Build();
+  ASSERT_EQ(2, corrections.correction_size());
+  for (const OpCostCorrection& correction : corrections.correction()) {
+    EXPECT_EQ("MatMul", correction.op());
+    EXPECT_EQ("CPU", correction.device_type());
+    EXPECT_NEAR(4.0, correction.correction(), 1e-9);
+    EXPECT_EQ(2, correction.num_samples());
+  }
+  EXPECT_EQ(-1, corrections.correction(0).shape_class());
+  EXPECT_EQ(6, corrections.correction(1).shape_class());
+  EXPECT_EQ(0, calibrator.Build(/*min_samples=*/3).correction_size());
+}
+
+TEST(OpCostCalibratorTest, CalibratedEstimator) {
+  OpLevelCostEstimator estimator;
+  estimator.set_calibration(nullptr);
+  const OpContext op_context = MatMulContext(64);
+  const Costs predicted = estimator.PredictCosts(op_context);
+  ASSERT_GT(predicted.execution_time.count(), 0);
+
+  OpCostCalibrator calibrator;
+  calibrator.AddMeasurement(
+      op_context.op_info, predicted.execution_time,
+      Costs::Duration(3 * predicted.execution_time.count()));
+  estimator.set_calibration(
+      std::make_shared<const OpCostCalibration>(calibrator.Build()));
+  const Costs calibrated = estimator.PredictCosts(op_context);
+  EXPECT_NEAR(3 * predicted.execution_time.count(),
+              calibrated.execution_time.count(), 1);
+}
+
+TEST(OpCostCalibratorTest, AddOpMetrics) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {},
+            {{"dtype", DT_FLOAT}, {"shape", TensorShape({64, 64})}}),
+       NDef("matmul", "MatMul", {"x", "x"}, {{"T", DT_FLOAT}}),
+       NDef("relu", "Relu", {"matmul"}, {{"T", DT_FLOAT}})});
+
+  profiler::OpMetricsDb op_metrics_db;
+  profiler::OpMetrics* metrics = op_metrics_db.add_metrics_db();
+  metrics->set_name("matmul");
+  metrics->set_occurrences(2);
+  metrics->set_self_time_ps(2 * 1000 * 1000);
+  // Ops missing from the graph are ignored.
+  metrics = op_metrics_db.add_metrics_db();
+  metrics->set_name("missing");
+  metrics->set_occurrences(1);
+  metrics->set_self_time_ps(1000);
+
+  OpCostCalibrator calibrator;
+  TF_ASSERT_OK(calibrator.AddOpMetrics(item, op_metrics_db, CpuDevice()));
+  const OpCostCorrectionList corrections = calibrator.Build();
+  ASSERT_EQ(2, corrections.correction_size());
+  EXPECT_EQ("MatMul", corrections.correction(0).op());
+  EXPECT_EQ(-1, corrections.correction(0).shape_class());
+  EXPECT_EQ(12, corrections.correction(1).shape_class());
+  EXPECT_EQ(1, corrections.correction(1).num_samples());
+  EXPECT_GT(corrections.correction(1).correction(), 0);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
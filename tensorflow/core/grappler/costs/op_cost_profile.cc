@@ -0,0 +1,125 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+std::string OpKey(const std::string& op,
+                  const std::vector<std::string>& fused_ops) {
+  if (fused_ops.empty()) return op;
+  return absl::StrCat(op, "[", absl::StrJoin(fused_ops, ","), "]");
+}
+
+// Returns false if the shape is not fully defined.
+bool ShapeKey(const TensorShapeProto& shape, std::string* key) {
+  if (shape.unknown_rank()) return false;
+  std::vector<int64> dims;
+  dims.reserve(shape.dim_size());
+  for (const auto& dim : shape.dim()) {
+    if (dim.size() < 0) return false;
+    dims.push_back(dim.size());
+  }
+  *key = absl::StrCat("[", absl::StrJoin(dims, ","), "]");
+  return true;
+}
+
+std::vector<std::string> FusedOps(const OpInfo& op_info) {
+  for (const char* attr_name : {"fused_ops", "op_names"}) {
+    auto it = op_info.attr().find(attr_name);
+    if (it != op_info.attr().end()) {
+      const auto& list = it->second.list().s();
+      return std::vector<std::string>(list.begin(), list.end());
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+OpCostProfile::OpCostProfile(const OpPerformanceList& op_performance) {
+  for (const OpPerformance& perf : op_performance.op_performance()) {
+    if (perf.compute_cost() <= 0) continue;
+    OpCosts& op_costs = costs_[OpKey(perf.op().op(), FusedOps(perf.op()))];
+    op_costs.all_shapes.Add(perf.compute_cost());
+    std::string shape_key;
+    if (perf.op().inputs_size() > 0 &&
+        ShapeKey(perf.op().inputs(0).shape(), &shape_key)) {
+      op_costs.by_shape[shape_key].Add(perf.compute_cost());
+    }
+  }
+}
+
+Status OpCostProfile::Load(const std::string& path,
+                           std::shared_ptr<const OpCostProfile>* profile) {
+  static mutex* mu = new mutex();
+  static auto* profiles =
+      new absl::flat_hash_map<std::string,
+                              std::shared_ptr<const OpCostProfile>>();
+  mutex_lock l(*mu);
+  auto it = profiles->find(path);
+  if (it != profiles->end()) {
+    *profile = it->second;
+    return Status::OK();
+  }
+  OpPerformanceList op_performance;
+  if (!ReadBinaryProto(Env::Default(), path, &op_performance).ok()) {
+    TF_RETURN_IF_ERROR(ReadTextProto(Env::Default(), path, &op_performance));
+  }
+  *profile = std::make_shared<const OpCostProfile>(op_performance);
+  VLOG(1) << "Loaded cost profile for " << (*profile)->num_ops()
+          << " ops from " << path;
+  profiles->emplace(path, *profile);
+  return Status::OK();
+}
+
+int64 OpCostProfile::ComputeCost(const Op& op) const {
+  auto it = costs_.find(OpKey(op.op, op.fused_ops));
+  if (it == costs_.end()) return -1;
+  std::string shape_key;
+  if (op.input_shape != nullptr && ShapeKey(*op.input_shape, &shape_key)) {
+    auto shape_it = it->second.by_shape.find(shape_key);
+    if (shape_it != it->second.by_shape.end()) {
+      return shape_it->second.Average();
+    }
+  }
+  return it->second.all_shapes.Average();
+}
+
+bool OpCostProfile::PredictsFusionGain(const Op& fused,
+                                       const std::vector<Op>& ops) const {
+  const int64 fused_cost = ComputeCost(fused);
+  if (fused_cost < 0) return true;
+  int64 unfused_cost = 0;
+  for (const Op& op : ops) {
+    const int64 cost = ComputeCost(op);
+    if (cost < 0) return true;
+    unfused_cost += cost;
+  }
+  VLOG(2) << "Cost of " << OpKey(fused.op, fused.fused_ops) << ": "
+          << fused_cost << "ns fused vs. " << unfused_cost << "ns unfused";
+  return fused_cost < unfused_cost;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
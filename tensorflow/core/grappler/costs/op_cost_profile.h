@@ -0,0 +1,89 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_PROFILE_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_PROFILE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Measured compute costs of ops, e.g. collected by MeasuringCostEstimator or
+// by a prior profiler session. Optimizers use the profile to apply a rewrite
+// that fuses a group of ops only if the fused op is measured to be faster on
+// the target machine.
+class OpCostProfile {
+ public:
+  // An op whose cost is looked up in the profile.
+  struct Op {
+    std::string op;
+    // Ops fused into `op`, i.e. the "fused_ops" or "op_names" attribute of
+    // fused ops. Empty for regular ops.
+    std::vector<std::string> fused_ops;
+    // Shape of the first input of the op, if known.
+    const TensorShapeProto* input_shape = nullptr;
+  };
+
+  explicit OpCostProfile(const OpPerformanceList& op_performance);
+
+  // Loads the binary or text `OpPerformanceList` stored at `path`. Profiles are
+  // cached by path, so that the file is read only once per process.
+  static Status Load(const std::string& path,
+                     std::shared_ptr<const OpCostProfile>* profile);
+
+  // Returns the average measured compute cost of `op` in nanoseconds, or -1 if
+  // the op was not profiled. Measurements for the input shape of `op` are
+  // preferred over the average for all input shapes.
+  int64 ComputeCost(const Op& op) const;
+
+  // Returns true if the profile predicts that running `fused` is faster than
+  // running `ops`, or if any of the ops was not profiled.
+  bool PredictsFusionGain(const Op& fused, const std::vector<Op>& ops) const;
+
+  // Returns the number of distinct (fused) ops in the profile.
+  int num_ops() const { return costs_.size(); }
+
+ private:
+  struct Cost {
+    int64 total_ns = 0;
+    int64 count = 0;
+
+    void Add(int64 cost_ns) {
+      total_ns += cost_ns;
+      ++count;
+    }
+    int64 Average() const { return total_ns / count; }
+  };
+
+  struct OpCosts {
+    Cost all_shapes;
+    absl::flat_hash_map<std::string, Cost> by_shape;
+  };
+
+  absl::flat_hash_map<std::string, OpCosts> costs_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_PROFILE_H_
@@ -0,0 +1,122 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+TensorShapeProto Shape(const std::vector<int64>& dims) {
+  TensorShapeProto shape;
+  for (int64 dim : dims) shape.add_dim()->set_size(dim);
+  return shape;
+}
+
+void AddOp(const string& op, const std::vector<string>& fused_ops,
+           const std::vector<int64>& input_dims, int64 compute_cost,
+           OpPerformanceList* profile) {
+  OpPerformance* perf = profile->add_op_performance();
+  perf->mutable_op()->set_op(op);
+  if (!fused_ops.empty()) {
+    auto* list = (*perf->mutable_op()->mutable_attr())["fused_ops"]
+                     .mutable_list();
+    for (const string& fused_op : fused_ops) list->add_s(fused_op);
+  }
+  *perf->mutable_op()->add_inputs()->mutable_shape() = Shape(input_dims);
+  perf->set_compute_cost(compute_cost);
+}
+
+TEST(OpCostProfileTest, ComputeCost) {
+  OpPerformanceList list;
+  AddOp("MatMul", {}, {8, 8}, 100, &list);
+  AddOp("MatMul", {}, {8, 8}, 200, &list);
+  AddOp("MatMul", {}, {16, 16}, 900, &list);
+  AddOp("_FusedMatMul", {"BiasAdd"}, {8, 8}, 120, &list);
+  OpCostProfile profile(list);
+  EXPECT_EQ(2, profile.num_ops());
+
+  const TensorShapeProto small = Shape({8, 8});
+  const TensorShapeProto other = Shape({4, 4});
+  TensorShapeProto unknown = Shape({-1, 8});
+  EXPECT_EQ(150, profile.ComputeCost({"MatMul", {}, &small}));
+  // Falls back to the average over all shapes.
+  EXPECT_EQ(400, profile.ComputeCost({"MatMul", {}, &other}));
+  EXPECT_EQ(400, profile.ComputeCost({"MatMul", {}, &unknown}));
+  EXPECT_EQ(400, profile.ComputeCost({"MatMul"}));
+  EXPECT_EQ(120, profile.ComputeCost({"_FusedMatMul", {"BiasAdd"}, &small}));
+  EXPECT_EQ(-1, profile.ComputeCost({"_FusedMatMul", {"BiasAdd", "Relu"}}));
+  EXPECT_EQ(-1, profile.ComputeCost({"Conv2D"}));
+}
+
+TEST(OpCostProfileTest, PredictsFusionGain) {
+  OpPerformanceList list;
+  AddOp("MatMul", {}, {8, 8}, 100, &list);
+  AddOp("BiasAdd", {}, {8, 8}, 10, &list);
+  AddOp("Relu", {}, {8, 8}, 10, &list);
+  AddOp("_FusedMatMul", {"BiasAdd"}, {8, 8}, 105, &list);
+  AddOp("_FusedMatMul", {"BiasAdd", "Relu"}, {8, 8}, 150, &list);
+  OpCostProfile profile(list);
+
+  const TensorShapeProto shape = Shape({8, 8});
+  const OpCostProfile::Op matmul = {"MatMul", {}, &shape};
+  const OpCostProfile::Op bias_add = {"BiasAdd", {}, &shape};
+  const OpCostProfile::Op relu = {"Relu", {}, &shape};
+  EXPECT_TRUE(profile.PredictsFusionGain({"_FusedMatMul", {"BiasAdd"}, &shape},
+                                         {matmul, bias_add}));
+  EXPECT_FALSE(
+      profile.PredictsFusionGain({"_FusedMatMul", {"BiasAdd", "Relu"}, &shape},
+                                 {matmul, bias_add, relu}));
+  // Unprofiled ops keep the default behavior.
+  EXPECT_TRUE(profile.PredictsFusionGain({"_FusedMatMul", {"BiasAdd", "Elu"}},
+                                         {matmul, bias_add, {"Elu"}}));
+  EXPECT_TRUE(profile.PredictsFusionGain({"_FusedConv2D", {"BiasAdd"}},
+                                         {{"Conv2D"}, bias_add}));
+}
+
+TEST(OpCostProfileTest, Load) {
+  OpPerformanceList list;
+  AddOp("MatMul", {}, {8, 8}, 100, &list);
+  const string path =
+      io::JoinPath(testing::TmpDir(), "op_cost_profile_test.pb");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), path, list));
+
+  std::shared_ptr<const OpCostProfile> profile;
+  TF_ASSERT_OK(OpCostProfile::Load(path, &profile));
+  EXPECT_EQ(100, profile->ComputeCost({"MatMul"}));
+  // Profiles are cached by path.
+  std::shared_ptr<const OpCostProfile> cached;
+  TF_ASSERT_OK(OpCostProfile::Load(path, &cached));
+  EXPECT_EQ(profile.get(), cached.get());
+
+  const string text_path =
+      io::JoinPath(testing::TmpDir(), "op_cost_profile_test.pbtxt");
+  TF_ASSERT_OK(WriteTextProto(Env::Default(), text_path, list));
+  TF_ASSERT_OK(OpCostProfile::Load(text_path, &profile));
+  EXPECT_EQ(100, profile->ComputeCost({"MatMul"}));
+
+  EXPECT_FALSE(
+      OpCostProfile::Load(io::JoinPath(testing::TmpDir(), "missing"), &profile)
+          .ok());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -645,9 +645,20 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
   // By default, use sum of memory_time and compute_time for execution_time.
   compute_memory_overlap_ = false;
+
+  calibration_ = OpCostCalibration::FromEnv();
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
+  Costs costs = PredictUncalibratedCosts(op_context);
+  if (calibration_ != nullptr) {
+    calibration_->Apply(op_context.op_info, &costs);
+  }
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictUncalibratedCosts(
+    const OpContext& op_context) const {
   Costs costs;
   NodeCosts node_costs;
   if (PredictNodeCosts(op_context, &node_costs).ok()) {
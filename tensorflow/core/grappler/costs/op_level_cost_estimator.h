@@ -16,10 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
 
+#include <memory>
 #include <numeric>
 
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/util/padding.h"
@@ -98,7 +100,17 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Sets the calibration applied to the predicted costs. By default, the
+  // calibration file named by TF_OP_COST_CALIBRATION_FILE is used, if any.
+  void set_calibration(std::shared_ptr<const OpCostCalibration> calibration) {
+    calibration_ = std::move(calibration);
+  }
+
  protected:
+  // Predicts the costs of the op with the analytical model only, i.e. without
+  // applying the calibration.
+  Costs PredictUncalibratedCosts(const OpContext& op_context) const;
+
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
   // input/output tensor sizes of the given op_info combined.
@@ -320,6 +332,8 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  // Measured corrections of the predicted costs; may be null.
+  std::shared_ptr<const OpCostCalibration> calibration_;
 
  private:
   friend class OpLevelCostEstimatorTest;
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 
 #include <algorithm>
+#include <cmath>
 #include <deque>
 #include <limits>
 #include <unordered_map>
@@ -228,9 +229,11 @@ void ReplaceWithNoOp(NodeDef* node, const GraphOptimizerContext& ctx) {
 
 // Graph optimizer context extension specific to ArithmeticOptimizer.
 struct ArithmeticOptimizerContext {
-  explicit ArithmeticOptimizerContext(SetVector<NodeDef*>* nodes_to_simplify)
-      : nodes_to_simplify(nodes_to_simplify) {}
+  explicit ArithmeticOptimizerContext(SetVector<NodeDef*>* nodes_to_simplify,
+                                      const OpCostProfile* cost_profile)
+      : nodes_to_simplify(nodes_to_simplify), cost_profile(cost_profile) {}
   SetVector<NodeDef*>* nodes_to_simplify;
+  const OpCostProfile* cost_profile;  // may be NULL
 };
 
 // Base class for single arithmetic optimization: e.g. Bitcast optimization,
@@ -252,6 +255,32 @@ class ArithmeticOptimizerStage : public GraphOptimizerStage<string> {
     ctx_ext_.nodes_to_simplify->PushBack(node);
   }
 
+  // Returns true if the cost profile predicts that replacing `nodes` with a
+  // `fused_op` node running `fused_ops` is faster. The first node provides the
+  // input of the fused op. Without a profile, all fusions are applied.
+  bool IsFusionProfitable(const string& fused_op,
+                          const std::vector<string>& fused_ops,
+                          const std::vector<const NodeDef*>& nodes) const {
+    if (ctx_ext_.cost_profile == nullptr) return true;
+
+    std::vector<OpCostProfile::Op> ops;
+    ops.reserve(nodes.size());
+    for (const NodeDef* node : nodes) {
+      OpCostProfile::Op op;
+      op.op = node->op();
+      const OpInfo::TensorProperties* properties;
+      if (node->input_size() > 0 &&
+          GetTensorProperties(node->input(0), &properties).ok()) {
+        op.input_shape = &properties->shape();
+      }
+      ops.push_back(std::move(op));
+    }
+    OpCostProfile::Op fused = ops.front();
+    fused.op = fused_op;
+    fused.fused_ops = fused_ops;
+    return ctx_ext_.cost_profile->PredictsFusionGain(fused, ops);
+  }
+
   // Update consumers of node to take new_input as input instead.
   Status UpdateConsumers(NodeDef* node, const string& new_input) {
     const auto consumers = ctx().node_map->GetOutputs(node->name());
@@ -1937,6 +1966,9 @@ class FuseSquaredDiffStage : public ArithmeticOptimizerStage {
       const DataType type = GetDataTypeFromAttr(*b, "T");
       if ((type == DT_COMPLEX64) || (type == DT_COMPLEX128))
         return Status::OK();
+      if (!IsFusionProfitable("SquaredDifference", {}, {b, node})) {
+        return Status::OK();
+      }
       node->set_op("Identity");
       b->set_op("SquaredDifference");
       AddToOptimizationQueue(node);
@@ -3639,13 +3671,22 @@ class UnaryOpsComposition : public ArithmeticOptimizerStage {
     // We were not able to find a chain that can be replaced.
     if (op_names.size() == 1) return Status::OK();
 
+    // Reverse the trace to get correct composition computation order.
+    std::reverse(op_names.begin(), op_names.end());
+
+    // Nodes of the chain in composition order, like `op_names`.
+    std::vector<const NodeDef*> chain;
+    for (auto it = op_nodes.rbegin(); it != op_nodes.rend(); ++it) {
+      chain.push_back(ctx().node_map->GetNode(*it));
+    }
+    if (!IsFusionProfitable("_UnaryOpsComposition", op_names, chain)) {
+      return Status::OK();
+    }
+
     // Do not add fused nodes to any other chain.
     std::for_each(op_nodes.begin(), op_nodes.end(),
                   [this](const string& name) { AddToFusedNodes(name); });
 
-    // Reverse the trace to get correct composition computation order.
-    std::reverse(op_names.begin(), op_names.end());
-
     VLOG(2) << "Fuse unary ops: root=" << root->name() << " op_names=["
             << absl::StrJoin(op_names, ", ") << "]";
 
@@ -4104,6 +4145,21 @@ class RemoveStackSliceSameAxis : public ArithmeticOptimizerStage {
 //     segment_ids = sparse_ids.indices[:, 0]
 //     result = tf.sparse.segment_<combiner>(
 //          embeddings, sparse_ids.values, segment_ids)
+//
+// More generally, when the rows fed to the reduction come from a tf.gather()
+// whose indices are not produced by tf.unique(), the gather is folded into the
+// reduction by gathering the (much smaller) index vector instead of the rows:
+//
+//     gathered_rows = tf.gather(params, ids)
+//     result = tf.sparse.segment_<combiner>(gathered_rows, idx, segment_ids)
+//
+// becomes
+//
+//     result = tf.sparse.segment_<combiner>(
+//          params, tf.gather(ids, idx), segment_ids)
+//
+// so that the [nnz, dim] intermediate is never materialized and the reduction
+// kernel accumulates rows of `params` directly into its output.
 class SimplifyEmbeddingLookupStage : public ArithmeticOptimizerStage {
  public:
   explicit SimplifyEmbeddingLookupStage(
@@ -4136,19 +4192,17 @@ class SimplifyEmbeddingLookupStage : public ArithmeticOptimizerStage {
     NodeDef* unique_node = nullptr;
     TF_RETURN_IF_ERROR(GetInputNode(gather_node->input(1), &unique_node));
     if (!IsUnique(*unique_node) || IsInPreserveSet(*unique_node) ||
-        unique_node->device() != gather_node->device())
-      return Status::OK();
-    if (unique_node->op() == "UniqueV2" && !IsAxis0(*unique_node, 1))
-      return Status::OK();
+        unique_node->device() != gather_node->device() ||
+        (unique_node->op() == "UniqueV2" && !IsAxis0(*unique_node, 1)) ||
+        ParseTensorName(reduction_node->input(1)) !=
+            TensorId(unique_node->name(), 1)) {
+      return FoldGatherIntoIndices(reduction_node, gather_node,
+                                   simplified_node_name);
+    }
 
     DataType unique_element_type;
     TF_RETURN_IF_ERROR(GetNodeAttr(*unique_node, "T", &unique_element_type));
 
-    // Input 1 (indices) of the reduction node must be output 1 of the unique
-    // node.
-    const TensorId idx_tensor = ParseTensorName(reduction_node->input(1));
-    if (idx_tensor != TensorId(unique_node->name(), 1)) return Status::OK();
-
     // Input 0 (data) of the reduction node becomes input 1 (params) of the
     // gather node.
     reduction_node->set_input(0, gather_node->input(0));
@@ -4169,6 +4223,69 @@ class SimplifyEmbeddingLookupStage : public ArithmeticOptimizerStage {
   }
 
  private:
+  // Rewrites reduction(gather(params, ids), idx, ...) into
+  // reduction(params, gather(ids, idx), ...).
+  Status FoldGatherIntoIndices(NodeDef* reduction_node, NodeDef* gather_node,
+                               string* simplified_node_name) {
+    // The gathered rows must not be needed elsewhere, otherwise the gather
+    // still runs and the rewrite only adds work.
+    if (NumNonControlOutputs(*gather_node, *ctx().node_map) != 1) {
+      return Status::OK();
+    }
+    int batch_dims = 0;
+    if (gather_node->op() == "GatherV2" &&
+        TryGetNodeAttr(*gather_node, "batch_dims", &batch_dims) &&
+        batch_dims != 0) {
+      return Status::OK();
+    }
+    // The reduction indexes the first dimension of its data, which matches
+    // the rows of `params` only if `ids` is a vector.
+    const OpInfo::TensorProperties* ids_properties;
+    if (!GetTensorProperties(gather_node->input(1), &ids_properties).ok() ||
+        ids_properties->shape().unknown_rank() ||
+        ids_properties->shape().dim_size() != 1) {
+      return Status::OK();
+    }
+
+    const NodeScopeAndName scope_and_name =
+        ParseNodeScopeAndName(reduction_node->name());
+    const string indices_node_name =
+        OptimizedNodeName(scope_and_name, "GatherIndices");
+    if (ctx().node_map->NodeExists(indices_node_name)) return Status::OK();
+
+    DataType ids_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*gather_node, "Tindices", &ids_type));
+    DataType idx_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*reduction_node, "Tidx", &idx_type));
+
+    NodeDef* indices_node = AddEmptyNode(indices_node_name);
+    indices_node->set_op("Gather");
+    indices_node->set_device(reduction_node->device());
+    indices_node->add_input(gather_node->input(1));
+    indices_node->add_input(reduction_node->input(1));
+    SetDataTypeToAttr(ids_type, "Tparams", indices_node);
+    SetDataTypeToAttr(idx_type, "Tindices", indices_node);
+    (*indices_node->mutable_attr())["validate_indices"].set_b(true);
+    ForwardControlDependencies(indices_node, {gather_node});
+    ctx().node_map->AddOutput(NodeName(gather_node->input(1)),
+                              indices_node_name);
+    ctx().node_map->AddOutput(NodeName(reduction_node->input(1)),
+                              indices_node_name);
+
+    ctx().node_map->UpdateInput(reduction_node->name(),
+                                reduction_node->input(0),
+                                gather_node->input(0));
+    reduction_node->set_input(0, gather_node->input(0));
+    ctx().node_map->UpdateInput(reduction_node->name(),
+                                reduction_node->input(1), indices_node_name);
+    reduction_node->set_input(1, indices_node_name);
+    SetDataTypeToAttr(ids_type, "Tidx", reduction_node);
+
+    AddToOptimizationQueue(indices_node);
+    *simplified_node_name = reduction_node->name();
+    return Status::OK();
+  }
+
   bool IsAxis0(const NodeDef& node, int axis_input) {
     Tensor axis_tensor;
     if (!GetTensorFromConstNode(node.input(axis_input), &axis_tensor))
@@ -4243,6 +4360,134 @@ class RemoveCastIntoSegmentReductionStage : public ArithmeticOptimizerStage {
   }
 };
 
+// Removes QuantizeV2(Dequantize(q, min, max), min, max) round trips.
+//
+// Graphs that are converted operator by operator to quantized kernels often
+// dequantize a quantized result only to quantize it again with the same range
+// for the next quantized op. In MIN_COMBINED mode with an 8- or 16-bit type
+// and a constant range that QuantizeV2 does not adjust, the round trip
+// reproduces `q` exactly, so consumers of the QuantizeV2 outputs can read `q`,
+// `min` and `max` directly and the float tensor in between is never built.
+class RemoveRedundantQuantizationStage : public ArithmeticOptimizerStage {
+ public:
+  explicit RemoveRedundantQuantizationStage(
+      const GraphOptimizerContext& ctx,
+      const ArithmeticOptimizerContext& ctx_ext)
+      : ArithmeticOptimizerStage("RemoveRedundantQuantizationStage", ctx,
+                                 ctx_ext) {}
+  ~RemoveRedundantQuantizationStage() override = default;
+
+  bool IsSupported(const NodeDef* node) const override {
+    return node->op() == "QuantizeV2";
+  }
+
+  Status TrySimplify(NodeDef* quantize_node,
+                     string* simplified_node_name) override {
+    if (IsInPreserveSet(*quantize_node)) return Status::OK();
+
+    NodeDef* dequantize_node = nullptr;
+    TF_RETURN_IF_ERROR(
+        GetInputNode(quantize_node->input(0), &dequantize_node));
+    if (dequantize_node->op() != "Dequantize" ||
+        IsInPreserveSet(*dequantize_node) ||
+        dequantize_node->device() != quantize_node->device() ||
+        !HasSameQuantizationAttrs(*dequantize_node, *quantize_node)) {
+      return Status::OK();
+    }
+
+    // Both ops must see the same range, and QuantizeV2 must use it unchanged.
+    for (int i = 1; i <= 2; ++i) {
+      if (ParseTensorName(quantize_node->input(i)) !=
+          ParseTensorName(dequantize_node->input(i))) {
+        return Status::OK();
+      }
+    }
+    if (!IsRangeKeptByQuantize(*quantize_node)) return Status::OK();
+
+    // The pipeline forwards every consumer of `quantize_node` to the tensor
+    // returned in `simplified_node_name`, so the min and max outputs have to
+    // be redirected here.
+    const std::vector<NodeDef*> consumers =
+        ctx().node_map->GetOutputsOrderedByNodeName(quantize_node->name());
+    for (NodeDef* consumer : consumers) {
+      bool uses_output = false;
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        const TensorId tensor = ParseTensorName(consumer->input(i));
+        if (tensor.node() != quantize_node->name()) continue;
+        if (tensor.index() == 1 || tensor.index() == 2) {
+          const string& range_input = dequantize_node->input(tensor.index());
+          consumer->set_input(i, range_input);
+          ctx().node_map->AddOutput(NodeName(range_input), consumer->name());
+          AddToOptimizationQueue(consumer);
+        } else {
+          uses_output = true;
+        }
+      }
+      if (!uses_output) {
+        ctx().node_map->RemoveOutput(quantize_node->name(), consumer->name());
+      }
+    }
+
+    *simplified_node_name = dequantize_node->input(0);
+    return Status::OK();
+  }
+
+ private:
+  bool HasSameQuantizationAttrs(const NodeDef& dequantize,
+                                const NodeDef& quantize) const {
+    DataType dequantize_type;
+    DataType quantize_type;
+    if (!GetNodeAttr(dequantize, "T", &dequantize_type).ok() ||
+        !GetNodeAttr(quantize, "T", &quantize_type).ok() ||
+        dequantize_type != quantize_type) {
+      return false;
+    }
+    // Wider types do not survive the float round trip exactly.
+    if (quantize_type != DT_QINT8 && quantize_type != DT_QUINT8 &&
+        quantize_type != DT_QINT16 && quantize_type != DT_QUINT16) {
+      return false;
+    }
+    DataType float_type = DT_FLOAT;
+    TryGetNodeAttr(dequantize, "dtype", &float_type);
+    if (float_type != DT_FLOAT) return false;
+
+    for (const NodeDef* node : {&dequantize, &quantize}) {
+      string mode = "MIN_COMBINED";
+      TryGetNodeAttr(*node, "mode", &mode);
+      int axis = -1;
+      TryGetNodeAttr(*node, "axis", &axis);
+      if (mode != "MIN_COMBINED" || axis != -1) return false;
+    }
+    bool dequantize_narrow_range = false;
+    bool quantize_narrow_range = false;
+    TryGetNodeAttr(dequantize, "narrow_range", &dequantize_narrow_range);
+    TryGetNodeAttr(quantize, "narrow_range", &quantize_narrow_range);
+    return dequantize_narrow_range == quantize_narrow_range;
+  }
+
+  // Mirrors the range adjustment done by the QuantizeV2 kernel: the range is
+  // widened to include zero and to span at least `ensure_minimum_range`.
+  bool IsRangeKeptByQuantize(const NodeDef& quantize) {
+    Tensor min_tensor;
+    Tensor max_tensor;
+    if (!GetTensorFromConstNode(quantize.input(1), &min_tensor) ||
+        !GetTensorFromConstNode(quantize.input(2), &max_tensor) ||
+        min_tensor.dtype() != DT_FLOAT || max_tensor.dtype() != DT_FLOAT ||
+        min_tensor.NumElements() != 1 || max_tensor.NumElements() != 1) {
+      return false;
+    }
+    const float min_range = min_tensor.flat<float>()(0);
+    const float max_range = max_tensor.flat<float>()(0);
+    float ensure_minimum_range = 0.01f;
+    TryGetNodeAttr(quantize, "ensure_minimum_range", &ensure_minimum_range);
+    const float epsilon =
+        std::max(1.0f, std::max(std::fabs(min_range), std::fabs(max_range))) *
+        ensure_minimum_range;
+    return min_range <= 0.0f && max_range >= 0.0f &&
+           max_range >= min_range + epsilon;
+  }
+};
+
 }  // namespace
 
 Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
@@ -4255,7 +4500,8 @@ Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
   const GraphOptimizerContext ctx(&nodes_to_preserve_, optimized_graph_,
                                   graph_properties_.get(), node_map_.get(),
                                   &feed_nodes_, opt_level_);
-  const ArithmeticOptimizerContext ctx_ext(&nodes_to_simplify);
+  const ArithmeticOptimizerContext ctx_ext(&nodes_to_simplify,
+                                           cost_profile_.get());
 
   // Stop pipeline after first stage returning non-empty simplified tensor
   // name.
@@ -4325,6 +4571,8 @@ Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
     pipeline.AddStage<RemoveCastIntoSegmentReductionStage>(ctx, ctx_ext);
   if (options_.fuse_squared_diff)
     pipeline.AddStage<FuseSquaredDiffStage>(ctx, ctx_ext);
+  if (options_.remove_redundant_quantization)
+    pipeline.AddStage<RemoveRedundantQuantizationStage>(ctx, ctx_ext);
 
   VLOG(1) << "Run " << pipeline.NumStages() << " arithmetic optimizer stages: "
           << absl::StrJoin(pipeline.StageNames(), ", ");
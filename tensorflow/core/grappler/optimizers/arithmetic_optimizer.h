@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
 
+#include <memory>
 #include <unordered_set>
 
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
@@ -31,15 +33,22 @@ constexpr char kArithmeticOptimizer[] = "ArithmeticOptimizer";
 
 // Optimize TF computations by reducing the arithmetic complexity required to
 // run a model.
+//
+// If `cost_profile` is not null, rewrites that fuse several ops into one (e.g.
+// `_UnaryOpsComposition`) are applied only if the profile predicts that the
+// fused op is faster.
 class ArithmeticOptimizer : public GraphOptimizer {
  public:
   ArithmeticOptimizer()
       : opt_level_(RewriterConfig::ON),
         options_(ArithmeticOptimizerOptions::Default(RewriterConfig::ON)) {}
 
-  explicit ArithmeticOptimizer(RewriterConfig::Toggle opt_level)
+  explicit ArithmeticOptimizer(
+      RewriterConfig::Toggle opt_level,
+      std::shared_ptr<const OpCostProfile> cost_profile = nullptr)
       : opt_level_(opt_level),
-        options_(ArithmeticOptimizerOptions::Default(opt_level)) {}
+        options_(ArithmeticOptimizerOptions::Default(opt_level)),
+        cost_profile_(std::move(cost_profile)) {}
 
   ~ArithmeticOptimizer() override {}
 
@@ -91,6 +100,7 @@ class ArithmeticOptimizer : public GraphOptimizer {
     bool simplify_aggregation = true;
     bool simplify_embedding_lookup = true;
     bool remove_cast_into_segment_reduction = true;
+    bool remove_redundant_quantization = true;
 
     // Choose which arithmetic optimizer stages will be enabled for a given
     // optimization level by default.
@@ -134,6 +144,7 @@ class ArithmeticOptimizer : public GraphOptimizer {
 
   RewriterConfig::Toggle opt_level_;
   ArithmeticOptimizerOptions options_;
+  std::shared_ptr<const OpCostProfile> cost_profile_;
 
   bool fetch_nodes_known_ = false;
   std::unordered_set<string> nodes_to_preserve_;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer_test_utils.h"
@@ -3059,6 +3060,43 @@ TEST_F(ArithmeticOptimizerTest, FuseSquaredDiff) {
   }
 }
 
+TEST_F(ArithmeticOptimizerTest, FuseSquaredDiffGuidedByCostProfile) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {1, 2});
+  Output y = ops::Const(s.WithOpName("y"), {3.0f, 4.0f}, {1, 2});
+  Output sub_x_y = ops::Sub(s.WithOpName("sub_x_y"), x, y);
+  Output square_sub_x_y = ops::Square(s.WithOpName("output"), sub_x_y);
+
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  const auto sub_op = [&](int64 squared_difference_cost) -> string {
+    OpPerformanceList list;
+    for (const auto& op_cost :
+         std::vector<std::pair<string, int64>>{
+             {"Sub", 10},
+             {"Square", 10},
+             {"SquaredDifference", squared_difference_cost}}) {
+      OpPerformance* perf = list.add_op_performance();
+      perf->mutable_op()->set_op(op_cost.first);
+      perf->set_compute_cost(op_cost.second);
+    }
+    GraphDef output;
+    ArithmeticOptimizer optimizer(RewriterConfig::ON,
+                                  std::make_shared<const OpCostProfile>(list));
+    EnableOnlyFuseSquaredDiff(&optimizer);
+    OptimizeAndPrune(&optimizer, &item, &output);
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "sub_x_y") return node.op();
+    }
+    return "";
+  };
+
+  EXPECT_EQ("SquaredDifference", sub_op(/*squared_difference_cost=*/15));
+  EXPECT_EQ("Sub", sub_op(/*squared_difference_cost=*/30));
+}
+
 TEST_F(ArithmeticOptimizerTest, DoNotFuseSquaredDiffFetchNode) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {1, 2});
@@ -4669,6 +4707,56 @@ TEST_F(ArithmeticOptimizerTest, SimplifyEmbeddingLookup) {
   }
 }
 
+TEST_F(ArithmeticOptimizerTest, SimplifyEmbeddingLookupWithoutUnique) {
+  for (DataType ids_type : {DT_INT32, DT_INT64}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    Output embeddings =
+        ops::Const(s.WithOpName("embeddings"),
+                   {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f}, {3, 2});
+    Output ids = ops::Cast(s.WithOpName("ids"),
+                           ops::Const(s.WithOpName("ids_int32"), {2, 0, 1, 2}),
+                           ids_type);
+    Output idx = ops::Const(s.WithOpName("idx"), {0, 1, 3, 2, 3, 0, 1});
+    Output segment_ids =
+        ops::Const(s.WithOpName("segment_ids"), {0, 1, 1, 2, 2, 2, 2});
+    Output gathered_rows =
+        ops::Gather(s.WithOpName("gathered_rows"), embeddings, ids);
+    Output result = ops::SparseSegmentMean(s.WithOpName("result"),
+                                           gathered_rows, idx, segment_ids);
+    Output id = ops::Identity(s.WithOpName("id"), result);
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    item.fetch = {"id"};
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+    ASSERT_EQ(tensors_expected.size(), 1);
+
+    GraphDef output;
+    ArithmeticOptimizer optimizer;
+    EnableOnlySimplifyEmbeddingLookup(&optimizer);
+    OptimizeAndPrune(&optimizer, &item, &output);
+
+    int num_gathers = 0;
+    for (const auto& node : output.node()) {
+      if (node.name() == "result") {
+        EXPECT_EQ(node.input(0), "embeddings");
+        EXPECT_NE(node.input(1), "idx");
+        EXPECT_EQ(node.attr().at("Tidx").type(), ids_type);
+      }
+      if (node.op() == "Gather") {
+        ++num_gathers;
+        EXPECT_EQ(node.input(0), "ids");
+        EXPECT_EQ(node.input(1), "idx");
+      }
+    }
+    EXPECT_EQ(num_gathers, 1);
+
+    auto tensors = EvaluateNodes(output, item.fetch);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+}
+
 TEST_F(ArithmeticOptimizerTest, RemoveCastIntoSegmentReduction) {
   for (DataType indices_type : {DT_INT32, DT_INT64}) {
     for (DataType segment_ids_type : {DT_INT32, DT_INT64}) {
@@ -4713,5 +4801,85 @@ TEST_F(ArithmeticOptimizerTest, RemoveCastIntoSegmentReduction) {
   }
 }
 
+TEST_F(ArithmeticOptimizerTest, RemoveRedundantQuantization) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {-1.0f, 0.0f, 0.5f, 2.0f}, {4});
+  Output min_range = ops::Const(s.WithOpName("min_range"), -1.0f);
+  Output max_range = ops::Const(s.WithOpName("max_range"), 2.0f);
+  auto quantize =
+      ops::QuantizeV2(s.WithOpName("quantize"), x, min_range, max_range,
+                      DT_QUINT8);
+  Output dequantize = ops::Dequantize(s.WithOpName("dequantize"),
+                                      quantize.output, min_range, max_range);
+  auto requantize =
+      ops::QuantizeV2(s.WithOpName("requantize"), dequantize, min_range,
+                      max_range, DT_QUINT8);
+  Output result = ops::Dequantize(s.WithOpName("result"), requantize.output,
+                                  requantize.output_min,
+                                  requantize.output_max);
+  Output id = ops::Identity(s.WithOpName("id"), result);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"id"};
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyRemoveRedundantQuantization(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  for (const auto& node : output.node()) {
+    if (node.name() == "result") {
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "quantize");
+      EXPECT_EQ(node.input(1), "min_range");
+      EXPECT_EQ(node.input(2), "max_range");
+    }
+    EXPECT_NE(node.name(), "requantize");
+    EXPECT_NE(node.name(), "dequantize");
+  }
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepQuantizationWithAdjustedRange) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f, 3.0f, 4.0f}, {4});
+  // QuantizeV2 widens a range that excludes zero, so the round trip changes
+  // the quantized values.
+  Output min_range = ops::Const(s.WithOpName("min_range"), 1.0f);
+  Output max_range = ops::Const(s.WithOpName("max_range"), 4.0f);
+  auto quantize =
+      ops::QuantizeV2(s.WithOpName("quantize"), x, min_range, max_range,
+                      DT_QUINT8);
+  Output dequantize = ops::Dequantize(s.WithOpName("dequantize"),
+                                      quantize.output, min_range, max_range);
+  auto requantize =
+      ops::QuantizeV2(s.WithOpName("requantize"), dequantize, min_range,
+                      max_range, DT_QUINT8);
+  Output result = ops::Dequantize(s.WithOpName("result"), requantize.output,
+                                  requantize.output_min,
+                                  requantize.output_max);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"result"};
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyRemoveRedundantQuantization(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  bool found_requantize = false;
+  for (const auto& node : output.node()) {
+    if (node.name() == "requantize") found_requantize = true;
+  }
+  EXPECT_TRUE(found_requantize);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
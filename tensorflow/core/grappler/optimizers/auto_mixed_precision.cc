@@ -26,6 +26,8 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -972,9 +974,10 @@ class AutoMixedPrecisionImpl {
  public:
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
-                         GraphDef* graph, string id,
+                         const GrapplerItem& item, GraphDef* graph, string id,
                          AutoMixedPrecisionMode mode)
-      : virtual_placer_(cluster->GetDevices()),
+      : item_(item),
+        virtual_placer_(cluster->GetDevices()),
         nodes_to_preserve_(nodes_to_preserve),
         graph_(graph),
         function_library_(OpRegistry::Global(), graph->library()),
@@ -1036,10 +1039,21 @@ class AutoMixedPrecisionImpl {
       absl::flat_hash_set<int>* allow_set) const;
   void MakeCastsAllowIfAllOutputsAllow(
       absl::flat_hash_set<int>* allow_set) const;
+  Costs::NanoSeconds PredictExecutionTime(const GraphProperties& properties,
+                                          const OpLevelCostEstimator& estimator,
+                                          const NodeDef& node,
+                                          bool* inaccurate) const;
+  Costs::NanoSeconds PredictCastTime(
+      const OpInfo::TensorProperties& f32_tensor,
+      const OpLevelCostEstimator& estimator, const NodeDef& node, bool to_f16,
+      bool* inaccurate) const;
+  void RemoveUnprofitableAllowClusters(
+      absl::flat_hash_set<int>* allow_set) const;
   NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_f16,
                         const string& device) const;
   Status ChangeTypeAttrsAndAddCasts(const absl::flat_hash_set<int>& allow_set);
 
+  const GrapplerItem& item_;
   VirtualPlacer virtual_placer_;
   std::unordered_set<string> nodes_to_preserve_;
   GraphDef* graph_;
@@ -1402,6 +1416,13 @@ Status AutoMixedPrecisionImpl::Optimize() {
   RemoveAllowsetWithFp32(&allow_set);
   VLOG(2) << "Finished pass 5";
 
+  if (mode_ == AutoMixedPrecisionMode::MKL && !ShouldIgnorePerformance()) {
+    VLOG(2) << "Beginning pass 6 to remove allow clusters whose predicted "
+               "speedup does not cover the cost of their casts";
+    RemoveUnprofitableAllowClusters(&allow_set);
+    VLOG(2) << "Finished pass 6";
+  }
+
   VLOG(2) << "Forcing color match between data structure ops";
   for (const auto& cluster : tensor_list_clusters) {
     ForceColorMatchBetweenTensorListOps(cluster, &allow_set, &deny_set);
@@ -1739,6 +1760,142 @@ void AutoMixedPrecisionImpl::RemoveAllowsetWithFp32(
   }
 }
 
+Costs::NanoSeconds AutoMixedPrecisionImpl::PredictExecutionTime(
+    const GraphProperties& properties, const OpLevelCostEstimator& estimator,
+    const NodeDef& node, bool* inaccurate) const {
+  OpContext op_context;
+  op_context.op_info.set_op(node.op());
+  *op_context.op_info.mutable_attr() = node.attr();
+  for (const auto& input : properties.GetInputProperties(node.name())) {
+    *op_context.op_info.add_inputs() = input;
+  }
+  for (const auto& output : properties.GetOutputProperties(node.name())) {
+    *op_context.op_info.add_outputs() = output;
+  }
+  *op_context.op_info.mutable_device() = virtual_placer_.get_device(node);
+  const Costs costs = estimator.PredictCosts(op_context);
+  *inaccurate |= costs.inaccurate;
+  return costs.execution_time;
+}
+
+Costs::NanoSeconds AutoMixedPrecisionImpl::PredictCastTime(
+    const OpInfo::TensorProperties& f32_tensor,
+    const OpLevelCostEstimator& estimator, const NodeDef& node, bool to_f16,
+    bool* inaccurate) const {
+  OpInfo::TensorProperties f16_tensor = f32_tensor;
+  f16_tensor.set_dtype(target_dtype_);
+  OpContext op_context;
+  op_context.op_info.set_op("Cast");
+  auto& attr = *op_context.op_info.mutable_attr();
+  attr["SrcT"].set_type(to_f16 ? DT_FLOAT : target_dtype_);
+  attr["DstT"].set_type(to_f16 ? target_dtype_ : DT_FLOAT);
+  *op_context.op_info.add_inputs() = to_f16 ? f32_tensor : f16_tensor;
+  *op_context.op_info.add_outputs() = to_f16 ? f16_tensor : f32_tensor;
+  *op_context.op_info.mutable_device() = virtual_placer_.get_device(node);
+  const Costs costs = estimator.PredictCosts(op_context);
+  *inaccurate |= costs.inaccurate;
+  return costs.execution_time;
+}
+
+// The allow/deny lists assume that converting an op to bf16 always pays off.
+// On the CPU this does not hold for clusters of small ops, where the Casts
+// around the cluster can cost more than the conversion saves. This pass
+// removes each connected cluster of allow nodes whose predicted savings do not
+// exceed the predicted cost of the Casts at its boundary. Clusters containing
+// ops with unknown shapes or costs are kept, since no prediction is possible.
+void AutoMixedPrecisionImpl::RemoveUnprofitableAllowClusters(
+    absl::flat_hash_set<int>* allow_set) const {
+  GraphProperties properties(item_);
+  Status status = properties.InferStatically(/*assume_valid_feeds=*/false);
+  if (!status.ok()) {
+    VLOG(1) << "Skipping the cost-based pass, shape inference failed: "
+            << status;
+    return;
+  }
+  OpLevelCostEstimator estimator;
+
+  // bf16 halves the memory traffic of the converted ops, and CPUs with
+  // AVX512-BF16 or AMX at least double their multiply-accumulate throughput.
+  // Both are approximated by halving the execution time of the cluster.
+  constexpr double kBf16SavedFraction = 0.5;
+
+  absl::flat_hash_set<int> visited;
+  for (int root_idx = 0; root_idx < graph_type_view_.num_nodes(); ++root_idx) {
+    if (!allow_set->count(root_idx) || visited.count(root_idx)) continue;
+    std::vector<int> cluster;
+    DfsTypeTraversal(graph_type_view_, {graph_type_view_.GetNode(root_idx)},
+                     TypeTraversalDirection::kFollowInputsAndOutputs,
+                     DfsTypePredicates::Enter([&](int idx) -> bool {
+                       return allow_set->count(idx) && !visited.count(idx);
+                     }),
+                     DfsTypeCallbacks::PreOrder([&](int idx) {
+                       visited.insert(idx);
+                       cluster.push_back(idx);
+                     }));
+
+    absl::flat_hash_set<const NodeDef*> cluster_nodes;
+    for (int idx : cluster) {
+      cluster_nodes.insert(graph_type_view_.GetNode(idx)->node);
+    }
+
+    bool inaccurate = false;
+    double saved_ns = 0;
+    double cast_ns = 0;
+    for (const NodeDef* node : cluster_nodes) {
+      saved_ns += kBf16SavedFraction *
+                  PredictExecutionTime(properties, estimator, *node,
+                                       &inaccurate)
+                      .count();
+
+      // Casts to f16 of the float32 inputs produced outside of the cluster.
+      const auto& input_props = properties.GetInputProperties(node->name());
+      for (int i = 0; i < node->input_size(); ++i) {
+        if (IsControlInput(node->input(i))) break;
+        if (i >= input_props.size() || input_props[i].dtype() != DT_FLOAT) {
+          continue;
+        }
+        const NodeDef* fanin =
+            graph_view_.GetNode(ParseTensorName(node->input(i)).node());
+        if (fanin != nullptr && !cluster_nodes.count(fanin)) {
+          cast_ns += PredictCastTime(input_props[i], estimator, *node,
+                                     /*to_f16=*/true, &inaccurate)
+                         .count();
+        }
+      }
+
+      // Casts back to float32 of the outputs consumed outside of the cluster.
+      const auto& output_props = properties.GetOutputProperties(node->name());
+      for (int port = 0; port < output_props.size(); ++port) {
+        if (output_props[port].dtype() != DT_FLOAT) continue;
+        bool escapes_cluster = false;
+        for (const auto& input :
+             graph_view_.GetFanout(GraphView::OutputPort(node, port))) {
+          escapes_cluster |= !cluster_nodes.count(input.node);
+        }
+        if (escapes_cluster) {
+          cast_ns += PredictCastTime(output_props[port], estimator, *node,
+                                     /*to_f16=*/false, &inaccurate)
+                         .count();
+        }
+      }
+    }
+
+    if (inaccurate || saved_ns > cast_ns) continue;
+    VLOG(1) << "Removing cluster of " << cluster_nodes.size()
+            << " nodes from the allow set: predicted savings of " << saved_ns
+            << "ns do not cover casts costing " << cast_ns << "ns";
+    for (int idx : cluster) {
+      allow_set->erase(idx);
+      if (VLOG_IS_ON(2)) {
+        const NodeTypeId& item = *graph_type_view_.GetNode(idx);
+        VLOG(2) << "UnPainting type " << item.type_attr.DebugString()
+                << " of node " << item.node->name() << " ALLOW because the "
+                << "cluster is not expected to get faster";
+      }
+    }
+  }
+}
+
 // Forces NextIteration nodes and their output Merge node(s) to have the same
 // color. Specifically, it removes them all from allow_set if any of the Merge
 // nodes is not in allow_set, otherwise it adds the NextIteration node to
@@ -2028,8 +2185,8 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   // Optimize the output graph in-place.
-  AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id, mode_);
+  AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), item,
+                                   output, item.id, mode_);
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
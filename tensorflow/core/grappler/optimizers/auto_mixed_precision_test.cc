@@ -1368,6 +1368,30 @@ TEST_F(AutoMixedPrecisionMklTest, TensorListSetGet) {
   }
 }
 
+TEST_F(AutoMixedPrecisionMklTest, UnprofitableClusterIsNotConverted) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  // A matrix-vector product does too little work per element to amortize the
+  // casts of its inputs.
+  Output input1 = ops::Const(s.WithOpName("input1"), 1.f / 32, {1, 4096});
+  Output input2 = ops::Const(s.WithOpName("input2"), 1.f / 32, {4096, 1});
+  Output allow1 = ops::MatMul(s.WithOpName("allow1"), input1, input2);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), allow1);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::MKL};
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  EXPECT_EQ(output.node_size(), item.graph.node_size());
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_FLOAT);
+}
+
 #endif  // INTEL_MKL
 
 }  // namespace
@@ -23,9 +23,12 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -148,7 +151,60 @@ bool UniqueNodes::SameNode(const NodeDef& node1, const NodeDef& node2) const {
   return true;
 }
 
-bool CommonSubgraphElimination::CanDedup(const NodeDef& node) const {
+namespace {
+
+// Returns the name of the function called by the node, or an empty string if
+// the node is not a function call.
+string CalledFunctionName(const FunctionLibraryDefinition& function_library,
+                          const NodeDef& node) {
+  if (IsPartitionedCall(node) || IsStatefulPartitionedCall(node)) {
+    const AttrValue* f = AttrSlice(node).Find("f");
+    return f != nullptr ? f->func().name() : "";
+  }
+  return function_library.Find(node.op()) != nullptr ? node.op() : "";
+}
+
+}  // namespace
+
+bool CommonSubgraphElimination::IsFreeOfSideEffectFunction(
+    const string& function_name) {
+  auto it = side_effect_free_functions_.find(function_name);
+  if (it != side_effect_free_functions_.end()) return it->second;
+
+  const FunctionDef* fdef = function_library_->Find(function_name);
+  if (fdef == nullptr) return false;
+  // Recursive functions are conservatively considered to have side effects.
+  side_effect_free_functions_[function_name] = false;
+
+  const auto is_free_of_side_effect_attr = [this](const AttrValue& attr) {
+    if (attr.has_func()) return IsFreeOfSideEffectFunction(attr.func().name());
+    for (const NameAttrList& func : attr.list().func()) {
+      if (!IsFreeOfSideEffectFunction(func.name())) return false;
+    }
+    return true;
+  };
+
+  for (const NodeDef& node : fdef->node_def()) {
+    for (const auto& attr : node.attr()) {
+      if (!is_free_of_side_effect_attr(attr.second)) return false;
+    }
+    if (IsPartitionedCall(node) || IsStatefulPartitionedCall(node) ||
+        IsAssert(node) || IsPrint(node)) {
+      // Function calls were checked through their "f" attribute above.
+      continue;
+    }
+    if (function_library_->Find(node.op()) != nullptr) {
+      if (!IsFreeOfSideEffectFunction(node.op())) return false;
+    } else if (!IsFreeOfSideEffect(node)) {
+      return false;
+    }
+  }
+
+  side_effect_free_functions_[function_name] = true;
+  return true;
+}
+
+bool CommonSubgraphElimination::CanDedup(const NodeDef& node) {
   if (nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
     return false;
   }
@@ -162,6 +218,13 @@ bool CommonSubgraphElimination::CanDedup(const NodeDef& node) const {
   if (IsAssert(node) || IsPrint(node)) {
     return true;
   }
+  // Function calls (including StatefulPartitionedCall, which is always marked
+  // as stateful) can be deduped iff the called function body is free of side
+  // effects.
+  const string function_name = CalledFunctionName(*function_library_, node);
+  if (!function_name.empty()) {
+    return IsFreeOfSideEffectFunction(function_name);
+  }
   return IsFreeOfSideEffect(node);
 }
 
@@ -273,6 +336,9 @@ Status CommonSubgraphElimination::Optimize(Cluster* /*cluster*/,
   // Set up helper data structures.
   nodes_to_preserve_ = item.NodesToPreserve();
   fetch_nodes_known_ = !item.fetch.empty();
+  function_library_ = absl::make_unique<FunctionLibraryDefinition>(
+      OpRegistry::Global(), item.graph.library());
+  side_effect_free_functions_.clear();
   *optimized_graph = item.graph;
 
   // Perform topological sort on the graph in order to help DedupComputations
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COMMON_SUBGRAPH_ELIMINATION_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COMMON_SUBGRAPH_ELIMINATION_H_
 
+#include <memory>
 #include <unordered_set>
 
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
@@ -56,7 +59,11 @@ class CommonSubgraphElimination : public GraphOptimizer {
   friend class CommonSubgraphEliminationTest;
 
   // Returns true if it is safe to dedup node from the graph.
-  bool CanDedup(const NodeDef& node) const;
+  bool CanDedup(const NodeDef& node);
+
+  // Returns true if the function, and all the functions it calls, are free of
+  // side effects, so that calls with identical inputs can be deduped.
+  bool IsFreeOfSideEffectFunction(const string& function_name);
 
   // Dedup redundant nodes in the graph.
   Status DedupComputations(GraphDef* optimized_graph);
@@ -65,6 +72,8 @@ class CommonSubgraphElimination : public GraphOptimizer {
 
   bool fetch_nodes_known_ = false;
   std::unordered_set<string> nodes_to_preserve_;
+  std::unique_ptr<FunctionLibraryDefinition> function_library_;
+  absl::flat_hash_map<string, bool> side_effect_free_functions_;
 };
 
 }  // end namespace grappler
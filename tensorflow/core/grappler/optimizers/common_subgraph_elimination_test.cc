@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -174,5 +175,60 @@ TEST_F(CommonSubgraphEliminationTest, OpDedupCommutative) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(CommonSubgraphEliminationTest, OpDedupFunctionCalls) {
+  using test::function::NDef;
+
+  FunctionDef x_times_two = test::function::XTimesTwo();
+  FunctionDef random_uniform = test::function::RandomUniform();
+
+  const auto call = [](const string& name, const string& function,
+                       DataType dtype, DataType output_dtype) {
+    AttrValue f;
+    f.mutable_func()->set_name(function);
+    (*f.mutable_func()->mutable_attr())["T"].set_type(dtype);
+    return NDef(name, "StatefulPartitionedCall", {"x"},
+                {{"f", f},
+                 {"Tin", DataTypeSlice{dtype}},
+                 {"Tout", DataTypeSlice{output_dtype}}},
+                "/device:CPU:0");
+  };
+
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, "/device:CPU:0"),
+       call("twice1", "XTimesTwo", DT_FLOAT, DT_FLOAT),
+       call("twice2", "XTimesTwo", DT_FLOAT, DT_FLOAT),
+       call("random1", "RandomUniform", DT_FLOAT, DT_INT64),
+       call("random2", "RandomUniform", DT_FLOAT, DT_INT64),
+       NDef("add", "Add", {"twice1", "twice2"}, {{"T", DT_FLOAT}},
+            "/device:CPU:0"),
+       NDef("sub", "Sub", {"random1", "random2"}, {{"T", DT_INT64}},
+            "/device:CPU:0")},
+      {x_times_two, random_uniform});
+  item.fetch = {"add", "sub"};
+
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+
+  // Calls to a side effect free function are deduped.
+  EXPECT_EQ(node_map.GetNode("twice2"), nullptr);
+  const NodeDef* add = node_map.GetNode("add");
+  ASSERT_NE(add, nullptr);
+  ASSERT_EQ(add->input_size(), 2);
+  EXPECT_EQ(add->input(0), "twice1");
+  EXPECT_EQ(add->input(1), "twice1");
+
+  // Calls to a function with stateful ops are preserved.
+  EXPECT_NE(node_map.GetNode("random1"), nullptr);
+  EXPECT_NE(node_map.GetNode("random2"), nullptr);
+  const NodeDef* sub = node_map.GetNode("sub");
+  ASSERT_NE(sub, nullptr);
+  ASSERT_EQ(sub->input_size(), 2);
+  EXPECT_EQ(sub->input(0), "random1");
+  EXPECT_EQ(sub->input(1), "random2");
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
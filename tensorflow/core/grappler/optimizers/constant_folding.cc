@@ -44,15 +44,19 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/bcast.h"
+#include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 
 namespace tensorflow {
@@ -61,6 +65,8 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 
 // We only fold/materialize constants smaller than 100kB.
 const int64 kMaxConstantSize = 100 * 1024;
+// Folded values from the constant folding cache are memory-mapped from 64kB on.
+const int64 kMinImmutableConstSize = 64 * 1024;
 
 namespace {
 template <typename T>
@@ -184,17 +190,110 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
   }
 }
 
+// Returns the key of the folded values of `node` in the constant folding
+// cache. It covers everything the values depend on: the op and attributes of
+// the node, its input values, and the TensorFlow version that evaluates it.
+string ConstantFoldingCacheKey(const NodeDef& node,
+                               const TensorVector& inputs) {
+  NodeDef key_node;
+  key_node.set_op(node.op());
+  *key_node.mutable_attr() = node.attr();
+  uint64 fingerprint = FingerprintCat64(Fingerprint64(TF_VERSION_STRING),
+                                        DeterministicProtoHash64(key_node));
+  for (const TensorValue& input : inputs) {
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(strings::StrCat(
+                         DataTypeString(input->dtype()),
+                         input->shape().DebugString())));
+    if (DataTypeCanUseMemcpy(input->dtype())) {
+      fingerprint =
+          FingerprintCat64(fingerprint, Fingerprint64(input->tensor_data()));
+    } else {
+      TensorProto proto;
+      input->AsProtoTensorContent(&proto);
+      fingerprint =
+          FingerprintCat64(fingerprint, DeterministicProtoHash64(proto));
+    }
+  }
+  return strings::FpToString(fingerprint);
+}
+
+string ConstantFoldingCacheDataPath(const string& cache_dir, const string& key,
+                                    int output) {
+  return io::JoinPath(cache_dir, strings::StrCat(key, "-", output, ".data"));
+}
+
+// Writes `path` with `write_fn` through a temporary file, so that concurrent
+// readers of the cache never see a partially written file.
+template <typename WriteFn>
+Status WriteConstantFoldingCacheFile(Env* env, const string& path,
+                                     WriteFn write_fn) {
+  string temp_path = path;
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  Status s = write_fn(temp_path);
+  if (s.ok()) {
+    s = env->RenameFile(temp_path, path);
+  }
+  if (!s.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+  return s;
+}
+
+// Writes the folded values `outputs` to the constant folding cache entry
+// `key`. The index `<key>.index` holds the dtype and shape of each output,
+// with DT_INVALID for dead outputs. The raw data of each output of a POD type
+// goes to its own `<key>-<output>.data` file so that it can be memory-mapped,
+// and the values of the other outputs are stored in the index.
+Status WriteConstantFoldingCacheEntry(Env* env, const string& cache_dir,
+                                      const string& key,
+                                      const TensorVector& outputs,
+                                      AttrValue::ListValue* index) {
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(cache_dir));
+  index->Clear();
+  for (int i = 0; i < outputs.size(); ++i) {
+    TensorProto* output_proto = index->add_tensor();
+    const Tensor* output = outputs[i].tensor;
+    if (output == nullptr) {
+      output_proto->set_dtype(DT_INVALID);
+      continue;
+    }
+    if (!DataTypeCanUseMemcpy(output->dtype())) {
+      output->AsProtoTensorContent(output_proto);
+      continue;
+    }
+    output_proto->set_dtype(output->dtype());
+    output->shape().AsProto(output_proto->mutable_tensor_shape());
+    TF_RETURN_IF_ERROR(WriteConstantFoldingCacheFile(
+        env, ConstantFoldingCacheDataPath(cache_dir, key, i),
+        [env, output](const string& path) {
+          return WriteStringToFile(env, path, output->tensor_data());
+        }));
+  }
+  // The index is written last: an entry is complete once it exists.
+  return WriteConstantFoldingCacheFile(
+      env, io::JoinPath(cache_dir, strings::StrCat(key, ".index")),
+      [env, index](const string& path) {
+        return WriteBinaryProto(env, path, *index);
+      });
+}
+
 }  // namespace
 
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
                                  DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_emulation)
+                                 bool fold_quantization_emulation,
+                                 const string& cache_dir)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
       disable_compressed_tensor_optimization_(
           disable_compressed_tensor_optimization),
-      fold_quantization_emulation_(fold_quantization_emulation) {
+      fold_quantization_emulation_(fold_quantization_emulation),
+      cache_dir_(cache_dir) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -1017,7 +1116,9 @@ bool ConstantFolding::IsFoldableUncached(
       if (output_shape.IsFullyDefined()) {
         const int64 num_bytes =
             output_shape.num_elements() * DataTypeSize(output_prop.dtype());
-        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize) {
+        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize &&
+            !(CanUseImmutableConst(node) &&
+              DataTypeCanUseMemcpy(output_prop.dtype()))) {
           // Do not fold nodes if the in-memory size of output is too large.
           // Notice that this is not exactly the same check used in
           // CreateNodeDef() where the actual encoded size is checked.
@@ -1033,7 +1134,7 @@ bool ConstantFolding::IsFoldableUncached(
 bool ConstantFolding::MaybeFoldable(const NodeDef& node,
                                     const GraphProperties* properties) const {
   // Skip constants, they're already folded
-  if (IsConstant(node)) {
+  if (IsConstant(node) || IsImmutableConst(node)) {
     return false;
   }
   // Don't fold stateful ops such as TruncatedNormal.
@@ -1358,6 +1459,11 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     total_inputs_size += value->TotalBytes();
   }
 
+  if (!cache_dir_.empty()) {
+    return EvaluateOneFoldableCached(node, inputs, total_inputs_size, outputs,
+                                     result_too_large);
+  }
+
   TF_RETURN_IF_ERROR(EvaluateNode(node, inputs, &output_tensors));
   if (output_tensors.empty()) {
     return Status(error::INVALID_ARGUMENT, "Expected at least one output.");
@@ -1385,6 +1491,101 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
   return Status::OK();
 }
 
+bool ConstantFolding::CanUseImmutableConst(const NodeDef& node) const {
+  if (cache_dir_.empty()) {
+    return false;
+  }
+  // ImmutableConst only has a CPU kernel.
+  DeviceNameUtils::ParsedName parsed_name;
+  return node.device().empty() ||
+         (DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+          (!parsed_name.has_type || parsed_name.type == DEVICE_CPU));
+}
+
+Status ConstantFolding::EvaluateOneFoldableCached(
+    const NodeDef& node, const TensorVector& inputs, size_t total_inputs_size,
+    std::vector<NodeDef>* outputs, bool* result_too_large) {
+  Env* env = Env::Default();
+  const string key = ConstantFoldingCacheKey(node, inputs);
+  AttrValue::ListValue index;
+  Status s = ReadBinaryProto(
+      env, io::JoinPath(cache_dir_, strings::StrCat(key, ".index")), &index);
+  if (s.ok()) {
+    VLOG(2) << "Constant folding cache hit for " << node.name() << ": " << key;
+  } else {
+    TensorVector output_tensors;
+    auto output_cleanup = gtl::MakeCleanup([&output_tensors] {
+      for (const auto& output : output_tensors) {
+        delete output.tensor;
+      }
+    });
+    TF_RETURN_IF_ERROR(EvaluateNode(node, inputs, &output_tensors));
+    if (output_tensors.empty()) {
+      return Status(error::INVALID_ARGUMENT, "Expected at least one output.");
+    }
+    TF_RETURN_IF_ERROR(WriteConstantFoldingCacheEntry(env, cache_dir_, key,
+                                                      output_tensors, &index));
+  }
+
+  outputs->resize(index.tensor_size());
+  for (int i = 0; i < index.tensor_size(); ++i) {
+    const TensorProto& output_proto = index.tensor(i);
+    if (output_proto.dtype() == DT_INVALID) {
+      // Dead output.
+      outputs->at(i) = NodeDef();
+      continue;
+    }
+    string node_name = OptimizedNodeName(node, "-folded");
+    if (index.tensor_size() > 1) {
+      node_name = strings::StrCat(node_name, "-", i);
+    }
+    Tensor value(output_proto.dtype(), output_proto.tensor_shape());
+    if (!DataTypeCanUseMemcpy(value.dtype())) {
+      if (!value.FromProto(output_proto)) {
+        return errors::DataLoss("Invalid constant folding cache entry ", key);
+      }
+    } else {
+      const string data_path = ConstantFoldingCacheDataPath(cache_dir_, key, i);
+      if (value.TotalBytes() >= kMinImmutableConstSize &&
+          CanUseImmutableConst(node)) {
+        // The ImmutableConst kernel maps the data at run time.
+        NodeDef* immutable_const = &outputs->at(i);
+        immutable_const->set_name(node_name);
+        immutable_const->set_op("ImmutableConst");
+        AttrValue attr_type;
+        attr_type.set_type(value.dtype());
+        immutable_const->mutable_attr()->insert({"dtype", attr_type});
+        AttrValue attr_shape;
+        value.shape().AsProto(attr_shape.mutable_shape());
+        immutable_const->mutable_attr()->insert({"shape", attr_shape});
+        AttrValue attr_region;
+        attr_region.set_s(data_path);
+        immutable_const->mutable_attr()->insert(
+            {"memory_region_name", attr_region});
+        continue;
+      }
+      if (value.TotalBytes() > 0) {
+        std::unique_ptr<ReadOnlyMemoryRegion> region;
+        TF_RETURN_IF_ERROR(
+            env->NewReadOnlyMemoryRegionFromFile(data_path, &region));
+        if (region->length() != value.TotalBytes()) {
+          return errors::DataLoss("Constant folding cache file ", data_path,
+                                  " has ", region->length(),
+                                  " bytes, expected ", value.TotalBytes());
+        }
+        std::memcpy(value.data(), region->data(), region->length());
+      }
+    }
+    Status create_status = CreateNodeDef(node_name, TensorValue(&value),
+                                         &outputs->at(i), total_inputs_size);
+    if (!create_status.ok()) {
+      *result_too_large = true;
+      return create_status;
+    }
+  }
+  return Status::OK();
+}
+
 Status ConstantFolding::FoldMergeNode(NodeDef* node, GraphDef* output_graph) {
   // Merge nodes are special, in the sense that they execute as soon as one of
   // their input is ready. We can therefore fold a merge node iff it has at
@@ -1530,7 +1731,7 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
     // We rewrite the existing node if it only has a single output, and
     // create new nodes otherwise.
     if (const_nodes.size() == 1) {
-      node->set_op("Const");
+      node->set_op(const_node->op());
       // Note we need to clear the inputs in NodeMap before we clear the inputs
       // in the node, otherwise NodeMap would see empty inputs and effectively
       // does nothing.
@@ -34,6 +34,7 @@ namespace grappler {
 const char kConstantFoldingConst[] = "ConstantFolding";
 const char kConstantFoldingCtrl[] = "ConstantFoldingCtrl";
 extern const int64 kMaxConstantSize;
+extern const int64 kMinImmutableConstSize;
 
 // Constant folding optimization for a graph.
 class ConstantFolding : public GraphOptimizer {
@@ -48,9 +49,12 @@ class ConstantFolding : public GraphOptimizer {
   explicit ConstantFolding(DeviceBase* cpu_device,
                            bool disable_compressed_tensor_optimization = false,
                            bool fold_quantization_emulation = true);
+  // If `cache_dir` is not empty, the folded values are cached in that
+  // directory across runs of the optimizer (see EvaluateOneFoldableCached()).
   ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device,
                   bool disable_compressed_tensor_optimization = false,
-                  bool fold_quantization_emulation = true);
+                  bool fold_quantization_emulation = true,
+                  const string& cache_dir = "");
 
   ~ConstantFolding() override {}
 
@@ -98,6 +102,19 @@ class ConstantFolding : public GraphOptimizer {
   Status EvaluateOneFoldable(const NodeDef& node, std::vector<NodeDef>* outputs,
                              bool* result_too_large);
 
+  // Evaluates `node` on `inputs` through the cache in `cache_dir_`, keyed by
+  // a fingerprint of the node and of its inputs. The raw data of the folded
+  // values is stored in separate files, and values of at least
+  // kMinImmutableConstSize bytes are emitted as ImmutableConst nodes that
+  // memory-map these files instead of Const nodes.
+  Status EvaluateOneFoldableCached(
+      const NodeDef& node, const gtl::InlinedVector<TensorValue, 4>& inputs,
+      size_t total_inputs_size, std::vector<NodeDef>* outputs,
+      bool* result_too_large);
+  // Returns true if the folded values of `node` may be emitted as
+  // ImmutableConst nodes.
+  bool CanUseImmutableConst(const NodeDef& node) const;
+
   Status FoldMergeNode(NodeDef* node, GraphDef* output_graph);
   Status FoldNode(NodeDef* node, GraphDef* output_graph,
                   bool* result_too_large);
@@ -343,6 +360,7 @@ class ConstantFolding : public GraphOptimizer {
   bool graph_contains_assign_or_inplace_op_;
   bool disable_compressed_tensor_optimization_;
   bool fold_quantization_emulation_;
+  string cache_dir_;
 };
 
 }  // end namespace grappler
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tensor_coding.h"
@@ -4410,6 +4411,60 @@ TEST_F(ConstantFoldingTest, QuantizationEmulation) {
   }
 }
 
+TEST_F(ConstantFoldingTest, CacheDir) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  // `large` is too large to be folded into a Const node.
+  Output start = ops::Const(scope.WithOpName("start"), 0.0f, {});
+  Output limit = ops::Const(scope.WithOpName("limit"), 32768.0f, {});
+  Output delta = ops::Const(scope.WithOpName("delta"), 1.0f, {});
+  Output large = ops::Range(scope.WithOpName("large"), start, limit, delta);
+  Output small = ops::Add(scope.WithOpName("small"), limit, delta);
+  Output large_id = ops::Identity(scope.WithOpName("large_id"), large);
+  Output small_id = ops::Identity(scope.WithOpName("small_id"), small);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch = {"large_id", "small_id"};
+  std::vector<Tensor> expected_tensors = EvaluateNodes(item.graph, item.fetch);
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "constant_folding_cache");
+  std::vector<string> cache_files;
+  for (int i = 0; i < 2; ++i) {
+    ConstantFolding optimizer(RewriterConfig::ON, /*cpu_device=*/nullptr,
+                              /*disable_compressed_tensor_optimization=*/false,
+                              /*fold_quantization_emulation=*/true, cache_dir);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "large") {
+        EXPECT_EQ("ImmutableConst", node.op());
+        EXPECT_TRUE(Env::Default()
+                        ->FileExists(node.attr().at("memory_region_name").s())
+                        .ok());
+      } else if (node.name() == "small") {
+        EXPECT_EQ("Const", node.op());
+      }
+    }
+    std::vector<Tensor> actual_tensors = EvaluateNodes(output, item.fetch);
+    ASSERT_EQ(expected_tensors.size(), actual_tensors.size());
+    for (int j = 0; j < item.fetch.size(); ++j) {
+      test::ExpectTensorEqual<float>(expected_tensors[j], actual_tensors[j]);
+    }
+
+    // The second run reuses the cache entries of the first one.
+    std::vector<string> files;
+    TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &files));
+    if (i == 0) {
+      EXPECT_FALSE(files.empty());
+      cache_files = files;
+    } else {
+      EXPECT_EQ(cache_files.size(), files.size());
+    }
+  }
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -66,11 +66,14 @@ const ConfigList& DefaultPluginConfigs() {
                       {"auto_mixed_precision", RewriterConfig::ON},
                       {"auto_mixed_precision_mkl", RewriterConfig::ON},
                       {"pin_to_host_optimization", RewriterConfig::ON},
+                      {"locality_aware_placement", RewriterConfig::ON},
                       {"layout_optimizer", RewriterConfig::ON},
                       {"remapping", RewriterConfig::ON},
+                      {"elementwise_fusion", RewriterConfig::ON},
                       {"loop_optimization", RewriterConfig::ON},
                       {"dependency_optimization", RewriterConfig::ON},
                       {"auto_parallel", RewriterConfig::ON},
+                      {"micro_batch_pipeline", RewriterConfig::ON},
                       {"memory_optimization", RewriterConfig::ON},
                       {"scoped_allocator_optimization", RewriterConfig::ON}});
   return *default_plugin_configs;
@@ -0,0 +1,272 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kFusedElementwise[] = "_FusedElementwise";
+
+// Upper bound on the number of ops fused into one node, which bounds the
+// scratch space the kernel needs for the intermediate values of a tile.
+constexpr size_t kMaxFusedOps = 32;
+
+// Returns the number of inputs of the elementwise ops supported by the
+// `_FusedElementwise` kernel, and 0 for all other ops.
+int ElementwiseOpArity(const string& op) {
+  static const auto* arity = new absl::flat_hash_map<string, int>({
+      // Unary ops.
+      {"Abs", 1},
+      {"Exp", 1},
+      {"Log", 1},
+      {"Neg", 1},
+      {"Reciprocal", 1},
+      {"Relu", 1},
+      {"Rsqrt", 1},
+      {"Sigmoid", 1},
+      {"Sqrt", 1},
+      {"Square", 1},
+      {"Tanh", 1},
+      // Binary ops, whose inputs may broadcast.
+      {"Add", 2},
+      {"AddV2", 2},
+      {"Maximum", 2},
+      {"Minimum", 2},
+      {"Mul", 2},
+      {"RealDiv", 2},
+      {"SquaredDifference", 2},
+      {"Sub", 2},
+  });
+  auto it = arity->find(op);
+  return it == arity->end() ? 0 : it->second;
+}
+
+DataType GetElementType(const NodeDef& node) {
+  auto it = node.attr().find("T");
+  return it == node.attr().end() ? DT_INVALID : it->second.type();
+}
+
+bool IsFusible(const NodeDef& node) {
+  const int arity = ElementwiseOpArity(node.op());
+  if (arity == 0 || NumNonControlInputs(node) != arity) return false;
+  const DataType dtype = GetElementType(node);
+  return (dtype == DT_FLOAT || dtype == DT_DOUBLE) && NodeIsOnCpu(&node);
+}
+
+struct Fanouts {
+  // Indices of the nodes that consume output 0 of a node, once per input.
+  std::vector<int> consumers;
+  bool has_control_fanouts = false;
+  bool has_other_fanouts = false;
+};
+
+}  // namespace
+
+Status ElementwiseFusion::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                   GraphDef* optimized_graph) {
+  if (xla_auto_clustering_on_) {
+    return errors::Aborted("Elementwise ops are fused by XLA.");
+  }
+  // _FusedElementwise does not have a gradient function.
+  if (!item.optimization_options().allow_non_differentiable_rewrites) {
+    return errors::Aborted("Non-differentiable rewrites are not allowed.");
+  }
+
+  *optimized_graph = item.graph;
+  GraphDef* graph = optimized_graph;
+  // Processing the graph in reverse topological order grows each fused DAG
+  // from its last op.
+  if (!TopologicalSort(graph).ok()) {
+    return errors::Aborted("Elementwise fusion requires an acyclic graph.");
+  }
+
+  const int num_nodes = graph->node_size();
+  absl::flat_hash_map<string, int> node_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    node_index[graph->node(i).name()] = i;
+  }
+  std::vector<Fanouts> fanouts(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    for (const string& input : graph->node(i).input()) {
+      const TensorId tensor = ParseTensorName(input);
+      auto it = node_index.find(tensor.node());
+      if (it == node_index.end()) continue;
+      Fanouts& producer = fanouts[it->second];
+      if (tensor.index() < 0) {
+        producer.has_control_fanouts = true;
+      } else if (tensor.index() == 0) {
+        producer.consumers.push_back(i);
+      } else {
+        producer.has_other_fanouts = true;
+      }
+    }
+  }
+
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  std::vector<bool> fusible(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    fusible[i] = IsFusible(graph->node(i));
+  }
+
+  std::vector<bool> fused(num_nodes);
+  std::set<int> nodes_to_delete;
+  std::vector<NodeDef> fused_nodes;
+  for (int root = num_nodes - 1; root >= 0; --root) {
+    if (!fusible[root] || fused[root]) continue;
+    const NodeDef& root_node = graph->node(root);
+
+    // A producer joins the DAG if all of its consumers are in the DAG already.
+    // Visiting the candidates in reverse topological order makes sure that all
+    // consumers that can join the DAG have joined before their producers are
+    // visited.
+    absl::flat_hash_set<int> members = {root};
+    std::priority_queue<int> candidates;
+    auto add_inputs = [&](int member) {
+      for (const string& input : graph->node(member).input()) {
+        if (IsControlInput(input)) continue;
+        auto it = node_index.find(ParseTensorName(input).node());
+        if (it != node_index.end()) candidates.push(it->second);
+      }
+    };
+    add_inputs(root);
+    while (!candidates.empty() && members.size() < kMaxFusedOps) {
+      const int candidate = candidates.top();
+      candidates.pop();
+      if (members.contains(candidate)) continue;
+      const NodeDef& node = graph->node(candidate);
+      const Fanouts& candidate_fanouts = fanouts[candidate];
+      if (!fusible[candidate] || fused[candidate] ||
+          candidate_fanouts.has_control_fanouts ||
+          candidate_fanouts.has_other_fanouts ||
+          nodes_to_preserve.count(node.name()) > 0 ||
+          GetElementType(node) != GetElementType(root_node) ||
+          node.device() != root_node.device()) {
+        continue;
+      }
+      const bool all_consumers_fused = absl::c_all_of(
+          candidate_fanouts.consumers,
+          [&members](int consumer) { return members.contains(consumer); });
+      if (!all_consumers_fused) continue;
+      members.insert(candidate);
+      add_inputs(candidate);
+    }
+    if (members.size() < 2) continue;
+
+    // The members in topological order are the steps of the fused op.
+    std::vector<int> steps(members.begin(), members.end());
+    std::sort(steps.begin(), steps.end());
+    absl::flat_hash_map<string, int> step_index;
+    for (int i = 0; i < steps.size(); ++i) {
+      step_index[graph->node(steps[i]).name()] = i;
+    }
+
+    NodeDef fused_node;
+    fused_node.set_name(root_node.name());
+    fused_node.set_op(kFusedElementwise);
+    fused_node.set_device(root_node.device());
+    AttrValue op_names;
+    // Operands of the steps before the number of arguments is known: a step
+    // index if the first element is true, an argument index otherwise.
+    std::vector<std::pair<bool, int>> operands;
+    absl::flat_hash_map<string, int> arg_index;
+    std::vector<string> args;
+    absl::flat_hash_set<string> control_inputs;
+    for (int member : steps) {
+      const NodeDef& node = graph->node(member);
+      op_names.mutable_list()->add_s(node.op());
+      for (const string& input : node.input()) {
+        if (IsControlInput(input)) {
+          control_inputs.insert(input);
+          continue;
+        }
+        const TensorId tensor = ParseTensorName(input);
+        auto step_it = step_index.find(tensor.node());
+        if (step_it != step_index.end()) {
+          operands.emplace_back(true, step_it->second);
+          continue;
+        }
+        const int num_args = args.size();
+        auto arg_it = arg_index.emplace(tensor.ToString(), num_args).first;
+        if (arg_it->second == num_args) args.push_back(input);
+        operands.emplace_back(false, arg_it->second);
+      }
+      if (NumNonControlInputs(node) == 1) operands.emplace_back(false, -1);
+    }
+
+    const int num_args = args.size();
+    AttrValue operand_values;
+    for (const auto& operand : operands) {
+      const int value =
+          operand.first ? num_args + operand.second : operand.second;
+      operand_values.mutable_list()->add_i(value);
+    }
+    for (const string& arg : args) {
+      fused_node.add_input(arg);
+    }
+    std::vector<string> sorted_control_inputs(control_inputs.begin(),
+                                              control_inputs.end());
+    std::sort(sorted_control_inputs.begin(), sorted_control_inputs.end());
+    for (const string& control_input : sorted_control_inputs) {
+      fused_node.add_input(control_input);
+    }
+    auto* attr = fused_node.mutable_attr();
+    (*attr)["T"].set_type(GetElementType(root_node));
+    (*attr)["num_args"].set_i(num_args);
+    (*attr)["op_names"] = std::move(op_names);
+    (*attr)["operands"] = std::move(operand_values);
+
+    VLOG(2) << "Fuse " << steps.size() << " elementwise ops into "
+            << root_node.name();
+    for (int member : steps) {
+      fused[member] = true;
+      if (member != root) nodes_to_delete.insert(member);
+    }
+    fused_nodes.push_back(std::move(fused_node));
+  }
+
+  for (NodeDef& fused_node : fused_nodes) {
+    *graph->mutable_node(node_index[fused_node.name()]) =
+        std::move(fused_node);
+  }
+  EraseNodesFromGraph(nodes_to_delete, graph);
+  return Status::OK();
+}
+
+void ElementwiseFusion::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                 const GraphDef& optimized_graph,
+                                 double result) {
+  // Nothing to do for ElementwiseFusion.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,60 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fuses DAGs of elementwise unary and binary CPU ops (e.g. Mul->Add->Tanh->Mul)
+// into a single `_FusedElementwise` node, which evaluates the whole DAG in one
+// tiled loop instead of materializing every intermediate tensor. Inputs of the
+// binary ops may broadcast.
+//
+// The fused DAGs only include nodes whose outputs are not used outside of the
+// DAG, so that no intermediate result has to be kept. The pass does nothing if
+// XLA auto-clustering is on, since XLA fuses these ops itself.
+class ElementwiseFusion : public GraphOptimizer {
+ public:
+  explicit ElementwiseFusion(RewriterConfig::Toggle opt_level,
+                             bool xla_auto_clustering_on = false)
+      : opt_level_(opt_level),
+        xla_auto_clustering_on_(xla_auto_clustering_on) {}
+
+  ~ElementwiseFusion() override {}
+
+  string name() const override { return "elementwise_fusion"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+  bool xla_auto_clustering_on_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
@@ -0,0 +1,135 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kCpu[] = "/device:CPU:0";
+
+class ElementwiseFusionTest : public GrapplerTest {};
+
+TEST_F(ElementwiseFusionTest, FuseChainWithBroadcasting) {
+  using ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCpu);
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       Placeholder::Shape({8, 16}));
+  auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT,
+                           Placeholder::Shape({16}));
+  auto mul = ops::Mul(s.WithOpName("mul"), x, scale);
+  auto add = ops::AddV2(s.WithOpName("add"), mul, ops::Const(s, 0.5f));
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), add);
+  auto out = ops::Mul(s.WithOpName("out"), tanh, x);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), out);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({8, 16});
+  auto scale_t = GenerateRandomTensor<DT_FLOAT>({16});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}, {"scale", scale_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "mul");
+    EXPECT_NE(node.name(), "add");
+    EXPECT_NE(node.name(), "tanh");
+    if (node.name() == "out") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "scale");
+      EXPECT_EQ(node.attr().at("num_args").i(), 3);
+      const auto& op_names = node.attr().at("op_names").list();
+      ASSERT_EQ(op_names.s_size(), 4);
+      EXPECT_EQ(op_names.s(0), "Mul");
+      EXPECT_EQ(op_names.s(1), "AddV2");
+      EXPECT_EQ(op_names.s(2), "Tanh");
+      EXPECT_EQ(op_names.s(3), "Mul");
+      const auto& operands = node.attr().at("operands").list();
+      ASSERT_EQ(operands.i_size(), 8);
+      EXPECT_EQ(operands.i(3), 2);
+      EXPECT_EQ(operands.i(5), -1);
+      EXPECT_EQ(operands.i(7), 0);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(ElementwiseFusionTest, DoNotFuseNodesWithOtherConsumers) {
+  using ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCpu);
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT, Placeholder::Shape({32}));
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto neg = ops::Neg(s.WithOpName("neg"), exp);
+  auto sqrt = ops::Sqrt(s.WithOpName("sqrt"), neg);
+  // `exp` is also used outside of the Neg->Sqrt chain, `neg` is a fetch.
+  auto matmul = ops::MatMul(s.WithOpName("matmul"),
+                            ops::Reshape(s, exp, {1, 32}),
+                            ops::Reshape(s, sqrt, {32, 1}));
+
+  GrapplerItem item;
+  item.fetch = {"matmul", "neg"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  CompareGraphs(item.graph, output);
+}
+
+TEST_F(ElementwiseFusionTest, DoNotFuseWithXlaAutoClustering) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCpu);
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto neg = ops::Neg(s.WithOpName("neg"), exp);
+
+  GrapplerItem item;
+  item.fetch = {"neg"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  ElementwiseFusion optimizer(RewriterConfig::ON,
+                              /*xla_auto_clustering_on=*/true);
+  GraphDef output;
+  EXPECT_TRUE(
+      errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
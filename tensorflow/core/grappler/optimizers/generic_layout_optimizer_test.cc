@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -675,6 +676,55 @@ TEST_F(GenericLayoutOptimizerTest, CancelTransposeAroundPad) {
   test::ExpectTensorEqual<float>(tensors_expected[1], tensors[1]);
 }
 
+#if !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+TEST_F(GenericLayoutOptimizerTest, CpuNhwcToNchwConversion) {
+  Scope scope = Scope::NewRootScope().WithDevice("/device:CPU:0");
+  auto input = ops::RandomUniform(scope.WithOpName("input"),
+                                  {kBatchSize, kHeight, kWidth, kDepthIn},
+                                  DT_FLOAT);
+  auto filter = ops::RandomUniform(scope.WithOpName("filter"),
+                                   {kKernel, kKernel, kDepthIn, kDepthOut},
+                                   DT_FLOAT);
+  auto conv = ops::Conv2D(scope.WithOpName("conv2d"), input, filter,
+                          {1, 1, 1, 1}, "SAME");
+  auto relu = ops::Relu(scope.WithOpName("relu"), conv);
+  auto depth_to_space =
+      ops::DepthToSpace(scope.WithOpName("depth_to_space"), relu, 2);
+  auto output = ops::Identity(scope.WithOpName("output"), depth_to_space);
+
+  GrapplerItem item;
+  TF_ASSERT_OK(scope.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHW);
+  GraphDef output_graph;
+  const Status status =
+      optimizer.Optimize(virtual_cluster_.get(), item, &output_graph);
+  if (!IsMKLEnabled()) {
+    EXPECT_TRUE(errors::IsAborted(status));
+    return;
+  }
+  TF_ASSERT_OK(status);
+
+  Status graph_status;
+  utils::GraphView graph_view(&output_graph, &graph_status);
+  TF_ASSERT_OK(graph_status);
+
+  // Conv2D has a oneDNN kernel and is converted, while DepthToSpace is left
+  // in NHWC with a transpose at the region boundary.
+  auto* conv_node = graph_view.GetNode("conv2d");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  auto* depth_to_space_node = graph_view.GetNode("depth_to_space");
+  ASSERT_NE(depth_to_space_node, nullptr);
+  VerifyDataFormatAttributeMatch(depth_to_space_node, "NHWC");
+  ASSERT_EQ(depth_to_space_node->NumRegularFanins(), 1);
+  EXPECT_EQ(
+      depth_to_space_node->GetRegularFanin(0).node_view()->node()->op(),
+      "Transpose");
+}
+#endif  // !(GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+
 TEST_F(GenericLayoutOptimizerTest, PreserveInputShapes) {
   using test::function::NDef;
 
@@ -280,7 +280,15 @@ bool Transposer::ShouldProcess(const TransposeContext& context,
   // Only transposes floating point nodes.
   const bool is_integer_conv2d = IsNonFloatingConv2D(node);
 
+  // On CPU, NCHW is only a useful target for ops whose oneDNN kernels reorder
+  // it into a blocked layout; other layout sensitive ops stay in NHWC, so that
+  // transposes are only inserted at the boundaries of oneDNN regions.
+  const bool is_supported_on_cpu =
+      context.target_device != kCPU || context.dst_format != "NCHW" ||
+      !IsLayoutSensitiveOp(*node_def) || IsCpuBlockedLayoutOp(*node_def);
+
   return is_on_target_device && data_format_match && !is_integer_conv2d &&
+         is_supported_on_cpu &&
          !context.nodes_to_preserve.contains(node_def->name()) &&
          !(node.NumRegularFanouts() == 0 && node.NumControlledFanouts() == 0);
 }
@@ -1980,6 +1988,15 @@ bool IsLayoutSensitiveOp(const NodeDef& node) {
          IsConv3DBackpropFilterV2(node);
 }
 
+bool IsCpuBlockedLayoutOp(const NodeDef& node) {
+  const auto& op = node.op();
+  return op == "AvgPool" || op == "MaxPool" || IsAvgPoolGrad(node) ||
+         IsBiasAdd(node) || IsBiasAddGrad(node) || IsConv2D(node) ||
+         IsConv2DBackpropFilter(node) || IsConv2DBackpropInput(node) ||
+         IsDepthwiseConv2dNative(node) || IsFusedBatchNorm(node) ||
+         IsFusedBatchNormGrad(node) || IsMaxPoolGrad(node);
+}
+
 bool IsDefaultLayoutAgnosticOp(const NodeDef& node) {
   static absl::flat_hash_set<string>* agnostic_nodes =
       new absl::flat_hash_set<std::string>({"Abs",
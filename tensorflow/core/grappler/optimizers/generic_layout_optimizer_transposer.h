@@ -610,6 +610,10 @@ bool IsDefaultLayoutSensitiveOp(const NodeDef& node);
 
 bool IsLayoutSensitiveOp(const NodeDef& node);
 
+// Returns true if the layout sensitive op has a oneDNN CPU kernel that accepts
+// NCHW and reorders it internally into a blocked layout (nChw8c/nChw16c).
+bool IsCpuBlockedLayoutOp(const NodeDef& node);
+
 bool IsDefaultLayoutAgnosticOp(const NodeDef& node);
 
 bool IsLayoutAgnosticOp(const NodeDef& node);
@@ -0,0 +1,257 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/locality_aware_placement.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Moves that save fewer bytes than this are not worth perturbing the
+// placement for.
+constexpr int64 kMinSavedBytes = 1024;
+
+// The compute time of a device may grow to this factor of the compute time of
+// the most loaded device of the original placement.
+constexpr double kCapacitySlack = 1.1;
+
+// Returns the task of "device", e.g. "/job:worker/replica:0/task:1", or an
+// empty string if "device" is not a full device name.
+string TaskOf(const string& device) {
+  string task, local;
+  if (!DeviceNameUtils::SplitDeviceName(device, &task, &local)) return "";
+  return task;
+}
+
+string DeviceTypeOf(const string& device) {
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(device, &parsed) || !parsed.has_type) {
+    return "";
+  }
+  return parsed.type;
+}
+
+// Returns the size of output "port" of a node with "outputs", or 0 if it is
+// unknown.
+int64 OutputBytes(const std::vector<OpInfo::TensorProperties>& outputs,
+                  int port) {
+  if (port < 0 || port >= static_cast<int>(outputs.size())) return 0;
+  return CalculateTensorSize(outputs[port]);
+}
+
+bool HasRefOrResource(
+    const std::vector<OpInfo::TensorProperties>& properties) {
+  for (const auto& prop : properties) {
+    if (IsRefType(prop.dtype()) || prop.dtype() == DT_RESOURCE) return true;
+  }
+  return false;
+}
+
+// Returns the names of the nodes with colocation constraints, and of the nodes
+// they are colocated with.
+absl::flat_hash_set<string> ColocatedNodes(const GraphDef& graph) {
+  absl::flat_hash_set<string> colocated;
+  for (const NodeDef& node : graph.node()) {
+    auto it = node.attr().find(kColocationAttrName);
+    if (it == node.attr().end()) continue;
+    colocated.insert(node.name());
+    for (const string& group : it->second.list().s()) {
+      if (absl::StartsWith(group, kColocationGroupPrefix)) {
+        colocated.insert(group.substr(strlen(kColocationGroupPrefix)));
+      }
+    }
+  }
+  return colocated;
+}
+
+}  // namespace
+
+Status LocalityAwarePlacement::Optimize(Cluster* cluster,
+                                        const GrapplerItem& item,
+                                        GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+
+  absl::flat_hash_set<string> tasks;
+  for (const NodeDef& node : optimized_graph->node()) {
+    const string task = TaskOf(node.device());
+    if (!task.empty()) tasks.insert(task);
+  }
+  if (tasks.size() < 2) {
+    return errors::Aborted("Nothing to do.");
+  }
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(
+      properties.InferStatically(/*assume_valid_feeds=*/false,
+                                 /*aggressive_shape_inference=*/false,
+                                 /*include_tensor_values=*/false));
+
+  TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
+  NodeMap node_map(optimized_graph);
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : optimized_graph->node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  // Predicts the compute time of every node, and the load of every device.
+  std::unordered_map<string, DeviceProperties> cluster_devices;
+  if (cluster != nullptr) cluster_devices = cluster->GetDevices();
+  OpLevelCostEstimator estimator;
+  absl::flat_hash_map<const NodeDef*, int64> node_costs;
+  absl::flat_hash_map<string, int64> device_loads;
+  // Devices of each type in each task.
+  absl::flat_hash_map<string, absl::flat_hash_set<string>> task_devices;
+  for (const NodeDef& node : optimized_graph->node()) {
+    const string task = TaskOf(node.device());
+    if (task.empty()) continue;
+    task_devices[task].insert(node.device());
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.device_name = node.device();
+    op_context.op_info = BuildOpInfoWithoutDevice(
+        node, name_to_node, properties.GetInputProperties(node.name()));
+    auto it = cluster_devices.find(node.device());
+    *op_context.op_info.mutable_device() = it != cluster_devices.end()
+                                               ? it->second
+                                               : GetDeviceInfo(node.device());
+    const int64 cost =
+        estimator.PredictCosts(op_context).execution_time.count();
+    node_costs[&node] = cost;
+    device_loads[node.device()] += cost;
+  }
+  int64 max_load = 0;
+  for (const auto& load : device_loads) {
+    max_load = std::max(max_load, load.second);
+  }
+  const int64 capacity = static_cast<int64>(max_load * kCapacitySlack);
+
+  const absl::flat_hash_set<string> colocated =
+      ColocatedNodes(*optimized_graph);
+  const std::unordered_set<string> nodes_to_preserve =
+      item.NodesToPreserve();
+
+  int num_moved = 0;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    const string task = TaskOf(node.device());
+    const string device_type = DeviceTypeOf(node.device());
+    if (task.empty() || device_type.empty() ||
+        nodes_to_preserve.count(node.name()) > 0 ||
+        colocated.contains(node.name()) || IsStateful(node) ||
+        IsControlFlow(node) || IsSend(node) || IsRecv(node) ||
+        HasRefOrResource(properties.GetInputProperties(node.name())) ||
+        HasRefOrResource(properties.GetOutputProperties(node.name()))) {
+      continue;
+    }
+
+    // Bytes of the data edges of "node" to each task and device.
+    absl::flat_hash_map<string, int64> task_bytes;
+    absl::flat_hash_map<string, int64> device_bytes;
+    auto add_edge = [&](const NodeDef* other, int64 bytes) {
+      task_bytes[TaskOf(other->device())] += bytes;
+      device_bytes[other->device()] += bytes;
+    };
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) continue;
+      const TensorId id = ParseTensorName(input);
+      const NodeDef* producer = node_map.GetNode(input);
+      if (producer == nullptr) continue;
+      add_edge(producer,
+               OutputBytes(properties.GetOutputProperties(producer->name()),
+                           id.index()));
+    }
+    const std::vector<OpInfo::TensorProperties>& outputs =
+        properties.GetOutputProperties(node.name());
+    for (const NodeDef* consumer : node_map.GetOutputs(node.name())) {
+      for (const string& input : consumer->input()) {
+        if (IsControlInput(input)) continue;
+        const TensorId id = ParseTensorName(input);
+        if (id.node() != node.name()) continue;
+        add_edge(consumer, OutputBytes(outputs, id.index()));
+      }
+    }
+
+    const int64 local_bytes = task_bytes[task];
+    string best_task = task;
+    int64 best_bytes = local_bytes;
+    for (const auto& bytes : task_bytes) {
+      if (!bytes.first.empty() && bytes.second > best_bytes) {
+        best_task = bytes.first;
+        best_bytes = bytes.second;
+      }
+    }
+    if (best_bytes - local_bytes < kMinSavedBytes) continue;
+
+    // Prefers the device of the same type with the largest transfers, and
+    // then the least loaded one.
+    const int64 cost = node_costs[&node];
+    string target;
+    int64 target_bytes = -1;
+    int64 target_load = std::numeric_limits<int64>::max();
+    for (const string& device : task_devices[best_task]) {
+      if (DeviceTypeOf(device) != device_type) continue;
+      const int64 load = device_loads[device];
+      if (load + cost > capacity) continue;
+      const int64 bytes = device_bytes[device];
+      if (bytes > target_bytes ||
+          (bytes == target_bytes && load < target_load)) {
+        target = device;
+        target_bytes = bytes;
+        target_load = load;
+      }
+    }
+    if (target.empty()) continue;
+
+    VLOG(2) << "Moving node " << node.name() << " from " << node.device()
+            << " to " << target << " saves " << best_bytes - local_bytes
+            << " bytes";
+    device_loads[node.device()] -= cost;
+    device_loads[target] += cost;
+    node.set_device(target);
+    ++num_moved;
+  }
+  VLOG(1) << "Moved " << num_moved << " nodes closer to their inputs";
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,58 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_LOCALITY_AWARE_PLACEMENT_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_LOCALITY_AWARE_PLACEMENT_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Refines the placement of a graph placed over several tasks, to reduce the
+// number of bytes transferred between tasks once the graph is partitioned.
+//
+// Nodes are visited in topological order.  A node whose data inputs and
+// outputs (sized with GraphProperties) mostly live on another task is moved
+// there, to a device of the same type, typically the one of its largest
+// producer.  The move is only made if the compute time of the target device,
+// as predicted by OpLevelCostEstimator, stays within the capacity given by the
+// most loaded device of the original placement.
+//
+// Stateful nodes, control flow, nodes with reference or resource inputs,
+// nodes with colocation constraints and nodes to preserve are never moved.
+class LocalityAwarePlacement : public GraphOptimizer {
+ public:
+  LocalityAwarePlacement() {}
+  explicit LocalityAwarePlacement(RewriterConfig::Toggle opt_level) {}
+
+  ~LocalityAwarePlacement() override {}
+
+  string name() const override { return "locality_aware_placement"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_LOCALITY_AWARE_PLACEMENT_H_
@@ -0,0 +1,104 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/locality_aware_placement.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kTask0[] = "/job:worker/replica:0/task:0/device:CPU:0";
+constexpr char kTask1[] = "/job:worker/replica:0/task:1/device:CPU:0";
+
+class LocalityAwarePlacementTest : public GrapplerTest {
+ protected:
+  // A large input on task 0, reduced on task 1.
+  GrapplerItem MakeReductionItem() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto x = ops::Placeholder(s.WithOpName("x").WithDevice(kTask0), DT_FLOAT,
+                              ops::Placeholder::Shape({256, 256}));
+    auto sum = ops::Sum(s.WithOpName("sum").WithDevice(kTask1), x, {0, 1});
+    auto fetch = ops::Identity(s.WithOpName("fetch").WithDevice(kTask1), sum);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"x", GenerateRandomTensor<DT_FLOAT>({256, 256})}};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+
+  static string DeviceOf(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return node.device();
+    }
+    return "";
+  }
+};
+
+TEST_F(LocalityAwarePlacementTest, MovesReductionToItsInput) {
+  GrapplerItem item = MakeReductionItem();
+
+  LocalityAwarePlacement optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(kTask0, DeviceOf(output, "sum"));
+  // Inputs and fetches keep their placement.
+  EXPECT_EQ(kTask0, DeviceOf(output, "x"));
+  EXPECT_EQ(kTask1, DeviceOf(output, "fetch"));
+}
+
+TEST_F(LocalityAwarePlacementTest, KeepsColocatedNodes) {
+  GrapplerItem item = MakeReductionItem();
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "sum") {
+      (*node.mutable_attr())[kColocationAttrName].mutable_list()->add_s(
+          "loc:@fetch");
+    }
+  }
+
+  LocalityAwarePlacement optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(kTask1, DeviceOf(output, "sum"));
+}
+
+TEST_F(LocalityAwarePlacementTest, NothingToDoOnOneTask) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kTask0);
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({256, 256}));
+  auto fetch = ops::Sum(s.WithOpName("fetch"), x, {0, 1});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  LocalityAwarePlacement optimizer(RewriterConfig::ON);
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <deque>
 #include <limits>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -546,6 +547,489 @@ Status RemoveStackOps(const std::unordered_set<string>& nodes_to_preserve,
   return Status::OK();
 }
 
+// Software-pipelines while loops whose body starts with a computation that
+// only depends on an index loop variable and on loop invariants, such as an
+// embedding lookup of the current step. The prefix of iteration i+1 is
+// computed during iteration i and passed to the next iteration in a new loop
+// variable, so that it runs in parallel with the rest of the body instead of
+// delaying it.
+//
+// The prefix of an iteration may not be valid if the loop doesn't execute
+// that iteration (e.g. a lookup out of bounds), so it is only computed if the
+// loop condition holds for it. This requires the loop condition to only
+// depend on the index and on loop invariants.
+class LoopPipeliningOptimizer {
+ public:
+  LoopPipeliningOptimizer(const std::unordered_set<string>& nodes_to_preserve,
+                          GraphDef* optimized_graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        optimized_graph_(optimized_graph) {}
+  Status Optimize();
+
+ private:
+  // A top-level while loop with an index variable and a prefix to pipeline.
+  struct PipelinedLoop {
+    const NodeDef* loop_cond = nullptr;
+    // The input of the LoopCond node.
+    const NodeDef* predicate = nullptr;
+    const NodeDef* index_enter = nullptr;
+    const NodeDef* index_merge = nullptr;
+    const NodeDef* index_identity = nullptr;
+    // Value of the index in the next iteration.
+    string index_next;
+    // Nodes of the prefix, in topological order.
+    std::vector<const NodeDef*> prefix;
+    absl::flat_hash_set<string> prefix_names;
+    // Tensors of the prefix that are consumed by the rest of the body.
+    std::vector<string> prefix_outputs;
+  };
+
+  bool IsInvariantEnter(const NodeDef& node, int frame_id) const;
+  bool FindIndexVariable(const NodeDef& loop_cond, int frame_id,
+                         PipelinedLoop* loop) const;
+  bool FindPrefix(int frame_id, PipelinedLoop* loop) const;
+  NodeDef* AddNode(const string& name, const string& op, const string& device,
+                   const std::vector<string>& inputs, DataType type);
+  // Clones `nodes` of `loop`, replacing the node `index_name` with `index`.
+  // If `before_loop`, the clones are placed before the loop, and loop
+  // invariants are replaced by their values outside of the loop.
+  Status CloneNodes(const PipelinedLoop& loop,
+                    const std::vector<const NodeDef*>& nodes,
+                    const string& index_name, const string& index,
+                    bool before_loop, const string& suffix,
+                    std::unordered_map<string, string>* clones);
+  Status Pipeline(const PipelinedLoop& loop);
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  GraphDef* optimized_graph_;  // Not owned.
+  std::unique_ptr<NodeMap> node_map_;
+  FrameView frame_view_;
+};
+
+// The prefix of a loop is only pipelined if it has at least this many nodes.
+constexpr int kMinPipelinedPrefixSize = 2;
+
+bool LoopPipeliningOptimizer::IsInvariantEnter(const NodeDef& node,
+                                               int frame_id) const {
+  if (!IsEnter(node) || !node.attr().at("is_constant").b()) {
+    return false;
+  }
+  const std::vector<int>& frame_ids = frame_view_.Frames(node);
+  if (frame_ids.size() != 1 || frame_ids[0] != frame_id) {
+    return false;
+  }
+  const NodeDef* input = node_map_->GetNode(node.input(0));
+  return input != nullptr && frame_view_.Frames(*input).empty();
+}
+
+bool LoopPipeliningOptimizer::FindIndexVariable(const NodeDef& loop_cond,
+                                                int frame_id,
+                                                PipelinedLoop* loop) const {
+  loop->loop_cond = &loop_cond;
+  loop->predicate = node_map_->GetNode(loop_cond.input(0));
+  if (loop->predicate == nullptr || !IsFreeOfSideEffect(*loop->predicate)) {
+    return false;
+  }
+  // The loop condition must only depend on a single loop variable, the index.
+  for (const string& input : loop->predicate->input()) {
+    const NodeDef* input_node = node_map_->GetNode(input);
+    if (input_node == nullptr || IsControlInput(input)) {
+      return false;
+    }
+    if (IsMerge(*input_node)) {
+      if (ParseTensorName(input).index() != 0 ||
+          (loop->index_merge != nullptr && loop->index_merge != input_node)) {
+        return false;
+      }
+      loop->index_merge = input_node;
+    } else if (!IsConstant(*input_node) &&
+               !IsInvariantEnter(*input_node, frame_id)) {
+      return false;
+    }
+  }
+  const NodeDef* merge = loop->index_merge;
+  if (merge == nullptr || merge->input_size() != 2) {
+    return false;
+  }
+  loop->index_enter = node_map_->GetNode(merge->input(0));
+  const NodeDef* next_iteration = node_map_->GetNode(merge->input(1));
+  if (loop->index_enter == nullptr || !IsEnter(*loop->index_enter) ||
+      loop->index_enter->attr().at("is_constant").b() ||
+      next_iteration == nullptr || !IsNextIteration(*next_iteration)) {
+    return false;
+  }
+  const NodeDef* initial_index =
+      node_map_->GetNode(loop->index_enter->input(0));
+  if (initial_index == nullptr || !frame_view_.Frames(*initial_index).empty()) {
+    return false;
+  }
+
+  // The body reads the index through Identity(Switch(index, loop_cond):1).
+  const NodeDef* index_switch = nullptr;
+  for (const NodeDef* output : node_map_->GetOutputs(merge->name())) {
+    if (IsSwitch(*output) && output->input_size() == 2 &&
+        NodeName(output->input(1)) == loop_cond.name()) {
+      index_switch = output;
+    }
+  }
+  if (index_switch == nullptr) {
+    return false;
+  }
+  for (const NodeDef* output : node_map_->GetOutputs(index_switch->name())) {
+    if (ParseTensorName(output->input(0)).index() != 1) continue;
+    if (!IsIdentity(*output) || loop->index_identity != nullptr) {
+      return false;
+    }
+    loop->index_identity = output;
+  }
+  if (loop->index_identity == nullptr) {
+    return false;
+  }
+
+  // The next index must be available early in the iteration, otherwise the
+  // pipelined prefix would have to wait for it.
+  loop->index_next = next_iteration->input(0);
+  const NodeDef* index_next = node_map_->GetNode(loop->index_next);
+  if (index_next == nullptr || !IsFreeOfSideEffect(*index_next)) {
+    return false;
+  }
+  for (const string& input : index_next->input()) {
+    const NodeDef* input_node = node_map_->GetNode(input);
+    if (input_node == nullptr ||
+        (input_node != loop->index_identity && !IsConstant(*input_node) &&
+         !IsInvariantEnter(*input_node, frame_id))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LoopPipeliningOptimizer::FindPrefix(int frame_id,
+                                         PipelinedLoop* loop) const {
+  const string& index_next_name = NodeName(loop->index_next);
+  // Returns true if `input` of a prefix node is available to the prefix.
+  const auto is_prefix_input = [&](const string& input) {
+    const NodeDef* input_node = node_map_->GetNode(input);
+    if (input_node == nullptr) return false;
+    if (input_node == loop->index_identity ||
+        loop->prefix_names.contains(input_node->name())) {
+      return true;
+    }
+    return !IsControlInput(input) &&
+           (IsConstant(*input_node) || IsInvariantEnter(*input_node, frame_id));
+  };
+
+  // A node is part of the prefix once all its inputs are available to the
+  // prefix, so the nodes are added in topological order.
+  std::deque<const NodeDef*> queue;
+  for (const NodeDef* output :
+       node_map_->GetOutputsOrderedByNodeName(loop->index_identity->name())) {
+    queue.push_back(output);
+  }
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    if (loop->prefix_names.contains(node->name()) ||
+        node->name() == index_next_name || IsConstant(*node) ||
+        IsControlFlow(*node) || !IsFreeOfSideEffect(*node) ||
+        nodes_to_preserve_.count(node->name()) > 0) {
+      continue;
+    }
+    const std::vector<int>& frame_ids = frame_view_.Frames(*node);
+    if (frame_ids.size() != 1 || frame_ids[0] != frame_id) {
+      continue;
+    }
+    bool has_data_input_from_prefix = false;
+    bool all_inputs_available = true;
+    for (const string& input : node->input()) {
+      if (!is_prefix_input(input)) {
+        all_inputs_available = false;
+        break;
+      }
+      if (!IsControlInput(input) && !IsConstant(*node_map_->GetNode(input)) &&
+          !IsEnter(*node_map_->GetNode(input))) {
+        has_data_input_from_prefix = true;
+      }
+    }
+    // Each node of the prefix must depend on the index through a data edge, so
+    // that it is dead whenever the index is.
+    if (!all_inputs_available || !has_data_input_from_prefix) {
+      continue;
+    }
+    loop->prefix.push_back(node);
+    loop->prefix_names.insert(node->name());
+    for (const NodeDef* output :
+         node_map_->GetOutputsOrderedByNodeName(node->name())) {
+      queue.push_back(output);
+    }
+  }
+  if (loop->prefix.size() < kMinPipelinedPrefixSize) {
+    return false;
+  }
+
+  absl::flat_hash_set<string> prefix_outputs;
+  for (const NodeDef* node : loop->prefix) {
+    for (const NodeDef* output :
+         node_map_->GetOutputsOrderedByNodeName(node->name())) {
+      if (loop->prefix_names.contains(output->name())) continue;
+      for (const string& input : output->input()) {
+        if (NodeName(input) != node->name()) continue;
+        // Control dependencies on the prefix can't be pipelined.
+        if (IsControlInput(input)) {
+          return false;
+        }
+        const string tensor_name = TensorIdToString(ParseTensorName(input));
+        if (prefix_outputs.insert(tensor_name).second) {
+          loop->prefix_outputs.push_back(tensor_name);
+        }
+      }
+    }
+  }
+  return !loop->prefix_outputs.empty();
+}
+
+NodeDef* LoopPipeliningOptimizer::AddNode(const string& name,
+                                          const string& op,
+                                          const string& device,
+                                          const std::vector<string>& inputs,
+                                          DataType type) {
+  NodeDef* node = optimized_graph_->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  node->set_device(device);
+  node_map_->AddNode(name, node);
+  for (const string& input : inputs) {
+    node->add_input(input);
+    node_map_->AddOutput(NodeName(input), name);
+  }
+  if (type != DT_INVALID) {
+    (*node->mutable_attr())["T"].set_type(type);
+  }
+  return node;
+}
+
+Status LoopPipeliningOptimizer::CloneNodes(
+    const PipelinedLoop& loop, const std::vector<const NodeDef*>& nodes,
+    const string& index_name, const string& index, bool before_loop,
+    const string& suffix, std::unordered_map<string, string>* clones) {
+  const auto clone_name = [&](const string& name) {
+    return AddPrefixToNodeName(StrCat(name, "/", suffix), kLoopOptimizer);
+  };
+  for (const NodeDef* node : nodes) {
+    NodeDef* clone = AddNode(clone_name(node->name()), node->op(),
+                             node->device(), {}, DT_INVALID);
+    *clone->mutable_attr() = node->attr();
+    (*clones)[node->name()] = clone->name();
+    for (const string& input : node->input()) {
+      const bool is_control = IsControlInput(input);
+      const TensorId tensor = ParseTensorName(input);
+      const string input_name(tensor.node());
+      string new_input;
+      if (input_name == index_name) {
+        // The control dependency is implied by the data dependency on the
+        // index.
+        if (is_control) continue;
+        new_input = index;
+      } else if (clones->count(input_name) > 0) {
+        new_input = (*clones)[input_name];
+      } else if (!before_loop) {
+        new_input = input_name;
+      } else {
+        const NodeDef* input_node = node_map_->GetNode(input_name);
+        if (IsConstant(*input_node)) {
+          // Constants of the loop are placed before the loop without their
+          // control dependencies.
+          NodeDef* const_clone = AddNode(clone_name(input_name), "Const",
+                                         input_node->device(), {}, DT_INVALID);
+          *const_clone->mutable_attr() = input_node->attr();
+          (*clones)[input_name] = const_clone->name();
+          new_input = const_clone->name();
+        } else if (IsEnter(*input_node)) {
+          new_input = NodeName(input_node->input(0));
+          if (!is_control) {
+            clone->add_input(input_node->input(0));
+            node_map_->AddOutput(new_input, clone->name());
+            continue;
+          }
+        } else {
+          return errors::Internal("Unexpected input ", input, " of ",
+                                  node->name(), " in pipelined loop ",
+                                  loop.index_identity->name());
+        }
+      }
+      if (is_control) {
+        new_input = AsControlDependency(NodeName(new_input));
+      } else if (tensor.index() > 0) {
+        new_input = StrCat(new_input, ":", tensor.index());
+      }
+      clone->add_input(new_input);
+      node_map_->AddOutput(NodeName(new_input), clone->name());
+    }
+  }
+  return Status::OK();
+}
+
+Status LoopPipeliningOptimizer::Pipeline(const PipelinedLoop& loop) {
+  const NodeDef& index_enter = *loop.index_enter;
+  const string& device = index_enter.device();
+  const DataType index_type = index_enter.attr().at("T").type();
+  const string& initial_index = index_enter.input(0);
+  const auto name = [&loop](const string& suffix) {
+    return AddPrefixToNodeName(
+        StrCat(loop.index_identity->name(), "/pipelined/", suffix),
+        kLoopOptimizer);
+  };
+
+  // The loop condition for the first iteration, evaluated before the loop, and
+  // for the next iteration.
+  std::unordered_map<string, string> first_clones;
+  TF_RETURN_IF_ERROR(CloneNodes(loop, {loop.predicate},
+                                loop.index_merge->name(), initial_index,
+                                /*before_loop=*/true, "first", &first_clones));
+  const string first_predicate = first_clones[loop.predicate->name()];
+  std::unordered_map<string, string> next_clones;
+  TF_RETURN_IF_ERROR(CloneNodes(loop, {loop.predicate},
+                                loop.index_merge->name(), loop.index_next,
+                                /*before_loop=*/false, "next", &next_clones));
+  const string next_predicate = next_clones[loop.predicate->name()];
+
+  // The prefix of the first iteration, computed before the loop, and of the
+  // next iteration. They only run if the corresponding iteration does.
+  const NodeDef* first_index =
+      AddNode(name("first_index"), "Switch", device,
+              {initial_index, first_predicate}, index_type);
+  first_clones.clear();
+  TF_RETURN_IF_ERROR(CloneNodes(loop, loop.prefix,
+                                loop.index_identity->name(),
+                                StrCat(first_index->name(), ":1"),
+                                /*before_loop=*/true, "first", &first_clones));
+  const NodeDef* next_index =
+      AddNode(name("next_index"), "Switch", device,
+              {loop.index_next, next_predicate}, index_type);
+  next_clones.clear();
+  TF_RETURN_IF_ERROR(CloneNodes(loop, loop.prefix,
+                                loop.index_identity->name(),
+                                StrCat(next_index->name(), ":1"),
+                                /*before_loop=*/false, "next", &next_clones));
+
+  const auto clone_tensor = [](const string& tensor_name,
+                               std::unordered_map<string, string>& clones) {
+    const TensorId tensor = ParseTensorName(tensor_name);
+    return TensorIdToString(
+        TensorId(clones[string(tensor.node())], tensor.index()));
+  };
+
+  for (int i = 0; i < loop.prefix_outputs.size(); ++i) {
+    const string& output = loop.prefix_outputs[i];
+    const TensorId output_tensor = ParseTensorName(output);
+    const NodeDef* output_node = node_map_->GetNode(output);
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+    const OpRegistrationData* op_reg_data = nullptr;
+    TF_RETURN_IF_ERROR(
+        OpRegistry::Global()->LookUp(output_node->op(), &op_reg_data));
+    TF_RETURN_IF_ERROR(InOutTypesForNode(*output_node, op_reg_data->op_def,
+                                         &input_types, &output_types));
+    if (output_tensor.index() >= output_types.size()) {
+      return errors::InvalidArgument("Invalid output ", output);
+    }
+    const DataType type = output_types[output_tensor.index()];
+    const string var = StrCat("var_", i);
+
+    // Initial value of the loop variable: the prefix of the first iteration,
+    // or an empty tensor if the loop doesn't run at all.
+    NodeDef* empty = AddNode(name(StrCat(var, "/empty")), "Const",
+                             output_node->device(), {}, DT_INVALID);
+    (*empty->mutable_attr())["dtype"].set_type(type);
+    TensorProto* empty_value =
+        (*empty->mutable_attr())["value"].mutable_tensor();
+    empty_value->set_dtype(type);
+    empty_value->mutable_tensor_shape()->add_dim()->set_size(0);
+    const NodeDef* empty_switch =
+        AddNode(name(StrCat(var, "/empty_switch")), "Switch", device,
+                {empty->name(), first_predicate}, type);
+    NodeDef* initial_value = AddNode(
+        name(StrCat(var, "/initial")), "Merge", device,
+        {clone_tensor(output, first_clones), empty_switch->name()}, type);
+    (*initial_value->mutable_attr())["N"].set_i(2);
+
+    // The loop variable.
+    NodeDef* enter = AddNode(name(StrCat(var, "/enter")), "Enter", device,
+                             {initial_value->name()}, type);
+    (*enter->mutable_attr())["frame_name"] =
+        index_enter.attr().at("frame_name");
+    (*enter->mutable_attr())["is_constant"].set_b(false);
+    (*enter->mutable_attr())["parallel_iterations"] =
+        index_enter.attr().at("parallel_iterations");
+    NodeDef* merge = AddNode(name(StrCat(var, "/merge")), "Merge", device,
+                             {enter->name()}, type);
+    (*merge->mutable_attr())["N"].set_i(2);
+    const NodeDef* var_switch =
+        AddNode(name(StrCat(var, "/switch")), "Switch", device,
+                {merge->name(), loop.loop_cond->name()}, type);
+    const NodeDef* identity =
+        AddNode(name(StrCat(var, "/identity")), "Identity", device,
+                {StrCat(var_switch->name(), ":1")}, type);
+
+    // Next value of the loop variable: the prefix of the next iteration, or
+    // the current value if the loop stops.
+    const NodeDef* keep_switch =
+        AddNode(name(StrCat(var, "/keep_switch")), "Switch", device,
+                {identity->name(), next_predicate}, type);
+    NodeDef* next_value = AddNode(
+        name(StrCat(var, "/next")), "Merge", device,
+        {clone_tensor(output, next_clones), keep_switch->name()}, type);
+    (*next_value->mutable_attr())["N"].set_i(2);
+    const NodeDef* next_iteration =
+        AddNode(name(StrCat(var, "/next_iteration")), "NextIteration", device,
+                {next_value->name()}, type);
+    merge->add_input(next_iteration->name());
+    node_map_->AddOutput(next_iteration->name(), merge->name());
+
+    // The rest of the body reads the prefix from the loop variable.
+    for (NodeDef* consumer :
+         node_map_->GetOutputsOrderedByNodeName(output_node->name())) {
+      if (loop.prefix_names.contains(consumer->name())) continue;
+      for (int j = 0; j < consumer->input_size(); ++j) {
+        if (ParseTensorName(consumer->input(j)) == output_tensor) {
+          node_map_->UpdateInput(consumer->name(), consumer->input(j),
+                                 identity->name());
+          consumer->set_input(j, identity->name());
+        }
+      }
+    }
+  }
+  VLOG(1) << "Pipelined " << loop.prefix.size() << " nodes of loop "
+          << index_enter.attr().at("frame_name").s();
+  return Status::OK();
+}
+
+Status LoopPipeliningOptimizer::Optimize() {
+  node_map_.reset(new NodeMap(optimized_graph_));
+  TF_RETURN_IF_ERROR(frame_view_.InferFromGraph(*optimized_graph_));
+
+  std::vector<PipelinedLoop> loops;
+  for (const NodeDef& node : optimized_graph_->node()) {
+    if (!IsLoopCond(node)) continue;
+    // Only top-level loops are pipelined.
+    const std::vector<int>& frame_ids = frame_view_.Frames(node);
+    if (frame_ids.size() != 1) continue;
+    PipelinedLoop loop;
+    if (FindIndexVariable(node, frame_ids[0], &loop) &&
+        FindPrefix(frame_ids[0], &loop)) {
+      loops.push_back(std::move(loop));
+    }
+  }
+
+  std::set<string> nodes_to_delete;
+  for (const PipelinedLoop& loop : loops) {
+    TF_RETURN_IF_ERROR(Pipeline(loop));
+    nodes_to_delete.insert(loop.prefix_names.begin(), loop.prefix_names.end());
+  }
+  EraseNodesFromGraph(nodes_to_delete, optimized_graph_);
+  return Status::OK();
+}
+
 bool IsSimpleBinaryOperator(const NodeDef& node) {
   return (IsLess(node) || IsLessEqual(node) || IsGreater(node) ||
           IsGreaterEqual(node) || IsEqual(node));
@@ -725,7 +1209,7 @@ LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
                              DeviceBase* cpu_device)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -733,6 +1217,7 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   if (!options_.enable_loop_invariant_node_motion &&
       !options_.enable_stack_push_removal &&
+      !options_.enable_loop_pipelining &&
       !options_.enable_dead_branch_removal) {
     return errors::Aborted("Nothing to do.");
   }
@@ -745,6 +1230,11 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   if (options_.enable_stack_push_removal) {
     TF_RETURN_IF_ERROR(RemoveStackOps(item.NodesToPreserve(), optimized_graph));
   }
+  if (options_.enable_loop_pipelining) {
+    LoopPipeliningOptimizer pipelining_optimizer(item.NodesToPreserve(),
+                                                 optimized_graph);
+    TF_RETURN_IF_ERROR(pipelining_optimizer.Optimize());
+  }
   if (options_.enable_dead_branch_removal) {
     NodeMap node_map(optimized_graph);
     absl::flat_hash_set<string> feed_nodes;
@@ -56,9 +56,13 @@ class LoopOptimizer : public GraphOptimizer {
     bool enable_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
+    // Pipelining computes the prefix of the next iteration speculatively
+    // during the current one, so it is only done in aggressive mode.
+    bool enable_loop_pipelining = false;
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
+      options.enable_loop_pipelining = opt_level == RewriterConfig::AGGRESSIVE;
       return options;
     }
   };
@@ -70,11 +70,17 @@ class LoopOptimizerTest : public GrapplerTest {
     optimizer->options_.enable_stack_push_removal = true;
   }
 
+  void EnableOnlyLoopPipelining(LoopOptimizer* optimizer) {
+    DisableAllStages(optimizer);
+    optimizer->options_.enable_loop_pipelining = true;
+  }
+
  private:
   void DisableAllStages(LoopOptimizer* optimizer) {
     LoopOptimizer::LoopOptimizerOptions options;
     options.enable_loop_invariant_node_motion = false;
     options.enable_stack_push_removal = false;
+    options.enable_loop_pipelining = false;
     optimizer->options_ = options;
   }
 };
@@ -1689,5 +1695,118 @@ versions {
   EXPECT_TRUE(found);
 }
 
+TEST_F(LoopOptimizerTest, PipelineLoopPrefix) {
+  // acc = 0; for (i = 0; i < n; ++i) acc += Square(Gather(table, i))
+  for (const int n : {5, 0}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    ops::Const(s.WithOpName("table"), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f}, {5});
+    ops::Const(s.WithOpName("n"), n);
+    ops::Const(s.WithOpName("zero"), 0);
+    ops::Const(s.WithOpName("acc0"), 0.0f);
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    GraphDef* graph = &item.graph;
+
+    const auto attrs = [](DataType type) {
+      AttrValue attr;
+      attr.set_type(type);
+      return std::vector<std::pair<string, AttrValue>>{{"T", attr}};
+    };
+    const auto add_enter = [&](const string& name, const string& input,
+                               DataType type, bool is_constant) {
+      auto attributes = attrs(type);
+      AttrValue frame_name;
+      frame_name.set_s("while");
+      attributes.emplace_back("frame_name", frame_name);
+      AttrValue is_const;
+      is_const.set_b(is_constant);
+      attributes.emplace_back("is_constant", is_const);
+      AttrValue parallel_iterations;
+      parallel_iterations.set_i(1);
+      attributes.emplace_back("parallel_iterations", parallel_iterations);
+      AddNode(name, "Enter", {input}, attributes, graph);
+    };
+    const auto add_const = [&](const string& name, int32 value) {
+      AttrValue dtype;
+      dtype.set_type(DT_INT32);
+      AttrValue tensor;
+      test::AsScalar<int32>(value).AsProtoTensorContent(
+          tensor.mutable_tensor());
+      AddNode(name, "Const", {"^while/Identity_i"},
+              {{"dtype", dtype}, {"value", tensor}}, graph);
+    };
+    add_enter("while/Enter_i", "zero", DT_INT32, false);
+    add_enter("while/Enter_acc", "acc0", DT_FLOAT, false);
+    add_enter("while/Enter_n", "n", DT_INT32, true);
+    add_enter("while/Enter_table", "table", DT_FLOAT, true);
+    AddNode("while/Merge_i", "Merge", {"while/Enter_i", "while/Next_i"},
+            attrs(DT_INT32), graph);
+    AddNode("while/Merge_acc", "Merge", {"while/Enter_acc", "while/Next_acc"},
+            attrs(DT_FLOAT), graph);
+    AddNode("while/Less", "Less", {"while/Merge_i", "while/Enter_n"},
+            attrs(DT_INT32), graph);
+    AddNode("while/LoopCond", "LoopCond", {"while/Less"}, {}, graph);
+    AddNode("while/Switch_i", "Switch", {"while/Merge_i", "while/LoopCond"},
+            attrs(DT_INT32), graph);
+    AddNode("while/Switch_acc", "Switch", {"while/Merge_acc", "while/LoopCond"},
+            attrs(DT_FLOAT), graph);
+    AddNode("while/Identity_i", "Identity", {"while/Switch_i:1"},
+            attrs(DT_INT32), graph);
+    AddNode("while/Identity_acc", "Identity", {"while/Switch_acc:1"},
+            attrs(DT_FLOAT), graph);
+    add_const("while/one", 1);
+    add_const("while/axis", 0);
+    AddNode("while/add_i", "AddV2", {"while/Identity_i", "while/one"},
+            attrs(DT_INT32), graph);
+    AttrValue float_type;
+    float_type.set_type(DT_FLOAT);
+    AttrValue int_type;
+    int_type.set_type(DT_INT32);
+    AttrValue batch_dims;
+    batch_dims.set_i(0);
+    AddNode("while/Gather", "GatherV2",
+            {"while/Enter_table", "while/Identity_i", "while/axis"},
+            {{"Tparams", float_type},
+             {"Tindices", int_type},
+             {"Taxis", int_type},
+             {"batch_dims", batch_dims}},
+            graph);
+    AddNode("while/Square", "Square", {"while/Gather"}, attrs(DT_FLOAT), graph);
+    AddNode("while/add_acc", "AddV2", {"while/Identity_acc", "while/Square"},
+            attrs(DT_FLOAT), graph);
+    AddNode("while/Next_i", "NextIteration", {"while/add_i"}, attrs(DT_INT32),
+            graph);
+    AddNode("while/Next_acc", "NextIteration", {"while/add_acc"},
+            attrs(DT_FLOAT), graph);
+    AddNode("while/Exit_acc", "Exit", {"while/Switch_acc"}, attrs(DT_FLOAT),
+            graph);
+    item.fetch = {"while/Exit_acc"};
+
+    LoopOptimizer optimizer;
+    EnableOnlyLoopPipelining(&optimizer);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    // The lookup of the next step moved to a new loop variable.
+    NodeMap node_map(&output);
+    EXPECT_EQ(node_map.GetNode("while/Gather"), nullptr);
+    EXPECT_EQ(node_map.GetNode("while/Square"), nullptr);
+    const NodeDef* add_acc = node_map.GetNode("while/add_acc");
+    ASSERT_NE(add_acc, nullptr);
+    ASSERT_EQ(add_acc->input_size(), 2);
+    EXPECT_EQ(add_acc->input(1),
+              "LoopOptimizer/while/Identity_i/pipelined/var_0/identity");
+
+    // The lookup is never evaluated out of bounds.
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+    auto tensors = EvaluateNodes(output, item.fetch);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+    test::ExpectTensorEqual<float>(
+        tensors[0], test::AsScalar<float>(n == 5 ? 55.0f : 0.0f));
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
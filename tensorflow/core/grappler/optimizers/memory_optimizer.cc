@@ -440,9 +440,74 @@ void RecomputeSubgraph(
   }
 }
 
+// Selects the candidates for recomputation whose outputs are live at the
+// predicted memory peak of a device whose peak exceeds `memory_budget` (or the
+// memory size of the device if `memory_budget` is 0). The largest outputs are
+// selected first, until recomputing them would bring the peak below the
+// budget. Returns false if the peak memory usage can't be predicted or no
+// budget is known for any device.
+bool SelectRecomputationsForPeakMemory(
+    Cluster* cluster, const GrapplerItem& item, int64 memory_budget,
+    const std::unordered_set<const NodeDef*>& candidates,
+    std::unordered_set<string>* nodes_to_recompute) {
+  GraphMemory memory(item);
+  Status s = memory.InferStatically(cluster->GetDevices());
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return false;
+  }
+  std::unordered_set<string> candidate_names;
+  for (const NodeDef* candidate : candidates) {
+    candidate_names.insert(candidate->name());
+  }
+
+  bool has_budget = false;
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const int64 budget =
+        memory_budget > 0 ? memory_budget : device.second.memory_size();
+    if (budget <= 0) {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory < 0) {
+      continue;
+    }
+    has_budget = true;
+    if (mem_usage.used_memory <= budget) {
+      continue;
+    }
+    std::vector<const GraphMemory::LiveTensor*> live_candidates;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (candidate_names.count(live_tensor.node) > 0) {
+        live_candidates.push_back(&live_tensor);
+      }
+    }
+    std::sort(live_candidates.begin(), live_candidates.end(),
+              [](const GraphMemory::LiveTensor* a,
+                 const GraphMemory::LiveTensor* b) {
+                return a->memory_used > b->memory_used;
+              });
+    int64 peak = mem_usage.used_memory;
+    for (const GraphMemory::LiveTensor* live_tensor : live_candidates) {
+      if (peak <= budget) {
+        break;
+      }
+      nodes_to_recompute->insert(live_tensor->node);
+      peak -= live_tensor->memory_used;
+    }
+    VLOG(1) << "Recomputation reduces the predicted peak memory of " << name
+            << " from " << mem_usage.used_memory << " to " << peak
+            << " bytes (budget: " << budget << " bytes)";
+  }
+  return has_budget;
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
-                                GraphDef* graph, const GrapplerItem& item) {
+                                int64 memory_budget, Cluster* cluster,
+                                GrapplerItem* item) {
+  GraphDef* graph = &item->graph;
   // The topological numberings and NodeMap will be stale as soon as we start
   // modifying the graph in RecomputeSubgraph. However, RecomputeSubgraph only
   // looks up nodes which were in the original graph, and preserves the graph
@@ -456,7 +521,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
   // Do not recompute nodes which are fed, since the recomputed node would not
   // take on the fed value (i.e. gradients would be incorrect).
   std::unordered_set<string> feeds;
-  for (const auto& feed : item.feed) {
+  for (const auto& feed : item->feed) {
     feeds.insert(NodeName(feed.first));
   }
   std::function<bool(const NodeDef&)> is_target =
@@ -480,14 +545,34 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
     // separated by identity ops).
     std::unordered_set<string> cheap_to_recompute_ops =
         GetCheapToRecomputeOps();
-    recomputed_subgraphs = GetOpGroupsToRecompute(
-        graph, node_map,
+    std::function<bool(const NodeDef&)> is_cheap_to_recompute =
         [&cheap_to_recompute_ops, &feeds, &is_target](const NodeDef& node) {
           return !is_target(node) && feeds.count(node.name()) == 0 &&
                  (cheap_to_recompute_ops.count(node.op()) > 0 ||
                   node.attr().count(kRecomputeHint) > 0);
-        },
-        is_target);
+        };
+    // If the peak memory usage can be predicted, only recompute the cheap ops
+    // needed to fit the peak into the memory budget, and otherwise all of
+    // them.
+    std::unordered_set<string> nodes_to_recompute;
+    if (cluster != nullptr && !item->fetch.empty() &&
+        SelectRecomputationsForPeakMemory(
+            cluster, *item, memory_budget,
+            FindCandidateRecomputeNodes(node_map, graph,
+                                        is_cheap_to_recompute, is_target),
+            &nodes_to_recompute)) {
+      recomputed_subgraphs = GetOpGroupsToRecompute(
+          graph, node_map,
+          [&nodes_to_recompute, &is_cheap_to_recompute](const NodeDef& node) {
+            return is_cheap_to_recompute(node) &&
+                   (nodes_to_recompute.count(node.name()) > 0 ||
+                    node.attr().count(kRecomputeHint) > 0);
+          },
+          is_target);
+    } else {
+      recomputed_subgraphs = GetOpGroupsToRecompute(
+          graph, node_map, is_cheap_to_recompute, is_target);
+    }
   } else if (optimization_level == RewriterConfig::MANUAL) {
     recomputed_subgraphs = GetOpGroupsToRecompute(
         graph, node_map,
@@ -1395,9 +1480,9 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   RelaxAssignNodes(nodes_to_relax, &optimized_item.graph);
 
   if (run_recomputation_pass) {
-    RecomputationRewritingPass(optimization_level_,
-                               recomputation_targets_name_scope_,
-                               &optimized_item.graph, item);
+    RecomputationRewritingPass(
+        optimization_level_, recomputation_targets_name_scope_,
+        memory_budget_bytes_, cluster, &optimized_item);
   }
 
   std::unordered_set<string> skip_list;
@@ -20,6 +20,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -448,6 +449,57 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, RecomputationDrivenByPeakMemory) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output a = ops::RandomNormal(s.WithOpName("a"), {128, 128, 8}, DT_FLOAT);
+  Output b = ops::Sqrt(s.WithOpName("b"), a);
+  Output c = ops::Square(s.WithOpName("c"), b);
+  Output d = ops::AddN(s.WithOpName("gradients/d"), {c});
+  Output e = ops::AddN(s.WithOpName("gradients/e"), {d, b});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  auto count_recomputed_nodes = [](const GraphDef& graph) {
+    int count = 0;
+    for (const NodeDef& node : graph.node()) {
+      if (absl::StartsWith(node.name(), "Recomputed/")) ++count;
+    }
+    return count;
+  };
+
+  // The predicted peak fits into the budget: nothing is recomputed.
+  {
+    MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                              "gradients/",
+                              /*memory_budget_bytes=*/int64{1} << 40);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+    EXPECT_EQ(0, count_recomputed_nodes(output));
+  }
+
+  // The predicted peak exceeds the budget: `b`, which is live at the peak, is
+  // recomputed for `gradients/e`.
+  {
+    MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                              "gradients/", /*memory_budget_bytes=*/1);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+    EXPECT_LT(0, count_recomputed_nodes(output));
+    NodeMap node_map(&output);
+    const NodeDef* new_e = node_map.GetNode("gradients/e");
+    ASSERT_NE(nullptr, new_e);
+    EXPECT_EQ("Recomputed/b", new_e->input(1));
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, {});
+    auto tensors = EvaluateNodes(output, item.fetch, {});
+    ASSERT_EQ(1, tensors.size());
+    EXPECT_EQ(tensors_expected[0].shape(), tensors[0].shape());
+  }
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
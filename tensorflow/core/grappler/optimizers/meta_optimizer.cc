@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
@@ -35,10 +38,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
 #include "tensorflow/core/grappler/optimizers/debug_stripper.h"
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
+#include "tensorflow/core/grappler/optimizers/locality_aware_placement.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/micro_batch_pipeline.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
@@ -52,8 +58,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -81,6 +92,40 @@ string PrintSizesBeforeAfter(const GraphDef& before, const GraphDef& after) {
                          NumEdges(after) - NumEdges(before), ")");
 }
 
+// Returns the execution time of `graph` predicted by AnalyticalCostEstimator,
+// or -1 if it can't be estimated.
+int64 EstimateExecutionTimeNs(Cluster* cluster, const GrapplerItem& item,
+                              const GraphDef& graph) {
+  GrapplerItem estimated_item = item.WithGraph(GraphDef(graph));
+  AnalyticalCostEstimator estimator(cluster, /*use_static_shapes=*/true,
+                                    /*use_aggressive_shape_inference=*/false);
+  Costs costs;
+  Status status = estimator.Initialize(estimated_item);
+  if (status.ok()) {
+    status = estimator.PredictCosts(estimated_item.graph,
+                                    /*run_metadata=*/nullptr, &costs);
+  }
+  if (!status.ok()) {
+    VLOG(2) << "Failed to estimate the cost of " << item.id << ": " << status;
+    return -1;
+  }
+  return costs.execution_time.count();
+}
+
+// Returns the maximum number of library functions that are optimized
+// concurrently. Setting TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS to 1
+// optimizes functions one by one.
+int64 NumFunctionOptimizationThreads() {
+  int64 num_threads;
+  Status s = ReadInt64FromEnvVar("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS",
+                                 port::MaxParallelism(), &num_threads);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    num_threads = port::MaxParallelism();
+  }
+  return std::max<int64>(num_threads, 1);
+}
+
 int NumIterations(const RewriterConfig& cfg) {
   return cfg.meta_optimizer_iterations() == RewriterConfig::DEFAULT_NUM_ITERS
              ? kDefaultNumberOfIterations
@@ -205,7 +250,11 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
              !cfg_.experimental_disable_folding_quantization_emulation()));
   MK_OPT("shape", "shape_optimization", new ShapeOptimizer());
   MK_OPT("remap", "remapping",
-         new Remapper(cfg_.remapping(), xla_auto_clustering_on_));
+         new Remapper(cfg_.remapping(), xla_auto_clustering_on_,
+                      cost_profile_));
+  MK_OPT("elementwise_fusion", "elementwise_fusion",
+         new ElementwiseFusion(cfg_.elementwise_fusion(),
+                               xla_auto_clustering_on_));
   MK_OPT("layout", "layout_optimizer",
          new GenericLayoutOptimizer(
              /*optimization level*/ cfg_.layout_optimizer(),
@@ -223,9 +272,13 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("common_subgraph_elimination", "common_subgraph_elimination",
          new CommonSubgraphElimination(cfg_.common_subgraph_elimination()));
   MK_OPT("arithmetic", "arithmetic_optimization",
-         new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
+         new ArithmeticOptimizer(cfg_.arithmetic_optimization(),
+                                 cost_profile_));
   MK_OPT("autoparallel", "auto_parallel",
          new AutoParallel(cfg_.auto_parallel().num_replicas()));
+  MK_OPT("micro_batch_pipeline", "micro_batch_pipeline",
+         new MicroBatchPipeline(
+             cfg_.micro_batch_pipeline().num_micro_batches()));
   MK_OPT("loop", "loop_optimization",
          new LoopOptimizer(cfg_.loop_optimization(), cpu_device_));
   MK_OPT("dependency", "dependency_optimization",
@@ -236,6 +289,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host", "pin_to_host_optimization",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("locality_aware_placement", "locality_aware_placement",
+         new LocalityAwarePlacement(cfg_.locality_aware_placement()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -251,6 +306,15 @@ MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
   auto global_jit_level =
       cfg.graph_options().optimizer_options().global_jit_level();
   xla_auto_clustering_on_ = IsXlaGlobalJitOn(global_jit_level);
+  if (!cfg_.experimental_cost_profile_path().empty()) {
+    Status s = OpCostProfile::Load(cfg_.experimental_cost_profile_path(),
+                                   &cost_profile_);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to load cost profile, fusions will not be "
+                      "guided by measured op costs: "
+                   << s;
+    }
+  }
 }
 
 Status MetaOptimizer::InitializeOptimizers(
@@ -294,7 +358,8 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(MakeUnique<ConstantFolding>(
         cfg_.constant_folding(), cpu_device_,
         cfg_.experimental_disable_compressed_tensor_optimization(),
-        !cfg_.experimental_disable_folding_quantization_emulation()));
+        !cfg_.experimental_disable_folding_quantization_emulation(),
+        cfg_.constant_folding_cache_dir()));
   }
   if (BOTH_NOT_OFF(shape_optimization)) {
     optimizers->push_back(MakeUnique<ShapeOptimizer>());
@@ -319,7 +384,8 @@ Status MetaOptimizer::InitializeOptimizers(
   }
   if (BOTH_NOT_OFF(arithmetic_optimization)) {
     optimizers->push_back(
-        MakeUnique<ArithmeticOptimizer>(cfg_.arithmetic_optimization()));
+        MakeUnique<ArithmeticOptimizer>(cfg_.arithmetic_optimization(),
+                                        cost_profile_));
   }
   if (BOTH_NOT_OFF(layout_optimizer)) {
     optimizers->push_back(MakeUnique<GenericLayoutOptimizer>(
@@ -328,7 +394,12 @@ Status MetaOptimizer::InitializeOptimizers(
   }
   if (BOTH_NOT_OFF(remapping)) {
     optimizers->push_back(
-        MakeUnique<Remapper>(cfg_.remapping(), xla_auto_clustering_on_));
+        MakeUnique<Remapper>(cfg_.remapping(), xla_auto_clustering_on_,
+                             cost_profile_));
+  }
+  if (BOTH_ARE_ON(elementwise_fusion)) {
+    optimizers->push_back(MakeUnique<ElementwiseFusion>(
+        cfg_.elementwise_fusion(), xla_auto_clustering_on_));
   }
   if (BOTH_NOT_OFF(loop_optimization)) {
     optimizers->push_back(
@@ -344,17 +415,28 @@ Status MetaOptimizer::InitializeOptimizers(
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
       optimizers->push_back(
           // Use the default target node name prefix "gradients/"
-          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization()));
+          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization(), "gradients/",
+                                      cfg_.memory_optimizer_budget_bytes()));
     } else {
       optimizers->push_back(MakeUnique<MemoryOptimizer>(
           cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
+          cfg_.memory_optimizer_target_node_name_scope(),
+          cfg_.memory_optimizer_budget_bytes()));
     }
   }
   if (cfg_.auto_parallel().enable() && PLUGIN_IS_ON(auto_parallel)) {
     optimizers->push_back(
         MakeUnique<AutoParallel>(cfg_.auto_parallel().num_replicas()));
   }
+  if (cfg_.micro_batch_pipeline().enable() &&
+      PLUGIN_IS_ON(micro_batch_pipeline)) {
+    optimizers->push_back(MakeUnique<MicroBatchPipeline>(
+        cfg_.micro_batch_pipeline().num_micro_batches()));
+  }
+  if (BOTH_ARE_ON(locality_aware_placement)) {
+    optimizers->push_back(MakeUnique<LocalityAwarePlacement>(
+        cfg_.locality_aware_placement()));
+  }
 
 #ifndef ENABLE_MKL
   if (BOTH_ARE_ON(scoped_allocator_optimization)) {
@@ -498,8 +580,10 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
     PRINT_CFG(constant_folding)
     PRINT_CFG(shape_optimization)
     PRINT_CFG(pin_to_host_optimization)
+    PRINT_CFG(locality_aware_placement)
     PRINT_CFG(layout_optimizer)
     PRINT_CFG(remapping)
+    PRINT_CFG(elementwise_fusion)
     PRINT_CFG(loop_optimization)
     PRINT_CFG(dependency_optimization)
     PRINT_CFG(scoped_allocator_optimization)
@@ -522,6 +606,9 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
     user_cfg.toggle_config["auto_parallel"] = cfg_.auto_parallel().enable()
                                                   ? RewriterConfig::ON
                                                   : RewriterConfig::OFF;
+    user_cfg.toggle_config["micro_batch_pipeline"] =
+        cfg_.micro_batch_pipeline().enable() ? RewriterConfig::ON
+                                             : RewriterConfig::OFF;
   } else {
     for (const string& optimizer_name : cfg_.optimizers()) {
       if (optimizer_name == "pruning") user_cfg.disable_model_pruning = true;
@@ -540,12 +627,15 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
       PRINT_CFG("auto_mixed_precision", "auto_mixed_precision")
       PRINT_CFG("auto_mixed_precision_mkl", "auto_mixed_precision_mkl")
       PRINT_CFG("pin_to_host", "pin_to_host_optimization")
+      PRINT_CFG("locality_aware_placement", "locality_aware_placement")
       PRINT_CFG("layout", "layout_optimizer")
       PRINT_CFG("remap", "remapping")
+      PRINT_CFG("elementwise_fusion", "elementwise_fusion")
       PRINT_CFG("loop", "loop_optimization")
       PRINT_CFG("dependency", "dependency_optimization")
       PRINT_CFG("memory", "memory_optimization")
       PRINT_CFG("autoparallel", "auto_parallel")
+      PRINT_CFG("micro_batch_pipeline", "micro_batch_pipeline")
       PRINT_CFG("scoped_allocator", "scoped_allocator_optimization")
 #undef PRINT_CFG
     }
@@ -601,6 +691,13 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
 
 Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                     GraphDef* optimized_graph) {
+  return OptimizeGraph(cluster, std::move(item), optimized_graph,
+                       &optimization_results_);
+}
+
+Status MetaOptimizer::OptimizeGraph(
+    Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+    std::vector<GraphOptimizationResult>* optimization_results) {
   int min_graph_nodes = cfg_.min_graph_nodes() == 0 ? kDefaultMinGraphNodes
                                                     : cfg_.min_graph_nodes();
   if (item.graph.node_size() < min_graph_nodes) {
@@ -657,6 +754,13 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
   GraphOptimizationResult optimization_result(item.id);
   GraphOptimizer* sa_optimizer = nullptr;
 
+  // Record the graph optimization result, also if the deadline cut it short.
+  auto record_result = gtl::MakeCleanup([&]() {
+    optimization_result.wall_time_us = Env::Default()->NowMicros() - start_us;
+    optimization_result.deadline_exceeded = DeadlineExceeded();
+    optimization_results->push_back(std::move(optimization_result));
+  });
+
   // Constants in the graph are normally compressed after model_pruner.
   // Do it here if model pruner is disabled.
   if (cfg_.disable_model_pruning()) {
@@ -692,8 +796,9 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
       }
 #endif
 
-      TF_RETURN_IF_ERROR(RunOptimizer(optimizer.get(), cluster, &item,
-                                      optimized_graph, &optimization_result));
+      TF_RETURN_IF_ERROR(RunOptimizer(optimizer.get(), iteration, cluster,
+                                      &item, optimized_graph,
+                                      &optimization_result));
 
       if (iteration == 0 && optimizer->name() == "model_pruner") {
         CompressConstants(optimized_graph);
@@ -725,8 +830,9 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
 #ifndef ENABLE_MKL
   // ScopedAllocatorOptimizer must run last.
   if (sa_optimizer != nullptr) {
-    TF_RETURN_IF_ERROR(RunOptimizer(sa_optimizer, cluster, &item,
-                                    optimized_graph, &optimization_result));
+    TF_RETURN_IF_ERROR(RunOptimizer(sa_optimizer, NumIterations(cfg_) - 1,
+                                    cluster, &item, optimized_graph,
+                                    &optimization_result));
     GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
   }
 #endif
@@ -737,9 +843,6 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                      return result.status.ok();
                                    }) != optimization_result.results.end();
 
-  // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
-
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
     ReassignColocation(optimized_graph);
@@ -754,8 +857,22 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
 }
 
 Status MetaOptimizer::RunOptimizer(
-    GraphOptimizer* optimizer, Cluster* cluster, GrapplerItem* optimized_item,
-    GraphDef* optimized_graph, GraphOptimizationResult* optimization_result) {
+    GraphOptimizer* optimizer, int iteration, Cluster* cluster,
+    GrapplerItem* optimized_item, GraphDef* optimized_graph,
+    GraphOptimizationResult* optimization_result) {
+  PassReport report;
+  report.set_optimizer(optimizer->name());
+  report.set_iteration(iteration);
+  report.set_num_nodes_before(optimized_graph->node_size());
+  report.set_num_edges_before(NumEdges(*optimized_graph));
+
+  const bool estimate_cost =
+      cfg_.experimental_optimization_report() && cluster != nullptr;
+  if (estimate_cost && optimization_result->estimated_time_ns < 0) {
+    optimization_result->estimated_time_ns =
+        EstimateExecutionTimeNs(cluster, *optimized_item, *optimized_graph);
+  }
+
   const uint64 start_us = Env::Default()->NowMicros();
 
   // If optimizer doesn't need a function library, we will replace it with a
@@ -782,6 +899,8 @@ Status MetaOptimizer::RunOptimizer(
   const float duration_ms = (end_us - start_us) / 1000.0f;
   metrics::UpdateGrapplerPassTime(optimizer->name(), end_us - start_us);
 
+  report.set_wall_time_us(end_us - start_us);
+
   string message;
   if (!status.ok()) {
     optimized_graph->Swap(&optimized_item->graph);
@@ -792,13 +911,17 @@ Status MetaOptimizer::RunOptimizer(
                                 " did nothing. time = ", duration_ms, "ms.");
       // Swallow the non-critical error.
       status = Status::OK();
+      report.set_no_change(true);
     } else if (errors::IsDeadlineExceeded(status)) {
       message =
           strings::StrCat(status.ToString(), ", time = ", duration_ms, "ms.");
       LOG(WARNING) << optimizer->name() << " failed: " << message;
+      report.set_deadline_exceeded(true);
+      report.set_error(status.ToString());
     } else {
       message = status.ToString();
       LOG(ERROR) << optimizer->name() << " failed: " << message;
+      report.set_error(status.ToString());
     }
   } else {
     message = strings::StrCat(
@@ -812,8 +935,25 @@ Status MetaOptimizer::RunOptimizer(
     optimized_graph->mutable_library()->Swap(&optimized_graph_function_library);
   }
 
-  OptimizerResult optimizer_result{optimizer->name(), message, status};
-  optimization_result->results.push_back(optimizer_result);
+  report.set_num_nodes_after(optimized_graph->node_size());
+  report.set_num_edges_after(NumEdges(*optimized_graph));
+  metrics::UpdateGrapplerPassReport(
+      optimizer->name(), report.wall_time_us(),
+      report.num_nodes_after() - report.num_nodes_before(),
+      report.deadline_exceeded());
+
+  if (estimate_cost) {
+    report.set_estimated_time_before_ns(optimization_result->estimated_time_ns);
+    if (status.ok() && !report.no_change()) {
+      optimization_result->estimated_time_ns =
+          EstimateExecutionTimeNs(cluster, *optimized_item, *optimized_graph);
+    }
+    report.set_estimated_time_after_ns(optimization_result->estimated_time_ns);
+  }
+
+  OptimizerResult optimizer_result{optimizer->name(), message, status,
+                                   std::move(report)};
+  optimization_result->results.push_back(std::move(optimizer_result));
 
   if (!status.ok() && cfg_.fail_on_optimizer_errors()) return status;
 
@@ -883,6 +1023,15 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
   optimization_results_.clear();
+  optimization_wall_time_us_ = 0;
+
+  // Record the total optimization time, also if the deadline cut it short.
+  auto record_report = gtl::MakeCleanup([this, start_us]() {
+    optimization_wall_time_us_ = Env::Default()->NowMicros() - start_us;
+    if (cfg_.experimental_optimization_report()) {
+      DumpProtoToFile("grappler_optimization_report", GetOptimizationReport());
+    }
+  });
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -989,8 +1138,107 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
+
+  // Function bodies are optimized in batches of functions that do not call
+  // each other. Functions of a batch are optimized concurrently, and the
+  // results are committed to `flib` in library order, so that the optimized
+  // graph is identical to the one produced by optimizing functions one by one.
+  struct FunctionOptimization {
+    string name;
+    GrapplerFunctionItem item;
+    GraphDef optimized_graph;
+    Status status;
+    std::vector<GraphOptimizationResult> results;
+  };
+  const int64 num_threads = NumFunctionOptimizationThreads();
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+  std::vector<FunctionOptimization> batch;
+  absl::flat_hash_set<string> batch_funcs;
+
   while (optimize_function_library) {
     optimize_function_library = false;
+    const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
+
+    // Optimizes the body of a single function. Might run concurrently with
+    // other functions of the batch, and must not touch shared state.
+    const auto optimize_function = [&](FunctionOptimization* f) {
+      if (is_tpu_graph) {
+        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+        // passes do not handle TPU functions correctly in a variety of ways
+        // (Note that due to the pre-placement TPU graph rewriting passes, the
+        // TPU-related ops are encapsulated away into functions). For example,
+        // TPU graphs contain TPUReplicateMetadata node that carries relevant
+        // TPU metadata and Grappler passes could prune that away. Grappler
+        // passes could also cause issues around shape inference. Since the
+        // desired and existing behavior is to not optimize TPU functions with
+        // Grappler, this check preserves that. The only exception is
+        // implementation selector what is required to swap in some TPU specific
+        // lowering code and is verified the work correctly on TPUs.
+        ImplementationSelector implementation_selector;
+
+        // Implementation selector needs to have access to valid function
+        // signature and attributes, and it doesn't need actual function body.
+        FunctionDefLibrary func_item_function_library;
+        func_item_function_library.Swap(f->item.graph.mutable_library());
+        *f->item.graph.mutable_library() =
+            GetFunctionDefLibraryStub(func_item_function_library);
+
+        f->status = implementation_selector.Optimize(cluster, f->item,
+                                                     &f->optimized_graph);
+      } else {
+        GrapplerFunctionItem func_item_copy = f->item;
+        f->status = OptimizeGraph(cluster, std::move(func_item_copy),
+                                  &f->optimized_graph, &f->results);
+      }
+    };
+
+    // Optimizes all functions of the batch and replaces them in `flib`.
+    const auto optimize_batch = [&]() -> Status {
+      if (batch.size() == 1) {
+        optimize_function(&batch[0]);
+      } else if (!batch.empty()) {
+        if (!thread_pool) {
+          thread_pool = absl::make_unique<thread::ThreadPool>(
+              Env::Default(), "meta_optimizer_functions", num_threads);
+        }
+        BlockingCounter counter(batch.size());
+        for (FunctionOptimization& f : batch) {
+          thread_pool->Schedule([&optimize_function, &counter, &f]() {
+            optimize_function(&f);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
+      }
+
+      for (FunctionOptimization& f : batch) {
+        TF_RETURN_IF_ERROR(f.status);
+        for (GraphOptimizationResult& result : f.results) {
+          result.is_function = true;
+          optimization_results_.push_back(std::move(result));
+        }
+
+        // Function body optimization might have created new specialized
+        // functions for each instantiation context. Add them to the library.
+        for (const FunctionDef& func_def :
+             f.optimized_graph.library().function()) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
+        }
+
+        // Convert optimized graph back to FunctionDef.
+        FunctionDef optimized_func;
+        f.item.SwapFunctionBody(std::move(f.optimized_graph));
+        TF_RETURN_IF_ERROR(MakeFunctionDef(f.item, flib, &optimized_func));
+
+        // Replace optimized function with a new FunctionDef.
+        TF_RETURN_IF_ERROR(flib.ReplaceFunction(f.name, optimized_func));
+      }
+      batch.clear();
+      batch_funcs.clear();
+      return Status::OK();
+    };
 
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
@@ -1025,20 +1273,35 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       optimized_funcs.insert(func_name);
 
       // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
+      FunctionOptimization f;
+      f.name = func_name;
       TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
+          MakeGrapplerFunctionItem(func, flib, producer, &f.item));
+
+      // If the function calls into a function of the current batch, it must see
+      // the optimized body of the callee, so the batch has to be committed
+      // first.
+      const bool calls_batch_function = absl::c_any_of(
+          f.item.graph.library().function(), [&](const FunctionDef& callee) {
+            return batch_funcs.contains(callee.signature().name());
+          });
+      if (calls_batch_function) {
+        TF_RETURN_IF_ERROR(optimize_batch());
+        f.item = GrapplerFunctionItem();
+        TF_RETURN_IF_ERROR(
+            MakeGrapplerFunctionItem(func, flib, producer, &f.item));
+      }
 
       // If we need to compute the gradient of optimized function at runtime, we
       // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
+      f.item.optimization_options().allow_non_differentiable_rewrites =
           !differentiable_functions.contains(func_name);
 
       // Device set available to the function is defined only by the runtime,
       // when we instantiate and execute the function. We can't use all devices
       // available to the main graph, because after partitioning the function
       // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
+      if (!f.item.devices().empty()) {
         return errors::Internal("GrapplerFunctionItem devices must be empty.");
       }
 
@@ -1046,57 +1309,16 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       // instantiated by the function definition, because we must guarantee
       // function execution semantics wrt side effects (see
       // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
+      f.item.optimization_options().allow_pruning_stateful_and_dataset_ops =
           false;
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+      batch_funcs.insert(func_name);
+      batch.push_back(std::move(f));
+      if (static_cast<int64>(batch.size()) >= num_threads) {
+        TF_RETURN_IF_ERROR(optimize_batch());
       }
-
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
-        }
-      }
-
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
     }
+    TF_RETURN_IF_ERROR(optimize_batch());
 
     // If optimized at least one function, update the graph library.
     if (optimize_function_library) {
@@ -1134,6 +1356,22 @@ string MetaOptimizer::GetResultString() const {
   return result_string;
 }
 
+OptimizationReport MetaOptimizer::GetOptimizationReport() const {
+  OptimizationReport report;
+  report.set_wall_time_us(optimization_wall_time_us_);
+  for (const GraphOptimizationResult& graph_result : optimization_results_) {
+    GraphReport* graph_report = report.add_graphs();
+    graph_report->set_id(graph_result.id);
+    graph_report->set_is_function(graph_result.is_function);
+    graph_report->set_wall_time_us(graph_result.wall_time_us);
+    graph_report->set_deadline_exceeded(graph_result.deadline_exceeded);
+    for (const OptimizerResult& result : graph_result.results) {
+      *graph_report->add_passes() = result.report;
+    }
+  }
+  return report;
+}
+
 void MetaOptimizer::PrintResult() { LOG(INFO) << GetResultString(); }
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg) {
@@ -1152,12 +1390,15 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.loop_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.dependency_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.auto_parallel().enable() ||
+         rewrite_cfg.micro_batch_pipeline().enable() ||
          rewrite_cfg.memory_optimization() != RewriterConfig::NO_MEM_OPT ||
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
 #ifndef ENABLE_MKL
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
 #endif
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.elementwise_fusion() == RewriterConfig::ON ||
+         rewrite_cfg.locality_aware_placement() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
          !rewrite_cfg.optimizers().empty() ||
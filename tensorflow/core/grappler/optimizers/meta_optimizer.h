@@ -16,12 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 
+#include <memory>
+
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/optimization_report.pb.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -52,6 +56,10 @@ class MetaOptimizer : public GraphOptimizer {
 
   string GetResultString() const;
 
+  // Returns a structured report of the passes run on the main graph and the
+  // functions by the last OptimizeConsumeItem.
+  OptimizationReport GetOptimizationReport() const;
+
   void PrintResult();
 
   void Feedback(Cluster* cluster, const GrapplerItem& item,
@@ -101,24 +109,41 @@ class MetaOptimizer : public GraphOptimizer {
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
   bool xla_auto_clustering_on_;
+  // Measured op costs that guide fusions, if configured.
+  std::shared_ptr<const OpCostProfile> cost_profile_;
 
   struct OptimizerResult {
     string optimizer_name;
     string message;
     Status status;
+    PassReport report;
   };
 
   struct GraphOptimizationResult {
     explicit GraphOptimizationResult(const string& id) : id(id) {}
     string id;
+    bool is_function = false;
+    uint64 wall_time_us = 0;
+    bool deadline_exceeded = false;
+    // Predicted execution time of the current graph, if already estimated.
+    int64 estimated_time_ns = -1;
     std::vector<OptimizerResult> results;
   };
 
-  Status RunOptimizer(GraphOptimizer* optimizer, Cluster* cluster,
-                      GrapplerItem* optimized_item, GraphDef* optimized_graph,
+  Status RunOptimizer(GraphOptimizer* optimizer, int iteration,
+                      Cluster* cluster, GrapplerItem* optimized_item,
+                      GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
+  // Same as `OptimizeGraph` above, but records the optimization result in
+  // `optimization_results` instead of `optimization_results_`, so that it can
+  // be called concurrently for different items.
+  Status OptimizeGraph(
+      Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+      std::vector<GraphOptimizationResult>* optimization_results);
+
   std::vector<GraphOptimizationResult> optimization_results_;
+  uint64 optimization_wall_time_us_ = 0;
 };
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg);
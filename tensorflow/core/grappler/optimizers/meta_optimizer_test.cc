@@ -18,6 +18,7 @@ limitations under the License.
 #include <atomic>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -426,6 +427,169 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
   test::ExpectTensorEqual<int>(tensors_expected[1], tensors[1]);
 }
 
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryInParallel) {
+  using test::function::NDef;
+
+  // Enable only function optimization.
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_function_optimization(RewriterConfig::ON);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  // Define function library:
+  //
+  //   MyMul(x, y)    = x * y
+  //  *MySquare(x)    = MyMul(x, x)
+  //  *MyQuadratic(x) = MySquare(MySquare(x))
+  //  *MyCube_i(x)    = MyMul(MySquare(x), x)
+  //
+  //  * - marked as noinline
+  //
+  // MyCube_i functions can be optimized concurrently, but MyQuadratic and
+  // MyCube_i must see the optimized body of MySquare.
+  std::vector<FunctionDef> funcs;
+  funcs.push_back(FunctionDefHelper::Create(
+      "MyMul", {"x:T", "y:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"mul"}, "Mul", {"x", "y"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}}));
+  funcs.push_back(FunctionDefHelper::Create(
+      "MySquare", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"my_mul"}, "MyMul", {"x", "x"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "my_mul:z:0"}}));
+  funcs.push_back(FunctionDefHelper::Create(
+      "MyQuadratic", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"square"}, "MySquare", {"x"}, {{"T", "$T"}}},
+       {{"quadratic"}, "MySquare", {"square:z"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "quadratic:z:0"}}));
+  constexpr int kNumCubes = 8;
+  for (int i = 0; i < kNumCubes; ++i) {
+    funcs.push_back(FunctionDefHelper::Create(
+        absl::StrCat("MyCube_", i), {"x:T"}, {"z:T"}, {"T: {float, double}"},
+        {{{"square"}, "MySquare", {"x"}, {{"T", "$T"}}},
+         {{"cube"}, "MyMul", {"square:z", "x"}, {{"T", "$T"}}}},
+        /*ret_def=*/
+        {{"z", "cube:z:0"}}));
+  }
+  for (int i = 1; i < funcs.size(); ++i) {
+    (*funcs[i].mutable_attr())["_noinline"].set_b(true);
+  }
+
+  std::vector<NodeDef> nodes = {
+      NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+      NDef("square", "MySquare", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+      NDef("quadratic", "MyQuadratic", {"a"}, {{"T", DT_FLOAT}}, kDevice)};
+  std::vector<string> fetch = {"square", "quadratic"};
+  for (int i = 0; i < kNumCubes; ++i) {
+    const string name = absl::StrCat("cube_", i);
+    nodes.push_back(NDef(name, absl::StrCat("MyCube_", i), {"a"},
+                         {{"T", DT_FLOAT}}, kDevice));
+    fetch.push_back(name);
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, funcs);
+  item.fetch = fetch;
+  item.feed.emplace_back("a", test::AsScalar<float>(3.0f));
+
+  const auto optimize = [&](const string& num_threads) -> GraphDef {
+    setenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS", num_threads.c_str(),
+           /*overwrite=*/1);
+    MetaOptimizer optimizer(nullptr, config_proto);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+    unsetenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS");
+    return output;
+  };
+  GraphDef serial = optimize("1");
+  GraphDef parallel = optimize("4");
+
+  EXPECT_EQ(serial.DebugString(), parallel.DebugString());
+
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(parallel));
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors_expected.size(), tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
+TEST_F(MetaOptimizerTest, ReportsOptimizationPasses) {
+  using test::function::NDef;
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::ONE);
+  rewriter_config.add_optimizers("pruning");
+  rewriter_config.add_optimizers("function");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  // MySquare(x) = x * x, marked as noinline so its body is optimized as a
+  // separate graph.
+  FunctionDef my_square = FunctionDefHelper::Create(
+      "MySquare", {"x:T"}, {"z:T"}, {"T: {float, double}"},
+      {{{"mul"}, "Mul", {"x", "x"}, {{"T", "$T"}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}});
+  (*my_square.mutable_attr())["_noinline"].set_b(true);
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("id", "Identity", {"a"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("square", "MySquare", {"id"}, {{"T", DT_FLOAT}}, kDevice)},
+      {my_square});
+  item.fetch = {"square"};
+
+  MetaOptimizer optimizer(nullptr, config_proto);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const OptimizationReport report = optimizer.GetOptimizationReport();
+  ASSERT_GE(report.graphs_size(), 2);
+
+  const GraphReport& main_graph = report.graphs(0);
+  EXPECT_EQ("tf_graph", main_graph.id());
+  EXPECT_FALSE(main_graph.is_function());
+  EXPECT_FALSE(main_graph.deadline_exceeded());
+  EXPECT_LE(main_graph.wall_time_us(), report.wall_time_us());
+  ASSERT_EQ(2, main_graph.passes_size());
+  EXPECT_EQ("model_pruner", main_graph.passes(0).optimizer());
+  EXPECT_EQ(0, main_graph.passes(0).iteration());
+  EXPECT_EQ(3, main_graph.passes(0).num_nodes_before());
+  EXPECT_EQ(2, main_graph.passes(0).num_edges_before());
+  EXPECT_EQ("function_optimizer", main_graph.passes(1).optimizer());
+  EXPECT_EQ(main_graph.passes(0).num_nodes_after(),
+            main_graph.passes(1).num_nodes_before());
+  for (const PassReport& pass : main_graph.passes()) {
+    EXPECT_TRUE(pass.error().empty()) << pass.error();
+    // Costs are only estimated if requested.
+    EXPECT_EQ(0, pass.estimated_time_before_ns());
+    EXPECT_EQ(0, pass.estimated_time_after_ns());
+  }
+
+  // The function optimizer might have specialized MySquare for its caller.
+  bool found_function = false;
+  for (const GraphReport& graph : report.graphs()) {
+    if (!absl::StartsWith(graph.id(), "MySquare")) continue;
+    found_function = true;
+    EXPECT_TRUE(graph.is_function());
+    EXPECT_EQ(2, graph.passes_size());
+  }
+  EXPECT_TRUE(found_function);
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryPruneUnusedOutputs) {
   using test::function::NDef;
 
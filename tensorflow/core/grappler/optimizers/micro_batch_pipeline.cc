@@ -0,0 +1,481 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/micro_batch_pipeline.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/grappler/utils/transitive_fanin.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kMicroBatchPipelinePrefix[] = "MicroBatchPipeline";
+
+// How the micro-batch values of a tensor are combined for its consumers
+// outside of the micro-batches.
+enum class MergeMode { kConcat, kMean };
+
+// Returns the position of the gradient input of `node` if it is an optimizer
+// update op, or -1. Ref and resource variable versions take their inputs in
+// the same order.
+int GradientInputPosition(const NodeDef& node) {
+  static const auto* positions = new absl::flat_hash_map<string, int>{
+      {"ApplyGradientDescent", 2}, {"ApplyProximalGradientDescent", 4},
+      {"ApplyAdadelta", 6},        {"ApplyAdagrad", 3},
+      {"ApplyProximalAdagrad", 5}, {"ApplyAdagradDA", 3},
+      {"ApplyFtrl", 3},            {"ApplyMomentum", 3},
+      {"ApplyAdam", 9},            {"ApplyRMSProp", 7},
+      {"ApplyCenteredRMSProp", 8}};
+  absl::string_view op = node.op();
+  absl::ConsumePrefix(&op, "Resource");
+  auto it = positions->find(op);
+  return it == positions->end() ? -1 : it->second;
+}
+
+bool IsBatchSource(const NodeDef& node,
+                   const absl::flat_hash_set<string>& feeds) {
+  return feeds.contains(node.name()) || IsDequeueOp(node) ||
+         node.op() == "IteratorGetNext" || node.op() == "IteratorGetNextSync";
+}
+
+// Returns "node:port" for a data input, which is how batched outputs are keyed.
+string CanonicalTensorName(const string& input) {
+  const TensorId id = ParseTensorName(input);
+  return absl::StrCat(id.node(), ":", id.index());
+}
+
+string MicroBatchName(const string& name, int micro_batch) {
+  return AddPrefixToNodeName(
+      name, absl::StrCat(kMicroBatchPipelinePrefix, "/MicroBatch_",
+                         micro_batch));
+}
+
+// Unknown dimensions that GraphProperties could not relate to any other are
+// -1; the others are known sizes or symbolic ids shared by equal dimensions.
+bool IsTrackedDim(int64 size) { return size != -1; }
+
+Status ChooseMergeMode(const OpInfo::TensorProperties& output,
+                       const absl::flat_hash_set<int64>& batch_dims,
+                       MergeMode* mode) {
+  const TensorShapeProto& shape = output.shape();
+  if (!shape.unknown_rank() && shape.dim_size() > 0 &&
+      IsTrackedDim(shape.dim(0).size()) &&
+      batch_dims.contains(shape.dim(0).size())) {
+    *mode = MergeMode::kConcat;
+    return Status::OK();
+  }
+  if (!shape.unknown_rank() &&
+      (shape.dim_size() == 0 || IsTrackedDim(shape.dim(0).size())) &&
+      DataTypeIsFloating(output.dtype())) {
+    *mode = MergeMode::kMean;
+    return Status::OK();
+  }
+  return errors::Aborted("Cannot merge the micro-batches of a ",
+                         DataTypeString(output.dtype()), " tensor of shape ",
+                         PartialTensorShape(shape).DebugString());
+}
+
+Tensor FloatingScalar(DataType dtype, double value) {
+  Tensor tensor(dtype, TensorShape({}));
+  switch (dtype) {
+    case DT_HALF:
+      tensor.scalar<Eigen::half>()() = static_cast<Eigen::half>(value);
+      break;
+    case DT_BFLOAT16:
+      tensor.scalar<bfloat16>()() = static_cast<bfloat16>(value);
+      break;
+    case DT_DOUBLE:
+      tensor.scalar<double>()() = value;
+      break;
+    default:
+      tensor.scalar<float>()() = static_cast<float>(value);
+      break;
+  }
+  return tensor;
+}
+
+NodeDef* AddConstNode(const string& name, const string& device,
+                      const Tensor& value, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(device);
+  (*node->mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent((*node->mutable_attr())["value"].mutable_tensor());
+  return node;
+}
+
+Tensor Int32Scalar(int32 value) {
+  Tensor tensor(DT_INT32, TensorShape({}));
+  tensor.scalar<int32>()() = value;
+  return tensor;
+}
+
+}  // namespace
+
+Status MicroBatchPipeline::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                    GraphDef* optimized_graph) {
+  const GraphDef& graph = item.graph;
+  if (num_micro_batches_ < 2 || item.fetch.empty()) {
+    return errors::Aborted("Nothing to do.");
+  }
+  for (const NodeDef& node : graph.node()) {
+    if (absl::StartsWith(node.name(),
+                         absl::StrCat(kMicroBatchPipelinePrefix, "/"))) {
+      return errors::Aborted("The graph is already pipelined.");
+    }
+  }
+
+  std::vector<const NodeDef*> topo_order;
+  if (!ComputeTopologicalOrder(graph, &topo_order).ok()) {
+    return errors::Aborted("Micro-batch pipelining requires an acyclic graph.");
+  }
+  absl::flat_hash_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph.node()) nodes[node.name()] = &node;
+
+  std::vector<const NodeDef*> train_nodes;
+  TF_RETURN_IF_ERROR(ComputeTransitiveFanin(graph, item.fetch, &train_nodes));
+  const absl::flat_hash_set<const NodeDef*> in_train(train_nodes.begin(),
+                                                     train_nodes.end());
+
+  // The batch size is read from the feeds, so they have to match the shapes
+  // of the nodes they replace.
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(
+      properties.InferStatically(/*assume_valid_feeds=*/true,
+                                 /*aggressive_shape_inference=*/false,
+                                 /*include_tensor_values=*/false));
+
+  // Finds the batched outputs, and the values their dimension 0 takes.
+  absl::flat_hash_set<string> feeds;
+  for (const auto& feed : item.feed) feeds.insert(NodeName(feed.first));
+  absl::flat_hash_map<string, DataType> batched_outputs;
+  absl::flat_hash_set<string> batch_sources;
+  absl::flat_hash_set<int64> batch_dims;
+  for (const NodeDef* node : train_nodes) {
+    if (!IsBatchSource(*node, feeds)) continue;
+    const auto& outputs = properties.GetOutputProperties(node->name());
+    for (int port = 0, end = outputs.size(); port < end; ++port) {
+      const TensorShapeProto& shape = outputs[port].shape();
+      if (shape.unknown_rank() || shape.dim_size() == 0) continue;
+      const int64 batch_size = shape.dim(0).size();
+      if (batch_size > 0 && batch_size % num_micro_batches_ != 0) {
+        return errors::Aborted("Batch size ", batch_size, " of ",
+                               node->name(), " is not divisible by ",
+                               num_micro_batches_);
+      }
+      batched_outputs[absl::StrCat(node->name(), ":", port)] =
+          outputs[port].dtype();
+      batch_sources.insert(node->name());
+      if (IsTrackedDim(batch_size)) batch_dims.insert(batch_size);
+    }
+  }
+  if (batched_outputs.empty()) {
+    return errors::Aborted("No batched inputs.");
+  }
+
+  // Nodes of the training step that depend on the batch through data edges
+  // are replicated per micro-batch, except for the optimizer updates.
+  absl::flat_hash_set<string> replicated;
+  for (const NodeDef* node : topo_order) {
+    if (!in_train.contains(node) || batch_sources.contains(node->name()) ||
+        GradientInputPosition(*node) >= 0) {
+      continue;
+    }
+    for (const string& input : node->input()) {
+      if (IsControlInput(input)) break;
+      if (batched_outputs.contains(CanonicalTensorName(input)) ||
+          replicated.contains(NodeName(input))) {
+        if (IsControlFlow(*node)) {
+          return errors::Aborted(
+              "Micro-batch pipelining does not support control flow: ",
+              node->name());
+        }
+        replicated.insert(node->name());
+        break;
+      }
+    }
+  }
+  if (replicated.empty()) {
+    return errors::Aborted("Nothing to do.");
+  }
+
+  optimized_graph->Clear();
+  *optimized_graph->mutable_library() = graph.library();
+  *optimized_graph->mutable_versions() = graph.versions();
+
+  // Splits every batched output used by the micro-batches.
+  absl::flat_hash_map<string, string> splits;
+  auto get_split = [&](const string& tensor) -> const string& {
+    auto it = splits.find(tensor);
+    if (it != splits.end()) return it->second;
+    const TensorId id = ParseTensorName(tensor);
+    const string& device = nodes[string(id.node())]->device();
+    const string name = absl::StrCat(kMicroBatchPipelinePrefix, "/Split/",
+                                     id.node(), "_", id.index());
+    AddConstNode(absl::StrCat(name, "/dim"), device, Int32Scalar(0),
+                 optimized_graph);
+    NodeDef* split = optimized_graph->add_node();
+    split->set_name(name);
+    split->set_op("Split");
+    split->set_device(device);
+    split->add_input(absl::StrCat(name, "/dim"));
+    split->add_input(tensor);
+    (*split->mutable_attr())["num_split"].set_i(num_micro_batches_);
+    (*split->mutable_attr())["T"].set_type(batched_outputs[tensor]);
+    return splits.emplace(tensor, name).first->second;
+  };
+
+  // Merges the micro-batch values of the tensors used outside of the
+  // micro-batches. Merges are keyed by tensor and mode.
+  std::map<std::pair<string, MergeMode>, string> merges;
+  auto add_merge = [&](const string& tensor, MergeMode mode,
+                       const string& name) {
+    const TensorId id = ParseTensorName(tensor);
+    const string producer(id.node());
+    const string& device = nodes[producer]->device();
+    const DataType dtype =
+        properties.GetOutputProperties(producer)[id.index()].dtype();
+    NodeDef* merge = optimized_graph->add_node();
+    merge->set_device(device);
+    (*merge->mutable_attr())["T"].set_type(dtype);
+    if (mode == MergeMode::kConcat) {
+      merge->set_name(name);
+      merge->set_op("ConcatV2");
+      for (int i = 0; i < num_micro_batches_; ++i) {
+        merge->add_input(MicroBatchName(tensor, i));
+      }
+      merge->add_input(absl::StrCat(name, "/axis"));
+      (*merge->mutable_attr())["N"].set_i(num_micro_batches_);
+      (*merge->mutable_attr())["Tidx"].set_type(DT_INT32);
+      AddConstNode(absl::StrCat(name, "/axis"), device, Int32Scalar(0),
+                   optimized_graph);
+    } else {
+      merge->set_name(absl::StrCat(name, "/sum"));
+      merge->set_op("AddN");
+      for (int i = 0; i < num_micro_batches_; ++i) {
+        merge->add_input(MicroBatchName(tensor, i));
+      }
+      (*merge->mutable_attr())["N"].set_i(num_micro_batches_);
+      AddConstNode(absl::StrCat(name, "/scale"), device,
+                   FloatingScalar(dtype, 1.0 / num_micro_batches_),
+                   optimized_graph);
+      NodeDef* mean = optimized_graph->add_node();
+      mean->set_name(name);
+      mean->set_op("Mul");
+      mean->set_device(device);
+      mean->add_input(absl::StrCat(name, "/sum"));
+      mean->add_input(absl::StrCat(name, "/scale"));
+      (*mean->mutable_attr())["T"].set_type(dtype);
+    }
+    merges[{tensor, mode}] = name;
+  };
+  auto get_merge = [&](const string& tensor, MergeMode mode) -> string {
+    auto it = merges.find({tensor, mode});
+    if (it != merges.end()) return it->second;
+    const TensorId id = ParseTensorName(tensor);
+    const string name = absl::StrCat(kMicroBatchPipelinePrefix, "/Merge/",
+                                     id.node(), "_", id.index());
+    add_merge(tensor, mode, mode == MergeMode::kConcat
+                                ? absl::StrCat(name, "/concat")
+                                : absl::StrCat(name, "/mean"));
+    return merges[{tensor, mode}];
+  };
+
+  // Preserved nodes that are replicated are replaced by the merge of their
+  // only output, or by a NoOp depending on all the micro-batches.
+  for (const string& preserved : item.NodesToPreserve()) {
+    if (!replicated.contains(preserved)) continue;
+    const auto& outputs = properties.GetOutputProperties(preserved);
+    if (outputs.empty()) {
+      NodeDef* noop = optimized_graph->add_node();
+      noop->set_name(preserved);
+      noop->set_op("NoOp");
+      noop->set_device(nodes[preserved]->device());
+      for (int i = 0; i < num_micro_batches_; ++i) {
+        noop->add_input(AsControlDependency(MicroBatchName(preserved, i)));
+      }
+    } else if (outputs.size() == 1) {
+      MergeMode mode;
+      TF_RETURN_IF_ERROR(ChooseMergeMode(outputs[0], batch_dims, &mode));
+      add_merge(absl::StrCat(preserved, ":0"), mode, preserved);
+    } else {
+      return errors::Aborted("Cannot preserve batch dependent node ",
+                             preserved, " with several outputs");
+    }
+  }
+
+  // Copies the shared nodes, reading the merged values of the micro-batches.
+  for (const NodeDef& node : graph.node()) {
+    if (replicated.contains(node.name())) continue;
+    NodeDef* copy = optimized_graph->add_node();
+    *copy = node;
+    copy->clear_input();
+    const int gradient_position = GradientInputPosition(node);
+    for (int k = 0; k < node.input_size(); ++k) {
+      const string& input = node.input(k);
+      const string producer = NodeName(input);
+      if (!replicated.contains(producer)) {
+        copy->add_input(input);
+      } else if (IsControlInput(input)) {
+        for (int i = 0; i < num_micro_batches_; ++i) {
+          copy->add_input(AsControlDependency(MicroBatchName(producer, i)));
+        }
+      } else {
+        const TensorId id = ParseTensorName(input);
+        const auto& output = properties.GetOutputProperties(producer).at(
+            id.index());
+        MergeMode mode;
+        if (k == gradient_position) {
+          // Gradients are averaged over the micro-batches.
+          if (!DataTypeIsFloating(output.dtype())) {
+            return errors::Aborted("Unexpected gradient type for ",
+                                   node.name());
+          }
+          mode = MergeMode::kMean;
+        } else {
+          TF_RETURN_IF_ERROR(ChooseMergeMode(output, batch_dims, &mode));
+        }
+        copy->add_input(get_merge(CanonicalTensorName(input), mode));
+      }
+    }
+  }
+
+  // Clones the replicated nodes once per micro-batch.
+  absl::flat_hash_map<string, NodeDef*> clones;
+  for (int i = 0; i < num_micro_batches_; ++i) {
+    for (const NodeDef* node : topo_order) {
+      if (!replicated.contains(node->name())) continue;
+      NodeDef* clone = optimized_graph->add_node();
+      *clone = *node;
+      clone->set_name(MicroBatchName(node->name(), i));
+      for (string& input : *clone->mutable_input()) {
+        if (replicated.contains(NodeName(input))) {
+          input = MicroBatchName(input, i);
+        } else if (!IsControlInput(input)) {
+          const string tensor = CanonicalTensorName(input);
+          if (batched_outputs.contains(tensor)) {
+            input = absl::StrCat(get_split(tensor), ":", i);
+          }
+        }
+      }
+      auto colocation = clone->mutable_attr()->find(kColocationAttrName);
+      if (colocation != clone->mutable_attr()->end()) {
+        for (string& group : *colocation->second.mutable_list()->mutable_s()) {
+          absl::string_view colocated = group;
+          if (absl::ConsumePrefix(&colocated, kColocationGroupPrefix) &&
+              replicated.contains(colocated)) {
+            group = absl::StrCat(kColocationGroupPrefix,
+                                 MicroBatchName(string(colocated), i));
+          }
+        }
+      }
+      clones[clone->name()] = clone;
+    }
+  }
+
+  // Orders the micro-batches on every device. A node is a backward node if it
+  // depends on its own device through another device, as gradients flowing
+  // back from later stages do; the forward and the backward nodes of a device
+  // are ordered separately, so that a stage can run the forward pass of a
+  // micro-batch while earlier ones are still on their way back.
+  absl::flat_hash_map<string, std::set<string>> upstream_devices;
+  absl::flat_hash_map<string, std::pair<string, bool>> phases;
+  absl::flat_hash_set<string> has_phase_input, has_phase_output;
+  for (const NodeDef* node : topo_order) {
+    if (!replicated.contains(node->name())) continue;
+    const string& device = node->device();
+    std::set<string>& upstream = upstream_devices[node->name()];
+    upstream.insert(device);
+    bool backward = false;
+    for (const string& input : node->input()) {
+      const string producer = NodeName(input);
+      if (!replicated.contains(producer) || IsControlInput(input)) continue;
+      const std::set<string>& producer_upstream = upstream_devices[producer];
+      upstream.insert(producer_upstream.begin(), producer_upstream.end());
+      if (nodes[producer]->device() == device
+              ? phases[producer].second
+              : producer_upstream.count(device) > 0) {
+        backward = true;
+      }
+    }
+    phases[node->name()] = {device, backward};
+    for (const string& input : node->input()) {
+      const string producer = NodeName(input);
+      if (replicated.contains(producer) &&
+          phases[producer] == phases[node->name()]) {
+        has_phase_input.insert(node->name());
+        has_phase_output.insert(producer);
+      }
+    }
+  }
+  std::map<std::pair<string, bool>, std::vector<const NodeDef*>> entries,
+      sinks;
+  for (const NodeDef* node : topo_order) {
+    if (!replicated.contains(node->name())) continue;
+    const auto& phase = phases[node->name()];
+    if (!has_phase_input.contains(node->name())) {
+      entries[phase].push_back(node);
+    }
+    if (!has_phase_output.contains(node->name())) sinks[phase].push_back(node);
+  }
+  for (int i = 1; i < num_micro_batches_; ++i) {
+    int phase_index = 0;
+    for (const auto& phase_sinks : sinks) {
+      const auto& phase = phase_sinks.first;
+      NodeDef* done = optimized_graph->add_node();
+      done->set_name(absl::StrCat(kMicroBatchPipelinePrefix, "/MicroBatch_",
+                                  i - 1, "/Phase_", phase_index++, "_Done"));
+      done->set_op("NoOp");
+      done->set_device(phase.first);
+      for (const NodeDef* sink : phase_sinks.second) {
+        done->add_input(
+            AsControlDependency(MicroBatchName(sink->name(), i - 1)));
+      }
+      for (const NodeDef* entry : entries[phase]) {
+        clones[MicroBatchName(entry->name(), i)]->add_input(
+            AsControlDependency(done->name()));
+      }
+    }
+  }
+
+  VLOG(1) << "Pipelined " << replicated.size() << " nodes over "
+          << num_micro_batches_ << " micro-batches";
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,69 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MICRO_BATCH_PIPELINE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MICRO_BATCH_PIPELINE_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Splits the batch of a training step into micro-batches that are pipelined
+// over the devices a model has been manually split across.
+//
+// When the stages of a model are placed on different devices with device
+// scopes, a step runs the stages one after the other and only one device is
+// busy at a time. This pass splits every batched input along dimension 0 into
+// `num_micro_batches` parts and clones the nodes that depend on the batch once
+// per micro-batch, on the same devices. Micro-batch i+1 can then run on a
+// stage while micro-batch i runs on the next one. As in GPipe, each device
+// processes the micro-batches in order: the forward nodes of micro-batch i on
+// a device wait for those of micro-batch i-1, and so do the backward nodes.
+//
+// The gradients of the micro-batches are averaged before the single optimizer
+// update of the step. Other batch dependent tensors used by the rest of the
+// graph or fetched are concatenated if they keep the batch dimension and
+// averaged otherwise.
+//
+// Batched inputs are the outputs of rank 1 or more of the feeds, dequeue and
+// IteratorGetNext nodes. Their batch size must be divisible by the number of
+// micro-batches. Graphs whose batch dependent part contains control flow are
+// left unchanged.
+class MicroBatchPipeline : public GraphOptimizer {
+ public:
+  explicit MicroBatchPipeline(int num_micro_batches)
+      : num_micro_batches_(num_micro_batches) {}
+
+  ~MicroBatchPipeline() override {}
+
+  string name() const override { return "micro_batch_pipeline"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+ private:
+  const int num_micro_batches_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_MICRO_BATCH_PIPELINE_H_
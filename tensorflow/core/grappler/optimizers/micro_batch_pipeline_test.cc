@@ -0,0 +1,168 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/micro_batch_pipeline.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kStage0[] = "/job:worker/replica:0/task:0/device:GPU:0";
+constexpr char kStage1[] = "/job:worker/replica:0/task:0/device:GPU:1";
+
+class MicroBatchPipelineTest : public GrapplerTest {
+ protected:
+  // A two stage model: `h` runs on the first stage, `y` on the second, and the
+  // gradient `g` of the first stage depends on both.
+  GrapplerItem MakeTwoStageItem(int batch_size, const string& stage0,
+                                const string& stage1) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto x = ops::Placeholder(s.WithOpName("x").WithDevice(stage0), DT_FLOAT,
+                              ops::Placeholder::Shape({batch_size, 4}));
+    auto w = ops::Const(s.WithOpName("w").WithDevice(stage0),
+                        {0.5f, -1.0f, 0.25f, 2.0f, 1.5f, -0.5f, 0.75f, 1.0f,
+                         -2.0f, 0.5f, 1.0f, -0.25f},
+                        {4, 3});
+    auto h = ops::MatMul(s.WithOpName("h").WithDevice(stage0), x, w);
+    auto y = ops::Tanh(s.WithOpName("y").WithDevice(stage1), h);
+    auto g = ops::MatMul(s.WithOpName("g").WithDevice(stage0), x, y,
+                         ops::MatMul::TransposeA(true));
+
+    GrapplerItem item;
+    item.fetch = {"y", "g"};
+    item.feed = {{"x", GenerateRandomTensor<DT_FLOAT>({batch_size, 4})}};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(MicroBatchPipelineTest, MergesFetchedValues) {
+  GrapplerItem item = MakeTwoStageItem(8, "", "");
+
+  MicroBatchPipeline optimizer(2);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* split = FindNode(output, "MicroBatchPipeline/Split/x_0");
+  ASSERT_NE(split, nullptr);
+  EXPECT_EQ("Split", split->op());
+  EXPECT_EQ(2, split->attr().at("num_split").i());
+  // The batch dimension of `y` is concatenated, `g` is averaged.
+  EXPECT_EQ("ConcatV2", FindNode(output, "y")->op());
+  EXPECT_EQ("Mul", FindNode(output, "g")->op());
+
+  auto expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  auto actual = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(2, actual.size());
+  test::ExpectTensorNear<float>(expected[0], actual[0], 1e-6);
+  Tensor scaled(DT_FLOAT, actual[1].shape());
+  scaled.flat<float>() = actual[1].flat<float>() * 2.0f;
+  test::ExpectTensorNear<float>(expected[1], scaled, 1e-5);
+}
+
+TEST_F(MicroBatchPipelineTest, AveragesGradients) {
+  GrapplerItem item = MakeTwoStageItem(8, kStage0, kStage1);
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto var = ops::Variable(s.WithOpName("var").WithDevice(kStage0), {4, 3},
+                           DT_FLOAT);
+  auto lr = ops::Const(s.WithOpName("lr").WithDevice(kStage0), 0.1f);
+  auto g = ops::Placeholder(s.WithOpName("g"), DT_FLOAT);
+  ops::ApplyGradientDescent(s.WithOpName("apply").WithDevice(kStage0), var,
+                            lr, g);
+  GraphDef update;
+  TF_CHECK_OK(s.ToGraphDef(&update));
+  for (const NodeDef& node : update.node()) {
+    if (node.name() != "g") *item.graph.add_node() = node;
+  }
+  item.fetch = {"apply"};
+
+  MicroBatchPipeline optimizer(2);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* apply = FindNode(output, "apply");
+  ASSERT_NE(apply, nullptr);
+  EXPECT_EQ("var", apply->input(0));
+  EXPECT_EQ("MicroBatchPipeline/Merge/g_0/mean", apply->input(2));
+  EXPECT_EQ(nullptr, FindNode(output, "g"));
+
+  for (int i = 0; i < 2; ++i) {
+    const string prefix = strings::StrCat("MicroBatchPipeline/MicroBatch_", i);
+    const NodeDef* h = FindNode(output, strings::StrCat(prefix, "/h"));
+    ASSERT_NE(h, nullptr);
+    EXPECT_EQ(kStage0, h->device());
+    EXPECT_EQ(strings::StrCat("MicroBatchPipeline/Split/x_0:", i),
+              h->input(0));
+    EXPECT_EQ("w", h->input(1));
+    const NodeDef* y = FindNode(output, strings::StrCat(prefix, "/y"));
+    ASSERT_NE(y, nullptr);
+    EXPECT_EQ(kStage1, y->device());
+  }
+
+  // The forward and the backward nodes of the second micro-batch wait for
+  // those of the first one on the same device.
+  const NodeDef* h1 = FindNode(output, "MicroBatchPipeline/MicroBatch_1/h");
+  ASSERT_EQ(3, h1->input_size());
+  const NodeDef* h_done = FindNode(output, NodeName(h1->input(2)));
+  ASSERT_NE(h_done, nullptr);
+  EXPECT_EQ(kStage0, h_done->device());
+  EXPECT_EQ("^MicroBatchPipeline/MicroBatch_0/h", h_done->input(0));
+
+  const NodeDef* g1 = FindNode(output, "MicroBatchPipeline/MicroBatch_1/g");
+  ASSERT_EQ(3, g1->input_size());
+  const NodeDef* g_done = FindNode(output, NodeName(g1->input(2)));
+  ASSERT_NE(g_done, nullptr);
+  EXPECT_NE(h_done, g_done);
+  EXPECT_EQ("^MicroBatchPipeline/MicroBatch_0/g", g_done->input(0));
+
+  const NodeDef* y1 = FindNode(output, "MicroBatchPipeline/MicroBatch_1/y");
+  ASSERT_EQ(2, y1->input_size());
+  EXPECT_EQ(kStage1, FindNode(output, NodeName(y1->input(1)))->device());
+}
+
+TEST_F(MicroBatchPipelineTest, RequiresDivisibleBatch) {
+  GrapplerItem item = MakeTwoStageItem(7, "", "");
+
+  MicroBatchPipeline optimizer(2);
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+TEST_F(MicroBatchPipelineTest, SingleMicroBatchIsNoOp) {
+  GrapplerItem item = MakeTwoStageItem(8, "", "");
+
+  MicroBatchPipeline optimizer(1);
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
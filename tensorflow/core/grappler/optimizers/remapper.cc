@@ -18,6 +18,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
 #include "tensorflow/core/grappler/graph_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/util/util.h"
 
 #if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
 #include "third_party/gpus/cudnn/cudnn.h"
 #endif  // GOOGLE_CUDA
 
@@ -59,6 +61,9 @@ namespace grappler {
 //   (1) FusedBatchNorm + <Activation>
 //   (2) FusedBatchNorm + SideInput + <Activation>
 //
+// ResizeBilinear + ... -> _FusedResizeBilinearNormalize (CPU only):
+//   (1) ResizeBilinear + Sub(const offset) + Mul(const scale) + <Cast>
+//
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
@@ -70,6 +75,8 @@ constexpr char kFusedMatMul[] = "_FusedMatMul";
 constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
+constexpr char kFusedResizeBilinearNormalize[] =
+    "_FusedResizeBilinearNormalize";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -78,18 +85,21 @@ constexpr int kMissingIndex = -1;
 
 struct RemapperContext {
   explicit RemapperContext(GrapplerItem* item, Status* status,
-                           bool xla_auto_clustering_on)
+                           bool xla_auto_clustering_on,
+                           const OpCostProfile* cost_profile)
       : nodes_to_preserve(item->NodesToPreserve()),
         graph_view(&item->graph, status),
         graph_properties(*item),
         inferred_graph_properties(false),
-        xla_auto_clustering_on(xla_auto_clustering_on) {}
+        xla_auto_clustering_on(xla_auto_clustering_on),
+        cost_profile(cost_profile) {}
 
   std::unordered_set<string> nodes_to_preserve;
   utils::MutableGraphView graph_view;
   GraphProperties graph_properties;
   bool inferred_graph_properties;
   bool xla_auto_clustering_on;
+  const OpCostProfile* cost_profile;  // may be NULL
 };
 
 // FusedBatchNorm that can be replaced with a cheaper set of primitives.
@@ -123,6 +133,19 @@ struct FusedBatchNormGradEx {
   int fwd_fused_batch_norm = kMissingIndex;
 };
 
+// ResizeBilinear followed by a Sub and a Mul with constant offset and scale,
+// and an optional Cast of the float result to bfloat16.
+struct ResizeBilinearWithNormalize {
+  ResizeBilinearWithNormalize() = default;
+
+  int resize = kMissingIndex;
+  int sub = kMissingIndex;
+  int mul = kMissingIndex;
+  int cast = kMissingIndex;
+  int offset = kMissingIndex;
+  int scale = kMissingIndex;
+};
+
 // Contraction node followed by a BiasAdd.
 struct ContractionWithBiasAdd {
   ContractionWithBiasAdd() = default;
@@ -267,7 +290,7 @@ bool IsCpuCompatibleDataType(const NodeDef* contraction,
 bool IsGpuCompatibleDataType(const NodeDef* contraction,
                              const string& type_attr = "T") {
   DataType dtype = GetDataTypeFromAttr(*contraction, type_attr);
-  if (IsConv2D(*contraction)) {
+  if (IsConv2D(*contraction) || IsMatMul(*contraction)) {
     return dtype == DT_FLOAT;
   } else {
     return false;
@@ -307,6 +330,17 @@ bool IsCpuCompatibleMatMul(const NodeDef* matmul) {
   return NodeIsOnCpu(matmul) && IsCpuCompatibleDataType(matmul);
 }
 
+// `_FusedMatMul` on GPU computes the fused ops in a cuBLASLt epilogue, which is
+// only available since CUDA 11.
+bool IsGpuCompatibleMatMul(const NodeDef* matmul) {
+  DCHECK(IsMatMul(*matmul)) << "Expected MatMul op";
+#if GOOGLE_CUDA && CUDA_VERSION >= 11000
+  return NodeIsOnGpu(matmul) && IsGpuCompatibleDataType(matmul);
+#else
+  return false;
+#endif  // GOOGLE_CUDA && CUDA_VERSION >= 11000
+}
+
 bool IsCpuCompatibleDepthwiseConv2dNative(const NodeDef* dw_conv2d) {
   DCHECK(IsDepthwiseConv2dNative(*dw_conv2d))
       << "Expected DepthwiseConv2dNative op";
@@ -335,7 +369,8 @@ bool IsCpuCompatible(const RemapperContext& ctx, const Pattern& matched) {
   }
 }
 
-// Checks if we can rewrite a pattern to the `_FusedConv2D` on GPU device.
+// Checks if we can rewrite a pattern to the `_Fused{Conv2D,MatMul}` on GPU
+// device.
 bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithBiasAddAndActivation& matched) {
 #if TENSORFLOW_USE_ROCM
@@ -350,6 +385,12 @@ bool IsGpuCompatible(const RemapperContext& ctx,
 
   const GraphDef* graph = ctx.graph_view.graph();
   const NodeDef& contraction_node = graph->node(matched.contraction);
+
+  // cuBLASLt epilogues support only Relu activation.
+  if (IsMatMul(contraction_node)) {
+    return IsRelu(graph->node(matched.activation)) &&
+           IsGpuCompatibleMatMul(&contraction_node);
+  }
   if (!IsConv2D(contraction_node)) return false;
 
   const std::vector<OpInfo::TensorProperties>& input_props =
@@ -375,7 +416,11 @@ bool IsGpuCompatible(const RemapperContext& ctx,
 }
 bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithBiasAdd& matched) {
-  return false;
+  if (ctx.xla_auto_clustering_on) return false;
+
+  const NodeDef& contraction_node =
+      ctx.graph_view.graph()->node(matched.contraction);
+  return IsMatMul(contraction_node) && IsGpuCompatibleMatMul(&contraction_node);
 }
 bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithSqueezeAndBiasAdd& matched) {
@@ -418,6 +463,82 @@ inline bool HasAtMostOneDataFanoutAtPort0(
   return absl::c_count_if(node_view.GetRegularFanout(0), predicate) <= 1;
 }
 
+// Returns the fused op that replaces `contraction` and its fused ops.
+string FusedContractionOp(const NodeDef& contraction) {
+  if (IsConv2D(contraction)) return kFusedConv2D;
+  if (IsDepthwiseConv2dNative(contraction)) return kFusedDepthwiseConv2dNative;
+  return kFusedMatMul;
+}
+
+// Returns true if the cost profile predicts that replacing the nodes at
+// `node_indices` with a `fused_op` node running `fused_ops` is faster. The
+// first node provides the input of the fused op. Without a profile, all
+// fusions are applied.
+bool IsFusionProfitable(const RemapperContext& ctx, const string& fused_op,
+                        const std::vector<string>& fused_ops,
+                        const std::vector<int>& node_indices) {
+  if (ctx.cost_profile == nullptr) return true;
+
+  std::vector<OpCostProfile::Op> ops;
+  ops.reserve(node_indices.size());
+  for (int node_index : node_indices) {
+    const NodeDef* node = ctx.graph_view.GetNode(node_index)->node();
+    OpCostProfile::Op op;
+    op.op = node->op();
+    if (ctx.inferred_graph_properties) {
+      const auto& props = ctx.graph_properties.GetInputProperties(node->name());
+      if (!props.empty()) op.input_shape = &props[0].shape();
+    }
+    ops.push_back(std::move(op));
+  }
+  OpCostProfile::Op fused = ops.front();
+  fused.op = fused_op;
+  fused.fused_ops = fused_ops;
+  return ctx.cost_profile->PredictsFusionGain(fused, ops);
+}
+
+bool IsFusionProfitable(const RemapperContext& ctx,
+                        const ContractionWithBiasAdd& matched) {
+  const NodeDef* contraction =
+      ctx.graph_view.GetNode(matched.contraction)->node();
+  return IsFusionProfitable(ctx, FusedContractionOp(*contraction),
+                            {"BiasAdd"},
+                            {matched.contraction, matched.bias_add});
+}
+
+bool IsFusionProfitable(const RemapperContext& ctx,
+                        const ContractionWithBiasAddAndActivation& matched) {
+  const NodeDef* contraction =
+      ctx.graph_view.GetNode(matched.contraction)->node();
+  const NodeDef* activation =
+      ctx.graph_view.GetNode(matched.activation)->node();
+  return IsFusionProfitable(
+      ctx, FusedContractionOp(*contraction), {"BiasAdd", activation->op()},
+      {matched.contraction, matched.bias_add, matched.activation});
+}
+
+bool IsFusionProfitable(const RemapperContext& ctx,
+                        const ContractionWithSqueezeAndBiasAdd& matched) {
+  // The Squeeze node is kept after the fused op.
+  return IsFusionProfitable(ctx, kFusedConv2D, {"BiasAdd"},
+                            {matched.contraction, matched.bias_add});
+}
+
+bool IsFusionProfitable(const RemapperContext& ctx,
+                        const ContractionWithBatchNorm& matched) {
+  return IsFusionProfitable(ctx, kFusedConv2D, {"FusedBatchNorm"},
+                            {matched.contraction, matched.fused_batch_norm});
+}
+
+bool IsFusionProfitable(const RemapperContext& ctx,
+                        const ContractionWithBatchNormAndActivation& matched) {
+  const NodeDef* activation =
+      ctx.graph_view.GetNode(matched.activation)->node();
+  return IsFusionProfitable(
+      ctx, kFusedConv2D, {"FusedBatchNorm", activation->op()},
+      {matched.contraction, matched.fused_batch_norm, matched.activation});
+}
+
 bool FindContractionWithBias(const RemapperContext& ctx, int node_index,
                              ContractionWithBiasAdd* matched,
                              bool check_device_compatible = true) {
@@ -1089,6 +1210,108 @@ bool FindFusedBatchNormGradEx(const RemapperContext& ctx, int node_index,
 
   return false;
 }
+// Returns the number of elements of a Const node that holds a scalar or a
+// vector of floats, or -1 for any other node.
+int64 NumElementsOfFloatScalarOrVectorConst(const NodeDef& node) {
+  if (!IsConstant(node) || !HasDataType(&node, DT_FLOAT, "dtype")) return -1;
+  const auto it = node.attr().find("value");
+  if (it == node.attr().end() || !it->second.has_tensor()) return -1;
+  const TensorShapeProto& shape = it->second.tensor().tensor_shape();
+  if (shape.unknown_rank() || shape.dim_size() > 1) return -1;
+  return shape.dim_size() == 0 ? 1 : shape.dim(0).size();
+}
+
+bool FindResizeBilinearWithNormalize(const RemapperContext& ctx,
+                                     int node_index,
+                                     ResizeBilinearWithNormalize* matched) {
+  // Root of the pattern must be a Mul, or a Cast of a Mul to bfloat16.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (HasControlFaninOrFanout(*node_view) || IsInPreserveSet(ctx, node_def))
+    return false;
+
+  int cast_index = kMissingIndex;
+  const auto* mul_node_view = node_view;
+  if (IsCast(*node_def)) {
+    if (!HasDataType(node_def, DT_FLOAT, "SrcT") ||
+        !HasDataType(node_def, DT_BFLOAT16, "DstT") ||
+        node_view->NumRegularFanins() != 1)
+      return false;
+    // The fused kernel rounds to nearest like a non-truncating Cast.
+    bool truncate = false;
+    if (TryGetNodeAttr(*node_def, "Truncate", &truncate) && truncate)
+      return false;
+    cast_index = node_index;
+    mul_node_view = node_view->GetRegularFanin(0).node_view();
+    if (HasControlFaninOrFanout(*mul_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*mul_node_view) ||
+        IsInPreserveSet(ctx, mul_node_view->node()))
+      return false;
+  }
+  const auto* mul_node_def = mul_node_view->node();
+  if (!IsMul(*mul_node_def) || !HasDataType(mul_node_def, DT_FLOAT) ||
+      mul_node_view->NumRegularFanins() != 2)
+    return false;
+
+  // Mul is commutative, so the scale may be either of its inputs.
+  for (int scale_port = 0; scale_port < 2; ++scale_port) {
+    const auto* scale_node_view =
+        mul_node_view->GetRegularFanin(scale_port).node_view();
+    const auto* sub_node_view =
+        mul_node_view->GetRegularFanin(1 - scale_port).node_view();
+    const auto* sub_node_def = sub_node_view->node();
+    if (!IsSub(*sub_node_def) || !HasDataType(sub_node_def, DT_FLOAT) ||
+        sub_node_view->NumRegularFanins() != 2 ||
+        HasControlFaninOrFanout(*sub_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*sub_node_view) ||
+        IsInPreserveSet(ctx, sub_node_def))
+      continue;
+
+    const auto* resize_node_view =
+        sub_node_view->GetRegularFanin(0).node_view();
+    const auto* offset_node_view =
+        sub_node_view->GetRegularFanin(1).node_view();
+    const auto* resize_node_def = resize_node_view->node();
+    if (resize_node_def->op() != "ResizeBilinear" ||
+        !NodeIsOnCpu(resize_node_def) ||
+        HasControlFaninOrFanout(*resize_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*resize_node_view) ||
+        IsInPreserveSet(ctx, resize_node_def))
+      continue;
+
+    const int64 num_offsets =
+        NumElementsOfFloatScalarOrVectorConst(*offset_node_view->node());
+    const int64 num_scales =
+        NumElementsOfFloatScalarOrVectorConst(*scale_node_view->node());
+    if (num_offsets < 1 || num_scales < 1) continue;
+
+    // Per-channel offset and scale must match the number of channels, as the
+    // fused kernel does not broadcast the image over them.
+    if (num_offsets > 1 || num_scales > 1) {
+      if (!ctx.inferred_graph_properties) continue;
+      const auto& props =
+          ctx.graph_properties.GetInputProperties(resize_node_def->name());
+      if (props.empty() || props[0].shape().unknown_rank() ||
+          props[0].shape().dim_size() != 4)
+        continue;
+      const int64 channels = props[0].shape().dim(3).size();
+      if ((num_offsets > 1 && num_offsets != channels) ||
+          (num_scales > 1 && num_scales != channels))
+        continue;
+    }
+
+    matched->resize = resize_node_view->node_index();
+    matched->sub = sub_node_view->node_index();
+    matched->mul = mul_node_view->node_index();
+    matched->cast = cast_index;
+    matched->offset = offset_node_view->node_index();
+    matched->scale = scale_node_view->node_index();
+    return true;
+  }
+
+  return false;
+}
+
 void CopyConv2DAttributes(const NodeDef& conv2d, NodeDef* fused_conv2d,
                           const NodeDef* activation = nullptr) {
   DCHECK(IsConv2D(conv2d)) << "Input node must be a Conv2D";
@@ -1662,6 +1885,54 @@ Status AddFusedBatchNormGradExNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+Status AddFusedResizeBilinearNormalizeNode(
+    RemapperContext* ctx, const ResizeBilinearWithNormalize& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& resize = graph->node(matched.resize);
+  const NodeDef& sub = graph->node(matched.sub);
+  const NodeDef& mul = graph->node(matched.mul);
+  const int root = matched.cast != kMissingIndex ? matched.cast : matched.mul;
+  const NodeDef& root_node = graph->node(root);
+
+  VLOG(2) << "Fuse ResizeBilinear with normalization:"
+          << " resize=" << resize.name() << " sub=" << sub.name()
+          << " mul=" << mul.name() << " cast="
+          << (matched.cast != kMissingIndex ? root_node.name() : "<none>");
+
+  // Replace the root of the pattern with a _FusedResizeBilinearNormalize.
+  NodeDef fused_op;
+  fused_op.set_op(kFusedResizeBilinearNormalize);
+  fused_op.set_name(root_node.name());
+  fused_op.set_device(resize.device());
+
+  fused_op.add_input(resize.input(0));                     // 0: images
+  fused_op.add_input(resize.input(1));                     // 1: size
+  fused_op.add_input(graph->node(matched.offset).name());  // 2: offset
+  fused_op.add_input(graph->node(matched.scale).name());   // 3: scale
+
+  auto* attr = fused_op.mutable_attr();
+  auto& src_attr = resize.attr();
+  (*attr)["T"] = src_attr.at("T");
+  (*attr)["align_corners"] = src_attr.at("align_corners");
+  (*attr)["half_pixel_centers"] = src_attr.at("half_pixel_centers");
+  SetAttrValue(matched.cast != kMissingIndex ? DT_BFLOAT16 : DT_FLOAT,
+               &(*attr)["out_type"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[root] = true;
+  (*nodes_to_delete)[matched.resize] = true;
+  (*nodes_to_delete)[matched.sub] = true;
+  if (matched.cast != kMissingIndex) (*nodes_to_delete)[matched.mul] = true;
+
+  return Status::OK();
+}
+
 Status AddBatchNormNodes(RemapperContext* ctx, const FusedBatchNorm& matched) {
   const GraphDef* graph = ctx->graph_view.graph();
   const NodeDef& fused_node = graph->node(matched.fused_batch_norm);
@@ -1910,6 +2181,7 @@ bool IsContractionWithAdd(const RemapperContext& ctx, int node_index) {
 //   (3) Fusing Conv2D biasadd and relu on GPU
 //   (4) INTEL_MKL specific: Conv2D -> Add or Conv2D -> BiasAdd -> Add.
 //   (5) Fusing side output and/or activation into FusedBatchNormGrad.
+//   (6) Fusing per-channel normalization into ResizeBilinear.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1997,6 +2269,27 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
+  // Candidate for a ResizeBilinear + Sub + Mul [+ Cast] fusion.
+  const auto is_resize_normalize_candidate = [&]() -> bool {
+    const auto* mul_node_view = node_view;
+    if (IsCast(*node_def)) {
+      if (node_view->NumRegularFanins() < 1) return false;
+      mul_node_view = node_view->GetRegularFanin(0).node_view();
+    }
+    if (!IsMul(*mul_node_view->node())) return false;
+
+    for (const auto& mul_fanin : mul_node_view->GetRegularFanins()) {
+      const auto* sub_node_view = mul_fanin.node_view();
+      if (!IsSub(*sub_node_view->node())) continue;
+      if (sub_node_view->NumRegularFanins() < 1) continue;
+      if (sub_node_view->GetRegularFanin(0).node_view()->node()->op() ==
+          "ResizeBilinear")
+        return true;
+    }
+
+    return false;
+  };
+
   // TODO(intel-tf): Clean up #ifdef.
 #ifdef INTEL_MKL
   (void)is_relu_biasadd_conv2d_candidate;  // To fix unused variable error.
@@ -2006,11 +2299,13 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   else
     return is_relu_biasadd_conv2d_candidate() || is_batch_norm_candidate() ||
            is_batch_norm_fusion_candidate() ||
-           is_batch_norm_grad_fusion_candidate();
+           is_batch_norm_grad_fusion_candidate() ||
+           is_resize_normalize_candidate();
 #else
   return is_relu_biasadd_conv2d_candidate() || is_batch_norm_candidate() ||
          is_batch_norm_fusion_candidate() ||
-         is_batch_norm_grad_fusion_candidate();
+         is_batch_norm_grad_fusion_candidate() ||
+         is_resize_normalize_candidate();
 #endif  // INTEL_MKL
 }
 
@@ -2020,7 +2315,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
                           GraphDef* optimized_graph) {
   GrapplerItem mutable_item = item;
   Status status;
-  RemapperContext ctx(&mutable_item, &status, xla_auto_clustering_on_);
+  RemapperContext ctx(&mutable_item, &status, xla_auto_clustering_on_,
+                      cost_profile_.get());
   TF_RETURN_IF_ERROR(status);
   // Processing graph in reverse-topological sorted order allows to remap
   // longer chains of dependent ops in one pass.
@@ -2095,7 +2391,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // _Fused{Conv2D,DepthwiseConv2dNative,MatMul}
     ContractionWithBiasAdd contract_with_bias;
     if (allow_non_differentiable_rewrites &&
-        FindContractionWithBias(ctx, i, &contract_with_bias)) {
+        FindContractionWithBias(ctx, i, &contract_with_bias) &&
+        IsFusionProfitable(ctx, contract_with_bias)) {
       TF_RETURN_IF_ERROR(AddFusedContractionNode(
           &ctx, contract_with_bias, &invalidated_nodes, &nodes_to_delete));
       continue;
@@ -2106,7 +2403,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     ContractionWithBiasAddAndActivation contract_with_bias_and_activation;
     if (allow_non_differentiable_rewrites &&
         FindContractionWithBiasAndActivation(
-            ctx, i, &contract_with_bias_and_activation)) {
+            ctx, i, &contract_with_bias_and_activation) &&
+        IsFusionProfitable(ctx, contract_with_bias_and_activation)) {
       TF_RETURN_IF_ERROR(
           AddFusedContractionNode(&ctx, contract_with_bias_and_activation,
                                   &invalidated_nodes, &nodes_to_delete));
@@ -2120,7 +2418,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // Remap Conv2D+Squeeze+BiasAdd into the _FusedConv2D+Squeeze.
     ContractionWithSqueezeAndBiasAdd contract_with_squeeze_and_bias;
     if (allow_non_differentiable_rewrites &&
-        FindConv2DWithSqueezeAndBias(ctx, i, &contract_with_squeeze_and_bias)) {
+        FindConv2DWithSqueezeAndBias(ctx, i, &contract_with_squeeze_and_bias) &&
+        IsFusionProfitable(ctx, contract_with_squeeze_and_bias)) {
       TF_RETURN_IF_ERROR(
           AddFusedConv2DNode(&ctx, contract_with_squeeze_and_bias,
                              &invalidated_nodes, &nodes_to_delete));
@@ -2130,7 +2429,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // Remap Conv2D+FusedBatchNorm into the _FusedConv2D;
     ContractionWithBatchNorm contract_with_batch_norm;
     if (allow_non_differentiable_rewrites &&
-        FindConv2DWithBatchNorm(ctx, i, &contract_with_batch_norm)) {
+        FindConv2DWithBatchNorm(ctx, i, &contract_with_batch_norm) &&
+        IsFusionProfitable(ctx, contract_with_batch_norm)) {
       TF_RETURN_IF_ERROR(AddFusedConv2DNode(&ctx, contract_with_batch_norm,
                                             &invalidated_nodes,
                                             &nodes_to_delete));
@@ -2142,7 +2442,8 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
         contract_with_batch_norm_and_activation;
     if (allow_non_differentiable_rewrites &&
         FindConv2DWithBatchNormAndActivation(
-            ctx, i, &contract_with_batch_norm_and_activation)) {
+            ctx, i, &contract_with_batch_norm_and_activation) &&
+        IsFusionProfitable(ctx, contract_with_batch_norm_and_activation)) {
       TF_RETURN_IF_ERROR(
           AddFusedConv2DNode(&ctx, contract_with_batch_norm_and_activation,
                              &invalidated_nodes, &nodes_to_delete));
@@ -2167,6 +2468,16 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap ResizeBilinear+Sub+Mul+<Cast> into the
+    // _FusedResizeBilinearNormalize.
+    ResizeBilinearWithNormalize resize_with_normalize;
+    if (allow_non_differentiable_rewrites &&
+        FindResizeBilinearWithNormalize(ctx, i, &resize_with_normalize)) {
+      TF_RETURN_IF_ERROR(AddFusedResizeBilinearNormalizeNode(
+          &ctx, resize_with_normalize, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
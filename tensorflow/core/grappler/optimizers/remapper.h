@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_H_
 
+#include <memory>
+
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
@@ -24,12 +27,18 @@ namespace grappler {
 
 // Optimize TF computations by remapping subgraphs/nodes onto other subgraphs or
 // nodes to decrease the amount of operations needed to perform a computation.
+//
+// If `cost_profile` is not null, contractions are fused with their BiasAdd,
+// FusedBatchNorm and activation nodes only if the profile predicts that the
+// fused op is faster.
 class Remapper : public GraphOptimizer {
  public:
   explicit Remapper(RewriterConfig::Toggle opt_level,
-                    bool xla_auto_clustering_on = false)
+                    bool xla_auto_clustering_on = false,
+                    std::shared_ptr<const OpCostProfile> cost_profile = nullptr)
       : opt_level_(opt_level),
-        xla_auto_clustering_on_(xla_auto_clustering_on) {}
+        xla_auto_clustering_on_(xla_auto_clustering_on),
+        cost_profile_(std::move(cost_profile)) {}
 
   ~Remapper() override {}
 
@@ -46,6 +55,7 @@ class Remapper : public GraphOptimizer {
  private:
   RewriterConfig::Toggle opt_level_;
   bool xla_auto_clustering_on_;
+  std::shared_ptr<const OpCostProfile> cost_profile_;
 };
 
 }  // end namespace grappler
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/op_cost_profile.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/platform/test.h"
 
 #if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
 #include "third_party/gpus/cudnn/cudnn.h"
 #endif  // GOOGLE_CUDA
 
@@ -663,6 +665,65 @@ TEST_F(RemapperTest, FuseConv2DWithBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(RemapperTest, FuseConv2DWithBiasGuidedByCostProfile) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input_shape = ops::Placeholder::Shape({8, 32, 32, 3});
+  auto filter_shape = ops::Placeholder::Shape({1, 1, 3, 128});
+  auto bias_shape = ops::Placeholder::Shape({128});
+
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  std::vector<int> strides = {1, 1, 1, 1};
+  auto conv = ops::Conv2D(s.WithOpName("conv"), input, filter, strides, "SAME");
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), bias_add);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  const auto make_profile = [](int64 fused_cost) {
+    OpPerformanceList list;
+    const auto add_op = [&list](const string& op, int64 cost) {
+      OpPerformance* perf = list.add_op_performance();
+      perf->mutable_op()->set_op(op);
+      perf->set_compute_cost(cost);
+      return perf;
+    };
+    add_op("Conv2D", 100);
+    add_op("BiasAdd", 10);
+    OpPerformance* fused = add_op("_FusedConv2D", fused_cost);
+    (*fused->mutable_op()->mutable_attr())["fused_ops"]
+        .mutable_list()
+        ->add_s("BiasAdd");
+    return std::make_shared<const OpCostProfile>(list);
+  };
+
+  const auto bias_add_op = [&](int64 fused_cost) -> string {
+    Remapper optimizer(RewriterConfig::ON, /*xla_auto_clustering_on=*/false,
+                       make_profile(fused_cost));
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "bias_add") return node.op();
+    }
+    return "";
+  };
+
+  EXPECT_EQ("_FusedConv2D", bias_add_op(/*fused_cost=*/100));
+  EXPECT_EQ("BiasAdd", bias_add_op(/*fused_cost=*/200));
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
@@ -814,6 +875,79 @@ TEST_F(RemapperTest, DISABLED_FuseConv2DWithBiasAndActivationOnGPU) {
   }
 }
 
+TEST_F(RemapperTest, FuseMatMulWithBiasAndActivationOnGPU) {
+#if !(GOOGLE_CUDA && CUDA_VERSION >= 11000)
+  GTEST_SKIP() << "No CUDA 11, skip FuseMatMulWithBiasAndActivation on GPU";
+#endif  // !(GOOGLE_CUDA && CUDA_VERSION >= 11000)
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = Placeholder::Shape({8, 32});
+  auto rhs_shape = Placeholder::Shape({32, 64});
+  auto bias_shape = Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+  ops::Identity fetch = [&]() -> ops::Identity {
+    auto activate = s.WithOpName("activation");
+    auto fetch = s.WithOpName("fetch");
+    return ops::Identity(fetch, ops::Relu(activate, bias_add));
+  }();
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on GPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:GPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "activation") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+
+      EXPECT_EQ(node.attr().at("num_args").i(), 1);
+      EXPECT_EQ(node.input(2), "bias");
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Relu");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  if (GetNumAvailableGPUs() > 0) {
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    // cuBLAS may pick different (TensorFloat-32) algorithms for the fused and
+    // unfused matmul.
+    test::ExpectClose(tensors[0], tensors_expected[0], 1e-2, 1e-2);
+  }
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
   using ::tensorflow::ops::Placeholder;
 
@@ -1276,5 +1410,114 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+
+TEST_F(RemapperTest, FuseResizeBilinearWithNormalize) {
+  using ops::Placeholder;
+
+  for (bool cast_to_bfloat16 : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto input_shape = ops::Placeholder::Shape({2, 8, 10, 3});
+    auto input = Placeholder(s.WithOpName("input"), DT_UINT8, input_shape);
+    auto size = ops::Const(s.WithOpName("size"), {12, 7}, {2});
+    auto offset =
+        ops::Const(s.WithOpName("offset"), {123.7f, 116.3f, 103.5f}, {3});
+    auto scale = ops::Const(s.WithOpName("scale"), 1.0f / 58.0f);
+
+    auto resize = ops::ResizeBilinear(
+        s.WithOpName("resize"), input, size,
+        ops::ResizeBilinear::HalfPixelCenters(true));
+    auto sub = ops::Sub(s.WithOpName("sub"), resize, offset);
+    auto mul = ops::Mul(s.WithOpName("mul"), scale, sub);
+
+    Output normalized = mul;
+    if (cast_to_bfloat16) {
+      normalized = ops::Cast(s.WithOpName("cast"), mul, DT_BFLOAT16);
+    }
+    auto fetch = ops::Cast(s.WithOpName("fetch"), normalized, DT_FLOAT);
+
+    auto input_t = GenerateRandomTensor<DT_UINT8>({2, 8, 10, 3});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"input", input_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::AGGRESSIVE);  // trust placeholders shape
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    const string fused_name = cast_to_bfloat16 ? "cast" : "mul";
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "resize");
+      EXPECT_NE(node.name(), "sub");
+      if (node.name() == fused_name) {
+        EXPECT_EQ(node.op(), "_FusedResizeBilinearNormalize");
+        ASSERT_EQ(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "input");
+        EXPECT_EQ(node.input(1), "size");
+        EXPECT_EQ(node.input(2), "offset");
+        EXPECT_EQ(node.input(3), "scale");
+
+        auto attr = node.attr();
+        EXPECT_EQ(attr["T"].type(), DT_UINT8);
+        EXPECT_EQ(attr["out_type"].type(),
+                  cast_to_bfloat16 ? DT_BFLOAT16 : DT_FLOAT);
+        EXPECT_TRUE(attr["half_pixel_centers"].b());
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0],
+                                  cast_to_bfloat16 ? 1e-2 : 1e-5);
+  }
+}
+
+TEST_F(RemapperTest, DoNotFuseResizeBilinearWithMismatchedOffset) {
+  using ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // A single channel image is broadcast against the three offsets, which the
+  // fused kernel does not support.
+  auto input_shape = ops::Placeholder::Shape({1, 4, 4, 1});
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+  auto size = ops::Const(s.WithOpName("size"), {8, 8}, {2});
+  auto offset = ops::Const(s.WithOpName("offset"), {1.0f, 2.0f, 3.0f}, {3});
+  auto scale = ops::Const(s.WithOpName("scale"), 0.5f);
+
+  auto resize = ops::ResizeBilinear(s.WithOpName("resize"), input, size);
+  auto sub = ops::Sub(s.WithOpName("sub"), resize, offset);
+  auto mul = ops::Mul(s.WithOpName("mul"), sub, scale);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), mul);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::AGGRESSIVE);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "_FusedResizeBilinearNormalize");
+  }
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
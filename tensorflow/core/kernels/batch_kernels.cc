@@ -89,6 +89,8 @@ class BatchResource : public serving::BatchResourceBase {
                        FunctionLibraryRuntime::Handle fhandle,
                        FunctionLibraryRuntime* flib,
                        bool enable_large_batch_splitting,
+                       int32 length_bucket_dimension,
+                       const std::vector<int32>& length_bucket_boundaries,
                        std::unique_ptr<BatchResource>* resource) {
     BatcherT::Options batcher_options;
     batcher_options.num_batch_threads = num_batch_threads;
@@ -101,7 +103,8 @@ class BatchResource : public serving::BatchResourceBase {
                                batch_timeout_micros, max_enqueued_batches,
                                allowed_batch_sizes,
                                enable_large_batch_splitting),
-        allowed_batch_sizes));
+        allowed_batch_sizes, length_bucket_dimension,
+        length_bucket_boundaries));
     return Status::OK();
   }
 
@@ -110,6 +113,8 @@ class BatchResource : public serving::BatchResourceBase {
       int32 max_batch_size, int32 batch_timeout_micros,
       int32 max_enqueued_batches, const std::vector<int32>& allowed_batch_sizes,
       FunctionLibraryRuntime::Handle fhandle, FunctionLibraryRuntime* flib,
+      int32 length_bucket_dimension,
+      const std::vector<int32>& length_bucket_boundaries,
       std::unique_ptr<BatchResource>* resource) {
     std::shared_ptr<AdaptiveBatcherT> batcher;
     TF_RETURN_IF_ERROR(AdaptiveBatcherT::Create(
@@ -120,7 +125,8 @@ class BatchResource : public serving::BatchResourceBase {
         GetAdaptiveBatcherQueueOptions(
             max_batch_size, batch_timeout_micros, max_enqueued_batches,
             true /* enable large batch split */, allowed_batch_sizes),
-        allowed_batch_sizes));
+        allowed_batch_sizes, length_bucket_dimension,
+        length_bucket_boundaries));
     return Status::OK();
   }
 
@@ -130,11 +136,14 @@ class BatchResource : public serving::BatchResourceBase {
   BatchResource(FunctionLibraryRuntime::Handle fhandle,
                 FunctionLibraryRuntime* flib, std::shared_ptr<BatcherT> batcher,
                 const BatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                int32 length_bucket_dimension,
+                std::vector<int32> length_bucket_boundaries)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), length_bucket_dimension,
+            std::move(length_bucket_boundaries)),
         fhandle_(fhandle),
         flib_(flib) {}
 
@@ -142,11 +151,14 @@ class BatchResource : public serving::BatchResourceBase {
                 FunctionLibraryRuntime* flib,
                 std::shared_ptr<AdaptiveBatcherT> batcher,
                 const AdaptiveBatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                int32 length_bucket_dimension,
+                std::vector<int32> length_bucket_boundaries)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), length_bucket_dimension,
+            std::move(length_bucket_boundaries)),
         fhandle_(fhandle),
         flib_(flib) {}
 
@@ -229,7 +241,15 @@ class BatchFunctionKernel : public AsyncOpKernel {
       has_attribute_enable_large_batch_splitting_ = false;
     }
 
+    if (c->HasAttr("length_bucket_boundaries")) {
+      OP_REQUIRES_OK(c, c->GetAttr("length_bucket_boundaries",
+                                   &length_bucket_boundaries_));
+      OP_REQUIRES_OK(c, c->GetAttr("length_bucket_dimension",
+                                   &length_bucket_dimension_));
+    }
+
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(c, ValidateLengthBuckets());
   }
 
   bool IsExpensive() override { return false; }
@@ -280,7 +300,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
         TF_RETURN_IF_ERROR(BatchResource::Create(
             adaptive_shared_batch_scheduler_options, max_batch_size_,
             batch_timeout_micros_, max_enqueued_batches_, allowed_batch_sizes_,
-            handle, flib_, &new_resource));
+            handle, flib_, length_bucket_dimension_,
+            length_bucket_boundaries_, &new_resource));
         *r = new_resource.release();
         return Status::OK();
       };
@@ -290,7 +311,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
         TF_RETURN_IF_ERROR(BatchResource::Create(
             num_batch_threads_, max_batch_size_, batch_timeout_micros_,
             max_enqueued_batches_, allowed_batch_sizes_, handle, flib_,
-            enable_large_batch_splitting_, &new_resource));
+            enable_large_batch_splitting_, length_bucket_dimension_,
+            length_bucket_boundaries_, &new_resource));
         *r = new_resource.release();
         return Status::OK();
       };
@@ -408,6 +430,30 @@ class BatchFunctionKernel : public AsyncOpKernel {
     return Status::OK();
   }
 
+  // Validates the length bucket attributes. The boundaries must be positive and
+  // increase monotonically, and the bucketed dimension cannot be the batch
+  // dimension.
+  Status ValidateLengthBuckets() const {
+    if (length_bucket_boundaries_.empty()) {
+      return Status::OK();
+    }
+    if (length_bucket_dimension_ < 1) {
+      return errors::InvalidArgument(
+          "length_bucket_dimension must be at least 1; was ",
+          length_bucket_dimension_);
+    }
+    int32 last_boundary = 0;
+    for (const int32 boundary : length_bucket_boundaries_) {
+      if (boundary <= last_boundary) {
+        return errors::InvalidArgument(
+            "length_bucket_boundaries entries must be positive and "
+            "monotonically increasing");
+      }
+      last_boundary = boundary;
+    }
+    return Status::OK();
+  }
+
  private:
   string container_;
   string shared_name_;
@@ -422,6 +468,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
   FunctionLibraryRuntime* flib_;
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
+  int32 length_bucket_dimension_ = 1;
+  std::vector<int32> length_bucket_boundaries_;
   mutex mu_;
 
   // Parameters for adaptive batch scheduler only.
@@ -475,7 +523,8 @@ class BatchKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle,
-          /*flib=*/nullptr, false, &new_resource));
+          /*flib=*/nullptr, false, /*length_bucket_dimension=*/1,
+          /*length_bucket_boundaries=*/{}, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
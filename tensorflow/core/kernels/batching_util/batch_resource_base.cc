@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include <algorithm>
+
 #include "absl/types/optional.h"
 #include "tensorflow/core/framework/ops_util.h"
 #include "tensorflow/core/framework/tensor_util.h"
@@ -138,6 +140,30 @@ const string& GetModelName(OpKernelContext* ctx) {
   return ctx->session_metadata()->name();
 }
 
+// Records one event per request of a processed batch, from its enqueue to the
+// split of its outputs. The phase boundaries shared by the batch are attached
+// as stats, from which the profiler derives per-request timelines.
+void RecordBatchRequests(const BatchResourceBase::BatchT& batch,
+                         uint64 batch_start_time, uint64 compute_start_time,
+                         uint64 compute_end_time) {
+  if (!profiler::TraceMe::Active()) return;
+  const uint64 end_time = EnvTime::NowNanos();
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    const BatchResourceBase::BatchTask& task = batch.task(i);
+    profiler::TraceMe::CompleteActivity(
+        [&] {
+          return profiler::TraceMeEncode(
+              "BatchRequest",
+              {{"request_id", task.guid},
+               {"batching_input_task_size", task.size()},
+               {"batch_start_time_ns", batch_start_time},
+               {"compute_start_time_ns", compute_start_time},
+               {"compute_end_time_ns", compute_end_time}});
+        },
+        task.start_time, end_time);
+  }
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -231,8 +257,16 @@ Status BatchResourceBase::RegisterInput(
   batch_components->status = std::make_shared<ThreadSafeStatus>();
 
   BatcherQueueT* batcher_queue;
-  TF_RETURN_IF_ERROR(
-      LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+  if (length_bucket_boundaries_.empty()) {
+    TF_RETURN_IF_ERROR(
+        LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+  } else {
+    const int length_bucket =
+        GetLengthBucket(GetSequenceLength(batch_components->inputs));
+    TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(
+        absl::StrCat(batcher_queue_name, "/length_bucket_", length_bucket),
+        &batcher_queue));
+  }
   return batcher_queue->Schedule(&batch_components);
 }
 
@@ -327,6 +361,24 @@ int BatchResourceBase::RoundToLowestAllowedBatchSize(int batch_size) const {
   return batch_size;
 }
 
+int64 BatchResourceBase::GetSequenceLength(
+    const std::vector<Tensor>& inputs) const {
+  int64 sequence_length = 0;
+  for (const Tensor& input : inputs) {
+    if (input.dims() > length_bucket_dimension_) {
+      sequence_length =
+          std::max(sequence_length, input.dim_size(length_bucket_dimension_));
+    }
+  }
+  return sequence_length;
+}
+
+int BatchResourceBase::GetLengthBucket(int64 sequence_length) const {
+  return std::lower_bound(length_bucket_boundaries_.begin(),
+                          length_bucket_boundaries_.end(), sequence_length) -
+         length_bucket_boundaries_.begin();
+}
+
 Status BatchResourceBase::ConcatInputTensors(
     const BatchT& batch, OpKernelContext* context,
     std::vector<Tensor>* concatenated_tensors) const {
@@ -352,19 +404,46 @@ Status BatchResourceBase::ConcatInputTensors(
   const int num_inputs = batch.task(0).inputs.size();
   concatenated_tensors->reserve(num_inputs);
 
+  // With length buckets, every task is padded to the boundary of the batch's
+  // bucket (all tasks in a batch come from the same bucket), or to the longest
+  // task for the overflow bucket.
+  int64 padded_sequence_length = 0;
+  if (!length_bucket_boundaries_.empty()) {
+    for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
+      padded_sequence_length =
+          std::max(padded_sequence_length,
+                   GetSequenceLength(batch.task(task_idx).inputs));
+    }
+    const int length_bucket = GetLengthBucket(padded_sequence_length);
+    if (length_bucket < static_cast<int>(length_bucket_boundaries_.size())) {
+      padded_sequence_length = length_bucket_boundaries_[length_bucket];
+    }
+  }
+
   // Process each input one at a time (the typical case has just one).
   for (int i = 0; i < num_inputs; ++i) {
     // Concatenate the tasks ith input tensors into a big output tensor.
     std::vector<Tensor> to_concatenate;
     to_concatenate.reserve(batch.num_tasks());
     for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
-      to_concatenate.push_back(batch.task(task_idx).inputs.at(i));
+      const Tensor& input = batch.task(task_idx).inputs.at(i);
+      if (length_bucket_boundaries_.empty() ||
+          input.dims() <= length_bucket_dimension_ ||
+          input.dim_size(length_bucket_dimension_) == padded_sequence_length) {
+        to_concatenate.push_back(input);
+        continue;
+      }
+      Tensor padded_input;
+      TF_RETURN_IF_ERROR(concat_split_util::PadAlongDimension(
+          context, input, length_bucket_dimension_, padded_sequence_length,
+          &padded_input));
+      to_concatenate.push_back(std::move(padded_input));
     }
 
     // Add padding as needed. Use the first row of the first task's tensor as
     // the data for padding.
     if (padding_amount > 0) {
-      const Tensor& padding_source = batch.task(0).inputs.at(i);
+      const Tensor& padding_source = to_concatenate.front();
       Tensor padding;
       if (padding_source.shape().dim_size(0) == 0) {
         return errors::InvalidArgument(
@@ -408,12 +487,18 @@ Status BatchResourceBase::ConcatInputTensors(
        op_kernel_context = input_task.context, status = shared_status]() {
         const int num_output = op_kernel_context->num_outputs();
         for (int i = 0; i < num_output; ++i) {
+          // A single piece (the input was carried over whole into a fresh
+          // batch) is already the output; forward it without a copy.
+          if (output->size() == 1) {
+            op_kernel_context->set_output(i, std::move((*output)[0][i]));
+            continue;
+          }
+
           Tensor output_tensor;
 
           // Concat would memcpy each input tensor to one output tensor.
-          // In this context, Concat can be further optimized to get rid of
-          // some (probably all) memcpy when input tensors are slices of
-          // another copy.
+          // The pieces come from different batches, so they never share a
+          // buffer and the copy cannot be avoided.
           std::vector<Tensor> to_concatenate;
           to_concatenate.reserve(output->size());
           for (int j = 0; j < output->size(); ++j) {
@@ -531,23 +616,18 @@ Status BatchResourceBase::SplitOutputTensors(
           "the 0th dimension sizes of the input tensors");
     }
 
+    // Hand each task a zero-copy view of its rows of the batched output. The
+    // views keep the batched output alive until every task has released its
+    // piece. Views that are not aligned enough for Eigen are copied instead.
+    // The padding rows, if any, are not needed.
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
-    DCHECK(split_status.ok()) << split_status.ToString();
-    if (!split_status.ok()) {
-      return errors::Internal("Tensor split operation failed: ",
-                              split_status.ToString());
-    }
-    DCHECK_EQ(split_tensor.size(), task_sizes_plus_optional_padding.size());
-    if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
-      return errors::Internal(
-          "Tensor split operation did not work as expected; got ",
-          split_tensor.size(), " splits; expected ",
-          task_sizes_plus_optional_padding.size());
-    }
+    split_tensor.reserve(batch->num_tasks());
+    concat_split_util::SplitIntoSlices(
+        output_tensor,
+        gtl::ArraySlice<int64>(task_sizes_plus_optional_padding.data(),
+                               batch->num_tasks()),
+        &split_tensor);
 
-    // Ignore a possible final split_tensors entry containing the padding.
     for (int j = 0; j < batch->num_tasks(); ++j) {
       BatchTask& task = *(batch->mutable_task(j));
       if (task.is_partial) {
@@ -566,6 +646,7 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   if (batch->empty()) {
     return;
   }
+  const uint64 batch_start_time = EnvTime::NowNanos();
 
   // We use the 'propagated_context' from one of the threads which setup one
   // of the tasks. This will propagate any common context over all the threads
@@ -629,6 +710,7 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   finally.release();
   ProcessFuncBatchImpl(
       last_task, args, &combined_outputs, [&](const Status& run_status) {
+        const uint64 compute_end_time = EnvTime::NowNanos();
         Status final_status;
         auto run_finally = gtl::MakeCleanup([&]() {
           // We do the cleanup here as an optimization, so that
@@ -644,6 +726,10 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
           return;
         }
         final_status = SplitOutputTensors(combined_outputs, batch.get());
+        if (final_status.ok()) {
+          RecordBatchRequests(*batch, batch_start_time, current_time,
+                              compute_end_time);
+        }
       });
 }
 
@@ -89,6 +89,7 @@ class BatchResourceBase : public ResourceBase {
 
     bool is_partial = false;
 
+    // Time at which the task was enqueued, from EnvTime::NowNanos().
     uint64 start_time;
 
     size_t size() const override { return inputs[0].shape().dim_size(0); }
@@ -113,25 +114,35 @@ class BatchResourceBase : public ResourceBase {
   using BatcherQueueT = BatchScheduler<BatchResourceBase::BatchTask>;
   using BatchT = Batch<BatchResourceBase::BatchTask>;
 
+  // If 'length_bucket_boundaries' is non-empty, tasks are batched separately
+  // per length bucket; see 'length_bucket_boundaries_' below.
   BatchResourceBase(bool has_process_batch_function,
                     std::shared_ptr<BatcherT> batcher,
                     const BatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
+                    std::vector<int32> allowed_batch_sizes,
+                    int32 length_bucket_dimension = 1,
+                    std::vector<int32> length_bucket_boundaries = {})
       : has_process_batch_function_(has_process_batch_function),
         batcher_(std::move(batcher)),
         batcher_queue_options_(batcher_queue_options),
-        allowed_batch_sizes_(std::move(allowed_batch_sizes)) {
+        allowed_batch_sizes_(std::move(allowed_batch_sizes)),
+        length_bucket_dimension_(length_bucket_dimension),
+        length_bucket_boundaries_(std::move(length_bucket_boundaries)) {
     allowed_batch_sizes_str_ = absl::StrJoin(allowed_batch_sizes_, ",");
   }
 
   BatchResourceBase(bool has_process_batch_function,
                     std::shared_ptr<AdaptiveBatcherT> batcher,
                     const AdaptiveBatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
+                    std::vector<int32> allowed_batch_sizes,
+                    int32 length_bucket_dimension = 1,
+                    std::vector<int32> length_bucket_boundaries = {})
       : has_process_batch_function_(has_process_batch_function),
         adaptive_batcher_(std::move(batcher)),
         adaptive_batcher_queue_options_(batcher_queue_options),
-        allowed_batch_sizes_(std::move(allowed_batch_sizes)) {}
+        allowed_batch_sizes_(std::move(allowed_batch_sizes)),
+        length_bucket_dimension_(length_bucket_dimension),
+        length_bucket_boundaries_(std::move(length_bucket_boundaries)) {}
 
   static BatcherT::QueueOptions GetBatcherQueueOptions(
       int32 num_batch_threads, int32 max_batch_size, int32 batch_timeout_micros,
@@ -164,6 +175,15 @@ class BatchResourceBase : public ResourceBase {
   // returns 'batch_size'.
   int RoundToLowestAllowedBatchSize(int batch_size) const;
 
+  // Returns the length of 'inputs' along 'length_bucket_dimension_', i.e. the
+  // largest size of that dimension among the inputs that have it.
+  int64 GetSequenceLength(const std::vector<Tensor>& inputs) const;
+
+  // Returns the index of the length bucket for 'sequence_length': the first
+  // entry in 'length_bucket_boundaries_' that is greater than or equal to it,
+  // or 'length_bucket_boundaries_.size()' for the overflow bucket.
+  int GetLengthBucket(int64 sequence_length) const;
+
   Status ConcatInputTensors(const BatchT& batch, OpKernelContext* context,
                             std::vector<Tensor>* concatenated_tensors) const;
 
@@ -231,6 +251,18 @@ class BatchResourceBase : public ResourceBase {
   // A concatenated string of <allowed_batch_sizes_>, separated by ",". This is
   // used to record batching parameter.
   string allowed_batch_sizes_str_;
+
+  // Length bucketing for variable-length inputs. If
+  // 'length_bucket_boundaries_' is non-empty, each task goes to a separate
+  // batcher queue per bucket, chosen by its size along
+  // 'length_bucket_dimension_' (see GetLengthBucket()), and the inputs of a
+  // batch are zero-padded along that dimension up to the bucket's boundary.
+  // This lets variable-length tasks be batched without padding short ones to
+  // the longest length seen. Tasks longer than the last boundary share an
+  // overflow bucket and are padded to the longest among them. Inputs with no
+  // such dimension are left as is.
+  const int32 length_bucket_dimension_;
+  const std::vector<int32> length_bucket_boundaries_;
 };
 
 }  // namespace serving
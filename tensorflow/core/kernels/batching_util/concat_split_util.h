@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/ops_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/concat_lib.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/platform/status.h"
@@ -109,6 +110,98 @@ inline Status Concat(OpKernelContext* context,
   return concat_status;
 }
 
+// Pads 'input' with default-valued (i.e. zero or empty) elements along
+// 'dimension', so that the size of that dimension becomes 'length'. Requires
+// that all elements of 'input' have element type T and that 'length' is not
+// smaller than the current size. Writes to 'output' using 'context' for the
+// allocation to ensure proper device placement.
+template <typename T>
+Status PadAlongDimension(OpKernelContext* context, const Tensor& input,
+                         int dimension, int64 length, Tensor* output) {
+  if (dimension < 0 || dimension >= input.dims()) {
+    return errors::InvalidArgument("Cannot pad dimension ", dimension,
+                                   " of a tensor with shape ",
+                                   input.shape().DebugString());
+  }
+  const int64 input_length = input.dim_size(dimension);
+  if (length < input_length) {
+    return errors::InvalidArgument("Cannot pad dimension ", dimension,
+                                   " of a tensor with shape ",
+                                   input.shape().DebugString(), " to ", length);
+  }
+
+  TensorShape output_shape(input.shape());
+  output_shape.set_dim(dimension, length);
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  TF_RETURN_IF_ERROR(context->allocate_temp(DataTypeToEnum<T>::value,
+                                            output_shape, output, attr));
+  if (output->NumElements() == 0) {
+    return Status::OK();
+  }
+
+  // View both tensors as {outer, length, inner} and copy the input into the
+  // leading part of the middle dimension.
+  int64 outer = 1;
+  for (int i = 0; i < dimension; ++i) {
+    outer *= input.dim_size(i);
+  }
+  int64 inner = 1;
+  for (int i = dimension + 1; i < input.dims(); ++i) {
+    inner *= input.dim_size(i);
+  }
+  auto output_3d = output->shaped<T, 3>({outer, length, inner});
+  output_3d.setConstant(T());
+  if (input.NumElements() > 0) {
+    const Eigen::DSizes<Eigen::DenseIndex, 3> offsets(0, 0, 0);
+    const Eigen::DSizes<Eigen::DenseIndex, 3> extents(outer, input_length,
+                                                      inner);
+    output_3d.slice(offsets, extents) =
+        input.shaped<T, 3>({outer, input_length, inner});
+  }
+  return Status::OK();
+}
+
+// Same as 'PadAlongDimension' above, but handles Tensor dtype deduction
+// automatically.
+inline Status PadAlongDimension(OpKernelContext* context, const Tensor& input,
+                                int dimension, int64 length, Tensor* output) {
+  const DataType type = input.dtype();
+  Status pad_status;
+  switch (type) {
+#define CASE(type)                                                          \
+  case DataTypeToEnum<type>::value:                                         \
+    pad_status =                                                            \
+        PadAlongDimension<type>(context, input, dimension, length, output); \
+    break;
+    TF_CALL_ALL_TYPES(CASE);
+#undef CASE
+    default:
+      pad_status = errors::InvalidArgument("Unsupported data type: ", type);
+      break;
+  }
+  return pad_status;
+}
+
+// Splits 'input' along the zeroth dimension into 'sizes.size()' tensors, the
+// ith having zeroth-dimension size 'sizes[i]', without copying: the outputs
+// are views of 'input' and keep its buffer alive. Views that are not aligned
+// enough for Eigen are deep-copied instead. The sizes may add up to less than
+// the zeroth-dimension size of 'input'.
+inline void SplitIntoSlices(const Tensor& input,
+                            const gtl::ArraySlice<int64> sizes,
+                            std::vector<Tensor>* outputs) {
+  int64 position = 0;
+  for (const int64 size : sizes) {
+    Tensor slice = input.Slice(position, position + size);
+    if (!slice.IsAligned()) {
+      slice = tensor::DeepCopy(slice);
+    }
+    outputs->push_back(std::move(slice));
+    position += size;
+  }
+}
+
 // The Split*() functions split 'input' with element type T into 'sizes.size()'
 // tensors along the zeroth dimension, with the ith split having zeroth-
 // dimension size 'sizes[i]'. They allocate the output tensors using 'context',
@@ -149,6 +242,23 @@ Status SplitEasyCases(OpKernelContext* context, const Tensor& input,
     return Status::OK();
   }
 
+  // Special case 2: the inner dimensions are not aligned in general, but every
+  // requested slice happens to start at an aligned address.
+  std::vector<Tensor> slices;
+  slices.reserve(sizes.size());
+  int64 position = 0;
+  for (const int64 size : sizes) {
+    slices.push_back(input.Slice(position, position + size));
+    if (!slices.back().IsAligned()) {
+      return Status::OK();
+    }
+    position += size;
+  }
+  for (Tensor& slice : slices) {
+    outputs->push_back(std::move(slice));
+  }
+  *done = true;
+
   return Status::OK();
 }
 
@@ -0,0 +1,118 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/concat_split_util.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace concat_split_util {
+namespace {
+
+// Inner dimension sizes whose rows are respectively always and never aligned
+// for Eigen.
+constexpr int64 kAlignedRowSize = EIGEN_MAX_ALIGN_BYTES / sizeof(float);
+constexpr int64 kUnalignedRowSize = kAlignedRowSize + 1;
+
+// Returns a [num_rows, row_size] tensor whose elements are 0, 1, 2, ...
+Tensor Iota(int64 num_rows, int64 row_size) {
+  Tensor tensor(DT_FLOAT, TensorShape({num_rows, row_size}));
+  auto flat = tensor.flat<float>();
+  for (int64 i = 0; i < flat.size(); ++i) flat(i) = i;
+  return tensor;
+}
+
+// Checks that "slice" holds rows [begin, begin + num_rows) of Iota().
+void ExpectRows(const Tensor& slice, int64 begin, int64 num_rows,
+                int64 row_size) {
+  test::ExpectTensorEqual<float>(
+      Iota(begin + num_rows, row_size).Slice(begin, begin + num_rows), slice);
+}
+
+TEST(SplitEasyCasesTest, AlignedInputIsSplitIntoViews) {
+  Tensor input = Iota(8, kAlignedRowSize);
+  std::vector<Tensor> outputs;
+  bool done;
+  TF_ASSERT_OK(SplitEasyCases<float>(/*context=*/nullptr, input, {3, 5},
+                                     &outputs, &done));
+  ASSERT_TRUE(done);
+  ASSERT_EQ(2, outputs.size());
+  for (const Tensor& output : outputs) {
+    EXPECT_TRUE(output.SharesBufferWith(input));
+    // Views cannot be forwarded, so their rows are never written in place.
+    EXPECT_FALSE(output.RefCountIsOne());
+  }
+  EXPECT_EQ(input.tensor_data().data() + 3 * kAlignedRowSize * sizeof(float),
+            outputs[1].tensor_data().data());
+  // Neither can the input while the views are alive.
+  EXPECT_FALSE(input.RefCountIsOne());
+
+  // The views keep the buffer alive after the input is dropped.
+  input = Tensor();
+  ExpectRows(outputs[0], 0, 3, kAlignedRowSize);
+  ExpectRows(outputs[1], 3, 5, kAlignedRowSize);
+}
+
+TEST(SplitEasyCasesTest, UnalignedInputIsSplitAtAlignedOffsets) {
+  // Every slice starts at a multiple of EIGEN_MAX_ALIGN_BYTES.
+  const int64 rows_per_slice = kAlignedRowSize;
+  Tensor input = Iota(2 * rows_per_slice, kUnalignedRowSize);
+  std::vector<Tensor> outputs;
+  bool done;
+  TF_ASSERT_OK(SplitEasyCases<float>(/*context=*/nullptr, input,
+                                     {rows_per_slice, rows_per_slice},
+                                     &outputs, &done));
+  ASSERT_TRUE(done);
+  ASSERT_EQ(2, outputs.size());
+  EXPECT_TRUE(outputs[0].SharesBufferWith(input));
+  EXPECT_TRUE(outputs[1].SharesBufferWith(input));
+  ExpectRows(outputs[1], rows_per_slice, rows_per_slice, kUnalignedRowSize);
+}
+
+TEST(SplitEasyCasesTest, UnalignedSlicesAreNotEasy) {
+  Tensor input = Iota(4, kUnalignedRowSize);
+  std::vector<Tensor> outputs;
+  bool done;
+  TF_ASSERT_OK(SplitEasyCases<float>(/*context=*/nullptr, input, {1, 3},
+                                     &outputs, &done));
+  EXPECT_FALSE(done);
+  EXPECT_TRUE(outputs.empty());
+  EXPECT_TRUE(input.RefCountIsOne());
+}
+
+TEST(SplitIntoSlicesTest, CopiesOnlyUnalignedSlices) {
+  Tensor input = Iota(5, kUnalignedRowSize);
+  std::vector<Tensor> outputs;
+  // The last row is padding, which is not returned.
+  SplitIntoSlices(input, {1, 3}, &outputs);
+  ASSERT_EQ(2, outputs.size());
+  EXPECT_TRUE(outputs[0].SharesBufferWith(input));
+  EXPECT_FALSE(outputs[1].SharesBufferWith(input));
+  EXPECT_TRUE(outputs[1].IsAligned());
+
+  // Writing to the input only shows through the view.
+  input.matrix<float>()(0, 0) = -1;
+  input.matrix<float>()(1, 0) = -1;
+  EXPECT_EQ(-1, outputs[0].matrix<float>()(0, 0));
+  input = Tensor();
+  ExpectRows(outputs[1], 1, 3, kUnalignedRowSize);
+}
+
+}  // namespace
+}  // namespace concat_split_util
+}  // namespace tensorflow
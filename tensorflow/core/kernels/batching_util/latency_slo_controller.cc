@@ -0,0 +1,211 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_slo_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Weight given to older batches in the processing time fit, per new batch.
+constexpr double kFitDecay = 0.98;
+
+// The timeout is only raised while the estimate stays below this fraction of
+// the target, so that the controller does not oscillate around the target.
+constexpr double kHeadroomFraction = 0.9;
+
+// The timeout is raised in steps of this fraction of its allowed range.
+constexpr int64 kTimeoutStepDivisor = 16;
+
+int64 Percentile99(std::vector<int64>* samples) {
+  if (samples->empty()) return 0;
+  const size_t index =
+      std::min(samples->size() - 1, samples->size() * 99 / 100);
+  std::nth_element(samples->begin(), samples->begin() + index,
+                   samples->end());
+  return (*samples)[index];
+}
+
+void RecordBatchTimeoutMicros(int64 batch_timeout_micros, const string& name) {
+  static auto* cell = monitoring::Gauge<int64, 1>::New(
+      "/tensorflow/serving/batching/slo_controller/batch_timeout_micros",
+      "Tracks the batch timeout chosen by the latency SLO controller.",
+      "name");
+  cell->GetCell(name)->Set(batch_timeout_micros);
+}
+
+void RecordMaxBatchSize(int64 max_batch_size, const string& name) {
+  static auto* cell = monitoring::Gauge<int64, 1>::New(
+      "/tensorflow/serving/batching/slo_controller/max_batch_size",
+      "Tracks the maximum batch size chosen by the latency SLO controller.",
+      "name");
+  cell->GetCell(name)->Set(max_batch_size);
+}
+
+void RecordEstimatedP99LatencyMicros(int64 latency_micros,
+                                     const string& name) {
+  static auto* cell = monitoring::Gauge<int64, 1>::New(
+      "/tensorflow/serving/batching/slo_controller/estimated_p99_latency_us",
+      "Tracks the p99 latency the latency SLO controller based its last "
+      "decision on.",
+      "name");
+  cell->GetCell(name)->Set(latency_micros);
+}
+
+}  // namespace
+
+Status LatencySloController::Create(
+    const Options& options, std::unique_ptr<LatencySloController>* controller) {
+  if (options.target_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be positive; was ",
+        options.target_latency_micros);
+  }
+  if (options.min_batch_timeout_micros < 0 ||
+      options.min_batch_timeout_micros > options.max_batch_timeout_micros) {
+    return errors::InvalidArgument(
+        "min_batch_timeout_micros must be in [0, max_batch_timeout_micros]; "
+        "was ",
+        options.min_batch_timeout_micros, " with max_batch_timeout_micros ",
+        options.max_batch_timeout_micros);
+  }
+  if (options.min_batch_size < 1 ||
+      options.min_batch_size > options.max_batch_size) {
+    return errors::InvalidArgument(
+        "min_batch_size must be in [1, max_batch_size]; was ",
+        options.min_batch_size, " with max_batch_size ",
+        options.max_batch_size);
+  }
+  if (options.num_batches_per_adjustment < 1) {
+    return errors::InvalidArgument(
+        "num_batches_per_adjustment must be positive; was ",
+        options.num_batches_per_adjustment);
+  }
+  controller->reset(new LatencySloController(options));
+  return Status::OK();
+}
+
+LatencySloController::LatencySloController(const Options& options)
+    : options_(options),
+      batch_timeout_micros_(options.max_batch_timeout_micros),
+      max_batch_size_(options.max_batch_size) {
+  queueing_delays_micros_.reserve(options_.num_batches_per_adjustment);
+  processing_micros_.reserve(options_.num_batches_per_adjustment);
+  ExportMetrics();
+}
+
+void LatencySloController::RecordQueueingDelay(int64 queueing_delay_micros) {
+  mutex_lock l(mu_);
+  queueing_delays_micros_.push_back(std::max<int64>(0, queueing_delay_micros));
+}
+
+void LatencySloController::RecordBatchProcessed(size_t batch_size,
+                                                int64 processing_micros) {
+  mutex_lock l(mu_);
+  const double x = static_cast<double>(batch_size);
+  const double y = static_cast<double>(std::max<int64>(0, processing_micros));
+  sum_weight_ = sum_weight_ * kFitDecay + 1;
+  sum_x_ = sum_x_ * kFitDecay + x;
+  sum_y_ = sum_y_ * kFitDecay + y;
+  sum_xx_ = sum_xx_ * kFitDecay + x * x;
+  sum_xy_ = sum_xy_ * kFitDecay + x * y;
+
+  processing_micros_.push_back(std::max<int64>(0, processing_micros));
+  if (processing_micros_.size() >= options_.num_batches_per_adjustment) {
+    Adjust();
+  }
+}
+
+double LatencySloController::PredictProcessingMicros(size_t batch_size) const {
+  mutex_lock l(mu_);
+  return PredictProcessingMicrosLocked(static_cast<double>(batch_size));
+}
+
+double LatencySloController::PredictProcessingMicrosLocked(
+    double batch_size) const {
+  if (sum_weight_ == 0) return 0;
+  const double mean_x = sum_x_ / sum_weight_;
+  const double mean_y = sum_y_ / sum_weight_;
+  const double variance_x = sum_xx_ / sum_weight_ - mean_x * mean_x;
+  if (variance_x < 1e-6 * std::max(1.0, mean_x * mean_x)) {
+    // All recent batches had (almost) the same size, so the slope cannot be
+    // fitted. Assume processing time grows proportionally with batch size,
+    // which errs on the side of smaller batches.
+    return mean_x > 0 ? mean_y * batch_size / mean_x : mean_y;
+  }
+  const double slope =
+      std::max(0.0, (sum_xy_ / sum_weight_ - mean_x * mean_y) / variance_x);
+  const double intercept = mean_y - slope * mean_x;
+  return std::max(0.0, intercept + slope * batch_size);
+}
+
+void LatencySloController::Adjust() {
+  const int64 p99_latency_micros =
+      Percentile99(&queueing_delays_micros_) + Percentile99(&processing_micros_);
+  queueing_delays_micros_.clear();
+  processing_micros_.clear();
+
+  int64 timeout_micros = batch_timeout_micros_.load(std::memory_order_relaxed);
+  if (p99_latency_micros > options_.target_latency_micros) {
+    timeout_micros =
+        std::max(options_.min_batch_timeout_micros, timeout_micros / 2);
+  } else if (p99_latency_micros <
+             kHeadroomFraction * options_.target_latency_micros) {
+    const int64 step = std::max<int64>(
+        1, (options_.max_batch_timeout_micros -
+            options_.min_batch_timeout_micros) /
+               kTimeoutStepDivisor);
+    timeout_micros =
+        std::min(options_.max_batch_timeout_micros, timeout_micros + step);
+  }
+
+  // Largest batch size whose predicted processing time fits in the budget
+  // left after waiting for the timeout. The prediction is non-decreasing in
+  // the batch size, so binary search applies.
+  const double budget_micros =
+      static_cast<double>(options_.target_latency_micros - timeout_micros);
+  size_t lo = options_.min_batch_size;
+  size_t hi = options_.max_batch_size;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo + 1) / 2;
+    if (PredictProcessingMicrosLocked(mid) <= budget_micros) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  batch_timeout_micros_.store(timeout_micros, std::memory_order_relaxed);
+  max_batch_size_.store(lo, std::memory_order_relaxed);
+  estimated_p99_latency_micros_.store(p99_latency_micros,
+                                      std::memory_order_relaxed);
+  ExportMetrics();
+}
+
+void LatencySloController::ExportMetrics() const {
+  RecordBatchTimeoutMicros(batch_timeout_micros(), options_.name);
+  RecordMaxBatchSize(max_batch_size(), options_.name);
+  RecordEstimatedP99LatencyMicros(estimated_p99_latency_micros(),
+                                  options_.name);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,145 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_CONTROLLER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_CONTROLLER_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Adjusts the batch timeout and the maximum batch size of a single batching
+// queue so that the observed tail latency of its tasks stays under a target.
+//
+// The queue reports, for every batch it dispatches, how long the oldest task in
+// the batch waited ("queueing delay"), and for every batch it processes, the
+// batch size and how long the process-batch callback took. Every
+// 'num_batches_per_adjustment' processed batches the controller estimates the
+// p99 latency as the sum of the p99 queueing delay and the p99 processing time
+// over that window, and then:
+//  - if the estimate exceeds the target, halves the timeout (multiplicative
+//    decrease), since waiting is the cheapest latency to give back;
+//  - if the estimate is comfortably below the target, raises the timeout by a
+//    fixed step (additive increase) to form larger batches;
+//  - picks the largest batch size whose predicted processing time, from a
+//    decayed linear fit of processing time against batch size, fits in what is
+//    left of the target after the timeout.
+// Both knobs stay within the configured bounds. The decisions are exported
+// under /tensorflow/serving/batching/slo_controller/*, labeled by 'name'.
+//
+// This object is thread-safe. The current values may be read without
+// contention from the scheduler's hot path.
+class LatencySloController {
+ public:
+  struct Options {
+    // Label used for the exported metrics.
+    string name = "default";
+
+    // The latency target for a task, from the time it is scheduled to the time
+    // its batch finishes processing. Must be positive.
+    int64 target_latency_micros = 0;
+
+    // Bounds on the batch timeout. The controller starts at the upper bound.
+    int64 min_batch_timeout_micros = 0;
+    int64 max_batch_timeout_micros = 0;
+
+    // Bounds on the maximum batch size. The controller starts at the upper
+    // bound.
+    size_t min_batch_size = 1;
+    size_t max_batch_size = 1;
+
+    // How many processed batches make up one decision window.
+    int num_batches_per_adjustment = 32;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<LatencySloController>* controller);
+
+  // Records the time the oldest task of a batch spent waiting in the queue,
+  // measured when the batch is handed to a batch thread.
+  void RecordQueueingDelay(int64 queueing_delay_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that a batch of 'batch_size' took 'processing_micros' to process.
+  // May trigger an adjustment.
+  void RecordBatchProcessed(size_t batch_size, int64 processing_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // The batch timeout and maximum batch size the queue should currently use.
+  int64 batch_timeout_micros() const {
+    return batch_timeout_micros_.load(std::memory_order_relaxed);
+  }
+  size_t max_batch_size() const {
+    return max_batch_size_.load(std::memory_order_relaxed);
+  }
+
+  // The p99 latency estimate of the last decision window (0 before the first
+  // adjustment).
+  int64 estimated_p99_latency_micros() const {
+    return estimated_p99_latency_micros_.load(std::memory_order_relaxed);
+  }
+
+  // Predicted processing time of a batch of 'batch_size', from the batches
+  // seen so far. Returns 0 if nothing has been recorded yet.
+  double PredictProcessingMicros(size_t batch_size) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  explicit LatencySloController(const Options& options);
+
+  void Adjust() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  double PredictProcessingMicrosLocked(double batch_size) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void ExportMetrics() const;
+
+  const Options options_;
+
+  std::atomic<int64> batch_timeout_micros_;
+  std::atomic<size_t> max_batch_size_;
+  std::atomic<int64> estimated_p99_latency_micros_{0};
+
+  mutable mutex mu_;
+
+  // Samples of the current decision window.
+  std::vector<int64> queueing_delays_micros_ TF_GUARDED_BY(mu_);
+  std::vector<int64> processing_micros_ TF_GUARDED_BY(mu_);
+
+  // Exponentially decayed sums for the least-squares fit
+  // processing_micros ~= intercept + slope * batch_size.
+  double sum_weight_ TF_GUARDED_BY(mu_) = 0;
+  double sum_x_ TF_GUARDED_BY(mu_) = 0;
+  double sum_y_ TF_GUARDED_BY(mu_) = 0;
+  double sum_xx_ TF_GUARDED_BY(mu_) = 0;
+  double sum_xy_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LatencySloController);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_CONTROLLER_H_
@@ -0,0 +1,158 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_slo_controller.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+LatencySloController::Options DefaultOptions() {
+  LatencySloController::Options options;
+  options.target_latency_micros = 10000;
+  options.min_batch_timeout_micros = 0;
+  options.max_batch_timeout_micros = 4000;
+  options.min_batch_size = 1;
+  options.max_batch_size = 128;
+  options.num_batches_per_adjustment = 4;
+  return options;
+}
+
+// Feeds one decision window of identical batches.
+void RecordWindow(LatencySloController* controller, size_t batch_size,
+                  int64 queueing_delay_micros, int64 processing_micros) {
+  for (int i = 0; i < 4; ++i) {
+    controller->RecordQueueingDelay(queueing_delay_micros);
+    controller->RecordBatchProcessed(batch_size, processing_micros);
+  }
+}
+
+TEST(LatencySloControllerTest, InvalidOptions) {
+  std::unique_ptr<LatencySloController> controller;
+
+  LatencySloController::Options options = DefaultOptions();
+  options.target_latency_micros = 0;
+  EXPECT_FALSE(LatencySloController::Create(options, &controller).ok());
+
+  options = DefaultOptions();
+  options.min_batch_timeout_micros = 5000;
+  EXPECT_FALSE(LatencySloController::Create(options, &controller).ok());
+
+  options = DefaultOptions();
+  options.min_batch_size = 0;
+  EXPECT_FALSE(LatencySloController::Create(options, &controller).ok());
+
+  options = DefaultOptions();
+  options.min_batch_size = 256;
+  EXPECT_FALSE(LatencySloController::Create(options, &controller).ok());
+
+  options = DefaultOptions();
+  options.num_batches_per_adjustment = 0;
+  EXPECT_FALSE(LatencySloController::Create(options, &controller).ok());
+}
+
+TEST(LatencySloControllerTest, StartsAtUpperBounds) {
+  std::unique_ptr<LatencySloController> controller;
+  TF_ASSERT_OK(LatencySloController::Create(DefaultOptions(), &controller));
+  EXPECT_EQ(4000, controller->batch_timeout_micros());
+  EXPECT_EQ(128, controller->max_batch_size());
+  EXPECT_EQ(0, controller->estimated_p99_latency_micros());
+}
+
+TEST(LatencySloControllerTest, BacksOffTimeoutWhenOverTarget) {
+  std::unique_ptr<LatencySloController> controller;
+  TF_ASSERT_OK(LatencySloController::Create(DefaultOptions(), &controller));
+
+  RecordWindow(controller.get(), 8, 9000, 2000);
+  EXPECT_EQ(11000, controller->estimated_p99_latency_micros());
+  EXPECT_EQ(2000, controller->batch_timeout_micros());
+
+  RecordWindow(controller.get(), 8, 9000, 2000);
+  EXPECT_EQ(1000, controller->batch_timeout_micros());
+
+  // Never goes below the lower bound.
+  for (int i = 0; i < 20; ++i) {
+    RecordWindow(controller.get(), 8, 9000, 2000);
+  }
+  EXPECT_EQ(0, controller->batch_timeout_micros());
+}
+
+TEST(LatencySloControllerTest, RaisesTimeoutWithHeadroom) {
+  LatencySloController::Options options = DefaultOptions();
+  options.min_batch_timeout_micros = 1000;
+  std::unique_ptr<LatencySloController> controller;
+  TF_ASSERT_OK(LatencySloController::Create(options, &controller));
+
+  // Bring the timeout down first.
+  RecordWindow(controller.get(), 8, 9000, 2000);
+  EXPECT_EQ(2000, controller->batch_timeout_micros());
+
+  // Well under target: the timeout grows by (4000 - 1000) / 16 per window.
+  RecordWindow(controller.get(), 8, 1000, 100);
+  EXPECT_EQ(2187, controller->batch_timeout_micros());
+
+  // Within the headroom band: no change.
+  RecordWindow(controller.get(), 8, 8000, 1500);
+  EXPECT_EQ(2187, controller->batch_timeout_micros());
+
+  // Never goes above the upper bound.
+  for (int i = 0; i < 20; ++i) {
+    RecordWindow(controller.get(), 8, 1000, 100);
+  }
+  EXPECT_EQ(4000, controller->batch_timeout_micros());
+}
+
+TEST(LatencySloControllerTest, FitsBatchSizeIntoProcessingBudget) {
+  LatencySloController::Options options = DefaultOptions();
+  options.target_latency_micros = 10050;
+  options.max_batch_timeout_micros = 0;
+  std::unique_ptr<LatencySloController> controller;
+  TF_ASSERT_OK(LatencySloController::Create(options, &controller));
+
+  // Processing takes 1000us + 100us per element, so at most 90 elements fit in
+  // the target.
+  for (int i = 0; i < 8; ++i) {
+    const size_t batch_size = 8 * (i + 1);
+    controller->RecordQueueingDelay(0);
+    controller->RecordBatchProcessed(batch_size, 1000 + 100 * batch_size);
+  }
+  EXPECT_NEAR(5000, controller->PredictProcessingMicros(40), 1);
+  EXPECT_EQ(90, controller->max_batch_size());
+}
+
+TEST(LatencySloControllerTest, AssumesProportionalCostForOneBatchSize) {
+  LatencySloController::Options options = DefaultOptions();
+  options.min_batch_size = 16;
+  std::unique_ptr<LatencySloController> controller;
+  TF_ASSERT_OK(LatencySloController::Create(options, &controller));
+
+  // With only one batch size seen, processing time is assumed proportional to
+  // batch size: ~97us per element. The 4ms timeout leaves 6ms, i.e. 61
+  // elements.
+  RecordWindow(controller.get(), 32, 1000, 3100);
+  EXPECT_EQ(4000, controller->batch_timeout_micros());
+  EXPECT_EQ(61, controller->max_batch_size());
+
+  // If even small batches blow the budget, the lower bound holds.
+  RecordWindow(controller.get(), 1, 1000, 20000);
+  EXPECT_EQ(16, controller->max_batch_size());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -28,6 +28,7 @@ limitations under the License.
 
 #include "absl/time/clock.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/latency_slo_controller.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -195,6 +196,20 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If positive, the queue adjusts its batch timeout and maximum batch size
+    // at runtime so that the p99 latency of its tasks (queueing plus batch
+    // processing) stays under this target; see latency_slo_controller.h.
+    // 'batch_timeout_micros' and the maximum batch size above then act as
+    // upper bounds, and the two fields below as lower bounds. Useful when the
+    // load varies enough that no single timeout is right all day.
+    int64 target_latency_micros = 0;
+    int64 min_batch_timeout_micros = 0;
+    size_t min_execution_batch_size = 1;
+
+    // Label under which the adjusted parameters are exported as metrics when
+    // 'target_latency_micros' is set.
+    string latency_controller_name = "default";
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -271,9 +286,12 @@ class Queue {
       std::unique_ptr<TaskType>* input_task, int open_batch_remaining_slot,
       int max_execution_batch_size,
       std::vector<std::unique_ptr<TaskType>>* output_tasks)>;
+  // 'latency_controller' may be null, in which case the batch timeout and
+  // maximum batch size are fixed by 'options'.
   Queue(const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
         Env* env, ProcessBatchCallback process_batch_callback,
-        SchedulableBatchCallback schedulable_batch_callback);
+        SchedulableBatchCallback schedulable_batch_callback,
+        std::unique_ptr<LatencySloController> latency_controller = nullptr);
 
   // Illegal to destruct unless the queue is empty.
   ~Queue();
@@ -303,6 +321,9 @@ class Queue {
   // Returned value would be less than or equal to the maximum allowed input
   // size that's provided by caller of batch scheduler.
   size_t max_execution_batch_size() const {
+    if (latency_controller_ != nullptr) {
+      return latency_controller_->max_batch_size();
+    }
     if (options_.enable_large_batch_splitting) {
       return options_.max_execution_batch_size;
     } else {
@@ -346,6 +367,14 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns the batch timeout currently in effect.
+  int64 batch_timeout_micros() const {
+    if (latency_controller_ != nullptr) {
+      return latency_controller_->batch_timeout_micros();
+    }
+    return options_.batch_timeout_micros;
+  }
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -359,6 +388,9 @@ class Queue {
   // schedulable.
   SchedulableBatchCallback schedulable_batch_callback_;
 
+  // Adjusts the batch timeout and maximum batch size, if enabled.
+  const std::unique_ptr<LatencySloController> latency_controller_;
+
   mutable mutex mu_;
 
   // Whether this queue can accept new tasks. This variable is monotonic: it
@@ -376,6 +408,11 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
 
+  // The values of 'open_batch_start_time_micros_' for the closed batches in
+  // 'batches_', front to back. Only maintained if 'latency_controller_' is set,
+  // which needs them to measure queueing delay.
+  std::deque<uint64> closed_batch_start_times_micros_ TF_GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled.
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
@@ -493,6 +530,22 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         options.max_execution_batch_size);
   }
 
+  std::unique_ptr<LatencySloController> latency_controller;
+  if (options.target_latency_micros > 0) {
+    LatencySloController::Options controller_options;
+    controller_options.name = options.latency_controller_name;
+    controller_options.target_latency_micros = options.target_latency_micros;
+    controller_options.min_batch_timeout_micros =
+        options.min_batch_timeout_micros;
+    controller_options.max_batch_timeout_micros = options.batch_timeout_micros;
+    controller_options.min_batch_size = options.min_execution_batch_size;
+    controller_options.max_batch_size = options.enable_large_batch_splitting
+                                            ? options.max_execution_batch_size
+                                            : options.input_batch_size_limit;
+    TF_RETURN_IF_ERROR(
+        LatencySloController::Create(controller_options, &latency_controller));
+  }
+
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
     schedulable_batch_cv_.notify_one();
@@ -500,7 +553,7 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
   auto internal_queue =
       std::unique_ptr<internal::Queue<TaskType>>(new internal::Queue<TaskType>(
           options, options_.env, process_batch_callback,
-          schedulable_batch_callback));
+          schedulable_batch_callback, std::move(latency_controller)));
   auto handle = std::unique_ptr<BatchScheduler<TaskType>>(
       new internal::QueueHandle<TaskType>(this->shared_from_this(),
                                           internal_queue.get()));
@@ -590,11 +643,13 @@ template <typename TaskType>
 Queue<TaskType>::Queue(
     const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
     Env* env, ProcessBatchCallback process_batch_callback,
-    SchedulableBatchCallback schedulable_batch_callback)
+    SchedulableBatchCallback schedulable_batch_callback,
+    std::unique_ptr<LatencySloController> latency_controller)
     : options_(options),
       env_(env),
       process_batch_callback_(process_batch_callback),
-      schedulable_batch_callback_(schedulable_batch_callback) {
+      schedulable_batch_callback_(schedulable_batch_callback),
+      latency_controller_(std::move(latency_controller)) {
   // Set the higher 32 bits of traceme_context_id_counter_ to be the creation
   // time of the queue. This prevents the batches in different queues to have
   // the same traceme_context_id_counter_.
@@ -634,8 +689,12 @@ Status Queue<TaskType>::ScheduleWithoutSplit(std::unique_ptr<TaskType>* task) {
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() >
-        options_.input_batch_size_limit) {
+    // The open batch is closed once the task doesn't fit. (Without a latency
+    // controller the limit is 'input_batch_size_limit', which every task
+    // fits into on its own.)
+    if (!batches_.back()->empty() &&
+        batches_.back()->size() + (*task)->size() >
+            max_execution_batch_size()) {
       if (batches_.size() >= options_.max_enqueued_batches) {
         return errors::Unavailable(
             "The batch scheduling queue to which this task was submitted is "
@@ -688,7 +747,7 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
   }
 
   // The max size to be enqueued.
-  const int max_execution_batch_size = options_.max_execution_batch_size;
+  const int max_execution_batch_size = this->max_execution_batch_size();
 
   bool notify_of_schedulable_batch = false;
   {
@@ -731,7 +790,7 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
 
     for (int i = 0; i < output_tasks.size(); ++i) {
       if (batches_.back()->size() + output_tasks[i]->size() >
-          options_.max_execution_batch_size) {
+          max_execution_batch_size) {
         StartNewBatch();
       }
       if (batches_.back()->empty()) {
@@ -802,6 +861,11 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
       ++num_batches_being_processed_;
       batch_to_schedule = std::move(batches_.front());
       batches_.pop_front();
+      if (latency_controller_ != nullptr) {
+        latency_controller_->RecordQueueingDelay(
+            env_->NowMicros() - closed_batch_start_times_micros_.front());
+        closed_batch_start_times_micros_.pop_front();
+      }
     } else {
       schedulable_batch_ = false;
     }
@@ -820,7 +884,13 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
       },
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
+  const size_t batch_size = batch->size();
+  const uint64 process_start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
+  if (latency_controller_ != nullptr) {
+    latency_controller_->RecordBatchProcessed(
+        batch_size, env_->NowMicros() - process_start_time_micros);
+  }
 
   {
     mutex_lock l(mu_);
@@ -862,6 +932,9 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
   batches_.back()->Close();
+  if (latency_controller_ != nullptr) {
+    closed_batch_start_times_micros_.push_back(open_batch_start_time_micros_);
+  }
   batches_.emplace_back(new Batch<TaskType>(++traceme_context_id_counter_));
 }
 
@@ -884,7 +957,7 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros();
 }
 
 template <typename TaskType>
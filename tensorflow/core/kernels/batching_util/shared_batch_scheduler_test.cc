@@ -591,6 +591,80 @@ TEST(SharedBatchSchedulerTest, QueueDestructorBlocksUntilAllTasksProcessed) {
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, InvalidLatencyTargetOptions) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {};
+  SharedBatchScheduler<FakeTask>::Options options;
+  options.num_batch_threads = 1;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.input_batch_size_limit = 10;
+  queue_options.batch_timeout_micros = 1000;
+  queue_options.target_latency_micros = 5000;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+
+  queue_options.min_batch_timeout_micros = 2000;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler->AddQueue(queue_options, callback, &queue).code());
+
+  queue_options.min_batch_timeout_micros = 0;
+  queue_options.min_execution_batch_size = 20;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler->AddQueue(queue_options, callback, &queue).code());
+}
+
+TEST(SharedBatchSchedulerTest, LatencyTargetShrinksMaxBatchSize) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    // Each element takes 100us to process, so only 10 of them fit in the
+    // latency target.
+    mutex mu;
+    int num_batches_processed = 0;
+    condition_variable batch_processed_cv;
+    auto callback = [&env, &mu, &num_batches_processed,
+                     &batch_processed_cv](
+                        std::unique_ptr<Batch<FakeTask>> batch) {
+      env.AdvanceByMicroseconds(100 * batch->size());
+      mutex_lock l(mu);
+      ++num_batches_processed;
+      batch_processed_cv.notify_all();
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 100;
+    queue_options.batch_timeout_micros = 0;
+    queue_options.max_enqueued_batches = 2;
+    queue_options.target_latency_micros = 1000;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+    EXPECT_EQ(200, queue->SchedulingCapacity());
+
+    // One decision window of batches that blow the target, plus one more batch
+    // to make sure the batch thread is done recording the window.
+    constexpr int kNumBatches = 33;
+    for (int i = 0; i < kNumBatches; ++i) {
+      TF_ASSERT_OK(ScheduleTask(20, queue.get()));
+      mutex_lock l(mu);
+      while (num_batches_processed <= i) {
+        batch_processed_cv.wait(l);
+      }
+    }
+    EXPECT_EQ(20, queue->SchedulingCapacity());
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
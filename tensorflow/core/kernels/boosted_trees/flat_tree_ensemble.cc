@@ -0,0 +1,268 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/boosted_trees/flat_tree_ensemble.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace {
+
+// Examples walked through one tree before moving on to the next tree.
+constexpr int64 kExampleBlockSize = 64;
+// Fewest trees worth handing to a shard of their own.
+constexpr int32 kMinTreesPerShard = 16;
+// Estimated cycles to walk one tree for one example; the same magic number
+// the proto-walking kernel used.
+constexpr int64 kCostPerTree = 10;
+
+}  // namespace
+
+Status FlatTreeEnsemble::Create(const TreeEnsemble& ensemble,
+                                std::unique_ptr<FlatTreeEnsemble>* result) {
+  if (ensemble.tree_weights_size() < ensemble.trees_size()) {
+    return errors::InvalidArgument("Tree ensemble has ", ensemble.trees_size(),
+                                   " trees but only ",
+                                   ensemble.tree_weights_size(), " weights.");
+  }
+  std::unique_ptr<FlatTreeEnsemble> flat(new FlatTreeEnsemble());
+  flat->roots_.reserve(ensemble.trees_size());
+  std::vector<int32> flat_ids;
+  int32 num_leaves = 0;
+  for (int32 tree_id = 0; tree_id < ensemble.trees_size(); ++tree_id) {
+    const Tree& tree = ensemble.trees(tree_id);
+    const float tree_weight = ensemble.tree_weights(tree_id);
+    if (tree.nodes_size() == 0) {
+      return errors::InvalidArgument("Tree ", tree_id, " has no nodes.");
+    }
+    // First number every node, so that children can be linked by their flat
+    // ids regardless of where they appear in the tree.
+    flat_ids.resize(tree.nodes_size());
+    int32 num_splits = flat->splits_.size();
+    for (int32 node_id = 0; node_id < tree.nodes_size(); ++node_id) {
+      flat_ids[node_id] = tree.nodes(node_id).node_case() == Node::kLeaf
+                              ? ~num_leaves++
+                              : num_splits++;
+    }
+    flat->roots_.push_back(flat_ids[0]);
+
+    auto child = [&](int32 node_id, int32 child_id, int32* flat_id) {
+      if (child_id <= 0 || child_id >= tree.nodes_size()) {
+        return errors::InvalidArgument("Node ", node_id, " of tree ", tree_id,
+                                       " has invalid child ", child_id, ".");
+      }
+      *flat_id = flat_ids[child_id];
+      return Status::OK();
+    };
+    for (int32 node_id = 0; node_id < tree.nodes_size(); ++node_id) {
+      const Node& node = tree.nodes(node_id);
+      Split split;
+      switch (node.node_case()) {
+        case Node::kLeaf: {
+          const Leaf& leaf = node.leaf();
+          if (leaf.has_sparse_vector()) {
+            return errors::Unimplemented("Sparse leaf in tree ", tree_id,
+                                         " is not supported.");
+          }
+          const int32 dimension =
+              leaf.has_vector() ? leaf.vector().value_size() : 1;
+          if (flat->logits_dimension_ == 0) {
+            flat->logits_dimension_ = dimension;
+          } else if (dimension != flat->logits_dimension_) {
+            return errors::InvalidArgument(
+                "Leaf ", node_id, " of tree ", tree_id, " has ", dimension,
+                " logits, expected ", flat->logits_dimension_, ".");
+          }
+          if (leaf.has_vector()) {
+            for (const float value : leaf.vector().value()) {
+              flat->leaf_values_.push_back(tree_weight * value);
+            }
+          } else {
+            flat->leaf_values_.push_back(tree_weight * leaf.scalar());
+          }
+          continue;
+        }
+        case Node::kBucketizedSplit: {
+          const BucketizedSplit& bucketized = node.bucketized_split();
+          split.feature_id = bucketized.feature_id();
+          split.dimension_id = bucketized.dimension_id();
+          split.threshold = bucketized.threshold();
+          split.categorical = false;
+          TF_RETURN_IF_ERROR(
+              child(node_id, bucketized.left_id(), &split.left));
+          TF_RETURN_IF_ERROR(
+              child(node_id, bucketized.right_id(), &split.right));
+          break;
+        }
+        case Node::kCategoricalSplit: {
+          const CategoricalSplit& categorical = node.categorical_split();
+          split.feature_id = categorical.feature_id();
+          split.dimension_id = categorical.dimension_id();
+          split.threshold = categorical.value();
+          split.categorical = true;
+          TF_RETURN_IF_ERROR(
+              child(node_id, categorical.left_id(), &split.left));
+          TF_RETURN_IF_ERROR(
+              child(node_id, categorical.right_id(), &split.right));
+          break;
+        }
+        default:
+          return errors::Unimplemented("Node type ", node.node_case(),
+                                       " in tree ", tree_id,
+                                       " is not supported.");
+      }
+      flat->splits_.push_back(split);
+    }
+  }
+  *result = std::move(flat);
+  return Status::OK();
+}
+
+Status FlatTreeEnsemble::ValidateFeatures(
+    const std::vector<TTypes<int32>::ConstMatrix>& features) const {
+  for (const auto& feature : features) {
+    if (feature.dimension(0) != features[0].dimension(0)) {
+      return errors::InvalidArgument(
+          "All bucketized features must have the same batch size, got ",
+          feature.dimension(0), " and ", features[0].dimension(0), ".");
+    }
+  }
+  for (const Split& split : splits_) {
+    if (split.feature_id < 0 || split.feature_id >= features.size()) {
+      return errors::InvalidArgument("Split on feature ", split.feature_id,
+                                     ", but only ", features.size(),
+                                     " bucketized features were given.");
+    }
+    if (split.dimension_id < 0 ||
+        split.dimension_id >= features[split.feature_id].dimension(1)) {
+      return errors::InvalidArgument(
+          "Split on dimension ", split.dimension_id, " of feature ",
+          split.feature_id, ", which has ",
+          features[split.feature_id].dimension(1), " dimensions.");
+    }
+  }
+  return Status::OK();
+}
+
+void FlatTreeEnsemble::AddLogits(
+    const std::vector<TTypes<int32>::ConstMatrix>& features,
+    int64 example_begin, int64 example_end, int32 tree_begin, int32 tree_end,
+    float* logits) const {
+  std::vector<const int32*> columns;
+  std::vector<int64> strides;
+  columns.reserve(features.size());
+  strides.reserve(features.size());
+  for (const auto& feature : features) {
+    columns.push_back(feature.data());
+    strides.push_back(feature.dimension(1));
+  }
+  const Split* const splits = splits_.data();
+  const int32 dimension = logits_dimension_;
+  for (int64 block_begin = example_begin; block_begin < example_end;
+       block_begin += kExampleBlockSize) {
+    const int64 block_end =
+        std::min(block_begin + kExampleBlockSize, example_end);
+    for (int32 tree_id = tree_begin; tree_id < tree_end; ++tree_id) {
+      for (int64 i = block_begin; i < block_end; ++i) {
+        int32 node = roots_[tree_id];
+        while (node >= 0) {
+          const Split& split = splits[node];
+          const int32 value = columns[split.feature_id]
+                                     [i * strides[split.feature_id] +
+                                      split.dimension_id];
+          const bool go_left = split.categorical ? value == split.threshold
+                                                 : value <= split.threshold;
+          node = go_left ? split.left : split.right;
+        }
+        const float* leaf =
+            &leaf_values_[static_cast<int64>(~node) * dimension];
+        float* row = logits + i * dimension;
+        for (int32 j = 0; j < dimension; ++j) {
+          row[j] += leaf[j];
+        }
+      }
+    }
+  }
+}
+
+void FlatTreeEnsemble::Predict(
+    const std::vector<TTypes<int32>::ConstMatrix>& features,
+    thread::ThreadPool* workers, TTypes<float>::Matrix logits) const {
+  logits.setZero();
+  const int64 batch_size = logits.dimension(0);
+  const int32 num_trees = this->num_trees();
+  if (batch_size == 0 || num_trees == 0) {
+    return;
+  }
+  DCHECK_EQ(logits.dimension(1), logits_dimension_);
+  const int num_threads = workers->NumThreads();
+  const int64 num_blocks =
+      (batch_size + kExampleBlockSize - 1) / kExampleBlockSize;
+  int32 trees_per_shard = num_trees;
+  if (num_blocks < num_threads) {
+    const int32 num_tree_shards = std::max<int64>(
+        1, std::min<int64>(num_threads / num_blocks,
+                           num_trees / kMinTreesPerShard));
+    trees_per_shard = (num_trees + num_tree_shards - 1) / num_tree_shards;
+  }
+
+  if (trees_per_shard == num_trees) {
+    auto do_work = [this, &features, &logits, num_trees](int64 start,
+                                                         int64 end) {
+      AddLogits(features, start, end, 0, num_trees, logits.data());
+    };
+    Shard(num_threads, workers, batch_size,
+          /*cost_per_unit=*/num_trees * kCostPerTree, do_work);
+    return;
+  }
+
+  // Each tree shard sums into its own buffer; the buffers are then added in
+  // tree order.
+  const int32 num_tree_shards =
+      (num_trees + trees_per_shard - 1) / trees_per_shard;
+  const int64 shard_size = batch_size * logits_dimension_;
+  std::vector<float> partial_logits(num_tree_shards * shard_size, 0.0f);
+  auto do_work = [this, &features, &partial_logits, batch_size, num_blocks,
+                  num_trees, trees_per_shard,
+                  shard_size](int64 start, int64 end) {
+    for (int64 unit = start; unit < end; ++unit) {
+      const int32 tree_shard = unit / num_blocks;
+      const int64 block = unit % num_blocks;
+      const int32 tree_begin = tree_shard * trees_per_shard;
+      AddLogits(features, block * kExampleBlockSize,
+                std::min(batch_size, (block + 1) * kExampleBlockSize),
+                tree_begin, std::min(num_trees, tree_begin + trees_per_shard),
+                &partial_logits[tree_shard * shard_size]);
+    }
+  };
+  Shard(num_threads, workers, num_tree_shards * num_blocks,
+        /*cost_per_unit=*/kExampleBlockSize * trees_per_shard * kCostPerTree,
+        do_work);
+  float* output = logits.data();
+  for (int32 tree_shard = 0; tree_shard < num_tree_shards; ++tree_shard) {
+    const float* partial = &partial_logits[tree_shard * shard_size];
+    for (int64 k = 0; k < shard_size; ++k) {
+      output[k] += partial[k];
+    }
+  }
+}
+
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_FLAT_TREE_ENSEMBLE_H_
+#define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_FLAT_TREE_ENSEMBLE_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+
+class TreeEnsemble;
+
+// An inference-only copy of a TreeEnsemble proto, compiled into flat arrays.
+//
+// Walking the proto costs a oneof dispatch and several indirections per node.
+// Here every split of every tree lives in one contiguous array of fixed-size
+// records whose child links point straight at the next split or, when
+// negative, at a leaf whose logits are already scaled by the tree weight.
+// Prediction walks one tree for a block of examples before moving on to the
+// next tree, so that tree's splits stay in cache across the whole block.
+// Each example still sums its trees in ensemble order.
+class FlatTreeEnsemble {
+ public:
+  // Compiles `ensemble`. Fails for node types that prediction does not
+  // support and for leaves whose logits dimensions disagree.
+  static Status Create(const TreeEnsemble& ensemble,
+                       std::unique_ptr<FlatTreeEnsemble>* result);
+
+  int32 num_trees() const { return roots_.size(); }
+  int32 num_splits() const { return splits_.size(); }
+  // The size of each leaf's logits vector, or 0 for an empty ensemble.
+  int32 logits_dimension() const { return logits_dimension_; }
+
+  // Checks that every split reads an existing column of `features`.
+  Status ValidateFeatures(
+      const std::vector<TTypes<int32>::ConstMatrix>& features) const;
+
+  // Adds the weighted logits of trees [tree_begin, tree_end) for examples
+  // [example_begin, example_end) to `logits`, a row-major
+  // [batch_size, logits_dimension] buffer.
+  void AddLogits(const std::vector<TTypes<int32>::ConstMatrix>& features,
+                 int64 example_begin, int64 example_end, int32 tree_begin,
+                 int32 tree_end, float* logits) const;
+
+  // Writes the logits of the whole ensemble for every example to `logits`,
+  // sharding across blocks of examples on `workers`. Batches too small to
+  // occupy every worker are additionally sharded across ranges of trees,
+  // whose partial sums are then added in tree order.
+  void Predict(const std::vector<TTypes<int32>::ConstMatrix>& features,
+               thread::ThreadPool* workers,
+               TTypes<float>::Matrix logits) const;
+
+ private:
+  struct Split {
+    int32 feature_id;
+    int32 dimension_id;
+    // Bucket threshold, or the category for categorical splits.
+    int32 threshold;
+    bool categorical;
+    // Index of the next split, or ~leaf_index for leaves.
+    int32 left;
+    int32 right;
+  };
+
+  FlatTreeEnsemble() = default;
+
+  std::vector<Split> splits_;
+  // Per tree, the index of the root split, or ~leaf_index if the root is a
+  // leaf.
+  std::vector<int32> roots_;
+  // [num_leaves, logits_dimension_] leaf logits times the tree weight.
+  std::vector<float> leaf_values_;
+  int32 logits_dimension_ = 0;
+};
+
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_FLAT_TREE_ENSEMBLE_H_
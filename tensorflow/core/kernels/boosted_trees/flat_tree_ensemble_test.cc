@@ -0,0 +1,169 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/boosted_trees/flat_tree_ensemble.h"
+
+#include <vector>
+
+#include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace {
+
+// Two trees over a bucketized feature with two dimensions and a categorical
+// feature:
+//   tree 0 (weight 1): feature 0, dimension 1 <= 4 ? 1.0 : 2.0
+//   tree 1 (weight 0.5): feature 1 == 3 ? -4.0 : 6.0
+constexpr char kEnsemble[] = R"(
+  trees {
+    nodes { bucketized_split {
+      feature_id: 0 dimension_id: 1 threshold: 4 left_id: 1 right_id: 2 } }
+    nodes { leaf { scalar: 1.0 } }
+    nodes { leaf { scalar: 2.0 } }
+  }
+  trees {
+    nodes { categorical_split {
+      feature_id: 1 value: 3 left_id: 1 right_id: 2 } }
+    nodes { leaf { scalar: -4.0 } }
+    nodes { leaf { scalar: 6.0 } }
+  }
+  tree_weights: 1.0
+  tree_weights: 0.5
+)";
+
+TreeEnsemble ParseEnsemble(const char* text) {
+  TreeEnsemble ensemble;
+  CHECK(protobuf::TextFormat::ParseFromString(text, &ensemble));
+  return ensemble;
+}
+
+TEST(FlatTreeEnsembleTest, Predict) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  TF_ASSERT_OK(FlatTreeEnsemble::Create(ParseEnsemble(kEnsemble), &flat));
+  EXPECT_EQ(2, flat->num_trees());
+  EXPECT_EQ(2, flat->num_splits());
+  EXPECT_EQ(1, flat->logits_dimension());
+
+  const std::vector<int32> bucketized = {0, 4, 0, 5, 9, 1};
+  const std::vector<int32> categorical = {3, 3, 2};
+  std::vector<TTypes<int32>::ConstMatrix> features = {
+      TTypes<int32>::ConstMatrix(bucketized.data(), 3, 2),
+      TTypes<int32>::ConstMatrix(categorical.data(), 3, 1)};
+  TF_ASSERT_OK(flat->ValidateFeatures(features));
+
+  std::vector<float> logits(3);
+  thread::ThreadPool workers(Env::Default(), "test", 2);
+  flat->Predict(features, &workers,
+                TTypes<float>::Matrix(logits.data(), 3, 1));
+  EXPECT_EQ(1.0f - 2.0f, logits[0]);
+  EXPECT_EQ(2.0f - 2.0f, logits[1]);
+  EXPECT_EQ(1.0f + 3.0f, logits[2]);
+}
+
+TEST(FlatTreeEnsembleTest, RejectsMissingFeature) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  TF_ASSERT_OK(FlatTreeEnsemble::Create(ParseEnsemble(kEnsemble), &flat));
+  const std::vector<int32> bucketized = {0, 4};
+  std::vector<TTypes<int32>::ConstMatrix> features = {
+      TTypes<int32>::ConstMatrix(bucketized.data(), 1, 2)};
+  EXPECT_FALSE(flat->ValidateFeatures(features).ok());
+}
+
+TEST(FlatTreeEnsembleTest, RejectsMismatchedLeaves) {
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  EXPECT_FALSE(FlatTreeEnsemble::Create(ParseEnsemble(R"(
+      trees { nodes { leaf { scalar: 1.0 } } }
+      trees { nodes { leaf { vector { value: 1.0 value: 2.0 } } } }
+      tree_weights: 1.0
+      tree_weights: 1.0
+  )"),
+                                        &flat)
+                   .ok());
+}
+
+// Builds `num_trees` random trees of the given depth over a single
+// bucketized feature with `num_dimensions` dimensions.
+TreeEnsemble RandomEnsemble(int num_trees, int depth, int num_dimensions,
+                            int logits_dimension) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rng(&philox);
+  TreeEnsemble ensemble;
+  for (int t = 0; t < num_trees; ++t) {
+    Tree* tree = ensemble.add_trees();
+    ensemble.add_tree_weights(rng.RandFloat());
+    const int num_splits = (1 << depth) - 1;
+    for (int n = 0; n < 2 * num_splits + 1; ++n) {
+      Node* node = tree->add_nodes();
+      if (n < num_splits) {
+        BucketizedSplit* split = node->mutable_bucketized_split();
+        split->set_dimension_id(rng.Uniform(num_dimensions));
+        split->set_threshold(rng.Uniform(10));
+        split->set_left_id(2 * n + 1);
+        split->set_right_id(2 * n + 2);
+      } else {
+        for (int j = 0; j < logits_dimension; ++j) {
+          node->mutable_leaf()->mutable_vector()->add_value(rng.RandFloat());
+        }
+      }
+    }
+  }
+  return ensemble;
+}
+
+TEST(FlatTreeEnsembleTest, ShardingMatchesSerialWalk) {
+  const int kNumTrees = 200;
+  const int kNumDimensions = 5;
+  const int kLogitsDimension = 3;
+  std::unique_ptr<FlatTreeEnsemble> flat;
+  TF_ASSERT_OK(FlatTreeEnsemble::Create(
+      RandomEnsemble(kNumTrees, /*depth=*/4, kNumDimensions, kLogitsDimension),
+      &flat));
+
+  random::PhiloxRandom philox(7, 11);
+  random::SimplePhilox rng(&philox);
+  thread::ThreadPool workers(Env::Default(), "test", 8);
+  // A small batch is sharded across trees, a large one across examples.
+  for (const int batch_size : {3, 1000}) {
+    std::vector<int32> bucketized(batch_size * kNumDimensions);
+    for (int32& value : bucketized) {
+      value = rng.Uniform(10);
+    }
+    std::vector<TTypes<int32>::ConstMatrix> features = {
+        TTypes<int32>::ConstMatrix(bucketized.data(), batch_size,
+                                   kNumDimensions)};
+    TF_ASSERT_OK(flat->ValidateFeatures(features));
+
+    std::vector<float> expected(batch_size * kLogitsDimension, 0.0f);
+    flat->AddLogits(features, 0, batch_size, 0, kNumTrees, expected.data());
+    std::vector<float> actual(batch_size * kLogitsDimension);
+    flat->Predict(features, &workers,
+                  TTypes<float>::Matrix(actual.data(), batch_size,
+                                        kLogitsDimension));
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(expected[i], actual[i], 1e-4) << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace boosted_trees
+}  // namespace tensorflow
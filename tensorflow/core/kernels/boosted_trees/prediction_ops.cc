@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/boosted_trees/boosted_trees.pb.h"
+#include "tensorflow/core/kernels/boosted_trees/flat_tree_ensemble.h"
 #include "tensorflow/core/kernels/boosted_trees/resources.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
@@ -229,52 +231,30 @@ class BoostedTreesPredictOp : public OpKernel {
                                 &output_logits_t));
     auto output_logits = output_logits_t->matrix<float>();
 
-    // Return zero logits if it's an empty ensemble.
-    if (resource->num_trees() <= 0) {
-      output_logits.setZero();
-      return;
+    std::shared_ptr<const boosted_trees::FlatTreeEnsemble> flat_ensemble;
+    {
+      tf_shared_lock l(*resource->get_mutex());
+      // Return zero logits if it's an empty ensemble.
+      if (resource->num_trees() <= 0) {
+        output_logits.setZero();
+        return;
+      }
+      OP_REQUIRES_OK(context, resource->GetFlatEnsemble(&flat_ensemble));
     }
+    OP_REQUIRES(context,
+                flat_ensemble->logits_dimension() == logits_dimension_,
+                errors::InvalidArgument(
+                    "Tree ensemble has ", flat_ensemble->logits_dimension(),
+                    " logits per leaf, but logits_dimension is ",
+                    logits_dimension_, "."));
+    OP_REQUIRES_OK(context,
+                   flat_ensemble->ValidateFeatures(bucketized_features));
 
-    const int32 last_tree = resource->num_trees() - 1;
-    auto do_work = [&resource, &bucketized_features, &output_logits, last_tree,
-                    this](int64 start, int64 end) {
-      for (int32 i = start; i < end; ++i) {
-        std::vector<float> tree_logits(logits_dimension_, 0.0);
-        int32 tree_id = 0;
-        int32 node_id = 0;
-        while (true) {
-          if (resource->is_leaf(tree_id, node_id)) {
-            const float tree_weight = resource->GetTreeWeight(tree_id);
-            const auto& leaf_logits = resource->node_value(tree_id, node_id);
-            DCHECK_EQ(leaf_logits.size(), logits_dimension_);
-            for (int32 j = 0; j < logits_dimension_; ++j) {
-              tree_logits[j] += tree_weight * leaf_logits[j];
-            }
-            // Stop if it was the last tree.
-            if (tree_id == last_tree) {
-              break;
-            }
-            // Move onto other trees.
-            ++tree_id;
-            node_id = 0;
-          } else {
-            node_id =
-                resource->next_node(tree_id, node_id, i, bucketized_features);
-          }
-        }
-        for (int32 j = 0; j < logits_dimension_; ++j) {
-          output_logits(i, j) = tree_logits[j];
-        }
-      }
-    };
-    // 10 is the magic number. The actual number might depend on (the number of
-    // layers in the trees) and (cpu cycles spent on each layer), but this
-    // value would work for many cases. May be tuned later.
-    const int64 cost = (last_tree + 1) * 10;
+    // Walk the compiled ensemble rather than the proto; see
+    // FlatTreeEnsemble for how the work is laid out and sharded.
     thread::ThreadPool* const worker_threads =
         context->device()->tensorflow_cpu_worker_threads()->workers;
-    Shard(worker_threads->NumThreads(), worker_threads, batch_size,
-          /*cost_per_unit=*/cost, do_work);
+    flat_ensemble->Predict(bucketized_features, worker_threads, output_logits);
   }
 
  private:
@@ -374,6 +374,23 @@ void BoostedTreesEnsembleResource::Reset() {
   arena_.Reset();
   tree_ensemble_ =
       protobuf::Arena::CreateMessage<boosted_trees::TreeEnsemble>(&arena_);
+
+  mutex_lock l(flat_ensemble_mu_);
+  flat_ensemble_.reset();
+}
+
+Status BoostedTreesEnsembleResource::GetFlatEnsemble(
+    std::shared_ptr<const boosted_trees::FlatTreeEnsemble>* flat_ensemble) {
+  mutex_lock l(flat_ensemble_mu_);
+  if (flat_ensemble_ == nullptr || flat_ensemble_stamp_ != stamp()) {
+    std::unique_ptr<boosted_trees::FlatTreeEnsemble> compiled;
+    TF_RETURN_IF_ERROR(
+        boosted_trees::FlatTreeEnsemble::Create(*tree_ensemble_, &compiled));
+    flat_ensemble_ = std::move(compiled);
+    flat_ensemble_stamp_ = stamp();
+  }
+  *flat_ensemble = flat_ensemble_;
+  return Status::OK();
 }
 
 void BoostedTreesEnsembleResource::PostPruneTree(const int32 current_tree,
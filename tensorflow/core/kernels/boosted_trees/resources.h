@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 #define TENSORFLOW_CORE_KERNELS_BOOSTED_TREES_RESOURCES_H_
 
+#include <memory>
+
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/kernels/boosted_trees/flat_tree_ensemble.h"
 #include "tensorflow/core/kernels/boosted_trees/tree_helper.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -152,6 +155,12 @@ class BoostedTreesEnsembleResource : public StampedResource {
                               std::vector<float>* logit_updates) const;
   mutex* get_mutex() { return &mu_; }
 
+  // Returns the ensemble compiled for fast prediction, recompiling it if the
+  // stamp changed since it was last compiled. Caller needs to hold at least a
+  // shared lock on the mutex while calling this.
+  Status GetFlatEnsemble(
+      std::shared_ptr<const boosted_trees::FlatTreeEnsemble>* flat_ensemble);
+
  private:
   // Helper method to check whether a node is a terminal node in that it
   // only has leaf nodes as children.
@@ -171,6 +180,13 @@ class BoostedTreesEnsembleResource : public StampedResource {
       std::vector<int32>* nodes_to_delete,
       std::vector<std::pair<int32, std::vector<float>>>* nodes_meta);
 
+  // Prediction-only compilation of tree_ensemble_ and the stamp it was
+  // compiled at.
+  mutex flat_ensemble_mu_;
+  std::shared_ptr<const boosted_trees::FlatTreeEnsemble> flat_ensemble_
+      TF_GUARDED_BY(flat_ensemble_mu_);
+  int64 flat_ensemble_stamp_ TF_GUARDED_BY(flat_ensemble_mu_) = -1;
+
  protected:
   protobuf::Arena arena_;
   mutex mu_;
@@ -0,0 +1,377 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/conv_autotune_maps.h"
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include <stdlib.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/protobuf/autotuning.pb.h"
+#include "tensorflow/core/protobuf/conv_autotuning.pb.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+void ConvParameters::ToProto(ConvParametersProto* proto) const {
+  proto->set_batch(batch_);
+  proto->set_in_depths(in_depths_);
+  proto->set_out_depths(out_depths_);
+  proto->mutable_in()->Add(in_.begin(), in_.end());
+  proto->set_data_format(data_format_);
+  proto->mutable_filter()->Add(filter_.begin(), filter_.end());
+  proto->mutable_dilation()->Add(dilation_.begin(), dilation_.end());
+  proto->mutable_stride()->Add(stride_.begin(), stride_.end());
+  proto->mutable_padding()->Add(padding_.begin(), padding_.end());
+  proto->set_dtype(dtype_);
+  proto->set_group_count(group_count_);
+}
+
+ConvParameters ConvParameters::FromProto(const ConvParametersProto& proto,
+                                         int device_id) {
+  auto to_array = [](const protobuf::RepeatedField<int64>& values) {
+    return SpatialArray(values.begin(), values.end());
+  };
+  return ConvParameters(
+      proto.batch(), proto.in_depths(), to_array(proto.in()),
+      static_cast<TensorFormat>(proto.data_format()), proto.out_depths(),
+      to_array(proto.filter()), to_array(proto.dilation()),
+      to_array(proto.stride()), to_array(proto.padding()),
+      static_cast<DataType>(proto.dtype()), device_id, proto.group_count());
+}
+
+namespace {
+
+// Execution plans of the cuDNN frontend API are only valid in the process
+// that created them, so configs using them are not persisted.
+bool IsPersistable(const se::dnn::AlgorithmConfig& config) {
+  return !(config.algorithm().has_value() &&
+           config.algorithm()->IsExecutionPlan()) &&
+         !(config.algorithm_no_scratch().has_value() &&
+           config.algorithm_no_scratch()->IsExecutionPlan());
+}
+
+bool IsPersistable(const ConvAutotuneEntryProto& entry) {
+  return entry.algorithm().exec_plan_id().empty() &&
+         entry.algorithm_no_scratch().exec_plan_id().empty();
+}
+
+se::dnn::AlgorithmDesc AlgorithmFromProto(
+    const se::dnn::AlgorithmProto& proto) {
+  return se::dnn::AlgorithmDesc(
+      proto.algo_id(),
+      proto.math_type() == se::dnn::AlgorithmProto::TENSOR_OP_MATH);
+}
+
+void ConfigToEntryProto(const se::dnn::AlgorithmConfig& config,
+                        ConvAutotuneEntryProto* entry) {
+  if (config.algorithm().has_value()) {
+    *entry->mutable_algorithm() = config.algorithm()->ToProto();
+  }
+  if (config.algorithm_no_scratch().has_value()) {
+    *entry->mutable_algorithm_no_scratch() =
+        config.algorithm_no_scratch()->ToProto();
+  }
+  if (config.scratch_size().has_value()) {
+    entry->set_scratch_bytes(*config.scratch_size());
+  }
+}
+
+se::dnn::AlgorithmConfig ConfigFromEntryProto(
+    const ConvAutotuneEntryProto& entry) {
+  se::dnn::AlgorithmConfig config;
+  if (entry.has_algorithm()) {
+    config.set_algorithm(AlgorithmFromProto(entry.algorithm()));
+  }
+  if (entry.has_algorithm_no_scratch()) {
+    config.set_algorithm_no_scratch(
+        AlgorithmFromProto(entry.algorithm_no_scratch()));
+  }
+  if (entry.optional_scratch_bytes_case() ==
+      ConvAutotuneEntryProto::kScratchBytes) {
+    config.set_scratch_size(entry.scratch_bytes());
+  }
+  return config;
+}
+
+// Identifies an entry within the results of one device.
+string EntryKey(const ConvAutotuneEntryProto& entry) {
+  return absl::StrCat(entry.map_name(), ":",
+                      entry.parameters().SerializeAsString());
+}
+
+bool SameDevice(const ConvAutotuneDeviceProto& a,
+                const ConvAutotuneDeviceProto& b) {
+  return !a.device_name().empty() && a.device_name() == b.device_name() &&
+         a.compute_capability().major() == b.compute_capability().major() &&
+         a.compute_capability().minor() == b.compute_capability().minor() &&
+         a.driver_version() == b.driver_version() &&
+         a.cudnn_version().major() == b.cudnn_version().major() &&
+         a.cudnn_version().minor() == b.cudnn_version().minor() &&
+         a.cudnn_version().patch() == b.cudnn_version().patch();
+}
+
+// Adds the devices and entries of `from` that `to` does not have yet.
+void MergeResults(const ConvAutotuneResultsProto& from,
+                  ConvAutotuneResultsProto* to) {
+  for (const ConvAutotuneDeviceProto& from_device : from.devices()) {
+    ConvAutotuneDeviceProto* to_device = nullptr;
+    for (ConvAutotuneDeviceProto& device : *to->mutable_devices()) {
+      if (SameDevice(device, from_device)) {
+        to_device = &device;
+        break;
+      }
+    }
+    if (to_device == nullptr) {
+      *to->add_devices() = from_device;
+      continue;
+    }
+    std::set<string> keys;
+    for (const ConvAutotuneEntryProto& entry : to_device->entries()) {
+      keys.insert(EntryKey(entry));
+    }
+    for (const ConvAutotuneEntryProto& entry : from_device.entries()) {
+      if (keys.insert(EntryKey(entry)).second) {
+        *to_device->add_entries() = entry;
+      }
+    }
+  }
+}
+
+// Returns the description of the local GPUs, indexed by device ordinal. The
+// description of a GPU whose executor cannot be created is left empty and
+// matches no results.
+std::vector<ConvAutotuneDeviceProto> DescribeLocalDevices() {
+  std::vector<ConvAutotuneDeviceProto> devices;
+#if TENSORFLOW_USE_ROCM
+  auto platform = se::MultiPlatformManager::PlatformWithName("ROCM");
+#else
+  auto platform = se::MultiPlatformManager::PlatformWithName("CUDA");
+#endif
+  if (!platform.ok()) return devices;
+  for (int i = 0; i < platform.ValueOrDie()->VisibleDeviceCount(); ++i) {
+    ConvAutotuneDeviceProto device;
+    auto executor = platform.ValueOrDie()->ExecutorForDevice(i);
+    if (executor.ok()) {
+      se::StreamExecutor* stream_exec = executor.ValueOrDie();
+      const se::DeviceDescription& desc = stream_exec->GetDeviceDescription();
+      device.set_device_name(desc.name());
+      *device.mutable_compute_capability() = GetComputeCapability(stream_exec);
+      device.set_driver_version(desc.driver_version());
+      *device.mutable_cudnn_version() = GetCudnnVersion(stream_exec);
+    }
+    devices.push_back(std::move(device));
+  }
+  return devices;
+}
+
+class ConvAutotuneMapRegistry {
+ public:
+  static ConvAutotuneMapRegistry* Global() {
+    static ConvAutotuneMapRegistry* registry = new ConvAutotuneMapRegistry;
+    return registry;
+  }
+
+  void Register(const string& name, ConvAutoTuneMap* map) {
+    mutex_lock l(mu_);
+    maps_[name] = map;
+    for (const auto& loaded : loaded_[name]) {
+      map->InsertAccepted(loaded.first, loaded.second);
+    }
+  }
+
+  void Serialize(ConvAutotuneResultsProto* results) {
+    mutex_lock l(mu_);
+    const std::vector<ConvAutotuneDeviceProto>& devices = LocalDevicesLocked();
+    // GPUs with the same description share one ConvAutotuneDeviceProto.
+    std::vector<int> result_index(devices.size(), -1);
+    std::vector<std::set<string>> result_keys;
+    for (const auto& named_map : maps_) {
+      named_map.second->ForEachAccepted(
+          [&](const ConvParameters& params,
+              const se::dnn::AlgorithmConfig& config) {
+            const int ordinal = params.device_id();
+            if (ordinal < 0 || ordinal >= static_cast<int>(devices.size()) ||
+                devices[ordinal].device_name().empty() ||
+                !IsPersistable(config)) {
+              return;
+            }
+            if (result_index[ordinal] < 0) {
+              for (int i = 0; i < ordinal; ++i) {
+                if (SameDevice(devices[i], devices[ordinal])) {
+                  result_index[ordinal] = result_index[i];
+                  break;
+                }
+              }
+            }
+            if (result_index[ordinal] < 0) {
+              result_index[ordinal] = results->devices_size();
+              *results->add_devices() = devices[ordinal];
+              result_keys.emplace_back();
+            }
+            ConvAutotuneEntryProto entry;
+            entry.set_map_name(named_map.first);
+            params.ToProto(entry.mutable_parameters());
+            ConfigToEntryProto(config, &entry);
+            // Identical GPUs usually agree; keep the first result seen.
+            if (result_keys[result_index[ordinal]]
+                    .insert(EntryKey(entry))
+                    .second) {
+              *results->mutable_devices(result_index[ordinal])
+                   ->add_entries() = std::move(entry);
+            }
+          });
+    }
+  }
+
+  void Load(const ConvAutotuneResultsProto& results) {
+    mutex_lock l(mu_);
+    const std::vector<ConvAutotuneDeviceProto>& devices = LocalDevicesLocked();
+    for (const ConvAutotuneDeviceProto& device : results.devices()) {
+      for (int ordinal = 0, end = devices.size(); ordinal < end; ++ordinal) {
+        if (!SameDevice(devices[ordinal], device)) continue;
+        for (const ConvAutotuneEntryProto& entry : device.entries()) {
+          if (!IsPersistable(entry)) continue;
+          ConvParameters params =
+              ConvParameters::FromProto(entry.parameters(), ordinal);
+          se::dnn::AlgorithmConfig config = ConfigFromEntryProto(entry);
+          auto map = maps_.find(entry.map_name());
+          if (map != maps_.end()) {
+            map->second->InsertAccepted(params, config);
+          }
+          loaded_[entry.map_name()].emplace_back(std::move(params),
+                                                 std::move(config));
+        }
+      }
+    }
+  }
+
+ private:
+  const std::vector<ConvAutotuneDeviceProto>& LocalDevicesLocked()
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (!local_devices_described_) {
+      local_devices_ = DescribeLocalDevices();
+      local_devices_described_ = true;
+    }
+    return local_devices_;
+  }
+
+  mutex mu_;
+  std::map<string, ConvAutoTuneMap*> maps_ TF_GUARDED_BY(mu_);
+  // Loaded results by map name, kept to seed maps registered later.
+  std::map<string,
+           std::vector<std::pair<ConvParameters, se::dnn::AlgorithmConfig>>>
+      loaded_ TF_GUARDED_BY(mu_);
+  bool local_devices_described_ TF_GUARDED_BY(mu_) = false;
+  std::vector<ConvAutotuneDeviceProto> local_devices_ TF_GUARDED_BY(mu_);
+};
+
+const string& ResultsFilePath() {
+  static const string* path = [] {
+    string value;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_CONV_AUTOTUNE_RESULTS_FILE",
+                                     /*default_val=*/"", &value));
+    return new string(value);
+  }();
+  return *path;
+}
+
+// Merges the results of this process into the results file. The file is
+// re-read first so that results written by other processes since this one
+// started are kept, and replaced atomically so that concurrent readers never
+// see a partial file.
+void SaveResultsFile() {
+  const string& path = ResultsFilePath();
+  ConvAutotuneResultsProto results;
+  ConvAutotuneMapRegistry::Global()->Serialize(&results);
+  Env* env = Env::Default();
+  if (env->FileExists(path).ok()) {
+    string serialized;
+    ConvAutotuneResultsProto existing;
+    if (ReadFileToString(env, path, &serialized).ok() &&
+        existing.ParseFromString(serialized)) {
+      MergeResults(existing, &results);
+    }
+  }
+  const string tmp_path =
+      absl::StrCat(path, ".tmp.", env->GetProcessId(), ".", env->NowMicros());
+  Status s = WriteStringToFile(env, tmp_path, results.SerializeAsString());
+  if (s.ok()) s = env->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to save convolution autotune results to " << path
+                 << ": " << s;
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+}
+
+void LoadResultsFile() {
+  const string& path = ResultsFilePath();
+  if (path.empty()) return;
+  Env* env = Env::Default();
+  if (env->FileExists(path).ok()) {
+    string serialized;
+    Status s = ReadFileToString(env, path, &serialized);
+    if (s.ok()) s = LoadSerializedConvAutotuneMaps(serialized);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to load convolution autotune results from "
+                   << path << ": " << s;
+    }
+  }
+  // Autotune maps are never destroyed, so they are still intact when exit
+  // handlers run.
+  atexit(SaveResultsFile);
+}
+
+}  // namespace
+
+void RegisterConvAutotuneMap(const std::string& name, ConvAutoTuneMap* map) {
+  static absl::once_flag load_once;
+  absl::call_once(load_once, LoadResultsFile);
+  ConvAutotuneMapRegistry::Global()->Register(name, map);
+}
+
+Status SerializeConvAutotuneMaps(std::string* output) {
+  ConvAutotuneResultsProto results;
+  ConvAutotuneMapRegistry::Global()->Serialize(&results);
+  if (!results.SerializeToString(output)) {
+    return errors::Internal("Failed to serialize convolution autotune results");
+  }
+  return Status::OK();
+}
+
+Status LoadSerializedConvAutotuneMaps(absl::string_view serialized) {
+  ConvAutotuneResultsProto results;
+  if (!results.ParseFromArray(serialized.data(), serialized.size())) {
+    return errors::InvalidArgument(
+        "Failed to parse serialized convolution autotune results");
+  }
+  ConvAutotuneMapRegistry::Global()->Load(results);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
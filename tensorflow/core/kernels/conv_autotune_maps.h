@@ -0,0 +1,77 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Persists the results of convolution autotuning across processes.
+//
+// Convolution kernels pick their cuDNN algorithm by timing the candidates the
+// first time they see a given shape, and each new process pays for this
+// again. When TF_CONV_AUTOTUNE_RESULTS_FILE names a file, the accepted results
+// of all convolution autotune maps are loaded from it when the first map is
+// created and merged back into it when the process exits. Results are keyed by
+// the GPU name, compute capability, driver and cuDNN versions, so a file can
+// be shared by processes running on different hardware.
+
+#ifndef TENSORFLOW_CORE_KERNELS_CONV_AUTOTUNE_MAPS_H_
+#define TENSORFLOW_CORE_KERNELS_CONV_AUTOTUNE_MAPS_H_
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/kernels/conv_ops_gpu.h"
+#include "tensorflow/core/kernels/gpu_utils.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+typedef AutoTuneMap<ConvParameters, se::dnn::AlgorithmConfig> ConvAutoTuneMap;
+
+// Makes `map` part of the persisted autotune state: it is seeded with the
+// results loaded for `name` and included in SerializeConvAutotuneMaps().
+void RegisterConvAutotuneMap(const std::string& name, ConvAutoTuneMap* map);
+
+// Serializes the accepted results of all registered convolution autotune maps
+// into a binary ConvAutotuneResultsProto.
+Status SerializeConvAutotuneMaps(std::string* output);
+
+// Loads results produced by SerializeConvAutotuneMaps(), possibly by another
+// process. Results measured on a GPU unlike any local GPU are ignored. Maps
+// registered later are seeded as well.
+Status LoadSerializedConvAutotuneMaps(absl::string_view serialized);
+
+// Same as AutoTuneSingleton, but the map is registered with
+// RegisterConvAutotuneMap() under Group::name().
+template <class Group>
+class ConvAutoTuneSingleton {
+ public:
+  typedef ConvAutoTuneMap AutoTuneType;
+  static AutoTuneType* GetInstance() {
+    static AutoTuneType* instance = [] {
+      AutoTuneType* map = AutoTuneSingleton<Group, ConvParameters,
+                                            se::dnn::AlgorithmConfig>::
+          GetInstance();
+      RegisterConvAutotuneMap(Group::name(), map);
+      return map;
+    }();
+    return instance;
+  }
+};
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#endif  // TENSORFLOW_CORE_KERNELS_CONV_AUTOTUNE_MAPS_H_
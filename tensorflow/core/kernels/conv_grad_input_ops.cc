@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/conv_grad_input_ops.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/kernels/conv_autotune_maps.h"
 #include "tensorflow/core/protobuf/autotuning.pb.h"
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
@@ -40,8 +41,7 @@ struct ConvBackwardDataAutoTuneGroup {
   static string name() { return "ConvBwdData"; }
 };
 
-typedef AutoTuneSingleton<ConvBackwardDataAutoTuneGroup, ConvParameters,
-                          se::dnn::AlgorithmConfig>
+typedef ConvAutoTuneSingleton<ConvBackwardDataAutoTuneGroup>
     AutoTuneConvBwdData;
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
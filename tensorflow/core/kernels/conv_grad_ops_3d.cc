@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/conv_3d.h"
+#include "tensorflow/core/kernels/conv_autotune_maps.h"
 #include "tensorflow/core/kernels/conv_grad_ops.h"
 #include "tensorflow/core/kernels/conv_grad_shape_utils.h"
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
@@ -1194,9 +1195,7 @@ struct Conv3dBackwardDataAutoTuneGroup {
   static string name() { return "Conv3dBwdData"; }
 };
 
-typedef AutoTuneSingleton<Conv3dBackwardDataAutoTuneGroup, ConvParameters,
-                          se::dnn::AlgorithmConfig>
-
+typedef ConvAutoTuneSingleton<Conv3dBackwardDataAutoTuneGroup>
     AutoTuneConv3dBwdData;
 template <typename T>
 class Conv3DBackpropInputOp<GPUDevice, T> : public OpKernel {
@@ -1751,8 +1750,7 @@ struct Conv3dBackwardFilterAutoTuneGroup {
   static string name() { return "Conv3dBwdFilter"; }
 };
 
-typedef AutoTuneSingleton<Conv3dBackwardFilterAutoTuneGroup, ConvParameters,
-                          se::dnn::AlgorithmConfig>
+typedef ConvAutoTuneSingleton<Conv3dBackwardFilterAutoTuneGroup>
     AutoTuneConv3dBwdFilter;
 
 template <typename T>
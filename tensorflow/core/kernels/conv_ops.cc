@@ -26,10 +26,13 @@ limitations under the License.
 
 #include <string.h>
 
+#include <array>
 #include <atomic>
+#include <functional>
 #include <map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -48,8 +51,11 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/padding.h"
 #include "tensorflow/core/util/tensor_format.h"
 #include "tensorflow/core/util/use_cudnn.h"
@@ -59,6 +65,7 @@ limitations under the License.
 #endif
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/kernels/conv_autotune_maps.h"
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/autotuning.pb.h"
@@ -345,13 +352,65 @@ class LaunchDeepConvOp {
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int /*out_cols*/, int /*out_depth*/, int /*dilation_rows*/,
                   int /*dilation_cols*/, int /*stride_rows*/,
-                  int /*stride_cols*/, Tensor* /*output*/,
-                  TensorFormat /*data_format*/) {
+                  int /*stride_cols*/, const Padding& /*padding*/,
+                  Tensor* /*output*/, TensorFormat /*data_format*/) {
     return false;
   }
 };
 
-// Conditionally launches DeepConv operation based on convolution parameters.
+namespace {
+
+// Returns true if Conv2D on CPU should measure the algorithms it can use for
+// a convolution shape the first time it sees it, and use the fastest one.
+// Off by default, since DeepConv2D rounds differently from SpatialConvolution.
+bool CpuConv2DAutotuneEnabled() {
+  bool enabled = false;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_CPU_CONV2D_AUTOTUNE",
+                                 /*default_val=*/false, &enabled));
+  return enabled;
+}
+
+// Algorithms that compute a float NHWC Conv2D on CPU.
+enum class CpuConv2DAlgorithm {
+  kSpatialConvolution,  // Eigen SpatialConvolution (im2col + contraction).
+  kDeepConv2D,          // Winograd transform, see deep_conv2d.cc.
+};
+
+// Process-wide map from a convolution shape, and the number of threads it
+// runs on, to the fastest algorithm measured for it.
+class CpuConv2DAlgorithmMap {
+ public:
+  using Key = std::array<int64, 10>;
+
+  static CpuConv2DAlgorithmMap* Global() {
+    static CpuConv2DAlgorithmMap* map = new CpuConv2DAlgorithmMap;
+    return map;
+  }
+
+  bool Find(const Key& key, CpuConv2DAlgorithm* algorithm) const {
+    mutex_lock l(mu_);
+    auto it = algorithms_.find(key);
+    if (it == algorithms_.end()) return false;
+    *algorithm = it->second;
+    return true;
+  }
+
+  void Insert(const Key& key, CpuConv2DAlgorithm algorithm) {
+    mutex_lock l(mu_);
+    algorithms_.emplace(key, algorithm);
+  }
+
+ private:
+  mutable mutex mu_;
+  absl::flat_hash_map<Key, CpuConv2DAlgorithm> algorithms_
+      TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+// Conditionally launches DeepConv operation based on convolution parameters,
+// or on measurements of DeepConv2D and SpatialConvolution if
+// TF_CPU_CONV2D_AUTOTUNE is set.
 template <>
 class LaunchDeepConvOp<CPUDevice, float> {
  public:
@@ -361,11 +420,12 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int dilation_rows,
                   int dilation_cols, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  const Padding& padding, Tensor* output,
+                  TensorFormat data_format) {
     if (data_format != FORMAT_NHWC || dilation_rows != 1 ||
-        dilation_cols != 1 ||
-        !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
-                          in_depth, out_depth, out_rows, out_cols)) {
+        dilation_cols != 1 || filter.dim_size(2) != in_depth ||
+        !IsDeepConv2DSupported(stride_rows, stride_cols, filter_rows,
+                               filter_cols)) {
       return false;
     }
 
@@ -382,13 +442,67 @@ class LaunchDeepConvOp<CPUDevice, float> {
     args.out_cols = out_cols;
     args.out_depth = out_depth;
 
+    if (CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
+                         in_depth, out_depth, out_rows, out_cols)) {
+      RunDeepConv2D(ctx, args, input, filter, output);
+      return true;
+    }
+    if (!CpuConv2DAutotuneEnabled()) return false;
+
+    const CpuConv2DAlgorithmMap::Key key = {
+        batch,     input_rows, input_cols, in_depth,
+        out_depth, pad_rows,   pad_cols,   out_rows,
+        out_cols,  ctx->device()->tensorflow_cpu_worker_threads()->num_threads};
+    CpuConv2DAlgorithm algorithm;
+    if (CpuConv2DAlgorithmMap::Global()->Find(key, &algorithm)) {
+      if (algorithm == CpuConv2DAlgorithm::kSpatialConvolution) return false;
+      RunDeepConv2D(ctx, args, input, filter, output);
+      return true;
+    }
+
+    // Time the second run of each algorithm, so that one-off costs like
+    // allocating scratch buffers are not counted. The SpatialConvolution run
+    // goes last, so that the output holds its result if it wins.
+    auto run_spatial_convolution = [&]() {
+      LaunchGeneric<CPUDevice, float>()(ctx, input, filter, stride_rows,
+                                        stride_cols, dilation_rows,
+                                        dilation_cols, padding, {}, output,
+                                        data_format);
+    };
+    auto run_deep_conv2d = [&]() {
+      RunDeepConv2D(ctx, args, input, filter, output);
+    };
+    auto measure_micros = [](const std::function<void()>& run) {
+      run();
+      const uint64 start_us = Env::Default()->NowMicros();
+      run();
+      return Env::Default()->NowMicros() - start_us;
+    };
+    const uint64 deep_conv2d_us = measure_micros(run_deep_conv2d);
+    const uint64 spatial_convolution_us =
+        measure_micros(run_spatial_convolution);
+    algorithm = deep_conv2d_us < spatial_convolution_us
+                    ? CpuConv2DAlgorithm::kDeepConv2D
+                    : CpuConv2DAlgorithm::kSpatialConvolution;
+    VLOG(1) << "Conv2D autotune for input " << input.shape().DebugString()
+            << " and filter " << filter.shape().DebugString()
+            << ": DeepConv2D " << deep_conv2d_us << "us, SpatialConvolution "
+            << spatial_convolution_us << "us";
+    CpuConv2DAlgorithmMap::Global()->Insert(key, algorithm);
+    if (algorithm == CpuConv2DAlgorithm::kDeepConv2D) run_deep_conv2d();
+    return true;
+  }
+
+ private:
+  static void RunDeepConv2D(OpKernelContext* ctx, const Conv2DArgs& args,
+                            const Tensor& input, const Tensor& filter,
+                            Tensor* output) {
     auto input_ptr = input.template flat<float>().data();
     auto filter_ptr = filter.template flat<float>().data();
     auto output_ptr = output->template flat<float>().data();
 
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
                                             output_ptr);
-    return true;
   }
 };
 
@@ -700,7 +814,8 @@ class Conv2DOp : public BinaryOp<T> {
             dimensions.pad_cols_before, dimensions.out_rows,
             dimensions.out_cols, dimensions.out_depth, dimensions.dilation_rows,
             dimensions.dilation_cols, dimensions.stride_rows,
-            dimensions.stride_cols, output, params_.data_format)) {
+            dimensions.stride_cols, params_.padding, output,
+            params_.data_format)) {
       return;
     }
 
@@ -763,9 +878,7 @@ struct ConvAutoTuneGroup {
   static string name() { return "Conv"; }
 };
 
-typedef AutoTuneSingleton<ConvAutoTuneGroup, ConvParameters,
-                          se::dnn::AlgorithmConfig>
-    AutoTuneConv;
+typedef ConvAutoTuneSingleton<ConvAutoTuneGroup> AutoTuneConv;
 
 template <typename T>
 void LaunchConv2DOp<GPUDevice, T>::operator()(
@@ -30,6 +30,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class ConvParametersProto;
+
 // Returns true if the given StreamExecutor is for a Volta or newer nvidia GPU.
 inline bool IsVoltaOrLater(const se::StreamExecutor& stream_exec) {
   int major, minor;
@@ -139,6 +141,13 @@ class ConvParameters {
     return !(*this == other);
   }
   uint64 hash() const { return hash_code_; }
+  int device_id() const { return device_id_; }
+
+  // Conversions used to persist autotune results across processes, defined in
+  // conv_autotune_maps.cc. The device ordinal is not part of the proto.
+  void ToProto(ConvParametersProto* proto) const;
+  static ConvParameters FromProto(const ConvParametersProto& proto,
+                                  int device_id);
 
   string ToString() const {
     // clang-format off
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/conv_autotune_maps.h"
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
@@ -34,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tensor_float_32_utils.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/conv_autotuning.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/public/session.h"
 
@@ -94,6 +96,58 @@ TEST(ConvParameters, WinogradNonfusedAlgoSize) {
       conv_params_large.ShouldIncludeWinogradNonfusedAlgoPreCudnn7<float>());
 }
 
+TEST(ConvParameters, ProtoRoundTrip) {
+  ConvParameters params(2, 3, {{10, 11}}, FORMAT_NHWC, 4, {{3, 3}}, {{1, 1}},
+                        {{2, 2}}, {{1, 0}}, DT_HALF, /*device_id=*/1,
+                        /*group_count=*/3);
+  ConvParametersProto proto;
+  params.ToProto(&proto);
+  EXPECT_EQ(ConvParameters::FromProto(proto, /*device_id=*/1), params);
+  EXPECT_NE(ConvParameters::FromProto(proto, /*device_id=*/0), params);
+}
+
+struct ConvAutotuneMapsTestGroup {
+  static string name() { return "ConvAutotuneMapsTest"; }
+};
+
+struct ConvAutotuneMapsTestLoadGroup {
+  static string name() { return "ConvAutotuneMapsTestLoad"; }
+};
+
+TEST(ConvAutotuneMaps, SerializeAndLoad) {
+  ConvParameters params(1, 8, {{32, 32}}, FORMAT_NCHW, 16, {{3, 3}}, {{1, 1}},
+                        {{1, 1}}, {{1, 1}}, DT_FLOAT, /*device_id=*/0);
+  se::dnn::AlgorithmConfig config(se::dnn::AlgorithmDesc(5, true), 1024,
+                                  se::dnn::AlgorithmDesc(1, false));
+  ConvAutoTuneSingleton<ConvAutotuneMapsTestGroup>::GetInstance()
+      ->InsertAccepted(params, config);
+
+  string serialized;
+  TF_ASSERT_OK(SerializeConvAutotuneMaps(&serialized));
+  ConvAutotuneResultsProto results;
+  ASSERT_TRUE(results.ParseFromString(serialized));
+
+  // Load the entry back under the name of a second map, as if it had been
+  // produced by another process.
+  int num_entries = 0;
+  for (auto& device : *results.mutable_devices()) {
+    for (auto& entry : *device.mutable_entries()) {
+      if (entry.map_name() == ConvAutotuneMapsTestGroup::name()) {
+        entry.set_map_name(ConvAutotuneMapsTestLoadGroup::name());
+        ++num_entries;
+      }
+    }
+  }
+  EXPECT_EQ(num_entries, 1);
+  TF_ASSERT_OK(LoadSerializedConvAutotuneMaps(results.SerializeAsString()));
+
+  auto* load_map =
+      ConvAutoTuneSingleton<ConvAutotuneMapsTestLoadGroup>::GetInstance();
+  se::dnn::AlgorithmConfig loaded;
+  ASSERT_TRUE(load_map->Find(params, &loaded));
+  EXPECT_EQ(loaded, config);
+}
+
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 class FusedResizePadConvOpTest : public OpsTestBase {
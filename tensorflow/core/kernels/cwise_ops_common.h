@@ -464,6 +464,7 @@ struct BinaryFunctor<CPUDevice, Functor, 2, false> {
              bool* error) {
     typedef typename Functor::in_type T;
     typename Functor::func func;
+    if (RowOrColumnBCast(dev, out, in0, bcast0, in1, bcast1)) return;
     if (Functor::use_bcast_optimization && use_bcast_optimization<T>::value) {
       // Optimize for speed by using Eigen::type2index and avoid
       // .broadcast() when we know it's a no-op.
@@ -544,6 +545,71 @@ struct BinaryFunctor<CPUDevice, Functor, 2, false> {
     auto rhs = in1.broadcast(bcast1);
     Assign(dev, out, lhs.binaryExpr(rhs, func));
   }
+
+ private:
+  // Handles [n, m] op [1, m] (row) and [n, m] op [n, 1] (column) broadcasts,
+  // with the broadcast operand on either side. BCast collapses any rank to
+  // these shapes when one operand varies only along the innermost or only
+  // along the outer dimensions, e.g. [N, H, W, C] op [1, 1, 1, C]. Each output
+  // row is computed from one contiguous row of the full operand, so Eigen
+  // evaluates it with full packets instead of doing broadcast index math per
+  // coefficient. Returns false if the shapes do not match or rows are too
+  // short to amortize the per-row setup.
+  bool RowOrColumnBCast(
+      const CPUDevice& dev,
+      typename TTypes<typename Functor::out_type, NDIMS>::Tensor out,
+      typename TTypes<typename Functor::in_type, NDIMS>::ConstTensor in0,
+      const Eigen::array<Eigen::DenseIndex, NDIMS>& bcast0,
+      typename TTypes<typename Functor::in_type, NDIMS>::ConstTensor in1,
+      const Eigen::array<Eigen::DenseIndex, NDIMS>& bcast1) {
+    typedef typename Functor::out_type Tout;
+    typedef typename Functor::in_type Tin;
+    typedef typename Functor::func Binary;
+    static constexpr int kMinRowSize =
+        4 * Eigen::internal::packet_traits<Tin>::size;
+
+    const Eigen::Index rows = out.dimension(0);
+    const Eigen::Index cols = out.dimension(1);
+    const bool in0_full = AllOne<NDIMS>(bcast0);
+    const bool in1_full = AllOne<NDIMS>(bcast1);
+    if (cols < kMinRowSize || in0_full == in1_full) return false;
+
+    const Tin* full = in0_full ? in0.data() : in1.data();
+    const Tin* small = in0_full ? in1.data() : in0.data();
+    const auto& small_dims = in0_full ? in1.dimensions() : in0.dimensions();
+    const bool row = small_dims[0] == 1 && small_dims[1] == cols;
+    const bool column = small_dims[0] == rows && small_dims[1] == 1;
+    if (!row && !column) return false;
+
+    Tout* out_data = out.data();
+    auto work = [=](Eigen::Index first, Eigen::Index last) {
+      typedef typename Eigen::internal::scalar_left<
+          Tout, Tin, Binary, /*is_scalar_in_host_memory=*/true>
+          Left;
+      typedef typename Eigen::internal::scalar_right<
+          Tout, Tin, Binary, /*is_scalar_in_host_memory=*/true>
+          Right;
+      typename TTypes<Tin>::UnalignedConstFlat vec(small, cols);
+      for (Eigen::Index r = first; r < last; ++r) {
+        typename TTypes<Tin>::UnalignedConstFlat in_row(full + r * cols, cols);
+        typename TTypes<Tout>::UnalignedFlat out_row(out_data + r * cols, cols);
+        if (row && in0_full) {
+          out_row = in_row.binaryExpr(vec, Binary());
+        } else if (row) {
+          out_row = vec.binaryExpr(in_row, Binary());
+        } else if (in0_full) {
+          out_row = in_row.unaryExpr(Right(small + r));
+        } else {
+          out_row = in_row.unaryExpr(Left(small + r));
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost(
+        (row ? 2 : 1) * cols * sizeof(Tin), cols * sizeof(Tout),
+        cols * Eigen::internal::functor_traits<Binary>::Cost);
+    dev.parallelFor(rows, cost, work);
+    return true;
+  }
 };
 
 // Version of BinaryFunctor with error handling.
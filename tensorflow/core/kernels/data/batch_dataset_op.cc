@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/util/batch_util.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -44,11 +45,14 @@ namespace data {
 
 constexpr char kInputImplEmpty[] = "input_impl_empty";
 constexpr char kBatchDataset[] = "BatchDataset";
+constexpr char kPreallocateOutputsEnvVar[] =
+    "TF_DATA_BATCH_PREALLOCATE_OUTPUTS";
 
 class BatchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, int64 batch_size, bool drop_remainder,
-          bool parallel_copy, const DatasetBase* input, int op_version)
+          bool parallel_copy, bool preallocate_outputs,
+          const DatasetBase* input, int op_version)
       : DatasetBase(DatasetContext(ctx)),
         batch_size_(batch_size),
         // Dataset batch is sometimes used to stack all elements in the
@@ -59,6 +63,11 @@ class BatchDatasetOp::Dataset : public DatasetBase {
                                      : std::min<int64>(batch_size, 1 << 16)),
         drop_remainder_(drop_remainder),
         parallel_copy_(parallel_copy),
+        // Every batch that is produced has `batch_size` rows only if the
+        // final partial batch is dropped or never reached.
+        preallocate_outputs_(preallocate_outputs &&
+                             (drop_remainder ||
+                              input->Cardinality() == kInfiniteCardinality)),
         input_(input),
         op_version_(op_version),
         traceme_metadata_(
@@ -157,6 +166,9 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (dataset()->preallocate_outputs_) {
+        return GetNextPreallocated(ctx, out_tensors, end_of_sequence);
+      }
       // Each row of `batch_elements` is a tuple of tensors from the
       // input iterator.
       std::vector<std::vector<Tensor>> batch_elements;
@@ -239,6 +251,48 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Like GetNextInternal(), but copies each input element into a batch that
+    // is allocated up front as soon as the element is produced, instead of
+    // buffering `batch_size` elements and copying them afterwards.  The
+    // element is still in cache when it is copied, and its buffers are
+    // released right away rather than being held until the batch is full.
+    Status GetNextPreallocated(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) {
+      std::vector<Tensor> batch;
+      int64 num_elements = 0;
+      {
+        mutex_lock l(mu_);
+        if (!input_impl_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        *end_of_sequence = false;
+        while (num_elements < dataset()->batch_size_) {
+          std::vector<Tensor> batch_element_tuple;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &batch_element_tuple, end_of_sequence));
+          if (*end_of_sequence) {
+            input_impl_.reset();
+            break;
+          }
+          TF_RETURN_IF_ERROR(CopyElementToBatch(
+              ctx, dataset()->batch_size_, num_elements,
+              std::move(batch_element_tuple), &batch));
+          ++num_elements;
+        }
+      }
+
+      // A partial batch can only be the last one, which is dropped.
+      if (num_elements < dataset()->batch_size_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      *out_tensors = std::move(batch);
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
   };
@@ -247,6 +301,10 @@ class BatchDatasetOp::Dataset : public DatasetBase {
   const int64 reserve_size_;
   const bool drop_remainder_;
   const bool parallel_copy_;
+  // If true, batches are assembled with GetNextPreallocated().  Set from the
+  // TF_DATA_BATCH_PREALLOCATE_OUTPUTS environment variable, and only if every
+  // batch that is produced is full.  Takes precedence over `parallel_copy_`.
+  const bool preallocate_outputs_;
   const DatasetBase* const input_;
   const int op_version_;
   std::vector<PartialTensorShape> output_shapes_;
@@ -259,6 +317,9 @@ BatchDatasetOp::BatchDatasetOp(OpKernelConstruction* ctx)
   if (ctx->HasAttr(kParallelCopy)) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kParallelCopy, &parallel_copy_));
   }
+  OP_REQUIRES_OK(ctx, ReadBoolFromEnvVar(kPreallocateOutputsEnvVar,
+                                         /*default_val=*/false,
+                                         &preallocate_outputs_));
 }
 
 void BatchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -274,8 +335,8 @@ void BatchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
         ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
   }
 
-  *output = new Dataset(ctx, batch_size, drop_remainder, parallel_copy_, input,
-                        op_version_);
+  *output = new Dataset(ctx, batch_size, drop_remainder, parallel_copy_,
+                        preallocate_outputs_, input, op_version_);
 }
 
 namespace {
@@ -40,6 +40,7 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
   class Dataset;
   const int op_version_;
   bool parallel_copy_ = false;
+  bool preallocate_outputs_ = false;
 };
 
 }  // namespace data
@@ -283,6 +283,38 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(BatchDatasetOpTest, BatchDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+class BatchDatasetOpPreallocateOutputsTest : public BatchDatasetOpTest {
+ protected:
+  void SetUp() override {
+    setenv("TF_DATA_BATCH_PREALLOCATE_OUTPUTS", "true", /*overwrite=*/1);
+  }
+  void TearDown() override { unsetenv("TF_DATA_BATCH_PREALLOCATE_OUTPUTS"); }
+};
+
+TEST_F(BatchDatasetOpPreallocateOutputsTest, DropRemainder) {
+  TF_ASSERT_OK(Initialize(BatchDatasetParams4()));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape({3}),
+                           {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(BatchDatasetOpPreallocateOutputsTest, BatchLargerThanInput) {
+  TF_ASSERT_OK(Initialize(BatchDatasetParams5()));
+  TF_ASSERT_OK(CheckIteratorGetNext({}, /*compare_order=*/true));
+}
+
+// Partial batches are still copied after all their elements are produced.
+TEST_F(BatchDatasetOpPreallocateOutputsTest, KeepRemainder) {
+  TF_ASSERT_OK(Initialize(BatchDatasetParams3()));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      {CreateTensor<int64>(TensorShape({3}), {0, 1, 2}),
+       CreateTensor<int64>(TensorShape({3}), {3, 4, 5}),
+       CreateTensor<int64>(TensorShape({3}), {6, 7, 8}),
+       CreateTensor<int64>(TensorShape({1}), {9})},
+      /*compare_order=*/true));
+}
+
 TEST_F(BatchDatasetOpTest, InvalidBatchSize) {
   auto batch_dataset_params = InvalidBatchSizeBatchDatasetParams();
   EXPECT_EQ(Initialize(batch_dataset_params).code(),
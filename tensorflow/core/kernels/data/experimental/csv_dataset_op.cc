@@ -26,6 +26,41 @@ namespace data {
 namespace experimental {
 namespace {
 
+// Returns whether any byte of `word` is zero.
+inline bool HasZeroByte(uint64 word) {
+  return ((word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL) != 0;
+}
+
+// Returns the offset of the first byte in `data[pos, size)` that may end an
+// unquoted field, i.e. `delim`, '\n', '\r' or (if `check_quotes`) '"', or
+// `size` if there is none. Compares eight bytes at a time so that long fields
+// do not pay a branch per character.
+size_t FindUnquotedFieldEnd(const char* data, size_t pos, size_t size,
+                            char delim, bool check_quotes) {
+  constexpr uint64 kOnes = 0x0101010101010101ULL;
+  const uint64 delims = kOnes * static_cast<uint8>(delim);
+  const uint64 newlines = kOnes * static_cast<uint8>('\n');
+  const uint64 returns = kOnes * static_cast<uint8>('\r');
+  const uint64 quotes = kOnes * static_cast<uint8>(check_quotes ? '"' : '\n');
+  while (pos + sizeof(uint64) <= size) {
+    uint64 word;
+    memcpy(&word, data + pos, sizeof(word));
+    if (HasZeroByte(word ^ delims) || HasZeroByte(word ^ newlines) ||
+        HasZeroByte(word ^ returns) || HasZeroByte(word ^ quotes)) {
+      break;
+    }
+    pos += sizeof(uint64);
+  }
+  for (; pos < size; ++pos) {
+    const char ch = data[pos];
+    if (ch == delim || ch == '\n' || ch == '\r' ||
+        (check_quotes && ch == '"')) {
+      break;
+    }
+  }
+  return pos;
+}
+
 class CSVDatasetOp : public DatasetOpKernel {
  public:
   explicit CSVDatasetOp(OpKernelConstruction* ctx)
@@ -508,7 +543,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         pos_++;  // Starting quotation mark
 
         Status parse_result;
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter scans to the next quote or refills
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             if (errors::IsOutOfRange(s)) {
@@ -562,7 +597,11 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Only a quotation mark can end a quoted field, so skip straight
+            // to the next one.
+            const char* quote = static_cast<const char*>(
+                memchr(buffer_.data() + pos_, '"', buffer_.size() - pos_));
+            pos_ = quote == nullptr ? buffer_.size() : quote - buffer_.data();
           }
         }
       }
@@ -641,7 +680,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter scans to the next special char or refills
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -657,6 +696,12 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          pos_ = FindUnquotedFieldEnd(buffer_.data(), pos_, buffer_.size(),
+                                      dataset()->delim_,
+                                      dataset()->use_quote_delim_);
+          if (pos_ >= buffer_.size()) {
+            continue;  // The field continues in the next buffer.
+          }
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -789,7 +834,7 @@ class CSVDatasetOp : public DatasetOpKernel {
               component.scalar<tstring>()() =
                   dataset()->record_defaults_[output_idx].flat<tstring>()(0);
             } else {
-              component.scalar<tstring>()() = string(field);
+              component.scalar<tstring>()().assign(field.data(), field.size());
             }
             break;
           }
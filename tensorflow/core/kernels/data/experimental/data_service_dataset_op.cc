@@ -718,6 +718,7 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       GetElementRequest req;
       req.set_task_id(task.info.task_id());
       req.set_skipped_previous_round(task.skipped_previous_round);
+      req.set_accepts_stored_uncompressed(true);
       absl::optional<int64> round_index;
       if (StrictRoundRobin()) {
         round_index = task.round;
@@ -647,13 +647,20 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                           std::vector<Tensor>* output) {
         thread::ThreadPool* device_threadpool =
             ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
+        // Views into `input`, which outlives the parsing, so that the
+        // serialized examples are not copied.
         std::vector<tstring> slice_vec;
+        int64 num_serialized = 0;
+        for (const Tensor& t : input) {
+          num_serialized += t.NumElements();
+        }
+        slice_vec.reserve(num_serialized);
         for (const Tensor& t : input) {
           auto serialized_t = t.flat<tstring>();
-          gtl::ArraySlice<tstring> slice(serialized_t.data(),
-                                         serialized_t.size());
-          for (auto it = slice.begin(); it != slice.end(); it++)
-            slice_vec.push_back(*it);
+          for (int64 i = 0; i < serialized_t.size(); ++i) {
+            slice_vec.emplace_back();
+            slice_vec.back().assign_as_view(serialized_t(i));
+          }
         }
         example::FastParseExampleConfig config = dataset()->config_;
         // local copy of config_ for modification.
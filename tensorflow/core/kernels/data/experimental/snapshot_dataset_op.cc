@@ -273,6 +273,11 @@ class SnapshotDatasetV2Op::Dataset::Iterator::Writer
   uint64 run_id_ TF_GUARDED_BY(mu_);
   tstring run_dir_ TF_GUARDED_BY(mu_);
 
+  // Whether to refresh the heartbeat of the unfinalized metadata file, so that
+  // other jobs share this run instead of writing their own.
+  const bool heartbeat_;
+  int64 last_heartbeat_micros_ TF_GUARDED_BY(mu_) = 0;
+
   // Stores the ID of the current checkpoint .snapshot file being read. See top
   // of this file for the directory layout.
   uint64 current_checkpoint_id_ TF_GUARDED_BY(mu_);
@@ -521,6 +526,17 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::InitializeIterator(
     TF_RETURN_IF_ERROR(snapshot_util::DetermineOpState(
         /*mode_string=*/"", file_exists, &metadata,
         /*pending_snapshot_expiry_seconds=*/0, &mode_));
+    // Jobs with the same input pipeline (e.g. a hyperparameter sweep) would
+    // otherwise each write a full copy of the snapshot while the first copy
+    // is in progress.
+    if (mode_ == snapshot_util::WRITER && file_exists &&
+        snapshot_util::SharePendingSnapshots() &&
+        snapshot_util::IsLivePendingSnapshot(metadata)) {
+      LOG(INFO) << "Snapshot " << hash_dir_ << " is being written by run "
+                << metadata.run_id() << "; reading the input directly instead "
+                << "of writing another copy.";
+      mode_ = snapshot_util::PASSTHROUGH;
+    }
   }
 
   switch (mode_) {
@@ -627,6 +643,7 @@ SnapshotDatasetV2Op::Dataset::Iterator::Writer::Writer(const Params& params)
     : DatasetIterator<Dataset>(params),
       writers_closed_(false),
       run_id_(0),
+      heartbeat_(snapshot_util::SharePendingSnapshots()),
       current_checkpoint_id_(0) {}
 
 SnapshotDatasetV2Op::Dataset::Iterator::Writer::~Writer() {
@@ -660,6 +677,10 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::WriteMetadataFile(
     metadata.add_dtype(output_dtype);
   }
   metadata.set_finalized(finalized);
+  if (heartbeat_ && !finalized) {
+    last_heartbeat_micros_ = EnvTime::NowMicros();
+    metadata.set_heartbeat_timestamp(last_heartbeat_micros_);
+  }
   tstring hash_directory = io::JoinPath(
       dataset()->writer_prefix_,
       snapshot_util::HashDirectory(dataset()->path_, dataset()->hash_));
@@ -721,6 +742,12 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::GetNextInternal(
           run_id_);
       TF_RETURN_IF_ERROR(ctx->env()->RecursivelyCreateDir(run_dir_));
       TF_RETURN_IF_ERROR(WriteMetadataFile(ctx->env(), /*finalized=*/false));
+    } else if (heartbeat_) {
+      const int64 now = EnvTime::NowMicros();
+      if (now - last_heartbeat_micros_ >=
+          snapshot_util::kSnapshotHeartbeatIntervalMicros) {
+        TF_RETURN_IF_ERROR(WriteMetadataFile(ctx->env(), /*finalized=*/false));
+      }
     }
 
     // Writers have either encountered an error or are closed.
@@ -995,9 +1022,11 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         ctx,
         compression_ == io::compression::kNone ||
             compression_ == io::compression::kGzip ||
-            compression_ == io::compression::kSnappy,
-        errors::InvalidArgument("compression must be either '', 'GZIP' or "
-                                "'SNAPPY'."));
+            compression_ == io::compression::kSnappy ||
+            compression_ == io::compression::kZstd ||
+            compression_ == io::compression::kLz4,
+        errors::InvalidArgument("compression must be either '', 'GZIP', "
+                                "'SNAPPY', 'ZSTD' or 'LZ4'."));
 
     OP_REQUIRES(
         ctx, pending_snapshot_expiry_seconds_ >= 1,
@@ -612,38 +612,45 @@ class MultiDeviceIteratorGetNextFromShardOp : public AsyncOpKernel {
     OP_REQUIRES_OK_ASYNC(
         ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &iterator), done);
 
-    background_worker_.Schedule(std::bind(
-        [ctx, iterator, shard_num, incarnation_id](DoneCallback done) {
-          Notification n;
-          MultiDeviceIteratorCallback callback = std::bind(
-              [ctx, &n](const HostBufferElement& elem) {
-                Status s = elem.status;
-                if (!s.ok()) {
-                  ctx->SetStatus(s);
-                } else if (elem.end_of_sequence) {
-                  ctx->SetStatus(errors::OutOfRange("End of sequence"));
-                } else {
-                  for (int i = 0; i < elem.value.size(); ++i) {
-                    ctx->set_output(i, elem.value[i]);
-                  }
-                }
-                n.Notify();
-              },
-              std::placeholders::_1);
-
-          Status s = iterator->GetNextFromShard(ctx, shard_num, incarnation_id,
-                                                std::move(callback));
+    // The callback may run synchronously inside `GetNextFromShard()` when the
+    // shard already has a buffered element, or later from the background
+    // thread once one is produced. Whichever of the callback and this thread
+    // finishes last completes the op. Completing inline avoids a thread hop
+    // per element in the common (buffered) case; late completions are
+    // bounced to `background_worker_` because the callback may be invoked
+    // while the iterator's lock is held.
+    auto pending = std::make_shared<std::atomic<int>>(2);
+    MultiDeviceIteratorCallback callback = std::bind(
+        [this, ctx, pending](const DoneCallback& done,
+                             const HostBufferElement& elem) {
+          Status s = elem.status;
           if (!s.ok()) {
             ctx->SetStatus(s);
-            iterator->Unref();
-            done();
-            return;
+          } else if (elem.end_of_sequence) {
+            ctx->SetStatus(errors::OutOfRange("End of sequence"));
+          } else {
+            for (int i = 0; i < elem.value.size(); ++i) {
+              ctx->set_output(i, elem.value[i]);
+            }
+          }
+          if (pending->fetch_sub(1) == 1) {
+            background_worker_.Schedule(done);
           }
-          iterator->Unref();
-          n.WaitForNotification();
-          done();
         },
-        std::move(done)));
+        done, std::placeholders::_1);
+
+    Status s = iterator->GetNextFromShard(ctx, shard_num, incarnation_id,
+                                          std::move(callback));
+    iterator->Unref();
+    if (!s.ok()) {
+      // The callback is never invoked if `GetNextFromShard()` fails.
+      ctx->SetStatus(s);
+      done();
+      return;
+    }
+    if (pending->fetch_sub(1) == 1) {
+      done();
+    }
   }
 
  private:
@@ -638,13 +638,43 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         return ConsumeHelper(result);
       }
       // If we are allowed to be nondeterministic (i.e. return results out of
-      // order), try to find an element in the cycle that has a result
-      // available.
-      for (int i = 0; i < dataset()->cycle_length_; ++i) {
+      // order), first try the element at the current position, then borrow a
+      // result from another element of the cycle without moving the position.
+      // This keeps the output in deterministic order whenever the head-of-line
+      // element keeps up, and bounds any reordering to the current cycle.
+      if (ConsumeHelper(result) || ConsumeOutOfOrder(result)) {
+        return true;
+      }
+      // No buffered result is available. Rotate through the cycle so that
+      // exhausted elements get replaced and their inputs start producing.
+      for (int i = 1; i < dataset()->cycle_length_; ++i) {
+        AdvanceToNextInCycle();
         if (ConsumeHelper(result)) {
           return true;
         }
-        AdvanceToNextInCycle();
+      }
+      return false;
+    }
+
+    // Consumes a buffered result from a current element other than the one at
+    // `cycle_index_`, returning an indication of whether a result was found.
+    // Unlike `ConsumeHelper()`, this does not advance the position in the
+    // interleave cycle.
+    bool ConsumeOutOfOrder(std::shared_ptr<Result>* result)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (int64 i = 1; i < (last_valid_current_element_ + 1); ++i) {
+        int64 index = (cycle_index_ + i) % (last_valid_current_element_ + 1);
+        std::shared_ptr<Element>& element = current_elements_[index];
+        if (!element || element->results.empty()) {
+          continue;
+        }
+        std::swap(*result, element->results.front());
+        element->results.pop_front();
+        if (!element->active) {
+          elements_to_process_.push_back(index);
+          current_workers_cond_var_.notify_one();
+        }
+        return true;
       }
       return false;
     }
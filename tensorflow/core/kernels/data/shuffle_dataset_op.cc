@@ -19,6 +19,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/element_spill_store.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -55,6 +57,9 @@ namespace data {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 const int64 kMaxEpochsInBuffer = 3;
+// Default memory budget for the buffered elements when spilling is enabled.
+const int64 kDefaultSpillMemoryBudgetBytes = 1LL << 30;  // 1 GB.
+const int64 kSpillFileBytes = 64LL << 20;                // 64 MB.
 
 constexpr char kNumRandomSamples[] = "num_random_samples";
 constexpr char kDataProduced[] = "data_produced";
@@ -157,7 +162,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       seed_generator_->GenerateSeeds(&seed_, &seed2_);
       ResetRngs();
-      return Status::OK();
+      return InitializeSpillLocked(ctx);
     }
 
     Status GetNextInternal(IteratorContext* ctx,
@@ -209,9 +214,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             VLOG(1) << "Starting to fill up shuffle buffer of size: "
                     << this->dataset()->buffer_size_;
           }
-          this->RecordBufferEnqueue(ctx, input_element);
-          buffer_->at(slices_.back()->end % this->dataset()->buffer_size_) =
-              std::move(input_element);
+          TF_RETURN_IF_ERROR(AddToBufferLocked(
+              ctx, slices_.back()->end % this->dataset()->buffer_size_,
+              std::move(input_element)));
           num_elements_++;
           slices_.back()->end++;
         } else {
@@ -248,13 +253,16 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             Random() % (slices_.front()->end - slices_.front()->start);
         int64 index =
             (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-        *out_tensors = std::move(buffer_->at(index));
-        this->RecordBufferDequeue(ctx, *out_tensors);
-        std::swap(buffer_->at(index),
-                  buffer_->at(slices_.front()->start %
-                              this->dataset()->buffer_size_));
+        TF_RETURN_IF_ERROR(TakeFromBufferLocked(ctx, index, out_tensors));
+        const int64 start_index =
+            slices_.front()->start % this->dataset()->buffer_size_;
+        std::swap(buffer_->at(index), buffer_->at(start_index));
+        if (spill_store_) {
+          std::swap(spilled_[index], spilled_[start_index]);
+        }
         slices_.front()->start++;
         num_elements_--;
+        MaybePrefetchLocked(ctx);
       } else {
         DCHECK(input_impl_ == nullptr);
         *end_of_sequence = true;
@@ -302,7 +310,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kEpoch), epoch_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kNumElements), num_elements_));
-      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      TF_RETURN_IF_ERROR(WriteBufferLocked(writer));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kSlicesSize), slices_.size()));
       for (size_t i = 0; i < slices_.size(); ++i) {
@@ -361,6 +369,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           this->dataset()->buffer_size_);
       TF_RETURN_IF_ERROR(
           ReadElementsFromCheckpoint(reader, prefix(), buffer_.get()));
+      TF_RETURN_IF_ERROR(RebuildSpillLocked());
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
@@ -396,6 +405,19 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       int64 end;
     };
 
+    // A spilled element that is read ahead of being produced.
+    struct PrefetchedElement {
+      explicit PrefetchedElement(const ElementSpillStore::Handle& handle)
+          : handle(handle) {}
+
+      const ElementSpillStore::Handle handle;
+      mutex mu;
+      condition_variable cond_var;
+      bool done TF_GUARDED_BY(mu) = false;
+      Status status TF_GUARDED_BY(mu);
+      std::vector<Tensor> element TF_GUARDED_BY(mu);
+    };
+
     random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       num_random_samples_++;
@@ -403,6 +425,152 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return out;
     }
 
+    // Enables spilling of buffered elements to local disk if
+    // `TF_DATA_SHUFFLE_SPILL_DIR` is set. Once the buffered elements exceed
+    // `TF_DATA_SHUFFLE_MEMORY_BUDGET_BYTES`, further elements are written to
+    // the spill directory and only their handles are kept in memory.
+    Status InitializeSpillLocked(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      string spill_dir;
+      TF_RETURN_IF_ERROR(
+          ReadStringFromEnvVar("TF_DATA_SHUFFLE_SPILL_DIR", "", &spill_dir));
+      if (spill_dir.empty()) {
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(ReadInt64FromEnvVar(
+          "TF_DATA_SHUFFLE_MEMORY_BUDGET_BYTES", kDefaultSpillMemoryBudgetBytes,
+          &memory_budget_bytes_));
+      spill_store_ = std::make_shared<ElementSpillStore>(ctx->env(), spill_dir,
+                                                         kSpillFileBytes);
+      spilled_.resize(this->dataset()->buffer_size_);
+      return Status::OK();
+    }
+
+    Status AddToBufferLocked(IteratorContext* ctx, int64 index,
+                             std::vector<Tensor> element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64 bytes = GetTotalBytes(element);
+      if (spill_store_ && buffered_bytes_ + bytes > memory_budget_bytes_) {
+        TF_RETURN_IF_ERROR(spill_store_->Write(element, &spilled_[index]));
+        buffer_->at(index).clear();
+        return Status::OK();
+      }
+      this->RecordBufferEnqueue(ctx, element);
+      buffered_bytes_ += bytes;
+      buffer_->at(index) = std::move(element);
+      return Status::OK();
+    }
+
+    Status TakeFromBufferLocked(IteratorContext* ctx, int64 index,
+                                std::vector<Tensor>* out_tensors)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!spill_store_ || !spilled_[index].valid()) {
+        *out_tensors = std::move(buffer_->at(index));
+        buffered_bytes_ -= GetTotalBytes(*out_tensors);
+        this->RecordBufferDequeue(ctx, *out_tensors);
+        return Status::OK();
+      }
+      const ElementSpillStore::Handle handle = spilled_[index];
+      spilled_[index] = ElementSpillStore::Handle();
+      Status s;
+      if (prefetch_ && prefetch_->handle == handle) {
+        std::shared_ptr<PrefetchedElement> prefetch = std::move(prefetch_);
+        mutex_lock l(prefetch->mu);
+        while (!prefetch->done) {
+          prefetch->cond_var.wait(l);
+        }
+        s = prefetch->status;
+        *out_tensors = std::move(prefetch->element);
+      } else {
+        s = spill_store_->Read(handle, out_tensors);
+      }
+      spill_store_->Release(handle);
+      return s;
+    }
+
+    // Predicts the element produced by the next call to `GetNext()` and, if
+    // it has been spilled, starts reading it in the background. The
+    // prediction is wrong if the next call starts a new epoch, in which case
+    // the element is read synchronously.
+    void MaybePrefetchLocked(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!spill_store_ || slices_.empty()) {
+        return;
+      }
+      const Slice& front = *slices_.front();
+      int64 size = front.end - front.start;
+      if (slices_.size() == 1 && input_impl_) {
+        // The next call refills the buffer before choosing an element.
+        size++;
+      }
+      if (size == 0) {
+        return;
+      }
+      random::PhiloxRandom parent_generator(seed_, seed2_);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator(
+          &parent_generator);
+      generator.Skip(num_random_samples_);
+      const int64 index =
+          (front.start + generator() % size) % this->dataset()->buffer_size_;
+      const ElementSpillStore::Handle& handle = spilled_[index];
+      if (!handle.valid() || (prefetch_ && prefetch_->handle == handle)) {
+        return;
+      }
+      prefetch_ = std::make_shared<PrefetchedElement>(handle);
+      (*ctx->runner())([store = spill_store_, prefetch = prefetch_]() {
+        std::vector<Tensor> element;
+        Status s = store->Read(prefetch->handle, &element);
+        mutex_lock l(prefetch->mu);
+        prefetch->status = s;
+        prefetch->element = std::move(element);
+        prefetch->done = true;
+        prefetch->cond_var.notify_all();
+      });
+    }
+
+    Status WriteBufferLocked(IteratorStateWriter* writer)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!spill_store_) {
+        return WriteElementsToCheckpoint(writer, prefix(), *buffer_);
+      }
+      // Spilled elements are checkpointed like buffered ones, so that the
+      // checkpoint does not depend on whether spilling is enabled.
+      std::vector<std::vector<Tensor>> buffer(buffer_->size());
+      for (size_t i = 0; i < buffer.size(); ++i) {
+        if (i < spilled_.size() && spilled_[i].valid()) {
+          TF_RETURN_IF_ERROR(spill_store_->Read(spilled_[i], &buffer[i]));
+        } else {
+          buffer[i] = buffer_->at(i);
+        }
+      }
+      return WriteElementsToCheckpoint(writer, prefix(), buffer);
+    }
+
+    // Recomputes the memory used by the restored `buffer_` and spills the
+    // elements that exceed the memory budget.
+    Status RebuildSpillLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      prefetch_.reset();
+      buffered_bytes_ = 0;
+      for (ElementSpillStore::Handle& handle : spilled_) {
+        if (handle.valid()) {
+          spill_store_->Release(handle);
+          handle = ElementSpillStore::Handle();
+        }
+      }
+      for (size_t i = 0; i < buffer_->size(); ++i) {
+        std::vector<Tensor>& element = buffer_->at(i);
+        const int64 bytes = GetTotalBytes(element);
+        if (spill_store_ && i < spilled_.size() && !element.empty() &&
+            buffered_bytes_ + bytes > memory_budget_bytes_) {
+          TF_RETURN_IF_ERROR(spill_store_->Write(element, &spilled_[i]));
+          element.clear();
+        } else {
+          buffered_bytes_ += bytes;
+        }
+      }
+      return Status::OK();
+    }
+
     mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
@@ -422,6 +590,15 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_GUARDED_BY(mu_);
     int64 num_random_samples_ TF_GUARDED_BY(mu_) = 0;
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
+    // Total size of the elements held in `buffer_`.
+    int64 buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+    // The following are only set if spilling is enabled.
+    int64 memory_budget_bytes_ TF_GUARDED_BY(mu_) = 0;
+    std::shared_ptr<ElementSpillStore> spill_store_ TF_GUARDED_BY(mu_);
+    // Locations of the elements of `buffer_` that have been spilled. Entries
+    // for elements held in `buffer_` are not valid.
+    std::vector<ElementSpillStore::Handle> spilled_ TF_GUARDED_BY(mu_);
+    std::shared_ptr<PrefetchedElement> prefetch_ TF_GUARDED_BY(mu_);
   };
 
   const DatasetBase* const input_;
@@ -13,6 +13,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/platform/path.h"
 
 namespace tensorflow {
 namespace data {
@@ -549,6 +550,93 @@ INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+// Spills every buffered element, which must not change the produced sequence.
+class ShuffleDatasetOpSpillTest : public ShuffleDatasetOpTest {
+ protected:
+  void SetUp() override {
+    setenv("TF_DATA_SHUFFLE_SPILL_DIR",
+           io::JoinPath(testing::TmpDir(), "shuffle_spill").c_str(),
+           /*overwrite=*/1);
+    setenv("TF_DATA_SHUFFLE_MEMORY_BUDGET_BYTES", "1", /*overwrite=*/1);
+  }
+  void TearDown() override {
+    unsetenv("TF_DATA_SHUFFLE_SPILL_DIR");
+    unsetenv("TF_DATA_SHUFFLE_MEMORY_BUDGET_BYTES");
+  }
+};
+
+class ParameterizedSpillGetNextTest
+    : public ShuffleDatasetOpSpillTest,
+      public ::testing::WithParamInterface<
+          GetNextTestCase<ShuffleDatasetParams>> {};
+
+TEST_P(ParameterizedSpillGetNextTest, GetNext) {
+  auto test_case = GetParam();
+  TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_EXPECT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+    if (test_case.dataset_params.count() == -1 &&
+        out_tensors.size() == test_case.expected_shuffle_outputs.size()) {
+      break;
+    }
+  }
+
+  TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
+                           /*compare_order=*/true));
+}
+
+INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpSpillTest,
+                        ParameterizedSpillGetNextTest,
+                        ::testing::ValuesIn(GetNextTestCases()));
+
+class ParameterizedSpillIteratorSaveAndRestoreTest
+    : public ShuffleDatasetOpSpillTest,
+      public ::testing::WithParamInterface<
+          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {};
+
+TEST_P(ParameterizedSpillIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
+  auto test_case = GetParam();
+  TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  int cur_iteration = 0;
+  for (int breakpoint : test_case.breakpoints) {
+    VariantTensorDataWriter writer;
+    TF_EXPECT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+    std::vector<const VariantTensorData*> data;
+    writer.GetData(&data);
+    VariantTensorDataReader reader(data);
+    TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                 test_case.dataset_params.iterator_prefix(),
+                                 *dataset_, &iterator_));
+
+    while (cur_iteration <= breakpoint) {
+      std::vector<Tensor> next;
+      TF_EXPECT_OK(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+      cur_iteration++;
+    }
+  }
+
+  TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
+                           /*compare_order=*/true));
+}
+
+INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpSpillTest,
+                        ParameterizedSpillIteratorSaveAndRestoreTest,
+                        ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
+
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   std::vector<ShuffleDatasetParams> dataset_params_vec(
       {ShuffleDatasetParamsWithInvalidBufferSize(),
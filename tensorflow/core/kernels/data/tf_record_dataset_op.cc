@@ -14,8 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/tf_record_dataset_op.h"
 
+#include <deque>
+
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
@@ -24,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -42,6 +47,10 @@ constexpr char kGcsFsPrefix[] = "gs://";
 constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64 kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64 kS3BlockSize = kCloudTpuBlockSize;
+constexpr char kReadAheadThreadsEnvVar[] =
+    "TF_DATA_TFRECORD_READ_AHEAD_THREADS";
+constexpr char kReadAheadBytesEnvVar[] = "TF_DATA_TFRECORD_READ_AHEAD_BYTES";
+constexpr int64 kDefaultReadAheadBytes = 64LL << 20;  // 64MB.
 
 bool is_cloud_tpu_gcs_fs() {
 #if (defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)) || \
@@ -51,15 +60,208 @@ bool is_cloud_tpu_gcs_fs() {
   return false;
 }
 
+// Reads the records of `filenames[file_index:]` in order on background
+// threads, so that I/O, decompression and CRC checks happen off the consumer
+// thread. Up to `num_threads` consecutive files are read concurrently, and the
+// records read ahead of the consumer are bounded by `max_buffered_bytes`. The
+// file being consumed may always buffer one record, so a later file can never
+// starve it of budget.
+class RecordReadAhead {
+ public:
+  // Starts reading `filenames[file_index]` at `offset`, or at the beginning
+  // of the file if `offset` is negative.
+  RecordReadAhead(Env* env, const std::vector<string>& filenames,
+                  const io::RecordReaderOptions& options, int num_threads,
+                  int64 max_buffered_bytes, size_t file_index, int64 offset)
+      : env_(env),
+        filenames_(filenames),
+        options_(options),
+        num_threads_(num_threads),
+        max_buffered_bytes_(max_buffered_bytes),
+        file_index_(file_index),
+        offset_(offset),
+        next_file_index_(file_index),
+        thread_pool_(absl::make_unique<thread::ThreadPool>(
+            env, ThreadOptions(), "tf_record_read_ahead", num_threads,
+            /*low_latency_hint=*/false)) {}
+
+  ~RecordReadAhead() {
+    Cancel();
+    // Waits for the reader threads to exit.
+    thread_pool_.reset();
+    if (deregister_fn_) deregister_fn_();
+  }
+
+  // Starts the readers, which stop when `cancellation_manager` is cancelled.
+  Status Start(CancellationManager* cancellation_manager)
+      TF_LOCKS_EXCLUDED(mu_) {
+    TF_RETURN_IF_ERROR(RegisterCancellationCallback(
+        cancellation_manager, [this]() { Cancel(); }, &deregister_fn_));
+    mutex_lock l(mu_);
+    ScheduleFilesLocked();
+    return Status::OK();
+  }
+
+  // Returns the next record. Like `io::SequentialRecordReader`, an error
+  // other than end of file ends the file it occurred in, and reading resumes
+  // with the next file on the following call.
+  Status GetNext(tstring* record, bool* end_of_sequence)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    while (!files_.empty()) {
+      File* file = files_.front().get();
+      while (!cancelled_ && file->records.empty() && !file->done) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) {
+        return errors::Cancelled("TFRecordDataset read-ahead was cancelled");
+      }
+      if (!file->records.empty()) {
+        Record& next = file->records.front();
+        buffered_bytes_ -= next.data.size();
+        offset_ = next.offset;
+        *record = std::move(next.data);
+        file->records.pop_front();
+        cond_var_.notify_all();
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+      const Status status = file->status;
+      files_.pop_front();
+      ++file_index_;
+      offset_ = -1;
+      ScheduleFilesLocked();
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    *end_of_sequence = true;
+    return Status::OK();
+  }
+
+  // Index of the file that the next record comes from.
+  size_t file_index() TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return file_index_;
+  }
+
+  // Offset in `filenames[file_index()]` after the last returned record, or -1
+  // if no record of that file has been returned yet.
+  int64 offset() TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return offset_;
+  }
+
+ private:
+  struct Record {
+    tstring data;
+    // Offset after the record, as reported by `TellOffset()`.
+    int64 offset;
+  };
+
+  struct File {
+    std::deque<Record> records;
+    // Set once the reader of the file has exited; `status` is OK at the end
+    // of the file.
+    bool done = false;
+    Status status;
+  };
+
+  // Starts readers for the files following the ones that are in flight.
+  void ScheduleFilesLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (files_.size() < num_threads_ &&
+           next_file_index_ < filenames_.size()) {
+      auto file = std::make_shared<File>();
+      files_.push_back(file);
+      const int64 offset = next_file_index_ == file_index_ ? offset_ : -1;
+      thread_pool_->Schedule(
+          [this, file, index = next_file_index_, offset]() {
+            ReadFile(file.get(), index, offset);
+          });
+      ++next_file_index_;
+    }
+  }
+
+  // Wakes up and stops all readers; subsequent calls to `GetNext()` return
+  // `Cancelled`.
+  void Cancel() TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+  }
+
+  void ReadFile(File* file, size_t index, int64 offset)
+      TF_LOCKS_EXCLUDED(mu_) {
+    std::unique_ptr<RandomAccessFile> random_access_file;
+    std::unique_ptr<io::SequentialRecordReader> reader;
+    Status s =
+        env_->NewRandomAccessFile(filenames_[index], &random_access_file);
+    if (s.ok()) {
+      reader = absl::make_unique<io::SequentialRecordReader>(
+          random_access_file.get(), options_);
+      if (offset > 0) {
+        s = reader->SeekOffset(offset);
+      }
+    }
+    while (s.ok()) {
+      Record record;
+      s = reader->ReadRecord(&record.data);
+      if (!s.ok()) {
+        break;
+      }
+      record.offset = reader->TellOffset();
+      mutex_lock l(mu_);
+      while (!cancelled_ && buffered_bytes_ >= max_buffered_bytes_ &&
+             !(file == files_.front().get() && file->records.empty())) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+      buffered_bytes_ += record.data.size();
+      file->records.push_back(std::move(record));
+      cond_var_.notify_all();
+    }
+    mutex_lock l(mu_);
+    file->done = true;
+    if (!errors::IsOutOfRange(s)) {
+      file->status = s;
+    }
+    cond_var_.notify_all();
+  }
+
+  Env* const env_;
+  const std::vector<string>& filenames_;
+  const io::RecordReaderOptions options_;
+  const size_t num_threads_;
+  const int64 max_buffered_bytes_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  size_t file_index_ TF_GUARDED_BY(mu_);
+  int64 offset_ TF_GUARDED_BY(mu_);
+  // Index of the first file that has no reader yet.
+  size_t next_file_index_ TF_GUARDED_BY(mu_);
+  // Files [file_index_, next_file_index_), in order.
+  std::deque<std::shared_ptr<File>> files_ TF_GUARDED_BY(mu_);
+  int64 buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  std::function<void()> deregister_fn_;
+};
+
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64 buffer_size)
+                   const string& compression_type, int64 buffer_size,
+                   int64 read_ahead_threads, int64 read_ahead_bytes)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-            compression_type)) {
+            compression_type)),
+        read_ahead_threads_(read_ahead_threads),
+        read_ahead_bytes_(read_ahead_bytes) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
@@ -118,6 +320,9 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
                            bool* end_of_sequence) override {
       out_tensors->reserve(1);
       mutex_lock l(mu_);
+      if (dataset()->read_ahead_threads_ > 0) {
+        return GetNextReadAheadLocked(ctx, out_tensors, end_of_sequence);
+      }
       do {
         // We are currently processing a file, so try to read the next record.
         if (reader_) {
@@ -161,6 +366,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
     Status SkipInternal(IteratorContext* ctx, int num_to_skip,
                         bool* end_of_sequence, int* num_skipped) override {
+      if (dataset()->read_ahead_threads_ > 0) {
+        // Records are read ahead anyway, so skipping them saves nothing.
+        return DatasetIterator<Dataset>::SkipInternal(
+            ctx, num_to_skip, end_of_sequence, num_skipped);
+      }
       *num_skipped = 0;
       mutex_lock l(mu_);
       do {
@@ -209,6 +419,17 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     Status SaveInternal(SerializationContext* ctx,
                         IteratorStateWriter* writer) override {
       mutex_lock l(mu_);
+      if (read_ahead_) {
+        // Uses the same format as the synchronous reader, so that
+        // checkpoints can be restored in either mode.
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurrentFileIndex),
+                                               read_ahead_->file_index()));
+        const int64 offset = read_ahead_->offset();
+        if (offset >= 0) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kOffset), offset));
+        }
+        return Status::OK();
+      }
       TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurrentFileIndex),
                                              current_file_index_));
 
@@ -227,6 +448,14 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kCurrentFileIndex),
                                             &current_file_index));
       current_file_index_ = size_t(current_file_index);
+      if (dataset()->read_ahead_threads_ > 0) {
+        read_ahead_offset_ = -1;
+        if (reader->Contains(full_name(kOffset))) {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name(kOffset), &read_ahead_offset_));
+        }
+        return Status::OK();
+      }
       if (reader->Contains(full_name(kOffset))) {
         int64 offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
@@ -237,6 +466,33 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Returns the next record from `read_ahead_`, which is started from
+    // `current_file_index_` and `read_ahead_offset_` on first use.
+    Status GetNextReadAheadLocked(IteratorContext* ctx,
+                                  std::vector<Tensor>* out_tensors,
+                                  bool* end_of_sequence)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!read_ahead_) {
+        auto read_ahead = absl::make_unique<RecordReadAhead>(
+            ctx->env(), dataset()->filenames_, dataset()->options_,
+            dataset()->read_ahead_threads_, dataset()->read_ahead_bytes_,
+            current_file_index_, read_ahead_offset_);
+        TF_RETURN_IF_ERROR(read_ahead->Start(ctx->cancellation_manager()));
+        read_ahead_ = std::move(read_ahead);
+      }
+      out_tensors->emplace_back(ctx->allocator({}), DT_STRING, TensorShape({}));
+      tstring& record = out_tensors->back().scalar<tstring>()();
+      Status s = read_ahead_->GetNext(&record, end_of_sequence);
+      if (!s.ok() || *end_of_sequence) {
+        out_tensors->pop_back();
+        return s;
+      }
+      static monitoring::CounterCell* bytes_counter =
+          metrics::GetTFDataBytesReadCounter(kDatasetType);
+      bytes_counter->IncrementBy(record.size());
+      return Status::OK();
+    }
+
     // Sets up reader streams to read from the file at `current_file_index_`.
     Status SetupStreamsLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (current_file_index_ >= dataset()->filenames_.size()) {
@@ -257,6 +513,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
       file_.reset();
+      read_ahead_.reset();
     }
 
     mutex mu_;
@@ -266,11 +523,20 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    // Only used if `read_ahead_threads_ > 0`. `read_ahead_offset_` is the
+    // restored offset in the file at `current_file_index_`, or -1.
+    std::unique_ptr<RecordReadAhead> read_ahead_ TF_GUARDED_BY(mu_);
+    int64 read_ahead_offset_ TF_GUARDED_BY(mu_) = -1;
   };
 
   const std::vector<string> filenames_;
   const tstring compression_type_;
   io::RecordReaderOptions options_;
+  // Number of files read ahead on background threads, or 0 to read records
+  // synchronously in `GetNext()`.
+  const int64 read_ahead_threads_;
+  const int64 read_ahead_bytes_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
@@ -322,8 +588,18 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
     buffer_size = kS3BlockSize;
   }
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  int64 read_ahead_threads = 0;
+  OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar(kReadAheadThreadsEnvVar,
+                                          /*default_val=*/0,
+                                          &read_ahead_threads));
+  int64 read_ahead_bytes = kDefaultReadAheadBytes;
+  OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar(kReadAheadBytesEnvVar,
+                                          kDefaultReadAheadBytes,
+                                          &read_ahead_bytes));
+
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, std::max<int64>(read_ahead_threads, 0),
+                        read_ahead_bytes);
 }
 
 namespace {
@@ -263,6 +263,72 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(TFRecordDatasetOpTest, TFRecordDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+// Reads the records on background threads, with a read-ahead budget of a
+// single byte so that every file has to wait for the one before it.
+class TFRecordDatasetOpReadAheadTest : public TFRecordDatasetOpTest {
+ protected:
+  void SetUp() override {
+    setenv("TF_DATA_TFRECORD_READ_AHEAD_THREADS", "2", /*overwrite=*/1);
+    setenv("TF_DATA_TFRECORD_READ_AHEAD_BYTES", "1", /*overwrite=*/1);
+  }
+  void TearDown() override {
+    unsetenv("TF_DATA_TFRECORD_READ_AHEAD_THREADS");
+    unsetenv("TF_DATA_TFRECORD_READ_AHEAD_BYTES");
+  }
+};
+
+TEST_F(TFRecordDatasetOpReadAheadTest, GetNext) {
+  for (auto& dataset_params :
+       {TFRecordDatasetParams1(), TFRecordDatasetParams2(),
+        TFRecordDatasetParams3()}) {
+    TF_ASSERT_OK(Initialize(dataset_params));
+    TF_ASSERT_OK(CheckIteratorGetNext(
+        CreateTensors<tstring>(
+            TensorShape({}), {{"1"}, {"22"}, {"333"}, {"a"}, {"bb"}, {"ccc"}}),
+        /*compare_order=*/true));
+  }
+}
+
+TEST_F(TFRecordDatasetOpReadAheadTest, Skip) {
+  TF_ASSERT_OK(Initialize(TFRecordDatasetParams1()));
+  TF_ASSERT_OK(CheckIteratorSkip(
+      /*num_to_skip=*/4, /*expected_num_skipped=*/4, /*get_next=*/true,
+      CreateTensors<tstring>(TensorShape({}), {{"bb"}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(TFRecordDatasetOpReadAheadTest, SaveAndRestore) {
+  for (auto& dataset_params :
+       {TFRecordDatasetParams1(), TFRecordDatasetParams3()}) {
+    TF_ASSERT_OK(Initialize(dataset_params));
+    TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+        dataset_params.iterator_prefix(),
+        CreateTensors<tstring>(
+            TensorShape({}), {{"1"}, {"22"}, {"333"}, {"a"}, {"bb"}, {"ccc"}}),
+        /*breakpoints=*/{0, 2, 3, 4, 7}, /*compare_order=*/true));
+  }
+}
+
+// A file that fails to open is skipped after its error is returned.
+TEST_F(TFRecordDatasetOpReadAheadTest, MissingFile) {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/tf_record_read_ahead_missing"),
+      absl::StrCat(testing::TmpDir(), "/tf_record_read_ahead_1")};
+  TF_ASSERT_OK(CreateTestFiles({filenames[1]}, {{"x", "yy"}},
+                               CompressionType::UNCOMPRESSED));
+  TF_ASSERT_OK(Initialize(TFRecordDatasetParams(
+      filenames, CompressionType::UNCOMPRESSED, /*buffer_size=*/10,
+      /*node_name=*/kNodeName)));
+
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  EXPECT_TRUE(errors::IsNotFound(iterator_->GetNext(
+      iterator_ctx_.get(), &out_tensors, &end_of_sequence)));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(TensorShape({}), {{"x"}, {"yy"}}),
+      /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -81,9 +81,11 @@ class DecodeCSVOp : public OpKernel {
       OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
     }
 
+    // Reused across records so that its storage is only allocated once.
+    std::vector<tstring> fields;
     for (int64 i = 0; i < records_size; ++i) {
       const StringPiece record(records_t(i));
-      std::vector<string> fields;
+      fields.clear();
       ExtractFields(ctx, record, &fields);
       OP_REQUIRES(ctx, fields.size() == out_type_.size(),
                   errors::InvalidArgument("Expect ", out_type_.size(),
@@ -97,7 +99,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_INT32: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (IsMissing(fields[f])) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -117,7 +119,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_INT64: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (IsMissing(fields[f])) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -137,7 +139,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_FLOAT: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (IsMissing(fields[f])) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -156,7 +158,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_DOUBLE: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (IsMissing(fields[f])) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -176,7 +178,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_STRING: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (IsMissing(fields[f])) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -205,8 +207,15 @@ class DecodeCSVOp : public OpKernel {
   bool select_all_cols_;
   string na_value_;
 
+  bool IsMissing(const tstring& field) const {
+    return field.empty() || StringPiece(field) == na_value_;
+  }
+
+  // Appends the selected fields of `input` to `result`. Each field is copied
+  // straight from the record into its tstring, which is then moved into the
+  // output, so a field costs at most one allocation.
   void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
+                     std::vector<tstring>* result) {
     int64 current_idx = 0;
     int64 num_fields_parsed = 0;
     int64 selector_idx = 0;  // Keep track of index into select_cols
@@ -229,8 +238,9 @@ class DecodeCSVOp : public OpKernel {
         }
 
         // This is the body of the field;
-        string field;
+        tstring field;
         if (!quoted) {
+          const int64 field_start = current_idx;
           while (static_cast<size_t>(current_idx) < input.size() &&
                  input[current_idx] != delim_) {
             OP_REQUIRES(ctx,
@@ -239,27 +249,36 @@ class DecodeCSVOp : public OpKernel {
                             input[current_idx] != '\r',
                         errors::InvalidArgument(
                             "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
             current_idx++;
           }
+          if (include) {
+            field.assign(input.data() + field_start,
+                         current_idx - field_start);
+          }
 
           // Go to next field or the end
           current_idx++;
         } else if (use_quote_delim_) {
+          // Start of the run of characters not yet appended to `field`.
+          int64 run_start = current_idx;
           // Quoted field needs to be ended with '"' and delim or end
           while (
               (static_cast<size_t>(current_idx) < input.size() - 1) &&
               (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
             if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
               current_idx++;
             } else {
               OP_REQUIRES(
                   ctx, input[current_idx + 1] == '"',
                   errors::InvalidArgument("Quote inside a string has to be "
                                           "escaped by another quote"));
-              if (include) field += '"';
+              // Keeps the first of the two quotes.
+              if (include) {
+                field.append(input.data() + run_start,
+                             current_idx + 1 - run_start);
+              }
               current_idx += 2;
+              run_start = current_idx;
             }
           }
 
@@ -271,13 +290,16 @@ class DecodeCSVOp : public OpKernel {
                 input[current_idx + 1] == delim_)),
               errors::InvalidArgument("Quoted field has to end with quote "
                                       "followed by delim or end"));
+          if (include) {
+            field.append(input.data() + run_start, current_idx - run_start);
+          }
 
           current_idx += 2;
         }
 
         num_fields_parsed++;
         if (include) {
-          result->push_back(field);
+          result->push_back(std::move(field));
           selector_idx++;
           if (selector_idx == select_cols_.size()) return;
         }
@@ -288,7 +310,7 @@ class DecodeCSVOp : public OpKernel {
                                    static_cast<size_t>(num_fields_parsed));
       // Check if the last field is missing
       if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+        result->emplace_back();
     }
   }
 };
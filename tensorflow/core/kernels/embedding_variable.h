@@ -0,0 +1,123 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
+#define TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A float embedding table keyed by int64 ids whose rows are materialized on
+// first access, so the id space can be much larger than the set of ids that
+// are actually seen during training.
+//
+// Each row holds `dim` embedding values followed by `num_slots` optimizer slot
+// vectors of the same width (e.g. the Adagrad accumulator, or Adam's first and
+// second moments), together with the last step at which it was read or
+// updated. Rows that have not been touched for a while can be dropped with
+// Evict().
+//
+// Rows are hash-partitioned into `num_shards` shards, each guarded by its own
+// mutex. Batched accesses group their ids by shard and visit the shards in
+// parallel, taking each shard lock once per batch.
+class EmbeddingVariable : public ResourceBase {
+ public:
+  struct Options {
+    int64 dim = 0;
+    int64 num_shards = 16;
+    int64 num_slots = 0;
+    // Embedding values of new rows are drawn from N(0, initializer_stddev^2)
+    // using a generator seeded by (seed, id), so a row evicted and created
+    // again starts from the same value.
+    float initializer_stddev = 0.0f;
+    float slot_initial_value = 0.0f;
+    int64 seed = 0;
+  };
+
+  // Called with the position of an id in the batch and a pointer to its row of
+  // row_width() floats. The row's shard lock is held during the call.
+  typedef std::function<void(int64 position, float* row)> RowFn;
+
+  explicit EmbeddingVariable(const Options& options);
+
+  const Options& options() const { return options_; }
+  int64 dim() const { return options_.dim; }
+  int64 num_slots() const { return options_.num_slots; }
+  int64 row_width() const { return row_width_; }
+
+  // Calls `fn` on the row of every id in `ids`, creating missing rows and
+  // recording `step` as their last access. Calls for ids in the same shard
+  // run sequentially in batch order; different shards may run concurrently
+  // on `workers`.
+  void ForEachRow(const DeviceBase::CpuWorkerThreads& workers,
+                  gtl::ArraySlice<int64> ids, int64 step, const RowFn& fn);
+
+  // Removes all rows whose last access step is less than `min_step` and
+  // returns the number of rows removed.
+  int64 Evict(int64 min_step);
+
+  // Copies out every row. `rows` receives row_width() floats per id.
+  void Export(std::vector<int64>* ids, std::vector<float>* rows,
+              std::vector<int64>* last_access_steps) const;
+
+  // Replaces the contents of the variable. `rows` holds row_width() floats per
+  // id.
+  void Import(gtl::ArraySlice<int64> ids, const float* rows,
+              gtl::ArraySlice<int64> last_access_steps);
+
+  // Returns the number of materialized rows.
+  int64 size() const;
+
+  string DebugString() const override;
+  int64 MemoryUsed() const override;
+
+ private:
+  struct Row {
+    int64 last_access_step = 0;
+    std::unique_ptr<float[]> values;
+  };
+
+  struct RowShard {
+    mutable mutex mu;
+    absl::flat_hash_map<int64, Row> rows TF_GUARDED_BY(mu);
+  };
+
+  int64 ShardIndex(int64 id) const;
+  float* FindOrCreateRow(RowShard* shard, int64 id, int64 step)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+  void InitializeRow(int64 id, float* row) const;
+
+  const Options options_;
+  const int64 row_width_;
+  std::unique_ptr<RowShard[]> shards_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EmbeddingVariable);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_EMBEDDING_VARIABLE_H_
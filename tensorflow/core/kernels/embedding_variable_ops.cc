@@ -0,0 +1,492 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/embedding_variable.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+EmbeddingVariable::EmbeddingVariable(const Options& options)
+    : options_(options),
+      row_width_(options.dim * (1 + options.num_slots)),
+      shards_(new RowShard[options.num_shards]) {}
+
+int64 EmbeddingVariable::ShardIndex(int64 id) const {
+  // Fibonacci hashing, so that runs of consecutive ids are spread over all
+  // shards.
+  const uint64 h = static_cast<uint64>(id) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<int64>((h >> 32) % options_.num_shards);
+}
+
+void EmbeddingVariable::InitializeRow(int64 id, float* row) const {
+  const int64 dim = options_.dim;
+  if (options_.initializer_stddev == 0.0f) {
+    std::fill(row, row + dim, 0.0f);
+  } else {
+    typedef random::NormalDistribution<random::PhiloxRandom, float> Normal;
+    random::PhiloxRandom philox(options_.seed, id);
+    Normal normal;
+    const int64 kSamples = Normal::kResultElementCount;
+    for (int64 i = 0; i < dim; i += kSamples) {
+      const auto samples = normal(&philox);
+      const int64 n = std::min(kSamples, dim - i);
+      for (int64 j = 0; j < n; ++j) {
+        row[i + j] = samples[j] * options_.initializer_stddev;
+      }
+    }
+  }
+  std::fill(row + dim, row + row_width_, options_.slot_initial_value);
+}
+
+float* EmbeddingVariable::FindOrCreateRow(RowShard* shard, int64 id,
+                                          int64 step) {
+  auto result = shard->rows.try_emplace(id);
+  Row& row = result.first->second;
+  if (result.second) {
+    row.values.reset(new float[row_width_]);
+    InitializeRow(id, row.values.get());
+  }
+  row.last_access_step = std::max(row.last_access_step, step);
+  return row.values.get();
+}
+
+void EmbeddingVariable::ForEachRow(const DeviceBase::CpuWorkerThreads& workers,
+                                   gtl::ArraySlice<int64> ids, int64 step,
+                                   const RowFn& fn) {
+  const int64 num_shards = options_.num_shards;
+  std::vector<std::vector<int64>> positions(num_shards);
+  for (int64 i = 0; i < ids.size(); ++i) {
+    positions[ShardIndex(ids[i])].push_back(i);
+  }
+  auto work = [&](int64 begin, int64 end) {
+    for (int64 s = begin; s < end; ++s) {
+      if (positions[s].empty()) continue;
+      RowShard* shard = &shards_[s];
+      mutex_lock l(shard->mu);
+      for (const int64 i : positions[s]) {
+        fn(i, FindOrCreateRow(shard, ids[i], step));
+      }
+    }
+  };
+  const int64 cost_per_shard =
+      (ids.size() / num_shards + 1) * row_width_ * 10;
+  Shard(workers.num_threads, workers.workers, num_shards, cost_per_shard,
+        work);
+}
+
+int64 EmbeddingVariable::Evict(int64 min_step) {
+  int64 num_evicted = 0;
+  for (int64 s = 0; s < options_.num_shards; ++s) {
+    RowShard* shard = &shards_[s];
+    mutex_lock l(shard->mu);
+    for (auto it = shard->rows.begin(); it != shard->rows.end();) {
+      if (it->second.last_access_step < min_step) {
+        shard->rows.erase(it++);
+        ++num_evicted;
+      } else {
+        ++it;
+      }
+    }
+  }
+  return num_evicted;
+}
+
+void EmbeddingVariable::Export(std::vector<int64>* ids,
+                               std::vector<float>* rows,
+                               std::vector<int64>* last_access_steps) const {
+  ids->clear();
+  rows->clear();
+  last_access_steps->clear();
+  for (int64 s = 0; s < options_.num_shards; ++s) {
+    const RowShard* shard = &shards_[s];
+    tf_shared_lock l(shard->mu);
+    ids->reserve(ids->size() + shard->rows.size());
+    rows->reserve(rows->size() + shard->rows.size() * row_width_);
+    last_access_steps->reserve(last_access_steps->size() +
+                               shard->rows.size());
+    for (const auto& entry : shard->rows) {
+      ids->push_back(entry.first);
+      const float* values = entry.second.values.get();
+      rows->insert(rows->end(), values, values + row_width_);
+      last_access_steps->push_back(entry.second.last_access_step);
+    }
+  }
+}
+
+void EmbeddingVariable::Import(gtl::ArraySlice<int64> ids, const float* rows,
+                               gtl::ArraySlice<int64> last_access_steps) {
+  for (int64 s = 0; s < options_.num_shards; ++s) {
+    mutex_lock l(shards_[s].mu);
+    shards_[s].rows.clear();
+  }
+  for (int64 i = 0; i < ids.size(); ++i) {
+    RowShard* shard = &shards_[ShardIndex(ids[i])];
+    mutex_lock l(shard->mu);
+    Row& row = shard->rows[ids[i]];
+    row.last_access_step = last_access_steps[i];
+    row.values.reset(new float[row_width_]);
+    std::copy(rows + i * row_width_, rows + (i + 1) * row_width_,
+              row.values.get());
+  }
+}
+
+int64 EmbeddingVariable::size() const {
+  int64 size = 0;
+  for (int64 s = 0; s < options_.num_shards; ++s) {
+    tf_shared_lock l(shards_[s].mu);
+    size += shards_[s].rows.size();
+  }
+  return size;
+}
+
+string EmbeddingVariable::DebugString() const {
+  return strings::StrCat("EmbeddingVariable(dim=", options_.dim,
+                         ", num_slots=", options_.num_slots,
+                         ", num_shards=", options_.num_shards,
+                         ", size=", size(), ")");
+}
+
+int64 EmbeddingVariable::MemoryUsed() const {
+  return size() * (row_width_ * sizeof(float) + sizeof(int64) + sizeof(Row));
+}
+
+REGISTER_RESOURCE_HANDLE_KERNEL(EmbeddingVariable);
+
+namespace {
+
+template <typename T>
+Status GetScalarInput(OpKernelContext* ctx, StringPiece name, T* value) {
+  const Tensor* t;
+  TF_RETURN_IF_ERROR(ctx->input(name, &t));
+  if (!TensorShapeUtils::IsScalar(t->shape())) {
+    return errors::InvalidArgument(name, " must be a scalar, got shape ",
+                                   t->shape().DebugString());
+  }
+  *value = t->scalar<T>()();
+  return Status::OK();
+}
+
+// Validates `indices` and `grad` of a sparse apply op against `var` and
+// returns the step the update is made at.
+Status ValidateSparseApply(OpKernelContext* ctx, const EmbeddingVariable& var,
+                           int64 required_slots, const Tensor** indices,
+                           const Tensor** grad, int64* step) {
+  if (var.num_slots() < required_slots) {
+    return errors::FailedPrecondition(
+        ctx->op_kernel().type_string(), " needs ", required_slots,
+        " slots per row but the embedding variable has ", var.num_slots());
+  }
+  TF_RETURN_IF_ERROR(ctx->input("indices", indices));
+  TF_RETURN_IF_ERROR(ctx->input("grad", grad));
+  if (!TensorShapeUtils::IsVector((*indices)->shape())) {
+    return errors::InvalidArgument("indices must be a vector, got shape ",
+                                   (*indices)->shape().DebugString());
+  }
+  const TensorShape expected({(*indices)->NumElements(), var.dim()});
+  if ((*grad)->shape() != expected) {
+    return errors::InvalidArgument("grad must have shape ",
+                                   expected.DebugString(), ", got ",
+                                   (*grad)->shape().DebugString());
+  }
+  return GetScalarInput(ctx, "step", step);
+}
+
+}  // namespace
+
+class EmbeddingVariableCreateOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableCreateOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dim", &options_.dim));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_shards", &options_.num_shards));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_slots", &options_.num_slots));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("initializer_stddev",
+                                     &options_.initializer_stddev));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("slot_initial_value",
+                                     &options_.slot_initial_value));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("seed", &options_.seed));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    // Only create one, if one does not exist already.
+    Status s = CreateResource(ctx, HandleFromInput(ctx, 0),
+                              new EmbeddingVariable(options_));
+    if (s.code() != error::ALREADY_EXISTS) {
+      OP_REQUIRES_OK(ctx, s);
+    }
+  }
+
+ private:
+  EmbeddingVariable::Options options_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableCreate").Device(DEVICE_CPU),
+                        EmbeddingVariableCreateOp);
+
+class EmbeddingVariableGatherOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableGatherOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable> var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    const Tensor& indices = ctx->input(1);
+    int64 step;
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "step", &step));
+
+    const int64 dim = var->dim();
+    TensorShape output_shape = indices.shape();
+    output_shape.AddDim(dim);
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    if (indices.NumElements() == 0) return;
+
+    const auto ids = indices.flat<int64>();
+    float* out = output->flat<float>().data();
+    var->ForEachRow(*ctx->device()->tensorflow_cpu_worker_threads(),
+                    gtl::ArraySlice<int64>(ids.data(), ids.size()), step,
+                    [out, dim](int64 i, float* row) {
+                      std::copy(row, row + dim, out + i * dim);
+                    });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableGather").Device(DEVICE_CPU),
+                        EmbeddingVariableGatherOp);
+
+// Applies Adagrad to the rows named by `indices` only. Slot 0 is the
+// accumulator. Duplicate indices are applied one after another.
+class EmbeddingVariableSparseApplyAdagradOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableSparseApplyAdagradOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable> var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    float lr;
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "lr", &lr));
+    const Tensor* indices;
+    const Tensor* grad;
+    int64 step;
+    OP_REQUIRES_OK(ctx, ValidateSparseApply(ctx, *var, /*required_slots=*/1,
+                                            &indices, &grad, &step));
+    if (indices->NumElements() == 0) return;
+
+    const int64 dim = var->dim();
+    const auto ids = indices->flat<int64>();
+    const float* g = grad->flat<float>().data();
+    var->ForEachRow(*ctx->device()->tensorflow_cpu_worker_threads(),
+                    gtl::ArraySlice<int64>(ids.data(), ids.size()), step,
+                    [g, lr, dim](int64 i, float* row) {
+                      float* v = row;
+                      float* accum = row + dim;
+                      const float* gi = g + i * dim;
+                      for (int64 d = 0; d < dim; ++d) {
+                        accum[d] += gi[d] * gi[d];
+                        v[d] -= lr * gi[d] / std::sqrt(accum[d]);
+                      }
+                    });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("EmbeddingVariableSparseApplyAdagrad").Device(DEVICE_CPU),
+    EmbeddingVariableSparseApplyAdagradOp);
+
+// Applies Adam to the rows named by `indices` only. Slots 0 and 1 hold the
+// first and second moment estimates. Rows that are not touched keep their
+// moments unchanged, as in the lazy Adam variant.
+class EmbeddingVariableSparseApplyAdamOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableSparseApplyAdamOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable> var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    float lr, beta1, beta2, epsilon, beta1_power, beta2_power;
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "lr", &lr));
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "beta1", &beta1));
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "beta2", &beta2));
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "epsilon", &epsilon));
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "beta1_power", &beta1_power));
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "beta2_power", &beta2_power));
+    const Tensor* indices;
+    const Tensor* grad;
+    int64 step;
+    OP_REQUIRES_OK(ctx, ValidateSparseApply(ctx, *var, /*required_slots=*/2,
+                                            &indices, &grad, &step));
+    if (indices->NumElements() == 0) return;
+
+    const int64 dim = var->dim();
+    const float alpha =
+        lr * std::sqrt(1.0f - beta2_power) / (1.0f - beta1_power);
+    const auto ids = indices->flat<int64>();
+    const float* g = grad->flat<float>().data();
+    var->ForEachRow(
+        *ctx->device()->tensorflow_cpu_worker_threads(),
+        gtl::ArraySlice<int64>(ids.data(), ids.size()), step,
+        [=](int64 i, float* row) {
+          float* v = row;
+          float* m = row + dim;
+          float* s = row + 2 * dim;
+          const float* gi = g + i * dim;
+          for (int64 d = 0; d < dim; ++d) {
+            m[d] += (gi[d] - m[d]) * (1.0f - beta1);
+            s[d] += (gi[d] * gi[d] - s[d]) * (1.0f - beta2);
+            v[d] -= alpha * m[d] / (std::sqrt(s[d]) + epsilon);
+          }
+        });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("EmbeddingVariableSparseApplyAdam").Device(DEVICE_CPU),
+    EmbeddingVariableSparseApplyAdamOp);
+
+class EmbeddingVariableEvictOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableEvictOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable> var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    int64 step, ttl;
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "step", &step));
+    OP_REQUIRES_OK(ctx, GetScalarInput(ctx, "ttl", &ttl));
+    OP_REQUIRES(ctx, ttl >= 0,
+                errors::InvalidArgument("ttl must be non-negative, got ", ttl));
+    Tensor* num_evicted;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape({}), &num_evicted));
+    num_evicted->scalar<int64>()() = var->Evict(step - ttl);
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableEvict").Device(DEVICE_CPU),
+                        EmbeddingVariableEvictOp);
+
+class EmbeddingVariableExportOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableExportOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable> var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    std::vector<int64> ids;
+    std::vector<float> rows;
+    std::vector<int64> last_access_steps;
+    var->Export(&ids, &rows, &last_access_steps);
+
+    const int64 n = ids.size();
+    const int64 dim = var->dim();
+    const int64 num_slots = var->num_slots();
+    const int64 row_width = var->row_width();
+    Tensor* keys;
+    Tensor* values;
+    Tensor* slots;
+    Tensor* steps;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({n}), &keys));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(1, TensorShape({n, dim}), &values));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            2, TensorShape({n, num_slots, dim}), &slots));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(3, TensorShape({n}), &steps));
+    std::copy(ids.begin(), ids.end(), keys->flat<int64>().data());
+    std::copy(last_access_steps.begin(), last_access_steps.end(),
+              steps->flat<int64>().data());
+    float* values_out = values->flat<float>().data();
+    float* slots_out = slots->flat<float>().data();
+    for (int64 i = 0; i < n; ++i) {
+      const float* row = rows.data() + i * row_width;
+      std::copy(row, row + dim, values_out + i * dim);
+      std::copy(row + dim, row + row_width,
+                slots_out + i * num_slots * dim);
+    }
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableExport").Device(DEVICE_CPU),
+                        EmbeddingVariableExportOp);
+
+class EmbeddingVariableImportOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableImportOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    core::RefCountPtr<EmbeddingVariable> var;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &var));
+    const Tensor& keys = ctx->input(1);
+    const Tensor& values = ctx->input(2);
+    const Tensor& slots = ctx->input(3);
+    const Tensor& steps = ctx->input(4);
+
+    const int64 dim = var->dim();
+    const int64 num_slots = var->num_slots();
+    const int64 row_width = var->row_width();
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(keys.shape()),
+                errors::InvalidArgument("keys must be a vector, got shape ",
+                                        keys.shape().DebugString()));
+    const int64 n = keys.NumElements();
+    OP_REQUIRES(ctx, values.shape() == TensorShape({n, dim}),
+                errors::InvalidArgument(
+                    "values must have shape [", n, ", ", dim, "], got ",
+                    values.shape().DebugString()));
+    OP_REQUIRES(ctx, slots.shape() == TensorShape({n, num_slots, dim}),
+                errors::InvalidArgument(
+                    "slots must have shape [", n, ", ", num_slots, ", ", dim,
+                    "], got ", slots.shape().DebugString()));
+    OP_REQUIRES(ctx, steps.shape() == keys.shape(),
+                errors::InvalidArgument(
+                    "last_access_steps must have the same shape as keys, got ",
+                    steps.shape().DebugString()));
+
+    std::vector<float> rows(n * row_width);
+    const float* values_in = values.flat<float>().data();
+    const float* slots_in = slots.flat<float>().data();
+    for (int64 i = 0; i < n; ++i) {
+      float* row = rows.data() + i * row_width;
+      std::copy(values_in + i * dim, values_in + (i + 1) * dim, row);
+      std::copy(slots_in + i * num_slots * dim,
+                slots_in + (i + 1) * num_slots * dim, row + dim);
+    }
+    const auto ids = keys.flat<int64>();
+    const auto last_access_steps = steps.flat<int64>();
+    var->Import(gtl::ArraySlice<int64>(ids.data(), n), rows.data(),
+                gtl::ArraySlice<int64>(last_access_steps.data(), n));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableImport").Device(DEVICE_CPU),
+                        EmbeddingVariableImportOp);
+
+}  // namespace tensorflow
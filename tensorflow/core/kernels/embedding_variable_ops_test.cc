@@ -0,0 +1,211 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/embedding_variable.h"
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace {
+
+EmbeddingVariable::Options MakeOptions(int64 dim, int64 num_slots) {
+  EmbeddingVariable::Options options;
+  options.dim = dim;
+  options.num_shards = 4;
+  options.num_slots = num_slots;
+  return options;
+}
+
+class EmbeddingVariableTest : public ::testing::Test {
+ protected:
+  EmbeddingVariableTest() : pool_(Env::Default(), "test", 2) {
+    workers_.num_threads = 2;
+    workers_.workers = &pool_;
+  }
+
+  // Returns the rows of `ids`, creating them at `step` if needed.
+  std::vector<float> Read(EmbeddingVariable* var, std::vector<int64> ids,
+                          int64 step) {
+    const int64 width = var->row_width();
+    std::vector<float> out(ids.size() * width);
+    var->ForEachRow(workers_, ids, step, [&](int64 i, float* row) {
+      std::copy(row, row + width, out.begin() + i * width);
+    });
+    return out;
+  }
+
+  thread::ThreadPool pool_;
+  DeviceBase::CpuWorkerThreads workers_;
+};
+
+TEST_F(EmbeddingVariableTest, RowsAreInitializedFromSeedAndId) {
+  EmbeddingVariable::Options options = MakeOptions(6, 1);
+  options.initializer_stddev = 1.0f;
+  options.slot_initial_value = 0.5f;
+  options.seed = 7;
+  core::RefCountPtr<EmbeddingVariable> var_a(new EmbeddingVariable(options));
+  options.num_shards = 3;
+  core::RefCountPtr<EmbeddingVariable> var_b(new EmbeddingVariable(options));
+
+  const std::vector<float> rows_a = Read(var_a.get(), {3, 11}, 1);
+  const std::vector<float> rows_b = Read(var_b.get(), {11, 3}, 1);
+  EXPECT_EQ(2, var_a->size());
+  for (int64 d = 0; d < 12; ++d) {
+    EXPECT_EQ(rows_a[d], rows_b[12 + d]);
+    EXPECT_EQ(rows_a[12 + d], rows_b[d]);
+  }
+  EXPECT_NE(rows_a[0], rows_a[12]);
+  for (int64 d = 6; d < 12; ++d) {
+    EXPECT_EQ(0.5f, rows_a[d]);
+  }
+}
+
+TEST_F(EmbeddingVariableTest, EvictRemovesStaleRows) {
+  core::RefCountPtr<EmbeddingVariable> var(
+      new EmbeddingVariable(MakeOptions(2, 0)));
+  Read(var.get(), {1, 2, 3}, 1);
+  Read(var.get(), {2}, 5);
+  EXPECT_EQ(0, var->Evict(1));
+  EXPECT_EQ(2, var->Evict(3));
+  EXPECT_EQ(1, var->size());
+
+  std::vector<int64> ids, steps;
+  std::vector<float> rows;
+  var->Export(&ids, &rows, &steps);
+  EXPECT_EQ(std::vector<int64>({2}), ids);
+  EXPECT_EQ(std::vector<int64>({5}), steps);
+}
+
+TEST_F(EmbeddingVariableTest, ExportImportRoundTrip) {
+  EmbeddingVariable::Options options = MakeOptions(3, 2);
+  options.initializer_stddev = 0.1f;
+  core::RefCountPtr<EmbeddingVariable> src(new EmbeddingVariable(options));
+  core::RefCountPtr<EmbeddingVariable> dst(new EmbeddingVariable(options));
+  Read(src.get(), {10, 20, 30}, 4);
+  Read(dst.get(), {40}, 1);
+
+  std::vector<int64> ids, steps;
+  std::vector<float> rows;
+  src->Export(&ids, &rows, &steps);
+  dst->Import(ids, rows.data(), steps);
+  EXPECT_EQ(3, dst->size());
+
+  for (int64 i = 0; i < ids.size(); ++i) {
+    const std::vector<float> expected = Read(src.get(), {ids[i]}, 0);
+    EXPECT_EQ(expected, Read(dst.get(), {ids[i]}, 0));
+  }
+  std::vector<int64> dst_ids, dst_steps;
+  std::vector<float> dst_rows;
+  dst->Export(&dst_ids, &dst_rows, &dst_steps);
+  EXPECT_EQ(std::vector<int64>({4, 4, 4}), dst_steps);
+}
+
+class EmbeddingVariableOpsTest : public OpsTestBase {
+ protected:
+  EmbeddingVariable* AddVariable(const EmbeddingVariable::Options& options) {
+    auto* var = new EmbeddingVariable(options);
+    AddResourceInput("", "embedding", var);
+    return var;
+  }
+};
+
+TEST_F(EmbeddingVariableOpsTest, GatherMaterializesRows) {
+  TF_ASSERT_OK(NodeDefBuilder("gather", "EmbeddingVariableGather")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_INT64))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  EmbeddingVariable::Options options = MakeOptions(2, 0);
+  options.initializer_stddev = 1.0f;
+  EmbeddingVariable* var = AddVariable(options);
+  AddInputFromArray<int64>(TensorShape({2, 2}), {5, 9, 5, 1 << 30});
+  AddInputFromArray<int64>(TensorShape({}), {3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const Tensor& output = *GetOutput(0);
+  ASSERT_EQ(TensorShape({2, 2, 2}), output.shape());
+  const auto out = output.flat<float>();
+  EXPECT_EQ(out(0), out(4));
+  EXPECT_EQ(out(1), out(5));
+  EXPECT_EQ(3, var->size());
+}
+
+TEST_F(EmbeddingVariableOpsTest, SparseApplyAdagradUpdatesIndexedRows) {
+  TF_ASSERT_OK(NodeDefBuilder("adagrad", "EmbeddingVariableSparseApplyAdagrad")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_INT64))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  EmbeddingVariable::Options options = MakeOptions(2, 1);
+  options.slot_initial_value = 0.1f;
+  EmbeddingVariable* var = AddVariable(options);
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  AddInputFromArray<float>(TensorShape({1, 2}), {1.0f, -2.0f});
+  AddInputFromArray<int64>(TensorShape({1}), {7});
+  AddInputFromArray<int64>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<int64> ids, steps;
+  std::vector<float> rows;
+  var->Export(&ids, &rows, &steps);
+  ASSERT_EQ(std::vector<int64>({7}), ids);
+  EXPECT_FLOAT_EQ(-0.5f / std::sqrt(1.1f), rows[0]);
+  EXPECT_FLOAT_EQ(1.0f / std::sqrt(4.1f), rows[1]);
+  EXPECT_FLOAT_EQ(1.1f, rows[2]);
+  EXPECT_FLOAT_EQ(4.1f, rows[3]);
+}
+
+TEST_F(EmbeddingVariableOpsTest, SparseApplyAdamRequiresTwoSlots) {
+  TF_ASSERT_OK(NodeDefBuilder("adam", "EmbeddingVariableSparseApplyAdam")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_INT64))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddVariable(MakeOptions(2, 1));
+  for (int i = 0; i < 6; ++i) {
+    AddInputFromArray<float>(TensorShape({}), {0.9f});
+  }
+  AddInputFromArray<float>(TensorShape({1, 2}), {1.0f, 1.0f});
+  AddInputFromArray<int64>(TensorShape({1}), {0});
+  AddInputFromArray<int64>(TensorShape({}), {1});
+  EXPECT_EQ(error::FAILED_PRECONDITION, RunOpKernel().code());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/batch_util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -43,7 +44,7 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   DCHECK_GT(queues_[0].size(), size_t{0});
   (*tuple).reserve(num_components());
   for (int i = 0; i < num_components(); ++i) {
-    (*tuple).push_back(queues_[i][0]);
+    (*tuple).push_back(std::move(queues_[i][0]));
     queues_[i].pop_front();
   }
 }
@@ -261,32 +262,18 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
 
             if (closed_ && queue_size < attempt->elements_requested) {
               // If we don't have enough for a full dequeue, we have
-              // to reset the attempt tuple.
-              if (!attempt->tuple.empty()) {
-                // Restore already-dequeued elements to the front of the
-                // queue.
-                for (int64 i = attempt->tuple[0].dim_size(0) -
-                               attempt->elements_requested - 1;
-                     i >= 0; --i) {
-                  for (int j = 0; j < num_components(); ++j) {
-                    Tensor element;
-                    Status s = GetElementComponentFromBatch(
-                        attempt->tuple, i, j, attempt->context, &element);
-                    if (!s.ok()) {
-                      attempt->context->SetStatus(
-                          errors::DataLoss("Failed to restore element from "
-                                           "partially-dequeued batch "
-                                           "to FIFOQueue: ",
-                                           s.error_message()));
-                    }
-                    queues_[j].push_front(element);
-                  }
+              // to reset the attempt.
+              // Restore already-dequeued elements to the front of the queue.
+              for (auto it = attempt->tuples.rbegin();
+                   it != attempt->tuples.rend(); ++it) {
+                for (int j = 0; j < num_components(); ++j) {
+                  queues_[j].push_front(std::move((*it)[j]));
                 }
               }
+              attempt->tuples.clear();
               if (allow_small_batch && !queues_[0].empty()) {
                 // Request all remaining elements in the queue.
                 queue_size = queues_[0].size();
-                attempt->tuple.clear();
                 attempt->elements_requested = queue_size;
               } else {
                 if (allow_small_batch) {
@@ -308,36 +295,24 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
 
             RunResult result = kNoProgress;
             for (; queue_size > 0; --queue_size) {
-              if (attempt->tuple.empty()) {
-                // Only allocate tuple when we have something to dequeue
-                // so we don't use excessive memory when there are many
-                // blocked dequeue attempts waiting.
-                attempt->tuple.reserve(num_components());
-                for (int i = 0; i < num_components(); ++i) {
-                  const TensorShape shape =
-                      ManyOutShape(i, attempt->elements_requested);
-                  Tensor element;
-                  attempt->context->SetStatus(attempt->context->allocate_temp(
-                      component_dtypes_[i], shape, &element));
-                  if (!attempt->context->status().ok()) return kComplete;
-                  attempt->tuple.emplace_back(element);
-                }
-              }
+              // Only move the dequeued elements aside while holding `mu_`.
+              // The batch is allocated and filled in `done_callback`, which
+              // runs outside the lock.
               result = kProgress;
-              Tuple tuple;
-              DequeueLocked(attempt->context, &tuple);
-              const int64 index =
-                  attempt->tuple[0].dim_size(0) - attempt->elements_requested;
-              for (int i = 0; i < num_components(); ++i) {
-                attempt->context->SetStatus(batch_util::CopyElementToSlice(
-                    std::move(tuple[i]), &attempt->tuple[i], index));
-                if (!attempt->context->status().ok()) return kComplete;
-              }
-              tuple.clear();
+              attempt->tuples.emplace_back();
+              DequeueLocked(attempt->context, &attempt->tuples.back());
               --attempt->elements_requested;
               if (attempt->elements_requested == 0) {
-                tuple = attempt->tuple;
-                attempt->done_callback = [callback, tuple]() {
+                auto elements = std::make_shared<std::vector<Tuple>>(
+                    std::move(attempt->tuples));
+                attempt->tuples.clear();
+                OpKernelContext* ctx = attempt->context;
+                attempt->done_callback = [this, callback, ctx, elements]() {
+                  Tuple tuple;
+                  ctx->SetStatus(BatchDequeuedElements(ctx, *elements, &tuple));
+                  if (!ctx->status().ok()) {
+                    tuple.clear();
+                  }
                   callback(tuple);
                 };
                 return kComplete;
@@ -355,6 +330,47 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 }
 
+Status FIFOQueue::BatchDequeuedElements(OpKernelContext* ctx,
+                                        const std::vector<Tuple>& elements,
+                                        Tuple* tuple) {
+  const int64 batch_size = elements.size();
+  tuple->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor batch;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        component_dtypes_[i], ManyOutShape(i, batch_size), &batch));
+    tuple->push_back(std::move(batch));
+  }
+  if (batch_size == 0) {
+    return Status::OK();
+  }
+
+  mutex status_mu;
+  Status status;
+  auto copy_range = [&](int64 start, int64 limit) {
+    for (int64 index = start; index < limit; ++index) {
+      for (int i = 0; i < num_components(); ++i) {
+        Status s = batch_util::CopyElementToSlice(elements[index][i],
+                                                  &(*tuple)[i], index);
+        if (!s.ok()) {
+          mutex_lock l(status_mu);
+          status.Update(s);
+          return;
+        }
+      }
+    }
+  };
+  int64 bytes_per_element = 0;
+  for (const Tensor& component : elements[0]) {
+    bytes_per_element += component.TotalBytes();
+  }
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+        bytes_per_element, copy_range);
+  return status;
+}
+
 Status FIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
   if (!MatchesNodeDefOp(node_def, "FIFOQueue").ok() &&
       !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
@@ -67,6 +67,13 @@ class FIFOQueue : public TypedQueue<std::deque<Tensor> > {
                                              Tensor* out_tensor);
 
  private:
+  // Allocates one batch tensor per component and copies `elements` into it.
+  // Called without holding `mu_`; large batches are copied in parallel on the
+  // device's CPU worker threads.
+  Status BatchDequeuedElements(OpKernelContext* ctx,
+                               const std::vector<Tuple>& elements,
+                               Tuple* tuple);
+
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueue);
 };
 
@@ -135,13 +135,11 @@ class IfOp : public AsyncOpKernel {
   ~IfOp() override {}
 
   void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
-    FHandle then_handle;
-    FHandle else_handle;
-    OP_REQUIRES_OK_ASYNC(ctx, GetHandles(ctx, &then_handle, &else_handle),
-                         done);
     bool cond;
-    OP_REQUIRES_OK(ctx, ToBool({ctx->input(0)}, &cond));
-    (new State(this, ctx, cond, then_handle, else_handle, done))->Start();
+    OP_REQUIRES_OK_ASYNC(ctx, ToBool({ctx->input(0)}, &cond), done);
+    FHandle handle;
+    OP_REQUIRES_OK_ASYNC(ctx, GetHandle(ctx, cond, &handle), done);
+    (new State(this, ctx, handle, done))->Start();
   }
 
  private:
@@ -154,13 +152,11 @@ class IfOp : public AsyncOpKernel {
 
   class State {
    public:
-    State(IfOp* kernel, OpKernelContext* ctx, bool cond, FHandle then_handle,
-          FHandle else_handle, DoneCallback done)
+    State(IfOp* kernel, OpKernelContext* ctx, FHandle handle,
+          DoneCallback done)
         : kernel_(kernel),
           ctx_(ctx),
-          cond_(cond),
-          then_handle_(then_handle),
-          else_handle_(else_handle),
+          handle_(handle),
           done_(std::move(done)),
           lib_(CHECK_NOTNULL(ctx_->function_library())) {
       SetRunOptions(ctx_, &opts_, true /* always_collect_stats */);
@@ -172,12 +168,11 @@ class IfOp : public AsyncOpKernel {
     ~State() {}
 
     void Start() {
-      FHandle handle = cond_ ? then_handle_ : else_handle_;
       rets_.clear();
       profiler::TraceMe trace_me("IfOp");
       lib_->Run(
           // Evaluate one of the branch.
-          opts_, handle, args_, &rets_,
+          opts_, handle_, args_, &rets_,
           // Done callback
           [this](Status s) {
             if (s.ok()) {
@@ -193,9 +188,7 @@ class IfOp : public AsyncOpKernel {
    private:
     IfOp* const kernel_;
     OpKernelContext* const ctx_;
-    const bool cond_;
-    FHandle then_handle_;
-    FHandle else_handle_;
+    const FHandle handle_;
     DoneCallback done_;
     FunctionLibraryRuntime* const lib_;
     FunctionLibraryRuntime::Options opts_;
@@ -203,8 +196,10 @@ class IfOp : public AsyncOpKernel {
     TensorVec rets_;
   };
 
-  Status GetHandles(OpKernelContext* ctx, FHandle* then_handle,
-                    FHandle* else_handle) {
+  // Returns the handle of the branch selected by `cond`. Each branch is
+  // instantiated the first time it is taken, so a branch that never runs
+  // (e.g. a rarely used fallback) is never instantiated.
+  Status GetHandle(OpKernelContext* ctx, bool cond, FHandle* handle) {
     // TODO(b/37549631): Because this op has `SetIsStateful()` in its
     // op registration, this kernel may be shared by multiple
     // subgraphs, which have different associated
@@ -214,27 +209,26 @@ class IfOp : public AsyncOpKernel {
     // functions this op uses.
     auto lib = ctx->function_library();
     if (lib == nullptr) return errors::Internal("No function library");
-    *then_handle = kInvalidHandle;
-    *else_handle = kInvalidHandle;
+    *handle = kInvalidHandle;
     {
       tf_shared_lock l(mu_);
       const auto iter = handles_.find(lib);
       if (TF_PREDICT_TRUE(iter != handles_.end())) {
-        *then_handle = iter->second.first;
-        *else_handle = iter->second.second;
+        *handle = cond ? iter->second.first : iter->second.second;
       }
     }
-    if (TF_PREDICT_FALSE(*then_handle == kInvalidHandle)) {
+    if (TF_PREDICT_FALSE(*handle == kInvalidHandle)) {
       mutex_lock l(mu_);
-      const auto iter = handles_.find(lib);
-      if (TF_PREDICT_TRUE(iter != handles_.end())) {
-        *then_handle = iter->second.first;
-        *else_handle = iter->second.second;
-      } else {
-        TF_RETURN_IF_ERROR(Instantiate(ctx, then_func_, then_handle));
-        TF_RETURN_IF_ERROR(Instantiate(ctx, else_func_, else_handle));
-        handles_[lib] = {*then_handle, *else_handle};
+      auto& handles =
+          handles_.emplace(lib, std::make_pair(kInvalidHandle, kInvalidHandle))
+              .first->second;
+      FHandle& branch_handle = cond ? handles.first : handles.second;
+      if (branch_handle == kInvalidHandle) {
+        TF_RETURN_IF_ERROR(
+            Instantiate(ctx, cond ? then_func_ : else_func_, handle));
+        branch_handle = *handle;
       }
+      *handle = branch_handle;
     }
     return Status::OK();
   }
@@ -255,25 +249,29 @@ class CaseOp : public AsyncOpKernel {
     OP_REQUIRES_ASYNC(ctx, lib != nullptr,
                       errors::Internal("No function library"), done);
 
-    // TODO(b/37549631): Because this op has `SetIsStateful()` in its op
-    // registration, this kernel may be shared by multiple subgraphs, which have
-    // different associated `FunctionLibraryRuntime` objects and hence different
-    // `FHandle` namespaces. So we must call Instantiate() to make sure we get
-    // the correct function handles with respect to `lib`. Note the underlying
-    // `lib->Instantiate()` caches the created function handles, so calling
-    // `Instantiate()` repeatedly on the same `lib` and function is cheap.
-    std::vector<FHandle> branch_handles(branch_funcs_.size());
-    for (int i = 0; i < branch_funcs_.size(); i++) {
-      OP_REQUIRES_OK_ASYNC(
-          ctx, Instantiate(lib, branch_funcs_[i], &branch_handles[i]), done);
-    }
-
     const Tensor& branch_index = ctx->input(0);
     OP_REQUIRES_ASYNC(ctx, TensorShapeUtils::IsScalar(branch_index.shape()),
                       errors::InvalidArgument("branch_index must be scalar"),
                       done);
     int32 branch = branch_index.scalar<int32>()();
-    (new State(this, ctx, branch, branch_handles, done))->Start();
+    // The last branch is the default branch.
+    if (branch < 0 || branch >= branch_funcs_.size()) {
+      branch = branch_funcs_.size() - 1;
+    }
+
+    // TODO(b/37549631): Because this op has `SetIsStateful()` in its op
+    // registration, this kernel may be shared by multiple subgraphs, which have
+    // different associated `FunctionLibraryRuntime` objects and hence different
+    // `FHandle` namespaces. So we must call Instantiate() to make sure we get
+    // the correct function handle with respect to `lib`. Note the underlying
+    // `lib->Instantiate()` caches the created function handles, so calling
+    // `Instantiate()` repeatedly on the same `lib` and function is cheap. Only
+    // the selected branch is instantiated, so branches that never run are
+    // never instantiated.
+    FHandle handle;
+    OP_REQUIRES_OK_ASYNC(ctx, Instantiate(lib, branch_funcs_[branch], &handle),
+                         done);
+    (new State(this, ctx, handle, done))->Start();
   }
 
  private:
@@ -281,12 +279,11 @@ class CaseOp : public AsyncOpKernel {
 
   class State {
    public:
-    State(CaseOp* kernel, OpKernelContext* ctx, int branch,
-          std::vector<FHandle> branch_handles, DoneCallback done)
+    State(CaseOp* kernel, OpKernelContext* ctx, FHandle handle,
+          DoneCallback done)
         : kernel_(kernel),
           ctx_(ctx),
-          branch_(branch),
-          branch_handles_(branch_handles),
+          handle_(handle),
           done_(std::move(done)),
           lib_(CHECK_NOTNULL(ctx_->function_library())) {
       SetRunOptions(ctx_, &opts_, true /* always_collect_stats */);
@@ -298,16 +295,11 @@ class CaseOp : public AsyncOpKernel {
     ~State() {}
 
     void Start() {
-      int branch = branch_;
-      // The last branch is the default branch.
-      if (branch < 0 || branch >= branch_handles_.size()) {
-        branch = branch_handles_.size() - 1;
-      }
       rets_.clear();
       profiler::TraceMe trace_me("CaseOp");
       lib_->Run(
           // Evaluate one of the branch.
-          opts_, branch_handles_[branch], args_, &rets_,
+          opts_, handle_, args_, &rets_,
           // Done callback
           [this](Status s) {
             if (s.ok()) {
@@ -323,8 +315,7 @@ class CaseOp : public AsyncOpKernel {
    private:
     CaseOp* const kernel_;
     OpKernelContext* const ctx_;
-    const int branch_;
-    std::vector<FHandle> branch_handles_;
+    const FHandle handle_;
     DoneCallback done_;
     FunctionLibraryRuntime* const lib_;
     FunctionLibraryRuntime::Options opts_;
@@ -0,0 +1,163 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// A branch that is not in the function library, so that instantiating it
+// fails. It is only ever instantiated if it is taken.
+constexpr char kUndefinedBranch[] = "Undefined";
+
+// Returns a function attr for `name`, instantiated for int32.
+NameAttrList Func(const string& name) {
+  NameAttrList func;
+  func.set_name(name);
+  (*func.mutable_attr())["T"].set_type(DT_INT32);
+  return func;
+}
+
+// Runs the graph without rewriting it, so that If and Case run as kernels.
+SessionOptions SessionOptionsWithoutRewrites() {
+  SessionOptions session_options;
+  session_options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  return session_options;
+}
+
+class FunctionalOpsTest : public ::testing::Test {
+ protected:
+  FunctionalOpsTest() : root_(Scope::NewRootScope().ExitOnError()) {
+    FunctionDefLibrary f_lib_proto;
+    *f_lib_proto.add_function() = test::function::XTimesTwo();
+    *f_lib_proto.add_function() = test::function::XTimesFour();
+    TF_CHECK_OK(root_.graph()->AddFunctionLibrary(f_lib_proto));
+    x_ = ops::Placeholder(root_.WithOpName("x"), DT_INT32);
+    selector_ = ops::Placeholder(root_.WithOpName("selector"), DT_INT32);
+  }
+
+  // Runs `op` with x = 10 and the given selector, which is the condition of
+  // an If or the branch index of a Case.
+  Status Run(ClientSession* session, Node* op, int32 selector, int32* y) {
+    ClientSession::FeedType feeds;
+    feeds.emplace(x_, Input::Initializer(10));
+    feeds.emplace(selector_, Input::Initializer(selector));
+    std::vector<Tensor> outputs;
+    TF_RETURN_IF_ERROR(session->Run(feeds, {Output(op)}, &outputs));
+    *y = outputs[0].scalar<int32>()();
+    return Status::OK();
+  }
+
+  Node* If(const string& then_branch, const string& else_branch) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder("if", "If", &root_.graph()->flib_def())
+                    .Input(selector_.node())
+                    .Input({NodeBuilder::NodeOut(x_.node())})
+                    .Attr("then_branch", Func(then_branch))
+                    .Attr("else_branch", Func(else_branch))
+                    .Attr("Tout", {DT_INT32})
+                    .Finalize(root_.graph(), &node));
+    return node;
+  }
+
+  Node* Case(const std::vector<string>& branches) {
+    AttrValue branches_attr;
+    for (const string& branch : branches) {
+      *branches_attr.mutable_list()->add_func() = Func(branch);
+    }
+    Node* node;
+    TF_CHECK_OK(NodeBuilder("case", "Case", &root_.graph()->flib_def())
+                    .Input(selector_.node())
+                    .Input({NodeBuilder::NodeOut(x_.node())})
+                    .Attr("branches", branches_attr)
+                    .Attr("Tout", {DT_INT32})
+                    .Finalize(root_.graph(), &node));
+    return node;
+  }
+
+  // Expects `s` to be the error of instantiating kUndefinedBranch.
+  void ExpectUndefinedBranchError(const Status& s) {
+    EXPECT_TRUE(errors::IsNotFound(s)) << s;
+    EXPECT_TRUE(absl::StrContains(s.error_message(), kUndefinedBranch)) << s;
+  }
+
+  Scope root_;
+  Output x_;
+  Output selector_;
+};
+
+TEST_F(FunctionalOpsTest, IfDoesNotInstantiateUntakenElseBranch) {
+  Node* if_op = If("XTimesTwo", kUndefinedBranch);
+  ClientSession session(root_, SessionOptionsWithoutRewrites());
+  int32 y;
+  TF_ASSERT_OK(Run(&session, if_op, /*selector=*/1, &y));
+  EXPECT_EQ(20, y);
+  TF_ASSERT_OK(Run(&session, if_op, /*selector=*/1, &y));
+  EXPECT_EQ(20, y);
+
+  // Taking the other branch is what instantiates it.
+  ExpectUndefinedBranchError(Run(&session, if_op, /*selector=*/0, &y));
+  TF_ASSERT_OK(Run(&session, if_op, /*selector=*/1, &y));
+  EXPECT_EQ(20, y);
+}
+
+TEST_F(FunctionalOpsTest, IfDoesNotInstantiateUntakenThenBranch) {
+  Node* if_op = If(kUndefinedBranch, "XTimesFour");
+  ClientSession session(root_, SessionOptionsWithoutRewrites());
+  int32 y;
+  TF_ASSERT_OK(Run(&session, if_op, /*selector=*/0, &y));
+  EXPECT_EQ(40, y);
+  ExpectUndefinedBranchError(Run(&session, if_op, /*selector=*/1, &y));
+}
+
+TEST_F(FunctionalOpsTest, CaseDoesNotInstantiateUntakenBranches) {
+  Node* case_op = Case({"XTimesTwo", kUndefinedBranch, "XTimesFour"});
+  ClientSession session(root_, SessionOptionsWithoutRewrites());
+  int32 y;
+  TF_ASSERT_OK(Run(&session, case_op, /*selector=*/0, &y));
+  EXPECT_EQ(20, y);
+  TF_ASSERT_OK(Run(&session, case_op, /*selector=*/2, &y));
+  EXPECT_EQ(40, y);
+  ExpectUndefinedBranchError(Run(&session, case_op, /*selector=*/1, &y));
+}
+
+TEST_F(FunctionalOpsTest, CaseRunsDefaultBranchForOutOfRangeIndex) {
+  // The last branch is the default one. No other branch is instantiated.
+  Node* case_op = Case({kUndefinedBranch, kUndefinedBranch, "XTimesFour"});
+  ClientSession session(root_, SessionOptionsWithoutRewrites());
+  int32 y;
+  TF_ASSERT_OK(Run(&session, case_op, /*selector=*/-1, &y));
+  EXPECT_EQ(40, y);
+  TF_ASSERT_OK(Run(&session, case_op, /*selector=*/3, &y));
+  EXPECT_EQ(40, y);
+  TF_ASSERT_OK(Run(&session, case_op, /*selector=*/100, &y));
+  EXPECT_EQ(40, y);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,378 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <unordered_map>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/str_join.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/kernels/cwise_ops_common.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Compute functions for the ops that can be fused into `_FusedElementwise`.
+// All of them evaluate a coefficient-wise Eigen expression over 1-D slices, so
+// that a fused DAG is evaluated slice by slice with the intermediate values
+// staying in cache.
+template <typename T>
+struct FusedElementwiseFns {
+  using InputBuffer = typename TTypes<T>::ConstFlat;
+  using OutputBuffer = typename TTypes<T>::Flat;
+
+  using UnaryFn = void (*)(const InputBuffer&, OutputBuffer*);
+  using BinaryFn = void (*)(const InputBuffer&, const InputBuffer&,
+                            OutputBuffer*);
+
+  struct Registration {
+    UnaryFn unary_fn = nullptr;
+    BinaryFn binary_fn = nullptr;
+    int cost = 0;
+  };
+
+  static const std::unordered_map<string, Registration>& Get() {
+    static const auto* fns = new std::unordered_map<string, Registration>({
+        {"Abs", Unary<functor::abs<T>>()},
+        {"Exp", Unary<functor::exp<T>>()},
+        {"Log", Unary<functor::log<T>>()},
+        {"Neg", Unary<functor::neg<T>>()},
+        {"Reciprocal", Unary<functor::inverse<T>>()},
+        {"Rsqrt", Unary<functor::rsqrt<T>>()},
+        {"Sigmoid", Unary<functor::sigmoid<T>>()},
+        {"Sqrt", Unary<functor::sqrt<T>>()},
+        {"Square", Unary<functor::square<T>>()},
+        {"Tanh", Unary<functor::tanh<T>>()},
+        {"Relu",
+         {ComputeRelu, nullptr, Cost<Eigen::internal::scalar_max_op<T>>()}},
+        {"Add", Binary<functor::add<T>>()},
+        {"AddV2", Binary<functor::add<T>>()},
+        {"Sub", Binary<functor::sub<T>>()},
+        {"Mul", Binary<functor::mul<T>>()},
+        {"RealDiv", Binary<functor::div<T>>()},
+        {"Maximum", Binary<functor::maximum<T>>()},
+        {"Minimum", Binary<functor::minimum<T>>()},
+        {"SquaredDifference", Binary<functor::squared_difference<T>>()},
+    });
+    return *fns;
+  }
+
+ private:
+  template <typename Func>
+  static int Cost() {
+    return Eigen::internal::functor_traits<Func>::Cost;
+  }
+
+  template <typename Functor>
+  static void ComputeUnary(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.unaryExpr(typename Functor::func());
+  }
+
+  template <typename Functor>
+  static void ComputeBinary(const InputBuffer& x, const InputBuffer& y,
+                            OutputBuffer* out) {
+    *out = x.binaryExpr(y, typename Functor::func());
+  }
+
+  static void ComputeRelu(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.cwiseMax(static_cast<T>(0));
+  }
+
+  template <typename Functor>
+  static Registration Unary() {
+    return {ComputeUnary<Functor>, nullptr, Cost<typename Functor::func>()};
+  }
+
+  template <typename Functor>
+  static Registration Binary() {
+    return {nullptr, ComputeBinary<Functor>, Cost<typename Functor::func>()};
+  }
+};
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  using Fns = FusedElementwiseFns<T>;
+  using InputBuffer = typename Fns::InputBuffer;
+  using OutputBuffer = typename Fns::OutputBuffer;
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args_));
+    std::vector<string> op_names;
+    std::vector<int32> operands;
+    OP_REQUIRES_OK(context, context->GetAttr("op_names", &op_names));
+    OP_REQUIRES_OK(context, context->GetAttr("operands", &operands));
+    OP_REQUIRES(context, !op_names.empty(),
+                errors::InvalidArgument(
+                    "Fused elementwise op must have at least one op"));
+    OP_REQUIRES(
+        context, operands.size() == 2 * op_names.size(),
+        errors::InvalidArgument("Expected two operands for each of the ",
+                                op_names.size(), " fused ops, got ",
+                                operands.size()));
+
+    const auto& fns = Fns::Get();
+    for (int i = 0; i < op_names.size(); ++i) {
+      auto it = fns.find(op_names[i]);
+      OP_REQUIRES(context, it != fns.end(),
+                  errors::InvalidArgument(
+                      "Do not have a compute function registered for op: ",
+                      op_names[i]));
+      Step step;
+      step.reg = it->second;
+      step.x = operands[2 * i];
+      step.y = operands[2 * i + 1];
+      // Values [0, num_args) are the inputs of the op, and value num_args + j
+      // is the result of step j.
+      const int num_values = num_args_ + i;
+      OP_REQUIRES(
+          context, step.x >= 0 && step.x < num_values,
+          errors::InvalidArgument("Invalid operand ", step.x, " of op ", i));
+      if (step.reg.binary_fn != nullptr) {
+        OP_REQUIRES(
+            context, step.y >= 0 && step.y < num_values,
+            errors::InvalidArgument("Invalid operand ", step.y, " of op ", i));
+      } else {
+        OP_REQUIRES(context, step.y == -1,
+                    errors::InvalidArgument("Unary op ", op_names[i],
+                                            " must not have a second operand"));
+      }
+      cost_ += step.reg.cost;
+      steps_.push_back(step);
+    }
+
+    VLOG(2) << "Fused elementwise op: [" << absl::StrJoin(op_names, ", ")
+            << "]; operands=[" << absl::StrJoin(operands, ", ")
+            << "]; cost=" << cost_;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    // The fused ops only read their inputs, so the output has the broadcast
+    // shape of all inputs.
+    TensorShape output_shape;
+    OP_REQUIRES_OK(ctx, BroadcastShape(ctx, &output_shape));
+    const int64 num_elements = output_shape.num_elements();
+
+    // Classifies the inputs by how they map onto the output.
+    std::vector<Input> inputs(num_args_);
+    absl::InlinedVector<int, 4> forwardable;
+    const int rank = output_shape.dims();
+    for (int i = 0; i < num_args_; ++i) {
+      const Tensor& in = ctx->input(i);
+      Input& input = inputs[i];
+      input.data = in.flat<T>().data();
+      if (in.NumElements() == num_elements) {
+        input.kind = Input::kFull;
+        forwardable.push_back(i);
+      } else if (in.NumElements() == 1) {
+        input.kind = Input::kScalar;
+      } else {
+        input.kind = Input::kBroadcast;
+        input.strides.resize(rank, 0);
+        int64 stride = 1;
+        for (int d = in.dims() - 1; d >= 0; --d) {
+          if (in.dim_size(d) != 1) {
+            input.strides[rank - in.dims() + d] = stride;
+          }
+          stride *= in.dim_size(d);
+        }
+      }
+    }
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            forwardable, 0, output_shape, &out));
+    if (num_elements == 0) return;
+
+    std::vector<int64> dims(output_shape.dim_sizes().begin(),
+                            output_shape.dim_sizes().end());
+    T* out_data = out->flat<T>().data();
+
+    auto compute_fn = [this, &inputs, &dims, out_data](int64 begin,
+                                                       int64 end) {
+      ComputeRange(inputs, dims, begin, end, out_data);
+    };
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    const int kOverheadCycles = static_cast<int>(steps_.size()) * 10;
+    Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * num_args_,
+                             /*bytes_stored=*/sizeof(T),
+                             kOverheadCycles + cost_);
+    device.parallelFor(num_elements, cost, AlignBlockSize,
+                       std::move(compute_fn));
+  }
+
+ private:
+  using Packet = typename Eigen::internal::packet_traits<T>::type;
+  static constexpr int kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+
+  // Number of output elements that are computed at a time; all intermediate
+  // values of a tile have to fit in L1/L2.
+  static constexpr int kTileSize = 1024;
+
+  struct Step {
+    typename Fns::Registration reg;
+    int x;
+    int y;
+  };
+
+  struct Input {
+    enum Kind { kFull, kScalar, kBroadcast };
+    Kind kind;
+    const T* data;
+    // Strides of the input in each output dimension, 0 for the broadcast
+    // dimensions. Only set for `kBroadcast`.
+    std::vector<int64> strides;
+  };
+
+  static inline int64 AlignBlockSize(int64 block_size) {
+    if (block_size >= 16 * kPacketSize) {
+      return (block_size + 4 * kPacketSize - 1) & ~(4 * kPacketSize - 1);
+    }
+    return (block_size + kPacketSize - 1) & ~(kPacketSize - 1);
+  }
+
+  Status BroadcastShape(OpKernelContext* ctx, TensorShape* shape) const {
+    int rank = 0;
+    for (int i = 0; i < num_args_; ++i) {
+      rank = std::max(rank, ctx->input(i).dims());
+    }
+    std::vector<int64> dims(rank, 1);
+    for (int i = 0; i < num_args_; ++i) {
+      const TensorShape& in = ctx->input(i).shape();
+      for (int d = 0; d < in.dims(); ++d) {
+        int64& dim = dims[rank - in.dims() + d];
+        const int64 size = in.dim_size(d);
+        if (size == dim || size == 1) continue;
+        if (dim != 1) {
+          return errors::InvalidArgument(
+              "Incompatible shapes of the inputs of the fused elementwise op: ",
+              in.DebugString(), " at input ", i);
+        }
+        dim = size;
+      }
+    }
+    return TensorShapeUtils::MakeShape(dims, shape);
+  }
+
+  // Gathers the elements [begin, begin + len) of the broadcast `input`.
+  static void Gather(const Input& input, const std::vector<int64>& dims,
+                     int64 begin, int64 len, T* dst) {
+    const int rank = dims.size();
+    absl::InlinedVector<int64, 8> index(rank);
+    int64 offset = 0;
+    int64 rest = begin;
+    for (int d = rank - 1; d >= 0; --d) {
+      index[d] = rest % dims[d];
+      rest /= dims[d];
+      offset += index[d] * input.strides[d];
+    }
+    for (int64 i = 0; i < len; ++i) {
+      dst[i] = input.data[offset];
+      for (int d = rank - 1; d >= 0; --d) {
+        offset += input.strides[d];
+        if (++index[d] < dims[d]) break;
+        offset -= index[d] * input.strides[d];
+        index[d] = 0;
+      }
+    }
+  }
+
+  void ComputeRange(const std::vector<Input>& inputs,
+                    const std::vector<int64>& dims, int64 begin, int64 end,
+                    T* out_data) const {
+    const int num_steps = steps_.size();
+    const int64 tile_size =
+        std::min(static_cast<int64>(kTileSize), end - begin);
+    // One tile of scratch space for each non-full input and each
+    // intermediate step; the last step writes to the output directly.
+    absl::InlinedVector<int, 8> buffer_index(num_args_ + num_steps, -1);
+    int num_buffers = 0;
+    for (int i = 0; i < num_args_; ++i) {
+      if (inputs[i].kind != Input::kFull) buffer_index[i] = num_buffers++;
+    }
+    for (int j = 0; j + 1 < num_steps; ++j) {
+      buffer_index[num_args_ + j] = num_buffers++;
+    }
+    std::vector<T> scratch(num_buffers * tile_size);
+    auto buffer = [&](int value) {
+      return scratch.data() + buffer_index[value] * tile_size;
+    };
+    for (int i = 0; i < num_args_; ++i) {
+      if (inputs[i].kind == Input::kScalar) {
+        std::fill_n(buffer(i), tile_size, inputs[i].data[0]);
+      }
+    }
+
+    absl::InlinedVector<const T*, 8> values(num_args_ + num_steps);
+    for (int64 tile_begin = begin; tile_begin < end; tile_begin += tile_size) {
+      const int64 len = std::min(tile_size, end - tile_begin);
+      for (int i = 0; i < num_args_; ++i) {
+        switch (inputs[i].kind) {
+          case Input::kFull:
+            values[i] = inputs[i].data + tile_begin;
+            break;
+          case Input::kScalar:
+            values[i] = buffer(i);
+            break;
+          case Input::kBroadcast:
+            Gather(inputs[i], dims, tile_begin, len, buffer(i));
+            values[i] = buffer(i);
+            break;
+        }
+      }
+      for (int j = 0; j < num_steps; ++j) {
+        const Step& step = steps_[j];
+        T* dst = j + 1 < num_steps ? buffer(num_args_ + j)
+                                   : out_data + tile_begin;
+        OutputBuffer result(dst, len);
+        const InputBuffer x(values[step.x], len);
+        if (step.reg.binary_fn != nullptr) {
+          const InputBuffer y(values[step.y], len);
+          step.reg.binary_fn(x, y, &result);
+        } else {
+          step.reg.unary_fn(x, &result);
+        }
+        values[num_args_ + j] = dst;
+      }
+    }
+  }
+
+  int num_args_;
+  std::vector<Step> steps_;
+  int cost_ = 0;
+};
+
+#define REGISTER_CPU(T)                                                       \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"),    \
+      FusedElementwiseOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  Status MakeOp(int num_args, const std::vector<string>& op_names,
+                const std::vector<int>& operands) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+                           .Input(FakeInput(num_args, DataTypeToEnum<T>::v()))
+                           .Attr("T", DataTypeToEnum<T>::v())
+                           .Attr("num_args", num_args)
+                           .Attr("op_names", op_names)
+                           .Attr("operands", operands)
+                           .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, MulAddTanhMul) {
+  // y = tanh(x * a + b) * x
+  TF_ASSERT_OK(MakeOp<float>(3, {"Mul", "AddV2", "Tanh", "Mul"},
+                             {0, 1, 3, 2, 4, -1, 5, 0}));
+  const int kSize = 5000;
+  std::vector<float> x(kSize), a(kSize), b(kSize), expected(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    x[i] = 0.001f * i - 2.5f;
+    a[i] = 0.5f + 0.0001f * i;
+    b[i] = -0.25f;
+    expected[i] = std::tanh(x[i] * a[i] + b[i]) * x[i];
+  }
+  AddInputFromArray<float>(TensorShape({kSize}), x);
+  AddInputFromArray<float>(TensorShape({kSize}), a);
+  AddInputFromArray<float>(TensorShape({kSize}), b);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({kSize}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectClose(expected_tensor, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, Broadcasting) {
+  // y = relu((x - mean) * scale), with a per-column `mean` and a scalar
+  // `scale`.
+  TF_ASSERT_OK(
+      MakeOp<double>(3, {"Sub", "Mul", "Relu"}, {0, 1, 3, 2, 4, -1}));
+  AddInputFromArray<double>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<double>(TensorShape({1, 3}), {2, 2, 5});
+  AddInputFromArray<double>(TensorShape({}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_DOUBLE, TensorShape({2, 3}));
+  test::FillValues<double>(&expected, {0, 0, 0, 4, 6, 2});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, BroadcastsAllInputs) {
+  // y = x + z with x: [2, 1] and z: [3].
+  TF_ASSERT_OK(MakeOp<float>(2, {"Add"}, {0, 1}));
+  AddInputFromArray<float>(TensorShape({2, 1}), {10, 20});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {11, 12, 13, 21, 22, 23});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, IncompatibleShapes) {
+  TF_ASSERT_OK(MakeOp<float>(2, {"Add"}, {0, 1}));
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(FusedElementwiseOpTest, InvalidAttrs) {
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeOp<float>(1, {"MatMul"}, {0, 0})));
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeOp<float>(1, {"Exp"}, {0, 0})));
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeOp<float>(1, {"Add"}, {0, 1})));
+  EXPECT_TRUE(errors::IsInvalidArgument(MakeOp<float>(1, {"Exp"}, {0})));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <atomic>
 
 #include "tensorflow/core/framework/bounds_check.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/gather_nd_op.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
 
@@ -63,6 +65,14 @@ class GatherNdSliceGenerator {
     return out_of_bounds;
   }
 
+  // Prefetches the slice of `Tparams` selected by the indices at `loc`.
+  EIGEN_ALWAYS_INLINE void PrefetchSlice(const Index loc) const {
+    Eigen::array<Eigen::DenseIndex, IXDIM + 1> ix;
+    if (!GenerateIndices(loc, &ix)) {
+      port::prefetch<port::PREFETCH_HINT_T0>(&Tparams_(ix));
+    }
+  }
+
   EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE int32
   operator()(const Eigen::array<Eigen::DenseIndex, 1>& loc_array) const {
     const Index loc = loc_array[0];
@@ -106,7 +116,17 @@ struct GatherNdSlice<CPUDevice, T, Index, IXDIM> {
         slice_size, Tindices, Tparams, Tout, &error_loc);
 
     auto compute_shard = [&](Eigen::Index begin, Eigen::Index end) {
+      // Slices are read from random positions of `Tparams`, so prefetch the
+      // slices kPrefetchDistance positions ahead of the one being copied.
+      constexpr Eigen::Index kPrefetchDistance = 8;
+      for (Eigen::Index i = begin;
+           i < std::min<Eigen::Index>(end, begin + kPrefetchDistance); ++i) {
+        gather_nd_generator.PrefetchSlice(i);
+      }
       for (Eigen::Index i = begin; i < end; ++i) {
+        if (i + kPrefetchDistance < end) {
+          gather_nd_generator.PrefetchSlice(i + kPrefetchDistance);
+        }
         const Eigen::array<Eigen::Index, 1> loc{i};
         gather_nd_generator(loc);
       }
@@ -236,6 +236,7 @@ static Graph* Gather(int dim) {
       ->UseRealTime()                                                          \
       ->Arg(1)                                                                 \
       ->Arg(10)                                                                \
+      ->Arg(16)                                                                \
       ->Arg(20)                                                                \
       ->Arg(64)                                                                \
       ->Arg(100)                                                               \
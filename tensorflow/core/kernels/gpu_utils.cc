@@ -94,8 +94,6 @@ void CheckRedzones(const se::RedzoneAllocator& rz_allocator,
   }
 }
 
-namespace {
-
 tensorflow::CudnnVersion GetCudnnVersion(se::StreamExecutor* stream_executor) {
   tensorflow::CudnnVersion cudnn_version;
   if (auto* dnn = stream_executor->AsDnn()) {
@@ -121,8 +119,6 @@ tensorflow::ComputeCapability GetComputeCapability(
   return cc;
 }
 
-}  // namespace
-
 void LogConvAutotuneResults(se::dnn::ConvolutionKind kind,
                             se::dnn::DataType element_type,
                             se::DeviceMemoryBase input_buffer,
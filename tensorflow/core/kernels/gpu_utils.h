@@ -37,6 +37,8 @@ namespace tensorflow {
 
 class NodeDef;
 class AutotuneResult;
+class ComputeCapability;
+class CudnnVersion;
 
 // Return whether the redzone check is disabled.
 //
@@ -59,6 +61,13 @@ se::DeviceMemoryBase WrapRedzoneBestEffort(se::RedzoneAllocator* rz_allocator,
 void CheckRedzones(const se::RedzoneAllocator& rz_allocator,
                    AutotuneResult* autotune_result);
 
+// Returns the cuDNN version used by `stream_executor`, or all zeros if it has
+// no DNN support.
+CudnnVersion GetCudnnVersion(se::StreamExecutor* stream_executor);
+
+// Returns the CUDA compute capability of the device of `stream_executor`.
+ComputeCapability GetComputeCapability(se::StreamExecutor* stream_executor);
+
 template <typename T>
 inline se::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory, uint64 size) {
   se::DeviceMemoryBase wrapped(const_cast<T*>(cuda_memory), size * sizeof(T));
@@ -82,14 +91,36 @@ class AutoTuneMap {
   bool Find(const Parameters& params, Config* config) const {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
-    if (iter == params_config_map_.end() ||
-        (iter->second.score < min_score_threshold_ &&
-         iter->second.count <= max_autotune_count_)) {
+    if (iter == params_config_map_.end() || !IsAccepted(iter->second)) {
       return false;
     }
     *config = iter->second.config;
     return true;
   }
+
+  // Calls `fn(params, config)` for every entry that Find() would return.
+  template <typename Fn>
+  void ForEachAccepted(Fn fn) const {
+    mutex_lock lock(mu_);
+    for (const auto& entry : params_config_map_) {
+      if (IsAccepted(entry.second)) fn(entry.first, entry.second.config);
+    }
+  }
+
+  // Inserts a config that Find() returns right away, e.g. one measured by a
+  // previous process. Configs that have already been accepted are kept.
+  void InsertAccepted(const Parameters& params, const Config& config) {
+    mutex_lock lock(mu_);
+    auto iter = params_config_map_.find(params);
+    if (iter == params_config_map_.end()) {
+      VLOG(1) << GetActionSummary("loads", params, config);
+      params_config_map_.insert(
+          std::make_pair(params, ValueType{config, min_score_threshold_, 1}));
+    } else if (!IsAccepted(iter->second)) {
+      VLOG(1) << GetActionSummary("loads", params, config);
+      iter->second = ValueType{config, min_score_threshold_, 1};
+    }
+  }
   void Insert(const Parameters& params, const Config& config) {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
@@ -188,6 +219,12 @@ class AutoTuneMap {
     int32 score;
     int32 count;
   };
+
+  bool IsAccepted(const ValueType& value) const {
+    return value.score >= min_score_threshold_ ||
+           value.count > max_autotune_count_;
+  }
+
   std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
       TF_GUARDED_BY(mu_);
   std::string name_;
@@ -15,6 +15,7 @@ limitations under the License.
 
 // See docs in ../ops/image_ops.cc
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 
@@ -67,6 +68,21 @@ FileFormat ClassifyFileFormat(StringPiece data) {
   return kUnknownFormat;
 }
 
+// Returns the largest libjpeg downscaling denominator (8, 4, 2 or 1) at which a
+// `height` x `width` region still decodes to at least `target_height` x
+// `target_width` pixels. A target of 0 only requires a non-empty dimension.
+int ChooseJpegScaleRatio(int height, int width, int target_height,
+                         int target_width) {
+  target_height = std::max(target_height, 1);
+  target_width = std::max(target_width, 1);
+  for (const int ratio : {8, 4, 2}) {
+    if (height / ratio >= target_height && width / ratio >= target_width) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
 // Decode an image. Supported image formats are JPEG, PNG, GIF and BMP. This is
 // a newer version of `DecodeImageOp` for enabling image data parsing to take
 // place in kernels only, reducing security vulnerabilities and redundancy.
@@ -98,6 +114,19 @@ class DecodeImageV2Op : public OpKernel {
                       flags_.ratio == 8,
                   errors::InvalidArgument("ratio must be 1, 2, 4, or 8, got ",
                                           flags_.ratio));
+      OP_REQUIRES_OK(context,
+                     context->GetAttr("target_height", &target_height_));
+      OP_REQUIRES_OK(context, context->GetAttr("target_width", &target_width_));
+      OP_REQUIRES(context, target_height_ >= 0 && target_width_ >= 0,
+                  errors::InvalidArgument(
+                      "target_height and target_width must be non-negative, "
+                      "got ",
+                      target_height_, " and ", target_width_));
+      OP_REQUIRES(
+          context,
+          flags_.ratio == 1 || (target_height_ == 0 && target_width_ == 0),
+          errors::InvalidArgument("ratio cannot be combined with "
+                                  "target_height or target_width"));
       OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
                                                &flags_.fancy_upscaling));
       OP_REQUIRES_OK(context,
@@ -242,6 +271,9 @@ class DecodeImageV2Op : public OpKernel {
       flags.crop_x = crop_window_vec(1);
       flags.crop_height = crop_window_vec(2);
       flags.crop_width = crop_window_vec(3);
+      if (target_height_ > 0 || target_width_ > 0) {
+        SetScaledCropWindow(input, &flags);
+      }
     } else if (op_type_ == "DecodeBmp") {
       // TODO(b/171060723): Only DecodeBmp as op_type_ is not acceptable here
       // because currently `decode_(jpeg|png|gif)` ops can decode any one of
@@ -252,6 +284,15 @@ class DecodeImageV2Op : public OpKernel {
                   errors::InvalidArgument(
                       "Trying to decode JPEG format using DecodeBmp op. Use "
                       "`decode_jpeg` or `decode_image` instead."));
+    } else if (target_height_ > 0 || target_width_ > 0) {
+      int height = 0;
+      int width = 0;
+      // On a bad header keep ratio 1 and let Uncompress report the error.
+      if (jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                             nullptr)) {
+        flags.ratio = ChooseJpegScaleRatio(height, width, target_height_,
+                                           target_width_);
+      }
     }
 
     // Output tensor and the image buffer size.
@@ -651,6 +692,34 @@ class DecodeImageV2Op : public OpKernel {
   }
 
  private:
+  // Picks the downscaling ratio of `flags` from the crop window, given in
+  // full-resolution coordinates, and maps the window to the scaled image that
+  // libjpeg will produce. Invalid windows are left untouched so that
+  // Uncompress rejects them.
+  void SetScaledCropWindow(StringPiece input, jpeg::UncompressFlags* flags) {
+    int height = 0;
+    int width = 0;
+    if (!jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                            nullptr)) {
+      return;
+    }
+    if (flags->crop_width <= 0 || flags->crop_height <= 0 ||
+        flags->crop_x < 0 || flags->crop_y < 0 ||
+        flags->crop_y + flags->crop_height > height ||
+        flags->crop_x + flags->crop_width > width) {
+      return;
+    }
+    const int ratio = ChooseJpegScaleRatio(
+        flags->crop_height, flags->crop_width, target_height_, target_width_);
+    // The scaled image is ceil(height / ratio) x ceil(width / ratio), so the
+    // rounded-down window stays inside it.
+    flags->ratio = ratio;
+    flags->crop_y /= ratio;
+    flags->crop_x /= ratio;
+    flags->crop_height /= ratio;
+    flags->crop_width /= ratio;
+  }
+
   void DecodeBMP(const uint8* input, const int row_size, uint8* const output,
                  const int width, const int height, const int output_channels,
                  const int input_channels, bool top_down);
@@ -659,6 +728,9 @@ class DecodeImageV2Op : public OpKernel {
   DataType data_type_ = DataType::DT_UINT8;
   bool expand_animations_ = true;
   jpeg::UncompressFlags flags_;
+  // Minimum output size used to pick the JPEG downscaling ratio; 0 disables.
+  int target_height_ = 0;
+  int target_width_ = 0;
   string op_type_;
 };
 
@@ -27,6 +27,8 @@ limitations under the License.
 #endif
 
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -105,6 +107,34 @@ inline void compute_interpolation_weights(const Scaler scaler,
   }
 }
 
+// Computes the cached interpolation weights on the x and y dimensions of an
+// image. The x indices are scaled by `channels` to avoid a multiplication
+// during iteration.
+inline void compute_image_interpolation_weights(
+    const int64 in_height, const int64 in_width, const int64 out_height,
+    const int64 out_width, const int channels, const float height_scale,
+    const float width_scale, const bool half_pixel_centers,
+    std::vector<CachedInterpolation>* xs,
+    std::vector<CachedInterpolation>* ys) {
+  ys->resize(out_height + 1);
+  xs->resize(out_width + 1);
+  if (half_pixel_centers) {
+    compute_interpolation_weights(HalfPixelScaler(), out_height, in_height,
+                                  height_scale, ys->data());
+    compute_interpolation_weights(HalfPixelScaler(), out_width, in_width,
+                                  width_scale, xs->data());
+  } else {
+    compute_interpolation_weights(LegacyScaler(), out_height, in_height,
+                                  height_scale, ys->data());
+    compute_interpolation_weights(LegacyScaler(), out_width, in_width,
+                                  width_scale, xs->data());
+  }
+  for (CachedInterpolation& x : *xs) {
+    x.lower *= channels;
+    x.upper *= channels;
+  }
+}
+
 /**
  * Computes the bilinear interpolation from the appropriate 4 float points
  * and the linear interpolation weights.
@@ -302,33 +332,148 @@ struct ResizeBilinear<CPUDevice, T> {
       return;
     }
 
-    std::vector<CachedInterpolation> ys(out_height + 1);
-    std::vector<CachedInterpolation> xs(out_width + 1);
+    std::vector<CachedInterpolation> ys;
+    std::vector<CachedInterpolation> xs;
+    compute_image_interpolation_weights(
+        in_height, in_width, out_height, out_width, channels, height_scale,
+        width_scale, half_pixel_centers, &xs, &ys);
 
-    // Compute the cached interpolation weights on the x and y dimensions.
-    if (half_pixel_centers) {
-      compute_interpolation_weights(HalfPixelScaler(), out_height, in_height,
-                                    height_scale, ys.data());
-      compute_interpolation_weights(HalfPixelScaler(), out_width, in_width,
-                                    width_scale, xs.data());
+    resize_image<T>(images, batch_size, in_height, in_width, out_height,
+                    out_width, channels, xs, ys, output);
+  }
+};
+}  // namespace functor
 
-    } else {
-      compute_interpolation_weights(LegacyScaler(), out_height, in_height,
-                                    height_scale, ys.data());
-      compute_interpolation_weights(LegacyScaler(), out_width, in_width,
-                                    width_scale, xs.data());
+namespace {
+// Returns the buffer a row of interpolated values is written to before it is
+// normalized: the output row itself for float outputs, `buffer` otherwise.
+inline float* InterpolationRow(float* output_row, std::vector<float>* buffer) {
+  return output_row;
+}
+
+template <typename OutT>
+inline float* InterpolationRow(OutT* output_row, std::vector<float>* buffer) {
+  return buffer->data();
+}
+}  // namespace
+
+// Computes `(ResizeBilinear(images, size) - offset) * scale` cast to OutT,
+// where offset and scale hold either one value or one value per channel. The
+// remapper creates this op from the equivalent chain of ops, so that image
+// preprocessing makes a single pass over the output instead of materializing
+// the float resize result, the difference and the product. Output rows are
+// interpolated and normalized while they are in cache, and sharded across
+// the intra-op thread pool.
+template <typename T, typename OutT>
+class FusedResizeBilinearNormalizeOp : public OpKernel {
+ public:
+  explicit FusedResizeBilinearNormalizeOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+    OP_REQUIRES_OK(
+        context, context->GetAttr("half_pixel_centers", &half_pixel_centers_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    ImageResizerState st(align_corners_, half_pixel_centers_);
+    st.ValidateAndCalculateOutputSize(context);
+    if (!context->status().ok()) return;
+
+    const int channels = st.channels;
+    const Tensor& offset = context->input(2);
+    const Tensor& scale = context->input(3);
+    for (const Tensor* t : {&offset, &scale}) {
+      OP_REQUIRES(context,
+                  TensorShapeUtils::IsScalar(t->shape()) ||
+                      (TensorShapeUtils::IsVector(t->shape()) &&
+                       (t->NumElements() == 1 || t->NumElements() == channels)),
+                  errors::InvalidArgument(
+                      "offset and scale must be scalars or vectors of length ",
+                      channels, ", got shapes ", offset.shape().DebugString(),
+                      " and ", scale.shape().DebugString()));
     }
-    // Scale x interpolation weights to avoid a multiplication during iteration.
-    for (int i = 0; i < xs.size(); ++i) {
-      xs[i].lower *= channels;
-      xs[i].upper *= channels;
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                TensorShape({st.batch_size, st.out_height,
+                                             st.out_width, channels}),
+                                &output));
+    if (output->NumElements() == 0) return;
+
+    const int64 in_row_size = st.in_width * channels;
+    const int64 in_batch_num_values = st.in_height * in_row_size;
+    const int64 out_height = st.out_height;
+    const int64 out_width = st.out_width;
+    const int64 out_row_size = out_width * channels;
+
+    // Offset and scale tiled over an output row, so that each row is
+    // normalized with element-wise vector operations.
+    Eigen::ArrayXf row_offset(out_row_size);
+    Eigen::ArrayXf row_scale(out_row_size);
+    const auto offset_flat = offset.flat<float>();
+    const auto scale_flat = scale.flat<float>();
+    for (int64 i = 0; i < out_row_size; ++i) {
+      const int c = i % channels;
+      row_offset[i] = offset_flat(offset_flat.size() == 1 ? 0 : c);
+      row_scale[i] = scale_flat(scale_flat.size() == 1 ? 0 : c);
     }
 
-    resize_image<T>(images, batch_size, in_height, in_width, out_height,
-                    out_width, channels, xs, ys, output);
+    std::vector<CachedInterpolation> xs_vec;
+    std::vector<CachedInterpolation> ys;
+    compute_image_interpolation_weights(
+        st.in_height, st.in_width, out_height, out_width, channels,
+        st.height_scale, st.width_scale, half_pixel_centers_, &xs_vec, &ys);
+    const CachedInterpolation* xs = xs_vec.data();
+
+    const T* images = context->input(0).flat<T>().data();
+    OutT* output_data = output->flat<OutT>().data();
+
+    auto resize_rows = [&](int64 start, int64 limit) {
+      std::vector<float> row_buffer;
+      if (!std::is_same<OutT, float>::value) row_buffer.resize(out_row_size);
+      for (int64 row = start; row < limit; ++row) {
+        const int64 b = row / out_height;
+        const int64 y = row % out_height;
+        const T* input_b_ptr = images + b * in_batch_num_values;
+        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
+        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
+        OutT* output_row = output_data + row * out_row_size;
+        float* interpolated = InterpolationRow(output_row, &row_buffer);
+
+        if (channels == 3) {
+#ifdef __SSE4_1__
+          ResizeLine3ChannelsVector(ys_input_lower_ptr, ys_input_upper_ptr, xs,
+                                    ys[y].lerp, out_width, interpolated);
+#else
+          ResizeLineChannels(ys_input_lower_ptr, ys_input_upper_ptr, xs,
+                             ys[y].lerp, out_width, interpolated, 3);
+#endif
+        } else {
+          ResizeLineChannels(ys_input_lower_ptr, ys_input_upper_ptr, xs,
+                             ys[y].lerp, out_width, interpolated, channels);
+        }
+
+        Eigen::Map<const Eigen::ArrayXf> in(interpolated, out_row_size);
+        Eigen::Map<Eigen::Array<OutT, Eigen::Dynamic, 1>> out(output_row,
+                                                              out_row_size);
+        out = ((in - row_offset) * row_scale).template cast<OutT>();
+      }
+    };
+
+    // Each row reads two input rows and computes a bilinear interpolation
+    // followed by a subtraction and a multiplication per output value.
+    const Eigen::TensorOpCost cost(2 * in_row_size * sizeof(T),
+                                   out_row_size * sizeof(OutT),
+                                   out_row_size * 10);
+    context->eigen_device<CPUDevice>().parallelFor(st.batch_size * out_height,
+                                                   cost, resize_rows);
   }
+
+ private:
+  bool align_corners_;
+  bool half_pixel_centers_;
 };
-}  // namespace functor
 
 template <typename Device, typename T>
 class ResizeBilinearOpGrad : public OpKernel {
@@ -473,6 +618,24 @@ TF_CALL_REAL_NUMBER_TYPES(REGISTER_KERNEL);
 
 #undef REGISTER_KERNEL
 
+#define REGISTER_KERNEL(T)                                                 \
+  REGISTER_KERNEL_BUILDER(Name("_FusedResizeBilinearNormalize")            \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("T")                      \
+                              .TypeConstraint<float>("out_type")           \
+                              .HostMemory("size"),                         \
+                          FusedResizeBilinearNormalizeOp<T, float>);       \
+  REGISTER_KERNEL_BUILDER(Name("_FusedResizeBilinearNormalize")            \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("T")                      \
+                              .TypeConstraint<bfloat16>("out_type")        \
+                              .HostMemory("size"),                         \
+                          FusedResizeBilinearNormalizeOp<T, bfloat16>);
+
+TF_CALL_REAL_NUMBER_TYPES(REGISTER_KERNEL);
+
+#undef REGISTER_KERNEL
+
 #define REGISTER_GRAD_KERNEL(T)                                             \
   REGISTER_KERNEL_BUILDER(                                                  \
       Name("ResizeBilinearGrad").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
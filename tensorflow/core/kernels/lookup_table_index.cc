@@ -0,0 +1,357 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/lookup_table_index.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/byte_order.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/random.h"
+
+namespace tensorflow {
+namespace lookup {
+
+constexpr char LookupTableIndex::kMagic[8];
+constexpr uint32 LookupTableIndex::kVersion;
+constexpr uint64 LookupTableIndex::kHeaderSize;
+constexpr uint64 LookupTableIndex::kOccupiedBit;
+
+namespace {
+
+using Slot = LookupTableIndex::Slot;
+
+struct Header {
+  char magic[8];
+  uint32 version;
+  uint32 key_dtype;
+  uint32 value_dtype;
+  uint32 reserved0;
+  uint64 num_entries;
+  uint64 num_slots;
+  uint64 arena_size;
+  uint64 reserved1[2];
+};
+static_assert(sizeof(Header) == LookupTableIndex::kHeaderSize,
+              "Header must be kHeaderSize bytes");
+
+bool IsSupportedDtype(DataType dtype) {
+  return dtype == DT_INT64 || dtype == DT_STRING;
+}
+
+uint64 HashKey(int64 key) {
+  return Hash64(reinterpret_cast<const char*>(&key), sizeof(key)) |
+         LookupTableIndex::kOccupiedBit;
+}
+
+uint64 HashKey(StringPiece key) {
+  return Hash64(key.data(), key.size()) | LookupTableIndex::kOccupiedBit;
+}
+
+// Helpers used by the writer to store keys and values into a slot. Strings are
+// appended to `arena` and referenced by (offset, size).
+Status StoreString(StringPiece s, string* arena, uint64* offset,
+                   uint32* size) {
+  if (s.size() > kuint32max) {
+    return errors::InvalidArgument("Strings longer than ", kuint32max,
+                                   " bytes are not supported in a lookup ",
+                                   "table index");
+  }
+  *offset = arena->size();
+  *size = static_cast<uint32>(s.size());
+  arena->append(s.data(), s.size());
+  return Status::OK();
+}
+
+Status StoreKey(int64 key, Slot* slot, string* arena) {
+  slot->key = static_cast<uint64>(key);
+  slot->key_size = 0;
+  return Status::OK();
+}
+
+Status StoreKey(const tstring& key, Slot* slot, string* arena) {
+  return StoreString(key, arena, &slot->key, &slot->key_size);
+}
+
+Status StoreValue(int64 value, Slot* slot, string* arena) {
+  slot->value = static_cast<uint64>(value);
+  slot->value_size = 0;
+  return Status::OK();
+}
+
+Status StoreValue(const tstring& value, Slot* slot, string* arena) {
+  return StoreString(value, arena, &slot->value, &slot->value_size);
+}
+
+bool KeyEquals(const Slot& slot, int64 key, const string& arena) {
+  return slot.key == static_cast<uint64>(key);
+}
+
+bool KeyEquals(const Slot& slot, const tstring& key, const string& arena) {
+  return StringPiece(arena.data() + slot.key, slot.key_size) ==
+         StringPiece(key);
+}
+
+bool ValueEquals(const Slot& slot, int64 value, const string& arena) {
+  return slot.value == static_cast<uint64>(value);
+}
+
+bool ValueEquals(const Slot& slot, const tstring& value, const string& arena) {
+  return StringPiece(arena.data() + slot.value, slot.value_size) ==
+         StringPiece(value);
+}
+
+uint64 NumSlotsFor(uint64 num_entries) {
+  // Keep the load factor at or below 0.5 so that probe sequences stay short.
+  uint64 num_slots = 2;
+  while (num_slots < 2 * num_entries) num_slots <<= 1;
+  return num_slots;
+}
+
+template <typename K, typename V>
+Status BuildIndex(const Tensor& keys, const Tensor& values,
+                  std::vector<Slot>* slots, string* arena,
+                  uint64* num_entries) {
+  const auto key_values = keys.flat<K>();
+  const auto value_values = values.flat<V>();
+  const uint64 num_slots = NumSlotsFor(key_values.size());
+  const uint64 mask = num_slots - 1;
+  slots->assign(num_slots, Slot());
+  *num_entries = 0;
+  for (int64 i = 0; i < key_values.size(); ++i) {
+    const K& key = key_values(i);
+    const V& value = value_values(i);
+    const uint64 hash = HashKey(key);
+    uint64 pos = hash & mask;
+    while (true) {
+      Slot& slot = (*slots)[pos];
+      if (!LookupTableIndex::IsOccupied(slot)) {
+        slot.hash = hash;
+        TF_RETURN_IF_ERROR(StoreKey(key, &slot, arena));
+        TF_RETURN_IF_ERROR(StoreValue(value, &slot, arena));
+        ++*num_entries;
+        break;
+      }
+      if (slot.hash == hash && KeyEquals(slot, key, *arena)) {
+        if (!ValueEquals(slot, value, *arena)) {
+          return errors::InvalidArgument(
+              "Duplicate key with different values while building lookup ",
+              "table index: ", key);
+        }
+        break;
+      }
+      pos = (pos + 1) & mask;
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status LookupTableIndex::Write(Env* env, const string& filename,
+                               const Tensor& keys, const Tensor& values) {
+  if (!port::kLittleEndian) {
+    return errors::Unimplemented(
+        "Lookup table indices are only supported on little-endian hosts");
+  }
+  if (!IsSupportedDtype(keys.dtype()) || !IsSupportedDtype(values.dtype())) {
+    return errors::InvalidArgument(
+        "Lookup table indices support int64 and string keys and values, got ",
+        DataTypeString(keys.dtype()), " -> ", DataTypeString(values.dtype()));
+  }
+  if (keys.dims() != 1 || values.dims() != 1 ||
+      keys.NumElements() != values.NumElements()) {
+    return errors::InvalidArgument(
+        "Keys and values must be vectors of the same size, got shapes ",
+        keys.shape().DebugString(), " and ", values.shape().DebugString());
+  }
+
+  std::vector<Slot> slots;
+  string arena;
+  uint64 num_entries;
+  if (keys.dtype() == DT_INT64 && values.dtype() == DT_INT64) {
+    TF_RETURN_IF_ERROR((BuildIndex<int64, int64>(keys, values, &slots, &arena,
+                                                 &num_entries)));
+  } else if (keys.dtype() == DT_INT64) {
+    TF_RETURN_IF_ERROR((BuildIndex<int64, tstring>(keys, values, &slots,
+                                                   &arena, &num_entries)));
+  } else if (values.dtype() == DT_INT64) {
+    TF_RETURN_IF_ERROR((BuildIndex<tstring, int64>(keys, values, &slots,
+                                                   &arena, &num_entries)));
+  } else {
+    TF_RETURN_IF_ERROR((BuildIndex<tstring, tstring>(keys, values, &slots,
+                                                     &arena, &num_entries)));
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.key_dtype = keys.dtype();
+  header.value_dtype = values.dtype();
+  header.num_entries = num_entries;
+  header.num_slots = slots.size();
+  header.arena_size = arena.size();
+
+  const string tmp_filename =
+      strings::StrCat(filename, ".tmp-", random::New64());
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_filename, &file));
+  Status s = file->Append(
+      StringPiece(reinterpret_cast<const char*>(&header), sizeof(header)));
+  if (s.ok()) {
+    s = file->Append(StringPiece(reinterpret_cast<const char*>(slots.data()),
+                                 slots.size() * sizeof(Slot)));
+  }
+  if (s.ok()) s = file->Append(arena);
+  if (s.ok()) s = file->Close();
+  if (s.ok()) s = env->RenameFile(tmp_filename, filename);
+  if (!s.ok()) {
+    env->DeleteFile(tmp_filename).IgnoreError();
+  }
+  return s;
+}
+
+Status LookupTableIndex::Open(Env* env, const string& filename,
+                              DataType key_dtype, DataType value_dtype,
+                              std::unique_ptr<LookupTableIndex>* index) {
+  if (!port::kLittleEndian) {
+    return errors::Unimplemented(
+        "Lookup table indices are only supported on little-endian hosts");
+  }
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(filename, &region));
+  const uint64 length = region->length();
+  if (length < kHeaderSize) {
+    return errors::DataLoss("Lookup table index ", filename,
+                            " is too short: ", length, " bytes");
+  }
+  Header header;
+  memcpy(&header, region->data(), sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return errors::DataLoss(filename, " is not a lookup table index");
+  }
+  if (header.version != kVersion) {
+    return errors::FailedPrecondition("Unsupported lookup table index version ",
+                                      header.version, " in ", filename);
+  }
+  if (static_cast<DataType>(header.key_dtype) != key_dtype ||
+      static_cast<DataType>(header.value_dtype) != value_dtype) {
+    return errors::InvalidArgument(
+        "Lookup table index ", filename, " maps ",
+        DataTypeString(static_cast<DataType>(header.key_dtype)), " -> ",
+        DataTypeString(static_cast<DataType>(header.value_dtype)),
+        " but the table expects ", DataTypeString(key_dtype), " -> ",
+        DataTypeString(value_dtype));
+  }
+  const uint64 num_slots = header.num_slots;
+  if (num_slots == 0 || (num_slots & (num_slots - 1)) != 0 ||
+      header.num_entries >= num_slots ||
+      num_slots > (length - kHeaderSize) / sizeof(Slot) ||
+      header.arena_size > length ||
+      length != kHeaderSize + num_slots * sizeof(Slot) + header.arena_size) {
+    return errors::DataLoss("Lookup table index ", filename,
+                            " has an inconsistent header");
+  }
+  if (reinterpret_cast<uintptr_t>(region->data()) % alignof(Slot) != 0) {
+    return errors::Unimplemented(
+        "The file system returned an unaligned memory region for ", filename);
+  }
+  index->reset(new LookupTableIndex(std::move(region), key_dtype,
+                                    header.num_entries, num_slots,
+                                    header.arena_size));
+  return Status::OK();
+}
+
+LookupTableIndex::LookupTableIndex(std::unique_ptr<ReadOnlyMemoryRegion> region,
+                                   DataType key_dtype, uint64 num_entries,
+                                   uint64 num_slots, uint64 arena_size)
+    : region_(std::move(region)),
+      key_dtype_(key_dtype),
+      num_entries_(num_entries),
+      num_slots_(num_slots),
+      arena_size_(arena_size) {
+  const char* data = static_cast<const char*>(region_->data());
+  slots_ = reinterpret_cast<const Slot*>(data + kHeaderSize);
+  arena_ = data + kHeaderSize + num_slots_ * sizeof(Slot);
+}
+
+template <typename KeyEqual>
+const LookupTableIndex::Slot* LookupTableIndex::Probe(
+    uint64 hash, KeyEqual key_equal) const {
+  const uint64 mask = num_slots_ - 1;
+  uint64 pos = hash & mask;
+  // Bounded by num_slots_ so that a corrupted, fully occupied index cannot
+  // loop forever.
+  for (uint64 i = 0; i < num_slots_; ++i) {
+    const Slot& slot = slots_[pos];
+    if (!IsOccupied(slot)) return nullptr;
+    if (slot.hash == hash && key_equal(slot)) return &slot;
+    pos = (pos + 1) & mask;
+  }
+  return nullptr;
+}
+
+const LookupTableIndex::Slot* LookupTableIndex::Find(int64 key) const {
+  DCHECK_EQ(key_dtype_, DT_INT64);
+  return Probe(HashKey(key), [key](const Slot& slot) {
+    return slot.key == static_cast<uint64>(key);
+  });
+}
+
+const LookupTableIndex::Slot* LookupTableIndex::Find(StringPiece key) const {
+  DCHECK_EQ(key_dtype_, DT_STRING);
+  return Probe(HashKey(key), [this, key](const Slot& slot) {
+    return slot.key_size == key.size() && slot.key <= arena_size_ &&
+           slot.key_size <= arena_size_ - slot.key &&
+           memcmp(arena_ + slot.key, key.data(), key.size()) == 0;
+  });
+}
+
+Status LookupTableIndex::GetArenaString(uint64 offset, uint32 size,
+                                        tstring* out) const {
+  if (offset > arena_size_ || size > arena_size_ - offset) {
+    return errors::DataLoss("Lookup table index string [", offset, ", ",
+                            offset + size, ") is outside of the arena of ",
+                            arena_size_, " bytes");
+  }
+  out->assign(arena_ + offset, size);
+  return Status::OK();
+}
+
+Status LookupTableIndex::GetValue(const Slot& slot, int64* value) const {
+  *value = static_cast<int64>(slot.value);
+  return Status::OK();
+}
+
+Status LookupTableIndex::GetValue(const Slot& slot, tstring* value) const {
+  return GetArenaString(slot.value, slot.value_size, value);
+}
+
+Status LookupTableIndex::GetKey(const Slot& slot, int64* key) const {
+  *key = static_cast<int64>(slot.key);
+  return Status::OK();
+}
+
+Status LookupTableIndex::GetKey(const Slot& slot, tstring* key) const {
+  return GetArenaString(slot.key, slot.key_size, key);
+}
+
+}  // namespace lookup
+}  // namespace tensorflow
@@ -0,0 +1,126 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_LOOKUP_TABLE_INDEX_H_
+#define TENSORFLOW_CORE_KERNELS_LOOKUP_TABLE_INDEX_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A prebuilt, immutable hash index for lookup tables that is read through
+// Env::NewReadOnlyMemoryRegionFromFile. Opening an index is O(1): lookups probe
+// the mapped file directly, so the working set is paged in on demand and the
+// pages are shared by every process that maps the same file.
+//
+// File layout (all integers little-endian):
+//
+//   Header (64 bytes): magic "TFLUIDX1", version, key_dtype, value_dtype,
+//                      num_entries, num_slots, arena_size.
+//   Slots:             num_slots * 32 bytes, open addressing with linear
+//                      probing. num_slots is a power of two and at least twice
+//                      num_entries.
+//   Arena:             arena_size bytes holding string keys and values.
+//
+// Each slot stores the 64-bit hash of its key with the top bit set to mark it
+// occupied. int64 keys and values are stored inline; string keys and values
+// are stored as (offset, size) pairs into the arena.
+//
+// Supported key types are DT_INT64 and DT_STRING; supported value types are
+// DT_INT64 and DT_STRING.
+class LookupTableIndex {
+ public:
+  struct Slot {
+    uint64 hash;
+    uint64 key;
+    uint64 value;
+    uint32 key_size;
+    uint32 value_size;
+  };
+  static_assert(sizeof(Slot) == 32, "Slot must be 32 bytes");
+
+  // Builds an index from the rank-1 `keys` and `values` tensors and writes it
+  // to `filename`. The file is written under a temporary name and renamed into
+  // place, so concurrent readers never observe a partially written index.
+  // Returns InvalidArgument if a key is mapped to two different values.
+  static Status Write(Env* env, const string& filename, const Tensor& keys,
+                      const Tensor& values);
+
+  // Maps the index stored in `filename` and validates its header against the
+  // expected key and value types.
+  static Status Open(Env* env, const string& filename, DataType key_dtype,
+                     DataType value_dtype,
+                     std::unique_ptr<LookupTableIndex>* index);
+
+  // Returns the slot holding `key`, or nullptr if the key is absent.
+  const Slot* Find(int64 key) const;
+  const Slot* Find(StringPiece key) const;
+
+  // Returns the value stored in `slot`. Returns DataLoss if a string value
+  // points outside of the arena.
+  Status GetValue(const Slot& slot, int64* value) const;
+  Status GetValue(const Slot& slot, tstring* value) const;
+
+  // Returns the key stored in `slot`, for export.
+  Status GetKey(const Slot& slot, int64* key) const;
+  Status GetKey(const Slot& slot, tstring* key) const;
+
+  // Returns all slots, including empty ones; see IsOccupied().
+  const Slot* slots() const { return slots_; }
+  uint64 num_slots() const { return num_slots_; }
+  uint64 num_entries() const { return num_entries_; }
+  uint64 mapped_bytes() const { return region_->length(); }
+
+  static bool IsOccupied(const Slot& slot) { return slot.hash & kOccupiedBit; }
+
+  static constexpr char kMagic[8] = {'T', 'F', 'L', 'U', 'I', 'D', 'X', '1'};
+  static constexpr uint32 kVersion = 1;
+  static constexpr uint64 kHeaderSize = 64;
+  static constexpr uint64 kOccupiedBit = 1ULL << 63;
+
+ private:
+  LookupTableIndex(std::unique_ptr<ReadOnlyMemoryRegion> region,
+                   DataType key_dtype, uint64 num_entries, uint64 num_slots,
+                   uint64 arena_size);
+
+  template <typename KeyEqual>
+  const Slot* Probe(uint64 hash, KeyEqual key_equal) const;
+  Status GetArenaString(uint64 offset, uint32 size, tstring* out) const;
+
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const DataType key_dtype_;
+  const uint64 num_entries_;
+  const uint64 num_slots_;
+  const uint64 arena_size_;
+  const Slot* slots_;
+  const char* arena_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LookupTableIndex);
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_LOOKUP_TABLE_INDEX_H_
@@ -0,0 +1,150 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/lookup_table_index.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+string IndexPath(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+TEST(LookupTableIndexTest, Int64ToInt64) {
+  const int64 kNumKeys = 1000;
+  Tensor keys(DT_INT64, TensorShape({kNumKeys}));
+  Tensor values(DT_INT64, TensorShape({kNumKeys}));
+  for (int64 i = 0; i < kNumKeys; ++i) {
+    keys.flat<int64>()(i) = 3 * i - 500;
+    values.flat<int64>()(i) = i;
+  }
+  const string path = IndexPath("int64_to_int64.idx");
+  TF_ASSERT_OK(LookupTableIndex::Write(Env::Default(), path, keys, values));
+
+  std::unique_ptr<LookupTableIndex> index;
+  TF_ASSERT_OK(LookupTableIndex::Open(Env::Default(), path, DT_INT64,
+                                      DT_INT64, &index));
+  EXPECT_EQ(kNumKeys, index->num_entries());
+  EXPECT_GE(index->num_slots(), 2 * kNumKeys);
+  for (int64 i = 0; i < kNumKeys; ++i) {
+    const LookupTableIndex::Slot* slot = index->Find(3 * i - 500);
+    ASSERT_NE(nullptr, slot);
+    int64 value;
+    TF_ASSERT_OK(index->GetValue(*slot, &value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_EQ(nullptr, index->Find(int64{-499}));
+  EXPECT_EQ(nullptr, index->Find(int64{1000000}));
+}
+
+TEST(LookupTableIndexTest, StringToString) {
+  Tensor keys = test::AsTensor<tstring>({"apple", "", "banana", "cherry"});
+  Tensor values = test::AsTensor<tstring>({"red", "empty", "yellow", ""});
+  const string path = IndexPath("string_to_string.idx");
+  TF_ASSERT_OK(LookupTableIndex::Write(Env::Default(), path, keys, values));
+
+  std::unique_ptr<LookupTableIndex> index;
+  TF_ASSERT_OK(LookupTableIndex::Open(Env::Default(), path, DT_STRING,
+                                      DT_STRING, &index));
+  EXPECT_EQ(4, index->num_entries());
+  for (int i = 0; i < 4; ++i) {
+    const tstring& key = keys.flat<tstring>()(i);
+    const LookupTableIndex::Slot* slot =
+        index->Find(StringPiece(key.data(), key.size()));
+    ASSERT_NE(nullptr, slot) << key;
+    tstring value;
+    TF_ASSERT_OK(index->GetValue(*slot, &value));
+    EXPECT_EQ(values.flat<tstring>()(i), value);
+    tstring stored_key;
+    TF_ASSERT_OK(index->GetKey(*slot, &stored_key));
+    EXPECT_EQ(key, stored_key);
+  }
+  EXPECT_EQ(nullptr, index->Find(StringPiece("durian")));
+}
+
+TEST(LookupTableIndexTest, DuplicateKeys) {
+  const string path = IndexPath("duplicates.idx");
+  TF_EXPECT_OK(LookupTableIndex::Write(Env::Default(), path,
+                                       test::AsTensor<int64>({1, 2, 1}),
+                                       test::AsTensor<int64>({10, 20, 10})));
+  std::unique_ptr<LookupTableIndex> index;
+  TF_ASSERT_OK(LookupTableIndex::Open(Env::Default(), path, DT_INT64,
+                                      DT_INT64, &index));
+  EXPECT_EQ(2, index->num_entries());
+
+  Status s = LookupTableIndex::Write(Env::Default(), path,
+                                     test::AsTensor<int64>({1, 2, 1}),
+                                     test::AsTensor<int64>({10, 20, 30}));
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST(LookupTableIndexTest, EmptyIndex) {
+  const string path = IndexPath("empty.idx");
+  TF_ASSERT_OK(LookupTableIndex::Write(
+      Env::Default(), path, Tensor(DT_STRING, TensorShape({0})),
+      Tensor(DT_INT64, TensorShape({0}))));
+  std::unique_ptr<LookupTableIndex> index;
+  TF_ASSERT_OK(LookupTableIndex::Open(Env::Default(), path, DT_STRING,
+                                      DT_INT64, &index));
+  EXPECT_EQ(0, index->num_entries());
+  EXPECT_EQ(nullptr, index->Find(StringPiece("a")));
+}
+
+TEST(LookupTableIndexTest, OpenRejectsMismatchedTypes) {
+  const string path = IndexPath("types.idx");
+  TF_ASSERT_OK(LookupTableIndex::Write(Env::Default(), path,
+                                       test::AsTensor<int64>({1}),
+                                       test::AsTensor<int64>({2})));
+  std::unique_ptr<LookupTableIndex> index;
+  Status s = LookupTableIndex::Open(Env::Default(), path, DT_STRING, DT_INT64,
+                                    &index);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST(LookupTableIndexTest, OpenRejectsCorruptFiles) {
+  const string path = IndexPath("corrupt.idx");
+  std::unique_ptr<LookupTableIndex> index;
+
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "short"));
+  EXPECT_TRUE(errors::IsDataLoss(LookupTableIndex::Open(
+      Env::Default(), path, DT_INT64, DT_INT64, &index)));
+
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, string(128, 'x')));
+  EXPECT_TRUE(errors::IsDataLoss(LookupTableIndex::Open(
+      Env::Default(), path, DT_INT64, DT_INT64, &index)));
+
+  // A valid index with its tail truncated.
+  TF_ASSERT_OK(LookupTableIndex::Write(Env::Default(), path,
+                                       test::AsTensor<int64>({1, 2, 3}),
+                                       test::AsTensor<int64>({4, 5, 6})));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  contents.resize(contents.size() - 8);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, contents));
+  EXPECT_TRUE(errors::IsDataLoss(LookupTableIndex::Open(
+      Env::Default(), path, DT_INT64, DT_INT64, &index)));
+}
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/lookup_table_index.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/random.h"
@@ -878,6 +879,110 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// Immutable lookup table backed by a prebuilt LookupTableIndex file. The index
+// is memory-mapped when the table is created, so creating the table does not
+// parse or copy the vocabulary, and processes that load the same file share
+// its pages.
+//
+// The index file is produced ahead of time by the WriteHashTableIndex op.
+template <class K, class V>
+class IndexedHashTable final : public LookupInterface {
+ public:
+  IndexedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    string index_filename;
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "index_filename", &index_filename));
+    OP_REQUIRES_OK(ctx, LookupTableIndex::Open(
+                            ctx->env(), index_filename, DataTypeToEnum<K>::v(),
+                            DataTypeToEnum<V>::v(), &index_));
+  }
+
+  size_t size() const override { return index_->num_entries(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    const auto default_flat = default_value.flat<V>();
+    const bool is_full_size_default =
+        (value_values.size() == default_flat.size());
+
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const LookupTableIndex::Slot* slot =
+          FindSlot(SubtleMustCopyIfIntegral(key_values(i)));
+      if (slot == nullptr) {
+        value_values(i) =
+            is_full_size_default ? default_flat(i) : default_flat(0);
+      } else {
+        TF_RETURN_IF_ERROR(index_->GetValue(*slot, &value_values(i)));
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return errors::FailedPrecondition("IndexedHashTable is immutable");
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    return errors::FailedPrecondition("IndexedHashTable is immutable");
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return errors::FailedPrecondition("IndexedHashTable is immutable");
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const int64 size = index_->num_entries();
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64 i = 0;
+    for (uint64 pos = 0; pos < index_->num_slots() && i < size; ++pos) {
+      const LookupTableIndex::Slot& slot = index_->slots()[pos];
+      if (!LookupTableIndex::IsOccupied(slot)) continue;
+      TF_RETURN_IF_ERROR(index_->GetKey(slot, &keys_data(i)));
+      TF_RETURN_IF_ERROR(index_->GetValue(slot, &values_data(i)));
+      ++i;
+    }
+    if (i != size) {
+      return errors::DataLoss("Lookup table index holds ", i,
+                              " entries but its header records ", size);
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  int64 MemoryUsed() const override {
+    return sizeof(IndexedHashTable) + index_->mapped_bytes();
+  }
+
+ private:
+  const LookupTableIndex::Slot* FindSlot(int64 key) const {
+    return index_->Find(key);
+  }
+
+  const LookupTableIndex::Slot* FindSlot(const tstring& key) const {
+    return index_->Find(StringPiece(key.data(), key.size()));
+  }
+
+  std::unique_ptr<LookupTableIndex> index_;
+};
+
 }  // namespace lookup
 
 // Base class for kernels that take a LookupTable handle as the 0th input.
@@ -1213,4 +1318,40 @@ REGISTER_KERNEL(tstring, ResourceHandle);
 
 #undef REGISTER_KERNEL
 
+// Register the IndexedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                               \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("IndexedHashTable")                                                \
+          .Device(DEVICE_CPU)                                                 \
+          .TypeConstraint<key_dtype>("key_dtype")                             \
+          .TypeConstraint<value_dtype>("value_dtype"),                        \
+      LookupTableOp<lookup::IndexedHashTable<key_dtype, value_dtype>,         \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(int64, tstring);
+REGISTER_KERNEL(tstring, int64);
+REGISTER_KERNEL(tstring, tstring);
+
+#undef REGISTER_KERNEL
+
+// Builds the index file read by IndexedHashTable.
+class WriteHashTableIndexOp : public OpKernel {
+ public:
+  explicit WriteHashTableIndexOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& filename = ctx->input(0);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(filename.shape()),
+                errors::InvalidArgument("filename must be a scalar, got shape ",
+                                        filename.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, lookup::LookupTableIndex::Write(
+                            ctx->env(), filename.scalar<tstring>()(),
+                            ctx->input(1), ctx->input(2)));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("WriteHashTableIndex").Device(DEVICE_CPU),
+                        WriteHashTableIndexOp);
+
 }  // namespace tensorflow
@@ -0,0 +1,134 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/lookup_table_op.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+// Returns a table mapping keys 0, 2, 4, ... to 0, 1, 2, ...
+core::RefCountPtr<HashTable<int64, int64>> CreateTable(int64 num_keys) {
+  Tensor keys(DT_INT64, TensorShape({num_keys}));
+  Tensor values(DT_INT64, TensorShape({num_keys}));
+  for (int64 i = 0; i < num_keys; ++i) {
+    keys.flat<int64>()(i) = 2 * i;
+    values.flat<int64>()(i) = i;
+  }
+  core::RefCountPtr<HashTable<int64, int64>> table(
+      new HashTable<int64, int64>(/*ctx=*/nullptr, /*kernel=*/nullptr));
+  KeyValueTensorIterator iter(&keys, &values);
+  TF_CHECK_OK(table->Initialize(iter));
+  return table;
+}
+
+Tensor RandomKeys(int64 num_keys, int64 max_key) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor keys(DT_INT64, TensorShape({num_keys}));
+  for (int64 i = 0; i < num_keys; ++i) {
+    keys.flat<int64>()(i) = rnd.Uniform64(max_key);
+  }
+  return keys;
+}
+
+void ExpectFindsAll(HashTable<int64, int64>* table, int64 table_size) {
+  const Tensor keys = RandomKeys(1000, 2 * table_size);
+  Tensor values(DT_INT64, keys.shape());
+  Tensor default_value = test::AsScalar<int64>(-1);
+  TF_ASSERT_OK(table->Find(/*ctx=*/nullptr, keys, &values, default_value));
+  for (int64 i = 0; i < keys.NumElements(); ++i) {
+    const int64 key = keys.flat<int64>()(i);
+    EXPECT_EQ(key % 2 == 0 ? key / 2 : -1, values.flat<int64>()(i));
+  }
+}
+
+TEST(HashTableTest, FindSmallTable) {
+  auto table = CreateTable(100);
+  ExpectFindsAll(table.get(), 100);
+}
+
+TEST(HashTableTest, FindLargeTable) {
+  // Large enough to take the prefetching path.
+  auto table = CreateTable(1 << 17);
+  ExpectFindsAll(table.get(), 1 << 17);
+}
+
+TEST(HashTableTest, FindFewerKeysThanPrefetchDistance) {
+  auto table = CreateTable(1 << 17);
+  Tensor keys = test::AsTensor<int64>({4, 5, 6});
+  Tensor values(DT_INT64, keys.shape());
+  TF_ASSERT_OK(table->Find(/*ctx=*/nullptr, keys, &values,
+                           test::AsScalar<int64>(-1)));
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({2, -1, 3}), values);
+}
+
+// Compares HashTable::Find() against probing an absl::flat_hash_map one key at
+// a time, for tables that fit in cache and tables that don't.
+void BM_HashTableFind(::testing::benchmark::State& state) {
+  const int64 table_size = state.range(0);
+  const int64 batch_size = state.range(1);
+  auto table = CreateTable(table_size);
+  const Tensor keys = RandomKeys(batch_size, 2 * table_size);
+  Tensor values(DT_INT64, keys.shape());
+  const Tensor default_value = test::AsScalar<int64>(-1);
+  for (auto s : state) {
+    TF_CHECK_OK(table->Find(/*ctx=*/nullptr, keys, &values, default_value));
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_HashTableFind)
+    ->ArgPair(1 << 10, 1024)
+    ->ArgPair(1 << 24, 1)
+    ->ArgPair(1 << 24, 1024);
+
+void BM_FlatHashMapFind(::testing::benchmark::State& state) {
+  const int64 table_size = state.range(0);
+  const int64 batch_size = state.range(1);
+  absl::flat_hash_map<int64, int64> table;
+  table.reserve(table_size);
+  for (int64 i = 0; i < table_size; ++i) {
+    table.emplace(2 * i, i);
+  }
+  const Tensor keys = RandomKeys(batch_size, 2 * table_size);
+  const auto key_values = keys.flat<int64>();
+  Tensor values(DT_INT64, keys.shape());
+  auto value_values = values.flat<int64>();
+  for (auto s : state) {
+    for (int64 i = 0; i < batch_size; ++i) {
+      value_values(i) = gtl::FindWithDefault(table, key_values(i), -1);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_FlatHashMapFind)
+    ->ArgPair(1 << 10, 1024)
+    ->ArgPair(1 << 24, 1)
+    ->ArgPair(1 << 24, 1024);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
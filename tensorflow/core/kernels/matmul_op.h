@@ -21,6 +21,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/lib/hash/hash.h"
 
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
 #if defined(TENSORFLOW_USE_CUSTOM_CONTRACTION_KERNEL)
 #include "tensorflow/core/kernels/eigen_contraction_kernel.h"
 #endif
@@ -60,17 +64,22 @@ struct MatMulFunctor {
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 // Encapsulate all the shape information that is used in matmul operations.
+// `epilogue` is the postprocessing fused into the matmul (e.g. BiasAdd + Relu
+// in `_FusedMatMul`).
 class MatmulParameters {
  public:
-  MatmulParameters(bool transa, bool transb, uint64 m, uint64 n, uint64 k,
-                   DataType dtype, int device_id)
+  MatmulParameters(
+      bool transa, bool transb, uint64 m, uint64 n, uint64 k, DataType dtype,
+      int device_id,
+      se::blas::Epilogue epilogue = se::blas::Epilogue::kDefault)
       : transa_(transa),
         transb_(transb),
         m_(m),
         n_(n),
         k_(k),
         dtype_(dtype),
-        device_id_(device_id) {
+        device_id_(device_id),
+        epilogue_(epilogue) {
     hash_code_ = transa;
     hash_code_ = Hash64Combine(hash_code_, transb);
     hash_code_ = Hash64Combine(hash_code_, m);
@@ -78,6 +87,7 @@ class MatmulParameters {
     hash_code_ = Hash64Combine(hash_code_, k);
     hash_code_ = Hash64Combine(hash_code_, dtype);
     hash_code_ = Hash64Combine(hash_code_, device_id);
+    hash_code_ = Hash64Combine(hash_code_, static_cast<int>(epilogue));
   }
   bool operator==(const MatmulParameters& other) const {
     return this->get_data_as_tuple() == other.get_data_as_tuple();
@@ -92,17 +102,20 @@ class MatmulParameters {
     // clang-format off
     return strings::StrCat(
         transa_, ", ", transb_, ", ",
-        m_, ", ", n_, ", ", k_,
-        dtype_, ", ", device_id_);
+        m_, ", ", n_, ", ", k_, ", ",
+        dtype_, ", ", device_id_, ", ",
+        static_cast<int>(epilogue_));
     // clang-format on
   }
 
  private:
-  typedef std::tuple<bool, bool, int64, int64, int64, DataType, int>
+  typedef std::tuple<bool, bool, int64, int64, int64, DataType, int,
+                     se::blas::Epilogue>
       ParameterDataType;
 
   ParameterDataType get_data_as_tuple() const {
-    return std::make_tuple(transa_, transb_, m_, n_, k_, dtype_, device_id_);
+    return std::make_tuple(transa_, transb_, m_, n_, k_, dtype_, device_id_,
+                           epilogue_);
   }
 
   bool transa_;
@@ -112,6 +125,7 @@ class MatmulParameters {
   uint64 k_;
   DataType dtype_;
   int device_id_;
+  se::blas::Epilogue epilogue_;
   uint64 hash_code_;
 };
 
@@ -20,7 +20,8 @@ limitations under the License.
 //
 // Activation: Relu, Relu6, Elu, etc...
 //
-// Currently supported only on CPU device.
+// On GPU device only MatMul + BiasAdd + [Relu] is supported, and it is computed
+// by a cuBLASLt matmul with a fused epilogue (requires CUDA 11).
 
 #ifndef TENSORFLOW_CORE_KERNELS_MATMUL_OP_FUSED_H_
 #define TENSORFLOW_CORE_KERNELS_MATMUL_OP_FUSED_H_
@@ -44,6 +45,16 @@ limitations under the License.
 #include "tensorflow/core/kernels/eigen_contraction_kernel.h"
 #endif
 
+#if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/core/kernels/gpu_utils.h"
+#include "tensorflow/core/kernels/matmul_op.h"
+#include "tensorflow/core/kernels/matmul_op_impl.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/tensor_float_32_utils.h"
+#include "tensorflow/core/util/matmul_autotune.h"
+#endif  // GOOGLE_CUDA
+
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -145,6 +156,168 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
   };
 };
 
+#if GOOGLE_CUDA && CUDA_VERSION >= 11000
+
+namespace {
+
+// Upper bound on the workspace the cuBLASLt algorithms are allowed to use.
+constexpr size_t kMaxBlasLtWorkspaceSize = 32 * 1024 * 1024;  // 32 MiB
+
+// Number of cuBLASLt algorithms that are profiled when autotuning is enabled.
+constexpr int kMaxBlasLtAutotuneAlgorithms = 16;
+
+struct FusedMatMulAutoTuneGroup {
+  static string name() { return "FusedMatMul"; }
+};
+
+typedef AutoTuneSingleton<FusedMatMulAutoTuneGroup, MatmulParameters,
+                          se::blas::AlgorithmConfig>
+    AutoTuneFusedMatMul;
+
+}  // namespace
+
+template <typename T>
+struct LaunchFusedMatMulOp<GPUDevice, T> {
+  void operator()(
+      OpKernelContext* context, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      FusedComputationType fusion, const FusedComputationArgs& fusion_args,
+      Tensor* output) {
+    se::blas::Epilogue epilogue = se::blas::Epilogue::kDefault;
+    switch (fusion) {
+      case FusedComputationType::kBiasAdd:
+        epilogue = se::blas::Epilogue::kBias;
+        break;
+      case FusedComputationType::kBiasAddWithRelu:
+        epilogue = se::blas::Epilogue::kBiasThenReLU;
+        break;
+      case FusedComputationType::kUndefined:
+        OP_REQUIRES_OK(context, errors::Internal("Fusion type is undefined"));
+        break;
+      default:
+        OP_REQUIRES_OK(context,
+                       errors::Internal("Fusion type is not supported"));
+    }
+
+    const bool transpose_a = dim_pair[0].first == 0;
+    const bool transpose_b = dim_pair[0].second == 1;
+    const int64 m = output->dim_size(0);
+    const int64 n = output->dim_size(1);
+    const int64 k = a.dim_size(dim_pair[0].first);
+
+    // Bias of the following dimensions: [ output_depth ]
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context, bias.dims() == 1 && bias.dim_size(0) == n,
+                errors::InvalidArgument("bias must be a vector of size ", n,
+                                        ", got shape ",
+                                        bias.shape().DebugString()));
+
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES(context, stream, errors::Internal("No GPU stream available."));
+
+    // cuBLASLt is column-major, so we compute the transposed product
+    // output^T = b^T * a^T. The bias is then added to every column of
+    // output^T, i.e. to every row of the row-major output.
+    se::blas::BlasLtMatmulPlanParams plan_params;
+    plan_params.ab_type = se::blas::ToDataType<T>::value;
+    plan_params.c_type = se::blas::ToDataType<T>::value;
+    plan_params.computation_type = tensor_float_32_execution_enabled()
+                                       ? se::blas::ComputationType::kTF32AsF32
+                                       : se::blas::ComputationType::kF32;
+    plan_params.pointer_mode = se::blas::PointerMode::kHost;
+    plan_params.epilogue = epilogue;
+    plan_params.transa = transpose_b ? se::blas::Transpose::kTranspose
+                                     : se::blas::Transpose::kNoTranspose;
+    plan_params.transb = transpose_a ? se::blas::Transpose::kTranspose
+                                     : se::blas::Transpose::kNoTranspose;
+    plan_params.m = n;
+    plan_params.n = m;
+    plan_params.k = k;
+    plan_params.lda = b.dim_size(1);
+    plan_params.ldb = a.dim_size(1);
+    plan_params.ldc = n;
+
+    auto plan_or = stream->parent()->CreateBlasLtMatmulPlan(plan_params);
+    OP_REQUIRES_OK(context, plan_or.status());
+    std::unique_ptr<se::blas::IBlasLtMatmulPlan> plan =
+        plan_or.ConsumeValueOrDie();
+
+    const bool autotune = MatmulAutotuneEnable();
+    auto algorithms_or = stream->parent()->GetBlasLtMatmulAlgorithms(
+        plan.get(), kMaxBlasLtWorkspaceSize,
+        autotune ? kMaxBlasLtAutotuneAlgorithms : 1);
+    OP_REQUIRES_OK(context, algorithms_or.status());
+    std::vector<std::unique_ptr<se::blas::IBlasLtMatmulAlgorithm>> algorithms =
+        algorithms_or.ConsumeValueOrDie();
+    OP_REQUIRES(context, !algorithms.empty(),
+                errors::Internal("No cuBLASLt algorithm found for MatMul with "
+                                 "fused epilogue"));
+
+    auto a_ptr = AsDeviceMemory(a.template flat<T>().data(),
+                                a.template flat<T>().size());
+    auto b_ptr = AsDeviceMemory(b.template flat<T>().data(),
+                                b.template flat<T>().size());
+    auto c_ptr = AsDeviceMemory(output->template flat<T>().data(),
+                                output->template flat<T>().size());
+    auto bias_ptr = AsDeviceMemory(bias.template flat<T>().data(),
+                                   bias.template flat<T>().size());
+
+    // The heuristics order the algorithms by their estimated compute time, so
+    // without autotuning we always run the first one. With autotuning the
+    // index of the fastest algorithm is cached per shape and epilogue.
+    se::blas::AlgorithmConfig algorithm_config(0);
+    MatmulParameters matmul_parameters(
+        transpose_a, transpose_b, m, n, k, DataTypeToEnum<T>::value,
+        stream->parent()->device_ordinal(), epilogue);
+    if (autotune && !AutoTuneFusedMatMul::GetInstance()->Find(
+                        matmul_parameters, &algorithm_config)) {
+      se::blas::ProfileResult best_result;
+      for (int i = 0; i < static_cast<int>(algorithms.size()); ++i) {
+        BlasScratchAllocator scratch_allocator(context);
+        se::blas::ProfileResult profile_result;
+        stream->ThenBlasLtMatmul(plan.get(), T(1), b_ptr, a_ptr, T(0), &c_ptr,
+                                 &scratch_allocator, algorithms[i].get(),
+                                 bias_ptr, &profile_result);
+        if (profile_result.is_valid() &&
+            profile_result.elapsed_time_in_ms() <
+                best_result.elapsed_time_in_ms()) {
+          best_result = profile_result;
+          best_result.set_algorithm(i);
+        }
+      }
+      if (best_result.is_valid()) {
+        algorithm_config.set_algorithm(best_result.algorithm());
+      }
+      AutoTuneFusedMatMul::GetInstance()->Insert(matmul_parameters,
+                                                 algorithm_config);
+    }
+
+    const se::blas::AlgorithmType algorithm_idx = algorithm_config.algorithm();
+    OP_REQUIRES(context,
+                0 <= algorithm_idx &&
+                    algorithm_idx < static_cast<int64>(algorithms.size()),
+                errors::Internal("Invalid cuBLASLt algorithm index ",
+                                 algorithm_idx, " for MatMul with fused "
+                                 "epilogue"));
+
+    BlasScratchAllocator scratch_allocator(context);
+    bool blas_launch_status =
+        stream
+            ->ThenBlasLtMatmul(plan.get(), T(1), b_ptr, a_ptr, T(0), &c_ptr,
+                               &scratch_allocator,
+                               algorithms[algorithm_idx].get(), bias_ptr)
+            .ok();
+    OP_REQUIRES(context, blas_launch_status,
+                errors::Internal("cuBLASLt MatMul with fused epilogue launch "
+                                 "failed : a.shape=",
+                                 a.shape().DebugString(),
+                                 ", b.shape=", b.shape().DebugString(),
+                                 ", m=", m, ", n=", n, ", k=", k));
+  }
+};
+
+#endif  // GOOGLE_CUDA && CUDA_VERSION >= 11000
+
 template <typename Device, typename T>
 class FusedMatMulOp : public OpKernel {
  public:
@@ -163,6 +336,11 @@ class FusedMatMulOp : public OpKernel {
           {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
           {FCT::kBiasAddWithLeakyRelu, {"BiasAdd", "LeakyRelu"}},
       };
+    } else {
+      patterns = {
+          {FCT::kBiasAdd, {"BiasAdd"}},
+          {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
+      };
     }
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
@@ -239,5 +417,19 @@ TF_CALL_float(REGISTER_FUSED_CPU_MATMUL);
 
 #undef REGISTER_FUSED_CPU_MATMUL
 
+#if GOOGLE_CUDA && CUDA_VERSION >= 11000
+
+// Registration of the GPU implementations.
+#define REGISTER_FUSED_GPU_MATMUL(T)                                  \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedMatMul").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<GPUDevice, T>);
+
+TF_CALL_float(REGISTER_FUSED_GPU_MATMUL);
+
+#undef REGISTER_FUSED_GPU_MATMUL
+
+#endif  // GOOGLE_CUDA && CUDA_VERSION >= 11000
+
 }  // namespace tensorflow
 #endif  // TENSORFLOW_CORE_KERNELS_MATMUL_OP_FUSED_H_
@@ -234,17 +234,52 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
 
     // Number of matrix multiplies i.e. size of the batch.
     const int64 batch_size = bcast.output_batch_size();
+
+    // If every batch entry of x is multiplied by the same y, the rows of x are
+    // contiguous and the whole batch is a single [batch * m, k] x [k, n]
+    // product, which is much cheaper than many small ones.
+    if (batch_size > 1 && bcast.y_batch_size() == 1 &&
+        bcast.x_batch_size() == batch_size && !adj_x && !trans_x) {
+      const int64 merged_rows = batch_size * in_x.dim_size(1);
+      Tensor in_x_merged;
+      OP_REQUIRES(context,
+                  in_x_merged.CopyFrom(
+                      in_x, TensorShape({1, merged_rows, in_x.dim_size(2)})),
+                  errors::Internal("Failed to reshape In[0] from ",
+                                   in_x.shape().DebugString()));
+      Tensor out_merged;
+      OP_REQUIRES(context,
+                  out_merged.CopyFrom(
+                      *out, TensorShape({1, merged_rows, out->dim_size(2)})),
+                  errors::Internal("Failed to reshape output from ",
+                                   out->shape().DebugString()));
+      const MatMulBCast merged_bcast(in_x_merged.shape().dim_sizes(),
+                                     in_y.shape().dim_sizes());
+      Launch(context, in_x_merged, in_y, adj_x, adj_y, trans_x, trans_y,
+             merged_bcast, &out_merged);
+      return;
+    }
+
     const int64 cost_per_unit =
         in_x.dim_size(1) * in_x.dim_size(2) * out->dim_size(2);
     const int64 small_dim = std::min(
         std::min(in_x.dim_size(1), in_x.dim_size(2)), out->dim_size(2));
+    const int64 large_dim = std::max(
+        std::max(in_x.dim_size(1), in_x.dim_size(2)), out->dim_size(2));
     // NOTE(nikhilsarda): This heuristic is optimal in benchmarks as of
     // Jan 21, 2020.
     const int64 kMaxCostOuterParallelism = 128 * 128;  // heuristic.
+    // Matrices no larger than this, e.g. the per-head products in attention
+    // layers, are multiplied in a single thread each. Parallelizing every one
+    // of them over the inner dims costs a thread pool round trip per product,
+    // which dominates the actual work.
+    const int64 kMaxSmallMatrixDim = 128;  // heuristic.
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const bool small_matrices = large_dim <= kMaxSmallMatrixDim &&
+                                batch_size >= worker_threads.num_threads;
     // TODO(rmlarsen): Reconsider the heuristics now that we have asynchronous
     // evaluation in Eigen Tensor.
-    if (small_dim > 1 &&
+    if (small_dim > 1 && !small_matrices &&
         (batch_size == 1 || cost_per_unit > kMaxCostOuterParallelism)) {
       // Parallelize over inner dims.
       // For large matrix products it is counter-productive to parallelize
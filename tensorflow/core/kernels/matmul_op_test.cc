@@ -610,6 +610,12 @@ BM_BatchMatmulBCast(1, 128, 1024, 1024, 1024, false);
 BM_BatchMatmulBCast(128, 1, 1024, 1024, 1024, true);
 BM_BatchMatmulBCast(128, 1, 1024, 1024, 1024, false);
 
+// Projections shared by all batch entries.
+BM_BatchMatmulBCast(128, 1, 64, 64, 64, true);
+BM_BatchMatmulBCast(128, 1, 64, 64, 64, false);
+BM_BatchMatmulBCast(32, 1, 128, 512, 64, true);
+BM_BatchMatmulBCast(32, 1, 128, 512, 64, false);
+
 // Matrix-vector multiplies.
 BM_BatchMatmulBCast(1, 128, 10000, 200, 1, true);
 BM_BatchMatmulBCast(1, 128, 10000, 200, 1, false);
@@ -667,6 +673,15 @@ BM_BatchMatmul(32, 256, 256, 256, false, false);
 BM_BatchMatmul(32, 1024, 1024, 1024, false, false);
 BM_BatchMatmul(32, 2048, 2048, 2048, false, false);
 
+// Attention with [batch * heads, seq_len, head_dim] operands: Q * K^T
+// followed by the attention weights times V.
+BM_BatchMatmul(96, 128, 64, 128, false, true);
+BM_BatchMatmul(96, 128, 128, 64, false, false);
+BM_BatchMatmul(384, 64, 64, 64, false, true);
+BM_BatchMatmul(384, 64, 64, 64, false, false);
+BM_BatchMatmul(768, 32, 32, 32, false, true);
+BM_BatchMatmul(768, 32, 32, 32, false, false);
+
 // Matrix-vector multiplies.
 BM_BatchMatmul(1, 10000, 200, 1, false, false);
 BM_BatchMatmul(8, 10000, 200, 1, false, false);
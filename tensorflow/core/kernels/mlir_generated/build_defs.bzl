@@ -119,6 +119,14 @@ def if_mlir_generated_cpu_kernels_enabled(if_true, if_false = []):
         "//conditions:default": if_false,
     })
 
+def _cpu_codegen_args():
+    return select({
+        "//tensorflow/core/kernels/mlir_generated:is_cpu_avx2_enabled": [
+            "--mattr=+avx,+avx2,+fma",
+        ],
+        "//conditions:default": [],
+    })
+
 def if_mlir_generated_experimental_kernels_enabled(if_true, if_false = []):
     return select({
         "//tensorflow/core/kernels/mlir_generated:is_experimental_enabled": if_true,
@@ -266,7 +274,7 @@ def _gen_kernel_library(
                 cpu_codegen = enable_cpu,
                 tile_size = tile_size,
                 unroll_factors = filtered_unroll_factors,
-                extra_args = extra_args,
+                extra_args = extra_args + (_cpu_codegen_args() if enable_cpu else []),
                 compatible_with = get_compatible_with_cloud(),
             )
 
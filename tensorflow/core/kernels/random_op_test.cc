@@ -17,8 +17,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/random_op_cpu.h"
 #include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -37,6 +39,46 @@ Tensor VecShape(int64 v) {
   }
 }
 
+// Checks that `dist` draws the same values from a PhiloxRandomBatch as from
+// the PhiloxRandom it is created from.
+template <class Distribution>
+void ExpectSameAsPhiloxRandom(const random::PhiloxRandom& gen,
+                              Distribution dist) {
+  random::PhiloxRandom scalar_gen = gen;
+  functor::PhiloxRandomBatch batch_gen(gen);
+  auto batch_dist = functor::BatchedDistribution<Distribution>::Convert(dist);
+  for (int i = 0; i < 3 * functor::PhiloxRandomBatch::kBatchSize + 1; ++i) {
+    auto expected = dist(&scalar_gen);
+    auto actual = batch_dist(&batch_gen);
+    for (int j = 0; j < Distribution::kResultElementCount; ++j) {
+      ASSERT_EQ(expected[j], actual[j]) << "sample " << i << " element " << j;
+    }
+  }
+}
+
+TEST(PhiloxRandomBatchTest, SameAsPhiloxRandom) {
+  using random::PhiloxRandom;
+  PhiloxRandom wrapping_gen(/*seed_lo=*/0x12345, /*seed_hi=*/~uint64{0});
+  // Makes the low word of the counter wrap around within the first batch.
+  wrapping_gen.Skip(~uint32{0} - 5);
+  for (const PhiloxRandom& gen : {PhiloxRandom(0x12345), wrapping_gen}) {
+    ExpectSameAsPhiloxRandom(
+        gen, random::UniformDistribution<PhiloxRandom, float>());
+    ExpectSameAsPhiloxRandom(
+        gen, random::UniformDistribution<PhiloxRandom, double>());
+    ExpectSameAsPhiloxRandom(
+        gen, random::UniformDistribution<PhiloxRandom, int32>(-10, 1000));
+    ExpectSameAsPhiloxRandom(
+        gen, random::UniformDistribution<PhiloxRandom, int64>(-10, 1LL << 40));
+    ExpectSameAsPhiloxRandom(
+        gen, random::UniformFullIntDistribution<PhiloxRandom, uint64>());
+    ExpectSameAsPhiloxRandom(
+        gen, random::NormalDistribution<PhiloxRandom, float>());
+    ExpectSameAsPhiloxRandom(
+        gen, random::NormalDistribution<PhiloxRandom, double>());
+  }
+}
+
 Graph* RandomUniform(int64 n) {
   Graph* g = new Graph(OpRegistry::Global());
   test::graph::RandomUniform(g, test::graph::Constant(g, VecShape(n)),
@@ -116,6 +158,22 @@ void BM_PhiloxRandom(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_PhiloxRandom);
 
+void BM_PhiloxRandomBatch(::testing::benchmark::State& state) {
+  // Fill 2M random numbers
+  int count = 2 << 20;
+  functor::PhiloxRandomBatch gen(random::PhiloxRandom(0x12345));
+
+  for (auto s : state) {
+    for (int j = 0; j < count; j += 4) {
+      /// each invocation of gen() returns 128-bit samples
+      auto samples = gen();
+      tensorflow::testing::DoNotOptimize(samples);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64>(state.iterations()) * count);
+}
+BENCHMARK(BM_PhiloxRandomBatch);
+
 void BM_StdMTRandom(::testing::benchmark::State& state) {
   // Fill 2M random numbers
   int count = 2 << 20;
@@ -128,6 +128,21 @@ Status CopyVariable(int output_idx, OpKernelContext* ctx, const Tensor* t) {
   return Status::OK();
 }
 
+// Reads `var`, which is in copy-on-read mode, into output `output_idx`,
+// reusing the variable's cached read snapshot when it is still current.
+// REQUIRES: *var->mu() is held in shared mode.
+Status ReadCopyOnReadVariable(int output_idx, OpKernelContext* ctx, Var* var) {
+  Tensor snapshot;
+  if (var->LookupReadSnapshot(&snapshot)) {
+    ctx->set_output(output_idx, snapshot);
+    return Status::OK();
+  }
+  const uint64 version = var->version();
+  TF_RETURN_IF_ERROR(CopyVariable(output_idx, ctx, &var->value()));
+  var->CacheReadSnapshot(*ctx->mutable_output(output_idx), version);
+  return Status::OK();
+}
+
 }  // namespace
 
 void ReadVariableOp::Compute(OpKernelContext* ctx) {
@@ -146,7 +161,7 @@ void ReadVariableOp::Compute(OpKernelContext* ctx) {
   // We're acquiring a reference to the underlying buffer while
   // holding a shared lock to guarantee ordering of reads and
   // writes when in copy-on-write mode.
-  const Tensor* t = variable->tensor();
+  const Tensor* t = &variable->value();
   if (!variable->copy_on_read_mode.load()) {
     OP_REQUIRES(
         ctx, dtype_ == t->dtype(),
@@ -155,7 +170,7 @@ void ReadVariableOp::Compute(OpKernelContext* ctx) {
             DataTypeString(dtype_), " got ", DataTypeString(t->dtype())));
     ctx->set_output(0, *t);
   } else {
-    OP_REQUIRES_OK(ctx, CopyVariable(0, ctx, t));
+    OP_REQUIRES_OK(ctx, ReadCopyOnReadVariable(0, ctx, variable.get()));
   }
 }
 
@@ -196,16 +211,16 @@ void ReadVariablesOp::Compute(OpKernelContext* ctx) {
     // holding a shared lock to guarantee ordering of reads and
     // writes.
     tf_shared_lock ml(*variables[i]->mu());
-    OP_REQUIRES(ctx, dtypes_[i] == variables[i]->tensor()->dtype(),
+    OP_REQUIRES(ctx, dtypes_[i] == variables[i]->value().dtype(),
                 errors::InvalidArgument(
                     "Trying to read variable ", handles[i]->name(),
                     " from Container: ", handles[i]->container(),
                     " with wrong dtype. Expected ", DataTypeString(dtypes_[i]),
-                    " got ", DataTypeString(variables[i]->tensor()->dtype())));
+                    " got ", DataTypeString(variables[i]->value().dtype())));
     if (variables[i]->copy_on_read_mode.load()) {
-      OP_REQUIRES_OK(ctx, CopyVariable(i, ctx, variables[i]->tensor()));
+      OP_REQUIRES_OK(ctx, ReadCopyOnReadVariable(i, ctx, variables[i].get()));
     } else {
-      const Tensor& t = *variables[i]->tensor();
+      const Tensor& t = variables[i]->value();
       ctx->set_output(i, t);
     }
   }
@@ -662,7 +677,7 @@ class ResourceGatherOp : public OpKernel {
     // reference count greater than one and make a copy of the
     // (potentially very large) tensor buffer.
     tf_shared_lock ml(*v->mu());
-    const Tensor& params = *v->tensor();
+    const Tensor& params = v->value();
     const Tensor& indices = c->input(1);
     OP_REQUIRES(
         c, TensorShapeUtils::IsVectorOrHigher(params.shape()),
@@ -828,7 +843,7 @@ class ResourceGatherNdOp : public OpKernel {
     // reference count greater than one and make a copy of the
     // (potentially very large) tensor buffer.
     tf_shared_lock ml(*v->mu());
-    const Tensor& params = *v->tensor();
+    const Tensor& params = v->value();
     const Tensor& indices = c->input(1);
 
     Tensor out;
@@ -894,6 +909,7 @@ class ResourceScatterUpdateOp : public OpKernel {
       // For POD dtypes, we can safely run the update without the mutex.
       tf_shared_lock ml(*v->mu());
       DoCompute(c);
+      v->InvalidateReadSnapshot();
     }
   }
 
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -41,32 +42,17 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
+// Computes the cell's gates and outputs from the pre-activations in `gates`.
 template <typename T, GateLayout gate_layout>
-void LSTMBlockCellFpropWithEigen(
-    const LSTMBlockCell& cell, OpKernelContext* ctx, const CPUDevice& d,
-    const float forget_bias, const float cell_clip, bool use_peephole,
-    typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix cs_prev,
-    typename TTypes<T>::ConstMatrix h_prev, typename TTypes<T>::ConstMatrix w,
-    typename TTypes<T>::ConstVec wci, typename TTypes<T>::ConstVec wcf,
-    typename TTypes<T>::ConstVec wco, typename TTypes<T>::ConstVec b,
-    typename TTypes<T>::Matrix xh, typename TTypes<T>::Matrix i,
+void LSTMBlockCellFpropFromGates(
+    const LSTMBlockCell& cell, const CPUDevice& d, const float forget_bias,
+    const float cell_clip, bool use_peephole,
+    typename TTypes<T>::ConstMatrix cs_prev, typename TTypes<T>::ConstVec wci,
+    typename TTypes<T>::ConstVec wcf, typename TTypes<T>::ConstVec wco,
+    typename TTypes<T>::Matrix gates, typename TTypes<T>::Matrix i,
     typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
     typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
-    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix gates,
-    typename TTypes<T>::Matrix h) {
-  // Concat xh = [x, h].
-  xh.slice(cell.xh_x_offsets(), cell.xh_x_extents()).device(d) = x;
-  xh.slice(cell.xh_h_offsets(), cell.xh_h_extents()).device(d) = h_prev;
-
-  // states1 = xh * w + b
-  typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());
-  TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
-      ctx, d, false, false, typename gemm_compute_type<T>::type(1.f), const_xh,
-      w, typename gemm_compute_type<T>::type(0.f), gates);
-  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
-  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({cell.batch_size(), 1});
-  gates.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
-
+    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix h) {
   Eigen::array<Eigen::DenseIndex, 2> p_shape({1, cell.cell_size()});
   Eigen::array<Eigen::DenseIndex, 2> p_broadcast_shape({cell.batch_size(), 1});
 
@@ -126,6 +112,148 @@ void LSTMBlockCellFpropWithEigen(
   h.device(d) = o * co;
 }
 
+template <typename T, GateLayout gate_layout>
+void LSTMBlockCellFpropWithEigen(
+    const LSTMBlockCell& cell, OpKernelContext* ctx, const CPUDevice& d,
+    const float forget_bias, const float cell_clip, bool use_peephole,
+    typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix cs_prev,
+    typename TTypes<T>::ConstMatrix h_prev, typename TTypes<T>::ConstMatrix w,
+    typename TTypes<T>::ConstVec wci, typename TTypes<T>::ConstVec wcf,
+    typename TTypes<T>::ConstVec wco, typename TTypes<T>::ConstVec b,
+    typename TTypes<T>::Matrix xh, typename TTypes<T>::Matrix i,
+    typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
+    typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
+    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix gates,
+    typename TTypes<T>::Matrix h) {
+  // Concat xh = [x, h].
+  xh.slice(cell.xh_x_offsets(), cell.xh_x_extents()).device(d) = x;
+  xh.slice(cell.xh_h_offsets(), cell.xh_h_extents()).device(d) = h_prev;
+
+  // states1 = xh * w + b
+  typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());
+  TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+      ctx, d, false, false, typename gemm_compute_type<T>::type(1.f), const_xh,
+      w, typename gemm_compute_type<T>::type(0.f), gates);
+  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
+  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({cell.batch_size(), 1});
+  gates.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
+
+  LSTMBlockCellFpropFromGates<T, gate_layout>(cell, d, forget_bias, cell_clip,
+                                              use_peephole, cs_prev, wci, wcf,
+                                              wco, gates, i, cs, f, o, ci, co,
+                                              h);
+}
+
+// Computes a BlockLSTM's gate pre-activations from its inputs one sequence at
+// a time rather than one time step at a time.
+//
+// The input rows of w only ever multiply x, so x * w[:input_size] + b is
+// computed for every time step in a single GEMM before the recurrence starts.
+// Each step is then left with the much smaller h_prev * w[input_size:], whose
+// weights are copied once into an aligned buffer that every step reuses.
+// Only the CPU kernel specializes this; other devices run the per-step cell.
+template <typename Device, typename T, GateLayout gate_layout>
+struct BlockLSTMInputProjection {
+  static constexpr bool kEnabled = false;
+
+  static Status Project(OpKernelContext* ctx, const Device& d,
+                        const int64 seq_len_max, const Tensor& x,
+                        const Tensor& w, const Tensor& b, Tensor* x_proj,
+                        Tensor* w_h) {
+    return errors::Unimplemented("BlockLSTM input projection");
+  }
+
+  static void Step(const LSTMBlockCell& cell, OpKernelContext* ctx,
+                   const Device& d, const float forget_bias,
+                   const float cell_clip, bool use_peephole,
+                   typename TTypes<T>::UnalignedConstMatrix x_proj,
+                   typename TTypes<T>::ConstMatrix cs_prev,
+                   typename TTypes<T>::ConstMatrix h_prev,
+                   typename TTypes<T>::ConstMatrix w_h,
+                   typename TTypes<T>::ConstVec wci,
+                   typename TTypes<T>::ConstVec wcf,
+                   typename TTypes<T>::ConstVec wco,
+                   typename TTypes<T>::Matrix i, typename TTypes<T>::Matrix cs,
+                   typename TTypes<T>::Matrix f, typename TTypes<T>::Matrix o,
+                   typename TTypes<T>::Matrix ci, typename TTypes<T>::Matrix co,
+                   typename TTypes<T>::Matrix gates,
+                   typename TTypes<T>::Matrix h) {}
+};
+
+template <typename T, GateLayout gate_layout>
+struct BlockLSTMInputProjection<CPUDevice, T, gate_layout> {
+  static constexpr bool kEnabled = true;
+
+  // Sets x_proj to the [seq_len_max * batch_size, 4 * cell_size] input half of
+  // every step's gates, bias included, and w_h to the recurrent rows of w.
+  static Status Project(OpKernelContext* ctx, const CPUDevice& d,
+                        const int64 seq_len_max, const Tensor& x,
+                        const Tensor& w, const Tensor& b, Tensor* x_proj,
+                        Tensor* w_h) {
+    const int64 batch_size = x.dim_size(1);
+    const int64 input_size = x.dim_size(2);
+    const int64 cell_size = w.dim_size(1) / 4;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::v(),
+        TensorShape({seq_len_max * batch_size, cell_size * 4}), x_proj));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                           TensorShape({cell_size, cell_size * 4}), w_h));
+
+    // The start of every input tensor is aligned, so the leading time steps of
+    // x and the input rows of w can be used in place.
+    typename TTypes<T>::ConstMatrix x_all(x.flat<T>().data(),
+                                          seq_len_max * batch_size, input_size);
+    typename TTypes<T>::ConstMatrix w_x(w.flat<T>().data(), input_size,
+                                        cell_size * 4);
+    typename TTypes<T>::Matrix x_proj_m = x_proj->matrix<T>();
+    TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+        ctx, d, false, false, typename gemm_compute_type<T>::type(1.f), x_all,
+        w_x, typename gemm_compute_type<T>::type(0.f), x_proj_m);
+    Eigen::array<Eigen::DenseIndex, 2> b_shape({1, cell_size * 4});
+    Eigen::array<Eigen::DenseIndex, 2> broadcast_shape(
+        {seq_len_max * batch_size, 1});
+    x_proj_m.device(d) +=
+        b.vec<T>().reshape(b_shape).broadcast(broadcast_shape);
+
+    // The recurrent rows start wherever input_size leaves them, so copy them
+    // out once instead of realigning them on every step.
+    typename TTypes<T>::UnalignedConstMatrix w_h_rows(
+        w.flat<T>().data() + input_size * cell_size * 4, cell_size,
+        cell_size * 4);
+    w_h->matrix<T>().device(d) = w_h_rows;
+    return Status::OK();
+  }
+
+  // Runs one step of the cell given that step's rows of x_proj.
+  static void Step(const LSTMBlockCell& cell, OpKernelContext* ctx,
+                   const CPUDevice& d, const float forget_bias,
+                   const float cell_clip, bool use_peephole,
+                   typename TTypes<T>::UnalignedConstMatrix x_proj,
+                   typename TTypes<T>::ConstMatrix cs_prev,
+                   typename TTypes<T>::ConstMatrix h_prev,
+                   typename TTypes<T>::ConstMatrix w_h,
+                   typename TTypes<T>::ConstVec wci,
+                   typename TTypes<T>::ConstVec wcf,
+                   typename TTypes<T>::ConstVec wco,
+                   typename TTypes<T>::Matrix i, typename TTypes<T>::Matrix cs,
+                   typename TTypes<T>::Matrix f, typename TTypes<T>::Matrix o,
+                   typename TTypes<T>::Matrix ci, typename TTypes<T>::Matrix co,
+                   typename TTypes<T>::Matrix gates,
+                   typename TTypes<T>::Matrix h) {
+    // gates = h_prev * w_h + x_proj
+    TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+        ctx, d, false, false, typename gemm_compute_type<T>::type(1.f), h_prev,
+        w_h, typename gemm_compute_type<T>::type(0.f), gates);
+    gates.device(d) += x_proj;
+
+    LSTMBlockCellFpropFromGates<T, gate_layout>(cell, d, forget_bias,
+                                                cell_clip, use_peephole,
+                                                cs_prev, wci, wcf, wco, gates,
+                                                i, cs, f, o, ci, co, h);
+  }
+};
+
 template <typename Device, typename T, GateLayout gate_layout>
 void LSTMBlockCellBpropWithEigen(
     const LSTMBlockCell& cell, OpKernelContext* ctx, const Device& d,
@@ -837,6 +965,10 @@ class BlockLSTMOp : public OpKernel {
     }
     OP_REQUIRES_OK(ctx, ctx->GetAttr("cell_clip", &cell_clip_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_peephole", &use_peephole_));
+    // The input projection can be turned off to run the per-step cell that
+    // devices without it use, e.g. to compare the two.
+    OP_REQUIRES_OK(ctx, ReadBoolFromEnvVar("TF_BLOCK_LSTM_PROJECT_INPUTS",
+                                           true, &project_inputs_));
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -970,9 +1102,23 @@ class BlockLSTMOp : public OpKernel {
     const Device& device = ctx->eigen_device<Device>();
 
     const int64 seq_len_max = seq_len_max_tensor->scalar<int64>()();
+
+    // Where supported, multiply the inputs of all time steps by w at once and
+    // leave only the recurrent GEMM inside the loop.
+    using InputProjection =
+        functor::BlockLSTMInputProjection<Device, T, gate_layout>;
+    const bool project_inputs = InputProjection::kEnabled && project_inputs_ &&
+                                seq_len_max > 1 && seq_len_max <= timelen;
+    Tensor x_proj_tensor;
+    Tensor w_h_tensor;
+    if (project_inputs) {
+      OP_REQUIRES_OK(ctx, InputProjection::Project(
+                              ctx, device, seq_len_max, *x, *w_tensor,
+                              *b_tensor, &x_proj_tensor, &w_h_tensor));
+    }
+
     SliceHelper<Device, T> slicer(ctx);
     for (int64 t = 0; t < seq_len_max; ++t) {
-      const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
       const Tensor& cs_prev_tensor2 =
           t == 0 ? *cs_prev_tensor
                  : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
@@ -987,16 +1133,33 @@ class BlockLSTMOp : public OpKernel {
       Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
       Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
 
-      functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS, gate_layout>(
-          batch_size, input_size, cell_size)(
-          ctx, device, forget_bias_, cell_clip_, use_peephole_,
-          x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
-          h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
-          wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
-          b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
-          cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
-          ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
-          gates_tensor.matrix<T>(), h_tensor.matrix<T>());
+      if (project_inputs) {
+        const int64 step_size = batch_size * cell_size * 4;
+        typename TTypes<T>::UnalignedConstMatrix x_proj(
+            x_proj_tensor.flat<T>().data() + t * step_size, batch_size,
+            cell_size * 4);
+        InputProjection::Step(
+            functor::LSTMBlockCell(batch_size, input_size, cell_size), ctx,
+            device, forget_bias_, cell_clip_, use_peephole_, x_proj,
+            cs_prev_tensor2.matrix<T>(), h_prev_tensor2.matrix<T>(),
+            const_cast<const Tensor&>(w_h_tensor).matrix<T>(),
+            wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
+            i_tensor.matrix<T>(), cs_tensor.matrix<T>(), f_tensor.matrix<T>(),
+            o_tensor.matrix<T>(), ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+            gates_tensor.matrix<T>(), h_tensor.matrix<T>());
+      } else {
+        const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
+        functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS, gate_layout>(
+            batch_size, input_size, cell_size)(
+            ctx, device, forget_bias_, cell_clip_, use_peephole_,
+            x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
+            h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
+            wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
+            b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
+            cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
+            ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+            gates_tensor.matrix<T>(), h_tensor.matrix<T>());
+      }
       slicer.FinishTimeStep();
     }
 
@@ -1015,6 +1178,7 @@ class BlockLSTMOp : public OpKernel {
   float forget_bias_;
   float cell_clip_;
   bool use_peephole_;
+  bool project_inputs_;
 };
 
 #define REGISTER_KERNEL(T)                                           \
@@ -0,0 +1,156 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <stdlib.h>
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Odd sizes, so that the time steps and the recurrent rows of w are not
+// aligned.
+constexpr int64 kTimeLen = 4;
+constexpr int64 kBatchSize = 3;
+constexpr int64 kInputSize = 5;
+constexpr int64 kCellSize = 7;
+
+// The outputs of BlockLSTM and LSTMBlockCell, in order.
+constexpr int kNumOutputs = 7;
+constexpr int kCsOutput = 1;
+constexpr int kHOutput = 6;
+
+// Returns a tensor of values in [-1, 1] that depend on "seed".
+Tensor Values(const TensorShape& shape, int seed) {
+  Tensor tensor(DT_FLOAT, shape);
+  test::FillFn<float>(&tensor,
+                      [seed](int i) { return std::sin(seed + 0.37f * i); });
+  return tensor;
+}
+
+class BlockLSTMOpTest : public OpsTestBase {
+ protected:
+  BlockLSTMOpTest()
+      : x_(Values({kTimeLen, kBatchSize, kInputSize}, 1)),
+        cs_prev_(Values({kBatchSize, kCellSize}, 2)),
+        h_prev_(Values({kBatchSize, kCellSize}, 3)),
+        w_(Values({kInputSize + kCellSize, 4 * kCellSize}, 4)),
+        wci_(Values({kCellSize}, 5)),
+        wcf_(Values({kCellSize}, 6)),
+        wco_(Values({kCellSize}, 7)),
+        b_(Values({4 * kCellSize}, 8)) {}
+
+  // Runs op "op" on "inputs" followed by the weights, and returns its
+  // outputs.
+  std::vector<Tensor> Run(const string& op, std::vector<Tensor*> inputs) {
+    NodeDefBuilder builder("lstm", op);
+    if (op == "BlockLSTM") builder.Input(FakeInput(DT_INT64));
+    for (int i = 0; i < 8; ++i) builder.Input(FakeInput(DT_FLOAT));
+    TF_CHECK_OK(builder.Attr("forget_bias", 1.0f)
+                    .Attr("cell_clip", 0.5f)
+                    .Attr("use_peephole", true)
+                    .Finalize(node_def()));
+    TF_CHECK_OK(InitOp());
+
+    for (Tensor* weight : {&w_, &wci_, &wcf_, &wco_, &b_}) {
+      inputs.push_back(weight);
+    }
+    inputs_.clear();
+    for (Tensor* input : inputs) inputs_.push_back(TensorValue(input));
+    TF_CHECK_OK(RunOpKernel());
+
+    std::vector<Tensor> outputs;
+    for (int i = 0; i < kNumOutputs; ++i) outputs.push_back(*GetOutput(i));
+    return outputs;
+  }
+
+  // Runs BlockLSTM for "seq_len_max" steps, with or without its input
+  // projection, and expects the same outputs as LSTMBlockCell run step by
+  // step.
+  void ExpectSameAsCells(bool project_inputs, int64 seq_len_max) {
+    setenv("TF_BLOCK_LSTM_PROJECT_INPUTS", project_inputs ? "1" : "0", 1);
+    Tensor seq_len_max_tensor = test::AsScalar<int64>(seq_len_max);
+    const std::vector<Tensor> block_outputs = Run(
+        "BlockLSTM", {&seq_len_max_tensor, &x_, &cs_prev_, &h_prev_});
+    unsetenv("TF_BLOCK_LSTM_PROJECT_INPUTS");
+
+    Tensor cs_prev = cs_prev_;
+    Tensor h_prev = h_prev_;
+    for (int64 t = 0; t < seq_len_max; ++t) {
+      Tensor x = tensor::DeepCopy(x_.SubSlice(t));
+      const std::vector<Tensor> cell_outputs =
+          Run("LSTMBlockCell", {&x, &cs_prev, &h_prev});
+      for (int i = 0; i < kNumOutputs; ++i) {
+        test::ExpectTensorNear<float>(
+            cell_outputs[i], tensor::DeepCopy(block_outputs[i].SubSlice(t)),
+            1e-5);
+      }
+      cs_prev = cell_outputs[kCsOutput];
+      h_prev = cell_outputs[kHOutput];
+    }
+
+    // The steps past seq_len_max are not run, and their states are zero.
+    const Tensor zeros = test::AsTensor<float>(
+        std::vector<float>(kBatchSize * kCellSize), {kBatchSize, kCellSize});
+    for (int64 t = seq_len_max; t < kTimeLen; ++t) {
+      test::ExpectTensorEqual<float>(
+          zeros, tensor::DeepCopy(block_outputs[kCsOutput].SubSlice(t)));
+      test::ExpectTensorEqual<float>(
+          zeros, tensor::DeepCopy(block_outputs[kHOutput].SubSlice(t)));
+    }
+  }
+
+  Tensor x_;
+  Tensor cs_prev_;
+  Tensor h_prev_;
+  Tensor w_;
+  Tensor wci_;
+  Tensor wcf_;
+  Tensor wco_;
+  Tensor b_;
+};
+
+TEST_F(BlockLSTMOpTest, InputProjectionMatchesCells) {
+  ExpectSameAsCells(/*project_inputs=*/true, kTimeLen);
+}
+
+TEST_F(BlockLSTMOpTest, InputProjectionMatchesCellsForShorterSequence) {
+  ExpectSameAsCells(/*project_inputs=*/true, kTimeLen - 1);
+}
+
+TEST_F(BlockLSTMOpTest, PerStepCellMatchesCells) {
+  ExpectSameAsCells(/*project_inputs=*/false, kTimeLen);
+}
+
+TEST_F(BlockLSTMOpTest, PerStepCellMatchesCellsForShorterSequence) {
+  ExpectSameAsCells(/*project_inputs=*/false, kTimeLen - 1);
+}
+
+TEST_F(BlockLSTMOpTest, SingleStepMatchesCell) {
+  ExpectSameAsCells(/*project_inputs=*/true, 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include <algorithm>
 #include <numeric>
 #include <unordered_map>
 #include <utility>
@@ -331,6 +332,28 @@ struct RestoreOp {
   ::tensorflow::Status status;
 };
 
+// Small tensors are grouped into batches of roughly this many bytes. When a
+// restore has more than one batch, the batches after the first are restored
+// concurrently from the thread pool, one BundleReader per batch.
+const int64 kSmallTensorBatchBytes = 16 << 20;  // 16MB
+
+// A batch of small restore operations that share a BundleReader.
+struct RestoreBatch {
+  void run_with_new_reader() {
+    BundleReader reader(Env::Default(), reader_prefix);
+    status = reader.status();
+    for (RestoreOp* op : ops) {
+      if (!status.ok()) return;
+      status = op->run(&reader);
+    }
+  }
+
+  std::vector<RestoreOp*> ops;
+  string reader_prefix;
+
+  ::tensorflow::Status status;
+};
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -357,12 +380,16 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   TF_RETURN_IF_ERROR(default_reader.status());
 
   std::vector<string> mismatched_errors;
+  std::vector<int64> restored_bytes(tensor_names_flat.size());
   for (const size_t i : sorted_name_idx) {
     TensorShape restored_full_shape;
     DataType original_dtype;
     const string& tensor_name = tensor_names_flat(i);
     TF_RETURN_IF_ERROR(default_reader.LookupDtypeAndShape(
         tensor_name, &original_dtype, &restored_full_shape));
+    restored_bytes[i] =
+        restored_full_shape.num_elements() *
+        std::max<int64>(DataTypeSize(original_dtype), 1);
     if (dtypes[i] != original_dtype) {
       string error_msg = strings::StrCat(
           "tensor_name = ", tensor_name, "; expected dtype ",
@@ -388,20 +415,38 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     }
   }
 
+  // Split the small tensors, in sorted order, into batches of about
+  // kSmallTensorBatchBytes.
+  std::vector<RestoreBatch> batches(1);
+  int64 batch_bytes = 0;
+  for (auto& op : direct_restore_ops) {
+    if (batch_bytes >= kSmallTensorBatchBytes) {
+      batches.emplace_back();
+      batch_bytes = 0;
+    }
+    batches.back().ops.push_back(op.get());
+    batches.back().reader_prefix = prefix_string;
+    batch_bytes += restored_bytes[op->idx];
+  }
+
   {
     // Schedule any threaded operations first, skipping thread pool creation if
     // we don't have any expensive operations.
     std::unique_ptr<thread::ThreadPool> reader_pool;
-    if (!pool_restore_ops.empty()) {
+    if (!pool_restore_ops.empty() || batches.size() > 1) {
       reader_pool.reset(
           new thread::ThreadPool(Env::Default(), "restore_tensors", 8));
       for (auto& op : pool_restore_ops) {
         reader_pool->Schedule([&op]() { op->run_with_new_reader(); });
       }
+      for (size_t b = 1; b < batches.size(); ++b) {
+        RestoreBatch* batch = &batches[b];
+        reader_pool->Schedule([batch]() { batch->run_with_new_reader(); });
+      }
     }
 
-    // Read small tensors from the op thread
-    for (auto& op : direct_restore_ops) {
+    // Read the first batch of small tensors from the op thread
+    for (RestoreOp* op : batches[0].ops) {
       TF_RETURN_IF_ERROR(op->run(&default_reader));
     }
   }
@@ -410,6 +455,9 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   for (auto& op : pool_restore_ops) {
     TF_RETURN_IF_ERROR(op->status);
   }
+  for (size_t b = 1; b < batches.size(); ++b) {
+    TF_RETURN_IF_ERROR(batches[b].status);
+  }
 
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
@@ -424,4 +472,134 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   return Status::OK();
 }
 
+
+Status SaveTensorsV2(const string& prefix,
+                     const std::vector<string>& tensor_names,
+                     const std::vector<string>& shape_and_slices,
+                     const std::vector<Tensor>& tensors) {
+  BundleWriter writer(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const string& tensor_name = tensor_names[i];
+    const Tensor& tensor = tensors[i];
+    VLOG(2) << "Starting save of " << tensor_name;
+
+    if (!shape_and_slices[i].empty()) {
+      const string& shape_spec = shape_and_slices[i];
+      TensorShape shape;
+      TensorSlice slice(tensor.dims());
+      TensorShape slice_shape;
+
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(shape_spec, &shape,
+                                                        &slice, &slice_shape));
+      if (!slice_shape.IsSameSize(tensor.shape())) {
+        return errors::InvalidArgument(
+            "Slice in shape_and_slice specification does not match the shape "
+            "of the tensor to  save: ",
+            shape_spec, ", tensor: ", tensor.shape().DebugString());
+      }
+
+      TF_RETURN_IF_ERROR(writer.AddSlice(tensor_name, shape, slice, tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(tensor_name, tensor));
+    }
+
+    if (VLOG_IS_ON(5)) {
+      if (tensor.dtype() == DT_FLOAT) {
+        const float* t_data = tensor.flat<float>().data();
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+        double avg = 0.0;
+        for (int i = 0; i < tensor.NumElements(); ++i) {
+          if (t_data[i] < min) min = t_data[i];
+          if (t_data[i] > max) max = t_data[i];
+          avg += t_data[i];
+        }
+        VLOG(5) << " min " << min << " max " << max << " avg "
+                << avg / tensor.NumElements() << " total elts "
+                << tensor.NumElements();
+      }
+    }
+
+    VLOG(2) << "Done save of " << tensor_name;
+  }
+  TF_RETURN_IF_ERROR(writer.Finish());
+  VLOG(1) << "Done BundleWriter, prefix_string: " << prefix;
+  return Status::OK();
+}
+
+AsyncCheckpointWriter* AsyncCheckpointWriter::Global() {
+  static AsyncCheckpointWriter* writer = new AsyncCheckpointWriter();
+  return writer;
+}
+
+AsyncCheckpointWriter::AsyncCheckpointWriter() {}
+
+void AsyncCheckpointWriter::Schedule(const std::vector<string>& prefixes,
+                                     std::function<Status()> fn) {
+  mutex_lock l(mu_);
+  // The thread is started on first use, so processes that only save
+  // synchronously do not pay for it.
+  if (thread_ == nullptr) {
+    thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "async_checkpoint_writer", [this]() { Run(); }));
+  }
+  for (const string& prefix : prefixes) {
+    ++num_pending_[prefix];
+  }
+  queue_.push_back({prefixes, std::move(fn)});
+  cv_.notify_all();
+}
+
+bool AsyncCheckpointWriter::HasPendingWrites(const string& prefix) {
+  mutex_lock l(mu_);
+  return num_pending_.contains(prefix);
+}
+
+Status AsyncCheckpointWriter::WaitForPrefix(const string& prefix) {
+  mutex_lock l(mu_);
+  while (num_pending_.contains(prefix)) {
+    cv_.wait(l);
+  }
+  auto it = errors_.find(prefix);
+  return it == errors_.end() ? Status::OK() : it->second;
+}
+
+Status AsyncCheckpointWriter::LastError(const string& prefix) {
+  mutex_lock l(mu_);
+  auto it = errors_.find(prefix);
+  return it == errors_.end() ? Status::OK() : it->second;
+}
+
+void AsyncCheckpointWriter::Run() {
+  while (true) {
+    Work work;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty()) {
+        cv_.wait(l);
+      }
+      work = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    const Status s = work.fn();
+    if (!s.ok()) {
+      LOG(ERROR) << "Asynchronous checkpoint write failed: " << s;
+    }
+    mutex_lock l(mu_);
+    for (const string& prefix : work.prefixes) {
+      if (s.ok()) {
+        errors_.erase(prefix);
+      } else {
+        errors_[prefix] = s;
+      }
+      auto it = num_pending_.find(prefix);
+      if (--it->second == 0) num_pending_.erase(it);
+    }
+    cv_.notify_all();
+  }
+}
+
 }  // namespace tensorflow
@@ -16,6 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 #define TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_writer.h"
 
@@ -68,6 +78,62 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& shape_and_slices,
                         gtl::ArraySlice<DataType> dtypes);
 
+// Writes "tensors" to a V2 checkpoint under "prefix". "shape_and_slices"
+// holds, for each tensor, either an empty string or the slice specification of
+// a partitioned tensor.
+Status SaveTensorsV2(const string& prefix,
+                     const std::vector<string>& tensor_names,
+                     const std::vector<string>& shape_and_slices,
+                     const std::vector<Tensor>& tensors);
+
+// Runs checkpoint writes on a background thread, so that SaveV2 with
+// "async_write" set can return as soon as it has copied its inputs.
+//
+// Work runs in the order it is scheduled. Ops that read or finalize a
+// checkpoint call WaitForPrefix() first, so within this process they always
+// observe a completed write.
+class AsyncCheckpointWriter {
+ public:
+  // Returns the process-wide writer.
+  static AsyncCheckpointWriter* Global();
+
+  // Schedules "fn" to run after all previously scheduled work. "prefixes" are
+  // the checkpoint prefixes that "fn" writes; an error returned by "fn" is
+  // recorded for each of them.
+  void Schedule(const std::vector<string>& prefixes,
+                std::function<Status()> fn);
+
+  // Returns true if work writing "prefix" is scheduled or running.
+  bool HasPendingWrites(const string& prefix);
+
+  // Blocks until no work writing "prefix" is pending, and returns
+  // LastError(prefix). Must not be called from scheduled work.
+  Status WaitForPrefix(const string& prefix);
+
+  // Returns the error of the last completed write to "prefix", or OK if it
+  // succeeded or there was none.
+  Status LastError(const string& prefix);
+
+ private:
+  struct Work {
+    std::vector<string> prefixes;
+    std::function<Status()> fn;
+  };
+
+  AsyncCheckpointWriter();
+
+  void Run();
+
+  mutex mu_;
+  condition_variable cv_;
+  std::deque<Work> queue_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<string, int> num_pending_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<string, Status> errors_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<Thread> thread_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncCheckpointWriter);
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_SAVE_RESTORE_TENSOR_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
@@ -88,9 +89,16 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
+//
+// With "async_write" set, the op copies its inputs and returns; the bundle is
+// written by AsyncCheckpointWriter in the background.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    if (context->HasAttr("async_write")) {
+      OP_REQUIRES_OK(context, context->GetAttr("async_write", &async_write_));
+    }
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -98,65 +106,44 @@ class SaveV2 : public OpKernel {
     const Tensor& shape_and_slices = context->input(2);
     ValidateInputs(true /* is save op */, context, prefix, tensor_names,
                    shape_and_slices);
+    if (!context->status().ok()) return;
 
     const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
     const int num_tensors = static_cast<int>(tensor_names.NumElements());
-    const string& prefix_string = prefix.scalar<tstring>()();
+    const string prefix_string = prefix.scalar<tstring>()();
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    std::vector<string> names(num_tensors);
+    std::vector<string> slices(num_tensors);
+    std::vector<Tensor> tensors(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
+      names[i] = tensor_names_flat(i);
+      slices[i] = shape_and_slices_flat(i);
       const Tensor& tensor = context->input(i + kFixedInputs);
-      VLOG(2) << "Starting save of " << tensor_name;
-
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
-
-      if (VLOG_IS_ON(5)) {
-        if (tensor.dtype() == DT_FLOAT) {
-          const float* t_data = tensor.flat<float>().data();
-          float min = std::numeric_limits<float>::infinity();
-          float max = -std::numeric_limits<float>::infinity();
-          double avg = 0.0;
-          for (int i = 0; i < tensor.NumElements(); ++i) {
-            if (t_data[i] < min) min = t_data[i];
-            if (t_data[i] > max) max = t_data[i];
-            avg += t_data[i];
-          }
-          VLOG(5) << " min " << min << " max " << max << " avg "
-                  << avg / tensor.NumElements() << " total elts "
-                  << tensor.NumElements();
-        }
-      }
+      // Asynchronous writes snapshot the inputs, since the variables they
+      // alias may be updated by later steps while the write is in progress.
+      tensors[i] = async_write_ ? tensor::DeepCopy(tensor) : tensor;
+    }
 
-      VLOG(2) << "Done save of " << tensor_name;
+    AsyncCheckpointWriter* async_writer = AsyncCheckpointWriter::Global();
+    if (!async_write_) {
+      // Do not race with an earlier asynchronous write of the same bundle.
+      async_writer->WaitForPrefix(prefix_string).IgnoreError();
+      OP_REQUIRES_OK(context,
+                     SaveTensorsV2(prefix_string, names, slices, tensors));
+      return;
     }
-    OP_REQUIRES_OK(context, writer.Finish());
-    VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
+    async_writer->Schedule(
+        {prefix_string},
+        [prefix_string, names = std::move(names), slices = std::move(slices),
+         tensors = std::move(tensors)]() {
+          return SaveTensorsV2(prefix_string, names, slices, tensors);
+        });
   }
+
+ private:
+  bool async_write_ = false;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -179,6 +166,8 @@ class RestoreV2 : public OpKernel {
                    shape_and_slices);
 
     const string& prefix_string = prefix.scalar<tstring>()();
+    OP_REQUIRES_OK(context, AsyncCheckpointWriter::Global()->WaitForPrefix(
+                                prefix_string));
 
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
@@ -233,14 +222,49 @@ class MergeV2Checkpoints : public OpKernel {
                     "Input destination_prefix should be a scalar tensor, got ",
                     destination_prefix.shape().DebugString(), " instead."));
 
-    const gtl::ArraySlice<tstring> input_prefixes =
-        gtl::ArraySlice<tstring>(checkpoint_prefixes.flat<tstring>());
+    const auto& input_prefixes_flat = checkpoint_prefixes.flat<tstring>();
+    std::vector<string> input_prefixes(input_prefixes_flat.data(),
+                                       input_prefixes_flat.data() +
+                                           input_prefixes_flat.size());
+    const string merged_prefix = destination_prefix.scalar<tstring>()();
+
+    // If any input is still being written asynchronously, merge once the
+    // writes complete instead of blocking the step.
+    AsyncCheckpointWriter* async_writer = AsyncCheckpointWriter::Global();
+    bool has_pending_writes = false;
+    for (const string& input_prefix : input_prefixes) {
+      if (async_writer->HasPendingWrites(input_prefix)) {
+        has_pending_writes = true;
+        break;
+      }
+    }
+    if (has_pending_writes) {
+      const bool delete_old_dirs = delete_old_dirs_;
+      async_writer->Schedule(
+          {merged_prefix}, [input_prefixes, merged_prefix, delete_old_dirs]() {
+            // Work runs in order, so the writes of the inputs have finished.
+            for (const string& input_prefix : input_prefixes) {
+              TF_RETURN_IF_ERROR(
+                  AsyncCheckpointWriter::Global()->LastError(input_prefix));
+            }
+            return Merge(input_prefixes, merged_prefix, delete_old_dirs);
+          });
+      return;
+    }
+    OP_REQUIRES_OK(context,
+                   Merge(input_prefixes, merged_prefix, delete_old_dirs_));
+  }
+
+ private:
+  static Status Merge(const std::vector<string>& input_prefixes,
+                      const string& merged_prefix, bool delete_old_dirs) {
     Env* env = Env::Default();
-    const string& merged_prefix = destination_prefix.scalar<tstring>()();
-    OP_REQUIRES_OK(
-        context, tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
+    std::vector<tstring> prefixes(input_prefixes.begin(),
+                                  input_prefixes.end());
+    TF_RETURN_IF_ERROR(
+        tensorflow::MergeBundles(env, prefixes, merged_prefix));
 
-    if (delete_old_dirs_) {
+    if (delete_old_dirs) {
       const string merged_dir(io::Dirname(merged_prefix));
       for (const string& input_prefix : input_prefixes) {
         const string dirname(io::Dirname(input_prefix));
@@ -251,9 +275,9 @@ class MergeV2Checkpoints : public OpKernel {
         if (!status.ok()) VLOG(1) << status;
       }
     }
+    return Status::OK();
   }
 
- private:
   // On merge, whether or not to delete the input (temporary) directories.
   bool delete_old_dirs_;
 };
@@ -23,6 +23,8 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <algorithm>
+#include <numeric>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -38,6 +40,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/util.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -340,11 +344,39 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     if (data.size() == 0) {
       return;
     }
+    // Minimum number of input values for which rows are bucketed by segment
+    // and reduced in parallel.
+    constexpr int64 kMinParallelReductionSize = 32768;
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
     const int64 N = segment_ids.dimension(0);
     const int64 num_segments = output.dimension(0);
+    const int64 num_cols = data.dimension(1);
     ReductionF reduction;
+    if (N * num_cols < kMinParallelReductionSize || device.numThreads() <= 1) {
+      for (int64 i = 0; i < N; ++i) {
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (j < 0) {
+          continue;
+        }
+        OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
+                    errors::InvalidArgument(
+                        "segment_ids", SliceDebugString(segment_ids_shape, i),
+                        " = ", j, " is out of range [0, ", num_segments, ")"));
+        reduction(data.template chip<0>(i), output.template chip<0>(j));
+      }
+      return;
+    }
+
+    // Bucket the rows by segment with a stable counting sort. Every segment
+    // is then reduced by a single thread, in the original row order, so the
+    // result is bitwise identical to the serial loop above regardless of the
+    // number of threads, and no atomics are needed.
+    std::vector<Index> ids(N);
+    std::vector<int64> segment_offsets(num_segments + 1, 0);
     for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
+      const Index j = internal::SubtleMustCopy(segment_ids(i));
+      ids[i] = j;
       if (j < 0) {
         continue;
       }
@@ -352,8 +384,32 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
                       " = ", j, " is out of range [0, ", num_segments, ")"));
-      reduction(data.template chip<0>(i), output.template chip<0>(j));
+      ++segment_offsets[j + 1];
+    }
+    std::partial_sum(segment_offsets.begin(), segment_offsets.end(),
+                     segment_offsets.begin());
+    std::vector<int64> rows(segment_offsets[num_segments]);
+    {
+      std::vector<int64> next_row(segment_offsets.begin(),
+                                  segment_offsets.end() - 1);
+      for (int64 i = 0; i < N; ++i) {
+        if (ids[i] >= 0) rows[next_row[ids[i]]++] = i;
+      }
     }
+
+    const double rows_per_segment =
+        static_cast<double>(rows.size()) / num_segments;
+    const Eigen::TensorOpCost cost(
+        rows_per_segment * num_cols * sizeof(T), num_cols * sizeof(T),
+        rows_per_segment * num_cols * Eigen::TensorOpCost::AddCost<T>());
+    device.parallelFor(num_segments, cost, [&](int64 begin, int64 end) {
+      for (int64 j = begin; j < end; ++j) {
+        auto out = output.template chip<0>(j);
+        for (int64 k = segment_offsets[j]; k < segment_offsets[j + 1]; ++k) {
+          reduction(data.template chip<0>(rows[k]), out);
+        }
+      }
+    });
   }
 };
 
@@ -531,12 +587,14 @@ class SparseSegmentReductionOpBase : public OpKernel {
     }
     auto temp_flat = temp.flat_outer_dims<float>();
 
-    int64 start = 0, end = 1;
-    // Index from which the output is not initialized.
-    SegmentId uninitialized_index = 0;
+    // Validate the segment ids and find the range of indices of each segment.
+    // Segments are then reduced independently of each other, so that they can
+    // be sharded across threads without changing the result.
+    std::vector<int64> segment_starts;
+    std::vector<SegmentId> segment_out_indices;
+    int64 start = 0;
     SegmentId out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    while (true) {
+    for (int64 end = 1;; ++end) {
       // We initialize next_index to 0 to avoid "warning: 'next_index' may be
       // used uninitialized in this function" in the Mac build (since the
       // compiler isn't smart enough to realize the code is safe).
@@ -544,7 +602,6 @@ class SparseSegmentReductionOpBase : public OpKernel {
       if (end < num_indices) {
         next_index = internal::SubtleMustCopy(segment_vec(end));
         if (out_index == next_index) {
-          ++end;
           continue;
         }
         // We have a new segment here.  Verify that the segment ids are growing.
@@ -558,33 +615,86 @@ class SparseSegmentReductionOpBase : public OpKernel {
               "Segment id ", out_index, " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
 
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(default_value_);
-      }
-
-      auto out = output_flat.template chip<0>(out_index);
-      auto temp = temp_flat.template chip<0>(out_index);
-      const int bad_offset = Reduce<T, Index>(input_flat, indices_vec, start,
-                                              end - start, out, temp);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset,
-                      "] == ", indices_vec(start + bad_offset),
-                      " out of range [0, ", input_flat.dimension(0), ")"));
-
+      segment_starts.push_back(start);
+      segment_out_indices.push_back(out_index);
       start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
       out_index = next_index;
-      if (end > num_indices) break;
+      if (end == num_indices) break;
     }
+    segment_starts.push_back(num_indices);
+    const int64 num_segments = segment_out_indices.size();
+
+    // Smallest position in `indices` holding an out of range index.
+    mutex mu;
+    int64 bad_index = num_indices;
+
+    auto reduce_segments = [&](int64 first_segment, int64 last_segment) {
+      // Index of the first row that has not been prefetched yet.
+      int64 prefetch_index = segment_starts[first_segment];
+      const int64 prefetch_end = segment_starts[last_segment];
+
+      for (int64 k = first_segment; k < last_segment; ++k) {
+        const SegmentId segment_id = segment_out_indices[k];
+        // Index from which the output is not initialized.
+        const SegmentId uninitialized_index =
+            k == 0 ? 0 : segment_out_indices[k - 1] + 1;
+
+        // If there is a gap between two indices, we need to set that gap to
+        // the default value.
+        if (segment_id > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              segment_id - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice.setConstant(default_value_);
+        }
 
+        // Rows are gathered from random positions of `input`, so issue the
+        // loads for the rows of the next few indices while this segment is
+        // being reduced.
+        const int64 segment_start = segment_starts[k];
+        const int64 segment_end = segment_starts[k + 1];
+        const int64 prefetch_limit =
+            std::min<int64>(prefetch_end, segment_end + kPrefetchRows);
+        for (; prefetch_index < prefetch_limit; ++prefetch_index) {
+          PrefetchRow(input_flat, indices_vec(prefetch_index));
+        }
+
+        auto out = output_flat.template chip<0>(segment_id);
+        auto temp = temp_flat.template chip<0>(segment_id);
+        const int bad_offset =
+            Reduce<T, Index>(input_flat, indices_vec, segment_start,
+                             segment_end - segment_start, out, temp);
+        if (bad_offset >= 0) {
+          mutex_lock l(mu);
+          bad_index = std::min(bad_index, segment_start + bad_offset);
+          return;
+        }
+      }
+    };
+
+    // Every segment is reduced by a single thread in the same order, so the
+    // result does not depend on the number of threads.
+    const CPUDevice& device = context->eigen_device<CPUDevice>();
+    if (num_indices * num_col < kMinParallelReductionSize ||
+        device.numThreads() <= 1) {
+      reduce_segments(0, num_segments);
+    } else {
+      const double indices_per_segment =
+          static_cast<double>(num_indices) / num_segments;
+      const Eigen::TensorOpCost cost(
+          indices_per_segment * num_col * sizeof(T), num_col * sizeof(T),
+          indices_per_segment * num_col * Eigen::TensorOpCost::AddCost<T>());
+      device.parallelFor(num_segments, cost, reduce_segments);
+    }
+    OP_REQUIRES(context, bad_index == num_indices,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_index, "] == ", indices_vec(bad_index),
+                    " out of range [0, ", input_flat.dimension(0), ")"));
+
+    const SegmentId uninitialized_index =
+        segment_out_indices[num_segments - 1] + 1;
     // Fill the gap at the end with the default value.
     if (uninitialized_index < output_rows) {
       Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
@@ -596,6 +706,28 @@ class SparseSegmentReductionOpBase : public OpKernel {
   }
 
  private:
+  // Number of indices ahead of the current segment whose rows are prefetched,
+  // and the maximum number of bytes prefetched from each row.
+  static constexpr int64 kPrefetchRows = 16;
+  static constexpr int64 kPrefetchBytesPerRow = 512;
+  // Minimum number of gathered values for which segments are reduced in
+  // parallel.
+  static constexpr int64 kMinParallelReductionSize = 32768;
+
+  static void PrefetchRow(const typename TTypes<T>::ConstMatrix& input_flat,
+                          Index row) {
+    if (input_flat.dimension(1) == 0 ||
+        !FastBoundsCheck(row, input_flat.dimension(0))) {
+      return;
+    }
+    const char* data = reinterpret_cast<const char*>(&input_flat(row, 0));
+    int64 num_bytes = input_flat.dimension(1) * sizeof(T);
+    if (num_bytes > kPrefetchBytesPerRow) num_bytes = kPrefetchBytesPerRow;
+    for (int64 offset = 0; offset < num_bytes; offset += 64) {
+      port::prefetch<port::PREFETCH_HINT_T0>(data + offset);
+    }
+  }
+
   template <typename Tin>
   using EnableIfBfloat16 =
       typename std::enable_if<std::is_same<Tin, bfloat16>::value, int>::type;
@@ -200,4 +200,80 @@ BENCHMARK(BM_SparseSegmentMeanGrad_High_BF16)
     ->Arg(1000)
     ->Arg(100000);
 
+
+// Reduces `num_indices` rows of width `num_cols` into `num_indices / 8`
+// segments, with the rows of each segment spread over the whole input.
+static void BM_UnsortedSegmentSum(::testing::benchmark::State& state) {
+  const int num_indices = state.range(0);
+  const int num_cols = state.range(1);
+  const int num_segments = num_indices / 8;
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({num_indices, num_cols}));
+  input.flat<float>().setRandom();
+  Tensor segment_ids(DT_INT32, TensorShape({num_indices}));
+  auto segment_ids_flat = segment_ids.flat<int32>();
+  for (int i = 0; i < num_indices; ++i) {
+    segment_ids_flat(i) = (i * 7919) % num_segments;
+  }
+  Tensor num_segments_t(DT_INT32, TensorShape({}));
+  num_segments_t.scalar<int32>()() = num_segments;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UnsortedSegmentSum")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Input(test::graph::Constant(g, num_segments_t))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetBytesProcessed(static_cast<int64>(state.iterations()) *
+                          num_indices * num_cols * sizeof(float));
+}
+
+BENCHMARK(BM_UnsortedSegmentSum)
+    ->UseRealTime()
+    ->ArgPair(1 << 16, 8)
+    ->ArgPair(1 << 20, 8)
+    ->ArgPair(1 << 20, 64);
+
+// Gathers `num_indices` random rows of width `num_cols` into sorted segments
+// of 8 rows each.
+static void BM_SparseSegmentSum(::testing::benchmark::State& state) {
+  const int num_indices = state.range(0);
+  const int num_cols = state.range(1);
+  const int num_rows = num_indices / 4;
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({num_rows, num_cols}));
+  input.flat<float>().setRandom();
+  Tensor indices(DT_INT32, TensorShape({num_indices}));
+  auto indices_flat = indices.flat<int32>();
+  Tensor segment_ids(DT_INT32, TensorShape({num_indices}));
+  auto segment_ids_flat = segment_ids.flat<int32>();
+  for (int i = 0; i < num_indices; ++i) {
+    indices_flat(i) = (i * 7919) % num_rows;
+    segment_ids_flat(i) = i / 8;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetBytesProcessed(static_cast<int64>(state.iterations()) *
+                          num_indices * num_cols * sizeof(float));
+}
+
+BENCHMARK(BM_SparseSegmentSum)
+    ->UseRealTime()
+    ->ArgPair(1 << 16, 8)
+    ->ArgPair(1 << 20, 8)
+    ->ArgPair(1 << 20, 64);
+
 }  // namespace tensorflow
@@ -291,19 +291,19 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
     // rows in each batch.
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int32 num_threads = worker_threads.num_threads;
-    const int64 block_size =
-        num_lhs_rows / std::max(kMaxShards, kNumShardsPerThread * num_threads);
+    const std::vector<int64> shards =
+        NnzBalancedShards(lhs, batch_size, num_lhs_rows, num_threads);
     const int64 num_rhs_rows = rhs.dim_size(rhs.dims() - 2);
     const int64 num_rhs_cols = rhs.dim_size(rhs.dims() - 1);
     worker_threads.workers->ParallelFor(
-        batch_size * num_lhs_rows /* total */,
+        shards.size() - 1 /* total */,
         thread::ThreadPool::SchedulingParams(
             thread::ThreadPool::SchedulingStrategy::
                 kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64 batch_and_row_begin, int64 batch_and_row_end) {
+            absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+        [&](int64 shard_begin, int64 shard_end) {
           HandleBatchAndRowRange(
-              num_lhs_rows, batch_and_row_begin, batch_and_row_end,
+              num_lhs_rows, shards[shard_begin], shards[shard_end],
               [&](int64 batch_idx, int64 row_begin, int64 row_end) {
                 const int64 num_shard_rows = row_end - row_begin;
 
@@ -364,17 +364,17 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
 
     // Parallelize matrix multiplication across batch dimensions and across
     // columns of A^T in each batch. These correspond to rows of A.
-    const int64 block_size =
-        num_lhs_cols / std::max(kMaxShards, kNumShardsPerThread * num_threads);
+    const std::vector<int64> shards =
+        NnzBalancedShards(lhs, batch_size, num_lhs_cols, num_threads);
     worker_threads.workers->ParallelForWithWorkerId(
-        batch_size * num_lhs_cols /* total */,
+        shards.size() - 1 /* total */,
         thread::ThreadPool::SchedulingParams(
             thread::ThreadPool::SchedulingStrategy::
                 kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64 batch_and_row_begin, int64 batch_and_row_end, int tid) {
+            absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+        [&](int64 shard_begin, int64 shard_end, int tid) {
           HandleBatchAndRowRange(
-              num_lhs_cols, batch_and_row_begin, batch_and_row_end,
+              num_lhs_cols, shards[shard_begin], shards[shard_end],
               [&](int64 batch_idx, int64 row_begin, int64 row_end) {
                 const int64 num_shard_rows = row_end - row_begin;
 
@@ -418,6 +418,49 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
         Eigen::array<Index, 1>({0}), Reducer());
   }
 
+  // Splits the rows of all batches of `matrix`, flattened into
+  // [0, batch_size * num_rows), into contiguous shards of roughly equal cost,
+  // where a row costs its number of nonzeros plus one. Splitting by row count
+  // alone balances badly on power-law matrices such as graph adjacencies,
+  // where a few rows hold most of the nonzeros. Returns the shard boundaries,
+  // starting at 0 and ending at batch_size * num_rows.
+  std::vector<int64> NnzBalancedShards(const CSRSparseMatrix& matrix,
+                                       const int64 batch_size,
+                                       const int64 num_rows,
+                                       const int32 num_threads) {
+    const int64 total_rows = batch_size * num_rows;
+    const int64 num_shards = std::min(
+        total_rows,
+        batch_size * std::max(kMaxShards, kNumShardsPerThread * num_threads));
+    // Cost of the flattened rows before `row`.
+    auto cost_before = [&](int64 row) -> int64 {
+      if (row == total_rows) return matrix.total_nnz() + total_rows;
+      const int64 batch_idx = row / num_rows;
+      return matrix.batch_offset(batch_idx) +
+             matrix.row_pointers_vec(batch_idx)(row % num_rows) + row;
+    };
+    const int64 total_cost = cost_before(total_rows);
+
+    std::vector<int64> shards = {0};
+    for (int64 shard = 1; shard < num_shards; ++shard) {
+      const int64 target = total_cost * shard / num_shards;
+      // Find the first row whose preceding cost reaches the target.
+      int64 lo = shards.back();
+      int64 hi = total_rows;
+      while (lo < hi) {
+        const int64 mid = lo + (hi - lo) / 2;
+        if (cost_before(mid) < target) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      if (lo > shards.back()) shards.push_back(lo);
+    }
+    if (total_rows > 0) shards.push_back(total_rows);
+    return shards;
+  }
+
   // Given a range [batch_and_row_begin, batch_and_row_end) which is a
   // contiguous subset of [0, num_rows * batch_size), calls the function
   // fn(batch_idx, row_begin, row_end) for each batch index
@@ -19,6 +19,9 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_xent_op.h"
 
+#include <algorithm>
+#include <type_traits>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -135,19 +138,93 @@ class SparseSoftmaxXentWithLogitsOp : public OpKernel {
   }
 };
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
 namespace functor {
+
+// Row-wise CPU implementation. Every row is reduced and rewritten in blocks
+// while it is still in cache, and nothing the size of the logits is allocated:
+// the shifted exponentials are written straight into backprop, which may alias
+// logits. Labels must already have been checked to be in range.
+template <typename T, typename Index>
+struct SparseXentRowwiseImpl {
+  static void Compute(OpKernelContext* ctx,
+                      typename TTypes<T>::ConstMatrix logits,
+                      typename TTypes<Index>::ConstVec labels,
+                      typename TTypes<T>::Vec loss,
+                      typename TTypes<T>::Matrix backprop) {
+    using ConstRow = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+    using Row = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+    const int64 batch_size = logits.dimension(0);
+    const int64 num_classes = logits.dimension(1);
+    // Classes per block; the exponentials of a block stay in L1 between the
+    // sweep that writes them and the reduction that reads them back.
+    constexpr int64 kBlockSize = 2048;
+
+    auto compute_rows = [&](int64 begin, int64 end) {
+      for (int64 b = begin; b < end; ++b) {
+        const T* logits_row = &logits(b, 0);
+        T* backprop_row = &backprop(b, 0);
+        const Index label = internal::SubtleMustCopy(labels(b));
+
+        T max_logit = Eigen::NumTraits<T>::lowest();
+        for (int64 j = 0; j < num_classes; j += kBlockSize) {
+          const int64 n = std::min(kBlockSize, num_classes - j);
+          max_logit =
+              std::max(max_logit, ConstRow(logits_row + j, n).maxCoeff());
+        }
+        // Read before the sweep below, since backprop may alias logits.
+        const T label_logit = logits_row[label] - max_logit;
+
+        T sum_exp(0);
+        for (int64 j = 0; j < num_classes; j += kBlockSize) {
+          const int64 n = std::min(kBlockSize, num_classes - j);
+          Row exp_logits(backprop_row + j, n);
+          exp_logits = (ConstRow(logits_row + j, n) - max_logit).exp();
+          sum_exp += exp_logits.sum();
+        }
+
+        // log(sum(exp(logits - max_logits))) - (logits - max_logits)[label]
+        loss(b) = Eigen::numext::log(sum_exp) - label_logit;
+
+        // backprop: prob - 1{ j == label }.
+        const T inv_sum_exp = T(1) / sum_exp;
+        for (int64 j = 0; j < num_classes; j += kBlockSize) {
+          const int64 n = std::min(kBlockSize, num_classes - j);
+          Row(backprop_row + j, n) *= inv_sum_exp;
+        }
+        backprop_row[label] -= T(1);
+      }
+    };
+
+    const double exp_cost =
+        Eigen::internal::functor_traits<Eigen::internal::scalar_exp_op<T>>::Cost;
+    const Eigen::TensorOpCost cost(
+        3 * num_classes * sizeof(T), 2 * num_classes * sizeof(T),
+        num_classes * (exp_cost + 3 * Eigen::TensorOpCost::AddCost<T>() +
+                       Eigen::TensorOpCost::MulCost<T>()));
+    ctx->eigen_device<CPUDevice>().parallelFor(batch_size, cost, compute_rows);
+  }
+};
+
+// Partial specialization for a CPUDevice. Half precision uses the Eigen
+// implementation from SparseXentEigenImpl, whose tree reductions lose less
+// precision than accumulating whole rows in half.
 template <typename T, typename Index>
 struct SparseXentFunctor<CPUDevice, T, Index> {
   void operator()(OpKernelContext* ctx, typename TTypes<T>::ConstMatrix logits,
                   typename TTypes<Index>::ConstVec labels,
                   typename TTypes<T>::Vec scratch, typename TTypes<T>::Vec loss,
                   typename TTypes<T>::Matrix backprop) {
-    SparseXentEigenImpl<CPUDevice, T, Index>::Compute(ctx, logits, labels,
-                                                      scratch, loss, backprop);
+    if (std::is_same<T, Eigen::half>::value) {
+      SparseXentEigenImpl<CPUDevice, T, Index>::Compute(
+          ctx, logits, labels, scratch, loss, backprop);
+      return;
+    }
+    SparseXentRowwiseImpl<T, Index>::Compute(ctx, logits, labels, loss,
+                                             backprop);
   }
 };
+
 }  // namespace functor
 
 #define REGISTER(Dev, T, Index)                   \
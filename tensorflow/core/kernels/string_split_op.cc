@@ -15,7 +15,9 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -24,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -62,10 +65,15 @@ std::vector<StringPiece> SplitOnCharSet(const tstring& str,
                                         const tstring& delim_set, Predicate p) {
   std::vector<StringPiece> result;
   StringPiece text(str);
-  StringPiece delims(delim_set);
+  // A byte lookup table instead of searching `delim_set` for every input byte.
+  bool is_delim[256] = {};
+  for (const char c : delim_set) {
+    is_delim[static_cast<unsigned char>(c)] = true;
+  }
   size_t token_start = 0;
   for (size_t i = 0; i < text.size() + 1; i++) {
-    if ((i == text.size()) || (delims.find(text[i]) != StringPiece::npos)) {
+    if ((i == text.size()) ||
+        is_delim[static_cast<unsigned char>(text[i])]) {
       StringPiece token(text.data() + token_start, i - token_start);
       if (p(token)) {
         result.emplace_back(token);
@@ -139,24 +147,90 @@ std::vector<StringPiece> SplitV2(const tstring& str, StringPiece sep,
     }
     return result;
   }
-  auto p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
+  // StringPiece::find looks for the first byte of `sep` with memchr, which is
+  // vectorized, instead of comparing byte by byte like std::search.
+  size_t pos = text.find(sep);
   int split = 0;
-  while (p != text.end()) {
-    StringPiece token = text.substr(0, p - text.begin());
-    result.push_back(token);
-    text.remove_prefix(token.size());
-    text.remove_prefix(sep.size());
+  while (pos != StringPiece::npos) {
+    result.push_back(text.substr(0, pos));
+    text.remove_prefix(pos + sep.size());
     ++split;
     if (maxsplit > 0 && split == maxsplit) {
       result.push_back(StringPiece(text));
       return result;
     }
-    p = std::search(text.begin(), text.end(), sep.begin(), sep.end());
+    pos = text.find(sep);
   }
   result.push_back(text);
   return result;
 }
 
+// Splits every string of `input_vec` with `split`, a callable returning the
+// tokens of one string as a std::vector<StringPiece>, and writes them as the
+// indices, values and dense shape outputs of a SparseTensor. Strings are split
+// and written out in parallel; the tokens point into the input buffer until
+// they are copied, once, into the output tensor.
+template <typename SplitFn>
+void SplitToSparseTensor(OpKernelContext* ctx,
+                         TTypes<tstring>::ConstVec input_vec,
+                         const SplitFn& split) {
+  const int64 batch_size = input_vec.dimension(0);
+  int64 total_bytes = 0;
+  for (int64 i = 0; i < batch_size; ++i) {
+    total_bytes += input_vec(i).size();
+  }
+  // A fixed overhead per string plus a few cycles per byte to scan and copy.
+  const int64 cost_per_unit =
+      100 + 4 * total_bytes / std::max<int64>(batch_size, 1);
+  auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+
+  std::vector<std::vector<StringPiece>> tokens(batch_size);
+  Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+        cost_per_unit, [&](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            tokens[i] = split(input_vec(i));
+          }
+        });
+
+  // Offset of the first token of each string in the outputs.
+  std::vector<int64> row_starts(batch_size + 1, 0);
+  int64 max_num_entries = 0;
+  for (int64 i = 0; i < batch_size; ++i) {
+    const int64 n_entries = tokens[i].size();
+    row_starts[i + 1] = row_starts[i] + n_entries;
+    max_num_entries = std::max(max_num_entries, n_entries);
+  }
+  const int64 output_size = row_starts[batch_size];
+
+  Tensor* sp_indices_t;
+  OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
+                                           &sp_indices_t));
+  Tensor* sp_tokens_t;
+  OP_REQUIRES_OK(
+      ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
+  Tensor* sp_shape_t;
+  OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
+
+  auto sp_indices = sp_indices_t->matrix<int64>();
+  auto sp_tokens = sp_tokens_t->vec<tstring>();
+  auto sp_shape = sp_shape_t->vec<int64>();
+  sp_shape(0) = batch_size;
+  sp_shape(1) = max_num_entries;
+  Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+        cost_per_unit, [&](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            const std::vector<StringPiece>& row_tokens = tokens[i];
+            int64 c = row_starts[i];
+            for (int64 j = 0; j < row_tokens.size(); ++j) {
+              sp_indices(c, 0) = i;
+              sp_indices(c, 1) = j;
+              sp_tokens(c).assign(row_tokens[j].data(), row_tokens[j].size());
+              ++c;
+            }
+          }
+        });
+}
+
 }  // namespace
 
 class StringSplitOp : public OpKernel {
@@ -179,7 +253,6 @@ class StringSplitOp : public OpKernel {
                                         input_tensor->shape().DebugString()));
 
     const auto input_vec = input_tensor->vec<tstring>();
-    const int64 batch_size = input_vec.dimension(0);
 
     const Tensor* delimiter_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("delimiter", &delimiter_tensor));
@@ -190,48 +263,14 @@ class StringSplitOp : public OpKernel {
     const auto delimiter_vec = delimiter_tensor->flat<tstring>();
     const tstring& delimiter = delimiter_vec(0);
     // Empty delimiter means split the input character by character.
-    std::vector<StringPiece> tokens;
-    // Guess that we'll be unpacking a handful of tokens per example.
-    static constexpr int kReserveSize = 4;
-    tokens.reserve(batch_size * kReserveSize);
-
-    int64 output_size = 0;
-    int64 max_num_entries = 0;
-    std::vector<int64> num_indices(batch_size);
-    for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<StringPiece> parts =
-          skip_empty_ ? Split(input_vec(i), delimiter, str_util::SkipEmpty())
-                      : Split(input_vec(i), delimiter, str_util::AllowEmpty());
-      int64 n_entries = parts.size();
-      num_indices[i] = n_entries;
-      output_size += n_entries;
-      max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), std::make_move_iterator(parts.begin()),
-                    std::make_move_iterator(parts.end()));
-    }
-
-    Tensor* sp_indices_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
-                                             &sp_indices_t));
-    Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
-    Tensor* sp_shape_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
-
-    auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<tstring>();
-    auto sp_shape = sp_shape_t->vec<int64>();
-    sp_shape(0) = batch_size;
-    sp_shape(1) = max_num_entries;
-    size_t c = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-      for (size_t j = 0; j < num_indices[i]; ++j) {
-        sp_indices(c, 0) = i;
-        sp_indices(c, 1) = j;
-        sp_tokens(c).assign(tokens[c].data(), tokens[c].size());
-        ++c;
-      }
+    if (skip_empty_) {
+      SplitToSparseTensor(ctx, input_vec, [&delimiter](const tstring& str) {
+        return Split(str, delimiter, str_util::SkipEmpty());
+      });
+    } else {
+      SplitToSparseTensor(ctx, input_vec, [&delimiter](const tstring& str) {
+        return Split(str, delimiter, str_util::AllowEmpty());
+      });
     }
   }
 
@@ -254,7 +293,6 @@ class StringSplitV2Op : public OpKernel {
                                         input_tensor->shape().DebugString()));
 
     const auto input_vec = input_tensor->vec<tstring>();
-    const int64 batch_size = input_vec.dimension(0);
 
     const Tensor* sep_tensor;
     OP_REQUIRES_OK(ctx, ctx->input("sep", &sep_tensor));
@@ -263,46 +301,9 @@ class StringSplitV2Op : public OpKernel {
                                         sep_tensor->shape().DebugString()));
     const auto sep_vec = sep_tensor->flat<tstring>();
     StringPiece sep(sep_vec(0));
-    std::vector<StringPiece> tokens;
-    // Guess that we'll be unpacking a handful of tokens per example.
-    static constexpr int kReserveSize = 4;
-    tokens.reserve(batch_size * kReserveSize);
-
-    int64 output_size = 0;
-    int64 max_num_entries = 0;
-    std::vector<int64> num_indices(batch_size);
-    for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<StringPiece> parts = SplitV2(input_vec(i), sep, maxsplit_);
-      int64 n_entries = parts.size();
-      num_indices[i] = n_entries;
-      output_size += n_entries;
-      max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
-    }
-
-    Tensor* sp_indices_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
-                                             &sp_indices_t));
-    Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
-    Tensor* sp_shape_t;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
-
-    auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<tstring>();
-    auto sp_shape = sp_shape_t->vec<int64>();
-    sp_shape(0) = batch_size;
-    sp_shape(1) = max_num_entries;
-    size_t c = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-      for (size_t j = 0; j < num_indices[i]; ++j) {
-        sp_indices(c, 0) = i;
-        sp_indices(c, 1) = j;
-        sp_tokens(c).assign(tokens[c].data(), tokens[c].size());
-        ++c;
-      }
-    }
+    SplitToSparseTensor(ctx, input_vec, [sep, this](const tstring& str) {
+      return SplitV2(str, sep, maxsplit_);
+    });
   }
 
  private:
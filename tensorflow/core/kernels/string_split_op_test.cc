@@ -93,7 +93,8 @@ BENCHMARK(BM_StringSplit)
     ->Arg(32)
     ->Arg(64)
     ->Arg(128)
-    ->Arg(256);
+    ->Arg(256)
+    ->Arg(4096);
 
 Graph* SetupStringSplitV2Graph(const Tensor& input) {
   Graph* g = new Graph(OpRegistry::Global());
@@ -124,6 +125,7 @@ BENCHMARK(BM_StringSplitV2)
     ->Arg(32)
     ->Arg(64)
     ->Arg(128)
-    ->Arg(256);
+    ->Arg(256)
+    ->Arg(4096);
 
 }  // end namespace tensorflow
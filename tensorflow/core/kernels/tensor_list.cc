@@ -51,6 +51,32 @@ void TensorList::Encode(VariantTensorData* data) const {
   data->set_metadata(metadata);
 }
 
+bool TensorList::StackFromPage(Tensor* stacked) const {
+  const Tensor& page = tensors_->page_;
+  const std::vector<Tensor>& values = tensors_->values_;
+  if (values.empty() || page.dtype() != element_dtype ||
+      !DataTypeCanUseMemcpy(page.dtype()) || page.dims() == 0 ||
+      page.dim_size(0) < static_cast<int64>(values.size())) {
+    return false;
+  }
+  TensorShape row_shape = page.shape();
+  row_shape.RemoveDim(0);
+  const size_t row_bytes =
+      row_shape.num_elements() * DataTypeSize(page.dtype());
+  const char* base = page.tensor_data().data();
+  for (size_t i = 0; i < values.size(); ++i) {
+    const Tensor& t = values[i];
+    if (t.dtype() != page.dtype() || t.shape() != row_shape ||
+        t.tensor_data().data() != base + i * row_bytes) {
+      return false;
+    }
+  }
+  *stacked = static_cast<int64>(values.size()) == page.dim_size(0)
+                 ? page
+                 : page.Slice(0, values.size());
+  return true;
+}
+
 static Status TensorListDeviceCopy(
     const TensorList& from, TensorList* to,
     const UnaryVariantOpRegistry::AsyncTensorDeviceCopyFn& copy) {
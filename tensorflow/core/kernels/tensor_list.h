@@ -134,9 +134,21 @@ class TensorList {
     out.max_num_elements = max_num_elements;
     // This performs a copy of the std::vector.
     out.tensors_->values_ = tensors_->values_;
+    out.tensors_->page_ = tensors_->page_;
     return out;
   }
 
+  // Records `page`, a tensor whose slices along dimension 0 back the list
+  // elements, e.g. the input of TensorListFromTensor when the elements alias
+  // its rows. The elements remain the source of truth: kernels that modify
+  // `tensors()` do not need to update the page.
+  void set_page(const Tensor& page) { tensors_->page_ = page; }
+
+  // If the elements are, in order, views of the leading rows of the page,
+  // stores a tensor aliasing those rows in `stacked` and returns true. This
+  // lets TensorListStack return without copying any element.
+  bool StackFromPage(Tensor* stacked) const;
+
   // Is this TensorList the only one with a reference to the underlying
   // container?
   bool RefCountIsOne() const { return tensors_->RefCountIsOne(); }
@@ -145,6 +157,7 @@ class TensorList {
   class Tensors : public core::RefCounted {
    public:
     std::vector<Tensor> values_;
+    Tensor page_;
   };
   Tensors* tensors_;
 };
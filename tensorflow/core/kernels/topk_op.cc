@@ -99,6 +99,38 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+// Minimum number of columns of a row worth a thread of their own, see
+// TopKFunctor<CPUDevice, T>::ComputeWithRowShards.
+constexpr int64 kMinColumnsPerRowShard = 1 << 16;
+
+// Pushes the columns [begin, end) of a row into `filter`, in order. Once
+// `filter` is full, blocks of columns whose values are all no greater than its
+// bottom value are skipped: the columns come after every column in `filter`,
+// so they would lose ties and be dropped anyway. Checking a block is a
+// branch-free reduction which vectorizes, so long runs of losers are cheap.
+template <typename T, typename Filter>
+void PushColumns(const T* input_data, int32 begin, int32 end, Filter* filter) {
+  constexpr int32 kBlockSize = 64;
+  int32 c = begin;
+  while (c < end) {
+    const int32 block_end = std::min(end, c + kBlockSize);
+    if (filter->size() == filter->limit()) {
+      const T threshold = input_data[filter->peek_bottom()];
+      bool any_greater = false;
+      for (int32 i = c; i < block_end; ++i) {
+        any_greater |= input_data[i] > threshold;
+      }
+      if (!any_greater) {
+        c = block_end;
+        continue;
+      }
+    }
+    for (; c < block_end; ++c) {
+      filter->push(c);
+    }
+  }
+}
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -182,9 +214,7 @@ struct TopKFunctor<CPUDevice, T> {
           // Use the TopN heap object to sort.
           gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
           filter.reserve(num_cols);
-          for (int32 c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
+          PushColumns(input_data, 0, num_cols, &filter);
 
           int32 i = 0;
           if (sorted) {
@@ -222,11 +252,100 @@ struct TopKFunctor<CPUDevice, T> {
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // With fewer rows than threads, split wide rows into column ranges of at
+    // least kMinColumnsPerRowShard columns, which are worth a thread each.
+    const int64 num_row_shards =
+        k == num_cols
+            ? 1
+            : std::min((worker_threads.num_threads + num_rows - 1) / num_rows,
+                       num_cols / std::max<int64>(kMinColumnsPerRowShard,
+                                                  8 * static_cast<int64>(k)));
+    if (num_row_shards > 1) {
+      return ComputeWithRowShards(context, k, input, num_rows, num_cols,
+                                  num_row_shards, sort_cost / num_row_shards,
+                                  values, indices);
+    }
+
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return Status::OK();
   }
+
+ private:
+  // Computes the top k of each row by splitting the row into `num_row_shards`
+  // column ranges, computing the top k of each range in parallel, then merging
+  // the candidates of the ranges. The result is always sorted, which is also a
+  // valid result for `sorted` == false.
+  static Status ComputeWithRowShards(
+      OpKernelContext* context, int k,
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,
+      const int64 num_cols, const int64 num_row_shards,
+      const double row_shard_cost, typename TTypes<T, 2>::Tensor values,
+      typename TTypes<int, 2>::Tensor indices) {
+    const int64 num_candidates = num_row_shards * k;
+    Tensor candidates_tensor;
+    TF_RETURN_IF_ERROR(context->allocate_temp(
+        DT_INT32, TensorShape({num_rows, num_candidates}),
+        &candidates_tensor));
+    auto candidates = candidates_tensor.matrix<int32>();
+
+    const auto make_comp = [&input](int64 row) {
+      const T* input_data = &input(row, 0);
+      // Orders by decreasing value, then by increasing column.
+      return [input_data](const int32 a, const int32 b) {
+        if (input_data[b] < input_data[a]) {
+          return true;
+        } else if (input_data[b] > input_data[a]) {
+          return false;
+        } else {
+          return a < b;
+        }
+      };
+    };
+
+    auto FindCandidates = [&](int64 start, int64 limit) {
+      for (int64 i = start; i < limit; ++i) {
+        const int64 row = i / num_row_shards;
+        const int64 row_shard = i % num_row_shards;
+        const int32 begin = num_cols * row_shard / num_row_shards;
+        const int32 end = num_cols * (row_shard + 1) / num_row_shards;
+        const auto comp = make_comp(row);
+        gtl::TopN<int32, decltype(comp)> filter(k, comp);
+        filter.reserve(end - begin);
+        PushColumns(&input(row, 0), begin, end, &filter);
+        // Each range has at least k columns, so it yields k candidates.
+        std::copy(filter.unsorted_begin(), filter.unsorted_end(),
+                  &candidates(row, row_shard * k));
+      }
+    };
+
+    auto MergeCandidates = [&](int64 start_row, int64 limit_row) {
+      for (int64 row = start_row; row < limit_row; ++row) {
+        int32* begin = &candidates(row, 0);
+        std::partial_sort(begin, begin + k, begin + num_candidates,
+                          make_comp(row));
+        std::copy(begin, begin + k, &indices(row, 0));
+        std::transform(begin, begin + k, &values(row, 0),
+                       [row, &input](const int32 loc) {
+                         return input(row, loc);
+                       });
+      }
+    };
+
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_row_shards, static_cast<int64>(row_shard_cost),
+          FindCandidates);
+    const double merge_cost =
+        num_candidates * Eigen::numext::log2(static_cast<float>(k + 1)) *
+        (3 * Eigen::TensorOpCost::AddCost<int32>() +
+         Eigen::TensorOpCost::AddCost<T>());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          static_cast<int64>(merge_cost), MergeCandidates);
+    return Status::OK();
+  }
 };
 
 }  // namespace functor
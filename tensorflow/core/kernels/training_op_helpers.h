@@ -86,9 +86,17 @@ struct VariableInputLockHolder {
         shared_locks_(std::move(other.shared_locks_)) {}
 
   ~VariableInputLockHolder() {
+    // Variables updated under a shared lock may have had a partial update
+    // cached as a read snapshot by a concurrent read; drop it.
+    if (shared_locks_ != nullptr && !shared_locks_->empty()) {
+      for (Var* var : vars_) {
+        var->InvalidateReadSnapshot();
+      }
+    }
     // Release the locks before unreffing the Vars, because each lock
     // is potentially borrowed from a Var in vars_.
     locks_.reset();
+    shared_locks_.reset();
     for (Var* var : vars_) {
       var->Unref();
     }
@@ -15,7 +15,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
+#include <type_traits>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -65,43 +67,321 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+// Removes size-1 dimensions and merges input dimensions that remain adjacent
+// and in order in the output. On return, 'dims' holds the input dimensions and
+// output dimension i is input dimension new_perm[i]. At least one dimension is
+// always returned.
+void FoldTransposeDimensions(const TensorShape& shape,
+                             const gtl::ArraySlice<int32> perm,
+                             internal::TransposeDimsVec* dims,
+                             internal::TransposePermsVec* new_perm) {
+  // Index of every input dimension once size-1 dimensions are dropped.
+  internal::TransposePermsVec compact_index(shape.dims(), -1);
+  int num_compact_dims = 0;
+  for (int i = 0; i < shape.dims(); ++i) {
+    if (shape.dim_size(i) != 1) compact_index[i] = num_compact_dims++;
+  }
+
+  // Groups of merged input dimensions in output order, identified by the
+  // compact index of their first input dimension.
+  internal::TransposePermsVec group_heads;
+  internal::TransposeDimsVec group_sizes;
+  int prev_index = -2;
+  for (int i = 0; i < perm.size(); ++i) {
+    const int index = compact_index[perm[i]];
+    if (index < 0) continue;
+    if (index == prev_index + 1) {
+      group_sizes.back() *= shape.dim_size(perm[i]);
+    } else {
+      group_heads.push_back(index);
+      group_sizes.push_back(shape.dim_size(perm[i]));
+    }
+    prev_index = index;
+  }
+  if (group_heads.empty()) {
+    group_heads.push_back(0);
+    group_sizes.push_back(1);
+  }
+
+  const int num_groups = group_heads.size();
+  internal::TransposePermsVec input_order(num_groups);
+  for (int i = 0; i < num_groups; ++i) input_order[i] = i;
+  std::sort(input_order.begin(), input_order.end(), [&](int a, int b) {
+    return group_heads[a] < group_heads[b];
+  });
+  dims->resize(num_groups);
+  new_perm->resize(num_groups);
+  for (int i = 0; i < num_groups; ++i) {
+    (*dims)[i] = group_sizes[input_order[i]];
+    (*new_perm)[input_order[i]] = i;
+  }
+}
+
+// Transposes the rows x cols tile at 'in', whose rows are in_stride elements
+// apart, into the cols x rows tile at 'out', whose rows are out_stride elements
+// apart.
+template <typename T>
+struct TileTransposer {
+  // Number of elements per side of the blocks transposed in registers, or 1 if
+  // the element type has no matching SIMD packet.
+  static constexpr int kBlockSize = 1;
+  static void TransposeBlock(const T* in, int64 in_stride, T* out,
+                             int64 out_stride) {}
+};
+
+// 4 and 8 byte elements are moved through float and double packets, which
+// only shuffle the bits around.
+template <typename T, typename Scalar>
+struct PacketTileTransposer {
+  using Packet = typename Eigen::internal::packet_traits<Scalar>::type;
+  static constexpr int kBlockSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+  static void TransposeBlock(const T* in, int64 in_stride, T* out,
+                             int64 out_stride) {
+    Eigen::internal::PacketBlock<Packet, kBlockSize> block;
+    for (int i = 0; i < kBlockSize; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet>(
+          reinterpret_cast<const Scalar*>(in + i * in_stride));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < kBlockSize; ++i) {
+      Eigen::internal::pstoreu(reinterpret_cast<Scalar*>(out + i * out_stride),
+                               block.packet[i]);
+    }
+  }
+};
+
+template <>
+struct TileTransposer<uint32> : PacketTileTransposer<uint32, float> {};
+template <>
+struct TileTransposer<uint64> : PacketTileTransposer<uint64, double> {};
+
+template <typename T>
+void TransposeTile(const T* in, int64 in_stride, T* out, int64 out_stride,
+                   int64 rows, int64 cols) {
+  constexpr int kBlockSize = TileTransposer<T>::kBlockSize;
+  int64 row = 0;
+  if (kBlockSize > 1) {
+    for (; row + kBlockSize <= rows; row += kBlockSize) {
+      int64 col = 0;
+      for (; col + kBlockSize <= cols; col += kBlockSize) {
+        TileTransposer<T>::TransposeBlock(in + row * in_stride + col, in_stride,
+                                          out + col * out_stride + row,
+                                          out_stride);
+      }
+      for (; col < cols; ++col) {
+        for (int64 r = row; r < row + kBlockSize; ++r) {
+          out[col * out_stride + r] = in[r * in_stride + col];
+        }
+      }
+    }
+  }
+  for (; row < rows; ++row) {
+    for (int64 col = 0; col < cols; ++col) {
+      out[col * out_stride + row] = in[row * in_stride + col];
+    }
+  }
+}
+
+constexpr int64 kTileSize = 32;
+
+// Transposes a tensor whose dimensions and permutation have already been
+// folded (no size-1 dimensions, no two input dimensions that stay adjacent).
+// If the innermost dimension stays in place, whole rows are copied. Otherwise
+// the two dimensions that become innermost in the input and the output are
+// cut into kTileSize x kTileSize tiles, which are transposed in registers
+// where the element type allows it, and tiles are distributed over threads.
+template <typename T>
+void TransposeFolded(const CPUDevice& device, const T* in,
+                     const internal::TransposeDimsVec& dims,
+                     const internal::TransposePermsVec& perm, T* out) {
+  const int ndims = dims.size();
+  internal::TransposeDimsVec in_strides(ndims);
+  internal::TransposeDimsVec out_dims(ndims);
+  internal::TransposeDimsVec out_strides(ndims);
+  in_strides[ndims - 1] = 1;
+  out_strides[ndims - 1] = 1;
+  for (int i = ndims - 1; i > 0; --i) {
+    in_strides[i - 1] = in_strides[i] * dims[i];
+  }
+  for (int i = 0; i < ndims; ++i) out_dims[i] = dims[perm[i]];
+  for (int i = ndims - 1; i > 0; --i) {
+    out_strides[i - 1] = out_strides[i] * out_dims[i];
+  }
+
+  if (perm[ndims - 1] == ndims - 1) {
+    // The innermost dimension is unchanged: copy rows of contiguous elements.
+    const int64 row_size = dims[ndims - 1];
+    const int64 num_rows = out_strides[0] * out_dims[0] / row_size;
+    auto copy_rows = [&](int64 begin, int64 end) {
+      internal::TransposeDimsVec index(ndims - 1);
+      int64 in_offset = 0;
+      int64 t = begin;
+      for (int i = ndims - 2; i >= 0; --i) {
+        index[i] = t % out_dims[i];
+        t /= out_dims[i];
+        in_offset += index[i] * in_strides[perm[i]];
+      }
+      for (int64 row = begin; row < end; ++row) {
+        std::copy(in + in_offset, in + in_offset + row_size,
+                  out + row * row_size);
+        // Advance the output index by one row and update the input offset.
+        for (int i = ndims - 2; i >= 0; --i) {
+          in_offset += in_strides[perm[i]];
+          if (++index[i] < out_dims[i]) break;
+          in_offset -= index[i] * in_strides[perm[i]];
+          index[i] = 0;
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost(/*bytes_loaded=*/row_size * sizeof(T),
+                                   /*bytes_stored=*/row_size * sizeof(T),
+                                   /*compute_cycles=*/ndims);
+    device.parallelFor(num_rows, cost, std::move(copy_rows));
+    return;
+  }
+
+  // Input dimension 'row_dim' becomes the innermost output dimension, and the
+  // innermost input dimension ends up at output position 'col_pos'.
+  const int row_dim = perm[ndims - 1];
+  int col_pos = 0;
+  while (perm[col_pos] != ndims - 1) ++col_pos;
+  const int64 num_rows = dims[row_dim];
+  const int64 num_cols = dims[ndims - 1];
+  const int64 in_row_stride = in_strides[row_dim];
+  const int64 out_col_stride = out_strides[col_pos];
+
+  // The remaining dimensions, in output order.
+  internal::TransposeDimsVec outer_dims, outer_in_strides, outer_out_strides;
+  for (int i = 0; i < ndims - 1; ++i) {
+    if (i == col_pos) continue;
+    outer_dims.push_back(out_dims[i]);
+    outer_in_strides.push_back(in_strides[perm[i]]);
+    outer_out_strides.push_back(out_strides[i]);
+  }
+
+  const int64 row_tiles = (num_rows + kTileSize - 1) / kTileSize;
+  const int64 col_tiles = (num_cols + kTileSize - 1) / kTileSize;
+  auto transpose_tiles = [&](int64 begin, int64 end) {
+    for (int64 tile = begin; tile < end; ++tile) {
+      // Consecutive tiles write next to each other in the output.
+      int64 t = tile;
+      const int64 row_begin = (t % row_tiles) * kTileSize;
+      t /= row_tiles;
+      const int64 col_begin = (t % col_tiles) * kTileSize;
+      t /= col_tiles;
+      int64 in_offset = row_begin * in_row_stride + col_begin;
+      int64 out_offset = col_begin * out_col_stride + row_begin;
+      for (int i = outer_dims.size() - 1; i >= 0; --i) {
+        const int64 index = t % outer_dims[i];
+        t /= outer_dims[i];
+        in_offset += index * outer_in_strides[i];
+        out_offset += index * outer_out_strides[i];
+      }
+      TransposeTile(in + in_offset, in_row_stride, out + out_offset,
+                    out_col_stride, std::min(kTileSize, num_rows - row_begin),
+                    std::min(kTileSize, num_cols - col_begin));
+    }
+  };
+  const int64 num_outer = out_strides[0] * out_dims[0] / (num_rows * num_cols);
+  const Eigen::TensorOpCost cost(
+      /*bytes_loaded=*/kTileSize * kTileSize * sizeof(T),
+      /*bytes_stored=*/kTileSize * kTileSize * sizeof(T),
+      /*compute_cycles=*/kTileSize * kTileSize);
+  device.parallelFor(num_outer * row_tiles * col_tiles, cost,
+                     std::move(transpose_tiles));
+}
+
+// Returns true if 'dims' and 'perm', as returned by FoldTransposeDimensions,
+// are better handled by TransposeFolded than by an Eigen shuffle: rows must
+// be long enough to amortize the index computations, and tiles must not
+// degenerate into thin slivers.
+template <typename T>
+bool UseTransposeFolded(const internal::TransposeDimsVec& dims,
+                        const internal::TransposePermsVec& perm) {
+  constexpr int64 kMinRowBytes = 32;
+  constexpr int64 kMinTiledDim = 8;
+  if (std::is_same<T, tstring>::value) return false;
+  const int ndims = dims.size();
+  if (perm[ndims - 1] == ndims - 1) {
+    return dims[ndims - 1] * sizeof(T) >= kMinRowBytes;
+  }
+  return dims[perm[ndims - 1]] >= kMinTiledDim &&
+         dims[ndims - 1] >= kMinTiledDim;
+}
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
-    switch (in.dims()) {
+    if (in.NumElements() == 0) return;
+    internal::TransposeDimsVec dims;
+    internal::TransposePermsVec folded_perm;
+    FoldTransposeDimensions(in.shape(), perm, &dims, &folded_perm);
+    if (!conjugate && UseTransposeFolded<T>(dims, folded_perm)) {
+      TransposeFolded<T>(
+          d, reinterpret_cast<const T*>(in.tensor_data().data()), dims,
+          folded_perm,
+          reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data())));
+      return;
+    }
+
+    // Shuffle the folded tensors, which needs fewer index computations.
+    TensorShape in_shape;
+    TensorShape out_shape;
+    for (int i = 0; i < dims.size(); ++i) {
+      in_shape.AddDim(dims[i]);
+      out_shape.AddDim(dims[folded_perm[i]]);
+    }
+    Tensor in_folded;
+    Tensor out_folded;
+    CHECK(in_folded.CopyFrom(in, in_shape));
+    CHECK(out_folded.CopyFrom(*out, out_shape));
+    switch (dims.size()) {
+      case 1:
+        internal::TransposeUsingEigen<CPUDevice, T, 1>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
+        break;
       case 2:
-        internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       case 3:
-        internal::TransposeUsingEigen<CPUDevice, T, 3>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 3>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       case 4:
-        internal::TransposeUsingEigen<CPUDevice, T, 4>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 4>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       case 5:
-        internal::TransposeUsingEigen<CPUDevice, T, 5>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 5>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       case 6:
-        internal::TransposeUsingEigen<CPUDevice, T, 6>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 6>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       case 7:
-        internal::TransposeUsingEigen<CPUDevice, T, 7>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 7>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       case 8:
-        internal::TransposeUsingEigen<CPUDevice, T, 8>(d, in, perm, conjugate,
-                                                       out);
+        internal::TransposeUsingEigen<CPUDevice, T, 8>(d, in_folded,
+                                                       folded_perm, conjugate,
+                                                       &out_folded);
         break;
       default:
-        TransposeSimple<T, conjugate>(d, in, perm, out);
+        TransposeSimple<T, conjugate>(d, in_folded, folded_perm, &out_folded);
         break;
     }
   }
@@ -0,0 +1,180 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class TransposeOpTest : public OpsTestBase {
+ protected:
+  // Transposes a tensor of the given shape filled with 0, 1, 2, ... and
+  // compares the result with an element-wise reference.
+  template <typename T>
+  void TransposeAndCheck(const TensorShape& shape,
+                         const std::vector<int32>& perm) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "Transpose")
+                     .Input(FakeInput(DataTypeToEnum<T>::value))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInput<T>(shape, [](int i) -> T { return static_cast<T>(i % 251); });
+    AddInputFromArray<int32>(TensorShape({static_cast<int64>(perm.size())}),
+                             perm);
+    TF_ASSERT_OK(RunOpKernel());
+
+    TensorShape out_shape;
+    for (int32 dim : perm) out_shape.AddDim(shape.dim_size(dim));
+    Tensor expected(allocator(), DataTypeToEnum<T>::value, out_shape);
+    const auto in_strides = ComputeStride<int64>(shape);
+    const auto out_strides = ComputeStride<int64>(out_shape);
+    auto expected_flat = expected.flat<T>();
+    for (int64 o = 0; o < out_shape.num_elements(); ++o) {
+      int64 t = o;
+      int64 i = 0;
+      for (int d = 0; d < perm.size(); ++d) {
+        i += (t / out_strides[d]) * in_strides[perm[d]];
+        t %= out_strides[d];
+      }
+      expected_flat(o) = static_cast<T>(i % 251);
+    }
+    test::ExpectTensorEqual<T>(expected, *GetOutput(0));
+  }
+};
+
+TEST_F(TransposeOpTest, Matrix) {
+  TransposeAndCheck<float>({67, 45}, {1, 0});
+}
+
+TEST_F(TransposeOpTest, InnermostDimensionKept) {
+  TransposeAndCheck<float>({4, 9, 3, 16}, {0, 2, 1, 3});
+  TransposeAndCheck<uint8>({4, 9, 3, 5}, {2, 0, 1, 3});
+}
+
+TEST_F(TransposeOpTest, InnerDimensionsSwapped) {
+  TransposeAndCheck<float>({2, 3, 37, 41}, {0, 1, 3, 2});
+  TransposeAndCheck<double>({5, 19, 3, 21}, {3, 2, 0, 1});
+  TransposeAndCheck<int16>({3, 33, 4, 17}, {0, 2, 3, 1});
+  TransposeAndCheck<int8>({40, 3, 2, 40}, {3, 1, 2, 0});
+}
+
+TEST_F(TransposeOpTest, HighRank) {
+  TransposeAndCheck<float>({3, 4, 2, 9, 1, 10}, {5, 3, 1, 4, 2, 0});
+  TransposeAndCheck<int32>({2, 9, 3, 2, 10, 2, 3}, {4, 1, 6, 0, 3, 2, 5});
+  TransposeAndCheck<int64>({2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+                           {9, 0, 8, 1, 7, 2, 6, 3, 5, 4});
+}
+
+TEST_F(TransposeOpTest, SmallDimensions) {
+  TransposeAndCheck<float>({64, 3, 2}, {0, 2, 1});
+  TransposeAndCheck<float>({1, 5, 1, 7, 1}, {4, 3, 2, 1, 0});
+  TransposeAndCheck<complex64>({6, 11, 13}, {2, 0, 1});
+}
+
+static Graph* Transpose(DataType type, const TensorShape& shape,
+                        const std::vector<int32>& perm) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor data(type, shape);
+  data.flat<float>().setRandom();
+  Tensor perm_tensor(DT_INT32, TensorShape({static_cast<int64>(perm.size())}));
+  for (int i = 0; i < perm.size(); ++i) perm_tensor.vec<int32>()(i) = perm[i];
+  test::graph::Binary(g, "Transpose", test::graph::Constant(g, data),
+                      test::graph::Constant(g, perm_tensor));
+  return g;
+}
+
+static SessionOptions GetOptions(int intra_threads) {
+  SessionOptions opts;
+  opts.config.set_intra_op_parallelism_threads(intra_threads);
+  opts.config.set_inter_op_parallelism_threads(1);
+  return opts;
+}
+
+static void RunTransposeBenchmark(::testing::benchmark::State& state,
+                                  const TensorShape& shape,
+                                  const std::vector<int32>& perm) {
+  const int intra_threads = state.range(0);
+  SessionOptions opts = GetOptions(intra_threads);
+  test::Benchmark("cpu", Transpose(DT_FLOAT, shape, perm), &opts, nullptr,
+                  nullptr, "", /*old_benchmark_api*/ false)
+      .Run(state);
+  const int64 num_items =
+      static_cast<int64>(state.iterations()) * shape.num_elements();
+  state.SetItemsProcessed(num_items);
+  state.SetBytesProcessed(num_items * sizeof(float));
+}
+
+// Splitting attention heads: [batch, seq_len, heads, head_dim] to
+// [batch, heads, seq_len, head_dim].
+void BM_TransposeSplitHeads(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {8, 128, 12, 64}, {0, 2, 1, 3});
+}
+
+BENCHMARK(BM_TransposeSplitHeads)->UseRealTime()->Arg(1)->Arg(4);
+
+// Transposed keys for attention scores: [batch, heads, seq_len, head_dim] to
+// [batch, heads, head_dim, seq_len].
+void BM_TransposeKeys(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {8, 12, 128, 64}, {0, 1, 3, 2});
+}
+
+BENCHMARK(BM_TransposeKeys)->UseRealTime()->Arg(1)->Arg(4);
+
+void BM_TransposeNHWCToNCHW(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {16, 32, 32, 64}, {0, 3, 1, 2});
+}
+
+BENCHMARK(BM_TransposeNHWCToNCHW)->UseRealTime()->Arg(1)->Arg(4);
+
+void BM_TransposeNCHWToNHWC(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {16, 64, 32, 32}, {0, 2, 3, 1});
+}
+
+BENCHMARK(BM_TransposeNCHWToNHWC)->UseRealTime()->Arg(1)->Arg(4);
+
+void BM_TransposeMatrix(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {1024, 1024}, {1, 0});
+}
+
+BENCHMARK(BM_TransposeMatrix)->UseRealTime()->Arg(1)->Arg(4);
+
+void BM_TransposeRank5(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {4, 8, 16, 32, 8}, {4, 2, 0, 3, 1});
+}
+
+BENCHMARK(BM_TransposeRank5)->UseRealTime()->Arg(1)->Arg(4);
+
+void BM_TransposeRank6(::testing::benchmark::State& state) {
+  RunTransposeBenchmark(state, {4, 6, 8, 10, 12, 16}, {5, 3, 1, 4, 2, 0});
+}
+
+BENCHMARK(BM_TransposeRank6)->UseRealTime()->Arg(1)->Arg(4);
+
+}  // namespace
+}  // namespace tensorflow
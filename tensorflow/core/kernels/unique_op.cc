@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +72,21 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Integer ids get two additional paths for 1-D inputs: a linear scan when the
+// input is already sorted, and a partitioned multi-threaded hash path for large
+// inputs. Both return the unique elements in order of first occurrence, like
+// the single-threaded hash map.
+template <typename T>
+struct UniqueOpIsIntegerId : std::false_type {};
+template <>
+struct UniqueOpIsIntegerId<int32> : std::true_type {};
+template <>
+struct UniqueOpIsIntegerId<int64> : std::true_type {};
+
+// 1-D integer inputs with at least this many elements are deduplicated on the
+// intra-op thread pool.
+constexpr int64 kParallelUniqueMinElements = 64 * 1024;
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -142,6 +161,12 @@ class UniqueOp : public OpKernel {
                                 1, TensorShape({new_sizes[1]}), &idx));
     auto idx_vec = idx->template vec<TIndex>();
 
+    if (TensorShapeUtils::IsVector(input.shape()) &&
+        TryIntegerFastPaths(context, input, idx_vec,
+                            UniqueOpIsIntegerId<T>())) {
+      return;
+    }
+
     int64 uniq_size;
     if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
@@ -237,6 +262,212 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  typedef typename TTypes<TIndex>::Vec IndexVec;
+
+  // Returns true if the outputs were computed by one of the integer fast paths.
+  bool TryIntegerFastPaths(OpKernelContext* context, const Tensor& input,
+                           IndexVec idx_vec, std::false_type) {
+    return false;
+  }
+
+  bool TryIntegerFastPaths(OpKernelContext* context, const Tensor& input,
+                           IndexVec idx_vec, std::true_type) {
+    auto Tin = input.flat<T>();
+    if (std::is_sorted(Tin.data(), Tin.data() + Tin.size())) {
+      ComputeSorted(context, input, idx_vec);
+      return true;
+    }
+    if (Tin.size() >= kParallelUniqueMinElements &&
+        context->device()->tensorflow_cpu_worker_threads()->num_threads > 1) {
+      ComputeParallel(context, input, idx_vec);
+      return true;
+    }
+    return false;
+  }
+
+  // Sorted input: equal elements are adjacent, so a unique element's index is
+  // the number of distinct runs before it.
+  void ComputeSorted(OpKernelContext* context, const Tensor& input,
+                     IndexVec idx_vec) {
+    auto Tin = input.flat<T>();
+    const int64 N = static_cast<int64>(Tin.size());
+    int64 uniq_size = 0;
+    for (int64 i = 0; i < N; ++i) {
+      if (i == 0 || Tin(i) != Tin(i - 1)) {
+        ++uniq_size;
+      }
+      idx_vec(i) = static_cast<TIndex>(uniq_size - 1);
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({uniq_size}), &output));
+    auto Tout = output->flat<T>();
+    for (int64 i = 0; i < N; ++i) {
+      if (i == 0 || Tin(i) != Tin(i - 1)) {
+        Tout(idx_vec(i)) = Tin(i);
+      }
+    }
+
+    if (num_outputs() > 2) {
+      Tensor* count = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &count));
+      auto count_vec = count->template vec<TIndex>();
+      count_vec.setZero();
+      for (int64 i = 0; i < N; ++i) {
+        count_vec(idx_vec(i))++;
+      }
+    }
+  }
+
+  // Large unsorted input. Positions are scattered into hash partitions, with
+  // each partition's positions kept in input order, and every partition is
+  // deduplicated by its own thread. First occurrences are then numbered in
+  // input order with a prefix sum over chunks of the input, which gives the
+  // same output as the sequential hash map.
+  void ComputeParallel(OpKernelContext* context, const Tensor& input,
+                       IndexVec idx_vec) {
+    auto Tin = input.flat<T>();
+    const int64 N = static_cast<int64>(Tin.size());
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int num_threads = worker_threads.num_threads;
+
+    // The partition of an element is given by the top bits of its
+    // multiplicative hash, so the number of partitions is a power of two.
+    int partition_bits = 1;
+    while ((1 << partition_bits) < 4 * num_threads && partition_bits < 8) {
+      ++partition_bits;
+    }
+    const int64 num_partitions = int64{1} << partition_bits;
+    auto partition_of = [partition_bits](T x) {
+      return static_cast<int64>((static_cast<uint64>(x) *
+                                 0x9E3779B97F4A7C15ULL) >>
+                                (64 - partition_bits));
+    };
+
+    const int64 num_chunks = std::min<int64>(4 * num_threads, N / 4096 + 1);
+    const int64 chunk_size = (N + num_chunks - 1) / num_chunks;
+    auto for_each_chunk = [&](int64 cost_per_element,
+                              const std::function<void(int64, int64, int64)>&
+                                  fn) {
+      Shard(num_threads, worker_threads.workers, num_chunks,
+            chunk_size * cost_per_element, [&](int64 begin, int64 end) {
+              for (int64 c = begin; c < end; ++c) {
+                fn(c, c * chunk_size, std::min(N, (c + 1) * chunk_size));
+              }
+            });
+    };
+
+    // Scatter positions into partitions, ordered by chunk within each
+    // partition so that positions stay in input order.
+    std::vector<int64> offsets(num_chunks * num_partitions, 0);
+    for_each_chunk(5, [&](int64 c, int64 begin, int64 end) {
+      int64* counts = &offsets[c * num_partitions];
+      for (int64 i = begin; i < end; ++i) {
+        ++counts[partition_of(Tin(i))];
+      }
+    });
+    std::vector<int64> partition_start(num_partitions + 1);
+    int64 total = 0;
+    for (int64 p = 0; p < num_partitions; ++p) {
+      partition_start[p] = total;
+      for (int64 c = 0; c < num_chunks; ++c) {
+        const int64 n = offsets[c * num_partitions + p];
+        offsets[c * num_partitions + p] = total;
+        total += n;
+      }
+    }
+    partition_start[num_partitions] = total;
+    std::vector<int64> positions(N);
+    for_each_chunk(5, [&](int64 c, int64 begin, int64 end) {
+      int64* next = &offsets[c * num_partitions];
+      for (int64 i = begin; i < end; ++i) {
+        positions[next[partition_of(Tin(i))]++] = i;
+      }
+    });
+
+    // Deduplicate each partition, recording for every position the position
+    // of the first occurrence of its element.
+    struct Entry {
+      int64 first;
+      int64 count;
+    };
+    std::vector<absl::flat_hash_map<T, Entry>> uniq(num_partitions);
+    std::vector<int64> first_pos(N);
+    Shard(num_threads, worker_threads.workers, num_partitions,
+          (N / num_partitions + 1) * 50, [&](int64 begin, int64 end) {
+            for (int64 p = begin; p < end; ++p) {
+              auto& map = uniq[p];
+              map.reserve(partition_start[p + 1] - partition_start[p]);
+              for (int64 k = partition_start[p]; k < partition_start[p + 1];
+                   ++k) {
+                const int64 i = positions[k];
+                Entry& entry =
+                    map.try_emplace(Tin(i), Entry{i, 0}).first->second;
+                ++entry.count;
+                first_pos[i] = entry.first;
+              }
+            }
+          });
+
+    // Number first occurrences in input order.
+    std::vector<int64> chunk_start(num_chunks);
+    for_each_chunk(2, [&](int64 c, int64 begin, int64 end) {
+      int64 n = 0;
+      for (int64 i = begin; i < end; ++i) {
+        n += first_pos[i] == i;
+      }
+      chunk_start[c] = n;
+    });
+    int64 uniq_size = 0;
+    for (int64 c = 0; c < num_chunks; ++c) {
+      const int64 n = chunk_start[c];
+      chunk_start[c] = uniq_size;
+      uniq_size += n;
+    }
+    for_each_chunk(2, [&](int64 c, int64 begin, int64 end) {
+      int64 next = chunk_start[c];
+      for (int64 i = begin; i < end; ++i) {
+        if (first_pos[i] == i) {
+          idx_vec(i) = static_cast<TIndex>(next++);
+        }
+      }
+    });
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({uniq_size}), &output));
+    auto Tout = output->flat<T>();
+    for_each_chunk(3, [&](int64 c, int64 begin, int64 end) {
+      for (int64 i = begin; i < end; ++i) {
+        if (first_pos[i] == i) {
+          Tout(idx_vec(i)) = Tin(i);
+        } else {
+          idx_vec(i) = idx_vec(first_pos[i]);
+        }
+      }
+    });
+
+    if (num_outputs() > 2) {
+      Tensor* count = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &count));
+      auto count_vec = count->template vec<TIndex>();
+      Shard(num_threads, worker_threads.workers, num_partitions,
+            (uniq_size / num_partitions + 1) * 5, [&](int64 begin, int64 end) {
+              for (int64 p = begin; p < end; ++p) {
+                for (const auto& it : uniq[p]) {
+                  count_vec(idx_vec(it.second.first)) =
+                      static_cast<TIndex>(it.second.count);
+                }
+              }
+            });
+    }
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
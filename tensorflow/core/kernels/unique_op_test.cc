@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -111,6 +112,44 @@ void BM_Unique_INT32_Repeat(::testing::benchmark::State& state) {
                           sizeof(int32));
 }
 
+void RunUniqueInt64Benchmark(::testing::benchmark::State& state,
+                             bool sorted) {
+  const int dim = state.range(0);
+  const int max_int = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_INT64, TensorShape({dim}));
+  auto input_vec = input.vec<int64>();
+  for (int i = 0; i < dim; ++i) {
+    input_vec(i) = std::rand() % max_int;
+  }
+  if (sorted) {
+    std::sort(input_vec.data(), input_vec.data() + dim);
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Unique")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+  FixupSourceAndSinkEdges(g);
+
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr,
+                  "SINGLE_THREADED_EXECUTOR", /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetBytesProcessed(static_cast<int64>(state.iterations()) * dim *
+                          sizeof(int64));
+}
+
+void BM_Unique_INT64(::testing::benchmark::State& state) {
+  RunUniqueInt64Benchmark(state, /*sorted=*/false);
+}
+
+void BM_Unique_INT64_Sorted(::testing::benchmark::State& state) {
+  RunUniqueInt64Benchmark(state, /*sorted=*/true);
+}
+
 TensorProto GetRandomStringsTensorProto(int dim, int max_str_len) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_STRING);
@@ -193,6 +232,18 @@ BENCHMARK(BM_Unique_INT32_Repeat)
     ->ArgPair(64 * 1024, 64 * 1024 * 1024)
     ->ArgPair(1024 * 1024, 64 * 1024 * 1024);
 
+BENCHMARK(BM_Unique_INT64)
+    ->UseRealTime()
+    ->ArgPair(64 * 1024, 1024 * 1024)
+    ->ArgPair(1024 * 1024, 1024 * 1024)
+    ->ArgPair(10 * 1024 * 1024, 1024 * 1024)
+    ->ArgPair(10 * 1024 * 1024, 64 * 1024 * 1024);
+
+BENCHMARK(BM_Unique_INT64_Sorted)
+    ->UseRealTime()
+    ->ArgPair(1024 * 1024, 1024 * 1024)
+    ->ArgPair(10 * 1024 * 1024, 64 * 1024 * 1024);
+
 BENCHMARK(BM_Unique_STRING)
     ->UseRealTime()
     ->Arg(32)
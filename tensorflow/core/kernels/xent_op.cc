@@ -19,6 +19,9 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/xent_op.h"
 
+#include <algorithm>
+#include <type_traits>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -131,12 +134,87 @@ class SoftmaxXentWithLogitsOp : public OpKernel {
   }
 };
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
 namespace functor {
-template <typename Device, typename T>
-struct XentFunctorBase {
-  void operator()(const Device& d,
+
+// Row-wise CPU implementation for operands that are not broadcast. Every row
+// is reduced and rewritten in blocks while it is still in cache, and the only
+// storage touched besides the inputs and outputs is a handful of scalars per
+// row: the shifted exponentials are written straight into backprop, which may
+// alias logits.
+template <typename T>
+struct XentRowwiseImpl {
+  static void Compute(const CPUDevice& d,
+                      typename TTypes<T>::ConstMatrix logits,
+                      typename TTypes<T>::ConstMatrix labels,
+                      typename TTypes<T>::Vec loss,
+                      typename TTypes<T>::Matrix backprop) {
+    using ConstRow = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+    using Row = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+    const int64 batch_size = logits.dimension(0);
+    const int64 num_classes = logits.dimension(1);
+    // Classes per block; the exponentials of a block stay in L1 between the
+    // sweep that writes them and the reduction that reads them back.
+    constexpr int64 kBlockSize = 2048;
+
+    auto compute_rows = [&](int64 begin, int64 end) {
+      for (int64 b = begin; b < end; ++b) {
+        const T* logits_row = &logits(b, 0);
+        const T* labels_row = &labels(b, 0);
+        T* backprop_row = &backprop(b, 0);
+
+        T max_logit = Eigen::NumTraits<T>::lowest();
+        for (int64 j = 0; j < num_classes; j += kBlockSize) {
+          const int64 n = std::min(kBlockSize, num_classes - j);
+          max_logit =
+              std::max(max_logit, ConstRow(logits_row + j, n).maxCoeff());
+        }
+
+        // Reads each block of logits before overwriting it with
+        // exp(logits - max_logits), since backprop may alias logits.
+        T sum_exp(0);
+        T label_sum(0);
+        T label_dot(0);
+        for (int64 j = 0; j < num_classes; j += kBlockSize) {
+          const int64 n = std::min(kBlockSize, num_classes - j);
+          ConstRow labels_block(labels_row + j, n);
+          Row exp_logits(backprop_row + j, n);
+          const auto shifted_logits = ConstRow(logits_row + j, n) - max_logit;
+          label_sum += labels_block.sum();
+          label_dot += (labels_block * shifted_logits).sum();
+          exp_logits = shifted_logits.exp();
+          sum_exp += exp_logits.sum();
+        }
+
+        //  sum(labels * (log(sum(exp(logits - max_logits))) -
+        //                (logits - max_logits)))
+        loss(b) = label_sum * Eigen::numext::log(sum_exp) - label_dot;
+
+        // backprop: prob - labels.
+        const T inv_sum_exp = T(1) / sum_exp;
+        for (int64 j = 0; j < num_classes; j += kBlockSize) {
+          const int64 n = std::min(kBlockSize, num_classes - j);
+          Row prob(backprop_row + j, n);
+          prob = prob * inv_sum_exp - ConstRow(labels_row + j, n);
+        }
+      }
+    };
+
+    const double exp_cost =
+        Eigen::internal::functor_traits<Eigen::internal::scalar_exp_op<T>>::Cost;
+    const Eigen::TensorOpCost cost(
+        4 * num_classes * sizeof(T), 2 * num_classes * sizeof(T),
+        num_classes * (exp_cost + 5 * Eigen::TensorOpCost::AddCost<T>() +
+                       3 * Eigen::TensorOpCost::MulCost<T>()));
+    d.parallelFor(batch_size, cost, compute_rows);
+  }
+};
+
+// Partial specialization for a CPUDevice. Broadcast operands and half
+// precision use the Eigen implementation from XentEigenImpl.
+template <typename T>
+struct XentFunctor<CPUDevice, T> {
+  void operator()(const CPUDevice& d,
                   const Eigen::DSizes<Eigen::DenseIndex, 2>& shape,
                   const Eigen::array<Eigen::DenseIndex, 2>& logits_bcast,
                   const Eigen::array<Eigen::DenseIndex, 2>& labels_bcast,
@@ -145,14 +223,20 @@ struct XentFunctorBase {
                   typename TTypes<T>::Matrix scratch,
                   typename TTypes<T>::Vec loss,
                   typename TTypes<T>::Matrix backprop) {
-    XentEigenImpl<Device, T>::Compute(d, shape, logits_bcast, labels_bcast,
-                                      logits, labels, scratch, loss, backprop);
+    const bool is_broadcast = logits_bcast[0] != 1 || logits_bcast[1] != 1 ||
+                              labels_bcast[0] != 1 || labels_bcast[1] != 1;
+    // Half keeps the tree reductions of the Eigen implementation, which lose
+    // less precision than accumulating whole rows in half.
+    if (is_broadcast || std::is_same<T, Eigen::half>::value) {
+      XentEigenImpl<CPUDevice, T>::Compute(d, shape, logits_bcast,
+                                           labels_bcast, logits, labels,
+                                           scratch, loss, backprop);
+      return;
+    }
+    XentRowwiseImpl<T>::Compute(d, logits, labels, loss, backprop);
   }
 };
 
-template <typename T>
-struct XentFunctor<CPUDevice, T> : XentFunctorBase<CPUDevice, T> {};
-
 }  // namespace functor
 
 #define REGISTER_CPU(T)                                         \
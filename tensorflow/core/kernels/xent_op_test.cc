@@ -56,9 +56,11 @@ BM_XentDev(64, 10000, gpu);
 BM_XentDev(64, 30000, gpu);
 BM_XentDev(64, 100000, gpu);
 
-/// Only the smaller tests for CPU. Otherwise, it's too slow
 BM_XentDev(16, 10000, cpu);
 BM_XentDev(32, 10000, cpu);
 BM_XentDev(64, 10000, cpu);
 
+BM_XentDev(16, 100000, cpu);
+BM_XentDev(32, 100000, cpu);
+
 }  // end namespace tensorflow
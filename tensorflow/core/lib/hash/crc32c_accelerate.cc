@@ -15,21 +15,28 @@ limitations under the License.
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
-// SSE4.2 accelerated CRC32c.
+// Hardware accelerated CRC32c, with SSE4.2 on x86-64 and the ARMv8 CRC32
+// extension on AArch64.
 
-// See if the SSE4.2 crc32c instruction is available.
+// On x86-64 the crc32 instruction is enabled per function, so it is used
+// whenever the CPU supports it, not only in builds with -msse4.2.
 #undef USE_SSE_CRC32C
-#ifdef __SSE4_2__
-#if defined(__x86_64__) && defined(__GNUC__) && \
-    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
+#undef USE_ARM_CRC32C
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
 #define USE_SSE_CRC32C 1
 #elif defined(__x86_64__) && defined(__clang__)
 #if __has_builtin(__builtin_cpu_supports)
 #define USE_SSE_CRC32C 1
 #endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+// The CRC32 extension is optional in ARMv8.0, and enabling it per function
+// is spelled differently by each compiler, so it is only used when the build
+// targets it.
+#define USE_ARM_CRC32C 1
 #endif
-#endif /* __SSE4_2__ */
 
 // This version of Apple clang has a bug:
 // https://llvm.org/bugs/show_bug.cgi?id=25510
@@ -39,12 +46,18 @@ limitations under the License.
 
 #ifdef USE_SSE_CRC32C
 #include <nmmintrin.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+
+#ifdef USE_ARM_CRC32C
+#include <arm_acle.h>
+#define CRC32C_TARGET
 #endif
 
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -54,42 +67,130 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
-// SSE4.2 optimized crc32c computation.
+#ifdef USE_SSE_CRC32C
 bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
 
-uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
-  const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
-  const uint8_t *e = p + size;
-  uint32_t l = crc ^ 0xffffffffu;
+static inline CRC32C_TARGET uint32_t Crc8(uint32_t crc, uint8_t v) {
+  return _mm_crc32_u8(crc, v);
+}
+static inline CRC32C_TARGET uint64_t Crc64(uint64_t crc, uint64_t v) {
+  return _mm_crc32_u64(crc, v);
+}
+#else
+bool CanAccelerate() { return true; }
+
+static inline uint32_t Crc8(uint32_t crc, uint8_t v) {
+  return __crc32cb(crc, v);
+}
+static inline uint64_t Crc64(uint64_t crc, uint64_t v) {
+  return __crc32cd(crc, v);
+}
+#endif
+
+static inline uint64_t Load64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Extends the raw (not pre- or post-inverted) crc "l" with p[0, n).
+static CRC32C_TARGET uint32_t ExtendRaw(uint32_t l, const uint8_t *p,
+                                        size_t n) {
+  uint64_t l64 = l;
+  for (; n >= 16; p += 16, n -= 16) {
+    l64 = Crc64(l64, Load64(p));
+    l64 = Crc64(l64, Load64(p + 8));
+  }
+  l = l64;
+  if (n >= 8) {
+    l = Crc64(l, Load64(p));
+    p += 8;
+    n -= 8;
+  }
+  for (; n > 0; ++p, --n) {
+    l = Crc8(l, *p);
+  }
+  return l;
+}
 
-  // Advance p until aligned to 8-bytes..
-  // Point x at first 7-byte aligned byte in string.  This might be
-  // just past the end of the string.
-  const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
-  const uint8_t *x = reinterpret_cast<const uint8_t *>(((pval + 7) >> 3) << 3);
-  if (x <= e) {
-    // Process bytes until finished or p is 8-byte aligned
-    while (p != x) {
-      l = _mm_crc32_u8(l, *p);
-      p++;
+// The crc instruction has a latency of 3 cycles but a throughput of one per
+// cycle, so a single dependency chain runs at a third of the peak rate.
+// Inputs of at least 3 * kBlockSize bytes are therefore split into three
+// streams of kBlockSize bytes whose crcs are computed together, then combined.
+//
+// The raw crc of A followed by B is Shift(crc(A)) ^ crc(B), where Shift()
+// extends a crc with |B| zero bytes.  Shift() is linear, so it is computed
+// with one table lookup per byte of the crc.
+template <size_t kBlockSize>
+class ThreeStreams {
+ public:
+  static const ThreeStreams &Get() {
+    static const ThreeStreams *streams = new ThreeStreams;
+    return *streams;
+  }
+
+  // Consumes the multiples of 3 * kBlockSize bytes at the start of [*p, *p +
+  // *n), and returns the raw crc "l" extended with them.
+  CRC32C_TARGET uint32_t Extend(uint32_t l, const uint8_t **p,
+                                size_t *n) const {
+    for (; *n >= 3 * kBlockSize; *p += 3 * kBlockSize, *n -= 3 * kBlockSize) {
+      const uint8_t *p0 = *p;
+      const uint8_t *p1 = p0 + kBlockSize;
+      const uint8_t *p2 = p1 + kBlockSize;
+      uint64_t c0 = l;
+      uint64_t c1 = 0;
+      uint64_t c2 = 0;
+      for (size_t i = 0; i < kBlockSize; i += 8) {
+        c0 = Crc64(c0, Load64(p0 + i));
+        c1 = Crc64(c1, Load64(p1 + i));
+        c2 = Crc64(c2, Load64(p2 + i));
+      }
+      l = Shift(Shift(static_cast<uint32_t>(c0)) ^ static_cast<uint32_t>(c1)) ^
+          static_cast<uint32_t>(c2);
     }
+    return l;
   }
 
-  // Process bytes 16 at a time
-  uint64_t l64 = l;
-  while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
-    p += 16;
+ private:
+  ThreeStreams() {
+    static const uint8_t kZeros[kBlockSize] = {0};
+    uint32_t basis[32];
+    for (int i = 0; i < 32; ++i) {
+      basis[i] = ExtendRaw(1u << i, kZeros, kBlockSize);
+    }
+    for (int k = 0; k < 4; ++k) {
+      for (int b = 0; b < 256; ++b) {
+        uint32_t v = 0;
+        for (int j = 0; j < 8; ++j) {
+          if (b & (1 << j)) v ^= basis[8 * k + j];
+        }
+        shift_[k][b] = v;
+      }
+    }
   }
 
-  // Process remaining bytes one at a time.
-  l = l64;
-  while (p < e) {
-    l = _mm_crc32_u8(l, *p);
-    p++;
+  uint32_t Shift(uint32_t l) const {
+    return shift_[0][l & 0xff] ^ shift_[1][(l >> 8) & 0xff] ^
+           shift_[2][(l >> 16) & 0xff] ^ shift_[3][l >> 24];
   }
 
+  uint32_t shift_[4][256];
+};
+
+CRC32C_TARGET uint32_t AcceleratedExtend(uint32_t crc, const char *buf,
+                                         size_t size) {
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
+  uint32_t l = crc ^ 0xffffffffu;
+
+  // Process bytes until p is 8-byte aligned.
+  for (; size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0; ++p, --size) {
+    l = Crc8(l, *p);
+  }
+  if (size >= 3 * 256) {
+    l = ThreeStreams<4096>::Get().Extend(l, &p, &size);
+    l = ThreeStreams<256>::Get().Extend(l, &p, &size);
+  }
+  l = ExtendRaw(l, p, size);
   return l ^ 0xffffffffu;
 }
 
@@ -0,0 +1,185 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/lz4/lz4_inputstream.h"
+
+#include <string.h>
+
+#include "lz4frame.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+struct Lz4StreamDef {
+  Lz4StreamDef(size_t input_buffer_capacity, size_t output_buffer_capacity)
+      : input(new char[input_buffer_capacity]),
+        output(new char[output_buffer_capacity]) {}
+
+  ~Lz4StreamDef() { LZ4F_freeDecompressionContext(dctx); }
+
+  LZ4F_dctx* dctx = nullptr;
+
+  // Compressed bytes in [input + input_pos, input + input_size) have not been
+  // decompressed yet.
+  std::unique_ptr<char[]> input;
+  size_t input_pos = 0;
+  size_t input_size = 0;
+
+  // Decompressed bytes in [next_unread_byte, next_unread_byte + avail_out)
+  // have not been returned to the caller yet.
+  std::unique_ptr<char[]> output;
+  char* next_unread_byte = nullptr;
+  size_t avail_out = 0;
+
+  // Whether the last call to LZ4F_decompress filled `output` in the middle of
+  // a frame, in which case lz4 may hold more output without needing more
+  // input.
+  bool output_full = false;
+
+  // Whether the decoder stopped in the middle of a frame.
+  bool in_frame = false;
+};
+
+Lz4InputStream::Lz4InputStream(InputStreamInterface* input_stream,
+                               size_t input_buffer_bytes,
+                               size_t output_buffer_bytes,
+                               bool owns_input_stream)
+    : owns_input_stream_(owns_input_stream),
+      input_stream_(input_stream),
+      input_buffer_capacity_(input_buffer_bytes),
+      output_buffer_capacity_(output_buffer_bytes),
+      lz4_stream_def_(
+          new Lz4StreamDef(input_buffer_bytes, output_buffer_bytes)) {
+  LZ4F_errorCode_t ret =
+      LZ4F_createDecompressionContext(&lz4_stream_def_->dctx, LZ4F_VERSION);
+  if (LZ4F_isError(ret)) {
+    init_status_ = errors::ResourceExhausted(
+        "Failed to create lz4 decompression context: ",
+        LZ4F_getErrorName(ret));
+  }
+}
+
+Lz4InputStream::Lz4InputStream(InputStreamInterface* input_stream,
+                               size_t input_buffer_bytes,
+                               size_t output_buffer_bytes)
+    : Lz4InputStream(input_stream, input_buffer_bytes, output_buffer_bytes,
+                     false) {}
+
+Lz4InputStream::~Lz4InputStream() {
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+Status Lz4InputStream::Reset() {
+  TF_RETURN_IF_ERROR(init_status_);
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+  LZ4F_resetDecompressionContext(lz4_stream_def_->dctx);
+  lz4_stream_def_->input_pos = 0;
+  lz4_stream_def_->input_size = 0;
+  lz4_stream_def_->avail_out = 0;
+  lz4_stream_def_->output_full = false;
+  lz4_stream_def_->in_frame = false;
+  bytes_read_ = 0;
+  return Status::OK();
+}
+
+Status Lz4InputStream::ReadFromStream() {
+  tstring data;
+  Status s = input_stream_->ReadNBytes(input_buffer_capacity_, &data);
+  // A short read at the end of the file still yields usable data.
+  if (errors::IsOutOfRange(s) && !data.empty()) {
+    s = Status::OK();
+  }
+  TF_RETURN_IF_ERROR(s);
+  memcpy(lz4_stream_def_->input.get(), data.data(), data.size());
+  lz4_stream_def_->input_pos = 0;
+  lz4_stream_def_->input_size = data.size();
+  return Status::OK();
+}
+
+Status Lz4InputStream::Decompress() {
+  Lz4StreamDef* def = lz4_stream_def_.get();
+  DCHECK_EQ(def->avail_out, 0);
+  // Frame and block headers are consumed without producing any output, so
+  // keep feeding the decoder until something comes out.
+  while (def->avail_out == 0) {
+    if (def->input_pos == def->input_size && !def->output_full) {
+      Status s = ReadFromStream();
+      if (errors::IsOutOfRange(s) && def->in_frame) {
+        return errors::DataLoss("Truncated lz4 stream after ", bytes_read_,
+                                " decompressed bytes");
+      }
+      TF_RETURN_IF_ERROR(s);
+    }
+    size_t dst_size = output_buffer_capacity_;
+    size_t src_size = def->input_size - def->input_pos;
+    size_t ret =
+        LZ4F_decompress(def->dctx, def->output.get(), &dst_size,
+                        def->input.get() + def->input_pos, &src_size, nullptr);
+    if (LZ4F_isError(ret)) {
+      return errors::DataLoss("lz4 decompression failed: ",
+                              LZ4F_getErrorName(ret));
+    }
+    def->input_pos += src_size;
+    def->in_frame = ret != 0;
+    def->output_full =
+        def->in_frame && dst_size == output_buffer_capacity_;
+    def->next_unread_byte = def->output.get();
+    def->avail_out = dst_size;
+  }
+  return Status::OK();
+}
+
+size_t Lz4InputStream::ReadBytesFromCache(size_t bytes_to_read,
+                                          tstring* result) {
+  Lz4StreamDef* def = lz4_stream_def_.get();
+  size_t can_read_bytes = std::min(bytes_to_read, def->avail_out);
+  if (can_read_bytes > 0) {
+    result->append(def->next_unread_byte, can_read_bytes);
+    def->next_unread_byte += can_read_bytes;
+    def->avail_out -= can_read_bytes;
+    bytes_read_ += can_read_bytes;
+  }
+  return can_read_bytes;
+}
+
+Status Lz4InputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  TF_RETURN_IF_ERROR(init_status_);
+  result->clear();
+  bytes_to_read -= ReadBytesFromCache(bytes_to_read, result);
+  while (bytes_to_read > 0) {
+    TF_RETURN_IF_ERROR(Decompress());
+    bytes_to_read -= ReadBytesFromCache(bytes_to_read, result);
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status Lz4InputStream::ReadNBytes(int64 bytes_to_read, absl::Cord* result) {
+  tstring buf;
+  TF_RETURN_IF_ERROR(ReadNBytes(bytes_to_read, &buf));
+  result->Clear();
+  result->Append(buf.data());
+  return Status::OK();
+}
+#endif
+
+int64 Lz4InputStream::Tell() const { return bytes_read_; }
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,104 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_INPUTSTREAM_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Forward declare the decompression state, lz4frame.h is only included in the
+// .cc file.
+struct Lz4StreamDef;
+
+// A Lz4InputStream reads a stream in the LZ4 frame format
+// (https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md), such as the
+// output of Lz4OutputBuffer or the `lz4` command line tool. Concatenated
+// frames are read back as one stream.
+//
+// A given instance of a Lz4InputStream is NOT safe for concurrent use
+// by multiple threads.
+class Lz4InputStream : public InputStreamInterface {
+ public:
+  // Creates a Lz4InputStream for `input_stream` with a buffer of size
+  // `input_buffer_bytes` bytes for reading contents from `input_stream` and
+  // another buffer with size `output_buffer_bytes` for caching decompressed
+  // contents.
+  //
+  // Takes ownership of `input_stream` iff `owns_input_stream` is true.
+  Lz4InputStream(InputStreamInterface* input_stream, size_t input_buffer_bytes,
+                 size_t output_buffer_bytes, bool owns_input_stream);
+
+  // Equivalent to the previous constructor with owns_input_stream=false.
+  Lz4InputStream(InputStreamInterface* input_stream, size_t input_buffer_bytes,
+                 size_t output_buffer_bytes);
+
+  ~Lz4InputStream() override;
+
+  // Reads bytes_to_read bytes into *result, overwriting *result.
+  //
+  // Return Status codes:
+  // OK:           If successful.
+  // OUT_OF_RANGE: If there are not enough bytes to read before
+  //               the end of the stream.
+  // DATA_LOSS:    If the compressed data is corrupted or truncated.
+  // others:       If reading from stream failed.
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status ReadNBytes(int64 bytes_to_read, absl::Cord* result) override;
+#endif
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  // Refills the input buffer from `input_stream_`. Returns OutOfRange if no
+  // data is left in `input_stream_`.
+  Status ReadFromStream();
+
+  // Decompresses the next chunk of data into the output buffer. Returns
+  // OutOfRange at the end of the stream.
+  Status Decompress();
+
+  // Appends at most `bytes_to_read` cached decompressed bytes to `result`.
+  // Returns the number of bytes appended.
+  size_t ReadBytesFromCache(size_t bytes_to_read, tstring* result);
+
+  const bool owns_input_stream_;
+  InputStreamInterface* input_stream_;
+  const size_t input_buffer_capacity_;
+  const size_t output_buffer_capacity_;
+  Status init_status_;
+
+  std::unique_ptr<Lz4StreamDef> lz4_stream_def_;
+
+  // Number of *uncompressed* bytes that have been read from this stream.
+  int64 bytes_read_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Lz4InputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_LZ4_LZ4_INPUTSTREAM_H_
@@ -0,0 +1,211 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/lz4/lz4_outputbuffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "lz4frame.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+LZ4F_preferences_t MakePreferences(const Lz4CompressionOptions& options) {
+  LZ4F_preferences_t preferences;
+  memset(&preferences, 0, sizeof(preferences));
+  preferences.compressionLevel = options.compression_level;
+  return preferences;
+}
+
+}  // namespace
+
+Lz4OutputBuffer::Lz4OutputBuffer(WritableFile* file, size_t input_buffer_bytes,
+                                 size_t output_buffer_bytes,
+                                 const Lz4CompressionOptions& lz4_options)
+    : file_(file),
+      input_buffer_capacity_(input_buffer_bytes),
+      output_buffer_capacity_(output_buffer_bytes),
+      lz4_options_(lz4_options),
+      input_buffer_(new char[input_buffer_bytes]) {}
+
+Lz4OutputBuffer::~Lz4OutputBuffer() {
+  if (cctx_ != nullptr) {
+    LOG(WARNING) << "Lz4OutputBuffer::Close() not called. Possible data loss";
+    LZ4F_freeCompressionContext(cctx_);
+  }
+}
+
+Status Lz4OutputBuffer::Init() {
+  if (input_buffer_capacity_ == 0) {
+    return errors::InvalidArgument(
+        "input_buffer_bytes should be greater than 0");
+  }
+  const LZ4F_preferences_t preferences = MakePreferences(lz4_options_);
+  // One compressed input buffer, including the end of the frame, must always
+  // fit in the output buffer.
+  output_buffer_capacity_ = std::max<size_t>(
+      {output_buffer_capacity_,
+       LZ4F_compressBound(input_buffer_capacity_, &preferences),
+       LZ4F_HEADER_SIZE_MAX});
+  output_buffer_.reset(new char[output_buffer_capacity_]);
+
+  LZ4F_errorCode_t ret = LZ4F_createCompressionContext(&cctx_, LZ4F_VERSION);
+  if (LZ4F_isError(ret)) {
+    cctx_ = nullptr;
+    return errors::ResourceExhausted(
+        "Failed to create lz4 compression context: ", LZ4F_getErrorName(ret));
+  }
+  size_t header_size = LZ4F_compressBegin(
+      cctx_, output_buffer_.get(), output_buffer_capacity_, &preferences);
+  if (LZ4F_isError(header_size)) {
+    LZ4F_freeCompressionContext(cctx_);
+    cctx_ = nullptr;
+    return errors::InvalidArgument("Invalid lz4 compression options: ",
+                                   LZ4F_getErrorName(header_size));
+  }
+  output_size_ = header_size;
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::CheckNotClosed() const {
+  if (cctx_ == nullptr) {
+    return errors::FailedPrecondition(
+        "Lz4OutputBuffer not initialized or already closed");
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::FlushOutputBufferToFile() {
+  if (output_size_ > 0) {
+    TF_RETURN_IF_ERROR(
+        file_->Append(StringPiece(output_buffer_.get(), output_size_)));
+    output_size_ = 0;
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::ReserveOutput(size_t bytes) {
+  if (output_buffer_capacity_ - output_size_ < bytes) {
+    return FlushOutputBufferToFile();
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::Compress(StringPiece data) {
+  const LZ4F_preferences_t preferences = MakePreferences(lz4_options_);
+  while (!data.empty()) {
+    const size_t chunk_size = std::min(data.size(), input_buffer_capacity_);
+    TF_RETURN_IF_ERROR(
+        ReserveOutput(LZ4F_compressBound(chunk_size, &preferences)));
+    size_t ret = LZ4F_compressUpdate(
+        cctx_, output_buffer_.get() + output_size_,
+        output_buffer_capacity_ - output_size_, data.data(), chunk_size,
+        nullptr);
+    if (LZ4F_isError(ret)) {
+      return errors::DataLoss("lz4 compression failed: ",
+                              LZ4F_getErrorName(ret));
+    }
+    output_size_ += ret;
+    data.remove_prefix(chunk_size);
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::CompressBuffered() {
+  TF_RETURN_IF_ERROR(Compress(StringPiece(input_buffer_.get(), input_size_)));
+  input_size_ = 0;
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::Append(StringPiece data) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  if (data.size() <= input_buffer_capacity_ - input_size_) {
+    memcpy(input_buffer_.get() + input_size_, data.data(), data.size());
+    input_size_ += data.size();
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(CompressBuffered());
+  if (data.size() <= input_buffer_capacity_) {
+    memcpy(input_buffer_.get(), data.data(), data.size());
+    input_size_ = data.size();
+    return Status::OK();
+  }
+  // Large writes skip the input buffer.
+  return Compress(data);
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status Lz4OutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status Lz4OutputBuffer::Flush() {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  TF_RETURN_IF_ERROR(CompressBuffered());
+  const LZ4F_preferences_t preferences = MakePreferences(lz4_options_);
+  TF_RETURN_IF_ERROR(ReserveOutput(LZ4F_compressBound(0, &preferences)));
+  size_t ret =
+      LZ4F_flush(cctx_, output_buffer_.get() + output_size_,
+                 output_buffer_capacity_ - output_size_, nullptr);
+  if (LZ4F_isError(ret)) {
+    return errors::DataLoss("lz4 flush failed: ", LZ4F_getErrorName(ret));
+  }
+  output_size_ += ret;
+  TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  return file_->Flush();
+}
+
+Status Lz4OutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status Lz4OutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status Lz4OutputBuffer::Close() {
+  if (cctx_ != nullptr) {
+    TF_RETURN_IF_ERROR(CompressBuffered());
+    const LZ4F_preferences_t preferences = MakePreferences(lz4_options_);
+    TF_RETURN_IF_ERROR(ReserveOutput(LZ4F_compressBound(0, &preferences)));
+    size_t ret =
+        LZ4F_compressEnd(cctx_, output_buffer_.get() + output_size_,
+                         output_buffer_capacity_ - output_size_, nullptr);
+    if (LZ4F_isError(ret)) {
+      return errors::DataLoss("lz4 compression failed: ",
+                              LZ4F_getErrorName(ret));
+    }
+    output_size_ += ret;
+    TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+    LZ4F_freeCompressionContext(cctx_);
+    cctx_ = nullptr;
+  }
+  return Status::OK();
+}
+
+Status Lz4OutputBuffer::Tell(int64* position) { return file_->Tell(position); }
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/lz4/lz4_inputstream.h"
+#include "tensorflow/core/lib/io/lz4/lz4_outputbuffer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+string GenTestString(int copies) {
+  string result;
+  for (int i = 0; i < copies; ++i) {
+    strings::StrAppend(&result, "Lorem ipsum dolor sit amet ", i,
+                       ", consectetur adipiscing elit. ");
+  }
+  return result;
+}
+
+// Writes `num_writes` copies of `data` to `fname` through a Lz4OutputBuffer.
+Status WriteCompressedFile(const string& fname, const string& data,
+                           int num_writes, bool with_flush,
+                           size_t input_buffer_bytes,
+                           size_t output_buffer_bytes,
+                           const Lz4CompressionOptions& options) {
+  std::unique_ptr<WritableFile> file_writer;
+  TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(fname, &file_writer));
+  Lz4OutputBuffer out(file_writer.get(), input_buffer_bytes,
+                      output_buffer_bytes, options);
+  TF_RETURN_IF_ERROR(out.Init());
+  for (int i = 0; i < num_writes; ++i) {
+    TF_RETURN_IF_ERROR(out.Append(data));
+    if (with_flush) {
+      TF_RETURN_IF_ERROR(out.Flush());
+    }
+  }
+  TF_RETURN_IF_ERROR(out.Close());
+  return file_writer->Close();
+}
+
+void TestRoundTrip(size_t compress_input_buf_size,
+                   size_t compress_output_buf_size,
+                   size_t uncompress_input_buf_size,
+                   size_t uncompress_output_buf_size, int num_writes,
+                   bool with_flush, int num_copies,
+                   const Lz4CompressionOptions& options) {
+  const string fname = testing::TmpDir() + "/lz4_buffers_test";
+  const string data = GenTestString(num_copies);
+  TF_ASSERT_OK(WriteCompressedFile(fname, data, num_writes, with_flush,
+                                   compress_input_buf_size,
+                                   compress_output_buf_size, options));
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file_reader));
+  RandomAccessInputStream random_input_stream(file_reader.get());
+  Lz4InputStream in(&random_input_stream, uncompress_input_buf_size,
+                    uncompress_output_buf_size);
+
+  // Run the test twice, resetting the stream after the first attempt.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    for (int i = 0; i < num_writes; ++i) {
+      tstring decompressed_output;
+      TF_ASSERT_OK(in.ReadNBytes(data.size(), &decompressed_output));
+      EXPECT_EQ(data, decompressed_output);
+      EXPECT_EQ(data.size() * (i + 1), in.Tell());
+    }
+    tstring rest;
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &rest)));
+    EXPECT_TRUE(rest.empty());
+    TF_ASSERT_OK(in.Reset());
+  }
+}
+
+TEST(Lz4Buffers, MultipleWritesWithoutFlush) {
+  TestRoundTrip(256, 256, 256, 256, 10, false, 10, Lz4CompressionOptions());
+}
+
+TEST(Lz4Buffers, MultipleWritesWithFlush) {
+  TestRoundTrip(256, 256, 256, 256, 10, true, 10, Lz4CompressionOptions());
+}
+
+TEST(Lz4Buffers, TinyBuffers) {
+  TestRoundTrip(1, 1, 1, 1, 3, true, 2, Lz4CompressionOptions());
+}
+
+TEST(Lz4Buffers, WritesLargerThanInputBuffer) {
+  TestRoundTrip(100, 64, 32, 2 << 10, 5, false, 200, Lz4CompressionOptions());
+}
+
+TEST(Lz4Buffers, HighCompression) {
+  Lz4CompressionOptions options;
+  options.compression_level = 9;
+  TestRoundTrip(1 << 10, 1 << 10, 1 << 10, 1 << 10, 20, true, 50, options);
+}
+
+TEST(Lz4Buffers, TruncatedFile) {
+  const string fname = testing::TmpDir() + "/lz4_buffers_truncated_test";
+  const string data = GenTestString(100);
+  TF_ASSERT_OK(WriteCompressedFile(fname, data, 1, false, 256, 256,
+                                   Lz4CompressionOptions()));
+  string compressed;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), fname, &compressed));
+  compressed.resize(compressed.size() - 1);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname, compressed));
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file_reader));
+  RandomAccessInputStream random_input_stream(file_reader.get());
+  Lz4InputStream in(&random_input_stream, 256, 256);
+  tstring decompressed_output;
+  EXPECT_TRUE(
+      errors::IsDataLoss(in.ReadNBytes(data.size(), &decompressed_output)));
+}
+
+TEST(Lz4Buffers, CloseTwice) {
+  const string fname = testing::TmpDir() + "/lz4_buffers_close_test";
+  std::unique_ptr<WritableFile> file_writer;
+  TF_ASSERT_OK(Env::Default()->NewWritableFile(fname, &file_writer));
+  Lz4OutputBuffer out(file_writer.get(), 256, 256, Lz4CompressionOptions());
+  TF_ASSERT_OK(out.Init());
+  TF_ASSERT_OK(out.Append("data"));
+  TF_ASSERT_OK(out.Close());
+  TF_EXPECT_OK(out.Close());
+  EXPECT_TRUE(errors::IsFailedPrecondition(out.Append("more")));
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
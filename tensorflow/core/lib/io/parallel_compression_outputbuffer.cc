@@ -0,0 +1,147 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/parallel_compression_outputbuffer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+ParallelCompressionOutputBuffer::ParallelCompressionOutputBuffer(
+    WritableFile* file, size_t block_bytes, int num_threads,
+    CompressFn compress)
+    : file_(file),
+      block_bytes_(std::max<size_t>(block_bytes, 1)),
+      num_threads_(std::max(num_threads, 1)),
+      compress_(std::move(compress)),
+      current_(new Block),
+      thread_pool_(new thread::ThreadPool(
+          Env::Default(), "parallel_compression", num_threads_)) {
+  current_->input.reserve(block_bytes_);
+}
+
+ParallelCompressionOutputBuffer::~ParallelCompressionOutputBuffer() {
+  if (!closed_) {
+    LOG(WARNING) << "ParallelCompressionOutputBuffer::Close() not called. "
+                 << "Possible data loss";
+  }
+  thread_pool_.reset();
+}
+
+void ParallelCompressionOutputBuffer::ScheduleCurrentBlock() {
+  Block* block = current_.get();
+  {
+    mutex_lock l(mu_);
+    blocks_.push_back(std::move(current_));
+  }
+  current_.reset(new Block);
+  current_->input.reserve(block_bytes_);
+  thread_pool_->Schedule([this, block]() {
+    string output;
+    const Status s = compress_(block->input, &output);
+    string().swap(block->input);
+    mutex_lock l(mu_);
+    block->output = std::move(output);
+    block->status = s;
+    block->done = true;
+    block_done_.notify_all();
+  });
+}
+
+Status ParallelCompressionOutputBuffer::WriteBlocks(bool wait_for_all) {
+  const size_t max_blocks = wait_for_all ? 0 : 2 * num_threads_;
+  while (status_.ok()) {
+    std::unique_ptr<Block> block;
+    {
+      mutex_lock l(mu_);
+      if (blocks_.empty()) break;
+      Block* front = blocks_.front().get();
+      if (!front->done && blocks_.size() <= max_blocks) break;
+      while (!front->done) block_done_.wait(l);
+      block = std::move(blocks_.front());
+      blocks_.pop_front();
+    }
+    status_ = block->status;
+    if (status_.ok()) status_ = file_->Append(block->output);
+  }
+  return status_;
+}
+
+Status ParallelCompressionOutputBuffer::Append(StringPiece data) {
+  if (closed_) {
+    return errors::FailedPrecondition(
+        "ParallelCompressionOutputBuffer already closed");
+  }
+  TF_RETURN_IF_ERROR(status_);
+  while (!data.empty()) {
+    const size_t bytes_to_add =
+        std::min(data.size(), block_bytes_ - current_->input.size());
+    current_->input.append(data.data(), bytes_to_add);
+    data.remove_prefix(bytes_to_add);
+    if (current_->input.size() == block_bytes_) {
+      ScheduleCurrentBlock();
+      TF_RETURN_IF_ERROR(WriteBlocks(/*wait_for_all=*/false));
+    }
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ParallelCompressionOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status ParallelCompressionOutputBuffer::Flush() {
+  if (closed_) {
+    return errors::FailedPrecondition(
+        "ParallelCompressionOutputBuffer already closed");
+  }
+  if (!current_->input.empty()) ScheduleCurrentBlock();
+  TF_RETURN_IF_ERROR(WriteBlocks(/*wait_for_all=*/true));
+  return file_->Flush();
+}
+
+Status ParallelCompressionOutputBuffer::Close() {
+  if (closed_) return Status::OK();
+  closed_ = true;
+  if (!current_->input.empty()) ScheduleCurrentBlock();
+  return WriteBlocks(/*wait_for_all=*/true);
+}
+
+Status ParallelCompressionOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ParallelCompressionOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status ParallelCompressionOutputBuffer::Tell(int64* position) {
+  return file_->Tell(position);
+}
+
+}  // namespace io
+}  // namespace tensorflow
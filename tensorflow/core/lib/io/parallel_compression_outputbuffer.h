@@ -0,0 +1,129 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_PARALLEL_COMPRESSION_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_PARALLEL_COMPRESSION_OUTPUTBUFFER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Splits its input into blocks, compresses each block on its own on a thread
+// pool, and writes the compressed blocks to a file in order. This only yields
+// a readable file for formats in which independently compressed streams can
+// be concatenated, such as gzip members or zstd frames.
+//
+// A given instance of a ParallelCompressionOutputBuffer is NOT safe for
+// concurrent use by multiple threads.
+class ParallelCompressionOutputBuffer : public WritableFile {
+ public:
+  // Compresses `input` into `*output` as a complete, independent stream.
+  // Called concurrently from the thread pool.
+  using CompressFn = std::function<Status(StringPiece input, string* output)>;
+
+  // Creates a ParallelCompressionOutputBuffer for `file` that compresses
+  // blocks of `block_bytes` with `compress` on `num_threads` threads. At most
+  // twice as many blocks as there are threads are buffered, beyond which
+  // `Append()` waits for the oldest one.
+  // Does not take ownership of `file`.
+  ParallelCompressionOutputBuffer(WritableFile* file, size_t block_bytes,
+                                  int num_threads, CompressFn compress);
+
+  // Waits for blocks being compressed, but does not write them.
+  ~ParallelCompressionOutputBuffer() override;
+
+  // Adds `data` to the current block, and schedules the block for
+  // compression when it is full.
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Compresses the current block, even if not full, waits for all blocks and
+  // writes them to file, then flushes it. Frequent flushes produce small
+  // blocks that compress poorly.
+  Status Flush() override;
+
+  // Compresses the current block and writes all blocks to file. This must be
+  // called before the destructor to avoid any data loss. Does not close the
+  // file.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or `Sync()`
+  // will fail.
+  Status Close() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Writes all blocks to file, as `Flush()` does, and syncs it.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  Status Tell(int64* position) override;
+
+ private:
+  struct Block {
+    string input;
+    string output;
+    Status status;
+    bool done = false;
+  };
+
+  // Hands the current block to the thread pool.
+  void ScheduleCurrentBlock();
+
+  // Writes the compressed blocks at the front of `blocks_` to file. Waits for
+  // all blocks if `wait_for_all`, or else only until at most `2 * num_threads_`
+  // blocks are left.
+  Status WriteBlocks(bool wait_for_all);
+
+  WritableFile* file_;  // Not owned
+  const size_t block_bytes_;
+  const int num_threads_;
+  const CompressFn compress_;
+  std::unique_ptr<Block> current_;
+  bool closed_ = false;
+  // Status of the first failed write or compression.
+  Status status_;
+
+  mutex mu_;
+  condition_variable block_done_;
+  // Blocks handed to the thread pool, in the order of the input.
+  std::deque<std::unique_ptr<Block>> blocks_;
+  // Declared last so that its destruction waits for running compressions
+  // before the blocks go away.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ParallelCompressionOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_PARALLEL_COMPRESSION_OUTPUTBUFFER_H_
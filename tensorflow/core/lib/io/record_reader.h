@@ -19,11 +19,18 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/platform.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/snappy/snappy_compression_options.h"
 #include "tensorflow/core/lib/io/snappy/snappy_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/lib/io/lz4/lz4_compression_options.h"
+#include "tensorflow/core/lib/io/lz4/lz4_inputstream.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
+#endif  // IS_MOBILE_PLATFORM
 #endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -38,7 +45,9 @@ struct RecordReaderOptions {
   enum CompressionType {
     NONE = 0,
     ZLIB_COMPRESSION = 1,
-    SNAPPY_COMPRESSION = 2
+    SNAPPY_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3,
+    LZ4_COMPRESSION = 4
   };
   CompressionType compression_type = NONE;
 
@@ -47,6 +56,12 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // Whether to verify the crc of each record's data. The crc of each record's
+  // length is always verified, so corrupted framing is still detected. Turning
+  // this off removes most of the checksumming cost, for storage that already
+  // guarantees the integrity of what it returns.
+  bool verify_data_checksum = true;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -54,6 +69,10 @@ struct RecordReaderOptions {
   // Options specific to compression.
   ZlibCompressionOptions zlib_options;
   SnappyCompressionOptions snappy_options;
+#if !defined(IS_MOBILE_PLATFORM)
+  ZstdCompressionOptions zstd_options;
+  Lz4CompressionOptions lz4_options;
+#endif  // IS_MOBILE_PLATFORM
 #endif  // IS_SLIM_BUILD
 };
 
@@ -116,7 +135,8 @@ class RecordReader {
   Status GetMetadata(Metadata* md);
 
  private:
-  Status ReadChecksummed(uint64 offset, size_t n, tstring* result);
+  Status ReadChecksummed(uint64 offset, size_t n, tstring* result,
+                         bool verify_checksum = true);
   Status PositionInputStream(uint64 offset);
 
   RecordReaderOptions options_;
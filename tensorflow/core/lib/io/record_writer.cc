@@ -49,6 +49,12 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
   } else if (compression_type == compression::kSnappy) {
     options.compression_type = io::RecordWriterOptions::SNAPPY_COMPRESSION;
+#if !defined(IS_MOBILE_PLATFORM)
+  } else if (compression_type == compression::kZstd) {
+    options.compression_type = io::RecordWriterOptions::ZSTD_COMPRESSION;
+  } else if (compression_type == compression::kLz4) {
+    options.compression_type = io::RecordWriterOptions::LZ4_COMPRESSION;
+#endif  // IS_MOBILE_PLATFORM
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
                << ". No compression will be used.";
@@ -65,7 +71,15 @@ RecordWriter::RecordWriter(WritableFile* dest,
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (IsZlibCompressed(options)) {
+  if (IsZlibCompressed(options) && options.zlib_options.num_workers > 0 &&
+      options.zlib_options.window_bits > MAX_WBITS) {
+    const ZlibCompressionOptions zlib_options = options.zlib_options;
+    dest_ = new ParallelCompressionOutputBuffer(
+        dest, zlib_options.input_buffer_size, zlib_options.num_workers,
+        [zlib_options](StringPiece input, string* output) {
+          return ZlibCompress(input, zlib_options, output);
+        });
+  } else if (IsZlibCompressed(options)) {
     ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
         dest, options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options);
@@ -79,6 +93,30 @@ RecordWriter::RecordWriter(WritableFile* dest,
     dest_ =
         new SnappyOutputBuffer(dest, options.snappy_options.input_buffer_size,
                                options.snappy_options.output_buffer_size);
+#if !defined(IS_MOBILE_PLATFORM)
+  } else if (options.compression_type ==
+             RecordWriterOptions::ZSTD_COMPRESSION) {
+    ZstdOutputBuffer* zstd_output_buffer = new ZstdOutputBuffer(
+        dest, options.zstd_options.input_buffer_size,
+        options.zstd_options.output_buffer_size, options.zstd_options);
+    Status s = zstd_output_buffer->Init();
+    if (!s.ok()) {
+      LOG(FATAL) << "Failed to initialize Zstd outputbuffer. Error: "
+                 << s.ToString();
+    }
+    dest_ = zstd_output_buffer;
+  } else if (options.compression_type ==
+             RecordWriterOptions::LZ4_COMPRESSION) {
+    Lz4OutputBuffer* lz4_output_buffer = new Lz4OutputBuffer(
+        dest, options.lz4_options.input_buffer_size,
+        options.lz4_options.output_buffer_size, options.lz4_options);
+    Status s = lz4_output_buffer->Init();
+    if (!s.ok()) {
+      LOG(FATAL) << "Failed to initialize LZ4 outputbuffer. Error: "
+                 << s.ToString();
+    }
+    dest_ = lz4_output_buffer;
+#endif  // IS_MOBILE_PLATFORM
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
   } else {
@@ -138,7 +176,7 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
 
 Status RecordWriter::Close() {
   if (dest_ == nullptr) return Status::OK();
-  if (IsZlibCompressed(options_) || IsSnappyCompressed(options_)) {
+  if (options_.compression_type != RecordWriterOptions::NONE) {
     Status s = dest_->Close();
     delete dest_;
     dest_ = nullptr;
@@ -175,6 +175,11 @@ class RecordioTest : public ::testing::Test {
 
   void ForceError() { source_.force_error(); }
 
+  void SetReaderOptions(const RecordReaderOptions& options) {
+    delete reader_;
+    reader_ = new RecordReader(&source_, options);
+  }
+
   void StartReadingAt(uint64_t initial_offset) { readpos_ = initial_offset; }
 
   void CheckOffsetPastEndReturnsNoRecords(uint64_t offset_past_end) {
@@ -368,6 +373,24 @@ TEST_F(RecordioTest, CorruptDataCrc) {
   AssertHasSubstr(Read(), "Data loss");
 }
 
+TEST_F(RecordioTest, CorruptDataWithoutDataChecksum) {
+  RecordReaderOptions options;
+  options.verify_data_checksum = false;
+  SetReaderOptions(options);
+  Write("foo");
+  IncrementByte(12, 1);
+  ASSERT_EQ("goo", Read());
+}
+
+TEST_F(RecordioTest, CorruptLengthCrcWithoutDataChecksum) {
+  RecordReaderOptions options;
+  options.verify_data_checksum = false;
+  SetReaderOptions(options);
+  Write("foo");
+  IncrementByte(10, 100);
+  AssertHasSubstr(Read(), "Data loss");
+}
+
 TEST_F(RecordioTest, ReadEnd) { CheckOffsetPastEndReturnsNoRecords(0); }
 
 TEST_F(RecordioTest, ReadPastEnd) { CheckOffsetPastEndReturnsNoRecords(5); }
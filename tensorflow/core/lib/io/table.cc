@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/table.h"
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/block.h"
@@ -22,7 +26,9 @@ limitations under the License.
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/table_options.h"
 #include "tensorflow/core/lib/io/two_level_iterator.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace table {
@@ -179,6 +185,69 @@ Status Table::InternalGet(const StringPiece& k, void* arg,
   return s;
 }
 
+Status Table::MultiGet(
+    const std::vector<StringPiece>& keys,
+    const std::function<void(size_t i, const StringPiece& value)>& found,
+    thread::ThreadPool* pool) const {
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+  // Groups the sorted keys by the block that may hold them.  An index entry's
+  // key is >= the last key of its block and < the first key of the next one,
+  // so the index only needs a seek once a key is past the current entry.
+  struct BlockKeys {
+    string handle;
+    std::vector<size_t> keys;
+  };
+  std::vector<BlockKeys> blocks;
+  std::unique_ptr<Iterator> index_iter(rep_->index_block->NewIterator());
+  for (size_t i : order) {
+    if (blocks.empty() || keys[i] > index_iter->key()) {
+      index_iter->Seek(keys[i]);
+      if (!index_iter->Valid()) {
+        // This and all later keys are past the last key of the table.
+        break;
+      }
+      blocks.push_back({string(index_iter->value()), {}});
+    }
+    blocks.back().keys.push_back(i);
+  }
+  TF_RETURN_IF_ERROR(index_iter->status());
+
+  Table* table = const_cast<Table*>(this);
+  auto read_block = [table, &keys, &found](const BlockKeys& block) {
+    std::unique_ptr<Iterator> block_iter(BlockReader(table, block.handle));
+    for (size_t i : block.keys) {
+      block_iter->Seek(keys[i]);
+      if (block_iter->Valid() && block_iter->key() == keys[i]) {
+        found(i, block_iter->value());
+      }
+    }
+    return block_iter->status();
+  };
+  if (pool == nullptr || blocks.size() < 2) {
+    for (const BlockKeys& block : blocks) {
+      TF_RETURN_IF_ERROR(read_block(block));
+    }
+    return Status::OK();
+  }
+  std::vector<Status> statuses(blocks.size());
+  BlockingCounter counter(blocks.size());
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    pool->Schedule([&read_block, &blocks, &statuses, &counter, b]() {
+      statuses[b] = read_block(blocks[b]);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
 uint64 Table::ApproximateOffsetOf(const StringPiece& key) const {
   Iterator* index_iter = rep_->index_block->NewIterator();
   index_iter->Seek(key);
@@ -18,12 +18,19 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <functional>
+#include <vector>
+
 #include "tensorflow/core/lib/io/iterator.h"
 
 namespace tensorflow {
 
 class RandomAccessFile;
 
+namespace thread {
+class ThreadPool;
+}  // namespace thread
+
 namespace table {
 
 struct Options;
@@ -61,6 +68,16 @@ class Table {
   // be close to the file length.
   uint64 ApproximateOffsetOf(const StringPiece& key) const;
 
+  // Looks up all of "keys", which may be in any order, and calls
+  // found(i, value) for each keys[i] that is in the table.  The keys are
+  // sorted and grouped by block, so each block that may hold any of them is
+  // read and decoded once.  If "pool" is non-null, the blocks are read in
+  // parallel on it, and "found" may be called concurrently for different i.
+  Status MultiGet(const std::vector<StringPiece>& keys,
+                  const std::function<void(size_t i, const StringPiece& value)>&
+                      found,
+                  thread::ThreadPool* pool = nullptr) const;
+
  private:
   struct Rep;
   Rep* rep_;
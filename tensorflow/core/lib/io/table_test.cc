@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table.h"
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <string>
 #include <vector>
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace table {
@@ -146,7 +148,7 @@ class StringSource : public RandomAccessFile {
 
  private:
   string contents_;
-  mutable uint64 bytes_read_;
+  mutable std::atomic<uint64> bytes_read_;
 };
 
 typedef std::map<string, string, STLLessThan> KVMap;
@@ -247,6 +249,13 @@ class TableConstructor : public Constructor {
 
   uint64 BytesRead() const { return source_->BytesRead(); }
 
+  Status MultiGet(
+      const std::vector<StringPiece>& keys,
+      const std::function<void(size_t, const StringPiece&)>& found,
+      thread::ThreadPool* pool) const {
+    return table_->MultiGet(keys, found, pool);
+  }
+
  private:
   void Reset() {
     delete table_;
@@ -633,5 +642,39 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, MultiGet) {
+  TableConstructor c;
+  for (int i = 0; i < 1000; ++i) {
+    c.Add(strings::StrCat("k", 1000 + i), strings::StrCat("v", i));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 256;
+  options.compression = kNoCompression;
+  c.Finish(options, &keys, &kvmap);
+
+  // Unsorted, spread over many blocks, with duplicates and missing keys.
+  const std::vector<string> lookup = {"k1999", "k1000", "k1500", "missing",
+                                      "k1500", "k1501", "a",     "k1250x",
+                                      "k1123", "zzz"};
+  const std::vector<string> expected = {"v999", "v0", "v500", "", "v500",
+                                        "v501", "",   "",     "v123", ""};
+  std::vector<StringPiece> lookup_pieces(lookup.begin(), lookup.end());
+  thread::ThreadPool pool(Env::Default(), "multi_get", 4);
+  for (thread::ThreadPool* p : {static_cast<thread::ThreadPool*>(nullptr),
+                                &pool}) {
+    std::vector<string> values(lookup.size());
+    Status s = c.MultiGet(
+        lookup_pieces,
+        [&values](size_t i, const StringPiece& value) {
+          values[i] = string(value);
+        },
+        p);
+    ASSERT_TRUE(s.ok()) << s;
+    EXPECT_EQ(expected, values);
+  }
+}
+
 }  // namespace table
 }  // namespace tensorflow
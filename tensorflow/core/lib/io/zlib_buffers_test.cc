@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/parallel_compression_outputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -109,6 +110,65 @@ TEST(ZlibBuffers, Gzip) {
   TestAllCombinations(CompressionOptions::GZIP(), CompressionOptions::GZIP());
 }
 
+TEST(ZlibBuffers, ParallelGzip) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  const CompressionOptions options = CompressionOptions::GZIP();
+  for (auto file_size : NumCopies()) {
+    string data = GenTestString(file_size);
+    for (auto block_size : InputBufferSizes()) {
+      for (int num_threads : {1, 4}) {
+        std::unique_ptr<WritableFile> file_writer;
+        TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+        ParallelCompressionOutputBuffer out(
+            file_writer.get(), block_size, num_threads,
+            [&options](StringPiece input, string* output) {
+              return ZlibCompress(input, options, output);
+            });
+        // Writes in pieces that do not line up with the blocks, with a flush
+        // in the middle.
+        StringPiece remaining(data);
+        while (!remaining.empty()) {
+          const size_t n = std::min<size_t>(remaining.size(), 777);
+          TF_ASSERT_OK(out.Append(remaining.substr(0, n)));
+          remaining.remove_prefix(n);
+          if (remaining.size() == data.size() / 2) TF_ASSERT_OK(out.Flush());
+        }
+        TF_ASSERT_OK(out.Close());
+        EXPECT_TRUE(errors::IsFailedPrecondition(out.Append("x")));
+        TF_ASSERT_OK(file_writer->Close());
+
+        std::unique_ptr<RandomAccessFile> file_reader;
+        TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+        std::unique_ptr<RandomAccessInputStream> input_stream(
+            new RandomAccessInputStream(file_reader.get()));
+        ZlibInputStream in(input_stream.get(), 1000, 1000, options);
+        tstring result;
+        TF_ASSERT_OK(in.ReadNBytes(data.size(), &result));
+        EXPECT_EQ(result, data);
+        EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &result)));
+      }
+    }
+  }
+}
+
+TEST(ZlibBuffers, ParallelCompressionFailure) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  std::unique_ptr<WritableFile> file_writer;
+  TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+  ParallelCompressionOutputBuffer out(
+      file_writer.get(), 10, 2, [](StringPiece input, string* output) {
+        return errors::Internal("compression failed");
+      });
+  Status s = out.Append(GenTestString());
+  if (s.ok()) s = out.Close();
+  EXPECT_TRUE(errors::IsInternal(s)) << s;
+  out.Close().IgnoreError();
+}
+
 void TestMultipleWrites(uint8 input_buf_size, uint8 output_buf_size,
                         int num_writes, bool with_flush = false) {
   Env* env = Env::Default();
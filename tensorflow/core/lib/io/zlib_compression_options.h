@@ -111,6 +111,16 @@ class ZlibCompressionOptions {
   // for a simpler decoder for special applications.
   int8 compression_strategy;
 
+  // If positive, RecordWriter compresses gzip output (window_bits of
+  // 16 + [8..15]) on this many threads: each block of `input_buffer_size`
+  // bytes becomes an independent gzip member, and the members are written in
+  // order. This costs a little compression ratio. Other formats are always
+  // compressed on the writing thread, since readers stop at the end of the
+  // first zlib stream.
+  //
+  // This option is ignored for `ZlibInputStream`.
+  int32 num_workers = 0;
+
   // When this is set to true and we are unable to find the header to correctly
   // decompress a file, we return an error when `ReadNBytes` is called instead
   // of CHECK-failing. Defaults to false (i.e. CHECK-failing).
@@ -239,5 +239,33 @@ Status ZlibOutputBuffer::Deflate(int flush) {
 
 Status ZlibOutputBuffer::Tell(int64* position) { return file_->Tell(position); }
 
+Status ZlibCompress(StringPiece input,
+                    const ZlibCompressionOptions& zlib_options,
+                    string* output) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  int status =
+      deflateInit2(&stream, zlib_options.compression_level,
+                   zlib_options.compression_method, zlib_options.window_bits,
+                   zlib_options.mem_level, zlib_options.compression_strategy);
+  if (status != Z_OK) {
+    return errors::InvalidArgument("deflateInit failed with status", status);
+  }
+  output->resize(deflateBound(&stream, input.size()));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  stream.avail_out = output->size();
+  // With an output buffer of deflateBound() bytes, a single call compresses
+  // all input.
+  status = deflate(&stream, Z_FINISH);
+  output->resize(stream.total_out);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    return errors::DataLoss("deflate() failed with error ", status);
+  }
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
@@ -152,6 +152,14 @@ class ZlibOutputBuffer : public WritableFile {
   TF_DISALLOW_COPY_AND_ASSIGN(ZlibOutputBuffer);
 };
 
+// Compresses `input` into `*output` as one complete zlib, gzip or raw deflate
+// stream, as selected by `zlib_options.window_bits`. ZlibInputStream reads
+// concatenated gzip streams as one, so gzip output of this function can be
+// used with ParallelCompressionOutputBuffer.
+Status ZlibCompress(StringPiece input,
+                    const ZlibCompressionOptions& zlib_options,
+                    string* output);
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -0,0 +1,193 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/zstd/zstd_inputstream.h"
+
+#include <string.h>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "zstd.h"
+
+namespace tensorflow {
+namespace io {
+
+struct ZstdStreamDef {
+  ZstdStreamDef(size_t input_buffer_capacity, size_t output_buffer_capacity)
+      : input(new char[input_buffer_capacity]),
+        output(new char[output_buffer_capacity]) {
+    in.src = input.get();
+    in.size = 0;
+    in.pos = 0;
+  }
+
+  ~ZstdStreamDef() { ZSTD_freeDCtx(dctx); }
+
+  ZSTD_DCtx* dctx = nullptr;
+
+  // Compressed bytes read from the input stream. `in.pos` is the next byte to
+  // decompress and `in.size` the number of valid bytes in `input`.
+  std::unique_ptr<char[]> input;
+  ZSTD_inBuffer in;
+
+  // Decompressed bytes in [next_unread_byte, next_unread_byte + avail_out)
+  // have not been returned to the caller yet.
+  std::unique_ptr<char[]> output;
+  char* next_unread_byte = nullptr;
+  size_t avail_out = 0;
+
+  // Whether the last call to ZSTD_decompressStream filled `output` in the
+  // middle of a frame, in which case zstd may hold more output without needing
+  // more input.
+  bool output_full = false;
+
+  // Whether the decoder stopped in the middle of a frame.
+  bool in_frame = false;
+};
+
+ZstdInputStream::ZstdInputStream(InputStreamInterface* input_stream,
+                                 size_t input_buffer_bytes,
+                                 size_t output_buffer_bytes,
+                                 const ZstdCompressionOptions& zstd_options,
+                                 bool owns_input_stream)
+    : owns_input_stream_(owns_input_stream),
+      input_stream_(input_stream),
+      input_buffer_capacity_(input_buffer_bytes),
+      output_buffer_capacity_(output_buffer_bytes),
+      zstd_stream_def_(
+          new ZstdStreamDef(input_buffer_bytes, output_buffer_bytes)) {
+  ZSTD_DCtx* dctx = ZSTD_createDCtx();
+  zstd_stream_def_->dctx = dctx;
+  if (dctx == nullptr) {
+    init_status_ = errors::ResourceExhausted("ZSTD_createDCtx failed");
+    return;
+  }
+  if (!zstd_options.dictionary.empty()) {
+    size_t ret = ZSTD_DCtx_loadDictionary(dctx, zstd_options.dictionary.data(),
+                                          zstd_options.dictionary.size());
+    if (ZSTD_isError(ret)) {
+      init_status_ = errors::InvalidArgument(
+          "Failed to load zstd dictionary: ", ZSTD_getErrorName(ret));
+    }
+  }
+}
+
+ZstdInputStream::ZstdInputStream(InputStreamInterface* input_stream,
+                                 size_t input_buffer_bytes,
+                                 size_t output_buffer_bytes,
+                                 const ZstdCompressionOptions& zstd_options)
+    : ZstdInputStream(input_stream, input_buffer_bytes, output_buffer_bytes,
+                      zstd_options, false) {}
+
+ZstdInputStream::~ZstdInputStream() {
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+Status ZstdInputStream::Reset() {
+  TF_RETURN_IF_ERROR(init_status_);
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+  // Resetting the session keeps the dictionary loaded.
+  ZSTD_DCtx_reset(zstd_stream_def_->dctx, ZSTD_reset_session_only);
+  zstd_stream_def_->in.size = 0;
+  zstd_stream_def_->in.pos = 0;
+  zstd_stream_def_->avail_out = 0;
+  zstd_stream_def_->output_full = false;
+  zstd_stream_def_->in_frame = false;
+  bytes_read_ = 0;
+  return Status::OK();
+}
+
+Status ZstdInputStream::ReadFromStream() {
+  tstring data;
+  Status s = input_stream_->ReadNBytes(input_buffer_capacity_, &data);
+  // A short read at the end of the file still yields usable data.
+  if (errors::IsOutOfRange(s) && !data.empty()) {
+    s = Status::OK();
+  }
+  TF_RETURN_IF_ERROR(s);
+  memcpy(zstd_stream_def_->input.get(), data.data(), data.size());
+  zstd_stream_def_->in.size = data.size();
+  zstd_stream_def_->in.pos = 0;
+  return Status::OK();
+}
+
+Status ZstdInputStream::Decompress() {
+  ZstdStreamDef* def = zstd_stream_def_.get();
+  DCHECK_EQ(def->avail_out, 0);
+  // ZSTD_decompressStream may consume a frame header without producing any
+  // output, so keep feeding it until something comes out.
+  while (def->avail_out == 0) {
+    if (def->in.pos == def->in.size && !def->output_full) {
+      Status s = ReadFromStream();
+      if (errors::IsOutOfRange(s) && def->in_frame) {
+        return errors::DataLoss("Truncated zstd stream after ", bytes_read_,
+                                " decompressed bytes");
+      }
+      TF_RETURN_IF_ERROR(s);
+    }
+    ZSTD_outBuffer out = {def->output.get(), output_buffer_capacity_, 0};
+    size_t ret = ZSTD_decompressStream(def->dctx, &out, &def->in);
+    if (ZSTD_isError(ret)) {
+      return errors::DataLoss("zstd decompression failed: ",
+                              ZSTD_getErrorName(ret));
+    }
+    def->in_frame = ret != 0;
+    def->output_full = def->in_frame && out.pos == out.size;
+    def->next_unread_byte = def->output.get();
+    def->avail_out = out.pos;
+  }
+  return Status::OK();
+}
+
+size_t ZstdInputStream::ReadBytesFromCache(size_t bytes_to_read,
+                                           tstring* result) {
+  ZstdStreamDef* def = zstd_stream_def_.get();
+  size_t can_read_bytes = std::min(bytes_to_read, def->avail_out);
+  if (can_read_bytes > 0) {
+    result->append(def->next_unread_byte, can_read_bytes);
+    def->next_unread_byte += can_read_bytes;
+    def->avail_out -= can_read_bytes;
+    bytes_read_ += can_read_bytes;
+  }
+  return can_read_bytes;
+}
+
+Status ZstdInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  TF_RETURN_IF_ERROR(init_status_);
+  result->clear();
+  bytes_to_read -= ReadBytesFromCache(bytes_to_read, result);
+  while (bytes_to_read > 0) {
+    TF_RETURN_IF_ERROR(Decompress());
+    bytes_to_read -= ReadBytesFromCache(bytes_to_read, result);
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ZstdInputStream::ReadNBytes(int64 bytes_to_read, absl::Cord* result) {
+  tstring buf;
+  TF_RETURN_IF_ERROR(ReadNBytes(bytes_to_read, &buf));
+  result->Clear();
+  result->Append(buf.data());
+  return Status::OK();
+}
+#endif
+
+int64 ZstdInputStream::Tell() const { return bytes_read_; }
+
+}  // namespace io
+}  // namespace tensorflow
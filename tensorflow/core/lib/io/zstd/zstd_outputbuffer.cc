@@ -0,0 +1,174 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/zstd/zstd_outputbuffer.h"
+
+#include <string.h>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "zstd.h"
+
+namespace tensorflow {
+namespace io {
+
+ZstdOutputBuffer::ZstdOutputBuffer(WritableFile* file,
+                                   size_t input_buffer_bytes,
+                                   size_t output_buffer_bytes,
+                                   const ZstdCompressionOptions& zstd_options)
+    : file_(file),
+      input_buffer_capacity_(input_buffer_bytes),
+      output_buffer_capacity_(output_buffer_bytes),
+      zstd_options_(zstd_options),
+      input_buffer_(new char[input_buffer_bytes]),
+      output_buffer_(new char[output_buffer_bytes]) {}
+
+ZstdOutputBuffer::~ZstdOutputBuffer() {
+  if (cctx_ != nullptr) {
+    LOG(WARNING) << "ZstdOutputBuffer::Close() not called. Possible data loss";
+    ZSTD_freeCCtx(cctx_);
+  }
+}
+
+Status ZstdOutputBuffer::Init() {
+  if (output_buffer_capacity_ == 0) {
+    return errors::InvalidArgument(
+        "output_buffer_bytes should be greater than 0");
+  }
+  cctx_ = ZSTD_createCCtx();
+  if (cctx_ == nullptr) {
+    return errors::ResourceExhausted("ZSTD_createCCtx failed");
+  }
+  size_t ret = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel,
+                                      zstd_options_.compression_level);
+  if (!ZSTD_isError(ret) && zstd_options_.num_workers > 0) {
+    // Fails if libzstd was built without ZSTD_MULTITHREAD.
+    ret = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_nbWorkers,
+                                 zstd_options_.num_workers);
+  }
+  if (!ZSTD_isError(ret) && !zstd_options_.dictionary.empty()) {
+    ret = ZSTD_CCtx_loadDictionary(cctx_, zstd_options_.dictionary.data(),
+                                   zstd_options_.dictionary.size());
+  }
+  if (ZSTD_isError(ret)) {
+    ZSTD_freeCCtx(cctx_);
+    cctx_ = nullptr;
+    return errors::InvalidArgument("Invalid zstd compression options: ",
+                                   ZSTD_getErrorName(ret));
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::CheckNotClosed() const {
+  if (cctx_ == nullptr) {
+    return errors::FailedPrecondition(
+        "ZstdOutputBuffer not initialized or already closed");
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::FlushOutputBufferToFile() {
+  if (output_size_ > 0) {
+    TF_RETURN_IF_ERROR(
+        file_->Append(StringPiece(output_buffer_.get(), output_size_)));
+    output_size_ = 0;
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::Compress(StringPiece data, int end_op) {
+  const auto directive = static_cast<ZSTD_EndDirective>(end_op);
+  ZSTD_inBuffer in = {data.data(), data.size(), 0};
+  while (true) {
+    ZSTD_outBuffer out = {output_buffer_.get(), output_buffer_capacity_,
+                          output_size_};
+    size_t remaining = ZSTD_compressStream2(cctx_, &out, &in, directive);
+    if (ZSTD_isError(remaining)) {
+      return errors::DataLoss("zstd compression failed: ",
+                              ZSTD_getErrorName(remaining));
+    }
+    output_size_ = out.pos;
+    if (output_size_ == output_buffer_capacity_) {
+      TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+    }
+    const bool done = directive == ZSTD_e_continue ? in.pos == in.size
+                                                   : remaining == 0;
+    if (done) return Status::OK();
+  }
+}
+
+Status ZstdOutputBuffer::CompressBuffered(int end_op) {
+  TF_RETURN_IF_ERROR(
+      Compress(StringPiece(input_buffer_.get(), input_size_), end_op));
+  input_size_ = 0;
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::Append(StringPiece data) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  if (data.size() <= input_buffer_capacity_ - input_size_) {
+    memcpy(input_buffer_.get() + input_size_, data.data(), data.size());
+    input_size_ += data.size();
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(CompressBuffered(ZSTD_e_continue));
+  if (data.size() <= input_buffer_capacity_) {
+    memcpy(input_buffer_.get(), data.data(), data.size());
+    input_size_ = data.size();
+    return Status::OK();
+  }
+  // Large writes skip the input buffer.
+  return Compress(data, ZSTD_e_continue);
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ZstdOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status ZstdOutputBuffer::Flush() {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  TF_RETURN_IF_ERROR(CompressBuffered(ZSTD_e_flush));
+  TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+  return file_->Flush();
+}
+
+Status ZstdOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ZstdOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status ZstdOutputBuffer::Close() {
+  if (cctx_ != nullptr) {
+    TF_RETURN_IF_ERROR(CompressBuffered(ZSTD_e_end));
+    TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
+    ZSTD_freeCCtx(cctx_);
+    cctx_ = nullptr;
+  }
+  return Status::OK();
+}
+
+Status ZstdOutputBuffer::Tell(int64* position) { return file_->Tell(position); }
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,119 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/zstd/zstd_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+// Forward declare the compression context, zstd.h is only included in the
+// .cc file.
+struct ZSTD_CCtx_s;
+
+namespace tensorflow {
+namespace io {
+
+// Compresses output with zstd (https://facebook.github.io/zstd/) and writes it
+// to a file. The output can be read with ZstdInputStream.
+//
+// A given instance of a ZstdOutputBuffer is NOT safe for concurrent use
+// by multiple threads.
+class ZstdOutputBuffer : public WritableFile {
+ public:
+  // Creates a ZstdOutputBuffer for `file` with two buffers that cache the
+  // 1. input data to be compressed
+  // 2. the compressed output
+  // with sizes `input_buffer_bytes` and `output_buffer_bytes` respectively.
+  // Does not take ownership of `file`.
+  ZstdOutputBuffer(WritableFile* file, size_t input_buffer_bytes,
+                   size_t output_buffer_bytes,
+                   const ZstdCompressionOptions& zstd_options);
+
+  ~ZstdOutputBuffer() override;
+
+  // Creates the compression context. This call is required before any other
+  // operation on the buffer.
+  Status Init();
+
+  // Adds `data` to the compression pipeline. Small writes are cached and
+  // compressed in bulk once the input buffer is full.
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Compresses any cached input and writes all output to file. The data
+  // written so far can be decompressed without waiting for `Close()`.
+  Status Flush() override;
+
+  // Compresses any cached input, ends the zstd frame and writes all output to
+  // file. This must be called before the destructor to avoid any data loss.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or `Sync()`
+  // will fail.
+  Status Close() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Compresses any cached input, writes all output to file and syncs it.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  Status Tell(int64* position) override;
+
+ private:
+  // Feeds `data` to zstd with the given ZSTD_EndDirective, writing the output
+  // buffer to file whenever it fills up. Returns once all of `data` has been
+  // consumed and, unless `end_op` is ZSTD_e_continue, zstd has no more output
+  // pending.
+  Status Compress(StringPiece data, int end_op);
+
+  // Compresses the contents of the input buffer with `end_op`.
+  Status CompressBuffered(int end_op);
+
+  // Appends the contents of the output buffer to `file_`.
+  Status FlushOutputBufferToFile();
+
+  Status CheckNotClosed() const;
+
+  WritableFile* file_;  // Not owned
+  const size_t input_buffer_capacity_;
+  const size_t output_buffer_capacity_;
+  const ZstdCompressionOptions zstd_options_;
+
+  std::unique_ptr<char[]> input_buffer_;
+  size_t input_size_ = 0;
+  std::unique_ptr<char[]> output_buffer_;
+  size_t output_size_ = 0;
+
+  ZSTD_CCtx_s* cctx_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ZstdOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
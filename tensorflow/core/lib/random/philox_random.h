@@ -112,6 +112,12 @@ class PhiloxRandom {
   // that are used in the diffusion process.
   using Key = Array<uint32, 2>;
 
+  // We use the same constants as recommended by the original paper.
+  static constexpr uint32 kPhiloxW32A = 0x9E3779B9;
+  static constexpr uint32 kPhiloxW32B = 0xBB67AE85;
+  static constexpr uint32 kPhiloxM4x32A = 0xD2511F53;
+  static constexpr uint32 kPhiloxM4x32B = 0xCD9E8D57;
+
   PHILOX_DEVICE_INLINE
   PhiloxRandom() {}
 
@@ -191,12 +197,6 @@ class PhiloxRandom {
   }
 
  private:
-  // We use the same constants as recommended by the original paper.
-  static constexpr uint32 kPhiloxW32A = 0x9E3779B9;
-  static constexpr uint32 kPhiloxW32B = 0xBB67AE85;
-  static constexpr uint32 kPhiloxM4x32A = 0xD2511F53;
-  static constexpr uint32 kPhiloxM4x32B = 0xCD9E8D57;
-
   // Helper function to skip the next sample of 128-bits in the current stream.
   PHILOX_DEVICE_INLINE void SkipOne() {
     if (++counter_[0] == 0) {
@@ -179,6 +179,12 @@ class UniformDistribution<Generator, int32> {
   UniformDistribution(int32 lo, int32 hi)
       : lo_(lo), range_(static_cast<uint32>(hi) - static_cast<uint32>(lo)) {}
 
+  // Same distribution, drawing from another generator type.
+  template <class OtherGenerator>
+  explicit UniformDistribution(
+      const UniformDistribution<OtherGenerator, int32>& other)
+      : lo_(other.lo_), range_(other.range_) {}
+
   PHILOX_DEVICE_INLINE
   ResultType operator()(Generator* gen) {
     typename Generator::ResultType sample = (*gen)();
@@ -195,6 +201,9 @@ class UniformDistribution<Generator, int32> {
   // lo < 0 < hi, but always fits in unsigned.
   int32 lo_;
   uint32 range_;
+
+  template <class, typename>
+  friend class UniformDistribution;
 };
 
 template <class Generator>
@@ -214,6 +223,12 @@ class UniformDistribution<Generator, int64> {
   UniformDistribution(int64 lo, int64 hi)
       : lo_(lo), range_(static_cast<uint64>(hi) - static_cast<uint64>(lo)) {}
 
+  // Same distribution, drawing from another generator type.
+  template <class OtherGenerator>
+  explicit UniformDistribution(
+      const UniformDistribution<OtherGenerator, int64>& other)
+      : lo_(other.lo_), range_(other.range_) {}
+
   PHILOX_DEVICE_INLINE
   ResultType operator()(Generator* gen) {
     typename Generator::ResultType sample = (*gen)();
@@ -231,6 +246,9 @@ class UniformDistribution<Generator, int64> {
   // lo < 0 < hi, but always fits in unsigned.
   int64 lo_;
   uint64 range_;
+
+  template <class, typename>
+  friend class UniformDistribution;
 };
 
 // Similar to `UniformDistribution`, except that instead of generating numbers
@@ -106,7 +106,7 @@ void NcclCommunicator::Enqueue(std::shared_ptr<CollectiveContext> col_ctx,
   NcclManager::Context context(
       nccl_collective_key, num_local_devices, num_global_devices,
       col_params->group.runtime_details.communicator_key,
-      col_params->source_rank);
+      col_params->source_rank, col_params->group.group_key);
   VLOG(1) << "NcclCommunicator::Enqueue type " << col_params->instance.type
           << " num_tasks " << col_params->group.num_tasks << " current task "
           << col_params->group.task_names[col_params->default_rank]
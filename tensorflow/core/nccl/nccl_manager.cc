@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/annotated_traceme.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #if GOOGLE_CUDA
 #include "tensorflow/stream_executor/cuda/cuda_activation.h"
 #elif TENSORFLOW_USE_ROCM
@@ -111,12 +112,18 @@ struct NcclManager::CommunicatorMember {
 struct NcclManager::Communicator {
  public:
   explicit Communicator(std::vector<CommunicatorMember> members,
-                        const string& key)
-      : num_devices(members.size()), members(std::move(members)), key(key) {}
+                        const string& key, int stream_slot)
+      : num_devices(members.size()),
+        members(std::move(members)),
+        key(key),
+        stream_slot(stream_slot) {}
 
   const int num_devices;
   std::vector<CommunicatorMember> members;
   const string key;
+  // Slot of the communication streams of `members`, see
+  // NcclManager::StreamSlot.
+  const int stream_slot;
 };
 
 namespace {
@@ -163,7 +170,8 @@ struct NcclManager::Collective : public core::RefCounted {
   Collective(const string& collective_key_in, DataType data_type_in,
              CollectiveType type_in, ncclRedOp_t reduction_op_in,
              int num_local_devices_in, int num_global_devices_in,
-             const string& communicator_key_in)
+             const string& communicator_key_in, int group_key_in,
+             int stream_slot_in)
       : collective_key(collective_key_in),
         data_type(data_type_in),
         type(type_in),
@@ -171,7 +179,9 @@ struct NcclManager::Collective : public core::RefCounted {
         num_local_devices(num_local_devices_in),
         num_global_devices(num_global_devices_in),
         single_node(num_local_devices_in == num_global_devices_in),
-        communicator_key(communicator_key_in) {
+        communicator_key(communicator_key_in),
+        group_key(group_key_in),
+        stream_slot(stream_slot_in) {
     participants.reserve(num_local_devices_in);
 #if TENSORFLOW_USE_ROCM
     // On ROCm platform, this allows caller to either use the singleton instance
@@ -193,6 +203,8 @@ struct NcclManager::Collective : public core::RefCounted {
   const int num_global_devices;    // devices across all nodes
   const bool single_node;          // true if all devices are at one node
   const string communicator_key;
+  const int group_key;
+  const int stream_slot;  // communication streams to launch on
 
   Communicator* communicator = nullptr;
 
@@ -229,6 +241,19 @@ NcclManager::NcclManager() {
   VLOG(2) << "New NcclManager " << this;
 #if TENSORFLOW_USE_ROCM
   ++instance_count;
+#else
+  int64 num_streams_per_device;
+  Status s = ReadInt64FromEnvVar("TF_NCCL_NUM_STREAMS_PER_DEVICE",
+                                 /*default_val=*/1, &num_streams_per_device);
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    num_streams_per_device = 1;
+  } else if (num_streams_per_device < 1) {
+    LOG(ERROR) << "Ignoring TF_NCCL_NUM_STREAMS_PER_DEVICE="
+               << num_streams_per_device << ", which should be >= 1.";
+    num_streams_per_device = 1;
+  }
+  num_streams_per_device_ = num_streams_per_device;
 #endif
 }
 NcclManager::~NcclManager() {
@@ -301,6 +326,10 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     // Since it's expected that a small number of distinct communicators will
     // be needed, communicators_ is not garbage collected currently.
     //
+    // Collectives of groups assigned different stream slots use different
+    // communicators for the same devices, as NCCL requires the operations on
+    // one communicator to be issued in order on a single stream.
+    //
     // Launching of kernels must be serialized so that, given collectives A and
     // B, and an order of them (e.g., A before B), then for each comm_stream
     // involved, the kernel for A is launched before the kernel for B. This is
@@ -308,7 +337,8 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     // kernels to per-stream launch queues.  The launch queues are processed by
     // LoopKernelLaunches.
     for (auto& comm : communicators_) {
-      if (comm->num_devices == collective->num_global_devices) {
+      if (comm->num_devices == collective->num_global_devices &&
+          comm->stream_slot == collective->stream_slot) {
         int i;
         for (i = 0; i < collective->num_local_devices; ++i) {
           if (comm->members[i].nccl_stream->executor !=
@@ -355,7 +385,9 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
     auto* executor = collective->participants[i]->executor;
 
     // Find a communication stream to use for the device.
-    auto& streams = device_to_comm_streams_[executor];
+    auto& streams =
+        device_to_comm_streams_[std::make_pair(executor,
+                                               collective->stream_slot)];
     NcclStream* nccl_stream = nullptr;
     for (const auto& s : streams) {
       if (used_streams.insert(s).second) {
@@ -423,8 +455,9 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   for (int i = 0; i < collective->num_local_devices; ++i) {
     members[i].nccl_comm = nccl_comms[i];
   }
-  communicators_.emplace_back(
-      new Communicator(std::move(members), collective->communicator_key));
+  communicators_.emplace_back(new Communicator(std::move(members),
+                                              collective->communicator_key,
+                                              collective->stream_slot));
   *communicator = communicators_.back().get();
   return Status::OK();
 }
@@ -508,7 +541,8 @@ void NcclManager::AddParticipant(std::unique_ptr<Participant> participant,
         collective = new Collective(
             context.collective_key, data_type, collective_type, reduction_op,
             context.num_local_devices, context.num_global_devices,
-            context.communicator_key);
+            context.communicator_key, context.group_key,
+            StreamSlot(context.group_key));
         collectives_.emplace(context.collective_key, collective);
       } else {
         collective = collective_it->second;
@@ -570,6 +604,13 @@ void NcclManager::AddParticipant(std::unique_ptr<Participant> participant,
             " already has root_rank ", collective->root_rank,
             " but new participant has root_rank ", context.source_rank);
       }
+      if (collective->status.ok() &&
+          collective->group_key != context.group_key) {
+        collective->status = errors::Internal(
+            "Collective ", collective->collective_key,
+            " previously initialized with group_key ", collective->group_key,
+            " but now got group_key ", context.group_key);
+      }
       if (collective->status.ok() &&
           !kValidDataTypes.Contains(collective->data_type)) {
         collective->status = errors::Internal(
@@ -610,6 +651,11 @@ bool NcclManager::CheckReady(const string& collective_key,
   return false;
 }
 
+int NcclManager::StreamSlot(int group_key) const {
+  if (group_key < 0) return 0;
+  return group_key % num_streams_per_device_;
+}
+
 void NcclManager::RunCollective(Collective* collective) {
   // For TraceMeConsumer in Connection::RPCDone().
   tensorflow::profiler::TraceMeProducer traceme("Schedule Collective");
@@ -666,6 +712,10 @@ void NcclManager::RunCollective(Collective* collective) {
     // is to prevent collectives from deadlocking each other.
     // Note that it would be possible to run multiple collectives at once, if
     // they have non-intersecting sets of devices.
+    //
+    // Collectives of different stream slots are queued in this same order,
+    // which follows the dependencies CollectiveExecutor derives from instance
+    // keys, but their kernels run concurrently once launched.
     mutex_lock l(collective_mu);
     for (int i = 0; i < collective->num_local_devices; ++i) {
       NcclStream* nccl_stream =
@@ -133,12 +133,13 @@ class NcclManager {
   struct Context {
     Context(const string& collective_key, int num_local_devices,
             int num_global_devices, const string& communicator_key,
-            int source_rank)
+            int source_rank, int group_key = -1)
         : collective_key(collective_key),
           num_local_devices(num_local_devices),
           num_global_devices(num_global_devices),
           communicator_key(communicator_key),
-          source_rank(source_rank) {}
+          source_rank(source_rank),
+          group_key(group_key) {}
 
     // Unique key for this collective instance
     const string& collective_key;
@@ -159,6 +160,14 @@ class NcclManager {
 
     // Rank of broadcast source.
     int source_rank;
+
+    // Key of the collective group the instance belongs to, or -1 if unknown.
+    // When several communication streams per device are enabled, collectives
+    // of different groups may be assigned different streams and communicators
+    // and run concurrently; collectives of one group always share a stream and
+    // run in launch order. All participants of a collective must pass the
+    // same `group_key`.
+    int group_key;
   };
 
   // Adds one participant to an all-reduce.
@@ -237,6 +246,10 @@ class NcclManager {
   bool CheckReady(const string& collective_key, Collective* collective)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns the communication stream slot used by collectives of
+  // `group_key`, in [0, num_streams_per_device_).
+  int StreamSlot(int group_key) const;
+
   // Run <collective>.  This calls takes ownership of <collective>.
   void RunCollective(Collective* collective);
   void LoopKernelLaunches(NcclStream* stream);
@@ -246,12 +259,18 @@ class NcclManager {
   // Maps key to collectives currently being assembled or run.
   absl::flat_hash_map<string, Collective*> collectives_ TF_GUARDED_BY(mu_);
 
-  // Maps a device to the communication streams that make up its collective.
-  // This is used to share the stream across different communicators that
-  // include the same device.
-  absl::flat_hash_map<se::StreamExecutor*, std::vector<NcclStream*>>
+  // Maps a device and stream slot to the communication streams that make up
+  // its collective. This is used to share the stream across different
+  // communicators that include the same device and use the same slot.
+  absl::flat_hash_map<std::pair<se::StreamExecutor*, int>,
+                      std::vector<NcclStream*>>
       device_to_comm_streams_ TF_GUARDED_BY(mu_);
 
+  // Number of communication streams per device, from the
+  // TF_NCCL_NUM_STREAMS_PER_DEVICE environment variable. Defaults to 1, which
+  // serializes all collectives of a device.
+  int num_streams_per_device_ = 1;
+
   std::vector<std::unique_ptr<Communicator>> communicators_ TF_GUARDED_BY(mu_);
 
   Status status_ TF_GUARDED_BY(mu_);
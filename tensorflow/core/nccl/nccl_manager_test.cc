@@ -573,6 +573,49 @@ TYPED_TEST(NcclManagerTest, MultipleCallers) {
   }
 }
 
+// Runs all-reduces of two collective groups on separate communication streams,
+// with the participants of both added in an interleaved order.
+TYPED_TEST(NcclManagerTest, MultipleStreamsPerDevice) {
+  const int num_ranks = this->NumGPUs();
+  const int num_groups = 2;
+  setenv("TF_NCCL_NUM_STREAMS_PER_DEVICE", "2", /*overwrite=*/1);
+  NcclManager nccl_manager;
+  unsetenv("TF_NCCL_NUM_STREAMS_PER_DEVICE");
+
+  for (int iteration = 0; iteration < 3; ++iteration) {
+    std::vector<std::unique_ptr<typename TestFixture::TestCase>> test_cases;
+    for (int group = 0; group < num_groups; ++group) {
+      test_cases.emplace_back(this->MakeReductionTestCase(
+          /*num_nodes=*/1, num_ranks, ncclSum, TensorShape({128, group + 1}),
+          1.5f * group));
+    }
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      for (int group = 0; group < num_groups; ++group) {
+        // Odd ranks add the second group first.
+        const int g = rank % 2 == 0 ? group : num_groups - 1 - group;
+        auto* test_case = test_cases[g].get();
+        auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+        auto* info = device->tensorflow_gpu_device_info();
+        auto* stream = device->tensorflow_gpu_device_info()->stream;
+        auto participant = absl::make_unique<NcclManager::Participant>(
+            device->executor(), stream, info, &test_case->ins[rank],
+            &test_case->outs[rank], /*global_rank=*/-1,
+            this->CreateDoneCallback(test_case));
+        nccl_manager.AddToAllReduce(
+            std::move(participant),
+            {strings::StrCat("allreduce", g), /*num_local_devices=*/num_ranks,
+             /*num_global_devices=*/num_ranks, /*communicator_key=*/"",
+             /*source_rank=*/-1, /*group_key=*/g},
+            ncclSum);
+      }
+    }
+
+    for (int group = 0; group < num_groups; ++group) {
+      this->VerifyResults(test_cases[group].get());
+    }
+  }
+}
+
 // Test basic all-gather.
 TYPED_TEST(NcclManagerTest, BasicAllGather) {
   const int num_ranks = this->NumGPUs();
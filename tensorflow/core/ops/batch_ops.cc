@@ -54,6 +54,11 @@ REGISTER_OP("BatchFunction")
     // NOTE: Support for `enable_large_batch_splitting == true` is still
     // developed in progress.
     .Attr("enable_large_batch_splitting: bool = false")
+    // If 'length_bucket_boundaries' is non-empty, inputs are batched
+    // separately per length bucket along 'length_bucket_dimension', and padded
+    // only up to their bucket's boundary along that dimension.
+    .Attr("length_bucket_boundaries: list(int) = []")
+    .Attr("length_bucket_dimension: int = 1")
     // TODO(apassos): Fix this shape inference function. It requires shape
     // inference of function calls.
     .SetShapeFn(shape_inference::UnknownShape);
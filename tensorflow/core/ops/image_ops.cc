@@ -305,6 +305,30 @@ REGISTER_OP("ResizeBilinear")
     .Attr("half_pixel_centers: bool = false")
     .SetShapeFn(ResizeShapeFn);
 
+// --------------------------------------------------------------------------
+REGISTER_OP("_FusedResizeBilinearNormalize")
+    .Input("images: T")
+    .Input("size: int32")
+    .Input("offset: float")
+    .Input("scale: float")
+    .Output("resized_images: out_type")
+    .Attr(
+        "T: {int8, uint8, int16, uint16, int32, int64, bfloat16, half, "
+        "float, double}")
+    .Attr("out_type: {float, bfloat16} = DT_FLOAT")
+    .Attr("align_corners: bool = false")
+    .Attr("half_pixel_centers: bool = false")
+    .SetShapeFn(ResizeShapeFn)
+    .Doc(R"doc(
+Computes `(ResizeBilinear(images, size) - offset) * scale` in a single pass
+and casts the result to `out_type`.
+
+`offset` and `scale` are scalars or vectors with one value per channel.
+
+NOTE: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("ScaleAndTranslate")
     .Input("images: T")
@@ -466,6 +490,8 @@ REGISTER_OP("DecodeJpeg")
     .Attr("try_recover_truncated: bool = false")
     .Attr("acceptable_fraction: float = 1.0")
     .Attr("dct_method: string = ''")
+    .Attr("target_height: int = 0")
+    .Attr("target_width: int = 0")
     .Output("image: uint8")
     .SetShapeFn(DecodeImageShapeFn);
 
@@ -479,6 +505,8 @@ REGISTER_OP("DecodeAndCropJpeg")
     .Attr("try_recover_truncated: bool = false")
     .Attr("acceptable_fraction: float = 1.0")
     .Attr("dct_method: string = ''")
+    .Attr("target_height: int = 0")
+    .Attr("target_width: int = 0")
     .Output("image: uint8")
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle unused;
@@ -417,4 +417,116 @@ REGISTER_OP("ConsumeMutexLock")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) { return Status::OK(); });
 
+REGISTER_RESOURCE_HANDLE_OP(EmbeddingVariable);
+
+REGISTER_OP("EmbeddingVariableCreate")
+    .Input("resource: resource")
+    .Attr("dim: int >= 1")
+    .Attr("num_shards: int >= 1 = 16")
+    .Attr("num_slots: int >= 0 = 0")
+    .Attr("initializer_stddev: float = 0")
+    .Attr("slot_initial_value: float = 0")
+    .Attr("seed: int = 0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableGather")
+    .Input("resource: resource")
+    .Input("indices: int64")
+    .Input("step: int64")
+    .Output("output: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->input(1), c->Vector(InferenceContext::kUnknownDim), &out));
+      c->set_output(0, out);
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableSparseApplyAdagrad")
+    .Input("resource: resource")
+    .Input("lr: float")
+    .Input("grad: float")
+    .Input("indices: int64")
+    .Input("step: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableSparseApplyAdam")
+    .Input("resource: resource")
+    .Input("beta1_power: float")
+    .Input("beta2_power: float")
+    .Input("lr: float")
+    .Input("beta1: float")
+    .Input("beta2: float")
+    .Input("epsilon: float")
+    .Input("grad: float")
+    .Input("indices: int64")
+    .Input("step: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      for (int i = 1; i <= 6; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(7), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(8), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(9), 0, &unused));
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableEvict")
+    .Input("resource: resource")
+    .Input("step: int64")
+    .Input("ttl: int64")
+    .Output("num_evicted: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableExport")
+    .Input("resource: resource")
+    .Output("keys: int64")
+    .Output("values: float")
+    .Output("slots: float")
+    .Output("last_access_steps: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle keys = c->Vector(InferenceContext::kUnknownDim);
+      c->set_output(0, keys);
+      c->set_output(1, c->UnknownShapeOfRank(2));
+      c->set_output(2, c->UnknownShapeOfRank(3));
+      c->set_output(3, keys);
+      return Status::OK();
+    });
+
+REGISTER_OP("EmbeddingVariableImport")
+    .Input("resource: resource")
+    .Input("keys: int64")
+    .Input("values: float")
+    .Input("slots: float")
+    .Input("last_access_steps: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle keys;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &keys));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 3, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(keys, c->input(4), &unused));
+      return Status::OK();
+    });
+
 }  // namespace tensorflow
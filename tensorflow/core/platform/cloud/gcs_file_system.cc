@@ -23,6 +23,7 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/platform/file_statistics.h"
@@ -48,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 #ifdef _WIN32
@@ -144,6 +146,18 @@ constexpr char kAppendMode[] = "GCS_APPEND_MODE";
 // default as the multiple API calls required add a risk of stranding temporary
 // objects.
 constexpr char kComposeAppend[] = "compose";
+// The environment variable that enables parallel composite uploads of files
+// opened with NewWritableFile, in chunks of this many MB (format: <int64>).
+// Disabled by default for the same reason as GCS_APPEND_MODE=compose.
+constexpr char kParallelCompositeUploadChunkSize[] =
+    "GCS_PARALLEL_COMPOSITE_UPLOAD_CHUNK_SIZE_MB";
+// The environment variable that overrides the number of threads uploading
+// chunks in parallel composite uploads (format: <int64>).
+constexpr char kParallelCompositeUploadThreads[] =
+    "GCS_PARALLEL_COMPOSITE_UPLOAD_THREADS";
+constexpr int64 kDefaultParallelCompositeUploadThreads = 8;
+// The maximum number of source objects of a GCS compose request.
+constexpr size_t kMaxComposeSources = 32;
 
 Status GetTmpFilename(string* filename) {
   *filename = io::GetTempFilename("");
@@ -424,7 +438,10 @@ class GcsWritableFile : public WritableFile {
                   RetryConfig retry_config, bool compose_append,
                   SessionCreator session_creator,
                   ObjectUploader object_uploader, StatusPoller status_poller,
-                  GenerationGetter generation_getter)
+                  GenerationGetter generation_getter,
+                  uint64 composite_chunk_size = 0,
+                  std::shared_ptr<thread::ThreadPool> composite_upload_pool =
+                      nullptr)
       : bucket_(bucket),
         object_(object),
         filesystem_(filesystem),
@@ -437,7 +454,10 @@ class GcsWritableFile : public WritableFile {
         session_creator_(std::move(session_creator)),
         object_uploader_(std::move(object_uploader)),
         status_poller_(std::move(status_poller)),
-        generation_getter_(std::move(generation_getter)) {
+        generation_getter_(std::move(generation_getter)),
+        composite_chunk_size_(composite_upload_pool ? composite_chunk_size
+                                                    : 0),
+        composite_upload_pool_(std::move(composite_upload_pool)) {
     // TODO: to make it safer, outfile_ should be constructed from an FD
     VLOG(3) << "GcsWritableFile: " << GetGcsPath();
     if (GetTmpFilename(&tmp_content_filename_).ok()) {
@@ -471,7 +491,8 @@ class GcsWritableFile : public WritableFile {
         session_creator_(std::move(session_creator)),
         object_uploader_(std::move(object_uploader)),
         status_poller_(std::move(status_poller)),
-        generation_getter_(std::move(generation_getter)) {
+        generation_getter_(std::move(generation_getter)),
+        composite_chunk_size_(0) {
     VLOG(3) << "GcsWritableFile: " << GetGcsPath() << "with existing file "
             << tmp_content_filename;
     tmp_content_filename_ = tmp_content_filename;
@@ -481,6 +502,12 @@ class GcsWritableFile : public WritableFile {
 
   ~GcsWritableFile() override {
     Close().IgnoreError();
+    // Part uploads reference this file, so wait for them even if Close()
+    // failed.
+    for (const auto& part : composite_parts_) {
+      part->uploaded.WaitForNotification();
+      std::remove(part->tmp_content_filename.c_str());
+    }
     std::remove(tmp_content_filename_.c_str());
   }
 
@@ -488,6 +515,9 @@ class GcsWritableFile : public WritableFile {
     TF_RETURN_IF_ERROR(CheckWritable());
     VLOG(3) << "Append: " << GetGcsPath() << " size " << data.length();
     sync_needed_ = true;
+    if (composite_chunk_size_ > 0) {
+      return AppendToCompositeChunks(data);
+    }
     outfile_ << data;
     if (!outfile_.good()) {
       return errors::Internal(
@@ -502,6 +532,7 @@ class GcsWritableFile : public WritableFile {
       Status sync_status = Sync();
       if (sync_status.ok()) {
         outfile_.close();
+        sync_status = DeleteCompositeParts();
       }
       return sync_status;
     }
@@ -536,6 +567,7 @@ class GcsWritableFile : public WritableFile {
     if (*position == -1) {
       return errors::Internal("tellp on the internal temporary file failed");
     }
+    *position += composite_parts_size_;
     return Status::OK();
   }
 
@@ -552,6 +584,9 @@ class GcsWritableFile : public WritableFile {
       return errors::Internal(
           "Could not write to the internal temporary file.");
     }
+    if (!composite_parts_.empty()) {
+      return CompositeSyncImpl();
+    }
     UploadSessionHandle session_handle;
     uint64 start_offset = 0;
     string object_to_upload = object_;
@@ -611,6 +646,218 @@ class GcsWritableFile : public WritableFile {
     return upload_status;
   }
 
+  /// Writes `data` to the temporary files of composite parts, and starts
+  /// uploading each part as soon as it is full.
+  Status AppendToCompositeChunks(StringPiece data) {
+    while (!data.empty()) {
+      uint64 chunk_size;
+      TF_RETURN_IF_ERROR(GetCurrentFileSize(&chunk_size));
+      const size_t n =
+          std::min<uint64>(data.size(), composite_chunk_size_ - chunk_size);
+      outfile_ << data.substr(0, n);
+      if (!outfile_.good()) {
+        return errors::Internal(
+            "Could not append to the internal temporary file.");
+      }
+      data.remove_prefix(n);
+      if (chunk_size + n == composite_chunk_size_) {
+        TF_RETURN_IF_ERROR(StartCompositePartUpload());
+      }
+    }
+    return Status::OK();
+  }
+
+  /// Starts uploading the full chunk in the current temporary file to a
+  /// temporary object, and continues writing to a new temporary file.
+  Status StartCompositePartUpload() {
+    outfile_.close();
+    if (outfile_.fail()) {
+      return errors::Internal(
+          "Could not write to the internal temporary file.");
+    }
+    auto part = std::make_shared<CompositePart>();
+    part->tmp_content_filename = tmp_content_filename_;
+    part->object = GetCompositePartObject(composite_parts_size_);
+    part->size = composite_chunk_size_;
+    composite_parts_.push_back(part);
+    composite_parts_size_ += composite_chunk_size_;
+    composite_upload_pool_->Schedule([this, part]() {
+      part->status = UploadCompositePart(part->tmp_content_filename,
+                                         part->size, part->object);
+      if (part->status.ok()) {
+        std::remove(part->tmp_content_filename.c_str());
+      }
+      part->uploaded.Notify();
+    });
+
+    TF_RETURN_IF_ERROR(GetTmpFilename(&tmp_content_filename_));
+    outfile_.open(tmp_content_filename_,
+                  std::ofstream::binary | std::ofstream::app);
+    return CheckWritable();
+  }
+
+  /// Uploads the whole content of `tmp_content_filename`, which is `size`
+  /// bytes, to `part_object`.
+  Status UploadCompositePart(const string& tmp_content_filename, uint64 size,
+                             const string& part_object) {
+    UploadSessionHandle session_handle;
+    TF_RETURN_IF_ERROR(session_creator_(0, part_object, bucket_, size,
+                                        GetGcsPathWithObject(part_object),
+                                        &session_handle));
+    uint64 already_uploaded = 0;
+    bool first_attempt = true;
+    const Status upload_status = RetryingUtils::CallWithRetries(
+        [&]() {
+          if (session_handle.resumable && !first_attempt) {
+            bool completed;
+            TF_RETURN_IF_ERROR(status_poller_(
+                session_handle.session_uri, size,
+                GetGcsPathWithObject(part_object), &completed,
+                &already_uploaded));
+            if (completed) {
+              return Status::OK();
+            }
+          }
+          first_attempt = false;
+          return object_uploader_(session_handle.session_uri, 0,
+                                  already_uploaded, tmp_content_filename, size,
+                                  GetGcsPathWithObject(part_object));
+        },
+        retry_config_);
+    if (upload_status.code() == errors::Code::NOT_FOUND) {
+      // As in SyncImpl(), rely on the RetryingFileSystem to retry the Sync()
+      // call, which uploads the part again.
+      return errors::Unavailable(strings::StrCat(
+          "Upload to gs://", bucket_, "/", part_object,
+          " failed, caused by: ", upload_status.ToString()));
+    }
+    return upload_status;
+  }
+
+  /// Makes the object the concatenation of the uploaded parts and of the
+  /// current, partial, chunk.
+  Status CompositeSyncImpl() {
+    std::vector<string> sources;
+    for (const auto& part : composite_parts_) {
+      part->uploaded.WaitForNotification();
+      if (!part->status.ok()) {
+        LOG(WARNING) << "Retrying the upload of " << part->object
+                     << " after: " << part->status;
+        part->status = UploadCompositePart(part->tmp_content_filename,
+                                           part->size, part->object);
+        TF_RETURN_IF_ERROR(part->status);
+        std::remove(part->tmp_content_filename.c_str());
+      }
+      sources.push_back(part->object);
+    }
+    uint64 tail_size;
+    TF_RETURN_IF_ERROR(GetCurrentFileSize(&tail_size));
+    if (tail_size > 0) {
+      // The tail is uploaded to the object of the part it will become once it
+      // is full, which then overwrites it.
+      composite_tail_object_ = GetCompositePartObject(composite_parts_size_);
+      TF_RETURN_IF_ERROR(UploadCompositePart(tmp_content_filename_, tail_size,
+                                             composite_tail_object_));
+      sources.push_back(composite_tail_object_);
+    }
+    TF_RETURN_IF_ERROR(ComposeObjects(sources));
+    // Erase the file from the file cache on every successful write.
+    file_cache_erase_();
+    return Status::OK();
+  }
+
+  /// Composes `sources` into the object. Since a compose request takes at
+  /// most kMaxComposeSources sources, more sources are first composed in
+  /// groups into intermediate temporary objects.
+  Status ComposeObjects(std::vector<string> sources) {
+    std::vector<string> intermediate_objects;
+    for (int round = 0; sources.size() > kMaxComposeSources; ++round) {
+      std::vector<string> composed_objects;
+      for (size_t begin = 0; begin < sources.size();
+           begin += kMaxComposeSources) {
+        const size_t end = std::min(begin + kMaxComposeSources, sources.size());
+        composed_objects.push_back(strings::StrCat(
+            io::Dirname(object_), "/.tmpcompose/", io::Basename(object_),
+            ".compose", round, ".", begin / kMaxComposeSources));
+        TF_RETURN_IF_ERROR(ComposeObject(
+            std::vector<string>(sources.begin() + begin, sources.begin() + end),
+            composed_objects.back()));
+      }
+      intermediate_objects.insert(intermediate_objects.end(),
+                                  composed_objects.begin(),
+                                  composed_objects.end());
+      sources = std::move(composed_objects);
+    }
+    TF_RETURN_IF_ERROR(ComposeObject(sources, object_));
+    for (const string& object : intermediate_objects) {
+      TF_RETURN_IF_ERROR(DeleteObject(object));
+    }
+    return Status::OK();
+  }
+
+  /// Makes `target` the concatenation of `sources`.
+  Status ComposeObject(const std::vector<string>& sources,
+                       const string& target) {
+    VLOG(3) << "ComposeObject: " << sources.size() << " objects to "
+            << GetGcsPathWithObject(target);
+    string source_objects;
+    for (const string& source : sources) {
+      strings::StrAppend(&source_objects, source_objects.empty() ? "" : ",",
+                         "{'name': '", source, "'}");
+    }
+    const string request_body =
+        strings::StrCat("{'sourceObjects': [", source_objects, "]}");
+    return RetryingUtils::CallWithRetries(
+        [&request_body, &target, this]() {
+          std::unique_ptr<HttpRequest> request;
+          TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+          request->SetUri(strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                          request->EscapeString(target),
+                                          "/compose"));
+          request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                               timeouts_->metadata);
+          request->AddHeader("content-type", "application/json");
+          request->SetPostFromBuffer(request_body.c_str(), request_body.size());
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(
+              request->Send(), " when composing to ",
+              GetGcsPathWithObject(target));
+          return Status::OK();
+        },
+        retry_config_);
+  }
+
+  /// Deletes the temporary objects of the composite parts.
+  Status DeleteCompositeParts() {
+    Status status;
+    for (const auto& part : composite_parts_) {
+      status.Update(DeleteObject(part->object));
+    }
+    // A tail that later became a full part was overwritten by that part.
+    if (!composite_tail_object_.empty() &&
+        std::none_of(composite_parts_.begin(), composite_parts_.end(),
+                     [this](const std::shared_ptr<CompositePart>& part) {
+                       return part->object == composite_tail_object_;
+                     })) {
+      status.Update(DeleteObject(composite_tail_object_));
+    }
+    composite_tail_object_.clear();
+    return status;
+  }
+
+  Status DeleteObject(const string& object) {
+    const string object_path = GetGcsPathWithObject(object);
+    return RetryingUtils::DeleteWithRetries(
+        [&object_path, this]() {
+          return filesystem_->DeleteFile(object_path, nullptr);
+        },
+        retry_config_);
+  }
+
+  string GetCompositePartObject(uint64 offset) const {
+    return strings::StrCat(io::Dirname(object_), "/.tmpcompose/",
+                           io::Basename(object_), ".part", offset);
+  }
+
   Status CheckWritable() const {
     if (!outfile_.is_open()) {
       return errors::FailedPrecondition(
@@ -731,6 +978,31 @@ class GcsWritableFile : public WritableFile {
   const ObjectUploader object_uploader_;
   const StatusPoller status_poller_;
   const GenerationGetter generation_getter_;
+
+  /// \brief A chunk of a parallel composite upload.
+  ///
+  /// In a parallel composite upload, every composite_chunk_size_ bytes are
+  /// written to their own temporary file, which is uploaded to a temporary
+  /// object on composite_upload_pool_ as soon as it is full. Sync() composes
+  /// these objects, and one with the remaining bytes, into the object.
+  struct CompositePart {
+    string tmp_content_filename;
+    string object;
+    uint64 size;
+    /// The result of the upload, set before `uploaded` is notified.
+    Status status;
+    Notification uploaded;
+  };
+  // The size of the chunks of parallel composite uploads, or 0 if they are
+  // disabled.
+  const uint64 composite_chunk_size_;
+  std::shared_ptr<thread::ThreadPool> composite_upload_pool_;
+  std::vector<std::shared_ptr<CompositePart>> composite_parts_;
+  // The number of bytes in composite_parts_.
+  uint64 composite_parts_size_ = 0;
+  // The object the partial last chunk was uploaded to by the latest Sync(),
+  // or empty.
+  string composite_tail_object_;
 };
 
 class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
@@ -799,12 +1071,23 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  readahead_blocks_ = kDefaultReadaheadBlocks;
+  if (GetEnvVar(kReadaheadBlocks, strings::safe_strtou64, &value)) {
+    readahead_blocks_ = value;
+  }
+  max_readahead_bytes_ = readahead_blocks_ * block_size_;
+  if (GetEnvVar(kMaxReadaheadSize, strings::safe_strtou64, &value)) {
+    max_readahead_bytes_ = value * 1024 * 1024;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "readahead blocks = " << readahead_blocks_ << " ; "
+          << "max readahead size = " << max_readahead_bytes_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -925,6 +1208,15 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   } else {
     compose_append_ = false;
   }
+
+  uint64 composite_chunk_size_mb = 0;
+  GetEnvVar(kParallelCompositeUploadChunkSize, strings::safe_strtou64,
+            &composite_chunk_size_mb);
+  int64 composite_upload_threads = kDefaultParallelCompositeUploadThreads;
+  GetEnvVar(kParallelCompositeUploadThreads, strings::safe_strto64,
+            &composite_upload_threads);
+  SetParallelCompositeUpload(composite_chunk_size_mb * 1024 * 1024,
+                             composite_upload_threads);
 }
 
 GcsFileSystem::GcsFileSystem(
@@ -1032,7 +1324,8 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      readahead_blocks_, max_readahead_bytes_));
 
   // Check if cache is enabled here to avoid unnecessary mutex contention.
   cache_enabled_ = file_block_cache->IsCacheEnabled();
@@ -1295,11 +1588,19 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
     return Status::OK();
   };
 
+  uint64 composite_chunk_size;
+  std::shared_ptr<thread::ThreadPool> composite_upload_pool;
+  {
+    mutex_lock l(mu_);
+    composite_chunk_size = parallel_composite_upload_chunk_size_;
+    composite_upload_pool = parallel_composite_upload_pool_;
+  }
   result->reset(new GcsWritableFile(
       bucket, object, this, &timeouts_,
       [this, fname]() { ClearFileCaches(fname); }, retry_config_,
       compose_append_, session_creator, object_uploader, status_poller,
-      generation_getter));
+      generation_getter, composite_chunk_size,
+      std::move(composite_upload_pool)));
   return Status::OK();
 }
 
@@ -2073,6 +2374,20 @@ void GcsFileSystem::SetStats(GcsStatsInterface* stats) {
   stats_->Configure(this, &throttle_, file_block_cache_.get());
 }
 
+void GcsFileSystem::SetParallelCompositeUpload(uint64 chunk_size_bytes,
+                                               int num_threads) {
+  mutex_lock l(mu_);
+  if (chunk_size_bytes == 0 || num_threads <= 0) {
+    parallel_composite_upload_chunk_size_ = 0;
+    parallel_composite_upload_pool_.reset();
+    return;
+  }
+  parallel_composite_upload_chunk_size_ = chunk_size_bytes;
+  // Files that are open keep using the thread pool they were opened with.
+  parallel_composite_upload_pool_ = std::make_shared<thread::ThreadPool>(
+      Env::Default(), "gcs_composite_upload", num_threads);
+}
+
 void GcsFileSystem::SetCacheStats(FileBlockCacheStatsInterface* cache_stats) {
   tf_shared_lock l(block_cache_lock_);
   if (file_block_cache_ == nullptr) {
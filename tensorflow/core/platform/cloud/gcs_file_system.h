@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_GCS_FILE_SYSTEM_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_GCS_FILE_SYSTEM_H_
 
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/retrying_file_system.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -62,6 +64,14 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that sets how many blocks past a sequential read are
+// fetched from GCS in parallel, in the background. Requires the block cache.
+constexpr char kReadaheadBlocks[] = "GCS_READ_CACHE_READAHEAD_BLOCKS";
+constexpr size_t kDefaultReadaheadBlocks = 0;
+// The environment variable that overrides the maximum number of bytes being
+// fetched ahead of reads at any time. Specified in MB; defaults to the size of
+// GCS_READ_CACHE_READAHEAD_BLOCKS blocks.
+constexpr char kMaxReadaheadSize[] = "GCS_READ_CACHE_MAX_READAHEAD_SIZE_MB";
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -195,6 +205,13 @@ class GcsFileSystem : public FileSystem {
   /// Set an object to collect file block cache stats.
   void SetCacheStats(FileBlockCacheStatsInterface* cache_stats);
 
+  /// Configures parallel composite uploads of the files opened afterwards by
+  /// NewWritableFile: every `chunk_size_bytes` bytes written are uploaded to a
+  /// temporary object on one of `num_threads` threads, without waiting for
+  /// Flush(), Sync() or Close(), which then compose them into the file. A
+  /// `chunk_size_bytes` of 0 disables them.
+  void SetParallelCompositeUpload(uint64 chunk_size_bytes, int num_threads);
+
   /// These accessors are mainly for testing purposes, to verify that the
   /// environment variables that control these parameters are handled correctly.
   size_t block_size() {
@@ -215,6 +232,10 @@ class GcsFileSystem : public FileSystem {
   }
 
   bool compose_append() const { return compose_append_; }
+  uint64 parallel_composite_upload_chunk_size() {
+    mutex_lock l(mu_);
+    return parallel_composite_upload_chunk_size_;
+  }
   string additional_header_name() const {
     return additional_header_ ? additional_header_->first : "";
   }
@@ -415,6 +436,10 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The readahead settings of the block caches made by MakeFileBlockCache.
+  size_t readahead_blocks_ = 0;
+  size_t max_readahead_bytes_ = 0;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -436,6 +461,12 @@ class GcsFileSystem : public FileSystem {
   std::unordered_set<string> allowed_locations_;
   bool compose_append_;
 
+  // The chunk size of parallel composite uploads, or 0 if they are disabled,
+  // and the threads uploading the chunks.
+  uint64 parallel_composite_upload_chunk_size_ TF_GUARDED_BY(mu_) = 0;
+  std::shared_ptr<thread::ThreadPool> parallel_composite_upload_pool_
+      TF_GUARDED_BY(mu_);
+
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
   // Additional header material to be transmitted with all GCS requests
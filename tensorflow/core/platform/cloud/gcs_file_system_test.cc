@@ -1341,6 +1341,112 @@ TEST(GcsFileSystemTest, NewWritableFile_NoObjectName) {
             fs.NewWritableFile("gs://bucket/", nullptr, &file).code());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_ParallelCompositeUpload) {
+  std::vector<HttpRequest*> requests({
+      // Full chunks are uploaded to temporary objects while appending.
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=some%2Fpath%2F.tmpcompose%2F"
+          "writeable.part0\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 10\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-9/10\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: 0123456789\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=some%2Fpath%2F.tmpcompose%2F"
+          "writeable.part10\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 10\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-9/10\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: abcdefghij\n",
+                          ""),
+      // Close() uploads the rest, and composes the temporary objects.
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+          "uploadType=resumable&name=some%2Fpath%2F.tmpcompose%2F"
+          "writeable.part20\n"
+          "Auth Token: fake_token\n"
+          "Header X-Upload-Content-Length: 3\n"
+          "Post: yes\n"
+          "Timeouts: 5 1 10\n",
+          "", {{"Location", "https://custom/upload/location"}}),
+      new FakeHttpRequest("Uri: https://custom/upload/location\n"
+                          "Auth Token: fake_token\n"
+                          "Header Content-Range: bytes 0-2/3\n"
+                          "Timeouts: 5 1 30\n"
+                          "Put body: xyz\n",
+                          ""),
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "some%2Fpath%2Fwriteable/compose\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n"
+          "Header content-type: application/json\n"
+          "Post body: {'sourceObjects': ["
+          "{'name': 'some/path/.tmpcompose/writeable.part0'},"
+          "{'name': 'some/path/.tmpcompose/writeable.part10'},"
+          "{'name': 'some/path/.tmpcompose/writeable.part20'}]}\n",
+          ""),
+      new FakeHttpRequest("Uri: "
+                          "https://www.googleapis.com/storage/v1/b/bucket/o/"
+                          "some%2Fpath%2F.tmpcompose%2Fwriteable.part0\n"
+                          "Auth Token: fake_token\n"
+                          "Timeouts: 5 1 10\n"
+                          "Delete: yes\n",
+                          ""),
+      new FakeHttpRequest("Uri: "
+                          "https://www.googleapis.com/storage/v1/b/bucket/o/"
+                          "some%2Fpath%2F.tmpcompose%2Fwriteable.part10\n"
+                          "Auth Token: fake_token\n"
+                          "Timeouts: 5 1 10\n"
+                          "Delete: yes\n",
+                          ""),
+      new FakeHttpRequest("Uri: "
+                          "https://www.googleapis.com/storage/v1/b/bucket/o/"
+                          "some%2Fpath%2F.tmpcompose%2Fwriteable.part20\n"
+                          "Auth Token: fake_token\n"
+                          "Timeouts: 5 1 10\n"
+                          "Delete: yes\n",
+                          ""),
+  });
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  // A single upload thread keeps the order of the requests deterministic.
+  fs.SetParallelCompositeUpload(10 /* chunk size */, 1 /* threads */);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(
+      fs.NewWritableFile("gs://bucket/some/path/writeable", nullptr, &wfile));
+  TF_EXPECT_OK(wfile->Append("0123456789abc"));
+  TF_EXPECT_OK(wfile->Append("defghijxyz"));
+  int64 position;
+  TF_EXPECT_OK(wfile->Tell(&position));
+  EXPECT_EQ(23, position);
+  TF_EXPECT_OK(wfile->Close());
+}
+
 TEST(GcsFileSystemTest, NewAppendableFile) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
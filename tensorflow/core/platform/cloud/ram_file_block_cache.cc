@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 #include <cstring>
 #include <memory>
+#include <utility>
+#include <vector>
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/env.h"
 
@@ -46,6 +48,11 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
     }
   }
 
+  return Insert_Locked(key);
+}
+
+std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Insert_Locked(
+    const Key& key) {
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
@@ -83,11 +90,17 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
   // in the cache, and our current block is not block size, this likely means
   // we have inconsistent state within the cache. Note: it's possible some
   // incomplete reads may still go undetected.
+  // Blocks fetched ahead of reads may lie past the end of the file, in which
+  // case they are empty, or may still be in flight; skip over both.
   if (block->data.size() < block_size_) {
     Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
     auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    while (fcmp != block_map_.begin() && key < (--fcmp)->first) {
+      mutex_lock l(fcmp->second->mu);
+      if (fcmp->second->state == FetchState::FINISHED &&
+          !fcmp->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -182,6 +195,7 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  MaybeReadahead(filename, offset, n, finish);
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -227,6 +241,74 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   return Status::OK();
 }
 
+void RamFileBlockCache::MaybeReadahead(const string& filename, size_t offset,
+                                       size_t n, size_t finish) {
+  if (readahead_pool_ == nullptr) {
+    return;
+  }
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> blocks_to_fetch;
+  {
+    mutex_lock lock(mu_);
+    auto it = readahead_states_.find(filename);
+    if (it == readahead_states_.end()) {
+      if (readahead_states_.size() >= kMaxReadaheadFiles) {
+        // The states are only hints, so drop them all rather than tracking
+        // which file was read least recently.
+        readahead_states_.clear();
+      }
+      it = readahead_states_.emplace(filename, ReadaheadState()).first;
+    }
+    ReadaheadState& state = it->second;
+    if (offset == state.next_offset) {
+      ++state.sequential_reads;
+    } else {
+      state.sequential_reads = 0;
+    }
+    state.next_offset = offset + n;
+    if (state.sequential_reads < 2) {
+      return;
+    }
+    const size_t end =
+        std::min(finish + readahead_blocks_ * block_size_, state.eof_offset);
+    for (size_t pos = finish; pos < end; pos += block_size_) {
+      if (readahead_bytes_in_flight_ + block_size_ > max_readahead_bytes_) {
+        break;
+      }
+      Key key = std::make_pair(filename, pos);
+      if (block_map_.find(key) != block_map_.end()) {
+        continue;
+      }
+      readahead_bytes_in_flight_ += block_size_;
+      blocks_to_fetch.emplace_back(key, Insert_Locked(key));
+    }
+  }
+  for (auto& key_and_block : blocks_to_fetch) {
+    readahead_pool_->Schedule([this, key_and_block]() {
+      const Key& key = key_and_block.first;
+      const std::shared_ptr<Block>& block = key_and_block.second;
+      // A read of the block that started in the meantime fetches it instead,
+      // and this waits for that fetch to finish.
+      Status status = MaybeFetch(key, block);
+      if (status.ok()) {
+        status = UpdateLRU(key, block);
+      }
+      if (!status.ok()) {
+        VLOG(1) << "Readahead of " << key.first << "@" << key.second
+                << " failed: " << status;
+      }
+      mutex_lock lock(mu_);
+      readahead_bytes_in_flight_ -= block_size_;
+      if (status.ok() && block->data.size() < block_size_) {
+        auto it = readahead_states_.find(key.first);
+        if (it != readahead_states_.end()) {
+          it->second.eof_offset = std::min(it->second.eof_offset,
+                                           key.second + block->data.size());
+        }
+      }
+    });
+  }
+}
+
 bool RamFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
                                                        int64 file_signature) {
   mutex_lock lock(mu_);
@@ -271,6 +353,7 @@ void RamFileBlockCache::Flush() {
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
+  readahead_states_.clear();
   cache_size_ = 0;
 }
 
@@ -280,6 +363,7 @@ void RamFileBlockCache::RemoveFile(const string& filename) {
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+  readahead_states_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
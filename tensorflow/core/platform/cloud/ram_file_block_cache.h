@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -52,20 +55,43 @@ class RamFileBlockCache : public FileBlockCache {
 
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
                     BlockFetcher block_fetcher, Env* env = Env::Default())
+      : RamFileBlockCache(block_size, max_bytes, max_staleness, block_fetcher,
+                          /*readahead_blocks=*/0, /*max_readahead_bytes=*/0,
+                          env) {}
+
+  /// As above, but once a file is read sequentially, each read also fetches up
+  /// to `readahead_blocks` blocks past its end in the background, in parallel.
+  /// At most `max_readahead_bytes` (capped at half of `max_bytes`) are fetched
+  /// in the background at any time, across all files.
+  RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
+                    BlockFetcher block_fetcher, size_t readahead_blocks,
+                    size_t max_readahead_bytes, Env* env = Env::Default())
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
+        readahead_blocks_(block_size > 0 && max_bytes > 0 ? readahead_blocks
+                                                          : 0),
+        max_readahead_bytes_(std::min(max_readahead_bytes, max_bytes / 2)),
         block_fetcher_(block_fetcher),
         env_(env) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (readahead_blocks_ > 0 && max_readahead_bytes_ >= block_size_) {
+      readahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_readahead_FBC",
+          std::min<size_t>(readahead_blocks_, kMaxReadaheadThreads)));
+    }
     VLOG(1) << "GCS file block cache is "
-            << (IsCacheEnabled() ? "enabled" : "disabled");
+            << (IsCacheEnabled() ? "enabled" : "disabled")
+            << ", readahead is " << (readahead_pool_ ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying readahead_pool_ will block until the pending readahead
+    // fetches, which reference this cache, have finished.
+    readahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -127,6 +153,11 @@ class RamFileBlockCache : public FileBlockCache {
   const size_t max_bytes_;
   /// The maximum staleness of any block in the LRU cache, in seconds.
   const uint64 max_staleness_;
+  /// The number of blocks to fetch ahead of sequential reads, or 0 if
+  /// readahead is disabled.
+  const size_t readahead_blocks_;
+  /// The maximum number of bytes being fetched ahead at any time.
+  const size_t max_readahead_bytes_;
   /// The callback to read a block from the underlying filesystem.
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
@@ -183,6 +214,26 @@ class RamFileBlockCache : public FileBlockCache {
     condition_variable cond_var;
   };
 
+  /// \brief The readahead state of a file.
+  ///
+  /// A read is sequential if it starts where the previous read of the same
+  /// file ended, or at offset 0 for the first read of the file. Readahead
+  /// starts with the second consecutive sequential read.
+  struct ReadaheadState {
+    /// The offset at which the previous read ended.
+    size_t next_offset = 0;
+    /// The number of consecutive sequential reads.
+    int sequential_reads = 0;
+    /// The offset past the end of the file, once a block fetched ahead came
+    /// back partial. No blocks at or after it are fetched ahead.
+    size_t eof_offset = std::numeric_limits<size_t>::max();
+  };
+
+  /// The maximum number of threads fetching blocks ahead of reads.
+  static constexpr int kMaxReadaheadThreads = 16;
+  /// The maximum number of files whose readahead state is tracked.
+  static constexpr size_t kMaxReadaheadFiles = 1024;
+
   /// \brief The block map type for the file block cache.
   ///
   /// The block map is an ordered map from Key to Block.
@@ -197,9 +248,19 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) TF_LOCKS_EXCLUDED(mu_);
 
+  /// Insert a new empty block for a Key that is not in the block cache.
+  std::shared_ptr<Block> Insert_Locked(const Key& key)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       TF_LOCKS_EXCLUDED(mu_);
 
+  /// Record a read of [offset, offset + n) from `filename` and, if the file is
+  /// being read sequentially, schedule background fetches of the blocks
+  /// starting at the block-aligned offset `finish`.
+  void MaybeReadahead(const string& filename, size_t offset, size_t n,
+                      size_t finish) TF_LOCKS_EXCLUDED(mu_);
+
   /// Trim the block cache to make room for another entry.
   void Trim() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -221,6 +282,10 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
+  /// The threads fetching blocks ahead of sequential reads, or nullptr if
+  /// readahead is disabled.
+  std::unique_ptr<thread::ThreadPool> readahead_pool_;
+
   /// Guards access to the block map, LRU list, and cached byte count.
   mutable mutex mu_;
 
@@ -243,6 +308,12 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ TF_GUARDED_BY(mu_);
+
+  /// The readahead state of the files read most recently.
+  std::map<string, ReadaheadState> readahead_states_ TF_GUARDED_BY(mu_);
+
+  /// The number of bytes being fetched ahead of reads.
+  size_t readahead_bytes_in_flight_ TF_GUARDED_BY(mu_) = 0;
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -566,5 +567,128 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+// Records the offsets requested from a fetcher, which may be called from the
+// readahead threads of a cache.
+class FetchRecorder {
+ public:
+  void Record(size_t offset) {
+    mutex_lock l(mu_);
+    offsets_.push_back(offset);
+    cond_var_.notify_all();
+  }
+
+  // Waits until `count` fetches have been recorded, and returns their offsets
+  // in ascending order.
+  std::vector<size_t> WaitForFetches(size_t count) {
+    mutex_lock l(mu_);
+    while (offsets_.size() < count) {
+      if (cond_var_.wait_for(l, std::chrono::seconds(10)) ==
+          std::cv_status::timeout) {
+        break;
+      }
+    }
+    std::vector<size_t> offsets = offsets_;
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+  }
+
+ private:
+  mutex mu_;
+  condition_variable cond_var_;
+  std::vector<size_t> offsets_ TF_GUARDED_BY(mu_);
+};
+
+TEST(RamFileBlockCacheTest, ReadaheadSequentialReads) {
+  const size_t block_size = 16;
+  const size_t file_size = 10 * block_size;
+  FetchRecorder recorder;
+  auto fetcher = [&recorder, file_size](const string& filename, size_t offset,
+                                        size_t n, char* buffer,
+                                        size_t* bytes_transferred) {
+    recorder.Record(offset);
+    *bytes_transferred = std::min(n, file_size - std::min(offset, file_size));
+    memset(buffer, 'a' + offset / block_size, *bytes_transferred);
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher,
+                          /*readahead_blocks=*/4,
+                          /*max_readahead_bytes=*/4 * block_size);
+  std::vector<char> out;
+  // The first read of a file does not fetch ahead, the second sequential one
+  // fetches the four blocks after it.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+  EXPECT_EQ(recorder.WaitForFetches(6),
+            std::vector<size_t>({0, 16, 32, 48, 64, 80}));
+  // The blocks fetched ahead are cache hits, and these reads are not
+  // sequential so they do not fetch ahead.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 5 * block_size, block_size, &out));
+  EXPECT_EQ(out, std::vector<char>(block_size, 'f'));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 2 * block_size, block_size / 2, &out));
+  EXPECT_EQ(out, std::vector<char>(block_size / 2, 'c'));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 8 * block_size, block_size, &out));
+  EXPECT_EQ(out, std::vector<char>(block_size, 'i'));
+  EXPECT_EQ(recorder.WaitForFetches(7),
+            std::vector<size_t>({0, 16, 32, 48, 64, 80, 128}));
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadPastEndOfFile) {
+  const size_t block_size = 16;
+  const size_t file_size = 2 * block_size + block_size / 2;
+  FetchRecorder recorder;
+  auto fetcher = [&recorder, file_size](const string& filename, size_t offset,
+                                        size_t n, char* buffer,
+                                        size_t* bytes_transferred) {
+    recorder.Record(offset);
+    *bytes_transferred = std::min(n, file_size - std::min(offset, file_size));
+    memset(buffer, 'x', *bytes_transferred);
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher,
+                          /*readahead_blocks=*/4,
+                          /*max_readahead_bytes=*/4 * block_size);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+  EXPECT_EQ(recorder.WaitForFetches(6).size(), 6);
+  // The empty blocks fetched past the end of the file do not make the partial
+  // last block look inconsistent.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 2 * block_size, block_size, &out));
+  EXPECT_EQ(out.size(), block_size / 2);
+  Status status = ReadCache(&cache, "a", 3 * block_size, block_size, &out);
+  EXPECT_EQ(status.code(), error::OUT_OF_RANGE);
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadBudget) {
+  const size_t block_size = 16;
+  FetchRecorder recorder;
+  Notification release_fetches;
+  auto fetcher = [&recorder, &release_fetches](
+                     const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    recorder.Record(offset);
+    if (offset >= 2 * block_size) {
+      release_fetches.WaitForNotification();
+    }
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher,
+                          /*readahead_blocks=*/8,
+                          /*max_readahead_bytes=*/2 * block_size);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size / 2, &out));
+  EXPECT_EQ(recorder.WaitForFetches(4),
+            std::vector<size_t>({0, 16, 32, 48}));
+  // Only two blocks may be fetched ahead at a time, so the next sequential
+  // read does not fetch more until they are done.
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size + block_size / 2,
+                         block_size / 2, &out));
+  release_fetches.Notify();
+  EXPECT_EQ(recorder.WaitForFetches(4).size(), 4);
+}
+
 }  // namespace
 }  // namespace tensorflow
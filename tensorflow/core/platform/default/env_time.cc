@@ -28,4 +28,16 @@ uint64 EnvTime::NowNanos() {
           static_cast<uint64>(ts.tv_nsec));
 }
 
+/* static */
+uint64 EnvTime::ThreadCpuNanos() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return (static_cast<uint64>(ts.tv_sec) * kSecondsToNanos +
+            static_cast<uint64>(ts.tv_nsec));
+  }
+#endif
+  return 0;
+}
+
 }  // namespace tensorflow
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "absl/base/internal/sysinfo.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
@@ -356,6 +358,29 @@ double NominalCPUFrequency() {
   return tensorflow::profile_utils::CpuUtils::GetCycleCounterFrequency();
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// Reads a byte count from a cgroup memory control file. Returns false if the
+// file does not exist or does not hold a number (e.g. "max").
+bool ReadCgroupMemoryValue(const char* path, int64* value) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+  long long result = 0;  // NOLINT(runtime/int)
+  const bool ok = fscanf(file, "%lld", &result) == 1;
+  fclose(file);
+  if (!ok || result < 0) {
+    return false;
+  }
+  *value = result;
+  return true;
+}
+
+}  // namespace
+#endif
+
 MemoryInfo GetMemoryInfo() {
   MemoryInfo mem_info = {INT64_MAX, INT64_MAX};
 #if defined(__linux__) && !defined(__ANDROID__)
@@ -365,6 +390,19 @@ MemoryInfo GetMemoryInfo() {
     mem_info.free = info.freeram;
     mem_info.total = info.totalram;
   }
+  // In a container the memory limit of the cgroup (v2, then v1) can be far
+  // below the host memory.
+  int64 limit = 0;
+  int64 usage = 0;
+  if ((ReadCgroupMemoryValue("/sys/fs/cgroup/memory.max", &limit) &&
+       ReadCgroupMemoryValue("/sys/fs/cgroup/memory.current", &usage)) ||
+      (ReadCgroupMemoryValue("/sys/fs/cgroup/memory/memory.limit_in_bytes",
+                             &limit) &&
+       ReadCgroupMemoryValue("/sys/fs/cgroup/memory/memory.usage_in_bytes",
+                             &usage))) {
+    mem_info.total = std::min(mem_info.total, limit);
+    mem_info.free = std::min(mem_info.free, std::max<int64>(limit - usage, 0));
+  }
 #endif
   return mem_info;
 }
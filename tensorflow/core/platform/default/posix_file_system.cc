@@ -26,15 +26,34 @@ limitations under the License.
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define TF_POSIX_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/platform/default/posix_file_system.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/error.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -44,6 +63,307 @@ namespace tensorflow {
 // 128KB of copy buffer
 constexpr size_t kPosixCopyFileBufferSize = 128 * 1024;
 
+#if defined(TF_POSIX_HAS_IO_URING)
+// Number of reads an IoUring keeps in flight at once.
+constexpr unsigned kIoUringEntries = 64;
+
+// A minimal io_uring, used by PosixRandomAccessFile::MultiRead to keep many
+// reads in flight from one thread. Each thread has its own ring, so it needs
+// no locking.
+class IoUring {
+ public:
+  ~IoUring() { Close(); }
+
+  // Returns the ring of the calling thread, or nullptr if io_uring is not
+  // supported by the kernel or not allowed in this process.
+  static IoUring* ForCurrentThread() {
+    static std::atomic<bool> unavailable(false);
+    if (unavailable.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    thread_local std::unique_ptr<IoUring> ring;
+    if (ring == nullptr || ring->ring_fd_ < 0) {
+      ring.reset(new IoUring);
+      if (!ring->Init(kIoUringEntries)) {
+        VLOG(1) << "io_uring is not available: " << strerror(errno);
+        unavailable.store(true, std::memory_order_relaxed);
+        ring.reset();
+        return nullptr;
+      }
+    }
+    return ring.get();
+  }
+
+  // Reads `iovecs[i]` from `fd` at `offsets[i]` for all `i` < `num`, and
+  // stores the number of bytes read, or -errno, in `results[i]`. Returns
+  // false if the ring itself failed, in which case the ring is closed and the
+  // reads must be retried another way.
+  bool ReadV(int fd, const struct iovec* iovecs, const uint64* offsets,
+             size_t num, int64* results) {
+    size_t next = 0;
+    size_t completed = 0;
+    unsigned in_flight = 0;
+    unsigned to_submit = 0;
+    while (completed < num) {
+      // In-flight reads never exceed the SQ size, and the CQ is twice as
+      // large, so neither ring can overflow.
+      while (next < num && in_flight < sq_entries_) {
+        const unsigned tail = *sq_tail_;
+        const unsigned index = tail & sq_mask_;
+        struct io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fd;
+        sqe->off = offsets[next];
+        sqe->addr = reinterpret_cast<uint64>(&iovecs[next]);
+        sqe->len = 1;
+        sqe->user_data = next;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        ++next;
+        ++in_flight;
+        ++to_submit;
+      }
+      const int ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, 1,
+                              IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+          continue;
+        }
+        // Reads still in flight write the same bytes into the same buffers as
+        // the retries of the caller, so it is safe to abandon them.
+        LOG(WARNING) << "io_uring_enter() failed: " << strerror(errno);
+        Close();
+        return false;
+      }
+      to_submit -= ret;
+      unsigned head = *cq_head_;
+      const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != cq_tail; ++head) {
+        const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        results[cqe.user_data] = cqe.res;
+        ++completed;
+        --in_flight;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+    return true;
+  }
+
+ private:
+  IoUring() {}
+
+  bool Init(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd_ < 0) {
+      return false;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = Map(cq_ring_size_, IORING_OFF_CQ_RING);
+    void* sqes = Map(sqes_size_, IORING_OFF_SQES);
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+      Close();
+      return false;
+    }
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  void* Map(size_t size, off_t offset) {
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return address == MAP_FAILED ? nullptr : address;
+  }
+
+  void Close() {
+    if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+    if (cq_ring_ != nullptr) munmap(cq_ring_, cq_ring_size_);
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+    sq_ring_ = nullptr;
+    cq_ring_ = nullptr;
+    sqes_ = nullptr;
+    ring_fd_ = -1;
+  }
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  struct io_uring_sqe* sqes_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  struct io_uring_cqe* cqes_ = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+#endif  // TF_POSIX_HAS_IO_URING
+
+#if defined(O_DIRECT)
+// Files at least this large, in MB, are read with O_DIRECT, bypassing the page
+// cache. Reading datasets much larger than memory through the page cache
+// evicts hot pages, e.g. model weights, for data that is read only once.
+// Unset by default, which disables O_DIRECT reads.
+constexpr char kDirectIOMinFileSizeEnv[] =
+    "TF_POSIX_DIRECT_IO_MIN_FILE_SIZE_MB";
+
+// Offsets, lengths and buffers of O_DIRECT reads are aligned to this, which
+// covers the logical block size of all common devices.
+constexpr size_t kDirectIOAlignment = 4096;
+// Size of the aligned buffers that O_DIRECT reads go through.
+constexpr size_t kDirectIOBufferSize = 1 << 20;
+// At most this many idle buffers are kept for reuse.
+constexpr size_t kDirectIOMaxPooledBuffers = 16;
+
+// A free list of aligned buffers for O_DIRECT reads, shared by all files.
+class DirectIOBufferPool {
+ public:
+  static DirectIOBufferPool* Get() {
+    static DirectIOBufferPool* pool = new DirectIOBufferPool;
+    return pool;
+  }
+
+  char* Acquire() {
+    {
+      mutex_lock l(mu_);
+      if (!buffers_.empty()) {
+        char* buffer = buffers_.back();
+        buffers_.pop_back();
+        return buffer;
+      }
+    }
+    return static_cast<char*>(
+        port::AlignedMalloc(kDirectIOBufferSize, kDirectIOAlignment));
+  }
+
+  void Release(char* buffer) {
+    {
+      mutex_lock l(mu_);
+      if (buffers_.size() < kDirectIOMaxPooledBuffers) {
+        buffers_.push_back(buffer);
+        return;
+      }
+    }
+    port::AlignedFree(buffer);
+  }
+
+ private:
+  mutex mu_;
+  std::vector<char*> buffers_ TF_GUARDED_BY(mu_);
+};
+
+// Random-access file read with O_DIRECT. Reads are widened to aligned ranges,
+// read into pooled aligned buffers and copied out, unless the caller's range
+// and buffer are already aligned.
+class PosixDirectRandomAccessFile : public RandomAccessFile {
+ private:
+  string filename_;
+  int fd_;
+
+ public:
+  PosixDirectRandomAccessFile(const string& fname, int fd)
+      : filename_(fname), fd_(fd) {}
+  ~PosixDirectRandomAccessFile() override {
+    if (close(fd_) < 0) {
+      LOG(ERROR) << "close() failed: " << strerror(errno);
+    }
+  }
+
+  Status Name(StringPiece* result) const override {
+    *result = filename_;
+    return Status::OK();
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    Status s;
+    char* dst = scratch;
+    char* buffer = nullptr;
+    while (n > 0 && s.ok()) {
+      const uint64 aligned_offset = offset & ~(kDirectIOAlignment - 1);
+      const size_t skip = offset - aligned_offset;
+      const bool aligned =
+          skip == 0 && n >= kDirectIOAlignment &&
+          reinterpret_cast<uintptr_t>(dst) % kDirectIOAlignment == 0;
+      char* target;
+      size_t length;
+      if (aligned) {
+        // Reads whole blocks straight into the caller's buffer.
+        target = dst;
+        length = std::min<size_t>(n, INT32_MAX) & ~(kDirectIOAlignment - 1);
+      } else {
+        if (buffer == nullptr) {
+          buffer = DirectIOBufferPool::Get()->Acquire();
+        }
+        target = buffer;
+        length = std::min(kDirectIOBufferSize,
+                          (skip + n + kDirectIOAlignment - 1) &
+                              ~(kDirectIOAlignment - 1));
+      }
+      ssize_t r =
+          pread(fd_, target, length, static_cast<off_t>(aligned_offset));
+      if (r > static_cast<ssize_t>(skip)) {
+        const size_t copied = std::min<size_t>(r - skip, n);
+        if (!aligned) {
+          memcpy(dst, buffer + skip, copied);
+        }
+        dst += copied;
+        n -= copied;
+        offset += copied;
+      } else if (r >= 0) {
+        s = Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+      } else if (errno == EINTR || errno == EAGAIN) {
+        // Retry
+      } else {
+        s = IOError(filename_, errno);
+      }
+    }
+    if (buffer != nullptr) {
+      DirectIOBufferPool::Get()->Release(buffer);
+    }
+    *result = StringPiece(scratch, dst - scratch);
+    return s;
+  }
+};
+
+// Returns true if `fd` should be read with O_DIRECT, per
+// kDirectIOMinFileSizeEnv.
+bool UseDirectIO(int fd) {
+  const char* min_size_str = getenv(kDirectIOMinFileSizeEnv);
+  uint64 min_size_mb;
+  if (min_size_str == nullptr ||
+      !strings::safe_strtou64(min_size_str, &min_size_mb)) {
+    return false;
+  }
+  struct stat st;
+  return fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+         static_cast<uint64>(st.st_size) >= min_size_mb * 1024 * 1024;
+}
+#endif  // O_DIRECT
+
 // pread() based random-access
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
@@ -95,6 +415,53 @@ class PosixRandomAccessFile : public RandomAccessFile {
     return s;
   }
 
+  Status MultiRead(std::vector<ReadRequest>* requests) const override {
+#if defined(TF_POSIX_HAS_IO_URING)
+    IoUring* ring = IoUring::ForCurrentThread();
+    if (ring == nullptr) {
+      return RandomAccessFile::MultiRead(requests);
+    }
+    const size_t num = requests->size();
+    std::vector<struct iovec> iovecs(num);
+    std::vector<uint64> offsets(num);
+    std::vector<int64> results(num);
+    for (size_t i = 0; i < num; ++i) {
+      const ReadRequest& request = (*requests)[i];
+      iovecs[i].iov_base = request.scratch;
+      iovecs[i].iov_len = std::min<size_t>(request.n, INT32_MAX);
+      offsets[i] = request.offset;
+    }
+    if (!ring->ReadV(fd_, iovecs.data(), offsets.data(), num,
+                     results.data())) {
+      return RandomAccessFile::MultiRead(requests);
+    }
+    for (size_t i = 0; i < num; ++i) {
+      ReadRequest& request = (*requests)[i];
+      const int64 r = results[i];
+      if (r < 0 && r != -EINTR && r != -EAGAIN) {
+        request.result = StringPiece(request.scratch, 0);
+        request.status = IOError(filename_, -r);
+        continue;
+      }
+      const size_t bytes_read = std::max<int64>(r, 0);
+      request.status = Status::OK();
+      request.result = StringPiece(request.scratch, bytes_read);
+      if (bytes_read < request.n) {
+        // Finishes short reads with pread(), which also detects EOF.
+        StringPiece rest;
+        request.status =
+            Read(request.offset + bytes_read, request.n - bytes_read, &rest,
+                 request.scratch + bytes_read);
+        request.result =
+            StringPiece(request.scratch, bytes_read + rest.size());
+      }
+    }
+    return Status::OK();
+#else
+    return RandomAccessFile::MultiRead(requests);
+#endif
+  }
+
 #if defined(TF_CORD_SUPPORT)
   Status Read(uint64 offset, size_t n, absl::Cord* cord) const override {
     if (n == 0) {
@@ -229,6 +596,18 @@ Status PosixFileSystem::NewRandomAccessFile(
   if (fd < 0) {
     s = IOError(fname, errno);
   } else {
+#if defined(O_DIRECT)
+    if (UseDirectIO(fd)) {
+      // Filesystems without O_DIRECT support, e.g. tmpfs, fail the open.
+      int direct_fd = open(translated_fname.c_str(), O_RDONLY | O_DIRECT);
+      if (direct_fd >= 0) {
+        close(fd);
+        result->reset(
+            new PosixDirectRandomAccessFile(translated_fname, direct_fd));
+        return s;
+      }
+    }
+#endif
     result->reset(new PosixRandomAccessFile(translated_fname, fd));
   }
   return s;
@@ -39,6 +39,7 @@ static int64 bytes_processed;
 static int64 items_processed;
 static int64 accum_time = 0;
 static int64 start_time = 0;
+static int repetitions = 1;
 static Env* env;
 
 Benchmark::Benchmark(const char* name, void (*fn)(int))
@@ -204,36 +205,57 @@ void Benchmark::Run(const char* pattern) {
 
       int iters;
       double seconds;
-      b->Run(arg.first, arg.second, &iters, &seconds);
-
-      char buf[100];
-      std::string full_label = label;
-      if (bytes_processed > 0) {
-        snprintf(buf, sizeof(buf), " %.5fMB/s",
-                 (bytes_processed * 1e-6) / seconds);
-        full_label += buf;
-      }
-      if (items_processed > 0) {
-        snprintf(buf, sizeof(buf), " %.5fM items/s",
-                 (items_processed * 1e-6) / seconds);
-        full_label += buf;
+      int64 total_iters = 0;
+      double total_seconds = 0;
+      // Wall time per iteration of each repetition, in seconds.
+      std::vector<double> wall_times;
+      for (int repetition = 0; repetition < repetitions; ++repetition) {
+        b->Run(arg.first, arg.second, &iters, &seconds);
+        total_iters += iters;
+        total_seconds += seconds;
+        wall_times.push_back(seconds / iters);
+
+        char buf[100];
+        std::string full_label = label;
+        if (bytes_processed > 0) {
+          snprintf(buf, sizeof(buf), " %.5fMB/s",
+                   (bytes_processed * 1e-6) / seconds);
+          full_label += buf;
+        }
+        if (items_processed > 0) {
+          snprintf(buf, sizeof(buf), " %.5fM items/s",
+                   (items_processed * 1e-6) / seconds);
+          full_label += buf;
+        }
+        printf("%-*s %10.0f %10d\t%s\n", width, name.c_str(),
+               seconds * 1e9 / iters, iters, full_label.c_str());
       }
-      printf("%-*s %10.0f %10d\t%s\n", width, name.c_str(),
-             seconds * 1e9 / iters, iters, full_label.c_str());
 
       TestReporter reporter(name);
       Status s = reporter.Initialize();
-      if (!s.ok()) {
-        LOG(ERROR) << s.ToString();
-        exit(EXIT_FAILURE);
+      if (s.ok()) {
+        s = reporter.Benchmark(total_iters, 0.0, total_seconds,
+                               items_processed * 1e-6 / seconds);
       }
-      s = reporter.Benchmark(iters, 0.0, seconds,
-                             items_processed * 1e-6 / seconds);
-      if (!s.ok()) {
-        LOG(ERROR) << s.ToString();
-        exit(EXIT_FAILURE);
+      // With several repetitions, record each of them so that regressions
+      // can be told apart from noise when comparing runs.
+      if (repetitions > 1) {
+        for (double wall_time : wall_times) {
+          if (s.ok()) s = reporter.AddMetric("wall_time", wall_time);
+        }
+      }
+      if (s.ok() && bytes_processed > 0) {
+        s = reporter.SetProperty("bytes_per_second",
+                                 bytes_processed / seconds);
+      }
+      if (s.ok() && items_processed > 0) {
+        s = reporter.SetProperty("items_per_second",
+                                 items_processed / seconds);
       }
-      s = reporter.Close();
+      if (s.ok() && !label.empty()) {
+        s = reporter.SetProperty("label", label);
+      }
+      if (s.ok()) s = reporter.Close();
       if (!s.ok()) {
         LOG(ERROR) << s.ToString();
         exit(EXIT_FAILURE);
@@ -242,6 +264,11 @@ void Benchmark::Run(const char* pattern) {
   }
 }
 
+void Benchmark::SetRepetitions(int n) {
+  CHECK_GE(n, 1);
+  repetitions = n;
+}
+
 void Benchmark::Register() {
   if (!all_benchmarks) all_benchmarks = new std::vector<Benchmark*>;
   all_benchmarks->push_back(this);
@@ -109,6 +109,10 @@ class Benchmark {
 
   static void Run(const char* pattern);
 
+  // Runs every benchmark `n` times, 1 by default. The wall time of each
+  // repetition is reported, so that runs can be compared statistically.
+  static void SetRepetitions(int n);
+
  private:
   string name_;
   int num_args_;
@@ -90,6 +90,62 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, DirectIORead) {
+  const string filename = io::JoinPath(BaseDir(), "direct_io");
+  const string input = CreateTestFile(env_, filename, 3 * 4096 + 100);
+  // Reads all files with O_DIRECT, where the filesystem supports it.
+  setenv("TF_POSIX_DIRECT_IO_MIN_FILE_SIZE_MB", "0", 1);
+  std::unique_ptr<RandomAccessFile> f;
+  Status s = env_->NewRandomAccessFile(filename, &f);
+  unsetenv("TF_POSIX_DIRECT_IO_MIN_FILE_SIZE_MB");
+  TF_ASSERT_OK(s);
+
+  string scratch(input.size() + 1, '\0');
+  StringPiece result;
+  for (const std::pair<uint64, size_t>& range :
+       std::vector<std::pair<uint64, size_t>>{
+           {0, 4096}, {1, 10}, {4000, 200}, {4096, 2 * 4096}, {0, 12388}}) {
+    TF_EXPECT_OK(f->Read(range.first, range.second, &result, &scratch[0]));
+    EXPECT_EQ(input.substr(range.first, range.second), result);
+  }
+  // Reading past EOF should give an OUT_OF_RANGE error
+  EXPECT_EQ(error::OUT_OF_RANGE,
+            f->Read(12000, 1000, &result, &scratch[0]).code());
+  EXPECT_EQ(input.substr(12000), result);
+  EXPECT_EQ(error::OUT_OF_RANGE,
+            f->Read(0, input.size() + 1, &result, &scratch[0]).code());
+  EXPECT_EQ(input, result);
+}
+
+TEST_F(DefaultEnvTest, MultiRead) {
+  const string filename = io::JoinPath(BaseDir(), "multi_read");
+  const string input = CreateTestFile(env_, filename, 100000);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // More requests than an io_uring keeps in flight, the last one past EOF.
+  const int num_requests = 200;
+  std::vector<string> scratch(num_requests, string(1000, '\0'));
+  std::vector<RandomAccessFile::ReadRequest> requests(num_requests);
+  for (int i = 0; i < num_requests; ++i) {
+    requests[i].offset = (i * 7919) % 99000;
+    requests[i].n = 1000;
+    requests[i].scratch = &scratch[i][0];
+  }
+  requests.back().offset = 99500;
+  Status s = f->MultiRead(&requests);
+  if (errors::IsUnimplemented(s)) {
+    return;
+  }
+  TF_ASSERT_OK(s);
+  for (int i = 0; i < num_requests - 1; ++i) {
+    TF_EXPECT_OK(requests[i].status);
+    EXPECT_EQ(input.substr(requests[i].offset, 1000), requests[i].result);
+  }
+  EXPECT_EQ(error::OUT_OF_RANGE, requests.back().status.code());
+  EXPECT_EQ(input.substr(99500), requests.back().result);
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
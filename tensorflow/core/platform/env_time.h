@@ -46,6 +46,10 @@ class EnvTime {
   /// \brief Returns the number of seconds since the Unix epoch.
   static uint64 NowSeconds() { return NowNanos() / kSecondsToNanos; }
 
+  /// \brief Returns the CPU time consumed by the calling thread in
+  /// nano-seconds, or 0 if the platform does not support thread CPU clocks.
+  static uint64 ThreadCpuNanos();
+
   /// \brief A version of NowNanos() that may be overridden by a subclass.
   virtual uint64 GetOverridableNowNanos() const { return NowNanos(); }
 
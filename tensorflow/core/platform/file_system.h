@@ -761,6 +761,33 @@ class RandomAccessFile {
   }
 #endif
 
+  /// \brief A range of the file to read with `MultiRead`.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    /// Must hold `n` bytes, and may be written by `MultiRead`.
+    char* scratch = nullptr;
+    /// Set to the data that was read, as by `Read`.
+    StringPiece result;
+    /// Set to the status of the read, as returned by `Read`.
+    tensorflow::Status status;
+  };
+
+  /// \brief Reads all of `requests`, keeping many of them in flight at once.
+  ///
+  /// Each request is completed as by
+  /// `Read(offset, n, &result, scratch)`, with its own `status`.
+  ///
+  /// This is an optional operation that may not be implemented by every
+  /// filesystem. If it returns a non-OK status, no request was completed and
+  /// callers should fall back to `Read`.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual tensorflow::Status MultiRead(
+      std::vector<ReadRequest>* requests) const {
+    return errors::Unimplemented("This filesystem does not support MultiRead()");
+  }
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
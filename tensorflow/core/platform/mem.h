@@ -68,7 +68,8 @@ struct MemoryBandwidthInfo {
   int64 bw_used = 0;  // memory bandwidth used across all CPU (in MBs/second)
 };
 
-// Retrieves the host memory information. If any of the fields in the returned
+// Retrieves the host memory information, limited by the memory limit of the
+// cgroup of the process if there is one. If any of the fields in the returned
 // MemoryInfo structure is INT64_MAX, it means such information is not
 // available.
 MemoryInfo GetMemoryInfo();
@@ -29,15 +29,25 @@ std::mt19937_64* InitRngWithRandomSeed() {
 }
 std::mt19937_64 InitRngWithDefaultSeed() { return std::mt19937_64(); }
 
-}  // anonymous namespace
-
-uint64 New64() {
+// Returns a seed drawn from the process-wide generator. Only called once per
+// thread, so the mutex is not contended on the New64() fast path.
+uint64 NewThreadSeed() {
   static std::mt19937_64* rng = InitRngWithRandomSeed();
   static mutex mu(LINKER_INITIALIZED);
   mutex_lock l(mu);
   return (*rng)();
 }
 
+}  // anonymous namespace
+
+uint64 New64() {
+  // Each thread owns a generator seeded from the process-wide one. Hot callers
+  // (e.g. every function call picks a random step ID) would otherwise
+  // serialize on a single global mutex.
+  thread_local std::mt19937_64 rng(NewThreadSeed());
+  return rng();
+}
+
 uint64 New64DefaultSeed() {
   static std::mt19937_64 rng = InitRngWithDefaultSeed();
   static mutex mu(LINKER_INITIALIZED);
@@ -39,7 +39,9 @@ limitations under the License.
 #include <cmath>
 #include <cstdlib>
 
+#include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 #include "tensorflow/core/platform/file_system_helper.h"
+#include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/s3/aws_crypto.h"
@@ -67,6 +69,9 @@ static const int kS3GetChildrenMaxKeys = 100;
 // Increasing the thread pool size since multiple downloads
 // and uploads can occur in parallel.
 static const int kExecutorPoolSize = 25;
+// The block cache of random access reads is disabled unless
+// S3_READ_CACHE_MAX_SIZE_MB is set, see S3FileSystem::S3FileSystem().
+static const uint64 kS3ReadCacheBlockSize = 16 * 1024 * 1024;  // 16 MB
 static const int kUploadRetries = 3;
 static const int kDownloadRetries = 3;
 static const char* kExecutorTag = "TransferManagerExecutor";
@@ -159,6 +164,17 @@ Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
       cfg.caPath = Aws::String(ca_path);
     }
 
+    // The maximum number of connections the client keeps open to S3, which
+    // bounds how many requests, including ranged reads, run concurrently.
+    const char* max_connections_str = getenv("S3_MAX_CONNECTIONS");
+    if (max_connections_str) {
+      int64 max_connections;
+      if (strings::safe_strto64(max_connections_str, &max_connections) &&
+          max_connections > 0) {
+        cfg.maxConnections = max_connections;
+      }
+    }
+
     init = true;
   }
 
@@ -234,12 +250,14 @@ class S3RandomAccessFile : public RandomAccessFile {
       const string& bucket, const string& object,
       const bool use_multi_part_download,
       std::shared_ptr<Aws::Transfer::TransferManager> transfer_manager,
-      std::shared_ptr<Aws::S3::S3Client> s3_client)
+      std::shared_ptr<Aws::S3::S3Client> s3_client,
+      FileBlockCache* file_block_cache = nullptr)
       : bucket_(bucket),
         object_(object),
         use_multi_part_download_(use_multi_part_download),
         transfer_manager_(transfer_manager),
-        s3_client_(s3_client) {}
+        s3_client_(s3_client),
+        file_block_cache_(file_block_cache) {}
 
   Status Name(StringPiece* result) const override {
     return errors::Unimplemented("S3RandomAccessFile does not support Name()");
@@ -249,6 +267,15 @@ class S3RandomAccessFile : public RandomAccessFile {
               char* scratch) const override {
     VLOG(1) << "ReadFilefromS3 s3://" << bucket_ << "/" << object_ << " from "
             << offset << " for n:" << n;
+    if (file_block_cache_ != nullptr) {
+      return ReadFileBlockCache(offset, n, result, scratch);
+    }
+    return ReadUncached(offset, n, result, scratch);
+  }
+
+  /// Reads from S3 directly, not through the block cache.
+  Status ReadUncached(uint64 offset, size_t n, StringPiece* result,
+                      char* scratch) const {
     if (use_multi_part_download_) {
       return ReadS3TransferManager(offset, n, result, scratch);
     } else {
@@ -256,6 +283,23 @@ class S3RandomAccessFile : public RandomAccessFile {
     }
   }
 
+  Status ReadFileBlockCache(uint64 offset, size_t n, StringPiece* result,
+                            char* scratch) const {
+    VLOG(3) << "Using FileBlockCache";
+    size_t bytes_transferred = 0;
+    Status status =
+        file_block_cache_->Read(strings::StrCat("s3://", bucket_, "/", object_),
+                                offset, n, scratch, &bytes_transferred);
+    *result = StringPiece(scratch, bytes_transferred);
+    TF_RETURN_IF_ERROR(status);
+    if (bytes_transferred < n) {
+      return errors::OutOfRange("EOF reached, ", bytes_transferred,
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
   Status ReadS3TransferManager(uint64 offset, size_t n, StringPiece* result,
                                char* scratch) const {
     VLOG(3) << "Using TransferManager";
@@ -342,6 +386,7 @@ class S3RandomAccessFile : public RandomAccessFile {
   std::shared_ptr<Aws::S3::S3Client> s3_client_;
   std::shared_ptr<Aws::Transfer::TransferManager> transfer_manager_;
   bool use_multi_part_download_;
+  FileBlockCache* file_block_cache_;  // Not owned.
 };
 
 class S3WritableFile : public WritableFile {
@@ -486,6 +531,58 @@ S3FileSystem::S3FileSystem()
     }
   }
 
+  executor_pool_size_ = kExecutorPoolSize;
+  const char* pool_size_str = getenv("S3_EXECUTOR_POOL_SIZE");
+  if (pool_size_str) {
+    int64 pool_size;
+    if (strings::safe_strto64(pool_size_str, &pool_size) && pool_size > 0) {
+      executor_pool_size_ = pool_size;
+    }
+  }
+
+  // The block cache for random access reads, as for GCS. It is only enabled
+  // if S3_READ_CACHE_MAX_SIZE_MB is set. Once a file is read sequentially,
+  // S3_READ_CACHE_READAHEAD_BLOCKS blocks past each read are fetched in
+  // parallel, with at most S3_READ_CACHE_MAX_READAHEAD_SIZE_MB in flight.
+  uint64 block_size = kS3ReadCacheBlockSize;
+  uint64 max_bytes = 0;
+  uint64 max_staleness = 0;
+  uint64 readahead_blocks = 0;
+  uint64 max_readahead_bytes = 0;
+  uint64 value;
+  const char* cache_str = getenv("S3_READ_CACHE_BLOCK_SIZE_MB");
+  if (cache_str && strings::safe_strtou64(cache_str, &value)) {
+    block_size = value * 1024 * 1024;
+  }
+  cache_str = getenv("S3_READ_CACHE_MAX_SIZE_MB");
+  if (cache_str && strings::safe_strtou64(cache_str, &value)) {
+    max_bytes = value * 1024 * 1024;
+  }
+  cache_str = getenv("S3_READ_CACHE_MAX_STALENESS");
+  if (cache_str && strings::safe_strtou64(cache_str, &value)) {
+    max_staleness = value;
+  }
+  cache_str = getenv("S3_READ_CACHE_READAHEAD_BLOCKS");
+  if (cache_str && strings::safe_strtou64(cache_str, &value)) {
+    readahead_blocks = value;
+  }
+  max_readahead_bytes = readahead_blocks * block_size;
+  cache_str = getenv("S3_READ_CACHE_MAX_READAHEAD_SIZE_MB");
+  if (cache_str && strings::safe_strtou64(cache_str, &value)) {
+    max_readahead_bytes = value * 1024 * 1024;
+  }
+  file_block_cache_.reset(new RamFileBlockCache(
+      block_size, max_bytes, max_staleness,
+      [this](const string& filename, size_t offset, size_t n, char* buffer,
+             size_t* bytes_transferred) {
+        return LoadBufferFromS3(filename, offset, n, buffer,
+                                bytes_transferred);
+      },
+      readahead_blocks, max_readahead_bytes));
+  if (!file_block_cache_->IsCacheEnabled()) {
+    file_block_cache_.reset();
+  }
+
   auto upload_pair = std::pair<Aws::Transfer::TransferDirection,
                                std::shared_ptr<Aws::Transfer::TransferManager>>(
       Aws::Transfer::TransferDirection::UPLOAD,
@@ -550,7 +647,7 @@ S3FileSystem::GetTransferManager(
     config.bufferSize = this->multi_part_chunk_size_[direction];
     // must be larger than pool size * multi part chunk size
     config.transferBufferMaxHeapSize =
-        (kExecutorPoolSize + 1) * this->multi_part_chunk_size_[direction];
+        (executor_pool_size_ + 1) * this->multi_part_chunk_size_[direction];
     this->transfer_managers_[direction] =
         Aws::Transfer::TransferManager::Create(config);
   }
@@ -562,7 +659,7 @@ S3FileSystem::GetExecutor() {
   if (this->executor_.get() == nullptr) {
     this->executor_ =
         Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(
-            kExecutorTag, kExecutorPoolSize);
+            kExecutorTag, executor_pool_size_);
   }
   return this->executor_;
 }
@@ -581,18 +678,68 @@ Status S3FileSystem::NewRandomAccessFile(
 
   // check if an override was defined for this file. used for testing
   bool use_mpd = this->use_multi_part_download_ && use_multi_part_download;
+  if (file_block_cache_ != nullptr) {
+    // Drop the cached blocks of the file if it changed since they were read.
+    Aws::S3::Model::HeadObjectRequest headObjectRequest;
+    headObjectRequest.WithBucket(bucket.c_str()).WithKey(object.c_str());
+    headObjectRequest.SetResponseStreamFactory([]() {
+      return Aws::New<Aws::StringStream>(kS3FileSystemAllocationTag);
+    });
+    auto headObjectOutcome = this->GetS3Client()->HeadObject(headObjectRequest);
+    if (headObjectOutcome.IsSuccess()) {
+      const Aws::String& etag = headObjectOutcome.GetResult().GetETag();
+      file_block_cache_->ValidateAndUpdateFileSignature(
+          strings::StrCat("s3://", bucket, "/", object),
+          Hash64(etag.data(), etag.size()));
+    }
+  }
   result->reset(new S3RandomAccessFile(
       bucket, object, use_mpd,
       this->GetTransferManager(Aws::Transfer::TransferDirection::DOWNLOAD),
-      this->GetS3Client()));
+      this->GetS3Client(), file_block_cache_.get()));
   return Status::OK();
 }
 
+Status S3FileSystem::LoadBufferFromS3(const string& fname, size_t offset,
+                                      size_t n, char* buffer,
+                                      size_t* bytes_transferred) {
+  string bucket, object;
+  TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
+  S3RandomAccessFile file(
+      bucket, object, use_multi_part_download_,
+      this->GetTransferManager(Aws::Transfer::TransferDirection::DOWNLOAD),
+      this->GetS3Client());
+  StringPiece result;
+  Status status = file.ReadUncached(offset, n, &result, buffer);
+  *bytes_transferred = result.size();
+  // Reads past the end of the file are not an error for the block cache.
+  if (status.code() == error::OUT_OF_RANGE) {
+    return Status::OK();
+  }
+  return status;
+}
+
+void S3FileSystem::FlushCaches(TransactionToken* token) {
+  if (file_block_cache_ != nullptr) {
+    file_block_cache_->Flush();
+  }
+}
+
+void S3FileSystem::ClearFileCaches(const string& fname) {
+  string bucket, object;
+  if (file_block_cache_ != nullptr &&
+      ParseS3Path(fname, false, &bucket, &object).ok()) {
+    file_block_cache_->RemoveFile(
+        strings::StrCat("s3://", bucket, "/", object));
+  }
+}
+
 Status S3FileSystem::NewWritableFile(const string& fname,
                                      TransactionToken* token,
                                      std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseS3Path(fname, false, &bucket, &object));
+  ClearFileCaches(fname);
   result->reset(new S3WritableFile(
       bucket, object,
       this->GetTransferManager(Aws::Transfer::TransferDirection::UPLOAD),
@@ -789,6 +936,7 @@ Status S3FileSystem::DeleteFile(const string& fname, TransactionToken* token) {
   if (!deleteObjectOutcome.IsSuccess()) {
     return CreateStatusFromAwsError(deleteObjectOutcome.GetError());
   }
+  ClearFileCaches(fname);
   return Status::OK();
 }
 
@@ -1187,6 +1335,8 @@ Status S3FileSystem::RenameFile(const string& src, const string& target,
     listObjectsRequest.SetMarker(listObjectsResult.GetNextMarker());
   } while (listObjectsResult.GetIsTruncated());
 
+  ClearFileCaches(src);
+  ClearFileCaches(target);
   return Status::OK();
 }
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include <aws/s3/model/CompletedMultipartUpload.h>
 #include <aws/transfer/TransferManager.h>
 
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/retrying_file_system.h"
@@ -94,6 +95,8 @@ class S3FileSystem : public FileSystem {
 
   Status HasAtomicMove(const string& path, bool* has_atomic_move) override;
 
+  void FlushCaches(TransactionToken* token) override;
+
  private:
   // Returns the member S3 client, initializing as-needed.
   // When the client tries to access the object in S3, e.g.,
@@ -151,6 +154,21 @@ class S3FileSystem : public FileSystem {
   std::map<Aws::Transfer::TransferDirection, uint64> multi_part_chunk_size_;
 
   bool use_multi_part_download_;
+
+  // Number of threads of the executor used by the transfer managers, from
+  // S3_EXECUTOR_POOL_SIZE.
+  int executor_pool_size_;
+
+  // Loads the bytes [offset, offset + n) of `fname` into `buffer` for the
+  // block cache.
+  Status LoadBufferFromS3(const string& fname, size_t offset, size_t n,
+                          char* buffer, size_t* bytes_transferred);
+
+  // Drops the cached blocks of `fname`.
+  void ClearFileCaches(const string& fname);
+
+  // Block cache of random access reads, null unless enabled.
+  std::unique_ptr<FileBlockCache> file_block_cache_;
 };
 
 /// S3 implementation of a file system with retry on failures.
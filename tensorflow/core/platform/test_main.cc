@@ -24,6 +24,7 @@ limitations under the License.
 // main() is supplied by gunit_main
 #else
 
+#include <cstdlib>
 #include <iostream>
 
 #include "absl/strings/match.h"
@@ -36,6 +37,12 @@ GTEST_API_ int main(int argc, char** argv) {
 
   tensorflow::testing::InstallStacktraceHandler();
   testing::InitGoogleTest(&argc, argv);
+  for (int i = 1; i < argc; i++) {
+    if (absl::StartsWith(argv[i], "--benchmark_repetitions=")) {
+      tensorflow::testing::Benchmark::SetRepetitions(
+          std::atoi(argv[i] + strlen("--benchmark_repetitions=")));
+    }
+  }
   for (int i = 1; i < argc; i++) {
     if (absl::StartsWith(argv[i], "--benchmarks=")) {
       const char* pattern = argv[i] + strlen("--benchmarks=");
@@ -68,4 +68,19 @@ uint64 EnvTime::NowNanos() {
       .count();
 }
 
+uint64 EnvTime::ThreadCpuNanos() {
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time,
+                      &kernel_time, &user_time)) {
+    return 0;
+  }
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernel_time.dwLowDateTime;
+  kernel.HighPart = kernel_time.dwHighDateTime;
+  user.LowPart = user_time.dwLowDateTime;
+  user.HighPart = user_time.dwHighDateTime;
+  // FILETIME durations are in 100 nano-second units.
+  return (kernel.QuadPart + user.QuadPart) * 100;
+}
+
 }  // namespace tensorflow
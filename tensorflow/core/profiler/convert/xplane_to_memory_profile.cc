@@ -82,10 +82,19 @@ void UpdateProfileSummary(const MemoryAggregationStats& stats,
 MemoryProfile GenerateMemoryProfile(const XPlane* host_trace) {
   XPlaneVisitor plane = CreateTfXPlaneVisitor(host_trace);
   MemoryProfile memory_profile;
+  // If the memory timeline was recorded, it covers every allocation of the
+  // wrapped allocators, so the events traced by the allocators themselves are
+  // ignored to avoid counting them twice.
+  bool has_memory_timeline = false;
+  plane.ForEachLine([&](const XLineVisitor& line) {
+    if (line.Name() == kMemoryTimelineLineName) has_memory_timeline = true;
+  });
   // Iterate over all XEvents in the XPlane, and add the XStats to a new
   // MemoryProfileSnapshot if the EventType is kMemoryAllocation or
   // kMemoryDeallocation.
   plane.ForEachLine([&](const XLineVisitor& line) {
+    const bool is_memory_timeline = line.Name() == kMemoryTimelineLineName;
+    if (has_memory_timeline && !is_memory_timeline) return;
     line.ForEachEvent([&](const XEventVisitor& event) {
       int64 event_type = event.Type().value_or(kUnknownHostEventType);
       if (!(IsMemoryAllocation(event_type) ||
@@ -143,6 +152,11 @@ MemoryProfile GenerateMemoryProfile(const XPlane* host_trace) {
           case StatType::kGroupId:
             metadata.set_step_id(stat.IntValue());
             break;
+          case StatType::kStepId:
+            // Events of the memory timeline are not grouped, but carry the
+            // step id of the allocating op.
+            if (is_memory_timeline) metadata.set_step_id(stat.IntValue());
+            break;
           case StatType::kRegionType:
             metadata.set_region_type(std::string(stat.StrOrRefValue()));
             break;
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
 #include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
 #include "tensorflow/core/profiler/lib/profiler_factory.h"
 #include "tensorflow/core/profiler/lib/profiler_interface.h"
 #include "tensorflow/core/profiler/profiler_options.pb.h"
@@ -69,6 +70,9 @@ class HostTracer : public ProfilerInterface {
   // Timestamp at the start of tracing.
   uint64 start_timestamp_ns_ = 0;
 
+  // Timestamp at the end of tracing.
+  uint64 stop_timestamp_ns_ = 0;
+
   // Container of all traced events.
   TraceMeRecorder::Events events_;
 };
@@ -99,6 +103,7 @@ Status HostTracer::Stop() {
     return errors::Internal("TraceMeRecorder not started");
   }
   events_ = TraceMeRecorder::Stop();
+  stop_timestamp_ns_ = GetCurrentTimeNanos();
   recording_ = false;
   return Status::OK();
 }
@@ -153,6 +158,10 @@ Status HostTracer::CollectData(XSpace* space) {
   XPlane* plane = FindOrAddMutablePlaneWithName(space, kHostThreadsPlaneName);
   ConvertCompleteEventsToXPlane(start_timestamp_ns_, std::exchange(events_, {}),
                                 plane);
+  if (MemoryTimeline* memory_timeline = MemoryTimeline::Get()) {
+    memory_timeline->ExportToXPlane(start_timestamp_ns_, stop_timestamp_ns_,
+                                    plane);
+  }
   return Status::OK();
 }
 
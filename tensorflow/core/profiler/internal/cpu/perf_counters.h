@@ -0,0 +1,83 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_PERF_COUNTERS_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_PERF_COUNTERS_H_
+
+#include <atomic>
+#include <string>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+
+class PerfCounterSource;
+
+namespace internal {
+
+// Active source of hardware performance counters, or nullptr.
+// Static atomic so PerfCounters::Source can be fast and non-blocking.
+TF_EXPORT extern std::atomic<PerfCounterSource*> g_perf_counter_source;
+
+}  // namespace internal
+
+// Hardware performance counter values of one thread at one point in time.
+struct PerfCounterValues {
+  static constexpr int kMaxCounters = 4;
+
+  int num_counters = 0;
+  uint64 values[kMaxCounters] = {};
+};
+
+// A backend that reads hardware performance counters of the calling thread,
+// e.g. through Linux perf_event.
+class PerfCounterSource {
+ public:
+  virtual ~PerfCounterSource() = default;
+
+  // Reads the counters of the calling thread. Returns false if they are not
+  // available on this thread.
+  virtual bool Read(PerfCounterValues* values) = 0;
+
+  // Returns the counter increments from `start` to `end`, both read on the
+  // same thread, encoded as TraceMe metadata ("#key=value,...#").
+  virtual std::string EncodeDelta(const PerfCounterValues& start,
+                                  const PerfCounterValues& end) = 0;
+};
+
+// Registry of the active PerfCounterSource. Kernel TraceMes (see
+// AnnotatedTraceMe) read the counters at their start and end and attach the
+// increments as metadata, which become stats of the op events in the XPlane.
+class PerfCounters {
+ public:
+  // Sets the active source, or disables counters if `source` is nullptr.
+  // `source` must outlive all uses, i.e. stay alive for the rest of the
+  // process, as readers may still be using a previous source.
+  static void SetSource(PerfCounterSource* source) {
+    internal::g_perf_counter_source.store(source, std::memory_order_release);
+  }
+
+  // Returns the active source, or nullptr. Cheap.
+  static PerfCounterSource* Source() {
+    return internal::g_perf_counter_source.load(std::memory_order_acquire);
+  }
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_PERF_COUNTERS_H_
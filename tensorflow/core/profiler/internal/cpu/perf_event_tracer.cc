@@ -0,0 +1,220 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
+#include "tensorflow/core/profiler/lib/profiler_factory.h"
+#include "tensorflow/core/profiler/lib/profiler_interface.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow/core/profiler/profiler_options.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+#if defined(PLATFORM_POSIX) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define TF_PROFILER_HAS_PERF_EVENT 1
+#endif
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+#if defined(TF_PROFILER_HAS_PERF_EVENT)
+
+// Size of the memory transfer caused by a last level cache miss.
+constexpr uint64 kCacheLineBytes = 64;
+
+// Counters of a group, in the order they are read. The group leader comes
+// first. Only the leading kNumRequiredCounters must be supported.
+constexpr uint64 kCounterConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+constexpr int kNumCounters = sizeof(kCounterConfigs) / sizeof(uint64);
+constexpr int kNumRequiredCounters = 2;
+static_assert(kNumCounters <= PerfCounterValues::kMaxCounters,
+              "Too many counters");
+
+int OpenCounter(uint64 config, int group_fd) {
+  struct perf_event_attr attr = {};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  // Only count user space, so that the default perf_event_paranoid setting
+  // is sufficient.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, /*pid=*/0,
+                                  /*cpu=*/-1, group_fd, /*flags=*/0));
+}
+
+// A perf_event counter group that counts the thread which opened it.
+class ThreadCounterGroup {
+ public:
+  ThreadCounterGroup() {
+    for (uint64 config : kCounterConfigs) {
+      int fd = OpenCounter(config, num_counters_ == 0 ? -1 : fds_[0]);
+      if (fd < 0) break;
+      fds_[num_counters_++] = fd;
+    }
+    if (num_counters_ < kNumRequiredCounters) Close();
+  }
+
+  ~ThreadCounterGroup() { Close(); }
+
+  bool ok() const { return num_counters_ > 0; }
+
+  bool Read(PerfCounterValues* values) const {
+    if (!ok()) return false;
+    // With PERF_FORMAT_GROUP, the number of counters precedes their values.
+    uint64 buffer[1 + kNumCounters];
+    const ssize_t size = (1 + num_counters_) * sizeof(uint64);
+    if (read(fds_[0], buffer, size) != size) return false;
+    values->num_counters = num_counters_;
+    for (int i = 0; i < num_counters_; ++i) values->values[i] = buffer[i + 1];
+    return true;
+  }
+
+ private:
+  void Close() {
+    for (int i = 0; i < num_counters_; ++i) close(fds_[i]);
+    num_counters_ = 0;
+  }
+
+  int fds_[kNumCounters];
+  int num_counters_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ThreadCounterGroup);
+};
+
+// Reads the cycles, instructions and last level cache misses of each thread.
+// The counter group of a thread is opened on its first read and stays open
+// until the thread exits, so threads that keep executing kernels only pay
+// for the group once.
+class PerfEventCounterSource : public PerfCounterSource {
+ public:
+  // Returns the process-wide instance, which is never destroyed.
+  static PerfEventCounterSource* Get() {
+    static PerfEventCounterSource* source = new PerfEventCounterSource();
+    return source;
+  }
+
+  bool Read(PerfCounterValues* values) override {
+    static thread_local ThreadCounterGroup group;
+    return group.Read(values);
+  }
+
+  std::string EncodeDelta(const PerfCounterValues& start,
+                          const PerfCounterValues& end) override {
+    auto delta = [&](int i) { return end.values[i] - start.values[i]; };
+    if (end.num_counters <= 2) {
+      return TraceMeEncode(
+          {{"cpu_cycles", delta(0)}, {"cpu_instructions", delta(1)}});
+    }
+    return TraceMeEncode({{"cpu_cycles", delta(0)},
+                          {"cpu_instructions", delta(1)},
+                          {"llc_misses", delta(2)},
+                          {"llc_miss_bytes", delta(2) * kCacheLineBytes}});
+  }
+
+ private:
+  PerfEventCounterSource() = default;
+};
+
+#endif  // TF_PROFILER_HAS_PERF_EVENT
+
+// This profiler enables the hardware performance counters of kernel
+// TraceMes. The counter increments become stats of the op events recorded by
+// the HostTracer, so it doesn't produce any data itself.
+class PerfEventTracer : public ProfilerInterface {
+ public:
+  PerfEventTracer() = default;
+  ~PerfEventTracer() override { Stop().IgnoreError(); }
+
+  Status Start() override;
+  Status Stop() override;
+
+  Status CollectData(RunMetadata* run_metadata) override {
+    return Status::OK();
+  }
+  Status CollectData(XSpace* space) override { return Status::OK(); }
+
+ private:
+  bool started_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PerfEventTracer);
+};
+
+Status PerfEventTracer::Start() {
+  if (started_) {
+    return errors::Internal("PerfEventTracer already started");
+  }
+#if defined(TF_PROFILER_HAS_PERF_EVENT)
+  PerfEventCounterSource* source = PerfEventCounterSource::Get();
+  PerfCounterValues values;
+  if (!source->Read(&values)) {
+    return errors::Unavailable(
+        "Hardware performance counters are not available through "
+        "perf_event_open; check /proc/sys/kernel/perf_event_paranoid.");
+  }
+  VLOG(1) << __FUNCTION__;
+  PerfCounters::SetSource(source);
+  started_ = true;
+  return Status::OK();
+#else
+  return errors::Unimplemented(
+      "Hardware performance counters are only supported on Linux.");
+#endif
+}
+
+Status PerfEventTracer::Stop() {
+  if (!started_) {
+    return errors::Internal("PerfEventTracer not started");
+  }
+  VLOG(1) << __FUNCTION__;
+  PerfCounters::SetSource(nullptr);
+  started_ = false;
+  return Status::OK();
+}
+
+}  // namespace
+
+// Not in anonymous namespace for testing purposes.
+std::unique_ptr<ProfilerInterface> CreatePerfEventTracer(
+    const ProfileOptions& options) {
+  if (options.perf_counter_level() == 0) return nullptr;
+  return absl::make_unique<PerfEventTracer>();
+}
+
+auto register_perf_event_tracer_factory = [] {
+  RegisterProfilerFactory(&CreatePerfEventTracer);
+  return 0;
+}();
+
+}  // namespace profiler
+}  // namespace tensorflow
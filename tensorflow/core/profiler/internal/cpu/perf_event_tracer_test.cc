@@ -0,0 +1,123 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
+#include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/annotated_traceme.h"
+#include "tensorflow/core/profiler/lib/profiler_interface.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow/core/profiler/profiler_options.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+std::unique_ptr<ProfilerInterface> CreatePerfEventTracer(
+    const ProfileOptions& options);
+
+namespace {
+
+// Counts 100 cycles and 10 instructions per read.
+class FakeCounterSource : public PerfCounterSource {
+ public:
+  bool Read(PerfCounterValues* values) override {
+    ++num_reads_;
+    values->num_counters = 2;
+    values->values[0] = num_reads_ * 100;
+    values->values[1] = num_reads_ * 10;
+    return true;
+  }
+
+  std::string EncodeDelta(const PerfCounterValues& start,
+                          const PerfCounterValues& end) override {
+    return TraceMeEncode(
+        {{"cpu_cycles", end.values[0] - start.values[0]},
+         {"cpu_instructions", end.values[1] - start.values[1]}});
+  }
+
+ private:
+  uint64 num_reads_ = 0;
+};
+
+// Returns the names of the complete events recorded on the current thread.
+std::vector<std::string> CompleteEventNames(TraceMeRecorder::Events events) {
+  std::vector<std::string> names;
+  for (const auto& thread : events) {
+    for (const auto& event : thread.events) {
+      if (event.IsComplete()) names.push_back(event.name);
+    }
+  }
+  return names;
+}
+
+TEST(PerfEventTracerTest, AnnotatedTraceMeAppendsCounterDeltas) {
+  // Sources must outlive their use.
+  static FakeCounterSource* source = new FakeCounterSource();
+
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1));
+  { AnnotatedTraceMe activity([] { return "untraced:Op"; }); }
+  PerfCounters::SetSource(source);
+  { AnnotatedTraceMe activity([] { return "MatMul:MatMul"; }); }
+  PerfCounters::SetSource(nullptr);
+  std::vector<std::string> names =
+      CompleteEventNames(TraceMeRecorder::Stop());
+
+  ASSERT_EQ(names.size(), 2);
+  EXPECT_EQ(names[0], "untraced:Op");
+  EXPECT_EQ(names[1], "MatMul:MatMul#cpu_cycles=100,cpu_instructions=10#");
+}
+
+TEST(PerfEventTracerTest, DisabledByDefault) {
+  ProfileOptions options;
+  EXPECT_EQ(CreatePerfEventTracer(options), nullptr);
+  options.set_perf_counter_level(1);
+  EXPECT_NE(CreatePerfEventTracer(options), nullptr);
+}
+
+TEST(PerfEventTracerTest, CollectsHardwareCounters) {
+  ProfileOptions options;
+  options.set_perf_counter_level(1);
+  std::unique_ptr<ProfilerInterface> tracer = CreatePerfEventTracer(options);
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1));
+  Status status = tracer->Start();
+  if (!status.ok()) {
+    TraceMeRecorder::Stop();
+    GTEST_SKIP() << status.ToString();
+  }
+  {
+    AnnotatedTraceMe activity([] { return "Sum:Sum"; });
+    volatile uint64 sum = 0;
+    for (int i = 0; i < 100000; ++i) sum += i;
+  }
+  TF_ASSERT_OK(tracer->Stop());
+  std::vector<std::string> names =
+      CompleteEventNames(TraceMeRecorder::Stop());
+
+  ASSERT_EQ(names.size(), 1);
+  EXPECT_TRUE(absl::StartsWith(names[0], "Sum:Sum#cpu_cycles="));
+  EXPECT_TRUE(absl::StrContains(names[0], "cpu_instructions="));
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
@@ -24,7 +24,10 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -302,6 +305,120 @@ class TraceMeRecorder::ThreadLocalRecorderWrapper {
   std::shared_ptr<TraceMeRecorder::ThreadLocalRecorder> recorder_;
 };
 
+// A fixed-size, open-addressing hash table of EventStatistics keyed by event
+// name. Add() is lock-free: slots are claimed with a compare-and-swap on the
+// name fingerprint and their counters are atomics, so threads recording the
+// same event only contend on its counters. Names that do not find a slot
+// within a few probes are dropped.
+class TraceMeRecorder::StatisticsTable {
+ public:
+  StatisticsTable() : slots_(new Slot[kNumSlots]) {}
+
+  void Add(absl::string_view name, uint64 duration_ns) {
+    // TraceMe metadata, e.g. step numbers, would give each event its own name.
+    name = name.substr(0, name.find('#'));
+    const uint64 fingerprint = Fingerprint64(name) | 1;  // 0 marks free slots
+    size_t index = fingerprint % kNumSlots;
+    for (int probe = 0; probe < kMaxProbes; ++probe) {
+      Slot& slot = slots_[index];
+      uint64 current = slot.fingerprint.load(std::memory_order_acquire);
+      if (current == 0 &&
+          slot.fingerprint.compare_exchange_strong(current, fingerprint,
+                                                   std::memory_order_acq_rel)) {
+        slot.name = std::string(name);
+        slot.named.store(true, std::memory_order_release);
+        slot.Add(duration_ns);
+        return;
+      }
+      if (current == fingerprint) {
+        slot.Add(duration_ns);
+        return;
+      }
+      index = (index + 1) % kNumSlots;
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Resets the counters. Names stay allocated to their slots.
+  void Clear() {
+    for (size_t i = 0; i < kNumSlots; ++i) slots_[i].Clear();
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+
+  std::vector<EventStatistics> Collect() const {
+    std::vector<EventStatistics> result;
+    for (size_t i = 0; i < kNumSlots; ++i) {
+      const Slot& slot = slots_[i];
+      if (!slot.named.load(std::memory_order_acquire)) continue;
+      EventStatistics stats;
+      stats.count = slot.count.load(std::memory_order_relaxed);
+      if (stats.count == 0) continue;
+      stats.name = slot.name;
+      stats.total_ns = slot.total_ns.load(std::memory_order_relaxed);
+      stats.min_ns = slot.min_ns.load(std::memory_order_relaxed);
+      stats.max_ns = slot.max_ns.load(std::memory_order_relaxed);
+      for (int b = 0; b < EventStatistics::kNumBuckets; ++b) {
+        stats.buckets[b] = slot.buckets[b].load(std::memory_order_relaxed);
+      }
+      result.push_back(std::move(stats));
+    }
+    const uint64 dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+      VLOG(1) << "Dropped statistics of " << dropped
+              << " events: too many distinct names";
+    }
+    return result;
+  }
+
+ private:
+  static constexpr size_t kNumSlots = 2048;
+  static constexpr int kMaxProbes = 16;
+
+  struct Slot {
+    void Add(uint64 duration_ns) {
+      count.fetch_add(1, std::memory_order_relaxed);
+      total_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+      const int bucket =
+          duration_ns == 0
+              ? 0
+              : std::min(EventStatistics::kNumBuckets - 1,
+                         Log2Floor64(duration_ns) + 1);
+      buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+      uint64 min = min_ns.load(std::memory_order_relaxed);
+      while (duration_ns < min &&
+             !min_ns.compare_exchange_weak(min, duration_ns,
+                                           std::memory_order_relaxed)) {
+      }
+      uint64 max = max_ns.load(std::memory_order_relaxed);
+      while (duration_ns > max &&
+             !max_ns.compare_exchange_weak(max, duration_ns,
+                                           std::memory_order_relaxed)) {
+      }
+    }
+
+    void Clear() {
+      count.store(0, std::memory_order_relaxed);
+      total_ns.store(0, std::memory_order_relaxed);
+      min_ns.store(kuint64max, std::memory_order_relaxed);
+      max_ns.store(0, std::memory_order_relaxed);
+      for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64> fingerprint{0};
+    // Set once `name` is written by the thread that claimed the slot.
+    std::atomic<bool> named{false};
+    std::string name;
+    std::atomic<uint64> count{0};
+    std::atomic<uint64> total_ns{0};
+    std::atomic<uint64> min_ns{kuint64max};
+    std::atomic<uint64> max_ns{0};
+    std::atomic<uint64> buckets[EventStatistics::kNumBuckets] = {};
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64> dropped_{0};
+};
+
 /*static*/ TraceMeRecorder* TraceMeRecorder::Get() {
   static TraceMeRecorder* singleton = new TraceMeRecorder;
   return singleton;
@@ -315,7 +432,7 @@ void TraceMeRecorder::RegisterThread(
 
 void TraceMeRecorder::UnregisterThread(uint32 tid) {
   // If tracing is active, keep the ThreadLocalRecorder alive.
-  if (Active()) return;
+  if (recording_.load(std::memory_order_acquire)) return;
   // If tracing is inactive, destroy the ThreadLocalRecorder.
   mutex_lock lock(mutex_);
   threads_.erase(tid);
@@ -363,21 +480,33 @@ TraceMeRecorder::Events TraceMeRecorder::Consume() {
   return result;
 }
 
+void TraceMeRecorder::UpdateTraceLevel() {
+  internal::g_trace_level.store(std::max(recording_level_, statistics_level_),
+                                std::memory_order_release);
+}
+
 bool TraceMeRecorder::StartRecording(int level) {
   level = std::max(0, level);
   mutex_lock lock(mutex_);
   // Change trace_level_ while holding mutex_.
-  int expected = kTracingDisabled;
-  bool started = internal::g_trace_level.compare_exchange_strong(
-      expected, level, std::memory_order_acq_rel);
-  if (started) {
-    // We may have old events in buffers because Record() raced with Stop().
-    Clear();
-  }
-  return started;
+  if (recording_level_ != kTracingDisabled) return false;
+  recording_level_ = level;
+  // We may have old events in buffers because Record() raced with Stop().
+  Clear();
+  recording_.store(true, std::memory_order_release);
+  UpdateTraceLevel();
+  return true;
 }
 
 void TraceMeRecorder::Record(Event&& event) {
+  TraceMeRecorder* recorder = Get();
+  if (recorder->statistics_.load(std::memory_order_acquire) &&
+      event.IsComplete()) {
+    const int64 duration_ns = event.end_time - event.start_time;
+    recorder->statistics_table_.load(std::memory_order_acquire)
+        ->Add(event.name, std::max<int64>(0, duration_ns));
+  }
+  if (!recorder->recording_.load(std::memory_order_acquire)) return;
   static thread_local ThreadLocalRecorderWrapper thread_local_recorder;
   thread_local_recorder.Record(std::move(event));
 }
@@ -386,13 +515,45 @@ TraceMeRecorder::Events TraceMeRecorder::StopRecording() {
   TraceMeRecorder::Events events;
   mutex_lock lock(mutex_);
   // Change trace_level_ while holding mutex_.
-  if (internal::g_trace_level.exchange(
-          kTracingDisabled, std::memory_order_acq_rel) != kTracingDisabled) {
+  if (recording_level_ != kTracingDisabled) {
+    recording_level_ = kTracingDisabled;
+    recording_.store(false, std::memory_order_release);
+    UpdateTraceLevel();
     events = Consume();
   }
   return events;
 }
 
+bool TraceMeRecorder::StartStatisticsCollection(int level) {
+  level = std::max(0, level);
+  mutex_lock lock(mutex_);
+  if (statistics_level_ != kTracingDisabled) return false;
+  StatisticsTable* table = statistics_table_.load(std::memory_order_relaxed);
+  if (table == nullptr) {
+    table = new StatisticsTable;
+    statistics_table_.store(table, std::memory_order_release);
+  }
+  table->Clear();
+  statistics_level_ = level;
+  statistics_.store(true, std::memory_order_release);
+  UpdateTraceLevel();
+  return true;
+}
+
+void TraceMeRecorder::StopStatisticsCollection() {
+  mutex_lock lock(mutex_);
+  statistics_level_ = kTracingDisabled;
+  statistics_.store(false, std::memory_order_release);
+  UpdateTraceLevel();
+}
+
+std::vector<TraceMeRecorder::EventStatistics>
+TraceMeRecorder::CollectStatistics() {
+  StatisticsTable* table = statistics_table_.load(std::memory_order_acquire);
+  if (table == nullptr) return {};
+  return table->Collect();
+}
+
 /*static*/ int64 TraceMeRecorder::NewActivityId() {
   // Activity IDs: To avoid contention over a counter, the top 32 bits identify
   // the originating thread, the bottom 32 bits name the event within a thread.
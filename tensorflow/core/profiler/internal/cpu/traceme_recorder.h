@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_TRACEME_RECORDER_H_
 #define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_TRACEME_RECORDER_H_
 
+#include <array>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -49,6 +50,11 @@ TF_EXPORT extern std::atomic<int> g_trace_level;
 // events. TraceMe::ActivityStart records start events, and TraceMe::ActivityEnd
 // records end events. The profiler then stops the recorder and finds start/end
 // pairs. (Unpaired start/end events are discarded at that point).
+//
+// Independently of recording, the recorder can aggregate the durations of
+// complete events into per-name statistics (StartStatistics()). This is much
+// cheaper than recording, as nothing is buffered, so it can stay on while
+// traces are recorded only occasionally.
 class TraceMeRecorder {
  public:
   // An Event is either the start of a TraceMe, the end of a TraceMe, or both.
@@ -80,6 +86,21 @@ class TraceMeRecorder {
   };
   using Events = std::vector<ThreadEvents>;
 
+  // Duration statistics of the complete events with a given name.
+  struct EventStatistics {
+    static constexpr int kNumBuckets = 40;
+
+    // Event name, without TraceMe metadata ("#key=value#").
+    std::string name;
+    uint64 count = 0;
+    uint64 total_ns = 0;
+    uint64 min_ns = 0;
+    uint64 max_ns = 0;
+    // Log2 histogram: buckets[0] counts events of 0ns, and buckets[i] events
+    // of [2^(i-1), 2^i) ns. The last bucket also counts longer events.
+    std::array<uint64, kNumBuckets> buckets = {};
+  };
+
   // Starts recording of TraceMe().
   // Only traces <= level will be recorded.
   // Level must be >= 0. If level is 0, no traces will be recorded.
@@ -89,7 +110,26 @@ class TraceMeRecorder {
   // Events passed to Record after Stop has started will be dropped.
   static Events Stop() { return Get()->StopRecording(); }
 
-  // Returns whether we're currently recording. Racy, but cheap!
+  // Starts aggregating the complete events of level <= `level` into
+  // statistics, until StopStatistics(). Clears the previous statistics.
+  // Returns false if statistics are already being aggregated.
+  // While both are on, recording and statistics use the higher of their
+  // levels.
+  static bool StartStatistics(int level) {
+    return Get()->StartStatisticsCollection(level);
+  }
+
+  // Stops aggregating statistics. The statistics remain available.
+  static void StopStatistics() { Get()->StopStatisticsCollection(); }
+
+  // Returns the statistics aggregated since the last StartStatistics(), in no
+  // particular order. Lock-free with respect to Record().
+  static std::vector<EventStatistics> GetStatistics() {
+    return Get()->CollectStatistics();
+  }
+
+  // Returns whether we're currently recording or aggregating statistics.
+  // Racy, but cheap!
   static inline bool Active(int level = 1) {
     return internal::g_trace_level.load(std::memory_order_acquire) >= level;
   }
@@ -106,6 +146,7 @@ class TraceMeRecorder {
  private:
   class ThreadLocalRecorder;
   class ThreadLocalRecorderWrapper;
+  class StatisticsTable;
 
   // Returns singleton.
   static TraceMeRecorder* Get();
@@ -120,6 +161,13 @@ class TraceMeRecorder {
   bool StartRecording(int level);
   Events StopRecording();
 
+  bool StartStatisticsCollection(int level);
+  void StopStatisticsCollection();
+  std::vector<EventStatistics> CollectStatistics();
+
+  // Sets g_trace_level from the recording and statistics levels.
+  void UpdateTraceLevel() TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Clears events from all active threads that were added due to Record
   // racing with StopRecording.
   void Clear() TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
@@ -137,6 +185,15 @@ class TraceMeRecorder {
   // stops so the events can be retrieved.
   absl::flat_hash_map<uint32, std::shared_ptr<ThreadLocalRecorder>> threads_
       TF_GUARDED_BY(mutex_);
+
+  int recording_level_ TF_GUARDED_BY(mutex_) = kTracingDisabled;
+  int statistics_level_ TF_GUARDED_BY(mutex_) = kTracingDisabled;
+  // Read by Record() without the lock.
+  std::atomic<bool> recording_{false};
+  std::atomic<bool> statistics_{false};
+  // Created by the first StartStatistics(), never destroyed since Record()
+  // may still be using it after StopStatistics().
+  std::atomic<StatisticsTable*> statistics_table_{nullptr};
 };
 
 }  // namespace profiler
@@ -186,6 +186,46 @@ TEST(RecorderTest, Multithreaded) {
   }
 }
 
+TEST(RecorderTest, Statistics) {
+  int64 start_time = GetCurrentTimeNanos();
+
+  TraceMeRecorder::Record({"before", start_time, start_time + 1});
+  ASSERT_TRUE(TraceMeRecorder::StartStatistics(/*level=*/1));
+  EXPECT_FALSE(TraceMeRecorder::StartStatistics(/*level=*/1));
+  EXPECT_TRUE(TraceMeRecorder::Active(1));
+  EXPECT_FALSE(TraceMeRecorder::Active(2));
+  TraceMeRecorder::Record({"op#step=1#", start_time, start_time + 100});
+  TraceMeRecorder::Record({"op#step=2#", start_time, start_time + 300});
+  // Split events are not aggregated.
+  TraceMeRecorder::Record({"split", start_time, -1});
+
+  // Recording does not interrupt the statistics.
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/2));
+  EXPECT_TRUE(TraceMeRecorder::Active(2));
+  TraceMeRecorder::Record({"op", start_time, start_time + 200});
+  auto events = TraceMeRecorder::Stop();
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_THAT(events[0].events, ElementsAre(Named("op")));
+  EXPECT_FALSE(TraceMeRecorder::Active(2));
+
+  TraceMeRecorder::StopStatistics();
+  EXPECT_FALSE(TraceMeRecorder::Active(1));
+  TraceMeRecorder::Record({"op", start_time, start_time + 1000});
+
+  auto statistics = TraceMeRecorder::GetStatistics();
+  ASSERT_EQ(statistics.size(), 1);
+  const TraceMeRecorder::EventStatistics& op = statistics[0];
+  EXPECT_EQ(op.name, "op");
+  EXPECT_EQ(op.count, 3);
+  EXPECT_EQ(op.total_ns, 600);
+  EXPECT_EQ(op.min_ns, 100);
+  EXPECT_EQ(op.max_ns, 300);
+  // 100ns and 200ns fall in [64, 128) and [128, 256), 300ns in [256, 512).
+  EXPECT_EQ(op.buckets[7], 1);
+  EXPECT_EQ(op.buckets[8], 1);
+  EXPECT_EQ(op.buckets[9], 1);
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
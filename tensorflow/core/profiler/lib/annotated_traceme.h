@@ -24,12 +24,18 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/profiler/internal/cpu/perf_counters.h"
+#endif
 
 namespace tensorflow {
 namespace profiler {
 
 // Combination of TraceMe and ScopedAnnotation which share the same label.
 // Optimization are done to ensure the label generation are done once.
+// While hardware performance counters are enabled (see PerfCounters), the
+// counter increments over the lifetime of the TraceMe are appended to it as
+// metadata.
 class AnnotatedTraceMe {
  public:
   template <typename NameGeneratorT>
@@ -44,11 +50,36 @@ class AnnotatedTraceMe {
       }
       if (TF_PREDICT_TRUE(traceme_enabled)) {
         trace_me_.emplace([&name] { return std::move(name); }, level);
+#if !defined(IS_MOBILE_PLATFORM)
+        perf_counter_source_ = PerfCounters::Source();
+        if (TF_PREDICT_FALSE(perf_counter_source_ != nullptr) &&
+            !perf_counter_source_->Read(&start_counters_)) {
+          perf_counter_source_ = nullptr;
+        }
+#endif
       }
     }
   }
 
+  ~AnnotatedTraceMe() {
+#if !defined(IS_MOBILE_PLATFORM)
+    if (TF_PREDICT_FALSE(perf_counter_source_ != nullptr)) {
+      PerfCounterValues end_counters;
+      if (perf_counter_source_->Read(&end_counters)) {
+        trace_me_->AppendMetadata([&] {
+          return perf_counter_source_->EncodeDelta(start_counters_,
+                                                   end_counters);
+        });
+      }
+    }
+#endif
+  }
+
  private:
+#if !defined(IS_MOBILE_PLATFORM)
+  PerfCounterSource* perf_counter_source_ = nullptr;
+  PerfCounterValues start_counters_;
+#endif
   absl::optional<TraceMe> trace_me_;
   absl::optional<ScopedAnnotation> scoped_annotation_;
 };
@@ -0,0 +1,163 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/utils/trace_utils.h"
+#include "tensorflow/core/profiler/utils/xplane_builder.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace profiler {
+
+/*static*/ MemoryTimeline* MemoryTimeline::Get() {
+  static MemoryTimeline* timeline = []() -> MemoryTimeline* {
+    int64 capacity = 0;
+    Status status = ReadInt64FromEnvVar("TF_MEMORY_TIMELINE_CAPACITY",
+                                        /*default_val=*/0, &capacity);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return nullptr;
+    }
+    if (capacity <= 0) return nullptr;
+    LOG(INFO) << "Recording the last " << capacity
+              << " allocations in the memory timeline.";
+    return new MemoryTimeline(capacity);
+  }();
+  return timeline;
+}
+
+MemoryTimeline::MemoryTimeline(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)) {
+  strings_.emplace_back();
+  string_ids_.emplace("", 0);
+}
+
+int32 MemoryTimeline::InternString(absl::string_view str) {
+  mutex_lock lock(strings_mu_);
+  auto it = string_ids_.find(str);
+  if (it != string_ids_.end()) return it->second;
+  const int32 id = strings_.size();
+  strings_.emplace_back(str);
+  string_ids_.emplace(strings_.back(), id);
+  return id;
+}
+
+std::string MemoryTimeline::GetString(int32 id) const {
+  tf_shared_lock lock(strings_mu_);
+  if (id < 0 || id >= static_cast<int32>(strings_.size())) return "";
+  return strings_[id];
+}
+
+void MemoryTimeline::Record(const MemoryTimelineRecord& record) {
+  mutex_lock lock(mu_);
+  if (records_.size() < capacity_) {
+    records_.push_back(record);
+    return;
+  }
+  records_[next_] = record;
+  next_ = (next_ + 1) % capacity_;
+  ++num_dropped_;
+}
+
+std::vector<MemoryTimelineRecord> MemoryTimeline::GetRecords() const {
+  tf_shared_lock lock(mu_);
+  std::vector<MemoryTimelineRecord> records;
+  records.reserve(records_.size());
+  records.insert(records.end(), records_.begin() + next_, records_.end());
+  records.insert(records.end(), records_.begin(), records_.begin() + next_);
+  return records;
+}
+
+uint64 MemoryTimeline::num_dropped() const {
+  tf_shared_lock lock(mu_);
+  return num_dropped_;
+}
+
+void MemoryTimeline::ExportToXPlane(uint64 start_time_ns, uint64 end_time_ns,
+                                    XPlane* raw_plane) const {
+  std::vector<MemoryTimelineRecord> records = GetRecords();
+  // Records from different threads may be slightly out of order.
+  std::stable_sort(records.begin(), records.end(),
+                   [](const MemoryTimelineRecord& a,
+                      const MemoryTimelineRecord& b) {
+                     return a.timestamp_ns < b.timestamp_ns;
+                   });
+
+  XPlaneBuilder plane(raw_plane);
+  XLineBuilder line = plane.GetOrCreateLine(kThreadIdMemoryTimeline);
+  line.SetName(kMemoryTimelineLineName);
+  line.SetTimestampNs(start_time_ns);
+  const XEventMetadata& allocation = *plane.GetOrCreateEventMetadata(
+      GetHostEventTypeStr(HostEventType::kMemoryAllocation));
+  const XEventMetadata& deallocation = *plane.GetOrCreateEventMetadata(
+      GetHostEventTypeStr(HostEventType::kMemoryDeallocation));
+  auto stat = [&plane](StatType type) -> const XStatMetadata& {
+    return *plane.GetOrCreateStatMetadata(GetStatTypeStr(type));
+  };
+  // Strings are stored once in the plane and referenced by the events.
+  auto ref = [this, &plane](int32 id) -> const XStatMetadata& {
+    return *plane.GetOrCreateStatMetadata(GetString(id));
+  };
+  const XStatMetadata& allocator_name = stat(StatType::kAllocatorName);
+  const XStatMetadata& bytes_allocated = stat(StatType::kBytesAllocated);
+  const XStatMetadata& peak_bytes_in_use = stat(StatType::kPeakBytesInUse);
+  const XStatMetadata& requested_bytes = stat(StatType::kRequestedBytes);
+  const XStatMetadata& allocation_bytes = stat(StatType::kAllocationBytes);
+  const XStatMetadata& address = stat(StatType::kAddress);
+  const XStatMetadata& tf_op = stat(StatType::kTfOp);
+  const XStatMetadata& step_id = stat(StatType::kStepId);
+  const XStatMetadata& shape = stat(StatType::kTensorShapes);
+  const XStatMetadata& data_type = stat(StatType::kDataType);
+
+  // The peak is tracked over all the records, including those before the
+  // exported window.
+  absl::flat_hash_map<int32, int64> peak_by_allocator;
+  for (const MemoryTimelineRecord& record : records) {
+    int64& peak = peak_by_allocator[record.allocator_id];
+    peak = std::max(peak, record.bytes_in_use);
+    if (record.timestamp_ns < start_time_ns ||
+        record.timestamp_ns > end_time_ns) {
+      continue;
+    }
+    XEventBuilder event =
+        line.AddEvent(record.bytes >= 0 ? allocation : deallocation);
+    event.SetTimestampNs(record.timestamp_ns);
+    const int64 num_bytes = std::abs(record.bytes);
+    event.AddStatValue(allocator_name, ref(record.allocator_id));
+    event.AddStatValue(bytes_allocated, record.bytes_in_use);
+    event.AddStatValue(peak_bytes_in_use, peak);
+    event.AddStatValue(requested_bytes, num_bytes);
+    event.AddStatValue(allocation_bytes, num_bytes);
+    event.AddStatValue(address, static_cast<int64>(record.address));
+    if (record.op_name_id != 0) {
+      event.AddStatValue(tf_op, ref(record.op_name_id));
+    }
+    event.AddStatValue(step_id, record.step_id);
+    if (record.shape_id != 0) {
+      event.AddStatValue(shape, ref(record.shape_id));
+    }
+    event.AddStatValue(data_type, record.data_type);
+  }
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
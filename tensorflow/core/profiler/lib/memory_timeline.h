@@ -0,0 +1,111 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_MEMORY_TIMELINE_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_MEMORY_TIMELINE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// An allocation or a deallocation recorded in a MemoryTimeline.
+struct MemoryTimelineRecord {
+  uint64 timestamp_ns = 0;
+  uint64 address = 0;
+  // Number of bytes allocated (positive) or freed (negative).
+  int64 bytes = 0;
+  // Number of bytes in use in the allocator after this event.
+  int64 bytes_in_use = 0;
+  // Step id of the op that allocated the memory.
+  int64 step_id = 0;
+  // Ids returned by MemoryTimeline::InternString(). 0 is the empty string.
+  int32 allocator_id = 0;
+  int32 op_name_id = 0;
+  int32 shape_id = 0;
+  // DataType of the tensor the memory was allocated for, or DT_INVALID.
+  int32 data_type = 0;
+};
+
+// Records every allocation and deallocation of the allocators wrapped by a
+// MemoryTimelineAllocator into a fixed-size ring buffer. The records are
+// attributed to the op, step and tensor shape of the allocation (see
+// ScopedMemoryDebugAnnotation), so that the ops holding memory at the peak can
+// be identified once the records are exported to an XPlane.
+//
+// Strings are interned so that a record has a fixed, small size. When the
+// buffer is full, the oldest records are overwritten.
+//
+// Thread-safe.
+class MemoryTimeline {
+ public:
+  // Returns the process-wide timeline, or nullptr if the memory timeline is
+  // disabled. It is enabled by setting the environment variable
+  // TF_MEMORY_TIMELINE_CAPACITY to the number of records to keep.
+  static MemoryTimeline* Get();
+
+  explicit MemoryTimeline(size_t capacity);
+
+  // Returns a small id identifying `str` in the records.
+  int32 InternString(absl::string_view str) TF_LOCKS_EXCLUDED(strings_mu_);
+
+  // Returns the string interned with the given id.
+  std::string GetString(int32 id) const TF_LOCKS_EXCLUDED(strings_mu_);
+
+  void Record(const MemoryTimelineRecord& record) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the records in the buffer, oldest first.
+  std::vector<MemoryTimelineRecord> GetRecords() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of records overwritten because the buffer was full.
+  uint64 num_dropped() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Adds the records in [start_time_ns, end_time_ns] to `plane`, as
+  // MemoryAllocation and MemoryDeallocation events on a line named
+  // kMemoryTimelineLineName. The events carry the same stats as the events of
+  // the BFC allocator, so the memory profile can be computed from them.
+  void ExportToXPlane(uint64 start_time_ns, uint64 end_time_ns,
+                      XPlane* plane) const;
+
+ private:
+  const size_t capacity_;
+
+  mutable mutex mu_;
+  std::vector<MemoryTimelineRecord> records_ TF_GUARDED_BY(mu_);
+  // Index of the slot the next record is written to, once the buffer is full.
+  size_t next_ TF_GUARDED_BY(mu_) = 0;
+  uint64 num_dropped_ TF_GUARDED_BY(mu_) = 0;
+
+  mutable mutex strings_mu_;
+  absl::flat_hash_map<std::string, int32> string_ids_
+      TF_GUARDED_BY(strings_mu_);
+  std::vector<std::string> strings_ TF_GUARDED_BY(strings_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryTimeline);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_MEMORY_TIMELINE_H_
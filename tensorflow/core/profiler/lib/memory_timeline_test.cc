@@ -0,0 +1,111 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/memory_timeline.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_visitor.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+MemoryTimelineRecord MakeRecord(uint64 timestamp_ns, int64 bytes) {
+  MemoryTimelineRecord record;
+  record.timestamp_ns = timestamp_ns;
+  record.bytes = bytes;
+  return record;
+}
+
+TEST(MemoryTimelineTest, InternsStrings) {
+  MemoryTimeline timeline(/*capacity=*/4);
+  EXPECT_EQ(timeline.InternString(""), 0);
+  const int32 id = timeline.InternString("MatMul");
+  EXPECT_NE(id, 0);
+  EXPECT_EQ(timeline.InternString("MatMul"), id);
+  EXPECT_NE(timeline.InternString("Conv2D"), id);
+  EXPECT_EQ(timeline.GetString(id), "MatMul");
+}
+
+TEST(MemoryTimelineTest, OverwritesOldestRecords) {
+  MemoryTimeline timeline(/*capacity=*/3);
+  for (int i = 1; i <= 5; ++i) {
+    timeline.Record(MakeRecord(/*timestamp_ns=*/i, /*bytes=*/i));
+  }
+  std::vector<MemoryTimelineRecord> records = timeline.GetRecords();
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_EQ(records[0].timestamp_ns, 3);
+  EXPECT_EQ(records[1].timestamp_ns, 4);
+  EXPECT_EQ(records[2].timestamp_ns, 5);
+  EXPECT_EQ(timeline.num_dropped(), 2);
+}
+
+TEST(MemoryTimelineTest, ExportsRecordsInWindow) {
+  MemoryTimeline timeline(/*capacity=*/16);
+  MemoryTimelineRecord record = MakeRecord(/*timestamp_ns=*/100, 64);
+  record.bytes_in_use = 1024;
+  timeline.Record(record);
+  record = MakeRecord(/*timestamp_ns=*/200, 256);
+  record.allocator_id = timeline.InternString("cpu");
+  record.op_name_id = timeline.InternString("MatMul");
+  record.step_id = 3;
+  record.bytes_in_use = 512;
+  timeline.Record(record);
+  record.timestamp_ns = 300;
+  record.bytes = -256;
+  record.bytes_in_use = 256;
+  timeline.Record(record);
+
+  XPlane raw_plane;
+  timeline.ExportToXPlane(/*start_time_ns=*/150, /*end_time_ns=*/300,
+                          &raw_plane);
+  XPlaneVisitor plane(&raw_plane);
+  ASSERT_EQ(raw_plane.lines_size(), 1);
+  std::vector<std::string> event_names;
+  std::vector<absl::flat_hash_map<std::string, std::string>> event_stats;
+  plane.ForEachLine([&](const XLineVisitor& line) {
+    EXPECT_EQ(line.Name(), kMemoryTimelineLineName);
+    line.ForEachEvent([&](const XEventVisitor& event) {
+      event_names.emplace_back(event.Name());
+      auto& stats = event_stats.emplace_back();
+      event.ForEachStat([&](const XStatVisitor& stat) {
+        stats[stat.Name()] = stat.ToString();
+      });
+    });
+  });
+  EXPECT_EQ(event_names,
+            std::vector<std::string>({"MemoryAllocation",
+                                      "MemoryDeallocation"}));
+  ASSERT_EQ(event_stats.size(), 2);
+  EXPECT_EQ(event_stats[0]["allocator_name"], "cpu");
+  EXPECT_EQ(event_stats[0]["tf_op"], "MatMul");
+  EXPECT_EQ(event_stats[0]["id"], "3");
+  EXPECT_EQ(event_stats[0]["requested_bytes"], "256");
+  EXPECT_EQ(event_stats[0]["bytes_allocated"], "512");
+  // Peaks are tracked per allocator.
+  EXPECT_EQ(event_stats[0]["peak_bytes_in_use"], "512");
+  EXPECT_EQ(event_stats[1]["requested_bytes"], "256");
+  EXPECT_EQ(event_stats[1]["bytes_allocated"], "256");
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
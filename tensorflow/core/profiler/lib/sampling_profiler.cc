@@ -0,0 +1,240 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/utils/op_metrics_db_utils.h"
+#include "tensorflow/core/profiler/utils/tf_op_utils.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// Builds the OpMetricsDb of the TF ops from the TraceMe statistics.
+class SampledOpMetricsDbBuilder : public OpMetricsDbBuilder {
+ public:
+  explicit SampledOpMetricsDbBuilder(OpMetricsDb* db)
+      : OpMetricsDbBuilder(db) {}
+
+  void Add(const TraceMeRecorder::EventStatistics& stats) {
+    const TfOp tf_op = ParseTfOpFullname(stats.name);
+    if (tf_op.category == Category::kUnknown) return;
+    OpMetrics* metrics =
+        LookupOrInsertNewOpMetrics(/*hlo_module_id=*/0, tf_op.name);
+    if (metrics->category().empty()) {
+      metrics->set_category(std::string(tf_op.type));
+    }
+    const uint64 time_ps = NanosToPicos(stats.total_ns);
+    const uint64 min_time_ps = NanosToPicos(stats.min_ns);
+    metrics->set_min_time_ps(metrics->occurrences() == 0
+                                 ? min_time_ps
+                                 : std::min(metrics->min_time_ps(),
+                                            min_time_ps));
+    metrics->set_occurrences(metrics->occurrences() + stats.count);
+    metrics->set_time_ps(metrics->time_ps() + time_ps);
+    metrics->set_self_time_ps(metrics->self_time_ps() + time_ps);
+    db()->set_total_op_time_ps(db()->total_op_time_ps() + time_ps);
+  }
+};
+
+// Returns the upper bound of the histogram bucket holding the `percentile`th
+// duration.
+uint64 ApproximatePercentileNs(const TraceMeRecorder::EventStatistics& stats,
+                               double percentile) {
+  const double rank = stats.count * percentile / 100.0;
+  uint64 seen = 0;
+  for (int b = 0; b < TraceMeRecorder::EventStatistics::kNumBuckets; ++b) {
+    seen += stats.buckets[b];
+    if (seen >= rank && seen > 0) {
+      return std::min(stats.max_ns, b == 0 ? 0 : uint64{1} << b);
+    }
+  }
+  return stats.max_ns;
+}
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler() {
+  int64 sample_every_n_steps = 0;
+  Status status = ReadInt64FromEnvVar("TF_SAMPLING_PROFILER_EVERY_N_STEPS",
+                                      /*default_val=*/0, &sample_every_n_steps);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  } else if (sample_every_n_steps > 0) {
+    SamplingProfilerOptions options;
+    options.sample_every_n_steps = sample_every_n_steps;
+    options_ = options;
+    sample_every_n_steps_ = sample_every_n_steps;
+    if (TraceMeRecorder::StartStatistics(options.statistics_level)) {
+      enabled_ = true;
+      LOG(INFO) << "Sampling profiler enabled, tracing one in "
+                << sample_every_n_steps << " steps.";
+    }
+  }
+}
+
+/*static*/ SamplingProfiler* SamplingProfiler::Get() {
+  static SamplingProfiler* profiler = new SamplingProfiler;
+  return profiler;
+}
+
+/*static*/ Status SamplingProfiler::Enable(
+    const SamplingProfilerOptions& options) {
+  SamplingProfiler* profiler = Get();
+  mutex_lock l(profiler->mu_);
+  if (profiler->enabled_) {
+    return errors::AlreadyExists("The sampling profiler is already enabled.");
+  }
+  if (!TraceMeRecorder::StartStatistics(options.statistics_level)) {
+    return errors::Unavailable("TraceMe statistics are already collected.");
+  }
+  profiler->options_ = options;
+  profiler->traces_.clear();
+  profiler->num_steps_ = 0;
+  profiler->next_sample_time_us_ = 0;
+  profiler->sample_every_n_steps_ = options.sample_every_n_steps;
+  profiler->enabled_ = true;
+  return Status::OK();
+}
+
+/*static*/ void SamplingProfiler::Disable() {
+  SamplingProfiler* profiler = Get();
+  mutex_lock l(profiler->mu_);
+  if (!profiler->enabled_) return;
+  profiler->enabled_ = false;
+  TraceMeRecorder::StopStatistics();
+}
+
+/*static*/ bool SamplingProfiler::IsEnabled() { return Get()->enabled_; }
+
+bool SamplingProfiler::ShouldSample() {
+  const int64 n = sample_every_n_steps_.load(std::memory_order_relaxed);
+  if (n <= 0) return false;
+  if ((num_steps_.fetch_add(1, std::memory_order_relaxed) + 1) % n != 0) {
+    return false;
+  }
+  const uint64 now_us = Env::Default()->NowMicros();
+  if (now_us < next_sample_time_us_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  if (sampling_.exchange(true, std::memory_order_acq_rel)) return false;
+  mutex_lock l(mu_);
+  next_sample_time_us_.store(
+      now_us + options_.min_sample_interval_ms * EnvTime::kMillisToMicros,
+      std::memory_order_relaxed);
+  return true;
+}
+
+void SamplingProfiler::AddTrace(XSpace&& space) {
+  mutex_lock l(mu_);
+  traces_.push_back(std::move(space));
+  while (traces_.size() > std::max<size_t>(1, options_.max_traces)) {
+    traces_.pop_front();
+  }
+}
+
+SamplingProfiler::Step::Step() {
+  SamplingProfiler* profiler = Get();
+  if (!profiler->enabled_.load(std::memory_order_relaxed) ||
+      !profiler->ShouldSample()) {
+    return;
+  }
+  ProfileOptions options;
+  {
+    mutex_lock l(profiler->mu_);
+    options = profiler->options_.trace_options;
+  }
+  session_ = ProfilerSession::Create(options);
+  if (!session_->Status().ok()) {
+    // Another profiler session is active.
+    VLOG(1) << "Not tracing sampled step: " << session_->Status();
+    session_.reset();
+    profiler->sampling_.store(false, std::memory_order_release);
+  }
+}
+
+SamplingProfiler::Step::~Step() {
+  if (session_ == nullptr) return;
+  SamplingProfiler* profiler = Get();
+  XSpace space;
+  Status status = session_->CollectData(&space);
+  session_.reset();
+  if (status.ok()) {
+    profiler->AddTrace(std::move(space));
+  } else {
+    LOG(WARNING) << "Failed to collect the trace of a sampled step: "
+                 << status;
+  }
+  profiler->sampling_.store(false, std::memory_order_release);
+}
+
+/*static*/ void SamplingProfiler::GetOpMetricsDb(OpMetricsDb* db) {
+  SampledOpMetricsDbBuilder builder(db);
+  for (const auto& stats : TraceMeRecorder::GetStatistics()) {
+    builder.Add(stats);
+  }
+}
+
+/*static*/ std::string SamplingProfiler::SummarizeOpStatistics(int max_ops) {
+  std::vector<TraceMeRecorder::EventStatistics> statistics;
+  for (auto& stats : TraceMeRecorder::GetStatistics()) {
+    if (ParseTfOpFullname(stats.name).category != Category::kUnknown) {
+      statistics.push_back(std::move(stats));
+    }
+  }
+  std::sort(statistics.begin(), statistics.end(),
+            [](const TraceMeRecorder::EventStatistics& a,
+               const TraceMeRecorder::EventStatistics& b) {
+              return a.total_ns > b.total_ns;
+            });
+  if (statistics.size() > static_cast<size_t>(std::max(0, max_ops))) {
+    statistics.resize(std::max(0, max_ops));
+  }
+  std::string summary = absl::StrFormat(
+      "%-60s %10s %12s %10s %10s %10s\n", "Op", "Count", "Total (us)",
+      "Avg (us)", "p50 (us)", "p99 (us)");
+  for (const auto& stats : statistics) {
+    absl::StrAppendFormat(
+        &summary, "%-60s %10d %12.1f %10.2f %10.2f %10.2f\n", stats.name,
+        stats.count, stats.total_ns / 1e3, stats.total_ns / 1e3 / stats.count,
+        ApproximatePercentileNs(stats, 50) / 1e3,
+        ApproximatePercentileNs(stats, 99) / 1e3);
+  }
+  return summary;
+}
+
+/*static*/ std::vector<XSpace> SamplingProfiler::TakeTraces() {
+  SamplingProfiler* profiler = Get();
+  mutex_lock l(profiler->mu_);
+  std::vector<XSpace> traces(
+      std::make_move_iterator(profiler->traces_.begin()),
+      std::make_move_iterator(profiler->traces_.end()));
+  profiler->traces_.clear();
+  return traces;
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,129 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/profiler_options.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+struct SamplingProfilerOptions {
+  // A full trace is collected for one in `sample_every_n_steps` steps. If 0,
+  // no traces are collected.
+  int64 sample_every_n_steps = 1000;
+  // Minimum time between two traced steps, in milliseconds.
+  int64 min_sample_interval_ms = 60 * 1000;
+  // Options of the profiler sessions tracing the sampled steps.
+  ProfileOptions trace_options = ProfilerSession::DefaultOptions();
+  // Number of traces kept in memory; older ones are dropped.
+  int max_traces = 4;
+  // TraceMe level of the events aggregated into op statistics between traces.
+  // Level 2 covers the expensive TF ops.
+  int statistics_level = 2;
+};
+
+// An always-on, low-overhead profiler for production jobs.
+//
+// While enabled, the durations of the TraceMe events are aggregated into
+// lock-free per-name histograms (see TraceMeRecorder::StartStatistics()), and
+// a rate-limited fraction of the steps is fully traced with a ProfilerSession.
+// The statistics are exposed as an OpMetricsDb, which the Monitor RPC of the
+// profiler service returns for continuous collection.
+//
+// Steps are delimited by SamplingProfiler::Step objects, created by the
+// session for each Run() call. A traced step records everything that happens
+// in the process while it runs, including concurrent steps.
+//
+// Can be enabled with the environment variable
+// TF_SAMPLING_PROFILER_EVERY_N_STEPS=<n>, with the default options otherwise.
+class SamplingProfiler {
+ public:
+  // Scope of a step or request. Traces it if it is sampled.
+  class Step {
+   public:
+    Step();
+    ~Step();
+
+   private:
+    std::unique_ptr<ProfilerSession> session_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Step);
+  };
+
+  // Enables the profiler, clearing the statistics and traces of a previous
+  // run. Fails if it is already enabled.
+  static Status Enable(const SamplingProfilerOptions& options);
+
+  // Disables the profiler. The statistics and traces remain available.
+  static void Disable();
+
+  static bool IsEnabled();
+
+  // Fills `db` with the statistics of the TF ops that ran since the profiler
+  // was enabled.
+  static void GetOpMetricsDb(OpMetricsDb* db);
+
+  // Returns a human readable summary of the `max_ops` TF ops with the most
+  // total time, with approximate percentiles of their durations.
+  static std::string SummarizeOpStatistics(int max_ops);
+
+  // Returns the traces of the sampled steps collected since the last call,
+  // oldest first.
+  static std::vector<XSpace> TakeTraces();
+
+ private:
+  SamplingProfiler();
+
+  static SamplingProfiler* Get();
+
+  // Returns true if the current step is to be traced. At most one step is
+  // traced at a time.
+  bool ShouldSample();
+
+  void AddTrace(XSpace&& space) TF_LOCKS_EXCLUDED(mu_);
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<int64> sample_every_n_steps_{0};
+  std::atomic<int64> num_steps_{0};
+  std::atomic<uint64> next_sample_time_us_{0};
+  std::atomic<bool> sampling_{false};
+
+  mutex mu_;
+  SamplingProfilerOptions options_ TF_GUARDED_BY(mu_);
+  std::deque<XSpace> traces_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SamplingProfiler);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_SAMPLING_PROFILER_H_
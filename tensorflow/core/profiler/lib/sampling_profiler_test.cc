@@ -0,0 +1,59 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+TEST(SamplingProfilerTest, TracesOneInNSteps) {
+  SamplingProfilerOptions options;
+  options.sample_every_n_steps = 2;
+  options.min_sample_interval_ms = 0;
+  TF_ASSERT_OK(SamplingProfiler::Enable(options));
+  EXPECT_TRUE(SamplingProfiler::IsEnabled());
+  EXPECT_FALSE(SamplingProfiler::Enable(options).ok());
+
+  for (int i = 0; i < 4; ++i) {
+    SamplingProfiler::Step step;
+    TraceMe traceme("model/matmul:MatMul", /*level=*/2);
+  }
+  SamplingProfiler::Disable();
+  EXPECT_FALSE(SamplingProfiler::IsEnabled());
+  EXPECT_EQ(SamplingProfiler::TakeTraces().size(), 2);
+  EXPECT_TRUE(SamplingProfiler::TakeTraces().empty());
+
+  // Statistics are kept for every step, traced or not.
+  OpMetricsDb db;
+  SamplingProfiler::GetOpMetricsDb(&db);
+  ASSERT_EQ(db.metrics_db_size(), 1);
+  const OpMetrics& metrics = db.metrics_db(0);
+  EXPECT_EQ(metrics.name(), "model/matmul");
+  EXPECT_EQ(metrics.category(), "MatMul");
+  EXPECT_EQ(metrics.occurrences(), 4);
+  EXPECT_EQ(db.total_op_time_ps(), metrics.time_ps());
+  EXPECT_NE(SamplingProfiler::SummarizeOpStatistics(10).find("model/matmul"),
+            std::string::npos);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
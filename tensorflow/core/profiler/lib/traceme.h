@@ -271,6 +271,20 @@ class TraceMe {
 #endif
   }
 
+  // Records an activity that already completed, with start and end times in
+  // nanoseconds since the epoch (e.g., from EnvTime::NowNanos()). Useful for
+  // activities that span several threads.
+  template <typename NameGeneratorT>
+  static void CompleteActivity(NameGeneratorT name_generator,
+                               int64 start_time_ns, int64 end_time_ns,
+                               int level = 1) {
+#if !defined(IS_MOBILE_PLATFORM)
+    if (TF_PREDICT_FALSE(TraceMeRecorder::Active(level))) {
+      TraceMeRecorder::Record({name_generator(), start_time_ns, end_time_ns});
+    }
+#endif
+  }
+
   static bool Active(int level = 1) {
 #if !defined(IS_MOBILE_PLATFORM)
     return TraceMeRecorder::Active(level);
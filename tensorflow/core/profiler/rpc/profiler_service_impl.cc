@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/profiler/lib/profiler_session.h"
+#include "tensorflow/core/profiler/lib/sampling_profiler.h"
 #include "tensorflow/core/profiler/profiler_service.grpc.pb.h"
 #include "tensorflow/core/profiler/profiler_service.pb.h"
 #include "tensorflow/core/profiler/protobuf/xplane.pb.h"
@@ -41,6 +42,9 @@ namespace {
 
 const absl::string_view kXPlanePb = "xplane.pb";
 
+// Number of ops summarized in a Monitor response.
+constexpr int kMaxMonitoredOps = 20;
+
 // Collects data in XSpace format. The data is saved to a repository
 // unconditionally.
 Status CollectDataToRepository(const ProfileRequest& request,
@@ -73,7 +77,14 @@ class ProfilerServiceImpl : public grpc::ProfilerService::Service {
  public:
   ::grpc::Status Monitor(::grpc::ServerContext* ctx, const MonitorRequest* req,
                          MonitorResponse* response) override {
-    return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "unimplemented.");
+    if (!SamplingProfiler::IsEnabled()) {
+      return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION,
+                            "The sampling profiler is not enabled.");
+    }
+    SamplingProfiler::GetOpMetricsDb(response->mutable_op_metrics_db());
+    response->set_data(
+        SamplingProfiler::SummarizeOpStatistics(kMaxMonitoredOps));
+    return ::grpc::Status::OK;
   }
 
   ::grpc::Status Profile(::grpc::ServerContext* ctx, const ProfileRequest* req,
@@ -336,6 +336,70 @@ void DeriveEventsFromHostTrace(const XPlane* host_trace,
   }
 }
 
+void DeriveEventsFromBatchRequests(XPlane* host_trace) {
+  struct BatchRequest {
+    absl::optional<int64> request_id;
+    int64 start_ns;
+    int64 batch_start_ns;
+    int64 compute_start_ns;
+    int64 compute_end_ns;
+    int64 end_ns;
+  };
+  std::vector<BatchRequest> requests;
+  XPlaneVisitor host_plane = CreateTfXPlaneVisitor(host_trace);
+  host_plane.ForEachLine([&](const XLineVisitor& line) {
+    if (IsDerivedThreadId(line.Id())) return;
+    line.ForEachEvent([&](const XEventVisitor& event) {
+      if (event.Type() != HostEventType::kBatchRequest) return;
+      auto batch_start = event.GetStat(StatType::kBatchStartTimeNs);
+      auto compute_start = event.GetStat(StatType::kComputeStartTimeNs);
+      auto compute_end = event.GetStat(StatType::kComputeEndTimeNs);
+      if (!batch_start || !compute_start || !compute_end) return;
+      BatchRequest request;
+      if (auto request_id = event.GetStat(StatType::kRequestId)) {
+        request.request_id = request_id->IntOrUintValue();
+      }
+      request.start_ns = PicosToNanos(event.TimestampPs());
+      request.batch_start_ns = batch_start->IntOrUintValue();
+      request.compute_start_ns = compute_start->IntOrUintValue();
+      request.compute_end_ns = compute_end->IntOrUintValue();
+      request.end_ns = PicosToNanos(event.EndTimestampPs());
+      requests.push_back(request);
+    });
+  });
+  if (requests.empty()) return;
+
+  XPlaneBuilder plane(host_trace);
+  XLineBuilder requests_line = plane.GetOrCreateLine(kThreadIdBatchRequests);
+  requests_line.SetName(kBatchRequestsLineName);
+  requests_line.SetTimestampNs(
+      absl::c_min_element(requests, [](const BatchRequest& a,
+                                       const BatchRequest& b) {
+        return a.start_ns < b.start_ns;
+      })->start_ns);
+  const XStatMetadata& request_id_stat =
+      *plane.GetOrCreateStatMetadata(GetStatTypeStr(StatType::kRequestId));
+  auto add_phase = [&](const BatchRequest& request, absl::string_view name,
+                       int64 start_ns, int64 end_ns) {
+    if (end_ns < start_ns) return;
+    XEventBuilder phase =
+        requests_line.AddEvent(*plane.GetOrCreateEventMetadata(name));
+    phase.SetTimestampNs(start_ns);
+    phase.SetDurationNs(end_ns - start_ns);
+    if (request.request_id) {
+      phase.AddStatValue(request_id_stat, *request.request_id);
+    }
+  };
+  for (const BatchRequest& request : requests) {
+    add_phase(request, "Queue Wait", request.start_ns, request.batch_start_ns);
+    add_phase(request, "Batch Formation", request.batch_start_ns,
+              request.compute_start_ns);
+    add_phase(request, "Compute", request.compute_start_ns,
+              request.compute_end_ns);
+    add_phase(request, "Split Output", request.compute_end_ns, request.end_ns);
+  }
+}
+
 void GenerateDerivedTimeLines(const GroupMetadataMap& group_metadata_map,
                               XSpace* space, bool step_info_only) {
   // TODO(profiler): Once we capture HLO protos for xla/gpu, we should use that
@@ -350,6 +414,11 @@ void GenerateDerivedTimeLines(const GroupMetadataMap& group_metadata_map,
     DeriveEventsFromAnnotations(dummy_symbol_resolver, group_metadata_map,
                                 plane, step_info_only);
   }
+  if (step_info_only) return;
+  if (XPlane* host_plane =
+          FindMutablePlaneWithName(space, kHostThreadsPlaneName)) {
+    DeriveEventsFromBatchRequests(host_plane);
+  }
 }
 
 }  // namespace profiler
@@ -99,8 +99,15 @@ void DeriveEventsFromHostTrace(const XPlane* host_trace,
                                const GroupMetadataMap& group_metadata_map,
                                std::vector<XPlane*> device_traces);
 
+// Derives the "Batch Requests" line of the host trace from the BatchRequest
+// events of the batching ops, splitting each request into its queue wait, batch
+// formation, compute and split output phases.
+void DeriveEventsFromBatchRequests(XPlane* host_trace);
+
 // Loops through XPlanes of input XSpace, if it is "device" XPlane, generating
 // derived timelines for the plane by calling DeriveEventsFromAnnotations.
+// Unless step_info_only, also derives the batch request phases of the host
+// XPlane.
 void GenerateDerivedTimeLines(const GroupMetadataMap& group_metadata_map,
                               XSpace* space, bool step_info_only = false);
 
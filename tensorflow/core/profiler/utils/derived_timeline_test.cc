@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/utils/derived_timeline.h"
 
+#include <utility>
+#include <vector>
+
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
@@ -173,6 +176,43 @@ TEST(DerivedTimelineTest, TfOpNameScopeTest) {
   });
 }
 
+// Checks that each batch request is split into its phases.
+TEST(DerivedTimelineTest, BatchRequestPhasesTest) {
+  constexpr int64 kRequestId = 42;
+  XSpace space;
+  GroupMetadataMap group_metadata_map;
+  XPlane* plane = GetOrCreateHostXPlane(&space);
+  XPlaneBuilder plane_builder(plane);
+  auto line_builder = plane_builder.GetOrCreateLine(0);
+  line_builder.SetTimestampNs(1000);
+  CreateXEvent(&plane_builder, &line_builder, HostEventType::kBatchRequest, 0,
+               10000,
+               {{StatType::kRequestId, kRequestId},
+                {StatType::kBatchStartTimeNs, int64{1002}},
+                {StatType::kComputeStartTimeNs, int64{1003}},
+                {StatType::kComputeEndTimeNs, int64{1008}}});
+  GenerateDerivedTimeLines(group_metadata_map, &space);
+  XPlaneVisitor plane_visitor = CreateTfXPlaneVisitor(plane);
+  EXPECT_EQ(plane_visitor.NumLines(), 2);
+  plane_visitor.ForEachLine([&](const XLineVisitor& line_visitor) {
+    if (line_visitor.Id() == 0) return;
+    EXPECT_EQ(line_visitor.Id(), kThreadIdBatchRequests);
+    EXPECT_EQ(line_visitor.Name(), kBatchRequestsLineName);
+    std::vector<std::pair<absl::string_view, int64>> phases;
+    line_visitor.ForEachEvent([&](const XEventVisitor& event_visitor) {
+      phases.emplace_back(event_visitor.Name(), event_visitor.DurationPs());
+      auto request_id = event_visitor.GetStat(StatType::kRequestId);
+      ASSERT_TRUE(request_id.has_value());
+      EXPECT_EQ(request_id->IntValue(), kRequestId);
+    });
+    EXPECT_THAT(phases, ::testing::ElementsAre(
+                            std::make_pair("Queue Wait", 2000),
+                            std::make_pair("Batch Formation", 1000),
+                            std::make_pair("Compute", 5000),
+                            std::make_pair("Split Output", 2000)));
+  });
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
@@ -43,6 +43,8 @@ const absl::string_view kXlaModuleLineName = "XLA Modules";
 const absl::string_view kXlaOpLineName = "XLA Ops";
 const absl::string_view kKernelLaunchLineName = "Launch Stats";
 const absl::string_view kSourceLineName = "Source code";
+const absl::string_view kBatchRequestsLineName = "Batch Requests";
+const absl::string_view kMemoryTimelineLineName = "Memory Timeline";
 
 namespace {
 
@@ -121,6 +123,7 @@ const HostEventTypeMap& GetHostEventTypeMap() {
       {"ScheduleWithoutSplit", kScheduleWithoutSplit},
       {"ScheduleWithSplit", kScheduleWithSplit},
       {"ASBSQueue::Schedule", kASBSQueueSchedule},
+      {"BatchRequest", kBatchRequest},
       // JAX related.
       {"LocalExecutable::ExecuteOnLocalDevices", kExecuteOnLocalDevices},
       // GPU related.
@@ -221,10 +224,18 @@ const StatTypeMap& GetStatTypeMap() {
       {"batch_size_after_padding", kBatchSizeAfterPadding},
       {"padding_amount", kPaddingAmount},
       {"batching_input_task_size", kBatchingInputTaskSize},
+      {"batch_start_time_ns", kBatchStartTimeNs},
+      {"compute_start_time_ns", kComputeStartTimeNs},
+      {"compute_end_time_ns", kComputeEndTimeNs},
       // GPU related metrics.
       {"theoretical_occupancy_pct", kTheoreticalOccupancyPct},
       {"occupancy_min_grid_size", kOccupancyMinGridSize},
       {"occupancy_suggested_block_size", kOccupancySuggestedBlockSize},
+      // CPU hardware performance counters.
+      {"cpu_cycles", kCpuCycles},
+      {"cpu_instructions", kCpuInstructions},
+      {"llc_misses", kLlcMisses},
+      {"llc_miss_bytes", kLlcMissBytes},
   });
   DCHECK_EQ(stat_type_map->size(), kNumStatTypes);
   return *stat_type_map;
@@ -54,6 +54,8 @@ TF_CONST_INIT extern const absl::string_view kXlaModuleLineName;
 TF_CONST_INIT extern const absl::string_view kXlaOpLineName;
 TF_CONST_INIT extern const absl::string_view kKernelLaunchLineName;
 TF_CONST_INIT extern const absl::string_view kSourceLineName;
+TF_CONST_INIT extern const absl::string_view kBatchRequestsLineName;
+TF_CONST_INIT extern const absl::string_view kMemoryTimelineLineName;
 
 // Interesting event types (i.e., TraceMe names).
 enum HostEventType {
@@ -115,6 +117,7 @@ enum HostEventType {
   kScheduleWithoutSplit,
   kScheduleWithSplit,
   kASBSQueueSchedule,
+  kBatchRequest,
   // JAX related.
   kExecuteOnLocalDevices,
   // GPU related.
@@ -215,11 +218,19 @@ enum StatType {
   kBatchSizeAfterPadding,
   kPaddingAmount,
   kBatchingInputTaskSize,
+  kBatchStartTimeNs,
+  kComputeStartTimeNs,
+  kComputeEndTimeNs,
   // GPU occupancy metrics
   kTheoreticalOccupancyPct,
   kOccupancyMinGridSize,
   kOccupancySuggestedBlockSize,
-  kLastStatType = kOccupancySuggestedBlockSize,
+  // CPU hardware performance counters.
+  kCpuCycles,
+  kCpuInstructions,
+  kLlcMisses,
+  kLlcMissBytes,
+  kLastStatType = kLlcMissBytes,
 };
 
 inline std::string GpuPlaneName(int32 device_ordinal) {
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <algorithm>
+
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -22,6 +24,9 @@ limitations under the License.
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/summary/summary_converter.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
@@ -54,6 +59,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
     string sep = absl::StartsWith(filename_suffix, ".") ? "" : ".";
     const string uniquified_filename_suffix = absl::StrCat(
         ".", pid, ".", file_id_counter.fetch_add(1), sep, filename_suffix);
+    mutex_lock wl(writer_mu_);
     mutex_lock ml(mu_);
     events_writer_ =
         tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
@@ -66,14 +72,33 @@ class SummaryFileWriter : public SummaryWriterInterface {
   }
 
   Status Flush() override {
-    mutex_lock ml(mu_);
-    if (!is_initialized_) {
-      return errors::FailedPrecondition("Class was not properly initialized.");
+    mutex_lock wl(writer_mu_);
+    std::vector<std::unique_ptr<Event>> events;
+    {
+      mutex_lock ml(mu_);
+      if (!is_initialized_) {
+        return errors::FailedPrecondition(
+            "Class was not properly initialized.");
+      }
+      events.swap(queue_);
+      last_flush_ = env_->NowMicros();
     }
-    return InternalFlush();
+    Status s = WriteAndFlushEvents(events);
+    mutex_lock ml(mu_);
+    s.Update(background_status_);
+    background_status_ = Status::OK();
+    return s;
   }
 
   ~SummaryFileWriter() override {
+    std::unique_ptr<Thread> flush_thread;
+    {
+      mutex_lock ml(mu_);
+      cancelled_ = true;
+      flush_cond_var_.notify_all();
+      flush_thread = std::move(flush_thread_);
+    }
+    flush_thread.reset();  // Joins the background thread.
     (void)Flush();  // Ignore errors.
   }
 
@@ -150,10 +175,34 @@ class SummaryFileWriter : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
+    // Surface the error of an earlier background flush, if any.
+    if (!background_status_.ok()) {
+      Status s = background_status_;
+      background_status_ = Status::OK();
+      return s;
+    }
+    if (queue_.size() >= MaxPendingEvents()) {
+      // The background thread cannot keep up with the file system. Drop the
+      // event rather than stalling the step that produced it.
+      ++num_dropped_events_;
+      LOG_EVERY_N(WARNING, 1000)
+          << "Dropped " << num_dropped_events_ << " summary events because "
+          << "writing to the events file is falling behind.";
+      return Status::OK();
+    }
     queue_.emplace_back(std::move(event));
     if (queue_.size() > max_queue_ ||
         env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+      // Write the events on the background thread so that a slow file system
+      // does not add latency to the op that emitted the summary.
+      last_flush_ = env_->NowMicros();
+      flush_requested_ = true;
+      if (!flush_thread_) {
+        flush_thread_.reset(env_->StartThread(
+            {}, "tf_summary_file_writer",
+            [this]() { BackgroundFlushThread(); }));
+      }
+      flush_cond_var_.notify_one();
     }
     return Status::OK();
   }
@@ -165,26 +214,70 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
+  // Upper bound on the number of events buffered while the background thread
+  // is writing; events beyond it are dropped.
+  size_t MaxPendingEvents() const {
+    return std::max<size_t>(100 * static_cast<size_t>(max_queue_), 10000);
+  }
+
+  Status WriteAndFlushEvents(const std::vector<std::unique_ptr<Event>>& events)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(writer_mu_) {
+    for (const std::unique_ptr<Event>& e : events) {
       events_writer_->WriteEvent(*e);
     }
-    queue_.clear();
     TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
                                     "Could not flush events file.");
-    last_flush_ = env_->NowMicros();
     return Status::OK();
   }
 
+  void BackgroundFlushThread() {
+    while (true) {
+      {
+        mutex_lock ml(mu_);
+        while (!cancelled_ && !flush_requested_) {
+          flush_cond_var_.wait(ml);
+        }
+        if (cancelled_) {
+          return;
+        }
+      }
+      // `writer_mu_` is acquired before taking the events from `queue_` so
+      // that batches reach the file in the order they were queued.
+      mutex_lock wl(writer_mu_);
+      std::vector<std::unique_ptr<Event>> events;
+      {
+        mutex_lock ml(mu_);
+        flush_requested_ = false;
+        events.swap(queue_);
+      }
+      Status s = WriteAndFlushEvents(events);
+      if (!s.ok()) {
+        mutex_lock ml(mu_);
+        background_status_.Update(s);
+      }
+    }
+  }
+
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
   uint64 last_flush_;
   Env* env_;
+  // Serializes writes to `events_writer_`. Acquired before `mu_`.
+  mutex writer_mu_;
   mutex mu_;
   std::vector<std::unique_ptr<Event>> queue_ TF_GUARDED_BY(mu_);
   // A pointer to allow deferred construction.
-  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<EventsWriter> events_writer_ TF_GUARDED_BY(writer_mu_);
+  // Background thread that writes queued events; started on the first flush.
+  std::unique_ptr<Thread> flush_thread_ TF_GUARDED_BY(mu_);
+  condition_variable flush_cond_var_;
+  bool flush_requested_ TF_GUARDED_BY(mu_) = false;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  // First error from a background flush, returned by the next call to
+  // `WriteEvent()` or `Flush()`.
+  Status background_status_ TF_GUARDED_BY(mu_);
+  int64 num_dropped_events_ TF_GUARDED_BY(mu_) = 0;
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
       TF_GUARDED_BY(mu_);
 };
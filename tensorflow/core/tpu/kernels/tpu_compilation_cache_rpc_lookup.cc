@@ -66,33 +66,12 @@ Status TpuCompilationCacheRpcLookup::Lookup(
     tpu::CompilationCacheFetchTarget fetch_target) {
   profiler::TraceMe proto_lookup_traceme("Remote TPU proto cache lookup",
                                          /*level=*/2);
-  entry->reset();
-  std::shared_ptr<CacheEntry> cache_entry;
-  // Keep a reference to CacheEntry objects evicted from the cache so that the
-  // potential deletion happens outside the lock upon method exit.
-  std::vector<std::shared_ptr<CacheEntry>> removed_entries;
-
   std::string local_proto_key = absl::StrCat(
       proto_key, "_", tpu::CompilationCacheFetchTarget_Name(fetch_target));
-
-  {
-    absl::MutexLock lock(&mu_);
-    auto iter = cache_.find(local_proto_key);
-    if (iter == cache_.end()) {
-      tpu::GetTpuProgramRequest request;
-      request.set_key(proto_key);
-      request.set_fetch_target(fetch_target);
-      TF_RETURN_IF_ERROR(
-          RemoteLookupLocked(local_proto_key, request, &cache_entry));
-    } else {
-      VLOG(1) << "Found key " << local_proto_key << " in local proto cache.";
-      cache_entry = iter->second;
-      auto erased = entries_by_last_use_.erase(cache_entry->last_use);
-      CHECK_EQ(erased, 1);
-    }
-    PostLookupLocked(&cache_entry, entry, &removed_entries);
-  }
-  return Status::OK();
+  tpu::GetTpuProgramRequest request;
+  request.set_key(proto_key);
+  request.set_fetch_target(fetch_target);
+  return LookupLocalOrRemote(local_proto_key, request, entry);
 }
 
 Status TpuCompilationCacheRpcLookup::Lookup(
@@ -101,12 +80,6 @@ Status TpuCompilationCacheRpcLookup::Lookup(
     tpu::CompilationCacheFetchTarget fetch_target) {
   profiler::TraceMe proto_lookup_traceme("Remote TPU proto cache lookup by uid",
                                          /*level=*/2);
-  entry->reset();
-  std::shared_ptr<CacheEntry> cache_entry;
-  // Keep a reference to CacheEntry objects evicted from the cache so that the
-  // potential deletion happens outside the lock upon method exit.
-  std::vector<std::shared_ptr<CacheEntry>> removed_entries;
-
   // Make a string key so that we can uniformly store cached entries under
   // string keys whether they are looked up by proto_key or uid+index. The
   // expectation is that any given executable will only ever be looked up
@@ -116,38 +89,62 @@ Status TpuCompilationCacheRpcLookup::Lookup(
   std::string local_proto_key =
       absl::StrCat(" _ ", uid, ":", proto_index, "_",
                    tpu::CompilationCacheFetchTarget_Name(fetch_target));
+  tpu::GetTpuProgramRequest request;
+  tpu::TpuCompilationUidAndIndex* uid_and_index =
+      request.mutable_uid_and_index();
+  uid_and_index->set_uid(uid);
+  uid_and_index->set_proto_index(proto_index);
+  request.set_fetch_target(fetch_target);
+  return LookupLocalOrRemote(local_proto_key, request, entry);
+}
+
+Status TpuCompilationCacheRpcLookup::LookupLocalOrRemote(
+    const std::string& local_proto_key,
+    const tpu::GetTpuProgramRequest& request,
+    std::unique_ptr<CompilationCacheEntryRef>* entry) {
+  entry->reset();
+  std::shared_ptr<CacheEntry> cache_entry;
+  // Keep a reference to CacheEntry objects evicted from the cache so that the
+  // potential deletion happens outside the lock upon method exit.
+  std::vector<std::shared_ptr<CacheEntry>> removed_entries;
+
   {
     absl::MutexLock lock(&mu_);
+    // At startup every core of the host asks for its program at once. Only
+    // one of them fetches a given key; the others wait for its result.
+    while (keys_in_flight_.count(local_proto_key) > 0) {
+      fetch_done_.Wait(&mu_);
+    }
     auto iter = cache_.find(local_proto_key);
-    if (iter == cache_.end()) {
-      tpu::GetTpuProgramRequest request;
-      tpu::TpuCompilationUidAndIndex* uid_and_index =
-          request.mutable_uid_and_index();
-      uid_and_index->set_uid(uid);
-      uid_and_index->set_proto_index(proto_index);
-      request.set_fetch_target(fetch_target);
-      TF_RETURN_IF_ERROR(
-          RemoteLookupLocked(local_proto_key, request, &cache_entry));
-    } else {
-      VLOG(1) << "Found uid " << uid << " and index " << proto_index
-              << " in local proto cache.";
+    if (iter != cache_.end()) {
+      VLOG(1) << "Found key " << local_proto_key << " in local proto cache.";
       cache_entry = iter->second;
       auto erased = entries_by_last_use_.erase(cache_entry->last_use);
       CHECK_EQ(erased, 1);
+      PostLookupLocked(&cache_entry, entry, &removed_entries);
+      return Status::OK();
     }
-    PostLookupLocked(&cache_entry, entry, &removed_entries);
+    keys_in_flight_.insert(local_proto_key);
   }
+
+  Status s = RemoteLookup(local_proto_key, request, &cache_entry);
+
+  absl::MutexLock lock(&mu_);
+  keys_in_flight_.erase(local_proto_key);
+  fetch_done_.SignalAll();
+  TF_RETURN_IF_ERROR(s);
+  cache_.emplace(local_proto_key, cache_entry);
+  cache_size_ += cache_entry->size;
+  PostLookupLocked(&cache_entry, entry, &removed_entries);
   return Status::OK();
 }
 
-Status TpuCompilationCacheRpcLookup::RemoteLookupLocked(
+Status TpuCompilationCacheRpcLookup::RemoteLookup(
     const std::string& local_proto_key,
     const tpu::GetTpuProgramRequest& request,
     std::shared_ptr<CacheEntry>* cache_entry) {
   profiler::TraceMe proto_lookup_traceme("Remote TPU proto cache fetch",
                                          /*level=*/2);
-  // Perform the RPC while holding the lock unless it is demonstrated that
-  // this causes a performance problem.
   ::grpc::ClientContext client_context;
   client_context.set_deadline(TimeToGprTimespec(::absl::Now() + kProtoTimeout));
   client_context.set_compression_algorithm(GRPC_COMPRESS_GZIP);
@@ -159,12 +156,8 @@ Status TpuCompilationCacheRpcLookup::RemoteLookupLocked(
           << " in remote subgraph cache status " << s;
   TF_RETURN_IF_ERROR(s);
 
-  TF_RETURN_IF_ERROR(DeserializeRpcResponseToCacheEntry(
-      local_proto_key, &response, cache_entry));
-  cache_.emplace(local_proto_key, (*cache_entry));
-  cache_size_ += (*cache_entry)->size;
-
-  return Status::OK();
+  return DeserializeRpcResponseToCacheEntry(local_proto_key, &response,
+                                            cache_entry);
 }
 
 void TpuCompilationCacheRpcLookup::PostLookupLocked(
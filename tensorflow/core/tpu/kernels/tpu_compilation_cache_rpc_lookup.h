@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
@@ -52,11 +53,19 @@ class TpuCompilationCacheRpcLookup : public TpuCompilationCacheLookup {
   string DebugString() const override;
 
  private:
+  // Returns the entry cached under `local_proto_key`, fetching it from the
+  // central cache with `request` on a miss. Concurrent lookups of the same key
+  // share a single RPC, and lookups of other keys are not blocked by it.
+  Status LookupLocalOrRemote(
+      const string& local_proto_key, const tpu::GetTpuProgramRequest& request,
+      std::unique_ptr<tpu::CompilationCacheEntryRef>* entry)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
   // Helper method to make the RPC request to the central cache.
-  Status RemoteLookupLocked(const string& local_proto_key,
-                            const tpu::GetTpuProgramRequest& request,
-                            std::shared_ptr<CacheEntry>* cache_entry)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status RemoteLookup(const string& local_proto_key,
+                      const tpu::GetTpuProgramRequest& request,
+                      std::shared_ptr<CacheEntry>* cache_entry)
+      ABSL_LOCKS_EXCLUDED(mu_);
 
   // Helper method to adjust datastructures after a cache lookup.
   // We use `removed_entries` so that actual CacheEntry destruction happens
@@ -88,6 +97,10 @@ class TpuCompilationCacheRpcLookup : public TpuCompilationCacheLookup {
       ABSL_GUARDED_BY(mu_);
   // Map from last_use to entry, used to evict entries in LRU order.
   std::map<int64, CacheEntry*> entries_by_last_use_ ABSL_GUARDED_BY(mu_);
+  // Keys whose RPC is in progress. Lookups of these keys wait on
+  // `fetch_done_` instead of issuing another RPC.
+  std::unordered_set<std::string> keys_in_flight_ ABSL_GUARDED_BY(mu_);
+  absl::CondVar fetch_done_;
 };
 }  // namespace tpu
 }  // namespace tensorflow
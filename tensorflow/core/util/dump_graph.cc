@@ -231,6 +231,26 @@ string DumpCostGraphDefToFile(const string& name, CostGraphDef const& graph_def,
   return filepath;
 }
 
+string DumpProtoToFile(const string& name,
+                       tensorflow::protobuf::Message const& proto,
+                       const string& dirname) {
+  string filepath;
+  std::unique_ptr<WritableFile> file;
+  Status status = CreateWritableFile(Env::Default(), dirname, name, ".pbtxt",
+                                     &filepath, &file);
+  if (!status.ok()) {
+    return StrCat("(failed to create writable file: ", status.ToString(), ")");
+  }
+
+  status = WriteTextProtoToUniqueFile(proto, file.get());
+  if (!status.ok()) {
+    return StrCat("(failed to dump ", proto.GetTypeName(), " to '", filepath,
+                  "': ", status.ToString(), ")");
+  }
+  LOG(INFO) << "Dumped " << proto.GetTypeName() << " to " << filepath;
+  return filepath;
+}
+
 string DumpGraphToFile(const string& name, Graph const& graph,
                        const FunctionLibraryDefinition* flib_def,
                        const string& dirname) {
@@ -20,7 +20,10 @@ limitations under the License.
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -31,8 +34,10 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -59,6 +64,14 @@ const int kTensorBundleVersion = 1;
 // Size of our input buffer for streaming reads
 static const int kBufferSize = 1024 * 1024;
 
+// Tensors larger than this are read with several concurrent range reads of
+// this size, directly into the destination buffer. This hides the per-request
+// latency of remote file systems. Unless the file supports
+// RandomAccessFile::MultiRead(), at most kNumParallelReadThreads chunks are in
+// flight at any time, across all readers in the process.
+static const int64 kParallelReadChunkSize = 16 << 20;
+static const int kNumParallelReadThreads = 8;
+
 // Key to the special BundleHeaderProto entry.  Do not change this, as clients
 // can make the assumption that the header is always the first entry in the
 // bundle.
@@ -66,6 +79,71 @@ const char* const kHeaderEntryKey = "";
 
 namespace {
 
+// Returns the threads shared by all BundleReaders for concurrent data reads and
+// index block decoding.
+thread::ThreadPool* BundleReaderPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "bundle_reader_parallel_read", kNumParallelReadThreads);
+  return pool;
+}
+
+// Checks that a chunk of ReadInParallel() read all of its bytes, and moves
+// them into place if the file returned them elsewhere.
+Status FinishChunkRead(Status s, StringPiece sp, uint64 chunk_offset,
+                       size_t chunk_size, char* chunk_destination) {
+  if (s.ok() && sp.size() != chunk_size) {
+    s = errors::DataLoss("Requested ", chunk_size, " bytes at offset ",
+                         chunk_offset, " but read ", sp.size());
+  }
+  if (s.ok() && sp.data() != chunk_destination) {
+    memmove(chunk_destination, sp.data(), chunk_size);
+  }
+  return s;
+}
+
+// Reads file[offset, offset+size) into "destination", splitting the read into
+// chunks of kParallelReadChunkSize bytes that are issued concurrently.
+Status ReadInParallel(RandomAccessFile* file, uint64 offset, size_t size,
+                      char* destination) {
+  const size_t num_chunks =
+      (size + kParallelReadChunkSize - 1) / kParallelReadChunkSize;
+  std::vector<RandomAccessFile::ReadRequest> requests(num_chunks);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    const size_t chunk_offset = i * kParallelReadChunkSize;
+    requests[i].offset = offset + chunk_offset;
+    requests[i].n =
+        std::min<size_t>(kParallelReadChunkSize, size - chunk_offset);
+    requests[i].scratch = destination + chunk_offset;
+  }
+  if (file->MultiRead(&requests).ok()) {
+    for (const RandomAccessFile::ReadRequest& request : requests) {
+      TF_RETURN_IF_ERROR(FinishChunkRead(request.status, request.result,
+                                         request.offset, request.n,
+                                         request.scratch));
+    }
+    return Status::OK();
+  }
+
+  thread::ThreadPool* pool = BundleReaderPool();
+  std::vector<Status> statuses(num_chunks);
+  BlockingCounter counter(num_chunks);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    pool->Schedule([file, &requests, i, &statuses, &counter]() {
+      RandomAccessFile::ReadRequest& request = requests[i];
+      StringPiece sp;
+      Status s = file->Read(request.offset, request.n, &sp, request.scratch);
+      statuses[i] = FinishChunkRead(s, sp, request.offset, request.n,
+                                    request.scratch);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
 // Reads "num_elements" string elements from file[offset, offset+size) into the
 // length-N "destination".  Discards the original content of "destination".
 //
@@ -405,8 +483,52 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64* size) {
   return status;
 }
 
+// The bytes of one tensor in a memory-mapped data file.  Holds a reference on
+// the mapping.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(TensorBuffer* root, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), root_(root), size_(size) {
+    root_->Ref();
+  }
+  ~MappedTensorBuffer() override { root_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return root_; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    root_->FillAllocationDescription(proto);
+    proto->set_requested_bytes(size_);
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  TensorBuffer* const root_;
+  const size_t size_;
+};
+
 }  // namespace
 
+// A read-only memory mapping of a data file.
+class BundleReader::MappedDataFile : public TensorBuffer {
+ public:
+  explicit MappedDataFile(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : TensorBuffer(const_cast<void*>(region->data())),
+        region_(std::move(region)) {}
+
+  size_t size() const override { return region_->length(); }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("mmap");
+  }
+  // The mapping may not be written to, so it must never be reused as an
+  // output buffer.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     : env_(env), options_(options), prefix_(prefix), out_(nullptr), size_(0) {
   status_ = env_->HasAtomicMove(prefix_, &use_temp_file_);
@@ -813,10 +935,44 @@ BundleReader::~BundleReader() {
   for (auto& temp : tensor_slices_) {
     delete temp.second;
   }
+  for (auto& temp : mapped_data_) {
+    if (temp.second != nullptr) {
+      temp.second->Unref();
+    }
+  }
   data_.clear();
   tensor_slices_.clear();
 }
 
+Status BundleReader::GetBundleEntryProtos(
+    const std::vector<string>& keys, std::vector<BundleEntryProto>* entries) {
+  TF_CHECK_OK(status_);
+  entries->clear();
+  entries->resize(keys.size());
+  const std::vector<StringPiece> key_pieces(keys.begin(), keys.end());
+  // Written concurrently for different keys, so not a vector<bool>.
+  std::vector<char> found(keys.size(), false);
+  std::vector<Status> statuses(keys.size());
+  TF_RETURN_IF_ERROR(table_->MultiGet(
+      key_pieces,
+      [&keys, entries, &found, &statuses](size_t i, const StringPiece& value) {
+        found[i] = true;
+        statuses[i] = ParseEntryProto(keys[i], value, &(*entries)[i]);
+      },
+      BundleReaderPool()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!found[i]) {
+      return errors::NotFound("Key ", keys[i], " not found in checkpoint");
+    }
+    TF_RETURN_IF_ERROR(statuses[i]);
+    if (!TensorShape::IsValid((*entries)[i].shape())) {
+      return errors::DataLoss("Invalid tensor shape: ", keys[i], " ",
+                              (*entries)[i].shape().ShortDebugString());
+    }
+  }
+  return Status::OK();
+}
+
 Status BundleReader::GetBundleEntryProto(StringPiece key,
                                          BundleEntryProto* entry) {
   entry->Clear();
@@ -885,7 +1041,10 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   if (DataTypeCanUseMemcpy(entry.dtype())) {
     char* backing_buffer = const_cast<char*>((ret->tensor_data().data()));
     size_t unused_bytes_read;
-    if (entry.size() > kBufferSize) {
+    if (entry.size() > 2 * kParallelReadChunkSize) {
+      TF_RETURN_IF_ERROR(ReadInParallel(buffered_file->file(), entry.offset(),
+                                        entry.size(), backing_buffer));
+    } else if (entry.size() > kBufferSize) {
       StringPiece sp;
       TF_RETURN_IF_ERROR(buffered_file->file()->Read(
           entry.offset(), entry.size(), &sp, backing_buffer));
@@ -948,6 +1107,81 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::GetMappedDataFile(int32 shard_id, MappedDataFile** file) {
+  auto it = mapped_data_.find(shard_id);
+  if (it == mapped_data_.end()) {
+    const string filename = DataFilename(prefix_, shard_id, num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    MappedDataFile* mapped = nullptr;
+    if (s.ok()) {
+      mapped = new MappedDataFile(std::move(region));
+    } else {
+      VLOG(1) << "Reading " << filename << " without memory mapping: " << s;
+    }
+    it = mapped_data_.emplace(shard_id, mapped).first;
+  }
+  *file = it->second;
+  return Status::OK();
+}
+
+Status BundleReader::ReadCurrentMapped(Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(ParseEntryProto(iter_->key(), iter_->value(), &entry));
+  if (!TensorShape::IsValid(entry.shape())) {
+    return errors::DataLoss("Invalid tensor shape: ", iter_->key(), " ",
+                            entry.shape().ShortDebugString());
+  }
+  MappedDataFile* mapped = nullptr;
+  if (entry.slices().empty() && DataTypeCanUseMemcpy(entry.dtype()) &&
+      !need_to_swap_bytes_ && entry.size() > 0) {
+    TF_RETURN_IF_ERROR(GetMappedDataFile(entry.shard_id(), &mapped));
+  }
+  if (mapped == nullptr) {
+    return ReadCurrent(val);
+  }
+
+  const TensorShape shape(entry.shape());
+  const size_t expected_size =
+      shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (entry.offset() > mapped->size() ||
+      entry.size() > mapped->size() - entry.offset()) {
+    return errors::DataLoss("Bundle entry ", key(), " at offset ",
+                            entry.offset(), " (", entry.size(),
+                            " bytes) exceeds the size of its data file, ",
+                            mapped->size(), " bytes");
+  }
+  const char* data = mapped->base<const char>() + entry.offset();
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+
+  if (reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment !=
+      0) {
+    // The data cannot back a tensor directly, but copying it out of the
+    // mapping still avoids the buffered file reads.
+    *val = Tensor(entry.dtype(), shape);
+    std::memcpy(const_cast<char*>(val->tensor_data().data()), data,
+                entry.size());
+    return Status::OK();
+  }
+  auto* buffer = new MappedTensorBuffer(mapped, data, entry.size());
+  *val = Tensor(entry.dtype(), shape, buffer);
+  buffer->Unref();
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1025,22 +1259,28 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
         " to restore in slice_spec: ", slice_spec.DebugString());
   }
 
+  // Looks up the entries of all stored slices at once, which reads each index
+  // block once no matter how many slices it holds.  We already have the entry
+  // for the full tensor, so don't query again if the slice is full.
+  std::vector<string> stored_slice_keys;
+  for (const auto& slice_tag_pair : details) {
+    if (!slice_tag_pair.first.IsFull()) {
+      stored_slice_keys.push_back(checkpoint::EncodeTensorNameSlice(
+          full_tensor_key_string, slice_tag_pair.first));
+    }
+  }
+  std::vector<BundleEntryProto> stored_slice_entries;
+  status_ = GetBundleEntryProtos(stored_slice_keys, &stored_slice_entries);
+  if (!status_.ok()) return status_;
+
   // The union of the slices in "details" covers "slice_spec".  Performs the
   // copies from each.
   BundleEntryProto stored_slice_entry = full_tensor_entry;
+  size_t next_stored_slice_entry = 0;
   for (const auto& slice_tag_pair : details) {
-    // Seeks for the stored slice.
     const TensorSlice& stored_slice = slice_tag_pair.first;
-
-    // We already have the entry for the full tensor, so don't query again if
-    // the slice is full.
     if (!stored_slice.IsFull()) {
-      const string encoded_stored_slice_name =
-          checkpoint::EncodeTensorNameSlice(full_tensor_key_string,
-                                            stored_slice);
-      status_ =
-          GetBundleEntryProto(encoded_stored_slice_name, &stored_slice_entry);
-      if (!status_.ok()) return status_;
+      stored_slice_entry.Swap(&stored_slice_entries[next_stored_slice_entry++]);
     }
 
     // TODO(zongheng): should we take an OpKernelContext, so that we can call
@@ -228,6 +228,20 @@ class BundleReader {
   // REQUIRES: status().ok() && Valid()
   Status ReadCurrent(Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like ReadCurrent(), but reads through a memory mapping of the data file
+  // when the file system supports it.  If the tensor is of a memcpy-able type
+  // and its data is aligned to Allocator::kAllocatorAlignment (see
+  // BundleWriter::Options::data_alignment), "val" is set to a read-only view
+  // of the mapped bytes instead of a copy.  The view keeps the mapping alive
+  // after the reader is destroyed, and is never forwarded to a kernel output.
+  //
+  // Bundles of a different endianness, partitioned tensors and tensors of
+  // other types are read as by ReadCurrent().
+  //
+  // Validates the stored crc32c checksum against the mapped bytes.
+  // REQUIRES: status().ok() && Valid()
+  Status ReadCurrentMapped(Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the slices of the tensor keyed by "key".  On OK, "slices"
   // is non-empty if and only if the tensor is a partitioned tensor.
   //
@@ -265,17 +279,31 @@ class BundleReader {
   string DebugString();
 
  private:
+  class MappedDataFile;
+
   // Seeks for "key" and reads the metadata proto.
   // On non-OK return, clears "entry" for the caller.
   // REQUIRES: status().ok()
   Status GetBundleEntryProto(StringPiece key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  // Like GetBundleEntryProto() for each of "keys", but reads each index block
+  // that holds any of them only once, decoding the blocks in parallel.
+  // REQUIRES: status().ok()
+  Status GetBundleEntryProtos(const std::vector<string>& keys,
+                              std::vector<BundleEntryProto>* entries)
+      TF_MUST_USE_RESULT;
+
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Sets "*file" to the memory mapping of data file "shard_id", or to nullptr
+  // if it cannot be mapped.
+  Status GetMappedDataFile(int32 shard_id,
+                           MappedDataFile** file) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -294,6 +322,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // Memory mappings of the data files, populated on-demand by
+  // ReadCurrentMapped().  Holds a reference on each mapping; nullptr for
+  // files that cannot be mapped.
+  std::unordered_map<int32, MappedDataFile*> mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
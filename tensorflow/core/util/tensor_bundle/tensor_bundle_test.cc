@@ -992,6 +992,43 @@ TEST(TensorBundleTest, TruncatedTensorContents) {
   EXPECT_TRUE(errors::IsOutOfRange(reader.Lookup("key", &val)));
 }
 
+TEST(TensorBundleTest, LargeTensorParallelRead) {
+  // Large enough to be read with several concurrent range reads, and not a
+  // multiple of the read chunk size.
+  const int64 kNumElements = (40 << 20) / sizeof(float) + 3;
+  Tensor large(DT_FLOAT, TensorShape({kNumElements}));
+  auto large_flat = large.flat<float>();
+  for (int64 i = 0; i < kNumElements; ++i) {
+    large_flat(i) = static_cast<float>(i % 1000003);
+  }
+
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("large"));
+    TF_EXPECT_OK(writer.Add("large", large));
+    TF_EXPECT_OK(writer.Add("small", Constant_2x3<float>(1.0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleReader reader(env, Prefix("large"));
+    TF_ASSERT_OK(reader.status());
+    Expect<float>(&reader, "large", large);
+    Expect<float>(&reader, "small", Constant_2x3<float>(1.0));
+  }
+
+  // Truncating the data file makes the last chunk read fail.
+  const string datafile = DataFilename(Prefix("large"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(env, datafile, &data));
+  const size_t truncated_size = kNumElements * sizeof(float) - 1;
+  TF_ASSERT_OK(WriteStringToFile(env, datafile,
+                                 StringPiece(data.data(), truncated_size)));
+  BundleReader reader(env, Prefix("large"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val(DT_FLOAT, TensorShape({kNumElements}));
+  EXPECT_FALSE(reader.Lookup("large", &val).ok());
+}
+
 TEST(TensorBundleTest, HeaderEntry) {
   {
     BundleWriter writer(Env::Default(), Prefix("b"));
@@ -1059,6 +1096,74 @@ TEST(TensorBundleTest, VersionTest) {
   }
 }
 
+TEST(TensorBundleTest, ReadCurrentMapped) {
+  for (int alignment : {1, 64}) {
+    const string prefix = Prefix(strings::StrCat("mapped_", alignment));
+    {
+      BundleWriter::Options opts;
+      opts.data_alignment = alignment;
+      BundleWriter writer(Env::Default(), prefix, opts);
+      TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1.5)));
+      TF_EXPECT_OK(writer.Add("b", Constant_2x3<tstring>("bundle")));
+      TF_EXPECT_OK(writer.Add("c", Constant(7, TensorShape({5}))));
+      TF_ASSERT_OK(writer.Finish());
+    }
+    Tensor a;
+    Tensor c;
+    Tensor c_again;
+    {
+      BundleReader reader(Env::Default(), prefix);
+      TF_ASSERT_OK(reader.status());
+      reader.Next();  // Skips the header entry.
+      ASSERT_TRUE(reader.Valid());
+      TF_ASSERT_OK(reader.ReadCurrentMapped(&a));
+      reader.Next();
+      Tensor b;
+      TF_ASSERT_OK(reader.ReadCurrentMapped(&b));
+      test::ExpectTensorEqual<tstring>(b, Constant_2x3<tstring>("bundle"));
+      reader.Next();
+      TF_ASSERT_OK(reader.ReadCurrentMapped(&c));
+      TF_ASSERT_OK(reader.ReadCurrentMapped(&c_again));
+      reader.Next();
+      EXPECT_FALSE(reader.Valid());
+    }
+    // Mapped tensors stay valid after the reader is gone.
+    test::ExpectTensorEqual<float>(a, Constant_2x3<float>(1.5));
+    test::ExpectTensorEqual<int>(c, Constant(7, TensorShape({5})));
+    test::ExpectTensorEqual<int>(c_again, Constant(7, TensorShape({5})));
+    // "c" follows the variable-length string data, so it is only aligned
+    // (and hence shared with the mapping) when the writer pads it.
+    if (alignment == 64) {
+      EXPECT_EQ(c.tensor_data().data(), c_again.tensor_data().data());
+    } else {
+      EXPECT_NE(c.tensor_data().data(), c_again.tensor_data().data());
+    }
+  }
+}
+
+TEST(TensorBundleTest, ReadCurrentMappedChecksum) {
+  const string prefix = Prefix("mapped_checksum");
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), prefix, opts);
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Flips a byte of the tensor data.
+  const string data_path = DataFilename(prefix, 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), data_path, &data));
+  data[0] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), data_path, data));
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  reader.Next();
+  Tensor a;
+  EXPECT_TRUE(errors::IsDataLoss(reader.ReadCurrentMapped(&a)));
+}
+
 class TensorBundleAlignmentTest : public ::testing::Test {
  protected:
   template <typename T>
@@ -75,6 +75,17 @@ class MMAPAllocation : public Allocation {
 
   int fd() const { return mmap_fd_; }
 
+  // Hints the OS to read the pages covering [ptr, ptr + bytes) ahead of their
+  // use. The range is clamped to the mapping. Returns false if the hint could
+  // not be given.
+  bool Prefetch(const void* ptr, size_t bytes) const;
+
+  // Hints the OS that the pages lying entirely within [ptr, ptr + bytes) are
+  // not needed for now, so that they can leave the resident set. They are read
+  // back from the file on their next access. Returns false if the hint could
+  // not be given.
+  bool Release(const void* ptr, size_t bytes) const;
+
   static bool IsSupported();
 
  protected:
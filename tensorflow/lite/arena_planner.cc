@@ -32,6 +32,9 @@ namespace {
 
 constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
 
+// Number of arena plans ArenaPlanner keeps for different tensor sizes.
+constexpr int kMaxCachedArenaPlans = 8;
+
 }  // namespace
 
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
@@ -82,6 +85,7 @@ TfLiteStatus ArenaPlanner::ResetAllocationsAfter(int node) {
 TfLiteStatus ArenaPlanner::PlanAllocations() {
   // Invalidate any existing data.
   TF_LITE_ENSURE_STATUS(ResetAllocations());
+  cached_arena_plans_.clear();
   // Maybe other verb instead of 'Assigned'
   alloc_node_.assign(graph_info_->num_tensors(), kNodeNotAssigned);
   dealloc_node_.assign(graph_info_->num_tensors(), kNodeNotAssigned);
@@ -178,11 +182,39 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
     }
   }
 
+  // Tensors of nodes executed in groups are live over their whole first and
+  // last groups, as all nodes of a group may run at the same time. Groups set
+  // for a different execution plan are dropped.
+  if (node_groups_.size() != graph_info_->num_execution_nodes()) {
+    node_groups_.clear();
+  }
+  if (!node_groups_.empty()) {
+    for (size_t i = 0; i < alloc_node_.size(); ++i) {
+      if (alloc_node_[i] != kNodeNotAssigned) {
+        alloc_node_[i] = NodeGroup(alloc_node_[i]);
+      }
+      if (dealloc_node_[i] != kNodeNotAssigned) {
+        dealloc_node_[i] = NodeGroup(dealloc_node_[i]);
+      }
+    }
+  }
+
   // Note that graph outputs will never be scheduled for deallocation. We
   // could do that here for completeness, but it won't have any effect.
   return kTfLiteOk;
 }
 
+void ArenaPlanner::SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+  offline_offsets_ = std::move(offsets);
+  cached_arena_plans_.clear();
+}
+
+TfLiteStatus ArenaPlanner::SetConcurrentNodeGroups(
+    const std::vector<int>& node_groups) {
+  node_groups_ = node_groups;
+  return PlanAllocations();
+}
+
 TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   // Grow the size of `allocs_` if necessary. This allows allocating temporary
   // tensors in op's `prepare` function.
@@ -198,9 +230,9 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
     TfLiteIntArray* node_temporaries = node.temporaries;
     for (int j = 0; j < node_temporaries->size; ++j) {
       int tensor_index = node_temporaries->data[j];
-      alloc_node_[tensor_index] = i;
+      alloc_node_[tensor_index] = NodeGroup(i);
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] = NodeGroup(i);
       }
     }
   }
@@ -310,10 +342,55 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
     }
   }
 
+  // A plan for an empty arena only depends on the sizes and usage intervals of
+  // the tensors, in order, so it may have been computed before.
+  std::vector<size_t> plan_key;
+  const bool plan_is_cacheable = first_node == 0 && !arena_.HasAllocations();
+  bool plan_is_cached = false;
+  if (plan_is_cacheable) {
+    for (const auto& tensor_index : tensor_order) {
+      const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+      if (tensor.allocation_type == kTfLiteArenaRw) {
+        plan_key.insert(plan_key.end(),
+                        {static_cast<size_t>(tensor_index), tensor.bytes,
+                         static_cast<size_t>(alloc_node_[tensor_index]),
+                         static_cast<size_t>(dealloc_node_[tensor_index])});
+      }
+    }
+    auto it = cached_arena_plans_.find(plan_key);
+    if (it != cached_arena_plans_.end()) {
+      arena_.RestorePlan(it->second.arena_plan);
+      for (const auto& alloc : it->second.allocs) {
+        allocs_[alloc.tensor] = alloc;
+      }
+      plan_is_cached = true;
+    }
+  }
+
+  // Tensors with an offline planned offset are placed first, so that the
+  // remaining ones fill the gaps around them.
+  std::vector<bool> offline_planned;
+  if (plan_is_cacheable && !plan_is_cached &&
+      CanUseOfflinePlannedOffsets(tensor_order)) {
+    offline_planned.resize(graph_info_->num_tensors());
+    for (const auto& tensor_index : tensor_order) {
+      const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+      if (tensor.allocation_type == kTfLiteArenaRw &&
+          offline_offsets_[tensor_index] >= 0) {
+        TF_LITE_ENSURE_STATUS(arena_.AllocateAt(
+            context_, tensor_alignment_, offline_offsets_[tensor_index],
+            tensor.bytes, tensor_index, alloc_node_[tensor_index],
+            dealloc_node_[tensor_index], &allocs_[tensor_index]));
+        offline_planned[tensor_index] = true;
+      }
+    }
+  }
+
   // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : tensor_order) {
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-    if (tensor.allocation_type == kTfLiteArenaRw) {
+    if (tensor.allocation_type == kTfLiteArenaRw && !plan_is_cached &&
+        (offline_planned.empty() || !offline_planned[tensor_index])) {
       TF_LITE_ENSURE_STATUS(
           arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
                           tensor_index, alloc_node_[tensor_index],
@@ -329,9 +406,59 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
           &allocs_[tensor_index]));
     }
   }
+
+  if (plan_is_cacheable && !plan_is_cached) {
+    if (cached_arena_plans_.size() >= kMaxCachedArenaPlans) {
+      cached_arena_plans_.erase(cached_arena_plans_.begin());
+    }
+    CachedArenaPlan& cached_plan = cached_arena_plans_[std::move(plan_key)];
+    cached_plan.arena_plan = arena_.GetPlan();
+    for (const auto& tensor_index : tensor_order) {
+      if (graph_info_->tensor(tensor_index)->allocation_type ==
+          kTfLiteArenaRw) {
+        cached_plan.allocs.push_back(allocs_[tensor_index]);
+      }
+    }
+  }
   return kTfLiteOk;
 }
 
+bool ArenaPlanner::CanUseOfflinePlannedOffsets(
+    const std::vector<int32_t>& tensor_order) const {
+  if (offline_offsets_.size() != graph_info_->num_tensors()) {
+    return false;
+  }
+  std::vector<ArenaAllocWithUsageInterval> planned;
+  for (const auto& tensor_index : tensor_order) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    const int32_t offset = offline_offsets_[tensor_index];
+    if (tensor.allocation_type != kTfLiteArenaRw || offset < 0) continue;
+    if (offset % tensor_alignment_ != 0) return false;
+    if (tensor.bytes == 0) continue;
+    ArenaAllocWithUsageInterval alloc;
+    alloc.offset = offset;
+    alloc.size = tensor.bytes;
+    alloc.tensor = tensor_index;
+    alloc.first_node = alloc_node_[tensor_index];
+    alloc.last_node = dealloc_node_[tensor_index];
+    planned.push_back(alloc);
+  }
+  // The offsets were planned for the sizes and usage intervals the model had
+  // offline, so check that tensors which overlap in memory still don't overlap
+  // in time.
+  std::sort(planned.begin(), planned.end());
+  for (size_t i = 0; i < planned.size(); ++i) {
+    for (size_t j = i + 1; j < planned.size(); ++j) {
+      if (planned[j].offset >= planned[i].offset + planned[i].size) break;
+      if (planned[j].first_node <= planned[i].last_node &&
+          planned[i].first_node <= planned[j].last_node) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
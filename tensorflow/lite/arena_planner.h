@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_ARENA_PLANNER_H_
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -58,6 +59,8 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ResetAllocations() override;
   TfLiteStatus ResetAllocationsAfter(int node) override;
   TfLiteStatus PlanAllocations() override;
+  TfLiteStatus SetConcurrentNodeGroups(
+      const std::vector<int>& node_groups) override;
   TfLiteStatus ExecuteAllocations(int first_node, int last_node) override;
   TfLiteStatus ReleaseNonPersistentMemory() override;
   TfLiteStatus AcquireNonPersistentMemory() override;
@@ -66,6 +69,13 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Sets arena offsets computed ahead of time, e.g. by an offline planner,
+  // indexed by tensor and -1 for tensors left to this planner. They are used
+  // whenever all tensors of the arena are placed from scratch, provided they
+  // are aligned and don't overlap tensors that are live at the same time given
+  // the current tensor sizes. Otherwise they are ignored.
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets);
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -89,6 +99,11 @@ class ArenaPlanner : public MemoryPlanner {
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
 
+  // Returns true if the offline planned offsets can be used to place the
+  // tensors in 'tensor_order'.
+  bool CanUseOfflinePlannedOffsets(
+      const std::vector<int32_t>& tensor_order) const;
+
   // Register an allocation for all internal (temporary) tensors of
   // 'node_index'.
   TfLiteStatus CalculateAllocationOfInternalTensors(int node_index);
@@ -97,6 +112,12 @@ class ArenaPlanner : public MemoryPlanner {
   // 'node_index'.
   TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
 
+  // Returns the group `node` is executed in, or `node` itself when nodes are
+  // executed one at a time.
+  int NodeGroup(int node) const {
+    return node_groups_.empty() ? node : node_groups_[node];
+  }
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -111,6 +132,10 @@ class ArenaPlanner : public MemoryPlanner {
   // the node's operation.
   std::vector<int32_t> dealloc_node_;
 
+  // Group of every execution node, set by SetConcurrentNodeGroups(). When not
+  // empty, alloc_node_ and dealloc_node_ hold groups rather than nodes.
+  std::vector<int> node_groups_;
+
   // Raw memory buffer that is allocated for all temporary and graph outputs
   // that are declared kTfLiteArenaRw.
   SimpleMemoryArena arena_;
@@ -119,6 +144,21 @@ class ArenaPlanner : public MemoryPlanner {
   // declared as kTfLiteArenaRwPersistent.
   SimpleMemoryArena persistent_arena_;
 
+  // Plans of arena_ computed from scratch (i.e. for all nodes after
+  // ResetAllocations()), keyed by the index, size and usage interval of every
+  // tensor they placed. Resizing inputs back to previously seen shapes then
+  // restores the offsets instead of placing every tensor again, which is
+  // quadratic in the number of tensors. Cleared by PlanAllocations().
+  struct CachedArenaPlan {
+    SimpleMemoryArena::Plan arena_plan;
+    std::vector<ArenaAllocWithUsageInterval> allocs;
+  };
+  std::map<std::vector<size_t>, CachedArenaPlan> cached_arena_plans_;
+
+  // Offsets of the tensors of arena_ planned ahead of time, or -1. See
+  // SetOfflinePlannedOffsets().
+  std::vector<int32_t> offline_offsets_;
+
   // If true, then no overlapping of memory areas is done, meaning intermediate
   // tensors and temporary tensors can be queried after running.
   // (modulo running delegates)
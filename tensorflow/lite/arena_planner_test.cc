@@ -292,6 +292,56 @@ TEST_F(ArenaPlannerTest, SimpleGraph) {
   EXPECT_EQ(GetOffset(1), 4);
 }
 
+TEST_F(ArenaPlannerTest, SimpleGraphWithOfflinePlannedOffsets) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  planner_->SetOfflinePlannedOffsets({-1, -1, 100, 64, -1, -1});
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(3), 64);
+  EXPECT_EQ(GetOffset(2), 100);
+  // The rest is placed around them.
+  auto overlap = [this](int t1, int t2) {
+    return GetOffset(t1) < GetOffsetAfter(t2) &&
+           GetOffset(t2) < GetOffsetAfter(t1);
+  };
+  for (int t : {0, 1, 4, 5}) {
+    EXPECT_FALSE(overlap(t, 2));
+    EXPECT_FALSE(overlap(t, 3));
+  }
+  EXPECT_FALSE(overlap(0, 1));
+  EXPECT_FALSE(overlap(4, 5));
+}
+
+TEST_F(ArenaPlannerTest, SimpleGraphWithInvalidOfflinePlannedOffsets) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // Tensors 2 and 4 are both used by the second op.
+  planner_->SetOfflinePlannedOffsets({-1, -1, 64, -1, 64, -1});
+  Execute(0, 10);
+
+  // Same as without offline planned offsets.
+  EXPECT_EQ(GetOffset(5), 12);
+  EXPECT_EQ(GetOffset(4), GetOffsetAfter(5));
+  EXPECT_EQ(GetOffset(3), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(4));
+  EXPECT_EQ(GetOffset(1), 4);
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphInputsPreserved) {
   TestGraph graph({0, 1},
                   {
@@ -759,6 +809,69 @@ TEST_F(ArenaPlannerTest, DebugTensors) {
   EXPECT_EQ(tensorOffsets.size(), 8);
 }
 
+TEST_F(ArenaPlannerTest, ResizeAndRestoreTensorSizes) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, 10);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i <= 5; ++i) {
+    offsets.push_back(GetOffset(i));
+  }
+
+  // Growing an input changes the plan.
+  (*graph.tensors())[0].bytes = 100;
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  EXPECT_GE(GetOffsetAfter(0) - GetOffset(0), 100);
+
+  // Going back to the original sizes gives back the original plan.
+  (*graph.tensors())[0].bytes = 3;
+  CHECK(planner_->ResetAllocations() == kTfLiteOk);
+  Execute(0, 10);
+  for (int i = 0; i <= 5; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]) << "tensor " << i;
+  }
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentNodeGroups) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {5}},  // First op, branch one
+                      {{1}, {2}, {}},   // Second op, branch one
+                      {{0}, {3}, {6}},  // Third op, branch two
+                      {{3}, {4}, {}},   // Fourth op, branch two
+                  },
+                  {2, 4});
+  SetGraph(&graph);
+  // The branches run side by side: first and third ops, then second and
+  // fourth ops.
+  CHECK(planner_->SetConcurrentNodeGroups({0, 1, 0, 1}) == kTfLiteOk);
+  Execute(0, 10);
+
+  auto overlap = [this](int t1, int t2) {
+    return GetOffset(t1) < GetOffsetAfter(t2) &&
+           GetOffset(t2) < GetOffsetAfter(t1);
+  };
+  // Tensors used at the same time by the two branches.
+  EXPECT_FALSE(overlap(1, 3));
+  EXPECT_FALSE(overlap(1, 6));
+  EXPECT_FALSE(overlap(5, 3));
+  EXPECT_FALSE(overlap(5, 6));
+  EXPECT_FALSE(overlap(2, 3));
+  EXPECT_FALSE(overlap(1, 4));
+  // Temporaries of the first group are free again in the second one.
+  EXPECT_TRUE(overlap(5, 2) || overlap(5, 4) || overlap(6, 2) ||
+              overlap(6, 4));
+}
+
 }  // namespace
 }  // namespace tflite
 
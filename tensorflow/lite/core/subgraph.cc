@@ -192,6 +192,21 @@ class SubgraphGuard {
   bool* is_subgraph_in_use_;
 };
 
+// The CPU backend context of the inter-op thread running a node on this
+// thread, if any. It takes precedence over the subgraph's own context, which
+// can't be used by several ops at the same time.
+thread_local TfLiteExternalContext* inter_op_cpu_backend_context = nullptr;
+
+// Makes the calling thread use `context` as its CPU backend context until
+// destroyed.
+class ScopedInterOpCpuBackendContext {
+ public:
+  explicit ScopedInterOpCpuBackendContext(TfLiteExternalContext* context) {
+    inter_op_cpu_backend_context = context;
+  }
+  ~ScopedInterOpCpuBackendContext() { inter_op_cpu_backend_context = nullptr; }
+};
+
 }  // namespace
 
 // A trivial implementation of GraphInfo around the Interpreter.
@@ -465,6 +480,10 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext &&
+      inter_op_cpu_backend_context != nullptr) {
+    return inter_op_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -588,6 +607,106 @@ void Subgraph::SetCancellationFunction(void* data,
   check_cancelled_func_ = check_cancelled_func;
 }
 
+TfLiteStatus Subgraph::SetNumInterOpThreads(int num_threads) {
+  if (num_threads < 1) {
+    ReportError("num_threads should be >= 1.");
+    return kTfLiteError;
+  }
+  concurrent_stages_.clear();
+  inter_op_cpu_backend_contexts_.clear();
+  inter_op_thread_pool_.reset();
+  if (num_threads > 1) {
+    inter_op_thread_pool_.reset(new InterOpThreadPool(num_threads));
+    inter_op_cpu_backend_contexts_.resize(num_threads);
+    for (int i = 1; i < num_threads; ++i) {
+      inter_op_cpu_backend_contexts_[i].reset(new ExternalCpuBackendContext());
+    }
+  }
+  if (memory_planner_) {
+    TF_LITE_ENSURE_STATUS(memory_planner_->SetConcurrentNodeGroups({}));
+  }
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::SetWeightPagingWindow(int num_ops) {
+  if (num_ops < 0) {
+    ReportError("num_ops should be >= 0.");
+    return kTfLiteError;
+  }
+  weight_paging_window_ = num_ops;
+  weight_paging_steps_.clear();
+  state_ = kStateUninvokable;
+  return kTfLiteOk;
+}
+
+namespace {
+
+// Returns the file mapping `tensor` is read from, if it is a weight of a
+// memory-mapped model.
+const MMAPAllocation* GetMappedWeightAllocation(const TfLiteTensor& tensor) {
+  if (tensor.allocation_type != kTfLiteMmapRo || tensor.allocation == nullptr) {
+    return nullptr;
+  }
+  const Allocation* allocation =
+      static_cast<const Allocation*>(tensor.allocation);
+  if (allocation->type() != Allocation::Type::kMMap) return nullptr;
+  return static_cast<const MMAPAllocation*>(allocation);
+}
+
+}  // namespace
+
+void Subgraph::PlanWeightPaging() {
+  weight_paging_steps_.clear();
+  if (weight_paging_window_ == 0 || !MMAPAllocation::IsSupported()) return;
+  const int num_steps = execution_plan_.size();
+  weight_paging_steps_.resize(num_steps);
+  bool has_mapped_weights = false;
+  for (int i = 0; i < num_steps; ++i) {
+    const TfLiteNode& node = nodes_and_registration_[execution_plan_[i]].first;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      if (GetMappedWeightAllocation(tensors_[tensor_index]) != nullptr) {
+        weight_paging_steps_[i].prefetch.push_back(tensor_index);
+        has_mapped_weights = true;
+      }
+    }
+  }
+  if (!has_mapped_weights) {
+    weight_paging_steps_.clear();
+    return;
+  }
+  for (int i = 0; i < num_steps; ++i) {
+    const int window_end = std::min(num_steps, i + 1 + weight_paging_window_);
+    for (int tensor_index : weight_paging_steps_[i].prefetch) {
+      bool read_in_window = false;
+      for (int j = i + 1; j < window_end && !read_in_window; ++j) {
+        const std::vector<int>& next = weight_paging_steps_[j].prefetch;
+        read_in_window =
+            std::find(next.begin(), next.end(), tensor_index) != next.end();
+      }
+      if (!read_in_window) {
+        weight_paging_steps_[i].release.push_back(tensor_index);
+      }
+    }
+  }
+}
+
+void Subgraph::PrefetchWeights(int execution_plan_index) {
+  for (int tensor_index :
+       weight_paging_steps_[execution_plan_index].prefetch) {
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    GetMappedWeightAllocation(tensor)->Prefetch(tensor.data.raw, tensor.bytes);
+  }
+}
+
+void Subgraph::ReleaseWeights(int execution_plan_index) {
+  for (int tensor_index : weight_paging_steps_[execution_plan_index].release) {
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    GetMappedWeightAllocation(tensor)->Release(tensor.data.raw, tensor.bytes);
+  }
+}
+
 bool Subgraph::IsCancelled() {
   return (check_cancelled_func_ != nullptr) &&
          (*check_cancelled_func_)(cancellation_data_);
@@ -729,6 +848,7 @@ TfLiteStatus Subgraph::AllocateTensors() {
   }
 
   TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  PlanWeightPaging();
 
   state_ = kStateInvokable;
 
@@ -993,9 +1113,11 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
 
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   if (!memory_planner_) {
-    memory_planner_.reset(new ArenaPlanner(
+    auto* arena_planner = new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
-        preserve_all_tensors_, kDefaultTensorAlignment));
+        preserve_all_tensors_, kDefaultTensorAlignment);
+    arena_planner->SetOfflinePlannedOffsets(offline_planned_offsets_);
+    memory_planner_.reset(arena_planner);
     memory_planner_->PlanAllocations();
   }
 
@@ -1028,6 +1150,10 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
                            execution_plan_, &last_exec_plan_index_prepared));
   next_execution_plan_index_to_prepare_ = last_exec_plan_index_prepared + 1;
 
+  if (next_execution_plan_index_to_plan_allocation_ == 0) {
+    TF_LITE_ENSURE_STATUS(PlanConcurrentStages());
+  }
+
   // Execute arena allocations.
   TF_LITE_ENSURE_STATUS(memory_planner_->ExecuteAllocations(
       next_execution_plan_index_to_plan_allocation_,
@@ -1056,6 +1182,178 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::EnsureNodeInputsAreReadable(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+bool Subgraph::MustRunAlone(const TfLiteNode& node,
+                            const TfLiteRegistration& registration) const {
+  // Delegate kernels and custom ops make no promise about thread safety, and
+  // control flow ops invoke subgraphs, which are not thread-safe either.
+  if (node.delegate != nullptr ||
+      registration.builtin_code == kTfLiteBuiltinCustom ||
+      registration.builtin_code == kTfLiteBuiltinWhile ||
+      registration.builtin_code == kTfLiteBuiltinIf ||
+      registration.builtin_code == kTfLiteBuiltinCallOnce) {
+    return true;
+  }
+  // Nodes without outputs only run for their side effects.
+  if (node.outputs->size == 0) return true;
+  // Resources, variants and variable tensors carry state between nodes that
+  // isn't visible as a data dependency.
+  for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+    for (int i = 0; i < tensors->size; ++i) {
+      const int tensor_index = tensors->data[i];
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors_[tensor_index];
+      if (tensor.is_variable || tensor.type == kTfLiteResource ||
+          tensor.type == kTfLiteVariant) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+TfLiteStatus Subgraph::PlanConcurrentStages() {
+  std::vector<std::vector<int>> stages;
+  if (inter_op_thread_pool_ && !has_dynamic_tensors_ &&
+      next_execution_plan_index_to_prepare_ == execution_plan_.size()) {
+    // Each node goes to the first stage after those of the nodes producing
+    // its inputs, and after the last node that must run alone.
+    std::vector<int> node_stages(execution_plan_.size());
+    std::vector<int> tensor_stages(tensors_.size(), -1);
+    int num_stages = 0;
+    int first_stage = 0;
+    for (int i = 0; i < execution_plan_.size(); ++i) {
+      const auto& node_and_reg = nodes_and_registration_[execution_plan_[i]];
+      const TfLiteNode& node = node_and_reg.first;
+      int stage = first_stage;
+      if (MustRunAlone(node, node_and_reg.second)) {
+        stage = num_stages;
+        first_stage = stage + 1;
+      } else {
+        for (int j = 0; j < node.inputs->size; ++j) {
+          const int tensor_index = node.inputs->data[j];
+          if (tensor_index == kTfLiteOptionalTensor) continue;
+          stage = std::max(stage, tensor_stages[tensor_index] + 1);
+        }
+      }
+      for (int j = 0; j < node.outputs->size; ++j) {
+        const int tensor_index = node.outputs->data[j];
+        if (tensor_index == kTfLiteOptionalTensor) continue;
+        tensor_stages[tensor_index] = stage;
+      }
+      node_stages[i] = stage;
+      num_stages = std::max(num_stages, stage + 1);
+    }
+    // Stick to the execution plan if no two nodes can run concurrently.
+    if (num_stages < execution_plan_.size()) {
+      stages.resize(num_stages);
+      for (int i = 0; i < execution_plan_.size(); ++i) {
+        stages[node_stages[i]].push_back(i);
+      }
+    }
+  }
+
+  if (stages == concurrent_stages_) return kTfLiteOk;
+  concurrent_stages_ = std::move(stages);
+  std::vector<int> node_groups;
+  if (!concurrent_stages_.empty()) {
+    node_groups.resize(execution_plan_.size());
+    for (int stage = 0; stage < concurrent_stages_.size(); ++stage) {
+      for (int execution_plan_index : concurrent_stages_[stage]) {
+        node_groups[execution_plan_index] = stage;
+      }
+    }
+  }
+  return memory_planner_->SetConcurrentNodeGroups(node_groups);
+}
+
+TfLiteStatus Subgraph::InvokeConcurrentStages() {
+  for (const std::vector<int>& stage : concurrent_stages_) {
+    // Copying tensors out of delegates is left to the calling thread.
+    for (int execution_plan_index : stage) {
+      const auto& node_and_reg =
+          nodes_and_registration_[execution_plan_[execution_plan_index]];
+      TF_LITE_ENSURE_STATUS(
+          EnsureNodeInputsAreReadable(node_and_reg.first, node_and_reg.second));
+    }
+
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+
+    EnsureTensorsVectorCapacity();
+    std::vector<TfLiteStatus> statuses(stage.size(), kTfLiteOk);
+    auto invoke_node = [&](int task_index, int thread_index) {
+      const int node_index = execution_plan_[stage[task_index]];
+      TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const TfLiteRegistration& registration =
+          nodes_and_registration_[node_index].second;
+
+      const char* op_name = nullptr;
+      if (profiler_) op_name = GetTFLiteOpName(registration);
+      TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), op_name,
+                                            node_index);
+      ScopedInterOpCpuBackendContext cpu_backend_context(
+          inter_op_cpu_backend_contexts_[thread_index].get());
+      statuses[task_index] = OpInvoke(registration, &node);
+    };
+    // Profilers aren't thread-safe.
+    if (profiler_) {
+      for (int i = 0; i < stage.size(); ++i) invoke_node(i, 0);
+    } else {
+      inter_op_thread_pool_->Run(stage.size(), invoke_node);
+    }
+
+    for (int i = 0; i < stage.size(); ++i) {
+      if (statuses[i] != kTfLiteOk) {
+        const int node_index = execution_plan_[stage[i]];
+        return ReportOpError(&context_,
+                             nodes_and_registration_[node_index].first,
+                             nodes_and_registration_[node_index].second,
+                             node_index, "failed to invoke");
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::Invoke() {
   SubgraphGuard guard(&context_, &is_subgraph_in_use_);
   TF_LITE_ENSURE_OK(&context_, guard.status());
@@ -1075,6 +1373,18 @@ TfLiteStatus Subgraph::Invoke() {
   }
   TFLITE_SCOPED_TAGGED_DEFAULT_PROFILE(profiler_.get(), "Invoke");
 
+  if (!concurrent_stages_.empty()) {
+    return InvokeConcurrentStages();
+  }
+
+  const bool page_weights = !weight_paging_steps_.empty();
+  if (page_weights) {
+    for (int i = 0;
+         i < weight_paging_window_ && i < weight_paging_steps_.size(); ++i) {
+      PrefetchWeights(i);
+    }
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1095,37 +1405,7 @@ TfLiteStatus Subgraph::Invoke() {
     if (profiler_) op_name = GetTFLiteOpName(registration);
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node, registration));
 
     if (check_cancelled_func_ != nullptr &&
         check_cancelled_func_(cancellation_data_)) {
@@ -1133,12 +1413,18 @@ TfLiteStatus Subgraph::Invoke() {
       return kTfLiteError;
     }
 
+    const int prefetch_index = execution_plan_index + weight_paging_window_;
+    if (page_weights && prefetch_index < weight_paging_steps_.size()) {
+      PrefetchWeights(prefetch_index);
+    }
+
     EnsureTensorsVectorCapacity();
     tensor_resized_since_op_invoke_ = false;
     if (OpInvoke(registration, &node) != kTfLiteOk) {
       return ReportOpError(&context_, node, registration, node_index,
                            "failed to invoke");
     }
+    if (page_weights) ReleaseWeights(execution_plan_index);
 
     // Force execution prep for downstream ops if the latest op triggered the
     // resize of a dynamic tensor.
@@ -31,6 +31,8 @@ limitations under the License.
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/inter_op_thread_pool.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/util.h"
 
@@ -266,6 +268,28 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  // Runs nodes that don't depend on each other concurrently, on up to
+  // `num_threads` threads, from the next AllocateTensors() on. 1 (the default)
+  // runs nodes one at a time. Each thread uses a CPU backend context of its
+  // own, so consider reducing the number of threads of the interpreter, which
+  // every op may still use, accordingly.
+  //
+  // Nodes still run one at a time when the graph has dynamic tensors or a
+  // profiler is set. Delegated nodes, custom ops, control flow ops and ops
+  // using resources or variable tensors never run concurrently with others.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  // Pages the weights of memory-mapped models in and out along the execution
+  // plan, from the next AllocateTensors() on: the weights of the next
+  // `num_ops` nodes are prefetched ahead of their use, and the weights of
+  // each node are released after it ran unless one of those nodes reads
+  // them too. This bounds the resident set of models larger than the available
+  // memory. 0 (the default) leaves paging to the OS. Only applies when nodes
+  // run one at a time.
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetWeightPagingWindow(int num_ops);
+
   // Ensure the data in `tensor.data` is readable. In case delegate is used,
   // it might require to copy the data from delegate buffer to raw memory.
   // WARNING: This is an experimental API and subject to change.
@@ -350,6 +374,16 @@ class Subgraph {
   void SetName(const char* name);
   const std::string& GetName() const;
 
+  // Sets arena offsets of the tensors planned ahead of time, indexed by tensor
+  // and -1 for tensors planned at runtime, e.g. from the
+  // "OfflineMemoryAllocation" model metadata. Must be called before the first
+  // AllocateTensors(). The offsets are ignored if they no longer fit the
+  // tensor sizes. See ArenaPlanner::SetOfflinePlannedOffsets().
+  // WARNING: This is an experimental API and subject to change.
+  void SetOfflinePlannedOffsets(std::vector<int32_t> offsets) {
+    offline_planned_offsets_ = std::move(offsets);
+  }
+
  private:
   friend class TestDelegate;
   // SubgraphAwareProfiler wraps an actual TFLite profiler, such as a
@@ -441,6 +475,33 @@ class Subgraph {
                                     const std::vector<int>& execution_plan,
                                     int* last_execution_plan_index_prepared);
 
+  // Groups the execution plan into concurrent_stages_ once all ops have been
+  // prepared, and plans memory so that the nodes of each stage can run at the
+  // same time. Leaves concurrent_stages_ empty when nodes must run one at a
+  // time.
+  TfLiteStatus PlanConcurrentStages();
+
+  // Invokes the nodes of concurrent_stages_, one stage after the other.
+  TfLiteStatus InvokeConcurrentStages();
+
+  // Fills weight_paging_steps_ for the current execution plan, or clears it
+  // if weight paging is disabled.
+  void PlanWeightPaging();
+
+  // Prefetches, respectively releases, the weights listed by
+  // weight_paging_steps_ for `execution_plan_index`.
+  void PrefetchWeights(int execution_plan_index);
+  void ReleaseWeights(int execution_plan_index);
+
+  // Checks that the inputs of `node` can be read, copying them from delegate
+  // buffers if needed.
+  TfLiteStatus EnsureNodeInputsAreReadable(
+      const TfLiteNode& node, const TfLiteRegistration& registration);
+
+  // Returns true if `node` must not run concurrently with any other node.
+  bool MustRunAlone(const TfLiteNode& node,
+                    const TfLiteRegistration& registration) const;
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -721,6 +782,34 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // Threads running the nodes of a concurrent stage, or null if nodes run one
+  // at a time. See SetNumInterOpThreads().
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // CPU backend contexts of the threads of inter_op_thread_pool_, by thread
+  // index. The calling thread, index 0, uses the subgraph's own context.
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      inter_op_cpu_backend_contexts_;
+
+  // Execution plan indices grouped into stages, in execution order, such that
+  // no node depends on another node of its stage. Empty if nodes run one at a
+  // time, in execution plan order.
+  std::vector<std::vector<int>> concurrent_stages_;
+
+  // Number of nodes whose weights are prefetched ahead of their execution, or
+  // 0 if weight paging is disabled. See SetWeightPagingWindow().
+  int weight_paging_window_ = 0;
+
+  // Memory-mapped weight tensors to page, by execution plan index.
+  struct WeightPagingStep {
+    // Mapped weights read by the node.
+    std::vector<int> prefetch;
+    // Mapped weights read by the node and by none of the nodes of the window
+    // that follows it.
+    std::vector<int> release;
+  };
+  std::vector<WeightPagingStep> weight_paging_steps_;
+
   // Contains <tensor idx, custom allocation> pairs for all applicable tensors.
   std::vector<std::pair<int, TfLiteCustomAllocation>> custom_allocations_;
 
@@ -760,6 +849,9 @@ class Subgraph {
   // debugging.
   bool preserve_all_tensors_ = false;
 
+  // Arena offsets planned ahead of time. See SetOfflinePlannedOffsets().
+  std::vector<int32_t> offline_planned_offsets_;
+
   // Whether the subgraph is currently in use (e.g. running the `Invoke`
   // or `AllocateTensors` functions).
   bool is_subgraph_in_use_ = false;
@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow/lite/delegates/gpu/delegate.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/common.h"
@@ -69,6 +74,52 @@ InferenceUsage ToUsage(int32_t usage) {
   return InferenceUsage::UNKNOWN;
 }
 
+// Continues the 64-bit FNV-1a hash `hash` with `size` bytes of `data`. Unlike
+// std::hash, the result is stable across builds, which matters for names of
+// files that outlive the process.
+uint64_t Fnv1aHash(const void* data, size_t size,
+                   uint64_t hash = 0xcbf29ce484222325ULL) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+absl::Status ReadFile(const std::string& path, std::vector<uint8_t>* data) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return absl::NotFoundError(absl::StrCat("Cannot open ", path));
+  }
+  data->resize(file.tellg());
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(data->data()), data->size())) {
+    data->clear();
+    return absl::DataLossError(absl::StrCat("Cannot read ", path));
+  }
+  return absl::OkStatus();
+}
+
+// Writes through a temporary file, so that a concurrent or interrupted writer
+// never leaves a truncated file behind at `path`.
+absl::Status WriteFile(const std::string& path,
+                       const std::vector<uint8_t>& data) {
+  const std::string temp_path = absl::StrCat(path, ".tmp");
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file ||
+        !file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+      std::remove(temp_path.c_str());
+      return absl::UnavailableError(absl::StrCat("Cannot write ", temp_path));
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    return absl::UnavailableError(absl::StrCat("Cannot rename to ", path));
+  }
+  return absl::OkStatus();
+}
+
 // Forward declarations.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
 
@@ -86,6 +137,16 @@ class Delegate {
     if (options_.max_delegated_partitions <= 0) {
       options_.max_delegated_partitions = 1;
     }
+    // Keep copies of the strings, the caller only has to keep them alive
+    // until the delegate is created.
+    if ((options_.experimental_flags &
+         TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION) &&
+        options_.serialization_dir && options_.model_token) {
+      serialization_dir_ = options_.serialization_dir;
+      model_token_ = options_.model_token;
+    }
+    options_.serialization_dir = nullptr;
+    options_.model_token = nullptr;
   }
 
   TfLiteDelegate* tflite_delegate() { return &delegate_; }
@@ -100,9 +161,30 @@ class Delegate {
   }
   int num_delegate_kernels() const { return num_delegate_kernels_; }
 
+  bool IsSerializationEnabled() const {
+    return !serialization_dir_.empty() && !model_token_.empty();
+  }
+  // Returns the path prefix of the files holding the serialized data of the
+  // partition made of `nodes`.
+  std::string SerializationPathPrefix(const TfLiteIntArray* nodes) const {
+    uint64_t hash = Fnv1aHash(model_token_.data(), model_token_.size());
+    hash = Fnv1aHash(nodes->data, nodes->size * sizeof(nodes->data[0]), hash);
+    // The serialized inference context is only valid for the options it was
+    // built with.
+    const int64_t options[] = {
+        options_.is_precision_loss_allowed, options_.inference_preference,
+        options_.inference_priority1,       options_.inference_priority2,
+        options_.inference_priority3,       options_.experimental_flags};
+    hash = Fnv1aHash(options, sizeof(options), hash);
+    return absl::StrCat(serialization_dir_, "/gpu_delegate_",
+                        absl::Hex(hash, absl::kZeroPad16));
+  }
+
  private:
   TfLiteDelegate delegate_;
   TfLiteGpuDelegateOptionsV2 options_;
+  std::string serialization_dir_;
+  std::string model_token_;
   int num_delegate_kernels_ = 0;
 
   friend class DelegateKernel;
@@ -127,19 +209,23 @@ class DelegateKernel {
     std::vector<uint32_t> output_refs;
     RETURN_IF_ERROR(InitializeGraph(context, delegate_params, &graph,
                                     &input_refs, &output_refs));
+    if (delegate_->IsSerializationEnabled()) {
+      serialization_path_prefix_ =
+          delegate_->SerializationPathPrefix(delegate_params->nodes_to_replace);
+    }
 
     std::unique_ptr<InferenceBuilder> builder;
     bool graph_is_destroyed;
     const int experimental_flags = delegate_->options().experimental_flags;
     if (experimental_flags & TFLITE_GPU_EXPERIMENTAL_FLAGS_CL_ONLY) {
-      RETURN_IF_ERROR(
-          InitializeOpenClApi(&graph, &builder, &graph_is_destroyed));
+      RETURN_IF_ERROR(InitializeOpenClApi(&graph, input_refs, output_refs,
+                                          &builder, &graph_is_destroyed));
     } else if (experimental_flags & TFLITE_GPU_EXPERIMENTAL_FLAGS_GL_ONLY) {
       RETURN_IF_ERROR(InitializeOpenGlApi(&graph, &builder));
     } else {
       // By default, we try CL first & fall back to GL if that fails.
-      absl::Status status =
-          InitializeOpenClApi(&graph, &builder, &graph_is_destroyed);
+      absl::Status status = InitializeOpenClApi(
+          &graph, input_refs, output_refs, &builder, &graph_is_destroyed);
       if (!status.ok()) {
         TF_LITE_KERNEL_LOG(context, std::string(status.message()).c_str());
         TF_LITE_KERNEL_LOG(context, "Falling back to OpenGL");
@@ -282,10 +368,25 @@ class DelegateKernel {
   }
 
   absl::Status InitializeOpenClApi(GraphFloat32* graph,
+                                   const std::vector<uint32_t>& input_refs,
+                                   const std::vector<uint32_t>& output_refs,
                                    std::unique_ptr<InferenceBuilder>* builder,
                                    bool* graph_is_destroyed) {
     *graph_is_destroyed = false;
     cl::InferenceEnvironmentOptions env_options;
+    std::vector<uint8_t> serialized_model;
+    const bool use_serialization = !serialization_path_prefix_.empty();
+    if (use_serialization) {
+      // Missing or unreadable files only mean that nothing was serialized yet;
+      // everything is rebuilt and written below in that case.
+      ReadFile(absl::StrCat(serialization_path_prefix_, ".programs"),
+               &serialized_binary_cache_)
+          .IgnoreError();
+      ReadFile(absl::StrCat(serialization_path_prefix_, ".model"),
+               &serialized_model)
+          .IgnoreError();
+      env_options.serialized_binary_cache = serialized_binary_cache_;
+    }
     cl::InferenceEnvironmentProperties properties;
     RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
                                                 &properties));
@@ -306,14 +407,90 @@ class DelegateKernel {
       }
     }
     options.usage = ToUsage(delegate_options.inference_preference);
+    if (!use_serialization) {
+      *graph_is_destroyed = true;
+      RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
+          options, std::move(*graph), builder));
+      TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
+                           "Initialized OpenCL-based API.");
+      return absl::OkStatus();
+    }
+
+    if (!serialized_model.empty()) {
+      const absl::Status status = RestoreOpenClModel(
+          serialized_model, input_refs, output_refs, builder);
+      if (status.ok()) {
+        // The program cache is discarded when the OpenCL driver changed, in
+        // which case the programs were compiled from source again.
+        const std::vector<uint8_t> binary_cache =
+            cl_environment_->GetSerializedBinaryCache();
+        if (binary_cache != serialized_binary_cache_) {
+          WriteSerializedData(/*serialized_model=*/nullptr, binary_cache);
+        }
+        TFLITE_LOG_PROD_ONCE(
+            tflite::TFLITE_LOG_INFO,
+            "Initialized OpenCL-based API from serialized data.");
+        return absl::OkStatus();
+      }
+      TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                      "Ignoring serialized GPU delegate data: %s",
+                      std::string(status.message()).c_str());
+      serialized_model.clear();
+    }
     *graph_is_destroyed = true;
+    RETURN_IF_ERROR(cl_environment_->BuildSerializedModel(
+        options, std::move(*graph), &serialized_model));
     RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
-        options, std::move(*graph), builder));
+        serialized_model, builder, /*in_refs=*/nullptr, /*out_refs=*/nullptr));
+    WriteSerializedData(&serialized_model,
+                        cl_environment_->GetSerializedBinaryCache());
     TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                          "Initialized OpenCL-based API.");
     return absl::OkStatus();
   }
 
+  // Writes the serialized inference context, unless `serialized_model` is
+  // null, and the compiled programs. Failing to write only costs the next
+  // initialization its speedup, so errors are merely logged.
+  void WriteSerializedData(const std::vector<uint8_t>* serialized_model,
+                           const std::vector<uint8_t>& binary_cache) {
+    absl::Status status = absl::OkStatus();
+    if (serialized_model) {
+      status = WriteFile(absl::StrCat(serialization_path_prefix_, ".model"),
+                         *serialized_model);
+    }
+    if (status.ok()) {
+      status = WriteFile(absl::StrCat(serialization_path_prefix_, ".programs"),
+                         binary_cache);
+    }
+    if (!status.ok()) {
+      TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                      "Cannot serialize GPU delegate data: %s",
+                      std::string(status.message()).c_str());
+    }
+  }
+
+  // Creates the builder from a serialized inference context, provided that it
+  // was built for a graph with the same inputs and outputs.
+  absl::Status RestoreOpenClModel(const std::vector<uint8_t>& serialized_model,
+                                  const std::vector<uint32_t>& input_refs,
+                                  const std::vector<uint32_t>& output_refs,
+                                  std::unique_ptr<InferenceBuilder>* builder) {
+    std::vector<int64_t> in_refs;
+    std::vector<int64_t> out_refs;
+    RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
+        serialized_model, builder, &in_refs, &out_refs));
+    if (!std::equal(in_refs.begin(), in_refs.end(), input_refs.begin(),
+                    input_refs.end()) ||
+        !std::equal(out_refs.begin(), out_refs.end(), output_refs.begin(),
+                    output_refs.end())) {
+      builder->reset();
+      return absl::InvalidArgumentError(
+          "Serialized model does not match the delegated graph.");
+    }
+    return absl::OkStatus();
+  }
+
   absl::Status InitializeOpenGlApi(GraphFloat32* graph,
                                    std::unique_ptr<InferenceBuilder>* builder) {
 #ifndef CL_DELEGATE_NO_GL
@@ -341,6 +518,11 @@ class DelegateKernel {
   // The Delegate instance that's shared across all DelegateKernel instances.
   Delegate* const delegate_;  // doesn't own the memory.
   std::unique_ptr<cl::InferenceEnvironment> cl_environment_;
+  // Empty unless serialization is enabled.
+  std::string serialization_path_prefix_;
+  // Backs cl::InferenceEnvironmentOptions::serialized_binary_cache, which the
+  // environment reads whenever it creates a builder.
+  std::vector<uint8_t> serialized_binary_cache_;
 #ifndef CL_DELEGATE_NO_GL
   std::unique_ptr<gl::InferenceEnvironment> gl_environment_;
 #endif
@@ -450,6 +632,8 @@ TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default() {
   options.inference_priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO;
   options.experimental_flags = TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT;
   options.max_delegated_partitions = 1;
+  options.serialization_dir = nullptr;
+  options.model_token = nullptr;
   return options;
 }
 
@@ -533,6 +533,12 @@ uint64_t GetHash(const TfLiteIntArray* int_array, uint64_t combine_with = 0) {
   return result;
 }
 
+uint64_t CombineHash(uint64_t value, uint64_t combine_with) {
+  constexpr auto kHashConst = 0x9e3779b97f4a7800ULL;
+  return combine_with ^
+         (value + kHashConst + (combine_with << 10) + (combine_with >> 4));
+}
+
 bool HasZeroes(TfLiteIntArrayView array) {
   for (auto value : array) {
     if (value == 0) {
@@ -728,7 +734,8 @@ class NNAPIOpBuilder {
                      allocation_mapping,
                  std::vector<int>* nnapi_to_tflite_op_mapping,
                  ANeuralNetworksModel* nn_model, int* nnapi_errno,
-                 bool allow_dynamic_dimensions)
+                 bool allow_dynamic_dimensions,
+                 uint64_t* model_fingerprint = nullptr)
       : nnapi_(nnapi),
         context_(context),
         operand_mapping_(tensor_mapping),
@@ -737,7 +744,8 @@ class NNAPIOpBuilder {
         nnapi_to_tflite_op_mapping_(nnapi_to_tflite_op_mapping),
         nn_model_(nn_model),
         nnapi_errno_(nnapi_errno),
-        allow_dynamic_dimensions_(allow_dynamic_dimensions) {}
+        allow_dynamic_dimensions_(allow_dynamic_dimensions),
+        model_fingerprint_(model_fingerprint) {}
 
   TfLiteStatus AddScalarBoolOperand(bool value) {
     return AddScalarOperand<bool>(value, ANEURALNETWORKS_BOOL);
@@ -1004,6 +1012,13 @@ class NNAPIOpBuilder {
         nnapi_->ANeuralNetworksModel_addOperation(
             nn_model_, type, input_count, inputs, output_count, outputs),
         "adding operation", nnapi_errno_);
+    if (model_fingerprint_) {
+      FingerprintValue(&type, sizeof(type));
+      FingerprintValue(&input_count, sizeof(input_count));
+      FingerprintValue(inputs, input_count * sizeof(uint32_t));
+      FingerprintValue(&output_count, sizeof(output_count));
+      FingerprintValue(outputs, output_count * sizeof(uint32_t));
+    }
     nnapi_to_tflite_op_mapping_->push_back(lite_node_index);
     return kTfLiteOk;
   }
@@ -1030,6 +1045,7 @@ class NNAPIOpBuilder {
           context_,
           nnapi_->ANeuralNetworksModel_addOperand(nn_model_, &operand_type),
           "adding operand", nnapi_errno_);
+      FingerprintOperandType(operand_type);
       dequantized_ann_index = operand_mapping_->add_new_non_tensor_operand();
 
       // Add Dequantize operation.
@@ -1135,6 +1151,7 @@ class NNAPIOpBuilder {
         context_,
         nnapi_->ANeuralNetworksModel_addOperand(nn_model_, &operand_type),
         "adding operand", nnapi_errno_);
+    FingerprintOperandType(operand_type);
 
     augmented_inputs_.push_back(ann_tensor_index);
 
@@ -1144,6 +1161,7 @@ class NNAPIOpBuilder {
             nn_model_, ann_tensor_index, new_tensor->data.raw,
             new_tensor->bytes),
         "setting new operand value", nnapi_errno_);
+    FingerprintValue(new_tensor->data.raw, new_tensor->bytes);
 
     return kTfLiteOk;
   }
@@ -1191,12 +1209,14 @@ class NNAPIOpBuilder {
         context_,
         nnapi_->ANeuralNetworksModel_addOperand(nn_model_, &operand_type),
         "adding operand", nnapi_errno_);
+    FingerprintOperandType(operand_type);
     const int ann_index = operand_mapping_->add_new_non_tensor_operand();
     RETURN_TFLITE_ERROR_IF_NN_ERROR(
         context_,
         nnapi_->ANeuralNetworksModel_setOperandValue(nn_model_, ann_index,
                                                      &value, sizeof(T)),
         "setting new operand value", nnapi_errno_);
+    FingerprintValue(&value, sizeof(T));
     augmented_inputs_.push_back(ann_index);
     return kTfLiteOk;
   }
@@ -1215,6 +1235,7 @@ class NNAPIOpBuilder {
         context_,
         nnapi_->ANeuralNetworksModel_addOperand(nn_model_, &operand_type),
         "adding operand", nnapi_errno_);
+    FingerprintOperandType(operand_type);
 
     const int ann_index = operand_mapping_->add_new_non_tensor_operand();
     RETURN_TFLITE_ERROR_IF_NN_ERROR(
@@ -1222,6 +1243,7 @@ class NNAPIOpBuilder {
         nnapi_->ANeuralNetworksModel_setOperandValue(
             nn_model_, ann_index, values, sizeof(T) * num_values),
         "settings new operand value", nnapi_errno_);
+    FingerprintValue(values, sizeof(T) * num_values);
     augmented_inputs_.push_back(ann_index);
     return kTfLiteOk;
   }
@@ -1257,6 +1279,7 @@ class NNAPIOpBuilder {
         context_,
         nnapi_->ANeuralNetworksModel_addOperand(nn_model_, &operand_type),
         "adding operand", nnapi_errno_);
+    FingerprintOperandType(operand_type);
     const int ann_index = operand_mapping_->add_new_non_tensor_operand();
     augmented_outputs_.push_back(ann_index);
     if (ann_index_out) *ann_index_out = ann_index;
@@ -1409,6 +1432,7 @@ class NNAPIOpBuilder {
         context_,
         nnapi_->ANeuralNetworksModel_addOperand(nn_model_, &operand_type),
         "adding operand", tensor, nnapi_errno_);
+    FingerprintOperandType(operand_type);
 
     if (nn_type == ANEURALNETWORKS_TENSOR_QUANT8_SYMM_PER_CHANNEL) {
       RETURN_TFLITE_ERROR_IF_NN_ERROR_FOR_TENSOR(
@@ -1417,6 +1441,10 @@ class NNAPIOpBuilder {
               nn_model_, ann_tensor_index, &ann_perchannel_params),
           "setting new operand per channel quantization params", tensor,
           nnapi_errno_);
+      FingerprintValue(&ann_perchannel_params.channelDim,
+                       sizeof(ann_perchannel_params.channelDim));
+      FingerprintValue(ann_perchannel_params.scales,
+                       ann_perchannel_params.scaleCount * sizeof(float));
     }
     if (tensor->allocation_type == kTfLiteMmapRo) {
       if (IsQuantized(tensor_type) && need_int8_conversion &&
@@ -1451,6 +1479,7 @@ class NNAPIOpBuilder {
                 nn_model_, ann_tensor_index, new_tensor->data.raw,
                 new_tensor->bytes),
             "setting new operand value", tensor, nnapi_errno_);
+        FingerprintValue(new_tensor->data.raw, new_tensor->bytes);
 #ifdef TFLITE_NNAPI_ALLOW_MMAP_SHARING
       } else if (tensor->allocation &&
                  static_cast<const Allocation*>(tensor->allocation)->type() ==
@@ -1476,6 +1505,7 @@ class NNAPIOpBuilder {
                 nn_model_, ann_tensor_index, ann_memory_handle, offset,
                 tensor->bytes),
             "setting new operand value from memory", tensor, nnapi_errno_);
+        FingerprintValue(tensor->data.raw, tensor->bytes);
 #endif
       } else {
         RETURN_TFLITE_ERROR_IF_NN_ERROR_FOR_TENSOR(
@@ -1483,12 +1513,38 @@ class NNAPIOpBuilder {
             nnapi_->ANeuralNetworksModel_setOperandValue(
                 nn_model_, ann_tensor_index, tensor->data.raw, tensor->bytes),
             "setting new operand value", tensor, nnapi_errno_);
+        FingerprintValue(tensor->data.raw, tensor->bytes);
       }
     }
     indices->push_back(ann_tensor_index);
     return kTfLiteOk;
   }
 
+  // Folds the description of a newly added operand into the model
+  // fingerprint, if one is being computed.
+  void FingerprintOperandType(const ANeuralNetworksOperandType& operand_type) {
+    if (!model_fingerprint_) return;
+    FingerprintValue(&operand_type.type, sizeof(operand_type.type));
+    FingerprintValue(&operand_type.dimensionCount,
+                     sizeof(operand_type.dimensionCount));
+    FingerprintValue(operand_type.dimensions,
+                     operand_type.dimensionCount * sizeof(uint32_t));
+    FingerprintValue(&operand_type.scale, sizeof(operand_type.scale));
+    FingerprintValue(&operand_type.zeroPoint, sizeof(operand_type.zeroPoint));
+  }
+
+  // Folds `length` bytes of model content into the model fingerprint, if one
+  // is being computed.
+  void FingerprintValue(const void* data, size_t length) {
+    if (!model_fingerprint_) return;
+    const uint64_t value =
+        data == nullptr ? 0
+                        : ::util::Fingerprint64(
+                              static_cast<const char*>(data), length);
+    *model_fingerprint_ =
+        CombineHash(CombineHash(length, value), *model_fingerprint_);
+  }
+
   // Access to NNAPI.
   const NnApi* const nnapi_;
 
@@ -1525,6 +1581,10 @@ class NNAPIOpBuilder {
 
   // Whether to allow dynamic batch size without re-compilation.
   bool allow_dynamic_dimensions_;
+
+  // If not null, accumulates a fingerprint of everything added to the NNAPI
+  // model, used to derive compilation cache tokens.
+  uint64_t* const model_fingerprint_;
 };  // namespace nnapi
 
 namespace {
@@ -3668,17 +3728,20 @@ TfLiteStatus NNAPIDelegateKernel::Init(TfLiteContext* context,
   nn_compilation_cache_token_.clear();
   const char* cache_dir = delegate_options.cache_dir;
   const char* model_token = delegate_options.model_token;
-  if (nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 && cache_dir &&
-      model_token) {
+  if (nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 && cache_dir) {
     // Compilation caching could be enabled, try construct the uint8
     // token.
     // TODO(b/133342794): use a generic token generator class.
     uint64_t token_parts[4];
-    // Create bits from model_token.
+    // Create bits from model_token, or from the content of the NNAPI model
+    // when no token was provided. The latter covers the operations, operand
+    // shapes and constant values, so distinct models get distinct tokens.
     // Using farmhash fingerprint instead of std::hash, as the latter is not
     // guaranteed to be stable across program invocations.
     token_parts[0] =
-        ::util::Fingerprint64(model_token, std::strlen(model_token));
+        model_token
+            ? ::util::Fingerprint64(model_token, std::strlen(model_token))
+            : nn_model_fingerprint_;
     // Create bits from params->nodes_to_replace.
     token_parts[1] = GetHash(params->nodes_to_replace);
     // Create bits from params->input_tensors. These include the input tensor
@@ -3792,7 +3855,9 @@ TfLiteStatus NNAPIDelegateKernel::Prepare(TfLiteContext* context,
                                   "completing NNAPI compilation", nnapi_errno);
   nn_compilation_.reset(compilation);
 
-  // Create burst object to be reused across a sequence of executions
+  // Create burst object to be reused across a sequence of executions. Burst
+  // mode is only an optimization: if the driver cannot create a burst object
+  // the executions fall back to the regular compute path.
   if (delegate_options.use_burst_computation &&
       nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI12 &&
       nnapi_->ANeuralNetworksBurst_create) {
@@ -3802,9 +3867,11 @@ TfLiteStatus NNAPIDelegateKernel::Prepare(TfLiteContext* context,
     if (create_burst_result != ANEURALNETWORKS_NO_ERROR) {
       nnapi_->ANeuralNetworksBurst_free(burst);
       burst = nullptr;
+      TFLITE_LOG_PROD_ONCE(TFLITE_LOG_WARNING,
+                           "NNAPI burst creation failed with error %s, "
+                           "falling back to non-burst execution.",
+                           NnApiErrorDescription(create_burst_result).c_str());
     }
-    RETURN_TFLITE_ERROR_IF_NN_ERROR(context, create_burst_result,
-                                    "creating NNAPI burst", nnapi_errno);
     nn_burst_.reset(burst);
   }
 
@@ -4292,14 +4359,17 @@ void NNAPIDelegateKernel::AddDequantizeOperatorsWhereNeeded(
 }
 
 TfLiteStatus NNAPIDelegateKernel::AddOpsAndTensors(
-    TfLiteContext* context, int* nnapi_errno, bool allow_dynamic_dimensions) {
+    TfLiteContext* context, int* nnapi_errno, bool allow_dynamic_dimensions,
+    bool fingerprint_model) {
   DequantizeMapping dequantize_mapping;
   // The operand builder allows creating a single op. It is created outside
   // the for loop to avoid reallocating the vectors.
+  nn_model_fingerprint_ = 0;
   NNAPIOpBuilder builder(nnapi_, context, &operand_mapping_,
                          &dequantize_mapping, &allocation_memory_mapping_,
                          &nnapi_to_tflite_op_mapping_, nn_model_.get(),
-                         nnapi_errno, allow_dynamic_dimensions);
+                         nnapi_errno, allow_dynamic_dimensions,
+                         fingerprint_model ? &nn_model_fingerprint_ : nullptr);
   // If we have target accelerators the target SDK version might be
   // different than the current android version.
   target_sdk_version_ = nnapi_->android_sdk_version;
@@ -4791,9 +4861,13 @@ TfLiteStatus NNAPIDelegateKernel::BuildGraph(
     const StatefulNnApiDelegate::Options& delegate_options,
     const TfLiteIntArray* input_tensors, const TfLiteIntArray* output_tensors,
     int* nnapi_errno) {
-  // Build the ops and tensors.
+  // Build the ops and tensors. The model content is only fingerprinted when
+  // it is needed to derive the compilation cache token.
+  const bool fingerprint_model = delegate_options.cache_dir != nullptr &&
+                                 delegate_options.model_token == nullptr;
   TF_LITE_ENSURE_STATUS(AddOpsAndTensors(
-      context, nnapi_errno, delegate_options.allow_dynamic_dimensions));
+      context, nnapi_errno, delegate_options.allow_dynamic_dimensions,
+      fingerprint_model));
   // Map input and output tensor indices to ANN
   std::vector<uint32_t> inputs;
   inputs.reserve(input_tensors->size);
@@ -4862,6 +4936,9 @@ TfLiteStatus NNAPIDelegateKernel::BuildGraph(
 
   auto allow_fp16 =
       context->allow_fp32_relax_to_fp16 | delegate_options.allow_fp16;
+  if (fingerprint_model) {
+    nn_model_fingerprint_ = CombineHash(allow_fp16, nn_model_fingerprint_);
+  }
   if (nnapi_->android_sdk_version >= kMinSdkVersionForNNAPI11) {
     RETURN_TFLITE_ERROR_IF_NN_ERROR(
         context,
@@ -68,11 +68,14 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     const char* cache_dir = nullptr;
 
     // The unique nul-terminated token string for NNAPI model.
-    // Default to nullptr, which implies the NNAPI will not try caching the
-    // compilation. It is the caller's responsibility to ensure there is no
-    // clash of the tokens.
-    // NOTE: when using compilation caching, it is not recommended to use the
-    // same delegate instance for multiple models.
+    // Default to nullptr. If cache_dir is set and no token is provided, the
+    // token is derived from a fingerprint of the content of each delegated
+    // partition (operations, operand shapes and constant values). Computing
+    // it reads all the constant data of the model once per initialization.
+    // When a token is provided, it is the caller's responsibility to ensure
+    // there is no clash of the tokens.
+    // NOTE: when using compilation caching with an explicit token, it is not
+    // recommended to use the same delegate instance for multiple models.
     const char* model_token = nullptr;
 
     // Whether to disallow NNAPI CPU usage. Only effective on Android 10 and
@@ -129,9 +132,10 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     // Use NNAPI Burst mode if supported.
     // Burst mode allows accelerators to efficiently manage resources, which
     // would significantly reduce overhead especially if the same delegate
-    // instance is to be used for multiple inferences.
-    // Default: Disabled.
-    bool use_burst_computation = false;
+    // instance is to be used for multiple inferences. If the driver cannot
+    // create a burst object, the regular execution path is used instead.
+    // Default: Enabled.
+    bool use_burst_computation = true;
   };
 
   // Uses default options.
@@ -259,7 +263,7 @@ class StatefulNnApiDelegate : public TfLiteDelegate {
     // Whether to allow dynamic dimension sizes without re-compilation.
     bool allow_dynamic_dimensions = false;
     // Whether to use NNAPI Burst mode.
-    bool use_burst_computation = false;
+    bool use_burst_computation = true;
 
     explicit Data(const NnApi* nnapi);
     ~Data();
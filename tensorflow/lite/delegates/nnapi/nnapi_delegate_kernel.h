@@ -366,6 +366,9 @@ class NNAPIDelegateKernel {
   std::unique_ptr<NNMemory> nn_output_memory_;
 
   std::vector<uint8_t> nn_compilation_cache_token_;
+  // Fingerprint of the NNAPI model content, used to derive
+  // nn_compilation_cache_token_ when no model token is provided.
+  uint64_t nn_model_fingerprint_ = 0;
 
   std::vector<int> nnapi_to_tflite_op_mapping_;
 
@@ -377,7 +380,8 @@ class NNAPIDelegateKernel {
       int tflite_node_index, NNAPIOpBuilder* builder, int* nnapi_errno);
 
   TfLiteStatus AddOpsAndTensors(TfLiteContext* context, int* nnapi_errno,
-                                bool allow_dynamic_dimensions);
+                                bool allow_dynamic_dimensions,
+                                bool fingerprint_model);
 
   TfLiteStatus BuildGraph(TfLiteContext* context,
                           const StatefulNnApiDelegate::Options& options,
@@ -16,8 +16,12 @@ limitations under the License.
 #include "tensorflow/lite/delegates/utils.h"
 
 #include <algorithm>
+#include <cctype>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "tensorflow/lite/builtin_ops.h"
@@ -49,6 +53,50 @@ TfLiteStatus CreateNewTensorWithDifferentType(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+namespace {
+
+bool ParseLatencyField(const std::string& field, int node_index,
+                       std::unordered_map<int, float>* latencies) {
+  if (field.empty()) return true;
+  char* end = nullptr;
+  const float latency = std::strtof(field.c_str(), &end);
+  if (end != field.c_str() + field.size() || latency < 0) return false;
+  (*latencies)[node_index] = latency;
+  return true;
+}
+
+}  // namespace
+
+bool ParseNodeLatencyTable(const std::string& table,
+                           PartitionCostModel* cost_model) {
+  std::istringstream lines(table);
+  std::string line;
+  while (std::getline(lines, line)) {
+    line.erase(std::remove_if(line.begin(), line.end(),
+                              [](char c) { return std::isspace(c); }),
+               line.end());
+    if (line.empty() || line[0] == '#') continue;
+
+    std::vector<std::string> fields;
+    std::istringstream line_stream(line);
+    std::string field;
+    while (std::getline(line_stream, field, ',')) fields.push_back(field);
+    if (line.back() == ',') fields.emplace_back();
+    if (fields.size() != 3) return false;
+
+    char* end = nullptr;
+    const long node_index = std::strtol(fields[0].c_str(), &end, 10);
+    if (fields[0].empty() || *end != '\0' || node_index < 0) return false;
+    if (!ParseLatencyField(fields[1], node_index,
+                           &cost_model->cpu_latency_us) ||
+        !ParseLatencyField(fields[2], node_index,
+                           &cost_model->delegate_latency_us)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 TfLiteStatus GraphPartitionHelper::Partition(
     std::set<std::string>* unsupported_nodes_info) {
   const auto prepare_status = PrepareSupportedNodes(unsupported_nodes_info);
@@ -111,6 +159,65 @@ std::vector<int> GraphPartitionHelper::GetNodesOfFirstNLargestPartitionsImpl(
   return ops_to_replace;
 }
 
+float GraphPartitionHelper::PredictPartitionSavingUs(
+    const PartitionCostModel& cost_model,
+    const TfLiteDelegateParams& partition) const {
+  auto latency = [](const std::unordered_map<int, float>& latencies,
+                    int node_index, float default_latency) {
+    const auto it = latencies.find(node_index);
+    return it == latencies.end() ? default_latency : it->second;
+  };
+
+  float cpu_latency_us = 0.0f;
+  float delegate_latency_us = cost_model.partition_overhead_us;
+  for (int node_index : TfLiteIntArrayView(partition.nodes_to_replace)) {
+    cpu_latency_us += latency(cost_model.cpu_latency_us, node_index,
+                              cost_model.default_cpu_latency_us);
+    delegate_latency_us += latency(cost_model.delegate_latency_us, node_index,
+                                   cost_model.default_delegate_latency_us);
+  }
+
+  // Constant tensors are handed to the delegate once at initialization, so
+  // only the remaining boundary tensors are transferred on every invocation.
+  if (cost_model.transfer_us_per_byte > 0.0f) {
+    size_t transfer_bytes = 0;
+    for (const TfLiteIntArray* tensors :
+         {partition.input_tensors, partition.output_tensors}) {
+      if (tensors == nullptr) continue;
+      for (int tensor_index : TfLiteIntArrayView(tensors)) {
+        const TfLiteTensor& tensor = context_->tensors[tensor_index];
+        if (!IsConstantTensor(&tensor)) transfer_bytes += tensor.bytes;
+      }
+    }
+    delegate_latency_us += cost_model.transfer_us_per_byte * transfer_bytes;
+  }
+
+  return cpu_latency_us - delegate_latency_us;
+}
+
+std::vector<int> GraphPartitionHelper::GetNodesOfCostEffectivePartitions(
+    const PartitionCostModel& cost_model, int n) const {
+  std::vector<std::pair<float, const TfLiteDelegateParams*>> savings;
+  for (const auto* p : partitions_) {
+    const float saving_us = PredictPartitionSavingUs(cost_model, *p);
+    if (saving_us > 0.0f) savings.emplace_back(saving_us, p);
+  }
+  std::stable_sort(savings.begin(), savings.end(),
+                   [](const std::pair<float, const TfLiteDelegateParams*>& a,
+                      const std::pair<float, const TfLiteDelegateParams*>& b) {
+                     return a.first > b.first;
+                   });
+
+  std::vector<int> ops_to_replace;
+  const int total = savings.size();
+  for (int i = 0; i < std::min(total, n); ++i) {
+    const auto* nodes = savings[i].second->nodes_to_replace;
+    ops_to_replace.insert(ops_to_replace.end(), nodes->data,
+                          nodes->data + nodes->size);
+  }
+  return ops_to_replace;
+}
+
 TfLiteStatus GraphPartitionHelper::PrepareSupportedNodes(
     std::set<std::string>* unsupported_nodes_info) {
   if (!is_node_supported_fn_) return kTfLiteOk;
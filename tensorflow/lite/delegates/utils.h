@@ -45,6 +45,36 @@ using IsNodeSupportedFn =
     std::function<bool(TfLiteContext*, TfLiteNode*, TfLiteRegistration*,
                        std::string* unsupported_details)>;
 
+// Latency estimates used to decide which partitions are worth delegating.
+// Per-node latencies can be measured with the TFLite profiler (e.g. the
+// benchmark tool's op profiling output, whose node names end with ":<node
+// index>") and supplied as a table, see ParseNodeLatencyTable.
+struct PartitionCostModel {
+  // Estimated latency in microseconds of each node when run on CPU and on the
+  // delegate, keyed by node index. Nodes missing from a map use the
+  // corresponding default.
+  std::unordered_map<int, float> cpu_latency_us;
+  std::unordered_map<int, float> delegate_latency_us;
+  float default_cpu_latency_us = 0.0f;
+  float default_delegate_latency_us = 0.0f;
+
+  // Fixed cost in microseconds of every delegated partition, i.e. of handing
+  // execution over to the delegate and synchronizing with it afterwards.
+  float partition_overhead_us = 0.0f;
+
+  // Cost in microseconds of moving one byte of a non-constant partition input
+  // or output tensor between the CPU and the delegate.
+  float transfer_us_per_byte = 0.0f;
+};
+
+// Parses a node latency table into 'cost_model'. Every line that is neither
+// empty nor starts with '#' has the form
+//   <node index>,<cpu latency in us>,<delegate latency in us>
+// An empty latency field leaves the corresponding default in effect.
+// Returns false if the table is malformed.
+bool ParseNodeLatencyTable(const std::string& table,
+                           PartitionCostModel* cost_model);
+
 // A utility class to help model graph parition.
 // Note the class *needs* to be used in TfLiteDelegate::Prepare.
 class GraphPartitionHelper {
@@ -91,6 +121,22 @@ class GraphPartitionHelper {
     return GetNodesOfFirstNLargestPartitionsImpl(n, min_nodes_per_partition);
   }
 
+  // Returns a list of node indices of all nodes from the partitions that
+  // 'cost_model' predicts to run faster on the delegate than on CPU, counting
+  // the cost of entering and leaving each partition. At most 'n' partitions
+  // are selected, those with the largest predicted saving first. Partitions
+  // are separated by unsupported nodes, so each one is decided on its own and
+  // the selection minimizes the total predicted latency.
+  std::vector<int> GetNodesOfCostEffectivePartitions(
+      const PartitionCostModel& cost_model,
+      int n = std::numeric_limits<int>::max()) const;
+
+  // Returns the predicted latency saving in microseconds of delegating
+  // 'partition' rather than running it on CPU. Negative if the delegated
+  // partition is predicted to be slower.
+  float PredictPartitionSavingUs(const PartitionCostModel& cost_model,
+                                 const TfLiteDelegateParams& partition) const;
+
   int num_total_nodes() const { return num_total_nodes_; }
   int num_supported_nodes() const { return num_supported_nodes_; }
   int num_partitions() const { return partitions_.size(); }
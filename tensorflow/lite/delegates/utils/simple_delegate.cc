@@ -94,9 +94,16 @@ TfLiteStatus DelegatePrepare(TfLiteContext* context,
   delegates::GraphPartitionHelper helper(context, node_supported_fn);
   TF_LITE_ENSURE_STATUS(helper.Partition(nullptr));
 
-  std::vector<int> supported_nodes = helper.GetNodesOfFirstNLargestPartitions(
-      delegate_options.max_delegated_partitions,
-      delegate_options.min_nodes_per_partition);
+  std::vector<int> supported_nodes;
+  if (delegate_options.partition_cost_model) {
+    supported_nodes = helper.GetNodesOfCostEffectivePartitions(
+        *delegate_options.partition_cost_model,
+        delegate_options.max_delegated_partitions);
+  } else {
+    supported_nodes = helper.GetNodesOfFirstNLargestPartitions(
+        delegate_options.max_delegated_partitions,
+        delegate_options.min_nodes_per_partition);
+  }
 
   TFLITE_LOG_PROD(tflite::TFLITE_LOG_INFO,
                   "%s delegate: %d nodes delegated out of %d nodes with "
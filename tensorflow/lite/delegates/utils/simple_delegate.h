@@ -32,6 +32,7 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/utils.h"
 
 namespace tflite {
 
@@ -78,6 +79,11 @@ class SimpleDelegateInterface {
     // The minimum number of nodes allowed in a delegated graph, values <=0
     // means unlimited.
     int min_nodes_per_partition = 0;
+
+    // If set, only the partitions that this cost model predicts to run faster
+    // on the delegate than on CPU are delegated, instead of partitions being
+    // chosen by size. 'min_nodes_per_partition' is ignored in that case.
+    std::shared_ptr<const delegates::PartitionCostModel> partition_cost_model;
   };
 
   virtual ~SimpleDelegateInterface() {}
@@ -250,6 +250,60 @@ TEST(GraphPartitionHelper, CheckPartitionsWithSupportedNodeList) {
   EXPECT_THAT(nodes, testing::ElementsAreArray({0, 3, 7, 8, 2, 4, 9}));
 }
 
+TEST(GraphPartitionHelper, CheckCostEffectivePartitions) {
+  // The mocked TfLiteContext has 4 partitions: {1}, {0,3,7,8}, {2,4,9}, {5,6}.
+  MockTfLiteContext mocked_context;
+  GraphPartitionHelper helper(&mocked_context, IsNodeSupported);
+  EXPECT_EQ(kTfLiteOk, helper.Partition(nullptr));
+
+  // Every node takes 10us on CPU and 2us on the delegate, and each delegated
+  // partition costs another 20us. So only partitions with more than 2 nodes
+  // pay off: {0,3,7,8} saves 12us and {2,4,9} saves 4us.
+  PartitionCostModel cost_model;
+  cost_model.default_cpu_latency_us = 10;
+  cost_model.default_delegate_latency_us = 2;
+  cost_model.partition_overhead_us = 20;
+  EXPECT_FLOAT_EQ(-12, helper.PredictPartitionSavingUs(
+                           cost_model, *mocked_context.delegate_params()));
+  EXPECT_THAT(helper.GetNodesOfCostEffectivePartitions(cost_model),
+              testing::ElementsAreArray({0, 3, 7, 8, 2, 4, 9}));
+  EXPECT_THAT(helper.GetNodesOfCostEffectivePartitions(cost_model, 1),
+              testing::ElementsAreArray({0, 3, 7, 8}));
+
+  // A slow CPU node makes {5,6} the most profitable partition, while a slow
+  // delegate node makes {2,4,9} slower than running on CPU.
+  cost_model.cpu_latency_us[5] = 50;
+  cost_model.delegate_latency_us[9] = 15;
+  EXPECT_THAT(helper.GetNodesOfCostEffectivePartitions(cost_model),
+              testing::ElementsAreArray({5, 6, 0, 3, 7, 8}));
+
+  // Nothing is delegated if every partition is slower on the delegate.
+  cost_model.partition_overhead_us = 100;
+  EXPECT_TRUE(helper.GetNodesOfCostEffectivePartitions(cost_model).empty());
+}
+
+TEST(UtilsTest, ParseNodeLatencyTable) {
+  PartitionCostModel cost_model;
+  EXPECT_TRUE(ParseNodeLatencyTable(
+      "# node, cpu us, delegate us\n"
+      "0, 12.5, 3\n"
+      "\n"
+      "4,7,\n"
+      "5,,1.5\n",
+      &cost_model));
+  EXPECT_EQ(2, cost_model.cpu_latency_us.size());
+  EXPECT_FLOAT_EQ(12.5, cost_model.cpu_latency_us[0]);
+  EXPECT_FLOAT_EQ(7, cost_model.cpu_latency_us[4]);
+  EXPECT_EQ(2, cost_model.delegate_latency_us.size());
+  EXPECT_FLOAT_EQ(3, cost_model.delegate_latency_us[0]);
+  EXPECT_FLOAT_EQ(1.5, cost_model.delegate_latency_us[5]);
+
+  EXPECT_FALSE(ParseNodeLatencyTable("0,1\n", &cost_model));
+  EXPECT_FALSE(ParseNodeLatencyTable("x,1,2\n", &cost_model));
+  EXPECT_FALSE(ParseNodeLatencyTable("0,1,fast\n", &cost_model));
+  EXPECT_FALSE(ParseNodeLatencyTable("-1,1,2\n", &cost_model));
+}
+
 }  // namespace
 }  // namespace delegates
 }  // namespace tflite
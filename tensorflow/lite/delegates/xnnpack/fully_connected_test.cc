@@ -14,9 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <memory>
 #include <random>
+#include <string>
 
 #include <gtest/gtest.h>
 #include "tensorflow/lite/delegates/xnnpack/fully_connected_tester.h"
@@ -251,6 +253,46 @@ TEST(FullyConnected, FP16Weights) {
       .Test(xnnpack_delegate.get());
 }
 
+TEST(FullyConnected, FP16WeightsWithWeightsCache) {
+  const std::string weights_cache_file_path =
+      ::testing::TempDir() + "/fully_connected_fp16_weights_cache";
+  std::remove(weights_cache_file_path.c_str());
+  TfLiteXNNPackDelegateOptions delegate_options =
+      TfLiteXNNPackDelegateOptionsDefault();
+  delegate_options.weights_cache_file_path = weights_cache_file_path.c_str();
+
+  std::random_device random_device;
+  auto rng = std::mt19937(random_device());
+  auto batch_rng =
+      std::bind(std::uniform_int_distribution<int32_t>(2, 5), std::ref(rng));
+  auto channels_rng =
+      std::bind(std::uniform_int_distribution<int32_t>(2, 9), std::ref(rng));
+  const auto batch = batch_rng();
+  const auto input_channels = channels_rng();
+  const auto output_channels = channels_rng();
+
+  // Every model gets new random weights, so the second delegate must not use
+  // the weights cached by the first one.
+  for (int i = 0; i < 2; i++) {
+    std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+        xnnpack_delegate(TfLiteXNNPackDelegateCreate(&delegate_options),
+                         TfLiteXNNPackDelegateDelete);
+
+    FullyConnectedTester()
+        .InputShape({batch, input_channels})
+        .InputChannels(input_channels)
+        .OutputChannels(output_channels)
+        .FP16Weights()
+        .Test(xnnpack_delegate.get());
+
+    FILE* weights_cache_file =
+        std::fopen(weights_cache_file_path.c_str(), "rb");
+    ASSERT_NE(weights_cache_file, nullptr);
+    std::fclose(weights_cache_file);
+  }
+  std::remove(weights_cache_file_path.c_str());
+}
+
 TEST(FullyConnected, ReluActivation) {
   std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
       xnnpack_delegate(TfLiteXNNPackDelegateCreate(nullptr),
@@ -116,5 +116,53 @@ TEST(Relu, MultiThreading) {
       .Test(BuiltinOperator_RELU, xnnpack_delegate.get());
 }
 
+TEST(Relu, Resized) {
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      xnnpack_delegate(TfLiteXNNPackDelegateCreate(nullptr),
+                       TfLiteXNNPackDelegateDelete);
+
+  std::random_device random_device;
+  auto rng = std::mt19937(random_device());
+  auto shape_rng =
+      std::bind(std::uniform_int_distribution<int32_t>(2, 5), std::ref(rng));
+  const auto batch = shape_rng();
+  const auto width = shape_rng();
+  const auto channels = shape_rng();
+
+  UnaryElementwiseTester()
+      .Shape({batch, width, channels})
+      .ResizedShape({batch, width + 3, channels})
+      .ResizedShape({batch, width, channels})
+      .Test(BuiltinOperator_RELU, xnnpack_delegate.get());
+}
+
+TEST(Relu, ResizedWithRuntimeCache) {
+  TfLiteXNNPackDelegateOptions delegate_options =
+      TfLiteXNNPackDelegateOptionsDefault();
+  delegate_options.runtime_cache_size = 2;
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      xnnpack_delegate(TfLiteXNNPackDelegateCreate(&delegate_options),
+                       TfLiteXNNPackDelegateDelete);
+
+  std::random_device random_device;
+  auto rng = std::mt19937(random_device());
+  auto shape_rng =
+      std::bind(std::uniform_int_distribution<int32_t>(2, 5), std::ref(rng));
+  const auto batch = shape_rng();
+  const auto width = shape_rng();
+  const auto channels = shape_rng();
+
+  // Alternates between cached runtimes, then evicts the least recently used
+  // one.
+  UnaryElementwiseTester()
+      .Shape({batch, width, channels})
+      .ResizedShape({batch, width + 3, channels})
+      .ResizedShape({batch, width, channels})
+      .ResizedShape({batch, width + 3, channels})
+      .ResizedShape({batch, width + 7, channels})
+      .ResizedShape({batch, width, channels})
+      .Test(BuiltinOperator_RELU, xnnpack_delegate.get());
+}
+
 }  // namespace xnnpack
 }  // namespace tflite
@@ -80,48 +80,65 @@ void UnaryElementwiseTester::Test(tflite::BuiltinOperator unary_op,
 
   ASSERT_EQ(delegate_interpreter->ModifyGraphWithDelegate(delegate), kTfLiteOk);
 
-  float* default_input_data = default_interpreter->typed_tensor<float>(
-      default_interpreter->inputs()[0]);
-  std::generate(default_input_data, default_input_data + Size(),
-                std::ref(input_rng));
-
-  float* delegate_input_data = delegate_interpreter->typed_tensor<float>(
-      delegate_interpreter->inputs()[0]);
-  std::copy(default_input_data, default_input_data + Size(),
-            delegate_input_data);
-
-  ASSERT_EQ(default_interpreter->Invoke(), kTfLiteOk);
-  ASSERT_EQ(delegate_interpreter->Invoke(), kTfLiteOk);
-
-  float* default_output_data = default_interpreter->typed_tensor<float>(
-      default_interpreter->outputs()[0]);
-  float* delegate_output_data = delegate_interpreter->typed_tensor<float>(
-      delegate_interpreter->outputs()[0]);
-
-  switch (unary_op) {
-    case BuiltinOperator_ABS:
-    case BuiltinOperator_CEIL:
-    case BuiltinOperator_FLOOR:
-    case BuiltinOperator_NEG:
-    case BuiltinOperator_RELU:
-    case BuiltinOperator_RELU_N1_TO_1:
-    case BuiltinOperator_RELU6:
-    case BuiltinOperator_ROUND:
-    case BuiltinOperator_SQUARE:
-    case BuiltinOperator_SQRT:
-      for (size_t i = 0; i < Size(); i++) {
-        ASSERT_EQ(default_output_data[i], delegate_output_data[i]);
-      }
-      break;
-    default:
-      for (size_t i = 0; i < Size(); i++) {
-        ASSERT_NEAR(
-            default_output_data[i], delegate_output_data[i],
-            std::numeric_limits<float>::epsilon() *
-                std::max(std::abs(default_output_data[i]) * RelativeTolerance(),
-                         1.0f));
-      }
-      break;
+  for (size_t r = 0; r <= ResizedShapes().size(); r++) {
+    int32_t size = Size();
+    if (r != 0) {
+      const std::vector<int> shape(ResizedShapes()[r - 1].cbegin(),
+                                   ResizedShapes()[r - 1].cend());
+      ASSERT_EQ(default_interpreter->ResizeInputTensor(
+                    default_interpreter->inputs()[0], shape),
+                kTfLiteOk);
+      ASSERT_EQ(delegate_interpreter->ResizeInputTensor(
+                    delegate_interpreter->inputs()[0], shape),
+                kTfLiteOk);
+      ASSERT_EQ(default_interpreter->AllocateTensors(), kTfLiteOk);
+      ASSERT_EQ(delegate_interpreter->AllocateTensors(), kTfLiteOk);
+      size = ComputeSize(ResizedShapes()[r - 1]);
+    }
+
+    float* default_input_data = default_interpreter->typed_tensor<float>(
+        default_interpreter->inputs()[0]);
+    std::generate(default_input_data, default_input_data + size,
+                  std::ref(input_rng));
+
+    float* delegate_input_data = delegate_interpreter->typed_tensor<float>(
+        delegate_interpreter->inputs()[0]);
+    std::copy(default_input_data, default_input_data + size,
+              delegate_input_data);
+
+    ASSERT_EQ(default_interpreter->Invoke(), kTfLiteOk);
+    ASSERT_EQ(delegate_interpreter->Invoke(), kTfLiteOk);
+
+    float* default_output_data = default_interpreter->typed_tensor<float>(
+        default_interpreter->outputs()[0]);
+    float* delegate_output_data = delegate_interpreter->typed_tensor<float>(
+        delegate_interpreter->outputs()[0]);
+
+    switch (unary_op) {
+      case BuiltinOperator_ABS:
+      case BuiltinOperator_CEIL:
+      case BuiltinOperator_FLOOR:
+      case BuiltinOperator_NEG:
+      case BuiltinOperator_RELU:
+      case BuiltinOperator_RELU_N1_TO_1:
+      case BuiltinOperator_RELU6:
+      case BuiltinOperator_ROUND:
+      case BuiltinOperator_SQUARE:
+      case BuiltinOperator_SQRT:
+        for (size_t i = 0; i < size; i++) {
+          ASSERT_EQ(default_output_data[i], delegate_output_data[i]);
+        }
+        break;
+      default:
+        for (size_t i = 0; i < size; i++) {
+          ASSERT_NEAR(default_output_data[i], delegate_output_data[i],
+                      std::numeric_limits<float>::epsilon() *
+                          std::max(std::abs(default_output_data[i]) *
+                                       RelativeTolerance(),
+                                   1.0f));
+        }
+        break;
+    }
   }
 }
 
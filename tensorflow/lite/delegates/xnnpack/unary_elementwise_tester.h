@@ -45,6 +45,21 @@ class UnaryElementwiseTester {
 
   int32_t Size() const { return size_; }
 
+  // Adds a shape to resize the input to after the first inference, to run
+  // inference again.
+  inline UnaryElementwiseTester& ResizedShape(
+      std::initializer_list<int32_t> shape) {
+    for (auto it = shape.begin(); it != shape.end(); ++it) {
+      EXPECT_GT(*it, 0);
+    }
+    resized_shapes_.emplace_back(shape.begin(), shape.end());
+    return *this;
+  }
+
+  const std::vector<std::vector<int32_t>>& ResizedShapes() const {
+    return resized_shapes_;
+  }
+
   inline UnaryElementwiseTester& RelativeTolerance(float relative_tolerance) {
     relative_tolerance_ = relative_tolerance;
     return *this;
@@ -61,6 +76,7 @@ class UnaryElementwiseTester {
 
   std::vector<int32_t> shape_;
   int32_t size_;
+  std::vector<std::vector<int32_t>> resized_shapes_;
   float relative_tolerance_{10.0f};
 };
 
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <limits>
 #include <memory>
@@ -29,10 +30,12 @@ limitations under the License.
 
 #include <fp16.h>
 #include <xnnpack.h>
+#include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/tools/optimize/sparsity/format_converter.h"
 
 namespace tflite {
@@ -42,6 +45,36 @@ namespace {
 // Forward declaration.
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate);
 
+// Header of the weights cache file. The unpacked static data follows at
+// kWeightsCacheDataOffset, so that it is as aligned in the mapped file as in
+// memory.
+struct WeightsCacheHeader {
+  char magic[8];
+  uint64_t version;
+  uint64_t fingerprint;
+  uint64_t data_size;
+};
+
+constexpr char kWeightsCacheMagic[8] = {'X', 'N', 'N', 'W', 'C', 'A', 'C', 'H'};
+constexpr uint64_t kWeightsCacheVersion = 1;
+constexpr size_t kWeightsCacheDataOffset = 64;
+
+// Mixes `size` bytes at `data` into `hash`, 8 bytes at a time.
+uint64_t Fingerprint(uint64_t hash, const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + i, std::min(sizeof(uint64_t), size - i));
+    hash = (hash ^ word) * UINT64_C(0x9E3779B97F4A7C15);
+    hash ^= hash >> 32;
+  }
+  return hash;
+}
+
+uint64_t FingerprintValue(uint64_t hash, uint64_t value) {
+  return Fingerprint(hash, &value, sizeof(value));
+}
+
 class Delegate {
   friend class Subgraph;
 
@@ -53,6 +86,16 @@ class Delegate {
           pthreadpool_create(static_cast<size_t>(options->num_threads)));
     }
 #endif
+    if (options != nullptr && options->weights_cache_file_path != nullptr) {
+      weights_cache_file_path_ = options->weights_cache_file_path;
+    }
+    if (options != nullptr && options->runtime_cache_size > 0) {
+      runtime_cache_size_ = options->runtime_cache_size;
+      // Keep the delegate kernels when tensors are resized, and have the
+      // runtime propagate the new shapes to them.
+      delegate_.flags = kTfLiteDelegateFlagsAllowDynamicTensors |
+                        kTfLiteDelegateFlagsRequirePropagatedShapes;
+    }
     TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
                          "Created TensorFlow Lite XNNPACK delegate for CPU.");
   }
@@ -60,6 +103,20 @@ class Delegate {
   TfLiteIntArray* PrepareOpsToDelegate(TfLiteContext* context);
   TfLiteDelegate* tflite_delegate() { return &delegate_; }
 
+  // Unpacked data for quasi-static tensors, either in memory or mapped from
+  // the weights cache file.
+  const char* static_unpacked_data() const {
+    if (weights_cache_ != nullptr) {
+      return static_cast<const char*>(weights_cache_->base()) +
+             kWeightsCacheDataOffset;
+    }
+    return static_unpacked_data_.data();
+  }
+
+  // Number of XNNPACK runtimes, for different input shapes, that every
+  // delegate kernel keeps, or 0 if delegate kernels are recreated on resize.
+  int runtime_cache_size() const { return runtime_cache_size_; }
+
   pthreadpool_t threadpool() const {
 #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
     return nullptr;
@@ -78,6 +135,21 @@ class Delegate {
       kTfLiteDelegateFlagsNone,       // .flags
   };
 
+  // Computes the fingerprint and the size of the static data to unpack into
+  // `tensors`, laid out as in static_unpacked_data_. The fingerprint covers
+  // the unpacking nodes and the contents of the static tensors they read.
+  void FingerprintStaticData(
+      TfLiteContext* context, const std::vector<int>& tensors,
+      const std::unordered_map<int, int>& quasi_static_tensors_producers,
+      uint64_t* fingerprint, size_t* data_size) const;
+
+  // Maps the weights cache file into weights_cache_ if it holds `data_size`
+  // bytes of unpacked data with the given fingerprint.
+  bool LoadWeightsCache(uint64_t fingerprint, size_t data_size);
+
+  // Writes static_unpacked_data_ to the weights cache file.
+  bool SaveWeightsCache(uint64_t fingerprint);
+
   // Unpacked data for quasi-static tensors, i.e. tensors produced by
   // dequantizing or unpacking static buffers.
   std::vector<char> static_unpacked_data_;
@@ -91,6 +163,13 @@ class Delegate {
   std::unordered_set<int> static_unpack_nodes_;
   // Set of indices of tensors with unpacked static sparse weights.
   std::unordered_set<int> static_sparse_weights_;
+  // See runtime_cache_size().
+  int runtime_cache_size_ = 0;
+  // Path of the file caching static_unpacked_data_, or empty.
+  std::string weights_cache_file_path_;
+  // Mapping of the weights cache file. When set, it holds the unpacked data
+  // for quasi-static tensors instead of static_unpacked_data_.
+  std::unique_ptr<MMAPAllocation> weights_cache_;
 #if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
   // Thread pool with smart-pointer for lifetime management.
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)> threadpool_{
@@ -103,6 +182,30 @@ class Subgraph {
   static Subgraph* Create(TfLiteContext* context,
                           const TfLiteDelegateParams* params,
                           const Delegate* delegate) {
+    if (delegate->runtime_cache_size() > 0) {
+      // Tensor shapes are only known to be propagated in Prepare(), which
+      // creates the runtime.
+      return new Subgraph(params, delegate);
+    }
+
+    std::unordered_set<int> externals;
+    xnn_runtime_t runtime =
+        CreateRuntime(context, params, delegate, &externals);
+    if (runtime == nullptr) {
+      return nullptr;
+    }
+    Subgraph* subgraph = new Subgraph(params, delegate);
+    subgraph->runtimes_.emplace_back(std::vector<int>(), runtime);
+    subgraph->externals_ = std::move(externals);
+    return subgraph;
+  }
+
+  // Creates an XNNPACK runtime for the delegated nodes with the current tensor
+  // shapes. `externals` receives the tensors to pass in xnn_setup_runtime().
+  static xnn_runtime_t CreateRuntime(TfLiteContext* context,
+                                     const TfLiteDelegateParams* params,
+                                     const Delegate* delegate,
+                                     std::unordered_set<int>* externals_out) {
     // Convert subgraph inputs and outputs to hash sets for faster lookup.
     const std::unordered_set<int> inputs(
         &params->input_tensors->data[0],
@@ -249,7 +352,7 @@ class Subgraph {
         // Check for quasi-static data.
         const auto it = delegate->static_unpacked_data_map_.find(t);
         if (it != delegate->static_unpacked_data_map_.end()) {
-          data = delegate->static_unpacked_data_.data() + it->second;
+          data = delegate->static_unpacked_data() + it->second;
         }
       }
       if (inputs.count(t) != 0) {
@@ -326,12 +429,67 @@ class Subgraph {
       return nullptr;
     }
 
-    return new Subgraph(runtime_ptr, std::move(externals));
+    *externals_out = std::move(externals);
+    return runtime_ptr;
   }
 
-  TfLiteStatus Prepare(TfLiteContext* context) { return kTfLiteOk; }
+  TfLiteStatus Prepare(TfLiteContext* context) {
+    if (delegate_->runtime_cache_size() <= 0) {
+      return kTfLiteOk;
+    }
+
+    // Tensors may have been resized and reallocated since the last run.
+    first_run_ = true;
+
+    // Shapes of all the other tensors follow from the input shapes.
+    std::vector<int> input_shapes;
+    for (int t : inputs_) {
+      const TfLiteTensor& tensor = context->tensors[t];
+      if (tensor.allocation_type == kTfLiteMmapRo) {
+        continue;
+      }
+      input_shapes.push_back(tensor.dims->size);
+      input_shapes.insert(input_shapes.end(), &tensor.dims->data[0],
+                          &tensor.dims->data[tensor.dims->size]);
+    }
+
+    auto runtime_it =
+        std::find_if(runtimes_.begin(), runtimes_.end(),
+                     [&input_shapes](const CachedRuntime& cached_runtime) {
+                       return cached_runtime.input_shapes == input_shapes;
+                     });
+    if (runtime_it != runtimes_.end()) {
+      // Keep the most recently used runtime first.
+      std::rotate(runtimes_.begin(), runtime_it, runtime_it + 1);
+      return kTfLiteOk;
+    }
+
+    TfLiteDelegateParams params = {};
+    params.nodes_to_replace = nodes_to_replace_.get();
+    params.input_tensors = input_tensors_.get();
+    params.output_tensors = output_tensors_.get();
+    std::unordered_set<int> externals;
+    xnn_runtime_t runtime =
+        CreateRuntime(context, &params, delegate_, &externals);
+    if (runtime == nullptr) {
+      return kTfLiteError;
+    }
+    if (runtimes_.size() >=
+        static_cast<size_t>(delegate_->runtime_cache_size())) {
+      runtimes_.pop_back();
+    }
+    runtimes_.emplace(runtimes_.begin(), std::move(input_shapes), runtime);
+    externals_ = std::move(externals);
+    return kTfLiteOk;
+  }
 
   TfLiteStatus Invoke(TfLiteContext* context) {
+    if (runtimes_.empty()) {
+      TF_LITE_KERNEL_LOG(context, "XNNPACK runtime was not prepared");
+      return kTfLiteError;
+    }
+    xnn_runtime_t runtime = runtimes_.front().runtime.get();
+
     if (first_run_) {
       std::vector<xnn_external_value> external_values;
       for (int t : externals_) {
@@ -342,7 +500,7 @@ class Subgraph {
       }
 
       const xnn_status status = xnn_setup_runtime(
-          runtime_.get(), external_values.size(), external_values.data());
+          runtime, external_values.size(), external_values.data());
       if (status != xnn_status_success) {
         TF_LITE_KERNEL_LOG(context, "failed to setup XNNPACK runtime");
         return kTfLiteError;
@@ -351,7 +509,7 @@ class Subgraph {
       first_run_ = false;
     }
 
-    const xnn_status status = xnn_invoke_runtime(runtime_.get());
+    const xnn_status status = xnn_invoke_runtime(runtime);
     if (status != xnn_status_success) {
       TF_LITE_KERNEL_LOG(context, "failed to invoke XNNPACK runtime");
       return kTfLiteError;
@@ -3006,13 +3164,43 @@ class Subgraph {
   }
 
  private:
-  Subgraph(xnn_runtime_t runtime, std::unordered_set<int>&& externals)
-      : runtime_(runtime, &xnn_delete_runtime), externals_(externals) {}
+  // XNNPACK Runtime (subgraph + workspace) for the given input shapes, with
+  // smart-pointer for lifetime management.
+  struct CachedRuntime {
+    CachedRuntime(std::vector<int> input_shapes, xnn_runtime_t runtime)
+        : input_shapes(std::move(input_shapes)),
+          runtime(runtime, &xnn_delete_runtime) {}
+
+    std::vector<int> input_shapes;
+    std::unique_ptr<xnn_runtime, decltype(&xnn_delete_runtime)> runtime;
+  };
 
-  // XNNPACK Runtime (subgraph + workspace) with smart-pointer for lifetime
-  // management.
-  std::unique_ptr<xnn_runtime, decltype(&xnn_delete_runtime)> runtime_{
-      nullptr, &xnn_delete_runtime};
+  using IntArrayPtr =
+      std::unique_ptr<TfLiteIntArray, void (*)(TfLiteIntArray*)>;
+
+  Subgraph(const TfLiteDelegateParams* params, const Delegate* delegate)
+      : delegate_(delegate),
+        nodes_to_replace_(TfLiteIntArrayCopy(params->nodes_to_replace),
+                          &TfLiteIntArrayFree),
+        input_tensors_(TfLiteIntArrayCopy(params->input_tensors),
+                       &TfLiteIntArrayFree),
+        output_tensors_(TfLiteIntArrayCopy(params->output_tensors),
+                        &TfLiteIntArrayFree),
+        inputs_(&params->input_tensors->data[0],
+                &params->input_tensors->data[params->input_tensors->size]) {}
+
+  const Delegate* delegate_;
+  // Copy of the delegate parameters, to create runtimes for new shapes.
+  IntArrayPtr nodes_to_replace_;
+  IntArrayPtr input_tensors_;
+  IntArrayPtr output_tensors_;
+  std::vector<int> inputs_;
+  // Runtimes, the most recently used one first. When the delegate keeps
+  // delegate kernels on resize, up to Delegate::runtime_cache_size() runtimes
+  // are kept for different input shapes, so that alternating shapes (e.g.
+  // sequence lengths) don't recreate them. Otherwise the only runtime is
+  // created in Create().
+  std::vector<CachedRuntime> runtimes_;
   // TFLite Tensor IDs == XNNPACK Value IDs of input/output tensors for the
   // delegated subgraph.
   std::unordered_set<int> externals_;
@@ -3025,6 +3213,7 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   static_unpacked_data_.clear();
   static_unpack_nodes_.clear();
   static_sparse_weights_.clear();
+  weights_cache_.reset();
 
   TfLiteIntArray* execution_plan = nullptr;
   if (context->GetExecutionPlan(context, &execution_plan) != kTfLiteOk) {
@@ -3154,7 +3343,21 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
                      quasi_static_tensors_producers[t2];
             });
 
+  // Look up the unpacked data in the weights cache, if any.
+  uint64_t static_data_fingerprint = 0;
+  bool static_data_is_cached = false;
+  if (!weights_cache_file_path_.empty() &&
+      !sorted_quasi_static_tensors_to_unpack.empty()) {
+    size_t static_data_size = 0;
+    FingerprintStaticData(context, sorted_quasi_static_tensors_to_unpack,
+                          quasi_static_tensors_producers,
+                          &static_data_fingerprint, &static_data_size);
+    static_data_is_cached =
+        LoadWeightsCache(static_data_fingerprint, static_data_size);
+  }
+
   // Unpack static data of all tensors
+  size_t static_data_size = 0;
   for (int t : sorted_quasi_static_tensors_to_unpack) {
     const int producer_index = quasi_static_tensors_producers[t];
     // Check if TFLite nodes can be delegated to XNNPACK
@@ -3221,11 +3424,15 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     }
 
     // Align to XNN_EXTRA_BYTES bytes
-    while (static_unpacked_data_.size() % XNN_EXTRA_BYTES != 0) {
-      static_unpacked_data_.push_back(0);
+    const size_t tensor_offset =
+        (static_data_size + XNN_EXTRA_BYTES - 1) / XNN_EXTRA_BYTES *
+        XNN_EXTRA_BYTES;
+    static_data_size = tensor_offset + context->tensors[t].bytes;
+    if (static_data_is_cached) {
+      static_unpacked_data_map_[t] = tensor_offset;
+      continue;
     }
-    const size_t tensor_offset = static_unpacked_data_.size();
-    static_unpacked_data_.resize(tensor_offset + context->tensors[t].bytes);
+    static_unpacked_data_.resize(static_data_size);
 
     char* unpacked_data = static_unpacked_data_.data() + tensor_offset;
     const char* packed_data =
@@ -3318,6 +3525,15 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
     static_unpacked_data_map_[t] = tensor_offset;
   }
 
+  // Share the unpacked data with later delegates, and with other processes
+  // by mapping it from the cache file rather than keeping a private copy.
+  if (!weights_cache_file_path_.empty() && !static_data_is_cached &&
+      !static_unpacked_data_.empty() &&
+      SaveWeightsCache(static_data_fingerprint) &&
+      LoadWeightsCache(static_data_fingerprint, static_unpacked_data_.size())) {
+    std::vector<char>().swap(static_unpacked_data_);
+  }
+
   // Add nodes that unpack static data consumed by delegated nodes.
   // Note: this is done purely to avoid the overhead of running these nodes
   // again in TFLite interpreter which would allocate memory for their outputs.
@@ -3345,6 +3561,121 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   return nodes_to_delegate;
 }
 
+void Delegate::FingerprintStaticData(
+    TfLiteContext* context, const std::vector<int>& tensors,
+    const std::unordered_map<int, int>& quasi_static_tensors_producers,
+    uint64_t* fingerprint, size_t* data_size) const {
+  uint64_t hash = FingerprintValue(kWeightsCacheVersion, XNN_EXTRA_BYTES);
+  size_t size = 0;
+  for (int t : tensors) {
+    const TfLiteTensor& output_tensor = context->tensors[t];
+    size = (size + XNN_EXTRA_BYTES - 1) / XNN_EXTRA_BYTES * XNN_EXTRA_BYTES +
+           output_tensor.bytes;
+    hash = FingerprintValue(hash, t);
+    hash = FingerprintValue(hash, output_tensor.type);
+    hash = FingerprintValue(hash, output_tensor.bytes);
+
+    const auto producer_it = quasi_static_tensors_producers.find(t);
+    TfLiteNode* node = nullptr;
+    TfLiteRegistration* registration = nullptr;
+    if (producer_it == quasi_static_tensors_producers.end() ||
+        context->GetNodeAndRegistration(context, producer_it->second, &node,
+                                        &registration) != kTfLiteOk ||
+        node->inputs->size != 1) {
+      // PrepareOpsToDelegate() fails for such tensors.
+      continue;
+    }
+    hash = FingerprintValue(hash, registration->builtin_code);
+    const int input = node->inputs->data[0];
+    const TfLiteTensor& input_tensor = context->tensors[input];
+    hash = FingerprintValue(hash, input);
+    hash = FingerprintValue(hash, input_tensor.type);
+    hash = FingerprintValue(hash, input_tensor.bytes);
+    if (input_tensor.allocation_type == kTfLiteMmapRo) {
+      hash = Fingerprint(hash, input_tensor.data.raw_const, input_tensor.bytes);
+    }
+  }
+  *fingerprint = hash;
+  *data_size = size;
+}
+
+bool Delegate::LoadWeightsCache(uint64_t fingerprint, size_t data_size) {
+  weights_cache_.reset();
+  if (!MMAPAllocation::IsSupported()) {
+    return false;
+  }
+  FILE* file = std::fopen(weights_cache_file_path_.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  WeightsCacheHeader header;
+  const bool header_matches =
+      std::fread(&header, sizeof(header), 1, file) == 1 &&
+      std::memcmp(header.magic, kWeightsCacheMagic, sizeof(header.magic)) ==
+          0 &&
+      header.version == kWeightsCacheVersion &&
+      header.fingerprint == fingerprint && header.data_size == data_size;
+  std::fclose(file);
+  if (!header_matches) {
+    return false;
+  }
+
+  std::unique_ptr<MMAPAllocation> weights_cache(new MMAPAllocation(
+      weights_cache_file_path_.c_str(), DefaultErrorReporter()));
+  if (!weights_cache->valid() ||
+      weights_cache->bytes() <
+          kWeightsCacheDataOffset + data_size + XNN_EXTRA_BYTES) {
+    return false;
+  }
+  weights_cache_ = std::move(weights_cache);
+  TFLITE_LOG(tflite::TFLITE_LOG_INFO, "Loaded XNNPACK weights cache from %s.",
+             weights_cache_file_path_.c_str());
+  return true;
+}
+
+bool Delegate::SaveWeightsCache(uint64_t fingerprint) {
+  // Write to a temporary file first, so that other processes never map a
+  // partially written cache.
+  const std::string temporary_path = weights_cache_file_path_ + ".tmp";
+  FILE* file = std::fopen(temporary_path.c_str(), "wb");
+  if (file == nullptr) {
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                    "Failed to create XNNPACK weights cache %s.",
+                    temporary_path.c_str());
+    return false;
+  }
+  WeightsCacheHeader header;
+  std::memcpy(header.magic, kWeightsCacheMagic, sizeof(header.magic));
+  header.version = kWeightsCacheVersion;
+  header.fingerprint = fingerprint;
+  header.data_size = static_unpacked_data_.size();
+  // The data is followed by XNN_EXTRA_BYTES of padding, like XNNPACK inputs.
+  const std::vector<char> padding(
+      std::max<size_t>(kWeightsCacheDataOffset - sizeof(header),
+                       XNN_EXTRA_BYTES));
+  bool written =
+      std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+      std::fwrite(padding.data(), kWeightsCacheDataOffset - sizeof(header), 1,
+                  file) == 1 &&
+      std::fwrite(static_unpacked_data_.data(), static_unpacked_data_.size(),
+                  1, file) == 1 &&
+      std::fwrite(padding.data(), XNN_EXTRA_BYTES, 1, file) == 1;
+  written = std::fclose(file) == 0 && written;
+  if (written) {
+    // Replacing an existing file fails on some platforms.
+    std::remove(weights_cache_file_path_.c_str());
+    written = std::rename(temporary_path.c_str(),
+                          weights_cache_file_path_.c_str()) == 0;
+  }
+  if (!written) {
+    std::remove(temporary_path.c_str());
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                    "Failed to write XNNPACK weights cache %s.",
+                    weights_cache_file_path_.c_str());
+  }
+  return written;
+}
+
 void* SubgraphInit(TfLiteContext* context, const char* buffer, size_t length) {
   const TfLiteDelegateParams* params =
       reinterpret_cast<const TfLiteDelegateParams*>(buffer);
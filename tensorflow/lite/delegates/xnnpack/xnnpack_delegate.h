@@ -26,6 +26,25 @@ typedef struct {
   // Number of threads to use in the thread pool.
   // 0 or negative value means no thread pool used.
   int32_t num_threads;
+  // Path of a file caching the static weights that the delegate unpacks, i.e.
+  // FP16 weights dequantized to FP32 and sparse weights densified. The file is
+  // written the first time the weights are unpacked and memory-mapped by later
+  // delegate instances for the same model, which skip unpacking and share the
+  // unpacked weights with other processes. The cache is rewritten when the
+  // weights no longer match it. NULL disables caching.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  const char* weights_cache_file_path;
+  // Number of XNNPACK runtimes, one per set of input shapes, that every
+  // delegated subgraph keeps. When positive, resizing input tensors no longer
+  // re-applies the delegate, which unpacks the static weights and recreates
+  // every runtime again. Instead the delegate kernels switch to the runtime
+  // for the new input shapes, creating it if it isn't among the most recently
+  // used ones. Useful for models run with a few alternating input shapes, e.g.
+  // sequence lengths. 0 or negative value re-applies the delegate on resize.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  int32_t runtime_cache_size;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns a structure with the default XNNPack delegate options.
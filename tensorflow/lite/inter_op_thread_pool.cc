@@ -0,0 +1,93 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/inter_op_thread_pool.h"
+
+#include <functional>
+#include <mutex>  // NOLINT
+
+namespace tflite {
+
+InterOpThreadPool::InterOpThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    workers_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  batch_posted_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void InterOpThreadPool::Run(
+    int num_tasks,
+    const std::function<void(int task_index, int thread_index)>& task) {
+  if (num_tasks <= 0) return;
+  if (workers_.empty() || num_tasks == 1) {
+    for (int i = 0; i < num_tasks; ++i) {
+      task(i, 0);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    num_unfinished_tasks_ = num_tasks;
+    ++batch_;
+  }
+  batch_posted_.notify_all();
+  RunTasks(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  batch_done_.wait(lock, [this]() { return num_unfinished_tasks_ == 0; });
+  task_ = nullptr;
+}
+
+void InterOpThreadPool::WorkerLoop(int thread_index) {
+  int last_batch = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      batch_posted_.wait(lock, [this, last_batch]() {
+        return shutdown_ || batch_ != last_batch;
+      });
+      if (shutdown_) return;
+      last_batch = batch_;
+    }
+    RunTasks(thread_index);
+  }
+}
+
+void InterOpThreadPool::RunTasks(int thread_index) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (task_ != nullptr && next_task_ < num_tasks_) {
+    const int task_index = next_task_++;
+    const std::function<void(int, int)>& task = *task_;
+    lock.unlock();
+    task(task_index, thread_index);
+    lock.lock();
+    if (--num_unfinished_tasks_ == 0) {
+      batch_done_.notify_one();
+    }
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,74 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
+#define TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace tflite {
+
+// A fixed set of threads that run batches of independent tasks, as used by a
+// Subgraph to execute nodes that don't depend on each other concurrently.
+// The thread calling Run() takes part in running the batch, so a pool of
+// `num_threads` owns `num_threads - 1` threads of its own.
+//
+// Run() must not be called concurrently, nor from one of its own tasks.
+class InterOpThreadPool {
+ public:
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+
+  // Total number of threads running tasks, including the caller of Run().
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Runs `task(task_index, thread_index)` for every task_index in
+  // [0, num_tasks) and returns once all of them finished. `thread_index` is in
+  // [0, num_threads()) and identifies the thread running the task, 0 being the
+  // caller's thread, so that tasks may use per-thread state.
+  void Run(int num_tasks,
+           const std::function<void(int task_index, int thread_index)>& task);
+
+ private:
+  void WorkerLoop(int thread_index);
+  // Runs tasks of the current batch until none is left.
+  void RunTasks(int thread_index);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  // Signaled when a new batch is posted or the pool shuts down.
+  std::condition_variable batch_posted_;
+  // Signaled when the last task of a batch finishes.
+  std::condition_variable batch_done_;
+  // Incremented for every batch, so that workers can tell a new batch apart
+  // from a spurious wakeup.
+  int batch_ = 0;
+  bool shutdown_ = false;
+  const std::function<void(int, int)>* task_ = nullptr;
+  int num_tasks_ = 0;
+  int next_task_ = 0;
+  int num_unfinished_tasks_ = 0;
+
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_INTER_OP_THREAD_POOL_H_
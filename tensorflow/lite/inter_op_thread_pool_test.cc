@@ -0,0 +1,58 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/inter_op_thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+TEST(InterOpThreadPoolTest, RunsEveryTaskOnce) {
+  for (int num_threads = 1; num_threads <= 4; ++num_threads) {
+    InterOpThreadPool pool(num_threads);
+    EXPECT_EQ(pool.num_threads(), num_threads);
+    for (int num_tasks = 0; num_tasks < 10; ++num_tasks) {
+      std::vector<std::atomic<int>> runs(num_tasks);
+      for (auto& r : runs) r = 0;
+      pool.Run(num_tasks, [&](int task_index, int thread_index) {
+        EXPECT_GE(thread_index, 0);
+        EXPECT_LT(thread_index, num_threads);
+        ++runs[task_index];
+      });
+      for (const auto& r : runs) {
+        EXPECT_EQ(r, 1);
+      }
+    }
+  }
+}
+
+TEST(InterOpThreadPoolTest, RunsTasksConcurrently) {
+  InterOpThreadPool pool(2);
+  // Both tasks wait for each other, which only finishes if they run at the
+  // same time.
+  std::atomic<int> started(0);
+  pool.Run(2, [&](int, int) {
+    ++started;
+    while (started < 2) {
+    }
+  });
+  EXPECT_EQ(started, 2);
+}
+
+}  // namespace
+}  // namespace tflite
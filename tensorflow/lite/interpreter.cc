@@ -376,6 +376,17 @@ TfLiteStatus Interpreter::SetNumThreads(int num_threads) {
   return kTfLiteOk;
 }
 
+TfLiteStatus Interpreter::SetNumInterOpThreads(int num_threads) {
+  return primary_subgraph().SetNumInterOpThreads(num_threads);
+}
+
+TfLiteStatus Interpreter::SetWeightPagingWindow(int num_ops) {
+  for (auto& subgraph : subgraphs_) {
+    TF_LITE_ENSURE_STATUS(subgraph->SetWeightPagingWindow(num_ops));
+  }
+  return kTfLiteOk;
+}
+
 void Interpreter::SetAllowFp16PrecisionForFp32(bool allow) {
   for (auto& subgraph : subgraphs_) {
     subgraph->context()->allow_fp32_relax_to_fp16 = allow;
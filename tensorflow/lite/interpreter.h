@@ -453,6 +453,28 @@ class Interpreter {
   /// implementation-defined and platform-dependent.
   TfLiteStatus SetNumThreads(int num_threads);
 
+  /// Run nodes of the primary subgraph that don't depend on each other
+  /// concurrently, on up to `num_threads` threads. Takes effect at the next
+  /// AllocateTensors(), which must be called before Invoke(). 1 (the default)
+  /// runs one node at a time.
+  ///
+  /// Ops still use the threads set by SetNumThreads() within each node, so the
+  /// two are usually balanced, e.g. SetNumThreads(1) for many small branches.
+  /// Nodes run one at a time when the graph has dynamic tensors or a profiler
+  /// is set.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetNumInterOpThreads(int num_threads);
+
+  /// Page the weights of a memory-mapped model in and out while it runs, for
+  /// models larger than the available memory: the weights of the next
+  /// `num_ops` nodes are prefetched ahead of their execution and released
+  /// after their last use within that window. Takes effect at the next
+  /// AllocateTensors(), which must be called before Invoke(). 0 (the default)
+  /// leaves paging to the OS. Has no effect on weights copied in memory, e.g.
+  /// by a delegate.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus SetWeightPagingWindow(int num_ops);
+
   /// Allow float16 precision for FP32 calculation when possible.
   /// Default: not allow.
   ///
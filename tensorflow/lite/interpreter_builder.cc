@@ -142,6 +142,10 @@ std::map<std::string, uint32_t> GetMapFromTensorMap(
   return result;
 }
 
+// Name of the metadata holding arena offsets planned ahead of time, as written
+// by tools/optimize:offline_memory_planner and read by TF Lite Micro.
+constexpr char kOfflineMemoryAllocationMetadata[] = "OfflineMemoryAllocation";
+
 }  // namespace
 
 const char* kEmptyTensorName = "";
@@ -497,6 +501,48 @@ TfLiteStatus InterpreterBuilder::ParseSparsity(
   return kTfLiteOk;
 }
 
+TfLiteStatus InterpreterBuilder::ParseOfflineMemoryPlan(
+    Interpreter* interpreter) {
+  const auto* metadata_list = model_->metadata();
+  if (metadata_list == nullptr) return kTfLiteOk;
+  for (const auto metadata : *metadata_list) {
+    if (metadata == nullptr || metadata->name() == nullptr ||
+        metadata->name()->str() != kOfflineMemoryAllocationMetadata) {
+      continue;
+    }
+    // The buffer holds int32 words: version, subgraph index, number of
+    // tensors and then the arena offset of every tensor, or -1.
+    const auto* buffers = model_->buffers();
+    const Buffer* buffer = metadata->buffer() < buffers->size()
+                               ? buffers->Get(metadata->buffer())
+                               : nullptr;
+    if (buffer == nullptr || buffer->data() == nullptr ||
+        buffer->data()->size() < 3 * sizeof(int32_t)) {
+      TF_LITE_REPORT_ERROR(error_reporter_, "Invalid %s metadata.",
+                           kOfflineMemoryAllocationMetadata);
+      return kTfLiteError;
+    }
+    std::vector<int32_t> words(buffer->data()->size() / sizeof(int32_t));
+    memcpy(words.data(), buffer->data()->data(),
+           words.size() * sizeof(int32_t));
+    const int32_t version = words[0];
+    const int32_t subgraph_index = words[1];
+    const int32_t num_tensors = words[2];
+    if (version != 1 || subgraph_index < 0 ||
+        static_cast<size_t>(subgraph_index) >= interpreter->subgraphs_size() ||
+        num_tensors != interpreter->subgraph(subgraph_index)->tensors_size() ||
+        words.size() != 3 + static_cast<size_t>(num_tensors)) {
+      TF_LITE_REPORT_ERROR(error_reporter_, "Invalid %s metadata.",
+                           kOfflineMemoryAllocationMetadata);
+      return kTfLiteError;
+    }
+    interpreter->subgraph(subgraph_index)
+        ->SetOfflinePlannedOffsets(
+            std::vector<int32_t>(words.begin() + 3, words.end()));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus InterpreterBuilder::ParseSignatureDefs(
     const flatbuffers::Vector<flatbuffers::Offset<SignatureDef>>*
         signature_def_list,
@@ -799,6 +845,10 @@ TfLiteStatus InterpreterBuilder::operator()(
     return cleanup_and_error();
   }
 
+  if (ParseOfflineMemoryPlan(interpreter->get()) != kTfLiteOk) {
+    return cleanup_and_error();
+  }
+
   if (num_fp32_tensors_ > 0) {
     (*interpreter)->lazy_delegate_providers_ =
         op_resolver_.GetDelegates(num_threads_);
@@ -0,0 +1,97 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/interpreter_pool.h"
+
+#include <utility>
+
+#include "tensorflow/lite/interpreter_builder.h"
+
+namespace tflite {
+
+InterpreterPool::Lease::Lease(Lease&& other)
+    : pool_(other.pool_), interpreter_(std::move(other.interpreter_)) {
+  other.pool_ = nullptr;
+}
+
+InterpreterPool::Lease& InterpreterPool::Lease::operator=(Lease&& other) {
+  if (this != &other) {
+    Release();
+    pool_ = other.pool_;
+    interpreter_ = std::move(other.interpreter_);
+    other.pool_ = nullptr;
+  }
+  return *this;
+}
+
+InterpreterPool::Lease::~Lease() { Release(); }
+
+void InterpreterPool::Lease::Release() {
+  if (pool_ != nullptr && interpreter_ != nullptr) {
+    pool_->Release(std::move(interpreter_));
+  }
+  pool_ = nullptr;
+}
+
+InterpreterPool::InterpreterPool(const FlatBufferModel* model,
+                                 const OpResolver* op_resolver,
+                                 int num_threads, int max_idle_interpreters)
+    : model_(model),
+      op_resolver_(op_resolver),
+      num_threads_(num_threads),
+      max_idle_interpreters_(max_idle_interpreters) {}
+
+TfLiteStatus InterpreterPool::Acquire(Lease* lease) {
+  std::unique_ptr<Interpreter> interpreter;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!idle_interpreters_.empty()) {
+      interpreter = std::move(idle_interpreters_.back());
+      idle_interpreters_.pop_back();
+    }
+  }
+  if (interpreter == nullptr) {
+    // Building and planning an interpreter is the expensive part, so it is
+    // done outside of the lock.
+    InterpreterBuilder builder(*model_, *op_resolver_);
+    if (builder(&interpreter, num_threads_) != kTfLiteOk ||
+        interpreter == nullptr) {
+      return kTfLiteError;
+    }
+    if (interpreter->AllocateTensors() != kTfLiteOk) {
+      return kTfLiteError;
+    }
+  }
+  *lease = Lease();
+  lease->pool_ = this;
+  lease->interpreter_ = std::move(interpreter);
+  return kTfLiteOk;
+}
+
+int InterpreterPool::num_idle_interpreters() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(idle_interpreters_.size());
+}
+
+void InterpreterPool::Release(std::unique_ptr<Interpreter> interpreter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (static_cast<int>(idle_interpreters_.size()) < max_idle_interpreters_) {
+    idle_interpreters_.push_back(std::move(interpreter));
+  }
+  // Otherwise the interpreter is destroyed here. That is rare enough (more
+  // concurrent executions than idle slots) for doing it under the lock to be
+  // fine.
+}
+
+}  // namespace tflite
@@ -0,0 +1,104 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+/// Serving one model to many threads.
+#ifndef TENSORFLOW_LITE_INTERPRETER_POOL_H_
+#define TENSORFLOW_LITE_INTERPRETER_POOL_H_
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+
+/// Runs one model from many threads at once. An `Interpreter` is not
+/// thread-safe, so every concurrent execution gets one of its own. All of them
+/// are built from the same `FlatBufferModel`, whose constant tensors are
+/// referenced rather than copied, and an interpreter is kept around once its
+/// execution finishes, so that later executions neither rebuild the graph nor
+/// re-plan its arena. Memory thus grows with the number of concurrent
+/// executions times the activation (arena) size of the model.
+///
+/// Usage:
+///
+/// <pre><code>
+/// InterpreterPool pool(model.get(), &resolver);
+/// // On any thread:
+/// InterpreterPool::Lease lease;
+/// if (pool.Acquire(&lease) != kTfLiteOk) return ...;
+/// // Fill the inputs of lease.interpreter(), then:
+/// lease.interpreter()->Invoke();
+/// // The interpreter returns to the pool when `lease` is destroyed.
+/// </code></pre>
+class InterpreterPool {
+ public:
+  /// Exclusive use of one interpreter of a pool until destroyed.
+  class Lease {
+   public:
+    Lease() = default;
+    Lease(Lease&& other);
+    Lease& operator=(Lease&& other);
+    ~Lease();
+
+    /// The leased interpreter, with its tensors allocated. Null for a
+    /// default-constructed or moved-from lease.
+    Interpreter* interpreter() const { return interpreter_.get(); }
+
+   private:
+    friend class InterpreterPool;
+
+    void Release();
+
+    InterpreterPool* pool_ = nullptr;
+    std::unique_ptr<Interpreter> interpreter_;
+  };
+
+  /// `model` and `op_resolver` must outlive the pool. Interpreters run their
+  /// kernels on `num_threads` threads (-1 lets TF Lite decide). At most
+  /// `max_idle_interpreters` idle interpreters are kept; the others are
+  /// destroyed when their lease ends.
+  InterpreterPool(const FlatBufferModel* model, const OpResolver* op_resolver,
+                  int num_threads = -1, int max_idle_interpreters = 16);
+
+  InterpreterPool(const InterpreterPool&) = delete;
+  InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+  /// Leases an idle interpreter, or builds one if there is none. Any input
+  /// the previous user resized keeps its shape. Thread-safe.
+  TfLiteStatus Acquire(Lease* lease);
+
+  /// Number of idle interpreters currently held by the pool.
+  int num_idle_interpreters() const;
+
+ private:
+  void Release(std::unique_ptr<Interpreter> interpreter);
+
+  const FlatBufferModel* model_;
+  const OpResolver* op_resolver_;
+  const int num_threads_;
+  const int max_idle_interpreters_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Interpreter>> idle_interpreters_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_INTERPRETER_POOL_H_
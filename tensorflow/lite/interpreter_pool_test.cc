@@ -0,0 +1,117 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/interpreter_pool.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+namespace {
+
+// add.bin computes output = (input + input) + input on a 1x8x8x3 tensor.
+class InterpreterPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile("tensorflow/lite/testdata/add.bin");
+    ASSERT_TRUE(model_);
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver_;
+};
+
+TEST_F(InterpreterPoolTest, ReusesReleasedInterpreter) {
+  InterpreterPool pool(model_.get(), &resolver_);
+  Interpreter* first = nullptr;
+  {
+    InterpreterPool::Lease lease;
+    ASSERT_EQ(pool.Acquire(&lease), kTfLiteOk);
+    first = lease.interpreter();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(pool.num_idle_interpreters(), 0);
+  }
+  EXPECT_EQ(pool.num_idle_interpreters(), 1);
+
+  InterpreterPool::Lease lease;
+  ASSERT_EQ(pool.Acquire(&lease), kTfLiteOk);
+  EXPECT_EQ(lease.interpreter(), first);
+}
+
+TEST_F(InterpreterPoolTest, KeepsAtMostMaxIdleInterpreters) {
+  InterpreterPool pool(model_.get(), &resolver_, /*num_threads=*/1,
+                       /*max_idle_interpreters=*/1);
+  {
+    InterpreterPool::Lease first;
+    InterpreterPool::Lease second;
+    ASSERT_EQ(pool.Acquire(&first), kTfLiteOk);
+    ASSERT_EQ(pool.Acquire(&second), kTfLiteOk);
+    EXPECT_NE(first.interpreter(), second.interpreter());
+  }
+  EXPECT_EQ(pool.num_idle_interpreters(), 1);
+}
+
+TEST_F(InterpreterPoolTest, ConcurrentExecutions) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumIterations = 20;
+  InterpreterPool pool(model_.get(), &resolver_, /*num_threads=*/1);
+  std::vector<std::thread> threads;
+  // Not std::vector<bool>, whose elements share storage across threads.
+  std::vector<int> results(kNumThreads, 0);
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&pool, &results, t]() {
+      bool ok = true;
+      for (int i = 0; i < kNumIterations && ok; ++i) {
+        InterpreterPool::Lease lease;
+        if (pool.Acquire(&lease) != kTfLiteOk) {
+          ok = false;
+          break;
+        }
+        Interpreter* interpreter = lease.interpreter();
+        TfLiteTensor* input = interpreter->tensor(interpreter->inputs()[0]);
+        const int num_elements = input->bytes / sizeof(float);
+        const float value = t * kNumIterations + i;
+        for (int j = 0; j < num_elements; ++j) {
+          input->data.f[j] = value;
+        }
+        if (interpreter->Invoke() != kTfLiteOk) {
+          ok = false;
+          break;
+        }
+        const TfLiteTensor* output =
+            interpreter->tensor(interpreter->outputs()[0]);
+        for (int j = 0; j < num_elements; ++j) {
+          ok = ok && output->data.f[j] == 3 * value;
+        }
+      }
+      results[t] = ok ? 1 : 0;
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kNumThreads; ++t) {
+    EXPECT_EQ(results[t], 1) << "thread " << t;
+  }
+  EXPECT_LE(pool.num_idle_interpreters(), kNumThreads);
+}
+
+}  // namespace
+}  // namespace tflite
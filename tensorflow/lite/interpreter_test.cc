@@ -735,6 +735,61 @@ TEST(BasicInterpreter, ReleaseNonPersistentMemory) {
   ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
 }
 
+TEST(BasicInterpreter, ConcurrentBranches) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2, 4}), kTfLiteOk);
+
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {3}, quantized),
+              kTfLiteOk);
+  }
+
+  // Two branches of two ops each, reading the same input.
+  TfLiteRegistration reg = GetPassthroughOpRegistration();
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0}, {3}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({3}, {4}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(0), kTfLiteError);
+  ASSERT_EQ(interpreter.SetNumInterOpThreads(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // Tensors used by the two branches at the same time must not overlap.
+  auto overlap = [&](int t1, int t2) {
+    const TfLiteTensor* a = interpreter.tensor(t1);
+    const TfLiteTensor* b = interpreter.tensor(t2);
+    return a->data.raw < b->data.raw + b->bytes &&
+           b->data.raw < a->data.raw + a->bytes;
+  };
+  EXPECT_FALSE(overlap(1, 3));
+  EXPECT_FALSE(overlap(2, 3));
+  EXPECT_FALSE(overlap(1, 4));
+
+  for (int run = 0; run < 10; ++run) {
+    for (int i = 0; i < 3; ++i) {
+      interpreter.typed_tensor<float>(0)[i] = run + i;
+    }
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(interpreter.typed_tensor<float>(2)[i], run + i);
+      EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], run + i);
+    }
+  }
+}
+
 // Forcefully divides tensor allocation in three steps: one before invocation
 // and two more at invocation time. This happens because we use string tensors
 // and their sizes can't be determined until invocation time.
@@ -582,7 +582,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                       fw_input_to_input_weights->dims->data[0]);
   }
   TfLiteIntArray* fw_scratch_buffer_size = TfLiteIntArrayCreate(2);
-  fw_scratch_buffer_size->data[0] = n_batch;
+  // The float kernel uses a scratch buffer holding the gates of every time
+  // step to compute their input contribution for the whole sequence at once.
+  fw_scratch_buffer_size->data[0] =
+      is_hybrid_op ? n_batch : n_batch * max_time;
   if (fw_use_cifg) {
     // Reserving space for Cell, Forget, Output gates
     fw_scratch_buffer_size->data[1] = n_fw_cell * 3;
@@ -644,7 +647,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                       bw_input_to_input_weights->dims->data[0]);
   }
   TfLiteIntArray* bw_scratch_buffer_size = TfLiteIntArrayCreate(2);
-  bw_scratch_buffer_size->data[0] = n_batch;
+  // As for the forward cell, the float kernel keeps every time step's gates.
+  bw_scratch_buffer_size->data[0] =
+      is_hybrid_op ? n_batch : n_batch * max_time;
   if (bw_use_cifg) {
     // Reserving space for Cell, Forget, Output gates
     bw_scratch_buffer_size->data[1] = n_bw_cell * 3;
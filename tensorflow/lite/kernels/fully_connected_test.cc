@@ -1234,6 +1234,52 @@ class SparseFullyConnectedOpModel : public SingleOpModel {
   int input_size_;
 };
 
+// In the sparse quantized model the weights are symmetrically quantized to
+// int8 from the given float values, and the input, bias and output are
+// quantized with the given parameters.
+class SparseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseQuantizedFullyConnectedOpModel(TfLiteRegistration* registration,
+                                       int units, const TensorData& input,
+                                       const TensorData& weights,
+                                       const std::vector<float>& weights_data,
+                                       float bias_scale,
+                                       const TensorData& output) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data,
+                                   /*symmetric_quantize=*/true);
+    bias_ = AddInput({TensorType_INT32, {units}, 0, 0, bias_scale});
+    output_ = AddOutput(output);
+
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_RELU)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     /*num_threads=*/1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+  void SetBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
 class SparseFullyConnectedOpTest : public SingleOpTest {
  protected:
   const std::map<string, TfLiteRegistration*>& GetKernelMap() override {
@@ -1524,6 +1570,56 @@ TEST_P(SparseFullyConnectedOpTest, SparseHybrid1x16TestMultiThreaded) {
                     1e-3)));
   }
 }
+TEST_P(SparseFullyConnectedOpTest, SparseInt81x16Test) {
+  std::vector<float> weight_data = {
+      /* 1st row */
+      0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4,
+      1.5, 1.6, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 0.0,
+      /* 2nd row */
+      0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 12.7, -1.0, 0.5, -0.5, 2.0, -2.0, 0.3, -0.3, 1.1, -1.1, 0.7,
+      -0.7, 0.2, -0.2, 0.9, -0.9,
+      /* 3rd row */
+      -0.4, -0.4, -0.4, -0.4, -0.4, -0.4, -0.4, -0.4, -0.4, -0.4, -0.4, -0.4,
+      -0.4, -0.4, -0.4, -0.4, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6,
+      0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6,
+      /* 4th row */
+      0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.0, 0.0, 0.0};
+  TensorData weight = {};
+  weight.type = TensorType_FLOAT32;
+  weight.shape = {4, 32};
+  weight.traversal_order = {0, 1, 2};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {1};
+  weight.block_size = {16};
+  // The weights are quantized with a scale of 12.7 / 127 = 0.1, so the bias
+  // scale is 0.5 * 0.1.
+  SparseQuantizedFullyConnectedOpModel m(
+      GetRegistration(), /*units=*/4,
+      /*input=*/{TensorType_INT8, {2, 32}, -63.5, 64}, weight, weight_data,
+      /*bias_scale=*/0.05,
+      /*output=*/{TensorType_INT8, {}, -31.75, 32});
+  m.SetBias({1.0, -2.0, 0.5, 3.0});
+  m.SetInput({
+      -1.0, -0.5, 0.0,  0.5,  1.0,  -1.0, -0.5, 0.0,  0.5,  1.0,  -1.0,
+      -0.5, 0.0,  0.5,  1.0,  -1.0, -0.5, 0.0,  0.5,  1.0,  -1.0, -0.5,
+      0.0,  0.5,  1.0,  -1.0, -0.5, 0.0,  0.5,  1.0,  -1.0, -0.5,  // b = 0
+      -1.5, 0.0,  1.5,  -0.5, 1.0,  -1.0, 0.5,  -1.5, 0.0,  1.5,  -0.5,
+      1.0,  -1.0, 0.5,  -1.5, 0.0,  1.5,  -0.5, 1.0,  -1.0, 0.5,  -1.5,
+      0.0,  1.5,  -0.5, 1.0,  -1.0, 0.5,  -1.5, 0.0,  1.5,  -0.5,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 4));
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {0.9, 0.0, 0.6, 3.0, 0.0, 20.9, 1.7, 3.0}, 0.25)));
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
@@ -1931,6 +1931,59 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  constexpr int kBlockSize = kInt8ValuesPerNeonVector;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vector + batch * m_cols;
+    for (int row = 0; row < m_rows; ++row) {
+      int32x4_t dotprod_32x4 = vmovq_n_s32(0);
+      int32x4_t row_sum_32x4 = vmovq_n_s32(0);
+
+      for (int i = segments[row]; i < segments[row + 1]; ++i) {
+        const int block_start_index = indices[i] * kBlockSize;
+        const int8_t* vector_block_in_batch_ptr =
+            vector_in_batch + block_start_index;
+
+        // Load 16 int8 values from the vector and matrix row.
+        const int8x16_t vector_s8x16 = vld1q_s8(vector_block_in_batch_ptr);
+        const int8x16_t matrix_s8x16 = vld1q_s8(matrix_ptr);
+        // Multiply the low and high halves into int16 and pairwise add the
+        // products into the int32 accumulator.
+        int16x8_t prod_16x8 =
+            vmull_s8(vget_low_s8(vector_s8x16), vget_low_s8(matrix_s8x16));
+        prod_16x8 = vmlal_s8(prod_16x8, vget_high_s8(vector_s8x16),
+                             vget_high_s8(matrix_s8x16));
+        dotprod_32x4 = vpadalq_s16(dotprod_32x4, prod_16x8);
+        // Keep the sum of the weights to apply the input offset once per row.
+        row_sum_32x4 = vpadalq_s16(row_sum_32x4, vpaddlq_s8(matrix_s8x16));
+        matrix_ptr += kBlockSize;
+      }
+
+      int32_t dotprod = AccumulateNeonLane(dotprod_32x4) +
+                        input_offset * AccumulateNeonLane(row_sum_32x4);
+      if (bias_vector != nullptr) {
+        dotprod += bias_vector[row];
+      }
+      dotprod = MultiplyByQuantizedMultiplier(dotprod, output_multiplier,
+                                              output_shift);
+      dotprod += output_offset;
+      result[batch * m_rows + row] = static_cast<int8_t>(
+          std::min(std::max(dotprod, output_activation_min),
+                   output_activation_max));
+    }
+  }
+}
+
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
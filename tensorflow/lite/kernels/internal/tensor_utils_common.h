@@ -98,6 +98,24 @@ void SparseMatrixBatchVectorMultiplyAccumulate1x4(
     const int32_t* __restrict__ indices, int m_rows, int m_cols,
     const float* __restrict__ vector, int n_batch, float* __restrict__ result);
 
+// Same as the function above, but for an int8 matrix with block pattern 1x16
+// and int8 vectors, as in a fully quantized fully connected op. The matrix
+// must be quantized symmetrically. Each row's dot product with the vector
+// offset by input_offset is added to bias_vector (which may be null),
+// rescaled by output_multiplier and output_shift, offset by output_offset and
+// clamped to [output_activation_min, output_activation_max]. Unlike the other
+// functions, the int8 result is overwritten rather than accumulated to.
+// This function assumes that m_cols is a multiple of the block size (16 in
+// this case) so that there's no incomplete block.
+void SparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
 // Same as the function above, but the matrix is stored in block compressed
 // sparse row format with block pattern 1x16 which consists of two arrays:
 //   1. A matrix array stores non-zero blocks of the matrix in row major.
@@ -146,6 +146,9 @@ inline float GetTensorScale(const TfLiteTensor* tensor) {
 //   n_input, n_aux_input, n_output, n_cell     - size of vectors.
 //   activation                                 - activation to use.
 //   is_input_all_zeros, is_aux_input_all_zeros - if input vectors are all zero.
+//   is_input_precomputed                       - if gate already holds the
+//                                                initial value plus the
+//                                                input_weight * input term.
 //   use_layer_norm                             - if doing layer norm LSTM.
 inline void CalculateLstmGateFloat(
     const float* input, const float* input_to_gate_weights,
@@ -156,22 +159,25 @@ inline void CalculateLstmGateFloat(
     const int n_batch, const int n_input, const int n_aux_input,
     const int n_output, const int n_cell,
     const TfLiteFusedActivation activation, float* gate,
-    const bool is_input_all_zeros, const bool is_aux_input_all_zeros) {
+    const bool is_input_all_zeros, const bool is_aux_input_all_zeros,
+    const bool is_input_precomputed = false) {
   const bool use_peephole = (cell_to_gate_weights != nullptr);
   const bool use_layer_norm = (layer_norm_coefficients != nullptr);
 
-  // Initialize scratch buffers with bias for regular lstm or initialize with
-  // zero for layer norm lstm.
-  if (use_layer_norm) {
-    std::fill_n(gate, n_cell * n_batch, 0.0f);
-  } else {
-    tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_batch, gate);
-  }
-  // For each batch and cell: compute input_weight * input.
-  // Skip if input is all zeros.
-  if (!is_input_all_zeros) {
-    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
-        input_to_gate_weights, n_cell, n_input, input, n_batch, gate);
+  if (!is_input_precomputed) {
+    // Initialize scratch buffers with bias for regular lstm or initialize with
+    // zero for layer norm lstm.
+    if (use_layer_norm) {
+      std::fill_n(gate, n_cell * n_batch, 0.0f);
+    } else {
+      tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_batch, gate);
+    }
+    // For each batch and cell: compute input_weight * input.
+    // Skip if input is all zeros.
+    if (!is_input_all_zeros) {
+      tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          input_to_gate_weights, n_cell, n_input, input, n_batch, gate);
+    }
   }
   // For each batch and cell: compute aux_input_weight * aux_input.
   // Skip if auxiliary input is not available or all zeros.
@@ -200,6 +206,25 @@ inline void CalculateLstmGateFloat(
                                         gate);
 }
 
+// Initializes a gate for a whole sequence with its bias (or zero for layer
+// norm LSTM) and accumulates input_weight * input for all n_vectors input
+// vectors with a single matrix multiplication. The result is consumed by
+// CalculateLstmGateFloat with is_input_precomputed set, one step at a time.
+void PrecomputeLstmGateInputFloat(const float* input,
+                                  const float* input_to_gate_weights,
+                                  const float* layer_norm_coefficients,
+                                  const float* gate_bias, const int n_vectors,
+                                  const int n_input, const int n_cell,
+                                  float* gate) {
+  if (layer_norm_coefficients != nullptr) {
+    std::fill_n(gate, n_cell * n_vectors, 0.0f);
+  } else {
+    tensor_utils::VectorBatchVectorAssign(gate_bias, n_cell, n_vectors, gate);
+  }
+  tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+      input_to_gate_weights, n_cell, n_input, input, n_vectors, gate);
+}
+
 // Updates the LSTM cell state, used by both float and hybrid LSTM versions.
 //
 // Implements the following formula:
@@ -831,7 +856,8 @@ inline void LstmStepFloat(
     const TfLiteLSTMParams* params, int n_batch, int n_cell, int n_input,
     int n_aux_input, int n_output, int output_batch_leading_dim,
     float* output_state_ptr, float* cell_state_ptr, float* scratch0,
-    float* scratch1, float* scratch2, float* scratch3, float* output_ptr) {
+    float* scratch1, float* scratch2, float* scratch3, float* output_ptr,
+    bool input_gates_precomputed = false) {
   ruy::profiler::ScopeLabel label("LstmStepFloat");
   // Since we have already checked that weights are all there or none, we can
   // check the existence of only one to the get the condition.
@@ -843,8 +869,10 @@ inline void LstmStepFloat(
   float* cell_gate_scratch = scratch2;
   float* output_gate_scratch = scratch3;
 
-  // Check if inputs are all zeros so we can skip some computations.
+  // Check if inputs are all zeros so we can skip some computations. The check
+  // is not needed when the input contribution of the gates is precomputed.
   const bool is_input_all_zeros =
+      !input_gates_precomputed &&
       tensor_utils::IsZeroVector(input_ptr, n_batch * n_input);
   const bool is_aux_input_all_zeros =
       (aux_input_ptr == nullptr ||
@@ -858,7 +886,7 @@ inline void LstmStepFloat(
         cell_to_input_weights_ptr, input_layer_norm_coefficients_ptr,
         input_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
         /*activation=*/kTfLiteActSigmoid, input_gate_scratch,
-        is_input_all_zeros, is_aux_input_all_zeros);
+        is_input_all_zeros, is_aux_input_all_zeros, input_gates_precomputed);
   }
   // Calculate the forget gate.
   CalculateLstmGateFloat(
@@ -868,7 +896,7 @@ inline void LstmStepFloat(
       cell_to_forget_weights_ptr, forget_layer_norm_coefficients_ptr,
       forget_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
       /*activation=*/kTfLiteActSigmoid, forget_gate_scratch, is_input_all_zeros,
-      is_aux_input_all_zeros);
+      is_aux_input_all_zeros, input_gates_precomputed);
   // Calculate the cell update gate.
   CalculateLstmGateFloat(input_ptr, input_to_cell_weights_ptr, aux_input_ptr,
                          aux_input_to_cell_weights_ptr, output_state_ptr,
@@ -877,7 +905,8 @@ inline void LstmStepFloat(
                          cell_layer_norm_coefficients_ptr, cell_gate_bias_ptr,
                          n_batch, n_input, n_aux_input, n_output, n_cell,
                          params->activation, cell_gate_scratch,
-                         is_input_all_zeros, is_aux_input_all_zeros);
+                         is_input_all_zeros, is_aux_input_all_zeros,
+                         input_gates_precomputed);
   // Update the cell state.
   UpdateLstmCellFloat(n_batch, n_cell, cell_state_ptr, input_gate_scratch,
                       forget_gate_scratch, cell_gate_scratch, use_cifg,
@@ -890,7 +919,7 @@ inline void LstmStepFloat(
       cell_to_output_weights_ptr, output_layer_norm_coefficients_ptr,
       output_gate_bias_ptr, n_batch, n_input, n_aux_input, n_output, n_cell,
       /*activation=*/kTfLiteActSigmoid, output_gate_scratch, is_input_all_zeros,
-      is_aux_input_all_zeros);
+      is_aux_input_all_zeros, input_gates_precomputed);
   // Update the output state.
   CalculateLstmOutputFloat(n_batch, n_cell, n_output, cell_state_ptr,
                            output_gate_scratch, params->activation,
@@ -1732,6 +1761,17 @@ TfLiteStatus EvalFloat(
   // check the existence of only one to the get the condition.
   const bool use_cifg = (input_to_input_weights == nullptr);
 
+  // If the scratch buffer has room for the gates of every time step, the input
+  // contribution of the gates is computed for the whole sequence upfront, so
+  // the input weights are streamed once instead of once per time step.
+  const int n_gates = use_cifg ? 3 : 4;
+  const bool input_gates_precomputed =
+      max_time > 1 &&
+      scratch_buffer->bytes >=
+          sizeof(float) * n_gates * max_time * n_batch * n_cell;
+  const int gate_scratch_size =
+      (input_gates_precomputed ? max_time : 1) * n_batch * n_cell;
+
   // Index the scratch buffers pointers to the global scratch buffer.
   float* scratch_buffer_ptr = GetTensorData<float>(scratch_buffer);
   float* input_gate_scratch = nullptr;
@@ -1740,13 +1780,42 @@ TfLiteStatus EvalFloat(
   float* output_gate_scratch = nullptr;
   if (use_cifg) {
     cell_gate_scratch = scratch_buffer_ptr;
-    forget_gate_scratch = scratch_buffer_ptr + n_cell * n_batch;
-    output_gate_scratch = scratch_buffer_ptr + 2 * n_cell * n_batch;
+    forget_gate_scratch = scratch_buffer_ptr + gate_scratch_size;
+    output_gate_scratch = scratch_buffer_ptr + 2 * gate_scratch_size;
   } else {
     input_gate_scratch = scratch_buffer_ptr;
-    cell_gate_scratch = scratch_buffer_ptr + n_cell * n_batch;
-    forget_gate_scratch = scratch_buffer_ptr + 2 * n_cell * n_batch;
-    output_gate_scratch = scratch_buffer_ptr + 3 * n_cell * n_batch;
+    cell_gate_scratch = scratch_buffer_ptr + gate_scratch_size;
+    forget_gate_scratch = scratch_buffer_ptr + 2 * gate_scratch_size;
+    output_gate_scratch = scratch_buffer_ptr + 3 * gate_scratch_size;
+  }
+
+  if (input_gates_precomputed) {
+    // The gate rows follow the order of the input vectors, i.e. row
+    // (t * n_batch + b) if time major and row (b * max_time + t) otherwise.
+    const float* input_ptr = GetTensorData<float>(input);
+    const int n_vectors = max_time * n_batch;
+    if (!use_cifg) {
+      PrecomputeLstmGateInputFloat(
+          input_ptr, GetTensorData<float>(input_to_input_weights),
+          GetTensorData<float>(input_layer_norm_coefficients),
+          GetTensorData<float>(input_gate_bias), n_vectors, n_input, n_cell,
+          input_gate_scratch);
+    }
+    PrecomputeLstmGateInputFloat(
+        input_ptr, GetTensorData<float>(input_to_forget_weights),
+        GetTensorData<float>(forget_layer_norm_coefficients),
+        GetTensorData<float>(forget_gate_bias), n_vectors, n_input, n_cell,
+        forget_gate_scratch);
+    PrecomputeLstmGateInputFloat(
+        input_ptr, GetTensorData<float>(input_to_cell_weights),
+        GetTensorData<float>(cell_layer_norm_coefficients),
+        GetTensorData<float>(cell_gate_bias), n_vectors, n_input, n_cell,
+        cell_gate_scratch);
+    PrecomputeLstmGateInputFloat(
+        input_ptr, GetTensorData<float>(input_to_output_weights),
+        GetTensorData<float>(output_layer_norm_coefficients),
+        GetTensorData<float>(output_gate_bias), n_vectors, n_input, n_cell,
+        output_gate_scratch);
   }
 
   const int output_batch_leading_dim =
@@ -1766,6 +1835,11 @@ TfLiteStatus EvalFloat(
       }
       float* output_ptr =
           GetTensorData<float>(output) + t_rel * output_step + output_offset;
+      // Offset the scratch pointers to the right time step.
+      const int scratch_offset =
+          input_gates_precomputed ? t_rel * n_batch * n_cell : 0;
+      float* input_gate_scratch_ptr =
+          input_gate_scratch ? input_gate_scratch + scratch_offset : nullptr;
 
       LstmStepFloat(
           input_ptr, GetTensorData<float>(input_to_input_weights),
@@ -1795,8 +1869,10 @@ TfLiteStatus EvalFloat(
           GetTensorData<float>(projection_bias), params, n_batch, n_cell,
           n_input, aux_input_size, n_output, output_batch_leading_dim,
           GetTensorData<float>(output_state), GetTensorData<float>(cell_state),
-          input_gate_scratch, forget_gate_scratch, cell_gate_scratch,
-          output_gate_scratch, output_ptr);
+          input_gate_scratch_ptr, forget_gate_scratch + scratch_offset,
+          cell_gate_scratch + scratch_offset,
+          output_gate_scratch + scratch_offset, output_ptr,
+          input_gates_precomputed);
     }
   } else {
     for (int b = 0; b < n_batch; b++) {
@@ -1821,12 +1897,14 @@ TfLiteStatus EvalFloat(
         float* output_state_ptr =
             GetTensorData<float>(output_state) + b * output_batch_leading_dim;
         float* cell_state_ptr = GetTensorData<float>(cell_state) + b * n_cell;
-        // Offset the scratch pointers to the right batch.
+        // Offset the scratch pointers to the right batch (and time step).
+        const int scratch_offset =
+            (input_gates_precomputed ? time_offset : b) * n_cell;
         float* input_gate_scratch_ptr =
-            input_gate_scratch ? input_gate_scratch + b * n_cell : nullptr;
-        float* forget_gate_scratch_ptr = forget_gate_scratch + b * n_cell;
-        float* cell_gate_scratch_ptr = cell_gate_scratch + b * n_cell;
-        float* output_gate_scratch_ptr = output_gate_scratch + b * n_cell;
+            input_gate_scratch ? input_gate_scratch + scratch_offset : nullptr;
+        float* forget_gate_scratch_ptr = forget_gate_scratch + scratch_offset;
+        float* cell_gate_scratch_ptr = cell_gate_scratch + scratch_offset;
+        float* output_gate_scratch_ptr = output_gate_scratch + scratch_offset;
 
         LstmStepFloat(
             input_ptr, GetTensorData<float>(input_to_input_weights),
@@ -1857,7 +1935,7 @@ TfLiteStatus EvalFloat(
             n_cell, n_input, aux_input_size, n_output, output_batch_leading_dim,
             output_state_ptr, cell_state_ptr, input_gate_scratch_ptr,
             forget_gate_scratch_ptr, cell_gate_scratch_ptr,
-            output_gate_scratch_ptr, output_ptr);
+            output_gate_scratch_ptr, output_ptr, input_gates_precomputed);
       }
     }
   }
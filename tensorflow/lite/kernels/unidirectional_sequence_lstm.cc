@@ -882,6 +882,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       reinterpret_cast<TfLiteUnidirectionalSequenceLSTMParams*>(
           node->builtin_data);
   const bool time_major = params->time_major;
+  const int max_time = time_major ? input->dims->data[0] : input->dims->data[1];
   const int n_batch = time_major ? input->dims->data[1] : input->dims->data[0];
   const int n_input = input->dims->data[2];
 
@@ -960,7 +961,14 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       context, node, lstm::full::kInputToInputWeightsTensor);
   const bool use_cifg = (input_to_input_weights == nullptr);
   TfLiteIntArray* scratch_buffer_size = TfLiteIntArrayCreate(2);
-  scratch_buffer_size->data[0] = n_batch;
+  if (input->type == kTfLiteFloat32 &&
+      input_to_output_weights->type == kTfLiteFloat32) {
+    // Reserve the gates of every time step, so the float kernel can compute
+    // the input contribution of the gates for the whole sequence at once.
+    scratch_buffer_size->data[0] = n_batch * max_time;
+  } else {
+    scratch_buffer_size->data[0] = n_batch;
+  }
   if (use_cifg) {
     // Reserving space for Cell, Forget, Output gates
     scratch_buffer_size->data[1] = n_cell * 3;
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MEMORY_PLANNER_H_
 #define TENSORFLOW_LITE_MEMORY_PLANNER_H_
 
+#include <vector>
+
 #include "tensorflow/lite/c/common.h"
 
 namespace tflite {
@@ -30,6 +32,17 @@ class MemoryPlanner {
   // actual size of the tensors is not.
   virtual TfLiteStatus PlanAllocations() = 0;
 
+  // Plans the allocations again for nodes that are executed in groups rather
+  // than one at a time: nodes of the same group may execute in any order, or
+  // concurrently, so tensors used by any of them, or live across the group,
+  // must not share memory. `node_groups` holds the group of every execution
+  // node. Groups are executed in increasing order, which must agree with the
+  // order of all dependencies between nodes. Once groups are set, all nodes
+  // must be allocated by a single ExecuteAllocations() call. An empty
+  // `node_groups` goes back to executing nodes one at a time.
+  virtual TfLiteStatus SetConcurrentNodeGroups(
+      const std::vector<int>& node_groups) = 0;
+
   // Allocates the necessary memory to execute all nodes in the interval
   // [first_node, last_node].
   virtual TfLiteStatus ExecuteAllocations(int first_node, int last_node) = 0;
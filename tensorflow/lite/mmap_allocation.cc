@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <fcntl.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -72,6 +73,57 @@ size_t MMAPAllocation::bytes() const { return buffer_size_bytes_; }
 
 bool MMAPAllocation::valid() const { return mmapped_buffer_ != MAP_FAILED; }
 
+namespace {
+
+// Clamps [ptr, ptr + bytes) to [base, base + size), and widens it to whole
+// pages if `round_out`, or narrows it to the whole pages it contains
+// otherwise. Returns false if the resulting range is empty.
+bool GetPageRange(const void* base, size_t size, const void* ptr, size_t bytes,
+                  bool round_out, uintptr_t* begin, uintptr_t* end) {
+  static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t map_begin = reinterpret_cast<uintptr_t>(base);
+  const uintptr_t map_end = map_begin + size;
+  uintptr_t range_begin = reinterpret_cast<uintptr_t>(ptr);
+  uintptr_t range_end = range_begin + bytes;
+  if (range_begin < map_begin) range_begin = map_begin;
+  if (range_end > map_end) range_end = map_end;
+  if (round_out) {
+    range_begin &= ~(page_size - 1);
+    range_end = (range_end + page_size - 1) & ~(page_size - 1);
+  } else {
+    range_begin = (range_begin + page_size - 1) & ~(page_size - 1);
+    range_end &= ~(page_size - 1);
+  }
+  if (range_begin >= range_end) return false;
+  *begin = range_begin;
+  *end = range_end;
+  return true;
+}
+
+}  // namespace
+
+bool MMAPAllocation::Prefetch(const void* ptr, size_t bytes) const {
+  uintptr_t begin, end;
+  if (!valid() || !GetPageRange(mmapped_buffer_, buffer_size_bytes_, ptr,
+                                bytes, /*round_out=*/true, &begin, &end)) {
+    return false;
+  }
+  return madvise(reinterpret_cast<void*>(begin), end - begin,
+                 MADV_WILLNEED) == 0;
+}
+
+bool MMAPAllocation::Release(const void* ptr, size_t bytes) const {
+  uintptr_t begin, end;
+  if (!valid() || !GetPageRange(mmapped_buffer_, buffer_size_bytes_, ptr,
+                                bytes, /*round_out=*/false, &begin, &end)) {
+    return false;
+  }
+  // The mapping is shared and read-only, so dropped pages are reloaded from
+  // the file rather than zero-filled.
+  return madvise(reinterpret_cast<void*>(begin), end - begin,
+                 MADV_DONTNEED) == 0;
+}
+
 bool MMAPAllocation::IsSupported() { return true; }
 
 }  // namespace tflite
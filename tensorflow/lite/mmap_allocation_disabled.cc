@@ -41,6 +41,14 @@ size_t MMAPAllocation::bytes() const { return 0; }
 
 bool MMAPAllocation::valid() const { return false; }
 
+bool MMAPAllocation::Prefetch(const void* ptr, size_t bytes) const {
+  return false;
+}
+
+bool MMAPAllocation::Release(const void* ptr, size_t bytes) const {
+  return false;
+}
+
 bool MMAPAllocation::IsSupported() { return false; }
 
 }  // namespace tflite
@@ -335,6 +335,39 @@ TEST(BasicFlatBufferModel, TestSetNumThreads) {
                       reporter.error_messages());
 }
 
+TEST(BasicFlatBufferModel, TestWeightPaging) {
+  TestErrorReporter reporter;
+  auto model = FlatBufferModel::BuildFromFile(
+      "tensorflow/lite/testdata/test_model.bin", &reporter);
+  ASSERT_TRUE(model);
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(
+      InterpreterBuilder(*model, TrivialResolver(&dummy_reg))(&interpreter),
+      kTfLiteOk);
+  ASSERT_NE(interpreter, nullptr);
+
+  ASSERT_EQ(interpreter->SetWeightPagingWindow(-1), kTfLiteError);
+  ASSERT_EQ(interpreter->SetWeightPagingWindow(1), kTfLiteOk);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+  // Tensor 0 is a weight read by the first node, which is paged out after
+  // each run and must still read back the same.
+  const TfLiteTensor* weight = interpreter->tensor(0);
+  ASSERT_EQ(weight->allocation_type, kTfLiteMmapRo);
+  const std::vector<char> expected(weight->data.raw,
+                                   weight->data.raw + weight->bytes);
+  for (int run = 0; run < 3; ++run) {
+    ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+    EXPECT_EQ(std::vector<char>(weight->data.raw,
+                                weight->data.raw + weight->bytes),
+              expected);
+  }
+
+  ASSERT_EQ(interpreter->SetWeightPagingWindow(0), kTfLiteOk);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
 // Test that loading a model with TensorFlow ops fails when the flex delegate is
 // not linked into the target.
 TEST(FlexModel, FailureWithoutFlexDelegate) {
@@ -82,13 +82,36 @@ TfLiteStatus SimpleMemoryArena::Allocate(
   // Update the required buffer size.
   high_water_mark_ = std::max(high_water_mark_, best_offset + size);
   new_alloc->offset = best_offset;
+  InsertAlloc(*new_alloc);
+  return kTfLiteOk;
+}
 
+TfLiteStatus SimpleMemoryArena::AllocateAt(
+    TfLiteContext* context, size_t alignment, size_t offset, size_t size,
+    int32_t tensor, int32_t first_node, int32_t last_node,
+    ArenaAllocWithUsageInterval* new_alloc) {
+  TF_LITE_ENSURE(context, alignment <= arena_alignment_);
+  TF_LITE_ENSURE(context, AlignTo(alignment, offset) == offset);
+  new_alloc->tensor = tensor;
+  new_alloc->first_node = first_node;
+  new_alloc->last_node = last_node;
+  new_alloc->size = size;
+  if (size == 0) {
+    new_alloc->offset = 0;
+    return kTfLiteOk;
+  }
+  high_water_mark_ = std::max(high_water_mark_, offset + size);
+  new_alloc->offset = offset;
+  InsertAlloc(*new_alloc);
+  return kTfLiteOk;
+}
+
+void SimpleMemoryArena::InsertAlloc(const ArenaAllocWithUsageInterval& alloc) {
   auto insertion_it = ordered_allocs_.begin();
-  while (insertion_it != ordered_allocs_.end() && *insertion_it < *new_alloc) {
+  while (insertion_it != ordered_allocs_.end() && *insertion_it < alloc) {
     ++insertion_it;
   }
-  ordered_allocs_.insert(insertion_it, *new_alloc);
-  return kTfLiteOk;
+  ordered_allocs_.insert(insertion_it, alloc);
 }
 
 TfLiteStatus SimpleMemoryArena::Deallocate(
@@ -160,6 +183,12 @@ TfLiteStatus SimpleMemoryArena::ClearPlan() {
   return kTfLiteOk;
 }
 
+void SimpleMemoryArena::RestorePlan(const Plan& plan) {
+  committed_ = false;
+  high_water_mark_ = plan.high_water_mark;
+  ordered_allocs_ = plan.ordered_allocs;
+}
+
 TfLiteStatus SimpleMemoryArena::ReleaseBuffer() {
   committed_ = false;
   underlying_buffer_size_ = 0;
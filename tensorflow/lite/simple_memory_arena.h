@@ -75,6 +75,14 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Like Allocate(), but schedules the allocation at a given offset instead of
+  // the best fitting gap. The caller must make sure that it doesn't overlap any
+  // allocation whose usage interval intersects [first_node, last_node].
+  TfLiteStatus AllocateAt(TfLiteContext* context, size_t alignment,
+                          size_t offset, size_t size, int32_t tensor,
+                          int32_t first_node, int32_t last_node,
+                          ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context,
                           const ArenaAllocWithUsageInterval& alloc);
 
@@ -87,6 +95,21 @@ class SimpleMemoryArena {
 
   TfLiteStatus Commit(TfLiteContext* context);
 
+  // The allocations scheduled since the last ClearPlan(). A plan can be saved
+  // and restored later instead of repeating the same Allocate() calls.
+  struct Plan {
+    size_t high_water_mark = 0;
+    std::vector<ArenaAllocWithUsageInterval> ordered_allocs;
+  };
+
+  Plan GetPlan() const { return {high_water_mark_, ordered_allocs_}; }
+
+  // Replaces the allocations scheduled so far with 'plan'. Like ClearPlan(),
+  // this requires the arena to be committed & resolved again.
+  void RestorePlan(const Plan& plan);
+
+  bool HasAllocations() const { return !ordered_allocs_.empty(); }
+
   TfLiteStatus ResolveAlloc(TfLiteContext* context,
                             const ArenaAllocWithUsageInterval& alloc,
                             char** output_ptr);
@@ -108,6 +131,9 @@ class SimpleMemoryArena {
   }
 
  private:
+  // Records 'alloc' in ordered_allocs_, keeping it sorted by offset.
+  void InsertAlloc(const ArenaAllocWithUsageInterval& alloc);
+
   bool committed_;
   size_t arena_alignment_;
   size_t high_water_mark_;
@@ -373,6 +373,43 @@ TEST(BenchmarkTest, RunWithUseCaching) {
   EXPECT_EQ(kTfLiteOk, status);
 }
 
+TEST(BenchmarkTest, RunThroughputWithMultipleInterpreters) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = CreateFp32Params();
+  params.Set<int32_t>("num_interpreters", 3);
+  params.Set<float>("throughput_secs", 0.1f);
+  TestBenchmark benchmark(std::move(params));
+  EXPECT_EQ(kTfLiteOk, benchmark.Run());
+
+  const auto& results = benchmark.throughput_results();
+  EXPECT_EQ(3, results.num_interpreters);
+  EXPECT_GE(results.num_inferences, 3);
+  EXPECT_EQ(results.num_inferences, results.latency_us.count());
+  EXPECT_GT(results.inferences_per_second(), 0);
+  EXPECT_LE(results.latency_p50_us, results.latency_p90_us);
+  EXPECT_LE(results.latency_p90_us, results.latency_p99_us);
+  EXPECT_LE(results.latency_p99_us, results.latency_us.max());
+}
+
+TEST(BenchmarkTest, RunThroughputWithSharedCpuBackendContext) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  TestBenchmark benchmark(CreateFp32Params());
+  ScopedCommandlineArgs scoped_argv({"--num_interpreters=2",
+                                     "--throughput_secs=0.1",
+                                     "--share_cpu_backend_context=true"});
+  EXPECT_EQ(kTfLiteOk, benchmark.Run(scoped_argv.argc(), scoped_argv.argv()));
+  EXPECT_EQ(2, benchmark.throughput_results().num_interpreters);
+  EXPECT_GE(benchmark.throughput_results().num_inferences, 2);
+}
+
+TEST(BenchmarkTest, RunWithInvalidNumInterpreters) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  TestBenchmark benchmark(CreateFp32Params());
+  ScopedCommandlineArgs scoped_argv({"--num_interpreters=0"});
+  EXPECT_EQ(kTfLiteError,
+            benchmark.Run(scoped_argv.argc(), scoped_argv.argv()));
+}
+
 class MaxDurationWorksTestListener : public BenchmarkListener {
   void OnBenchmarkEnd(const BenchmarkResults& results) override {
     const int64_t num_actual_runs = results.inference_time_us().count();
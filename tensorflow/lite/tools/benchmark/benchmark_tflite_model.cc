@@ -15,14 +15,18 @@ limitations under the License.
 
 #include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <random>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <unordered_set>
 #include <vector>
 
@@ -35,7 +39,9 @@ limitations under the License.
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/optional_debug_tools.h"
+#include "tensorflow/lite/profiling/memory_info.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
+#include "tensorflow/lite/profiling/time.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
@@ -263,6 +269,17 @@ CreateProfileSummaryFormatter(bool format_as_csv) {
              : std::make_shared<profiling::ProfileSummaryDefaultFormatter>();
 }
 
+// Returns the 'percentile'-th value of the ascending 'sorted_values'.
+int64_t Percentile(const std::vector<int64_t>& sorted_values,
+                   double percentile) {
+  if (sorted_values.empty()) return 0;
+  const size_t index = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * sorted_values.size()));
+  return sorted_values[std::min(std::max<size_t>(index, 1),
+                                sorted_values.size()) -
+                       1];
+}
+
 }  // namespace
 
 BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
@@ -292,6 +309,13 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
   default_params.AddParam("print_postinvoke_state",
                           BenchmarkParam::Create<bool>(false));
 
+  default_params.AddParam("num_interpreters",
+                          BenchmarkParam::Create<int32_t>(1));
+  default_params.AddParam("throughput_secs",
+                          BenchmarkParam::Create<float>(10.0f));
+  default_params.AddParam("share_cpu_backend_context",
+                          BenchmarkParam::Create<bool>(false));
+
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
     default_params.Merge(delegate_provider->DefaultParams());
@@ -360,7 +384,21 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "print_postinvoke_state", &params_,
           "print out the interpreter internals just before benchmark completes "
           "(i.e. after all repeated Invoke calls complete). The internals will "
-          "include allocated memory size of each tensor etc.")};
+          "include allocated memory size of each tensor etc."),
+      CreateFlag<int32_t>(
+          "num_interpreters", &params_,
+          "If greater than 1, after the regular benchmark, create this many "
+          "interpreters and invoke them concurrently from as many threads to "
+          "measure aggregate throughput."),
+      CreateFlag<float>("throughput_secs", &params_,
+                        "duration of the multi-interpreter throughput run in "
+                        "seconds, see also num_interpreters"),
+      CreateFlag<bool>(
+          "share_cpu_backend_context", &params_,
+          "Whether the interpreters of the throughput run share one CPU "
+          "backend context (and thus one thread pool of num_threads threads). "
+          "A shared context doesn't support concurrent invocations, so the "
+          "interpreters then take turns running on it.")};
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
 
@@ -399,6 +437,12 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
                       "Print post-invoke interpreter state", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_interpreters", "Num interpreters",
+                      verbose);
+  LOG_BENCHMARK_PARAM(float, "throughput_secs",
+                      "Throughput run duration (seconds)", verbose);
+  LOG_BENCHMARK_PARAM(bool, "share_cpu_backend_context",
+                      "Share CPU backend context", verbose);
 
   for (const auto& delegate_provider :
        tools::GetRegisteredDelegateProviders()) {
@@ -412,6 +456,10 @@ TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
         << "Please specify the name of your TF Lite input file with --graph";
     return kTfLiteError;
   }
+  if (params_.Get<int32_t>("num_interpreters") < 1) {
+    TFLITE_LOG(ERROR) << "--num_interpreters must be at least 1";
+    return kTfLiteError;
+  }
 
   return PopulateInputLayerInfo(
       params_.Get<std::string>("input_layer"),
@@ -609,11 +657,16 @@ TfLiteStatus BenchmarkTfLiteModel::PrepareInputData() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
-  auto interpreter_inputs = interpreter_->inputs();
+  CopyInputsData(interpreter_.get());
+  return kTfLiteOk;
+}
+
+void BenchmarkTfLiteModel::CopyInputsData(Interpreter* interpreter) {
+  auto interpreter_inputs = interpreter->inputs();
   // Set the values of the input tensors from inputs_data_.
   for (int j = 0; j < interpreter_inputs.size(); ++j) {
     int i = interpreter_inputs[j];
-    TfLiteTensor* t = interpreter_->tensor(i);
+    TfLiteTensor* t = interpreter->tensor(i);
     if (t->type == kTfLiteString) {
       if (inputs_data_[j].data) {
         static_cast<DynamicBuffer*>(inputs_data_[j].data.get())
@@ -631,8 +684,6 @@ TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
                   inputs_data_[j].bytes);
     }
   }
-
-  return kTfLiteOk;
 }
 
 TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
@@ -817,5 +868,175 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
 
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
 
+TfLiteStatus BenchmarkTfLiteModel::Run() {
+  TF_LITE_ENSURE_STATUS(BenchmarkModel::Run());
+  if (params_.Get<int32_t>("num_interpreters") <= 1 ||
+      params_.Get<bool>("dry_run")) {
+    return kTfLiteOk;
+  }
+  return RunThroughputBenchmark();
+}
+
+TfLiteStatus BenchmarkTfLiteModel::CreateThroughputInterpreter(
+    TfLiteExternalContext* shared_context,
+    std::vector<Interpreter::TfLiteDelegatePtr>* delegates,
+    std::unique_ptr<Interpreter>* interpreter) {
+  auto resolver = GetOpResolver();
+  tflite::InterpreterBuilder(*model_, *resolver)(
+      interpreter, params_.Get<int32_t>("num_threads"));
+  if (!*interpreter) {
+    TFLITE_LOG(ERROR) << "Failed to initialize the interpreter";
+    return kTfLiteError;
+  }
+  if (shared_context != nullptr) {
+    (*interpreter)->SetExternalContext(kTfLiteCpuBackendContext,
+                                       shared_context);
+  }
+  (*interpreter)
+      ->SetAllowFp16PrecisionForFp32(params_.Get<bool>("allow_fp16"));
+
+  for (const auto& delegate_provider :
+       tools::GetRegisteredDelegateProviders()) {
+    auto delegate = delegate_provider->CreateTfLiteDelegate(params_);
+    if (delegate == nullptr) continue;
+    if ((*interpreter)->ModifyGraphWithDelegate(delegate.get()) !=
+        kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to apply " << delegate_provider->GetName()
+                        << " delegate.";
+      return kTfLiteError;
+    }
+    delegates->emplace_back(std::move(delegate));
+  }
+
+  auto interpreter_inputs = (*interpreter)->inputs();
+  for (int j = 0; j < inputs_.size(); ++j) {
+    int i = interpreter_inputs[j];
+    if ((*interpreter)->tensor(i)->type != kTfLiteString) {
+      (*interpreter)->ResizeInputTensor(i, inputs_[j].shape);
+    }
+  }
+  if ((*interpreter)->AllocateTensors() != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to allocate tensors!";
+    return kTfLiteError;
+  }
+  CopyInputsData(interpreter->get());
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkTfLiteModel::RunThroughputBenchmark() {
+  const int num_interpreters = params_.Get<int32_t>("num_interpreters");
+  const bool share_context = params_.Get<bool>("share_cpu_backend_context");
+  TFLITE_LOG(INFO) << "Running throughput benchmark with " << num_interpreters
+                   << " interpreters for "
+                   << params_.Get<float>("throughput_secs") << " seconds"
+                   << (share_context ? " sharing one CPU backend context."
+                                     : ".");
+
+  // Declared ahead of the interpreters so that they're destroyed last.
+  std::unique_ptr<tflite::ExternalCpuBackendContext> shared_context;
+  std::vector<Interpreter::TfLiteDelegatePtr> delegates;
+  std::vector<std::unique_ptr<Interpreter>> interpreters(num_interpreters);
+  if (share_context) {
+    shared_context.reset(new tflite::ExternalCpuBackendContext());
+    std::unique_ptr<tflite::CpuBackendContext> cpu_backend_context(
+        new tflite::CpuBackendContext());
+    cpu_backend_context->SetUseCaching(params_.Get<bool>("use_caching"));
+    cpu_backend_context->SetMaxNumThreads(params_.Get<int32_t>("num_threads"));
+    shared_context->set_internal_backend_context(
+        std::move(cpu_backend_context));
+  }
+
+  const auto start_mem_usage = profiling::memory::GetMemoryUsage();
+  for (auto& interpreter : interpreters) {
+    TF_LITE_ENSURE_STATUS(CreateThroughputInterpreter(
+        shared_context.get(), &delegates, &interpreter));
+  }
+  const auto mem_usage =
+      profiling::memory::GetMemoryUsage() - start_mem_usage;
+
+  // Run every interpreter once so that lazy initialization in the first
+  // invocation isn't counted.
+  for (auto& interpreter : interpreters) {
+    if (interpreter->Invoke() != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to invoke the interpreter";
+      return kTfLiteError;
+    }
+  }
+
+  // A shared CPU backend context can't be used by concurrent invocations.
+  std::mutex shared_context_mu;
+  std::vector<std::vector<int64_t>> latencies_us(num_interpreters);
+  std::vector<TfLiteStatus> statuses(num_interpreters, kTfLiteOk);
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t finish_us =
+      start_us +
+      static_cast<int64_t>(params_.Get<float>("throughput_secs") * 1.e6f);
+  std::vector<std::thread> threads;
+  threads.reserve(num_interpreters);
+  for (int i = 0; i < num_interpreters; ++i) {
+    threads.emplace_back([&, i]() {
+      Interpreter* interpreter = interpreters[i].get();
+      do {
+        std::unique_lock<std::mutex> lock(shared_context_mu, std::defer_lock);
+        if (share_context) lock.lock();
+        const int64_t invoke_start_us = profiling::time::NowMicros();
+        statuses[i] = interpreter->Invoke();
+        latencies_us[i].push_back(profiling::time::NowMicros() -
+                                  invoke_start_us);
+      } while (statuses[i] == kTfLiteOk &&
+               profiling::time::NowMicros() < finish_us);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  const int64_t end_us = profiling::time::NowMicros();
+
+  for (TfLiteStatus status : statuses) {
+    if (status != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to invoke the interpreter";
+      return status;
+    }
+  }
+
+  ThroughputResults results;
+  results.num_interpreters = num_interpreters;
+  results.duration_secs = (end_us - start_us) / 1e6;
+  std::vector<int64_t> all_latencies_us;
+  for (const auto& thread_latencies_us : latencies_us) {
+    all_latencies_us.insert(all_latencies_us.end(),
+                            thread_latencies_us.begin(),
+                            thread_latencies_us.end());
+  }
+  for (int64_t latency_us : all_latencies_us) {
+    results.latency_us.UpdateStat(latency_us);
+  }
+  std::sort(all_latencies_us.begin(), all_latencies_us.end());
+  results.num_inferences = all_latencies_us.size();
+  results.latency_p50_us = Percentile(all_latencies_us, 50);
+  results.latency_p90_us = Percentile(all_latencies_us, 90);
+  results.latency_p99_us = Percentile(all_latencies_us, 99);
+  if (profiling::memory::MemoryUsage::IsSupported()) {
+    results.memory_bytes_per_interpreter =
+        static_cast<int64_t>(mem_usage.in_use_allocated_bytes) /
+        num_interpreters;
+  }
+  throughput_results_ = results;
+
+  TFLITE_LOG(INFO) << "Throughput: " << results.inferences_per_second()
+                   << " inferences/s over " << results.num_inferences
+                   << " inferences with " << num_interpreters
+                   << " interpreters";
+  TFLITE_LOG(INFO) << "Inference latency in us: "
+                   << "p50: " << results.latency_p50_us << ", "
+                   << "p90: " << results.latency_p90_us << ", "
+                   << "p99: " << results.latency_p99_us << ", "
+                   << "max: " << results.latency_us.max() << ", "
+                   << "avg: " << results.latency_us.avg();
+  if (results.memory_bytes_per_interpreter >= 0) {
+    TFLITE_LOG(INFO) << "Memory footprint per interpreter (MB): "
+                     << results.memory_bytes_per_interpreter / 1e6;
+  }
+  return kTfLiteOk;
+}
+
 }  // namespace benchmark
 }  // namespace tflite
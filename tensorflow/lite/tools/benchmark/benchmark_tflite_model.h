@@ -52,9 +52,35 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
     std::string input_file_path;
   };
 
+  // Results of the multi-interpreter throughput run that follows the regular
+  // benchmark when --num_interpreters is greater than 1.
+  struct ThroughputResults {
+    int num_interpreters = 0;
+    int64_t num_inferences = 0;
+    double duration_secs = 0.0;
+    tensorflow::Stat<int64_t> latency_us;
+    int64_t latency_p50_us = 0;
+    int64_t latency_p90_us = 0;
+    int64_t latency_p99_us = 0;
+    // Heap bytes held by each interpreter after tensor allocation, or -1 if
+    // memory usage can't be obtained on this platform.
+    int64_t memory_bytes_per_interpreter = -1;
+
+    double inferences_per_second() const {
+      return duration_secs > 0 ? num_inferences / duration_secs : 0.0;
+    }
+  };
+
   explicit BenchmarkTfLiteModel(BenchmarkParams params = DefaultParams());
   ~BenchmarkTfLiteModel() override;
 
+  using BenchmarkModel::Run;
+  TfLiteStatus Run() override;
+
+  const ThroughputResults& throughput_results() const {
+    return throughput_results_;
+  }
+
   std::vector<Flag> GetFlags() override;
   void LogParams() override;
   TfLiteStatus ValidateParams() override;
@@ -81,6 +107,10 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   // necessary.
   virtual std::unique_ptr<BenchmarkListener> MayCreateProfilingListener() const;
 
+  // Creates --num_interpreters interpreters and drives each from its own
+  // thread for --throughput_secs, recording aggregate throughput.
+  virtual TfLiteStatus RunThroughputBenchmark();
+
   void CleanUp();
 
   std::unique_ptr<tflite::FlatBufferModel> model_;
@@ -118,6 +148,17 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   InputTensorData LoadInputTensorData(const TfLiteTensor& t,
                                       const std::string& input_file_path);
 
+  // Copies the prepared input data into the input tensors of 'interpreter'.
+  void CopyInputsData(Interpreter* interpreter);
+
+  // Builds an interpreter for the throughput run with the same delegates,
+  // input shapes and precision settings as 'interpreter_'. Delegates created
+  // for it are appended to 'delegates', which must outlive the interpreter.
+  TfLiteStatus CreateThroughputInterpreter(
+      TfLiteExternalContext* shared_context,
+      std::vector<Interpreter::TfLiteDelegatePtr>* delegates,
+      std::unique_ptr<Interpreter>* interpreter);
+
   std::vector<InputLayerInfo> inputs_;
   std::vector<InputTensorData> inputs_data_;
   std::unique_ptr<BenchmarkListener> profiling_listener_ = nullptr;
@@ -125,6 +166,7 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   std::unique_ptr<BenchmarkListener> interpreter_state_printer_ = nullptr;
   std::mt19937 random_engine_;
   std::vector<Interpreter::TfLiteDelegatePtr> owned_delegates_;
+  ThroughputResults throughput_results_;
   // Always TFLITE_LOG the benchmark result.
   BenchmarkLoggingListener log_output_;
 };
@@ -45,6 +45,10 @@ class GpuDelegateProvider : public DelegateProvider {
     default_params_.AddParam("gpu_inference_for_sustained_speed",
                              ToolParam::Create<bool>(false));
     default_params_.AddParam("gpu_backend", ToolParam::Create<std::string>(""));
+    default_params_.AddParam("gpu_serialization_dir",
+                             ToolParam::Create<std::string>(""));
+    default_params_.AddParam("gpu_model_token",
+                             ToolParam::Create<std::string>(""));
 #endif
 #if defined(REAL_IPHONE_DEVICE)
     default_params_.AddParam("gpu_wait_type",
@@ -83,6 +87,14 @@ std::vector<Flag> GpuDelegateProvider::CreateFlags(ToolParams* params) const {
         "gpu_backend", params,
         "Force the GPU delegate to use a particular backend for execution, and "
         "fail if unsuccessful. Should be one of: cl, gl"),
+    CreateFlag<std::string>(
+        "gpu_serialization_dir", params,
+        "Directory to store the serialized OpenCL programs and inference "
+        "context in, to speed up later initializations. Requires "
+        "--gpu_model_token."),
+    CreateFlag<std::string>(
+        "gpu_model_token", params,
+        "Token identifying the model in --gpu_serialization_dir."),
 #endif
 #if defined(REAL_IPHONE_DEVICE)
     CreateFlag<std::string>(
@@ -107,6 +119,10 @@ void GpuDelegateProvider::LogParams(const ToolParams& params,
   LOG_TOOL_PARAM(params, bool, "gpu_inference_for_sustained_speed",
                  "Prefer maximizing the throughput in gpu", verbose);
   LOG_TOOL_PARAM(params, std::string, "gpu_backend", "GPU backend", verbose);
+  LOG_TOOL_PARAM(params, std::string, "gpu_serialization_dir",
+                 "GPU serialization directory", verbose);
+  LOG_TOOL_PARAM(params, std::string, "gpu_model_token", "GPU model token",
+                 verbose);
 #endif
 #if defined(REAL_IPHONE_DEVICE)
   LOG_TOOL_PARAM(params, std::string, "gpu_wait_type", "GPU delegate wait type",
@@ -143,6 +159,16 @@ TfLiteDelegatePtr GpuDelegateProvider::CreateTfLiteDelegate(
         gpu_opts.experimental_flags |= TFLITE_GPU_EXPERIMENTAL_FLAGS_GL_ONLY;
       }
     }
+    // The delegate copies the strings, they only need to outlive its creation.
+    const std::string serialization_dir =
+        params.Get<std::string>("gpu_serialization_dir");
+    const std::string model_token = params.Get<std::string>("gpu_model_token");
+    if (!serialization_dir.empty() && !model_token.empty()) {
+      gpu_opts.experimental_flags |=
+          TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION;
+      gpu_opts.serialization_dir = serialization_dir.c_str();
+      gpu_opts.model_token = model_token.c_str();
+    }
     gpu_opts.max_delegated_partitions =
         params.Get<int>("max_delegated_partitions");
     delegate = evaluation::CreateGPUDelegate(&gpu_opts);
@@ -0,0 +1,310 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/offline_memory_planner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/optimize/model_utils.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace optimize {
+
+namespace {
+
+constexpr int32_t kOfflineMemoryAllocationVersion = 1;
+constexpr int32_t kNotPlanned = -1;
+
+// A tensor to place in the arena, used from before first_node runs until
+// after last_node runs.
+struct TensorInterval {
+  int tensor;
+  size_t size;
+  int first_node;
+  int last_node;
+};
+
+size_t AlignTo(size_t offset) {
+  return (offset + kDefaultTensorAlignment - 1) / kDefaultTensorAlignment *
+         kDefaultTensorAlignment;
+}
+
+bool Overlap(const TensorInterval& a, const TensorInterval& b) {
+  return a.first_node <= b.last_node && b.first_node <= a.last_node;
+}
+
+// Returns the size in bytes of `tensor` when allocated in the arena, or 0 if
+// it isn't or its size isn't known before running the model.
+size_t GetArenaBytes(const ModelT& model, const TensorT& tensor,
+                     ErrorReporter* error_reporter) {
+  if (tensor.is_variable) return 0;
+  if (tensor.buffer < model.buffers.size() &&
+      !model.buffers[tensor.buffer]->data.empty()) {
+    return 0;
+  }
+  for (int32_t dim : tensor.shape_signature) {
+    if (dim < 0) return 0;
+  }
+  TfLiteType type;
+  size_t bytes;
+  if (ConvertTensorType(tensor.type, &type, error_reporter) != kTfLiteOk ||
+      GetSizeOfType(nullptr, type, &bytes) != kTfLiteOk) {
+    return 0;
+  }
+  for (int32_t dim : tensor.shape) {
+    if (dim < 0) return 0;
+    bytes *= dim;
+  }
+  return bytes;
+}
+
+// Computes the arena tensors of `subgraph` and their lifetimes the same way
+// ArenaPlanner::PlanAllocations() does.
+std::vector<TensorInterval> GetTensorIntervals(const ModelT& model,
+                                               const SubGraphT& subgraph,
+                                               ErrorReporter* error_reporter) {
+  const int num_tensors = subgraph.tensors.size();
+  const int num_nodes = subgraph.operators.size();
+  // Tensors never deallocated stay live until after the last node.
+  std::vector<int> first_node(num_tensors, -1);
+  std::vector<int> last_node(num_tensors, num_nodes);
+  std::vector<int> refcounts(num_tensors, 0);
+
+  for (int tensor : subgraph.outputs) {
+    if (tensor != kTfLiteOptionalTensor) refcounts[tensor]++;
+  }
+  for (int tensor : subgraph.inputs) {
+    if (tensor == kTfLiteOptionalTensor) continue;
+    refcounts[tensor]++;
+    first_node[tensor] = 0;
+  }
+  for (const auto& op : subgraph.operators) {
+    for (int tensor : op->inputs) {
+      if (tensor != kTfLiteOptionalTensor) refcounts[tensor]++;
+    }
+  }
+  for (int node = 0; node < num_nodes; ++node) {
+    const OperatorT& op = *subgraph.operators[node];
+    for (int tensor : op.outputs) {
+      if (tensor != kTfLiteOptionalTensor && first_node[tensor] < 0) {
+        first_node[tensor] = node;
+      }
+    }
+    for (int tensor : op.inputs) {
+      if (tensor == kTfLiteOptionalTensor) continue;
+      if (--refcounts[tensor] == 0 && first_node[tensor] >= 0) {
+        last_node[tensor] = node;
+      }
+    }
+  }
+
+  std::vector<TensorInterval> intervals;
+  for (int tensor = 0; tensor < num_tensors; ++tensor) {
+    if (first_node[tensor] < 0) continue;
+    const size_t size =
+        GetArenaBytes(model, *subgraph.tensors[tensor], error_reporter);
+    if (size == 0) continue;
+    intervals.push_back(
+        {tensor, size, first_node[tensor], last_node[tensor]});
+  }
+  return intervals;
+}
+
+// Places `intervals` in the given order, each one into the smallest gap left
+// by the already placed tensors it overlaps with, or after all of them.
+// Returns the arena size.
+size_t PlaceBestFit(const std::vector<TensorInterval>& intervals,
+                    const std::vector<int>& order,
+                    std::vector<size_t>* offsets) {
+  offsets->assign(intervals.size(), 0);
+  std::vector<int> placed;
+  placed.reserve(intervals.size());
+  size_t arena_size = 0;
+  for (int i : order) {
+    const TensorInterval& interval = intervals[i];
+    std::vector<int> neighbors;
+    for (int j : placed) {
+      if (Overlap(interval, intervals[j])) neighbors.push_back(j);
+    }
+    std::sort(neighbors.begin(), neighbors.end(), [offsets](int a, int b) {
+      return (*offsets)[a] < (*offsets)[b];
+    });
+
+    const size_t kNoOffset = std::numeric_limits<size_t>::max();
+    size_t best_offset = kNoOffset;
+    size_t best_fit = kNoOffset;
+    size_t current_offset = 0;
+    for (int j : neighbors) {
+      const size_t aligned_offset = AlignTo(current_offset);
+      const size_t neighbor_offset = (*offsets)[j];
+      if (aligned_offset + interval.size <= neighbor_offset &&
+          neighbor_offset - aligned_offset < best_fit) {
+        best_offset = aligned_offset;
+        best_fit = neighbor_offset - aligned_offset;
+      }
+      current_offset =
+          std::max(current_offset, neighbor_offset + intervals[j].size);
+    }
+    if (best_offset == kNoOffset) best_offset = AlignTo(current_offset);
+
+    (*offsets)[i] = best_offset;
+    arena_size = std::max(arena_size, best_offset + interval.size);
+    placed.push_back(i);
+  }
+  return arena_size;
+}
+
+// Returns the largest total size of the tensors live at any node.
+size_t GetLowerBound(const std::vector<TensorInterval>& intervals,
+                     int num_nodes) {
+  size_t lower_bound = 0;
+  for (int node = 0; node <= num_nodes; ++node) {
+    size_t live_size = 0;
+    for (const TensorInterval& interval : intervals) {
+      if (interval.first_node <= node && node <= interval.last_node) {
+        live_size += interval.size;
+      }
+    }
+    lower_bound = std::max(lower_bound, live_size);
+  }
+  return lower_bound;
+}
+
+}  // namespace
+
+TfLiteStatus PlanMemoryOffline(const ModelT& model,
+                               std::vector<int32_t>* offsets,
+                               size_t* arena_size, size_t* lower_bound,
+                               ErrorReporter* error_reporter) {
+  if (model.subgraphs.empty()) {
+    TF_LITE_REPORT_ERROR(error_reporter, "No subgraph in the model.");
+    return kTfLiteError;
+  }
+  const SubGraphT& subgraph = *model.subgraphs[0];
+  const std::vector<TensorInterval> intervals =
+      GetTensorIntervals(model, subgraph, error_reporter);
+
+  using Key = std::function<bool(const TensorInterval&, const TensorInterval&)>;
+  auto length = [](const TensorInterval& t) -> size_t {
+    return t.last_node - t.first_node + 1;
+  };
+  const std::vector<Key> orders = {
+      // Largest tensors first.
+      [](const TensorInterval& a, const TensorInterval& b) {
+        if (a.size != b.size) return a.size > b.size;
+        return a.first_node < b.first_node;
+      },
+      // Longest lived tensors first.
+      [length](const TensorInterval& a, const TensorInterval& b) {
+        if (length(a) != length(b)) return length(a) > length(b);
+        return a.size > b.size;
+      },
+      // Tensors taking the most memory over time first.
+      [length](const TensorInterval& a, const TensorInterval& b) {
+        if (a.size * length(a) != b.size * length(b)) {
+          return a.size * length(a) > b.size * length(b);
+        }
+        return a.size > b.size;
+      },
+  };
+
+  std::vector<size_t> best_offsets;
+  size_t best_arena_size = std::numeric_limits<size_t>::max();
+  for (const Key& key : orders) {
+    std::vector<int> order(intervals.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return key(intervals[a], intervals[b]);
+    });
+    std::vector<size_t> order_offsets;
+    const size_t order_arena_size =
+        PlaceBestFit(intervals, order, &order_offsets);
+    if (order_arena_size < best_arena_size) {
+      best_arena_size = order_arena_size;
+      best_offsets = std::move(order_offsets);
+    }
+  }
+  if (intervals.empty()) best_arena_size = 0;
+  if (best_arena_size > std::numeric_limits<int32_t>::max()) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Arena of %zu bytes is too large for offline offsets.",
+                         best_arena_size);
+    return kTfLiteError;
+  }
+
+  offsets->assign(subgraph.tensors.size(), kNotPlanned);
+  for (size_t i = 0; i < intervals.size(); ++i) {
+    (*offsets)[intervals[i].tensor] = static_cast<int32_t>(best_offsets[i]);
+  }
+  if (arena_size) *arena_size = best_arena_size;
+  if (lower_bound) {
+    *lower_bound = GetLowerBound(intervals, subgraph.operators.size());
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus AddOfflineMemoryPlan(ModelT* model,
+                                  ErrorReporter* error_reporter) {
+  std::vector<int32_t> offsets;
+  TF_LITE_ENSURE_STATUS(
+      PlanMemoryOffline(*model, &offsets, nullptr, nullptr, error_reporter));
+
+  std::vector<int32_t> words = {kOfflineMemoryAllocationVersion, 0,
+                                static_cast<int32_t>(offsets.size())};
+  words.insert(words.end(), offsets.begin(), offsets.end());
+  std::vector<uint8_t> data(words.size() * sizeof(int32_t));
+  std::memcpy(data.data(), words.data(), data.size());
+
+  for (const auto& metadata : model->metadata) {
+    if (metadata->name == kOfflineMemoryAllocationMetadata) {
+      model->buffers[metadata->buffer]->data = std::move(data);
+      return kTfLiteOk;
+    }
+  }
+  auto buffer = absl::make_unique<BufferT>();
+  buffer->data = std::move(data);
+  auto metadata = absl::make_unique<MetadataT>();
+  metadata->name = kOfflineMemoryAllocationMetadata;
+  metadata->buffer = model->buffers.size();
+  model->buffers.push_back(std::move(buffer));
+  model->metadata.push_back(std::move(metadata));
+  return kTfLiteOk;
+}
+
+TfLiteStatus AddOfflineMemoryPlan(const std::string& input_file,
+                                  const std::string& output_file,
+                                  ErrorReporter* error_reporter) {
+  std::unique_ptr<ModelT> model = utils::CreateMutableModelFromFile(input_file);
+  TF_LITE_ENSURE_STATUS(AddOfflineMemoryPlan(model.get(), error_reporter));
+  std::unique_ptr<flatbuffers::FlatBufferBuilder> builder =
+      utils::FinishModel(model.get());
+  utils::WriteFile(output_file, builder->GetBufferPointer(),
+                   builder->GetSize());
+  return kTfLiteOk;
+}
+
+}  // namespace optimize
+}  // namespace tflite
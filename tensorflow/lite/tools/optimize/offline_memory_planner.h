@@ -0,0 +1,71 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_MEMORY_PLANNER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace optimize {
+
+// Name of the model metadata holding offline planned arena offsets. The
+// metadata buffer is a list of int32 values: the format version (1), the
+// subgraph index, the number n of tensors in that subgraph, followed by the
+// arena offset of each of the n tensors, or -1 for tensors left to the
+// runtime planner. This is the format TF Lite Micro uses as well.
+constexpr char kOfflineMemoryAllocationMetadata[] = "OfflineMemoryAllocation";
+
+// Computes arena offsets for the activations (non-constant tensors of known
+// size) of the primary subgraph of `model`, using the lifetimes the TF Lite
+// runtime gives them when running the operators in order.
+//
+// Like the runtime's arena planner, tensors are placed one at a time into the
+// best fitting gap. Unlike it, several orders (by size, by lifetime length and
+// by size times lifetime length) are tried and the smallest arena is kept, as
+// XLA's heap simulator does. `offsets` receives one offset per tensor, or -1.
+// `arena_size` and `lower_bound`, if not null, receive the size of the arena
+// and the largest total size of tensors live at the same time, which no plan
+// can go below.
+//
+// Note: This is a private API, subject to change.
+TfLiteStatus PlanMemoryOffline(const ModelT& model,
+                               std::vector<int32_t>* offsets,
+                               size_t* arena_size, size_t* lower_bound,
+                               ErrorReporter* error_reporter);
+
+// Plans the primary subgraph of `model` as above and stores the offsets in
+// its kOfflineMemoryAllocationMetadata metadata, replacing any previous plan.
+//
+// Note: This is a private API, subject to change.
+TfLiteStatus AddOfflineMemoryPlan(ModelT* model, ErrorReporter* error_reporter);
+
+// Same as above but reads the model from `input_file` and writes the planned
+// model to `output_file`.
+//
+// Note: This is a private API, subject to change.
+TfLiteStatus AddOfflineMemoryPlan(const std::string& input_file,
+                                  const std::string& output_file,
+                                  ErrorReporter* error_reporter);
+
+}  // namespace optimize
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_MEMORY_PLANNER_H_
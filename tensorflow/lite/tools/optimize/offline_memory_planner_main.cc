@@ -0,0 +1,35 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cstdio>
+
+#include "tensorflow/lite/stderr_reporter.h"
+#include "tensorflow/lite/tools/optimize/offline_memory_planner.h"
+//
+// Note: This is a private API, subject to change.
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    printf(
+        "Wrong number of arguments. Example: offline_memory_planner_main "
+        "${input} ${output}");
+    return 1;
+  }
+
+  if (tflite::optimize::AddOfflineMemoryPlan(
+          argv[1], argv[2], tflite::DefaultErrorReporter()) != kTfLiteOk) {
+    return 1;
+  }
+
+  return 0;
+}
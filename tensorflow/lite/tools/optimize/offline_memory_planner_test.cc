@@ -0,0 +1,139 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/offline_memory_planner.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/memory/memory.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/stderr_reporter.h"
+
+namespace tflite {
+namespace optimize {
+namespace {
+
+// Adds a float tensor of `num_floats` elements to the only subgraph of
+// `model`, constant if `constant` is true, and returns its index.
+int AddTensor(ModelT* model, int num_floats, bool constant = false) {
+  auto buffer = absl::make_unique<BufferT>();
+  if (constant) buffer->data.resize(num_floats * sizeof(float));
+  auto tensor = absl::make_unique<TensorT>();
+  tensor->type = TensorType_FLOAT32;
+  tensor->shape = {num_floats};
+  tensor->buffer = model->buffers.size();
+  model->buffers.push_back(std::move(buffer));
+  auto& tensors = model->subgraphs[0]->tensors;
+  tensors.push_back(std::move(tensor));
+  return tensors.size() - 1;
+}
+
+void AddOperator(ModelT* model, const std::vector<int32_t>& inputs,
+                 const std::vector<int32_t>& outputs) {
+  auto op = absl::make_unique<OperatorT>();
+  op->inputs = inputs;
+  op->outputs = outputs;
+  model->subgraphs[0]->operators.push_back(std::move(op));
+}
+
+// Two branches that join:
+//   t0 -> t1 -> t2 -\
+//    \--> t3 -------> t4 (+ constant t5)
+std::unique_ptr<ModelT> CreateBranchyModel() {
+  auto model = absl::make_unique<ModelT>();
+  model->subgraphs.push_back(absl::make_unique<SubGraphT>());
+  // Buffer 0 is the empty buffer by convention.
+  model->buffers.push_back(absl::make_unique<BufferT>());
+  const int t0 = AddTensor(model.get(), 64);
+  const int t1 = AddTensor(model.get(), 256);
+  const int t2 = AddTensor(model.get(), 32);
+  const int t3 = AddTensor(model.get(), 128);
+  const int t4 = AddTensor(model.get(), 16);
+  const int t5 = AddTensor(model.get(), 16, /*constant=*/true);
+  AddOperator(model.get(), {t0}, {t1});
+  AddOperator(model.get(), {t1}, {t2});
+  AddOperator(model.get(), {t0}, {t3});
+  AddOperator(model.get(), {t2, t3, t5}, {t4});
+  model->subgraphs[0]->inputs = {t0};
+  model->subgraphs[0]->outputs = {t4};
+  return model;
+}
+
+TEST(OfflineMemoryPlannerTest, PlansNonOverlappingOffsets) {
+  auto model = CreateBranchyModel();
+  std::vector<int32_t> offsets;
+  size_t arena_size = 0;
+  size_t lower_bound = 0;
+  ASSERT_EQ(PlanMemoryOffline(*model, &offsets, &arena_size, &lower_bound,
+                              DefaultErrorReporter()),
+            kTfLiteOk);
+  ASSERT_EQ(offsets.size(), 6);
+
+  // Constant tensors are not in the arena.
+  EXPECT_EQ(offsets[5], -1);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_GE(offsets[i], 0);
+    EXPECT_EQ(offsets[i] % 64, 0);
+  }
+  // Sizes in bytes and lifetimes (first and last node) of t0..t4.
+  const size_t sizes[] = {256, 1024, 128, 512, 64};
+  const int first[] = {0, 0, 1, 2, 3};
+  const int last[] = {4, 1, 3, 3, 4};
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_LE(offsets[i] + sizes[i], arena_size);
+    for (int j = i + 1; j < 5; ++j) {
+      if (first[i] > last[j] || first[j] > last[i]) continue;
+      EXPECT_TRUE(offsets[i] + sizes[i] <= offsets[j] ||
+                  offsets[j] + sizes[j] <= offsets[i])
+          << "t" << i << " and t" << j << " overlap";
+    }
+  }
+  // t0, t1 and t2 are live together while the second operator runs.
+  EXPECT_EQ(lower_bound, 256 + 1024 + 128);
+  EXPECT_GE(arena_size, lower_bound);
+}
+
+TEST(OfflineMemoryPlannerTest, AddsAndReplacesMetadata) {
+  auto model = CreateBranchyModel();
+  ASSERT_EQ(AddOfflineMemoryPlan(model.get(), DefaultErrorReporter()),
+            kTfLiteOk);
+  ASSERT_EQ(AddOfflineMemoryPlan(model.get(), DefaultErrorReporter()),
+            kTfLiteOk);
+
+  ASSERT_EQ(model->metadata.size(), 1);
+  EXPECT_EQ(model->metadata[0]->name, kOfflineMemoryAllocationMetadata);
+  const std::vector<uint8_t>& data =
+      model->buffers[model->metadata[0]->buffer]->data;
+  ASSERT_EQ(data.size(), (3 + 6) * sizeof(int32_t));
+  std::vector<int32_t> words(data.size() / sizeof(int32_t));
+  std::memcpy(words.data(), data.data(), data.size());
+  EXPECT_EQ(words[0], 1);  // Version.
+  EXPECT_EQ(words[1], 0);  // Subgraph.
+  EXPECT_EQ(words[2], 6);  // Number of tensors.
+  std::vector<int32_t> offsets;
+  ASSERT_EQ(PlanMemoryOffline(*model, &offsets, nullptr, nullptr,
+                              DefaultErrorReporter()),
+            kTfLiteOk);
+  EXPECT_THAT(std::vector<int32_t>(words.begin() + 3, words.end()),
+              ::testing::ElementsAreArray(offsets));
+}
+
+}  // namespace
+}  // namespace optimize
+}  // namespace tflite
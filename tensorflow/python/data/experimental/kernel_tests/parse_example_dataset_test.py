@@ -1148,6 +1148,44 @@ class ParseExampleDatasetTest(test_base.DatasetTestBase,
     else:
       self.assertCountEqual(expected, actual)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testStringFeaturesOutliveSerializedInput(self):
+    # The kernel parses views into its input batch, so string features must
+    # be copied out before the batch is released. Long values do not fit in
+    # the small-string buffer of a tstring.
+    num_batches = 8
+    batch_size = 4
+    value = lambda i: (b"value_%d_" % i) * 8
+    batches = []
+    for b in range(num_batches):
+      batches.append([
+          example(features=features({
+              "dense": bytes_feature([value(b * batch_size + i)]),
+              "sparse": bytes_feature([value(i), value(b)]),
+          })).SerializeToString() for i in range(batch_size)
+      ])
+
+    test_features = {
+        "dense": parsing_ops.FixedLenFeature((), dtype=dtypes.string),
+        "sparse": parsing_ops.VarLenFeature(dtype=dtypes.string),
+    }
+    dataset = dataset_ops.Dataset.from_tensor_slices(batches)
+    dataset = dataset.apply(
+        contrib_parsing_ops.parse_example_dataset(
+            test_features, num_parallel_calls=4))
+
+    outputs = self.getDatasetOutput(dataset)
+    self.assertLen(outputs, num_batches)
+    for b, output in enumerate(outputs):
+      self.assertAllEqual(
+          [value(b * batch_size + i) for i in range(batch_size)],
+          output["dense"])
+      expected_sparse = []
+      for i in range(batch_size):
+        expected_sparse.extend([value(i), value(b)])
+      self.assertAllEqual(expected_sparse, output["sparse"].values)
+
+
 
 class ParseExampleDatasetCheckpointTest(tf_record_test_base.FeaturesTestBase,
                                         checkpoint_test_base.CheckpointTestBase,
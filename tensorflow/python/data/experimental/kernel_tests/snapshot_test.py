@@ -330,6 +330,36 @@ class SnapshotTest(tf_record_test_base.TFRecordTestBase,
         num_runs_per_fingerprint=2,
         num_snapshot_shards_per_run=multiprocessing.cpu_count())
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testWriteSnapshotDatasetSameFingerprintSharePendingRun(self):
+    os.environ["TF_DATA_SNAPSHOT_SHARE_PENDING_RUNS"] = "true"
+    try:
+      dataset1 = dataset_ops.Dataset.range(1000)
+      dataset1 = dataset1.apply(snapshot.snapshot(self._snapshot_dir))
+      next1 = self.getNext(dataset1)
+      for i in range(500):
+        self.assertEqual(i, self.evaluate(next1()))
+
+      # The second pipeline reads its input directly while the first one is
+      # still writing the snapshot.
+      dataset2 = dataset_ops.Dataset.range(1000)
+      dataset2 = dataset2.apply(snapshot.snapshot(self._snapshot_dir))
+      next2 = self.getNext(dataset2)
+      for i in range(500):
+        self.assertEqual(i, self.evaluate(next2()))
+
+      for i in range(500, 1000):
+        self.assertEqual(i, self.evaluate(next1()))
+        self.assertEqual(i, self.evaluate(next2()))
+    finally:
+      del os.environ["TF_DATA_SNAPSHOT_SHARE_PENDING_RUNS"]
+
+    self.assertSnapshotDirectoryContains(
+        self._snapshot_dir,
+        num_fingerprints=1,
+        num_runs_per_fingerprint=1,
+        num_snapshot_shards_per_run=multiprocessing.cpu_count())
+
   @combinations.generate(test_base.default_test_combinations())
   def testWriteSnapshotCustomShardFunction(self):
     dataset = dataset_ops.Dataset.range(1000)
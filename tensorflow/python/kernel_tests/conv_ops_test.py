@@ -2989,6 +2989,28 @@ class DeepConv2DTest(test.TestCase):
   def testConv2D3x3FilterStride1x1Same(self):
     self._RunTestCases([1, 1], "SAME")
 
+  def testConv2DAutotuneMatchesDefault(self):
+    # The first run of each shape measures DeepConv2D and SpatialConvolution,
+    # later runs use the cached winner; both must match the default kernel.
+    os.environ["TF_USE_DEEP_CONV2D"] = "0"
+    input_shape, filter_shape = [2, 7, 4, 81], [3, 3, 81, 77]
+    x1 = np.random.rand(*input_shape).astype(np.float32)
+    x2 = np.random.rand(*filter_shape).astype(np.float32)
+    with self.cached_session(use_gpu=False):
+      for padding in ["VALID", "SAME"]:
+        conv = nn_ops.conv2d(
+            constant_op.constant(x1), constant_op.constant(x2),
+            strides=[1, 1, 1, 1], padding=padding)
+        os.environ["TF_CPU_CONV2D_AUTOTUNE"] = "0"
+        values_expect = self.evaluate(conv)
+        try:
+          os.environ["TF_CPU_CONV2D_AUTOTUNE"] = "1"
+          for _ in range(2):
+            self.assertAllClose(
+                values_expect, self.evaluate(conv), rtol=1e-4, atol=1e-4)
+        finally:
+          os.environ["TF_CPU_CONV2D_AUTOTUNE"] = "0"
+
 
 class Conv2DBenchmark(test.Benchmark):
 
@@ -1473,6 +1473,56 @@ class CSRSparseMatrixOpsBenchmark(test.Benchmark):
                 },
                 min_iters=10)
 
+  def benchmark_sparse_matrix_mat_mul_power_law(self):
+    # Graph adjacency matrices have power-law row degrees: a few rows hold most
+    # of the nonzeros, which stresses how the CPU kernel balances its shards.
+    # num_rows, num_cols of the dense operand, transpose.
+    cases = [
+        [20000, 64, False],
+        [20000, 64, True],
+        [100000, 16, False],
+        [100000, 16, True],
+    ]
+    seed = 42
+
+    for num_rows, num_features, transpose in cases:
+      rng = np.random.RandomState(seed)
+      degrees = np.minimum(rng.zipf(1.8, size=num_rows), num_rows)
+      rows = np.repeat(np.arange(num_rows), degrees)
+      cols = rng.randint(num_rows, size=rows.size)
+      # Going through CSR sums away duplicate (row, col) pairs.
+      w_np = sparse.csr_matrix(
+          (rng.randn(rows.size).astype(np.float32), (rows, cols)),
+          shape=(num_rows, num_rows)).tocoo()
+      for num_threads in [1, 4, 8]:
+        with ops.Graph().as_default(), ops.device(CPU):
+          random_seed.set_random_seed(seed)
+          x = random_ops.random_normal([num_rows, num_features],
+                                       dtype=dtypes.float32)
+          w_st = sparse_tensor.SparseTensor(
+              zip(w_np.row, w_np.col), w_np.data, w_np.shape)
+          w_st = sparse_ops.sparse_reorder(w_st)
+          w_sm = sparse_csr_matrix_ops.sparse_tensor_to_csr_sparse_matrix(
+              w_st.indices, w_st.values, w_st.dense_shape)
+          xw_sparse_matrix = sparse_csr_matrix_ops.sparse_matrix_mat_mul(
+              w_sm, x, transpose_a=transpose)
+
+          with session.Session(
+              config=config_pb2.ConfigProto(
+                  intra_op_parallelism_threads=num_threads)) as sess:
+            name_template = (
+                "mat_mul_power_law_cpu_W_%d_x_%d_transpose_%s_threads_%d")
+            self.run_op_benchmark(
+                sess,
+                xw_sparse_matrix.op,
+                name=name_template %
+                (num_rows, num_features, transpose, num_threads),
+                extras={
+                    "num_nonzero": w_np.nnz,
+                    "max_row_nonzero": int(degrees.max()),
+                },
+                min_iters=10)
+
   def benchmark_sparse_matrix_sparse_matmul(self):
     density = 0.05
     # pylint: disable=g-long-lambda
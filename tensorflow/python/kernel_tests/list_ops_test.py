@@ -569,6 +569,22 @@ class ListOpsTest(test_util.TensorFlowTestCase, parameterized.TestCase):
     with context.device("gpu:0"):
       self.testTensorListFromTensor()
 
+  def testFromTensorStackRoundTrip(self):
+    # Rows of 16 floats are aligned, so the list elements alias `t`.
+    t = math_ops.range(48, dtype=dtypes.float32)
+    t = array_ops.reshape(t, [3, 16])
+    l = list_ops.tensor_list_from_tensor(t, element_shape=[16])
+    stacked = list_ops.tensor_list_stack(l, element_dtype=dtypes.float32)
+    self.assertAllEqual(self.evaluate(stacked), self.evaluate(t))
+    popped, _ = list_ops.tensor_list_pop_back(l, element_dtype=dtypes.float32)
+    stacked = list_ops.tensor_list_stack(popped, element_dtype=dtypes.float32)
+    self.assertAllEqual(self.evaluate(stacked), self.evaluate(t)[:2])
+    l = list_ops.tensor_list_set_item(l, 1, array_ops.zeros([16]))
+    stacked = list_ops.tensor_list_stack(l, element_dtype=dtypes.float32)
+    expected = self.evaluate(t)
+    expected[1] = 0.
+    self.assertAllEqual(self.evaluate(stacked), expected)
+
   def testGetSetBool(self):
     t = constant_op.constant([True, False])
     l = list_ops.tensor_list_from_tensor(t, element_shape=[])
@@ -305,6 +305,23 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase,
     read = resource_variable_ops.read_variable_op(handle, dtype=dtypes.int32)
     self.assertEqual(self.evaluate(read), [[3]])
 
+  @test_util.run_in_graph_and_eager_modes
+  def testReadsInCopyOnReadModeSeeScatterUpdates(self):
+    handle = resource_variable_ops.var_handle_op(
+        dtype=dtypes.int32, shape=[2])
+    self.evaluate(
+        resource_variable_ops.assign_variable_op(
+            handle, constant_op.constant([1, 2], dtype=dtypes.int32)))
+    for expected in ([3, 2], [5, 2], [7, 2]):
+      self.evaluate(
+          resource_variable_ops.resource_scatter_add(
+              handle, [0], constant_op.constant([2], dtype=dtypes.int32)))
+      # Repeated reads may share a snapshot, which must not go stale.
+      for _ in range(2):
+        read = resource_variable_ops.read_variable_op(
+            handle, dtype=dtypes.int32)
+        self.assertAllEqual(self.evaluate(read), expected)
+
   @test_util.run_in_graph_and_eager_modes
   def testGradientGatherNd(self):
     v = resource_variable_ops.ResourceVariable(
@@ -326,6 +326,23 @@ class UnsortedSegmentTest(SegmentReductionHelper):
               self.assertAllCloseAccordingToType(np_ans, tf_ans)
               self.assertShapeEqual(np_ans, s)
 
+  @test_util.run_deprecated_v1
+  def testLargeSumMatchesSerialOrder(self):
+    # Large enough for the CPU kernel to reduce segments in parallel. Each
+    # segment must still be accumulated in the order of its rows, which is
+    # also the order np.add.at applies them in.
+    np.random.seed(0)
+    num_segments = 300
+    indices = np.random.randint(-1, num_segments, size=4096)
+    np_x = np.random.randn(4096, 16).astype(np.float32)
+    np_ans = np.zeros((num_segments, 16), dtype=np.float32)
+    np.add.at(np_ans, indices[indices >= 0], np_x[indices >= 0])
+    with self.cached_session(use_gpu=False):
+      tf_ans = self.evaluate(
+          math_ops.unsorted_segment_sum(
+              np_x, segment_ids=indices, num_segments=num_segments))
+    self.assertAllEqual(np_ans, tf_ans)
+
   def testNumSegmentsTypes(self):
     dtypes = [dtypes_lib.int32, dtypes_lib.int64]
     indices_flat = np.array([0, 4, 0, 8, 3, 8, 4, 7, 7, 3])
@@ -27,6 +27,16 @@ from tensorflow.python.ops import gen_array_ops
 from tensorflow.python.platform import test
 
 
+def _unique_by_appearance(x):
+  """Returns unique, idx and count of `x` with elements in appearance order."""
+  u, first, inverse, count = np.unique(
+      x, return_index=True, return_inverse=True, return_counts=True)
+  order = np.argsort(first)
+  rank = np.empty_like(order)
+  rank[order] = np.arange(len(order))
+  return u[order], rank[inverse], count[order]
+
+
 class UniqueTest(test.TestCase):
 
   def testInt32(self):
@@ -170,6 +180,24 @@ class UniqueTest(test.TestCase):
     self.assertAllEqual(tf_y, true_y)
     self.assertAllEqual(tf_idx, true_idx)
 
+  def testSorted(self):
+    x = np.sort(np.random.randint(0, high=1000, size=7000)).astype(np.int64)
+    true_y, true_idx, _ = _unique_by_appearance(x)
+    y, idx = array_ops.unique(x)
+    tf_y, tf_idx = self.evaluate([y, idx])
+    self.assertAllEqual(tf_y, true_y)
+    self.assertAllEqual(tf_idx, true_idx)
+
+  def testLargeInt64(self):
+    # Large enough to be deduplicated on multiple threads.
+    x = np.random.randint(-2**40, high=2**40, size=50000).astype(np.int64)
+    x = np.concatenate([x, x[::3], np.random.permutation(x)[:100000]])
+    true_y, true_idx, _ = _unique_by_appearance(x)
+    y, idx = array_ops.unique(x)
+    tf_y, tf_idx = self.evaluate([y, idx])
+    self.assertAllEqual(tf_y, true_y)
+    self.assertAllEqual(tf_idx, true_idx)
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -315,6 +343,25 @@ class UniqueWithCountsTest(test.TestCase):
     self.assertAllEqual(tf_idx, true_idx)
     self.assertAllEqual(tf_count, true_count)
 
+  def testSorted(self):
+    x = np.sort(np.random.randint(0, high=1000, size=7000)).astype(np.int32)
+    true_y, true_idx, true_count = _unique_by_appearance(x)
+    y, idx, count = array_ops.unique_with_counts(x)
+    tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+    self.assertAllEqual(tf_y, true_y)
+    self.assertAllEqual(tf_idx, true_idx)
+    self.assertAllEqual(tf_count, true_count)
+
+  def testLargeInt64(self):
+    # Large enough to be deduplicated on multiple threads.
+    x = np.random.randint(0, high=30000, size=200000).astype(np.int64)
+    true_y, true_idx, true_count = _unique_by_appearance(x)
+    y, idx, count = array_ops.unique_with_counts(x)
+    tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+    self.assertAllEqual(tf_y, true_y)
+    self.assertAllEqual(tf_idx, true_idx)
+    self.assertAllEqual(tf_count, true_count)
+
 
 if __name__ == '__main__':
   test.main()
@@ -493,6 +493,42 @@ class BatchOpsTest(test.TestCase):
           np.all(
               np.equal(main_results[0], np.array([5, 6, 7], dtype=np.int32))))
 
+  def testBatchFunctionOpWithLengthBuckets(self):
+    """Tests that inputs are padded to the boundary of their length bucket."""
+    if context.executing_eagerly():
+      return
+
+    with self.cached_session() as sess:
+
+      @function.Defun(dtypes.int32)
+      def computation(in_t):
+        return in_t + 1
+
+      inp = array_ops.placeholder(dtype=dtypes.int32, shape=[1, None])
+      result = gen_batch_ops.batch_function(
+          [inp],
+          num_batch_threads=1,
+          max_batch_size=10,
+          batch_timeout_micros=100000,  # 100ms
+          Tout=[dtypes.int32],
+          length_bucket_boundaries=[2, 4],
+          f=computation,
+          captured_tensors=computation.captured_inputs)
+      thread_results = []
+
+      def worker():
+        thread_results.extend(
+            sess.run([result], feed_dict={inp: [[1, 2, 3]]}))
+
+      worker_thread = threading.Thread(target=worker)
+      worker_thread.start()
+      main_results = sess.run([result], feed_dict={inp: [[4]]})
+      worker_thread.join()
+      # The inputs land in different buckets, and the function sees them
+      # zero-padded to length 4 and 2 respectively.
+      self.assertAllEqual(thread_results[0], [[2, 3, 4, 1]])
+      self.assertAllEqual(main_results[0], [[5, 1]])
+
   def testBasicUnbatchDecoratedWithReshape(self):
     """Tests that the batch_function decorator works."""
     if context.executing_eagerly():
@@ -4262,6 +4262,39 @@ class JpegTest(test_util.TensorFlowTestCase):
           result = image_ops.decode_and_crop_jpeg(jpeg0, crop_window)
           self.evaluate(result)
 
+  def testDecodeJpegWithTargetSize(self):
+    base = "tensorflow/core/lib/jpeg/testdata"
+    jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+    # The image is 256x128; each target picks the largest ratio that keeps at
+    # least that many rows and columns.
+    for (target_height, target_width), ratio in [((32, 16), 8), ((33, 16), 4),
+                                                 ((0, 64), 2), ((200, 0), 1)]:
+      image0 = image_ops.decode_jpeg(jpeg0, ratio=ratio)
+      image1 = image_ops.decode_jpeg(
+          jpeg0, target_height=target_height, target_width=target_width)
+      image0, image1 = self.evaluate([image0, image1])
+      self.assertAllEqual(image0, image1)
+
+  def testCropAndDecodeJpegWithTargetSize(self):
+    base = "tensorflow/core/lib/jpeg/testdata"
+    jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+    # A 64x64 window at (32, 16) is decoded at ratio 4, where it is the 16x16
+    # window at (8, 4).
+    image0 = image_ops.decode_and_crop_jpeg(jpeg0, [8, 4, 16, 16], ratio=4)
+    image1 = image_ops.decode_and_crop_jpeg(
+        jpeg0, [32, 16, 64, 64], target_height=16, target_width=16)
+    image0, image1 = self.evaluate([image0, image1])
+    self.assertEqual(image1.shape, (16, 16, 3))
+    self.assertAllEqual(image0, image1)
+
+  def testDecodeJpegTargetSizeWithRatio(self):
+    base = "tensorflow/core/lib/jpeg/testdata"
+    jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+    with self.assertRaisesRegex((ValueError, errors.InvalidArgumentError),
+                                "ratio cannot be combined"):
+      self.evaluate(
+          image_ops.decode_jpeg(jpeg0, ratio=2, target_height=16))
+
   def testSynthetic(self):
     with self.cached_session():
       # Encode it, then decode it, then encode it
@@ -1213,7 +1213,11 @@ def _get_opt_einsum_contract_path(equation, shaped_inputs_tuple, optimize):
       use_blas=True)
   # Return a tuple so that the cached value is not mutable.
   indices_and_equations = tuple([(expr[0], expr[2]) for expr in contractions])
-  return indices_and_equations
+  label_to_dim = {}
+  for labels, shaped in zip(equation.split('->')[0].split(','),
+                            shaped_inputs_tuple):
+    label_to_dim.update(zip(labels, shaped.shape))
+  return _einsum_v2_reorder_intermediates(indices_and_equations, label_to_dim)
 
 
 # Cache the possibly expensive opt_einsum.contract_path call using lru_cache
@@ -1223,6 +1227,159 @@ if not six.PY2:
       _get_opt_einsum_contract_path)
 
 
+def _einsum_v2_transpose_cost(input_terms, output_term, label_to_dim):
+  """Returns the number of elements EinsumOp transposes for a binary einsum.
+
+  EinsumOp transposes each operand to [batch, free, contract, reduce] (or
+  [batch, contract, free, reduce]) order, where labels of the same type are
+  ordered by their first appearance in the equation. Its result is computed in
+  [batch, free labels of lhs, free labels of rhs] order and then transposed to
+  the output subscripts.
+
+  Args:
+    input_terms: Subscripts of the operands, without repeated labels.
+    output_term: Output subscripts.
+    label_to_dim: Map from labels to their (estimated) dimensions.
+  """
+  labels = ''.join(input_terms)
+  label_ids = {}
+  for label in labels:
+    label_ids.setdefault(label, len(label_ids))
+
+  def label_type(label, free_type=2):
+    # Same values as `EinsumHelper::DimensionType`, except that free and
+    # contract dimensions swap their values if `free_type` is 3.
+    is_unique = labels.count(label) == 1
+    if label in output_term:
+      return free_type if is_unique else 1
+    return 4 if is_unique else 5 - free_type
+
+  def num_elements(term):
+    return functools.reduce(lambda x, y: x * y,
+                            [label_to_dim.get(label, 1) for label in term], 1)
+
+  cost = 0
+  for term in input_terms:
+    if not any([(label_type(l, free_type), label_ids[l]) for l in term] ==
+               sorted([(label_type(l, free_type), label_ids[l]) for l in term])
+               for free_type in (2, 3)):
+      cost += num_elements(term)
+  computed = sorted([l for l in label_ids if label_type(l) == 1],
+                    key=label_ids.get)
+  computed += [l for l in labels if label_type(l) == 2]
+  if computed != list(output_term):
+    cost += num_elements(output_term)
+  return cost
+
+
+def _einsum_v2_reorder_intermediates(indices_and_equations, label_to_dim):
+  """Reorders subscripts of intermediate results to avoid transposing them.
+
+  The order of subscripts of an intermediate result, and whether it is the lhs
+  or the rhs of the einsum consuming it, are free to choose. For each
+  intermediate result, pick the choice that minimizes the elements transposed
+  by the einsums producing and consuming it, as estimated by
+  `_einsum_v2_transpose_cost`.
+
+  Args:
+    indices_and_equations: Sequence of (operand_indices, binary_equation)
+      pairs, as returned by opt_einsum for an n-ary einsum.
+    label_to_dim: Map from labels to their (estimated) dimensions.
+
+  Returns:
+    A tuple of (operand_indices, binary_equation) pairs computing the same
+    result.
+  """
+  input_terms = []
+  outputs = []
+  for operand_indices, equation in indices_and_equations:
+    input_str, output_str = equation.split('->')
+    input_terms.append(input_str.split(','))
+    outputs.append(output_str)
+    # Broadcasting and repeated labels are handled by EinsumOp in ways that are
+    # not modeled by `_einsum_v2_transpose_cost`; leave such equations as is.
+    if (len(input_terms[-1]) != len(operand_indices) or
+        len(operand_indices) > 2 or not all(
+            all(label.isalpha() for label in term) and
+            len(set(term)) == len(term)
+            for term in input_terms[-1] + [output_str])):
+      return indices_and_equations
+
+  # Replay the contractions on operand ids to find the consumer of each
+  # intermediate result. Ids below `num_inputs` denote einsum inputs, and id
+  # `num_inputs + k` denotes the result of the k-th contraction.
+  num_inputs = 1 + sum(len(indices) - 1 for indices, _ in indices_and_equations)
+  operands = list(range(num_inputs))
+  sources = []
+  consumers = {}
+  for k, (operand_indices, _) in enumerate(indices_and_equations):
+    sources.append([operands.pop(i) for i in operand_indices])
+    for operand in sources[-1]:
+      if operand >= num_inputs:
+        consumers[operand - num_inputs] = k
+    operands.append(num_inputs + k)
+  # Subscripts of the operands of each contraction keyed by operand id, and the
+  # order of the operands of each contraction.
+  terms = [dict(zip(srcs, term)) for srcs, term in zip(sources, input_terms)]
+  orders = [list(srcs) for srcs in sources]
+
+  def cost(k):
+    return _einsum_v2_transpose_cost([terms[k][src] for src in orders[k]],
+                                     outputs[k], label_to_dim)
+
+  for k in range(len(indices_and_equations) - 1):
+    result = num_inputs + k
+    c = consumers[k]
+    c_labels = ''.join(terms[c][src] for src in orders[c])
+
+    # Candidate subscripts: the current ones, the order in which contraction k
+    # computes its result, and both sorted by their dimension type in the
+    # consumer (ties broken by their position in the consumer's lhs).
+    k_labels = ''.join(terms[k][src] for src in orders[k])
+    computed = sorted([
+        l for l in set(k_labels) if k_labels.count(l) == 2 and l in outputs[k]
+    ], key=k_labels.index)
+    computed += [
+        l for l in k_labels if k_labels.count(l) == 1 and l in outputs[k]
+    ]
+    candidates = [outputs[k], ''.join(computed)]
+    lhs_term = terms[c][orders[c][0]]
+    for base in (outputs[k], ''.join(computed)):
+      for free_type in (2, 3):
+        def sort_key(l, base=base, free_type=free_type):
+          in_other = c_labels.count(l) == 2
+          if l in outputs[c]:
+            label_type = 1 if in_other else free_type
+          else:
+            label_type = 5 - free_type if in_other else 4
+          lhs_id = lhs_term.index(l) if l in lhs_term else len(lhs_term)
+          return label_type, lhs_id, base.index(l)
+        candidates.append(''.join(sorted(base, key=sort_key)))
+
+    best = None
+    for order in (orders[c], orders[c][::-1]):
+      for candidate in candidates:
+        outputs[k] = candidate
+        terms[c][result] = candidate
+        orders[c] = order
+        candidate_cost = cost(k) + cost(c)
+        if best is None or candidate_cost < best[0]:
+          best = (candidate_cost, candidate, order)
+    _, outputs[k], orders[c] = best
+    terms[c][result] = outputs[k]
+
+  reordered = []
+  for k, (operand_indices, _) in enumerate(indices_and_equations):
+    if orders[k] != sources[k]:
+      # Swap the operands by popping them in the reverse order.
+      i, j = operand_indices
+      j += int(j >= i)
+      operand_indices = (j, i - int(i > j))
+    equation = ','.join(terms[k][src] for src in orders[k]) + '->' + outputs[k]
+    reordered.append((operand_indices, equation))
+  return tuple(reordered)
+
+
 def _einsum_v2_parse_and_resolve_equation(equation, input_shapes):
   """Helper which validates einsum equation and resolves input shapes."""
   resolved_equation = equation.replace(' ', '')
@@ -877,6 +877,26 @@ class EinsumTest(test.TestCase):
       self._check(*input_1)
       self.assertEqual(mock_contract_path.call_count, 6 if six.PY2 else 2)
 
+  def test_opt_einsum_intermediates_not_transposed(self):
+    label_to_dim = {'a': 2, 'b': 3, 'c': 4, 'd': 5}
+    # The intermediate result is computed as 'ac' and consumed as 'ac', so
+    # neither einsum needs to transpose it.
+    self.assertEqual(
+        special_math_ops._einsum_v2_reorder_intermediates(
+            (((1, 0), 'ab,bc->ca'), ((1, 0), 'ca,cd->ad')), label_to_dim),
+        (((1, 0), 'ab,bc->ac'), ((1, 0), 'ac,cd->ad')))
+    # 'bc,cd->db' has its free dimensions in the wrong order for the output;
+    # swapping the operands avoids transposing the result.
+    self.assertEqual(
+        special_math_ops._einsum_v2_reorder_intermediates(
+            (((2, 1), 'ab,ca->bc'), ((1, 0), 'bc,cd->db')), label_to_dim),
+        (((2, 1), 'ab,ca->bc'), ((0, 0), 'cd,bc->db')))
+    # Broadcasting is left as is.
+    indices_and_equations = (((1, 0), '0ab,bc->0ca'), ((1, 0), '0ca,cd->0ad'))
+    self.assertEqual(
+        special_math_ops._einsum_v2_reorder_intermediates(
+            indices_and_equations, label_to_dim), indices_and_equations)
+
   @test_util.disable_xla('b/131919749')
   def test_long_cases_with_repeated_labels(self):
     cases = [
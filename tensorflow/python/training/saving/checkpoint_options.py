@@ -40,9 +40,11 @@ class CheckpointOptions(object):
   """
 
   # Define object attributes in __slots__ for improved memory and performance.
-  __slots__ = ("experimental_io_device",)
+  __slots__ = ("experimental_io_device", "experimental_enable_async_write")
 
-  def __init__(self, experimental_io_device=None):
+  def __init__(self,
+               experimental_io_device=None,
+               experimental_enable_async_write=False):
     """Creates an object that stores options for a Checkpoint.
 
     Args:
@@ -55,5 +57,11 @@ class CheckpointOptions(object):
         This is for example useful if you want to save to a local directory,
         such as "/tmp" when running in a distributed setting. In that case pass
         a device for the host where the "/tmp" directory is accessible.
+      experimental_enable_async_write: bool. If True, saving copies the
+        variable values and returns without waiting for the checkpoint files
+        to be written; a background thread writes them. Restoring the same
+        checkpoint from this process waits for the write to finish. Other
+        processes must not read the checkpoint before it is complete.
     """
     self.experimental_io_device = experimental_io_device
+    self.experimental_enable_async_write = experimental_enable_async_write
@@ -80,6 +80,9 @@ class _SingleDeviceSaver(object):
           tensor_slices.append(spec.slice_spec)
     save_device = options.experimental_io_device or "cpu:0"
     with ops.device(save_device):
+      if options.experimental_enable_async_write:
+        return io_ops.save_v2(file_prefix, tensor_names, tensor_slices,
+                              tensors, async_write=True)
       return io_ops.save_v2(file_prefix, tensor_names, tensor_slices, tensors)
 
   def restore(self, file_prefix, options=None):
@@ -27,11 +27,12 @@ std::string AllocatorStats::DebugString() const {
       "MaxAllocSize:     %20lld\n"
       "Reserved:         %20lld\n"
       "PeakReserved:     %20lld\n"
-      "LargestFreeBlock: %20lld\n",
+      "LargestFreeBlock: %20lld\n"
+      "Fragmentation:    %20.4f\n",
       this->bytes_limit ? *this->bytes_limit : 0, this->bytes_in_use,
       this->peak_bytes_in_use, this->num_allocs, this->largest_alloc_size,
       this->bytes_reserved, this->peak_bytes_reserved,
-      this->largest_free_block_bytes);
+      this->largest_free_block_bytes, this->fragmentation);
 }
 
 }  // namespace stream_executor
@@ -45,6 +45,10 @@ struct AllocatorStats {
 
   int64 largest_free_block_bytes;  // Largest free block's size in heap.
 
+  // Fraction of the free bytes in the heap that lie outside the largest free
+  // block, within [0, 1].
+  double fragmentation;
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
@@ -52,7 +56,8 @@ struct AllocatorStats {
         largest_alloc_size(0),
         bytes_reserved(0),
         peak_bytes_reserved(0),
-        largest_free_block_bytes(0) {}
+        largest_free_block_bytes(0),
+        fragmentation(0) {}
 
   std::string DebugString() const;
 };
@@ -19,11 +19,13 @@ limitations under the License.
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/stream_executor/allocator_stats.h"
 #include "tensorflow/stream_executor/device_memory.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 #include "tensorflow/stream_executor/platform.h"
@@ -222,6 +224,13 @@ class DeviceMemoryAllocator {
   // a different stream.
   virtual port::StatusOr<Stream *> GetStream(int device_ordinal) = 0;
 
+  // Returns the statistics of the allocator backing 'device_ordinal', or
+  // nullopt if the allocator does not track them.
+  virtual absl::optional<AllocatorStats> GetAllocatorStats(
+      int device_ordinal) {
+    return absl::nullopt;
+  }
+
  protected:
   const Platform* platform_;
 };
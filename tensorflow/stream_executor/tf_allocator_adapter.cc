@@ -64,4 +64,24 @@ port::StatusOr<Stream *> TfAllocatorAdapter::GetStream(int device_ordinal) {
   return stream_;
 }
 
+absl::optional<AllocatorStats> TfAllocatorAdapter::GetAllocatorStats(
+    int device_ordinal) {
+  absl::optional<tensorflow::AllocatorStats> tf_stats = wrapped_->GetStats();
+  if (!tf_stats) {
+    return absl::nullopt;
+  }
+  AllocatorStats stats;
+  stats.num_allocs = tf_stats->num_allocs;
+  stats.bytes_in_use = tf_stats->bytes_in_use;
+  stats.peak_bytes_in_use = tf_stats->peak_bytes_in_use;
+  stats.largest_alloc_size = tf_stats->largest_alloc_size;
+  stats.bytes_limit = tf_stats->bytes_limit;
+  stats.bytes_reserved = tf_stats->bytes_reserved;
+  stats.peak_bytes_reserved = tf_stats->peak_bytes_reserved;
+  stats.bytes_reservable_limit = tf_stats->bytes_reservable_limit;
+  stats.largest_free_block_bytes = tf_stats->largest_free_block_bytes;
+  stats.fragmentation = tf_stats->fragmentation;
+  return stats;
+}
+
 }  // namespace stream_executor
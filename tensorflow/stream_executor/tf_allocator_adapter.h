@@ -56,6 +56,9 @@ class TfAllocatorAdapter : public DeviceMemoryAllocator {
 
   port::StatusOr<Stream *> GetStream(int device_ordinal) override;
 
+  absl::optional<AllocatorStats> GetAllocatorStats(
+      int device_ordinal) override;
+
  private:
   tensorflow::Allocator *wrapped_;
   Stream *stream_;
@@ -105,6 +108,13 @@ class MultiDeviceAdapter : public DeviceMemoryAllocator {
     return per_device_allocators_[device_ordinal].GetStream(device_ordinal);
   }
 
+  absl::optional<AllocatorStats> GetAllocatorStats(
+      int device_ordinal) override {
+    CHECK_LT(device_ordinal, per_device_allocators_.size());
+    return per_device_allocators_[device_ordinal].GetAllocatorStats(
+        device_ordinal);
+  }
+
  private:
   std::vector<TfAllocatorAdapter> per_device_allocators_;
   // The wrapped TF allocators backing per_device_allocators_
@@ -0,0 +1,197 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/compare_benchmarks.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace compare_benchmarks {
+namespace {
+
+// Scales the MAD of normally distributed samples to their standard deviation.
+constexpr double kMadToStddev = 1.4826;
+
+}  // namespace
+
+void AddSamples(const BenchmarkEntries& entries, BenchmarkSamples* samples) {
+  for (const BenchmarkEntry& entry : entries.entry()) {
+    std::vector<double>& values = (*samples)[entry.name()];
+    bool has_repetitions = false;
+    for (const MetricEntry& metric : entry.metrics()) {
+      if (metric.name() != "wall_time") continue;
+      values.push_back(metric.value());
+      has_repetitions = true;
+    }
+    if (!has_repetitions && entry.iters() > 0) {
+      values.push_back(entry.wall_time());
+    }
+  }
+}
+
+Status ReadSamples(const string& pattern, BenchmarkSamples* samples) {
+  Env* env = Env::Default();
+  std::vector<string> filenames;
+  TF_RETURN_IF_ERROR(env->GetMatchingPaths(pattern, &filenames));
+  if (filenames.empty()) {
+    return errors::NotFound("No benchmark results match ", pattern);
+  }
+  for (const string& filename : filenames) {
+    BenchmarkEntries entries;
+    TF_RETURN_IF_ERROR(ReadBinaryProto(env, filename, &entries));
+    AddSamples(entries, samples);
+  }
+  return Status::OK();
+}
+
+double Median(std::vector<double> values) {
+  DCHECK(!values.empty());
+  const size_t mid = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + mid, values.end());
+  if (values.size() % 2 == 1) return values[mid];
+  const double upper = values[mid];
+  const double lower = *std::max_element(values.begin(), values.begin() + mid);
+  return (lower + upper) / 2;
+}
+
+double MedianAbsoluteDeviation(const std::vector<double>& values,
+                               double median) {
+  std::vector<double> deviations;
+  deviations.reserve(values.size());
+  for (double value : values) {
+    deviations.push_back(std::abs(value - median));
+  }
+  return Median(std::move(deviations));
+}
+
+std::vector<BenchmarkComparison> CompareBenchmarks(
+    const BenchmarkSamples& baseline, const BenchmarkSamples& candidate,
+    const ComparisonOptions& options) {
+  std::vector<BenchmarkComparison> comparisons;
+  for (const auto& base : baseline) {
+    auto cand = candidate.find(base.first);
+    if (cand == candidate.end()) continue;
+    if (base.second.empty() || cand->second.empty()) continue;
+
+    BenchmarkComparison comparison;
+    comparison.name = base.first;
+    comparison.num_baseline_samples = base.second.size();
+    comparison.num_candidate_samples = cand->second.size();
+    comparison.baseline_median = Median(base.second);
+    comparison.candidate_median = Median(cand->second);
+    comparison.baseline_mad =
+        MedianAbsoluteDeviation(base.second, comparison.baseline_median);
+    comparison.candidate_mad =
+        MedianAbsoluteDeviation(cand->second, comparison.candidate_median);
+
+    const double change =
+        comparison.candidate_median - comparison.baseline_median;
+    if (comparison.baseline_median > 0) {
+      comparison.relative_change = change / comparison.baseline_median;
+    }
+    const double noise =
+        options.num_mads * kMadToStddev *
+        std::hypot(comparison.baseline_mad, comparison.candidate_mad);
+    const bool significant =
+        std::abs(comparison.relative_change) >= options.min_relative_change &&
+        std::abs(change) > noise;
+    comparison.regression = significant && change > 0;
+    comparison.improvement = significant && change < 0;
+    comparisons.push_back(comparison);
+  }
+  return comparisons;
+}
+
+string FormatComparisons(const std::vector<BenchmarkComparison>& comparisons) {
+  size_t width = 10;
+  for (const BenchmarkComparison& comparison : comparisons) {
+    width = std::max(width, comparison.name.size());
+  }
+  string result = strings::Printf("%-*s %14s %14s %9s\n",
+                                  static_cast<int>(width), "Benchmark",
+                                  "Baseline(ns)", "Candidate(ns)", "Change");
+  for (const BenchmarkComparison& comparison : comparisons) {
+    const char* verdict = comparison.regression
+                              ? "REGRESSION"
+                              : (comparison.improvement ? "improvement" : "");
+    strings::Appendf(&result, "%-*s %8.0f+-%-4.0f %8.0f+-%-4.0f %+8.2f%% %s\n",
+                     static_cast<int>(width), comparison.name.c_str(),
+                     comparison.baseline_median * 1e9,
+                     comparison.baseline_mad * 1e9,
+                     comparison.candidate_median * 1e9,
+                     comparison.candidate_mad * 1e9,
+                     comparison.relative_change * 100, verdict);
+  }
+  return result;
+}
+
+int Main(int argc, char** argv) {
+  string baseline_pattern;
+  string candidate_pattern;
+  float min_relative_change = 0.05;
+  float num_mads = 3.0;
+
+  std::vector<Flag> flag_list = {
+      Flag("baseline", &baseline_pattern,
+           "files with the benchmark results of the baseline build"),
+      Flag("candidate", &candidate_pattern,
+           "files with the benchmark results of the candidate build"),
+      Flag("min_relative_change", &min_relative_change,
+           "smallest relative change of the median time to report"),
+      Flag("num_mads", &num_mads,
+           "how many median absolute deviations a change must exceed"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+
+  if (!parse_result || baseline_pattern.empty() || candidate_pattern.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+
+  ComparisonOptions options;
+  options.min_relative_change = min_relative_change;
+  options.num_mads = num_mads;
+
+  BenchmarkSamples baseline;
+  BenchmarkSamples candidate;
+  Status s = ReadSamples(baseline_pattern, &baseline);
+  if (s.ok()) s = ReadSamples(candidate_pattern, &candidate);
+  if (!s.ok()) {
+    LOG(ERROR) << "Could not read benchmark results: " << s;
+    return -1;
+  }
+
+  const std::vector<BenchmarkComparison> comparisons =
+      CompareBenchmarks(baseline, candidate, options);
+  printf("%s", FormatComparisons(comparisons).c_str());
+
+  const int num_regressions = std::count_if(
+      comparisons.begin(), comparisons.end(),
+      [](const BenchmarkComparison& c) { return c.regression; });
+  LOG(INFO) << "Compared " << comparisons.size() << " benchmarks, found "
+            << num_regressions << " regressions.";
+  return num_regressions > 0 ? 1 : 0;
+}
+
+}  // namespace compare_benchmarks
+}  // namespace tensorflow
@@ -0,0 +1,91 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TOOLS_BENCHMARK_COMPARE_BENCHMARKS_H_
+#define TENSORFLOW_TOOLS_BENCHMARK_COMPARE_BENCHMARKS_H_
+
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/test_log.pb.h"
+
+namespace tensorflow {
+namespace compare_benchmarks {
+
+// Wall time per iteration, in seconds, of every run of each benchmark, keyed
+// by benchmark name.
+using BenchmarkSamples = std::map<string, std::vector<double>>;
+
+struct ComparisonOptions {
+  // Changes of the median smaller than this fraction are never reported.
+  double min_relative_change = 0.05;
+  // A change is only significant if it exceeds this many (normalized) median
+  // absolute deviations of the samples.
+  double num_mads = 3.0;
+};
+
+struct BenchmarkComparison {
+  string name;
+  int num_baseline_samples = 0;
+  int num_candidate_samples = 0;
+  double baseline_median = 0;
+  double candidate_median = 0;
+  double baseline_mad = 0;
+  double candidate_mad = 0;
+  // (candidate_median - baseline_median) / baseline_median.
+  double relative_change = 0;
+  // The candidate is significantly slower, resp. faster, than the baseline.
+  bool regression = false;
+  bool improvement = false;
+};
+
+// Adds the samples recorded in `entries`. Entries written with
+// --benchmark_repetitions carry one "wall_time" metric per repetition, and
+// contribute all of them; others contribute their mean wall time.
+void AddSamples(const BenchmarkEntries& entries, BenchmarkSamples* samples);
+
+// Reads the BenchmarkEntries written by TestReporter to the files matching
+// `pattern` (e.g. "/tmp/run_*", given TEST_REPORT_FILE_PREFIX=/tmp/run_).
+Status ReadSamples(const string& pattern, BenchmarkSamples* samples);
+
+// Returns the median of `values`, which must not be empty.
+double Median(std::vector<double> values);
+
+// Returns the median absolute deviation of `values` around `median`.
+double MedianAbsoluteDeviation(const std::vector<double>& values,
+                               double median);
+
+// Compares the benchmarks present in both `baseline` and `candidate`, sorted
+// by name. A change is significant if the relative change of the medians is
+// at least `min_relative_change`, and the absolute change exceeds `num_mads`
+// times the combined MAD of both sample sets, scaled to estimate the
+// standard deviation. With a single sample per side, the MAD is zero and only
+// the relative threshold applies.
+std::vector<BenchmarkComparison> CompareBenchmarks(
+    const BenchmarkSamples& baseline, const BenchmarkSamples& candidate,
+    const ComparisonOptions& options);
+
+// Formats `comparisons` as a table, one benchmark per line.
+string FormatComparisons(const std::vector<BenchmarkComparison>& comparisons);
+
+// Handles argument parsing. Returns 1 if a regression was found.
+int Main(int argc, char** argv);
+
+}  // namespace compare_benchmarks
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TOOLS_BENCHMARK_COMPARE_BENCHMARKS_H_
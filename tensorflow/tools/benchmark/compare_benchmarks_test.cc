@@ -0,0 +1,126 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/compare_benchmarks.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace compare_benchmarks {
+namespace {
+
+BenchmarkEntries MakeEntries(const string& name,
+                             const std::vector<double>& wall_times) {
+  BenchmarkEntries entries;
+  BenchmarkEntry* entry = entries.add_entry();
+  entry->set_name(name);
+  entry->set_iters(100);
+  double total = 0;
+  for (double wall_time : wall_times) {
+    MetricEntry* metric = entry->add_metrics();
+    metric->set_name("wall_time");
+    metric->set_value(wall_time);
+    total += wall_time;
+  }
+  entry->set_wall_time(total / wall_times.size());
+  return entries;
+}
+
+TEST(CompareBenchmarksTest, MedianAndMad) {
+  EXPECT_EQ(2.0, Median({3.0, 1.0, 2.0}));
+  EXPECT_EQ(2.5, Median({4.0, 1.0, 2.0, 3.0}));
+  EXPECT_EQ(1.0, MedianAbsoluteDeviation({1.0, 2.0, 3.0, 100.0}, 2.5));
+}
+
+TEST(CompareBenchmarksTest, AddSamplesUsesRepetitions) {
+  BenchmarkSamples samples;
+  AddSamples(MakeEntries("BM_Foo", {1.0, 2.0, 3.0}), &samples);
+
+  // An entry without repetitions contributes its mean wall time.
+  BenchmarkEntries single;
+  BenchmarkEntry* entry = single.add_entry();
+  entry->set_name("BM_Foo");
+  entry->set_iters(10);
+  entry->set_wall_time(4.0);
+  AddSamples(single, &samples);
+
+  ASSERT_EQ(1, samples.size());
+  EXPECT_EQ(std::vector<double>({1.0, 2.0, 3.0, 4.0}), samples["BM_Foo"]);
+}
+
+TEST(CompareBenchmarksTest, FlagsSignificantChanges) {
+  BenchmarkSamples baseline;
+  BenchmarkSamples candidate;
+  // Noisy benchmark: a 10% change of the median is within the noise.
+  baseline["BM_Noisy"] = {1.0, 1.3, 0.7, 1.0, 1.2};
+  candidate["BM_Noisy"] = {1.1, 1.4, 0.8, 1.1, 1.3};
+  // Stable benchmarks: 10% changes are significant.
+  baseline["BM_Slower"] = {1.0, 1.01, 0.99, 1.0, 1.0};
+  candidate["BM_Slower"] = {1.1, 1.11, 1.09, 1.1, 1.1};
+  baseline["BM_Faster"] = {1.0, 1.01, 0.99, 1.0, 1.0};
+  candidate["BM_Faster"] = {0.9, 0.91, 0.89, 0.9, 0.9};
+  // Stable, but below the minimum relative change.
+  baseline["BM_Same"] = {1.0, 1.0, 1.0};
+  candidate["BM_Same"] = {1.01, 1.01, 1.01};
+  // Only present in the baseline.
+  baseline["BM_Removed"] = {1.0};
+
+  const std::vector<BenchmarkComparison> comparisons =
+      CompareBenchmarks(baseline, candidate, ComparisonOptions());
+  ASSERT_EQ(4, comparisons.size());
+
+  EXPECT_EQ("BM_Faster", comparisons[0].name);
+  EXPECT_FALSE(comparisons[0].regression);
+  EXPECT_TRUE(comparisons[0].improvement);
+  EXPECT_NEAR(-0.1, comparisons[0].relative_change, 1e-9);
+
+  EXPECT_EQ("BM_Noisy", comparisons[1].name);
+  EXPECT_FALSE(comparisons[1].regression);
+  EXPECT_FALSE(comparisons[1].improvement);
+
+  EXPECT_EQ("BM_Same", comparisons[2].name);
+  EXPECT_FALSE(comparisons[2].regression);
+  EXPECT_FALSE(comparisons[2].improvement);
+
+  EXPECT_EQ("BM_Slower", comparisons[3].name);
+  EXPECT_TRUE(comparisons[3].regression);
+  EXPECT_EQ(5, comparisons[3].num_baseline_samples);
+  EXPECT_NEAR(1.1, comparisons[3].candidate_median, 1e-9);
+}
+
+TEST(CompareBenchmarksTest, ReadSamples) {
+  const string dir = testing::TmpDir();
+  Env* env = Env::Default();
+  TF_ASSERT_OK(WriteBinaryProto(env, io::JoinPath(dir, "cmp_run_BM_A"),
+                                MakeEntries("BM_A", {1.0, 2.0})));
+  TF_ASSERT_OK(WriteBinaryProto(env, io::JoinPath(dir, "cmp_run_BM_B"),
+                                MakeEntries("BM_B", {3.0})));
+
+  BenchmarkSamples samples;
+  TF_ASSERT_OK(ReadSamples(io::JoinPath(dir, "cmp_run_*"), &samples));
+  ASSERT_EQ(2, samples.size());
+  EXPECT_EQ(std::vector<double>({1.0, 2.0}), samples["BM_A"]);
+  EXPECT_EQ(std::vector<double>({3.0}), samples["BM_B"]);
+
+  EXPECT_TRUE(errors::IsNotFound(
+      ReadSamples(io::JoinPath(dir, "missing_*"), &samples)));
+}
+
+}  // namespace
+}  // namespace compare_benchmarks
+}  // namespace tensorflow
@@ -749,6 +749,30 @@ def _tf_repositories():
         ],
     )
 
+    tf_http_archive(
+        name = "zstd",
+        build_file = "//third_party:zstd.BUILD",
+        sha256 = "734d1f565c42f691f8420c8d06783ad818060fc390dee43ae0a89f86d0a4f8c2",
+        strip_prefix = "zstd-1.4.5",
+        system_build_file = "//third_party/systemlibs:zstd.BUILD",
+        urls = [
+            "https://storage.googleapis.com/mirror.tensorflow.org/github.com/facebook/zstd/archive/v1.4.5.tar.gz",
+            "https://github.com/facebook/zstd/archive/v1.4.5.tar.gz",
+        ],
+    )
+
+    tf_http_archive(
+        name = "lz4",
+        build_file = "//third_party:lz4.BUILD",
+        sha256 = "658ba6191fa44c92280d4aa2c271b0f4fbc0e34d249578dd05e50e76d0e5efcc",
+        strip_prefix = "lz4-1.9.2",
+        system_build_file = "//third_party/systemlibs:lz4.BUILD",
+        urls = [
+            "https://storage.googleapis.com/mirror.tensorflow.org/github.com/lz4/lz4/archive/v1.9.2.tar.gz",
+            "https://github.com/lz4/lz4/archive/v1.9.2.tar.gz",
+        ],
+    )
+
     tf_http_archive(
         name = "nccl_archive",
         build_file = "//third_party:nccl/archive.BUILD",
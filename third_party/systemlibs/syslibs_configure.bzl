@@ -31,6 +31,7 @@ VALID_LIBS = [
     "jsoncpp_git",
     "libjpeg_turbo",
     "lmdb",
+    "lz4",
     "nasm",
     "nsync",
     "opt_einsum_archive",
@@ -46,6 +47,7 @@ VALID_LIBS = [
     "typing_extensions_archive",
     "wrapt",
     "zlib",
+    "zstd",
 ]
 
 def auto_configure_fail(msg):